@@ -0,0 +1,83 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::capture
+{
+    // The capture layer is a device wrapper that executes all calls on the underlying device and streams them
+    // into a binary trace file, together with the data they upload: buffer and texture writes, mapped buffer
+    // contents and shader binaries. The trace can then be replayed with replayTrace(...) on another device,
+    // e.g. to compare the CPU and GPU cost of the same frames with different NVRHI versions or drivers.
+    //
+    // The trace covers resource, pipeline and binding creation, command list recording with copies, clears,
+    // graphics and compute state, draws, dispatches, barriers and markers, and command list execution.
+    // Other calls, such as ray tracing, meshlets, readbacks and queries, are still executed but are only
+    // recorded as unsupported events, which the replay counts and skips.
+    // Shader binaries are stored as-is, so a trace can only be replayed on the graphics API it was captured on,
+    // or on the null backend.
+    struct CaptureLayerDesc
+    {
+        const char* traceFileName = nullptr;
+
+        CaptureLayerDesc& setTraceFileName(const char* value) { traceFileName = value; return *this; }
+    };
+
+    // Returns nullptr if the trace file cannot be created.
+    NVRHI_API DeviceHandle createCaptureLayer(IDevice* underlyingDevice, const CaptureLayerDesc& desc);
+
+    // Frames are delimited by IDevice::runGarbageCollection calls in the trace, which applications make once per frame.
+    struct ReplayFrameStats
+    {
+        // Time spent executing the frame's NVRHI calls on the CPU, including object creation and submission
+        double cpuTimeMs = 0.0;
+
+        // Sum of the GPU times of the frame's command lists, measured with timer queries.
+        // Reusable command lists are executed without timing, so their time is not included.
+        double gpuTimeMs = 0.0;
+
+        uint32_t numCommandLists = 0;
+        uint32_t numDraws = 0;
+        uint32_t numDispatches = 0;
+    };
+
+    struct ReplayResults
+    {
+        GraphicsAPI capturedGraphicsAPI = GraphicsAPI::D3D11;
+        std::vector<ReplayFrameStats> frames;
+
+        // Number of events that were captured as unsupported or referenced objects that could not be created
+        uint32_t numUnsupportedEvents = 0;
+        uint32_t numMissingObjects = 0;
+
+        // Set when the trace could not be read
+        std::string error;
+    };
+
+    // Replays the trace on the device, waiting for the device to become idle at the end of each frame
+    // so that the frames are timed independently. Returns false if the trace file cannot be read,
+    // or if it was captured on a different graphics API. Null traces and the null device are compatible with any API.
+    NVRHI_API bool replayTrace(IDevice* device, const char* traceFileName, ReplayResults& outResults);
+}
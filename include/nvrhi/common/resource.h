@@ -35,7 +35,7 @@ namespace nvrhi
     //
     // The encoding is chosen to minimize potential conflicts between implementations.
     // 0x00aabbcc, where:
-    //   aa is GAPI, 1 for D3D11, 2 for D3D12, 3 for VK
+    //   aa is GAPI, 1 for D3D11, 2 for D3D12, 3 for VK, 4 for the null backend
     //   bb is layer, 0 for native GAPI objects, 1 for reference NVRHI backend, 2 for user-defined backends
     //   cc is a sequential number
 
@@ -63,6 +63,8 @@ namespace nvrhi
         constexpr ObjectType D3D12_RootSignature                    = 0x00020009;
         constexpr ObjectType D3D12_PipelineState                    = 0x0002000a;
         constexpr ObjectType D3D12_CommandAllocator                 = 0x0002000b;
+        constexpr ObjectType D3D12_CommandSignature                 = 0x0002000c;
+        constexpr ObjectType D3D12_StateObject                      = 0x0002000d;
 
         constexpr ObjectType VK_Device                              = 0x00030001;
         constexpr ObjectType VK_PhysicalDevice                      = 0x00030002;
@@ -87,6 +89,7 @@ namespace nvrhi
         constexpr ObjectType VK_Pipeline                            = 0x00030013;
         constexpr ObjectType VK_Micromap                            = 0x00030014;
         constexpr ObjectType VK_ImageCreateInfo                     = 0x00030015;
+        constexpr ObjectType VK_IndirectCommandsLayoutEXT           = 0x00030016;
     };
 
     struct Object
@@ -395,6 +398,19 @@ namespace nvrhi
         {
             return m_refCount.load();
         }
+
+        // Adds a reference unless the object is already being destroyed, i.e. its count has reached 0.
+        // Used by caches that store raw pointers and remove them from the object's destructor.
+        bool TryAddRef()
+        {
+            unsigned long count = m_refCount.load();
+            do
+            {
+                if (count == 0)
+                    return false;
+            } while (!m_refCount.compare_exchange_weak(count, count + 1));
+            return true;
+        }
     };
 
 } // namespace nvrhi
\ No newline at end of file
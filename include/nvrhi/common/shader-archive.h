@@ -0,0 +1,170 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Indexed archive of shader permutations, written by the shaderCompiler tool with --archive.
+// Layout:
+//   ShaderArchiveHeader
+//   ShaderArchiveEntry[numEntries], sorted by permutationHash
+//   permutation strings
+//   payloads, each aligned to ShaderArchiveHeader::payloadAlignment bytes from the start of the file
+// All values are little-endian. A permutation string is the list of its defines sorted by name,
+// formatted as "NAME=VALUE" and separated by single spaces, see BuildShaderArchivePermutation.
+
+namespace nvrhi
+{
+    constexpr uint32_t c_ShaderArchiveSignature = 0x4153564e; // "NVSA"
+    constexpr uint32_t c_ShaderArchiveVersion = 1;
+    constexpr uint32_t c_ShaderArchivePayloadAlignment = 16;
+    // Entries that claim a larger uncompressed size are rejected when the archive is opened
+    constexpr uint32_t c_ShaderArchiveMaxUncompressedSize = 256 * 1024 * 1024;
+
+    enum class ShaderArchiveCompression : uint32_t
+    {
+        None = 0,
+        // LZ4 block format, without the frame header
+        LZ4 = 1
+    };
+
+    struct ShaderArchiveHeader
+    {
+        uint32_t signature;
+        uint32_t version;
+        uint32_t numEntries;
+        uint32_t payloadAlignment;
+    };
+
+    struct ShaderArchiveEntry
+    {
+        uint64_t permutationHash;
+        uint64_t dataOffset;
+        uint32_t dataSize;
+        uint32_t uncompressedSize;
+        uint32_t permutationOffset;
+        uint32_t permutationSize;
+        ShaderArchiveCompression compression;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(ShaderArchiveHeader) == 16, "sizeof(ShaderArchiveHeader) is supposed to be 16 bytes");
+    static_assert(sizeof(ShaderArchiveEntry) == 40, "sizeof(ShaderArchiveEntry) is supposed to be 40 bytes");
+
+    struct ShaderDefine
+    {
+        const char* name = nullptr;
+        // nullptr is equivalent to "1", same as a -D option without a value
+        const char* value = nullptr;
+    };
+
+    // Builds the canonical permutation string from (name, value) pairs, empty values are replaced with "1"
+    inline std::string BuildShaderArchivePermutation(std::vector<std::pair<std::string, std::string>> defines)
+    {
+        std::sort(defines.begin(), defines.end());
+
+        std::string result;
+        for (const auto& [name, value] : defines)
+        {
+            if (!result.empty())
+                result += ' ';
+            result += name;
+            result += '=';
+            result += value.empty() ? "1" : value;
+        }
+        return result;
+    }
+
+    // FNV-1a, the archive index depends on it so it must never change for a given archive version
+    inline uint64_t HashShaderArchivePermutation(const std::string& permutation)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c : permutation)
+        {
+            hash ^= uint8_t(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+}
+
+namespace nvrhi::utils
+{
+    // Reads shader permutation archives. The archive file is memory-mapped, and the permutations are found
+    // with a binary search in the hash index. findPermutation returns pointers into the mapped file,
+    // so uncompressed permutations can be passed to IDevice::createShader without any copies.
+    // Compressed permutations are decompressed on first access and stay in memory until the archive is closed.
+    // All functions except open... and close are thread-safe.
+    class ShaderArchive
+    {
+    public:
+        ShaderArchive() = default;
+        NVRHI_API ~ShaderArchive();
+
+        ShaderArchive(const ShaderArchive&) = delete;
+        ShaderArchive& operator=(const ShaderArchive&) = delete;
+
+        // Maps the archive file into memory. Returns false if the file cannot be mapped or is not a valid archive.
+        NVRHI_API bool open(const char* fileName);
+        // Uses an archive that is already in memory, which must stay valid until the archive is closed or destroyed.
+        NVRHI_API bool openMemory(const void* data, size_t size);
+        NVRHI_API void close();
+
+        [[nodiscard]] bool isOpen() const { return m_Header != nullptr; }
+        [[nodiscard]] uint32_t getNumPermutations() const { return m_Header ? m_Header->numEntries : 0; }
+
+        // Finds the permutation compiled with the given set of defines, in any order.
+        // The binary stays valid until the archive is closed or destroyed.
+        NVRHI_API bool findPermutation(const ShaderDefine* defines, size_t numDefines, const void** pBinary, size_t* pSize);
+
+        // Shortcut for findPermutation and IDevice::createShader, returns null if the permutation is not found
+        NVRHI_API ShaderHandle createShader(IDevice* device, const ShaderDesc& desc, const ShaderDefine* defines, size_t numDefines);
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+        const ShaderArchiveHeader* m_Header = nullptr;
+        const ShaderArchiveEntry* m_Entries = nullptr;
+
+        bool m_IsMapped = false;
+        // File and file mapping handles on Windows
+        void* m_FileHandle = nullptr;
+        void* m_MappingHandle = nullptr;
+
+        std::mutex m_DecompressionMutex;
+        std::unordered_map<uint32_t, std::vector<uint8_t>> m_DecompressedEntries; // keyed by entry index
+
+        bool validate();
+    };
+
+    // Decompresses a block of ShaderArchiveCompression::LZ4 data, returns false if the data is malformed
+    // or doesn't decompress to exactly 'dstSize' bytes
+    NVRHI_API bool DecompressLZ4Block(const void* src, size_t srcSize, void* dst, size_t dstSize);
+}
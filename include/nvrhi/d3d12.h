@@ -100,6 +100,20 @@ namespace nvrhi::d3d12
         virtual GraphicsPipelineHandle createHandleForNativeGraphicsPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const GraphicsPipelineDesc& desc, const FramebufferInfo& framebufferInfo) = 0;
         virtual MeshletPipelineHandle createHandleForNativeMeshletPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const MeshletPipelineDesc& desc, const FramebufferInfo& framebufferInfo) = 0;
         [[nodiscard]] virtual IDescriptorHeap* getDescriptorHeap(DescriptorHeapType heapType) = 0;
+
+        // Creates a new ray tracing pipeline that contains everything in 'pipeline' plus the shaders and hit groups
+        // from 'additions', using ID3D12Device7::AddToStateObject. Only the new shaders are compiled, and the shader
+        // identifiers of the existing exports stay the same. 'pipeline' must be created with allowAdditions = true,
+        // it stays valid. The configuration of 'additions' (payload and attribute sizes, recursion depth, global binding
+        // layouts) is ignored, the values from 'pipeline' are used. The new pipeline also allows additions.
+        virtual rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) = 0;
+
+        // DXIL has no specialization constants, so they are emulated with precompiled permutations: this function
+        // registers a permutation of 'baseShader' that was compiled with the given constant values applied, e.g. as macros.
+        // createShaderSpecialization(baseShader, ...) then returns the same permutation object whenever it's called
+        // with the same set of constants, in any order. 'baseShader' must be created with createShader.
+        // Returns the permutation, or null if the binary is empty or the constant IDs are not unique.
+        virtual ShaderHandle addShaderSpecializationPermutation(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants, const void* binary, size_t binarySize) = 0;
     };
 
     typedef RefCountPtr<IDevice> DeviceHandle;
@@ -128,6 +142,120 @@ namespace nvrhi::d3d12
         // Enable logging the buffer lifetime to IMessageCallback
         // Useful for debugging resource lifetimes
         bool logBufferLifetime = false;
+
+        // If enabled, buffers and textures that are not render targets or depth-stencil surfaces are created
+        // as placed resources in internally managed heaps, unless their desc requests a dedicated allocation.
+        // Resources can also opt in individually with ResourceAllocationMode::SubAllocated.
+        // Note that unlike committed resources, placed resources are not zero-initialized.
+        // Placement saves the per-allocation overhead of committed resources, but not memory for small buffers:
+        // D3D12 aligns placed buffers to 64 KB, so each buffer still occupies at least 64 KB of a heap.
+        // Small textures use 4 KB alignment when the runtime allows it. Many small buffers, such as per-object
+        // constants, should be packed by the application into one buffer and bound with ranges instead.
+        bool enablePlacedResourceAllocator = false;
+
+        // Size of the heaps created by the placed resource allocator.
+        uint64_t placedResourceHeapSize = 64 * 1024 * 1024;
+
+        // If enabled, committed buffers and textures in video memory are tracked in the order they were last used
+        // by executed command lists. When the local memory usage exceeds the OS budget, the least recently used
+        // resources that are not in use by the GPU are evicted, and they are made resident again before the next
+        // command list that references them is executed.
+        // Resources that are only accessed through descriptor tables are not visible to this tracking and must
+        // use ResidencyPriority::Maximum, which excludes them from eviction.
+        bool enableResidencyManager = false;
+
+        // Size of the persistently mapped ring buffer that each command list takes upload memory
+        // (writeBuffer, writeTexture, constant buffers, etc.) from. Requests that do not fit into the ring
+        // fall back to separately allocated chunks. Set to 0 to only use the chunks.
+        uint64_t uploadRingBufferSize = 0;
+
+        // Size of the persistently mapped buffers in the device-wide pool that asynchronous readbacks
+        // (ICommandList::readbackBuffer, readbackTexture) are suballocated from. The pool adds a buffer when
+        // a readback doesn't fit into the existing ones, sized to fit readbacks larger than this.
+        uint64_t readbackBufferSize = 4 * 1024 * 1024;
+
+        // If enabled and the device supports Enhanced Barriers (D3D12_FEATURE_D3D12_OPTIONS12),
+        // resource state transitions on the graphics and compute queues are recorded with
+        // ID3D12GraphicsCommandList7::Barrier instead of the legacy ResourceBarrier.
+        // Disable this if the application records its own legacy barriers on NVRHI resources
+        // inside NVRHI command lists, as the two barrier models cannot be mixed on one resource.
+        bool enableEnhancedBarriers = true;
+
+        // If enabled, executeCommandLists makes the submission wait for the submissions on other queues that
+        // last wrote the resources it uses, or that last used the resources it writes.
+        // Only the resources tracked by the command list state trackers are considered, i.e. not those with
+        // permanent states, volatile or CPU-accessible buffers, or resources only referenced by bindless descriptors.
+        bool enableAutomaticQueueSync = false;
+        // Report every automatically inserted queue wait to IMessageCallback with the Info severity
+        bool logAutomaticQueueSync = false;
+
+        // If enabled, executeCommandLists doesn't submit the command lists right away, but accumulates them,
+        // and IDevice::flushSubmissions submits all of them with one ExecuteCommandLists call per queue
+        // followed by a single fence signal. The returned instance IDs are the same as without deferral.
+        // The pending submissions are also flushed when the CPU waits for them (waitForIdle, mapBuffer,
+        // mapStagingTexture, event and timer queries), when another queue waits for them, and before a queue wait
+        // or updateTextureTileMappings is inserted into the queue. Polling a command list or query never flushes.
+        // The application must call flushSubmissions before presenting.
+        bool enableDeferredSubmission = false;
+
+        // If enabled and supported by the driver, graphics, compute and meshlet pipeline state objects are stored
+        // in an ID3D12PipelineLibrary, keyed by a hash of their descriptions, and loaded from it when the same
+        // pipeline state is created again. Pipelines created with NVAPI extensions are not stored.
+        bool enablePipelineLibrary = false;
+
+        // Maximum total size of the BLASes that one ICommandList::compactBottomLevelAccelStructs call compacts,
+        // measured before compaction. The call is typically made once per frame, and the BLASes that don't fit
+        // are left for the next calls. Set to 0 to compact all available BLASes at once. Not used with RTXMU.
+        // The same budget applies to the OMM arrays compacted by each ICommandList::compactOpacityMicromaps call.
+        uint64_t blasCompactionBudget = 64 * 1024 * 1024;
+
+        // If enabled, every acceleration structure and OMM build call is wrapped in a timer query taken from a pool,
+        // and IDevice::getAccelStructStats reports the GPU build time per frame. The pool uses up to
+        // 'maxAccelStructBuildTimerQueries' of the 'maxTimerQueries' timer queries. Reusable command lists are not timed.
+        bool enableAccelStructBuildTiming = false;
+        uint32_t maxAccelStructBuildTimerQueries = 64;
+
+        // If enabled, beginMarker / endMarker also record GPU timestamps into timer queries taken from a pool of up to
+        // 'maxProfilerTimerQueries' of the 'maxTimerQueries' timer queries, and IDevice::getProfilerFrameResults returns
+        // the timings as a tree of scopes per queue once the frame has finished executing. Markers in secondary,
+        // reusable and copy queue command lists are not timed.
+        bool enableMarkerProfiling = false;
+        uint32_t maxProfilerTimerQueries = 128;
+
+        // If enabled, createBindingSet returns the existing binding set when one is created again with an identical
+        // BindingSetDesc and layout, instead of allocating and writing new descriptors. The cached sets are released
+        // by runGarbageCollection once the application no longer references them.
+        bool enableBindingSetCache = false;
+
+        // If enabled, createFramebuffer returns the existing framebuffer when one is created again with an identical
+        // FramebufferDesc, so that creating framebuffers every frame is cheap. The cached framebuffers keep their
+        // attachment textures alive until runGarbageCollection finds them unreferenced and not requested since its
+        // previous call. Use IDevice::evictCachedFramebuffers to release them earlier, e.g. the swap chain back
+        // buffers before the swap chain is resized.
+        bool enableFramebufferCache = false;
+
+        // Control how resizeDescriptorTable grows descriptor tables. A growing table first tries to extend its range
+        // in the heap in place, which doesn't copy any descriptors. When the descriptors after the table are in use,
+        // the table moves to a new range large enough for max(newSize, capacity * descriptorTableGrowthFactor)
+        // descriptors, so that the following resizes stay in place and the copies are amortized. A move copies
+        // the descriptors up to the highest slot written with writeDescriptorTable, not the whole capacity.
+        // A factor of 1 allocates exactly the requested size.
+        // When the shader-visible heap itself has to grow, every descriptor up to the end of the last allocation
+        // in the heap is copied into the new heap, including free ranges in between; a large enough
+        // shaderResourceViewHeapSize avoids that cost.
+        // If reserveDescriptorTableCapacity is enabled, tables created from bindless layouts with a nonzero
+        // maxCapacity reserve that many descriptors upfront and never move when resized below that capacity.
+        float descriptorTableGrowthFactor = 2.f;
+        bool reserveDescriptorTableCapacity = false;
+
+        // If set, buildTopLevelAccelStruct splits the conversion of large instance arrays across the threads of the runner.
+        IParallelTaskRunner* parallelTaskRunner = nullptr;
+
+        // Optional initial contents of the pipeline library, previously returned by IDevice::getPipelineCacheData.
+        // The data is ignored with a warning if it was created on a different adapter or driver version.
+        // It's copied during createDevice.
+        const void* pipelineCacheData = nullptr;
+        size_t pipelineCacheDataSize = 0;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
@@ -0,0 +1,51 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::ObjectTypes
+{
+    constexpr ObjectType Nvrhi_Null_Device = 0x00040101;
+};
+
+namespace nvrhi::null
+{
+    // The null backend implements the NVRHI interfaces without any graphics API underneath.
+    // Command lists do all the work that the other backends do on the CPU - resource state tracking,
+    // upload memory suballocation, binding set and resource lifetime tracking - but record no native commands,
+    // so that the CPU overhead of NVRHI and the application can be measured without a GPU.
+    // Resource contents are not emulated: only the CPU-accessible buffers and staging textures have memory,
+    // and the commands never modify it. Readbacks return zeros.
+    struct DeviceDesc
+    {
+        IMessageCallback* messageCallback = nullptr;
+
+        // Time between the submission of a command list and its emulated completion on the queue.
+        // With 0, command lists complete when they are submitted. Submissions on a queue complete in order,
+        // and after the submissions that they wait for with queueWaitForCommandList.
+        uint32_t completionLatencyMicroseconds = 0;
+    };
+
+    NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
+}
@@ -30,6 +30,7 @@
 #include <cstdint>
 #include <cmath>
 #include <cstring>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -64,7 +65,7 @@ namespace nvrhi
 {
     // Version of the public API provided by NVRHI.
     // Increment this when any changes to the API are made.
-    static constexpr uint32_t c_HeaderVersion = 21;
+    static constexpr uint32_t c_HeaderVersion = 48;
 
     // Verifies that the version of the implementation matches the version of the header.
     // Returns true if they match. Use this when initializing apps using NVRHI as a shared library.
@@ -77,8 +78,10 @@ namespace nvrhi
     static constexpr uint32_t c_MaxBindlessRegisterSpaces = 16;
     static constexpr uint32_t c_MaxVolatileConstantBuffersPerLayout = 6;
     static constexpr uint32_t c_MaxVolatileConstantBuffers = 32;
+    static constexpr uint32_t c_MaxIndirectArguments = c_MaxVertexAttributes + 3; // vertex buffers, index buffer, push constants, draw
     static constexpr uint32_t c_MaxPushConstantSize = 128; // D3D12: root signature is 256 bytes max., Vulkan: 128 bytes of push constants guaranteed
     static constexpr uint32_t c_ConstantBufferOffsetSizeAlignment = 256; // Partially bound constant buffers must have offsets aligned to this and sizes multiple of this
+    static constexpr uint32_t c_MaxMemoryHeaps = 16; // Vulkan: VK_MAX_MEMORY_HEAPS
 
     //////////////////////////////////////////////////////////////////////////
     // Basic Types
@@ -88,9 +91,9 @@ namespace nvrhi
     {
         float r, g, b, a;
 
-        Color() : r(0.f), g(0.f), b(0.f), a(0.f) { }
-        Color(float c) : r(c), g(c), b(c), a(c) { }
-        Color(float _r, float _g, float _b, float _a) : r(_r), g(_g), b(_b), a(_a) { }
+        constexpr Color() : r(0.f), g(0.f), b(0.f), a(0.f) { }
+        constexpr Color(float c) : r(c), g(c), b(c), a(c) { }
+        constexpr Color(float _r, float _g, float _b, float _a) : r(_r), g(_g), b(_b), a(_a) { }
 
         bool operator ==(const Color& _b) const { return r == _b.r && g == _b.g && b == _b.b && a == _b.a; }
         bool operator !=(const Color& _b) const { return !(*this == _b); }
@@ -154,7 +157,8 @@ namespace nvrhi
     {
         D3D11,
         D3D12,
-        VULKAN
+        VULKAN,
+        NULL_DEVICE
     };
 
     enum class Format : uint8_t
@@ -321,6 +325,204 @@ namespace nvrhi
         uint64_t alignment = 0;
     };
 
+    // Describes the state of the device memory allocator used for resources that are not placed into user heaps.
+    // D3D11 reports no allocations, D3D12 only reports the heaps of the placed resource allocator.
+    struct MemoryAllocatorStats
+    {
+        // Memory blocks that are shared by multiple resources
+        uint64_t blockCount = 0;
+        uint64_t blockBytes = 0;
+
+        // Resources placed into the shared blocks, and the total size they occupy
+        uint64_t subAllocationCount = 0;
+        uint64_t subAllocationBytes = 0;
+
+        // Resources and heaps that use their own memory allocations
+        uint64_t dedicatedAllocationCount = 0;
+        uint64_t dedicatedAllocationBytes = 0;
+    };
+
+    // Current usage and budget of one memory heap, as reported by the OS.
+    // The budget is the amount of memory that the application can use without the OS paging it out.
+    struct MemoryHeapBudget
+    {
+        uint64_t budget = 0;
+        uint64_t usage = 0;
+        bool isDeviceLocal = false;
+    };
+
+    // D3D12: reports the local and non-local segment groups of the adapter.
+    // Vulkan: reports all memory heaps if VK_EXT_memory_budget is enabled, nothing otherwise.
+    // D3D11: reports nothing.
+    struct MemoryBudget
+    {
+        static_vector<MemoryHeapBudget, c_MaxMemoryHeaps> heaps;
+    };
+
+    // Aggregated statistics of the ray tracing acceleration structures and opacity micromaps created by a device.
+    // Sizes are the sizes of the data buffers of the live objects. BLASes managed by RTXMU are counted with no size.
+    // D3D11 reports nothing.
+    struct AccelStructStats
+    {
+        uint64_t bottomLevelCount = 0;
+        uint64_t bottomLevelBytes = 0;
+        uint64_t topLevelCount = 0;
+        uint64_t topLevelBytes = 0;
+        uint64_t opacityMicromapCount = 0;
+        uint64_t opacityMicromapBytes = 0;
+
+        // Live BLASes and OMM arrays that have been compacted, and their sizes before and after the compaction
+        uint64_t compactedCount = 0;
+        uint64_t compactedPrebuildBytes = 0;
+        uint64_t compactedBytes = 0;
+
+        // BLASes and OMM arrays whose compacted sizes are known, waiting for compactBottomLevelAccelStructs
+        // or compactOpacityMicromaps
+        uint64_t pendingCompactionCount = 0;
+
+        // Largest scratch memory used by a single build call or cluster operation since the device was created
+        uint64_t buildScratchHighWaterMark = 0;
+        uint64_t clusterOperationScratchHighWaterMark = 0;
+        uint64_t clusterOperationCount = 0;
+
+        // GPU timing of the build calls, if enabled with DeviceDesc::enableAccelStructBuildTiming.
+        // Covers the build calls that finished executing between the last two runGarbageCollection calls,
+        // which are per-frame totals when it is called once per frame. Untimed builds found no free timer query.
+        uint32_t lastFrameTimedBuilds = 0;
+        uint32_t lastFrameUntimedBuilds = 0;
+        float lastFrameBuildTimeSeconds = 0.f;
+    };
+
+    // Counters of the work recorded into a command list since it was opened, see ICommandList::getStats.
+    // They are plain counters updated by the recording thread, cheap enough to be always enabled.
+    struct CommandListStats
+    {
+        // Draws of a drawBatch call are counted individually, indirect draws and executeIndirect count once.
+        // Dispatches include dispatchMesh and dispatchRays.
+        uint64_t drawCalls = 0;
+        uint64_t dispatches = 0;
+
+        // Pipeline changes, and the binding sets, descriptor tables or push bindings that were bound
+        uint64_t pipelineBinds = 0;
+        uint64_t bindingSetBinds = 0;
+
+        // Barriers recorded into the graphics API command list, and resource state requirements that added no barrier,
+        // either because the resource was in the required state already or because an existing barrier was extended.
+        // D3D11 has no barriers and reports 0.
+        uint64_t barriersIssued = 0;
+        uint64_t barriersElided = 0;
+
+        // Vulkan: render passes that were interrupted, e.g. by a copy or a barrier, and resumed on the same framebuffer.
+        // The other backends have no render passes and report 0.
+        uint64_t renderPassBreaks = 0;
+
+        // Data written by writeBuffer, writeTexture and the beginWrite* functions,
+        // and the number of those writes that went to volatile buffers
+        uint64_t uploadBytes = 0;
+        uint64_t volatileBufferWrites = 0;
+
+        CommandListStats& operator+=(const CommandListStats& other)
+        {
+            drawCalls += other.drawCalls;
+            dispatches += other.dispatches;
+            pipelineBinds += other.pipelineBinds;
+            bindingSetBinds += other.bindingSetBinds;
+            barriersIssued += other.barriersIssued;
+            barriersElided += other.barriersElided;
+            renderPassBreaks += other.renderPassBreaks;
+            uploadBytes += other.uploadBytes;
+            volatileBufferWrites += other.volatileBufferWrites;
+            return *this;
+        }
+    };
+
+    // Types of the objects counted in DeviceStats::liveObjects
+    enum class LiveObjectType : uint8_t
+    {
+        Heap,
+        Buffer,
+        Texture,
+        StagingTexture,
+        Sampler,
+        BindingSet,
+        DescriptorTable,
+        Framebuffer,
+        GraphicsPipeline,
+        ComputePipeline,
+        MeshletPipeline,
+        RayTracingPipeline,
+        WorkGraphPipeline,
+
+        Count
+    };
+
+    struct LiveObjectStats
+    {
+        uint64_t count = 0;
+        // Heaps: capacity. Buffers and staging textures: size of the data.
+        // Textures: memory size on D3D12 and Vulkan, estimated from the description on D3D11 and the null backend.
+        // 0 for the other types.
+        uint64_t bytes = 0;
+    };
+
+    struct DescriptorHeapStats
+    {
+        uint64_t allocated = 0;
+        uint64_t capacity = 0;
+    };
+
+    // Device-wide counters, see IDevice::getDeviceStats. They are updated with atomics and always enabled.
+    struct DeviceStats
+    {
+        // Live objects created by the device or wrapping native objects, indexed by LiveObjectType.
+        // Acceleration structures are counted in AccelStructStats.
+        LiveObjectStats liveObjects[size_t(LiveObjectType::Count)];
+
+        // D3D12: descriptors in the SRV/UAV/CBV, sampler, RTV and DSV heaps.
+        // Vulkan: descriptor sets in the shared pools of the binding layouts, and bytes of the descriptor buffer
+        // if it's enabled with DeviceDesc::enableDescriptorBuffers.
+        // D3D11 and the null backend report nothing.
+        DescriptorHeapStats shaderResourceDescriptors;
+        DescriptorHeapStats samplerDescriptors;
+        DescriptorHeapStats renderTargetDescriptors;
+        DescriptorHeapStats depthStencilDescriptors;
+        DescriptorHeapStats descriptorSets;
+        DescriptorHeapStats descriptorBufferBytes;
+
+        // Upload and scratch memory chunks owned by the command lists, including the free chunks in their pools.
+        // D3D11 uses no upload chunks and reports nothing.
+        uint64_t uploadChunkCount = 0;
+        uint64_t uploadChunkBytes = 0;
+
+        // Submitted command lists that have not been retired by runGarbageCollection or a queue wait yet, and the
+        // resource references that they hold, which delay the release of those resources
+        uint64_t commandListsInFlight = 0;
+        uint64_t pendingResourceReferences = 0;
+
+        // Resources of retired command lists that wait to be released by runGarbageCollection(maxReleaseMicroseconds)
+        uint64_t queuedResourceReleases = 0;
+
+        // Number of command list executions since the device was created, and the sum of their CommandListStats
+        uint64_t executedCommandLists = 0;
+        CommandListStats executedCommandListTotals;
+    };
+
+    // Hint for the OS on which resources to keep in video memory when it's oversubscribed.
+    // D3D12: maps to ID3D12Device1::SetResidencyPriority for committed resources. Resources with
+    //   the Maximum priority are never evicted by the residency manager, see d3d12::DeviceDesc.
+    // Vulkan: maps to VK_EXT_memory_priority when it's enabled with its memoryPriority feature in
+    //   vulkan::DeviceDesc::enabledFeatures; resources with a non-Normal priority get dedicated memory
+    //   allocations because the priority applies to the whole allocation.
+    // D3D11: ignored
+    enum class ResidencyPriority : uint8_t
+    {
+        Minimum,
+        Low,
+        Normal,
+        High,
+        Maximum
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // Texture
     //////////////////////////////////////////////////////////////////////////
@@ -402,6 +604,26 @@ namespace nvrhi
 
     NVRHI_ENUM_CLASS_FLAG_OPERATORS(SharedResourceFlags)
 
+    // Controls whether a buffer or texture gets its own memory allocation, or is placed into a memory block
+    // that is shared with other resources. Ignored for virtual, tiled, volatile and shared resources.
+    enum class ResourceAllocationMode : uint8_t
+    {
+        // D3D12: sub-allocated if d3d12::DeviceDesc::enablePlacedResourceAllocator is set, committed otherwise
+        // Vulkan: sub-allocated unless the driver prefers a dedicated allocation
+        // D3D11: ignored
+        Default,
+
+        // D3D12: always a committed resource
+        // Vulkan: always a dedicated VkDeviceMemory allocation
+        // D3D11: ignored
+        Dedicated,
+
+        // D3D12: a placed resource in an internal heap, when the resource is compatible with that
+        // Vulkan: same as Default
+        // D3D11: ignored
+        SubAllocated
+    };
+
     struct TextureDesc
     {
         uint32_t width = 1;
@@ -429,6 +651,9 @@ namespace nvrhi
         bool isVirtual = false;
         bool isTiled = false;
 
+        ResourceAllocationMode allocationMode = ResourceAllocationMode::Default;
+        ResidencyPriority residencyPriority = ResidencyPriority::Normal;
+
         Color clearValue;
         bool useClearValue = false;
 
@@ -458,6 +683,8 @@ namespace nvrhi
         constexpr TextureDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
         constexpr TextureDesc& setKeepInitialState(bool value) { keepInitialState = value; return *this; }
         constexpr TextureDesc& setSharedResourceFlags(SharedResourceFlags value) { sharedResourceFlags = value; return *this; }
+        constexpr TextureDesc& setAllocationMode(ResourceAllocationMode value) { allocationMode = value; return *this; }
+        constexpr TextureDesc& setResidencyPriority(ResidencyPriority value) { residencyPriority = value; return *this; }
         
         // Equivalent to .setInitialState(_initialState).setKeepInitialState(true)
         constexpr TextureDesc& enableAutomaticStateTracking(ResourceStates _initialState)
@@ -699,8 +926,17 @@ namespace nvrhi
 
         CpuAccessMode cpuAccess = CpuAccessMode::None;
 
+        // For buffers with cpuAccess == Write, requests memory that is both device-local and CPU-writable:
+        // resizable BAR memory on Vulkan, GPU upload heaps on D3D12. The GPU then reads the data from video memory,
+        // which suits buffers that are written once per frame and read many times. Falls back to regular upload
+        // memory when such memory is unavailable or exhausted. See Feature::DeviceLocalUploadMemory.
+        bool preferDeviceLocal = false;
+
         SharedResourceFlags sharedResourceFlags = SharedResourceFlags::None;
 
+        ResourceAllocationMode allocationMode = ResourceAllocationMode::Default;
+        ResidencyPriority residencyPriority = ResidencyPriority::Normal;
+
         constexpr BufferDesc& setByteSize(uint64_t value) { byteSize = value; return *this; }
         constexpr BufferDesc& setStructStride(uint32_t value) { structStride = value; return *this; }
         constexpr BufferDesc& setMaxVersions(uint32_t value) { maxVersions = value; return *this; }
@@ -721,6 +957,9 @@ namespace nvrhi
         constexpr BufferDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
         constexpr BufferDesc& setKeepInitialState(bool value) { keepInitialState = value; return *this; }
         constexpr BufferDesc& setCpuAccess(CpuAccessMode value) { cpuAccess = value; return *this; }
+        constexpr BufferDesc& setPreferDeviceLocal(bool value) { preferDeviceLocal = value; return *this; }
+        constexpr BufferDesc& setAllocationMode(ResourceAllocationMode value) { allocationMode = value; return *this; }
+        constexpr BufferDesc& setResidencyPriority(ResidencyPriority value) { residencyPriority = value; return *this; }
 
         // Equivalent to .setInitialState(_initialState).setKeepInitialState(true)
         constexpr BufferDesc& enableAutomaticStateTracking(ResourceStates _initialState)
@@ -1258,6 +1497,22 @@ namespace nvrhi
         SamplerDesc& setAddressW(SamplerAddressMode mode) { addressW = mode; return *this; }
         SamplerDesc& setAllAddressModes(SamplerAddressMode mode) { addressU = addressV = addressW = mode; return *this; }
         SamplerDesc& setReductionType(SamplerReductionType type) { reductionType = type; return *this; }
+
+        bool operator ==(const SamplerDesc& b) const
+        {
+            return borderColor == b.borderColor
+                && maxAnisotropy == b.maxAnisotropy
+                && mipBias == b.mipBias
+                && minFilter == b.minFilter
+                && magFilter == b.magFilter
+                && mipFilter == b.mipFilter
+                && addressU == b.addressU
+                && addressV == b.addressV
+                && addressW == b.addressW
+                && reductionType == b.reductionType;
+        }
+
+        bool operator !=(const SamplerDesc& b) const { return !(*this == b); }
     };
 
     class ISampler : public IResource
@@ -1272,12 +1527,37 @@ namespace nvrhi
     // Framebuffer
     //////////////////////////////////////////////////////////////////////////
 
+    // What happens with the contents of an attachment when a framebuffer is bound after a different framebuffer,
+    // or for the first time in a command list. Binding the same framebuffer again, also after other commands
+    // or barriers, always continues with the current contents.
+    enum class AttachmentLoadOp : uint8_t
+    {
+        Load,
+        Clear,      // clear to FramebufferAttachment::clearColor, or clearDepth and clearStencil
+        DontCare    // the previous contents are undefined
+    };
+
+    // What happens with the contents of an attachment when the render pass ends. This is a hint for tiled GPUs
+    // on Vulkan, other APIs always store. With DontCare, the attachment contents must not be needed after the
+    // draws into the framebuffer, and the draws must not require barriers after the first one, as NVRHI
+    // interrupts the render pass for them. Use setTextureState/setBufferState and commitBarriers up front.
+    enum class AttachmentStoreOp : uint8_t
+    {
+        Store,
+        DontCare
+    };
+
     struct FramebufferAttachment
     {
         ITexture* texture = nullptr;
         TextureSubresourceSet subresources = TextureSubresourceSet(0, 1, 0, 1);
         Format format = Format::UNKNOWN;
         bool isReadOnly = false;
+        AttachmentLoadOp loadOp = AttachmentLoadOp::Load;
+        AttachmentStoreOp storeOp = AttachmentStoreOp::Store;
+        Color clearColor = 0.f;
+        float clearDepth = 1.f;
+        uint8_t clearStencil = 0;
         
         constexpr FramebufferAttachment& setTexture(ITexture* t) { texture = t; return *this; }
         constexpr FramebufferAttachment& setSubresources(TextureSubresourceSet value) { subresources = value; return *this; }
@@ -1286,6 +1566,10 @@ namespace nvrhi
         constexpr FramebufferAttachment& setMipLevel(MipLevel level) { subresources.baseMipLevel = level; subresources.numMipLevels = 1; return *this; }
         constexpr FramebufferAttachment& setFormat(Format f) { format = f; return *this; }
         constexpr FramebufferAttachment& setReadOnly(bool ro) { isReadOnly = ro; return *this; }
+        constexpr FramebufferAttachment& setLoadOp(AttachmentLoadOp op) { loadOp = op; return *this; }
+        constexpr FramebufferAttachment& setStoreOp(AttachmentStoreOp op) { storeOp = op; return *this; }
+        constexpr FramebufferAttachment& setClearColor(const Color& color) { loadOp = AttachmentLoadOp::Clear; clearColor = color; return *this; }
+        constexpr FramebufferAttachment& setClearDepthStencil(float depth, uint8_t stencil = 0) { loadOp = AttachmentLoadOp::Clear; clearDepth = depth; clearStencil = stencil; return *this; }
 
         [[nodiscard]] bool valid() const { return texture != nullptr; }
     };
@@ -1444,6 +1728,17 @@ namespace nvrhi
 
         typedef RefCountPtr<IOpacityMicromap> OpacityMicromapHandle;
 
+        // One OMM array build in a ICommandList::buildOpacityMicromaps batch,
+        // with the same meaning as the parameters of ICommandList::buildOpacityMicromap.
+        struct OpacityMicromapBuildDesc
+        {
+            IOpacityMicromap* opacityMicromap = nullptr;
+            const OpacityMicromapDesc* desc = nullptr;
+
+            OpacityMicromapBuildDesc& setOpacityMicromap(IOpacityMicromap* value) { opacityMicromap = value; return *this; }
+            OpacityMicromapBuildDesc& setDesc(const OpacityMicromapDesc* value) { desc = value; return *this; }
+        };
+
         //////////////////////////////////////////////////////////////////////////
         // rt::AccelStruct
         //////////////////////////////////////////////////////////////////////////
@@ -1742,6 +2037,20 @@ namespace nvrhi
 
         typedef RefCountPtr<IAccelStruct> AccelStructHandle;
 
+        // One BLAS build or update in a ICommandList::buildBottomLevelAccelStructs batch,
+        // with the same meaning as the parameters of ICommandList::buildBottomLevelAccelStruct.
+        struct BlasBuildDesc
+        {
+            IAccelStruct* accelStruct = nullptr;
+            const GeometryDesc* pGeometries = nullptr;
+            size_t numGeometries = 0;
+            AccelStructBuildFlags buildFlags = AccelStructBuildFlags::None;
+
+            BlasBuildDesc& setAccelStruct(IAccelStruct* value) { accelStruct = value; return *this; }
+            BlasBuildDesc& setGeometries(const GeometryDesc* value, size_t count) { pGeometries = value; numGeometries = count; return *this; }
+            BlasBuildDesc& setBuildFlags(AccelStructBuildFlags value) { buildFlags = value; return *this; }
+        };
+
 
         //////////////////////////////////////////////////////////////////////////
         // Clusters
@@ -2002,6 +2311,14 @@ namespace nvrhi
         //   an error.
         bool registerSpaceIsDescriptorSet = false;
 
+        // Push descriptor layouts do not use binding set objects. Instead, the bindings are provided for every
+        // draw or dispatch using ICommandList::setPushBindings(...), and the corresponding entry in the
+        // 'bindings' array of the graphics or compute state must be NULL.
+        // Intended for small layouts whose contents change very frequently. Requires Feature::PushDescriptors.
+        // - DX12: The bindings are written into a transient binding set, see createTransientBindingSet(...).
+        // - Vulkan: Maps to VK_KHR_push_descriptor. Only one push descriptor layout is allowed per pipeline.
+        bool usePushDescriptors = false;
+
         std::vector<BindingLayoutItem> bindings;
         VulkanBindingOffsets bindingOffsets;
 
@@ -2010,6 +2327,7 @@ namespace nvrhi
         BindingLayoutDesc& setRegisterSpaceIsDescriptorSet(bool value) { registerSpaceIsDescriptorSet = value; return *this; }
         // Shortcut for .setRegisterSpace(value).setRegisterSpaceIsDescriptorSet(true)
         BindingLayoutDesc& setRegisterSpaceAndDescriptorSet(uint32_t value) { registerSpace = value; registerSpaceIsDescriptorSet = true; return *this; }
+        BindingLayoutDesc& setUsePushDescriptors(bool value) { usePushDescriptors = value; return *this; }
         BindingLayoutDesc& addItem(const BindingLayoutItem& value) { bindings.push_back(value); return *this; }
         BindingLayoutDesc& setBindingOffsets(const VulkanBindingOffsets& value) { bindingOffsets = value; return *this; }
     };
@@ -2523,6 +2841,11 @@ namespace nvrhi
         VariableRateShadingState shadingRateState;
 
         BindingLayoutVector bindingLayouts;
+
+        // Set if the pipeline is used with command signatures that have IndirectArgumentType::VertexBuffer arguments.
+        // On Vulkan, such pipelines are created with dynamic vertex strides, which requires Vulkan 1.3
+        // or VK_EXT_extended_dynamic_state, see vulkan::DeviceDesc::enabledFeatures.
+        bool indirectVertexBuffers = false;
         
         GraphicsPipelineDesc& setPrimType(PrimitiveType value) { primType = value; return *this; }
         GraphicsPipelineDesc& setPatchControlPoints(uint32_t value) { patchControlPoints = value; return *this; }
@@ -2538,6 +2861,7 @@ namespace nvrhi
         GraphicsPipelineDesc& setRenderState(const RenderState& value) { renderState = value; return *this; }
         GraphicsPipelineDesc& setVariableRateShadingState(const VariableRateShadingState& value) { shadingRateState = value; return *this; }
         GraphicsPipelineDesc& addBindingLayout(IBindingLayout* layout) { bindingLayouts.push_back(layout); return *this; }
+        GraphicsPipelineDesc& setIndirectVertexBuffers(bool value) { indirectVertexBuffers = value; return *this; }
     };
 
     class IGraphicsPipeline : public IResource
@@ -2598,6 +2922,85 @@ namespace nvrhi
 
     typedef RefCountPtr<IMeshletPipeline> MeshletPipelineHandle;
 
+    //////////////////////////////////////////////////////////////////////////
+    // Work Graphs
+    //////////////////////////////////////////////////////////////////////////
+
+    // A node of a work graph pipeline.
+    // - DX12: Requires Feature::WorkGraphs. The node is a node shader named 'name' in the shader library of the pipeline,
+    //   and the runtime builds the graph from the node declarations in the library. Only the entry nodes, which have no
+    //   producer, need to be described here, so that dispatchGraph can refer to them.
+    // - Vulkan: Requires Feature::WorkGraphEmulation. The graph is emulated with a chain of compute dispatches, and every
+    //   node must be described here and use a compute shader. An entry node is dispatched with one thread group per input
+    //   record. Every other node is dispatched indirectly after its producer node, with the DispatchIndirectArguments
+    //   that the producer has written into the backing memory at 'dispatchArgumentsOffset'. The records passed between
+    //   the nodes are application-defined structures in the backing memory. Only the backing memory is synchronized
+    //   between the producers and the consumers, with buffer barriers, so the nodes that are not each others' producers
+    //   and consumers run without barriers between them.
+    struct WorkGraphNodeDesc
+    {
+        std::string name;
+        uint32_t arrayIndex = 0;
+
+        // Vulkan only
+        ShaderHandle computeShader;
+        // Index of the node that produces the input of this node in WorkGraphPipelineDesc::nodes, which must be lower
+        // than the index of this node, or -1 for an entry node
+        int32_t producerNode = -1;
+        uint64_t dispatchArgumentsOffset = 0;
+        // Where the input records of an entry node are copied by dispatchGraph
+        uint64_t inputRecordsOffset = 0;
+
+        WorkGraphNodeDesc& setName(const std::string& value) { name = value; return *this; }
+        WorkGraphNodeDesc& setArrayIndex(uint32_t value) { arrayIndex = value; return *this; }
+        WorkGraphNodeDesc& setComputeShader(IShader* value) { computeShader = value; return *this; }
+        WorkGraphNodeDesc& setProducerNode(int32_t value) { producerNode = value; return *this; }
+        WorkGraphNodeDesc& setDispatchArgumentsOffset(uint64_t value) { dispatchArgumentsOffset = value; return *this; }
+        WorkGraphNodeDesc& setInputRecordsOffset(uint64_t value) { inputRecordsOffset = value; return *this; }
+    };
+
+    struct WorkGraphPipelineDesc
+    {
+        // DX12 only, the DXIL library with the node shaders
+        ShaderLibraryHandle shaderLibrary;
+
+        std::vector<WorkGraphNodeDesc> nodes;
+
+        // Shared by all nodes
+        BindingLayoutVector bindingLayouts;
+
+        std::string debugName;
+
+        WorkGraphPipelineDesc& setShaderLibrary(IShaderLibrary* value) { shaderLibrary = value; return *this; }
+        WorkGraphPipelineDesc& addNode(const WorkGraphNodeDesc& value) { nodes.push_back(value); return *this; }
+        WorkGraphPipelineDesc& addBindingLayout(IBindingLayout* layout) { bindingLayouts.push_back(layout); return *this; }
+        WorkGraphPipelineDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+
+        // Returns the end of the last DispatchIndirectArguments of the non-entry nodes, the space that emulated
+        // work graphs need in the backing memory besides the records
+        [[nodiscard]] NVRHI_API uint64_t getDispatchArgumentsEnd() const;
+    };
+
+    // Size of the backing memory buffer that a work graph needs, which must be a UAV buffer of at least 'minSize' bytes.
+    // Sizes between 'minSize' and 'maxSize', in steps of 'sizeGranularity', may let the graph run with more parallelism.
+    // Emulated work graphs report WorkGraphPipelineDesc::getDispatchArgumentsEnd() as the minimum, the application
+    // must add the space for its records.
+    struct WorkGraphMemoryRequirements
+    {
+        uint64_t minSize = 0;
+        uint64_t maxSize = 0;
+        uint64_t sizeGranularity = 0;
+    };
+
+    class IWorkGraphPipeline : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const WorkGraphPipelineDesc& getDesc() const = 0;
+        [[nodiscard]] virtual WorkGraphMemoryRequirements getMemoryRequirements() const = 0;
+    };
+
+    typedef RefCountPtr<IWorkGraphPipeline> WorkGraphPipelineHandle;
+
     //////////////////////////////////////////////////////////////////////////
     // Draw and Dispatch
     //////////////////////////////////////////////////////////////////////////
@@ -2608,6 +3011,33 @@ namespace nvrhi
     class ITimerQuery : public IResource { };
     typedef RefCountPtr<ITimerQuery> TimerQueryHandle;
 
+    // Result of an asynchronous readback recorded with ICommandList::readbackBuffer or readbackTexture.
+    // The data is copied into memory suballocated from a pool of readback buffers owned by the device,
+    // and that memory stays reserved until the ticket is released.
+    class IReadbackTicket : public IResource
+    {
+    public:
+        // Returns true when the command list instance that recorded the readback has finished executing on the GPU.
+        // Never blocks.
+        [[nodiscard]] virtual bool isReady() = 0;
+
+        // Returns a pointer to the read back data, or nullptr if the readback is not ready yet.
+        [[nodiscard]] virtual const void* getData() = 0;
+
+        // Total size of the data in bytes.
+        [[nodiscard]] virtual size_t getSize() const = 0;
+
+        // Distance in bytes between consecutive rows of pixels or blocks, and between depth slices of a 3D texture
+        // region. These are the pitches required by the device, which may be larger than the tightly packed pitch.
+        // Both are zero for buffers.
+        [[nodiscard]] virtual size_t getRowPitch() const = 0;
+        [[nodiscard]] virtual size_t getDepthPitch() const = 0;
+    };
+    typedef RefCountPtr<IReadbackTicket> ReadbackTicketHandle;
+
+    // Called from IDevice::runGarbageCollection on the thread that calls it, once the readback data is ready.
+    typedef std::function<void(IReadbackTicket* ticket)> ReadbackCallback;
+
     struct VertexBufferBinding
     {
         IBuffer* buffer = nullptr;
@@ -2746,6 +3176,91 @@ namespace nvrhi
         constexpr DispatchIndirectArguments& setGroups3D(uint32_t x, uint32_t y, uint32_t z) { groupsX = x; groupsY = y; groupsZ = z; return *this; }
     };
 
+    //////////////////////////////////////////////////////////////////////////
+    // Command Signatures
+    //////////////////////////////////////////////////////////////////////////
+
+    // Layout of a vertex buffer argument in a device-generated command stream.
+    // Matches D3D12_VERTEX_BUFFER_VIEW and VkBindVertexBufferIndirectCommandEXT.
+    struct IndirectVertexBufferView
+    {
+        GpuVirtualAddress bufferAddress = 0;
+        uint32_t sizeInBytes = 0;
+        uint32_t strideInBytes = 0;
+    };
+
+    // Layout of an index buffer argument in a device-generated command stream.
+    // Matches D3D12_INDEX_BUFFER_VIEW. On Vulkan, the index format is interpreted as a DXGI_FORMAT value,
+    // using VK_INDIRECT_COMMANDS_INPUT_MODE_DXGI_INDEX_BUFFER_EXT.
+    struct IndirectIndexBufferView
+    {
+        static constexpr uint32_t c_FormatR16_UINT = 57; // DXGI_FORMAT_R16_UINT
+        static constexpr uint32_t c_FormatR32_UINT = 42; // DXGI_FORMAT_R32_UINT
+
+        GpuVirtualAddress bufferAddress = 0;
+        uint32_t sizeInBytes = 0;
+        uint32_t indexFormat = c_FormatR32_UINT;
+    };
+
+    enum class IndirectArgumentType : uint8_t
+    {
+        Draw,           // DrawIndirectArguments
+        DrawIndexed,    // DrawIndexedIndirectArguments
+        VertexBuffer,   // IndirectVertexBufferView
+        IndexBuffer,    // IndirectIndexBufferView
+        PushConstants   // pushConstantByteSize bytes of push constant data
+    };
+
+    struct IndirectArgumentDesc
+    {
+        IndirectArgumentType type = IndirectArgumentType::Draw;
+
+        // Vertex buffer slot updated by a VertexBuffer argument
+        uint32_t slot = 0;
+
+        // Range of the pipeline push constants updated by a PushConstants argument, multiples of 4 bytes
+        uint32_t pushConstantOffset = 0;
+        uint32_t pushConstantByteSize = 0;
+
+        constexpr IndirectArgumentDesc& setType(IndirectArgumentType value) { type = value; return *this; }
+        constexpr IndirectArgumentDesc& setSlot(uint32_t value) { slot = value; return *this; }
+        constexpr IndirectArgumentDesc& setPushConstantOffset(uint32_t value) { pushConstantOffset = value; return *this; }
+        constexpr IndirectArgumentDesc& setPushConstantByteSize(uint32_t value) { pushConstantByteSize = value; return *this; }
+
+        // Returns the size of this argument in the command stream, in bytes
+        [[nodiscard]] NVRHI_API uint32_t getByteSize() const;
+    };
+
+    // Describes the layout of one command in a device-generated command stream: a sequence of state changes
+    // followed by exactly one draw argument, which must be the last one. The arguments are tightly packed
+    // in the order of declaration, and each command occupies byteStride bytes in the argument buffer.
+    // - DX12: Maps to ID3D12CommandSignature.
+    // - Vulkan: Maps to VkIndirectCommandsLayoutEXT, requires VK_EXT_device_generated_commands.
+    struct CommandSignatureDesc
+    {
+        static_vector<IndirectArgumentDesc, c_MaxIndirectArguments> arguments;
+
+        // Size of one command in the argument buffer, 0 means the tightly packed size of all arguments
+        uint32_t byteStride = 0;
+
+        std::string debugName;
+
+        CommandSignatureDesc& addArgument(const IndirectArgumentDesc& value) { arguments.push_back(value); return *this; }
+        CommandSignatureDesc& setByteStride(uint32_t value) { byteStride = value; return *this; }
+        CommandSignatureDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+
+        // Returns byteStride, or the total size of all arguments if byteStride is 0
+        [[nodiscard]] NVRHI_API uint32_t getCommandByteStride() const;
+    };
+
+    class ICommandSignature : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const CommandSignatureDesc& getDesc() const = 0;
+    };
+
+    typedef RefCountPtr<ICommandSignature> CommandSignatureHandle;
+
     struct MeshletState
     {
         IMeshletPipeline* pipeline = nullptr;
@@ -2756,17 +3271,59 @@ namespace nvrhi
 
         BindingSetVector bindings;
 
+        // The buffer with the DispatchIndirectArguments for dispatchMeshIndirect and dispatchMeshIndirectCount
         IBuffer* indirectParams = nullptr;
 
+        // The buffer with the dispatch count for dispatchMeshIndirectCount, may be the same as indirectParams
+        IBuffer* indirectCountBuffer = nullptr;
+
         MeshletState& setPipeline(IMeshletPipeline* value) { pipeline = value; return *this; }
         MeshletState& setFramebuffer(IFramebuffer* value) { framebuffer = value; return *this; }
         MeshletState& setViewport(const ViewportState& value) { viewport = value; return *this; }
         MeshletState& setBlendColor(const Color& value) { blendConstantColor = value; return *this; }
         MeshletState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         MeshletState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        MeshletState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
         MeshletState& setDynamicStencilRefValue(uint8_t value) { dynamicStencilRefValue = value; return *this; }
     };
 
+    struct WorkGraphState
+    {
+        IWorkGraphPipeline* pipeline = nullptr;
+
+        BindingSetVector bindings;
+
+        // The buffer that holds the records and the scheduling state of the graph while it executes,
+        // see IWorkGraphPipeline::getMemoryRequirements
+        IBuffer* backingMemory = nullptr;
+
+        // The backing memory must be initialized before the first dispatch of a pipeline with it, and after it has been
+        // used for something else. The state can be set again without initialization to continue dispatching.
+        // Emulated work graphs ignore this, the application is responsible for clearing its records.
+        bool initializeBackingMemory = true;
+
+        WorkGraphState& setPipeline(IWorkGraphPipeline* value) { pipeline = value; return *this; }
+        WorkGraphState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
+        WorkGraphState& setBackingMemory(IBuffer* value) { backingMemory = value; return *this; }
+        WorkGraphState& setInitializeBackingMemory(bool value) { initializeBackingMemory = value; return *this; }
+    };
+
+    struct WorkGraphDispatchArguments
+    {
+        // Index of the entry node in WorkGraphPipelineDesc::nodes
+        uint32_t entryNode = 0;
+
+        // Input records of the entry node, which are copied when dispatchGraph is called.
+        // Nodes without input declared still need 'numRecords' to be 1 and no records.
+        const void* records = nullptr;
+        uint32_t numRecords = 1;
+        uint32_t recordStride = 0;
+
+        WorkGraphDispatchArguments& setEntryNode(uint32_t value) { entryNode = value; return *this; }
+        WorkGraphDispatchArguments& setRecords(const void* data, uint32_t count, uint32_t stride)
+            { records = data; numRecords = count; recordStride = stride; return *this; }
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // Ray Tracing
     //////////////////////////////////////////////////////////////////////////
@@ -2811,6 +3368,9 @@ namespace nvrhi
             uint32_t maxRecursionDepth = 1;
             int32_t hlslExtensionsUAV = -1;
             bool allowOpacityMicromaps = false;
+            // D3D12 only: create the state object with D3D12_STATE_OBJECT_FLAG_ALLOW_STATE_OBJECT_ADDITIONS,
+            // so that new shaders and hit groups can be added to it with d3d12::IDevice::addToRayTracingPipeline.
+            bool allowAdditions = false;
 
             PipelineDesc& addShader(const PipelineShaderDesc& value) { shaders.push_back(value); return *this; }
             PipelineDesc& addHitGroup(const PipelineHitGroupDesc& value) { hitGroups.push_back(value); return *this; }
@@ -2820,6 +3380,28 @@ namespace nvrhi
             PipelineDesc& setMaxRecursionDepth(uint32_t value) { maxRecursionDepth = value; return *this; }
             PipelineDesc& setHlslExtensionsUAV(int32_t value) { hlslExtensionsUAV = value; return *this; }
             PipelineDesc& setAllowOpacityMicromaps(bool value) { allowOpacityMicromaps = value; return *this; }
+            PipelineDesc& setAllowAdditions(bool value) { allowAdditions = value; return *this; }
+        };
+
+        struct ShaderTableDesc
+        {
+            // If enabled, the shader table is kept in a device-local buffer across command lists and frames.
+            // setRayTracingState only uploads the records that were changed since the table was last used,
+            // with copies, and the table keeps its GPU address until it outgrows the buffer.
+            // Such tables must not be updated by multiple command lists that are recorded at the same time.
+            // If disabled, the whole table is written into upload memory when it's first used in a command list
+            // and after every change.
+            bool isPersistent = false;
+
+            // Number of records that the buffer of a persistent table is initially created for.
+            // The buffer is reallocated when the table outgrows it, which rewrites the whole table.
+            uint32_t initialCapacity = 0;
+
+            std::string debugName;
+
+            ShaderTableDesc& setIsPersistent(bool value) { isPersistent = value; return *this; }
+            ShaderTableDesc& setInitialCapacity(uint32_t value) { initialCapacity = value; return *this; }
+            ShaderTableDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
         };
 
         class IPipeline;
@@ -2827,10 +3409,16 @@ namespace nvrhi
         class IShaderTable : public IResource
         {
         public:
+            [[nodiscard]] virtual const ShaderTableDesc& getDesc() const = 0;
             virtual void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            // Replace the shader and bindings of an existing record, returned by the corresponding add* function.
+            // With persistent tables, only the replaced record is uploaded again.
+            virtual bool setMissShader(int index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            virtual bool setHitGroup(int index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            virtual bool setCallableShader(int index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual void clearMissShaders() = 0;
             virtual void clearHitShaders() = 0;
             virtual void clearCallableShaders() = 0;
@@ -2844,6 +3432,7 @@ namespace nvrhi
         public:
             [[nodiscard]] virtual const rt::PipelineDesc& getDesc() const = 0;
             virtual ShaderTableHandle createShaderTable() = 0;
+            virtual ShaderTableHandle createShaderTable(const ShaderTableDesc& desc) = 0;
         };
 
         typedef RefCountPtr<IPipeline> PipelineHandle;
@@ -3006,7 +3595,17 @@ namespace nvrhi
         VirtualResources,
         WaveLaneCountMinMax,
         CooperativeVectorInferencing,
-        CooperativeVectorTraining
+        CooperativeVectorTraining,
+        SecondaryCommandLists,
+        ReusableCommandLists,
+        DeviceGeneratedCommands,
+        RayTracingIndirectInstanceCount,
+        PushDescriptors,
+        AsyncReadback,
+        DeviceLocalUploadMemory,
+        WorkGraphs,
+        WorkGraphEmulation,
+        MeshletIndirect
     };
 
     enum class MessageSeverity : uint8_t
@@ -3026,6 +3625,23 @@ namespace nvrhi
         Count
     };
 
+    // Identifies the command lists submitted to a queue up to and including 'instance', which is a value returned by
+    // IDevice::executeCommandLists. Unlike event queries, tickets are plain values that need no allocation or reset,
+    // and any number of them can be waited for with a single IDevice::waitForAll or waitForAny call.
+    // A ticket with instance 0 is always complete. D3D11 has no submission instances, executeCommandLists returns 0
+    // there, so only the tickets returned by IDevice::getSubmissionTicket can be waited for.
+    struct SubmissionTicket
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t instance = 0;
+
+        constexpr SubmissionTicket& setQueue(CommandQueue value) { queue = value; return *this; }
+        constexpr SubmissionTicket& setInstance(uint64_t value) { instance = value; return *this; }
+
+        constexpr bool operator==(const SubmissionTicket& other) const { return queue == other.queue && instance == other.instance; }
+        constexpr bool operator!=(const SubmissionTicket& other) const { return !(*this == other); }
+    };
+
     struct VariableRateShadingFeatureInfo
     {
         uint32_t shadingRateImageTileSize;
@@ -3054,13 +3670,86 @@ namespace nvrhi
         IMessageCallback& operator=(const IMessageCallback&) = delete;
         IMessageCallback& operator=(const IMessageCallback&&) = delete;
     };
+
+    // IParallelTaskRunner can be implemented by the application to let NVRHI use its job system threads
+    // for long-running internal work, such as ray tracing pipeline compilation on Vulkan.
+    class IParallelTaskRunner
+    {
+    protected:
+        IParallelTaskRunner() = default;
+        virtual ~IParallelTaskRunner() = default;
+
+    public:
+        // Must call 'task' on up to 'maxConcurrency' threads at the same time, one of which may be the calling thread,
+        // and return when all calls have returned. 'maxConcurrency' can be very large, meaning "as many as available".
+        // Each call returns when there is no more work that it can help with, so it's fine to use fewer threads.
+        virtual void runParallel(uint32_t maxConcurrency, const std::function<void()>& task) = 0;
+
+        IParallelTaskRunner(const IParallelTaskRunner&) = delete;
+        IParallelTaskRunner(const IParallelTaskRunner&&) = delete;
+        IParallelTaskRunner& operator=(const IParallelTaskRunner&) = delete;
+        IParallelTaskRunner& operator=(const IParallelTaskRunner&&) = delete;
+    };
     
+    static constexpr uint32_t c_InvalidProfilerScope = ~0u;
+
+    // A pair of beginMarker / endMarker calls timed by the GPU profiler, see DeviceDesc::enableMarkerProfiling
+    // on D3D12 and Vulkan.
+    struct ProfilerScope
+    {
+        std::string name;
+
+        // Index of the enclosing scope in ProfilerQueueResults::scopes, or c_InvalidProfilerScope for the outermost
+        // scopes of a command list. Parents always come before their children.
+        uint32_t parentIndex = c_InvalidProfilerScope;
+        uint32_t depth = 0;
+
+        // GPU timestamps in ticks of ProfilerQueueResults::timestampFrequency
+        uint64_t gpuBeginTimestamp = 0;
+        uint64_t gpuEndTimestamp = 0;
+
+        // The GPU timestamps converted to the std::chrono::steady_clock timeline in nanoseconds, so that they can be
+        // shown together with CPU timings. Only valid when ProfilerQueueResults::calibrated is true.
+        int64_t cpuBeginTimeNs = 0;
+        int64_t cpuEndTimeNs = 0;
+    };
+
+    struct ProfilerQueueResults
+    {
+        // The scopes of all command lists executed on the queue, in submission order
+        std::vector<ProfilerScope> scopes;
+
+        // GPU timestamp ticks per second
+        uint64_t timestampFrequency = 0;
+
+        // True if the GPU and CPU clocks of the queue could be correlated and the cpu*TimeNs members are valid
+        bool calibrated = false;
+
+        [[nodiscard]] double getDurationSeconds(const ProfilerScope& scope) const
+        {
+            return timestampFrequency ? double(scope.gpuEndTimestamp - scope.gpuBeginTimestamp) / double(timestampFrequency) : 0.0;
+        }
+    };
+
+    struct ProfilerFrameResults
+    {
+        // Frames are counted by runGarbageCollection calls: command lists submitted after the N'th call
+        // belong to frame N.
+        uint64_t frameIndex = 0;
+
+        ProfilerQueueResults queues[size_t(CommandQueue::Count)];
+
+        // Scopes that were not timed because the timer query pool was exhausted
+        uint32_t droppedScopes = 0;
+    };
+
     class IDevice;
 
     struct CommandListParameters
     {
         // A command list with enableImmediateExecution = true maps to the immediate context on DX11.
         // Two immediate command lists cannot be open at the same time, which is checked by the validation layer.
+        // Otherwise, the DX11 command list records into a deferred context.
         bool enableImmediateExecution = true;
 
         // Minimum size of memory chunks created to upload data to the device on DX12.
@@ -3076,11 +3765,44 @@ namespace nvrhi
         // COPY and COMPUTE queues have limited subsets of methods available.
         CommandQueue queueType = CommandQueue::Graphics;
 
+        // Creates a secondary command list that records draws for a part of a render pass, so that one pass can be
+        // recorded on multiple threads. See ICommandList::openSecondary(...) and executeSecondaryCommandLists(...).
+        // Requires queueType = Graphics and support for Feature::SecondaryCommandLists.
+        bool isSecondary = false;
+
+        // Creates a command list that is recorded once and can then be passed to executeCommandLists(...) any number
+        // of times, until it is opened again. Resource state transitions, uploads and volatile constant buffer
+        // contents are captured at recording time and replayed as-is on every execution.
+        // Textures and buffers used in a reusable command list must have keepInitialState = true or a permanent state,
+        // or be declared with beginTrackingTextureState / beginTrackingBufferState, so that the states on entry
+        // and exit are the same for every execution. Volatile constant buffers must be written in the command list
+        // itself before they are used, which the validation layer checks on every draw and dispatch, and their
+        // versions stay reserved until the command list is re-opened or destroyed.
+        // Requires support for Feature::ReusableCommandLists. Cannot be combined with isSecondary.
+        bool isReusable = false;
+
         CommandListParameters& setEnableImmediateExecution(bool value) { enableImmediateExecution = value; return *this; }
         CommandListParameters& setUploadChunkSize(size_t value) { uploadChunkSize = value; return *this; }
         CommandListParameters& setScratchChunkSize(size_t value) { scratchChunkSize = value; return *this; }
         CommandListParameters& setScratchMaxMemory(size_t value) { scratchMaxMemory = value; return *this; }
         CommandListParameters& setQueueType(CommandQueue value) { queueType = value; return *this; }
+        CommandListParameters& setIsSecondary(bool value) { isSecondary = value; return *this; }
+        CommandListParameters& setIsReusable(bool value) { isReusable = value; return *this; }
+    };
+
+    // Memory region returned by ICommandList::beginWriteTexture and beginWriteBuffer that the application fills
+    // directly before calling commitWrite. 'data' is null if the region couldn't be allocated.
+    struct MappedWriteRegion
+    {
+        void* data = nullptr;
+
+        // Distance in bytes between consecutive rows of pixels or blocks, and between depth slices of a 3D texture.
+        // Both are zero for buffers.
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+
+        // Total size of the region in bytes.
+        size_t size = 0;
     };
     
     //////////////////////////////////////////////////////////////////////////
@@ -3088,8 +3810,10 @@ namespace nvrhi
     //////////////////////////////////////////////////////////////////////////
 
     // Represents a sequence of GPU operations.
-    // - DX11: All command list objects map to the single immediate context. Only one command list may be in the open
-    //   state at any given time, and all command lists must have CommandListParameters::enableImmediateExecution = true.
+    // - DX11: Command lists with CommandListParameters::enableImmediateExecution = true map to the single immediate
+    //   context, and only one of them may be in the open state at any given time. Other command lists record into their
+    //   own deferred contexts, possibly on different threads, and are played back by IDevice::executeCommandLists.
+    //   Deferred command lists cannot perform partial writes to buffers with CpuAccessMode::Write.
     // - DX12: One command list object may contain multiple instances of ID3D12GraphicsCommandList* and
     //   ID3D12CommandAllocator objects, reusing older ones as they finish executing on the GPU. A command list object
     //   also contains the upload manager (for suballocating memory from the upload heap on operations such as
@@ -3115,6 +3839,25 @@ namespace nvrhi
         // Re-opening the command list without execution is allowed but not well-tested.
         virtual void close() = 0;
 
+        // Opens a secondary command list for recording draws into a render pass that uses 'framebuffer',
+        // with the viewports and scissor rects from 'viewport'. Secondary command lists are recorded like primary ones,
+        // and different secondary command lists can be recorded on different threads, with these restrictions:
+        // - Only setGraphicsState, setPushConstants, draw* and marker commands may be recorded.
+        // - GraphicsState::framebuffer must be the framebuffer passed here, and GraphicsState::viewport is ignored.
+        // - No barriers are placed. The primary command list must transition all resources used by the secondary
+        //   command list into the required states before executing it, e.g. with setResourceStatesForBindingSet(...).
+        // The secondary command list is closed with close() and executed with executeSecondaryCommandLists(...)
+        // on the primary command list, exactly once, before it can be opened again.
+        // - DX12: Records a bundle.
+        // - Vulkan: Records a secondary command buffer that continues a dynamic rendering pass.
+        // - DX11: Not supported.
+        virtual void openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport) = 0;
+
+        // Executes the closed secondary command lists in the order they are provided, each inside a render pass
+        // that uses its framebuffer. The graphics state of this command list is reset afterwards, so it needs
+        // to be set again with setGraphicsState(...) before any further draws.
+        virtual void executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists) = 0;
+
         // Resets the NVRHI state cache associated with the command list, clears some of the underlying API state.
         // This method is mostly useful when switching from recording commands to the open command list using 
         // non-NVRHI code - see getNativeObject(...) - to recording further commands using NVRHI.
@@ -3169,6 +3912,22 @@ namespace nvrhi
         virtual void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data,
             size_t rowPitch, size_t depthPitch = 0) = 0;
 
+        // Two-phase version of writeTexture that lets the application write the texture data directly into upload
+        // memory, avoiding an intermediate copy. The returned region uses the row and depth pitch required by the device,
+        // which may be larger than the tightly packed pitch. The region must be fully written before commitWrite(...) is
+        // called, and no other commands may be recorded into this command list between the two calls.
+        // - DX11: The region is temporary CPU memory that is passed to UpdateSubresource on commit.
+        // - DX12, Vulkan: The region is suballocated from the automatic upload buffer, and the copy into the texture
+        //   is recorded on commit.
+        virtual MappedWriteRegion beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) = 0;
+
+        // Two-phase version of writeBuffer, see beginWriteTexture(...). The returned region has the size 'dataSize'.
+        virtual MappedWriteRegion beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes = 0) = 0;
+
+        // Records the copy of the data written into the region returned by the last beginWriteTexture or
+        // beginWriteBuffer call into the destination resource.
+        virtual void commitWrite() = 0;
+
         // Performs a resolve operation to combine samples from some or all subresources of a multisample texture 'src'
         // into matching subresources of a non-multisample texture 'dest'. Both textures' formats must be of color type.
         // - DX11/12: Maps to a sequence of ResolveSubresource calls, one per subresource.
@@ -3207,6 +3966,25 @@ namespace nvrhi
         virtual void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes,
             uint64_t dataSizeBytes) = 0;
 
+        // Records an asynchronous readback of 'sizeBytes' bytes of buffer 'b' starting at 'offsetBytes', and returns
+        // a ticket that can be polled for the data without blocking. If 'callback' is provided, it is called
+        // from the first IDevice::runGarbageCollection after the data becomes ready, even if the application
+        // has released the ticket. Returns nullptr if the readback memory couldn't be allocated.
+        // Readbacks can not be recorded into secondary or reusable command lists.
+        // - DX11: Not supported.
+        // - DX12: Maps to CopyBufferRegion into a suballocated region of a readback heap buffer.
+        // - Vulkan: Maps to vkCmdCopyBuffer into a suballocated region of a host-visible buffer.
+        virtual ReadbackTicketHandle readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes,
+            ReadbackCallback callback = nullptr) = 0;
+
+        // Records an asynchronous readback of a single 2D or 3D region of texture data, see readbackBuffer(...).
+        // The rows of the returned data are placed with the ticket's row and depth pitch.
+        // - DX11: Not supported.
+        // - DX12: Maps to CopyTextureRegion into a placed footprint in a readback heap buffer.
+        // - Vulkan: Maps to vkCmdCopyImageToBuffer.
+        virtual ReadbackTicketHandle readbackTexture(ITexture* texture, const TextureSlice& slice,
+            ReadbackCallback callback = nullptr) = 0;
+
         // Clears the entire sampler feedback texture.
         // - DX12: Maps to ClearUnorderedAccessViewUint.
         // - DX11, Vulkan: Unsupported.
@@ -3239,6 +4017,32 @@ namespace nvrhi
         // Note that NVRHI only supports one push constants binding in all layouts used in a pipeline.
         virtual void setPushConstants(const void* data, size_t byteSize) = 0;
 
+        // Sets the bindings for a push descriptor layout (see BindingLayoutDesc::usePushDescriptors) in the
+        // currently set pipeline, without creating a binding set object. 'layoutIndex' is the index of the layout
+        // in the pipeline's binding layout array. Like setPushConstants, this must be called after setting
+        // the graphics, compute, ray tracing or meshlet state, and changing the state invalidates the bindings.
+        // The resources are not transitioned by this call: they must either have permanent states, or their
+        // states must be set with setTextureState / setBufferState before the state is set.
+        // Volatile constant buffers are bound with the contents written before this call.
+        // The resources are kept alive until the command list finishes executing if 'trackLiveness' is set.
+        // - DX11: Not supported.
+        // - DX12: Creates the descriptors in the shader-visible heap and binds them as a descriptor table.
+        // - Vulkan: Maps to vkCmdPushDescriptorSetKHR.
+        virtual void setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings) = 0;
+
+        // Creates a binding set that is only valid for use in this command list, until it is closed.
+        // The descriptors are linearly allocated from memory owned by the command list and are all recycled
+        // at once when the command list finishes executing, which is much cheaper than createBindingSet(...)
+        // for sets that are used for a single draw or dispatch. The returned set must not be used in other
+        // command lists or after the command list is opened again, even if the handle is still held.
+        // - DX11: Maps to IDevice::createBindingSet.
+        // - DX12: Allocates the descriptors from chunks of the shader-visible heap owned by the command list.
+        //   Chunks hold 256 SRV/UAV/CBV or 16 sampler descriptors, and transient sets use at most a quarter of each heap.
+        //   Sets that need more descriptors than one chunk holds, or that don't fit, fall back to regular allocation.
+        // - Vulkan: Allocates the descriptor set from pools owned by the command buffer, which are reset
+        //   when it is retired. With descriptor buffers, the set is placed in a transient descriptor buffer range.
+        virtual BindingSetHandle createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) = 0;
+
         // Sets the specified graphics state on the command list.
         // The state includes the pipeline (or individual shaders on DX11) and all resources bound to it,
         // from input buffers to render targets. See the members of GraphicsState for more information.
@@ -3249,6 +4053,20 @@ namespace nvrhi
         // state. To avoid these issues, call clearState() when switching from direct command list access to NVRHI.
         virtual void setGraphicsState(const GraphicsState& state) = 0;
 
+        // Replaces one binding set in the graphics state set by the last setGraphicsState(...) call.
+        // Only the new binding set is transitioned and bound, the rest of the state is not re-validated.
+        // Must only be used after setGraphicsState(...), with no other type of pipeline state set in between.
+        virtual void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) = 0;
+
+        // Replaces the vertex buffer bindings for the slots used in pBindings, in the graphics state set by the
+        // last setGraphicsState(...) call. Bindings for other slots are not modified.
+        // Same usage rules as setGraphicsBindingSet(...) apply.
+        virtual void setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings) = 0;
+
+        // Replaces the index buffer binding in the graphics state set by the last setGraphicsState(...) call.
+        // Same usage rules as setGraphicsBindingSet(...) apply.
+        virtual void setIndexBuffer(const IndexBufferBinding& binding) = 0;
+
         // Draws non-indexed primitivies using the current graphics state.
         // setGraphicsState(...) must be called between opening the command list or using other types of pipelines
         // and calling draw(...) or any of its siblings. If the pipeline uses push constants, those must be set
@@ -3265,6 +4083,24 @@ namespace nvrhi
         // - Vulkan: Maps to vkCmdDrawIndexed.
         virtual void drawIndexed(const DrawArguments& args) = 0;
 
+        // Issues 'count' non-indexed draws with the current graphics state, validating that state only once.
+        // If pushConstants is not NULL, pushConstantByteSize bytes starting at (pushConstants + i * pushConstantStride)
+        // are set as push constants before draw 'i'; a stride of 0 means the blocks are tightly packed.
+        // The byte size must match the pipeline push constant size, same as for setPushConstants(...).
+        // If pushConstants is NULL, all draws use the push constants set previously.
+        // - DX11/12: Maps to a loop over DrawInstanced, with root constant updates in between.
+        // - Vulkan: Maps to vkCmdDrawMultiEXT when VK_EXT_multi_draw is enabled with its multiDraw feature in
+        //   vulkan::DeviceDesc::enabledFeatures and the draws don't have per-draw push constants and share
+        //   the instance range, otherwise to a loop over vkCmdDraw.
+        virtual void drawBatch(const DrawArguments* args, size_t count,
+            const void* pushConstants = nullptr, size_t pushConstantByteSize = 0, size_t pushConstantStride = 0) = 0;
+
+        // Indexed version of drawBatch(...).
+        // - DX11/12: Maps to a loop over DrawIndexedInstanced, with root constant updates in between.
+        // - Vulkan: Maps to vkCmdDrawMultiIndexedEXT or a loop over vkCmdDrawIndexed, see drawBatch(...).
+        virtual void drawIndexedBatch(const DrawArguments* args, size_t count,
+            const void* pushConstants = nullptr, size_t pushConstantByteSize = 0, size_t pushConstantStride = 0) = 0;
+
         // Draws one or multiple sets of non-indexed primitives using the parameters provided in the indirect buffer
         // specified in the prior call to setGraphicsState(...). The memory layout in the buffer is the same for all
         // graphics APIs and is described by the DrawIndirectArguments structure. If drawCount is more than 1,
@@ -3298,6 +4134,21 @@ namespace nvrhi
         // - Vulkan: Maps to vkCmdDrawIndexedIndirectCount.
         virtual void drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount) = 0;
 
+        // Executes up to maxCommandCount commands from a device-generated command stream, which can change the vertex
+        // buffers, index buffer and push constants between draws. The command layout is described by the signature,
+        // and the commands are read from the indirect buffer specified in the prior call to setGraphicsState(...),
+        // starting at offsetBytes. If countBuffer is not NULL, the number of commands is the minimum of
+        // maxCommandCount and the 32-bit value in countBuffer at countBufferOffset.
+        // The current graphics pipeline must be the one that the signature was created for, or use the same binding
+        // layouts. The buffers referenced by the generated vertex and index buffer views are not tracked, they must be
+        // placed into the VertexBuffer and IndexBuffer states by the application. After the call, the vertex buffers,
+        // index buffer and push constants changed by the signature arguments are undefined and must be set again.
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with the custom signature.
+        // - Vulkan: Maps to vkCmdExecuteGeneratedCommandsEXT.
+        virtual void executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount,
+            IBuffer* countBuffer = nullptr, uint32_t countBufferOffset = 0) = 0;
+
         // Sets the specified compute state on the command list.
         // The state includes the pipeline (or individual shaders on DX11) and all resources bound to it.
         // See the members of ComputeState for more information.
@@ -3333,9 +4184,42 @@ namespace nvrhi
         // replacing graphics with meshlets.
         // - DX11: Not supported.
         // - DX12: Maps to DispatchMesh.
-        // - Vulkan: Maps to vkCmdDispatchMesh.
+        // - Vulkan: Maps to vkCmdDrawMeshTasksEXT, or to vkCmdDrawMeshTasksNV, which only supports 1D dispatches.
         virtual void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
 
+        // Draws meshlet primitives using the parameters provided in the indirect buffer specified in the prior call
+        // to setMeshletState(...). The memory layout in the buffer is described by the DispatchIndirectArguments
+        // structure. If dispatchCount is more than 1, the parameter structures are tightly packed one after another.
+        // Requires Feature::MeshletIndirect.
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with a predefined signature.
+        // - Vulkan: Maps to vkCmdDrawMeshTasksIndirectEXT, requires VK_EXT_mesh_shader.
+        virtual void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount = 1) = 0;
+
+        // Same as dispatchMeshIndirect(...), but the number of dispatches is the minimum of maxDispatchCount and
+        // the 32-bit value at countBufferOffset in the count buffer specified in the prior call to setMeshletState(...).
+        // Requires Feature::MeshletIndirect.
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with a predefined signature and a count buffer.
+        // - Vulkan: Maps to vkCmdDrawMeshTasksIndirectCountEXT, requires VK_EXT_mesh_shader.
+        virtual void dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount) = 0;
+
+        // Sets the specified work graph state on the command list.
+        // The state includes the pipeline, all resources bound to it, and the backing memory.
+        // Work graphs are supported natively on DX12 with Feature::WorkGraphs, and emulated on Vulkan with
+        // Feature::WorkGraphEmulation, see WorkGraphNodeDesc for the differences.
+        // See the comment to setGraphicsState(...) for information on state caching.
+        virtual void setWorkGraphState(const WorkGraphState& state) = 0;
+
+        // Launches the work graph from one of its entry nodes using the current work graph state.
+        // See the comment to draw(...) for information on state setting, push constants, and volatile constant buffers,
+        // replacing graphics with work graphs.
+        // - DX11: Not supported.
+        // - DX12: Maps to DispatchGraph with CPU input records.
+        // - Vulkan: Copies the records into the backing memory, then maps to vkCmdDispatch for the entry node and
+        //   vkCmdDispatchIndirect for the nodes that it feeds, with buffer barriers on the backing memory between them.
+        virtual void dispatchGraph(const WorkGraphDispatchArguments& args) = 0;
+
         // Sets the specified ray tracing state on the command list.
         // The state includes the shader table, which references the pipeline, and all bound resources.
         // Not supported on DX11.
@@ -3360,6 +4244,28 @@ namespace nvrhi
         // - DX12: Maps to NvAPI_D3D12_BuildRaytracingOpacityMicromapArray and requires NVAPI.
         // - Vulkan: Maps to vkCmdBuildMicromapsEXT.
         virtual void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) = 0;
+
+        // Builds multiple independent OMM arrays, with the same rules as buildOpacityMicromap for each one.
+        // The scratch memory for the batch is suballocated at once, and all the builds are recorded without barriers
+        // between them, so the GPU can execute them concurrently. Each OMM array can only appear once in a batch.
+        // - DX11: Not supported.
+        // - DX12: Maps to back-to-back BuildRaytracingAccelerationStructure calls with DXR 1.2,
+        //   or NvAPI_D3D12_BuildRaytracingOpacityMicromapArray calls with NVAPI.
+        // - Vulkan: Maps to one vkCmdBuildMicromapsEXT call with all the builds.
+        virtual void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds) = 0;
+
+        // Compacts the OMM arrays that are currently available for compaction, i.e. those that were built with
+        // the AllowCompaction flag by command lists that have finished executing, up to the total size given by
+        // DeviceDesc::blasCompactionBudget. Call this once per frame to compact streamed OMM arrays in the background.
+        // Compaction moves an OMM array to new memory: BLASes that reference it must be built after it is compacted,
+        // which can be checked with isCompacted(), or rebuilt.
+        // - DX11: Not supported.
+        // - DX12: Maps to CopyRaytracingAccelerationStructure with DXR 1.2. OMM arrays built through NVAPI are not compacted.
+        //   Every OMM array is a separate buffer with the 64 KB granularity of placed resources, so compaction only
+        //   saves memory for arrays that are larger than that.
+        // - Vulkan: Maps to vkCmdCopyMicromapEXT.
+        // If NVRHI is built with RTXMU enabled, OMM arrays are not compacted.
+        virtual void compactOpacityMicromaps() = 0;
         
         // Builds or updates a bottom-level ray tracing acceleration structure (BLAS).
         // A temporary memory region for the build is suballocated using the scratch buffer manager attached to the
@@ -3380,10 +4286,29 @@ namespace nvrhi
         // Note that RTXMU currently doesn't support OMM or LSS.
         virtual void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries,
             size_t numGeometries, rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
+        // Builds or updates multiple independent BLASes, with the same rules as buildBottomLevelAccelStruct for each one.
+        // This is much faster than calling buildBottomLevelAccelStruct in a loop for many small BLASes: the scratch memory
+        // for the batch is suballocated at once, and all the builds are recorded without barriers between them, so the GPU
+        // can execute them concurrently. Each BLAS can only appear once in a batch.
+        // - DX11: Not supported.
+        // - DX12: Maps to back-to-back BuildRaytracingAccelerationStructure calls.
+        // - Vulkan: Maps to one vkCmdBuildAccelerationStructuresKHR call with all the builds.
+        // If NVRHI is built with RTXMU enabled, the builds are passed to RTXMU individually.
+        virtual void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) = 0;
         
-        // Compacts all bottom-level ray tracing acceleration structures (BLASes) that are currently available
-        // for compaction. This process is handled by the RTXMU library. If NVRHI is built without RTXMU,
-        // this function has no effect.
+        // Compacts the bottom-level ray tracing acceleration structures (BLASes) that are currently available
+        // for compaction, i.e. those that were built with the AllowCompaction flag by command lists that have
+        // finished executing. Call this once per frame to compact the BLASes in the background.
+        // Compaction moves a BLAS to new memory, so its device address changes: top-level acceleration structures
+        // that reference a BLAS must be rebuilt after it is compacted, which can be checked with isCompacted().
+        // - DX11: Not supported.
+        // - DX12 and Vulkan without RTXMU: The compacted sizes are written by the builds and read when the command
+        //   lists are retired, without stalls. This function compacts the BLASes up to the total size given by
+        //   DeviceDesc::blasCompactionBudget, and releases the original memory when this command list finishes executing.
+        //   Virtual BLASes are not compacted. On DX12, every BLAS is a separate buffer placed into the shared heaps,
+        //   which are 64 KB granular, so compaction only saves memory for BLASes that are larger than that.
+        // - With RTXMU: This process is handled by the RTXMU library.
         virtual void compactBottomLevelAccelStructs() = 0;
 
         // Builds or updates a top-level ray tracing acceleration structure (TLAS).
@@ -3403,6 +4328,7 @@ namespace nvrhi
 
         // Performs one of the supported operations on clustered ray tracing acceleration structures (CLAS).
         // See the comments to rt::cluster::OperationDesc for more information.
+        // utils::ClusterOperationPool can provide the scratch sizes and output buffers for repeated operations.
         // - DX11: Not supported.
         // - DX12: Maps to NvAPI_D3D12_RaytracingExecuteMultiIndirectClusterOperation and requires NVAPI.
         // - Vulkan: Not supported.
@@ -3420,6 +4346,23 @@ namespace nvrhi
             uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
 
+        // Builds a TLAS from a GPU instance buffer, like buildTopLevelAccelStructFromBuffer(...), with the number
+        // of instances determined on the GPU. The count is read from an rt::IndirectTlasBuildArgs structure in
+        // 'argsBuffer' at 'argsBufferOffset', which must be created with isDrawIndirectArgs = true.
+        // The count must not exceed 'maxInstances', which determines the required TLAS and scratch sizes.
+        // When Feature::RayTracingIndirectInstanceCount is not supported, the TLAS is built with 'maxInstances'
+        // instances, and the instances past the GPU count must be inactive, i.e. have blasDeviceAddress = 0.
+        // rt::CullTlasInstance(...) in nvrhiHLSL.h and utils::TlasInstanceCullingPass produce such buffers.
+        // Updates (AccelStructBuildFlags::PerformUpdate) are not supported because the count is not known.
+        // - DX11: Not supported.
+        // - DX12: Maps to BuildRaytracingAccelerationStructure with 'maxInstances' instances.
+        // - Vulkan: Maps to vkCmdBuildAccelerationStructuresIndirectKHR if accelerationStructureIndirectBuild
+        //   is enabled in vulkan::DeviceDesc::enabledFeatures, or to vkCmdBuildAccelerationStructuresKHR with
+        //   'maxInstances' instances otherwise.
+        virtual void buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer,
+            uint64_t instanceBufferOffset, nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
         // Converts one or several CoopVec compatible matrices between layouts in GPU memory.
         // Source and destination buffers must be different.
         // - DX11: Not supported.
@@ -3450,6 +4393,8 @@ namespace nvrhi
         // - DX12: Maps to PIXBeginEvent.
         // - Vulkan: Maps to cmdBeginDebugUtilsLabelEXT or cmdDebugMarkerBeginEXT.
         // If Nsight Aftermath integration is enabled, also calls GFSDK_Aftermath_SetEventMarker on DX11 and DX12.
+        // If the GPU profiler is enabled on DX12 or Vulkan, the range is also timed, see IDevice::getProfilerFrameResults.
+        // Ranges that are still open when the command list is closed end there.
         virtual void beginMarker(const char* name) = 0;
 
         // Places a debug marker denoting the end of a range of commands in the command list.
@@ -3534,6 +4479,34 @@ namespace nvrhi
         // Has no effect on DX11.
         virtual void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) = 0;
 
+        // Starts transitioning the entire texture into the state of its next use, so that the GPU can overlap
+        // the transition with the commands recorded until that use. The transition completes on the next
+        // operation that requires a state for this texture. The texture must not be used by the commands
+        // recorded in between, except through that operation.
+        // Uses split barriers on DX12, and events on Vulkan when synchronization2 is available; otherwise the
+        // transition is simply placed at the point of use. Textures tracked per subresource are not affected.
+        // Has no effect on DX11.
+        virtual void beginTextureStateTransition(ITexture* texture, ResourceStates nextState) = 0;
+
+        // Starts transitioning the buffer into the state of its next use.
+        // See the comment to beginTextureStateTransition(...) for more information.
+        virtual void beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState) = 0;
+
+        // Places an aliasing barrier between two virtual resources whose memory overlaps in the same heap,
+        // see bindTextureMemory(...) and bindBufferMemory(...). Call it after the last use of 'resourceBefore'
+        // and before the first use of 'resourceAfter'. Either resource may be null, which means that any resource
+        // may have used the memory before, or will use it after.
+        // The contents of 'resourceAfter' are undefined after the barrier, so it must be cleared or fully
+        // overwritten before it is read. Pending barriers are committed before the aliasing barrier.
+        // - DX11: Has no effect.
+        // - DX12: Maps to a D3D12_RESOURCE_BARRIER_TYPE_ALIASING barrier, followed by a transition into the render
+        //   target or depth write state and DiscardResource for render target and depth-stencil textures, which must
+        //   be initialized that way. With Enhanced Barriers, maps to a global barrier, and the next transition of
+        //   a 'resourceAfter' texture discards its contents.
+        // - Vulkan: Maps to a global memory barrier, and 'resourceAfter' is transitioned from an undefined
+        //   layout on its next use.
+        virtual void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) = 0;
+
         // Flushes the barriers from the pending list into the graphics API command list.
         // Has no effect on DX11.
         virtual void commitBarriers() = 0;
@@ -3554,6 +4527,10 @@ namespace nvrhi
 
         // Returns the CommandListParameters structure that was used to create the command list. 
         virtual const CommandListParameters& getDesc() = 0;
+
+        // Returns the counters of the work recorded since the command list was opened, see CommandListStats.
+        // The counters are reset by open(), and added to DeviceStats when the command list is executed.
+        virtual CommandListStats getStats() = 0;
     };
 
     typedef RefCountPtr<ICommandList> CommandListHandle;
@@ -3597,18 +4574,31 @@ namespace nvrhi
         virtual ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) = 0;
         virtual ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) = 0;
         
+        // Samplers are immutable, so implementations may return the same object for equal descs (DX12 does).
         virtual SamplerHandle createSampler(const SamplerDesc& d) = 0;
 
         // Note: vertexShader is only necessary on D3D11, otherwise it may be null
         virtual InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) = 0;
         
-        // Event queries
+        // Event queries. On Vulkan, D3D12 and the null device, they are tickets held in objects that the device recycles,
+        // so creating and releasing them is cheap.
         virtual EventQueryHandle createEventQuery() = 0;
         virtual void setEventQuery(IEventQuery* query, CommandQueue queue) = 0;
         virtual bool pollEventQuery(IEventQuery* query) = 0;
         virtual void waitEventQuery(IEventQuery* query) = 0;
         virtual void resetEventQuery(IEventQuery* query) = 0;
 
+        // Returns a ticket for the command lists submitted to the queue so far, like setting an event query on it
+        virtual SubmissionTicket getSubmissionTicket(CommandQueue queue) = 0;
+        virtual bool pollSubmission(const SubmissionTicket& ticket) = 0;
+        // Block the calling thread until all, or at least one, of the submissions have completed, or until
+        // 'timeoutNanoseconds' have passed. Returns false on timeout, device removal, or if a ticket refers to
+        // an instance that has not been submitted yet. Waiting for zero tickets succeeds in waitForAll
+        // and fails in waitForAny. The waits map to one vkWaitSemaphores call on Vulkan and one
+        // SetEventOnMultipleFenceCompletion call on D3D12.
+        virtual bool waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds = ~0ull) = 0;
+        virtual bool waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds = ~0ull) = 0;
+
         // Timer queries - see also begin/endTimerQuery in ICommandList
         virtual TimerQueryHandle createTimerQuery() = 0;
         virtual bool pollTimerQuery(ITimerQuery* query) = 0;
@@ -3633,7 +4623,13 @@ namespace nvrhi
         [[deprecated("Use createMeshletPipeline with FramebufferInfo instead")]]
         virtual MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) = 0;
 
+        virtual WorkGraphPipelineHandle createWorkGraphPipeline(const WorkGraphPipelineDesc& desc) = 0;
+
         virtual rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) = 0;
+
+        // Creates a signature for executeIndirect(...) that can be used with the provided pipeline and other pipelines
+        // with the same binding layouts. Requires Feature::DeviceGeneratedCommands.
+        virtual CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline) = 0;
         
         virtual BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) = 0;
         virtual BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) = 0;
@@ -3653,6 +4649,10 @@ namespace nvrhi
         virtual CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) = 0;
         virtual uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
         virtual void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) = 0;
+        // Submits the command lists that executeCommandLists has accumulated on all queues when deferred submission
+        // is enabled with DeviceDesc::enableDeferredSubmission, see that option. Does nothing otherwise.
+        // IMPORTANT: Call this method before presenting a frame that uses deferred submission.
+        virtual void flushSubmissions() = 0;
         // returns true if the wait completes successfully, false if detecting a problem (e.g. device removal)
         virtual bool waitForIdle() = 0;
 
@@ -3660,10 +4660,50 @@ namespace nvrhi
         // IMPORTANT: Call this method at least once per frame.
         virtual void runGarbageCollection() = 0;
 
+        // Same as runGarbageCollection(), except that the references of the retired command lists are queued, and only
+        // the oldest queued resources are released until about 'maxReleaseMicroseconds' have passed. This spreads the
+        // destruction of many resources, e.g. when a level is unloaded, over several frames. The queue only holds
+        // resources that the GPU has finished using. Calling the version without a budget releases the whole queue,
+        // which is necessary when the application relies on the resources being destroyed, e.g. before resizing a swap chain.
+        // D3D11 and the null backend release everything right away.
+        virtual void runGarbageCollection(uint32_t maxReleaseMicroseconds) = 0;
+
+        // Drops the framebuffers cached with DeviceDesc::enableFramebufferCache that use 'texture' as an attachment,
+        // or all cached framebuffers if 'texture' is NULL. The cache keeps the attachments alive for up to two
+        // runGarbageCollection calls after the application releases them, so call this before releasing textures
+        // that must go away right away, e.g. the swap chain back buffers before resizing the swap chain.
+        // Framebuffers that the application still holds stay valid. Does nothing without the cache.
+        virtual void evictCachedFramebuffers(ITexture* texture = nullptr) = 0;
+
         virtual bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) = 0;
 
         virtual FormatSupport queryFormatSupport(Format format) = 0;
 
+        // Returns the current statistics of the resource memory allocator, see MemoryAllocatorStats.
+        virtual MemoryAllocatorStats getMemoryAllocatorStats() = 0;
+
+        // Returns the current memory usage and budget of the device memory heaps, see MemoryBudget.
+        virtual MemoryBudget getMemoryBudget() = 0;
+
+        // Returns the current statistics of the ray tracing acceleration structures, see AccelStructStats.
+        virtual AccelStructStats getAccelStructStats() = 0;
+
+        // Returns the device-wide counters of live objects, descriptor heaps, upload memory and
+        // executed command lists, see DeviceStats.
+        virtual DeviceStats getDeviceStats() = 0;
+
+        // Takes the marker timings of the oldest frame whose command lists have all finished executing, if the GPU
+        // profiler is enabled with DeviceDesc::enableMarkerProfiling. The results are collected in
+        // runGarbageCollection, so they are typically available a few frames after the frame was submitted.
+        // Returns false when no frame is ready. Only the last few frames are kept if the results are not taken.
+        virtual bool getProfilerFrameResults(ProfilerFrameResults& outResults) = 0;
+
+        // Serializes the contents of the device pipeline cache into 'data': the VkPipelineCache on Vulkan,
+        // or the pipeline library on DX12 if it is enabled. Pass the data to DeviceDesc::pipelineCacheData
+        // when creating the device on a later run to skip compiling the pipelines that it contains.
+        // Returns false if the device has no pipeline cache or serialization failed.
+        virtual bool getPipelineCacheData(std::vector<uint8_t>& data) = 0;
+
         // Returns a list of supported CoopVec matrix multiplication formats and accumulation capabilities.
         virtual coopvec::DeviceFeatures queryCoopVecFeatures() = 0;
 
@@ -3801,6 +4841,28 @@ namespace std
         }
     };
     
+    template<> struct hash<nvrhi::SamplerDesc>
+    {
+        std::size_t operator()(nvrhi::SamplerDesc const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.borderColor.r);
+            nvrhi::hash_combine(hash, s.borderColor.g);
+            nvrhi::hash_combine(hash, s.borderColor.b);
+            nvrhi::hash_combine(hash, s.borderColor.a);
+            nvrhi::hash_combine(hash, s.maxAnisotropy);
+            nvrhi::hash_combine(hash, s.mipBias);
+            nvrhi::hash_combine(hash, s.minFilter);
+            nvrhi::hash_combine(hash, s.magFilter);
+            nvrhi::hash_combine(hash, s.mipFilter);
+            nvrhi::hash_combine(hash, s.addressU);
+            nvrhi::hash_combine(hash, s.addressV);
+            nvrhi::hash_combine(hash, s.addressW);
+            nvrhi::hash_combine(hash, s.reductionType);
+            return hash;
+        }
+    };
+
     template<> struct hash<nvrhi::VariableRateShadingState>
     {
         std::size_t operator()(nvrhi::VariableRateShadingState const& s) const noexcept
@@ -55,6 +55,63 @@ namespace nvrhi
             GpuVirtualAddress blasDeviceAddress;
         };
 
+        // Indirect arguments of buildTopLevelAccelStructFromBufferIndirect(...).
+        // The layout matches VkAccelerationStructureBuildRangeInfoKHR, the reserved fields must be 0.
+        struct IndirectTlasBuildArgs
+        {
+            uint32_t instanceCount;
+            uint32_t reserved[3];
+        };
+
+        //////////////////////////////////////////////////////////////////////////
+        // GPU TLAS instance culling, see utils::TlasInstanceCullingPass
+        //////////////////////////////////////////////////////////////////////////
+
+        static const uint32_t kTlasCullingGroupSize = 64;
+        static const uint32_t kTlasCullingMaxLods = 4;
+
+        // One instance that the culling pass can write into the TLAS instance buffer
+        struct TlasCullingCandidate
+        {
+            // The instance to write, its blasDeviceAddress is replaced with the selected LOD
+            IndirectInstanceDesc instance;
+
+            // BLAS addresses of the LODs, from the most detailed one. Unused LODs must be 0.
+            GpuVirtualAddress lodBlasAddresses[kTlasCullingMaxLods];
+
+            // Maximum view distance of every LOD. Candidates farther than the last used LOD are culled.
+#ifdef __cplusplus
+            float lodMaxDistances[kTlasCullingMaxLods];
+#else
+            float4 lodMaxDistances;
+#endif
+
+            // Object-space bounding sphere: center in xyz, radius in w
+#ifdef __cplusplus
+            float boundingSphere[4];
+#else
+            float4 boundingSphere;
+#endif
+        };
+
+        // Constants of the culling pass, to be placed in a constant buffer
+        struct TlasCullingConstants
+        {
+            // World-space planes, a point p is inside when dot(plane.xyz, p) + plane.w >= 0
+#ifdef __cplusplus
+            float frustumPlanes[6][4];
+            float viewOrigin[3];
+#else
+            float4 frustumPlanes[6];
+            float3 viewOrigin;
+#endif
+            uint32_t numCandidates;
+            uint32_t maxInstances;
+            uint32_t enableFrustumCulling;
+            float lodDistanceScale;
+            uint32_t padding;
+        };
+
         namespace cluster
         {
             static const uint32_t kClasByteAlignment = 128;
@@ -124,7 +181,311 @@ namespace nvrhi
                 GpuVirtualAddress         clusterAddresses; // Address of an array of D3D12_GPU_VIRTUAL_ADDRESS holding valid addresses of CLAS previously constructed
             };
         } // namespace cluster
+#ifndef __cplusplus
+        // Culls one candidate against the view frustum, selects its LOD, and appends it to the instance buffer.
+        // 'args' holds the rt::IndirectTlasBuildArgs of the build and must be cleared before the pass.
+        // The instance count never exceeds constants.maxInstances, excess instances are dropped.
+        // Use it from a compute shader with kTlasCullingGroupSize threads per group, one thread per candidate.
+        void CullTlasInstance(
+            uint candidateIndex,
+            TlasCullingConstants constants,
+            StructuredBuffer<TlasCullingCandidate> candidates,
+            RWStructuredBuffer<IndirectInstanceDesc> instances,
+            RWByteAddressBuffer args)
+        {
+            if (candidateIndex >= constants.numCandidates)
+                return;
+
+            TlasCullingCandidate candidate = candidates[candidateIndex];
+            float4 localCenter = float4(candidate.boundingSphere.xyz, 1.0);
+            float3 center = float3(
+                dot(candidate.instance.transform[0], localCenter),
+                dot(candidate.instance.transform[1], localCenter),
+                dot(candidate.instance.transform[2], localCenter));
+
+            // Scale the radius by the longest axis of the transform
+            float4 row0 = candidate.instance.transform[0];
+            float4 row1 = candidate.instance.transform[1];
+            float4 row2 = candidate.instance.transform[2];
+            float3 axisX = float3(row0.x, row1.x, row2.x);
+            float3 axisY = float3(row0.y, row1.y, row2.y);
+            float3 axisZ = float3(row0.z, row1.z, row2.z);
+            float maxScaleSquared = max(dot(axisX, axisX), max(dot(axisY, axisY), dot(axisZ, axisZ)));
+            float radius = candidate.boundingSphere.w * sqrt(maxScaleSquared);
+
+            if (constants.enableFrustumCulling)
+            {
+                for (uint plane = 0; plane < 6; plane++)
+                {
+                    if (dot(constants.frustumPlanes[plane].xyz, center) + constants.frustumPlanes[plane].w < -radius)
+                        return;
+                }
+            }
+
+            float distance = max(length(center - constants.viewOrigin) - radius, 0.0) * constants.lodDistanceScale;
+            GpuVirtualAddress blasAddress = 0;
+            for (uint lod = 0; lod < kTlasCullingMaxLods; lod++)
+            {
+                if (candidate.lodBlasAddresses[lod] == 0)
+                    break;
+
+                if (distance <= candidate.lodMaxDistances[lod])
+                {
+                    blasAddress = candidate.lodBlasAddresses[lod];
+                    break;
+                }
+            }
+
+            if (blasAddress == 0)
+                return;
+
+            uint slot;
+            args.InterlockedAdd(0, 1, slot);
+            if (slot >= constants.maxInstances)
+            {
+                // Undo the increment so that the final count is maxInstances. Every slot below maxInstances
+                // has been taken by then, so no other thread can get a slot that is not written.
+                args.InterlockedAdd(0, 0xffffffff);
+                return;
+            }
+
+            IndirectInstanceDesc instance = candidate.instance;
+            instance.blasDeviceAddress = blasAddress;
+            instances[slot] = instance;
+        }
+#endif // !__cplusplus
     } // namespace rt
+
+    //////////////////////////////////////////////////////////////////////////
+    // GPU decompression of streamed buffer data, see utils::StreamingUploader
+    //////////////////////////////////////////////////////////////////////////
+
+    // Every group of the decompression shader writes this many bytes of the output, the last one possibly fewer
+    static const uint32_t kGpuDecompressionBytesPerGroup = 65536;
+
+    // Push constants of the decompression shader, all in bytes
+    struct GpuDecompressionConstants
+    {
+        uint32_t compressedOffset;
+        uint32_t compressedSize;
+        uint32_t decompressedOffset;
+        uint32_t decompressedSize;
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    // Single-pass mip chain generation, see utils::MipChainGenerator
+    //////////////////////////////////////////////////////////////////////////
+
+    static const uint32_t kMipGenGroupSize = 256;
+
+    // Every group reduces a 64x64 tile of the source mip into 6 mips, and the last group to finish reduces
+    // the 6th one, which is at most 64x64 texels, into 6 more mips
+    static const uint32_t kMipGenMaxMipsPerPass = 12;
+
+    static const uint32_t kMipGenReductionAverage = 0;
+    static const uint32_t kMipGenReductionMin = 1;
+    static const uint32_t kMipGenReductionMax = 2;
+
+    // Push constants of the mip generation shader
+    struct MipGenConstants
+    {
+        // Size of the source mip, the output mips are half the size of the previous one, rounded down
+        uint32_t sourceWidth;
+        uint32_t sourceHeight;
+        // Number of output mips, at most kMipGenMaxMipsPerPass
+        uint32_t numMips;
+        // Total number of groups in the dispatch
+        uint32_t numGroups;
+        uint32_t reduction;
+        // The outputs are views of an sRGB texture with the linear format, so the shader does the conversion
+        uint32_t encodeSrgb;
+        uint32_t padding0;
+        uint32_t padding1;
+    };
+
+#if !defined(__cplusplus) && defined(NVRHI_MIPGEN_SHADER)
+    // The resources of the mip generation shader, in register space 0. They are array views of the single
+    // array slice being processed, so that the same shader works for 2D textures and texture arrays.
+    // Define NVRHI_MIPGEN_INTEGER for the variant that processes unsigned integer formats.
+#ifdef NVRHI_MIPGEN_INTEGER
+    typedef uint4 MipGenValue;
+#else
+    typedef float4 MipGenValue;
+#endif
+
+    [[vk::push_constant]] ConstantBuffer<MipGenConstants> g_MipGenConstants : register(b0);
+    Texture2DArray<MipGenValue> g_MipGenSource : register(t0);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput0 : register(u0);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput1 : register(u1);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput2 : register(u2);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput3 : register(u3);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput4 : register(u4);
+    // Written by all groups and read by the last one
+    globallycoherent RWTexture2DArray<MipGenValue> g_MipGenOutput5 : register(u5);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput6 : register(u6);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput7 : register(u7);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput8 : register(u8);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput9 : register(u9);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput10 : register(u10);
+    RWTexture2DArray<MipGenValue> g_MipGenOutput11 : register(u11);
+    // Number of groups that have finished the first 6 mips, reset to 0 by the last group
+    globallycoherent RWByteAddressBuffer g_MipGenCounter : register(u12);
+
+    groupshared MipGenValue g_MipGenLds[32][32];
+    groupshared uint g_MipGenIsLastGroup;
+
+#ifndef NVRHI_MIPGEN_INTEGER
+    float3 MipGenLinearToSrgb(float3 color)
+    {
+        return select(color <= 0.0031308, color * 12.92, 1.055 * pow(color, 1.0 / 2.4) - 0.055);
+    }
+
+    float3 MipGenSrgbToLinear(float3 color)
+    {
+        return select(color <= 0.04045, color / 12.92, pow((color + 0.055) / 1.055, 2.4));
+    }
+#endif
+
+    MipGenValue MipGenReduce(MipGenValue a, MipGenValue b, MipGenValue c, MipGenValue d)
+    {
+        if (g_MipGenConstants.reduction == kMipGenReductionMin)
+            return min(min(a, b), min(c, d));
+        if (g_MipGenConstants.reduction == kMipGenReductionMax)
+            return max(max(a, b), max(c, d));
+#ifdef NVRHI_MIPGEN_INTEGER
+        // Rounded average that can't overflow
+        return a / 4 + b / 4 + c / 4 + d / 4 + (a % 4 + b % 4 + c % 4 + d % 4 + 2) / 4;
+#else
+        return (a + b + c + d) * 0.25;
+#endif
+    }
+
+    // Odd sizes are rounded down and drop the last row or column, which MipChainGenerator rejects for the min and max reductions
+    uint2 MipGenOutputSize(uint mip)
+    {
+        return max(uint2(g_MipGenConstants.sourceWidth, g_MipGenConstants.sourceHeight) >> (mip + 1), 1);
+    }
+
+    // The source is sampled with clamping, so that the texels past the edge of odd-sized mips repeat the last ones
+    MipGenValue MipGenLoad(uint2 coord, bool fromMiddleMip)
+    {
+        if (!fromMiddleMip)
+        {
+            uint2 maxCoord = uint2(g_MipGenConstants.sourceWidth, g_MipGenConstants.sourceHeight) - 1;
+            return g_MipGenSource[uint3(min(coord, maxCoord), 0)];
+        }
+
+        MipGenValue value = g_MipGenOutput5[uint3(min(coord, MipGenOutputSize(5) - 1), 0)];
+#ifndef NVRHI_MIPGEN_INTEGER
+        if (g_MipGenConstants.encodeSrgb)
+            value.rgb = MipGenSrgbToLinear(value.rgb);
+#endif
+        return value;
+    }
+
+    void MipGenStore(uint mip, uint2 coord, MipGenValue value)
+    {
+        if (mip >= g_MipGenConstants.numMips || any(coord >= MipGenOutputSize(mip)))
+            return;
+
+#ifndef NVRHI_MIPGEN_INTEGER
+        if (g_MipGenConstants.encodeSrgb)
+            value.rgb = MipGenLinearToSrgb(value.rgb);
+#endif
+
+        switch (mip)
+        {
+        case 0: g_MipGenOutput0[uint3(coord, 0)] = value; break;
+        case 1: g_MipGenOutput1[uint3(coord, 0)] = value; break;
+        case 2: g_MipGenOutput2[uint3(coord, 0)] = value; break;
+        case 3: g_MipGenOutput3[uint3(coord, 0)] = value; break;
+        case 4: g_MipGenOutput4[uint3(coord, 0)] = value; break;
+        case 5: g_MipGenOutput5[uint3(coord, 0)] = value; break;
+        case 6: g_MipGenOutput6[uint3(coord, 0)] = value; break;
+        case 7: g_MipGenOutput7[uint3(coord, 0)] = value; break;
+        case 8: g_MipGenOutput8[uint3(coord, 0)] = value; break;
+        case 9: g_MipGenOutput9[uint3(coord, 0)] = value; break;
+        case 10: g_MipGenOutput10[uint3(coord, 0)] = value; break;
+        default: g_MipGenOutput11[uint3(coord, 0)] = value; break;
+        }
+    }
+
+    // Reduces a 64x64 tile of the input into 32x32 texels of output mip 'mip', and then those texels
+    // through the group shared memory into the 5 next output mips
+    void MipGenDownsampleTile(uint2 tile, uint mip, uint localIndex, bool fromMiddleMip)
+    {
+        // Each thread produces a 2x2 block of the first mip
+        uint2 threadPos = uint2(localIndex % 16, localIndex / 16);
+        for (uint i = 0; i < 4; i++)
+        {
+            uint2 pos = threadPos * 2 + uint2(i & 1, i >> 1);
+            uint2 src = (tile * 32 + pos) * 2;
+            MipGenValue value = MipGenReduce(
+                MipGenLoad(src, fromMiddleMip),
+                MipGenLoad(src + uint2(1, 0), fromMiddleMip),
+                MipGenLoad(src + uint2(0, 1), fromMiddleMip),
+                MipGenLoad(src + uint2(1, 1), fromMiddleMip));
+            MipGenStore(mip, tile * 32 + pos, value);
+            g_MipGenLds[pos.y][pos.x] = value;
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        for (uint level = 1; level < 6; level++)
+        {
+            uint extent = 32 >> level;
+            uint2 pos = uint2(localIndex % extent, localIndex / extent);
+            bool active = localIndex < extent * extent;
+
+            MipGenValue value = (MipGenValue)0;
+            if (active)
+            {
+                uint2 src = pos * 2;
+                value = MipGenReduce(
+                    g_MipGenLds[src.y][src.x],
+                    g_MipGenLds[src.y][src.x + 1],
+                    g_MipGenLds[src.y + 1][src.x],
+                    g_MipGenLds[src.y + 1][src.x + 1]);
+                MipGenStore(mip + level, tile * extent + pos, value);
+            }
+            GroupMemoryBarrierWithGroupSync();
+
+            if (active)
+                g_MipGenLds[pos.y][pos.x] = value;
+            GroupMemoryBarrierWithGroupSync();
+        }
+    }
+
+    // Generates up to kMipGenMaxMipsPerPass mips in one dispatch of ceil(sourceWidth / 64) x ceil(sourceHeight / 64)
+    // groups. The middle mip must be at most 64x64 texels when numMips is over 6, i.e. the source at most 4096x4096.
+    // Call it from a compute shader with [numthreads(kMipGenGroupSize, 1, 1)]:
+    //   GenerateMips(SV_GroupID.xy, SV_GroupIndex)
+    void GenerateMips(uint2 groupId, uint localIndex)
+    {
+        MipGenDownsampleTile(groupId, 0, localIndex, false);
+
+        if (g_MipGenConstants.numMips <= 6)
+            return;
+
+        // Make the middle mip texel of this group visible before counting the group as finished
+        AllMemoryBarrierWithGroupSync();
+
+        if (localIndex == 0)
+        {
+            uint finishedGroups;
+            g_MipGenCounter.InterlockedAdd(0, 1, finishedGroups);
+            g_MipGenIsLastGroup = (finishedGroups == g_MipGenConstants.numGroups - 1) ? 1 : 0;
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        if (g_MipGenIsLastGroup == 0)
+            return;
+
+        if (localIndex == 0)
+            g_MipGenCounter.Store(0, 0);
+
+        MipGenDownsampleTile(uint2(0, 0), 6, localIndex, true);
+    }
+#endif // NVRHI_MIPGEN_SHADER
 } // namespace nvrhi
 
 #endif // __HLSL_VERSION 2021
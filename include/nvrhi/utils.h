@@ -23,6 +23,16 @@
 #pragma once
 
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <map>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdio>
+#include <memory>
 #include <nvrhi/nvrhi.h>
 
 namespace nvrhi::utils
@@ -92,7 +102,51 @@ namespace nvrhi::utils
         nvrhi::FormatSupport requiredFeatures,
         const nvrhi::Format* requestedFormats,
         size_t requestedFormatCount);
-    
+
+    // Conversions that can be applied to texture data while it is copied into upload memory.
+    enum class TextureRowConversion : uint8_t
+    {
+        // The rows are copied as is
+        None,
+        // 3-byte pixels are expanded to 4 bytes with the last channel set to 255, for the 8-bit RGBA and BGRA formats
+        RGB8ToRGBA8,
+        // 32-bit float channels are converted to 16-bit floats with round-to-nearest-even, for the *16_FLOAT formats
+        Float32ToFloat16
+    };
+
+    // Returns true if the data produced by 'conversion' matches the layout of 'format'.
+    NVRHI_API bool IsTextureRowConversionSupported(TextureRowConversion conversion, Format format);
+
+    // Copies 'depth' slices of 'numRows' rows from 'src' to 'dest', producing 'destRowSize' bytes per row and
+    // applying the conversion on the way. The source rows must contain the matching number of source pixels.
+    // This is the copy used by writeTexture on DX12 and Vulkan. It uses SSE2/AVX and SSSE3/F16C on x86, or NEON on ARM,
+    // as far as the compiler targets them, and writes with non-temporal stores that don't pollute the caches
+    // with the write-combined upload memory.
+    NVRHI_API void CopyTextureRows(
+        void* dest,
+        size_t destRowPitch,
+        size_t destDepthPitch,
+        const void* src,
+        size_t srcRowPitch,
+        size_t srcDepthPitch,
+        size_t destRowSize,
+        uint32_t numRows,
+        uint32_t depth,
+        TextureRowConversion conversion = TextureRowConversion::None);
+
+    // Same as ICommandList::writeTexture, but converts the data with 'conversion' while writing it into the upload
+    // region, which saves a separate conversion pass on the CPU. 'rowPitch' and 'depthPitch' describe the source data.
+    // Returns false if the conversion doesn't match the texture format or the region couldn't be allocated.
+    NVRHI_API bool WriteTextureConverted(
+        ICommandList* commandList,
+        ITexture* texture,
+        uint32_t arraySlice,
+        uint32_t mipLevel,
+        const void* data,
+        size_t rowPitch,
+        size_t depthPitch,
+        TextureRowConversion conversion);
+
     NVRHI_API const char* GraphicsAPIToString(GraphicsAPI api);
     NVRHI_API const char* TextureDimensionToString(TextureDimension dimension);
     NVRHI_API const char* DebugNameToString(const std::string& debugName);
@@ -145,4 +199,993 @@ namespace nvrhi::utils
         }
     };
 
+    // Places textures and buffers that are only needed during a part of the frame, such as G-buffer, bloom or
+    // post-processing targets, onto a small set of shared heaps, so that resources with non-overlapping lifetimes
+    // use the same memory.
+    // Usage:
+    // 1. Declare the resources with addTexture(...) and addBuffer(...), specifying the first and last pass where
+    //    each resource is used. Passes are numbered in the order they are recorded in.
+    // 2. Call compile() to create the resources and place them onto the heaps.
+    // 3. Call beginPass(...) before recording each pass to place the aliasing barriers for the resources
+    //    whose lifetime starts in that pass. Aliased resources have undefined contents at the start of their
+    //    lifetime and must be cleared or fully overwritten before they are read.
+    // The state of the resources is tracked like for any other resource, so their descs should normally use
+    // enableAutomaticStateTracking(...) with the state of their first use.
+    // Calling reset() or compile() again releases the resources, so the GPU must be done using them.
+    class TransientResourceAllocator
+    {
+    public:
+        static constexpr uint32_t c_InvalidResource = ~0u;
+
+        NVRHI_API explicit TransientResourceAllocator(IDevice* device);
+
+        NVRHI_API uint32_t addTexture(const TextureDesc& desc, uint32_t firstPass, uint32_t lastPass);
+        NVRHI_API uint32_t addBuffer(const BufferDesc& desc, uint32_t firstPass, uint32_t lastPass);
+
+        // Creates the resources and heaps. Heaps from a previous compile() are reused when they are large enough.
+        // Returns false if any resource or heap could not be created.
+        NVRHI_API bool compile();
+
+        // Places the aliasing barriers for resources whose lifetime starts in the given pass.
+        NVRHI_API void beginPass(ICommandList* commandList, uint32_t passIndex) const;
+
+        // Releases all declared resources, but keeps the heaps.
+        NVRHI_API void reset();
+
+        [[nodiscard]] NVRHI_API ITexture* getTexture(uint32_t index) const;
+        [[nodiscard]] NVRHI_API IBuffer* getBuffer(uint32_t index) const;
+
+        // Total size of the heaps, i.e. the memory actually used by the transient resources
+        [[nodiscard]] NVRHI_API uint64_t getHeapMemorySize() const;
+        // Total size of all transient resources, i.e. the memory they would use without aliasing
+        [[nodiscard]] NVRHI_API uint64_t getResourceMemorySize() const;
+
+    private:
+        // Resources are placed into separate heaps by category, which keeps buffers and images apart and
+        // satisfies the heap restrictions of D3D12 resource heap tier 1 for render targets.
+        enum HeapCategory : uint32_t
+        {
+            RenderTargets,
+            Textures,
+            Buffers,
+
+            HeapCategoryCount
+        };
+
+        struct TransientResource
+        {
+            TextureDesc textureDesc;
+            BufferDesc bufferDesc;
+            bool isTexture = false;
+            uint32_t firstPass = 0;
+            uint32_t lastPass = 0;
+
+            TextureHandle texture;
+            BufferHandle buffer;
+            MemoryRequirements memoryRequirements;
+            HeapCategory category = Buffers;
+            uint64_t heapOffset = 0;
+
+            // The resource that used the memory most recently before this one, if there is exactly one
+            uint32_t aliasedPredecessor = c_InvalidResource;
+            bool isAliased = false;
+        };
+
+        IDevice* m_Device;
+        std::vector<TransientResource> m_Resources;
+        HeapHandle m_Heaps[HeapCategoryCount];
+
+        // Aliased resources sorted by their first pass, used in beginPass
+        std::vector<uint32_t> m_AliasingBarrierOrder;
+
+        [[nodiscard]] IResource* getResource(uint32_t index) const;
+    };
+
+    // Uploads texture and buffer data in the background on the copy queue, so that streaming large amounts of data
+    // doesn't add copy work to the graphics timeline.
+    // Usage:
+    // 1. Enqueue upload requests from any thread with enqueueTextureUpload(...) or enqueueBufferUpload(...).
+    //    Requests with a higher priority are submitted first, requests with equal priority in the enqueue order.
+    // 2. Call update() regularly, e.g. once per frame, from a single thread. It retires the finished batches and
+    //    submits the next batch of requests that fits into the budget. The write callbacks of the requests are called
+    //    from update() and fill the upload memory directly, see ICommandList::beginWriteTexture(...).
+    // 3. Call queueWaitForUploads() before executing the graphics command lists that use the uploaded data, or poll
+    //    isRequestComplete(...) and only start using a resource when its upload is complete.
+    // The destination resources should use keepInitialState = true, so that they are returned into their initial
+    // state at the end of every copy batch. On DX12, copy queue command lists can only use the Common, CopySource
+    // and CopyDest states, so the initial state of the destinations must be Common when the copy queue is used:
+    // they decay to Common after each batch, and the graphics queue promotes them implicitly on first use, which works
+    // for buffers and for textures read by shaders. An initial ShaderResource state would make the copy command list
+    // record invalid transitions.
+    // If the device has no copy queue, the uploads are executed on the graphics queue instead, where any initial
+    // state works.
+    // Compressed buffer data can be decompressed on the GPU, when a decompression shader is passed to the constructor:
+    // - enqueueCompressedBufferUpload(...) requests write the compressed data into a device-local staging buffer
+    //   through upload memory, e.g. straight from a file with readFromFile(...), and the batch then runs the
+    //   decompression shader into the destination buffer, which must have canHaveUAVs and canHaveRawViews set.
+    // - The shader implements the compression format, e.g. GDeflate, because NVRHI does not ship compiled shaders.
+    //   It is a compute shader with these bindings in register space 0:
+    //     [[vk::push_constant]] ConstantBuffer<nvrhi::GpuDecompressionConstants> : register(b0)
+    //     ByteAddressBuffer : register(t0), the compressed data
+    //     RWByteAddressBuffer : register(u0), the destination buffer
+    //   and is dispatched with one group for every kGpuDecompressionBytesPerGroup bytes of decompressed data.
+    // - The uploads are executed on the compute queue instead of the copy queue, or on the graphics queue
+    //   if the device has no compute queue.
+    class StreamingUploader
+    {
+    public:
+        typedef uint64_t RequestID;
+        typedef std::function<void(const MappedWriteRegion& region)> WriteCallback;
+
+        // bytesPerBatch limits the data size of one copy submission, maxBytesInFlight limits the total size of the
+        // submitted batches that haven't finished executing, which also bounds the upload memory used.
+        // The staging buffer for compressed data has the size bytesPerBatch, which limits the compressed size of a request.
+        NVRHI_API explicit StreamingUploader(IDevice* device, uint64_t bytesPerBatch = 32 * 1024 * 1024,
+            uint64_t maxBytesInFlight = 256 * 1024 * 1024, IShader* decompressionShader = nullptr);
+        NVRHI_API ~StreamingUploader();
+
+        NVRHI_API RequestID enqueueTextureUpload(ITexture* texture, uint32_t arraySlice, uint32_t mipLevel,
+            int priority, WriteCallback callback);
+        NVRHI_API RequestID enqueueBufferUpload(IBuffer* buffer, uint64_t destOffsetBytes, size_t dataSize,
+            int priority, WriteCallback callback);
+
+        // Uploads 'compressedSize' bytes written by the callback and decompresses them on the GPU into 'decompressedSize'
+        // bytes of 'buffer' at 'destOffsetBytes', see the class comment. The offset and sizes must be multiples of 4.
+        // Returns 0 if the uploader has no decompression shader or the request is invalid.
+        NVRHI_API RequestID enqueueCompressedBufferUpload(IBuffer* buffer, uint64_t destOffsetBytes, size_t decompressedSize,
+            size_t compressedSize, int priority, WriteCallback callback);
+
+        // Returns a write callback that reads the whole region from 'file' starting at 'fileOffset', directly into
+        // the upload memory. For texture regions, 'fileRowPitch' is the distance between rows in the file, which are
+        // read into the rows of the region; when it's 0, the file data must already use the row pitch of the region.
+        // The file must stay open until the request has been submitted. Bytes that can't be read are set to zero.
+        [[nodiscard]] NVRHI_API static WriteCallback readFromFile(std::FILE* file, uint64_t fileOffset, size_t fileRowPitch = 0);
+
+        // Retires the finished batches and submits a new one. Returns the number of requests that were submitted.
+        NVRHI_API uint32_t update();
+
+        // Makes 'waitQueue' wait on the GPU until all batches submitted so far have finished.
+        NVRHI_API void queueWaitForUploads(CommandQueue waitQueue = CommandQueue::Graphics);
+
+        // Blocks until all submitted batches have finished executing, requests that are still queued are not affected.
+        NVRHI_API void waitForSubmittedUploads();
+
+        [[nodiscard]] NVRHI_API bool isRequestComplete(RequestID id);
+        [[nodiscard]] NVRHI_API size_t getNumQueuedRequests();
+        [[nodiscard]] uint64_t getBytesInFlight() const { return m_BytesInFlight; }
+
+    private:
+        struct Request
+        {
+            RequestID id = 0;
+            TextureHandle texture;
+            BufferHandle buffer;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+            uint64_t destOffset = 0;
+            // Size of the data written by the callback, the compressed size for compressed requests
+            uint64_t size = 0;
+            // Non-zero for requests that are decompressed on the GPU
+            uint64_t decompressedSize = 0;
+            WriteCallback callback;
+        };
+
+        struct Batch
+        {
+            EventQueryHandle query;
+            uint64_t bytes = 0;
+            std::vector<RequestID> requests;
+        };
+
+        IDevice* m_Device;
+        CommandQueue m_Queue = CommandQueue::Copy;
+        CommandListHandle m_CommandList;
+        const uint64_t m_BytesPerBatch;
+        const uint64_t m_MaxBytesInFlight;
+
+        BufferHandle m_StagingBuffer;
+        BindingLayoutHandle m_DecompressionLayout;
+        ComputePipelineHandle m_DecompressionPipeline;
+
+        std::mutex m_Mutex; // protects the queued and incomplete requests, which are accessed by enqueue calls
+        std::multimap<int, Request, std::greater<int>> m_QueuedRequests;
+        std::unordered_set<RequestID> m_IncompleteRequests;
+        RequestID m_NextRequestID = 1;
+
+        std::deque<Batch> m_BatchesInFlight;
+        std::vector<EventQueryHandle> m_QueryPool;
+        uint64_t m_BytesInFlight = 0;
+        uint64_t m_LastSubmittedInstance = 0;
+        uint64_t m_LastWaitedInstances[size_t(CommandQueue::Count)] = {};
+
+        RequestID enqueue(Request&& request, int priority);
+        void retireBatches(bool waitForAll);
+    };
+
+    // Creates pipelines on a pool of worker threads, so that large numbers of pipelines, such as all material PSOs,
+    // can be compiled in parallel during loading instead of one after another.
+    // Usage:
+    // 1. Add pipeline descriptions from any thread with addGraphicsPipelines(...), addComputePipelines(...),
+    //    addMeshletPipelines(...) or addRayTracingPipelines(...), or their single-pipeline versions. Each pipeline
+    //    gets a ticket, and the tickets of the pipelines added in one call are consecutive.
+    // 2. Poll isComplete(...) or getNumPendingPipelines(), or block in wait(...) or waitForAll().
+    // 3. Get the pipelines with getGraphicsPipeline(...) etc. once they are complete. A null handle means that
+    //    the pipeline could not be created, and the error has been reported to the device message callback.
+    // 4. Call releaseTicket(...) once the pipeline has been taken out of the batch, so that a long-lived batch
+    //    doesn't keep one entry per pipeline ever added to it.
+    // The pipelines are created with the regular IDevice functions, which are safe to call from multiple threads,
+    // and they are stored in the device pipeline cache like any other pipeline, see IDevice::getPipelineCacheData.
+    // The destructor waits for the pipelines that are being created and discards the ones that haven't been started.
+    class PipelineBatch
+    {
+    public:
+        typedef uint64_t Ticket;
+
+        // numThreads = 0 means one thread less than the number of hardware threads, but at least one.
+        NVRHI_API explicit PipelineBatch(IDevice* device, uint32_t numThreads = 0);
+        NVRHI_API ~PipelineBatch();
+
+        NVRHI_API Ticket addGraphicsPipelines(const GraphicsPipelineDesc* descs, size_t numDescs, const FramebufferInfo& fbinfo);
+        NVRHI_API Ticket addComputePipelines(const ComputePipelineDesc* descs, size_t numDescs);
+        NVRHI_API Ticket addMeshletPipelines(const MeshletPipelineDesc* descs, size_t numDescs, const FramebufferInfo& fbinfo);
+        NVRHI_API Ticket addRayTracingPipelines(const rt::PipelineDesc* descs, size_t numDescs);
+
+        Ticket addGraphicsPipeline(const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo) { return addGraphicsPipelines(&desc, 1, fbinfo); }
+        Ticket addComputePipeline(const ComputePipelineDesc& desc) { return addComputePipelines(&desc, 1); }
+        Ticket addMeshletPipeline(const MeshletPipelineDesc& desc, const FramebufferInfo& fbinfo) { return addMeshletPipelines(&desc, 1, fbinfo); }
+        Ticket addRayTracingPipeline(const rt::PipelineDesc& desc) { return addRayTracingPipelines(&desc, 1); }
+
+        [[nodiscard]] NVRHI_API bool isComplete(Ticket ticket);
+        // Number of pipelines that are queued or being created
+        [[nodiscard]] NVRHI_API size_t getNumPendingPipelines();
+
+        NVRHI_API void wait(Ticket ticket);
+        NVRHI_API void waitForAll();
+
+        // These functions return null if the pipeline is not complete yet, or if it has a different type.
+        [[nodiscard]] NVRHI_API GraphicsPipelineHandle getGraphicsPipeline(Ticket ticket);
+        [[nodiscard]] NVRHI_API ComputePipelineHandle getComputePipeline(Ticket ticket);
+        [[nodiscard]] NVRHI_API MeshletPipelineHandle getMeshletPipeline(Ticket ticket);
+        [[nodiscard]] NVRHI_API rt::PipelineHandle getRayTracingPipeline(Ticket ticket);
+
+        // Drops the batch's reference to the pipeline and, once it's complete, the entry for the ticket.
+        // Released tickets are reported as complete and return null pipelines.
+        NVRHI_API void releaseTicket(Ticket ticket);
+
+    private:
+        enum class PipelineType : uint8_t
+        {
+            Graphics,
+            Compute,
+            Meshlet,
+            RayTracing
+        };
+
+        // The descs are released when the pipeline is complete, only the result is kept
+        struct Job
+        {
+            PipelineType type = PipelineType::Graphics;
+            bool complete = false;
+            bool released = false;
+            FramebufferInfo framebufferInfo;
+            GraphicsPipelineDesc graphicsDesc;
+            ComputePipelineDesc computeDesc;
+            MeshletPipelineDesc meshletDesc;
+            rt::PipelineDesc rayTracingDesc;
+            RefCountPtr<IResource> pipeline;
+        };
+
+        IDevice* m_Device;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_JobsAvailable;
+        std::condition_variable m_JobCompleted;
+        std::deque<Job> m_Jobs; // indexed by ticket - m_FirstTicket
+        Ticket m_FirstTicket = 0;
+        std::deque<Ticket> m_QueuedJobs;
+        size_t m_NumPendingJobs = 0;
+        bool m_ShuttingDown = false;
+
+        std::vector<std::thread> m_Threads;
+
+        template<typename T> Ticket addJobs(PipelineType type, const T* descs, size_t numDescs, T Job::* descMember, const FramebufferInfo* fbinfo);
+        RefCountPtr<IResource> getPipeline(Ticket ticket, PipelineType type);
+        Job* findJob(Ticket ticket);
+        void removeReleasedJobs();
+        void workerThreadProc();
+    };
+
+    // Deduplicates pipelines, binding layouts and input layouts: each get... function returns the existing object
+    // if one has been created through the cache from an identical description, or creates a new one otherwise.
+    // Objects referenced by the descriptions, such as shaders or binding layouts, are compared by pointer,
+    // so binding layouts and input layouts should also come from the cache for pipelines to be shared.
+    // This also avoids creating redundant root signatures on D3D12 and pipeline layouts on Vulkan.
+    // The cache holds references to the objects it returns. Call releaseUnusedObjects() periodically, e.g. after
+    // unloading a level, to evict the objects that are not referenced anywhere else.
+    // All functions are thread-safe.
+    class PipelineStateCache
+    {
+    public:
+        NVRHI_API explicit PipelineStateCache(IDevice* device);
+
+        [[nodiscard]] NVRHI_API GraphicsPipelineHandle getGraphicsPipeline(const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo);
+        [[nodiscard]] NVRHI_API ComputePipelineHandle getComputePipeline(const ComputePipelineDesc& desc);
+        [[nodiscard]] NVRHI_API MeshletPipelineHandle getMeshletPipeline(const MeshletPipelineDesc& desc, const FramebufferInfo& fbinfo);
+        [[nodiscard]] NVRHI_API BindingLayoutHandle getBindingLayout(const BindingLayoutDesc& desc);
+        [[nodiscard]] NVRHI_API InputLayoutHandle getInputLayout(const VertexAttributeDesc* attributes, uint32_t attributeCount, IShader* vertexShader);
+
+        // Removes the objects that are only referenced by the cache, returns the number of removed objects
+        NVRHI_API size_t releaseUnusedObjects();
+        NVRHI_API void clear();
+
+        [[nodiscard]] NVRHI_API size_t getNumCachedObjects();
+
+    private:
+        struct Entry
+        {
+            RefCountPtr<IResource> object;
+            // The vertex shader used to create an input layout, which is referenced by pointer in the key
+            ShaderHandle vertexShader;
+        };
+
+        typedef std::unordered_map<std::string, Entry> EntryMap;
+
+        IDevice* m_Device;
+
+        std::mutex m_Mutex;
+        EntryMap m_GraphicsPipelines;
+        EntryMap m_ComputePipelines;
+        EntryMap m_MeshletPipelines;
+        EntryMap m_BindingLayouts;
+        EntryMap m_InputLayouts;
+
+        template<typename T, typename CreateFunc> RefCountPtr<T> getOrCreate(EntryMap& map, std::string&& key, CreateFunc&& create, IShader* vertexShader = nullptr);
+    };
+
+    struct DynamicTopLevelAccelStructDesc
+    {
+        // Rebuild the TLAS instead of refitting it when more than this fraction of the instances
+        // has moved or changed since the last rebuild
+        float maxChangedInstanceFraction = 0.25f;
+        // Rebuild the TLAS after this many consecutive refits, 0 means no limit
+        uint32_t maxRefitsBetweenRebuilds = 120;
+        // Dirty ranges separated by fewer unmodified instances than this are uploaded with one write,
+        // which uploads a little more data but records fewer copies
+        uint32_t dirtyRangeMergeDistance = 16;
+        // Initial capacity of the instance buffer and the TLAS, they grow when more instances are set
+        size_t initialCapacity = 1024;
+        // Flags for the TLAS builds, AllowUpdate is always added
+        rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::PreferFastTrace;
+        std::string debugName;
+
+        DynamicTopLevelAccelStructDesc& setMaxChangedInstanceFraction(float value) { maxChangedInstanceFraction = value; return *this; }
+        DynamicTopLevelAccelStructDesc& setMaxRefitsBetweenRebuilds(uint32_t value) { maxRefitsBetweenRebuilds = value; return *this; }
+        DynamicTopLevelAccelStructDesc& setDirtyRangeMergeDistance(uint32_t value) { dirtyRangeMergeDistance = value; return *this; }
+        DynamicTopLevelAccelStructDesc& setInitialCapacity(size_t value) { initialCapacity = value; return *this; }
+        DynamicTopLevelAccelStructDesc& setBuildFlags(rt::AccelStructBuildFlags value) { buildFlags = value; return *this; }
+        DynamicTopLevelAccelStructDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Keeps the instances of a TLAS in a persistent GPU buffer and updates the TLAS incrementally: only the instance
+    // ranges that were modified since the last build are uploaded, and the TLAS is refit from the buffer.
+    // The TLAS is rebuilt instead when the instance count changes, or when the refit quality is likely to have degraded
+    // too much, estimated from the fraction of changed instances and the number of refits since the last rebuild.
+    // Usage:
+    // 1. Set the instances with setInstances(...), then modify them with updateInstances(...) or updateTransforms(...).
+    // 2. Call build(...) before the TLAS is used, e.g. once per frame. It does nothing if no instances were modified.
+    // 3. Bind getAccelStruct() after build(...), because the TLAS is recreated when the instance count exceeds its capacity.
+    // The TLAS is built with buildTopLevelAccelStructFromBuffer, so the referenced BLASes are not state or liveness
+    // tracked: they must be kept alive and be ready for TLAS builds, like with that function.
+    // The instance buffer is updated with writeBuffer, so the command list must use automatic barriers for it.
+    // The class is not thread-safe.
+    class DynamicTopLevelAccelStruct
+    {
+    public:
+        NVRHI_API DynamicTopLevelAccelStruct(IDevice* device, const DynamicTopLevelAccelStructDesc& desc);
+
+        // Replaces all instances, the instance count can change.
+        NVRHI_API void setInstances(const rt::InstanceDesc* pInstances, size_t numInstances);
+        // Replaces 'count' instances starting at 'first', which must be within the current instances.
+        // Returns false if the range is out of bounds.
+        NVRHI_API bool updateInstances(size_t first, size_t count, const rt::InstanceDesc* pInstances);
+        // Replaces only the transforms of 'count' instances starting at 'first'.
+        // Returns false if the range is out of bounds.
+        NVRHI_API bool updateTransforms(size_t first, size_t count, const rt::AffineTransform* pTransforms);
+        // Makes the next build(...) rebuild the TLAS, e.g. after a scene change that is known to hurt the refit quality.
+        void requestRebuild() { m_RebuildRequested = true; }
+
+        // Uploads the modified instances and refits or rebuilds the TLAS.
+        // Returns false if the TLAS or the instance buffer could not be created.
+        NVRHI_API bool build(ICommandList* commandList);
+
+        [[nodiscard]] rt::IAccelStruct* getAccelStruct() const { return m_AccelStruct; }
+        [[nodiscard]] IBuffer* getInstanceBuffer() const { return m_InstanceBuffer; }
+        [[nodiscard]] size_t getNumInstances() const { return m_Instances.size(); }
+        // Fraction of the instances that were changed since the last rebuild, compared with maxChangedInstanceFraction
+        [[nodiscard]] float getChangedInstanceFraction() const;
+        // True if the last build(...) was a full rebuild rather than a refit
+        [[nodiscard]] bool lastBuildWasRebuild() const { return m_LastBuildWasRebuild; }
+
+    private:
+        IDevice* m_Device;
+        DynamicTopLevelAccelStructDesc m_Desc;
+
+        rt::AccelStructHandle m_AccelStruct;
+        BufferHandle m_InstanceBuffer;
+        size_t m_Capacity = 0;
+
+        // The instances in the GPU format, i.e. with BLAS device addresses
+        std::vector<rt::InstanceDesc> m_Instances;
+        // Ranges of instances [first, end) that were modified since the last build, in no particular order
+        std::vector<std::pair<size_t, size_t>> m_DirtyRanges;
+        std::vector<bool> m_ChangedSinceRebuild;
+        size_t m_NumChangedSinceRebuild = 0;
+        uint32_t m_RefitsSinceRebuild = 0;
+        size_t m_NumBuiltInstances = 0;
+        bool m_Built = false;
+        bool m_RebuildRequested = false;
+        bool m_LastBuildWasRebuild = false;
+
+        void writeInstance(size_t index, const rt::InstanceDesc& instance);
+        void markChanged(size_t index);
+        void addDirtyRange(size_t first, size_t count);
+        bool createResources(size_t capacity);
+    };
+
+    // Manages the memory of cluster acceleration structure operations, see ICommandList::executeMultiIndirectClusterOperation.
+    // - The size requirements of identical rt::cluster::OperationParams are queried from the device only once.
+    // - The scratch memory is suballocated from the scratch manager of the command list, which is persistent, grows on
+    //   demand and recycles its chunks when the command lists that used them have finished executing. So the pool only
+    //   has to provide the scratch size.
+    // - The output buffers of ImplicitDestinations operations are reused: a released buffer goes back to the pool and is
+    //   handed out again once the GPU has finished the work that was submitted before its release.
+    // Usage:
+    // 1. Fill an OperationDesc, and leave scratchSizeInBytes as 0 and, for ImplicitDestinations operations,
+    //    outAccelerationStructuresBuffer as NULL.
+    // 2. Call execute(...), which fills them in, records the operation, and returns the output buffer it used.
+    // 3. When the results in an output buffer are no longer needed, call releaseOutputBuffer(...) after submitting
+    //    the last command list that uses them.
+    // Output buffers can also be taken directly with acquireOutputBuffer(...), e.g. for the ExplicitDestinations mode.
+    // All functions are thread-safe.
+    class ClusterOperationPool
+    {
+    public:
+        NVRHI_API explicit ClusterOperationPool(IDevice* device, const std::string& debugName = "ClusterOperationPool");
+
+        // Returns the size requirements of the operation, from the cache if identical params have been queried before
+        NVRHI_API rt::cluster::OperationSizeInfo getSizeInfo(const rt::cluster::OperationParams& params);
+
+        // Takes a free output buffer of at least 'byteSize' bytes from the pool, or creates a new one.
+        // The buffers are acceleration structure storage that returns to the AccelStructRead state after each command list.
+        NVRHI_API BufferHandle acquireOutputBuffer(uint64_t byteSize);
+
+        // Returns an output buffer to the pool. Call it after submitting the last command list that uses the buffer
+        // to 'queue': the buffer is only reused after that queue has finished all work submitted before this call.
+        NVRHI_API void releaseOutputBuffer(IBuffer* buffer, CommandQueue queue = CommandQueue::Graphics);
+
+        // Records the operation with the missing sizes and buffers filled in from the pool, see the class comment.
+        // Returns the output buffer used by the operation, which is null for the modes without one.
+        NVRHI_API BufferHandle execute(ICommandList* commandList, const rt::cluster::OperationDesc& desc);
+
+        // Destroys the free output buffers that the GPU has finished using, returns the number of released bytes
+        NVRHI_API uint64_t releaseFreeBuffers();
+
+        [[nodiscard]] NVRHI_API size_t getNumCachedSizes();
+        [[nodiscard]] NVRHI_API uint64_t getFreeBufferBytes();
+
+    private:
+        struct ParamsHash
+        {
+            size_t operator()(const rt::cluster::OperationParams& params) const;
+        };
+
+        struct ParamsEqual
+        {
+            bool operator()(const rt::cluster::OperationParams& a, const rt::cluster::OperationParams& b) const;
+        };
+
+        // Buffers released to one queue between two retireReleasedBuffers calls, which share one event query
+        struct ReleasedBuffers
+        {
+            EventQueryHandle query;
+            std::vector<BufferHandle> buffers;
+        };
+
+        IDevice* m_Device;
+        std::string m_DebugName;
+
+        std::mutex m_Mutex;
+        std::unordered_map<rt::cluster::OperationParams, rt::cluster::OperationSizeInfo, ParamsHash, ParamsEqual> m_SizeCache;
+        // Free buffers sorted by size, for best fit allocation
+        std::multimap<uint64_t, BufferHandle> m_FreeBuffers;
+        uint64_t m_FreeBufferBytes = 0;
+        std::vector<BufferHandle> m_JustReleased[size_t(CommandQueue::Count)];
+        std::deque<ReleasedBuffers> m_ReleasedBuffers;
+        std::vector<EventQueryHandle> m_QueryPool;
+        uint32_t m_NumCreatedBuffers = 0;
+
+        void retireReleasedBuffers();
+    };
+
+    // Culls and LOD-selects TLAS instances on the GPU, then builds the TLAS with the GPU-determined instance count
+    // using buildTopLevelAccelStructFromBufferIndirect.
+    // The culling shader is provided by the application, because NVRHI does not ship compiled shaders. It is a compute
+    // shader that calls rt::CullTlasInstance from nvrhiHLSL.h with these bindings in register space 0:
+    //   ConstantBuffer<nvrhi::rt::TlasCullingConstants> : register(b0)
+    //   StructuredBuffer<nvrhi::rt::TlasCullingCandidate> : register(t0)
+    //   RWStructuredBuffer<nvrhi::rt::IndirectInstanceDesc> : register(u0)
+    //   RWByteAddressBuffer : register(u1)
+    //   [numthreads(nvrhi::rt::kTlasCullingGroupSize, 1, 1)], one thread per candidate, SV_DispatchThreadID.x as the index
+    // Usage:
+    // 1. Upload the candidates with setCandidates(...) when they change. The BLAS addresses are not state or liveness
+    //    tracked: the BLASes must be kept alive and be ready for TLAS builds, like with buildTopLevelAccelStructFromBuffer.
+    // 2. Call execute(...) with the view constants, e.g. once per frame, which builds the TLAS.
+    // The class is not thread-safe.
+    class TlasInstanceCullingPass
+    {
+    public:
+        NVRHI_API TlasInstanceCullingPass(IDevice* device, IShader* cullingShader, uint32_t maxCandidates,
+            const std::string& debugName = "TlasInstanceCullingPass");
+
+        // Returns false if any of the resources or the pipeline could not be created
+        [[nodiscard]] bool isValid() const { return m_Pipeline != nullptr; }
+
+        // Uploads the candidates, at most the maxCandidates passed to the constructor.
+        // Returns false if there are too many candidates.
+        NVRHI_API bool setCandidates(ICommandList* commandList, const rt::TlasCullingCandidate* pCandidates, uint32_t numCandidates);
+
+        // Runs the culling pass and builds 'tlas' from the visible instances. The numCandidates and maxInstances
+        // constants are filled in by the pass. 'tlas' must be created with topLevelMaxInstances >= maxCandidates.
+        NVRHI_API void execute(ICommandList* commandList, rt::IAccelStruct* tlas, const rt::TlasCullingConstants& constants,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None);
+
+        [[nodiscard]] IBuffer* getInstanceBuffer() const { return m_InstanceBuffer; }
+        // Holds the rt::IndirectTlasBuildArgs of the last build, e.g. to read back the number of visible instances
+        [[nodiscard]] IBuffer* getArgsBuffer() const { return m_ArgsBuffer; }
+        [[nodiscard]] uint32_t getNumCandidates() const { return m_NumCandidates; }
+
+    private:
+        IDevice* m_Device;
+        uint32_t m_MaxCandidates;
+        uint32_t m_NumCandidates = 0;
+        // Without indirect instance counts, the instance buffer is cleared so that the instances past the count are inactive
+        bool m_ClearInstances = false;
+
+        BufferHandle m_ConstantBuffer;
+        BufferHandle m_CandidateBuffer;
+        BufferHandle m_InstanceBuffer;
+        BufferHandle m_ArgsBuffer;
+        BindingLayoutHandle m_BindingLayout;
+        BindingSetHandle m_BindingSet;
+        ComputePipelineHandle m_Pipeline;
+    };
+
+    // Keeps a bindless descriptor table of textures, buffers or samplers that are referenced by stable indices,
+    // e.g. from material constants, so that draws don't need binding sets for them.
+    // - registerResource(...) returns a free slot of the table, and the table grows when it's full, up to the
+    //   maxCapacity of the bindless layout. The indices don't change when the table grows.
+    // - The descriptor writes are queued and applied together by commitUpdates(), which should be called once per
+    //   frame before recording the command lists that use the new indices.
+    // - A released slot is only reused, and its resource only released, after the GPU has finished the work that
+    //   was submitted to the given queue before the release.
+    // The registry holds references to the registered resources, because descriptor tables don't track liveness,
+    // so the GPU must be done using the table when the registry is destroyed.
+    // With the Mutable layout types on DX12, the shaders index the descriptor heap directly: add
+    // getDescriptorTable()->getFirstDescriptorIndexInHeap() to the indices, which changes when the table grows.
+    // All functions are thread-safe.
+    class BindlessRegistry
+    {
+    public:
+        static constexpr uint32_t c_InvalidIndex = ~0u;
+
+        NVRHI_API BindlessRegistry(IDevice* device, IBindingLayout* bindlessLayout, uint32_t initialCapacity = 1024);
+
+        // Takes a slot for the item and queues its descriptor write, the slot of the item is ignored.
+        // Returns c_InvalidIndex if the table can't grow anymore.
+        NVRHI_API uint32_t registerResource(const BindingSetItem& item);
+        NVRHI_API uint32_t registerTexture(ITexture* texture, Format format = Format::UNKNOWN,
+            TextureSubresourceSet subresources = AllSubresources, TextureDimension dimension = TextureDimension::Unknown);
+        NVRHI_API uint32_t registerSampler(ISampler* sampler);
+
+        // Releases a slot after the last command list that uses it has been submitted to 'queue'.
+        NVRHI_API void releaseResource(uint32_t index, CommandQueue queue = CommandQueue::Graphics);
+
+        // Grows the table if necessary, writes the queued descriptors, and recycles the slots that the GPU has
+        // finished using. Returns the number of written descriptors.
+        NVRHI_API uint32_t commitUpdates();
+
+        [[nodiscard]] IDescriptorTable* getDescriptorTable() const { return m_DescriptorTable; }
+        [[nodiscard]] NVRHI_API uint32_t getCapacity();
+        [[nodiscard]] NVRHI_API uint32_t getNumRegistered();
+
+    private:
+        // Slots released to one queue between two commitUpdates calls, which share one event query
+        struct ReleasedSlots
+        {
+            EventQueryHandle query;
+            std::vector<uint32_t> slots;
+        };
+
+        IDevice* m_Device;
+        DescriptorTableHandle m_DescriptorTable;
+        uint32_t m_MaxCapacity = 0;
+
+        std::mutex m_Mutex;
+        // Resource of each slot, kept alive until the slot is recycled
+        std::vector<RefCountPtr<IResource>> m_SlotResources;
+        std::vector<uint32_t> m_FreeSlots;
+        uint32_t m_NumSlots = 0; // slots below this index have been handed out at least once
+        uint32_t m_NumRegistered = 0;
+        std::vector<BindingSetItem> m_PendingWrites;
+        std::vector<uint32_t> m_JustReleased[size_t(CommandQueue::Count)];
+        std::deque<ReleasedSlots> m_ReleasedSlots;
+        std::vector<EventQueryHandle> m_QueryPool;
+
+        void retireReleasedSlots();
+    };
+
+    // Describes a matrix in CPU memory that is converted by CoopVecMatrixCache::getMatrix
+    struct CoopVecMatrixDesc
+    {
+        // Source matrix data, copied by getMatrix, so it doesn't have to stay alive
+        const void* data = nullptr;
+        size_t dataSize = 0;
+        coopvec::DataType srcType = coopvec::DataType::Float32;
+        coopvec::MatrixLayout srcLayout = coopvec::MatrixLayout::RowMajor;
+        // Zero means the stride returned by coopvec::getOptimalMatrixStride
+        size_t srcStride = 0;
+
+        coopvec::DataType dstType = coopvec::DataType::Float16;
+        coopvec::MatrixLayout dstLayout = coopvec::MatrixLayout::InferencingOptimal;
+
+        uint32_t numRows = 0;
+        uint32_t numColumns = 0;
+
+        CoopVecMatrixDesc& setData(const void* value, size_t size) { data = value; dataSize = size; return *this; }
+        CoopVecMatrixDesc& setSrcType(coopvec::DataType value) { srcType = value; return *this; }
+        CoopVecMatrixDesc& setSrcLayout(coopvec::MatrixLayout value) { srcLayout = value; return *this; }
+        CoopVecMatrixDesc& setSrcStride(size_t value) { srcStride = value; return *this; }
+        CoopVecMatrixDesc& setDstType(coopvec::DataType value) { dstType = value; return *this; }
+        CoopVecMatrixDesc& setDstLayout(coopvec::MatrixLayout value) { dstLayout = value; return *this; }
+        CoopVecMatrixDesc& setSize(uint32_t rows, uint32_t columns) { numRows = rows; numColumns = columns; return *this; }
+    };
+
+    // Converts CoopVec matrices from CPU data into device layouts and caches the results, so that the same matrices,
+    // e.g. the weights of a network that is reloaded, are only converted once.
+    // - The matrices are keyed by a hash of the source data, the source and destination types and layouts, and the
+    //   dimensions. A repeated getMatrix call returns the existing conversion.
+    // - The converted matrices are suballocated from large output buffers, with the sizes from
+    //   IDevice::getCoopVecMatrixSize and the strides from coopvec::getOptimalMatrixStride.
+    // - All conversions requested since the last flush() are recorded as one ICommandList::convertCoopVecMatrices call
+    //   on the compute queue, or on the graphics queue if the device has no compute queue.
+    // Usage:
+    // 1. Call getMatrix(...) for every matrix, which returns its location in the output buffers right away.
+    // 2. Call flush() to submit the conversions, then queueWaitForConversions() before executing the command lists
+    //    that read the matrices.
+    // The output buffers keep the UnorderedAccess state between command lists, and are only released by clear()
+    // or the destructor, which wait for the conversions in flight. The application must ensure that the GPU has
+    // finished using the matrices before that.
+    // All functions are thread-safe.
+    class CoopVecMatrixCache
+    {
+    public:
+        NVRHI_API explicit CoopVecMatrixCache(IDevice* device, uint64_t outputBufferSize = 16 * 1024 * 1024,
+            const std::string& debugName = "CoopVecMatrixCache");
+        NVRHI_API ~CoopVecMatrixCache();
+
+        // Returns the location of the converted matrix, and queues the conversion if it's not in the cache yet.
+        // The returned buffer is null if the matrix has no size on this device or the output buffer couldn't be created.
+        NVRHI_API coopvec::MatrixLayoutDesc getMatrix(const CoopVecMatrixDesc& desc);
+
+        // Submits the queued conversions in one command list, returns the number of converted matrices.
+        NVRHI_API uint32_t flush();
+
+        // Makes 'waitQueue' wait on the GPU until the conversions submitted so far have finished.
+        NVRHI_API void queueWaitForConversions(CommandQueue waitQueue = CommandQueue::Graphics);
+
+        // Releases all matrices and output buffers, see the class comment.
+        NVRHI_API void clear();
+
+        [[nodiscard]] NVRHI_API size_t getNumCachedMatrices();
+        [[nodiscard]] NVRHI_API size_t getNumQueuedConversions();
+        [[nodiscard]] NVRHI_API uint64_t getOutputBufferBytes();
+
+    private:
+        struct Key
+        {
+            size_t dataHash = 0;
+            size_t dataSize = 0;
+            size_t srcStride = 0;
+            coopvec::DataType srcType = coopvec::DataType::Float32;
+            coopvec::MatrixLayout srcLayout = coopvec::MatrixLayout::RowMajor;
+            coopvec::DataType dstType = coopvec::DataType::Float16;
+            coopvec::MatrixLayout dstLayout = coopvec::MatrixLayout::InferencingOptimal;
+            uint32_t numRows = 0;
+            uint32_t numColumns = 0;
+
+            bool operator==(const Key& other) const;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct OutputBuffer
+        {
+            BufferHandle buffer;
+            uint64_t usedBytes = 0;
+        };
+
+        struct QueuedConversion
+        {
+            std::vector<uint8_t> data;
+            coopvec::ConvertMatrixLayoutDesc desc;
+        };
+
+        // Source buffer of a submitted batch, released when the batch has finished
+        struct BatchInFlight
+        {
+            EventQueryHandle query;
+            BufferHandle sourceBuffer;
+        };
+
+        IDevice* m_Device;
+        uint64_t m_OutputBufferSize;
+        std::string m_DebugName;
+        CommandQueue m_Queue = CommandQueue::Compute;
+        CommandListHandle m_CommandList;
+
+        std::mutex m_Mutex;
+        std::unordered_map<Key, coopvec::MatrixLayoutDesc, KeyHash> m_Matrices;
+        std::vector<OutputBuffer> m_OutputBuffers;
+        uint64_t m_OutputBufferBytes = 0;
+        std::vector<QueuedConversion> m_QueuedConversions;
+        std::deque<BatchInFlight> m_BatchesInFlight;
+        std::vector<EventQueryHandle> m_QueryPool;
+        uint64_t m_LastSubmittedInstance = 0;
+        uint64_t m_LastWaitedInstances[size_t(CommandQueue::Count)] = {};
+
+        bool allocateOutput(size_t size, BufferHandle& outBuffer, uint64_t& outOffset);
+        void retireBatches(bool waitForAll);
+    };
+
+    struct SparseTextureStreamerDesc
+    {
+        // Size of each heap that the tiles are allocated from, a multiple of the 64 KB tile size
+        uint64_t heapSize = 64 * 1024 * 1024;
+        // Maximum total size of the heaps, i.e. the video memory used by the tiles of all textures
+        uint64_t memoryBudget = 256 * 1024 * 1024;
+        // Maximum number of tiles that one update(...) maps, to spread the loading work over several frames
+        uint32_t maxTilesMappedPerUpdate = 256;
+        // A resident tile can be evicted when the most recent feedback of its texture didn't request it,
+        // and it hasn't been requested for at least this many updates
+        uint32_t minFramesBeforeEviction = 8;
+        // Queue that executes the tile mapping updates. The command lists that sample the textures, and the one
+        // passed to update(...), must be executed on the same queue, so that the mappings are ordered with them.
+        CommandQueue queue = CommandQueue::Graphics;
+        std::string debugName = "SparseTextureStreamer";
+
+        SparseTextureStreamerDesc& setHeapSize(uint64_t value) { heapSize = value; return *this; }
+        SparseTextureStreamerDesc& setMemoryBudget(uint64_t value) { memoryBudget = value; return *this; }
+        SparseTextureStreamerDesc& setMaxTilesMappedPerUpdate(uint32_t value) { maxTilesMappedPerUpdate = value; return *this; }
+        SparseTextureStreamerDesc& setMinFramesBeforeEviction(uint32_t value) { minFramesBeforeEviction = value; return *this; }
+        SparseTextureStreamerDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        SparseTextureStreamerDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Keeps the tiles of tiled (sparse) textures resident based on the MinMip sampler feedback of the shaders that
+    // sample them, within a fixed memory budget.
+    // - The feedback is decoded and read back asynchronously with ICommandList::readbackBuffer, so the tiles are
+    //   requested from the feedback written a few frames earlier, and nothing waits for the GPU.
+    // - A feedback region that was sampled at mip M requests the tiles covering it in mips M and coarser.
+    //   Missing tiles are mapped from a pool of heaps, coarser mips first. When the budget is used up, the least
+    //   recently requested tiles are evicted and unmapped. The packed mips of each texture are always resident.
+    // - All tile mapping changes of a texture in one update(...) are made with a single updateTextureTileMappings call.
+    // - For every newly mapped tile, the load callback is called with the command list passed to update(...) and
+    //   the texel region of the tile, and must record the writes of its data into that command list, e.g. with
+    //   copyTexture from a staging texture. For the packed mips, it's called once per mip level with the whole level.
+    // - The residency texture of each texture (R8_UINT, one texel per tile of mip 0) holds the finest mip that is
+    //   resident in that tile and all coarser mips. Shaders should clamp the sampled LOD to it.
+    // Usage:
+    // 1. Create the textures with isTiled = true, and a MinMipOpaque sampler feedback texture for each of them,
+    //    which the shaders write with WriteSamplerFeedback. Register them with addTexture(...).
+    // 2. Call update(...) once per frame with an open command list, before recording the draws that sample the
+    //    textures, and execute that command list on desc.queue.
+    // Requires Feature::SamplerFeedback, Feature::VirtualResources and Feature::AsyncReadback.
+    // The GPU must be done using the textures when they are removed or the streamer is destroyed.
+    // The class is not thread-safe.
+    class SparseTextureStreamer
+    {
+    public:
+        static constexpr uint32_t c_InvalidTexture = ~0u;
+        static constexpr uint64_t c_TileSizeInBytes = 65536;
+
+        typedef std::function<void(ICommandList* commandList, ITexture* texture, const TextureSlice& region)> LoadCallback;
+
+        NVRHI_API SparseTextureStreamer(IDevice* device, const SparseTextureStreamerDesc& desc = SparseTextureStreamerDesc());
+        NVRHI_API ~SparseTextureStreamer();
+
+        // Returns false if the device doesn't support the required features
+        [[nodiscard]] bool isValid() const { return m_Valid; }
+
+        // Registers a 2D tiled texture with a single array slice, and maps its packed mips.
+        // Returns c_InvalidTexture if the texture is not supported or the packed mips don't fit into the budget.
+        NVRHI_API uint32_t addTexture(ITexture* texture, ISamplerFeedbackTexture* feedback, LoadCallback loadCallback);
+
+        // Unmaps all tiles of the texture and returns them to the pool
+        NVRHI_API void removeTexture(uint32_t textureID);
+
+        // Processes the feedback that has been read back, maps and evicts tiles, records the tile loads and
+        // residency texture updates, then records the decode and readback of the current feedback and clears it.
+        // Returns the number of tiles that were mapped.
+        NVRHI_API uint32_t update(ICommandList* commandList);
+
+        [[nodiscard]] NVRHI_API ITexture* getResidencyTexture(uint32_t textureID) const;
+        [[nodiscard]] uint32_t getNumResidentTiles() const { return m_NumResidentTiles; }
+        [[nodiscard]] uint64_t getHeapMemorySize() const { return uint64_t(m_Heaps.size()) * m_Desc.heapSize; }
+
+    private:
+        static constexpr uint32_t c_NoHeapTile = ~0u;
+
+        struct Tile
+        {
+            uint32_t heapTile = c_NoHeapTile;
+            uint32_t mipLevel = 0;
+            uint32_t x = 0;
+            uint32_t y = 0;
+            uint64_t lastRequestedFrame = 0;
+        };
+
+        struct Texture
+        {
+            TextureHandle texture;
+            SamplerFeedbackTextureHandle feedback;
+            LoadCallback loadCallback;
+
+            BufferHandle decodeBuffer;
+            ReadbackTicketHandle pendingFeedback;
+            uint32_t feedbackWidth = 0;
+            uint32_t feedbackHeight = 0;
+            uint32_t feedbackRowPitch = 0;
+            uint32_t mipRegionWidth = 0;
+            uint32_t mipRegionHeight = 0;
+            bool feedbackCleared = false;
+            // Update in which the most recent feedback was processed
+            uint64_t lastFeedbackFrame = 0;
+
+            TileShape tileShape;
+            PackedMipDesc packedMips;
+            std::vector<SubresourceTiling> mipTilings;
+            // Index of the first tile of each standard mip in 'tiles', which is ordered by mip, then row, then column
+            std::vector<uint32_t> mipFirstTile;
+            std::vector<Tile> tiles;
+            std::vector<uint32_t> packedMipHeapTiles;
+            bool packedMipsLoaded = false;
+
+            TextureHandle residencyTexture;
+            std::vector<uint8_t> residencyData;
+            bool residencyDirty = true;
+
+            // Mapping changes made by the current update, applied with one updateTextureTileMappings call
+            std::vector<uint32_t> tilesToMap;
+            std::vector<uint32_t> tilesToUnmap;
+        };
+
+        struct TileRef
+        {
+            uint32_t textureID;
+            uint32_t tileIndex;
+            uint32_t mipLevel;
+            uint64_t lastRequestedFrame;
+        };
+
+        IDevice* m_Device;
+        SparseTextureStreamerDesc m_Desc;
+        bool m_Valid = false;
+        uint64_t m_Frame = 0;
+
+        std::vector<std::unique_ptr<Texture>> m_Textures;
+        std::vector<HeapHandle> m_Heaps;
+        std::vector<uint32_t> m_FreeHeapTiles;
+        uint32_t m_TilesPerHeap = 0;
+        uint32_t m_NumResidentTiles = 0;
+
+        // Scratch lists of the current update
+        std::vector<TileRef> m_RequestedTiles;
+        std::vector<TileRef> m_EvictionCandidates;
+        size_t m_NextEvictionCandidate = 0;
+
+        bool allocateHeapTile(uint32_t& outHeapTile, bool allowEviction);
+        void processFeedback(uint32_t textureID, Texture& texture);
+        void collectEvictionCandidates();
+        void applyMappings(Texture& texture);
+        void updateResidencyData(Texture& texture);
+        void recordFeedbackDecode(ICommandList* commandList, Texture& texture);
+    };
+
+    enum class MipReduction : uint8_t
+    {
+        Average = kMipGenReductionAverage,
+        Min = kMipGenReductionMin,
+        Max = kMipGenReductionMax
+    };
+
+    // Generates mip chains and min/max depth pyramids on the GPU, with one compute dispatch for up to
+    // kMipGenMaxMipsPerPass mips, and more passes for larger textures.
+    // The shaders are provided by the application, because NVRHI does not ship compiled shaders. They are compute
+    // shaders that define NVRHI_MIPGEN_SHADER, include nvrhiHLSL.h and call GenerateMips from it:
+    //   #define NVRHI_MIPGEN_SHADER
+    //   #include <nvrhi/nvrhiHLSL.h>
+    //   [numthreads(nvrhi::kMipGenGroupSize, 1, 1)]
+    //   void main(uint3 groupId : SV_GroupID, uint localIndex : SV_GroupIndex) { nvrhi::GenerateMips(groupId.xy, localIndex); }
+    // The integer shader is the same one compiled with NVRHI_MIPGEN_INTEGER defined, and is only needed for
+    // unsigned integer formats. On Vulkan, the shaders read a storage image without a format in the shader,
+    // which requires the shaderStorageImageReadWithoutFormat device feature.
+    // Supported formats are the uncompressed ones with the Normalized, Float and unsigned Integer kinds that
+    // support typed UAV stores, including sRGB formats which are written through views with the matching linear format.
+    // The binding sets are cached per texture and mip range, and reference the textures until clearCache() is called.
+    // The constructor clears the counter buffer used by the shader with a command list executed on the graphics queue,
+    // so passes recorded for other queues must not execute before that command list.
+    // The class is not thread-safe.
+    class MipChainGenerator
+    {
+    public:
+        NVRHI_API MipChainGenerator(IDevice* device, IShader* shader, IShader* integerShader = nullptr,
+            const std::string& debugName = "MipChainGenerator");
+
+        // Returns false if the resources or the pipeline for the floating point formats could not be created
+        [[nodiscard]] bool isValid() const { return m_Pipeline != nullptr; }
+
+        // Generates the mips baseMipLevel + 1 to baseMipLevel + numMipLevels of one array slice of 'texture'
+        // from mip baseMipLevel, by default the whole chain from mip 0.
+        // Returns false if the texture or its format is not supported.
+        NVRHI_API bool generateMips(ICommandList* commandList, ITexture* texture, ArraySlice arraySlice = 0,
+            MipLevel baseMipLevel = 0, MipLevel numMipLevels = TextureSubresourceSet::AllMipLevels, MipReduction reduction = MipReduction::Average);
+
+        // Generates all mips of 'pyramid' from mip 0 of 'depthTexture' with the Min or Max reduction, e.g. for HiZ
+        // occlusion culling. Each texel of pyramid mip 0 is reduced from 2x2 depth texels, so the pyramid should be
+        // half the size of the depth texture. The first texel of the depth SRV format is used.
+        // Every texel is reduced from exactly 2x2 texels of the previous mip, so for the Min and Max reductions to be
+        // conservative, each dimension of the depth texture must stay even until it reaches 1 over the pyramid mips,
+        // e.g. be a power of two: pad the depth texture or use fewer pyramid mips otherwise. generateMips with the Min
+        // or Max reduction has the same requirement, and both return false if it isn't met.
+        NVRHI_API bool generateDepthPyramid(ICommandList* commandList, ITexture* depthTexture, ITexture* pyramid,
+            MipReduction reduction, ArraySlice arraySlice = 0);
+
+        // Releases the cached binding sets and the references to the textures they hold
+        void clearCache() { m_BindingSets.clear(); }
+
+    private:
+        struct PassKey
+        {
+            ITexture* source;
+            ITexture* dest;
+            MipLevel sourceMipLevel;
+            MipLevel destMipLevel;
+            MipLevel numMipLevels;
+            ArraySlice arraySlice;
+
+            bool operator==(const PassKey& other) const;
+        };
+
+        struct PassKeyHash
+        {
+            size_t operator()(const PassKey& key) const;
+        };
+
+        IDevice* m_Device;
+        BufferHandle m_CounterBuffer;
+        BindingLayoutHandle m_BindingLayout;
+        ComputePipelineHandle m_Pipeline;
+        ComputePipelineHandle m_IntegerPipeline;
+        std::unordered_map<PassKey, BindingSetHandle, PassKeyHash> m_BindingSets;
+
+        bool generate(ICommandList* commandList, ITexture* source, ITexture* dest, ArraySlice arraySlice,
+            MipLevel sourceMipLevel, MipLevel destMipLevel, MipLevel numMipLevels, MipReduction reduction);
+        // Returns the number of mips generated by the pass, or 0 if the binding set could not be created
+        MipLevel dispatchPass(ICommandList* commandList, const PassKey& key, IComputePipeline* pipeline,
+            Format uavFormat, bool encodeSrgb, MipReduction reduction);
+    };
+
 }
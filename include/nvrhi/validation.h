@@ -26,5 +26,33 @@
 
 namespace nvrhi::validation
 {
+    enum class ValidationLevel : uint8_t
+    {
+        // Every call is checked completely, including binding sets against their layouts and the resources in them.
+        Full,
+
+        // One out of every samplingInterval command list recordings and binding set creations is checked completely,
+        // the others only get the StateOnly checks. Since most command lists are recorded once per frame,
+        // this validates a different subset of the frame's work every frame.
+        Sampled,
+
+        // Only state machine errors are reported: command lists that are not open, missing or invalidated
+        // pipeline state, wrong queue types, missing push constants, NULL objects and out of range vertex buffer slots
+        // that would crash the backend, and buffers bound as index, vertex or indirect argument buffers without the flag for it.
+        // Binding sets are not checked against their layouts, their resources are not validated, and graphics states are
+        // not checked against the framebuffer info of the pipeline.
+        StateOnly
+    };
+
+    struct ValidationLayerDesc
+    {
+        ValidationLevel level = ValidationLevel::Full;
+        uint32_t samplingInterval = 16;
+
+        constexpr ValidationLayerDesc& setLevel(ValidationLevel value) { level = value; return *this; }
+        constexpr ValidationLayerDesc& setSamplingInterval(uint32_t value) { samplingInterval = value; return *this; }
+    };
+
     NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice);
+    NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice, const ValidationLayerDesc& desc);
 }
@@ -75,9 +75,130 @@ namespace nvrhi::vulkan
 
         // Indicates if VkPhysicalDeviceVulkan12Features::bufferDeviceAddress was set to 'true' at device creation time
         bool bufferDeviceAddressSupported = false;
+
+        // VkApplicationInfo::apiVersion that the instance was created with. The Vulkan 1.3 core functionality,
+        // e.g. the extended dynamic state, is used when both this and the physical device support 1.3.
+        uint32_t apiVersion = VK_API_VERSION_1_2;
+
+        // The chain of feature structures that was passed in VkDeviceCreateInfo::pNext, starting with
+        // VkPhysicalDeviceFeatures2 (wrap VkDeviceCreateInfo::pEnabledFeatures in one if that was used instead).
+        // The optional features of the enabled extensions, such as those of VK_EXT_extended_dynamic_state3,
+        // are only used when they are enabled in this chain. It's only accessed during createDevice.
+        const void* enabledFeatures = nullptr;
         bool aftermathEnabled = false;
         bool logBufferLifetime = false;
 
+        // Size of the device memory blocks that buffers and textures are sub-allocated from.
+        // Larger resources, shared resources, and resources that the driver wants in dedicated allocations
+        // always get their own VkDeviceMemory. Set to 0 to disable sub-allocation.
+        uint64_t memoryBlockSize = 64 * 1024 * 1024;
+
+        // Size of the persistently mapped ring buffer that each command list takes upload memory
+        // (writeBuffer, writeTexture, shader tables, etc.) from. Requests that do not fit into the ring
+        // fall back to separately allocated chunks. Set to 0 to only use the chunks.
+        uint64_t uploadRingBufferSize = 0;
+
+        // Size of the persistently mapped buffers in the device-wide pool that asynchronous readbacks
+        // (ICommandList::readbackBuffer, readbackTexture) are suballocated from. The pool adds a buffer when
+        // a readback doesn't fit into the existing ones, sized to fit readbacks larger than this.
+        uint64_t readbackBufferSize = 4 * 1024 * 1024;
+
+        // If enabled, executeCommandLists makes the submission wait for the submissions on other queues that
+        // last wrote the resources it uses, or that last used the resources it writes. When the queues are in
+        // different families, the ownership of such resources is also transferred with release and acquire barriers.
+        // Only the resources tracked by the command list state trackers are considered, i.e. not those with
+        // permanent states, volatile or CPU-accessible buffers, or resources only referenced by bindless descriptors.
+        bool enableAutomaticQueueSync = false;
+        // Report every automatically inserted queue wait to IMessageCallback with the Info severity
+        bool logAutomaticQueueSync = false;
+
+        // If enabled, executeCommandLists doesn't submit the command lists right away, but accumulates them with
+        // their semaphore waits and signals, and IDevice::flushSubmissions submits all of them with one vkQueueSubmit2
+        // call per queue, or one multi-batch vkQueueSubmit when VK_KHR_synchronization2 is not enabled.
+        // The returned instance IDs are the same as without deferral. The pending submissions are also flushed when
+        // the CPU waits for them (waitForIdle, mapBuffer, event and timer queries), when another queue waits for them,
+        // and before updateTextureTileMappings. Polling a command list or query never flushes.
+        // The application must call flushSubmissions before presenting, and before signaling the semaphores
+        // it passes to queueWaitForSemaphore from outside of the device.
+        bool enableDeferredSubmission = false;
+
+        // If enabled, executeCommandLists transfers the ownership of resources that were last used on a queue
+        // of a different family, like enableAutomaticQueueSync does, but leaves the other cross-queue synchronization
+        // to the application, e.g. queueWaitForCommandList. This keeps exclusive-mode images in their compressed
+        // layouts when uploading on the copy queue. The release barriers are submitted on the source queue, and only
+        // those submissions are waited for automatically. Implied by enableAutomaticQueueSync.
+        bool enableQueueOwnershipTransfers = false;
+
+        // If enabled and VK_EXT_graphics_pipeline_library is enabled on the device with its graphicsPipelineLibrary feature,
+        // graphics pipelines are fast-linked from separately cached vertex input, pre-rasterization, fragment shader
+        // and fragment output libraries, and replaced with link-time optimized versions built in the background.
+        // This reduces the cost of creating pipelines that share shaders or state with the previously created ones.
+        bool enableGraphicsPipelineLibrary = false;
+
+        // If enabled, graphics pipelines are created with the rasterizer, depth-stencil and input assembly state
+        // declared dynamic (Vulkan 1.3 extended dynamic state), and setGraphicsState sets the parts of that state
+        // that differ from the previous pipeline with vkCmdSet* calls. Pipelines that only differ in the dynamic state
+        // share one VkPipeline, which reduces the number of pipelines to compile and bind.
+        // Requires Vulkan 1.3 (see apiVersion), or VK_EXT_extended_dynamic_state and VK_EXT_extended_dynamic_state2
+        // with their extendedDynamicState features enabled. Otherwise, the state is static with a warning.
+        // When the corresponding VK_EXT_extended_dynamic_state3 features are enabled, the blend state, fill mode and
+        // conservative raster mode are dynamic too, and with VK_EXT_vertex_input_dynamic_state, so is the input layout.
+        // Graphics pipeline libraries are not used for the pipelines created in this mode.
+        bool enableDynamicPipelineState = false;
+
+        // Maximum total size of the BLASes that one ICommandList::compactBottomLevelAccelStructs call compacts,
+        // measured before compaction. The call is typically made once per frame, and the BLASes that don't fit
+        // are left for the next calls. Set to 0 to compact all available BLASes at once. Not used with RTXMU.
+        // The same budget applies to the OMM arrays compacted by each ICommandList::compactOpacityMicromaps call.
+        uint64_t blasCompactionBudget = 64 * 1024 * 1024;
+
+        // If enabled, every acceleration structure and OMM build call is wrapped in a timer query taken from a pool,
+        // and IDevice::getAccelStructStats reports the GPU build time per frame. The pool uses up to
+        // 'maxAccelStructBuildTimerQueries' of the 'maxTimerQueries' timer queries. Reusable command lists are not timed.
+        bool enableAccelStructBuildTiming = false;
+        uint32_t maxAccelStructBuildTimerQueries = 64;
+
+        // If enabled, beginMarker / endMarker also record GPU timestamps into timer queries taken from a pool of up to
+        // 'maxProfilerTimerQueries' of the 'maxTimerQueries' timer queries, and IDevice::getProfilerFrameResults returns
+        // the timings as a tree of scopes per queue once the frame has finished executing. Markers in secondary,
+        // reusable and copy queue command lists are not timed.
+        // On Vulkan, the scope times are calibrated with the CPU clock when VK_EXT_calibrated_timestamps is enabled,
+        // and markers end the current render pass like timer queries do.
+        bool enableMarkerProfiling = false;
+        uint32_t maxProfilerTimerQueries = 128;
+
+        // If enabled, createBindingSet returns the existing binding set when one is created again with an identical
+        // BindingSetDesc and layout, instead of allocating and writing new descriptors. The cached sets are released
+        // by runGarbageCollection once the application no longer references them.
+        bool enableBindingSetCache = false;
+
+        // If enabled, createFramebuffer returns the existing framebuffer when one is created again with an identical
+        // FramebufferDesc, so that creating framebuffers every frame is cheap. The cached framebuffers keep their
+        // attachment textures alive until runGarbageCollection finds them unreferenced and not requested since its
+        // previous call. Use IDevice::evictCachedFramebuffers to release them earlier, e.g. the swap chain back
+        // buffers before the swap chain is resized.
+        bool enableFramebufferCache = false;
+
+        // If enabled and VK_EXT_descriptor_buffer is enabled on the device with its descriptorBuffer feature, the descriptors
+        // of binding sets and descriptor tables are written directly into one buffer of 'descriptorBufferSize' bytes
+        // and bound by offset, instead of being allocated and bound as descriptor sets, which makes both cheaper.
+        // All pipelines are then created for descriptor buffers, and binding sets have no native descriptor sets.
+        // Requires buffer device addresses. The robust buffer descriptor sizes are used when robustBufferAccess is enabled
+        // in 'enabledFeatures', so that chain must be provided for devices created with robustBufferAccess.
+        bool enableDescriptorBuffers = false;
+        uint64_t descriptorBufferSize = 64 * 1024 * 1024;
+
+        // If set and VK_KHR_deferred_host_operations is enabled on the device, ray tracing pipelines are compiled
+        // as deferred operations that the threads provided by the runner join, instead of on the calling thread only.
+        // buildTopLevelAccelStruct also splits the conversion of large instance arrays across the threads of the runner.
+        IParallelTaskRunner* parallelTaskRunner = nullptr;
+
+        // Optional initial contents of the pipeline cache, previously returned by IDevice::getPipelineCacheData.
+        // The data is ignored with a warning if its header doesn't match the physical device and driver.
+        // It's only accessed during createDevice.
+        const void* pipelineCacheData = nullptr;
+        size_t pipelineCacheDataSize = 0;
+
         std::string vulkanLibraryName; // if empty, use default
     };
 
@@ -0,0 +1,587 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/capture.h>
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace nvrhi::capture
+{
+    constexpr uint32_t c_TraceMagic = 0x5452564e; // 'NVRT'
+
+    // Increment when the encoding of any existing event changes. Adding new event types doesn't require that,
+    // since the replay skips the events that it doesn't know.
+    constexpr uint32_t c_TraceFormatVersion = 2;
+
+    // A trace starts with the TraceHeader, followed by a sequence of events. Each event is a 16-bit type and
+    // a 32-bit payload size, followed by the payload. The command list events are nested in a CommandListRecording
+    // event that is written when the command list is closed.
+    // New event types must be added at the end of their group to keep the older traces readable.
+    enum class EventType : uint16_t
+    {
+        // Device events
+        ReleaseObject = 1,
+        CreateTexture,
+        CreateBuffer,
+        CreateShader,
+        CreateSampler,
+        CreateInputLayout,
+        CreateFramebuffer,
+        CreateGraphicsPipeline,
+        CreateComputePipeline,
+        CreateBindingLayout,
+        CreateBindingSet,
+        CreateCommandList,
+        WriteMappedBuffer,
+        CommandListRecording,
+        ExecuteCommandLists,
+        WaitForIdle,
+        FrameBoundary,
+        Unsupported,
+
+        // Command list events
+        Open = 1000,
+        Close,
+        ClearState,
+        ClearTextureFloat,
+        ClearDepthStencilTexture,
+        ClearTextureUInt,
+        CopyTexture,
+        WriteTexture,
+        ResolveTexture,
+        WriteBuffer,
+        ClearBufferUInt,
+        CopyBuffer,
+        CreateTransientBindingSet,
+        SetPushConstants,
+        SetGraphicsState,
+        SetGraphicsBindingSet,
+        SetVertexBuffers,
+        SetIndexBuffer,
+        SetComputeState,
+        Draw,
+        DrawIndexed,
+        DrawBatch,
+        DrawIndexedBatch,
+        DrawIndirect,
+        DrawIndexedIndirect,
+        Dispatch,
+        DispatchIndirect,
+        BeginMarker,
+        EndMarker,
+        SetEnableAutomaticBarriers,
+        SetResourceStatesForBindingSet,
+        SetEnableUavBarriersForTexture,
+        SetEnableUavBarriersForBuffer,
+        BeginTrackingTextureState,
+        BeginTrackingBufferState,
+        SetTextureState,
+        SetBufferState,
+        SetPermanentTextureState,
+        SetPermanentBufferState,
+        CommitBarriers
+    };
+
+    struct TraceHeader
+    {
+        uint32_t magic = c_TraceMagic;
+        uint32_t formatVersion = c_TraceFormatVersion;
+        uint32_t headerVersion = c_HeaderVersion;
+        GraphicsAPI graphicsAPI = GraphicsAPI::D3D11;
+    };
+
+    // Assigns trace IDs to the objects created through the capture layer. IDs are never reused:
+    // when an object is created at the address of a destroyed one, the old ID is reported as released.
+    class ObjectRegistry
+    {
+    public:
+        uint32_t add(IResource* object, uint32_t& outReleasedId);
+
+        // Returns 0 for NULL and for objects that weren't created through the capture layer
+        uint32_t find(IResource* object) const;
+
+    private:
+        mutable std::mutex m_Mutex;
+        std::unordered_map<IResource*, uint32_t> m_Ids;
+        uint32_t m_NextId = 1;
+    };
+
+    class TraceWriter
+    {
+    public:
+        static constexpr bool IsReading = false;
+
+        explicit TraceWriter(const ObjectRegistry& registry) : m_Registry(registry) { }
+
+        void beginEvent(EventType type);
+        void endEvent();
+
+        void bytes(const void* data, size_t size);
+        void blob(const void* data, size_t size);
+        void events(const TraceWriter& nested);
+
+        template<typename T> void pod(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            bytes(&value, sizeof(T));
+        }
+
+        void string(const std::string& value);
+
+        template<typename T> void object(T* const& value) { pod(m_Registry.find(value)); }
+        template<typename T> void object(const RefCountPtr<T>& value) { pod(m_Registry.find(value.Get())); }
+
+        template<typename V, typename F> void vector(const V& values, F&& serializeElement)
+        {
+            pod(uint32_t(values.size()));
+            for (const auto& value : values)
+                serializeElement(const_cast<typename V::value_type&>(value));
+        }
+
+        [[nodiscard]] const std::vector<uint8_t>& getData() const { return m_Data; }
+        void clear() { m_Data.clear(); m_OpenEvents.clear(); }
+
+    private:
+        const ObjectRegistry& m_Registry;
+        std::vector<uint8_t> m_Data;
+        std::vector<size_t> m_OpenEvents;
+    };
+
+    // Reads the events written by TraceWriter. Reading past the end of the data returns zeros
+    // and sets the failed flag.
+    class TraceReader
+    {
+    public:
+        static constexpr bool IsReading = true;
+
+        TraceReader(const uint8_t* data, size_t size, const std::vector<RefCountPtr<IResource>>& objects)
+            : m_Data(data), m_End(data + size), m_Objects(&objects)
+        { }
+
+        // Reads the next event header and returns a reader for its payload
+        bool nextEvent(EventType& outType, TraceReader& outPayload);
+
+        void bytes(void* data, size_t size);
+        const uint8_t* blob(size_t& outSize);
+
+        template<typename T> void pod(T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            bytes(&value, sizeof(T));
+        }
+
+        template<typename T> T read() { T value{}; pod(value); return value; }
+
+        void string(std::string& value);
+
+        template<typename T> void object(T*& value) { value = static_cast<T*>(findObject(read<uint32_t>())); }
+        template<typename T> void object(RefCountPtr<T>& value) { value = static_cast<T*>(findObject(read<uint32_t>())); }
+
+        template<typename V, typename F> void vector(V& values, F&& serializeElement)
+        {
+            const uint32_t count = read<uint32_t>();
+            if (count > values.max_size() || count > remaining())
+            {
+                m_Failed = true;
+                values.resize(0);
+                return;
+            }
+
+            values.resize(count);
+            for (auto& value : values)
+                serializeElement(value);
+        }
+
+        IResource* findObject(uint32_t id);
+
+        [[nodiscard]] size_t remaining() const { return size_t(m_End - m_Data); }
+        [[nodiscard]] bool failed() const { return m_Failed; }
+        [[nodiscard]] uint32_t getNumMissingObjects() const { return m_NumMissingObjects; }
+
+    private:
+        const uint8_t* m_Data;
+        const uint8_t* m_End;
+        const std::vector<RefCountPtr<IResource>>* m_Objects;
+        bool m_Failed = false;
+        uint32_t m_NumMissingObjects = 0;
+    };
+
+    // Size of the data passed to writeTexture for one mip level of one array slice
+    size_t getTextureWriteSize(const TextureDesc& desc, uint32_t mipLevel, size_t rowPitch, size_t depthPitch);
+
+    class DeviceWrapper;
+
+    class CommandListWrapper : public RefCounter<ICommandList>
+    {
+    public:
+        friend class DeviceWrapper;
+
+        CommandListWrapper(DeviceWrapper* device, ICommandList* commandList);
+
+    protected:
+        CommandListHandle m_CommandList;
+        RefCountPtr<DeviceWrapper> m_Device;
+        uint32_t m_Id = 0;
+
+        // Events recorded since open, written into the trace on close
+        TraceWriter m_Writer;
+
+        // The region returned by beginWriteBuffer or beginWriteTexture, recorded on commitWrite
+        MappedWriteRegion m_PendingWrite;
+        IBuffer* m_PendingWriteBuffer = nullptr;
+        uint64_t m_PendingWriteOffset = 0;
+        ITexture* m_PendingWriteTexture = nullptr;
+        uint32_t m_PendingWriteArraySlice = 0;
+        uint32_t m_PendingWriteMipLevel = 0;
+
+        // Records an event with the callback writing its payload
+        template<typename F> void writeEvent(EventType type, F&& writePayload)
+        {
+            m_Writer.beginEvent(type);
+            writePayload(m_Writer);
+            m_Writer.endEvent();
+        }
+
+        void writeEvent(EventType type) { writeEvent(type, [](TraceWriter&) { }); }
+        void unsupported(const char* function);
+
+    public:
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // ICommandList implementation
+
+        void open() override;
+        void close() override;
+        void openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport) override;
+        void executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists) override;
+        void clearState() override;
+
+        void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
+        void clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil) override;
+        void clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor) override;
+
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
+        void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+
+        void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
+        MappedWriteRegion beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
+        MappedWriteRegion beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes) override;
+        void commitWrite() override;
+        void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
+        void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        ReadbackTicketHandle readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback) override;
+        ReadbackTicketHandle readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback) override;
+
+        void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
+        void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format) override;
+        void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+
+        void setPushConstants(const void* data, size_t byteSize) override;
+        void setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings) override;
+        BindingSetHandle createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
+        void drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset) override;
+
+        void setComputeState(const ComputeState& state) override;
+        void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchIndirect(uint32_t offsetBytes)  override;
+
+        void setMeshletState(const MeshletState& state) override;
+        void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount) override;
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const WorkGraphDispatchArguments& args) override;
+
+        void setRayTracingState(const rt::State& state) override;
+        void dispatchRays(const rt::DispatchRaysArguments& args) override;
+
+        void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
+        void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactBottomLevelAccelStructs() override;
+        void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+            nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
+
+        void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
+
+        void beginTimerQuery(ITimerQuery* query) override;
+        void endTimerQuery(ITimerQuery* query) override;
+
+        void beginMarker(const char* name) override;
+        void endMarker() override;
+
+        void setEnableAutomaticBarriers(bool enable) override;
+        void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
+
+        void setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers) override;
+        void setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers) override;
+
+        void beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void setBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits) override;
+
+        void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
+        void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, ResourceStates nextState) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
+        void commitBarriers() override;
+        
+        ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
+        ResourceStates getBufferState(IBuffer* buffer) override;
+
+        IDevice* getDevice() override;
+        const CommandListParameters& getDesc() override;
+        CommandListStats getStats() override;
+    };
+
+    class DeviceWrapper : public RefCounter<IDevice>
+    {
+    public:
+        friend class CommandListWrapper;
+
+        DeviceWrapper(IDevice* device);
+
+        bool openTraceFile(const char* fileName);
+
+    protected:
+        DeviceHandle m_Device;
+        IMessageCallback* m_MessageCallback;
+        ObjectRegistry m_Registry;
+
+        // Protects the trace file and the bookkeeping below, always acquired before the registry lock
+        std::mutex m_TraceMutex;
+        std::ofstream m_TraceFile;
+        std::unordered_map<IBuffer*, void*> m_MappedBuffers;
+        std::unordered_set<std::string> m_ReportedUnsupportedFunctions;
+
+        void warning(const std::string& messageText) const;
+
+        // Records an event with the callback writing its payload
+        template<typename F> void writeEvent(EventType type, F&& writePayload);
+
+        // Assigns an ID to a newly created object and records its creation event, which starts with the ID.
+        // Objects that failed to be created are not recorded.
+        template<typename F> void writeCreation(EventType type, IResource* object, F&& writePayload);
+
+        void writeCommandListRecording(uint32_t commandListId, const TraceWriter& events);
+
+        // Records a frame boundary and flushes the trace file, the replay doesn't distinguish the budgeted collections
+        void writeFrameBoundary();
+
+        // Unsupported calls are recorded every time, but only reported once per function
+        void warnUnsupported(const char* function);
+        void writeUnsupported(const char* function);
+
+    public:
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // IDevice implementation
+
+        HeapHandle createHeap(const HeapDesc& d) override;
+
+        TextureHandle createTexture(const TextureDesc& d) override;
+        MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
+        bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+
+        TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
+
+        StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
+        void unmapStagingTexture(IStagingTexture* tex) override;
+
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+
+        SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+        SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
+
+        BufferHandle createBuffer(const BufferDesc& d) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void unmapBuffer(IBuffer* b) override;
+        MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
+        bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
+
+        BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
+        ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+
+        SamplerHandle createSampler(const SamplerDesc& d) override;
+
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) override;
+
+        // event queries
+        EventQueryHandle createEventQuery() override;
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override;
+        bool pollEventQuery(IEventQuery* query) override;
+        void waitEventQuery(IEventQuery* query) override;
+        void resetEventQuery(IEventQuery* query) override;
+        SubmissionTicket getSubmissionTicket(CommandQueue queue) override;
+        bool pollSubmission(const SubmissionTicket& ticket) override;
+        bool waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
+        bool waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
+
+        // timer queries
+        TimerQueryHandle createTimerQuery() override;
+        bool pollTimerQuery(ITimerQuery* query) override;
+        float getTimerQueryTime(ITimerQuery* query) override;
+        void resetTimerQuery(ITimerQuery* query) override;
+
+        GraphicsAPI getGraphicsAPI() override;
+
+        FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override;
+
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        WorkGraphPipelineHandle createWorkGraphPipeline(const WorkGraphPipelineDesc& desc) override;
+
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline) override;
+
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
+
+        BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
+
+        void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc)  override;
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override;
+        bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
+
+        CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void flushSubmissions() override;
+        bool waitForIdle() override;
+        void runGarbageCollection() override;
+        void runGarbageCollection(uint32_t maxReleaseMicroseconds) override;
+        void evictCachedFramebuffers(ITexture* texture) override;
+        bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
+        FormatSupport queryFormatSupport(Format format) override;
+        MemoryAllocatorStats getMemoryAllocatorStats() override;
+        MemoryBudget getMemoryBudget() override;
+        AccelStructStats getAccelStructStats() override;
+        DeviceStats getDeviceStats() override;
+        bool getProfilerFrameResults(ProfilerFrameResults& outResults) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& data) override;
+        coopvec::DeviceFeatures queryCoopVecFeatures() override;
+        size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
+        Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
+        IMessageCallback* getMessageCallback() override;
+        bool isAftermathEnabled() override;
+        AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override;
+    };
+
+    template<typename F> void DeviceWrapper::writeEvent(EventType type, F&& writePayload)
+    {
+        std::lock_guard lock(m_TraceMutex);
+
+        TraceWriter writer(m_Registry);
+        writer.beginEvent(type);
+        writePayload(writer);
+        writer.endEvent();
+
+        m_TraceFile.write(reinterpret_cast<const char*>(writer.getData().data()), std::streamsize(writer.getData().size()));
+    }
+
+    template<typename F> void DeviceWrapper::writeCreation(EventType type, IResource* object, F&& writePayload)
+    {
+        if (!object)
+            return;
+
+        std::lock_guard lock(m_TraceMutex);
+
+        uint32_t releasedId = 0;
+        const uint32_t id = m_Registry.add(object, releasedId);
+
+        TraceWriter writer(m_Registry);
+        if (releasedId)
+        {
+            writer.beginEvent(EventType::ReleaseObject);
+            writer.pod(releasedId);
+            writer.endEvent();
+        }
+
+        writer.beginEvent(type);
+        writer.pod(id);
+        writePayload(writer);
+        writer.endEvent();
+
+        m_TraceFile.write(reinterpret_cast<const char*>(writer.getData().data()), std::streamsize(writer.getData().size()));
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,784 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "capture-serialize.h"
+
+namespace nvrhi::capture
+{
+    CommandListWrapper::CommandListWrapper(DeviceWrapper* device, ICommandList* commandList)
+        : m_CommandList(commandList)
+        , m_Device(device)
+        , m_Writer(device->m_Registry)
+    { }
+
+    void CommandListWrapper::unsupported(const char* function)
+    {
+        m_Device->warnUnsupported(function);
+        writeEvent(EventType::Unsupported, [&](TraceWriter& w) { w.string(function); });
+    }
+
+    Object CommandListWrapper::getNativeObject(ObjectType objectType)
+    {
+        return m_CommandList->getNativeObject(objectType);
+    }
+
+    void CommandListWrapper::open()
+    {
+        m_Writer.clear();
+        writeEvent(EventType::Open);
+
+        m_CommandList->open();
+    }
+
+    void CommandListWrapper::close()
+    {
+        m_CommandList->close();
+
+        writeEvent(EventType::Close);
+        m_Device->writeCommandListRecording(m_Id, m_Writer);
+        m_Writer.clear();
+    }
+
+    void CommandListWrapper::openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport)
+    {
+        m_Writer.clear();
+        writeEvent(EventType::Open);
+        unsupported("openSecondary");
+
+        m_CommandList->openSecondary(framebuffer, viewport);
+    }
+
+    void CommandListWrapper::executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        unsupported("executeSecondaryCommandLists");
+
+        std::vector<ICommandList*> unwrappedCommandLists;
+        unwrappedCommandLists.resize(numCommandLists);
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(pCommandLists[i]);
+            unwrappedCommandLists[i] = wrapper ? wrapper->m_CommandList.Get() : pCommandLists[i];
+        }
+
+        m_CommandList->executeSecondaryCommandLists(unwrappedCommandLists.data(), unwrappedCommandLists.size());
+    }
+
+    void CommandListWrapper::clearState()
+    {
+        writeEvent(EventType::ClearState);
+        m_CommandList->clearState();
+    }
+
+    void CommandListWrapper::clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor)
+    {
+        writeEvent(EventType::ClearTextureFloat, [&](TraceWriter& w)
+        {
+            w.object(t);
+            w.pod(subresources);
+            w.pod(clearColor);
+        });
+
+        m_CommandList->clearTextureFloat(t, subresources, clearColor);
+    }
+
+    void CommandListWrapper::clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
+    {
+        writeEvent(EventType::ClearDepthStencilTexture, [&](TraceWriter& w)
+        {
+            w.object(t);
+            w.pod(subresources);
+            w.pod(clearDepth);
+            w.pod(depth);
+            w.pod(clearStencil);
+            w.pod(stencil);
+        });
+
+        m_CommandList->clearDepthStencilTexture(t, subresources, clearDepth, depth, clearStencil, stencil);
+    }
+
+    void CommandListWrapper::clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor)
+    {
+        writeEvent(EventType::ClearTextureUInt, [&](TraceWriter& w)
+        {
+            w.object(t);
+            w.pod(subresources);
+            w.pod(clearColor);
+        });
+
+        m_CommandList->clearTextureUInt(t, subresources, clearColor);
+    }
+
+    void CommandListWrapper::copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        writeEvent(EventType::CopyTexture, [&](TraceWriter& w)
+        {
+            w.object(dest);
+            w.pod(destSlice);
+            w.object(src);
+            w.pod(srcSlice);
+        });
+
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        unsupported("copyTexture(IStagingTexture*, ITexture*)");
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice)
+    {
+        unsupported("copyTexture(ITexture*, IStagingTexture*)");
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        writeEvent(EventType::WriteTexture, [&](TraceWriter& w)
+        {
+            w.object(dest);
+            w.pod(arraySlice);
+            w.pod(mipLevel);
+            w.pod(uint64_t(rowPitch));
+            w.pod(uint64_t(depthPitch));
+            w.blob(data, getTextureWriteSize(dest->getDesc(), mipLevel, rowPitch, depthPitch));
+        });
+
+        m_CommandList->writeTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+    }
+
+    void CommandListWrapper::resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources)
+    {
+        writeEvent(EventType::ResolveTexture, [&](TraceWriter& w)
+        {
+            w.object(dest);
+            w.pod(dstSubresources);
+            w.object(src);
+            w.pod(srcSubresources);
+        });
+
+        m_CommandList->resolveTexture(dest, dstSubresources, src, srcSubresources);
+    }
+
+    void CommandListWrapper::writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        writeEvent(EventType::WriteBuffer, [&](TraceWriter& w)
+        {
+            w.object(b);
+            w.pod(destOffsetBytes);
+            w.blob(data, dataSize);
+        });
+
+        m_CommandList->writeBuffer(b, data, dataSize, destOffsetBytes);
+    }
+
+    MappedWriteRegion CommandListWrapper::beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        m_PendingWrite = m_CommandList->beginWriteTexture(dest, arraySlice, mipLevel);
+        m_PendingWriteBuffer = nullptr;
+        m_PendingWriteTexture = dest;
+        m_PendingWriteArraySlice = arraySlice;
+        m_PendingWriteMipLevel = mipLevel;
+        return m_PendingWrite;
+    }
+
+    MappedWriteRegion CommandListWrapper::beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        m_PendingWrite = m_CommandList->beginWriteBuffer(b, dataSize, destOffsetBytes);
+        m_PendingWriteBuffer = b;
+        m_PendingWriteOffset = destOffsetBytes;
+        m_PendingWriteTexture = nullptr;
+        return m_PendingWrite;
+    }
+
+    void CommandListWrapper::commitWrite()
+    {
+        // The data written into the upload memory is recorded as a regular write
+        if (m_PendingWrite.data && m_PendingWriteBuffer)
+        {
+            writeEvent(EventType::WriteBuffer, [&](TraceWriter& w)
+            {
+                w.object(m_PendingWriteBuffer);
+                w.pod(m_PendingWriteOffset);
+                w.blob(m_PendingWrite.data, m_PendingWrite.size);
+            });
+        }
+        else if (m_PendingWrite.data && m_PendingWriteTexture)
+        {
+            writeEvent(EventType::WriteTexture, [&](TraceWriter& w)
+            {
+                w.object(m_PendingWriteTexture);
+                w.pod(m_PendingWriteArraySlice);
+                w.pod(m_PendingWriteMipLevel);
+                w.pod(uint64_t(m_PendingWrite.rowPitch));
+                w.pod(uint64_t(m_PendingWrite.depthPitch));
+                w.blob(m_PendingWrite.data, m_PendingWrite.size);
+            });
+        }
+
+        m_PendingWrite = MappedWriteRegion();
+        m_PendingWriteBuffer = nullptr;
+        m_PendingWriteTexture = nullptr;
+
+        m_CommandList->commitWrite();
+    }
+
+    void CommandListWrapper::clearBufferUInt(IBuffer* b, uint32_t clearValue)
+    {
+        writeEvent(EventType::ClearBufferUInt, [&](TraceWriter& w)
+        {
+            w.object(b);
+            w.pod(clearValue);
+        });
+
+        m_CommandList->clearBufferUInt(b, clearValue);
+    }
+
+    void CommandListWrapper::copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        writeEvent(EventType::CopyBuffer, [&](TraceWriter& w)
+        {
+            w.object(dest);
+            w.pod(destOffsetBytes);
+            w.object(src);
+            w.pod(srcOffsetBytes);
+            w.pod(dataSizeBytes);
+        });
+
+        m_CommandList->copyBuffer(dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
+    }
+
+    ReadbackTicketHandle CommandListWrapper::readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback)
+    {
+        unsupported("readbackBuffer");
+        return m_CommandList->readbackBuffer(b, offsetBytes, sizeBytes, std::move(callback));
+    }
+
+    ReadbackTicketHandle CommandListWrapper::readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback)
+    {
+        unsupported("readbackTexture");
+        return m_CommandList->readbackTexture(texture, slice, std::move(callback));
+    }
+
+    void CommandListWrapper::clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture)
+    {
+        unsupported("clearSamplerFeedbackTexture");
+        m_CommandList->clearSamplerFeedbackTexture(texture);
+    }
+
+    void CommandListWrapper::decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format)
+    {
+        unsupported("decodeSamplerFeedbackTexture");
+        m_CommandList->decodeSamplerFeedbackTexture(buffer, texture, format);
+    }
+
+    void CommandListWrapper::setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits)
+    {
+        unsupported("setSamplerFeedbackTextureState");
+        m_CommandList->setSamplerFeedbackTextureState(texture, stateBits);
+    }
+
+    void CommandListWrapper::setPushConstants(const void* data, size_t byteSize)
+    {
+        writeEvent(EventType::SetPushConstants, [&](TraceWriter& w) { w.blob(data, byteSize); });
+        m_CommandList->setPushConstants(data, byteSize);
+    }
+
+    void CommandListWrapper::setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings)
+    {
+        unsupported("setPushBindings");
+        m_CommandList->setPushBindings(layoutIndex, bindings);
+    }
+
+    BindingSetHandle CommandListWrapper::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSetHandle bindingSet = m_CommandList->createTransientBindingSet(desc, layout);
+        if (!bindingSet)
+            return nullptr;
+
+        // Transient binding sets are registered like the device objects, but their creation is replayed
+        // on the command list, in the recording order
+        uint32_t releasedId = 0;
+        const uint32_t id = m_Device->m_Registry.add(bindingSet, releasedId);
+
+        if (releasedId)
+            writeEvent(EventType::ReleaseObject, [&](TraceWriter& w) { w.pod(releasedId); });
+
+        writeEvent(EventType::CreateTransientBindingSet, [&](TraceWriter& w)
+        {
+            w.pod(id);
+            write(w, desc);
+            w.object(layout);
+        });
+
+        return bindingSet;
+    }
+
+    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    {
+        writeEvent(EventType::SetGraphicsState, [&](TraceWriter& w) { write(w, state); });
+        m_CommandList->setGraphicsState(state);
+    }
+
+    void CommandListWrapper::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        writeEvent(EventType::SetGraphicsBindingSet, [&](TraceWriter& w)
+        {
+            w.pod(slot);
+            w.object(bindingSet);
+        });
+
+        m_CommandList->setGraphicsBindingSet(slot, bindingSet);
+    }
+
+    void CommandListWrapper::setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings)
+    {
+        writeEvent(EventType::SetVertexBuffers, [&](TraceWriter& w)
+        {
+            w.pod(uint32_t(numBindings));
+            for (size_t i = 0; i < numBindings; i++)
+            {
+                w.object(pBindings[i].buffer);
+                w.pod(pBindings[i].slot);
+                w.pod(pBindings[i].offset);
+            }
+        });
+
+        m_CommandList->setVertexBuffers(pBindings, numBindings);
+    }
+
+    void CommandListWrapper::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        writeEvent(EventType::SetIndexBuffer, [&](TraceWriter& w)
+        {
+            w.object(binding.buffer);
+            w.pod(binding.format);
+            w.pod(binding.offset);
+        });
+
+        m_CommandList->setIndexBuffer(binding);
+    }
+
+    void CommandListWrapper::draw(const DrawArguments& args)
+    {
+        writeEvent(EventType::Draw, [&](TraceWriter& w) { w.pod(args); });
+        m_CommandList->draw(args);
+    }
+
+    void CommandListWrapper::drawIndexed(const DrawArguments& args)
+    {
+        writeEvent(EventType::DrawIndexed, [&](TraceWriter& w) { w.pod(args); });
+        m_CommandList->drawIndexed(args);
+    }
+
+    // Records the draw arguments and the per-draw push constants of a drawBatch or drawIndexedBatch call
+    static void writeDrawBatch(TraceWriter& w, const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        w.pod(uint32_t(count));
+        w.bytes(args, sizeof(DrawArguments) * count);
+
+        const size_t stride = pushConstantStride ? pushConstantStride : pushConstantByteSize;
+        const size_t pushConstantDataSize = (pushConstants && count) ? stride * (count - 1) + pushConstantByteSize : 0;
+
+        w.pod(uint64_t(pushConstantByteSize));
+        w.pod(uint64_t(stride));
+        w.blob(pushConstants, pushConstantDataSize);
+    }
+
+    void CommandListWrapper::drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        writeEvent(EventType::DrawBatch, [&](TraceWriter& w)
+        {
+            writeDrawBatch(w, args, count, pushConstants, pushConstantByteSize, pushConstantStride);
+        });
+
+        m_CommandList->drawBatch(args, count, pushConstants, pushConstantByteSize, pushConstantStride);
+    }
+
+    void CommandListWrapper::drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        writeEvent(EventType::DrawIndexedBatch, [&](TraceWriter& w)
+        {
+            writeDrawBatch(w, args, count, pushConstants, pushConstantByteSize, pushConstantStride);
+        });
+
+        m_CommandList->drawIndexedBatch(args, count, pushConstants, pushConstantByteSize, pushConstantStride);
+    }
+
+    void CommandListWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        writeEvent(EventType::DrawIndirect, [&](TraceWriter& w)
+        {
+            w.pod(offsetBytes);
+            w.pod(drawCount);
+        });
+
+        m_CommandList->drawIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        writeEvent(EventType::DrawIndexedIndirect, [&](TraceWriter& w)
+        {
+            w.pod(offsetBytes);
+            w.pod(drawCount);
+        });
+
+        m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount)
+    {
+        unsupported("drawIndexedIndirectCount");
+        m_CommandList->drawIndexedIndirectCount(offsetBytes, countBuffer, countBufferOffset, maxDrawCount);
+    }
+
+    void CommandListWrapper::executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset)
+    {
+        unsupported("executeIndirect");
+        m_CommandList->executeIndirect(signature, offsetBytes, maxCommandCount, countBuffer, countBufferOffset);
+    }
+
+    void CommandListWrapper::setComputeState(const ComputeState& state)
+    {
+        writeEvent(EventType::SetComputeState, [&](TraceWriter& w) { write(w, state); });
+        m_CommandList->setComputeState(state);
+    }
+
+    void CommandListWrapper::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        writeEvent(EventType::Dispatch, [&](TraceWriter& w)
+        {
+            w.pod(groupsX);
+            w.pod(groupsY);
+            w.pod(groupsZ);
+        });
+
+        m_CommandList->dispatch(groupsX, groupsY, groupsZ);
+    }
+
+    void CommandListWrapper::dispatchIndirect(uint32_t offsetBytes)
+    {
+        writeEvent(EventType::DispatchIndirect, [&](TraceWriter& w) { w.pod(offsetBytes); });
+        m_CommandList->dispatchIndirect(offsetBytes);
+    }
+
+    void CommandListWrapper::setMeshletState(const MeshletState& state)
+    {
+        unsupported("setMeshletState");
+        m_CommandList->setMeshletState(state);
+    }
+
+    void CommandListWrapper::dispatchMesh(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        unsupported("dispatchMesh");
+        m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        unsupported("dispatchMeshIndirect");
+        m_CommandList->dispatchMeshIndirect(offsetBytes, dispatchCount);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount)
+    {
+        unsupported("dispatchMeshIndirectCount");
+        m_CommandList->dispatchMeshIndirectCount(offsetBytes, countBufferOffset, maxDispatchCount);
+    }
+
+    void CommandListWrapper::setWorkGraphState(const WorkGraphState& state)
+    {
+        unsupported("setWorkGraphState");
+        m_CommandList->setWorkGraphState(state);
+    }
+
+    void CommandListWrapper::dispatchGraph(const WorkGraphDispatchArguments& args)
+    {
+        unsupported("dispatchGraph");
+        m_CommandList->dispatchGraph(args);
+    }
+
+    void CommandListWrapper::setRayTracingState(const rt::State& state)
+    {
+        unsupported("setRayTracingState");
+        m_CommandList->setRayTracingState(state);
+    }
+
+    void CommandListWrapper::dispatchRays(const rt::DispatchRaysArguments& args)
+    {
+        unsupported("dispatchRays");
+        m_CommandList->dispatchRays(args);
+    }
+
+    void CommandListWrapper::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc)
+    {
+        unsupported("buildOpacityMicromap");
+        m_CommandList->buildOpacityMicromap(omm, desc);
+    }
+
+    void CommandListWrapper::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds)
+    {
+        unsupported("buildOpacityMicromaps");
+        m_CommandList->buildOpacityMicromaps(pBuilds, numBuilds);
+    }
+
+    void CommandListWrapper::compactOpacityMicromaps()
+    {
+        unsupported("compactOpacityMicromaps");
+        m_CommandList->compactOpacityMicromaps();
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupported("buildBottomLevelAccelStruct");
+        m_CommandList->buildBottomLevelAccelStruct(as, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+        unsupported("buildBottomLevelAccelStructs");
+        m_CommandList->buildBottomLevelAccelStructs(pBuilds, numBuilds);
+    }
+
+    void CommandListWrapper::compactBottomLevelAccelStructs()
+    {
+        unsupported("compactBottomLevelAccelStructs");
+        m_CommandList->compactBottomLevelAccelStructs();
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupported("buildTopLevelAccelStruct");
+        m_CommandList->buildTopLevelAccelStruct(as, pInstances, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+        rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupported("buildTopLevelAccelStructFromBuffer");
+        m_CommandList->buildTopLevelAccelStructFromBuffer(as, instanceBuffer, instanceBufferOffset, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+        nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupported("buildTopLevelAccelStructFromBufferIndirect");
+        m_CommandList->buildTopLevelAccelStructFromBufferIndirect(as, instanceBuffer, instanceBufferOffset, argsBuffer, argsBufferOffset, maxInstances, buildFlags);
+    }
+
+    void CommandListWrapper::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
+    {
+        unsupported("executeMultiIndirectClusterOperation");
+        m_CommandList->executeMultiIndirectClusterOperation(desc);
+    }
+
+    void CommandListWrapper::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
+    {
+        unsupported("convertCoopVecMatrices");
+        m_CommandList->convertCoopVecMatrices(convertDescs, numDescs);
+    }
+
+    // The replay measures the command lists with its own timer queries, so the application queries are not recorded
+    void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
+    {
+        m_CommandList->beginTimerQuery(query);
+    }
+
+    void CommandListWrapper::endTimerQuery(ITimerQuery* query)
+    {
+        m_CommandList->endTimerQuery(query);
+    }
+
+    void CommandListWrapper::beginMarker(const char* name)
+    {
+        writeEvent(EventType::BeginMarker, [&](TraceWriter& w) { w.string(name); });
+        m_CommandList->beginMarker(name);
+    }
+
+    void CommandListWrapper::endMarker()
+    {
+        writeEvent(EventType::EndMarker);
+        m_CommandList->endMarker();
+    }
+
+    void CommandListWrapper::setEnableAutomaticBarriers(bool enable)
+    {
+        writeEvent(EventType::SetEnableAutomaticBarriers, [&](TraceWriter& w) { w.pod(enable); });
+        m_CommandList->setEnableAutomaticBarriers(enable);
+    }
+
+    void CommandListWrapper::setResourceStatesForBindingSet(IBindingSet* bindingSet)
+    {
+        writeEvent(EventType::SetResourceStatesForBindingSet, [&](TraceWriter& w) { w.object(bindingSet); });
+        m_CommandList->setResourceStatesForBindingSet(bindingSet);
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers)
+    {
+        writeEvent(EventType::SetEnableUavBarriersForTexture, [&](TraceWriter& w)
+        {
+            w.object(texture);
+            w.pod(enableBarriers);
+        });
+
+        m_CommandList->setEnableUavBarriersForTexture(texture, enableBarriers);
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers)
+    {
+        writeEvent(EventType::SetEnableUavBarriersForBuffer, [&](TraceWriter& w)
+        {
+            w.object(buffer);
+            w.pod(enableBarriers);
+        });
+
+        m_CommandList->setEnableUavBarriersForBuffer(buffer, enableBarriers);
+    }
+
+    void CommandListWrapper::beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        writeEvent(EventType::BeginTrackingTextureState, [&](TraceWriter& w)
+        {
+            w.object(texture);
+            w.pod(subresources);
+            w.pod(stateBits);
+        });
+
+        m_CommandList->beginTrackingTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        writeEvent(EventType::BeginTrackingBufferState, [&](TraceWriter& w)
+        {
+            w.object(buffer);
+            w.pod(stateBits);
+        });
+
+        m_CommandList->beginTrackingBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        writeEvent(EventType::SetTextureState, [&](TraceWriter& w)
+        {
+            w.object(texture);
+            w.pod(subresources);
+            w.pod(stateBits);
+        });
+
+        m_CommandList->setTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::setBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        writeEvent(EventType::SetBufferState, [&](TraceWriter& w)
+        {
+            w.object(buffer);
+            w.pod(stateBits);
+        });
+
+        m_CommandList->setBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits)
+    {
+        unsupported("setAccelStructState");
+        m_CommandList->setAccelStructState(as, stateBits);
+    }
+
+    void CommandListWrapper::setPermanentTextureState(ITexture* texture, ResourceStates stateBits)
+    {
+        writeEvent(EventType::SetPermanentTextureState, [&](TraceWriter& w)
+        {
+            w.object(texture);
+            w.pod(stateBits);
+        });
+
+        m_CommandList->setPermanentTextureState(texture, stateBits);
+    }
+
+    void CommandListWrapper::setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        writeEvent(EventType::SetPermanentBufferState, [&](TraceWriter& w)
+        {
+            w.object(buffer);
+            w.pod(stateBits);
+        });
+
+        m_CommandList->setPermanentBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::beginTextureStateTransition(ITexture* texture, ResourceStates nextState)
+    {
+        unsupported("beginTextureStateTransition");
+        m_CommandList->beginTextureStateTransition(texture, nextState);
+    }
+
+    void CommandListWrapper::beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState)
+    {
+        unsupported("beginBufferStateTransition");
+        m_CommandList->beginBufferStateTransition(buffer, nextState);
+    }
+
+    void CommandListWrapper::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        unsupported("aliasingBarrier");
+        m_CommandList->aliasingBarrier(resourceBefore, resourceAfter);
+    }
+
+    void CommandListWrapper::commitBarriers()
+    {
+        writeEvent(EventType::CommitBarriers);
+        m_CommandList->commitBarriers();
+    }
+
+    ResourceStates CommandListWrapper::getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel)
+    {
+        return m_CommandList->getTextureSubresourceState(texture, arraySlice, mipLevel);
+    }
+
+    ResourceStates CommandListWrapper::getBufferState(IBuffer* buffer)
+    {
+        return m_CommandList->getBufferState(buffer);
+    }
+
+    IDevice* CommandListWrapper::getDevice()
+    {
+        return m_Device;
+    }
+
+    const CommandListParameters& CommandListWrapper::getDesc()
+    {
+        return m_CommandList->getDesc();
+    }
+
+    CommandListStats CommandListWrapper::getStats()
+    {
+        return m_CommandList->getStats();
+    }
+
+} // namespace nvrhi::capture
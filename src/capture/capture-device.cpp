@@ -0,0 +1,628 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-serialize.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::capture
+{
+    DeviceHandle createCaptureLayer(IDevice* underlyingDevice, const CaptureLayerDesc& desc)
+    {
+        DeviceHandle wrapper = DeviceHandle::Create(new DeviceWrapper(underlyingDevice));
+
+        if (!checked_cast<DeviceWrapper*>(wrapper.Get())->openTraceFile(desc.traceFileName))
+            return nullptr;
+
+        return wrapper;
+    }
+
+    DeviceWrapper::DeviceWrapper(IDevice* device)
+        : m_Device(device)
+        , m_MessageCallback(device->getMessageCallback())
+    { }
+
+    bool DeviceWrapper::openTraceFile(const char* fileName)
+    {
+        if (!fileName)
+        {
+            m_MessageCallback->message(MessageSeverity::Error, "createCaptureLayer: traceFileName is NULL");
+            return false;
+        }
+
+        m_TraceFile.open(fileName, std::ios::binary | std::ios::trunc);
+        if (!m_TraceFile.is_open())
+        {
+            m_MessageCallback->message(MessageSeverity::Error, (std::string("createCaptureLayer: cannot create the trace file ") + fileName).c_str());
+            return false;
+        }
+
+        TraceHeader header;
+        header.graphicsAPI = m_Device->getGraphicsAPI();
+        m_TraceFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        return true;
+    }
+
+    void DeviceWrapper::warning(const std::string& messageText) const
+    {
+        m_MessageCallback->message(MessageSeverity::Warning, messageText.c_str());
+    }
+
+    void DeviceWrapper::writeCommandListRecording(uint32_t commandListId, const TraceWriter& events)
+    {
+        writeEvent(EventType::CommandListRecording, [&](TraceWriter& w)
+        {
+            w.pod(commandListId);
+            w.events(events);
+        });
+    }
+
+    void DeviceWrapper::warnUnsupported(const char* function)
+    {
+        std::lock_guard lock(m_TraceMutex);
+
+        if (m_ReportedUnsupportedFunctions.insert(function).second)
+            warning(std::string("Capture layer: ") + function + " is not supported, the trace will not replay it");
+    }
+
+    void DeviceWrapper::writeUnsupported(const char* function)
+    {
+        warnUnsupported(function);
+        writeEvent(EventType::Unsupported, [&](TraceWriter& w) { w.string(function); });
+    }
+
+    Object DeviceWrapper::getNativeObject(ObjectType objectType)
+    {
+        return m_Device->getNativeObject(objectType);
+    }
+
+    // Heaps are not recorded: the replay creates the virtual resources as regular committed resources,
+    // so the memory binding calls don't need to be replayed either.
+    HeapHandle DeviceWrapper::createHeap(const HeapDesc& d)
+    {
+        return m_Device->createHeap(d);
+    }
+
+    TextureHandle DeviceWrapper::createTexture(const TextureDesc& d)
+    {
+        TextureHandle texture = m_Device->createTexture(d);
+        writeCreation(EventType::CreateTexture, texture, [&](TraceWriter& w) { write(w, d); });
+        return texture;
+    }
+
+    MemoryRequirements DeviceWrapper::getTextureMemoryRequirements(ITexture* texture)
+    {
+        return m_Device->getTextureMemoryRequirements(texture);
+    }
+
+    bool DeviceWrapper::bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindTextureMemory(texture, heap, offset);
+    }
+
+    TextureHandle DeviceWrapper::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
+    {
+        TextureHandle handle = m_Device->createHandleForNativeTexture(objectType, texture, desc);
+        writeCreation(EventType::CreateTexture, handle, [&](TraceWriter& w) { write(w, desc); });
+        return handle;
+    }
+
+    StagingTextureHandle DeviceWrapper::createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
+    {
+        writeUnsupported("createStagingTexture");
+        return m_Device->createStagingTexture(d, cpuAccess);
+    }
+
+    void *DeviceWrapper::mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    {
+        return m_Device->mapStagingTexture(tex, slice, cpuAccess, outRowPitch);
+    }
+
+    void DeviceWrapper::unmapStagingTexture(IStagingTexture* tex)
+    {
+        m_Device->unmapStagingTexture(tex);
+    }
+
+    void DeviceWrapper::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        m_Device->getTextureTiling(texture, numTiles, desc, tileShape, subresourceTilingsNum, subresourceTilings);
+    }
+
+    void DeviceWrapper::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        writeUnsupported("updateTextureTileMappings");
+        m_Device->updateTextureTileMappings(texture, tileMappings, numTileMappings, executionQueue);
+    }
+
+    SamplerFeedbackTextureHandle DeviceWrapper::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+        writeUnsupported("createSamplerFeedbackTexture");
+        return m_Device->createSamplerFeedbackTexture(pairedTexture, desc);
+    }
+
+    SamplerFeedbackTextureHandle DeviceWrapper::createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture)
+    {
+        writeUnsupported("createSamplerFeedbackForNativeTexture");
+        return m_Device->createSamplerFeedbackForNativeTexture(objectType, texture, pairedTexture);
+    }
+
+    BufferHandle DeviceWrapper::createBuffer(const BufferDesc& d)
+    {
+        BufferHandle buffer = m_Device->createBuffer(d);
+        writeCreation(EventType::CreateBuffer, buffer, [&](TraceWriter& w) { write(w, d); });
+        return buffer;
+    }
+
+    void *DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags)
+    {
+        void* mappedData = m_Device->mapBuffer(b, mapFlags);
+
+        // The contents of the buffers mapped for writing are recorded when they are unmapped
+        if (mappedData && mapFlags == CpuAccessMode::Write)
+        {
+            std::lock_guard lock(m_TraceMutex);
+            m_MappedBuffers[b] = mappedData;
+        }
+
+        return mappedData;
+    }
+
+    void DeviceWrapper::unmapBuffer(IBuffer* b)
+    {
+        void* mappedData = nullptr;
+        {
+            std::lock_guard lock(m_TraceMutex);
+            auto it = m_MappedBuffers.find(b);
+            if (it != m_MappedBuffers.end())
+            {
+                mappedData = it->second;
+                m_MappedBuffers.erase(it);
+            }
+        }
+
+        if (mappedData)
+        {
+            writeEvent(EventType::WriteMappedBuffer, [&](TraceWriter& w)
+            {
+                w.object(b);
+                w.blob(mappedData, size_t(b->getDesc().byteSize));
+            });
+        }
+
+        m_Device->unmapBuffer(b);
+    }
+
+    MemoryRequirements DeviceWrapper::getBufferMemoryRequirements(IBuffer* buffer)
+    {
+        return m_Device->getBufferMemoryRequirements(buffer);
+    }
+
+    bool DeviceWrapper::bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindBufferMemory(buffer, heap, offset);
+    }
+
+    BufferHandle DeviceWrapper::createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc)
+    {
+        BufferHandle handle = m_Device->createHandleForNativeBuffer(objectType, buffer, desc);
+        writeCreation(EventType::CreateBuffer, handle, [&](TraceWriter& w) { write(w, desc); });
+        return handle;
+    }
+
+    ShaderHandle DeviceWrapper::createShader(const ShaderDesc& d, const void* binary, size_t binarySize)
+    {
+        ShaderHandle shader = m_Device->createShader(d, binary, binarySize);
+        writeCreation(EventType::CreateShader, shader, [&](TraceWriter& w)
+        {
+            write(w, d);
+            w.blob(binary, binarySize);
+        });
+        return shader;
+    }
+
+    ShaderHandle DeviceWrapper::createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        writeUnsupported("createShaderSpecialization");
+        return m_Device->createShaderSpecialization(baseShader, constants, numConstants);
+    }
+
+    ShaderLibraryHandle DeviceWrapper::createShaderLibrary(const void* binary, size_t binarySize)
+    {
+        writeUnsupported("createShaderLibrary");
+        return m_Device->createShaderLibrary(binary, binarySize);
+    }
+
+    SamplerHandle DeviceWrapper::createSampler(const SamplerDesc& d)
+    {
+        SamplerHandle sampler = m_Device->createSampler(d);
+        writeCreation(EventType::CreateSampler, sampler, [&](TraceWriter& w) { w.pod(d); });
+        return sampler;
+    }
+
+    InputLayoutHandle DeviceWrapper::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader)
+    {
+        InputLayoutHandle inputLayout = m_Device->createInputLayout(d, attributeCount, vertexShader);
+        writeCreation(EventType::CreateInputLayout, inputLayout, [&](TraceWriter& w)
+        {
+            w.pod(attributeCount);
+            for (uint32_t index = 0; index < attributeCount; index++)
+                write(w, d[index]);
+            w.object(vertexShader);
+        });
+        return inputLayout;
+    }
+
+    EventQueryHandle DeviceWrapper::createEventQuery()
+    {
+        return m_Device->createEventQuery();
+    }
+
+    void DeviceWrapper::setEventQuery(IEventQuery* query, CommandQueue queue)
+    {
+        m_Device->setEventQuery(query, queue);
+    }
+
+    bool DeviceWrapper::pollEventQuery(IEventQuery* query)
+    {
+        return m_Device->pollEventQuery(query);
+    }
+
+    void DeviceWrapper::waitEventQuery(IEventQuery* query)
+    {
+        m_Device->waitEventQuery(query);
+    }
+
+    void DeviceWrapper::resetEventQuery(IEventQuery* query)
+    {
+        m_Device->resetEventQuery(query);
+    }
+
+    SubmissionTicket DeviceWrapper::getSubmissionTicket(CommandQueue queue)
+    {
+        return m_Device->getSubmissionTicket(queue);
+    }
+
+    bool DeviceWrapper::pollSubmission(const SubmissionTicket& ticket)
+    {
+        return m_Device->pollSubmission(ticket);
+    }
+
+    bool DeviceWrapper::waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        return m_Device->waitForAll(tickets, numTickets, timeoutNanoseconds);
+    }
+
+    bool DeviceWrapper::waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        return m_Device->waitForAny(tickets, numTickets, timeoutNanoseconds);
+    }
+
+    TimerQueryHandle DeviceWrapper::createTimerQuery()
+    {
+        return m_Device->createTimerQuery();
+    }
+
+    bool DeviceWrapper::pollTimerQuery(ITimerQuery* query)
+    {
+        return m_Device->pollTimerQuery(query);
+    }
+
+    float DeviceWrapper::getTimerQueryTime(ITimerQuery* query)
+    {
+        return m_Device->getTimerQueryTime(query);
+    }
+
+    void DeviceWrapper::resetTimerQuery(ITimerQuery* query)
+    {
+        m_Device->resetTimerQuery(query);
+    }
+
+    GraphicsAPI DeviceWrapper::getGraphicsAPI()
+    {
+        return m_Device->getGraphicsAPI();
+    }
+
+    FramebufferHandle DeviceWrapper::createFramebuffer(const FramebufferDesc& desc)
+    {
+        FramebufferHandle framebuffer = m_Device->createFramebuffer(desc);
+        writeCreation(EventType::CreateFramebuffer, framebuffer, [&](TraceWriter& w) { write(w, desc); });
+        return framebuffer;
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        GraphicsPipelineHandle pipeline = m_Device->createGraphicsPipeline(desc, fbinfo);
+        writeCreation(EventType::CreateGraphicsPipeline, pipeline, [&](TraceWriter& w)
+        {
+            write(w, desc);
+            write(w, fbinfo);
+        });
+        return pipeline;
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+            return nullptr;
+
+        return createGraphicsPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    ComputePipelineHandle DeviceWrapper::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        ComputePipelineHandle pipeline = m_Device->createComputePipeline(desc);
+        writeCreation(EventType::CreateComputePipeline, pipeline, [&](TraceWriter& w) { write(w, desc); });
+        return pipeline;
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        writeUnsupported("createMeshletPipeline");
+        return m_Device->createMeshletPipeline(desc, fbinfo);
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+            return nullptr;
+
+        return createMeshletPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    WorkGraphPipelineHandle DeviceWrapper::createWorkGraphPipeline(const WorkGraphPipelineDesc& desc)
+    {
+        writeUnsupported("createWorkGraphPipeline");
+        return m_Device->createWorkGraphPipeline(desc);
+    }
+
+    rt::PipelineHandle DeviceWrapper::createRayTracingPipeline(const rt::PipelineDesc& desc)
+    {
+        writeUnsupported("createRayTracingPipeline");
+        return m_Device->createRayTracingPipeline(desc);
+    }
+
+    CommandSignatureHandle DeviceWrapper::createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline)
+    {
+        writeUnsupported("createCommandSignature");
+        return m_Device->createCommandSignature(desc, pipeline);
+    }
+
+    BindingLayoutHandle DeviceWrapper::createBindingLayout(const BindingLayoutDesc& desc)
+    {
+        BindingLayoutHandle layout = m_Device->createBindingLayout(desc);
+        writeCreation(EventType::CreateBindingLayout, layout, [&](TraceWriter& w) { write(w, desc); });
+        return layout;
+    }
+
+    BindingLayoutHandle DeviceWrapper::createBindlessLayout(const BindlessLayoutDesc& desc)
+    {
+        writeUnsupported("createBindlessLayout");
+        return m_Device->createBindlessLayout(desc);
+    }
+
+    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSetHandle bindingSet = m_Device->createBindingSet(desc, layout);
+        writeCreation(EventType::CreateBindingSet, bindingSet, [&](TraceWriter& w)
+        {
+            write(w, desc);
+            w.object(layout);
+        });
+        return bindingSet;
+    }
+
+    DescriptorTableHandle DeviceWrapper::createDescriptorTable(IBindingLayout* layout)
+    {
+        writeUnsupported("createDescriptorTable");
+        return m_Device->createDescriptorTable(layout);
+    }
+
+    void DeviceWrapper::resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents)
+    {
+        m_Device->resizeDescriptorTable(descriptorTable, newSize, keepContents);
+    }
+
+    bool DeviceWrapper::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item)
+    {
+        return m_Device->writeDescriptorTable(descriptorTable, item);
+    }
+
+    rt::OpacityMicromapHandle DeviceWrapper::createOpacityMicromap(const rt::OpacityMicromapDesc& desc)
+    {
+        writeUnsupported("createOpacityMicromap");
+        return m_Device->createOpacityMicromap(desc);
+    }
+
+    rt::AccelStructHandle DeviceWrapper::createAccelStruct(const rt::AccelStructDesc& desc)
+    {
+        writeUnsupported("createAccelStruct");
+        return m_Device->createAccelStruct(desc);
+    }
+
+    MemoryRequirements DeviceWrapper::getAccelStructMemoryRequirements(rt::IAccelStruct* as)
+    {
+        return m_Device->getAccelStructMemoryRequirements(as);
+    }
+
+    rt::cluster::OperationSizeInfo DeviceWrapper::getClusterOperationSizeInfo(const rt::cluster::OperationParams& params)
+    {
+        return m_Device->getClusterOperationSizeInfo(params);
+    }
+
+    bool DeviceWrapper::bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindAccelStructMemory(as, heap, offset);
+    }
+
+    CommandListHandle DeviceWrapper::createCommandList(const CommandListParameters& params)
+    {
+        CommandListHandle commandList = m_Device->createCommandList(params);
+        if (!commandList)
+            return nullptr;
+
+        CommandListWrapper* wrapper = new CommandListWrapper(this, commandList);
+        CommandListHandle handle = CommandListHandle::Create(wrapper);
+
+        writeCreation(EventType::CreateCommandList, wrapper, [&](TraceWriter& w) { write(w, params); });
+        wrapper->m_Id = m_Registry.find(wrapper);
+
+        return handle;
+    }
+
+    uint64_t DeviceWrapper::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        std::vector<ICommandList*> unwrappedCommandLists;
+        unwrappedCommandLists.resize(numCommandLists);
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(pCommandLists[i]);
+            unwrappedCommandLists[i] = wrapper ? wrapper->m_CommandList.Get() : pCommandLists[i];
+        }
+
+        writeEvent(EventType::ExecuteCommandLists, [&](TraceWriter& w)
+        {
+            w.pod(executionQueue);
+            w.pod(uint32_t(numCommandLists));
+            for (size_t i = 0; i < numCommandLists; i++)
+                w.object(pCommandLists[i]);
+        });
+
+        return m_Device->executeCommandLists(unwrappedCommandLists.data(), unwrappedCommandLists.size(), executionQueue);
+    }
+
+    void DeviceWrapper::queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance)
+    {
+        writeUnsupported("queueWaitForCommandList");
+        m_Device->queueWaitForCommandList(waitQueue, executionQueue, instance);
+    }
+
+    // Replay submits every command list right away, so the flushes are not recorded
+    void DeviceWrapper::flushSubmissions()
+    {
+        m_Device->flushSubmissions();
+    }
+
+    bool DeviceWrapper::waitForIdle()
+    {
+        writeEvent(EventType::WaitForIdle, [](TraceWriter&) { });
+        return m_Device->waitForIdle();
+    }
+
+    void DeviceWrapper::writeFrameBoundary()
+    {
+        writeEvent(EventType::FrameBoundary, [](TraceWriter&) { });
+
+        std::lock_guard lock(m_TraceMutex);
+        m_TraceFile.flush();
+    }
+
+    void DeviceWrapper::runGarbageCollection()
+    {
+        writeFrameBoundary();
+        m_Device->runGarbageCollection();
+    }
+
+    void DeviceWrapper::runGarbageCollection(uint32_t maxReleaseMicroseconds)
+    {
+        writeFrameBoundary();
+        m_Device->runGarbageCollection(maxReleaseMicroseconds);
+    }
+
+    void DeviceWrapper::evictCachedFramebuffers(ITexture* texture)
+    {
+        // Only affects the lifetime of the cached framebuffers, not the recorded work
+        m_Device->evictCachedFramebuffers(texture);
+    }
+
+    bool DeviceWrapper::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
+    {
+        return m_Device->queryFeatureSupport(feature, pInfo, infoSize);
+    }
+
+    FormatSupport DeviceWrapper::queryFormatSupport(Format format)
+    {
+        return m_Device->queryFormatSupport(format);
+    }
+
+    MemoryAllocatorStats DeviceWrapper::getMemoryAllocatorStats()
+    {
+        return m_Device->getMemoryAllocatorStats();
+    }
+
+    MemoryBudget DeviceWrapper::getMemoryBudget()
+    {
+        return m_Device->getMemoryBudget();
+    }
+
+    AccelStructStats DeviceWrapper::getAccelStructStats()
+    {
+        return m_Device->getAccelStructStats();
+    }
+
+    DeviceStats DeviceWrapper::getDeviceStats()
+    {
+        return m_Device->getDeviceStats();
+    }
+
+    bool DeviceWrapper::getProfilerFrameResults(ProfilerFrameResults& outResults)
+    {
+        return m_Device->getProfilerFrameResults(outResults);
+    }
+
+    bool DeviceWrapper::getPipelineCacheData(std::vector<uint8_t>& data)
+    {
+        return m_Device->getPipelineCacheData(data);
+    }
+
+    coopvec::DeviceFeatures DeviceWrapper::queryCoopVecFeatures()
+    {
+        return m_Device->queryCoopVecFeatures();
+    }
+
+    size_t DeviceWrapper::getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns)
+    {
+        return m_Device->getCoopVecMatrixSize(type, layout, rows, columns);
+    }
+
+    Object DeviceWrapper::getNativeQueue(ObjectType objectType, CommandQueue queue)
+    {
+        return m_Device->getNativeQueue(objectType, queue);
+    }
+
+    IMessageCallback* DeviceWrapper::getMessageCallback()
+    {
+        return m_MessageCallback;
+    }
+
+    bool DeviceWrapper::isAftermathEnabled()
+    {
+        return m_Device->isAftermathEnabled();
+    }
+
+    AftermathCrashDumpHelper& DeviceWrapper::getAftermathCrashDumpHelper()
+    {
+        return m_Device->getAftermathCrashDumpHelper();
+    }
+
+} // namespace nvrhi::capture
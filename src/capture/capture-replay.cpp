@@ -0,0 +1,724 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "capture-serialize.h"
+
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace nvrhi::capture
+{
+    namespace
+    {
+        class TraceReplayer
+        {
+        public:
+            TraceReplayer(IDevice* device, ReplayResults& results)
+                : m_Device(device)
+                , m_Results(results)
+            { }
+
+            bool replay(const uint8_t* events, size_t size);
+
+        private:
+            IDevice* m_Device;
+            ReplayResults& m_Results;
+
+            // Objects indexed by their trace IDs
+            std::vector<RefCountPtr<IResource>> m_Objects;
+
+            std::vector<TimerQueryHandle> m_TimerQueries;
+            size_t m_NumUsedTimerQueries = 0;
+
+            ReplayFrameStats m_Frame;
+            std::chrono::steady_clock::time_point m_FrameStartTime;
+
+            template<typename T> void setObject(uint32_t id, T* object)
+            {
+                if (id == 0)
+                    return;
+
+                if (id >= m_Objects.size())
+                    m_Objects.resize(id + 1);
+
+                m_Objects[id] = object;
+            }
+
+            template<typename T> T* findObject(TraceReader& payload)
+            {
+                T* object = nullptr;
+                payload.object(object);
+                return object;
+            }
+
+            bool replayDeviceEvent(EventType type, TraceReader& payload);
+            bool replayCommandListEvent(ICommandList* commandList, ITimerQuery*& timerQuery, EventType type, TraceReader& payload);
+            bool replayRecording(TraceReader& payload);
+            void endFrame();
+
+            ITimerQuery* acquireTimerQuery();
+        };
+
+        ITimerQuery* TraceReplayer::acquireTimerQuery()
+        {
+            if (m_NumUsedTimerQueries == m_TimerQueries.size())
+                m_TimerQueries.push_back(m_Device->createTimerQuery());
+
+            return m_TimerQueries[m_NumUsedTimerQueries++];
+        }
+
+        void TraceReplayer::endFrame()
+        {
+            const auto now = std::chrono::steady_clock::now();
+            m_Frame.cpuTimeMs = std::chrono::duration<double, std::milli>(now - m_FrameStartTime).count();
+
+            m_Device->waitForIdle();
+
+            for (size_t index = 0; index < m_NumUsedTimerQueries; index++)
+            {
+                ITimerQuery* query = m_TimerQueries[index];
+                if (query && m_Device->pollTimerQuery(query))
+                    m_Frame.gpuTimeMs += double(m_Device->getTimerQueryTime(query)) * 1000.0;
+
+                if (query)
+                    m_Device->resetTimerQuery(query);
+            }
+            m_NumUsedTimerQueries = 0;
+
+            m_Device->runGarbageCollection();
+
+            m_Results.frames.push_back(m_Frame);
+            m_Frame = ReplayFrameStats();
+            m_FrameStartTime = std::chrono::steady_clock::now();
+        }
+
+        bool TraceReplayer::replay(const uint8_t* events, size_t size)
+        {
+            TraceReader trace(events, size, m_Objects);
+            m_FrameStartTime = std::chrono::steady_clock::now();
+
+            EventType type;
+            TraceReader payload(nullptr, 0, m_Objects);
+            while (trace.nextEvent(type, payload))
+            {
+                if (!replayDeviceEvent(type, payload) || payload.failed())
+                {
+                    m_Results.error = "The trace contains a malformed event";
+                    return false;
+                }
+
+                m_Results.numMissingObjects += payload.getNumMissingObjects();
+            }
+
+            if (trace.failed())
+            {
+                m_Results.error = "The trace file is truncated";
+                return false;
+            }
+
+            // Traces that were closed in the middle of a frame end with a partial frame
+            if (m_Frame.numCommandLists != 0)
+                endFrame();
+
+            m_Device->waitForIdle();
+            return true;
+        }
+
+        bool TraceReplayer::replayDeviceEvent(EventType type, TraceReader& payload)
+        {
+            switch (type)
+            {
+            case EventType::ReleaseObject: {
+                const uint32_t id = payload.read<uint32_t>();
+                if (id < m_Objects.size())
+                    m_Objects[id] = nullptr;
+                break;
+            }
+
+            case EventType::CreateTexture: {
+                const uint32_t id = payload.read<uint32_t>();
+                TextureDesc desc;
+                serialize(payload, desc);
+                // Virtual resources are replayed as regular resources, heaps are not captured
+                desc.isVirtual = false;
+                setObject(id, m_Device->createTexture(desc).Get());
+                break;
+            }
+
+            case EventType::CreateBuffer: {
+                const uint32_t id = payload.read<uint32_t>();
+                BufferDesc desc;
+                serialize(payload, desc);
+                desc.isVirtual = false;
+                setObject(id, m_Device->createBuffer(desc).Get());
+                break;
+            }
+
+            case EventType::CreateShader: {
+                const uint32_t id = payload.read<uint32_t>();
+                ShaderDesc desc;
+                serialize(payload, desc);
+                size_t binarySize = 0;
+                const uint8_t* binary = payload.blob(binarySize);
+                setObject(id, m_Device->createShader(desc, binary, binarySize).Get());
+                break;
+            }
+
+            case EventType::CreateSampler: {
+                const uint32_t id = payload.read<uint32_t>();
+                const SamplerDesc desc = payload.read<SamplerDesc>();
+                setObject(id, m_Device->createSampler(desc).Get());
+                break;
+            }
+
+            case EventType::CreateInputLayout: {
+                const uint32_t id = payload.read<uint32_t>();
+                std::vector<VertexAttributeDesc> attributes;
+                payload.vector(attributes, [&payload](VertexAttributeDesc& attribute) { serialize(payload, attribute); });
+                IShader* vertexShader = findObject<IShader>(payload);
+                setObject(id, m_Device->createInputLayout(attributes.data(), uint32_t(attributes.size()), vertexShader).Get());
+                break;
+            }
+
+            case EventType::CreateFramebuffer: {
+                const uint32_t id = payload.read<uint32_t>();
+                FramebufferDesc desc;
+                serialize(payload, desc);
+                setObject(id, m_Device->createFramebuffer(desc).Get());
+                break;
+            }
+
+            case EventType::CreateGraphicsPipeline: {
+                const uint32_t id = payload.read<uint32_t>();
+                GraphicsPipelineDesc desc;
+                serialize(payload, desc);
+                FramebufferInfo framebufferInfo;
+                serialize(payload, framebufferInfo);
+                setObject(id, m_Device->createGraphicsPipeline(desc, framebufferInfo).Get());
+                break;
+            }
+
+            case EventType::CreateComputePipeline: {
+                const uint32_t id = payload.read<uint32_t>();
+                ComputePipelineDesc desc;
+                serialize(payload, desc);
+                setObject(id, m_Device->createComputePipeline(desc).Get());
+                break;
+            }
+
+            case EventType::CreateBindingLayout: {
+                const uint32_t id = payload.read<uint32_t>();
+                BindingLayoutDesc desc;
+                serialize(payload, desc);
+                setObject(id, m_Device->createBindingLayout(desc).Get());
+                break;
+            }
+
+            case EventType::CreateBindingSet: {
+                const uint32_t id = payload.read<uint32_t>();
+                BindingSetDesc desc;
+                serialize(payload, desc);
+                IBindingLayout* layout = findObject<IBindingLayout>(payload);
+                setObject(id, m_Device->createBindingSet(desc, layout).Get());
+                break;
+            }
+
+            case EventType::CreateCommandList: {
+                const uint32_t id = payload.read<uint32_t>();
+                CommandListParameters params;
+                serialize(payload, params);
+                setObject(id, m_Device->createCommandList(params).Get());
+                break;
+            }
+
+            case EventType::WriteMappedBuffer: {
+                IBuffer* buffer = findObject<IBuffer>(payload);
+                size_t dataSize = 0;
+                const uint8_t* data = payload.blob(dataSize);
+                if (!buffer)
+                    break;
+
+                void* mappedData = m_Device->mapBuffer(buffer, CpuAccessMode::Write);
+                if (mappedData)
+                {
+                    memcpy(mappedData, data, std::min(dataSize, size_t(buffer->getDesc().byteSize)));
+                    m_Device->unmapBuffer(buffer);
+                }
+                break;
+            }
+
+            case EventType::CommandListRecording:
+                return replayRecording(payload);
+
+            case EventType::ExecuteCommandLists: {
+                const CommandQueue queue = payload.read<CommandQueue>();
+                std::vector<ICommandList*> commandLists;
+                payload.vector(commandLists, [&payload](ICommandList*& commandList) { payload.object(commandList); });
+
+                // Skip the command lists that could not be created, they are counted as missing objects
+                commandLists.erase(std::remove(commandLists.begin(), commandLists.end(), nullptr), commandLists.end());
+                if (!commandLists.empty())
+                    m_Device->executeCommandLists(commandLists.data(), commandLists.size(), queue);
+                m_Frame.numCommandLists += uint32_t(commandLists.size());
+                break;
+            }
+
+            case EventType::WaitForIdle:
+                m_Device->waitForIdle();
+                break;
+
+            case EventType::FrameBoundary:
+                endFrame();
+                break;
+
+            case EventType::Unsupported:
+                ++m_Results.numUnsupportedEvents;
+                break;
+
+            default:
+                // Events from newer versions of the capture layer are skipped
+                break;
+            }
+
+            return true;
+        }
+
+        bool TraceReplayer::replayRecording(TraceReader& payload)
+        {
+            ICommandList* commandList = findObject<ICommandList>(payload);
+            ITimerQuery* timerQuery = nullptr;
+
+            EventType type;
+            TraceReader event(nullptr, 0, m_Objects);
+            while (payload.nextEvent(type, event))
+            {
+                if (!commandList)
+                {
+                    if (type == EventType::Unsupported)
+                        ++m_Results.numUnsupportedEvents;
+                    continue;
+                }
+
+                if (!replayCommandListEvent(commandList, timerQuery, type, event) || event.failed())
+                    return false;
+
+                m_Results.numMissingObjects += event.getNumMissingObjects();
+            }
+
+            return !payload.failed();
+        }
+
+        bool TraceReplayer::replayCommandListEvent(ICommandList* commandList, ITimerQuery*& timerQuery, EventType type, TraceReader& payload)
+        {
+            switch (type)
+            {
+            case EventType::ReleaseObject: {
+                const uint32_t id = payload.read<uint32_t>();
+                if (id < m_Objects.size())
+                    m_Objects[id] = nullptr;
+                break;
+            }
+
+            case EventType::Open:
+                commandList->open();
+
+                // Reusable command lists can be executed several times, a single query cannot measure that
+                if (!commandList->getDesc().isReusable && !commandList->getDesc().isSecondary)
+                {
+                    timerQuery = acquireTimerQuery();
+                    if (timerQuery)
+                        commandList->beginTimerQuery(timerQuery);
+                }
+                break;
+
+            case EventType::Close:
+                if (timerQuery)
+                    commandList->endTimerQuery(timerQuery);
+                timerQuery = nullptr;
+                commandList->close();
+                break;
+
+            case EventType::ClearState:
+                commandList->clearState();
+                break;
+
+            case EventType::ClearTextureFloat: {
+                ITexture* texture = findObject<ITexture>(payload);
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const Color clearColor = payload.read<Color>();
+                if (texture)
+                    commandList->clearTextureFloat(texture, subresources, clearColor);
+                break;
+            }
+
+            case EventType::ClearDepthStencilTexture: {
+                ITexture* texture = findObject<ITexture>(payload);
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const bool clearDepth = payload.read<bool>();
+                const float depth = payload.read<float>();
+                const bool clearStencil = payload.read<bool>();
+                const uint8_t stencil = payload.read<uint8_t>();
+                if (texture)
+                    commandList->clearDepthStencilTexture(texture, subresources, clearDepth, depth, clearStencil, stencil);
+                break;
+            }
+
+            case EventType::ClearTextureUInt: {
+                ITexture* texture = findObject<ITexture>(payload);
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const uint32_t clearColor = payload.read<uint32_t>();
+                if (texture)
+                    commandList->clearTextureUInt(texture, subresources, clearColor);
+                break;
+            }
+
+            case EventType::CopyTexture: {
+                ITexture* dest = findObject<ITexture>(payload);
+                const TextureSlice destSlice = payload.read<TextureSlice>();
+                ITexture* src = findObject<ITexture>(payload);
+                const TextureSlice srcSlice = payload.read<TextureSlice>();
+                if (dest && src)
+                    commandList->copyTexture(dest, destSlice, src, srcSlice);
+                break;
+            }
+
+            case EventType::WriteTexture: {
+                ITexture* dest = findObject<ITexture>(payload);
+                const uint32_t arraySlice = payload.read<uint32_t>();
+                const uint32_t mipLevel = payload.read<uint32_t>();
+                const size_t rowPitch = size_t(payload.read<uint64_t>());
+                const size_t depthPitch = size_t(payload.read<uint64_t>());
+                size_t dataSize = 0;
+                const uint8_t* data = payload.blob(dataSize);
+                if (dest && data && dataSize >= getTextureWriteSize(dest->getDesc(), mipLevel, rowPitch, depthPitch))
+                    commandList->writeTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+                break;
+            }
+
+            case EventType::ResolveTexture: {
+                ITexture* dest = findObject<ITexture>(payload);
+                const auto dstSubresources = payload.read<TextureSubresourceSet>();
+                ITexture* src = findObject<ITexture>(payload);
+                const auto srcSubresources = payload.read<TextureSubresourceSet>();
+                if (dest && src)
+                    commandList->resolveTexture(dest, dstSubresources, src, srcSubresources);
+                break;
+            }
+
+            case EventType::WriteBuffer: {
+                IBuffer* buffer = findObject<IBuffer>(payload);
+                const uint64_t destOffsetBytes = payload.read<uint64_t>();
+                size_t dataSize = 0;
+                const uint8_t* data = payload.blob(dataSize);
+                if (buffer && data)
+                    commandList->writeBuffer(buffer, data, dataSize, destOffsetBytes);
+                break;
+            }
+
+            case EventType::ClearBufferUInt: {
+                IBuffer* buffer = findObject<IBuffer>(payload);
+                const uint32_t clearValue = payload.read<uint32_t>();
+                if (buffer)
+                    commandList->clearBufferUInt(buffer, clearValue);
+                break;
+            }
+
+            case EventType::CopyBuffer: {
+                IBuffer* dest = findObject<IBuffer>(payload);
+                const uint64_t destOffsetBytes = payload.read<uint64_t>();
+                IBuffer* src = findObject<IBuffer>(payload);
+                const uint64_t srcOffsetBytes = payload.read<uint64_t>();
+                const uint64_t dataSizeBytes = payload.read<uint64_t>();
+                if (dest && src)
+                    commandList->copyBuffer(dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
+                break;
+            }
+
+            case EventType::CreateTransientBindingSet: {
+                const uint32_t id = payload.read<uint32_t>();
+                BindingSetDesc desc;
+                serialize(payload, desc);
+                IBindingLayout* layout = findObject<IBindingLayout>(payload);
+                setObject(id, commandList->createTransientBindingSet(desc, layout).Get());
+                break;
+            }
+
+            case EventType::SetPushConstants: {
+                size_t byteSize = 0;
+                const uint8_t* data = payload.blob(byteSize);
+                commandList->setPushConstants(data, byteSize);
+                break;
+            }
+
+            case EventType::SetGraphicsState: {
+                GraphicsState state;
+                serialize(payload, state);
+                commandList->setGraphicsState(state);
+                break;
+            }
+
+            case EventType::SetGraphicsBindingSet: {
+                const uint32_t slot = payload.read<uint32_t>();
+                IBindingSet* bindingSet = findObject<IBindingSet>(payload);
+                commandList->setGraphicsBindingSet(slot, bindingSet);
+                break;
+            }
+
+            case EventType::SetVertexBuffers: {
+                std::vector<VertexBufferBinding> bindings;
+                payload.vector(bindings, [&payload](VertexBufferBinding& binding)
+                {
+                    payload.object(binding.buffer);
+                    payload.pod(binding.slot);
+                    payload.pod(binding.offset);
+                });
+                commandList->setVertexBuffers(bindings.data(), bindings.size());
+                break;
+            }
+
+            case EventType::SetIndexBuffer: {
+                IndexBufferBinding binding;
+                payload.object(binding.buffer);
+                payload.pod(binding.format);
+                payload.pod(binding.offset);
+                commandList->setIndexBuffer(binding);
+                break;
+            }
+
+            case EventType::Draw:
+                commandList->draw(payload.read<DrawArguments>());
+                ++m_Frame.numDraws;
+                break;
+
+            case EventType::DrawIndexed:
+                commandList->drawIndexed(payload.read<DrawArguments>());
+                ++m_Frame.numDraws;
+                break;
+
+            case EventType::DrawBatch:
+            case EventType::DrawIndexedBatch: {
+                std::vector<DrawArguments> args;
+                payload.vector(args, [&payload](DrawArguments& arg) { payload.pod(arg); });
+                const size_t pushConstantByteSize = size_t(payload.read<uint64_t>());
+                const size_t pushConstantStride = size_t(payload.read<uint64_t>());
+                size_t pushConstantDataSize = 0;
+                const uint8_t* pushConstants = payload.blob(pushConstantDataSize);
+                if (pushConstantDataSize == 0)
+                    pushConstants = nullptr;
+
+                if (type == EventType::DrawBatch)
+                    commandList->drawBatch(args.data(), args.size(), pushConstants, pushConstantByteSize, pushConstantStride);
+                else
+                    commandList->drawIndexedBatch(args.data(), args.size(), pushConstants, pushConstantByteSize, pushConstantStride);
+                m_Frame.numDraws += uint32_t(args.size());
+                break;
+            }
+
+            case EventType::DrawIndirect:
+            case EventType::DrawIndexedIndirect: {
+                const uint32_t offsetBytes = payload.read<uint32_t>();
+                const uint32_t drawCount = payload.read<uint32_t>();
+                if (type == EventType::DrawIndirect)
+                    commandList->drawIndirect(offsetBytes, drawCount);
+                else
+                    commandList->drawIndexedIndirect(offsetBytes, drawCount);
+                m_Frame.numDraws += drawCount;
+                break;
+            }
+
+            case EventType::SetComputeState: {
+                ComputeState state;
+                serialize(payload, state);
+                commandList->setComputeState(state);
+                break;
+            }
+
+            case EventType::Dispatch: {
+                const uint32_t groupsX = payload.read<uint32_t>();
+                const uint32_t groupsY = payload.read<uint32_t>();
+                const uint32_t groupsZ = payload.read<uint32_t>();
+                commandList->dispatch(groupsX, groupsY, groupsZ);
+                ++m_Frame.numDispatches;
+                break;
+            }
+
+            case EventType::DispatchIndirect:
+                commandList->dispatchIndirect(payload.read<uint32_t>());
+                ++m_Frame.numDispatches;
+                break;
+
+            case EventType::BeginMarker: {
+                std::string name;
+                payload.string(name);
+                commandList->beginMarker(name.c_str());
+                break;
+            }
+
+            case EventType::EndMarker:
+                commandList->endMarker();
+                break;
+
+            case EventType::SetEnableAutomaticBarriers:
+                commandList->setEnableAutomaticBarriers(payload.read<bool>());
+                break;
+
+            case EventType::SetResourceStatesForBindingSet: {
+                IBindingSet* bindingSet = findObject<IBindingSet>(payload);
+                if (bindingSet)
+                    commandList->setResourceStatesForBindingSet(bindingSet);
+                break;
+            }
+
+            case EventType::SetEnableUavBarriersForTexture: {
+                ITexture* texture = findObject<ITexture>(payload);
+                const bool enableBarriers = payload.read<bool>();
+                if (texture)
+                    commandList->setEnableUavBarriersForTexture(texture, enableBarriers);
+                break;
+            }
+
+            case EventType::SetEnableUavBarriersForBuffer: {
+                IBuffer* buffer = findObject<IBuffer>(payload);
+                const bool enableBarriers = payload.read<bool>();
+                if (buffer)
+                    commandList->setEnableUavBarriersForBuffer(buffer, enableBarriers);
+                break;
+            }
+
+            case EventType::BeginTrackingTextureState:
+            case EventType::SetTextureState: {
+                ITexture* texture = findObject<ITexture>(payload);
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const auto stateBits = payload.read<ResourceStates>();
+                if (!texture)
+                    break;
+
+                if (type == EventType::BeginTrackingTextureState)
+                    commandList->beginTrackingTextureState(texture, subresources, stateBits);
+                else
+                    commandList->setTextureState(texture, subresources, stateBits);
+                break;
+            }
+
+            case EventType::BeginTrackingBufferState:
+            case EventType::SetBufferState:
+            case EventType::SetPermanentBufferState: {
+                IBuffer* buffer = findObject<IBuffer>(payload);
+                const auto stateBits = payload.read<ResourceStates>();
+                if (!buffer)
+                    break;
+
+                if (type == EventType::BeginTrackingBufferState)
+                    commandList->beginTrackingBufferState(buffer, stateBits);
+                else if (type == EventType::SetBufferState)
+                    commandList->setBufferState(buffer, stateBits);
+                else
+                    commandList->setPermanentBufferState(buffer, stateBits);
+                break;
+            }
+
+            case EventType::SetPermanentTextureState: {
+                ITexture* texture = findObject<ITexture>(payload);
+                const auto stateBits = payload.read<ResourceStates>();
+                if (texture)
+                    commandList->setPermanentTextureState(texture, stateBits);
+                break;
+            }
+
+            case EventType::CommitBarriers:
+                commandList->commitBarriers();
+                break;
+
+            case EventType::Unsupported:
+                ++m_Results.numUnsupportedEvents;
+                break;
+
+            default:
+                break;
+            }
+
+            return true;
+        }
+    }
+
+    bool replayTrace(IDevice* device, const char* traceFileName, ReplayResults& outResults)
+    {
+        outResults = ReplayResults();
+
+        std::ifstream file(traceFileName, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            outResults.error = std::string("Cannot open the trace file ") + traceFileName;
+            return false;
+        }
+
+        std::vector<uint8_t> data(size_t(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size()));
+        if (!file)
+        {
+            outResults.error = std::string("Cannot read the trace file ") + traceFileName;
+            return false;
+        }
+
+        TraceHeader header;
+        if (data.size() < sizeof(header))
+        {
+            outResults.error = "The trace file is too small";
+            return false;
+        }
+
+        memcpy(&header, data.data(), sizeof(header));
+        if (header.magic != c_TraceMagic)
+        {
+            outResults.error = "The file is not an NVRHI trace";
+            return false;
+        }
+
+        if (header.formatVersion != c_TraceFormatVersion)
+        {
+            outResults.error = "The trace format version " + std::to_string(header.formatVersion) + " is not supported, expected "
+                + std::to_string(c_TraceFormatVersion);
+            return false;
+        }
+
+        outResults.capturedGraphicsAPI = header.graphicsAPI;
+
+        // The shader binaries can only be used on the API that they were compiled for
+        const GraphicsAPI replayGraphicsAPI = device->getGraphicsAPI();
+        if (header.graphicsAPI != replayGraphicsAPI && header.graphicsAPI != GraphicsAPI::NULL_DEVICE
+            && replayGraphicsAPI != GraphicsAPI::NULL_DEVICE)
+        {
+            outResults.error = std::string("The trace was captured on ") + utils::GraphicsAPIToString(header.graphicsAPI)
+                + " and cannot be replayed on " + utils::GraphicsAPIToString(replayGraphicsAPI);
+            return false;
+        }
+
+        TraceReplayer replayer(device, outResults);
+        return replayer.replay(data.data() + sizeof(header), data.size() - sizeof(header));
+    }
+
+} // namespace nvrhi::capture
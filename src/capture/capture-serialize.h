@@ -0,0 +1,289 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "capture-backend.h"
+
+// Serialization of the NVRHI descriptors, shared by the capture layer and the replay.
+// Each function is instantiated with TraceWriter, which only reads the fields, and with TraceReader, which fills them.
+// Objects are stored as their trace IDs. Structures without pointers or strings are stored as raw bytes.
+
+namespace nvrhi::capture
+{
+    template<typename A> void serialize(A& ar, TextureDesc& d)
+    {
+        ar.pod(d.width);
+        ar.pod(d.height);
+        ar.pod(d.depth);
+        ar.pod(d.arraySize);
+        ar.pod(d.mipLevels);
+        ar.pod(d.sampleCount);
+        ar.pod(d.sampleQuality);
+        ar.pod(d.format);
+        ar.pod(d.dimension);
+        ar.string(d.debugName);
+        ar.pod(d.isShaderResource);
+        ar.pod(d.isRenderTarget);
+        ar.pod(d.isUAV);
+        ar.pod(d.isTypeless);
+        ar.pod(d.isShadingRateSurface);
+        ar.pod(d.sharedResourceFlags);
+        ar.pod(d.isVirtual);
+        ar.pod(d.isTiled);
+        ar.pod(d.allocationMode);
+        ar.pod(d.residencyPriority);
+        ar.pod(d.clearValue);
+        ar.pod(d.useClearValue);
+        ar.pod(d.initialState);
+        ar.pod(d.keepInitialState);
+    }
+
+    template<typename A> void serialize(A& ar, BufferDesc& d)
+    {
+        ar.pod(d.byteSize);
+        ar.pod(d.structStride);
+        ar.pod(d.maxVersions);
+        ar.string(d.debugName);
+        ar.pod(d.format);
+        ar.pod(d.canHaveUAVs);
+        ar.pod(d.canHaveTypedViews);
+        ar.pod(d.canHaveRawViews);
+        ar.pod(d.isVertexBuffer);
+        ar.pod(d.isIndexBuffer);
+        ar.pod(d.isConstantBuffer);
+        ar.pod(d.isDrawIndirectArgs);
+        ar.pod(d.isAccelStructBuildInput);
+        ar.pod(d.isAccelStructStorage);
+        ar.pod(d.isShaderBindingTable);
+        ar.pod(d.isVolatile);
+        ar.pod(d.isVirtual);
+        ar.pod(d.initialState);
+        ar.pod(d.keepInitialState);
+        ar.pod(d.cpuAccess);
+        ar.pod(d.preferDeviceLocal);
+        ar.pod(d.sharedResourceFlags);
+        ar.pod(d.allocationMode);
+        ar.pod(d.residencyPriority);
+    }
+
+    // Custom semantics and coordinate swizzling are not captured
+    template<typename A> void serialize(A& ar, ShaderDesc& d)
+    {
+        ar.pod(d.shaderType);
+        ar.string(d.debugName);
+        ar.string(d.entryName);
+        ar.pod(d.hlslExtensionsUAV);
+        ar.pod(d.useSpecificShaderExt);
+        ar.pod(d.fastGSFlags);
+    }
+
+    template<typename A> void serialize(A& ar, VertexAttributeDesc& d)
+    {
+        ar.string(d.name);
+        ar.pod(d.format);
+        ar.pod(d.arraySize);
+        ar.pod(d.bufferIndex);
+        ar.pod(d.offset);
+        ar.pod(d.elementStride);
+        ar.pod(d.isInstanced);
+    }
+
+    template<typename A> void serialize(A& ar, FramebufferAttachment& d)
+    {
+        ar.object(d.texture);
+        ar.pod(d.subresources);
+        ar.pod(d.format);
+        ar.pod(d.isReadOnly);
+        ar.pod(d.loadOp);
+        ar.pod(d.storeOp);
+        ar.pod(d.clearColor);
+        ar.pod(d.clearDepth);
+        ar.pod(d.clearStencil);
+    }
+
+    template<typename A> void serialize(A& ar, FramebufferDesc& d)
+    {
+        ar.vector(d.colorAttachments, [&ar](FramebufferAttachment& a) { serialize(ar, a); });
+        serialize(ar, d.depthAttachment);
+        serialize(ar, d.shadingRateAttachment);
+    }
+
+    template<typename A> void serialize(A& ar, FramebufferInfo& d)
+    {
+        ar.vector(d.colorFormats, [&ar](Format& f) { ar.pod(f); });
+        ar.pod(d.depthFormat);
+        ar.pod(d.sampleCount);
+        ar.pod(d.sampleQuality);
+    }
+
+    template<typename A> void serialize(A& ar, BindingLayoutVector& layouts)
+    {
+        ar.vector(layouts, [&ar](BindingLayoutHandle& layout) { ar.object(layout); });
+    }
+
+    template<typename A> void serialize(A& ar, GraphicsPipelineDesc& d)
+    {
+        ar.pod(d.primType);
+        ar.pod(d.patchControlPoints);
+        ar.object(d.inputLayout);
+        ar.object(d.VS);
+        ar.object(d.HS);
+        ar.object(d.DS);
+        ar.object(d.GS);
+        ar.object(d.PS);
+        ar.pod(d.renderState);
+        ar.pod(d.shadingRateState);
+        serialize(ar, d.bindingLayouts);
+        ar.pod(d.indirectVertexBuffers);
+    }
+
+    template<typename A> void serialize(A& ar, ComputePipelineDesc& d)
+    {
+        ar.object(d.CS);
+        serialize(ar, d.bindingLayouts);
+    }
+
+    // The bit fields of the items are transferred through temporaries
+    template<typename A> void serialize(A& ar, BindingLayoutItem& item)
+    {
+        ar.pod(item.slot);
+
+        ResourceType type = item.type;
+        uint16_t size = item.size;
+        ar.pod(type);
+        ar.pod(size);
+
+        if constexpr (A::IsReading)
+        {
+            item.type = type;
+            item.unused = 0;
+            item.size = size;
+        }
+    }
+
+    template<typename A> void serialize(A& ar, BindingLayoutDesc& d)
+    {
+        ar.pod(d.visibility);
+        ar.pod(d.registerSpace);
+        ar.pod(d.registerSpaceIsDescriptorSet);
+        ar.pod(d.usePushDescriptors);
+        ar.vector(d.bindings, [&ar](BindingLayoutItem& item) { serialize(ar, item); });
+        ar.pod(d.bindingOffsets);
+    }
+
+    template<typename A> void serialize(A& ar, BindingSetItem& item)
+    {
+        ar.object(item.resourceHandle);
+        ar.pod(item.slot);
+        ar.pod(item.arrayElement);
+
+        ResourceType type = item.type;
+        TextureDimension dimension = item.dimension;
+        Format format = item.format;
+        ar.pod(type);
+        ar.pod(dimension);
+        ar.pod(format);
+
+        if constexpr (A::IsReading)
+        {
+            item.type = type;
+            item.dimension = dimension;
+            item.format = format;
+            item.unused = 0;
+            item.unused2 = 0;
+        }
+
+        ar.pod(item.rawData[0]);
+        ar.pod(item.rawData[1]);
+    }
+
+    template<typename A> void serialize(A& ar, BindingSetDesc& d)
+    {
+        ar.vector(d.bindings, [&ar](BindingSetItem& item) { serialize(ar, item); });
+        ar.pod(d.trackLiveness);
+    }
+
+    template<typename A> void serialize(A& ar, BindingSetVector& bindings)
+    {
+        ar.vector(bindings, [&ar](IBindingSet*& bindingSet) { ar.object(bindingSet); });
+    }
+
+    template<typename A> void serialize(A& ar, GraphicsState& s)
+    {
+        ar.object(s.pipeline);
+        ar.object(s.framebuffer);
+        ar.vector(s.viewport.viewports, [&ar](Viewport& v) { ar.pod(v); });
+        ar.vector(s.viewport.scissorRects, [&ar](Rect& r) { ar.pod(r); });
+        ar.pod(s.shadingRateState);
+        ar.pod(s.blendConstantColor);
+        ar.pod(s.dynamicStencilRefValue);
+        serialize(ar, s.bindings);
+        ar.vector(s.vertexBuffers, [&ar](VertexBufferBinding& vb)
+        {
+            ar.object(vb.buffer);
+            ar.pod(vb.slot);
+            ar.pod(vb.offset);
+        });
+        ar.object(s.indexBuffer.buffer);
+        ar.pod(s.indexBuffer.format);
+        ar.pod(s.indexBuffer.offset);
+        ar.object(s.indirectParams);
+    }
+
+    template<typename A> void serialize(A& ar, ComputeState& s)
+    {
+        ar.object(s.pipeline);
+        serialize(ar, s.bindings);
+        ar.object(s.indirectParams);
+    }
+
+    // The sizes are stored as 64-bit values to keep the traces portable between 32- and 64-bit builds
+    template<typename A> void serialize(A& ar, CommandListParameters& d)
+    {
+        uint64_t uploadChunkSize = d.uploadChunkSize;
+        uint64_t scratchChunkSize = d.scratchChunkSize;
+        uint64_t scratchMaxMemory = d.scratchMaxMemory;
+
+        ar.pod(d.enableImmediateExecution);
+        ar.pod(uploadChunkSize);
+        ar.pod(scratchChunkSize);
+        ar.pod(scratchMaxMemory);
+        ar.pod(d.queueType);
+        ar.pod(d.isSecondary);
+        ar.pod(d.isReusable);
+
+        if constexpr (A::IsReading)
+        {
+            d.uploadChunkSize = size_t(uploadChunkSize);
+            d.scratchChunkSize = size_t(scratchChunkSize);
+            d.scratchMaxMemory = size_t(scratchMaxMemory);
+        }
+    }
+
+    // The writer never modifies the serialized value
+    template<typename T> void write(TraceWriter& writer, const T& value)
+    {
+        serialize(writer, const_cast<T&>(value));
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,194 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace nvrhi::capture
+{
+    uint32_t ObjectRegistry::add(IResource* object, uint32_t& outReleasedId)
+    {
+        std::lock_guard lock(m_Mutex);
+
+        const uint32_t id = m_NextId++;
+
+        // An object at the same address must have been destroyed before this one was created
+        uint32_t& entry = m_Ids[object];
+        outReleasedId = entry;
+        entry = id;
+
+        return id;
+    }
+
+    uint32_t ObjectRegistry::find(IResource* object) const
+    {
+        if (!object)
+            return 0;
+
+        std::lock_guard lock(m_Mutex);
+
+        auto it = m_Ids.find(object);
+        return (it != m_Ids.end()) ? it->second : 0;
+    }
+
+    void TraceWriter::beginEvent(EventType type)
+    {
+        pod(type);
+        m_OpenEvents.push_back(m_Data.size());
+        pod(uint32_t(0));
+    }
+
+    void TraceWriter::endEvent()
+    {
+        assert(!m_OpenEvents.empty());
+
+        const size_t sizeOffset = m_OpenEvents.back();
+        m_OpenEvents.pop_back();
+
+        const uint32_t payloadSize = uint32_t(m_Data.size() - sizeOffset - sizeof(uint32_t));
+        memcpy(m_Data.data() + sizeOffset, &payloadSize, sizeof(payloadSize));
+    }
+
+    void TraceWriter::bytes(const void* data, size_t size)
+    {
+        if (size == 0)
+            return;
+
+        const uint8_t* begin = static_cast<const uint8_t*>(data);
+        m_Data.insert(m_Data.end(), begin, begin + size);
+    }
+
+    void TraceWriter::blob(const void* data, size_t size)
+    {
+        pod(uint64_t(size));
+        bytes(data, size);
+    }
+
+    void TraceWriter::events(const TraceWriter& nested)
+    {
+        bytes(nested.m_Data.data(), nested.m_Data.size());
+    }
+
+    void TraceWriter::string(const std::string& value)
+    {
+        pod(uint32_t(value.size()));
+        bytes(value.data(), value.size());
+    }
+
+    bool TraceReader::nextEvent(EventType& outType, TraceReader& outPayload)
+    {
+        if (m_Failed || remaining() == 0)
+            return false;
+
+        pod(outType);
+        const uint32_t payloadSize = read<uint32_t>();
+
+        if (m_Failed || payloadSize > remaining())
+        {
+            m_Failed = true;
+            return false;
+        }
+
+        outPayload = TraceReader(m_Data, payloadSize, *m_Objects);
+        m_Data += payloadSize;
+        return true;
+    }
+
+    void TraceReader::bytes(void* data, size_t size)
+    {
+        if (size > remaining())
+        {
+            m_Failed = true;
+            m_Data = m_End;
+            memset(data, 0, size);
+            return;
+        }
+
+        if (size != 0)
+            memcpy(data, m_Data, size);
+        m_Data += size;
+    }
+
+    const uint8_t* TraceReader::blob(size_t& outSize)
+    {
+        const uint64_t size = read<uint64_t>();
+        if (size > remaining())
+        {
+            m_Failed = true;
+            m_Data = m_End;
+            outSize = 0;
+            return nullptr;
+        }
+
+        const uint8_t* data = m_Data;
+        m_Data += size;
+        outSize = size_t(size);
+        return data;
+    }
+
+    void TraceReader::string(std::string& value)
+    {
+        const uint32_t size = read<uint32_t>();
+        if (size > remaining())
+        {
+            m_Failed = true;
+            m_Data = m_End;
+            value.clear();
+            return;
+        }
+
+        value.assign(reinterpret_cast<const char*>(m_Data), size);
+        m_Data += size;
+    }
+
+    IResource* TraceReader::findObject(uint32_t id)
+    {
+        if (id == 0)
+            return nullptr;
+
+        if (id < m_Objects->size() && (*m_Objects)[id])
+            return (*m_Objects)[id];
+
+        ++m_NumMissingObjects;
+        return nullptr;
+    }
+
+    size_t getTextureWriteSize(const TextureDesc& desc, uint32_t mipLevel, size_t rowPitch, size_t depthPitch)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+        const uint32_t mipWidth = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t mipHeight = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t mipDepth = (desc.dimension == TextureDimension::Texture3D) ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        const size_t rowSize = size_t((mipWidth + blockSize - 1) / blockSize) * formatInfo.bytesPerBlock;
+        const size_t numRows = size_t((mipHeight + blockSize - 1) / blockSize);
+
+        // The last row and the last depth slice don't have to be padded to the full pitch
+        return depthPitch * (mipDepth - 1) + rowPitch * (numRows - 1) + rowSize;
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,222 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "accel-struct-stats.h"
+#include <cassert>
+
+namespace nvrhi
+{
+    static void atomicMax(std::atomic<uint64_t>& target, uint64_t value)
+    {
+        uint64_t current = target.load(std::memory_order_relaxed);
+        while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        { }
+    }
+
+    void AccelStructStatsTracker::addObject(ObjectType type, uint64_t bytes)
+    {
+        m_ObjectCounts[size_t(type)].fetch_add(1, std::memory_order_relaxed);
+        m_ObjectBytes[size_t(type)].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void AccelStructStatsTracker::removeObject(ObjectType type, uint64_t bytes)
+    {
+        m_ObjectCounts[size_t(type)].fetch_sub(1, std::memory_order_relaxed);
+        m_ObjectBytes[size_t(type)].fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    void AccelStructStatsTracker::addCompacted(uint64_t prebuildBytes, uint64_t compactedBytes)
+    {
+        m_CompactedCount.fetch_add(1, std::memory_order_relaxed);
+        m_CompactedPrebuildBytes.fetch_add(prebuildBytes, std::memory_order_relaxed);
+        m_CompactedBytes.fetch_add(compactedBytes, std::memory_order_relaxed);
+    }
+
+    void AccelStructStatsTracker::removeCompacted(uint64_t prebuildBytes, uint64_t compactedBytes)
+    {
+        m_CompactedCount.fetch_sub(1, std::memory_order_relaxed);
+        m_CompactedPrebuildBytes.fetch_sub(prebuildBytes, std::memory_order_relaxed);
+        m_CompactedBytes.fetch_sub(compactedBytes, std::memory_order_relaxed);
+    }
+
+    void AccelStructStatsTracker::buildScratchUsed(uint64_t bytes)
+    {
+        atomicMax(m_BuildScratchHighWaterMark, bytes);
+    }
+
+    void AccelStructStatsTracker::clusterOperationExecuted(uint64_t scratchBytes)
+    {
+        m_ClusterOperationCount.fetch_add(1, std::memory_order_relaxed);
+        atomicMax(m_ClusterOperationScratchHighWaterMark, scratchBytes);
+    }
+
+    TimerQueryHandle AccelStructStatsTracker::acquireTimerQuery(IDevice* device)
+    {
+        std::lock_guard lockGuard(m_TimingMutex);
+
+        if (!m_FreeQueries.empty())
+        {
+            TimerQueryHandle query = std::move(m_FreeQueries.back());
+            m_FreeQueries.pop_back();
+            return query;
+        }
+
+        TimerQueryHandle query;
+        if (m_NumCreatedQueries < m_MaxTimerQueries)
+            query = device->createTimerQuery();
+
+        if (query)
+            ++m_NumCreatedQueries;
+        else
+            ++m_FrameUntimedBuilds;
+
+        return query;
+    }
+
+    void AccelStructStatsTracker::buildsExecuted(std::vector<TimerQueryHandle>& queries)
+    {
+        if (queries.empty())
+            return;
+
+        std::lock_guard lockGuard(m_TimingMutex);
+
+        m_ExecutedQueries.insert(m_ExecutedQueries.end(), queries.begin(), queries.end());
+        queries.clear();
+    }
+
+    void AccelStructStatsTracker::endFrame(IDevice* device)
+    {
+        if (!m_BuildTimingEnabled)
+            return;
+
+        std::lock_guard lockGuard(m_TimingMutex);
+
+        // The command lists have finished executing, so reading the times doesn't wait
+        float buildTime = 0.f;
+        for (TimerQueryHandle& query : m_ExecutedQueries)
+        {
+            buildTime += device->getTimerQueryTime(query);
+            device->resetTimerQuery(query);
+            m_FreeQueries.push_back(std::move(query));
+        }
+
+        m_LastFrameTimedBuilds = uint32_t(m_ExecutedQueries.size());
+        m_LastFrameUntimedBuilds = m_FrameUntimedBuilds;
+        m_LastFrameBuildTime = buildTime;
+        m_ExecutedQueries.clear();
+        m_FrameUntimedBuilds = 0;
+    }
+
+    AccelStructStats AccelStructStatsTracker::getStats() const
+    {
+        AccelStructStats stats;
+        stats.bottomLevelCount = m_ObjectCounts[size_t(ObjectType::BottomLevel)].load(std::memory_order_relaxed);
+        stats.bottomLevelBytes = m_ObjectBytes[size_t(ObjectType::BottomLevel)].load(std::memory_order_relaxed);
+        stats.topLevelCount = m_ObjectCounts[size_t(ObjectType::TopLevel)].load(std::memory_order_relaxed);
+        stats.topLevelBytes = m_ObjectBytes[size_t(ObjectType::TopLevel)].load(std::memory_order_relaxed);
+        stats.opacityMicromapCount = m_ObjectCounts[size_t(ObjectType::OpacityMicromap)].load(std::memory_order_relaxed);
+        stats.opacityMicromapBytes = m_ObjectBytes[size_t(ObjectType::OpacityMicromap)].load(std::memory_order_relaxed);
+        stats.compactedCount = m_CompactedCount.load(std::memory_order_relaxed);
+        stats.compactedPrebuildBytes = m_CompactedPrebuildBytes.load(std::memory_order_relaxed);
+        stats.compactedBytes = m_CompactedBytes.load(std::memory_order_relaxed);
+        stats.buildScratchHighWaterMark = m_BuildScratchHighWaterMark.load(std::memory_order_relaxed);
+        stats.clusterOperationScratchHighWaterMark = m_ClusterOperationScratchHighWaterMark.load(std::memory_order_relaxed);
+        stats.clusterOperationCount = m_ClusterOperationCount.load(std::memory_order_relaxed);
+
+        std::lock_guard lockGuard(m_TimingMutex);
+        stats.lastFrameTimedBuilds = m_LastFrameTimedBuilds;
+        stats.lastFrameUntimedBuilds = m_LastFrameUntimedBuilds;
+        stats.lastFrameBuildTimeSeconds = m_LastFrameBuildTime;
+
+        return stats;
+    }
+
+    void AccelStructStatsEntry::set(AccelStructStatsTracker* tracker, AccelStructStatsTracker::ObjectType type, uint64_t bytes)
+    {
+        reset();
+
+        m_Tracker = tracker;
+        m_Type = type;
+        m_Bytes = bytes;
+        m_PrebuildBytes = bytes;
+        m_Compacted = false;
+
+        if (m_Tracker)
+            m_Tracker->addObject(m_Type, m_Bytes);
+    }
+
+    void AccelStructStatsEntry::setCompacted(uint64_t compactedBytes)
+    {
+        if (!m_Tracker)
+            return;
+
+        if (m_Compacted)
+            m_Tracker->removeCompacted(m_PrebuildBytes, m_Bytes);
+
+        m_Tracker->removeObject(m_Type, m_Bytes);
+        m_Bytes = compactedBytes;
+        m_Compacted = true;
+        m_Tracker->addObject(m_Type, m_Bytes);
+        m_Tracker->addCompacted(m_PrebuildBytes, m_Bytes);
+    }
+
+    void AccelStructStatsEntry::reset()
+    {
+        if (!m_Tracker)
+            return;
+
+        m_Tracker->removeObject(m_Type, m_Bytes);
+        if (m_Compacted)
+            m_Tracker->removeCompacted(m_PrebuildBytes, m_Bytes);
+
+        m_Tracker = nullptr;
+    }
+
+    ScopedAccelStructBuildTimer::ScopedAccelStructBuildTimer(AccelStructStatsTracker& tracker, IDevice* device,
+        ICommandList* commandList, std::vector<TimerQueryHandle>* pendingQueries, bool& active)
+    {
+        if (!tracker.isBuildTimingEnabled() || !pendingQueries || active)
+            return;
+
+        m_Active = &active;
+        active = true;
+
+        TimerQueryHandle query = tracker.acquireTimerQuery(device);
+        if (!query)
+            return;
+
+        m_CommandList = commandList;
+        m_Query = query;
+        m_CommandList->beginTimerQuery(m_Query);
+        pendingQueries->push_back(std::move(query));
+    }
+
+    ScopedAccelStructBuildTimer::~ScopedAccelStructBuildTimer()
+    {
+        if (m_Query)
+            m_CommandList->endTimerQuery(m_Query);
+
+        if (m_Active)
+            *m_Active = false;
+    }
+}
@@ -0,0 +1,142 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    // Collects the AccelStructStats of a device. The object counters are updated by AccelStructStatsEntry members
+    // of the objects, and the optional build timing uses a pool of timer queries that wrap the build calls.
+    class AccelStructStatsTracker
+    {
+    public:
+        enum class ObjectType : uint8_t
+        {
+            BottomLevel,
+            TopLevel,
+            OpacityMicromap,
+
+            Count
+        };
+
+        // 'maxTimerQueries' limits how many of the device timer queries the build timing can use
+        AccelStructStatsTracker(bool enableBuildTiming, uint32_t maxTimerQueries)
+            : m_BuildTimingEnabled(enableBuildTiming)
+            , m_MaxTimerQueries(maxTimerQueries)
+        { }
+
+        void addObject(ObjectType type, uint64_t bytes);
+        void removeObject(ObjectType type, uint64_t bytes);
+        void addCompacted(uint64_t prebuildBytes, uint64_t compactedBytes);
+        void removeCompacted(uint64_t prebuildBytes, uint64_t compactedBytes);
+
+        // Records the scratch memory of one build call or cluster operation for the high-water marks
+        void buildScratchUsed(uint64_t bytes);
+        void clusterOperationExecuted(uint64_t scratchBytes);
+
+        [[nodiscard]] bool isBuildTimingEnabled() const { return m_BuildTimingEnabled; }
+
+        // Takes a timer query for one build call from the pool, or creates one.
+        // Returns null and counts the build as untimed when the pool is exhausted.
+        TimerQueryHandle acquireTimerQuery(IDevice* device);
+
+        // Takes the timer queries of a command list that has finished executing
+        void buildsExecuted(std::vector<TimerQueryHandle>& queries);
+
+        // Reads the times of the executed builds, returns their queries to the pool, and starts a new frame.
+        // Called from runGarbageCollection.
+        void endFrame(IDevice* device);
+
+        [[nodiscard]] AccelStructStats getStats() const;
+
+    private:
+        const bool m_BuildTimingEnabled;
+        const uint32_t m_MaxTimerQueries;
+
+        std::atomic<uint64_t> m_ObjectCounts[size_t(ObjectType::Count)] = {};
+        std::atomic<uint64_t> m_ObjectBytes[size_t(ObjectType::Count)] = {};
+        std::atomic<uint64_t> m_CompactedCount = 0;
+        std::atomic<uint64_t> m_CompactedPrebuildBytes = 0;
+        std::atomic<uint64_t> m_CompactedBytes = 0;
+        std::atomic<uint64_t> m_BuildScratchHighWaterMark = 0;
+        std::atomic<uint64_t> m_ClusterOperationScratchHighWaterMark = 0;
+        std::atomic<uint64_t> m_ClusterOperationCount = 0;
+
+        mutable std::mutex m_TimingMutex;
+        std::vector<TimerQueryHandle> m_FreeQueries;
+        std::vector<TimerQueryHandle> m_ExecutedQueries;
+        uint32_t m_NumCreatedQueries = 0;
+        uint32_t m_FrameUntimedBuilds = 0;
+        uint32_t m_LastFrameTimedBuilds = 0;
+        uint32_t m_LastFrameUntimedBuilds = 0;
+        float m_LastFrameBuildTime = 0.f;
+    };
+
+    // Registers an acceleration structure or OMM array with an AccelStructStatsTracker while it is alive.
+    // The tracker must outlive the object, like the device contexts that the objects reference.
+    class AccelStructStatsEntry
+    {
+    public:
+        AccelStructStatsEntry() = default;
+        ~AccelStructStatsEntry() { reset(); }
+
+        AccelStructStatsEntry(const AccelStructStatsEntry&) = delete;
+        AccelStructStatsEntry& operator=(const AccelStructStatsEntry&) = delete;
+
+        void set(AccelStructStatsTracker* tracker, AccelStructStatsTracker::ObjectType type, uint64_t bytes);
+        // Replaces the size with the compacted size, the original size is reported as the pre-build size
+        void setCompacted(uint64_t compactedBytes);
+        void reset();
+
+    private:
+        AccelStructStatsTracker* m_Tracker = nullptr;
+        AccelStructStatsTracker::ObjectType m_Type = AccelStructStatsTracker::ObjectType::BottomLevel;
+        uint64_t m_Bytes = 0;
+        uint64_t m_PrebuildBytes = 0;
+        bool m_Compacted = false;
+    };
+
+    // Wraps one build call in a pooled timer query when the build timing is enabled. The query is added to
+    // 'pendingQueries', which the command list hands to the tracker once it has finished executing, or no query is
+    // used if it's null. 'active' marks the outermost scope, so that nested build calls are not timed twice.
+    class ScopedAccelStructBuildTimer
+    {
+    public:
+        ScopedAccelStructBuildTimer(AccelStructStatsTracker& tracker, IDevice* device, ICommandList* commandList,
+            std::vector<TimerQueryHandle>* pendingQueries, bool& active);
+        ~ScopedAccelStructBuildTimer();
+
+        ScopedAccelStructBuildTimer(const ScopedAccelStructBuildTimer&) = delete;
+        ScopedAccelStructBuildTimer& operator=(const ScopedAccelStructBuildTimer&) = delete;
+
+    private:
+        ICommandList* m_CommandList = nullptr;
+        ITimerQuery* m_Query = nullptr;
+        bool* m_Active = nullptr;
+    };
+}
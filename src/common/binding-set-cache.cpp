@@ -0,0 +1,117 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "binding-set-cache.h"
+#include <nvrhi/common/resourcebindingmap.h>
+
+namespace nvrhi
+{
+    static size_t hashBindingSetItem(const BindingSetItem& item)
+    {
+        size_t hash = 0;
+        hash_combine(hash, item.resourceHandle);
+        hash_combine(hash, item.slot);
+        hash_combine(hash, item.type);
+
+        // Hash the views the same way as the backends key their per-resource view caches
+        switch (item.type)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case ResourceType::Texture_SRV:
+        case ResourceType::Texture_UAV:
+            hash_combine(hash, TextureBindingKey(item.subresources, item.format));
+            hash_combine(hash, item.dimension);
+            break;
+
+        case ResourceType::TypedBuffer_SRV:
+        case ResourceType::TypedBuffer_UAV:
+        case ResourceType::StructuredBuffer_SRV:
+        case ResourceType::StructuredBuffer_UAV:
+        case ResourceType::RawBuffer_SRV:
+        case ResourceType::RawBuffer_UAV:
+        case ResourceType::ConstantBuffer:
+        case ResourceType::VolatileConstantBuffer:
+            hash_combine(hash, BufferBindingKey(item.range, item.format, item.type));
+            break;
+
+        default:
+            // Push constants keep their size in the range, the other types don't use it
+            hash_combine(hash, item.rawData[0]);
+            hash_combine(hash, item.rawData[1]);
+            break;
+        }
+
+        return hash;
+    }
+
+    size_t BindingSetCache::KeyHash::operator()(const Key& key) const
+    {
+        size_t hash = 0;
+        hash_combine(hash, key.layout);
+        hash_combine(hash, key.desc.trackLiveness);
+        for (const BindingSetItem& item : key.desc.bindings)
+            hash_combine(hash, hashBindingSetItem(item));
+        return hash;
+    }
+
+    size_t BindingSetCache::releaseUnused()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        size_t numReleased = 0;
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+        {
+            // The reference count can't grow while the cache holds the only reference, because new references
+            // are only handed out by getOrCreate under the lock
+            IBindingSet* bindingSet = it->second.Get();
+            bindingSet->AddRef();
+            const unsigned long refCount = bindingSet->Release();
+
+            if (refCount == 1)
+            {
+                it = m_Entries.erase(it);
+                ++numReleased;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        return numReleased;
+    }
+
+    void BindingSetCache::clear()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Entries.clear();
+    }
+
+    size_t BindingSetCache::getNumEntries()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Entries.size();
+    }
+}
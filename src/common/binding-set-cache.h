@@ -0,0 +1,96 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace nvrhi
+{
+    // Returns the existing binding set when one is created again with an identical BindingSetDesc and layout,
+    // used by the backends when DeviceDesc::enableBindingSetCache is set. The items are compared by resource
+    // pointer, like in BindingSetDesc::operator==.
+    // The cache holds a reference to each set, and releaseUnused() evicts the sets that are only referenced by
+    // the cache, which also releases the resources that they reference. It's called from runGarbageCollection.
+    class BindingSetCache
+    {
+    public:
+        // Returns the cached set, or creates one with 'create' and caches it.
+        // The creation is done without holding the lock, so that different sets can be created in parallel.
+        template<typename CreateFunc>
+        BindingSetHandle getOrCreate(const BindingSetDesc& desc, IBindingLayout* layout, CreateFunc&& create)
+        {
+            Key key;
+            key.desc = desc;
+            key.layout = layout;
+
+            {
+                std::lock_guard lockGuard(m_Mutex);
+
+                auto it = m_Entries.find(key);
+                if (it != m_Entries.end())
+                    return it->second;
+            }
+
+            BindingSetHandle bindingSet = create();
+            if (!bindingSet)
+                return nullptr;
+
+            std::lock_guard lockGuard(m_Mutex);
+
+            // If another thread has created the same set in the meantime, use that one and let this one go
+            auto result = m_Entries.emplace(std::move(key), bindingSet);
+            return result.first->second;
+        }
+
+        // Evicts the sets that are not referenced outside of the cache, returns the number of evicted sets
+        size_t releaseUnused();
+
+        void clear();
+
+        [[nodiscard]] size_t getNumEntries();
+
+    private:
+        struct Key
+        {
+            BindingSetDesc desc;
+            IBindingLayout* layout = nullptr;
+
+            bool operator==(const Key& other) const
+            {
+                return layout == other.layout && desc.trackLiveness == other.desc.trackLiveness && desc == other.desc;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        std::mutex m_Mutex;
+        std::unordered_map<Key, BindingSetHandle, KeyHash> m_Entries;
+    };
+}
@@ -0,0 +1,204 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/utils.h>
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi::utils
+{
+    BindlessRegistry::BindlessRegistry(IDevice* device, IBindingLayout* bindlessLayout, uint32_t initialCapacity)
+        : m_Device(device)
+    {
+        assert(device);
+        assert(bindlessLayout);
+
+        const BindlessLayoutDesc* layoutDesc = bindlessLayout->getBindlessDesc();
+        if (!layoutDesc)
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "BindlessRegistry requires a layout created with createBindlessLayout");
+            return;
+        }
+
+        // Zero means that the layout doesn't limit the table size
+        m_MaxCapacity = layoutDesc->maxCapacity;
+        if (m_MaxCapacity != 0)
+            initialCapacity = std::min(initialCapacity, m_MaxCapacity);
+
+        m_DescriptorTable = m_Device->createDescriptorTable(bindlessLayout);
+        if (m_DescriptorTable && initialCapacity != 0)
+            m_Device->resizeDescriptorTable(m_DescriptorTable, initialCapacity, false);
+    }
+
+    uint32_t BindlessRegistry::registerResource(const BindingSetItem& item)
+    {
+        if (!m_DescriptorTable)
+            return c_InvalidIndex;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint32_t slot;
+        if (!m_FreeSlots.empty())
+        {
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            if (m_MaxCapacity != 0 && m_NumSlots >= m_MaxCapacity)
+                return c_InvalidIndex;
+
+            slot = m_NumSlots++;
+            m_SlotResources.resize(m_NumSlots);
+        }
+
+        m_SlotResources[slot] = item.resourceHandle;
+        ++m_NumRegistered;
+
+        BindingSetItem& write = m_PendingWrites.emplace_back(item);
+        write.slot = slot;
+
+        return slot;
+    }
+
+    uint32_t BindlessRegistry::registerTexture(ITexture* texture, Format format, TextureSubresourceSet subresources,
+        TextureDimension dimension)
+    {
+        return registerResource(BindingSetItem::Texture_SRV(0, texture, format, subresources, dimension));
+    }
+
+    uint32_t BindlessRegistry::registerSampler(ISampler* sampler)
+    {
+        return registerResource(BindingSetItem::Sampler(0, sampler));
+    }
+
+    void BindlessRegistry::releaseResource(uint32_t index, CommandQueue queue)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        assert(index < m_NumSlots);
+        if (index >= m_NumSlots)
+            return;
+
+        m_JustReleased[size_t(queue)].push_back(index);
+        --m_NumRegistered;
+    }
+
+    void BindlessRegistry::retireReleasedSlots()
+    {
+        // Start tracking the slots released since the last call, all slots released to a queue share one query
+        for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+        {
+            if (m_JustReleased[queue].empty())
+                continue;
+
+            ReleasedSlots released;
+            if (m_QueryPool.empty())
+            {
+                released.query = m_Device->createEventQuery();
+            }
+            else
+            {
+                released.query = m_QueryPool.back();
+                m_QueryPool.pop_back();
+            }
+
+            m_Device->setEventQuery(released.query, CommandQueue(queue));
+            released.slots = std::move(m_JustReleased[queue]);
+            m_JustReleased[queue].clear();
+            m_ReleasedSlots.push_back(std::move(released));
+        }
+
+        // Recycle the slots that the GPU has finished using
+        for (auto it = m_ReleasedSlots.begin(); it != m_ReleasedSlots.end(); )
+        {
+            if (!m_Device->pollEventQuery(it->query))
+            {
+                ++it;
+                continue;
+            }
+
+            for (uint32_t slot : it->slots)
+            {
+                m_SlotResources[slot] = nullptr;
+                m_FreeSlots.push_back(slot);
+            }
+
+            m_Device->resetEventQuery(it->query);
+            m_QueryPool.push_back(std::move(it->query));
+            it = m_ReleasedSlots.erase(it);
+        }
+    }
+
+    uint32_t BindlessRegistry::commitUpdates()
+    {
+        if (!m_DescriptorTable)
+            return 0;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        retireReleasedSlots();
+
+        if (m_PendingWrites.empty())
+            return 0;
+
+        const uint32_t capacity = m_DescriptorTable->getCapacity();
+        if (m_NumSlots > capacity)
+        {
+            // Grow geometrically to keep the number of resizes low, the existing descriptors are copied
+            uint32_t newCapacity = std::max(m_NumSlots, capacity * 2);
+            if (m_MaxCapacity != 0)
+                newCapacity = std::min(newCapacity, m_MaxCapacity);
+
+            m_Device->resizeDescriptorTable(m_DescriptorTable, newCapacity, true);
+        }
+
+        uint32_t numWritten = 0;
+        for (const BindingSetItem& write : m_PendingWrites)
+        {
+            // Skip the writes for the slots that were released and recycled before they were committed
+            if (m_SlotResources[write.slot] != write.resourceHandle)
+                continue;
+
+            if (m_Device->writeDescriptorTable(m_DescriptorTable, write))
+                ++numWritten;
+        }
+        m_PendingWrites.clear();
+
+        return numWritten;
+    }
+
+    uint32_t BindlessRegistry::getCapacity()
+    {
+        return m_DescriptorTable ? m_DescriptorTable->getCapacity() : 0;
+    }
+
+    uint32_t BindlessRegistry::getNumRegistered()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_NumRegistered;
+    }
+}
@@ -0,0 +1,251 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi::utils
+{
+    // Output buffers are allocated in multiples of this size, so that buffers for similar operations can be reused
+    static constexpr uint64_t c_OutputBufferGranularity = 64 * 1024;
+
+    size_t ClusterOperationPool::ParamsHash::operator()(const rt::cluster::OperationParams& params) const
+    {
+        size_t hash = 0;
+        hash_combine(hash, params.maxArgCount);
+        hash_combine(hash, uint32_t(params.type));
+        hash_combine(hash, uint32_t(params.mode));
+        hash_combine(hash, uint32_t(params.flags));
+        hash_combine(hash, uint32_t(params.move.type));
+        hash_combine(hash, params.move.maxBytes);
+        hash_combine(hash, uint32_t(params.clas.vertexFormat));
+        hash_combine(hash, params.clas.maxGeometryIndex);
+        hash_combine(hash, params.clas.maxUniqueGeometryCount);
+        hash_combine(hash, params.clas.maxTriangleCount);
+        hash_combine(hash, params.clas.maxVertexCount);
+        hash_combine(hash, params.clas.maxTotalTriangleCount);
+        hash_combine(hash, params.clas.maxTotalVertexCount);
+        hash_combine(hash, params.clas.minPositionTruncateBitCount);
+        hash_combine(hash, params.blas.maxClasPerBlasCount);
+        hash_combine(hash, params.blas.maxTotalClasCount);
+        return hash;
+    }
+
+    bool ClusterOperationPool::ParamsEqual::operator()(const rt::cluster::OperationParams& a, const rt::cluster::OperationParams& b) const
+    {
+        return a.maxArgCount == b.maxArgCount
+            && a.type == b.type
+            && a.mode == b.mode
+            && a.flags == b.flags
+            && a.move.type == b.move.type
+            && a.move.maxBytes == b.move.maxBytes
+            && a.clas.vertexFormat == b.clas.vertexFormat
+            && a.clas.maxGeometryIndex == b.clas.maxGeometryIndex
+            && a.clas.maxUniqueGeometryCount == b.clas.maxUniqueGeometryCount
+            && a.clas.maxTriangleCount == b.clas.maxTriangleCount
+            && a.clas.maxVertexCount == b.clas.maxVertexCount
+            && a.clas.maxTotalTriangleCount == b.clas.maxTotalTriangleCount
+            && a.clas.maxTotalVertexCount == b.clas.maxTotalVertexCount
+            && a.clas.minPositionTruncateBitCount == b.clas.minPositionTruncateBitCount
+            && a.blas.maxClasPerBlasCount == b.blas.maxClasPerBlasCount
+            && a.blas.maxTotalClasCount == b.blas.maxTotalClasCount;
+    }
+
+    ClusterOperationPool::ClusterOperationPool(IDevice* device, const std::string& debugName)
+        : m_Device(device)
+        , m_DebugName(debugName)
+    {
+        assert(device);
+    }
+
+    rt::cluster::OperationSizeInfo ClusterOperationPool::getSizeInfo(const rt::cluster::OperationParams& params)
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            auto it = m_SizeCache.find(params);
+            if (it != m_SizeCache.end())
+                return it->second;
+        }
+
+        // Query outside of the lock, two threads querying the same params just get the same result
+        const rt::cluster::OperationSizeInfo sizeInfo = m_Device->getClusterOperationSizeInfo(params);
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_SizeCache.emplace(params, sizeInfo);
+        return sizeInfo;
+    }
+
+    void ClusterOperationPool::retireReleasedBuffers()
+    {
+        // Start tracking the buffers released since the last call. Setting the query here rather than in
+        // releaseOutputBuffer is conservative, and lets all buffers released to a queue share one query.
+        for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+        {
+            if (m_JustReleased[queue].empty())
+                continue;
+
+            ReleasedBuffers released;
+            if (m_QueryPool.empty())
+            {
+                released.query = m_Device->createEventQuery();
+            }
+            else
+            {
+                released.query = m_QueryPool.back();
+                m_QueryPool.pop_back();
+            }
+
+            m_Device->setEventQuery(released.query, CommandQueue(queue));
+            released.buffers = std::move(m_JustReleased[queue]);
+            m_JustReleased[queue].clear();
+            m_ReleasedBuffers.push_back(std::move(released));
+        }
+
+        // Return the buffers that the GPU has finished using into the free pool
+        for (auto it = m_ReleasedBuffers.begin(); it != m_ReleasedBuffers.end(); )
+        {
+            if (!m_Device->pollEventQuery(it->query))
+            {
+                ++it;
+                continue;
+            }
+
+            for (BufferHandle& buffer : it->buffers)
+            {
+                const uint64_t byteSize = buffer->getDesc().byteSize;
+                m_FreeBufferBytes += byteSize;
+                m_FreeBuffers.emplace(byteSize, std::move(buffer));
+            }
+
+            m_Device->resetEventQuery(it->query);
+            m_QueryPool.push_back(std::move(it->query));
+            it = m_ReleasedBuffers.erase(it);
+        }
+    }
+
+    BufferHandle ClusterOperationPool::acquireOutputBuffer(uint64_t byteSize)
+    {
+        byteSize = std::max(align(byteSize, c_OutputBufferGranularity), c_OutputBufferGranularity);
+
+        uint32_t bufferIndex = 0;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            retireReleasedBuffers();
+
+            // Take the smallest free buffer that fits, unless it would waste more than half of its memory
+            auto it = m_FreeBuffers.lower_bound(byteSize);
+            if (it != m_FreeBuffers.end() && it->first <= byteSize * 2)
+            {
+                BufferHandle buffer = std::move(it->second);
+                m_FreeBufferBytes -= it->first;
+                m_FreeBuffers.erase(it);
+                return buffer;
+            }
+
+            bufferIndex = m_NumCreatedBuffers++;
+        }
+
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = byteSize;
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.isAccelStructStorage = true;
+        bufferDesc.initialState = ResourceStates::AccelStructRead;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.debugName = m_DebugName + " output buffer " + std::to_string(bufferIndex);
+
+        return m_Device->createBuffer(bufferDesc);
+    }
+
+    void ClusterOperationPool::releaseOutputBuffer(IBuffer* buffer, CommandQueue queue)
+    {
+        if (!buffer)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_JustReleased[size_t(queue)].push_back(buffer);
+    }
+
+    BufferHandle ClusterOperationPool::execute(ICommandList* commandList, const rt::cluster::OperationDesc& desc)
+    {
+        assert(commandList);
+
+        rt::cluster::OperationDesc patchedDesc = desc;
+        BufferHandle outputBuffer = desc.outAccelerationStructuresBuffer;
+
+        const bool needsOutputBuffer = desc.params.mode == rt::cluster::OperationMode::ImplicitDestinations
+            && !desc.outAccelerationStructuresBuffer;
+
+        if (desc.scratchSizeInBytes == 0 || needsOutputBuffer)
+        {
+            const rt::cluster::OperationSizeInfo sizeInfo = getSizeInfo(desc.params);
+
+            if (patchedDesc.scratchSizeInBytes == 0)
+                patchedDesc.scratchSizeInBytes = sizeInfo.scratchSizeInBytes;
+
+            if (needsOutputBuffer)
+            {
+                outputBuffer = acquireOutputBuffer(sizeInfo.resultMaxSizeInBytes);
+                if (!outputBuffer)
+                    return nullptr;
+
+                patchedDesc.outAccelerationStructuresBuffer = outputBuffer;
+                patchedDesc.outAccelerationStructuresOffsetInBytes = 0;
+            }
+        }
+
+        commandList->executeMultiIndirectClusterOperation(patchedDesc);
+
+        return outputBuffer;
+    }
+
+    uint64_t ClusterOperationPool::releaseFreeBuffers()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        retireReleasedBuffers();
+
+        const uint64_t releasedBytes = m_FreeBufferBytes;
+        m_FreeBuffers.clear();
+        m_FreeBufferBytes = 0;
+        return releasedBytes;
+    }
+
+    size_t ClusterOperationPool::getNumCachedSizes()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_SizeCache.size();
+    }
+
+    uint64_t ClusterOperationPool::getFreeBufferBytes()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_FreeBufferBytes;
+    }
+}
@@ -0,0 +1,299 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+#include <string_view>
+
+namespace nvrhi::utils
+{
+    // Both DX12 and Vulkan require the converted matrices to be 64-byte aligned
+    static constexpr uint64_t c_MatrixAlignment = 64;
+
+    bool CoopVecMatrixCache::Key::operator==(const Key& other) const
+    {
+        return dataHash == other.dataHash
+            && dataSize == other.dataSize
+            && srcStride == other.srcStride
+            && srcType == other.srcType
+            && srcLayout == other.srcLayout
+            && dstType == other.dstType
+            && dstLayout == other.dstLayout
+            && numRows == other.numRows
+            && numColumns == other.numColumns;
+    }
+
+    size_t CoopVecMatrixCache::KeyHash::operator()(const Key& key) const
+    {
+        size_t hash = key.dataHash;
+        hash_combine(hash, key.dataSize);
+        hash_combine(hash, key.srcStride);
+        hash_combine(hash, uint32_t(key.srcType));
+        hash_combine(hash, uint32_t(key.srcLayout));
+        hash_combine(hash, uint32_t(key.dstType));
+        hash_combine(hash, uint32_t(key.dstLayout));
+        hash_combine(hash, key.numRows);
+        hash_combine(hash, key.numColumns);
+        return hash;
+    }
+
+    CoopVecMatrixCache::CoopVecMatrixCache(IDevice* device, uint64_t outputBufferSize, const std::string& debugName)
+        : m_Device(device)
+        , m_OutputBufferSize(outputBufferSize)
+        , m_DebugName(debugName)
+    {
+        assert(device);
+
+        if (!m_Device->queryFeatureSupport(Feature::ComputeQueue))
+            m_Queue = CommandQueue::Graphics;
+
+        CommandListParameters params;
+        params.setQueueType(m_Queue)
+            .setEnableImmediateExecution(false);
+
+        m_CommandList = m_Device->createCommandList(params);
+    }
+
+    CoopVecMatrixCache::~CoopVecMatrixCache()
+    {
+        // The source buffers and the command list must outlive the submitted batches
+        retireBatches(true);
+    }
+
+    bool CoopVecMatrixCache::allocateOutput(size_t size, BufferHandle& outBuffer, uint64_t& outOffset)
+    {
+        // The matrices are never released individually, so the output buffers are filled linearly
+        for (OutputBuffer& output : m_OutputBuffers)
+        {
+            const uint64_t offset = align(output.usedBytes, c_MatrixAlignment);
+            if (offset + size <= output.buffer->getDesc().byteSize)
+            {
+                output.usedBytes = offset + size;
+                outBuffer = output.buffer;
+                outOffset = offset;
+                return true;
+            }
+        }
+
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = std::max(m_OutputBufferSize, uint64_t(size));
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.canHaveRawViews = true;
+        // UnorderedAccess is valid on the compute queue, and on DX12 it's where the conversions leave the buffers
+        bufferDesc.initialState = ResourceStates::UnorderedAccess;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.debugName = m_DebugName + " output";
+
+        BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+        if (!buffer)
+            return false;
+
+        OutputBuffer& output = m_OutputBuffers.emplace_back();
+        output.buffer = buffer;
+        output.usedBytes = size;
+        m_OutputBufferBytes += bufferDesc.byteSize;
+
+        outBuffer = buffer;
+        outOffset = 0;
+        return true;
+    }
+
+    coopvec::MatrixLayoutDesc CoopVecMatrixCache::getMatrix(const CoopVecMatrixDesc& desc)
+    {
+        assert(desc.data || desc.dataSize == 0);
+
+        Key key;
+        key.dataHash = std::hash<std::string_view>()(std::string_view(static_cast<const char*>(desc.data), desc.dataSize));
+        key.dataSize = desc.dataSize;
+        key.srcStride = desc.srcStride;
+        key.srcType = desc.srcType;
+        key.srcLayout = desc.srcLayout;
+        key.dstType = desc.dstType;
+        key.dstLayout = desc.dstLayout;
+        key.numRows = desc.numRows;
+        key.numColumns = desc.numColumns;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto it = m_Matrices.find(key);
+        if (it != m_Matrices.end())
+            return it->second;
+
+        coopvec::MatrixLayoutDesc result;
+        result.type = desc.dstType;
+        result.layout = desc.dstLayout;
+        result.size = m_Device->getCoopVecMatrixSize(desc.dstType, desc.dstLayout, int(desc.numRows), int(desc.numColumns));
+        result.stride = coopvec::getOptimalMatrixStride(desc.dstType, desc.dstLayout, desc.numRows, desc.numColumns);
+
+        // Failures are not cached, so that they are retried, e.g. after releasing memory
+        BufferHandle outputBuffer;
+        if (result.size == 0 || desc.dataSize == 0 || !allocateOutput(result.size, outputBuffer, result.offset))
+            return coopvec::MatrixLayoutDesc();
+
+        result.buffer = outputBuffer;
+
+        QueuedConversion& conversion = m_QueuedConversions.emplace_back();
+        conversion.data.assign(static_cast<const uint8_t*>(desc.data), static_cast<const uint8_t*>(desc.data) + desc.dataSize);
+        conversion.desc.src.type = desc.srcType;
+        conversion.desc.src.layout = desc.srcLayout;
+        conversion.desc.src.size = desc.dataSize;
+        conversion.desc.src.stride = desc.srcStride;
+        conversion.desc.dst = result;
+        conversion.desc.numRows = desc.numRows;
+        conversion.desc.numColumns = desc.numColumns;
+
+        m_Matrices[key] = result;
+        return result;
+    }
+
+    void CoopVecMatrixCache::retireBatches(bool waitForAll)
+    {
+        while (!m_BatchesInFlight.empty())
+        {
+            BatchInFlight& batch = m_BatchesInFlight.front();
+
+            if (waitForAll)
+                m_Device->waitEventQuery(batch.query);
+            else if (!m_Device->pollEventQuery(batch.query))
+                break; // batches finish in submission order
+
+            m_Device->resetEventQuery(batch.query);
+            m_QueryPool.push_back(batch.query);
+            m_BatchesInFlight.pop_front();
+        }
+    }
+
+    uint32_t CoopVecMatrixCache::flush()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        retireBatches(false);
+
+        if (m_QueuedConversions.empty() || !m_CommandList)
+            return 0;
+
+        // Pack the sources of all conversions into one buffer
+
+        uint64_t sourceSize = 0;
+        for (QueuedConversion& conversion : m_QueuedConversions)
+        {
+            conversion.desc.src.offset = sourceSize;
+            sourceSize = align(sourceSize + conversion.data.size(), c_MatrixAlignment);
+        }
+
+        BufferDesc sourceDesc;
+        sourceDesc.byteSize = sourceSize;
+        sourceDesc.initialState = ResourceStates::CopyDest;
+        sourceDesc.debugName = m_DebugName + " source";
+
+        BufferHandle sourceBuffer = m_Device->createBuffer(sourceDesc);
+        if (!sourceBuffer)
+            return 0;
+
+        std::vector<coopvec::ConvertMatrixLayoutDesc> descs;
+        descs.reserve(m_QueuedConversions.size());
+
+        m_CommandList->open();
+
+        for (QueuedConversion& conversion : m_QueuedConversions)
+        {
+            m_CommandList->writeBuffer(sourceBuffer, conversion.data.data(), conversion.data.size(), conversion.desc.src.offset);
+
+            conversion.desc.src.buffer = sourceBuffer;
+            descs.push_back(conversion.desc);
+        }
+
+        m_CommandList->convertCoopVecMatrices(descs.data(), descs.size());
+
+        m_CommandList->close();
+        m_LastSubmittedInstance = m_Device->executeCommandList(m_CommandList, m_Queue);
+
+        BatchInFlight batch;
+        if (m_QueryPool.empty())
+        {
+            batch.query = m_Device->createEventQuery();
+        }
+        else
+        {
+            batch.query = m_QueryPool.back();
+            m_QueryPool.pop_back();
+        }
+        m_Device->setEventQuery(batch.query, m_Queue);
+        batch.sourceBuffer = sourceBuffer;
+        m_BatchesInFlight.push_back(std::move(batch));
+
+        const uint32_t numConverted = uint32_t(m_QueuedConversions.size());
+        m_QueuedConversions.clear();
+
+        return numConverted;
+    }
+
+    void CoopVecMatrixCache::queueWaitForConversions(CommandQueue waitQueue)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint64_t& lastWaitedInstance = m_LastWaitedInstances[size_t(waitQueue)];
+
+        if (waitQueue == m_Queue || m_LastSubmittedInstance == lastWaitedInstance)
+            return;
+
+        m_Device->queueWaitForCommandList(waitQueue, m_Queue, m_LastSubmittedInstance);
+        lastWaitedInstance = m_LastSubmittedInstance;
+    }
+
+    void CoopVecMatrixCache::clear()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        retireBatches(true);
+
+        m_Matrices.clear();
+        m_QueuedConversions.clear();
+        m_OutputBuffers.clear();
+        m_OutputBufferBytes = 0;
+    }
+
+    size_t CoopVecMatrixCache::getNumCachedMatrices()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Matrices.size();
+    }
+
+    size_t CoopVecMatrixCache::getNumQueuedConversions()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_QueuedConversions.size();
+    }
+
+    uint64_t CoopVecMatrixCache::getOutputBufferBytes()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_OutputBufferBytes;
+    }
+}
@@ -0,0 +1,174 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "device-stats.h"
+#include <algorithm>
+
+namespace nvrhi
+{
+    void DeviceStatsTracker::addObject(LiveObjectType type, uint64_t bytes)
+    {
+        m_ObjectCounts[size_t(type)].fetch_add(1, std::memory_order_relaxed);
+        m_ObjectBytes[size_t(type)].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void DeviceStatsTracker::removeObject(LiveObjectType type, uint64_t bytes)
+    {
+        m_ObjectCounts[size_t(type)].fetch_sub(1, std::memory_order_relaxed);
+        m_ObjectBytes[size_t(type)].fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    void DeviceStatsTracker::addUploadChunk(uint64_t bytes)
+    {
+        m_UploadChunkCount.fetch_add(1, std::memory_order_relaxed);
+        m_UploadChunkBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void DeviceStatsTracker::removeUploadChunk(uint64_t bytes)
+    {
+        m_UploadChunkCount.fetch_sub(1, std::memory_order_relaxed);
+        m_UploadChunkBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    void DeviceStatsTracker::addDescriptorSetCapacity(int64_t sets)
+    {
+        m_DescriptorSetCapacity.fetch_add(sets, std::memory_order_relaxed);
+    }
+
+    void DeviceStatsTracker::addAllocatedDescriptorSets(int64_t sets)
+    {
+        m_AllocatedDescriptorSets.fetch_add(sets, std::memory_order_relaxed);
+    }
+
+    void DeviceStatsTracker::commandListSubmitted(const CommandListStats& stats, size_t numReferences)
+    {
+        m_CommandListsInFlight.fetch_add(1, std::memory_order_relaxed);
+        m_PendingResourceReferences.fetch_add(numReferences, std::memory_order_relaxed);
+        m_ExecutedCommandLists.fetch_add(1, std::memory_order_relaxed);
+
+        m_DrawCalls.fetch_add(stats.drawCalls, std::memory_order_relaxed);
+        m_Dispatches.fetch_add(stats.dispatches, std::memory_order_relaxed);
+        m_PipelineBinds.fetch_add(stats.pipelineBinds, std::memory_order_relaxed);
+        m_BindingSetBinds.fetch_add(stats.bindingSetBinds, std::memory_order_relaxed);
+        m_BarriersIssued.fetch_add(stats.barriersIssued, std::memory_order_relaxed);
+        m_BarriersElided.fetch_add(stats.barriersElided, std::memory_order_relaxed);
+        m_RenderPassBreaks.fetch_add(stats.renderPassBreaks, std::memory_order_relaxed);
+        m_UploadBytes.fetch_add(stats.uploadBytes, std::memory_order_relaxed);
+        m_VolatileBufferWrites.fetch_add(stats.volatileBufferWrites, std::memory_order_relaxed);
+    }
+
+    void DeviceStatsTracker::commandListRetired(size_t numReferences)
+    {
+        m_CommandListsInFlight.fetch_sub(1, std::memory_order_relaxed);
+        m_PendingResourceReferences.fetch_sub(numReferences, std::memory_order_relaxed);
+    }
+
+    DeviceStats DeviceStatsTracker::getStats() const
+    {
+        DeviceStats stats;
+
+        for (size_t type = 0; type < size_t(LiveObjectType::Count); type++)
+        {
+            stats.liveObjects[type].count = m_ObjectCounts[type].load(std::memory_order_relaxed);
+            stats.liveObjects[type].bytes = m_ObjectBytes[type].load(std::memory_order_relaxed);
+        }
+
+        stats.descriptorSets.allocated = uint64_t(std::max<int64_t>(m_AllocatedDescriptorSets.load(std::memory_order_relaxed), 0));
+        stats.descriptorSets.capacity = uint64_t(std::max<int64_t>(m_DescriptorSetCapacity.load(std::memory_order_relaxed), 0));
+        stats.uploadChunkCount = m_UploadChunkCount.load(std::memory_order_relaxed);
+        stats.uploadChunkBytes = m_UploadChunkBytes.load(std::memory_order_relaxed);
+        stats.commandListsInFlight = m_CommandListsInFlight.load(std::memory_order_relaxed);
+        stats.pendingResourceReferences = m_PendingResourceReferences.load(std::memory_order_relaxed);
+        stats.executedCommandLists = m_ExecutedCommandLists.load(std::memory_order_relaxed);
+
+        CommandListStats& totals = stats.executedCommandListTotals;
+        totals.drawCalls = m_DrawCalls.load(std::memory_order_relaxed);
+        totals.dispatches = m_Dispatches.load(std::memory_order_relaxed);
+        totals.pipelineBinds = m_PipelineBinds.load(std::memory_order_relaxed);
+        totals.bindingSetBinds = m_BindingSetBinds.load(std::memory_order_relaxed);
+        totals.barriersIssued = m_BarriersIssued.load(std::memory_order_relaxed);
+        totals.barriersElided = m_BarriersElided.load(std::memory_order_relaxed);
+        totals.renderPassBreaks = m_RenderPassBreaks.load(std::memory_order_relaxed);
+        totals.uploadBytes = m_UploadBytes.load(std::memory_order_relaxed);
+        totals.volatileBufferWrites = m_VolatileBufferWrites.load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+    void DeviceStatsEntry::set(DeviceStatsTracker* tracker, LiveObjectType type, uint64_t bytes)
+    {
+        reset();
+
+        m_Tracker = tracker;
+        m_Type = type;
+        m_Bytes = bytes;
+
+        if (m_Tracker)
+            m_Tracker->addObject(type, bytes);
+    }
+
+    void DeviceStatsEntry::setUploadChunk(DeviceStatsTracker* tracker, uint64_t bytes)
+    {
+        reset();
+
+        m_Tracker = tracker;
+        m_Type = LiveObjectType::Count;
+        m_Bytes = bytes;
+
+        if (m_Tracker)
+            m_Tracker->addUploadChunk(bytes);
+    }
+
+    void DeviceStatsEntry::reset()
+    {
+        if (!m_Tracker)
+            return;
+
+        if (m_Type == LiveObjectType::Count)
+            m_Tracker->removeUploadChunk(m_Bytes);
+        else
+            m_Tracker->removeObject(m_Type, m_Bytes);
+
+        m_Tracker = nullptr;
+        m_Bytes = 0;
+    }
+
+    uint64_t estimateTextureMemorySize(const TextureDesc& desc)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+        uint64_t size = 0;
+        for (uint32_t mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+        {
+            const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+            const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+            const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+            size += uint64_t((width + blockSize - 1) / blockSize) * ((height + blockSize - 1) / blockSize)
+                * formatInfo.bytesPerBlock * depth;
+        }
+
+        return size * desc.arraySize * std::max(desc.sampleCount, 1u);
+    }
+}
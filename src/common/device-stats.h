@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+
+namespace nvrhi
+{
+    // Collects the DeviceStats of a device. The live objects and upload chunks are counted by DeviceStatsEntry
+    // members of the objects, and the command lists report their counters when they are submitted and retired.
+    // The backends fill the descriptor heap fields themselves.
+    class DeviceStatsTracker
+    {
+    public:
+        void addObject(LiveObjectType type, uint64_t bytes);
+        void removeObject(LiveObjectType type, uint64_t bytes);
+        void addUploadChunk(uint64_t bytes);
+        void removeUploadChunk(uint64_t bytes);
+
+        // Vulkan: descriptor set pools of the binding layouts
+        void addDescriptorSetCapacity(int64_t sets);
+        void addAllocatedDescriptorSets(int64_t sets);
+
+        // 'numReferences' is the number of resources that the submission keeps alive until it's retired
+        void commandListSubmitted(const CommandListStats& stats, size_t numReferences);
+        void commandListRetired(size_t numReferences);
+
+        [[nodiscard]] DeviceStats getStats() const;
+
+    private:
+        std::atomic<uint64_t> m_ObjectCounts[size_t(LiveObjectType::Count)] = {};
+        std::atomic<uint64_t> m_ObjectBytes[size_t(LiveObjectType::Count)] = {};
+        std::atomic<uint64_t> m_UploadChunkCount = 0;
+        std::atomic<uint64_t> m_UploadChunkBytes = 0;
+        std::atomic<int64_t> m_DescriptorSetCapacity = 0;
+        std::atomic<int64_t> m_AllocatedDescriptorSets = 0;
+        std::atomic<uint64_t> m_CommandListsInFlight = 0;
+        std::atomic<uint64_t> m_PendingResourceReferences = 0;
+        std::atomic<uint64_t> m_ExecutedCommandLists = 0;
+
+        std::atomic<uint64_t> m_DrawCalls = 0;
+        std::atomic<uint64_t> m_Dispatches = 0;
+        std::atomic<uint64_t> m_PipelineBinds = 0;
+        std::atomic<uint64_t> m_BindingSetBinds = 0;
+        std::atomic<uint64_t> m_BarriersIssued = 0;
+        std::atomic<uint64_t> m_BarriersElided = 0;
+        std::atomic<uint64_t> m_RenderPassBreaks = 0;
+        std::atomic<uint64_t> m_UploadBytes = 0;
+        std::atomic<uint64_t> m_VolatileBufferWrites = 0;
+    };
+
+    // Registers an object or an upload chunk with a DeviceStatsTracker while it is alive.
+    // The tracker must outlive the object, like the device contexts that the objects reference.
+    class DeviceStatsEntry
+    {
+    public:
+        DeviceStatsEntry() = default;
+        ~DeviceStatsEntry() { reset(); }
+
+        DeviceStatsEntry(const DeviceStatsEntry&) = delete;
+        DeviceStatsEntry& operator=(const DeviceStatsEntry&) = delete;
+
+        void set(DeviceStatsTracker* tracker, LiveObjectType type, uint64_t bytes = 0);
+        void setUploadChunk(DeviceStatsTracker* tracker, uint64_t bytes);
+        void reset();
+
+    private:
+        DeviceStatsTracker* m_Tracker = nullptr;
+        LiveObjectType m_Type = LiveObjectType::Count; // Count marks an upload chunk
+        uint64_t m_Bytes = 0;
+    };
+
+    // Size of the texture data without any padding or alignment, for the backends that can't query the memory size
+    uint64_t estimateTextureMemorySize(const TextureDesc& desc);
+}
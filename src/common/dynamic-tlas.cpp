@@ -0,0 +1,256 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/utils.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace nvrhi::utils
+{
+    DynamicTopLevelAccelStruct::DynamicTopLevelAccelStruct(IDevice* device, const DynamicTopLevelAccelStructDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        assert(device);
+    }
+
+    void DynamicTopLevelAccelStruct::writeInstance(size_t index, const rt::InstanceDesc& instance)
+    {
+        // Convert the instance into the format that buildTopLevelAccelStructFromBuffer expects
+        rt::InstanceDesc converted = instance;
+        converted.blasDeviceAddress = instance.bottomLevelAS ? instance.bottomLevelAS->getDeviceAddress() : 0;
+
+        rt::InstanceDesc& stored = m_Instances[index];
+        if (memcmp(&stored, &converted, sizeof(rt::InstanceDesc)) == 0)
+            return;
+
+        stored = converted;
+        markChanged(index);
+    }
+
+    void DynamicTopLevelAccelStruct::markChanged(size_t index)
+    {
+        if (!m_ChangedSinceRebuild[index])
+        {
+            m_ChangedSinceRebuild[index] = true;
+            ++m_NumChangedSinceRebuild;
+        }
+
+        // Extend the last dirty range when the instances are modified in order, which is the common case
+        if (!m_DirtyRanges.empty() && m_DirtyRanges.back().second == index)
+            m_DirtyRanges.back().second = index + 1;
+        else
+            m_DirtyRanges.emplace_back(index, index + 1);
+    }
+
+    void DynamicTopLevelAccelStruct::addDirtyRange(size_t first, size_t count)
+    {
+        if (count > 0)
+            m_DirtyRanges.emplace_back(first, first + count);
+    }
+
+    void DynamicTopLevelAccelStruct::setInstances(const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        if (numInstances == m_Instances.size())
+        {
+            updateInstances(0, numInstances, pInstances);
+            return;
+        }
+
+        // A different instance count requires a rebuild, which resets the change tracking, so the instances
+        // are just copied and uploaded as a whole
+        m_Instances.resize(numInstances);
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            rt::InstanceDesc& stored = m_Instances[i];
+            stored = pInstances[i];
+            stored.blasDeviceAddress = pInstances[i].bottomLevelAS ? pInstances[i].bottomLevelAS->getDeviceAddress() : 0;
+        }
+
+        m_ChangedSinceRebuild.assign(numInstances, false);
+        m_NumChangedSinceRebuild = 0;
+        m_DirtyRanges.clear();
+        addDirtyRange(0, numInstances);
+    }
+
+    bool DynamicTopLevelAccelStruct::updateInstances(size_t first, size_t count, const rt::InstanceDesc* pInstances)
+    {
+        if (first > m_Instances.size() || count > m_Instances.size() - first)
+            return false;
+
+        for (size_t i = 0; i < count; i++)
+            writeInstance(first + i, pInstances[i]);
+
+        return true;
+    }
+
+    bool DynamicTopLevelAccelStruct::updateTransforms(size_t first, size_t count, const rt::AffineTransform* pTransforms)
+    {
+        if (first > m_Instances.size() || count > m_Instances.size() - first)
+            return false;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t index = first + i;
+            if (memcmp(m_Instances[index].transform, pTransforms[i], sizeof(rt::AffineTransform)) == 0)
+                continue;
+
+            memcpy(m_Instances[index].transform, pTransforms[i], sizeof(rt::AffineTransform));
+            markChanged(index);
+        }
+
+        return true;
+    }
+
+    float DynamicTopLevelAccelStruct::getChangedInstanceFraction() const
+    {
+        if (m_Instances.empty())
+            return 0.f;
+
+        return float(m_NumChangedSinceRebuild) / float(m_Instances.size());
+    }
+
+    bool DynamicTopLevelAccelStruct::createResources(size_t capacity)
+    {
+        capacity = std::max<size_t>(capacity, 1);
+
+        const std::string debugName = m_Desc.debugName.empty() ? std::string("DynamicTopLevelAccelStruct") : m_Desc.debugName;
+
+        auto bufferDesc = BufferDesc()
+            .setByteSize(capacity * sizeof(rt::InstanceDesc))
+            .setIsAccelStructBuildInput(true)
+            .setInitialState(ResourceStates::AccelStructBuildInput)
+            .setKeepInitialState(true)
+            .setDebugName(debugName + " instances");
+
+        BufferHandle instanceBuffer = m_Device->createBuffer(bufferDesc);
+        if (!instanceBuffer)
+            return false;
+
+        auto asDesc = rt::AccelStructDesc()
+            .setTopLevelMaxInstances(capacity)
+            .setBuildFlags(m_Desc.buildFlags | rt::AccelStructBuildFlags::AllowUpdate)
+            .setDebugName(debugName);
+
+        rt::AccelStructHandle accelStruct = m_Device->createAccelStruct(asDesc);
+        if (!accelStruct)
+            return false;
+
+        // The previous objects may still be used by the GPU, the command lists keep them alive
+        m_InstanceBuffer = instanceBuffer;
+        m_AccelStruct = accelStruct;
+        m_Capacity = capacity;
+
+        return true;
+    }
+
+    bool DynamicTopLevelAccelStruct::build(ICommandList* commandList)
+    {
+        const size_t numInstances = m_Instances.size();
+
+        bool rebuild = !m_Built || m_RebuildRequested || numInstances != m_NumBuiltInstances;
+
+        if (!m_AccelStruct || numInstances > m_Capacity)
+        {
+            // Grow by at least 50% to avoid recreating the resources every time a few instances are added
+            const size_t capacity = m_AccelStruct
+                ? std::max(numInstances, m_Capacity + m_Capacity / 2)
+                : std::max(numInstances, m_Desc.initialCapacity);
+
+            if (!createResources(capacity))
+                return false;
+
+            // The new buffer has no instances in it
+            m_DirtyRanges.clear();
+            addDirtyRange(0, numInstances);
+            rebuild = true;
+        }
+
+        if (!rebuild && m_DirtyRanges.empty())
+            return true;
+
+        if (!rebuild)
+        {
+            // Refitting keeps the tree topology of the last rebuild, so its quality degrades as more instances move
+            // away from where they were when the TLAS was rebuilt
+            if (m_Desc.maxRefitsBetweenRebuilds > 0 && m_RefitsSinceRebuild >= m_Desc.maxRefitsBetweenRebuilds)
+                rebuild = true;
+            else if (getChangedInstanceFraction() > m_Desc.maxChangedInstanceFraction)
+                rebuild = true;
+        }
+
+        // Upload the dirty ranges, merging the ones that overlap or are close to each other
+
+        std::sort(m_DirtyRanges.begin(), m_DirtyRanges.end());
+
+        size_t rangeFirst = 0;
+        size_t rangeEnd = 0;
+        for (size_t i = 0; i <= m_DirtyRanges.size(); i++)
+        {
+            if (i < m_DirtyRanges.size() && rangeEnd > rangeFirst
+                && m_DirtyRanges[i].first <= rangeEnd + m_Desc.dirtyRangeMergeDistance)
+            {
+                rangeEnd = std::max(rangeEnd, m_DirtyRanges[i].second);
+                continue;
+            }
+
+            if (rangeEnd > rangeFirst)
+            {
+                commandList->writeBuffer(m_InstanceBuffer, m_Instances.data() + rangeFirst,
+                    (rangeEnd - rangeFirst) * sizeof(rt::InstanceDesc), rangeFirst * sizeof(rt::InstanceDesc));
+            }
+
+            if (i < m_DirtyRanges.size())
+            {
+                rangeFirst = m_DirtyRanges[i].first;
+                rangeEnd = m_DirtyRanges[i].second;
+            }
+        }
+
+        m_DirtyRanges.clear();
+
+        rt::AccelStructBuildFlags buildFlags = m_Desc.buildFlags | rt::AccelStructBuildFlags::AllowUpdate;
+        if (!rebuild)
+            buildFlags = buildFlags | rt::AccelStructBuildFlags::PerformUpdate;
+
+        commandList->buildTopLevelAccelStructFromBuffer(m_AccelStruct, m_InstanceBuffer, 0, numInstances, buildFlags);
+
+        if (rebuild)
+        {
+            m_ChangedSinceRebuild.assign(numInstances, false);
+            m_NumChangedSinceRebuild = 0;
+            m_RefitsSinceRebuild = 0;
+        }
+        else
+        {
+            ++m_RefitsSinceRebuild;
+        }
+
+        m_Built = true;
+        m_RebuildRequested = false;
+        m_LastBuildWasRebuild = rebuild;
+        m_NumBuiltInstances = numInstances;
+
+        return true;
+    }
+} // namespace nvrhi::utils
@@ -0,0 +1,147 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "framebuffer-cache.h"
+
+namespace nvrhi
+{
+    static bool attachmentsEqual(const FramebufferAttachment& a, const FramebufferAttachment& b)
+    {
+        return a.texture == b.texture
+            && a.subresources == b.subresources
+            && a.format == b.format
+            && a.isReadOnly == b.isReadOnly
+            && a.loadOp == b.loadOp
+            && a.storeOp == b.storeOp
+            && a.clearColor == b.clearColor
+            && a.clearDepth == b.clearDepth
+            && a.clearStencil == b.clearStencil;
+    }
+
+    static size_t hashAttachment(const FramebufferAttachment& attachment)
+    {
+        // The clear values are compared but not hashed, framebuffers that only differ in them are rare
+        size_t hash = 0;
+        hash_combine(hash, attachment.texture);
+        hash_combine(hash, attachment.subresources);
+        hash_combine(hash, attachment.format);
+        hash_combine(hash, attachment.isReadOnly);
+        hash_combine(hash, attachment.loadOp);
+        hash_combine(hash, attachment.storeOp);
+        return hash;
+    }
+
+    bool FramebufferCache::KeyEqual::operator()(const FramebufferDesc& a, const FramebufferDesc& b) const
+    {
+        if (a.colorAttachments.size() != b.colorAttachments.size())
+            return false;
+
+        for (size_t index = 0; index < a.colorAttachments.size(); index++)
+        {
+            if (!attachmentsEqual(a.colorAttachments[index], b.colorAttachments[index]))
+                return false;
+        }
+
+        return attachmentsEqual(a.depthAttachment, b.depthAttachment)
+            && attachmentsEqual(a.shadingRateAttachment, b.shadingRateAttachment);
+    }
+
+    size_t FramebufferCache::KeyHash::operator()(const FramebufferDesc& desc) const
+    {
+        size_t hash = 0;
+        for (const FramebufferAttachment& attachment : desc.colorAttachments)
+            hash_combine(hash, hashAttachment(attachment));
+        hash_combine(hash, hashAttachment(desc.depthAttachment));
+        hash_combine(hash, hashAttachment(desc.shadingRateAttachment));
+        return hash;
+    }
+
+    size_t FramebufferCache::releaseUnused()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        size_t numReleased = 0;
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+        {
+            // The reference count can't grow while the cache holds the only reference, because new references
+            // are only handed out by getOrCreate under the lock
+            IFramebuffer* framebuffer = it->second.framebuffer.Get();
+            framebuffer->AddRef();
+            const unsigned long refCount = framebuffer->Release();
+
+            if (refCount == 1 && !it->second.requested)
+            {
+                it = m_Entries.erase(it);
+                ++numReleased;
+            }
+            else
+            {
+                it->second.requested = false;
+                ++it;
+            }
+        }
+
+        return numReleased;
+    }
+
+    void FramebufferCache::evict(ITexture* texture)
+    {
+        if (!texture)
+        {
+            clear();
+            return;
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+        {
+            const FramebufferDesc& desc = it->first;
+
+            bool usesTexture = desc.depthAttachment.texture == texture || desc.shadingRateAttachment.texture == texture;
+            for (const FramebufferAttachment& attachment : desc.colorAttachments)
+                usesTexture = usesTexture || attachment.texture == texture;
+
+            if (usesTexture)
+                it = m_Entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void FramebufferCache::clear()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Entries.clear();
+    }
+
+    size_t FramebufferCache::getNumEntries()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Entries.size();
+    }
+}
@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace nvrhi
+{
+    // Returns the existing framebuffer when one is created again with an identical FramebufferDesc,
+    // used by the backends when DeviceDesc::enableFramebufferCache is set. The attachments are compared by texture
+    // pointer, subresources, format and all other attachment fields.
+    // The cache holds a reference to each framebuffer, which keeps the attachment textures alive. releaseUnused()
+    // evicts the framebuffers that are only referenced by the cache and haven't been requested since the previous
+    // releaseUnused() call, so the textures that the application has released go away after two calls at most.
+    // It's called from runGarbageCollection. evict() is called from IDevice::evictCachedFramebuffers.
+    class FramebufferCache
+    {
+    public:
+        // Returns the cached framebuffer, or creates one with 'create' and caches it.
+        // The creation is done without holding the lock, so that different framebuffers can be created in parallel.
+        template<typename CreateFunc>
+        FramebufferHandle getOrCreate(const FramebufferDesc& desc, CreateFunc&& create)
+        {
+            {
+                std::lock_guard lockGuard(m_Mutex);
+
+                auto it = m_Entries.find(desc);
+                if (it != m_Entries.end())
+                {
+                    it->second.requested = true;
+                    return it->second.framebuffer;
+                }
+            }
+
+            FramebufferHandle framebuffer = create();
+            if (!framebuffer)
+                return nullptr;
+
+            std::lock_guard lockGuard(m_Mutex);
+
+            // If another thread has created the same framebuffer in the meantime, use that one and let this one go
+            auto result = m_Entries.emplace(desc, Entry{ framebuffer, true });
+            result.first->second.requested = true;
+            return result.first->second.framebuffer;
+        }
+
+        // Evicts the framebuffers that are not referenced outside of the cache and were not requested recently,
+        // returns the number of evicted framebuffers
+        size_t releaseUnused();
+
+        // Evicts the framebuffers that have 'texture' as an attachment, or all of them if 'texture' is NULL
+        void evict(ITexture* texture);
+
+        void clear();
+
+        [[nodiscard]] size_t getNumEntries();
+
+    private:
+        struct Entry
+        {
+            FramebufferHandle framebuffer;
+            bool requested = false; // set by getOrCreate, cleared by releaseUnused
+        };
+
+        struct KeyEqual
+        {
+            bool operator()(const FramebufferDesc& a, const FramebufferDesc& b) const;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const FramebufferDesc& desc) const;
+        };
+
+        std::mutex m_Mutex;
+        std::unordered_map<FramebufferDesc, Entry, KeyHash, KeyEqual> m_Entries;
+    };
+}
@@ -0,0 +1,281 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "gpu-profiler.h"
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi
+{
+    TimerQueryHandle GpuProfiler::acquireTimerQuery(IDevice* device)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!m_FreeQueries.empty())
+        {
+            TimerQueryHandle query = std::move(m_FreeQueries.back());
+            m_FreeQueries.pop_back();
+            return query;
+        }
+
+        TimerQueryHandle query;
+        if (m_NumCreatedQueries < m_MaxTimerQueries)
+            query = device->createTimerQuery();
+
+        if (query)
+            ++m_NumCreatedQueries;
+
+        return query;
+    }
+
+    void GpuProfiler::releaseScopes(IDevice* device, ProfilerScopeList& list)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (PendingProfilerScope& scope : list.scopes)
+        {
+            device->resetTimerQuery(scope.query);
+            m_FreeQueries.push_back(std::move(scope.query));
+        }
+
+        list = ProfilerScopeList();
+    }
+
+    void GpuProfiler::scopesSubmitted(ProfilerScopeList& list, CommandQueue queue)
+    {
+        if (list.empty())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        Frame& frame = m_Frames.back();
+        ++frame.pendingLists;
+        frame.droppedScopes += list.droppedScopes;
+
+        list.queue = queue;
+        list.frameIndex = m_FirstFrameIndex + m_Frames.size() - 1;
+        list.submissionIndex = m_NextSubmissionIndex++;
+    }
+
+    void GpuProfiler::scopesExecuted(ProfilerScopeList& list)
+    {
+        if (list.empty())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        assert(list.frameIndex >= m_FirstFrameIndex);
+        Frame& frame = m_Frames[size_t(list.frameIndex - m_FirstFrameIndex)];
+
+        assert(frame.pendingLists > 0);
+        --frame.pendingLists;
+        frame.executedLists.push_back(std::move(list));
+        list = ProfilerScopeList();
+    }
+
+    void GpuProfiler::endFrame(IDevice* device, IProfilerTimestampSource& timestampSource)
+    {
+        if (!m_Enabled)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Frames.emplace_back();
+
+        // The clocks are sampled once per call, and only for the queues that have scopes
+        Calibration calibrations[size_t(CommandQueue::Count)];
+
+        // Frames are completed in order, so a frame that is still executing holds back the later ones
+        while (m_Frames.size() > 1 && m_Frames.front().pendingLists == 0)
+        {
+            resolveFrame(device, timestampSource, m_Frames.front(), calibrations);
+            m_Frames.pop_front();
+            ++m_FirstFrameIndex;
+        }
+    }
+
+    void GpuProfiler::resolveFrame(IDevice* device, IProfilerTimestampSource& timestampSource, Frame& frame,
+        Calibration (&calibrations)[size_t(CommandQueue::Count)])
+    {
+        std::sort(frame.executedLists.begin(), frame.executedLists.end(),
+            [](const ProfilerScopeList& a, const ProfilerScopeList& b) { return a.submissionIndex < b.submissionIndex; });
+
+        std::vector<ITimerQuery*> queries;
+        for (const ProfilerScopeList& list : frame.executedLists)
+        {
+            for (const PendingProfilerScope& scope : list.scopes)
+                queries.push_back(scope.query);
+        }
+
+        std::vector<uint64_t> timestamps(queries.size() * 2);
+        const bool timestampsValid = queries.empty() || timestampSource.readTimestamps(queries.data(), queries.size(), timestamps.data());
+
+        ProfilerFrameResults results;
+        results.frameIndex = m_FirstFrameIndex;
+        results.droppedScopes = frame.droppedScopes;
+
+        size_t timestampIndex = 0;
+        for (ProfilerScopeList& list : frame.executedLists)
+        {
+            ProfilerQueueResults& queueResults = results.queues[size_t(list.queue)];
+            const uint32_t baseIndex = uint32_t(queueResults.scopes.size());
+
+            for (PendingProfilerScope& pendingScope : list.scopes)
+            {
+                ProfilerScope scope;
+                scope.name = std::move(pendingScope.name);
+                scope.parentIndex = pendingScope.parentIndex == c_InvalidProfilerScope
+                    ? c_InvalidProfilerScope
+                    : baseIndex + pendingScope.parentIndex;
+                scope.depth = pendingScope.depth;
+                scope.gpuBeginTimestamp = timestamps[timestampIndex];
+                scope.gpuEndTimestamp = timestamps[timestampIndex + 1];
+                timestampIndex += 2;
+
+                queueResults.scopes.push_back(std::move(scope));
+
+                device->resetTimerQuery(pendingScope.query);
+                m_FreeQueries.push_back(std::move(pendingScope.query));
+            }
+        }
+
+        if (!timestampsValid)
+            return;
+
+        for (size_t queueIndex = 0; queueIndex < size_t(CommandQueue::Count); queueIndex++)
+        {
+            ProfilerQueueResults& queueResults = results.queues[queueIndex];
+            if (queueResults.scopes.empty())
+                continue;
+
+            const CommandQueue queue = CommandQueue(queueIndex);
+            queueResults.timestampFrequency = timestampSource.getTimestampFrequency(queue);
+
+            Calibration& calibration = calibrations[queueIndex];
+            if (!calibration.sampled)
+            {
+                calibration.sampled = true;
+                calibration.valid = timestampSource.calibrateTimestamps(queue, calibration.gpuTimestamp, calibration.cpuTimeNs);
+            }
+
+            if (!calibration.valid || queueResults.timestampFrequency == 0)
+                continue;
+
+            // The scopes are usually older than the calibration point, so the tick differences are signed
+            const double nsPerTick = 1e9 / double(queueResults.timestampFrequency);
+            auto toCpuTime = [&calibration, nsPerTick](uint64_t gpuTimestamp)
+            {
+                const int64_t ticks = int64_t(gpuTimestamp - calibration.gpuTimestamp);
+                return calibration.cpuTimeNs + int64_t(double(ticks) * nsPerTick);
+            };
+
+            for (ProfilerScope& scope : queueResults.scopes)
+            {
+                scope.cpuBeginTimeNs = toCpuTime(scope.gpuBeginTimestamp);
+                scope.cpuEndTimeNs = toCpuTime(scope.gpuEndTimestamp);
+            }
+            queueResults.calibrated = true;
+        }
+
+        m_Results.push_back(std::move(results));
+        while (m_Results.size() > c_MaxStoredFrames)
+            m_Results.pop_front();
+    }
+
+    bool GpuProfiler::getFrameResults(ProfilerFrameResults& outResults)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_Results.empty())
+            return false;
+
+        outResults = std::move(m_Results.front());
+        m_Results.pop_front();
+        return true;
+    }
+
+    void ProfilerScopeRecorder::beginScope(GpuProfiler& profiler, IDevice* device, ICommandList* commandList, const char* name)
+    {
+        TimerQueryHandle query = profiler.acquireTimerQuery(device);
+        if (!query)
+        {
+            ++m_List.droppedScopes;
+            m_OpenScopes.push_back(c_InvalidProfilerScope);
+            return;
+        }
+
+        // The scopes without queries are skipped, their children are attached to the nearest timed ancestor
+        PendingProfilerScope scope;
+        for (auto it = m_OpenScopes.rbegin(); it != m_OpenScopes.rend(); ++it)
+        {
+            if (*it != c_InvalidProfilerScope)
+            {
+                scope.parentIndex = *it;
+                scope.depth = m_List.scopes[*it].depth + 1;
+                break;
+            }
+        }
+
+        scope.name = name ? name : "";
+        scope.query = std::move(query);
+        commandList->beginTimerQuery(scope.query);
+
+        m_OpenScopes.push_back(uint32_t(m_List.scopes.size()));
+        m_List.scopes.push_back(std::move(scope));
+    }
+
+    void ProfilerScopeRecorder::endScope(ICommandList* commandList)
+    {
+        if (m_OpenScopes.empty())
+            return;
+
+        const uint32_t scopeIndex = m_OpenScopes.back();
+        m_OpenScopes.pop_back();
+
+        if (scopeIndex != c_InvalidProfilerScope)
+            commandList->endTimerQuery(m_List.scopes[scopeIndex].query);
+    }
+
+    void ProfilerScopeRecorder::endAllScopes(ICommandList* commandList)
+    {
+        while (!m_OpenScopes.empty())
+            endScope(commandList);
+    }
+
+    void ProfilerScopeRecorder::discard(GpuProfiler& profiler, IDevice* device)
+    {
+        m_OpenScopes.clear();
+
+        if (!m_List.empty())
+            profiler.releaseScopes(device, m_List);
+    }
+
+    ProfilerScopeList ProfilerScopeRecorder::takeScopes()
+    {
+        m_OpenScopes.clear();
+
+        ProfilerScopeList list = std::move(m_List);
+        m_List = ProfilerScopeList();
+        return list;
+    }
+}
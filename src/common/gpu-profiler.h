@@ -0,0 +1,154 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    // Backend functions that the GpuProfiler uses to read the timestamps of its timer queries
+    class IProfilerTimestampSource
+    {
+    public:
+        virtual ~IProfilerTimestampSource() = default;
+
+        // Reads the begin and end timestamps of finished timer queries into 'outTimestamps', two values per query
+        virtual bool readTimestamps(ITimerQuery* const* queries, size_t numQueries, uint64_t* outTimestamps) = 0;
+
+        virtual uint64_t getTimestampFrequency(CommandQueue queue) = 0;
+
+        // Samples the GPU timestamp counter of the queue and std::chrono::steady_clock at the same moment
+        virtual bool calibrateTimestamps(CommandQueue queue, uint64_t& outGpuTimestamp, int64_t& outCpuTimeNs) = 0;
+    };
+
+    struct PendingProfilerScope
+    {
+        std::string name;
+        TimerQueryHandle query;
+        uint32_t parentIndex = c_InvalidProfilerScope;
+        uint32_t depth = 0;
+    };
+
+    // The scopes recorded by one command list, kept with the command list instance until it has finished executing
+    struct ProfilerScopeList
+    {
+        std::vector<PendingProfilerScope> scopes;
+        uint32_t droppedScopes = 0;
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t frameIndex = 0;
+        uint64_t submissionIndex = 0;
+
+        [[nodiscard]] bool empty() const { return scopes.empty() && droppedScopes == 0; }
+    };
+
+    // Collects the timed marker scopes of a device, see DeviceDesc::enableMarkerProfiling. The scopes use a pool
+    // of timer queries, and the scopes of a frame are read in one batch once all its command lists have finished.
+    class GpuProfiler
+    {
+    public:
+        // 'maxTimerQueries' limits how many of the device timer queries the profiler can use
+        GpuProfiler(bool enabled, uint32_t maxTimerQueries)
+            : m_Enabled(enabled)
+            , m_MaxTimerQueries(maxTimerQueries)
+        {
+            m_Frames.emplace_back();
+        }
+
+        [[nodiscard]] bool isEnabled() const { return m_Enabled; }
+
+        // Takes a timer query for one scope from the pool, or creates one. Returns null when the pool is exhausted.
+        TimerQueryHandle acquireTimerQuery(IDevice* device);
+
+        // Returns the queries of scopes that were recorded but never submitted to the pool
+        void releaseScopes(IDevice* device, ProfilerScopeList& list);
+
+        // Assigns the scopes of a command list to the current frame when it's submitted
+        void scopesSubmitted(ProfilerScopeList& list, CommandQueue queue);
+
+        // Takes the scopes of a command list that has finished executing
+        void scopesExecuted(ProfilerScopeList& list);
+
+        // Reads the timestamps of the frames whose command lists have all finished executing, and starts a new frame.
+        // Called from runGarbageCollection.
+        void endFrame(IDevice* device, IProfilerTimestampSource& timestampSource);
+
+        bool getFrameResults(ProfilerFrameResults& outResults);
+
+    private:
+        struct Frame
+        {
+            uint32_t pendingLists = 0;
+            uint32_t droppedScopes = 0;
+            std::vector<ProfilerScopeList> executedLists;
+        };
+
+        struct Calibration
+        {
+            bool sampled = false;
+            bool valid = false;
+            uint64_t gpuTimestamp = 0;
+            int64_t cpuTimeNs = 0;
+        };
+
+        // Results that are not taken by the application are dropped after this many frames
+        static constexpr size_t c_MaxStoredFrames = 8;
+
+        void resolveFrame(IDevice* device, IProfilerTimestampSource& timestampSource, Frame& frame,
+            Calibration (&calibrations)[size_t(CommandQueue::Count)]);
+
+        const bool m_Enabled;
+        const uint32_t m_MaxTimerQueries;
+
+        std::mutex m_Mutex;
+        std::vector<TimerQueryHandle> m_FreeQueries;
+        uint32_t m_NumCreatedQueries = 0;
+        std::deque<Frame> m_Frames; // from m_FirstFrameIndex to the current frame
+        uint64_t m_FirstFrameIndex = 0;
+        uint64_t m_NextSubmissionIndex = 0;
+        std::deque<ProfilerFrameResults> m_Results;
+    };
+
+    // Records the timed marker scopes of one command list. The scopes are independent of other command lists,
+    // and the ones still open when the command list is closed are ended with endAllScopes.
+    class ProfilerScopeRecorder
+    {
+    public:
+        void beginScope(GpuProfiler& profiler, IDevice* device, ICommandList* commandList, const char* name);
+        void endScope(ICommandList* commandList);
+        void endAllScopes(ICommandList* commandList);
+
+        // Releases the scopes of a recording that was not submitted, when the command list is opened again
+        void discard(GpuProfiler& profiler, IDevice* device);
+
+        // Moves the scopes out of the recorder when the command list is submitted
+        ProfilerScopeList takeScopes();
+
+    private:
+        ProfilerScopeList m_List;
+        std::vector<uint32_t> m_OpenScopes; // c_InvalidProfilerScope for the scopes that got no timer query
+    };
+}
@@ -0,0 +1,322 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi::utils
+{
+    static_assert(sizeof(MipGenConstants) == 32);
+
+    // Every group reduces a 64x64 tile of the source mip into 6 mips
+    static constexpr uint32_t c_MipGenTileSize = 64;
+    static constexpr uint32_t c_MipGenMaxSizeForFullPass = c_MipGenTileSize * c_MipGenTileSize;
+    static constexpr uint32_t c_MipGenMipsPerGroupLevel = 6;
+    static constexpr uint32_t c_MipGenCounterSlot = kMipGenMaxMipsPerPass;
+
+    // Typed UAVs can't have sRGB formats, so the shader writes the encoded values through a linear view
+    static Format getLinearFormat(Format format)
+    {
+        switch (format)
+        {
+        case Format::SRGBA8_UNORM: return Format::RGBA8_UNORM;
+        case Format::SBGRA8_UNORM: return Format::BGRA8_UNORM;
+        case Format::SBGRX8_UNORM: return Format::BGRX8_UNORM;
+        default: return format;
+        }
+    }
+
+    static bool isCompatibleDimension(TextureDimension dimension)
+    {
+        switch (dimension)
+        {
+        case TextureDimension::Texture2D:
+        case TextureDimension::Texture2DArray:
+        case TextureDimension::TextureCube:
+        case TextureDimension::TextureCubeArray:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool MipChainGenerator::PassKey::operator==(const PassKey& other) const
+    {
+        return source == other.source
+            && dest == other.dest
+            && sourceMipLevel == other.sourceMipLevel
+            && destMipLevel == other.destMipLevel
+            && numMipLevels == other.numMipLevels
+            && arraySlice == other.arraySlice;
+    }
+
+    size_t MipChainGenerator::PassKeyHash::operator()(const PassKey& key) const
+    {
+        size_t hash = 0;
+        hash_combine(hash, key.source);
+        hash_combine(hash, key.dest);
+        hash_combine(hash, key.sourceMipLevel);
+        hash_combine(hash, key.destMipLevel);
+        hash_combine(hash, key.numMipLevels);
+        hash_combine(hash, key.arraySlice);
+        return hash;
+    }
+
+    MipChainGenerator::MipChainGenerator(IDevice* device, IShader* shader, IShader* integerShader, const std::string& debugName)
+        : m_Device(device)
+    {
+        assert(device);
+        assert(shader);
+
+        m_CounterBuffer = device->createBuffer(BufferDesc()
+            .setByteSize(16)
+            .setCanHaveUAVs(true)
+            .setCanHaveRawViews(true)
+            .setInitialState(ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true)
+            .setDebugName(debugName + " Counter"));
+
+        BindingLayoutDesc layoutDesc;
+        layoutDesc.setVisibility(ShaderType::Compute)
+            .addItem(BindingLayoutItem::PushConstants(0, sizeof(MipGenConstants)))
+            .addItem(BindingLayoutItem::Texture_SRV(0));
+        for (uint32_t slot = 0; slot < kMipGenMaxMipsPerPass; ++slot)
+            layoutDesc.addItem(BindingLayoutItem::Texture_UAV(slot));
+        layoutDesc.addItem(BindingLayoutItem::RawBuffer_UAV(c_MipGenCounterSlot));
+
+        m_BindingLayout = device->createBindingLayout(layoutDesc);
+
+        if (!m_CounterBuffer || !m_BindingLayout)
+            return;
+
+        // The shader resets the counter after every pass, so it only needs one clear. It is executed here rather than
+        // recorded into the first command list that generates mips, which the application may never execute.
+        CommandListHandle commandList = device->createCommandList();
+        if (!commandList)
+            return;
+
+        commandList->open();
+        commandList->clearBufferUInt(m_CounterBuffer, 0);
+        commandList->close();
+        device->executeCommandList(commandList);
+
+        m_Pipeline = device->createComputePipeline(ComputePipelineDesc()
+            .setComputeShader(shader)
+            .addBindingLayout(m_BindingLayout));
+
+        if (integerShader)
+        {
+            m_IntegerPipeline = device->createComputePipeline(ComputePipelineDesc()
+                .setComputeShader(integerShader)
+                .addBindingLayout(m_BindingLayout));
+        }
+    }
+
+    bool MipChainGenerator::generateMips(ICommandList* commandList, ITexture* texture, ArraySlice arraySlice,
+        MipLevel baseMipLevel, MipLevel numMipLevels, MipReduction reduction)
+    {
+        assert(commandList);
+        assert(texture);
+
+        const TextureDesc& desc = texture->getDesc();
+
+        if (!isCompatibleDimension(desc.dimension) || !desc.isUAV || arraySlice >= desc.arraySize || baseMipLevel >= desc.mipLevels)
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "MipChainGenerator requires a 2D, 2D array or cube texture created with isUAV = true");
+            return false;
+        }
+
+        numMipLevels = std::min(numMipLevels, desc.mipLevels - baseMipLevel - 1);
+        if (numMipLevels == 0)
+            return true;
+
+        return generate(commandList, texture, texture, arraySlice, baseMipLevel, baseMipLevel + 1, numMipLevels, reduction);
+    }
+
+    bool MipChainGenerator::generateDepthPyramid(ICommandList* commandList, ITexture* depthTexture, ITexture* pyramid,
+        MipReduction reduction, ArraySlice arraySlice)
+    {
+        assert(commandList);
+        assert(depthTexture);
+        assert(pyramid);
+
+        const TextureDesc& depthDesc = depthTexture->getDesc();
+        const TextureDesc& pyramidDesc = pyramid->getDesc();
+        const FormatKind depthKind = getFormatInfo(depthDesc.format).kind;
+
+        if (!isCompatibleDimension(depthDesc.dimension) || depthDesc.sampleCount != 1 || arraySlice >= depthDesc.arraySize ||
+            (depthKind != FormatKind::DepthStencil && depthKind != FormatKind::Float))
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "MipChainGenerator requires a single-sampled 2D depth texture to build a depth pyramid from");
+            return false;
+        }
+
+        if (!isCompatibleDimension(pyramidDesc.dimension) || !pyramidDesc.isUAV || arraySlice >= pyramidDesc.arraySize)
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "MipChainGenerator requires a 2D depth pyramid texture created with isUAV = true");
+            return false;
+        }
+
+        return generate(commandList, depthTexture, pyramid, arraySlice, 0, 0, pyramidDesc.mipLevels, reduction);
+    }
+
+    bool MipChainGenerator::generate(ICommandList* commandList, ITexture* source, ITexture* dest, ArraySlice arraySlice,
+        MipLevel sourceMipLevel, MipLevel destMipLevel, MipLevel numMipLevels, MipReduction reduction)
+    {
+        if (!isValid())
+            return false;
+
+        const Format destFormat = dest->getDesc().format;
+        const FormatInfo& formatInfo = getFormatInfo(destFormat);
+
+        const bool isInteger = formatInfo.kind == FormatKind::Integer;
+        if (formatInfo.kind == FormatKind::DepthStencil || formatInfo.blockSize != 1 || (isInteger && formatInfo.isSigned))
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                (std::string("MipChainGenerator doesn't support format ") + formatInfo.name).c_str());
+            return false;
+        }
+
+        IComputePipeline* pipeline = isInteger ? m_IntegerPipeline.Get() : m_Pipeline.Get();
+        if (!pipeline)
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "MipChainGenerator needs the integer shader to process integer formats");
+            return false;
+        }
+
+        if (reduction != MipReduction::Average)
+        {
+            // The min and max reductions are only conservative if no row or column is dropped by an odd mip size
+            const TextureDesc& sourceDesc = source->getDesc();
+            uint32_t width = std::max(sourceDesc.width >> sourceMipLevel, 1u);
+            uint32_t height = std::max(sourceDesc.height >> sourceMipLevel, 1u);
+            for (MipLevel mip = 0; mip < numMipLevels; ++mip)
+            {
+                if ((width > 1 && (width & 1) != 0) || (height > 1 && (height & 1) != 0))
+                {
+                    m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                        (std::string("MipChainGenerator can't reduce a ") + std::to_string(width) + "x" + std::to_string(height)
+                            + " mip with the Min or Max reduction, the dimensions must be even or 1").c_str());
+                    return false;
+                }
+
+                width = std::max(width >> 1, 1u);
+                height = std::max(height >> 1, 1u);
+            }
+        }
+
+        const Format uavFormat = getLinearFormat(destFormat);
+        const bool encodeSrgb = formatInfo.isSRGB;
+
+        PassKey key;
+        key.source = source;
+        key.dest = dest;
+        key.sourceMipLevel = sourceMipLevel;
+        key.destMipLevel = destMipLevel;
+        key.arraySlice = arraySlice;
+
+        while (numMipLevels > 0)
+        {
+            key.numMipLevels = numMipLevels;
+            MipLevel numPassMips = dispatchPass(commandList, key, pipeline, uavFormat, encodeSrgb, reduction);
+            if (numPassMips == 0)
+                return false;
+
+            // The next pass continues from the last mip written by this one
+            key.source = dest;
+            key.sourceMipLevel = key.destMipLevel + numPassMips - 1;
+            key.destMipLevel += numPassMips;
+            numMipLevels -= numPassMips;
+        }
+
+        return true;
+    }
+
+    MipLevel MipChainGenerator::dispatchPass(ICommandList* commandList, const PassKey& passKey, IComputePipeline* pipeline,
+        Format uavFormat, bool encodeSrgb, MipReduction reduction)
+    {
+        const TextureDesc& sourceDesc = passKey.source->getDesc();
+        const uint32_t sourceWidth = std::max(sourceDesc.width >> passKey.sourceMipLevel, 1u);
+        const uint32_t sourceHeight = std::max(sourceDesc.height >> passKey.sourceMipLevel, 1u);
+
+        // The last group can only reduce a middle mip that fits into one 64x64 tile
+        const uint32_t maxPassMips = std::max(sourceWidth, sourceHeight) > c_MipGenMaxSizeForFullPass
+            ? c_MipGenMipsPerGroupLevel
+            : kMipGenMaxMipsPerPass;
+
+        PassKey key = passKey;
+        key.numMipLevels = std::min(key.numMipLevels, maxPassMips);
+
+        BindingSetHandle& bindingSet = m_BindingSets[key];
+        if (!bindingSet)
+        {
+            BindingSetDesc setDesc;
+            setDesc.addItem(BindingSetItem::PushConstants(0, sizeof(MipGenConstants)))
+                .addItem(BindingSetItem::Texture_SRV(0, key.source, Format::UNKNOWN,
+                    TextureSubresourceSet(key.sourceMipLevel, 1, key.arraySlice, 1), TextureDimension::Texture2DArray));
+
+            // The slots past the last mip of the pass repeat it, the shader doesn't write them
+            for (uint32_t slot = 0; slot < kMipGenMaxMipsPerPass; ++slot)
+            {
+                MipLevel mipLevel = key.destMipLevel + std::min(slot, key.numMipLevels - 1);
+                setDesc.addItem(BindingSetItem::Texture_UAV(slot, key.dest, uavFormat,
+                    TextureSubresourceSet(mipLevel, 1, key.arraySlice, 1), TextureDimension::Texture2DArray));
+            }
+
+            setDesc.addItem(BindingSetItem::RawBuffer_UAV(c_MipGenCounterSlot, m_CounterBuffer));
+
+            bindingSet = m_Device->createBindingSet(setDesc, m_BindingLayout);
+            if (!bindingSet)
+            {
+                m_BindingSets.erase(key);
+                return 0;
+            }
+        }
+
+        const uint32_t groupsX = (sourceWidth + c_MipGenTileSize - 1) / c_MipGenTileSize;
+        const uint32_t groupsY = (sourceHeight + c_MipGenTileSize - 1) / c_MipGenTileSize;
+
+        MipGenConstants constants{};
+        constants.sourceWidth = sourceWidth;
+        constants.sourceHeight = sourceHeight;
+        constants.numMips = key.numMipLevels;
+        constants.numGroups = groupsX * groupsY;
+        constants.reduction = uint32_t(reduction);
+        constants.encodeSrgb = encodeSrgb ? 1 : 0;
+
+        commandList->setComputeState(ComputeState()
+            .setPipeline(pipeline)
+            .addBindingSet(bindingSet));
+        commandList->setPushConstants(&constants, sizeof(constants));
+        commandList->dispatch(groupsX, groupsY);
+
+        return key.numMipLevels;
+    }
+} // namespace nvrhi::utils
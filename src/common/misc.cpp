@@ -140,6 +140,50 @@ namespace nvrhi
         return false;
     }
     
+    uint32_t IndirectArgumentDesc::getByteSize() const
+    {
+        switch (type)
+        {
+        case IndirectArgumentType::Draw:
+            return uint32_t(sizeof(DrawIndirectArguments));
+        case IndirectArgumentType::DrawIndexed:
+            return uint32_t(sizeof(DrawIndexedIndirectArguments));
+        case IndirectArgumentType::VertexBuffer:
+            return uint32_t(sizeof(IndirectVertexBufferView));
+        case IndirectArgumentType::IndexBuffer:
+            return uint32_t(sizeof(IndirectIndexBufferView));
+        case IndirectArgumentType::PushConstants:
+            return pushConstantByteSize;
+        default:
+            utils::InvalidEnum();
+            return 0;
+        }
+    }
+
+    uint32_t CommandSignatureDesc::getCommandByteStride() const
+    {
+        if (byteStride != 0)
+            return byteStride;
+
+        uint32_t size = 0;
+        for (const auto& arg : arguments)
+            size += arg.getByteSize();
+
+        return size;
+    }
+
+    uint64_t WorkGraphPipelineDesc::getDispatchArgumentsEnd() const
+    {
+        uint64_t end = 0;
+        for (const auto& node : nodes)
+        {
+            if (node.producerNode >= 0)
+                end = std::max(end, node.dispatchArgumentsOffset + sizeof(DispatchIndirectArguments));
+        }
+
+        return end;
+    }
+
     FramebufferInfo::FramebufferInfo(const FramebufferDesc& desc)
     {
         for (size_t i = 0; i < desc.colorAttachments.size(); i++)
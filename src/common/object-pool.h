@@ -0,0 +1,127 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    /*
+    ObjectPool keeps the objects whose last reference has been released, so that frequently created small objects
+    like event queries are recycled instead of being allocated again. The objects implement their interface with
+    PooledRefCounter instead of RefCounter. Every object holds a reference to its pool, so the pool outlives
+    the device when the application still has objects from it. A recycled object keeps its previous contents,
+    it's up to the caller of acquire() to reinitialize it.
+     */
+
+    template<class T> class ObjectPool;
+
+    template<class Interface, class T>
+    class PooledRefCounter : public Interface
+    {
+    public:
+        unsigned long AddRef() override
+        {
+            return ++m_refCount;
+        }
+
+        unsigned long Release() override
+        {
+            unsigned long result = --m_refCount;
+            if (result == 0)
+            {
+                std::shared_ptr<ObjectPool<T>> pool = std::move(m_Pool);
+                if (pool)
+                    pool->recycle(static_cast<T*>(this));
+                else
+                    delete this;
+            }
+            return result;
+        }
+
+        unsigned long GetRefCount() override
+        {
+            return m_refCount.load();
+        }
+
+    private:
+        friend class ObjectPool<T>;
+
+        std::atomic<unsigned long> m_refCount = 1;
+        std::shared_ptr<ObjectPool<T>> m_Pool;
+    };
+
+    template<class T>
+    class ObjectPool : public std::enable_shared_from_this<ObjectPool<T>>
+    {
+    public:
+        ObjectPool() = default;
+
+        ~ObjectPool()
+        {
+            for (T* object : m_FreeObjects)
+                delete object;
+        }
+
+        // Returns a recycled or a new object with one reference
+        T* acquire()
+        {
+            T* object = nullptr;
+            {
+                std::lock_guard lockGuard(m_Mutex);
+                if (!m_FreeObjects.empty())
+                {
+                    object = m_FreeObjects.back();
+                    m_FreeObjects.pop_back();
+                }
+            }
+
+            if (object)
+                object->m_refCount = 1;
+            else
+                object = new T();
+
+            object->m_Pool = this->shared_from_this();
+            return object;
+        }
+
+        void recycle(T* object)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_FreeObjects.push_back(object);
+        }
+
+        // Non-copyable and non-movable, the objects point to the pool
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+
+    private:
+        std::mutex m_Mutex;
+        std::vector<T*> m_FreeObjects;
+    };
+
+} // namespace nvrhi
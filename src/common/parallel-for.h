@@ -0,0 +1,62 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+namespace nvrhi
+{
+    // Calls func(begin, end) for consecutive ranges of up to 'chunkSize' items that cover [0, count).
+    // When 'runner' is provided and there is more than one chunk, the chunks are distributed over its threads
+    // and 'func' must be safe to call concurrently. Otherwise, all items are processed on the calling thread.
+    template<typename F>
+    void parallelFor(IParallelTaskRunner* runner, size_t count, size_t chunkSize, const F& func)
+    {
+        assert(chunkSize > 0);
+
+        const size_t numChunks = (count + chunkSize - 1) / chunkSize;
+
+        if (!runner || numChunks <= 1)
+        {
+            if (count > 0)
+                func(size_t(0), count);
+            return;
+        }
+
+        std::atomic<size_t> nextChunk = 0;
+
+        runner->runParallel(uint32_t(std::min(numChunks, size_t(UINT32_MAX))), [&nextChunk, numChunks, chunkSize, count, &func]()
+        {
+            for (size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed); chunk < numChunks;
+                chunk = nextChunk.fetch_add(1, std::memory_order_relaxed))
+            {
+                const size_t begin = chunk * chunkSize;
+                func(begin, std::min(begin + chunkSize, count));
+            }
+        });
+    }
+} // namespace nvrhi
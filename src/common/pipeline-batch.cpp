@@ -0,0 +1,264 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi::utils
+{
+    PipelineBatch::PipelineBatch(IDevice* device, uint32_t numThreads)
+        : m_Device(device)
+    {
+        assert(device);
+
+        if (numThreads == 0)
+            numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+        m_Threads.reserve(numThreads);
+        for (uint32_t i = 0; i < numThreads; i++)
+            m_Threads.emplace_back(&PipelineBatch::workerThreadProc, this);
+    }
+
+    PipelineBatch::~PipelineBatch()
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_ShuttingDown = true;
+            m_NumPendingJobs -= m_QueuedJobs.size();
+            m_QueuedJobs.clear();
+        }
+
+        m_JobsAvailable.notify_all();
+
+        for (std::thread& thread : m_Threads)
+            thread.join();
+    }
+
+    template<typename T>
+    PipelineBatch::Ticket PipelineBatch::addJobs(PipelineType type, const T* descs, size_t numDescs, T Job::* descMember, const FramebufferInfo* fbinfo)
+    {
+        Ticket firstTicket;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            firstTicket = m_FirstTicket + Ticket(m_Jobs.size());
+
+            for (size_t i = 0; i < numDescs; i++)
+            {
+                Job& job = m_Jobs.emplace_back();
+                job.type = type;
+                job.*descMember = descs[i];
+                if (fbinfo)
+                    job.framebufferInfo = *fbinfo;
+
+                m_QueuedJobs.push_back(firstTicket + i);
+            }
+
+            m_NumPendingJobs += numDescs;
+        }
+
+        m_JobsAvailable.notify_all();
+
+        return firstTicket;
+    }
+
+    PipelineBatch::Ticket PipelineBatch::addGraphicsPipelines(const GraphicsPipelineDesc* descs, size_t numDescs, const FramebufferInfo& fbinfo)
+    {
+        return addJobs(PipelineType::Graphics, descs, numDescs, &Job::graphicsDesc, &fbinfo);
+    }
+
+    PipelineBatch::Ticket PipelineBatch::addComputePipelines(const ComputePipelineDesc* descs, size_t numDescs)
+    {
+        return addJobs(PipelineType::Compute, descs, numDescs, &Job::computeDesc, nullptr);
+    }
+
+    PipelineBatch::Ticket PipelineBatch::addMeshletPipelines(const MeshletPipelineDesc* descs, size_t numDescs, const FramebufferInfo& fbinfo)
+    {
+        return addJobs(PipelineType::Meshlet, descs, numDescs, &Job::meshletDesc, &fbinfo);
+    }
+
+    PipelineBatch::Ticket PipelineBatch::addRayTracingPipelines(const rt::PipelineDesc* descs, size_t numDescs)
+    {
+        return addJobs(PipelineType::RayTracing, descs, numDescs, &Job::rayTracingDesc, nullptr);
+    }
+
+    bool PipelineBatch::isComplete(Ticket ticket)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        assert(ticket < m_FirstTicket + m_Jobs.size());
+        if (ticket < m_FirstTicket)
+            return true;
+
+        const Job* job = findJob(ticket);
+        return job && job->complete;
+    }
+
+    size_t PipelineBatch::getNumPendingPipelines()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_NumPendingJobs;
+    }
+
+    void PipelineBatch::wait(Ticket ticket)
+    {
+        std::unique_lock lock(m_Mutex);
+
+        assert(ticket < m_FirstTicket + m_Jobs.size());
+        m_JobCompleted.wait(lock, [this, ticket]()
+        {
+            const Job* job = findJob(ticket);
+            return !job || job->complete;
+        });
+    }
+
+    void PipelineBatch::waitForAll()
+    {
+        std::unique_lock lock(m_Mutex);
+
+        m_JobCompleted.wait(lock, [this]() { return m_NumPendingJobs == 0; });
+    }
+
+    RefCountPtr<IResource> PipelineBatch::getPipeline(Ticket ticket, PipelineType type)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        const Job* job = findJob(ticket);
+        if (!job || !job->complete || job->type != type)
+            return nullptr;
+
+        return job->pipeline;
+    }
+
+    void PipelineBatch::releaseTicket(Ticket ticket)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        Job* job = findJob(ticket);
+        if (!job)
+            return;
+
+        job->released = true;
+        job->pipeline = nullptr;
+
+        removeReleasedJobs();
+    }
+
+    PipelineBatch::Job* PipelineBatch::findJob(Ticket ticket)
+    {
+        if (ticket < m_FirstTicket || ticket - m_FirstTicket >= m_Jobs.size())
+            return nullptr;
+
+        return &m_Jobs[size_t(ticket - m_FirstTicket)];
+    }
+
+    void PipelineBatch::removeReleasedJobs()
+    {
+        // Only the front can be removed, so that the tickets of the other jobs stay valid.
+        // Jobs that are still being created are kept until they complete, the workers reference them.
+        while (!m_Jobs.empty() && m_Jobs.front().released && m_Jobs.front().complete)
+        {
+            m_Jobs.pop_front();
+            ++m_FirstTicket;
+        }
+    }
+
+    GraphicsPipelineHandle PipelineBatch::getGraphicsPipeline(Ticket ticket)
+    {
+        return checked_cast<IGraphicsPipeline*>(getPipeline(ticket, PipelineType::Graphics).Get());
+    }
+
+    ComputePipelineHandle PipelineBatch::getComputePipeline(Ticket ticket)
+    {
+        return checked_cast<IComputePipeline*>(getPipeline(ticket, PipelineType::Compute).Get());
+    }
+
+    MeshletPipelineHandle PipelineBatch::getMeshletPipeline(Ticket ticket)
+    {
+        return checked_cast<IMeshletPipeline*>(getPipeline(ticket, PipelineType::Meshlet).Get());
+    }
+
+    rt::PipelineHandle PipelineBatch::getRayTracingPipeline(Ticket ticket)
+    {
+        return checked_cast<rt::IPipeline*>(getPipeline(ticket, PipelineType::RayTracing).Get());
+    }
+
+    void PipelineBatch::workerThreadProc()
+    {
+        std::unique_lock lock(m_Mutex);
+
+        while (true)
+        {
+            m_JobsAvailable.wait(lock, [this]() { return m_ShuttingDown || !m_QueuedJobs.empty(); });
+
+            if (m_ShuttingDown)
+                return;
+
+            const Ticket ticket = m_QueuedJobs.front();
+            m_QueuedJobs.pop_front();
+
+            // Adding or removing jobs at the ends of the deque doesn't move the other ones,
+            // so the job can be accessed without the lock
+            Job& job = *findJob(ticket);
+
+            lock.unlock();
+
+            RefCountPtr<IResource> pipeline;
+            switch (job.type)
+            {
+            case PipelineType::Graphics:
+                pipeline = m_Device->createGraphicsPipeline(job.graphicsDesc, job.framebufferInfo);
+                break;
+            case PipelineType::Compute:
+                pipeline = m_Device->createComputePipeline(job.computeDesc);
+                break;
+            case PipelineType::Meshlet:
+                pipeline = m_Device->createMeshletPipeline(job.meshletDesc, job.framebufferInfo);
+                break;
+            case PipelineType::RayTracing:
+                pipeline = m_Device->createRayTracingPipeline(job.rayTracingDesc);
+                break;
+            }
+
+            lock.lock();
+
+            if (!job.released)
+                job.pipeline = pipeline;
+            job.complete = true;
+            job.graphicsDesc = GraphicsPipelineDesc();
+            job.computeDesc = ComputePipelineDesc();
+            job.meshletDesc = MeshletPipelineDesc();
+            job.rayTracingDesc = rt::PipelineDesc();
+            --m_NumPendingJobs;
+
+            removeReleasedJobs();
+
+            m_JobCompleted.notify_all();
+        }
+    }
+}
@@ -0,0 +1,260 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <cassert>
+#include <type_traits>
+
+namespace nvrhi::utils
+{
+    namespace
+    {
+        // Builds an exact binary representation of a description, field by field to skip the struct padding.
+        // Referenced objects are stored as pointers, which is safe because the cached objects keep them alive.
+        class KeyBuilder
+        {
+        public:
+            template<typename T>
+            KeyBuilder& add(const T& value)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                m_Key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+                return *this;
+            }
+
+            KeyBuilder& add(const std::string& value)
+            {
+                add(value.size());
+                m_Key.append(value);
+                return *this;
+            }
+
+            template<typename T>
+            KeyBuilder& add(const RefCountPtr<T>& value)
+            {
+                return add(value.Get());
+            }
+
+            KeyBuilder& add(const FramebufferInfo& fbinfo)
+            {
+                add(fbinfo.colorFormats.size());
+                for (Format format : fbinfo.colorFormats)
+                    add(format);
+                return add(fbinfo.depthFormat).add(fbinfo.sampleCount).add(fbinfo.sampleQuality);
+            }
+
+            KeyBuilder& add(const BindingLayoutVector& layouts)
+            {
+                add(layouts.size());
+                for (const BindingLayoutHandle& layout : layouts)
+                    add(layout);
+                return *this;
+            }
+
+            KeyBuilder& add(const RenderState& state)
+            {
+                const BlendState& blend = state.blendState;
+                add(blend.alphaToCoverageEnable);
+                for (const BlendState::RenderTarget& target : blend.targets)
+                {
+                    add(target.blendEnable).add(target.srcBlend).add(target.destBlend).add(target.blendOp)
+                        .add(target.srcBlendAlpha).add(target.destBlendAlpha).add(target.blendOpAlpha).add(target.colorWriteMask);
+                }
+
+                const DepthStencilState& depth = state.depthStencilState;
+                add(depth.depthTestEnable).add(depth.depthWriteEnable).add(depth.depthFunc).add(depth.stencilEnable)
+                    .add(depth.stencilReadMask).add(depth.stencilWriteMask).add(depth.stencilRefValue).add(depth.dynamicStencilRef);
+                for (const DepthStencilState::StencilOpDesc* face : { &depth.frontFaceStencil, &depth.backFaceStencil })
+                    add(face->failOp).add(face->depthFailOp).add(face->passOp).add(face->stencilFunc);
+
+                const RasterState& raster = state.rasterState;
+                add(raster.fillMode).add(raster.cullMode).add(raster.frontCounterClockwise).add(raster.depthClipEnable)
+                    .add(raster.scissorEnable).add(raster.multisampleEnable).add(raster.antialiasedLineEnable)
+                    .add(raster.depthBias).add(raster.depthBiasClamp).add(raster.slopeScaledDepthBias)
+                    .add(raster.forcedSampleCount).add(raster.programmableSamplePositionsEnable)
+                    .add(raster.conservativeRasterEnable).add(raster.quadFillEnable)
+                    .add(raster.samplePositionsX).add(raster.samplePositionsY);
+
+                const SinglePassStereoState& stereo = state.singlePassStereo;
+                return add(stereo.enabled).add(stereo.independentViewportMask).add(stereo.renderTargetIndexOffset);
+            }
+
+            std::string&& take() { return std::move(m_Key); }
+
+        private:
+            std::string m_Key;
+        };
+    }
+
+    PipelineStateCache::PipelineStateCache(IDevice* device)
+        : m_Device(device)
+    {
+        assert(device);
+    }
+
+    template<typename T, typename CreateFunc>
+    RefCountPtr<T> PipelineStateCache::getOrCreate(EntryMap& map, std::string&& key, CreateFunc&& create, IShader* vertexShader)
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            const auto it = map.find(key);
+            if (it != map.end())
+                return checked_cast<T*>(it->second.object.Get());
+        }
+
+        // Create the object without holding the lock to let other threads use the cache in the meantime
+        RefCountPtr<T> object = create();
+        if (!object)
+            return nullptr;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Another thread might have created an identical object, use the one that got into the cache first
+        const auto [it, inserted] = map.try_emplace(std::move(key));
+        if (inserted)
+        {
+            it->second.object = object.Get();
+            it->second.vertexShader = vertexShader;
+            return object;
+        }
+
+        return checked_cast<T*>(it->second.object.Get());
+    }
+
+    GraphicsPipelineHandle PipelineStateCache::getGraphicsPipeline(const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo)
+    {
+        KeyBuilder key;
+        key.add(desc.primType).add(desc.patchControlPoints).add(desc.inputLayout)
+            .add(desc.VS).add(desc.HS).add(desc.DS).add(desc.GS).add(desc.PS)
+            .add(desc.renderState)
+            .add(desc.shadingRateState.enabled).add(desc.shadingRateState.shadingRate)
+            .add(desc.shadingRateState.pipelinePrimitiveCombiner).add(desc.shadingRateState.imageCombiner)
+            .add(desc.bindingLayouts)
+            .add(desc.indirectVertexBuffers)
+            .add(fbinfo);
+
+        return getOrCreate<IGraphicsPipeline>(m_GraphicsPipelines, key.take(),
+            [&]() { return m_Device->createGraphicsPipeline(desc, fbinfo); });
+    }
+
+    ComputePipelineHandle PipelineStateCache::getComputePipeline(const ComputePipelineDesc& desc)
+    {
+        KeyBuilder key;
+        key.add(desc.CS).add(desc.bindingLayouts);
+
+        return getOrCreate<IComputePipeline>(m_ComputePipelines, key.take(),
+            [&]() { return m_Device->createComputePipeline(desc); });
+    }
+
+    MeshletPipelineHandle PipelineStateCache::getMeshletPipeline(const MeshletPipelineDesc& desc, const FramebufferInfo& fbinfo)
+    {
+        KeyBuilder key;
+        key.add(desc.primType).add(desc.AS).add(desc.MS).add(desc.PS)
+            .add(desc.renderState)
+            .add(desc.bindingLayouts)
+            .add(fbinfo);
+
+        return getOrCreate<IMeshletPipeline>(m_MeshletPipelines, key.take(),
+            [&]() { return m_Device->createMeshletPipeline(desc, fbinfo); });
+    }
+
+    BindingLayoutHandle PipelineStateCache::getBindingLayout(const BindingLayoutDesc& desc)
+    {
+        KeyBuilder key;
+        key.add(desc.visibility).add(desc.registerSpace).add(desc.registerSpaceIsDescriptorSet)
+            .add(desc.bindingOffsets.shaderResource).add(desc.bindingOffsets.sampler)
+            .add(desc.bindingOffsets.constantBuffer).add(desc.bindingOffsets.unorderedAccess)
+            .add(desc.bindings.size());
+        for (const BindingLayoutItem& item : desc.bindings)
+            key.add(item.slot).add(item.type).add(uint16_t(item.size));
+
+        return getOrCreate<IBindingLayout>(m_BindingLayouts, key.take(),
+            [&]() { return m_Device->createBindingLayout(desc); });
+    }
+
+    InputLayoutHandle PipelineStateCache::getInputLayout(const VertexAttributeDesc* attributes, uint32_t attributeCount, IShader* vertexShader)
+    {
+        KeyBuilder key;
+        key.add(vertexShader).add(attributeCount);
+        for (uint32_t i = 0; i < attributeCount; i++)
+        {
+            const VertexAttributeDesc& attr = attributes[i];
+            key.add(attr.name).add(attr.format).add(attr.arraySize).add(attr.bufferIndex)
+                .add(attr.offset).add(attr.elementStride).add(attr.isInstanced);
+        }
+
+        return getOrCreate<IInputLayout>(m_InputLayouts, key.take(),
+            [&]() { return m_Device->createInputLayout(attributes, attributeCount, vertexShader); },
+            vertexShader);
+    }
+
+    size_t PipelineStateCache::releaseUnusedObjects()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        size_t numReleased = 0;
+
+        // Pipelines go first because they reference the layouts
+        for (EntryMap* map : { &m_GraphicsPipelines, &m_ComputePipelines, &m_MeshletPipelines, &m_InputLayouts, &m_BindingLayouts })
+        {
+            for (auto it = map->begin(); it != map->end(); )
+            {
+                // AddRef/Release pair returns the current reference count, 1 means the cache is the only owner
+                IResource* object = it->second.object.Get();
+                object->AddRef();
+                if (object->Release() == 1)
+                {
+                    it = map->erase(it);
+                    ++numReleased;
+                }
+                else
+                    ++it;
+            }
+        }
+
+        return numReleased;
+    }
+
+    void PipelineStateCache::clear()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_GraphicsPipelines.clear();
+        m_ComputePipelines.clear();
+        m_MeshletPipelines.clear();
+        m_InputLayouts.clear();
+        m_BindingLayouts.clear();
+    }
+
+    size_t PipelineStateCache::getNumCachedObjects()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_GraphicsPipelines.size() + m_ComputePipelines.size() + m_MeshletPipelines.size()
+            + m_InputLayouts.size() + m_BindingLayouts.size();
+    }
+}
@@ -0,0 +1,41 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+// CPU profiler hooks in the backend hot paths, which expand to nothing unless a hooks header is provided.
+// Set the NVRHI_PROFILE_HOOKS_HEADER CMake option to a header that defines NVRHI_PROFILE_SCOPE(name)
+// to open a named scope that ends with the enclosing block, e.g. for Tracy:
+//
+//     #include <tracy/Tracy.hpp>
+//     #define NVRHI_PROFILE_SCOPE(name) ZoneScopedN(name)
+//
+// The name is always a string literal.
+
+#ifdef NVRHI_PROFILE_HOOKS_HEADER
+#include NVRHI_PROFILE_HOOKS_HEADER
+#endif
+
+#ifndef NVRHI_PROFILE_SCOPE
+#define NVRHI_PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,142 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/misc.h>
+#include <cstdint>
+#include <cassert>
+#include <iterator>
+#include <map>
+
+namespace nvrhi
+{
+    /*
+    RangeAllocator manages the free space in a memory block that multiple resources are placed into,
+    such as a VkDeviceMemory object or an ID3D12Heap. It uses a first-fit search over the free ranges,
+    and merges adjacent free ranges when allocations are released.
+    The allocator is not thread-safe, callers are expected to provide their own synchronization.
+     */
+
+    class RangeAllocator
+    {
+    public:
+        explicit RangeAllocator(uint64_t size)
+            : m_Size(size)
+        {
+            if (size)
+                m_FreeRanges[0] = size;
+        }
+
+        // Finds a free range that fits 'size' bytes at an offset aligned to 'alignment' (a power of 2).
+        // Returns false if there is no such range.
+        bool allocate(uint64_t size, uint64_t alignment, uint64_t& outOffset)
+        {
+            if (size > m_Size - m_AllocatedBytes)
+                return false;
+
+            if (alignment == 0)
+                alignment = 1;
+
+            for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it)
+            {
+                const uint64_t rangeStart = it->first;
+                const uint64_t rangeEnd = it->first + it->second;
+                const uint64_t offset = align(rangeStart, alignment);
+
+                if (offset + size > rangeEnd)
+                    continue;
+
+                m_FreeRanges.erase(it);
+
+                // Return the alignment padding and the tail of the range to the free list
+                if (offset > rangeStart)
+                    m_FreeRanges[rangeStart] = offset - rangeStart;
+                if (offset + size < rangeEnd)
+                    m_FreeRanges[offset + size] = rangeEnd - (offset + size);
+
+                m_AllocatedBytes += size;
+                ++m_AllocationCount;
+
+                outOffset = offset;
+                return true;
+            }
+
+            return false;
+        }
+
+        // Returns a range previously obtained from allocate(...) to the free list.
+        void release(uint64_t offset, uint64_t size)
+        {
+            uint64_t rangeStart = offset;
+            uint64_t rangeEnd = offset + size;
+
+            // Merge with the following free range
+            auto next = m_FreeRanges.lower_bound(offset);
+            if (next != m_FreeRanges.end() && next->first == rangeEnd)
+            {
+                rangeEnd += next->second;
+                next = m_FreeRanges.erase(next);
+            }
+
+            // Merge with the preceding free range
+            if (next != m_FreeRanges.begin())
+            {
+                auto prev = std::prev(next);
+                if (prev->first + prev->second == rangeStart)
+                {
+                    rangeStart = prev->first;
+                    m_FreeRanges.erase(prev);
+                }
+            }
+
+            m_FreeRanges[rangeStart] = rangeEnd - rangeStart;
+
+            assert(m_AllocatedBytes >= size);
+            assert(m_AllocationCount > 0);
+            m_AllocatedBytes -= size;
+            --m_AllocationCount;
+        }
+
+        [[nodiscard]] uint64_t getSize() const { return m_Size; }
+        [[nodiscard]] uint64_t getAllocatedBytes() const { return m_AllocatedBytes; }
+        [[nodiscard]] uint32_t getAllocationCount() const { return m_AllocationCount; }
+        [[nodiscard]] bool isEmpty() const { return m_AllocationCount == 0; }
+
+    private:
+        uint64_t m_Size = 0;
+        uint64_t m_AllocatedBytes = 0;
+        uint32_t m_AllocationCount = 0;
+
+        // offset -> size
+        std::map<uint64_t, uint64_t> m_FreeRanges;
+    };
+
+    constexpr uint64_t NextPowerOf2(uint64_t value)
+    {
+        uint64_t result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+}
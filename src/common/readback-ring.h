@@ -0,0 +1,129 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/misc.h>
+#include <cstdint>
+#include <cassert>
+#include <deque>
+
+namespace nvrhi
+{
+    /*
+    ReadbackRing manages the space in a persistently mapped readback buffer that asynchronous readbacks
+    (ICommandList::readbackBuffer and readbackTexture) are placed into. Regions are allocated at the head
+    of the ring and stay allocated until their readback ticket is released, which happens in any order.
+    The tail only advances over the oldest regions once they are released, so a ticket that is held for a long
+    time blocks the reuse of the space behind it; the owner then allocates from another ring.
+    The ring is not thread-safe, callers are expected to provide their own synchronization.
+     */
+
+    class ReadbackRing
+    {
+    public:
+        explicit ReadbackRing(uint64_t size)
+            : m_Size(size)
+        { }
+
+        // Finds space for 'size' bytes at an offset aligned to 'alignment' (a power of 2) at the head of the ring.
+        // Returns false if there is no such space.
+        bool allocate(uint64_t size, uint64_t alignment, uint64_t& outOffset)
+        {
+            if (size == 0 || size > m_Size)
+                return false;
+
+            if (alignment == 0)
+                alignment = 1;
+
+            uint64_t offset;
+
+            if (m_Regions.empty())
+            {
+                offset = 0;
+            }
+            else
+            {
+                const uint64_t tail = m_Regions.front().begin;
+                offset = align(m_Head, alignment);
+
+                if (m_Head > tail)
+                {
+                    // The live regions are [tail, head), try the space after the head, then wrap around
+                    if (offset + size > m_Size)
+                    {
+                        if (size > tail)
+                            return false;
+                        offset = 0;
+                    }
+                }
+                else if (offset + size > tail)
+                {
+                    // The live regions are [tail, size) and [0, head)
+                    return false;
+                }
+            }
+
+            m_Regions.push_back(Region{ offset, false });
+            m_Head = offset + size;
+
+            outOffset = offset;
+            return true;
+        }
+
+        // Marks the region previously obtained from allocate(...) at 'offset' as released,
+        // and retires all released regions at the tail of the ring.
+        void release(uint64_t offset)
+        {
+            for (Region& region : m_Regions)
+            {
+                if (region.begin == offset && !region.released)
+                {
+                    region.released = true;
+                    break;
+                }
+            }
+
+            while (!m_Regions.empty() && m_Regions.front().released)
+                m_Regions.pop_front();
+
+            if (m_Regions.empty())
+                m_Head = 0;
+        }
+
+        [[nodiscard]] uint64_t getSize() const { return m_Size; }
+        [[nodiscard]] bool isEmpty() const { return m_Regions.empty(); }
+
+    private:
+        struct Region
+        {
+            uint64_t begin;
+            bool released;
+        };
+
+        uint64_t m_Size = 0;
+        uint64_t m_Head = 0;
+        std::deque<Region> m_Regions;
+    };
+}
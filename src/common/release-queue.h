@@ -0,0 +1,119 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include "resource-references.h"
+#include <chrono>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    /*
+    ReleaseQueue spreads the release of the resources referenced by retired command lists across frames.
+    IDevice::runGarbageCollection(maxReleaseMicroseconds) moves the references of the command lists that have
+    finished executing into the queue, and then releases the oldest queued references until the time budget is spent,
+    so unloading many resources at once doesn't destroy all of them in one frame. The references are only queued once
+    the GPU has finished with them, so releasing them later is as safe as releasing them right away.
+    A call without a budget releases everything, including the references queued by earlier calls.
+     */
+
+    class ReleaseQueue
+    {
+    public:
+        ReleaseQueue() = default;
+
+        ~ReleaseQueue()
+        {
+            releaseAll();
+        }
+
+        // Takes the references out of the list, which is left empty
+        void add(ResourceReferenceList& references)
+        {
+            if (references.empty())
+                return;
+
+            std::lock_guard lockGuard(m_Mutex);
+            references.moveTo(m_Pending);
+        }
+
+        // Releases the oldest references in batches until 'maxMicroseconds' have passed, and at least one batch,
+        // so that the queue keeps shrinking with any budget
+        void release(uint32_t maxMicroseconds)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(maxMicroseconds);
+
+            std::vector<RefCountPtr<IResource>> batch;
+            do
+            {
+                if (!takeBatch(batch))
+                    return;
+
+                // Released outside of the lock, as the destructors may release other objects
+                batch.clear();
+            }
+            while (std::chrono::steady_clock::now() < deadline);
+        }
+
+        void releaseAll()
+        {
+            std::vector<RefCountPtr<IResource>> batch;
+            while (takeBatch(batch))
+                batch.clear();
+        }
+
+        [[nodiscard]] size_t size() const
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            return m_Pending.size();
+        }
+
+        ReleaseQueue(const ReleaseQueue&) = delete;
+        ReleaseQueue& operator=(const ReleaseQueue&) = delete;
+
+    private:
+        // Small enough that a batch doesn't overshoot the budget by much, large enough to make the clock reads cheap
+        static constexpr size_t c_BatchSize = 32;
+
+        mutable std::mutex m_Mutex;
+        std::deque<RefCountPtr<IResource>> m_Pending;
+
+        bool takeBatch(std::vector<RefCountPtr<IResource>>& batch)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (m_Pending.empty())
+                return false;
+
+            const auto last = m_Pending.begin() + ptrdiff_t(std::min(c_BatchSize, m_Pending.size()));
+            batch.assign(std::make_move_iterator(m_Pending.begin()), std::make_move_iterator(last));
+            m_Pending.erase(m_Pending.begin(), last);
+            return true;
+        }
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,83 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <unordered_set>
+#include <vector>
+
+namespace nvrhi
+{
+    /*
+    ResourceReferenceList keeps the resources used by a command buffer alive until it has finished executing.
+    Every resource is referenced only once per recording: repeated uses of the same object, which are common
+    when many draws share pipelines, buffers and binding sets, only cost a hash lookup instead of an atomic
+    AddRef/Release pair and a growing vector. Clearing the list keeps the allocated storage, so command buffers
+    that are reused from a pool stop allocating after a few frames.
+    The list is not thread-safe, it is owned by a single command list while recording.
+     */
+
+    class ResourceReferenceList
+    {
+    public:
+        void add(IResource* resource)
+        {
+            if (!resource || resource == m_LastAdded)
+                return;
+
+            m_LastAdded = resource;
+
+            // The raw pointers in the set are safe to compare because the vector holds a reference to every one of them
+            if (m_Set.insert(resource).second)
+                m_Resources.emplace_back(resource);
+        }
+
+        void clear()
+        {
+            m_Resources.clear();
+            m_Set.clear();
+            m_LastAdded = nullptr;
+        }
+
+        // Moves the references to the end of 'container' and clears the list
+        template<typename Container> void moveTo(Container& container)
+        {
+            for (RefCountPtr<IResource>& resource : m_Resources)
+                container.push_back(std::move(resource));
+            clear();
+        }
+
+        [[nodiscard]] size_t size() const { return m_Resources.size(); }
+        [[nodiscard]] bool empty() const { return m_Resources.empty(); }
+
+        [[nodiscard]] auto begin() const { return m_Resources.begin(); }
+        [[nodiscard]] auto end() const { return m_Resources.end(); }
+
+    private:
+        std::vector<RefCountPtr<IResource>> m_Resources;
+        std::unordered_set<IResource*> m_Set;
+        IResource* m_LastAdded = nullptr;
+    };
+
+} // namespace nvrhi
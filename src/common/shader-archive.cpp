@@ -0,0 +1,332 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/shader-archive.h>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nvrhi::utils
+{
+    ShaderArchive::~ShaderArchive()
+    {
+        close();
+    }
+
+    bool ShaderArchive::open(const char* fileName)
+    {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        m_FileHandle = file;
+        m_MappingHandle = mapping;
+        m_Size = size_t(fileSize.QuadPart);
+#else
+        int file = ::open(fileName, O_RDONLY);
+        if (file < 0)
+            return false;
+
+        struct stat fileStat;
+        if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            ::close(file);
+            return false;
+        }
+
+        void* data = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        // The mapping stays valid after the file is closed
+        ::close(file);
+
+        if (data == MAP_FAILED)
+            return false;
+
+        m_Size = size_t(fileStat.st_size);
+#endif
+
+        m_Data = static_cast<const uint8_t*>(data);
+        m_IsMapped = true;
+
+        if (!validate())
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ShaderArchive::openMemory(const void* data, size_t size)
+    {
+        close();
+
+        m_Data = static_cast<const uint8_t*>(data);
+        m_Size = size;
+
+        if (!validate())
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void ShaderArchive::close()
+    {
+        if (m_IsMapped)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(m_Data);
+            CloseHandle(m_MappingHandle);
+            CloseHandle(m_FileHandle);
+            m_FileHandle = nullptr;
+            m_MappingHandle = nullptr;
+#else
+            munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+            m_IsMapped = false;
+        }
+
+        m_Data = nullptr;
+        m_Size = 0;
+        m_Header = nullptr;
+        m_Entries = nullptr;
+
+        std::lock_guard lockGuard(m_DecompressionMutex);
+        m_DecompressedEntries.clear();
+    }
+
+    bool ShaderArchive::validate()
+    {
+        if (!m_Data || m_Size < sizeof(ShaderArchiveHeader))
+            return false;
+
+        const ShaderArchiveHeader* header = reinterpret_cast<const ShaderArchiveHeader*>(m_Data);
+        if (header->signature != c_ShaderArchiveSignature || header->version != c_ShaderArchiveVersion)
+            return false;
+
+        const uint64_t indexEnd = sizeof(ShaderArchiveHeader) + uint64_t(header->numEntries) * sizeof(ShaderArchiveEntry);
+        if (indexEnd > m_Size)
+            return false;
+
+        const ShaderArchiveEntry* entries = reinterpret_cast<const ShaderArchiveEntry*>(m_Data + sizeof(ShaderArchiveHeader));
+
+        // Check all ranges once here, so that the lookups don't have to
+        for (uint32_t i = 0; i < header->numEntries; i++)
+        {
+            const ShaderArchiveEntry& entry = entries[i];
+
+            if (uint64_t(entry.permutationOffset) + entry.permutationSize > m_Size)
+                return false;
+
+            if (entry.dataOffset > m_Size || entry.dataSize > m_Size - entry.dataOffset)
+                return false;
+
+            if (entry.compression != ShaderArchiveCompression::None && entry.compression != ShaderArchiveCompression::LZ4)
+                return false;
+
+            // The decompression buffer is allocated from uncompressedSize, so don't trust it blindly.
+            // LZ4 cannot expand the data by more than 255x, anything above that is a corrupt entry.
+            if (entry.compression == ShaderArchiveCompression::LZ4 &&
+                (entry.uncompressedSize > c_ShaderArchiveMaxUncompressedSize ||
+                 uint64_t(entry.uncompressedSize) > uint64_t(entry.dataSize) * 255))
+                return false;
+
+            if (i > 0 && entries[i - 1].permutationHash > entry.permutationHash)
+                return false;
+        }
+
+        m_Header = header;
+        m_Entries = entries;
+        return true;
+    }
+
+    bool ShaderArchive::findPermutation(const ShaderDefine* defines, size_t numDefines, const void** pBinary, size_t* pSize)
+    {
+        if (!m_Header)
+            return false;
+
+        std::vector<std::pair<std::string, std::string>> definePairs;
+        definePairs.reserve(numDefines);
+        for (size_t i = 0; i < numDefines; i++)
+            definePairs.emplace_back(defines[i].name, defines[i].value ? defines[i].value : "");
+
+        const std::string permutation = BuildShaderArchivePermutation(std::move(definePairs));
+        const uint64_t hash = HashShaderArchivePermutation(permutation);
+
+        const ShaderArchiveEntry* entriesEnd = m_Entries + m_Header->numEntries;
+        const ShaderArchiveEntry* entry = std::lower_bound(m_Entries, entriesEnd, hash,
+            [](const ShaderArchiveEntry& e, uint64_t value) { return e.permutationHash < value; });
+
+        // Compare the strings to resolve hash collisions
+        for (; entry != entriesEnd && entry->permutationHash == hash; ++entry)
+        {
+            if (entry->permutationSize != permutation.size() ||
+                memcmp(m_Data + entry->permutationOffset, permutation.data(), permutation.size()) != 0)
+                continue;
+
+            const uint8_t* data = m_Data + entry->dataOffset;
+
+            if (entry->compression == ShaderArchiveCompression::None)
+            {
+                *pBinary = data;
+                *pSize = entry->dataSize;
+                return true;
+            }
+
+            const uint32_t entryIndex = uint32_t(entry - m_Entries);
+
+            std::lock_guard lockGuard(m_DecompressionMutex);
+
+            auto found = m_DecompressedEntries.find(entryIndex);
+            if (found == m_DecompressedEntries.end())
+            {
+                std::vector<uint8_t> decompressed(entry->uncompressedSize);
+                if (!DecompressLZ4Block(data, entry->dataSize, decompressed.data(), decompressed.size()))
+                    return false;
+
+                found = m_DecompressedEntries.emplace(entryIndex, std::move(decompressed)).first;
+            }
+
+            // The vector storage doesn't move when other entries are added to the map
+            *pBinary = found->second.data();
+            *pSize = found->second.size();
+            return true;
+        }
+
+        return false;
+    }
+
+    ShaderHandle ShaderArchive::createShader(IDevice* device, const ShaderDesc& desc, const ShaderDefine* defines, size_t numDefines)
+    {
+        const void* binary = nullptr;
+        size_t binarySize = 0;
+        if (!findPermutation(defines, numDefines, &binary, &binarySize))
+            return nullptr;
+
+        return device->createShader(desc, binary, binarySize);
+    }
+
+    bool DecompressLZ4Block(const void* src, size_t srcSize, void* dst, size_t dstSize)
+    {
+        const uint8_t* ip = static_cast<const uint8_t*>(src);
+        const uint8_t* const ipEnd = ip + srcSize;
+        uint8_t* op = static_cast<uint8_t*>(dst);
+        uint8_t* const opStart = op;
+        uint8_t* const opEnd = op + dstSize;
+
+        // Reads the extended length bytes that follow a length field of 15
+        auto readLength = [&ip, ipEnd](size_t& length)
+        {
+            uint8_t value;
+            do
+            {
+                if (ip >= ipEnd)
+                    return false;
+                value = *ip++;
+                length += value;
+            } while (value == 255);
+            return true;
+        };
+
+        while (ip < ipEnd)
+        {
+            const uint8_t token = *ip++;
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !readLength(literalLength))
+                return false;
+
+            if (literalLength > size_t(ipEnd - ip) || literalLength > size_t(opEnd - op))
+                return false;
+
+            memcpy(op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+
+            // The last sequence has only literals
+            if (ip == ipEnd)
+                break;
+
+            if (ipEnd - ip < 2)
+                return false;
+
+            const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+            ip += 2;
+
+            if (offset == 0 || offset > size_t(op - opStart))
+                return false;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(matchLength))
+                return false;
+            matchLength += 4;
+
+            if (matchLength > size_t(opEnd - op))
+                return false;
+
+            // The match can overlap the output, copy byte by byte
+            const uint8_t* match = op - offset;
+            for (size_t i = 0; i < matchLength; i++)
+                op[i] = match[i];
+            op += matchLength;
+        }
+
+        return op == opEnd;
+    }
+}
@@ -0,0 +1,646 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi::utils
+{
+    // Decoded MinMip feedback value of the regions that haven't been sampled
+    static constexpr uint8_t c_FeedbackNotSampled = 0xff;
+
+    // Row pitch alignment of the decoded feedback, same as D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    static constexpr uint32_t c_FeedbackRowPitchAlignment = 256;
+
+    // Maximum number of subresource tilings that getTextureTiling returns
+    static constexpr uint32_t c_MaxStandardMips = 16;
+
+    SparseTextureStreamer::SparseTextureStreamer(IDevice* device, const SparseTextureStreamerDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        assert(device);
+
+        if (!m_Device->queryFeatureSupport(Feature::SamplerFeedback) ||
+            !m_Device->queryFeatureSupport(Feature::VirtualResources) ||
+            !m_Device->queryFeatureSupport(Feature::AsyncReadback))
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "SparseTextureStreamer requires the SamplerFeedback, VirtualResources and AsyncReadback features");
+            return;
+        }
+
+        if (m_Desc.heapSize < c_TileSizeInBytes || m_Desc.heapSize % c_TileSizeInBytes != 0)
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "SparseTextureStreamer heap size must be a non-zero multiple of the 64 KB tile size");
+            return;
+        }
+
+        m_TilesPerHeap = uint32_t(m_Desc.heapSize / c_TileSizeInBytes);
+        m_Valid = true;
+    }
+
+    SparseTextureStreamer::~SparseTextureStreamer()
+    {
+        // The tiles don't have to be unmapped here, the textures either are destroyed
+        // along with the heaps, or are owned by the application which must have stopped using them
+    }
+
+    uint32_t SparseTextureStreamer::addTexture(ITexture* texture, ISamplerFeedbackTexture* feedback, LoadCallback loadCallback)
+    {
+        if (!m_Valid)
+            return c_InvalidTexture;
+
+        assert(texture);
+        assert(feedback);
+        assert(loadCallback);
+
+        const TextureDesc& textureDesc = texture->getDesc();
+        const SamplerFeedbackTextureDesc& feedbackDesc = feedback->getDesc();
+
+        if (!textureDesc.isTiled || textureDesc.dimension != TextureDimension::Texture2D || textureDesc.arraySize != 1)
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "SparseTextureStreamer only supports tiled 2D textures with a single array slice");
+            return c_InvalidTexture;
+        }
+
+        if (feedback->getPairedTexture() != texture || feedbackDesc.samplerFeedbackFormat != SamplerFeedbackFormat::MinMipOpaque ||
+            feedbackDesc.samplerFeedbackMipRegionX == 0 || feedbackDesc.samplerFeedbackMipRegionY == 0)
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "SparseTextureStreamer requires a MinMipOpaque sampler feedback texture paired with the texture");
+            return c_InvalidTexture;
+        }
+
+        auto tex = std::make_unique<Texture>();
+        tex->texture = texture;
+        tex->feedback = feedback;
+        tex->loadCallback = std::move(loadCallback);
+
+        uint32_t numTiles = 0;
+        uint32_t numTilings = std::min(textureDesc.mipLevels, c_MaxStandardMips);
+        SubresourceTiling tilings[c_MaxStandardMips];
+        m_Device->getTextureTiling(texture, &numTiles, &tex->packedMips, &tex->tileShape, &numTilings, tilings);
+
+        if (tex->packedMips.numStandardMips > numTilings || tex->tileShape.widthInTexels == 0 || tex->tileShape.heightInTexels == 0)
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "SparseTextureStreamer doesn't support the tiling of the texture");
+            return c_InvalidTexture;
+        }
+
+        tex->mipTilings.assign(tilings, tilings + tex->packedMips.numStandardMips);
+        for (uint32_t mipLevel = 0; mipLevel < tex->packedMips.numStandardMips; ++mipLevel)
+        {
+            const SubresourceTiling& tiling = tex->mipTilings[mipLevel];
+            tex->mipFirstTile.push_back(uint32_t(tex->tiles.size()));
+
+            for (uint32_t y = 0; y < tiling.heightInTiles; ++y)
+            {
+                for (uint32_t x = 0; x < tiling.widthInTiles; ++x)
+                {
+                    Tile tile;
+                    tile.mipLevel = mipLevel;
+                    tile.x = x;
+                    tile.y = y;
+                    tex->tiles.push_back(tile);
+                }
+            }
+        }
+
+        tex->mipRegionWidth = feedbackDesc.samplerFeedbackMipRegionX;
+        tex->mipRegionHeight = feedbackDesc.samplerFeedbackMipRegionY;
+        tex->feedbackWidth = (textureDesc.width + tex->mipRegionWidth - 1) / tex->mipRegionWidth;
+        tex->feedbackHeight = (textureDesc.height + tex->mipRegionHeight - 1) / tex->mipRegionHeight;
+        tex->feedbackRowPitch = align(tex->feedbackWidth, c_FeedbackRowPitchAlignment);
+
+        BufferDesc decodeBufferDesc;
+        decodeBufferDesc.setByteSize(uint64_t(tex->feedbackRowPitch) * tex->feedbackHeight)
+            .setDebugName(m_Desc.debugName + " feedback")
+            .setInitialState(ResourceStates::CopySource)
+            .setKeepInitialState(true);
+        tex->decodeBuffer = m_Device->createBuffer(decodeBufferDesc);
+
+        uint32_t residencyWidth = 1;
+        uint32_t residencyHeight = 1;
+        if (!tex->mipTilings.empty())
+        {
+            residencyWidth = tex->mipTilings[0].widthInTiles;
+            residencyHeight = tex->mipTilings[0].heightInTiles;
+        }
+
+        TextureDesc residencyDesc;
+        residencyDesc.setWidth(residencyWidth)
+            .setHeight(residencyHeight)
+            .setFormat(Format::R8_UINT)
+            .setDebugName(m_Desc.debugName + " residency")
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true);
+        tex->residencyTexture = m_Device->createTexture(residencyDesc);
+        tex->residencyData.resize(size_t(residencyWidth) * residencyHeight);
+
+        if (!tex->decodeBuffer || !tex->residencyTexture)
+            return c_InvalidTexture;
+
+        // The packed mips are mapped once and stay resident, so that every texel has some data to sample
+        for (uint32_t i = 0; i < tex->packedMips.numTilesForPackedMips; ++i)
+        {
+            uint32_t heapTile;
+            if (!allocateHeapTile(heapTile, false))
+            {
+                m_FreeHeapTiles.insert(m_FreeHeapTiles.end(), tex->packedMipHeapTiles.begin(), tex->packedMipHeapTiles.end());
+                m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                    "SparseTextureStreamer memory budget is too small for the packed mips of the texture");
+                return c_InvalidTexture;
+            }
+            tex->packedMipHeapTiles.push_back(heapTile);
+        }
+
+        if (!tex->packedMipHeapTiles.empty())
+        {
+            // Packed tiles are addressed by their index within the packed mips, and each one can come from a different heap
+            for (uint32_t i = 0; i < uint32_t(tex->packedMipHeapTiles.size()); ++i)
+            {
+                uint32_t heapTile = tex->packedMipHeapTiles[i];
+
+                TiledTextureCoordinate coordinate;
+                coordinate.mipLevel = uint16_t(tex->packedMips.numStandardMips);
+                coordinate.x = i;
+                TiledTextureRegion region;
+                region.tilesNum = 1;
+
+                TextureTilesMapping mapping;
+                mapping.tiledTextureCoordinates = &coordinate;
+                mapping.tiledTextureRegions = &region;
+                uint64_t byteOffset = uint64_t(heapTile % m_TilesPerHeap) * c_TileSizeInBytes;
+                mapping.byteOffsets = &byteOffset;
+                mapping.numTextureRegions = 1;
+                mapping.heap = m_Heaps[heapTile / m_TilesPerHeap];
+                m_Device->updateTextureTileMappings(texture, &mapping, 1, m_Desc.queue);
+            }
+        }
+
+        m_NumResidentTiles += uint32_t(tex->packedMipHeapTiles.size());
+
+        // Reuse the slots of removed textures to keep the IDs stable and the table compact
+        auto slot = std::find(m_Textures.begin(), m_Textures.end(), nullptr);
+        if (slot != m_Textures.end())
+        {
+            *slot = std::move(tex);
+            return uint32_t(slot - m_Textures.begin());
+        }
+
+        m_Textures.push_back(std::move(tex));
+        return uint32_t(m_Textures.size() - 1);
+    }
+
+    void SparseTextureStreamer::removeTexture(uint32_t textureID)
+    {
+        if (textureID >= m_Textures.size() || !m_Textures[textureID])
+            return;
+
+        Texture& texture = *m_Textures[textureID];
+
+        for (uint32_t tileIndex = 0; tileIndex < uint32_t(texture.tiles.size()); ++tileIndex)
+        {
+            Tile& tile = texture.tiles[tileIndex];
+            if (tile.heapTile == c_NoHeapTile)
+                continue;
+
+            m_FreeHeapTiles.push_back(tile.heapTile);
+            tile.heapTile = c_NoHeapTile;
+            texture.tilesToUnmap.push_back(tileIndex);
+            --m_NumResidentTiles;
+        }
+
+        texture.tilesToMap.clear();
+        applyMappings(texture);
+
+        if (!texture.packedMipHeapTiles.empty())
+        {
+            TiledTextureCoordinate coordinate;
+            coordinate.mipLevel = uint16_t(texture.packedMips.numStandardMips);
+            TiledTextureRegion region;
+            region.tilesNum = texture.packedMips.numTilesForPackedMips;
+
+            TextureTilesMapping mapping;
+            mapping.tiledTextureCoordinates = &coordinate;
+            mapping.tiledTextureRegions = &region;
+            mapping.numTextureRegions = 1;
+            m_Device->updateTextureTileMappings(texture.texture, &mapping, 1, m_Desc.queue);
+
+            m_FreeHeapTiles.insert(m_FreeHeapTiles.end(), texture.packedMipHeapTiles.begin(), texture.packedMipHeapTiles.end());
+            m_NumResidentTiles -= uint32_t(texture.packedMipHeapTiles.size());
+        }
+
+        m_Textures[textureID] = nullptr;
+    }
+
+    ITexture* SparseTextureStreamer::getResidencyTexture(uint32_t textureID) const
+    {
+        if (textureID >= m_Textures.size() || !m_Textures[textureID])
+            return nullptr;
+
+        return m_Textures[textureID]->residencyTexture;
+    }
+
+    bool SparseTextureStreamer::allocateHeapTile(uint32_t& outHeapTile, bool allowEviction)
+    {
+        if (!m_FreeHeapTiles.empty())
+        {
+            outHeapTile = m_FreeHeapTiles.back();
+            m_FreeHeapTiles.pop_back();
+            return true;
+        }
+
+        if (uint64_t(m_Heaps.size() + 1) * m_Desc.heapSize <= m_Desc.memoryBudget)
+        {
+            HeapDesc heapDesc;
+            heapDesc.setCapacity(m_Desc.heapSize)
+                .setType(HeapType::DeviceLocal)
+                .setDebugName(m_Desc.debugName + " heap");
+
+            HeapHandle heap = m_Device->createHeap(heapDesc);
+            if (heap)
+            {
+                uint32_t firstTile = uint32_t(m_Heaps.size()) * m_TilesPerHeap;
+                m_Heaps.push_back(heap);
+
+                // Push in reverse so that the tiles are allocated from the start of the heap
+                for (uint32_t i = m_TilesPerHeap; i > 1; --i)
+                    m_FreeHeapTiles.push_back(firstTile + i - 1);
+
+                outHeapTile = firstTile;
+                return true;
+            }
+        }
+
+        if (!allowEviction)
+            return false;
+
+        while (m_NextEvictionCandidate < m_EvictionCandidates.size())
+        {
+            const TileRef& candidate = m_EvictionCandidates[m_NextEvictionCandidate++];
+
+            Texture& texture = *m_Textures[candidate.textureID];
+            Tile& tile = texture.tiles[candidate.tileIndex];
+            if (tile.heapTile == c_NoHeapTile)
+                continue;
+
+            outHeapTile = tile.heapTile;
+            tile.heapTile = c_NoHeapTile;
+            texture.tilesToUnmap.push_back(candidate.tileIndex);
+            texture.residencyDirty = true;
+            --m_NumResidentTiles;
+            return true;
+        }
+
+        return false;
+    }
+
+    void SparseTextureStreamer::processFeedback(uint32_t textureID, Texture& texture)
+    {
+        const uint8_t* data = static_cast<const uint8_t*>(texture.pendingFeedback->getData());
+        assert(data);
+
+        const uint32_t numStandardMips = texture.packedMips.numStandardMips;
+
+        for (uint32_t ry = 0; ry < texture.feedbackHeight; ++ry)
+        {
+            const uint8_t* row = data + size_t(ry) * texture.feedbackRowPitch;
+
+            for (uint32_t rx = 0; rx < texture.feedbackWidth; ++rx)
+            {
+                uint32_t minMip = row[rx];
+                if (minMip == c_FeedbackNotSampled)
+                    continue;
+
+                // Sampling at mip M can also touch the coarser mips through trilinear filtering,
+                // and the residency map requires the coarser mips to be resident anyway
+                for (uint32_t mipLevel = minMip; mipLevel < numStandardMips; ++mipLevel)
+                {
+                    const SubresourceTiling& tiling = texture.mipTilings[mipLevel];
+
+                    uint32_t x0 = ((rx * texture.mipRegionWidth) >> mipLevel) / texture.tileShape.widthInTexels;
+                    uint32_t y0 = ((ry * texture.mipRegionHeight) >> mipLevel) / texture.tileShape.heightInTexels;
+                    uint32_t x1 = (((rx + 1) * texture.mipRegionWidth - 1) >> mipLevel) / texture.tileShape.widthInTexels;
+                    uint32_t y1 = (((ry + 1) * texture.mipRegionHeight - 1) >> mipLevel) / texture.tileShape.heightInTexels;
+                    x1 = std::min(x1, tiling.widthInTiles - 1);
+                    y1 = std::min(y1, tiling.heightInTiles - 1);
+
+                    for (uint32_t y = y0; y <= y1; ++y)
+                    {
+                        for (uint32_t x = x0; x <= x1; ++x)
+                        {
+                            uint32_t tileIndex = texture.mipFirstTile[mipLevel] + y * tiling.widthInTiles + x;
+                            Tile& tile = texture.tiles[tileIndex];
+
+                            if (tile.lastRequestedFrame == m_Frame)
+                                continue;
+
+                            tile.lastRequestedFrame = m_Frame;
+
+                            if (tile.heapTile == c_NoHeapTile)
+                                m_RequestedTiles.push_back({ textureID, tileIndex, mipLevel, m_Frame });
+                        }
+                    }
+                }
+            }
+        }
+
+        texture.lastFeedbackFrame = m_Frame;
+    }
+
+    void SparseTextureStreamer::collectEvictionCandidates()
+    {
+        m_EvictionCandidates.clear();
+        m_NextEvictionCandidate = 0;
+
+        for (uint32_t textureID = 0; textureID < uint32_t(m_Textures.size()); ++textureID)
+        {
+            const Texture* texture = m_Textures[textureID].get();
+            if (!texture || texture->lastFeedbackFrame == 0)
+                continue;
+
+            for (uint32_t tileIndex = 0; tileIndex < uint32_t(texture->tiles.size()); ++tileIndex)
+            {
+                const Tile& tile = texture->tiles[tileIndex];
+
+                if (tile.heapTile != c_NoHeapTile &&
+                    tile.lastRequestedFrame < texture->lastFeedbackFrame &&
+                    tile.lastRequestedFrame + m_Desc.minFramesBeforeEviction <= m_Frame)
+                {
+                    m_EvictionCandidates.push_back({ textureID, tileIndex, tile.mipLevel, tile.lastRequestedFrame });
+                }
+            }
+        }
+
+        // Least recently requested first, and the finest mips first among the tiles requested at the same time,
+        // because they are the cheapest to reload and the coarser mips keep the regions sampleable
+        std::sort(m_EvictionCandidates.begin(), m_EvictionCandidates.end(), [](const TileRef& a, const TileRef& b)
+        {
+            if (a.lastRequestedFrame != b.lastRequestedFrame)
+                return a.lastRequestedFrame < b.lastRequestedFrame;
+            return a.mipLevel < b.mipLevel;
+        });
+    }
+
+    void SparseTextureStreamer::applyMappings(Texture& texture)
+    {
+        if (texture.tilesToMap.empty() && texture.tilesToUnmap.empty())
+            return;
+
+        // Group the new mappings by heap, one TextureTilesMapping per heap, plus one without a heap for the unmapped tiles
+        std::sort(texture.tilesToMap.begin(), texture.tilesToMap.end(), [&texture](uint32_t a, uint32_t b)
+        {
+            return texture.tiles[a].heapTile < texture.tiles[b].heapTile;
+        });
+
+        const size_t numRegions = texture.tilesToMap.size() + texture.tilesToUnmap.size();
+        std::vector<TiledTextureCoordinate> coordinates;
+        std::vector<TiledTextureRegion> regions(numRegions);
+        std::vector<uint64_t> byteOffsets;
+        std::vector<TextureTilesMapping> mappings;
+        coordinates.reserve(numRegions);
+        byteOffsets.reserve(numRegions);
+
+        auto addCoordinate = [&texture, &coordinates](uint32_t tileIndex)
+        {
+            const Tile& tile = texture.tiles[tileIndex];
+            TiledTextureCoordinate coordinate;
+            coordinate.mipLevel = uint16_t(tile.mipLevel);
+            coordinate.x = tile.x;
+            coordinate.y = tile.y;
+            coordinates.push_back(coordinate);
+        };
+
+        for (auto& region : regions)
+            region.tilesNum = 1;
+
+        if (!texture.tilesToUnmap.empty())
+        {
+            TextureTilesMapping mapping;
+            mapping.tiledTextureCoordinates = coordinates.data();
+            mapping.tiledTextureRegions = regions.data();
+            mapping.numTextureRegions = uint32_t(texture.tilesToUnmap.size());
+
+            for (uint32_t tileIndex : texture.tilesToUnmap)
+            {
+                addCoordinate(tileIndex);
+                byteOffsets.push_back(0);
+            }
+
+            mappings.push_back(mapping);
+        }
+
+        for (uint32_t tileIndex : texture.tilesToMap)
+        {
+            uint32_t heapTile = texture.tiles[tileIndex].heapTile;
+            IHeap* heap = m_Heaps[heapTile / m_TilesPerHeap];
+
+            if (mappings.empty() || mappings.back().heap != heap)
+            {
+                TextureTilesMapping mapping;
+                mapping.tiledTextureCoordinates = coordinates.data() + coordinates.size();
+                mapping.tiledTextureRegions = regions.data() + coordinates.size();
+                mapping.byteOffsets = byteOffsets.data() + coordinates.size();
+                mapping.heap = heap;
+                mappings.push_back(mapping);
+            }
+
+            addCoordinate(tileIndex);
+            byteOffsets.push_back(uint64_t(heapTile % m_TilesPerHeap) * c_TileSizeInBytes);
+            ++mappings.back().numTextureRegions;
+        }
+
+        m_Device->updateTextureTileMappings(texture.texture, mappings.data(), uint32_t(mappings.size()), m_Desc.queue);
+
+        texture.tilesToUnmap.clear();
+    }
+
+    void SparseTextureStreamer::updateResidencyData(Texture& texture)
+    {
+        const uint32_t numStandardMips = texture.packedMips.numStandardMips;
+        if (numStandardMips == 0)
+        {
+            texture.residencyData[0] = 0;
+            return;
+        }
+
+        const SubresourceTiling& baseTiling = texture.mipTilings[0];
+
+        for (uint32_t y = 0; y < baseTiling.heightInTiles; ++y)
+        {
+            for (uint32_t x = 0; x < baseTiling.widthInTiles; ++x)
+            {
+                // Walk from the coarsest standard mip towards mip 0 and stop at the first missing tile,
+                // so that every mip at or above the stored one is resident
+                uint32_t residentMip = numStandardMips;
+                while (residentMip > 0)
+                {
+                    uint32_t mipLevel = residentMip - 1;
+                    const SubresourceTiling& tiling = texture.mipTilings[mipLevel];
+                    uint32_t tileX = std::min(x >> mipLevel, tiling.widthInTiles - 1);
+                    uint32_t tileY = std::min(y >> mipLevel, tiling.heightInTiles - 1);
+                    const Tile& tile = texture.tiles[texture.mipFirstTile[mipLevel] + tileY * tiling.widthInTiles + tileX];
+
+                    if (tile.heapTile == c_NoHeapTile)
+                        break;
+
+                    residentMip = mipLevel;
+                }
+
+                texture.residencyData[size_t(y) * baseTiling.widthInTiles + x] = uint8_t(residentMip);
+            }
+        }
+    }
+
+    void SparseTextureStreamer::recordFeedbackDecode(ICommandList* commandList, Texture& texture)
+    {
+        // The contents of a new feedback texture are undefined, so the first update only clears it
+        if (texture.feedbackCleared)
+        {
+            commandList->decodeSamplerFeedbackTexture(texture.decodeBuffer, texture.feedback, Format::R8_UINT);
+            texture.pendingFeedback = commandList->readbackBuffer(texture.decodeBuffer, 0, texture.decodeBuffer->getDesc().byteSize);
+
+            // Keep accumulating the feedback if the readback memory is exhausted, and try again on the next update
+            if (!texture.pendingFeedback)
+                return;
+        }
+
+        commandList->clearSamplerFeedbackTexture(texture.feedback);
+        texture.feedbackCleared = true;
+    }
+
+    uint32_t SparseTextureStreamer::update(ICommandList* commandList)
+    {
+        if (!m_Valid)
+            return 0;
+
+        assert(commandList);
+
+        ++m_Frame;
+        m_RequestedTiles.clear();
+
+        for (uint32_t textureID = 0; textureID < uint32_t(m_Textures.size()); ++textureID)
+        {
+            Texture* texture = m_Textures[textureID].get();
+            if (!texture || !texture->pendingFeedback || !texture->pendingFeedback->isReady())
+                continue;
+
+            processFeedback(textureID, *texture);
+            texture->pendingFeedback = nullptr;
+        }
+
+        // Map the coarsest mips first: they cover the largest areas, and the finer mips
+        // only become visible through the residency texture when the coarser ones are resident
+        std::sort(m_RequestedTiles.begin(), m_RequestedTiles.end(), [](const TileRef& a, const TileRef& b)
+        {
+            if (a.mipLevel != b.mipLevel)
+                return a.mipLevel > b.mipLevel;
+            if (a.textureID != b.textureID)
+                return a.textureID < b.textureID;
+            return a.tileIndex < b.tileIndex;
+        });
+
+        if (m_RequestedTiles.size() > m_Desc.maxTilesMappedPerUpdate)
+            m_RequestedTiles.resize(m_Desc.maxTilesMappedPerUpdate);
+
+        if (!m_RequestedTiles.empty())
+            collectEvictionCandidates();
+
+        uint32_t numMappedTiles = 0;
+        for (const TileRef& request : m_RequestedTiles)
+        {
+            uint32_t heapTile;
+            if (!allocateHeapTile(heapTile, true))
+                break;
+
+            Texture& texture = *m_Textures[request.textureID];
+            texture.tiles[request.tileIndex].heapTile = heapTile;
+            texture.tilesToMap.push_back(request.tileIndex);
+            texture.residencyDirty = true;
+            ++m_NumResidentTiles;
+            ++numMappedTiles;
+        }
+
+        m_EvictionCandidates.clear();
+        m_NextEvictionCandidate = 0;
+
+        for (const auto& texturePtr : m_Textures)
+        {
+            if (!texturePtr)
+                continue;
+
+            Texture& texture = *texturePtr;
+
+            applyMappings(texture);
+
+            if (!texture.packedMipsLoaded)
+            {
+                for (uint32_t i = 0; i < texture.packedMips.numPackedMips; ++i)
+                {
+                    TextureSlice slice;
+                    slice.setMipLevel(texture.packedMips.numStandardMips + i);
+                    texture.loadCallback(commandList, texture.texture, slice.resolve(texture.texture->getDesc()));
+                }
+                texture.packedMipsLoaded = true;
+            }
+
+            const TextureDesc& textureDesc = texture.texture->getDesc();
+            for (uint32_t tileIndex : texture.tilesToMap)
+            {
+                const Tile& tile = texture.tiles[tileIndex];
+                uint32_t mipWidth = std::max(textureDesc.width >> tile.mipLevel, 1u);
+                uint32_t mipHeight = std::max(textureDesc.height >> tile.mipLevel, 1u);
+
+                TextureSlice slice;
+                slice.setMipLevel(tile.mipLevel)
+                    .setOrigin(tile.x * texture.tileShape.widthInTexels, tile.y * texture.tileShape.heightInTexels)
+                    .setDepth(1);
+                slice.setWidth(std::min(texture.tileShape.widthInTexels, mipWidth - slice.x));
+                slice.setHeight(std::min(texture.tileShape.heightInTexels, mipHeight - slice.y));
+                texture.loadCallback(commandList, texture.texture, slice);
+            }
+            texture.tilesToMap.clear();
+
+            if (texture.residencyDirty)
+            {
+                updateResidencyData(texture);
+                const TextureDesc& residencyDesc = texture.residencyTexture->getDesc();
+                commandList->writeTexture(texture.residencyTexture, 0, 0, texture.residencyData.data(), residencyDesc.width);
+                texture.residencyDirty = false;
+            }
+
+            if (!texture.pendingFeedback)
+                recordFeedbackDecode(commandList, texture);
+        }
+
+        return numMappedTiles;
+    }
+}
@@ -24,10 +24,119 @@
 
 #include <nvrhi/utils.h>
 
+#include <algorithm>
+#include <mutex>
 #include <sstream>
 
 namespace nvrhi
 {
+    namespace
+    {
+        class StateTrackingSlotAllocator
+        {
+        public:
+            uint32_t allocate()
+            {
+                std::lock_guard lockGuard(m_Mutex);
+
+                if (m_FreeSlots.empty())
+                    return m_NextSlot++;
+
+                uint32_t slot = m_FreeSlots.back();
+                m_FreeSlots.pop_back();
+                return slot;
+            }
+
+            void release(uint32_t slot)
+            {
+                std::lock_guard lockGuard(m_Mutex);
+
+                m_FreeSlots.push_back(slot);
+            }
+
+        private:
+            std::mutex m_Mutex;
+            std::vector<uint32_t> m_FreeSlots;
+            uint32_t m_NextSlot = 0;
+        };
+
+        // Leaked intentionally: resources may be destroyed during static destruction
+        StateTrackingSlotAllocator& getSlotAllocator(bool texture)
+        {
+            static StateTrackingSlotAllocator* allocators = new StateTrackingSlotAllocator[2];
+            return allocators[texture ? 1 : 0];
+        }
+    }
+
+    uint32_t allocateStateTrackingSlot(bool texture)
+    {
+        return getSlotAllocator(texture).allocate();
+    }
+
+    void releaseStateTrackingSlot(bool texture, uint32_t slot)
+    {
+        getSlotAllocator(texture).release(slot);
+    }
+
+    bool isWriteState(ResourceStates state)
+    {
+        const ResourceStates writeStates = ResourceStates::UnorderedAccess
+            | ResourceStates::RenderTarget
+            | ResourceStates::DepthWrite
+            | ResourceStates::StreamOut
+            | ResourceStates::CopyDest
+            | ResourceStates::ResolveDest
+            | ResourceStates::AccelStructWrite
+            | ResourceStates::OpacityMicromapWrite
+            | ResourceStates::ConvertCoopVecMatrixOutput;
+
+        return (state & writeStates) != 0;
+    }
+
+    void QueueDependencies::addWait(CommandQueue queue, uint64_t instance, const std::string& reason)
+    {
+        if (instance > waitInstances[size_t(queue)])
+        {
+            waitInstances[size_t(queue)] = instance;
+            waitReasons[size_t(queue)] = &reason;
+        }
+    }
+
+    bool QueueDependencies::anyWaits() const
+    {
+        for (uint64_t instance : waitInstances)
+        {
+            if (instance != 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    void QueueDependencies::clear()
+    {
+        waitInstances.fill(0);
+        waitReasons.fill(nullptr);
+        textureTransfers.clear();
+        bufferTransfers.clear();
+    }
+
+    void reportQueueDependencies(const QueueDependencies& dependencies, CommandQueue executionQueue, IMessageCallback* messageCallback)
+    {
+        for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+        {
+            if (dependencies.waitInstances[queue] == 0)
+                continue;
+
+            std::stringstream ss;
+            ss << "Automatic queue sync: " << utils::CommandQueueToString(executionQueue) << " queue waits for "
+                << utils::CommandQueueToString(CommandQueue(queue)) << " queue instance " << dependencies.waitInstances[queue];
+            if (dependencies.waitReasons[queue])
+                ss << ", required by " << utils::DebugNameToString(*dependencies.waitReasons[queue]);
+            messageCallback->message(MessageSeverity::Info, ss.str().c_str());
+        }
+    }
+
     bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback)
     {
         if ((permanentState & requiredState) != requiredState)
@@ -161,6 +270,14 @@ namespace nvrhi
     }
     
     void CommandListResourceStateTracker::requireTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state)
+    {
+        const size_t numBarriers = m_TextureBarriers.size();
+        requireTextureStateInternal(texture, subresources, state);
+        if (m_TextureBarriers.size() == numBarriers)
+            ++m_ElidedBarrierCount;
+    }
+
+    void CommandListResourceStateTracker::requireTextureStateInternal(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state)
     {
         if (texture->permanentState != 0)
         {
@@ -172,6 +289,11 @@ namespace nvrhi
 
         TextureState* tracking = getTextureStateTracking(texture, true);
 
+        endSplitTransition(texture, tracking);
+
+        if (isWriteState(state))
+            tracking->written = true;
+
         if (tracking->subresourceStates.empty() && tracking->state == ResourceStates::Unknown)
         {
             std::stringstream ss;
@@ -189,7 +311,10 @@ namespace nvrhi
             bool uavNecessary = ((state & ResourceStates::UnorderedAccess) != 0)
                 && (tracking->enableUavBarriers || !tracking->firstUavBarrierPlaced);
 
-            if (transitionNecessary || uavNecessary)
+            // One UAV barrier per batch is enough
+            const bool uavBarrierPending = uavNecessary && !transitionNecessary && isUavBarrierPending(texture);
+
+            if ((transitionNecessary || uavNecessary) && !uavBarrierPending)
             {
                 TextureBarrier barrier;
                 barrier.texture = texture;
@@ -219,7 +344,7 @@ namespace nvrhi
                 stateExpanded = true;
             }
             
-            bool anyUavBarrier = false;
+            bool anyUavBarrier = isUavBarrierPending(texture);
 
             for (ArraySlice arraySlice = subresources.baseArraySlice; arraySlice < subresources.baseArraySlice + subresources.numArraySlices; arraySlice++)
             {
@@ -245,14 +370,7 @@ namespace nvrhi
 
                     if (transitionNecessary || uavNecessary)
                     {
-                        TextureBarrier barrier;
-                        barrier.texture = texture;
-                        barrier.entireTexture = false;
-                        barrier.mipLevel = mipLevel;
-                        barrier.arraySlice = arraySlice;
-                        barrier.stateBefore = priorState;
-                        barrier.stateAfter = state;
-                        m_TextureBarriers.push_back(barrier);
+                        addSubresourceBarrier(texture, mipLevel, arraySlice, priorState, state);
                     }
 
                     tracking->subresourceStates[subresourceIndex] = state;
@@ -263,11 +381,229 @@ namespace nvrhi
                         tracking->firstUavBarrierPlaced = true;
                     }
                 }
+
+                mergeLastTextureBarriers();
+            }
+
+            // Go back to whole-texture tracking when all subresources end up in the same state,
+            // so that the next transitions of this texture are single barriers again
+            bool uniformState = true;
+            for (ResourceStates subresourceState : tracking->subresourceStates)
+            {
+                if (subresourceState != state)
+                {
+                    uniformState = false;
+                    break;
+                }
+            }
+
+            if (uniformState)
+            {
+                tracking->subresourceStates.clear();
+                tracking->state = state;
+            }
+        }
+    }
+
+    void CommandListResourceStateTracker::addSubresourceBarrier(TextureStateExtension* texture, MipLevel mipLevel, ArraySlice arraySlice,
+        ResourceStates stateBefore, ResourceStates stateAfter)
+    {
+        if (!m_TextureBarriers.empty())
+        {
+            // Extend the previous barrier if it's the same transition on the previous mip level of the same array slice
+            TextureBarrier& last = m_TextureBarriers.back();
+            if (last.texture == texture && !last.entireTexture && last.split == SplitBarrier::None &&
+                last.stateBefore == stateBefore && last.stateAfter == stateAfter &&
+                last.arraySlice == arraySlice && last.numArraySlices == 1 &&
+                last.mipLevel + last.numMipLevels == mipLevel)
+            {
+                last.numMipLevels++;
+                return;
+            }
+        }
+
+        TextureBarrier barrier;
+        barrier.texture = texture;
+        barrier.entireTexture = false;
+        barrier.mipLevel = mipLevel;
+        barrier.arraySlice = arraySlice;
+        barrier.stateBefore = stateBefore;
+        barrier.stateAfter = stateAfter;
+        m_TextureBarriers.push_back(barrier);
+    }
+
+    void CommandListResourceStateTracker::mergeLastTextureBarriers()
+    {
+        if (m_TextureBarriers.empty())
+            return;
+
+        // Combine the last barrier with the previous one if they cover the same mip levels of adjacent array slices
+        if (m_TextureBarriers.size() >= 2)
+        {
+            const TextureBarrier& last = m_TextureBarriers[m_TextureBarriers.size() - 1];
+            TextureBarrier& prev = m_TextureBarriers[m_TextureBarriers.size() - 2];
+
+            if (prev.texture == last.texture && !prev.entireTexture && !last.entireTexture &&
+                prev.split == SplitBarrier::None && last.split == SplitBarrier::None &&
+                prev.stateBefore == last.stateBefore && prev.stateAfter == last.stateAfter &&
+                prev.mipLevel == last.mipLevel && prev.numMipLevels == last.numMipLevels &&
+                prev.arraySlice + prev.numArraySlices == last.arraySlice)
+            {
+                prev.numArraySlices += last.numArraySlices;
+                m_TextureBarriers.pop_back();
+            }
+        }
+
+        TextureBarrier& last = m_TextureBarriers.back();
+        const TextureDesc& desc = last.texture->descRef;
+        if (!last.entireTexture && last.mipLevel == 0 && last.numMipLevels == desc.mipLevels &&
+            last.arraySlice == 0 && last.numArraySlices == desc.arraySize)
+        {
+            last.entireTexture = true;
+        }
+    }
+
+    bool CommandListResourceStateTracker::isUavBarrierPending(const TextureStateExtension* texture) const
+    {
+        for (const TextureBarrier& barrier : m_TextureBarriers)
+        {
+            if (barrier.texture == texture && barrier.entireTexture && barrier.split == SplitBarrier::None &&
+                barrier.stateBefore == barrier.stateAfter && (barrier.stateAfter & ResourceStates::UnorderedAccess) != 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    bool CommandListResourceStateTracker::isUavBarrierPending(const BufferStateExtension* buffer) const
+    {
+        // Any barrier on the buffer synchronizes the UAV accesses before it
+        for (const BufferBarrier& barrier : m_BufferBarriers)
+        {
+            if (barrier.buffer == buffer && barrier.split == SplitBarrier::None)
+                return true;
+        }
+
+        return false;
+    }
+
+    void CommandListResourceStateTracker::beginTextureStateTransition(TextureStateExtension* texture, ResourceStates state)
+    {
+        if (texture->permanentState != 0)
+            return;
+
+        TextureState* tracking = getTextureStateTracking(texture, true);
+
+        endSplitTransition(texture, tracking);
+
+        // Split transitions of individual subresources are not supported, those are transitioned at the point of use
+        if (!tracking->subresourceStates.empty() || tracking->state == ResourceStates::Unknown || tracking->state == state)
+            return;
+
+        TextureBarrier barrier;
+        barrier.texture = texture;
+        barrier.entireTexture = true;
+        barrier.split = SplitBarrier::Begin;
+        barrier.stateBefore = tracking->state;
+        barrier.stateAfter = state;
+        m_TextureBarriers.push_back(barrier);
+
+        tracking->splitTransitionState = state;
+    }
+
+    void CommandListResourceStateTracker::beginBufferStateTransition(BufferStateExtension* buffer, ResourceStates state)
+    {
+        if (buffer->descRef.isVolatile || buffer->permanentState != 0 || buffer->descRef.cpuAccess != CpuAccessMode::None)
+            return;
+
+        BufferState* tracking = getBufferStateTracking(buffer, true);
+
+        endSplitTransition(buffer, tracking);
+
+        if (tracking->state == ResourceStates::Unknown || tracking->state == state)
+            return;
+
+        BufferBarrier barrier;
+        barrier.buffer = buffer;
+        barrier.split = SplitBarrier::Begin;
+        barrier.stateBefore = tracking->state;
+        barrier.stateAfter = state;
+        m_BufferBarriers.push_back(barrier);
+
+        tracking->splitTransitionState = state;
+    }
+
+    void CommandListResourceStateTracker::endSplitTransition(TextureStateExtension* texture, TextureState* tracking)
+    {
+        if (tracking->splitTransitionState == ResourceStates::Unknown)
+            return;
+
+        bool beginPending = false;
+        for (TextureBarrier& barrier : m_TextureBarriers)
+        {
+            if (barrier.texture == texture && barrier.split == SplitBarrier::Begin)
+            {
+                // Nothing was recorded between the begin and the end, use a regular barrier
+                barrier.split = SplitBarrier::None;
+                beginPending = true;
+                break;
+            }
+        }
+
+        if (!beginPending)
+        {
+            TextureBarrier barrier;
+            barrier.texture = texture;
+            barrier.entireTexture = true;
+            barrier.split = SplitBarrier::End;
+            barrier.stateBefore = tracking->state;
+            barrier.stateAfter = tracking->splitTransitionState;
+            m_TextureBarriers.push_back(barrier);
+        }
+
+        tracking->state = tracking->splitTransitionState;
+        tracking->splitTransitionState = ResourceStates::Unknown;
+    }
+
+    void CommandListResourceStateTracker::endSplitTransition(BufferStateExtension* buffer, BufferState* tracking)
+    {
+        if (tracking->splitTransitionState == ResourceStates::Unknown)
+            return;
+
+        bool beginPending = false;
+        for (BufferBarrier& barrier : m_BufferBarriers)
+        {
+            if (barrier.buffer == buffer && barrier.split == SplitBarrier::Begin)
+            {
+                barrier.split = SplitBarrier::None;
+                beginPending = true;
+                break;
             }
         }
+
+        if (!beginPending)
+        {
+            BufferBarrier barrier;
+            barrier.buffer = buffer;
+            barrier.split = SplitBarrier::End;
+            barrier.stateBefore = tracking->state;
+            barrier.stateAfter = tracking->splitTransitionState;
+            m_BufferBarriers.push_back(barrier);
+        }
+
+        tracking->state = tracking->splitTransitionState;
+        tracking->splitTransitionState = ResourceStates::Unknown;
     }
 
     void CommandListResourceStateTracker::requireBufferState(BufferStateExtension* buffer, ResourceStates state)
+    {
+        const size_t numBarriers = m_BufferBarriers.size();
+        requireBufferStateInternal(buffer, state);
+        if (m_BufferBarriers.size() == numBarriers)
+            ++m_ElidedBarrierCount;
+    }
+
+    void CommandListResourceStateTracker::requireBufferStateInternal(BufferStateExtension* buffer, ResourceStates state)
     {
         if (buffer->descRef.isVolatile)
             return;
@@ -287,6 +623,11 @@ namespace nvrhi
 
         BufferState* tracking = getBufferStateTracking(buffer, true);
 
+        endSplitTransition(buffer, tracking);
+
+        if (isWriteState(state))
+            tracking->written = true;
+
         if (tracking->state == ResourceStates::Unknown)
         {
             std::stringstream ss;
@@ -307,7 +648,7 @@ namespace nvrhi
             // Example: same buffer used as index and vertex buffer, or as SRV and indirect arguments.
             for (BufferBarrier& barrier : m_BufferBarriers)
             {
-                if (barrier.buffer == buffer)
+                if (barrier.buffer == buffer && barrier.split == SplitBarrier::None)
                 {
                     barrier.stateAfter = ResourceStates(barrier.stateAfter | state);
                     tracking->state = barrier.stateAfter;
@@ -316,7 +657,10 @@ namespace nvrhi
             }
         }
 
-        if (transitionNecessary || uavNecessary)
+        // One UAV barrier per batch is enough
+        const bool uavBarrierPending = uavNecessary && !transitionNecessary && isUavBarrierPending(buffer);
+
+        if ((transitionNecessary || uavNecessary) && !uavBarrierPending)
         {
             BufferBarrier barrier;
             barrier.buffer = buffer;
@@ -335,12 +679,17 @@ namespace nvrhi
 
     void CommandListResourceStateTracker::keepBufferInitialStates()
     {
-        for (auto& [buffer, tracking] : m_BufferStates)
+        for (size_t index = 0; index < m_BufferStates.size(); index++)
         {
+            BufferStateExtension* buffer = m_BufferStates.getResource(index);
+
+            // Split transitions can't extend past the end of the command list
+            endSplitTransition(buffer, &m_BufferStates.getState(index));
+
             if (buffer->descRef.keepInitialState && 
                 !buffer->permanentState &&
                 !buffer->descRef.isVolatile &&
-                !tracking->permanentTransition)
+                !m_BufferStates.getState(index).permanentTransition)
             {
                 requireBufferState(buffer, buffer->descRef.initialState);
             }
@@ -349,11 +698,15 @@ namespace nvrhi
 
     void CommandListResourceStateTracker::keepTextureInitialStates()
     {
-        for (auto& [texture, tracking] : m_TextureStates)
+        for (size_t index = 0; index < m_TextureStates.size(); index++)
         {
+            TextureStateExtension* texture = m_TextureStates.getResource(index);
+
+            endSplitTransition(texture, &m_TextureStates.getState(index));
+
             if (texture->descRef.keepInitialState && 
                 !texture->permanentState && 
-                !tracking->permanentTransition)
+                !m_TextureStates.getState(index).permanentTransition)
             {
                 requireTextureState(texture, AllSubresources, texture->descRef.initialState);
             }
@@ -375,7 +728,6 @@ namespace nvrhi
 
             texture->permanentState = state;
         }
-        m_PermanentTextureStates.clear();
 
         for (auto [buffer, state] : m_PermanentBufferStates)
         {
@@ -390,38 +742,143 @@ namespace nvrhi
 
             buffer->permanentState = state;
         }
-        m_PermanentBufferStates.clear();
 
-        for (const auto& [texture, stateTracking] : m_TextureStates)
+        for (size_t index = 0; index < m_TextureStates.size(); index++)
         {
+            TextureStateExtension* texture = m_TextureStates.getResource(index);
+
             if (texture->descRef.keepInitialState && !texture->stateInitialized)
                 texture->stateInitialized = true;
         }
 
-        m_TextureStates.clear();
-        m_BufferStates.clear();
+        // A reusable command list applies the same permanent states on every submission
+        if (m_Reusable)
+            return;
+
+        m_PermanentTextureStates.clear();
+        m_PermanentBufferStates.clear();
+        m_TextureStates.reset();
+        m_BufferStates.reset();
+    }
+
+    // Adds the waits for one resource used by a submission on 'queue', returns true if the resource was last accessed on another queue
+    static bool collectResourceQueueDependencies(const QueueAccessHistory& history, bool written, const std::string& debugName,
+        CommandQueue queue, QueueDependencies& dependencies)
+    {
+        // Read after write, or write after write
+        if (history.lastWriteInstance != 0 && history.lastWriteQueue != queue)
+            dependencies.addWait(history.lastWriteQueue, history.lastWriteInstance, debugName);
+
+        // Write after read
+        if (written)
+        {
+            for (size_t otherQueue = 0; otherQueue < size_t(CommandQueue::Count); otherQueue++)
+            {
+                if (CommandQueue(otherQueue) != queue && history.lastAccessInstances[otherQueue] != 0)
+                    dependencies.addWait(CommandQueue(otherQueue), history.lastAccessInstances[otherQueue], debugName);
+            }
+        }
+
+        return history.lastQueue != CommandQueue::Count && history.lastQueue != queue;
     }
 
-    TextureState* CommandListResourceStateTracker::getTextureStateTracking(TextureStateExtension* texture, bool allowCreate)
+    void CommandListResourceStateTracker::collectQueueDependencies(CommandQueue queue, QueueDependencies& dependencies)
+    {
+        for (size_t index = 0; index < m_TextureStates.size(); index++)
+        {
+            TextureStateExtension* texture = m_TextureStates.getResource(index);
+            const QueueAccessHistory& history = texture->queueAccess;
+
+            if (collectResourceQueueDependencies(history, m_TextureStates.getState(index).written, texture->descRef.debugName, queue, dependencies))
+            {
+                auto transfer = std::make_pair(texture, history.lastQueue);
+                if (std::find(dependencies.textureTransfers.begin(), dependencies.textureTransfers.end(), transfer) == dependencies.textureTransfers.end())
+                    dependencies.textureTransfers.push_back(transfer);
+            }
+        }
+
+        for (size_t index = 0; index < m_BufferStates.size(); index++)
+        {
+            BufferStateExtension* buffer = m_BufferStates.getResource(index);
+            const QueueAccessHistory& history = buffer->queueAccess;
+
+            if (collectResourceQueueDependencies(history, m_BufferStates.getState(index).written, buffer->descRef.debugName, queue, dependencies))
+            {
+                auto transfer = std::make_pair(buffer, history.lastQueue);
+                if (std::find(dependencies.bufferTransfers.begin(), dependencies.bufferTransfers.end(), transfer) == dependencies.bufferTransfers.end())
+                    dependencies.bufferTransfers.push_back(transfer);
+            }
+        }
+    }
+
+    void CommandListResourceStateTracker::recordQueueAccesses(CommandQueue queue, uint64_t instance)
     {
-        auto it = m_TextureStates.find(texture);
+        for (size_t index = 0; index < m_TextureStates.size(); index++)
+        {
+            const TextureState& tracking = m_TextureStates.getState(index);
+            QueueAccessHistory& history = m_TextureStates.getResource(index)->queueAccess;
+
+            if (tracking.written)
+            {
+                history.lastWriteQueue = queue;
+                history.lastWriteInstance = instance;
+            }
 
-        if (it != m_TextureStates.end())
+            history.lastAccessInstances[size_t(queue)] = instance;
+            history.lastQueue = queue;
+            history.lastState = tracking.state;
+            history.lastSubresourceStates = tracking.subresourceStates;
+        }
+
+        for (size_t index = 0; index < m_BufferStates.size(); index++)
         {
-            return it->second.get();
+            const BufferState& tracking = m_BufferStates.getState(index);
+            QueueAccessHistory& history = m_BufferStates.getResource(index)->queueAccess;
+
+            if (tracking.written)
+            {
+                history.lastWriteQueue = queue;
+                history.lastWriteInstance = instance;
+            }
+
+            history.lastAccessInstances[size_t(queue)] = instance;
+            history.lastQueue = queue;
+            history.lastState = tracking.state;
         }
+    }
+
+    void CommandListResourceStateTracker::reset()
+    {
+        m_PermanentTextureStates.clear();
+        m_PermanentBufferStates.clear();
+        m_TexturesRequiringInitialState.clear();
+        m_TextureStates.reset();
+        m_BufferStates.reset();
+        discardBarriers();
+    }
+
+    TextureState* CommandListResourceStateTracker::getTextureStateTracking(TextureStateExtension* texture, bool allowCreate)
+    {
+        if (TextureState* tracking = m_TextureStates.find(texture))
+            return tracking;
 
         if (!allowCreate)
             return nullptr;
         
-        std::unique_ptr<TextureState> trackingRef = std::make_unique<TextureState>();
-
-        TextureState* tracking = trackingRef.get();
-        m_TextureStates.insert(std::make_pair(texture, std::move(trackingRef)));
+        TextureState* tracking = m_TextureStates.insert(texture);
         
         if (texture->descRef.keepInitialState)
         {
-            tracking->state = texture->stateInitialized ? texture->descRef.initialState : ResourceStates::Common;
+            if (m_Reusable && !texture->stateInitialized)
+            {
+                // The texture will be in its initial state by the time the command list is executed
+                m_TexturesRequiringInitialState.push_back(texture);
+                tracking->state = texture->descRef.initialState;
+            }
+            else
+            {
+                tracking->state = texture->stateInitialized ? texture->descRef.initialState : ResourceStates::Common;
+            }
         }
 
         return tracking;
@@ -429,21 +886,14 @@ namespace nvrhi
 
     BufferState* CommandListResourceStateTracker::getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate)
     {
-        auto it = m_BufferStates.find(buffer);
-
-        if (it != m_BufferStates.end())
-        {
-            return it->second.get();
-        }
+        if (BufferState* tracking = m_BufferStates.find(buffer))
+            return tracking;
 
         if (!allowCreate)
             return nullptr;
 
-        std::unique_ptr<BufferState> trackingRef = std::make_unique<BufferState>();
+        BufferState* tracking = m_BufferStates.insert(buffer);
 
-        BufferState* tracking = trackingRef.get();
-        m_BufferStates.insert(std::make_pair(buffer, std::move(trackingRef)));
-                                                   
         if (buffer->descRef.keepInitialState)
         {
             tracking->state = buffer->descRef.initialState;
@@ -23,19 +23,52 @@
 #pragma once
 
 #include <nvrhi/nvrhi.h>
+#include <array>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace nvrhi
 {
+    // Dense per-resource indices that command list state trackers use to find the tracking data of a resource
+    // without hashing. Separate index spaces are used for textures and buffers, and indices of destroyed
+    // resources are reused for new ones.
+    uint32_t allocateStateTrackingSlot(bool texture);
+    void releaseStateTrackingSlot(bool texture, uint32_t slot);
+
+    // Returns true if the state includes an access that writes the resource
+    bool isWriteState(ResourceStates state);
+
+    // Accesses of a resource by submitted command lists, used for automatic cross-queue synchronization.
+    // Instances are the values returned by IDevice::executeCommandLists, 0 means no access.
+    struct QueueAccessHistory
+    {
+        CommandQueue lastWriteQueue = CommandQueue::Graphics;
+        uint64_t lastWriteInstance = 0;
+        std::array<uint64_t, size_t(CommandQueue::Count)> lastAccessInstances{};
+
+        // Queue that accessed the resource last, and the state it was left in there
+        CommandQueue lastQueue = CommandQueue::Count;
+        ResourceStates lastState = ResourceStates::Unknown;
+        std::vector<ResourceStates> lastSubresourceStates;
+    };
+
     struct BufferStateExtension
     {
         const BufferDesc& descRef;
         ResourceStates permanentState = ResourceStates::Unknown;
+        QueueAccessHistory queueAccess;
+        const uint32_t trackingSlot;
 
         explicit BufferStateExtension(const BufferDesc& desc)
             : descRef(desc)
+            , trackingSlot(allocateStateTrackingSlot(false))
         { }
+
+        ~BufferStateExtension() { releaseStateTrackingSlot(false, trackingSlot); }
+
+        BufferStateExtension(const BufferStateExtension&) = delete;
+        BufferStateExtension& operator=(const BufferStateExtension&) = delete;
     };
 
     struct TextureStateExtension
@@ -44,35 +77,153 @@ namespace nvrhi
         ResourceStates permanentState = ResourceStates::Unknown;
         bool stateInitialized = false;
         bool isSamplerFeedback = false;
+        QueueAccessHistory queueAccess;
+        const uint32_t trackingSlot;
 
         explicit TextureStateExtension(const TextureDesc& desc)
             : descRef(desc)
+            , trackingSlot(allocateStateTrackingSlot(true))
         { }
+
+        ~TextureStateExtension() { releaseStateTrackingSlot(true, trackingSlot); }
+
+        TextureStateExtension(const TextureStateExtension&) = delete;
+        TextureStateExtension& operator=(const TextureStateExtension&) = delete;
     };
 
     struct TextureState
     {
         std::vector<ResourceStates> subresourceStates;
         ResourceStates state = ResourceStates::Unknown;
+        ResourceStates splitTransitionState = ResourceStates::Unknown; // target of a split transition that has begun
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
         bool permanentTransition = false;
+        bool written = false;
+
+        // Returns the object to its default state, keeping the subresource array allocation
+        void reset()
+        {
+            subresourceStates.clear();
+            state = ResourceStates::Unknown;
+            splitTransitionState = ResourceStates::Unknown;
+            enableUavBarriers = true;
+            firstUavBarrierPlaced = false;
+            permanentTransition = false;
+            written = false;
+        }
     };
 
     struct BufferState
     {
         ResourceStates state = ResourceStates::Unknown;
+        ResourceStates splitTransitionState = ResourceStates::Unknown; // target of a split transition that has begun
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
         bool permanentTransition = false;
+        bool written = false;
+
+        void reset() { *this = BufferState(); }
+    };
+
+    // Maps resources to their tracked states in one command list, using the resource tracking slots.
+    // The states are stored in a flat array in the order the resources were first seen, and the slot map
+    // is validated by a generation counter, so that reset() is O(1) and keeps all allocations for reuse.
+    template<typename TResource, typename TState>
+    class ResourceStateTable
+    {
+    public:
+        [[nodiscard]] TState* find(const TResource* resource)
+        {
+            const uint32_t page = resource->trackingSlot / c_PageSize;
+            if (page >= m_Pages.size() || !m_Pages[page])
+                return nullptr;
+
+            const SlotEntry& entry = m_Pages[page][resource->trackingSlot % c_PageSize];
+            if (entry.generation != m_Generation || m_Resources[entry.index] != resource)
+                return nullptr;
+
+            return &m_States[entry.index];
+        }
+
+        // Adds a resource that is not in the table yet, returns its state object with default values.
+        // Pointers returned by find() and insert() are invalidated by the next insert().
+        TState* insert(TResource* resource)
+        {
+            const uint32_t page = resource->trackingSlot / c_PageSize;
+            if (page >= m_Pages.size())
+                m_Pages.resize(page + 1);
+            if (!m_Pages[page])
+                m_Pages[page] = std::make_unique<SlotEntry[]>(c_PageSize);
+
+            SlotEntry& entry = m_Pages[page][resource->trackingSlot % c_PageSize];
+            entry.generation = m_Generation;
+            entry.index = uint32_t(m_NumEntries);
+
+            if (m_NumEntries == m_States.size())
+            {
+                m_States.emplace_back();
+                m_Resources.push_back(resource);
+            }
+            else
+            {
+                m_States[m_NumEntries].reset();
+                m_Resources[m_NumEntries] = resource;
+            }
+
+            return &m_States[m_NumEntries++];
+        }
+
+        void reset()
+        {
+            m_NumEntries = 0;
+
+            if (++m_Generation == 0)
+            {
+                // The generation counter wrapped around, old entries could match again
+                for (auto& page : m_Pages)
+                    page.reset();
+                m_Generation = 1;
+            }
+        }
+
+        [[nodiscard]] size_t size() const { return m_NumEntries; }
+        [[nodiscard]] TResource* getResource(size_t index) const { return m_Resources[index]; }
+        [[nodiscard]] TState& getState(size_t index) { return m_States[index]; }
+
+    private:
+        static constexpr uint32_t c_PageSize = 256;
+
+        struct SlotEntry
+        {
+            uint32_t generation = 0;
+            uint32_t index = 0;
+        };
+
+        std::vector<std::unique_ptr<SlotEntry[]>> m_Pages;
+        std::vector<TResource*> m_Resources;
+        std::vector<TState> m_States;
+        size_t m_NumEntries = 0;
+        uint32_t m_Generation = 1;
+    };
+
+    // Split barriers are recorded as a Begin and an End barrier with the same states, with other commands in between
+    enum class SplitBarrier : uint8_t
+    {
+        None,
+        Begin,
+        End
     };
 
     struct TextureBarrier
     {
         TextureStateExtension* texture = nullptr;
         MipLevel mipLevel = 0;
+        MipLevel numMipLevels = 1;
         ArraySlice arraySlice = 0;
+        ArraySlice numArraySlices = 1;
         bool entireTexture = false;
+        SplitBarrier split = SplitBarrier::None;
         ResourceStates stateBefore = ResourceStates::Unknown;
         ResourceStates stateAfter = ResourceStates::Unknown;
     };
@@ -80,10 +231,31 @@ namespace nvrhi
     struct BufferBarrier
     {
         BufferStateExtension* buffer = nullptr;
+        SplitBarrier split = SplitBarrier::None;
         ResourceStates stateBefore = ResourceStates::Unknown;
         ResourceStates stateAfter = ResourceStates::Unknown;
     };
 
+    // Synchronization that a submission needs with the other queues, see CommandListResourceStateTracker::collectQueueDependencies
+    struct QueueDependencies
+    {
+        // Instance on each queue that the submission must wait for, 0 if none
+        std::array<uint64_t, size_t(CommandQueue::Count)> waitInstances{};
+        // Name of a resource that caused each wait, for the report
+        std::array<const std::string*, size_t(CommandQueue::Count)> waitReasons{};
+
+        // Resources that were last accessed on a different queue, with that queue
+        std::vector<std::pair<TextureStateExtension*, CommandQueue>> textureTransfers;
+        std::vector<std::pair<BufferStateExtension*, CommandQueue>> bufferTransfers;
+
+        void addWait(CommandQueue queue, uint64_t instance, const std::string& reason);
+        [[nodiscard]] bool anyWaits() const;
+        void clear();
+    };
+
+    // Sends an Info message for every queue wait in the dependencies
+    void reportQueueDependencies(const QueueDependencies& dependencies, CommandQueue executionQueue, IMessageCallback* messageCallback);
+
     class CommandListResourceStateTracker
     {
     public:
@@ -105,6 +277,10 @@ namespace nvrhi
         ResourceStates getTextureSubresourceState(TextureStateExtension* texture, ArraySlice arraySlice, MipLevel mipLevel);
         ResourceStates getBufferState(BufferStateExtension* buffer);
 
+        // Start split transitions, which are completed on the next require*State call for the resource
+        void beginTextureStateTransition(TextureStateExtension* texture, ResourceStates state);
+        void beginBufferStateTransition(BufferStateExtension* buffer, ResourceStates state);
+
         // Internal interface
         
         void requireTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state);
@@ -114,15 +290,42 @@ namespace nvrhi
         void keepTextureInitialStates();
         void commandListSubmitted();
 
+        // Reusable command lists keep the tracked states and permanent state requests across submissions,
+        // and assume that keepInitialState textures are in their initial states on entry.
+        void setReusable(bool reusable) { m_Reusable = reusable; }
+        // Discards all tracked states before a reusable command list is recorded again
+        void reset();
+        // keepInitialState textures that had never been used when the recording started. They must be transitioned
+        // into their initial states before the first execution of the reusable command list.
+        [[nodiscard]] const std::vector<TextureStateExtension*>& getTexturesRequiringInitialState() const { return m_TexturesRequiringInitialState; }
+
+        // Automatic cross-queue synchronization. Before the command list is submitted to a queue, adds the
+        // submissions on other queues that it depends on; after the submission, records its accesses.
+        // Resources with permanent states, volatile and CPU-accessible buffers are not tracked.
+        void collectQueueDependencies(CommandQueue queue, QueueDependencies& dependencies);
+        void recordQueueAccesses(CommandQueue queue, uint64_t instance);
+
         [[nodiscard]] const std::vector<TextureBarrier>& getTextureBarriers() const { return m_TextureBarriers; }
         [[nodiscard]] const std::vector<BufferBarrier>& getBufferBarriers() const { return m_BufferBarriers; }
-        void clearBarriers() { m_TextureBarriers.clear(); m_BufferBarriers.clear(); }
+        // Called after the barriers have been recorded into the command list, counts them as issued
+        void clearBarriers()
+        {
+            m_IssuedBarrierCount += m_TextureBarriers.size() + m_BufferBarriers.size();
+            discardBarriers();
+        }
+        void discardBarriers() { m_TextureBarriers.clear(); m_BufferBarriers.clear(); }
+
+        // Barriers counted by clearBarriers, and require*State calls that added no barrier, for CommandListStats
+        [[nodiscard]] uint64_t getIssuedBarrierCount() const { return m_IssuedBarrierCount; }
+        [[nodiscard]] uint64_t getElidedBarrierCount() const { return m_ElidedBarrierCount; }
+        void resetBarrierCounts() { m_IssuedBarrierCount = 0; m_ElidedBarrierCount = 0; }
 
     private:
         IMessageCallback* m_MessageCallback;
+        bool m_Reusable = false;
 
-        std::unordered_map<TextureStateExtension*, std::unique_ptr<TextureState>> m_TextureStates;
-        std::unordered_map<BufferStateExtension*, std::unique_ptr<BufferState>> m_BufferStates;
+        ResourceStateTable<TextureStateExtension, TextureState> m_TextureStates;
+        ResourceStateTable<BufferStateExtension, BufferState> m_BufferStates;
 
         // Deferred transitions of textures and buffers to permanent states.
         // They are executed only when the command list is executed, not when the app calls setPermanentTextureState or setPermanentBufferState.
@@ -132,8 +335,23 @@ namespace nvrhi
         std::vector<TextureBarrier> m_TextureBarriers;
         std::vector<BufferBarrier> m_BufferBarriers;
 
+        std::vector<TextureStateExtension*> m_TexturesRequiringInitialState;
+
+        uint64_t m_IssuedBarrierCount = 0;
+        uint64_t m_ElidedBarrierCount = 0;
+
+        void requireTextureStateInternal(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state);
+        void requireBufferStateInternal(BufferStateExtension* buffer, ResourceStates state);
+
         TextureState* getTextureStateTracking(TextureStateExtension* texture, bool allowCreate);
         BufferState* getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate);
+
+        void endSplitTransition(TextureStateExtension* texture, TextureState* tracking);
+        void endSplitTransition(BufferStateExtension* buffer, BufferState* tracking);
+        void addSubresourceBarrier(TextureStateExtension* texture, MipLevel mipLevel, ArraySlice arraySlice, ResourceStates stateBefore, ResourceStates stateAfter);
+        void mergeLastTextureBarriers();
+        [[nodiscard]] bool isUavBarrierPending(const TextureStateExtension* texture) const;
+        [[nodiscard]] bool isUavBarrierPending(const BufferStateExtension* buffer) const;
     };
 
     bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback);
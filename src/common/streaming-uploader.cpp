@@ -0,0 +1,402 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace nvrhi::utils
+{
+    // Alignment of the compressed data of each request in the staging buffer
+    static constexpr uint64_t c_StagingAlignment = 16;
+
+    static bool seekFile(std::FILE* file, uint64_t offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, int64_t(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    StreamingUploader::StreamingUploader(IDevice* device, uint64_t bytesPerBatch, uint64_t maxBytesInFlight,
+        IShader* decompressionShader)
+        : m_Device(device)
+        , m_BytesPerBatch(bytesPerBatch)
+        , m_MaxBytesInFlight(std::max(maxBytesInFlight, bytesPerBatch))
+    {
+        assert(device);
+
+        if (decompressionShader)
+        {
+            // The copy queue can't run compute shaders
+            m_Queue = m_Device->queryFeatureSupport(Feature::ComputeQueue) ? CommandQueue::Compute : CommandQueue::Graphics;
+
+            m_StagingBuffer = m_Device->createBuffer(BufferDesc()
+                .setByteSize(bytesPerBatch)
+                .setCanHaveRawViews(true)
+                .setInitialState(ResourceStates::ShaderResource)
+                .setKeepInitialState(true)
+                .setDebugName("StreamingUploader Staging"));
+
+            m_DecompressionLayout = m_Device->createBindingLayout(BindingLayoutDesc()
+                .setVisibility(ShaderType::Compute)
+                .addItem(BindingLayoutItem::PushConstants(0, sizeof(GpuDecompressionConstants)))
+                .addItem(BindingLayoutItem::RawBuffer_SRV(0))
+                .addItem(BindingLayoutItem::RawBuffer_UAV(0)));
+
+            if (m_StagingBuffer && m_DecompressionLayout)
+            {
+                m_DecompressionPipeline = m_Device->createComputePipeline(ComputePipelineDesc()
+                    .setComputeShader(decompressionShader)
+                    .addBindingLayout(m_DecompressionLayout));
+            }
+        }
+        else if (!m_Device->queryFeatureSupport(Feature::CopyQueue))
+        {
+            m_Queue = CommandQueue::Graphics;
+        }
+
+        CommandListParameters params;
+        params.setQueueType(m_Queue)
+            .setEnableImmediateExecution(false)
+            .setUploadChunkSize(size_t(bytesPerBatch));
+
+        m_CommandList = m_Device->createCommandList(params);
+    }
+
+    StreamingUploader::~StreamingUploader()
+    {
+        // The command list and its upload memory must outlive the submitted batches
+        retireBatches(true);
+    }
+
+    StreamingUploader::RequestID StreamingUploader::enqueue(Request&& request, int priority)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        request.id = m_NextRequestID++;
+        const RequestID id = request.id;
+
+        m_IncompleteRequests.insert(id);
+        m_QueuedRequests.emplace(priority, std::move(request));
+
+        return id;
+    }
+
+    StreamingUploader::RequestID StreamingUploader::enqueueTextureUpload(ITexture* texture, uint32_t arraySlice,
+        uint32_t mipLevel, int priority, WriteCallback callback)
+    {
+        assert(texture);
+
+        const TextureDesc& desc = texture->getDesc();
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t mipWidth = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t mipHeight = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t mipDepth = std::max(desc.depth >> mipLevel, 1u);
+        const uint64_t numCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const uint64_t numRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+        Request request;
+        request.texture = texture;
+        request.arraySlice = arraySlice;
+        request.mipLevel = mipLevel;
+        // The device row pitch may be larger, this is only used to enforce the budget
+        request.size = numCols * formatInfo.bytesPerBlock * numRows * mipDepth;
+        request.callback = std::move(callback);
+
+        return enqueue(std::move(request), priority);
+    }
+
+    StreamingUploader::RequestID StreamingUploader::enqueueBufferUpload(IBuffer* buffer, uint64_t destOffsetBytes,
+        size_t dataSize, int priority, WriteCallback callback)
+    {
+        assert(buffer);
+
+        Request request;
+        request.buffer = buffer;
+        request.destOffset = destOffsetBytes;
+        request.size = dataSize;
+        request.callback = std::move(callback);
+
+        return enqueue(std::move(request), priority);
+    }
+
+    StreamingUploader::RequestID StreamingUploader::enqueueCompressedBufferUpload(IBuffer* buffer, uint64_t destOffsetBytes,
+        size_t decompressedSize, size_t compressedSize, int priority, WriteCallback callback)
+    {
+        assert(buffer);
+
+        if (!m_DecompressionPipeline)
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "StreamingUploader needs a decompression shader for compressed uploads");
+            return 0;
+        }
+
+        const BufferDesc& desc = buffer->getDesc();
+        if (!desc.canHaveUAVs || !desc.canHaveRawViews || compressedSize == 0 || compressedSize > m_BytesPerBatch ||
+            (destOffsetBytes | decompressedSize | compressedSize) % 4 != 0 ||
+            destOffsetBytes + decompressedSize > std::min<uint64_t>(desc.byteSize, UINT32_MAX))
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error,
+                "Invalid compressed upload request: the buffer must allow raw UAVs, the offset and sizes must be "
+                "multiples of 4 within the first 4 GB of the buffer, and the compressed size must fit into one batch");
+            return 0;
+        }
+
+        Request request;
+        request.buffer = buffer;
+        request.destOffset = destOffsetBytes;
+        request.size = compressedSize;
+        request.decompressedSize = decompressedSize;
+        request.callback = std::move(callback);
+
+        return enqueue(std::move(request), priority);
+    }
+
+    StreamingUploader::WriteCallback StreamingUploader::readFromFile(std::FILE* file, uint64_t fileOffset, size_t fileRowPitch)
+    {
+        assert(file);
+
+        return [file, fileOffset, fileRowPitch](const MappedWriteRegion& region)
+        {
+            uint8_t* data = static_cast<uint8_t*>(region.data);
+
+            if (fileRowPitch == 0 || region.rowPitch == 0 || fileRowPitch == region.rowPitch)
+            {
+                size_t bytesRead = 0;
+                if (seekFile(file, fileOffset))
+                    bytesRead = std::fread(data, 1, region.size, file);
+
+                if (bytesRead < region.size)
+                    memset(data + bytesRead, 0, region.size - bytesRead);
+                return;
+            }
+
+            const size_t numRows = region.size / region.rowPitch;
+            const size_t rowSize = std::min(fileRowPitch, region.rowPitch);
+
+            for (size_t row = 0; row < numRows; ++row)
+            {
+                uint8_t* rowData = data + row * region.rowPitch;
+
+                size_t bytesRead = 0;
+                if (seekFile(file, fileOffset + uint64_t(row) * fileRowPitch))
+                    bytesRead = std::fread(rowData, 1, rowSize, file);
+
+                if (bytesRead < region.rowPitch)
+                    memset(rowData + bytesRead, 0, region.rowPitch - bytesRead);
+            }
+        };
+    }
+
+    void StreamingUploader::retireBatches(bool waitForAll)
+    {
+        while (!m_BatchesInFlight.empty())
+        {
+            Batch& batch = m_BatchesInFlight.front();
+
+            if (waitForAll)
+                m_Device->waitEventQuery(batch.query);
+            else if (!m_Device->pollEventQuery(batch.query))
+                break; // batches finish in submission order
+
+            {
+                std::lock_guard lockGuard(m_Mutex);
+                for (RequestID id : batch.requests)
+                    m_IncompleteRequests.erase(id);
+            }
+
+            m_BytesInFlight -= batch.bytes;
+            m_Device->resetEventQuery(batch.query);
+            m_QueryPool.push_back(batch.query);
+            m_BatchesInFlight.pop_front();
+        }
+    }
+
+    uint32_t StreamingUploader::update()
+    {
+        retireBatches(false);
+
+        if (!m_CommandList)
+            return 0;
+
+        // Take the requests for the batch out of the queue first, so that the callbacks run without holding the lock
+        std::vector<Request> requests;
+        // Offsets of the compressed requests in the staging buffer
+        std::vector<uint64_t> stagingOffsets;
+        uint64_t batchBytes = 0;
+        uint64_t stagingBytes = 0;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            while (!m_QueuedRequests.empty())
+            {
+                auto it = m_QueuedRequests.begin();
+                const uint64_t size = it->second.size;
+
+                // Always let one request through when nothing else is in flight, even if it's larger than the budget
+                const bool isFirst = requests.empty() && m_BytesInFlight == 0;
+                if (!isFirst && (batchBytes + size > m_BytesPerBatch || m_BytesInFlight + batchBytes + size > m_MaxBytesInFlight))
+                    break;
+
+                // The staging buffer is reused by every batch, which the queue executes in order
+                if (it->second.decompressedSize != 0)
+                {
+                    const uint64_t stagingOffset = align(stagingBytes, c_StagingAlignment);
+                    if (stagingOffset + size > m_BytesPerBatch)
+                        break;
+
+                    stagingOffsets.push_back(stagingOffset);
+                    stagingBytes = stagingOffset + size;
+                }
+
+                batchBytes += size;
+                requests.push_back(std::move(it->second));
+                m_QueuedRequests.erase(it);
+            }
+        }
+
+        if (requests.empty())
+            return 0;
+
+        Batch batch;
+        batch.bytes = batchBytes;
+
+        m_CommandList->open();
+
+        size_t compressedIndex = 0;
+        for (Request& request : requests)
+        {
+            MappedWriteRegion region;
+            if (request.texture)
+                region = m_CommandList->beginWriteTexture(request.texture, request.arraySlice, request.mipLevel);
+            else if (request.decompressedSize != 0)
+                region = m_CommandList->beginWriteBuffer(m_StagingBuffer, size_t(request.size), stagingOffsets[compressedIndex++]);
+            else
+                region = m_CommandList->beginWriteBuffer(request.buffer, size_t(request.size), request.destOffset);
+
+            // The request is still retired with the batch if the upload memory couldn't be allocated,
+            // the backend reports the error
+            if (region.data)
+            {
+                request.callback(region);
+                m_CommandList->commitWrite();
+            }
+
+            batch.requests.push_back(request.id);
+        }
+
+        // Decompress after all the copies, so that the staging buffer only transitions once
+        if (!stagingOffsets.empty())
+        {
+            std::unordered_map<IBuffer*, BindingSetHandle> bindingSets;
+            compressedIndex = 0;
+
+            for (const Request& request : requests)
+            {
+                if (request.decompressedSize == 0)
+                    continue;
+
+                const uint64_t stagingOffset = stagingOffsets[compressedIndex++];
+
+                BindingSetHandle& bindingSet = bindingSets[request.buffer];
+                if (!bindingSet)
+                {
+                    bindingSet = m_Device->createBindingSet(BindingSetDesc()
+                        .addItem(BindingSetItem::PushConstants(0, sizeof(GpuDecompressionConstants)))
+                        .addItem(BindingSetItem::RawBuffer_SRV(0, m_StagingBuffer))
+                        .addItem(BindingSetItem::RawBuffer_UAV(0, request.buffer)),
+                        m_DecompressionLayout);
+                }
+
+                if (!bindingSet)
+                    continue;
+
+                GpuDecompressionConstants constants;
+                constants.compressedOffset = uint32_t(stagingOffset);
+                constants.compressedSize = uint32_t(request.size);
+                constants.decompressedOffset = uint32_t(request.destOffset);
+                constants.decompressedSize = uint32_t(request.decompressedSize);
+
+                m_CommandList->setComputeState(ComputeState()
+                    .setPipeline(m_DecompressionPipeline)
+                    .addBindingSet(bindingSet));
+                m_CommandList->setPushConstants(&constants, sizeof(constants));
+                m_CommandList->dispatch(uint32_t((request.decompressedSize + kGpuDecompressionBytesPerGroup - 1) / kGpuDecompressionBytesPerGroup));
+            }
+        }
+
+        m_CommandList->close();
+        m_LastSubmittedInstance = m_Device->executeCommandList(m_CommandList, m_Queue);
+
+        if (m_QueryPool.empty())
+        {
+            batch.query = m_Device->createEventQuery();
+        }
+        else
+        {
+            batch.query = m_QueryPool.back();
+            m_QueryPool.pop_back();
+        }
+        m_Device->setEventQuery(batch.query, m_Queue);
+
+        m_BytesInFlight += batch.bytes;
+        m_BatchesInFlight.push_back(std::move(batch));
+
+        return uint32_t(requests.size());
+    }
+
+    void StreamingUploader::queueWaitForUploads(CommandQueue waitQueue)
+    {
+        uint64_t& lastWaitedInstance = m_LastWaitedInstances[size_t(waitQueue)];
+
+        if (waitQueue == m_Queue || m_LastSubmittedInstance == lastWaitedInstance)
+            return;
+
+        m_Device->queueWaitForCommandList(waitQueue, m_Queue, m_LastSubmittedInstance);
+        lastWaitedInstance = m_LastSubmittedInstance;
+    }
+
+    void StreamingUploader::waitForSubmittedUploads()
+    {
+        retireBatches(true);
+    }
+
+    bool StreamingUploader::isRequestComplete(RequestID id)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_IncompleteRequests.find(id) == m_IncompleteRequests.end();
+    }
+
+    size_t StreamingUploader::getNumQueuedRequests()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_QueuedRequests.size();
+    }
+}
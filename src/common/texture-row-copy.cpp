@@ -0,0 +1,324 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NVRHI_ROWS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define NVRHI_ROWS_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define NVRHI_ROWS_AVX 1
+#include <immintrin.h>
+#endif
+
+// MSVC doesn't define __F16C__, but its /arch:AVX2 implies F16C. GCC and Clang need -mf16c even with -mavx2.
+#if (defined(__F16C__) && defined(__AVX__)) || (defined(_MSC_VER) && defined(__AVX2__))
+#define NVRHI_ROWS_F16C 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define NVRHI_ROWS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace nvrhi::utils
+{
+    // Rows shorter than this are copied with memcpy, the setup of the vector loop isn't worth it for them
+    static constexpr size_t c_MinVectorRowSize = 64;
+
+    static void copyRow(uint8_t* dest, const uint8_t* src, size_t size)
+    {
+#if NVRHI_ROWS_SSE2
+        if (size >= c_MinVectorRowSize)
+        {
+            // Non-temporal stores need an aligned destination, copy the unaligned head separately
+            const size_t head = (16 - (uintptr_t(dest) & 15)) & 15;
+            memcpy(dest, src, head);
+            dest += head;
+            src += head;
+            size -= head;
+
+#if NVRHI_ROWS_AVX
+            if ((uintptr_t(dest) & 31) != 0 && size >= 16)
+            {
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dest), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+                dest += 16;
+                src += 16;
+                size -= 16;
+            }
+
+            for (; size >= 32; size -= 32, dest += 32, src += 32)
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(dest), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+#endif
+
+            for (; size >= 16; size -= 16, dest += 16, src += 16)
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dest), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+        }
+#endif
+
+        memcpy(dest, src, size);
+    }
+
+    static void expandRGB8Row(uint8_t* dest, const uint8_t* src, size_t numPixels)
+    {
+        size_t pixel = 0;
+
+#if NVRHI_ROWS_SSSE3
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(int(0xff000000u));
+        const bool aligned = (uintptr_t(dest) & 15) == 0;
+
+        // Each iteration loads 16 bytes for 4 pixels, stop while the extra 4 bytes are still inside the row
+        for (; pixel + 6 <= numPixels; pixel += 4)
+        {
+            __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pixel * 3));
+            value = _mm_or_si128(_mm_shuffle_epi8(value, shuffle), alpha);
+
+            __m128i* destAddress = reinterpret_cast<__m128i*>(dest + pixel * 4);
+            if (aligned)
+                _mm_stream_si128(destAddress, value);
+            else
+                _mm_storeu_si128(destAddress, value);
+        }
+#elif NVRHI_ROWS_NEON
+        const uint8x8_t alpha = vdup_n_u8(255);
+
+        for (; pixel + 8 <= numPixels; pixel += 8)
+        {
+            const uint8x8x3_t rgb = vld3_u8(src + pixel * 3);
+
+            uint8x8x4_t rgba;
+            rgba.val[0] = rgb.val[0];
+            rgba.val[1] = rgb.val[1];
+            rgba.val[2] = rgb.val[2];
+            rgba.val[3] = alpha;
+            vst4_u8(dest + pixel * 4, rgba);
+        }
+#endif
+
+        for (; pixel < numPixels; pixel++)
+        {
+            dest[pixel * 4 + 0] = src[pixel * 3 + 0];
+            dest[pixel * 4 + 1] = src[pixel * 3 + 1];
+            dest[pixel * 4 + 2] = src[pixel * 3 + 2];
+            dest[pixel * 4 + 3] = 255;
+        }
+    }
+
+    // Rounds to nearest even like the hardware conversions, and keeps NaNs as quiet NaNs
+    static uint16_t floatToHalf(float value)
+    {
+        constexpr uint32_t floatInfinity = 255u << 23;
+        constexpr uint32_t halfOverflow = (127u + 16u) << 23;
+        constexpr uint32_t halfMinNormal = 113u << 23;
+        constexpr uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        const uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        uint32_t result;
+        if (bits >= halfOverflow)
+        {
+            result = (bits > floatInfinity) ? 0x7e00u : 0x7c00u;
+        }
+        else if (bits < halfMinNormal)
+        {
+            // Adding the magic number aligns the mantissa for a denormal half and lets the FPU do the rounding
+            float magic;
+            memcpy(&magic, &denormMagic, sizeof(magic));
+            float shifted;
+            memcpy(&shifted, &bits, sizeof(shifted));
+            shifted += magic;
+            memcpy(&bits, &shifted, sizeof(bits));
+            result = bits - denormMagic;
+        }
+        else
+        {
+            const uint32_t mantissaOdd = (bits >> 13) & 1;
+            bits += ((15u - 127u) << 23) + 0xfffu + mantissaOdd;
+            result = bits >> 13;
+        }
+
+        return uint16_t(result | (sign >> 16));
+    }
+
+    static void convertFloat16Row(uint8_t* dest, const uint8_t* src, size_t numValues)
+    {
+        size_t index = 0;
+
+#if NVRHI_ROWS_F16C
+        const bool aligned = (uintptr_t(dest) & 15) == 0;
+
+        for (; index + 8 <= numValues; index += 8)
+        {
+            const __m256 value = _mm256_loadu_ps(reinterpret_cast<const float*>(src + index * 4));
+            const __m128i half = _mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT);
+
+            __m128i* destAddress = reinterpret_cast<__m128i*>(dest + index * 2);
+            if (aligned)
+                _mm_stream_si128(destAddress, half);
+            else
+                _mm_storeu_si128(destAddress, half);
+        }
+#elif NVRHI_ROWS_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+        for (; index + 4 <= numValues; index += 4)
+        {
+            const float32x4_t value = vld1q_f32(reinterpret_cast<const float*>(src + index * 4));
+            vst1_u16(reinterpret_cast<uint16_t*>(dest + index * 2), vreinterpret_u16_f16(vcvt_f16_f32(value)));
+        }
+#endif
+
+        for (; index < numValues; index++)
+        {
+            float value;
+            memcpy(&value, src + index * 4, sizeof(value));
+            const uint16_t half = floatToHalf(value);
+            memcpy(dest + index * 2, &half, sizeof(half));
+        }
+    }
+
+    bool IsTextureRowConversionSupported(TextureRowConversion conversion, Format format)
+    {
+        switch (conversion)
+        {
+        case TextureRowConversion::None:
+            return true;
+
+        case TextureRowConversion::RGB8ToRGBA8:
+            switch (format)  // NOLINT(clang-diagnostic-switch-enum)
+            {
+            case Format::RGBA8_UINT:
+            case Format::RGBA8_UNORM:
+            case Format::BGRA8_UNORM:
+            case Format::BGRX8_UNORM:
+            case Format::SRGBA8_UNORM:
+            case Format::SBGRA8_UNORM:
+            case Format::SBGRX8_UNORM:
+                return true;
+            default:
+                return false;
+            }
+
+        case TextureRowConversion::Float32ToFloat16:
+            return format == Format::R16_FLOAT || format == Format::RG16_FLOAT || format == Format::RGBA16_FLOAT;
+
+        default:
+            return false;
+        }
+    }
+
+    void CopyTextureRows(
+        void* dest,
+        size_t destRowPitch,
+        size_t destDepthPitch,
+        const void* src,
+        size_t srcRowPitch,
+        size_t srcDepthPitch,
+        size_t destRowSize,
+        uint32_t numRows,
+        uint32_t depth,
+        TextureRowConversion conversion)
+    {
+        for (uint32_t slice = 0; slice < depth; slice++)
+        {
+            uint8_t* destRow = static_cast<uint8_t*>(dest) + destDepthPitch * slice;
+            const uint8_t* srcRow = static_cast<const uint8_t*>(src) + srcDepthPitch * slice;
+
+            for (uint32_t row = 0; row < numRows; row++)
+            {
+                switch (conversion)
+                {
+                case TextureRowConversion::None:
+                    copyRow(destRow, srcRow, destRowSize);
+                    break;
+                case TextureRowConversion::RGB8ToRGBA8:
+                    expandRGB8Row(destRow, srcRow, destRowSize / 4);
+                    break;
+                case TextureRowConversion::Float32ToFloat16:
+                    convertFloat16Row(destRow, srcRow, destRowSize / 2);
+                    break;
+                default:
+                    InvalidEnum();
+                    return;
+                }
+
+                destRow += destRowPitch;
+                srcRow += srcRowPitch;
+            }
+        }
+
+#if NVRHI_ROWS_SSE2
+        // Make the non-temporal stores visible before the copy from the upload memory is submitted
+        _mm_sfence();
+#endif
+    }
+
+    bool WriteTextureConverted(
+        ICommandList* commandList,
+        ITexture* texture,
+        uint32_t arraySlice,
+        uint32_t mipLevel,
+        const void* data,
+        size_t rowPitch,
+        size_t depthPitch,
+        TextureRowConversion conversion)
+    {
+        const TextureDesc& desc = texture->getDesc();
+
+        if (!IsTextureRowConversionSupported(conversion, desc.format))
+            return false;
+
+        const MappedWriteRegion region = commandList->beginWriteTexture(texture, arraySlice, mipLevel);
+        if (!region.data)
+            return false;
+
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t mipWidth = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t widthInBlocks = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const uint32_t mipDepth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+        const uint32_t numRows = uint32_t(region.depthPitch / region.rowPitch);
+
+        CopyTextureRows(region.data, region.rowPitch, region.depthPitch, data, rowPitch, depthPitch,
+            size_t(widthInBlocks) * formatInfo.bytesPerBlock, numRows, mipDepth, conversion);
+
+        commandList->commitWrite();
+        return true;
+    }
+}
@@ -0,0 +1,130 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/utils.h>
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi::utils
+{
+    // The shader-side structures must match the layouts that the HLSL side uses
+    static_assert(sizeof(rt::IndirectInstanceDesc) == sizeof(rt::InstanceDesc));
+    static_assert(sizeof(rt::IndirectTlasBuildArgs) == 16);
+    static_assert(sizeof(rt::TlasCullingCandidate) == 128);
+    static_assert(sizeof(rt::TlasCullingConstants) == 128);
+
+    TlasInstanceCullingPass::TlasInstanceCullingPass(IDevice* device, IShader* cullingShader, uint32_t maxCandidates, const std::string& debugName)
+        : m_Device(device)
+        , m_MaxCandidates(std::max(maxCandidates, 1u))
+    {
+        assert(device);
+        assert(cullingShader);
+
+        m_ClearInstances = !device->queryFeatureSupport(Feature::RayTracingIndirectInstanceCount);
+
+        m_ConstantBuffer = device->createBuffer(CreateVolatileConstantBufferDesc(sizeof(rt::TlasCullingConstants),
+            (debugName + " Constants").c_str(), 16));
+
+        m_CandidateBuffer = device->createBuffer(BufferDesc()
+            .setByteSize(uint64_t(m_MaxCandidates) * sizeof(rt::TlasCullingCandidate))
+            .setStructStride(sizeof(rt::TlasCullingCandidate))
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName(debugName + " Candidates"));
+
+        m_InstanceBuffer = device->createBuffer(BufferDesc()
+            .setByteSize(uint64_t(m_MaxCandidates) * sizeof(rt::IndirectInstanceDesc))
+            .setStructStride(sizeof(rt::IndirectInstanceDesc))
+            .setCanHaveUAVs(true)
+            .setIsAccelStructBuildInput(true)
+            .setInitialState(ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true)
+            .setDebugName(debugName + " Instances"));
+
+        m_ArgsBuffer = device->createBuffer(BufferDesc()
+            .setByteSize(sizeof(rt::IndirectTlasBuildArgs))
+            .setCanHaveUAVs(true)
+            .setCanHaveRawViews(true)
+            .setIsDrawIndirectArgs(true)
+            .setInitialState(ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true)
+            .setDebugName(debugName + " Args"));
+
+        if (!m_ConstantBuffer || !m_CandidateBuffer || !m_InstanceBuffer || !m_ArgsBuffer)
+            return;
+
+        auto bindingSetDesc = BindingSetDesc()
+            .addItem(BindingSetItem::ConstantBuffer(0, m_ConstantBuffer))
+            .addItem(BindingSetItem::StructuredBuffer_SRV(0, m_CandidateBuffer))
+            .addItem(BindingSetItem::StructuredBuffer_UAV(0, m_InstanceBuffer))
+            .addItem(BindingSetItem::RawBuffer_UAV(1, m_ArgsBuffer));
+
+        if (!CreateBindingSetAndLayout(device, ShaderType::Compute, 0, bindingSetDesc, m_BindingLayout, m_BindingSet))
+            return;
+
+        m_Pipeline = device->createComputePipeline(ComputePipelineDesc()
+            .setComputeShader(cullingShader)
+            .addBindingLayout(m_BindingLayout));
+    }
+
+    bool TlasInstanceCullingPass::setCandidates(ICommandList* commandList, const rt::TlasCullingCandidate* pCandidates, uint32_t numCandidates)
+    {
+        if (numCandidates > m_MaxCandidates)
+            return false;
+
+        if (numCandidates > 0)
+            commandList->writeBuffer(m_CandidateBuffer, pCandidates, size_t(numCandidates) * sizeof(rt::TlasCullingCandidate));
+
+        m_NumCandidates = numCandidates;
+        return true;
+    }
+
+    void TlasInstanceCullingPass::execute(ICommandList* commandList, rt::IAccelStruct* tlas, const rt::TlasCullingConstants& constants,
+        rt::AccelStructBuildFlags buildFlags)
+    {
+        if (!isValid())
+            return;
+
+        rt::TlasCullingConstants passConstants = constants;
+        passConstants.numCandidates = m_NumCandidates;
+        passConstants.maxInstances = m_MaxCandidates;
+        commandList->writeBuffer(m_ConstantBuffer, &passConstants, sizeof(passConstants));
+
+        // A zero instance has no BLAS and is inactive
+        commandList->clearBufferUInt(m_ArgsBuffer, 0);
+        if (m_ClearInstances)
+            commandList->clearBufferUInt(m_InstanceBuffer, 0);
+
+        if (m_NumCandidates > 0)
+        {
+            commandList->setComputeState(ComputeState()
+                .setPipeline(m_Pipeline)
+                .addBindingSet(m_BindingSet));
+
+            commandList->dispatch((m_NumCandidates + rt::kTlasCullingGroupSize - 1) / rt::kTlasCullingGroupSize);
+        }
+
+        buildFlags = buildFlags & ~rt::AccelStructBuildFlags::PerformUpdate;
+
+        commandList->buildTopLevelAccelStructFromBufferIndirect(tlas, m_InstanceBuffer, 0, m_ArgsBuffer, 0, m_MaxCandidates, buildFlags);
+    }
+} // namespace nvrhi::utils
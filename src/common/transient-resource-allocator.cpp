@@ -0,0 +1,306 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi::utils
+{
+    TransientResourceAllocator::TransientResourceAllocator(IDevice* device)
+        : m_Device(device)
+    {
+        assert(device);
+    }
+
+    uint32_t TransientResourceAllocator::addTexture(const TextureDesc& desc, uint32_t firstPass, uint32_t lastPass)
+    {
+        assert(firstPass <= lastPass);
+
+        TransientResource resource;
+        resource.textureDesc = desc;
+        resource.isTexture = true;
+        resource.firstPass = firstPass;
+        resource.lastPass = lastPass;
+        resource.category = desc.isRenderTarget ? RenderTargets : Textures;
+
+        m_Resources.push_back(resource);
+        return uint32_t(m_Resources.size() - 1);
+    }
+
+    uint32_t TransientResourceAllocator::addBuffer(const BufferDesc& desc, uint32_t firstPass, uint32_t lastPass)
+    {
+        assert(firstPass <= lastPass);
+
+        TransientResource resource;
+        resource.bufferDesc = desc;
+        resource.isTexture = false;
+        resource.firstPass = firstPass;
+        resource.lastPass = lastPass;
+        resource.category = Buffers;
+
+        m_Resources.push_back(resource);
+        return uint32_t(m_Resources.size() - 1);
+    }
+
+    static bool lifetimesOverlap(uint32_t firstPassA, uint32_t lastPassA, uint32_t firstPassB, uint32_t lastPassB)
+    {
+        return firstPassA <= lastPassB && firstPassB <= lastPassA;
+    }
+
+    bool TransientResourceAllocator::compile()
+    {
+        m_AliasingBarrierOrder.clear();
+
+        // Release the resources from the previous compilation before placing new ones into the same heaps
+        for (TransientResource& resource : m_Resources)
+        {
+            resource.texture = nullptr;
+            resource.buffer = nullptr;
+            resource.aliasedPredecessor = c_InvalidResource;
+            resource.isAliased = false;
+        }
+
+        for (TransientResource& resource : m_Resources)
+        {
+            if (resource.isTexture)
+            {
+                TextureDesc desc = resource.textureDesc;
+                desc.isVirtual = true;
+                resource.texture = m_Device->createTexture(desc);
+                if (!resource.texture)
+                    return false;
+
+                resource.memoryRequirements = m_Device->getTextureMemoryRequirements(resource.texture);
+            }
+            else
+            {
+                BufferDesc desc = resource.bufferDesc;
+                desc.isVirtual = true;
+                resource.buffer = m_Device->createBuffer(desc);
+                if (!resource.buffer)
+                    return false;
+
+                resource.memoryRequirements = m_Device->getBufferMemoryRequirements(resource.buffer);
+            }
+
+            if (resource.memoryRequirements.size == 0)
+                return false;
+        }
+
+        // Place the largest resources first, each one at the lowest offset in its heap that does not overlap
+        // any already placed resource with an overlapping lifetime
+        std::vector<uint32_t> placementOrder(m_Resources.size());
+        for (uint32_t index = 0; index < uint32_t(m_Resources.size()); index++)
+            placementOrder[index] = index;
+
+        std::stable_sort(placementOrder.begin(), placementOrder.end(), [this](uint32_t a, uint32_t b)
+        {
+            return m_Resources[a].memoryRequirements.size > m_Resources[b].memoryRequirements.size;
+        });
+
+        uint64_t heapSizes[HeapCategoryCount] = {};
+        std::vector<uint32_t> placedResources;
+        std::vector<std::pair<uint64_t, uint64_t>> occupiedRanges;
+
+        for (uint32_t index : placementOrder)
+        {
+            TransientResource& resource = m_Resources[index];
+            const uint64_t size = resource.memoryRequirements.size;
+            const uint64_t alignment = std::max(resource.memoryRequirements.alignment, uint64_t(1));
+
+            occupiedRanges.clear();
+            for (uint32_t placedIndex : placedResources)
+            {
+                const TransientResource& placed = m_Resources[placedIndex];
+                if (placed.category == resource.category &&
+                    lifetimesOverlap(placed.firstPass, placed.lastPass, resource.firstPass, resource.lastPass))
+                {
+                    occupiedRanges.emplace_back(placed.heapOffset, placed.heapOffset + placed.memoryRequirements.size);
+                }
+            }
+
+            std::sort(occupiedRanges.begin(), occupiedRanges.end());
+
+            uint64_t offset = 0;
+            for (const auto& range : occupiedRanges)
+            {
+                if (align(offset, alignment) + size <= range.first)
+                    break;
+
+                offset = std::max(offset, range.second);
+            }
+
+            resource.heapOffset = align(offset, alignment);
+            heapSizes[resource.category] = std::max(heapSizes[resource.category], resource.heapOffset + size);
+            placedResources.push_back(index);
+        }
+
+        // Find the resources that share memory, and which resource used the memory before each of them
+        for (uint32_t index = 0; index < uint32_t(m_Resources.size()); index++)
+        {
+            TransientResource& resource = m_Resources[index];
+            const uint64_t begin = resource.heapOffset;
+            const uint64_t end = begin + resource.memoryRequirements.size;
+            uint32_t predecessorCount = 0;
+
+            for (uint32_t otherIndex = 0; otherIndex < uint32_t(m_Resources.size()); otherIndex++)
+            {
+                const TransientResource& other = m_Resources[otherIndex];
+                const uint64_t otherBegin = other.heapOffset;
+                const uint64_t otherEnd = otherBegin + other.memoryRequirements.size;
+
+                if (otherIndex == index || other.category != resource.category || otherEnd <= begin || end <= otherBegin)
+                    continue;
+
+                resource.isAliased = true;
+
+                if (other.lastPass < resource.firstPass)
+                {
+                    ++predecessorCount;
+                    resource.aliasedPredecessor = otherIndex;
+                }
+            }
+
+            // With several predecessors, a barrier with a null 'before' resource covers all of them
+            if (predecessorCount != 1)
+                resource.aliasedPredecessor = c_InvalidResource;
+
+            if (resource.isAliased)
+                m_AliasingBarrierOrder.push_back(index);
+        }
+
+        std::stable_sort(m_AliasingBarrierOrder.begin(), m_AliasingBarrierOrder.end(), [this](uint32_t a, uint32_t b)
+        {
+            return m_Resources[a].firstPass < m_Resources[b].firstPass;
+        });
+
+        // Create or grow the heaps
+        static const char* const heapNames[HeapCategoryCount] = {
+            "TransientRenderTargetHeap",
+            "TransientTextureHeap",
+            "TransientBufferHeap"
+        };
+
+        for (uint32_t category = 0; category < HeapCategoryCount; category++)
+        {
+            if (heapSizes[category] == 0)
+                continue;
+
+            if (m_Heaps[category] && m_Heaps[category]->getDesc().capacity >= heapSizes[category])
+                continue;
+
+            m_Heaps[category] = nullptr;
+
+            HeapDesc heapDesc;
+            heapDesc.capacity = heapSizes[category];
+            heapDesc.type = HeapType::DeviceLocal;
+            heapDesc.debugName = heapNames[category];
+
+            m_Heaps[category] = m_Device->createHeap(heapDesc);
+            if (!m_Heaps[category])
+                return false;
+        }
+
+        for (TransientResource& resource : m_Resources)
+        {
+            IHeap* heap = m_Heaps[resource.category];
+
+            const bool bound = resource.isTexture
+                ? m_Device->bindTextureMemory(resource.texture, heap, resource.heapOffset)
+                : m_Device->bindBufferMemory(resource.buffer, heap, resource.heapOffset);
+
+            if (!bound)
+                return false;
+        }
+
+        return true;
+    }
+
+    void TransientResourceAllocator::beginPass(ICommandList* commandList, uint32_t passIndex) const
+    {
+        auto it = std::lower_bound(m_AliasingBarrierOrder.begin(), m_AliasingBarrierOrder.end(), passIndex,
+            [this](uint32_t index, uint32_t pass) { return m_Resources[index].firstPass < pass; });
+
+        for (; it != m_AliasingBarrierOrder.end() && m_Resources[*it].firstPass == passIndex; ++it)
+        {
+            const TransientResource& resource = m_Resources[*it];
+
+            commandList->aliasingBarrier(getResource(resource.aliasedPredecessor), getResource(*it));
+        }
+    }
+
+    void TransientResourceAllocator::reset()
+    {
+        m_Resources.clear();
+        m_AliasingBarrierOrder.clear();
+    }
+
+    ITexture* TransientResourceAllocator::getTexture(uint32_t index) const
+    {
+        if (index >= m_Resources.size())
+            return nullptr;
+
+        return m_Resources[index].texture;
+    }
+
+    IBuffer* TransientResourceAllocator::getBuffer(uint32_t index) const
+    {
+        if (index >= m_Resources.size())
+            return nullptr;
+
+        return m_Resources[index].buffer;
+    }
+
+    IResource* TransientResourceAllocator::getResource(uint32_t index) const
+    {
+        if (index >= m_Resources.size())
+            return nullptr;
+
+        const TransientResource& resource = m_Resources[index];
+        if (resource.isTexture)
+            return resource.texture;
+
+        return resource.buffer;
+    }
+
+    uint64_t TransientResourceAllocator::getHeapMemorySize() const
+    {
+        uint64_t size = 0;
+        for (const HeapHandle& heap : m_Heaps)
+        {
+            if (heap)
+                size += heap->getDesc().capacity;
+        }
+        return size;
+    }
+
+    uint64_t TransientResourceAllocator::getResourceMemorySize() const
+    {
+        uint64_t size = 0;
+        for (const TransientResource& resource : m_Resources)
+            size += resource.memoryRequirements.size;
+        return size;
+    }
+
+} // namespace nvrhi::utils
@@ -169,10 +169,11 @@ namespace nvrhi::utils
     {
         switch (api)
         {
-        case GraphicsAPI::D3D11:  return "D3D11";
-        case GraphicsAPI::D3D12:  return "D3D12";
-        case GraphicsAPI::VULKAN: return "Vulkan";
-        default:                         return "<UNKNOWN>";
+        case GraphicsAPI::D3D11:       return "D3D11";
+        case GraphicsAPI::D3D12:       return "D3D12";
+        case GraphicsAPI::VULKAN:      return "Vulkan";
+        case GraphicsAPI::NULL_DEVICE: return "Null";
+        default:                       return "<UNKNOWN>";
         }
     }
 
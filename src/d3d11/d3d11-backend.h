@@ -25,9 +25,13 @@
 #include <nvrhi/d3d11.h>
 #include <nvrhi/common/resourcebindingmap.h>
 #include <nvrhi/utils.h>
+#include "../common/device-stats.h"
+#include "../common/profile-hooks.h"
 #include "../common/dxgi-format.h"
 
 #include <d3d11_1.h>
+#include <chrono>
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -65,6 +69,8 @@ namespace nvrhi::d3d11
         RefCountPtr<ID3D11Buffer> pushConstantBuffer;
         IMessageCallback* messageCallback = nullptr;
         bool nvapiAvailable = false;
+        // True when the driver records deferred context command lists natively, see D3D11_FEATURE_DATA_THREADING
+        bool driverCommandLists = false;
 #if NVRHI_WITH_AFTERMATH
         GFSDK_Aftermath_ContextHandle aftermathContext = nullptr;
 #endif
@@ -78,6 +84,7 @@ namespace nvrhi::d3d11
         TextureDesc desc;
         RefCountPtr<ID3D11Resource> resource;
         HANDLE sharedHandle = nullptr;
+        DeviceStatsEntry statsEntry;
 
         Texture(const Context& context) : m_Context(context) { }
         const TextureDesc& getDesc() const override { return desc; }
@@ -103,6 +110,7 @@ namespace nvrhi::d3d11
         RefCountPtr<Texture> texture;
         CpuAccessMode cpuAccess = CpuAccessMode::None;
         UINT mappedSubresource = UINT(-1);
+        DeviceStatsEntry statsEntry;
         
         const TextureDesc& getDesc() const override { return texture->getDesc(); }
     };
@@ -113,6 +121,7 @@ namespace nvrhi::d3d11
         BufferDesc desc;
         RefCountPtr<ID3D11Buffer> resource;
         HANDLE sharedHandle = nullptr;
+        DeviceStatsEntry statsEntry;
         
         Buffer(const Context& context) : m_Context(context) { }
         const BufferDesc& getDesc() const override { return desc; }
@@ -150,6 +159,7 @@ namespace nvrhi::d3d11
     public:
         SamplerDesc desc;
         RefCountPtr<ID3D11SamplerState> sampler;
+        DeviceStatsEntry statsEntry;
         
         const SamplerDesc& getDesc() const override { return desc; }
     };
@@ -192,6 +202,7 @@ namespace nvrhi::d3d11
         FramebufferInfoEx framebufferInfo;
         static_vector<RefCountPtr<ID3D11RenderTargetView>, c_MaxRenderTargets> RTVs;
         RefCountPtr<ID3D11DepthStencilView> DSV;
+        DeviceStatsEntry statsEntry;
         
         const FramebufferDesc& getDesc() const override { return desc; }
         const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
@@ -227,6 +238,7 @@ namespace nvrhi::d3d11
         RefCountPtr<ID3D11DomainShader> pDS;
         RefCountPtr<ID3D11GeometryShader> pGS;
         RefCountPtr<ID3D11PixelShader> pPS;
+        DeviceStatsEntry statsEntry;
         
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
@@ -238,6 +250,7 @@ namespace nvrhi::d3d11
         ComputePipelineDesc desc;
 
         RefCountPtr<ID3D11ComputeShader> shader;
+        DeviceStatsEntry statsEntry;
         
         const ComputePipelineDesc& getDesc() const override { return desc; }
     };
@@ -277,16 +290,64 @@ namespace nvrhi::d3d11
         uint32_t maxUAVSlot = 0;
 
         std::vector<RefCountPtr<IResource>> resources;
+        DeviceStatsEntry statsEntry;
         
         const BindingSetDesc* getDesc() const override { return &desc; }
         IBindingLayout* getLayout() const override { return layout; }
-        bool isSupersetOf(const BindingSet& other) const;
+    };
+
+    // Shadow copy of the constant buffers, SRVs and samplers bound to one shader stage of a device context.
+    // Binding sets are merged into the pending slots first, then commit() compares them with the slots that
+    // the context already has and issues at most one call per resource type, covering only the changed range.
+    class ShaderStageBindingCache
+    {
+    public:
+        // Forgets everything, to match a context that has been reset with ClearState
+        void reset();
+
+        // The runtime unbinds SRVs when their resources are bound as render targets or UAVs, so after such calls
+        // the bound SRVs are not known exactly anymore and have to be rebound on the next commit
+        void invalidateShaderResources() { m_ShaderResources.forceCommit = true; }
+
+        void unbindSet(const BindingSet& set);
+        void bindSet(const BindingSet& set);
+        void commit(ID3D11DeviceContext* context, ID3D11DeviceContext1* context1, ShaderType stage);
+
+    private:
+        struct ConstantBufferBinding
+        {
+            ID3D11Buffer* buffer = nullptr;
+            UINT offset = 0;
+            UINT count = 0;
+
+            bool operator==(const ConstantBufferBinding& b) const { return buffer == b.buffer && offset == b.offset && count == b.count; }
+            bool operator!=(const ConstantBufferBinding& b) const { return !(*this == b); }
+        };
+
+        template<typename T, uint32_t N>
+        struct Slots
+        {
+            T bound[N] = {};
+            T pending[N] = {};
+            uint32_t dirtyMin = N;
+            uint32_t dirtyMax = 0;
+            bool forceCommit = false;
+
+            void write(uint32_t slot, const T& value);
+            bool getChangedRange(uint32_t& first, uint32_t& last) const;
+            void markCommitted(uint32_t first, uint32_t last);
+        };
+
+        Slots<ConstantBufferBinding, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> m_ConstantBuffers;
+        Slots<ID3D11ShaderResourceView*, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT> m_ShaderResources;
+        Slots<ID3D11SamplerState*, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT> m_Samplers;
     };
 
     class CommandList : public RefCounter<ICommandList>
     {
     public:
-        explicit CommandList(const Context& context, IDevice* device, const CommandListParameters& params);
+        // The device context is either the immediate context or a deferred one when params.enableImmediateExecution is false
+        explicit CommandList(const Context& context, IDevice* device, const CommandListParameters& params, ID3D11DeviceContext* deviceContext);
         ~CommandList() override;
 
         // IResource implementation
@@ -297,6 +358,8 @@ namespace nvrhi::d3d11
 
         void open() override;
         void close() override;
+        void openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport) override;
+        void executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists) override;
         void clearState() override;
 
         void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
@@ -313,17 +376,30 @@ namespace nvrhi::d3d11
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        MappedWriteRegion beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
+        MappedWriteRegion beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        void commitWrite() override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        ReadbackTicketHandle readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback) override;
+        ReadbackTicketHandle readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
+        void setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings) override;
+        BindingSetHandle createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
+        void drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
+        void drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -331,16 +407,27 @@ namespace nvrhi::d3d11
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount) override;
+
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const WorkGraphDispatchArguments& args) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+            nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
@@ -367,7 +454,10 @@ namespace nvrhi::d3d11
 
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override { (void)texture; (void)stateBits; }
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override { (void)buffer; (void)stateBits; }
+        void beginTextureStateTransition(ITexture* texture, ResourceStates nextState) override { (void)texture; (void)nextState; }
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState) override { (void)buffer; (void)nextState; }
 
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override { (void)resourceBefore; (void)resourceAfter; }
         void commitBarriers() override { }
 
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override { (void)texture; (void)arraySlice; (void)mipLevel; return ResourceStates::Common; }
@@ -375,17 +465,44 @@ namespace nvrhi::d3d11
 
         IDevice* getDevice() override { return m_Device; }
         const CommandListParameters& getDesc() override { return m_Desc; }
+        CommandListStats getStats() override { return m_Stats; }
+
+        bool isDeferred() const { return !m_Desc.enableImmediateExecution; }
+        ID3D11CommandList* getRecordedCommandList() const { return m_RecordedCommandList; }
+
+        // Forgets the cached state without touching the context, used after the context state was reset externally
+        void invalidateStateCache();
 
     private:
         const Context& m_Context;
         IDevice* m_Device; // weak reference - to avoid a cyclic reference between Device and its ImmediateCommandList
         CommandListParameters m_Desc;
+        CommandListStats m_Stats;
+
+        RefCountPtr<ID3D11DeviceContext> m_DeviceContext;
+        RefCountPtr<ID3D11DeviceContext1> m_DeviceContext1;
+
+        // Result of FinishCommandList on a deferred context, played back by Device::executeCommandLists
+        RefCountPtr<ID3D11CommandList> m_RecordedCommandList;
 
         RefCountPtr<ID3DUserDefinedAnnotation> m_UserDefinedAnnotation;
 #if NVRHI_WITH_AFTERMATH
         AftermathMarkerTracker m_AftermathTracker;
 #endif
 
+        // There is no upload memory on DX11, so two-phase writes go through a CPU buffer owned by the command list
+        struct PendingWrite
+        {
+            TextureHandle texture;
+            BufferHandle buffer;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+            uint64_t destOffset = 0;
+            size_t rowPitch = 0;
+            size_t depthPitch = 0;
+            std::vector<uint8_t> data;
+        } m_PendingWrite;
+
         int m_NumUAVOverlapCommands = 0;
         void enterUAVOverlapSection();
         void leaveUAVOverlapSection();
@@ -397,6 +514,7 @@ namespace nvrhi::d3d11
 
         GraphicsPipelineHandle m_CurrentGraphicsPipeline;
         FramebufferHandle m_CurrentFramebuffer;
+        FramebufferHandle m_LastLoadedFramebuffer; // last framebuffer that the load ops were applied for
         ViewportState m_CurrentViewports{};
         static_vector<BindingSetHandle, c_MaxBindingLayouts> m_CurrentBindings;
         static_vector<VertexBufferBinding, c_MaxVertexAttributes> m_CurrentVertexBufferBindings;
@@ -411,20 +529,23 @@ namespace nvrhi::d3d11
         bool m_CurrentGraphicsStateValid = false;
         bool m_CurrentComputeStateValid = false;
 
+        // What the context has bound to the VS, HS, DS, GS and PS stages, in that order, and to the CS stage
+        ShaderStageBindingCache m_GraphicsStageBindings[5];
+        ShaderStageBindingCache m_ComputeStageBindings;
+
         void copyTexture(ID3D11Resource* dst, const TextureDesc& dstDesc, const TextureSlice& dstSlice,
             ID3D11Resource* src, const TextureDesc& srcDesc, const TextureSlice& srcSlice);
         
         void bindGraphicsPipeline(const GraphicsPipeline* pso) const;
 
-        void prepareToBindGraphicsResourceSets(
+        // Clears or discards the attachments of a framebuffer that is bound after a different one, see AttachmentLoadOp
+        void applyFramebufferLoadOps(Framebuffer* framebuffer);
+        void bindGraphicsResourceSets(
             const BindingSetVector& resourceSets,
             const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets,
             const IGraphicsPipeline* currentPipeline,
-            const IGraphicsPipeline* newPipeline,
-            bool updateFramebuffer,
-            BindingSetVector& outSetsToBind) const;
-        void bindGraphicsResourceSets(const BindingSetVector& setsToBind, const IGraphicsPipeline* newPipeline) const;
-        void bindComputeResourceSets(const BindingSetVector& resourceSets, const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets) const;
+            const IGraphicsPipeline* newPipeline);
+        void bindComputeResourceSets(const BindingSetVector& resourceSets, const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets);
     };
 
     class Device : public RefCounter<IDevice>
@@ -479,6 +600,10 @@ namespace nvrhi::d3d11
         bool pollEventQuery(IEventQuery* query) override;
         void waitEventQuery(IEventQuery* query) override;
         void resetEventQuery(IEventQuery* query) override;
+        SubmissionTicket getSubmissionTicket(CommandQueue queue) override;
+        bool pollSubmission(const SubmissionTicket& ticket) override;
+        bool waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
+        bool waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
 
         // timer queries
         TimerQueryHandle createTimerQuery(void) override;
@@ -499,8 +624,10 @@ namespace nvrhi::d3d11
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
 
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        WorkGraphPipelineHandle createWorkGraphPipeline(const WorkGraphPipelineDesc& desc) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline) override;
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -518,12 +645,21 @@ namespace nvrhi::d3d11
         bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
 
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
-        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override { (void)pCommandLists; (void)numCommandLists; (void)executionQueue; return 0; }
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override { (void)waitQueue; (void)executionQueue; (void)instance; }
+        void flushSubmissions() override { }
         bool waitForIdle() override;
         void runGarbageCollection() override { }
+        void runGarbageCollection(uint32_t) override { }
+        void evictCachedFramebuffers(ITexture*) override { }
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
+        MemoryAllocatorStats getMemoryAllocatorStats() override;
+        MemoryBudget getMemoryBudget() override;
+        AccelStructStats getAccelStructStats() override;
+        DeviceStats getDeviceStats() override;
+        bool getProfilerFrameResults(ProfilerFrameResults& outResults) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& data) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override { (void)objectType; (void)queue;  return nullptr; }
@@ -533,18 +669,32 @@ namespace nvrhi::d3d11
 
     private:
         Context m_Context;
+        DeviceStatsTracker m_Stats;
         EventQueryHandle m_WaitForIdleQuery;
         CommandListHandle m_ImmediateCommandList;
 
+        // The immediate context has no fences, so every submission ticket is an event query issued by
+        // getSubmissionTicket. The queries complete in order and are recycled once they have completed.
+        struct TicketQuery
+        {
+            uint64_t instance = 0;
+            RefCountPtr<ID3D11Query> query;
+        };
+        std::deque<TicketQuery> m_TicketQueries;
+        std::vector<RefCountPtr<ID3D11Query>> m_FreeTicketQueries;
+        uint64_t m_LastTicketInstance = 0;
+        uint64_t m_CompletedTicketInstance = 0;
+
         std::unordered_map<size_t, RefCountPtr<ID3D11BlendState>> m_BlendStates;
         std::unordered_map<size_t, RefCountPtr<ID3D11DepthStencilState>> m_DepthStencilStates;
         std::unordered_map<size_t, RefCountPtr<ID3D11RasterizerState>> m_RasterizerStates;
+        std::mutex m_StateCacheMutex; // pipelines can be created from multiple threads
 
         bool m_SinglePassStereoSupported = false;
         bool m_HlslExtensionsSupported = false;
         bool m_FastGeometryShaderSupported = false;
 
-        TextureHandle createTexture(const TextureDesc& d, CpuAccessMode cpuAccess) const;
+        TextureHandle createTexture(const TextureDesc& d, CpuAccessMode cpuAccess);
 
         ID3D11RenderTargetView* getRTVForAttachment(const FramebufferAttachment& attachment);
         ID3D11DepthStencilView* getDSVForAttachment(const FramebufferAttachment& attachment);
@@ -553,6 +703,10 @@ namespace nvrhi::d3d11
         ID3D11DepthStencilState* getDepthStencilState(const DepthStencilState& depthStencilState);
         ID3D11RasterizerState* getRasterizerState(const RasterState& rasterState);
 
+        // Retires the ticket queries up to the instance, waiting for them until the deadline if 'wait' is set
+        bool retireTicketQueries(uint64_t instance, bool wait, std::chrono::steady_clock::time_point deadline);
+        bool waitForTicketInstance(uint64_t instance, uint64_t timeoutNanoseconds);
+
         bool m_AftermathEnabled = false;
         AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
     };
@@ -141,6 +141,7 @@ namespace nvrhi::d3d11
         buffer->desc = d;
         buffer->resource = newBuffer;
         buffer->sharedHandle = sharedHandle;
+        buffer->statsEntry.set(&m_Stats, LiveObjectType::Buffer, d.byteSize);
         return BufferHandle::Create(buffer);
     }
 
@@ -150,15 +151,31 @@ namespace nvrhi::d3d11
 
         assert(destOffsetBytes + dataSize <= UINT_MAX);
 
+        m_Stats.uploadBytes += dataSize;
+        if (buffer->desc.isVolatile)
+            ++m_Stats.volatileBufferWrites;
+
         if (buffer->desc.cpuAccess == CpuAccessMode::Write)
         {
             // we can map if it it's D3D11_USAGE_DYNAMIC, but not UpdateSubresource
             D3D11_MAPPED_SUBRESOURCE mappedData;
             D3D11_MAP mapType = D3D11_MAP_WRITE_DISCARD;
             if (destOffsetBytes > 0 || dataSize + destOffsetBytes < buffer->desc.byteSize)
+            {
+                // Deferred contexts can only map dynamic resources with WRITE_DISCARD
+                if (isDeferred())
+                {
+                    std::stringstream ss;
+                    ss << "Partial writes to buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                        << " with CpuAccessMode::Write are not supported in deferred command lists";
+                    m_Context.error(ss.str());
+                    return;
+                }
+
                 mapType = D3D11_MAP_WRITE;
+            }
 
-            const HRESULT res = m_Context.immediateContext->Map(buffer->resource, 0, mapType, 0, &mappedData);
+            const HRESULT res = m_DeviceContext->Map(buffer->resource, 0, mapType, 0, &mappedData);
             if (FAILED(res))
             {
                 std::stringstream ss;
@@ -169,14 +186,19 @@ namespace nvrhi::d3d11
             }
 
             memcpy((char*)mappedData.pData + destOffsetBytes, data, dataSize);
-            m_Context.immediateContext->Unmap(buffer->resource, 0);
+            m_DeviceContext->Unmap(buffer->resource, 0);
         }
         else
         {
             D3D11_BOX box = { UINT(destOffsetBytes), 0, 0, UINT(destOffsetBytes + dataSize), 1, 1 };
             bool useBox = destOffsetBytes > 0 || dataSize < buffer->desc.byteSize;
 
-            m_Context.immediateContext->UpdateSubresource(buffer->resource, 0, useBox ? &box : nullptr, data, (UINT)dataSize, 0);
+            // Without driver command lists, the runtime applies the box offset to the source pointer
+            // for deferred contexts, so compensate for that as recommended in the UpdateSubresource docs
+            if (useBox && isDeferred() && !m_Context.driverCommandLists)
+                data = (const char*)data - destOffsetBytes;
+
+            m_DeviceContext->UpdateSubresource(buffer->resource, 0, useBox ? &box : nullptr, data, (UINT)dataSize, 0);
         }
     }
 
@@ -191,7 +213,7 @@ namespace nvrhi::d3d11
         ID3D11UnorderedAccessView* uav = checked_cast<Buffer*>(buffer)->getUAV(Format::UNKNOWN, EntireBuffer, viewType);
 
         UINT clearValues[4] = { clearValue, clearValue, clearValue, clearValue };
-        m_Context.immediateContext->ClearUnorderedAccessViewUint(uav, clearValues);
+        m_DeviceContext->ClearUnorderedAccessViewUint(uav, clearValues);
     }
 
     void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
@@ -210,7 +232,28 @@ namespace nvrhi::d3d11
         srcBox.top = 0;
         srcBox.front = 0;
         srcBox.back = 1;
-        m_Context.immediateContext->CopySubresourceRegion(dest->resource, 0, (UINT)destOffsetBytes, 0, 0, src->resource, 0, &srcBox);
+        m_DeviceContext->CopySubresourceRegion(dest->resource, 0, (UINT)destOffsetBytes, 0, 0, src->resource, 0, &srcBox);
+    }
+
+    ReadbackTicketHandle CommandList::readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback)
+    {
+        (void)b;
+        (void)offsetBytes;
+        (void)sizeBytes;
+        (void)callback;
+
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    ReadbackTicketHandle CommandList::readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback)
+    {
+        (void)texture;
+        (void)slice;
+        (void)callback;
+
+        utils::NotSupported();
+        return nullptr;
     }
     
     void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags)
@@ -276,6 +319,7 @@ namespace nvrhi::d3d11
         Buffer* buffer = new Buffer(m_Context);
         buffer->desc = desc;
         buffer->resource = pBuffer;
+        buffer->statsEntry.set(&m_Stats, LiveObjectType::Buffer, desc.byteSize);
         return BufferHandle::Create(buffer);
     }
 
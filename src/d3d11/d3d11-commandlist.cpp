@@ -22,15 +22,19 @@
 
 #include "d3d11-backend.h"
 #include <nvrhi/utils.h>
+#include <sstream>
+#include <iomanip>
 
 namespace nvrhi::d3d11
 {
-    CommandList::CommandList(const Context& context, IDevice* device, const CommandListParameters& params)
+    CommandList::CommandList(const Context& context, IDevice* device, const CommandListParameters& params, ID3D11DeviceContext* deviceContext)
         : m_Context(context)
         , m_Device(device)
         , m_Desc(params)
+        , m_DeviceContext(deviceContext)
     {
-        m_Context.immediateContext->QueryInterface(IID_PPV_ARGS(&m_UserDefinedAnnotation));
+        m_DeviceContext->QueryInterface(IID_PPV_ARGS(&m_DeviceContext1));
+        m_DeviceContext->QueryInterface(IID_PPV_ARGS(&m_UserDefinedAnnotation));
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
@@ -50,7 +54,7 @@ namespace nvrhi::d3d11
         switch (objectType)
         {
         case ObjectTypes::D3D11_DeviceContext:
-            return Object(m_Context.immediateContext);
+            return Object(m_DeviceContext);
         default:
             return nullptr;
         }
@@ -58,7 +62,11 @@ namespace nvrhi::d3d11
 
     void CommandList::open()
     {
+        m_RecordedCommandList = nullptr;
+        m_Stats = CommandListStats();
+
         clearState();
+        m_LastLoadedFramebuffer = nullptr;
     }
 
     void CommandList::close()
@@ -67,19 +75,53 @@ namespace nvrhi::d3d11
             leaveUAVOverlapSection();
 
         clearState();
+
+        if (isDeferred())
+        {
+            // Don't restore the deferred context state, it starts from the defaults after FinishCommandList,
+            // which matches the state cache that clearState() has just reset
+            const HRESULT res = m_DeviceContext->FinishCommandList(FALSE, &m_RecordedCommandList);
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "FinishCommandList call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+                m_Context.error(ss.str());
+            }
+        }
+    }
+
+    void CommandList::openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport)
+    {
+        (void)framebuffer;
+        (void)viewport;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        (void)pCommandLists;
+        (void)numCommandLists;
+
+        utils::NotSupported();
     }
 
     void CommandList::clearState()
     {
-        m_Context.immediateContext->ClearState();
+        m_DeviceContext->ClearState();
 
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_CurrentGraphicsStateValid && m_CurrentSinglePassStereoState.enabled)
         {
-            NvAPI_D3D_SetSinglePassStereoMode(m_Context.immediateContext, 1, 0, 0);
+            NvAPI_D3D_SetSinglePassStereoMode(m_DeviceContext, 1, 0, 0);
         }
 #endif
 
+        invalidateStateCache();
+    }
+
+    void CommandList::invalidateStateCache()
+    {
         m_CurrentGraphicsStateValid = false;
         m_CurrentComputeStateValid = false;
 
@@ -92,6 +134,10 @@ namespace nvrhi::d3d11
         m_CurrentComputePipeline = nullptr;
         m_CurrentIndirectBuffer = nullptr;
         m_CurrentBlendConstantColor = Color{};
+
+        for (ShaderStageBindingCache& cache : m_GraphicsStageBindings)
+            cache.reset();
+        m_ComputeStageBindings.reset();
     }
 
     void CommandList::setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers)
@@ -118,7 +164,7 @@ namespace nvrhi::d3d11
     {
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_NumUAVOverlapCommands == 0)
-            NvAPI_D3D11_BeginUAVOverlap(m_Context.immediateContext);
+            NvAPI_D3D11_BeginUAVOverlap(m_DeviceContext);
 #endif
 
         m_NumUAVOverlapCommands += 1;
@@ -128,7 +174,7 @@ namespace nvrhi::d3d11
     {
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_NumUAVOverlapCommands == 1)
-            NvAPI_D3D11_EndUAVOverlap(m_Context.immediateContext);
+            NvAPI_D3D11_EndUAVOverlap(m_DeviceContext);
 #endif
 
         m_NumUAVOverlapCommands = std::max(0, m_NumUAVOverlapCommands - 1);
@@ -146,8 +192,10 @@ namespace nvrhi::d3d11
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
         {
+            // The Aftermath context handle belongs to the immediate context, so deferred lists only track the marker
             const size_t aftermathMarker = m_AftermathTracker.pushEvent(name);
-            GFSDK_Aftermath_SetEventMarker(m_Context.aftermathContext, (const void*)aftermathMarker, 0);
+            if (!isDeferred())
+                GFSDK_Aftermath_SetEventMarker(m_Context.aftermathContext, (const void*)aftermathMarker, 0);
         }
 #endif
     }
@@ -164,18 +212,31 @@ namespace nvrhi::d3d11
 #endif
     }
     
-    static char g_PushConstantPaddingBuffer[c_MaxPushConstantSize] = {};
-
     void CommandList::setPushConstants(const void* data, size_t byteSize)
     {
         if (byteSize > c_MaxPushConstantSize)
             return;
 
-        memcpy(g_PushConstantPaddingBuffer, data, byteSize);
+        // Deferred command lists may be recorded on several threads at once, so the padding buffer can't be shared
+        char paddingBuffer[c_MaxPushConstantSize] = {};
+        memcpy(paddingBuffer, data, byteSize);
 
-        m_Context.immediateContext->UpdateSubresource(
+        // UpdateSubresource on a deferred context copies the data into the command list,
+        // so every recorded version of the push constants is preserved until playback
+        m_DeviceContext->UpdateSubresource(
             m_Context.pushConstantBuffer, 0, nullptr, 
-            g_PushConstantPaddingBuffer, 0, 0);
+            paddingBuffer, 0, 0);
+    }
+
+    void CommandList::setPushBindings(uint32_t, const BindingSetDesc&)
+    {
+        utils::NotSupported();
+    }
+
+    BindingSetHandle CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        // DX11 binding sets are just arrays of views, so there is nothing to gain from transient allocation
+        return m_Device->createBindingSet(desc, layout);
     }
 
     void CommandList::setMeshletState(const MeshletState&)
@@ -188,6 +249,31 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::dispatchMeshIndirect(uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::setWorkGraphState(const WorkGraphState&)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::dispatchGraph(const WorkGraphDispatchArguments&)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::executeIndirect(ICommandSignature*, uint32_t, uint32_t, IBuffer*, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::setRayTracingState(const rt::State&)
     {
         utils::NotSupported();
@@ -203,11 +289,26 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc*, size_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::compactOpacityMicromaps()
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct*, const rt::GeometryDesc*, size_t, rt::AccelStructBuildFlags)
     {
         utils::NotSupported();
     }
 
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc*, size_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::compactBottomLevelAccelStructs()
     {
         utils::NotSupported();
@@ -223,6 +324,11 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct*, nvrhi::IBuffer*, uint64_t, nvrhi::IBuffer*, uint64_t, size_t, rt::AccelStructBuildFlags)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc&)
     {
         utils::NotSupported();
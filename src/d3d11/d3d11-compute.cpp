@@ -29,8 +29,11 @@ namespace nvrhi::d3d11
 
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d11::createComputePipeline");
+
         ComputePipeline *pso = new ComputePipeline();
         pso->desc = desc;
+        pso->statsEntry.set(&m_Stats, LiveObjectType::ComputePipeline);
 
         if (desc.CS) pso->shader = checked_cast<Shader*>(desc.CS.Get())->CS;
 
@@ -53,8 +56,17 @@ namespace nvrhi::d3d11
         bool updatePipeline = !m_CurrentComputeStateValid || pso != m_CurrentComputePipeline;
         bool updateBindings = updatePipeline || arraysAreDifferent(m_CurrentBindings, state.bindings);
 
-        if (updatePipeline) m_Context.immediateContext->CSSetShader(pso->shader, nullptr, 0);
-        if (updateBindings) bindComputeResourceSets(state.bindings, m_CurrentComputeStateValid ? &m_CurrentBindings : nullptr);
+        if (updatePipeline)
+        {
+            m_DeviceContext->CSSetShader(pso->shader, nullptr, 0);
+            ++m_Stats.pipelineBinds;
+        }
+
+        if (updateBindings)
+        {
+            bindComputeResourceSets(state.bindings, m_CurrentComputeStateValid ? &m_CurrentBindings : nullptr);
+            m_Stats.bindingSetBinds += state.bindings.size();
+        }
 
         m_CurrentIndirectBuffer = state.indirectParams;
 
@@ -74,16 +86,19 @@ namespace nvrhi::d3d11
 
     void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
     {
-        m_Context.immediateContext->Dispatch(groupsX, groupsY, groupsZ);
+        ++m_Stats.dispatches;
+        m_DeviceContext->Dispatch(groupsX, groupsY, groupsZ);
     }
 
     void CommandList::dispatchIndirect(uint32_t offsetBytes)
     {
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentIndirectBuffer.Get());
-        
+
+        ++m_Stats.dispatches;
+
         if (indirectParams) // validation layer will issue an error otherwise
         {
-            m_Context.immediateContext->DispatchIndirect(indirectParams->resource, (UINT)offsetBytes);
+            m_DeviceContext->DispatchIndirect(indirectParams->resource, (UINT)offsetBytes);
         }
     }
 
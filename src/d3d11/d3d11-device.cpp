@@ -22,6 +22,7 @@
 
 #include "d3d11-backend.h"
 
+#include <nvrhi/common/misc.h>
 #include <nvrhi/utils.h>
 #include <sstream>
 #include <iomanip>
@@ -51,6 +52,10 @@ namespace nvrhi::d3d11
         m_Context.immediateContext->QueryInterface(IID_PPV_ARGS(&m_Context.immediateContext1));
         desc.context->GetDevice(&m_Context.device);
 
+        D3D11_FEATURE_DATA_THREADING threadingSupport = {};
+        if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threadingSupport, sizeof(threadingSupport))))
+            m_Context.driverCommandLists = threadingSupport.DriverCommandLists != FALSE;
+
 #if NVRHI_D3D11_WITH_NVAPI
         m_Context.nvapiAvailable = NvAPI_Initialize() == NVAPI_OK;
 
@@ -118,7 +123,7 @@ namespace nvrhi::d3d11
             m_Context.error(ss.str());
         }
 
-        m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, CommandListParameters()));   
+        m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, CommandListParameters(), m_Context.immediateContext));
     }
 
     Device::~Device()
@@ -164,19 +169,78 @@ namespace nvrhi::d3d11
 
     CommandListHandle Device::createCommandList(const CommandListParameters& params)
     {
-        if (!params.enableImmediateExecution)
+        if (params.queueType != CommandQueue::Graphics)
         {
-            m_Context.error("Deferred command lists are not supported by the D3D11 backend.");
+            m_Context.error("Non-graphics queues are not supported by the D3D11 backend.");
             return nullptr;
         }
 
-        if (params.queueType != CommandQueue::Graphics)
+        if (params.isSecondary)
         {
-            m_Context.error("Non-graphics queues are not supported by the D3D11 backend.");
+            m_Context.error("Secondary command lists are not supported by the D3D11 backend.");
             return nullptr;
         }
-        
-        return m_ImmediateCommandList;
+
+        if (params.isReusable)
+        {
+            m_Context.error("Reusable command lists are not supported by the D3D11 backend.");
+            return nullptr;
+        }
+
+        if (params.enableImmediateExecution)
+            return m_ImmediateCommandList;
+
+        // Each deferred command list gets its own deferred context, so that they can be recorded on different threads
+        RefCountPtr<ID3D11DeviceContext> deferredContext;
+        const HRESULT res = m_Context.device->CreateDeferredContext(0, &deferredContext);
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateDeferredContext call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        return CommandListHandle::Create(new CommandList(m_Context, this, params, deferredContext));
+    }
+
+    uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d11::executeCommandLists");
+
+        (void)executionQueue;
+
+        bool anyDeferred = false;
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+
+            // Nothing stays in flight, the driver keeps the resources of the commands alive
+            m_Stats.commandListSubmitted(commandList->getStats(), 0);
+            m_Stats.commandListRetired(0);
+
+            // Immediate command lists have already executed their commands while recording
+            if (!commandList->isDeferred())
+                continue;
+
+            ID3D11CommandList* recordedCommandList = commandList->getRecordedCommandList();
+            if (!recordedCommandList)
+            {
+                m_Context.error("Cannot execute a deferred command list that has not been closed");
+                continue;
+            }
+
+            m_Context.immediateContext->ExecuteCommandList(recordedCommandList, FALSE);
+            anyDeferred = true;
+        }
+
+        // Playback without restoring the context state leaves the immediate context in the default state,
+        // so the immediate command list has to rebind everything on its next use
+        if (anyDeferred)
+            checked_cast<CommandList*>(m_ImmediateCommandList.Get())->invalidateStateCache();
+
+        return 0;
     }
 
     void Device::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
@@ -305,6 +369,11 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc&, IGraphicsPipeline*)
+    {
+        return nullptr;
+    }
+
     rt::OpacityMicromapHandle Device::createOpacityMicromap(const rt::OpacityMicromapDesc& )
     {
         utils::NotSupported();
@@ -346,6 +415,12 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
+    WorkGraphPipelineHandle Device::createWorkGraphPipeline(const WorkGraphPipelineDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
     bool Device::waitForIdle()
     {
         if (!m_WaitForIdleQuery)
@@ -408,9 +483,47 @@ namespace nvrhi::d3d11
         Sampler* sampler = new Sampler();
         sampler->sampler = sState;
         sampler->desc = d;
+        sampler->statsEntry.set(&m_Stats, LiveObjectType::Sampler);
         return SamplerHandle::Create(sampler);
     }
 
+    MemoryAllocatorStats Device::getMemoryAllocatorStats()
+    {
+        // Resource memory is managed by the D3D11 runtime
+        return MemoryAllocatorStats();
+    }
+
+    MemoryBudget Device::getMemoryBudget()
+    {
+        return MemoryBudget();
+    }
+
+    AccelStructStats Device::getAccelStructStats()
+    {
+        // Ray tracing is not supported on D3D11
+        return AccelStructStats();
+    }
+
+    DeviceStats Device::getDeviceStats()
+    {
+        // The descriptors are managed by the driver
+        return m_Stats.getStats();
+    }
+
+    bool Device::getProfilerFrameResults(ProfilerFrameResults& outResults)
+    {
+        // The GPU profiler is not implemented on D3D11
+        (void)outResults;
+        return false;
+    }
+
+    bool Device::getPipelineCacheData(std::vector<uint8_t>& data)
+    {
+        // Pipeline caching is managed by the D3D11 driver
+        (void)data;
+        return false;
+    }
+
     coopvec::DeviceFeatures Device::queryCoopVecFeatures()
     {
         utils::NotSupported();
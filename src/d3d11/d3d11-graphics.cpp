@@ -35,6 +35,7 @@ namespace nvrhi::d3d11
         Framebuffer *ret = new Framebuffer();
         ret->desc = desc;
         ret->framebufferInfo = FramebufferInfoEx(desc);
+        ret->statsEntry.set(&m_Stats, LiveObjectType::Framebuffer);
 
         for(auto colorAttachment : desc.colorAttachments)
         {
@@ -52,6 +53,8 @@ namespace nvrhi::d3d11
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d11::createGraphicsPipeline");
+
         const RenderState& renderState = desc.renderState;
 
         if (desc.renderState.singlePassStereo.enabled && !m_SinglePassStereoSupported)
@@ -63,6 +66,7 @@ namespace nvrhi::d3d11
         GraphicsPipeline *pso = new GraphicsPipeline();
         pso->desc = desc;
         pso->framebufferInfo = fbinfo;
+        pso->statsEntry.set(&m_Stats, LiveObjectType::GraphicsPipeline);
 
         pso->primitiveTopology = convertPrimType(desc.primType, desc.patchControlPoints);
         pso->inputLayout = checked_cast<InputLayout*>(desc.inputLayout.Get());
@@ -114,16 +118,16 @@ namespace nvrhi::d3d11
 
     void CommandList::bindGraphicsPipeline(const GraphicsPipeline* pso) const
     {
-        m_Context.immediateContext->IASetPrimitiveTopology(pso->primitiveTopology);
-        m_Context.immediateContext->IASetInputLayout(pso->inputLayout ? pso->inputLayout->layout : nullptr);
+        m_DeviceContext->IASetPrimitiveTopology(pso->primitiveTopology);
+        m_DeviceContext->IASetInputLayout(pso->inputLayout ? pso->inputLayout->layout : nullptr);
 
-        m_Context.immediateContext->RSSetState(pso->pRS);
+        m_DeviceContext->RSSetState(pso->pRS);
 
-        m_Context.immediateContext->VSSetShader(pso->pVS, nullptr, 0);
-        m_Context.immediateContext->HSSetShader(pso->pHS, nullptr, 0);
-        m_Context.immediateContext->DSSetShader(pso->pDS, nullptr, 0);
-        m_Context.immediateContext->GSSetShader(pso->pGS, nullptr, 0);
-        m_Context.immediateContext->PSSetShader(pso->pPS, nullptr, 0);
+        m_DeviceContext->VSSetShader(pso->pVS, nullptr, 0);
+        m_DeviceContext->HSSetShader(pso->pHS, nullptr, 0);
+        m_DeviceContext->DSSetShader(pso->pDS, nullptr, 0);
+        m_DeviceContext->GSSetShader(pso->pGS, nullptr, 0);
+        m_DeviceContext->PSSetShader(pso->pPS, nullptr, 0);
     }
 
     static DX11_ViewportState convertViewportState(const ViewportState& vpState)
@@ -153,8 +157,45 @@ namespace nvrhi::d3d11
         return ret;
     }
 
+    void CommandList::applyFramebufferLoadOps(Framebuffer* framebuffer)
+    {
+        if (framebuffer == m_LastLoadedFramebuffer)
+            return;
+
+        m_LastLoadedFramebuffer = framebuffer;
+
+        for (size_t rtIndex = 0; rtIndex < framebuffer->RTVs.size(); rtIndex++)
+        {
+            const FramebufferAttachment& attachment = framebuffer->desc.colorAttachments[rtIndex];
+
+            if (attachment.loadOp == AttachmentLoadOp::Clear)
+                m_DeviceContext->ClearRenderTargetView(framebuffer->RTVs[rtIndex], &attachment.clearColor.r);
+            else if (attachment.loadOp == AttachmentLoadOp::DontCare && m_DeviceContext1)
+                m_DeviceContext1->DiscardView(framebuffer->RTVs[rtIndex]);
+        }
+
+        const FramebufferAttachment& depthAttachment = framebuffer->desc.depthAttachment;
+        if (framebuffer->DSV)
+        {
+            if (depthAttachment.loadOp == AttachmentLoadOp::Clear)
+            {
+                UINT clearFlags = D3D11_CLEAR_DEPTH;
+                if (getFormatInfo(depthAttachment.texture->getDesc().format).hasStencil)
+                    clearFlags |= D3D11_CLEAR_STENCIL;
+
+                m_DeviceContext->ClearDepthStencilView(framebuffer->DSV, clearFlags, depthAttachment.clearDepth, depthAttachment.clearStencil);
+            }
+            else if (depthAttachment.loadOp == AttachmentLoadOp::DontCare && m_DeviceContext1)
+            {
+                m_DeviceContext1->DiscardView(framebuffer->DSV);
+            }
+        }
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d11::setGraphicsState");
+
         GraphicsPipeline* pipeline = checked_cast<GraphicsPipeline*>(state.pipeline);
         Framebuffer* framebuffer = checked_cast<Framebuffer*>(state.framebuffer);
 
@@ -183,12 +224,6 @@ namespace nvrhi::d3d11
         const bool updateIndexBuffer = !m_CurrentGraphicsStateValid || m_CurrentIndexBufferBinding != state.indexBuffer;
         const bool updateVertexBuffers = !m_CurrentGraphicsStateValid || arraysAreDifferent(m_CurrentVertexBufferBindings, state.vertexBuffers);
 
-        BindingSetVector setsToBind;
-        if (updateBindings)
-        {
-            prepareToBindGraphicsResourceSets(state.bindings, m_CurrentGraphicsStateValid ? &m_CurrentBindings : nullptr, m_CurrentGraphicsPipeline, state.pipeline, updateFramebuffer, setsToBind);
-        }
-
         if (updateFramebuffer || checked_cast<GraphicsPipeline*>(m_CurrentGraphicsPipeline.Get())->pixelShaderHasUAVs != pipeline->pixelShaderHasUAVs)
         {
             static_vector<ID3D11RenderTargetView*, c_MaxRenderTargets> RTVs;
@@ -199,22 +234,28 @@ namespace nvrhi::d3d11
 
             if (pipeline->pixelShaderHasUAVs)
             {
-                m_Context.immediateContext->OMSetRenderTargetsAndUnorderedAccessViews(
+                m_DeviceContext->OMSetRenderTargetsAndUnorderedAccessViews(
                     UINT(RTVs.size()), RTVs.data(),
                     framebuffer->DSV,
                     D3D11_KEEP_UNORDERED_ACCESS_VIEWS, 0, nullptr, nullptr);
             }
             else
             {
-                m_Context.immediateContext->OMSetRenderTargets(
+                m_DeviceContext->OMSetRenderTargets(
                     UINT(RTVs.size()),RTVs.data(),
                     framebuffer->DSV);
             }
+
+            for (ShaderStageBindingCache& cache : m_GraphicsStageBindings)
+                cache.invalidateShaderResources();
+
+            applyFramebufferLoadOps(framebuffer);
         }
 
         if (updatePipeline)
         {
             bindGraphicsPipeline(pipeline);
+            ++m_Stats.pipelineBinds;
         }
 
         if (updatePipeline || updateStencilRef)
@@ -222,18 +263,19 @@ namespace nvrhi::d3d11
             m_CurrentStencilRefValue = pipeline->desc.renderState.depthStencilState.dynamicStencilRef
                 ? state.dynamicStencilRefValue
                 : pipeline->desc.renderState.depthStencilState.stencilRefValue;
-            m_Context.immediateContext->OMSetDepthStencilState(pipeline->pDepthStencilState, m_CurrentStencilRefValue);
+            m_DeviceContext->OMSetDepthStencilState(pipeline->pDepthStencilState, m_CurrentStencilRefValue);
         }
 
         if (updatePipeline || updateBlendState)
         {
             float blendFactor[4]{ state.blendConstantColor.r, state.blendConstantColor.g, state.blendConstantColor.b, state.blendConstantColor.a };
-            m_Context.immediateContext->OMSetBlendState(pipeline->pBlendState, blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
+            m_DeviceContext->OMSetBlendState(pipeline->pBlendState, blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
         }
 
         if (updateBindings)
         {
-            bindGraphicsResourceSets(setsToBind, state.pipeline);
+            bindGraphicsResourceSets(state.bindings, m_CurrentGraphicsStateValid ? &m_CurrentBindings : nullptr, m_CurrentGraphicsPipeline, state.pipeline);
+            m_Stats.bindingSetBinds += state.bindings.size();
 
             if (pipeline->pixelShaderHasUAVs)
             {
@@ -256,7 +298,10 @@ namespace nvrhi::d3d11
                     maxUAVSlot = std::max(maxUAVSlot, bindingSet->maxUAVSlot);
                 }
 
-                m_Context.immediateContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
+                m_DeviceContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
+
+                for (ShaderStageBindingCache& cache : m_GraphicsStageBindings)
+                    cache.invalidateShaderResources();
             }
         }
 
@@ -266,12 +311,12 @@ namespace nvrhi::d3d11
 
             if (vpState.numViewports)
             {
-                m_Context.immediateContext->RSSetViewports(vpState.numViewports, vpState.viewports);
+                m_DeviceContext->RSSetViewports(vpState.numViewports, vpState.viewports);
             }
 
             if (vpState.numScissorRects)
             {
-                m_Context.immediateContext->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+                m_DeviceContext->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
             }
         }
 
@@ -282,7 +327,7 @@ namespace nvrhi::d3d11
         {
             const SinglePassStereoState& spsState = pipeline->desc.renderState.singlePassStereo;
 
-            NvAPI_Status Status = NvAPI_D3D_SetSinglePassStereoMode(m_Context.immediateContext, spsState.enabled ? 2 : 1, spsState.renderTargetIndexOffset, spsState.independentViewportMask);
+            NvAPI_Status Status = NvAPI_D3D_SetSinglePassStereoMode(m_DeviceContext, spsState.enabled ? 2 : 1, spsState.renderTargetIndexOffset, spsState.independentViewportMask);
 
             if (Status != NVAPI_OK)
             {
@@ -326,7 +371,7 @@ namespace nvrhi::d3d11
                 }
             }
 
-            m_Context.immediateContext->IASetVertexBuffers(0, maxVbIndex + 1,
+            m_DeviceContext->IASetVertexBuffers(0, maxVbIndex + 1,
                 pVertexBuffers,
                 pVertexBufferStrides,
                 pVertexBufferOffsets);
@@ -336,13 +381,13 @@ namespace nvrhi::d3d11
         {
             if (state.indexBuffer.buffer)
             {
-                m_Context.immediateContext->IASetIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->resource,
+                m_DeviceContext->IASetIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->resource,
                     getDxgiFormatMapping(state.indexBuffer.format).srvFormat,
                     state.indexBuffer.offset);
             }
             else
             {
-                m_Context.immediateContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
+                m_DeviceContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
             }
         }
 
@@ -374,26 +419,158 @@ namespace nvrhi::d3d11
         }
     }
 
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        assert(m_CurrentGraphicsStateValid);
+
+        if (slot < m_CurrentBindings.size() && m_CurrentBindings[slot] == bindingSet)
+            return;
+
+        // Binding set changes go through the regular path because of the UAV slot merging between sets,
+        // which is still cheap on DX11 as there are no barriers to compute.
+        GraphicsState state;
+        state.pipeline = m_CurrentGraphicsPipeline;
+        state.framebuffer = m_CurrentFramebuffer;
+        state.viewport = m_CurrentViewports;
+        state.blendConstantColor = m_CurrentBlendConstantColor;
+        state.dynamicStencilRefValue = m_CurrentStencilRefValue;
+        state.vertexBuffers = m_CurrentVertexBufferBindings;
+        state.indexBuffer = m_CurrentIndexBufferBinding;
+        state.indirectParams = m_CurrentIndirectBuffer;
+
+        for (const auto& binding : m_CurrentBindings)
+            state.bindings.push_back(binding);
+
+        while (state.bindings.size() <= slot)
+            state.bindings.push_back(nullptr);
+
+        state.bindings[slot] = bindingSet;
+
+        setGraphicsState(state);
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings)
+    {
+        assert(m_CurrentGraphicsStateValid);
+
+        const auto* inputLayout = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsPipeline.Get())->inputLayout;
+
+        for (size_t i = 0; i < numBindings; i++)
+        {
+            const VertexBufferBinding& binding = pBindings[i];
+
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            assert(binding.offset <= UINT_MAX);
+
+            size_t index = 0;
+            while (index < m_CurrentVertexBufferBindings.size() && m_CurrentVertexBufferBindings[index].slot != binding.slot)
+                index++;
+
+            if (index == m_CurrentVertexBufferBindings.size())
+            {
+                m_CurrentVertexBufferBindings.push_back(binding);
+                m_CurrentVertexBuffers.push_back(binding.buffer);
+            }
+            else if (m_CurrentVertexBufferBindings[index] != binding)
+            {
+                m_CurrentVertexBufferBindings[index] = binding;
+                m_CurrentVertexBuffers[index] = binding.buffer;
+            }
+            else
+                continue;
+
+            ID3D11Buffer* pVertexBuffer = checked_cast<Buffer*>(binding.buffer)->resource;
+            UINT stride = inputLayout->elementStrides.at(binding.slot);
+            UINT offset = UINT(binding.offset);
+
+            m_DeviceContext->IASetVertexBuffers(binding.slot, 1, &pVertexBuffer, &stride, &offset);
+        }
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        assert(m_CurrentGraphicsStateValid);
+
+        if (!binding.buffer || m_CurrentIndexBufferBinding == binding)
+            return;
+
+        m_DeviceContext->IASetIndexBuffer(checked_cast<Buffer*>(binding.buffer)->resource,
+            getDxgiFormatMapping(binding.format).srvFormat,
+            binding.offset);
+
+        m_CurrentIndexBufferBinding = binding;
+        m_CurrentIndexBuffer = binding.buffer;
+    }
+
     void CommandList::draw(const DrawArguments& args)
     {
-        m_Context.immediateContext->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
+        ++m_Stats.drawCalls;
+        m_DeviceContext->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
     }
 
     void CommandList::drawIndexed(const DrawArguments& args)
     {
-        m_Context.immediateContext->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
+        ++m_Stats.drawCalls;
+        m_DeviceContext->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
+    }
+
+    void CommandList::drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        if (pushConstantStride == 0)
+            pushConstantStride = pushConstantByteSize;
+
+        const uint8_t* pushConstantData = static_cast<const uint8_t*>(pushConstants);
+
+        m_Stats.drawCalls += count;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pushConstantData)
+            {
+                setPushConstants(pushConstantData, pushConstantByteSize);
+                pushConstantData += pushConstantStride;
+            }
+
+            m_DeviceContext->DrawInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startVertexLocation, args[i].startInstanceLocation);
+        }
+    }
+
+    void CommandList::drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        if (pushConstantStride == 0)
+            pushConstantStride = pushConstantByteSize;
+
+        const uint8_t* pushConstantData = static_cast<const uint8_t*>(pushConstants);
+
+        m_Stats.drawCalls += count;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pushConstantData)
+            {
+                setPushConstants(pushConstantData, pushConstantByteSize);
+                pushConstantData += pushConstantStride;
+            }
+
+            m_DeviceContext->DrawIndexedInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startIndexLocation, args[i].startVertexLocation, args[i].startInstanceLocation);
+        }
     }
 
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentIndirectBuffer.Get());
 
+        ++m_Stats.drawCalls;
+
         if (indirectParams) // validation layer will issue an error otherwise
         {
             // Simulate multi-command D3D12 ExecuteIndirect or Vulkan vkCmdDrawIndirect with a loop
             for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
             {
-                m_Context.immediateContext->DrawInstancedIndirect(indirectParams->resource, offsetBytes);
+                m_DeviceContext->DrawInstancedIndirect(indirectParams->resource, offsetBytes);
                 offsetBytes += sizeof(DrawIndirectArguments);
             }
         }
@@ -403,12 +580,14 @@ namespace nvrhi::d3d11
     {
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentIndirectBuffer.Get());
 
+        ++m_Stats.drawCalls;
+
         if (indirectParams)
         {
             // Simulate multi-command D3D12 ExecuteIndirect or Vulkan vkCmdDrawIndirect with a loop
             for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
             {
-                m_Context.immediateContext->DrawIndexedInstancedIndirect(indirectParams->resource, offsetBytes);
+                m_DeviceContext->DrawIndexedInstancedIndirect(indirectParams->resource, offsetBytes);
                 offsetBytes += sizeof(DrawIndexedIndirectArguments);
             }
         }
@@ -440,6 +619,8 @@ namespace nvrhi::d3d11
             hash_combine(hash, target.colorWriteMask);
         }
 
+        std::lock_guard lockGuard(m_StateCacheMutex);
+
         RefCountPtr<ID3D11BlendState> d3dBlendState = m_BlendStates[hash];
 
         if (d3dBlendState)
@@ -496,6 +677,8 @@ namespace nvrhi::d3d11
         hash_combine(hash, depthState.backFaceStencil.passOp);
         hash_combine(hash, depthState.backFaceStencil.stencilFunc);
 
+        std::lock_guard lockGuard(m_StateCacheMutex);
+
         RefCountPtr<ID3D11DepthStencilState> d3dDepthStencilState = m_DepthStencilStates[hash];
 
         if (d3dDepthStencilState)
@@ -557,6 +740,8 @@ namespace nvrhi::d3d11
             }
         }
 
+        std::lock_guard lockGuard(m_StateCacheMutex);
+
         RefCountPtr<ID3D11RasterizerState> d3dRasterizerState = m_RasterizerStates[hash];
 
         if (d3dRasterizerState)
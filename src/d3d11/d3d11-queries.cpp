@@ -26,6 +26,7 @@
 #include <nvrhi/common/misc.h>
 #include <nvrhi/utils.h>
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -121,6 +122,103 @@ void Device::resetEventQuery(IEventQuery* _query)
     query->resolved = false;
 }
 
+SubmissionTicket Device::getSubmissionTicket(CommandQueue queue)
+{
+    (void)queue;
+
+    RefCountPtr<ID3D11Query> query;
+    if (!m_FreeTicketQueries.empty())
+    {
+        query = std::move(m_FreeTicketQueries.back());
+        m_FreeTicketQueries.pop_back();
+    }
+    else
+    {
+        D3D11_QUERY_DESC queryDesc;
+        queryDesc.Query = D3D11_QUERY_EVENT;
+        queryDesc.MiscFlags = 0;
+
+        if (!checkedCreateQuery(queryDesc, "SubmissionTicket", m_Context, &query))
+            return SubmissionTicket();
+    }
+
+    m_Context.immediateContext->End(query.Get());
+
+    TicketQuery ticketQuery;
+    ticketQuery.instance = ++m_LastTicketInstance;
+    ticketQuery.query = std::move(query);
+    m_TicketQueries.push_back(std::move(ticketQuery));
+
+    return SubmissionTicket()
+        .setQueue(CommandQueue::Graphics)
+        .setInstance(m_LastTicketInstance);
+}
+
+bool Device::retireTicketQueries(uint64_t instance, bool wait, std::chrono::steady_clock::time_point deadline)
+{
+    while (m_CompletedTicketInstance < instance && !m_TicketQueries.empty())
+    {
+        TicketQuery& ticketQuery = m_TicketQueries.front();
+
+        HRESULT hr;
+        do {
+            hr = m_Context.immediateContext->GetData(ticketQuery.query.Get(), nullptr, 0, wait ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH);
+        } while (wait && hr == S_FALSE && std::chrono::steady_clock::now() < deadline);
+
+        if (hr != S_OK)
+            return false;
+
+        m_CompletedTicketInstance = ticketQuery.instance;
+        m_FreeTicketQueries.push_back(std::move(ticketQuery.query));
+        m_TicketQueries.pop_front();
+    }
+
+    return m_CompletedTicketInstance >= instance;
+}
+
+bool Device::pollSubmission(const SubmissionTicket& ticket)
+{
+    if (ticket.instance > m_LastTicketInstance)
+        return false;
+
+    return retireTicketQueries(ticket.instance, false, std::chrono::steady_clock::time_point());
+}
+
+bool Device::waitForTicketInstance(uint64_t instance, uint64_t timeoutNanoseconds)
+{
+    if (instance > m_LastTicketInstance)
+        return false;
+
+    const auto deadline = (timeoutNanoseconds == ~0ull)
+        ? std::chrono::steady_clock::time_point::max()
+        : std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(timeoutNanoseconds));
+
+    return retireTicketQueries(instance, true, deadline);
+}
+
+// There is only one queue, so waiting for all tickets is waiting for the newest one, and waiting for any is waiting for the oldest one
+
+bool Device::waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+{
+    uint64_t instance = 0;
+    for (size_t i = 0; i < numTickets; i++)
+        instance = std::max(instance, tickets[i].instance);
+
+    return waitForTicketInstance(instance, timeoutNanoseconds);
+}
+
+bool Device::waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+{
+    if (numTickets == 0)
+        return false;
+
+    uint64_t instance = ~0ull;
+    for (size_t i = 0; i < numTickets; i++)
+        instance = std::min(instance, tickets[i].instance);
+
+    return waitForTicketInstance(instance, timeoutNanoseconds);
+}
+
 TimerQueryHandle Device::createTimerQuery(void)
 {
     TimerQuery *ret = new TimerQuery();
@@ -159,8 +257,8 @@ void CommandList::beginTimerQuery(ITimerQuery* _query)
     TimerQuery* query = checked_cast<TimerQuery*>(_query);
 
     assert(!query->resolved);
-    m_Context.immediateContext->Begin(query->disjoint.Get());
-    m_Context.immediateContext->End(query->start.Get());
+    m_DeviceContext->Begin(query->disjoint.Get());
+    m_DeviceContext->End(query->start.Get());
 }
 
 void CommandList::endTimerQuery(ITimerQuery* _query)
@@ -168,8 +266,8 @@ void CommandList::endTimerQuery(ITimerQuery* _query)
     TimerQuery* query = checked_cast<TimerQuery*>(_query);
 
     assert(!query->resolved);
-    m_Context.immediateContext->End(query->end.Get());
-    m_Context.immediateContext->End(query->disjoint.Get());
+    m_DeviceContext->End(query->end.Get());
+    m_DeviceContext->End(query->disjoint.Get());
 }
 
 bool Device::pollTimerQuery(ITimerQuery* _query)
@@ -45,9 +45,12 @@ BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc&)
 
 BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
 {
+    NVRHI_PROFILE_SCOPE("nvrhi::d3d11::createBindingSet");
+
     BindingSet *ret = new BindingSet();
     ret->desc = desc;
     ret->layout = layout;
+    ret->statsEntry.set(&m_Stats, LiveObjectType::BindingSet);
     ret->visibility = layout->getDesc()->visibility;
 
     // See https://learn.microsoft.com/en-us/windows/win32/api/d3d11_1/nf-d3d11_1-id3d11devicecontext1-vssetconstantbuffers1 
@@ -191,313 +194,285 @@ bool Device::writeDescriptorTable(IDescriptorTable*, const BindingSetItem&)
     return false;
 }
 
-static ID3D11Buffer *NullCBs[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = { nullptr };
-static ID3D11ShaderResourceView *NullSRVs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = { nullptr };
-static ID3D11SamplerState *NullSamplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = { nullptr };
-static ID3D11UnorderedAccessView *NullUAVs[D3D11_PS_CS_UAV_REGISTER_COUNT] = { 0 };
-static UINT NullUAVInitialCounts[D3D11_PS_CS_UAV_REGISTER_COUNT] = { 0 };
+static const ShaderType c_GraphicsStages[] = {
+    ShaderType::Vertex,
+    ShaderType::Hull,
+    ShaderType::Domain,
+    ShaderType::Geometry,
+    ShaderType::Pixel
+};
 
-bool BindingSet::isSupersetOf(const BindingSet& other) const
+template<typename T, uint32_t N>
+void ShaderStageBindingCache::Slots<T, N>::write(uint32_t slot, const T& value)
 {
-    return minSRVSlot <= other.minSRVSlot && maxSRVSlot >= other.maxSRVSlot
-        && minUAVSlot <= other.minUAVSlot && maxUAVSlot >= other.maxUAVSlot
-        && minSamplerSlot <= other.minSamplerSlot && maxSamplerSlot >= other.maxSamplerSlot
-        && minConstantBufferSlot <= other.minConstantBufferSlot && maxConstantBufferSlot >= other.maxConstantBufferSlot;
+    pending[slot] = value;
+    dirtyMin = std::min(dirtyMin, slot);
+    dirtyMax = std::max(dirtyMax, slot);
 }
 
-#define D3D11_SET_ARRAY(method, min, max, array) \
-        if ((max) >= (min)) \
-            m_Context.immediateContext->method(min, ((max) - (min) + 1), &(array)[min])
-#define D3D11_SET_ARRAY1(method, min, max, array, offsets, counts) \
-        if ((max) >= (min)) \
-            m_Context.immediateContext1->method(min, ((max) - (min) + 1), &(array)[min], &(offsets)[min], &(counts)[min])
-
-void CommandList::prepareToBindGraphicsResourceSets(
-    const BindingSetVector& resourceSets, 
-    const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets,
-    const IGraphicsPipeline* _currentPipeline,
-    const IGraphicsPipeline* _newPipeline, 
-    bool updateFramebuffer, 
-    BindingSetVector& outSetsToBind) const
+template<typename T, uint32_t N>
+bool ShaderStageBindingCache::Slots<T, N>::getChangedRange(uint32_t& first, uint32_t& last) const
 {
-    outSetsToBind = resourceSets;
-
-    if (currentResourceSets)
-    {
-        assert(_currentPipeline);
+    // When forced, any slot that was bound might have been unbound by the runtime, so only the slots
+    // that are known to be empty on both sides can be skipped
+    const uint32_t begin = forceCommit ? 0 : dirtyMin;
+    const uint32_t end = forceCommit ? N - 1 : dirtyMax;
 
-        const GraphicsPipeline* currentPipeline = checked_cast<const GraphicsPipeline*>(_currentPipeline);
-        const GraphicsPipeline* newPipeline = checked_cast<const GraphicsPipeline*>(_newPipeline);
+    first = N;
+    last = 0;
 
-        BindingSetVector setsToUnbind;
-        
-        for (const BindingSetHandle& bindingSet : *currentResourceSets)
+    for (uint32_t slot = begin; slot <= end && slot < N; slot++)
+    {
+        if (pending[slot] != bound[slot] || (forceCommit && bound[slot] != T{}))
         {
-            setsToUnbind.push_back(bindingSet);
+            first = std::min(first, slot);
+            last = slot;
         }
+    }
 
-        if (currentPipeline->shaderMask == newPipeline->shaderMask)
-        {
-            for (uint32_t i = 0; i < uint32_t(outSetsToBind.size()); i++)
-            {
-                if (outSetsToBind[i])
-                    for (uint32_t j = 0; j < uint32_t(setsToUnbind.size()); j++)
-                    {
-                        if (outSetsToBind[i] == setsToUnbind[j])
-                        {
-                            outSetsToBind[i] = nullptr;
-                            setsToUnbind[j] = nullptr;
-                            break;
-                        }
-                    }
-            }
+    return first <= last;
+}
 
-            if (!updateFramebuffer)
-            {
-                for (uint32_t i = 0; i < uint32_t(outSetsToBind.size()); i++)
-                {
-                    if (outSetsToBind[i])
-                        for (uint32_t j = 0; j < uint32_t(setsToUnbind.size()); j++)
-                        {
-                            if (setsToUnbind[j] && checked_cast<BindingSet*>(outSetsToBind[i])->isSupersetOf(*checked_cast<BindingSet*>(setsToUnbind[j])))
-                            {
-                                setsToUnbind[j] = nullptr;
-                            }
-                        }
-                }
-            }
-        }
+template<typename T, uint32_t N>
+void ShaderStageBindingCache::Slots<T, N>::markCommitted(uint32_t first, uint32_t last)
+{
+    for (uint32_t slot = first; slot <= last; slot++)
+        bound[slot] = pending[slot];
 
-        for (IBindingSet* _set : setsToUnbind)
-        {
-            if (!_set)
-                continue;
+    dirtyMin = N;
+    dirtyMax = 0;
+    forceCommit = false;
+}
 
-            BindingSet* set = checked_cast<BindingSet*>(_set);
+void ShaderStageBindingCache::reset()
+{
+    m_ConstantBuffers = {};
+    m_ShaderResources = {};
+    m_Samplers = {};
+}
 
-            ShaderType stagesToUnbind = set->visibility & currentPipeline->shaderMask;
+void ShaderStageBindingCache::unbindSet(const BindingSet& set)
+{
+    for (uint32_t slot = set.minConstantBufferSlot; slot <= set.maxConstantBufferSlot && slot < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; slot++)
+        m_ConstantBuffers.write(slot, ConstantBufferBinding());
 
-            if ((stagesToUnbind & ShaderType::Vertex) != 0)
-            {
-                D3D11_SET_ARRAY(VSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(VSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(VSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
-            }
+    for (uint32_t slot = set.minSRVSlot; slot <= set.maxSRVSlot && slot < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; slot++)
+        m_ShaderResources.write(slot, nullptr);
 
-            if ((stagesToUnbind & ShaderType::Hull) != 0)
-            {
-                D3D11_SET_ARRAY(HSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(HSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(HSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
-            }
+    for (uint32_t slot = set.minSamplerSlot; slot <= set.maxSamplerSlot && slot < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT; slot++)
+        m_Samplers.write(slot, nullptr);
+}
 
-            if ((stagesToUnbind & ShaderType::Domain) != 0)
-            {
-                D3D11_SET_ARRAY(DSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(DSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(DSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
-            }
+void ShaderStageBindingCache::bindSet(const BindingSet& set)
+{
+    for (uint32_t slot = set.minConstantBufferSlot; slot <= set.maxConstantBufferSlot && slot < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; slot++)
+    {
+        ConstantBufferBinding binding;
+        binding.buffer = set.constantBuffers[slot];
+        binding.offset = set.constantBufferOffsets[slot];
+        binding.count = set.constantBufferCounts[slot];
+        m_ConstantBuffers.write(slot, binding);
+    }
 
-            if ((stagesToUnbind & ShaderType::Geometry) != 0)
-            {
-                D3D11_SET_ARRAY(GSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(GSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(GSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
-            }
+    for (uint32_t slot = set.minSRVSlot; slot <= set.maxSRVSlot && slot < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; slot++)
+        m_ShaderResources.write(slot, set.SRVs[slot]);
 
-            if ((stagesToUnbind & ShaderType::Pixel) != 0)
-            {
-                D3D11_SET_ARRAY(PSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(PSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(PSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
-            }
-        }
-    }
+    for (uint32_t slot = set.minSamplerSlot; slot <= set.maxSamplerSlot && slot < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT; slot++)
+        m_Samplers.write(slot, set.samplers[slot]);
 }
 
-
-void CommandList::bindGraphicsResourceSets(
-    const BindingSetVector& setsToBind,
-    const IGraphicsPipeline* newPipeline) const
+void ShaderStageBindingCache::commit(ID3D11DeviceContext* context, ID3D11DeviceContext1* context1, ShaderType stage)
 {
-    for(IBindingSet* _set : setsToBind)
-    {
-        if (!_set)
-            continue;
+    uint32_t first, last;
 
-        BindingSet* set = checked_cast<BindingSet*>(_set);
-        const GraphicsPipeline* pipeline = checked_cast<const GraphicsPipeline*>(newPipeline);
-
-        ShaderType stagesToBind = set->visibility & pipeline->shaderMask;
+    if (m_ConstantBuffers.getChangedRange(first, last))
+    {
+        ID3D11Buffer* buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+        UINT offsets[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+        UINT counts[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
 
-        if ((stagesToBind & ShaderType::Vertex) != 0)
+        const UINT numBuffers = last - first + 1;
+        for (UINT i = 0; i < numBuffers; i++)
         {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(VSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
-            {
-                D3D11_SET_ARRAY(VSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-            }
-            D3D11_SET_ARRAY(VSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(VSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
+            const ConstantBufferBinding& binding = m_ConstantBuffers.pending[first + i];
+            buffers[i] = binding.buffer;
+            offsets[i] = binding.offset;
+            counts[i] = binding.count;
         }
 
-        if ((stagesToBind & ShaderType::Hull) != 0)
+        if (context1)
         {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(HSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
+            switch (stage)
             {
-                D3D11_SET_ARRAY(HSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
+            case ShaderType::Vertex:   context1->VSSetConstantBuffers1(first, numBuffers, buffers, offsets, counts); break;
+            case ShaderType::Hull:     context1->HSSetConstantBuffers1(first, numBuffers, buffers, offsets, counts); break;
+            case ShaderType::Domain:   context1->DSSetConstantBuffers1(first, numBuffers, buffers, offsets, counts); break;
+            case ShaderType::Geometry: context1->GSSetConstantBuffers1(first, numBuffers, buffers, offsets, counts); break;
+            case ShaderType::Pixel:    context1->PSSetConstantBuffers1(first, numBuffers, buffers, offsets, counts); break;
+            case ShaderType::Compute:  context1->CSSetConstantBuffers1(first, numBuffers, buffers, offsets, counts); break;
+            default: utils::InvalidEnum(); break;
             }
-            D3D11_SET_ARRAY(HSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(HSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
         }
-
-        if ((stagesToBind & ShaderType::Domain) != 0)
+        else
         {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(DSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
+            switch (stage)
             {
-                D3D11_SET_ARRAY(DSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
+            case ShaderType::Vertex:   context->VSSetConstantBuffers(first, numBuffers, buffers); break;
+            case ShaderType::Hull:     context->HSSetConstantBuffers(first, numBuffers, buffers); break;
+            case ShaderType::Domain:   context->DSSetConstantBuffers(first, numBuffers, buffers); break;
+            case ShaderType::Geometry: context->GSSetConstantBuffers(first, numBuffers, buffers); break;
+            case ShaderType::Pixel:    context->PSSetConstantBuffers(first, numBuffers, buffers); break;
+            case ShaderType::Compute:  context->CSSetConstantBuffers(first, numBuffers, buffers); break;
+            default: utils::InvalidEnum(); break;
             }
-            D3D11_SET_ARRAY(DSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(DSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
         }
 
-        if ((stagesToBind & ShaderType::Geometry) != 0)
+        m_ConstantBuffers.markCommitted(first, last);
+    }
+
+    if (m_ShaderResources.getChangedRange(first, last))
+    {
+        const UINT numViews = last - first + 1;
+        ID3D11ShaderResourceView* const* views = &m_ShaderResources.pending[first];
+
+        switch (stage)
         {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(GSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
-            {
-                D3D11_SET_ARRAY(GSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-            }
-            D3D11_SET_ARRAY(GSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(GSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
+        case ShaderType::Vertex:   context->VSSetShaderResources(first, numViews, views); break;
+        case ShaderType::Hull:     context->HSSetShaderResources(first, numViews, views); break;
+        case ShaderType::Domain:   context->DSSetShaderResources(first, numViews, views); break;
+        case ShaderType::Geometry: context->GSSetShaderResources(first, numViews, views); break;
+        case ShaderType::Pixel:    context->PSSetShaderResources(first, numViews, views); break;
+        case ShaderType::Compute:  context->CSSetShaderResources(first, numViews, views); break;
+        default: utils::InvalidEnum(); break;
         }
 
-        if ((stagesToBind & ShaderType::Pixel) != 0)
+        m_ShaderResources.markCommitted(first, last);
+    }
+    else
+    {
+        m_ShaderResources.forceCommit = false;
+    }
+
+    if (m_Samplers.getChangedRange(first, last))
+    {
+        const UINT numSamplers = last - first + 1;
+        ID3D11SamplerState* const* samplers = &m_Samplers.pending[first];
+
+        switch (stage)
         {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(PSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
-            {
-                D3D11_SET_ARRAY(PSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-            }
-            D3D11_SET_ARRAY(PSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(PSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
+        case ShaderType::Vertex:   context->VSSetSamplers(first, numSamplers, samplers); break;
+        case ShaderType::Hull:     context->HSSetSamplers(first, numSamplers, samplers); break;
+        case ShaderType::Domain:   context->DSSetSamplers(first, numSamplers, samplers); break;
+        case ShaderType::Geometry: context->GSSetSamplers(first, numSamplers, samplers); break;
+        case ShaderType::Pixel:    context->PSSetSamplers(first, numSamplers, samplers); break;
+        case ShaderType::Compute:  context->CSSetSamplers(first, numSamplers, samplers); break;
+        default: utils::InvalidEnum(); break;
         }
+
+        m_Samplers.markCommitted(first, last);
     }
 }
 
-void CommandList::bindComputeResourceSets(
+void CommandList::bindGraphicsResourceSets(
     const BindingSetVector& resourceSets,
-    const static_vector<BindingSetHandle,c_MaxBindingLayouts>* currentResourceSets) const
+    const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets,
+    const IGraphicsPipeline* _currentPipeline,
+    const IGraphicsPipeline* _newPipeline)
 {
-    BindingSetVector setsToBind = resourceSets;
+    const GraphicsPipeline* currentPipeline = checked_cast<const GraphicsPipeline*>(_currentPipeline);
+    const GraphicsPipeline* newPipeline = checked_cast<const GraphicsPipeline*>(_newPipeline);
 
-    if (currentResourceSets)
+    for (uint32_t stageIndex = 0; stageIndex < uint32_t(std::size(c_GraphicsStages)); stageIndex++)
     {
-        BindingSetVector setsToUnbind;
+        const ShaderType stage = c_GraphicsStages[stageIndex];
+        ShaderStageBindingCache& cache = m_GraphicsStageBindings[stageIndex];
 
-        for (const BindingSetHandle& bindingSet : *currentResourceSets)
+        // Clear the slots of the previous sets first and overlay the new sets on top,
+        // the cache then drops whatever ends up the same as before
+        if (currentResourceSets)
         {
-            setsToUnbind.push_back(bindingSet);
-        }
+            assert(currentPipeline);
 
-        for (uint32_t i = 0; i < uint32_t(setsToBind.size()); i++)
-        {
-            if (setsToBind[i])
-                for (uint32_t j = 0; j < uint32_t(setsToUnbind.size()); j++)
-                {
-                    if (setsToBind[i] == setsToUnbind[j])
-                    {
-                        setsToBind[i] = nullptr;
-                        setsToUnbind[j] = nullptr;
-                        break;
-                    }
-                }
+            for (const BindingSetHandle& _set : *currentResourceSets)
+            {
+                const BindingSet* set = checked_cast<const BindingSet*>(_set.Get());
+
+                if (set && (set->visibility & currentPipeline->shaderMask & stage) != 0)
+                    cache.unbindSet(*set);
+            }
         }
-        
-        for (uint32_t i = 0; i < uint32_t(setsToBind.size()); i++)
+
+        for (IBindingSet* _set : resourceSets)
         {
-            if (setsToBind[i])
-                for (uint32_t j = 0; j < uint32_t(setsToUnbind.size()); j++)
-                {
-                    BindingSet* setToBind = checked_cast<BindingSet*>(setsToBind[i]);
-                    BindingSet* setToUnbind = checked_cast<BindingSet*>(setsToUnbind[j]);
-
-                    if (setToUnbind && setToBind->isSupersetOf(*setToUnbind) && setToUnbind->maxUAVSlot < setToUnbind->minUAVSlot)
-                    {
-                        setsToUnbind[j] = nullptr;
-                    }
-                }
+            const BindingSet* set = checked_cast<const BindingSet*>(_set);
+
+            if (set && (set->visibility & newPipeline->shaderMask & stage) != 0)
+                cache.bindSet(*set);
         }
 
-        for (IBindingSet* _set : setsToUnbind)
-        {
-            if (!_set)
-                continue;
+        cache.commit(m_DeviceContext, m_DeviceContext1, stage);
+    }
+}
 
-            BindingSet* set = checked_cast<BindingSet*>(_set);
+void CommandList::bindComputeResourceSets(
+    const BindingSetVector& resourceSets,
+    const static_vector<BindingSetHandle,c_MaxBindingLayouts>* currentResourceSets)
+{
+    ShaderStageBindingCache& cache = m_ComputeStageBindings;
+
+    ID3D11UnorderedAccessView* UAVs[D3D11_1_UAV_SLOT_COUNT] = {};
+    static const UINT initialCounts[D3D11_1_UAV_SLOT_COUNT] = {};
+    uint32_t minUAVSlot = D3D11_1_UAV_SLOT_COUNT;
+    uint32_t maxUAVSlot = 0;
 
-            if ((set->visibility & ShaderType::Compute) == 0)
+    if (currentResourceSets)
+    {
+        for (const BindingSetHandle& _set : *currentResourceSets)
+        {
+            const BindingSet* set = checked_cast<const BindingSet*>(_set.Get());
+
+            if (!set || (set->visibility & ShaderType::Compute) == 0)
                 continue;
 
-            D3D11_SET_ARRAY(CSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-            D3D11_SET_ARRAY(CSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-            D3D11_SET_ARRAY(CSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
+            cache.unbindSet(*set);
 
             if (set->maxUAVSlot >= set->minUAVSlot)
             {
-                m_Context.immediateContext->CSSetUnorderedAccessViews(set->minUAVSlot,
-                    set->maxUAVSlot - set->minUAVSlot + 1,
-                    NullUAVs,
-                    NullUAVInitialCounts);
+                minUAVSlot = std::min(minUAVSlot, set->minUAVSlot);
+                maxUAVSlot = std::max(maxUAVSlot, set->maxUAVSlot);
             }
         }
     }
 
-    for(IBindingSet* _set : resourceSets)
+    for (IBindingSet* _set : resourceSets)
     {
-        BindingSet* set = checked_cast<BindingSet*>(_set);
+        const BindingSet* set = checked_cast<const BindingSet*>(_set);
 
-        if ((set->visibility & ShaderType::Compute) == 0)
+        if (!set || (set->visibility & ShaderType::Compute) == 0)
             continue;
 
-        if (m_Context.immediateContext1)
-        {
-            D3D11_SET_ARRAY1(CSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-        }
-        else
-        {
-            D3D11_SET_ARRAY(CSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-        }
-        D3D11_SET_ARRAY(CSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-        D3D11_SET_ARRAY(CSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
+        cache.bindSet(*set);
 
         if (set->maxUAVSlot >= set->minUAVSlot)
         {
-            m_Context.immediateContext->CSSetUnorderedAccessViews(set->minUAVSlot,
-                set->maxUAVSlot - set->minUAVSlot + 1,
-                &set->UAVs[set->minUAVSlot],
-                NullUAVInitialCounts);
+            for (uint32_t slot = set->minUAVSlot; slot <= set->maxUAVSlot; slot++)
+                UAVs[slot] = set->UAVs[slot];
+
+            minUAVSlot = std::min(minUAVSlot, set->minUAVSlot);
+            maxUAVSlot = std::max(maxUAVSlot, set->maxUAVSlot);
         }
     }
+
+    // UAVs are always rebound when the bindings change because binding them resets the hidden counters.
+    // Bind them in one call for all sets, before the SRVs, as the runtime may unbind SRVs of the same resources.
+    if (maxUAVSlot >= minUAVSlot)
+    {
+        m_DeviceContext->CSSetUnorderedAccessViews(minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
+        cache.invalidateShaderResources();
+    }
+
+    cache.commit(m_DeviceContext, m_DeviceContext1, ShaderType::Compute);
 }
 
-#undef D3D11_SET_ARRAY
 
 } // namespace nvrhi::d3d11
@@ -26,6 +26,7 @@
 #include <nvrhi/common/misc.h>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 namespace nvrhi::d3d11
 {
@@ -60,7 +61,7 @@ namespace nvrhi::d3d11
         }
     }
 
-    TextureHandle Device::createTexture(const TextureDesc& d, CpuAccessMode cpuAccess) const
+    TextureHandle Device::createTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
     {
         if (d.isVirtual)
         {
@@ -222,6 +223,10 @@ namespace nvrhi::d3d11
         texture->desc = d;
         texture->resource = pResource;
         texture->sharedHandle = sharedHandle;
+
+        // Staging textures are counted by createStagingTexture
+        if (cpuAccess == CpuAccessMode::None)
+            texture->statsEntry.set(&m_Stats, LiveObjectType::Texture, estimateTextureMemorySize(d));
         return TextureHandle::Create(texture);
     }
 
@@ -253,6 +258,7 @@ namespace nvrhi::d3d11
         Texture* texture = new Texture(m_Context);
         texture->desc = desc;
         texture->resource = static_cast<ID3D11Resource*>(_texture.pointer);
+        texture->statsEntry.set(&m_Stats, LiveObjectType::Texture, estimateTextureMemorySize(desc));
 
         return TextureHandle::Create(texture);
     }
@@ -264,6 +270,7 @@ namespace nvrhi::d3d11
         TextureHandle t = createTexture(d, cpuAccess);
         ret->texture = checked_cast<Texture*>(t.Get());
         ret->cpuAccess = cpuAccess;
+        ret->statsEntry.set(&m_Stats, LiveObjectType::StagingTexture, estimateTextureMemorySize(d));
         return StagingTextureHandle::Create(ret);
     }
 
@@ -287,13 +294,13 @@ namespace nvrhi::d3d11
             {
                 ID3D11UnorderedAccessView* uav = texture->getUAV(Format::UNKNOWN, currentMipSlice, TextureDimension::Unknown);
 
-                m_Context.immediateContext->ClearUnorderedAccessViewFloat(uav, &clearColor.r);
+                m_DeviceContext->ClearUnorderedAccessViewFloat(uav, &clearColor.r);
             }
             else if (texture->desc.isRenderTarget)
             {
                 ID3D11RenderTargetView* rtv = texture->getRTV(Format::UNKNOWN, currentMipSlice);
 
-                m_Context.immediateContext->ClearRenderTargetView(rtv, &clearColor.r);
+                m_DeviceContext->ClearRenderTargetView(rtv, &clearColor.r);
             }
             else
             {
@@ -330,7 +337,7 @@ namespace nvrhi::d3d11
                 UINT clearFlags = 0;
                 if (clearDepth)   clearFlags |= D3D11_CLEAR_DEPTH;
                 if (clearStencil) clearFlags |= D3D11_CLEAR_STENCIL;
-                m_Context.immediateContext->ClearDepthStencilView(dsv, clearFlags, depth, stencil);
+                m_DeviceContext->ClearDepthStencilView(dsv, clearFlags, depth, stencil);
             }
         }
     }
@@ -356,14 +363,14 @@ namespace nvrhi::d3d11
                 ID3D11UnorderedAccessView* uav = texture->getUAV(Format::UNKNOWN, currentMipSlice, TextureDimension::Unknown);
 
                 uint32_t clearValues[4] = { clearColor, clearColor, clearColor, clearColor };
-                m_Context.immediateContext->ClearUnorderedAccessViewUint(uav, clearValues);
+                m_DeviceContext->ClearUnorderedAccessViewUint(uav, clearValues);
             }
             else if (texture->desc.isRenderTarget)
             {
                 ID3D11RenderTargetView* rtv = texture->getRTV(Format::UNKNOWN, currentMipSlice);
 
                 float clearValues[4] = { float(clearColor), float(clearColor), float(clearColor), float(clearColor) };
-                m_Context.immediateContext->ClearRenderTargetView(rtv, clearValues);
+                m_DeviceContext->ClearRenderTargetView(rtv, clearValues);
             }
             else
             {
@@ -416,7 +423,7 @@ namespace nvrhi::d3d11
         srcBox.bottom = resolvedSrcSlice.y + resolvedSrcSlice.height;
         srcBox.back = resolvedSrcSlice.z + resolvedSrcSlice.depth;
 
-        m_Context.immediateContext->CopySubresourceRegion(dst,
+        m_DeviceContext->CopySubresourceRegion(dst,
                                        dstSubresource,
                                        resolvedDstSlice.x, resolvedDstSlice.y, resolvedDstSlice.z,
                                        src,
@@ -457,7 +464,65 @@ namespace nvrhi::d3d11
 
         UINT subresource = D3D11CalcSubresource(mipLevel, arraySlice, dest->desc.mipLevels);
 
-        m_Context.immediateContext->UpdateSubresource(dest->resource, subresource, nullptr, data, UINT(rowPitch), UINT(depthPitch));
+        const uint32_t mipDepth = std::max(dest->desc.depth >> mipLevel, 1u);
+        m_Stats.uploadBytes += depthPitch * mipDepth;
+
+        m_DeviceContext->UpdateSubresource(dest->resource, subresource, nullptr, data, UINT(rowPitch), UINT(depthPitch));
+    }
+
+    MappedWriteRegion CommandList::beginWriteTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        const FormatInfo& formatInfo = getFormatInfo(dest->desc.format);
+        const uint32_t mipWidth = std::max(dest->desc.width >> mipLevel, 1u);
+        const uint32_t mipHeight = std::max(dest->desc.height >> mipLevel, 1u);
+        const uint32_t mipDepth = std::max(dest->desc.depth >> mipLevel, 1u);
+        const uint32_t numCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const uint32_t numRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+        m_PendingWrite.texture = dest;
+        m_PendingWrite.arraySlice = arraySlice;
+        m_PendingWrite.mipLevel = mipLevel;
+        m_PendingWrite.rowPitch = size_t(numCols) * formatInfo.bytesPerBlock;
+        m_PendingWrite.depthPitch = m_PendingWrite.rowPitch * numRows;
+        m_PendingWrite.data.resize(m_PendingWrite.depthPitch * mipDepth);
+
+        MappedWriteRegion region;
+        region.data = m_PendingWrite.data.data();
+        region.rowPitch = m_PendingWrite.rowPitch;
+        region.depthPitch = m_PendingWrite.depthPitch;
+        region.size = m_PendingWrite.data.size();
+        return region;
+    }
+
+    MappedWriteRegion CommandList::beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        m_PendingWrite.buffer = b;
+        m_PendingWrite.destOffset = destOffsetBytes;
+        m_PendingWrite.data.resize(dataSize);
+
+        MappedWriteRegion region;
+        region.data = m_PendingWrite.data.data();
+        region.size = dataSize;
+        return region;
+    }
+
+    void CommandList::commitWrite()
+    {
+        PendingWrite& write = m_PendingWrite;
+
+        if (write.texture)
+        {
+            writeTexture(write.texture, write.arraySlice, write.mipLevel, write.data.data(), write.rowPitch, write.depthPitch);
+        }
+        else if (write.buffer)
+        {
+            writeBuffer(write.buffer, write.data.data(), write.data.size(), write.destOffset);
+        }
+
+        write.texture = nullptr;
+        write.buffer = nullptr;
     }
 
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
@@ -480,7 +545,7 @@ namespace nvrhi::d3d11
             {
                 uint32_t dstSubresource = D3D11CalcSubresource(mipLevel + dstSR.baseMipLevel, arrayIndex + dstSR.baseArraySlice, dest->desc.mipLevels);
                 uint32_t srcSubresource = D3D11CalcSubresource(mipLevel + srcSR.baseMipLevel, arrayIndex + srcSR.baseArraySlice, src->desc.mipLevels);
-                m_Context.immediateContext->ResolveSubresource(dest->resource, dstSubresource, src->resource, srcSubresource, formatMapping.rtvFormat);
+                m_DeviceContext->ResolveSubresource(dest->resource, dstSubresource, src->resource, srcSubresource, formatMapping.rtvFormat);
             }
         }
     }
@@ -0,0 +1,204 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+
+#include <sstream>
+#include <iomanip>
+
+namespace nvrhi::d3d12
+{
+    static uint32_t makePoolKey(D3D12_HEAP_TYPE heapType, PlacedResourceCategory category, bool smallAllocation)
+    {
+        return uint32_t(heapType)
+            | (uint32_t(category) << 4)
+            | (smallAllocation ? (1u << 6) : 0);
+    }
+
+    PlacedResourceAllocator::PlacedResourceAllocator(const Context& context, uint64_t heapSize)
+        : m_Context(context)
+        , m_HeapSize(align(heapSize, uint64_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)))
+    {
+    }
+
+    bool PlacedResourceAllocator::allocate(const D3D12_RESOURCE_ALLOCATION_INFO& allocInfo, D3D12_HEAP_TYPE heapType,
+        PlacedResourceCategory category, PlacedAllocation& outAllocation)
+    {
+        if (m_HeapSize == 0 || allocInfo.SizeInBytes == UINT64_MAX)
+            return false;
+
+        uint64_t size = allocInfo.SizeInBytes;
+        uint64_t alignment = allocInfo.Alignment;
+
+        // MSAA resources need 4 MB alignment, keep those committed
+        if (alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+            return false;
+
+        // Pick the size class: small resources are rounded up so that their slots can be reused by others.
+        // Buffers are an exception because D3D12 places them at 64 KB boundaries, so every placed buffer
+        // occupies at least 64 KB no matter how it is rounded. They are only rounded to that alignment,
+        // which keeps the waste per buffer below 64 KB instead of doubling it for sizes just above a power of 2.
+        // Packing many small buffers into one resource would need offsets in every view, copy and barrier,
+        // which the backend doesn't support; applications should use one buffer with ranges for those instead.
+        const bool smallAllocation = size <= c_SmallAllocationMaxSize;
+        uint64_t heapSize = m_HeapSize;
+        if (smallAllocation)
+        {
+            if (category == PlacedResourceCategory::Buffer)
+            {
+                size = align(size, alignment);
+            }
+            else
+            {
+                size = NextPowerOf2(std::max(size, alignment));
+                alignment = std::max(alignment, size);
+            }
+            heapSize = std::max(m_HeapSize / c_SmallHeapDivisor, uint64_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+            heapSize = std::max(heapSize, c_SmallAllocationMaxSize);
+        }
+
+        // Resources that would take up a large fraction of a heap don't benefit from sub-allocation
+        if (!smallAllocation && size > heapSize / 2)
+            return false;
+
+        const uint32_t poolKey = makePoolKey(heapType, category, smallAllocation);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto& pool = m_Pools[poolKey];
+
+        PlacedResourceHeap* heap = nullptr;
+        uint64_t offset = 0;
+        for (const auto& candidate : pool)
+        {
+            if (candidate->ranges.allocate(size, alignment, offset))
+            {
+                heap = candidate.get();
+                break;
+            }
+        }
+
+        if (!heap)
+        {
+            auto newHeap = std::make_unique<PlacedResourceHeap>(heapSize);
+            newHeap->poolKey = poolKey;
+
+            D3D12_HEAP_DESC heapDesc = {};
+            heapDesc.SizeInBytes = heapSize;
+            heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+            heapDesc.Properties.Type = heapType;
+            heapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+            heapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+            heapDesc.Properties.CreationNodeMask = 1; // no mGPU support in nvrhi so far
+            heapDesc.Properties.VisibleNodeMask = 1;
+
+            // Use the category-specific flags, which are valid on all resource heap tiers
+            switch (category)
+            {
+            case PlacedResourceCategory::Buffer:
+                heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+                break;
+            case PlacedResourceCategory::NonTargetTexture:
+                heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+                break;
+            default:
+                utils::InvalidEnum();
+                return false;
+            }
+
+            const HRESULT hr = m_Context.device->CreateHeap(&heapDesc, IID_PPV_ARGS(&newHeap->heap));
+
+            if (FAILED(hr))
+            {
+                // Not enough memory for a whole heap, maybe there is enough for a committed resource
+                std::stringstream ss;
+                ss << "CreateHeap call failed for the placed resource allocator, size = " << heapSize
+                    << ", HRESULT = 0x" << std::hex << std::setw(8) << hr;
+                m_Context.info(ss.str());
+
+                return false;
+            }
+
+            [[maybe_unused]] const bool allocated = newHeap->ranges.allocate(size, alignment, offset);
+            assert(allocated);
+
+            heap = newHeap.get();
+            pool.push_back(std::move(newHeap));
+        }
+
+        outAllocation.heap = heap;
+        outAllocation.offset = offset;
+        outAllocation.size = size;
+
+        return true;
+    }
+
+    void PlacedResourceAllocator::release(PlacedAllocation& allocation)
+    {
+        if (!allocation.heap)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        PlacedResourceHeap* heap = allocation.heap;
+        heap->ranges.release(allocation.offset, allocation.size);
+        allocation = PlacedAllocation();
+
+        if (!heap->ranges.isEmpty())
+            return;
+
+        // Release the empty heap unless it's the only one left in the pool, to avoid recreating
+        // the heap over and over when a single resource is created and destroyed repeatedly.
+        auto& pool = m_Pools[heap->poolKey];
+        if (pool.size() <= 1)
+            return;
+
+        for (auto it = pool.begin(); it != pool.end(); ++it)
+        {
+            if (it->get() == heap)
+            {
+                pool.erase(it);
+                break;
+            }
+        }
+    }
+
+    MemoryAllocatorStats PlacedResourceAllocator::getStats()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        MemoryAllocatorStats stats;
+        for (const auto& poolIter : m_Pools)
+        {
+            for (const auto& heap : poolIter.second)
+            {
+                ++stats.blockCount;
+                stats.blockBytes += heap->ranges.getSize();
+                stats.subAllocationCount += heap->ranges.getAllocationCount();
+                stats.subAllocationBytes += heap->ranges.getAllocatedBytes();
+            }
+        }
+
+        return stats;
+    }
+
+} // namespace nvrhi::d3d12
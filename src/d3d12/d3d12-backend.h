@@ -24,12 +24,15 @@
 
 #include <nvrhi/d3d12.h>
 
+// IDXGIFactory4 and IDXGIAdapter3 are used to query the video memory budget
+#include <dxgi.h>
+#include <dxgi1_4.h>
+
 #ifndef NVRHI_D3D12_WITH_NVAPI
 #define NVRHI_D3D12_WITH_NVAPI 0
 #endif
 
 #if NVRHI_D3D12_WITH_NVAPI
-#include <dxgi.h>
 #include <nvapi.h>
 #endif
 
@@ -71,25 +74,46 @@
 #define NVRHI_WITH_NVAPI_LSS (0)
 #endif
 
+// Work graphs were added in the Agility SDK 1.613
+#if defined(D3D12_SDK_VERSION) && (D3D12_SDK_VERSION >= 613)
+#define NVRHI_D3D12_WITH_WORK_GRAPHS (1)
+#else
+#define NVRHI_D3D12_WITH_WORK_GRAPHS (0)
+#endif
+
 #if D3D12_PREVIEW_SDK_VERSION >= 717
 #define NVRHI_D3D12_WITH_COOPVEC (1)
 #else
 #define NVRHI_D3D12_WITH_COOPVEC (0)
 #endif
 
+#include <atomic>
 #include <bitset>
+#include <deque>
 #include <memory>
 #include <queue>
 #include <list>
+#include <map>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
 
 #include <nvrhi/common/resourcebindingmap.h>
 #include <nvrhi/utils.h>
+#include "../common/accel-struct-stats.h"
+#include "../common/device-stats.h"
+#include "../common/profile-hooks.h"
+#include "../common/gpu-profiler.h"
+#include "../common/object-pool.h"
+#include "../common/binding-set-cache.h"
+#include "../common/framebuffer-cache.h"
 #include "../common/state-tracking.h"
 #include "../common/dxgi-format.h"
 #include "../common/versioning.h"
+#include "../common/range-allocator.h"
+#include "../common/readback-ring.h"
+#include "../common/release-queue.h"
+#include "../common/resource-references.h"
 
 #ifdef NVRHI_WITH_RTXMU
 #include <rtxmu/D3D12AccelStructManager.h>
@@ -100,6 +124,7 @@ namespace nvrhi::d3d12
     class RootSignature;
     class Buffer;
     class CommandList;
+    class Sampler;
     struct Context;
 
     typedef uint32_t RootParameterIndex;
@@ -130,12 +155,31 @@ namespace nvrhi::d3d12
     void TranslateBlendState(const BlendState& inState, D3D12_BLEND_DESC& outState);
     void TranslateDepthStencilState(const DepthStencilState& inState, D3D12_DEPTH_STENCIL_DESC& outState);
     void TranslateRasterizerState(const RasterState& inState, D3D12_RASTERIZER_DESC& outState);
+
+    // Accumulates the contents of a pipeline state description into the name of that pipeline in the pipeline library.
+    // Pointers in the descriptions must be followed and their contents added instead, e.g. with addShader.
+    class PipelineKeyHasher
+    {
+    public:
+        void add(const void* data, size_t size);
+        template<typename T> void add(const T& value) { add(&value, sizeof(T)); }
+        void addShader(const D3D12_SHADER_BYTECODE& shader);
+        void addRenderState(const D3D12_BLEND_DESC& blendState, const D3D12_RASTERIZER_DESC& rasterizerState,
+            const D3D12_DEPTH_STENCIL_DESC& depthStencilState);
+        [[nodiscard]] uint64_t getHash() const { return m_Hash; }
+        [[nodiscard]] std::wstring getName(const wchar_t* prefix) const;
+
+    private:
+        uint64_t m_Hash = 0xcbf29ce484222325ull; // FNV-1a offset basis
+    };
     
     struct Context
     {
         RefCountPtr<ID3D12Device> device;
+        RefCountPtr<ID3D12Device1> device1;
         RefCountPtr<ID3D12Device2> device2;
         RefCountPtr<ID3D12Device5> device5;
+        RefCountPtr<ID3D12Device7> device7;
         RefCountPtr<ID3D12Device8> device8;
 #if NVRHI_D3D12_WITH_COOPVEC
         RefCountPtr<ID3D12DevicePreview> devicePreview;
@@ -147,12 +191,24 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12CommandSignature> drawIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> drawIndexedIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> dispatchIndirectSignature;
+        RefCountPtr<ID3D12CommandSignature> dispatchMeshIndirectSignature; // null when mesh shaders are not supported
         RefCountPtr<ID3D12QueryHeap> timerQueryHeap;
         RefCountPtr<Buffer> timerQueryResolveBuffer;
 
+        // Used to query the video memory budget, may be null
+        RefCountPtr<IDXGIAdapter3> adapter3;
+
         bool logBufferLifetime = false;
+        bool enhancedBarriersSupported = false;
+        bool gpuUploadHeapSupported = false;
+        bool automaticQueueSync = false;
+        bool logAutomaticQueueSync = false;
+        bool deferredSubmission = false;
+        uint64_t uploadRingBufferSize = 0;
         IMessageCallback* messageCallback = nullptr;
+        IParallelTaskRunner* parallelTaskRunner = nullptr;
         void error(const std::string& message) const;
+        void warning(const std::string& message) const;
         void info(const std::string& message) const;
     };
 
@@ -168,12 +224,45 @@ namespace nvrhi::d3d12
         D3D12_GPU_DESCRIPTOR_HANDLE m_StartGpuHandleShaderVisible = { 0 };
         uint32_t m_Stride = 0;
         uint32_t m_NumDescriptors = 0;
-        std::vector<bool> m_AllocatedDescriptors;
-        DescriptorIndex m_SearchStart = 0;
         uint32_t m_NumAllocatedDescriptors = 0;
         std::mutex m_Mutex;
 
+        // Free ranges are kept in segregated lists, one per power of 2 size class, so that allocation and release
+        // take constant time regardless of how many descriptors are in use. The per-descriptor arrays store
+        // the free range size at its first index, the first index at its last index, and the list links.
+        static constexpr uint32_t c_NumFreeLists = 32;
+        std::vector<uint32_t> m_FreeRangeSizes;
+        std::vector<DescriptorIndex> m_FreeRangeStarts;
+        std::vector<DescriptorIndex> m_FreeRangeNext;
+        std::vector<DescriptorIndex> m_FreeRangePrev;
+        std::array<DescriptorIndex, c_NumFreeLists> m_FreeListHeads;
+        uint32_t m_FreeListMask = 0;
+#ifdef _DEBUG
+        std::vector<bool> m_AllocatedDescriptors;
+        // Descriptors that were released into one of the thread caches below but not yet returned to the heap
+        std::vector<bool> m_CachedDescriptors;
+#endif
+
+        // Single descriptors are served from small per-thread caches to avoid contention on m_Mutex.
+        // Threads are mapped to caches by hashing their IDs, so a cache may be shared by a few threads.
+        static constexpr uint32_t c_NumThreadCaches = 16;
+        static constexpr uint32_t c_ThreadCacheCapacity = 64;
+        static constexpr uint32_t c_ThreadCacheRefillCount = 16;
+        struct ThreadCache
+        {
+            std::mutex mutex;
+            std::vector<DescriptorIndex> indices;
+        };
+        std::array<ThreadCache, c_NumThreadCaches> m_ThreadCaches;
+
         HRESULT Grow(uint32_t minRequiredSize);
+        ThreadCache& getThreadCache();
+        DescriptorIndex allocateDescriptorsInternal(uint32_t count);
+        void releaseDescriptorsInternal(DescriptorIndex baseIndex, uint32_t count);
+        DescriptorIndex findFreeRange(uint32_t count) const;
+        void addFreeRange(DescriptorIndex start, uint32_t count);
+        void insertFreeRange(DescriptorIndex start, uint32_t count);
+        void removeFreeRange(DescriptorIndex start);
     public:
         explicit StaticDescriptorHeap(const Context& context);
 
@@ -182,6 +271,8 @@ namespace nvrhi::d3d12
         
         DescriptorIndex allocateDescriptors(uint32_t count) override;
         DescriptorIndex allocateDescriptor() override;
+        // Extends an allocated range by taking the free descriptors right after it, returns false if they are not free
+        bool tryExtendDescriptors(DescriptorIndex baseIndex, uint32_t count, uint32_t newCount);
         void releaseDescriptors(DescriptorIndex baseIndex, uint32_t count) override;
         void releaseDescriptor(DescriptorIndex index) override;
         D3D12_CPU_DESCRIPTOR_HANDLE getCpuHandle(DescriptorIndex index) override;
@@ -189,6 +280,298 @@ namespace nvrhi::d3d12
         D3D12_GPU_DESCRIPTOR_HANDLE getGpuHandle(DescriptorIndex index) override;
         [[nodiscard]] ID3D12DescriptorHeap* getHeap() const override;
         [[nodiscard]] ID3D12DescriptorHeap* getShaderVisibleHeap() const override;
+
+        // Descriptors held in the per-thread caches count as allocated
+        DescriptorHeapStats getStats();
+    };
+
+    // Hands out fixed-size chunks of a descriptor heap for the transient binding sets of command lists.
+    // At most 'maxChunks' chunks are taken from the heap, so that transient sets can't exhaust it, and when a chunk
+    // is released while 'maxIdleChunks' are already waiting for reuse, it goes back to the heap.
+    class TransientDescriptorChunkPool
+    {
+    public:
+        TransientDescriptorChunkPool(StaticDescriptorHeap& heap, uint32_t chunkSize, uint32_t maxChunks, uint32_t maxIdleChunks)
+            : m_Heap(heap)
+            , m_ChunkSize(chunkSize)
+            , m_MaxChunks(maxChunks)
+            , m_MaxIdleChunks(maxIdleChunks)
+        { }
+
+        ~TransientDescriptorChunkPool();
+
+        [[nodiscard]] uint32_t getChunkSize() const { return m_ChunkSize; }
+
+        // Returns c_InvalidDescriptorIndex if the pool or the heap is exhausted
+        DescriptorIndex acquireChunk();
+        void releaseChunks(const std::vector<DescriptorIndex>& chunks);
+
+    private:
+        StaticDescriptorHeap& m_Heap;
+        const uint32_t m_ChunkSize;
+        const uint32_t m_MaxChunks;
+        const uint32_t m_MaxIdleChunks;
+        std::mutex m_Mutex;
+        std::vector<DescriptorIndex> m_FreeChunks;
+        uint32_t m_NumAllocatedChunks = 0;
+    };
+
+    // Linear allocator over the chunks of a TransientDescriptorChunkPool, owned by a command list instance.
+    // All chunks go back to the pool when the instance is destroyed, i.e. when the GPU is done with it.
+    class TransientDescriptorAllocator
+    {
+    public:
+        explicit TransientDescriptorAllocator(TransientDescriptorChunkPool& pool)
+            : m_Pool(pool)
+        { }
+
+        ~TransientDescriptorAllocator() { m_Pool.releaseChunks(m_Chunks); }
+
+        // Returns c_InvalidDescriptorIndex if the range doesn't fit into a chunk
+        DescriptorIndex allocate(uint32_t count);
+
+    private:
+        TransientDescriptorChunkPool& m_Pool;
+        std::vector<DescriptorIndex> m_Chunks;
+        uint32_t m_OffsetInChunk = ~0u; // no chunk yet
+    };
+
+    // An ID3D12Heap that multiple placed resources are sub-allocated from.
+    struct PlacedResourceHeap
+    {
+        RefCountPtr<ID3D12Heap> heap;
+        uint32_t poolKey = 0;
+        RangeAllocator ranges;
+
+        explicit PlacedResourceHeap(uint64_t size)
+            : ranges(size)
+        { }
+    };
+
+    struct PlacedAllocation
+    {
+        PlacedResourceHeap* heap = nullptr;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    // Resource categories that can share a heap on all resource heap tiers
+    enum class PlacedResourceCategory : uint8_t
+    {
+        Buffer,
+        NonTargetTexture
+    };
+
+    // Places buffers and textures into internally managed heaps instead of creating a committed resource for each one.
+    class PlacedResourceAllocator
+    {
+    public:
+        PlacedResourceAllocator(const Context& context, uint64_t heapSize);
+
+        // Finds space for a resource with the given allocation info in a heap of the requested type and category.
+        // Returns false if the resource is not suitable for sub-allocation, in which case it should be committed.
+        bool allocate(const D3D12_RESOURCE_ALLOCATION_INFO& allocInfo, D3D12_HEAP_TYPE heapType,
+            PlacedResourceCategory category, PlacedAllocation& outAllocation);
+        void release(PlacedAllocation& allocation);
+
+        [[nodiscard]] MemoryAllocatorStats getStats();
+
+    private:
+        // Resources smaller than this are rounded up to a power of 2 and placed into smaller heaps,
+        // which keeps the free ranges in those heaps uniform and easy to reuse.
+        static constexpr uint64_t c_SmallAllocationMaxSize = 256 * 1024;
+        static constexpr uint32_t c_SmallHeapDivisor = 8;
+
+        const Context& m_Context;
+        uint64_t m_HeapSize;
+
+        std::mutex m_Mutex;
+        std::unordered_map<uint32_t, std::vector<std::unique_ptr<PlacedResourceHeap>>> m_Pools;
+    };
+
+    class Queue;
+    class CommandListInstance;
+    class D3D12BuildRaytracingAccelerationStructureInputs;
+
+    // Residency state of a committed resource that can be evicted by the ResidencyManager
+    struct ResidencyEntry
+    {
+        ID3D12Pageable* pageable = nullptr;
+        uint64_t size = 0;
+        bool registered = false;
+        bool resident = true;
+
+        // Last submission that used the resource on every queue
+        std::array<uint64_t, size_t(CommandQueue::Count)> lastUseInstances{};
+
+        // Position in the LRU list, valid while the resource is resident
+        std::list<ResidencyEntry*>::iterator position;
+    };
+
+    // Tracks committed resources in the order they were last used by submitted command lists, and evicts
+    // the least recently used ones that are idle when the local video memory usage exceeds the OS budget.
+    class ResidencyManager
+    {
+    public:
+        ResidencyManager(const Context& context, bool enabled)
+            : m_Context(context)
+            , m_Enabled(enabled)
+        { }
+
+        [[nodiscard]] bool isEnabled() const { return m_Enabled; }
+
+        // Applies the priority hint to a committed resource and starts tracking it if the manager is enabled
+        void registerResource(ResidencyEntry& entry, ID3D12Resource* resource, ResidencyPriority priority);
+        void unregisterResource(ResidencyEntry& entry);
+
+        // Makes all resources referenced by the command list instance resident and marks them as used by the submission
+        void prepareSubmission(const CommandListInstance& instance, CommandQueue queue, uint64_t submittedInstance);
+
+        // Evicts idle resources in LRU order until the usage is within the budget
+        void trimToBudget(const std::array<std::unique_ptr<Queue>, size_t(CommandQueue::Count)>& queues);
+
+    private:
+        const Context& m_Context;
+        const bool m_Enabled;
+
+        std::mutex m_Mutex;
+        std::list<ResidencyEntry*> m_ResidentEntries; // least recently used first
+        std::vector<ID3D12Pageable*> m_PageablesToProcess; // used locally, member to avoid re-allocations
+
+        void markUsed(IResource* resource, CommandQueue queue, uint64_t submittedInstance);
+        void markUsed(ResidencyEntry& entry, CommandQueue queue, uint64_t submittedInstance);
+    };
+
+    // Compacted size of a BLAS or an OMM array that was built by a command list, written by the GPU into a BlasCompactionManager slot.
+    // Exactly one of accelStruct and opacityMicromap is set.
+    struct PendingCompactedSize
+    {
+        rt::AccelStructHandle accelStruct;
+        int slot = -1;
+        rt::OpacityMicromapHandle opacityMicromap;
+    };
+
+    // Collects the compacted sizes of the BLASes and OMM arrays built with the AllowCompaction flag without RTXMU,
+    // and hands them out for compaction once their builds have finished executing. The builds write the sizes
+    // directly into a persistently mapped buffer, so no readback copies or barriers are needed.
+    class BlasCompactionManager
+    {
+    public:
+        BlasCompactionManager(const Context& context, uint64_t budget)
+            : m_Context(context)
+            , m_Budget(budget)
+            , m_Slots(c_MaxPendingSizes, false)
+        { }
+
+        ~BlasCompactionManager();
+
+        // Reserves a slot for the compacted size of a build and returns its GPU address,
+        // or 0 if all slots are in use by builds that haven't finished yet
+        D3D12_GPU_VIRTUAL_ADDRESS allocateSlot(int& outSlot);
+
+        // Reads the sizes written by a finished command list instance, releases their slots,
+        // and queues the BLASes and OMM arrays that will get smaller for compaction
+        void buildsCompleted(std::vector<PendingCompactedSize>& builds);
+
+        // Releases the slots of builds that were recorded into a command list that was never executed
+        void buildsDiscarded(std::vector<PendingCompactedSize>& builds);
+
+        // Takes the queued BLASes in the order they were built, until their total size exceeds the budget
+        void takeCandidates(std::vector<rt::AccelStructHandle>& outCandidates);
+
+        // Same as takeCandidates, for the queued OMM arrays
+        void takeOpacityMicromapCandidates(std::vector<rt::OpacityMicromapHandle>& outCandidates);
+
+        // Returns the number of queued BLASes and OMM arrays
+        size_t getNumPendingCompactions();
+
+    private:
+        static constexpr int c_MaxPendingSizes = 4096;
+
+        const Context& m_Context;
+        const uint64_t m_Budget;
+
+        std::mutex m_Mutex;
+        RefCountPtr<ID3D12Resource> m_SizeBuffer;
+        const uint64_t* m_SizeData = nullptr;
+        bool m_CreationFailed = false;
+        utils::BitSetAllocator m_Slots;
+        std::deque<rt::AccelStructHandle> m_Candidates;
+        std::deque<rt::OpacityMicromapHandle> m_OpacityMicromapCandidates;
+    };
+
+    class ReadbackPool;
+
+    class ReadbackTicket : public RefCounter<IReadbackTicket>
+    {
+    public:
+        uint32_t bufferIndex = 0;
+        uint64_t offset = 0;
+        const uint8_t* cpuAddress = nullptr;
+        size_t size = 0;
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+        ReadbackCallback callback;
+
+        // Set when the command list instance that recorded the readback is executed
+        RefCountPtr<ID3D12Fence> fence;
+        uint64_t fenceCounter = 0;
+
+        explicit ReadbackTicket(ReadbackPool& pool)
+            : m_Pool(pool)
+        { }
+
+        ~ReadbackTicket() override;
+
+        bool isReady() override;
+        const void* getData() override { return isReady() ? cpuAddress : nullptr; }
+        size_t getSize() const override { return size; }
+        size_t getRowPitch() const override { return rowPitch; }
+        size_t getDepthPitch() const override { return depthPitch; }
+
+    private:
+        ReadbackPool& m_Pool;
+    };
+
+    // Device-wide pool of persistently mapped readback heap buffers that the asynchronous readbacks are
+    // suballocated from, see ReadbackRing. The buffers are kept for the lifetime of the device.
+    class ReadbackPool
+    {
+    public:
+        ReadbackPool(const Context& context, uint64_t bufferSize)
+            : m_Context(context)
+            , m_BufferSize(bufferSize)
+        { }
+
+        ~ReadbackPool();
+
+        // Creates a ticket with 'size' bytes of readback memory at an offset aligned to 'alignment',
+        // and returns its buffer in 'outBuffer'. Returns nullptr if the memory couldn't be allocated.
+        RefCountPtr<ReadbackTicket> allocate(uint64_t size, uint64_t alignment, ID3D12Resource** outBuffer);
+        void release(uint32_t bufferIndex, uint64_t offset);
+
+        // Queues the callback of a submitted ticket, runCallbacks(...) calls it once the ticket is ready
+        void addPendingCallback(ReadbackTicket* ticket);
+        void runCallbacks();
+
+    private:
+        struct ReadbackBuffer
+        {
+            RefCountPtr<ID3D12Resource> resource;
+            uint8_t* cpuAddress = nullptr;
+            ReadbackRing ring;
+
+            explicit ReadbackBuffer(uint64_t size) : ring(size) { }
+        };
+
+        const Context& m_Context;
+        const uint64_t m_BufferSize;
+
+        std::mutex m_Mutex;
+        std::vector<std::unique_ptr<ReadbackBuffer>> m_Buffers;
+
+        std::mutex m_CallbackMutex;
+        std::vector<RefCountPtr<ReadbackTicket>> m_PendingCallbacks;
     };
 
     class DeviceResources
@@ -198,22 +581,75 @@ namespace nvrhi::d3d12
         StaticDescriptorHeap depthStencilViewHeap;
         StaticDescriptorHeap shaderResourceViewHeap;
         StaticDescriptorHeap samplerHeap;
+        TransientDescriptorChunkPool transientShaderResourceViewChunks;
+        TransientDescriptorChunkPool transientSamplerChunks;
         utils::BitSetAllocator timerQueries;
+        PlacedResourceAllocator placedResourceAllocator;
+        const bool placedResourceAllocatorEnabled;
+        ResidencyManager residencyManager;
+        AccelStructStatsTracker accelStructStats;
+        DeviceStatsTracker deviceStats;
+        GpuProfiler profiler;
 #ifdef NVRHI_WITH_RTXMU
         std::mutex asListMutex;
         std::vector<uint64_t> asBuildsCompleted;
+#else
+        BlasCompactionManager blasCompaction;
 #endif
+        ReadbackPool readbackPool;
 
         // The cache does not own the RS objects, so store weak references
         std::unordered_map<size_t, RootSignature*> rootsigCache;
+        std::mutex rootsigCacheMutex;
+
+        // Samplers are deduplicated by their desc, the cache stores weak references like the RS cache
+        std::unordered_map<SamplerDesc, Sampler*> samplerCache;
+        std::mutex samplerCacheMutex;
 
         explicit DeviceResources(const Context& context, const DeviceDesc& desc);
 
+        // Returns a sampler descriptor table in samplerHeap filled with the given sampler descriptors, sharing it
+        // with all binding sets that use the same samplers in the same order. Invalid indices get the default sampler.
+        DescriptorIndex acquireSharedSamplerTable(const std::vector<DescriptorIndex>& samplerDescriptors);
+        void releaseSharedSamplerTable(DescriptorIndex baseIndex);
+
         uint8_t getFormatPlaneCount(DXGI_FORMAT format);
 
+        [[nodiscard]] bool usePlacedResourceAllocator(ResourceAllocationMode mode) const
+        {
+            switch (mode)
+            {
+            case ResourceAllocationMode::Dedicated: return false;
+            case ResourceAllocationMode::SubAllocated: return true;
+            case ResourceAllocationMode::Default:
+            default: return placedResourceAllocatorEnabled;
+            }
+        }
+
     private:
         const Context& m_Context;
         std::unordered_map<DXGI_FORMAT, uint8_t> m_DxgiFormatPlaneCounts;
+
+        struct DescriptorIndexVectorHash
+        {
+            size_t operator()(const std::vector<DescriptorIndex>& v) const noexcept
+            {
+                size_t hash = 0;
+                for (DescriptorIndex index : v)
+                    hash_combine(hash, index);
+                return hash;
+            }
+        };
+
+        struct SharedSamplerTable
+        {
+            std::vector<DescriptorIndex> samplerDescriptors;
+            uint32_t refCount = 0;
+        };
+
+        std::unordered_map<std::vector<DescriptorIndex>, DescriptorIndex, DescriptorIndexVectorHash> m_SharedSamplerTableIndices;
+        std::unordered_map<DescriptorIndex, SharedSamplerTable> m_SharedSamplerTables; // keyed by the table base index
+        std::mutex m_SharedSamplerTableMutex;
     };
 
 
@@ -227,6 +663,10 @@ namespace nvrhi::d3d12
         std::vector<NV_CUSTOM_SEMANTIC> customSemantics;
         std::vector<uint32_t> coordinateSwizzling;
     #endif
+
+        // Permutations registered with addShaderSpecializationPermutation, keyed by (constantID, value) pairs sorted by ID
+        std::map<std::vector<std::pair<uint32_t, uint32_t>>, ShaderHandle> specializations;
+        std::mutex specializationsMutex;
         
         const ShaderDesc& getDesc() const override { return desc; }
         void getBytecode(const void** ppBytecode, size_t* pSize) const override;
@@ -265,6 +705,7 @@ namespace nvrhi::d3d12
     public:
         HeapDesc desc;
         RefCountPtr<ID3D12Heap> heap;
+        DeviceStatsEntry statsEntry;
 
         const HeapDesc& getDesc() override { return desc; }
     };
@@ -278,7 +719,9 @@ namespace nvrhi::d3d12
         uint8_t planeCount = 1;
         HANDLE sharedHandle = nullptr;
         HeapHandle heap;
-
+        PlacedAllocation placedAllocation;
+        ResidencyEntry residency;
+        DeviceStatsEntry statsEntry;
 
         Texture(const Context& context, DeviceResources& resources, TextureDesc desc, const D3D12_RESOURCE_DESC& resourceDesc)
             : TextureStateExtension(this->desc)
@@ -288,6 +731,9 @@ namespace nvrhi::d3d12
             , m_Resources(resources)
         {
             TextureStateExtension::stateInitialized = true;
+
+            for (auto& view : m_DefaultViews)
+                view.store(c_InvalidDescriptorIndex, std::memory_order_relaxed);
         }
 
         ~Texture() override;
@@ -305,14 +751,34 @@ namespace nvrhi::d3d12
         DescriptorIndex getClearMipLevelUAV(uint32_t mipLevel);
 
     private:
+        // The most common views: the texture's own format and dimension, all array slices, and all mip levels
+        // for SRVs or mip 0 for the other types. They are also stored in the view maps, which own them.
+        enum DefaultViewSlot
+        {
+            DefaultSRV,
+            DefaultUAV,
+            DefaultRTV,
+            DefaultDSV,
+            DefaultReadOnlyDSV,
+            DefaultViewSlotCount
+        };
+
         const Context& m_Context;
         DeviceResources& m_Resources;
 
+        // getNativeView is called free-threaded, e.g. from clears recorded on different threads.
+        // The default views are read without locking once created, the mutex protects the maps.
+        std::atomic<DescriptorIndex> m_DefaultViews[DefaultViewSlotCount];
+        std::mutex m_Mutex;
         TextureBindingKey_HashMap<DescriptorIndex> m_RenderTargetViews;
         TextureBindingKey_HashMap<DescriptorIndex> m_DepthStencilViews;
         TextureBindingKey_HashMap<DescriptorIndex> m_CustomSRVs;
         TextureBindingKey_HashMap<DescriptorIndex> m_CustomUAVs;
         std::vector<DescriptorIndex> m_ClearMipLevelUAVs;
+
+        [[nodiscard]] int getDefaultViewSlot(ObjectType objectType, Format format, const TextureSubresourceSet& subresources,
+            TextureDimension dimension, bool isReadOnlyDSV) const;
+        [[nodiscard]] Object getViewObject(ObjectType objectType, DescriptorIndex descriptorIndex) const;
     };
 
     class Buffer : public RefCounter<IBuffer>, public BufferStateExtension
@@ -324,10 +790,13 @@ namespace nvrhi::d3d12
         D3D12_RESOURCE_DESC resourceDesc{};
 
         HeapHandle heap;
+        PlacedAllocation placedAllocation;
+        ResidencyEntry residency;
 
         RefCountPtr<ID3D12Fence> lastUseFence;
         uint64_t lastUseFenceValue = 0;
         HANDLE sharedHandle = nullptr;
+        DeviceStatsEntry statsEntry;
 
         Buffer(const Context& context, DeviceResources& resources, BufferDesc desc)
             : BufferStateExtension(this->desc)
@@ -380,6 +849,7 @@ namespace nvrhi::d3d12
 
         SliceRegion mappedRegion;
         CpuAccessMode mappedAccess = CpuAccessMode::None;
+        DeviceStatsEntry statsEntry; // the memory is reported by the buffer
 
         // returns a SliceRegion struct corresponding to the subresource that slice points at
         // note that this always returns the entire subresource
@@ -428,7 +898,12 @@ namespace nvrhi::d3d12
     class Sampler : public RefCounter<ISampler>
     {
     public:
-        Sampler(const Context& context, const SamplerDesc& desc);
+        // Persistent descriptor in DeviceResources::samplerHeap, which binding sets copy into their tables
+        DescriptorIndex descriptor = c_InvalidDescriptorIndex;
+        DeviceStatsEntry statsEntry;
+
+        Sampler(const Context& context, DeviceResources& resources, const SamplerDesc& desc);
+        ~Sampler() override;
         
         void createDescriptor(size_t descriptor) const;
 
@@ -436,6 +911,7 @@ namespace nvrhi::d3d12
 
     private:
         const Context& m_Context;
+        DeviceResources& m_Resources;
         const SamplerDesc m_Desc;
         D3D12_SAMPLER_DESC m_d3d12desc;
     };
@@ -453,13 +929,12 @@ namespace nvrhi::d3d12
         const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
     };
 
-    class EventQuery : public RefCounter<IEventQuery>
+    // Recycled through Device::m_EventQueryPool
+    class EventQuery : public PooledRefCounter<IEventQuery, EventQuery>
     {
     public:
-        RefCountPtr<ID3D12Fence> fence;
-        uint64_t fenceCounter = 0;
+        SubmissionTicket ticket;
         bool started = false;
-        bool resolved = false;
     };
 
     class TimerQuery : public RefCounter<ITimerQuery>
@@ -524,6 +999,7 @@ namespace nvrhi::d3d12
     {
     public:
         size_t hash = 0;
+        uint64_t serializedHash = 0; // hash of the serialized root signature, used in the pipeline library keys
         static_vector<std::pair<BindingLayoutHandle, RootParameterIndex>, c_MaxBindingLayouts> pipelineLayouts;
         RefCountPtr<ID3D12RootSignature> handle;
         uint32_t pushConstantByteSize = 0;
@@ -551,6 +1027,7 @@ namespace nvrhi::d3d12
         DescriptorIndex DSV = c_InvalidDescriptorIndex;
         uint32_t rtWidth = 0;
         uint32_t rtHeight = 0;
+        DeviceStatsEntry statsEntry;
 
         Framebuffer(DeviceResources& resources)
             : m_Resources(resources)
@@ -583,12 +1060,23 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12PipelineState> pipelineState;
 
         bool requiresBlendFactor = false;
+        DeviceStatsEntry statsEntry;
         
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
         Object getNativeObject(ObjectType objectType) override;
     };
 
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+        RefCountPtr<ID3D12CommandSignature> signature;
+        
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override;
+    };
+
     class ComputePipeline : public RefCounter<IComputePipeline>
     {
     public:
@@ -596,11 +1084,31 @@ namespace nvrhi::d3d12
 
         RefCountPtr<RootSignature> rootSignature;
         RefCountPtr<ID3D12PipelineState> pipelineState;
+        DeviceStatsEntry statsEntry;
         
         const ComputePipelineDesc& getDesc() const override { return desc; }
         Object getNativeObject(ObjectType objectType) override;
     };
 
+    class WorkGraphPipeline : public RefCounter<IWorkGraphPipeline>
+    {
+    public:
+        WorkGraphPipelineDesc desc;
+
+        RefCountPtr<RootSignature> rootSignature;
+        RefCountPtr<ID3D12StateObject> stateObject;
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        D3D12_PROGRAM_IDENTIFIER programIdentifier{};
+#endif
+        std::vector<uint32_t> entrypointIndices; // per node in desc.nodes, only valid for the entry nodes
+        WorkGraphMemoryRequirements memoryRequirements;
+        DeviceStatsEntry statsEntry;
+
+        const WorkGraphPipelineDesc& getDesc() const override { return desc; }
+        WorkGraphMemoryRequirements getMemoryRequirements() const override { return memoryRequirements; }
+        Object getNativeObject(ObjectType objectType) override;
+    };
+
     class MeshletPipeline : public RefCounter<IMeshletPipeline>
     {
     public:
@@ -613,6 +1121,7 @@ namespace nvrhi::d3d12
         DX12_ViewportState viewportState;
 
         bool requiresBlendFactor = false;
+        DeviceStatsEntry statsEntry;
         
         const MeshletPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
@@ -633,12 +1142,15 @@ namespace nvrhi::d3d12
         bool descriptorTableValidSRVetc = false;
         bool descriptorTableValidSamplers = false;
         bool hasUavBindings = false;
+        bool isTransient = false; // descriptors are owned by a command list, see CommandList::createTransientBindingSet
+        bool sharedSamplerTable = false; // descriptorTableSamplers comes from DeviceResources::acquireSharedSamplerTable
 
         static_vector<std::pair<RootParameterIndex, IBuffer*>, c_MaxVolatileConstantBuffersPerLayout> rootParametersVolatileCB;
         
         std::vector<RefCountPtr<IResource>> resources;
 
         std::vector<uint16_t> bindingsThatNeedTransitions;
+        DeviceStatsEntry statsEntry;
 
         BindingSet(const Context& context, DeviceResources& resources)
             : m_Context(context)
@@ -662,6 +1174,13 @@ namespace nvrhi::d3d12
     public:
         uint32_t capacity = 0;
         DescriptorIndex firstDescriptor = 0;
+        // number of descriptors owned by the table starting at firstDescriptor, capacity <= reservedCapacity
+        uint32_t reservedCapacity = 0;
+        // part of the reservation made at creation, which is kept when the table shrinks
+        uint32_t minReservedCapacity = 0;
+        // one past the highest slot written with writeDescriptorTable, only this part is copied when the table moves
+        uint32_t numWrittenDescriptors = 0;
+        DeviceStatsEntry statsEntry;
 
         DescriptorTable(DeviceResources& resources)
             : m_Resources(resources)
@@ -705,6 +1224,16 @@ namespace nvrhi::d3d12
     };
 
     D3D12_RESOURCE_STATES convertResourceStates(ResourceStates stateBits);
+
+    struct BarrierStateMapping
+    {
+        D3D12_BARRIER_SYNC sync = D3D12_BARRIER_SYNC_NONE;
+        D3D12_BARRIER_ACCESS access = D3D12_BARRIER_ACCESS_COMMON;
+        D3D12_BARRIER_LAYOUT layout = D3D12_BARRIER_LAYOUT_COMMON;
+    };
+
+    // Translates NVRHI states into the sync scope, access and texture layout used by Enhanced Barriers
+    BarrierStateMapping convertBarrierState(ResourceStates stateBits);
     
     class BufferChunk
     {
@@ -718,6 +1247,7 @@ namespace nvrhi::d3d12
         void* cpuVA = nullptr;
         D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
         uint32_t identifier = 0;
+        DeviceStatsEntry statsEntry;
 
         ~BufferChunk();
     };
@@ -725,7 +1255,7 @@ namespace nvrhi::d3d12
     class UploadManager
     {
     public:
-        UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer);
+        UploadManager(const Context& context, class Queue* pQueue, DeviceStatsTracker& stats, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer, uint64_t ringBufferSize = 0);
 
         bool suballocateBuffer(uint64_t size, ID3D12GraphicsCommandList* pCommandList, ID3D12Resource** pBuffer, size_t* pOffset, void** pCpuVA,
             D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint64_t currentVersion, uint32_t alignment = 256);
@@ -733,8 +1263,16 @@ namespace nvrhi::d3d12
         void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
 
     private:
+        // A contiguous part of the ring buffer used by one recording of the command list
+        struct RingRegion
+        {
+            uint64_t end = 0;
+            uint64_t version = 0;
+        };
+
         const Context& m_Context;
         Queue* m_Queue;
+        DeviceStatsTracker& m_Stats;
         size_t m_DefaultChunkSize = 0;
         uint64_t m_MemoryLimit = 0;
         uint64_t m_AllocatedMemory = 0;
@@ -743,7 +1281,16 @@ namespace nvrhi::d3d12
         std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
 
+        // Ring buffer mode: allocations are taken from the head, whole regions are retired from the tail
+        uint64_t m_RingBufferSize = 0;
+        std::shared_ptr<BufferChunk> m_RingBuffer;
+        uint64_t m_RingHead = 0;
+        uint64_t m_RingTail = 0;
+        std::deque<RingRegion> m_RingRegions;
+
         [[nodiscard]] std::shared_ptr<BufferChunk> createChunk(size_t size) const;
+        bool tryAllocateFromRing(uint64_t size, uint32_t alignment, uint64_t currentVersion, uint64_t* pOffset);
+        void retireRingRegions(uint64_t completedInstance);
     };
 
     class OpacityMicromap : public RefCounter<rt::IOpacityMicromap>
@@ -751,8 +1298,10 @@ namespace nvrhi::d3d12
     public:
         RefCountPtr<d3d12::Buffer> dataBuffer;
         rt::OpacityMicromapDesc desc;
+        uint64_t compactedSize = 0;
         bool allowUpdate = false;
         bool compacted = false;
+        AccelStructStatsEntry statsEntry;
 
         OpacityMicromap()
         { }
@@ -769,14 +1318,18 @@ namespace nvrhi::d3d12
     public:
         RefCountPtr<d3d12::Buffer> dataBuffer;
         std::vector<rt::AccelStructHandle> bottomLevelASes;
-        std::vector<D3D12_RAYTRACING_INSTANCE_DESC> dxrInstances;
+        size_t numBuiltInstances = 0; // TLAS only, DXR doesn't allow updating to a different instance count
+        // BLAS only, the last buildTopLevelAccelStruct that referenced this BLAS, used to find the unique BLASes quickly
+        std::atomic<uint64_t> lastInstanceConversion = 0;
         rt::AccelStructDesc desc;
         bool allowUpdate = false;
         bool compacted = false;
+        uint64_t compactedSize = 0; // BLAS only, known after a build with AllowCompaction has finished executing
         size_t rtxmuId = ~0ull;
 #ifdef NVRHI_WITH_RTXMU
         D3D12_GPU_VIRTUAL_ADDRESS rtxmuGpuVA = 0;
 #endif
+        AccelStructStatsEntry statsEntry;
 
         AccelStruct(const Context& context)
             : m_Context(context)
@@ -814,6 +1367,9 @@ namespace nvrhi::d3d12
 
         std::unordered_map<std::string, ExportTableEntry> exports;
         uint32_t maxLocalRootParameters = 0;
+        // Number of hit group shaders renamed to avoid collisions, continued by addToRayTracingPipeline
+        uint32_t numRenamedExports = 0;
+        DeviceStatsEntry statsEntry;
 
         RayTracingPipeline(const Context& context)
             : m_Context(context)
@@ -824,6 +1380,7 @@ namespace nvrhi::d3d12
 
         const rt::PipelineDesc& getDesc() const override { return desc; }
         rt::ShaderTableHandle createShaderTable() override;
+        rt::ShaderTableHandle createShaderTable(const rt::ShaderTableDesc& desc) override;
 
     private:
         const Context& m_Context;
@@ -839,6 +1396,7 @@ namespace nvrhi::d3d12
         };
 
         RefCountPtr<RayTracingPipeline> pipeline;
+        rt::ShaderTableDesc desc;
 
         Entry rayGenerationShader = {};
         std::vector<Entry> missShaders;
@@ -847,17 +1405,33 @@ namespace nvrhi::d3d12
 
         uint32_t version = 0;
 
-        ShaderTable(const Context& context, RayTracingPipeline* _pipeline)
+        // Persistent tables only: the device-local copy of the table, and the parameters it was written with
+        BufferHandle persistentBuffer;
+        uint32_t persistentEntrySize = 0;
+        ID3D12DescriptorHeap* persistentHeapSRV = nullptr;
+        ID3D12DescriptorHeap* persistentHeapSamplers = nullptr;
+        // Records changed since the last upload, indexed in the order ray generation, miss, hit group, callable
+        std::vector<uint32_t> dirtyEntries;
+        bool allEntriesDirty = true;
+
+        ShaderTable(const Context& context, RayTracingPipeline* _pipeline, const rt::ShaderTableDesc& _desc)
             : pipeline(_pipeline)
+            , desc(_desc)
             , m_Context(context)
         { }
 
         uint32_t getNumEntries() const;
+        const Entry& getEntry(uint32_t index) const;
+        void markAllEntriesDirty();
 
+        const rt::ShaderTableDesc& getDesc() const override { return desc; }
         void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setMissShader(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setHitGroup(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setCallableShader(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
         void clearMissShaders() override;
         void clearHitShaders() override;
         void clearCallableShaders() override;
@@ -867,6 +1441,10 @@ namespace nvrhi::d3d12
         const Context& m_Context;
 
         bool verifyExport(const RayTracingPipeline::ExportTableEntry* pExport, IBindingSet* bindings) const;
+        bool setEntry(std::vector<Entry>& entries, uint32_t firstEntry, int index, const char* exportName, IBindingSet* bindings);
+        int addEntry(std::vector<Entry>& entries, uint32_t firstEntry, const char* exportName, IBindingSet* bindings);
+        void clearEntries(std::vector<Entry>& entries, uint32_t firstEntry);
+        void markEntryDirty(uint32_t index);
     };
 
 
@@ -892,8 +1470,19 @@ namespace nvrhi::d3d12
         explicit Queue(const Context& context, ID3D12CommandQueue* queue);
         uint64_t updateLastCompletedInstance();
 
+        // Executes the command lists and signals the fence with the new instance, or only appends them
+        // to the pending submission with DeviceDesc::enableDeferredSubmission. Returns the new instance.
+        uint64_t submit(ID3D12CommandList* const* commandLists, size_t numCommandLists);
+
+        // Executes the pending command lists and signals the fence with the last submitted instance
+        void flush();
+
     private:
         const Context& m_Context;
+
+        std::mutex m_SubmitMutex;
+        std::vector<ID3D12CommandList*> m_PendingCommandLists; // kept alive by the command list instances in flight
+        uint64_t m_LastFlushedInstance = 0;
     };
     
     class InternalCommandList
@@ -903,6 +1492,10 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12GraphicsCommandList> commandList;
         RefCountPtr<ID3D12GraphicsCommandList4> commandList4;
         RefCountPtr<ID3D12GraphicsCommandList6> commandList6;
+        RefCountPtr<ID3D12GraphicsCommandList7> commandList7;
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        RefCountPtr<ID3D12GraphicsCommandList10> commandList10;
+#endif
 #if NVRHI_D3D12_WITH_COOPVEC
         RefCountPtr<ID3D12GraphicsCommandListPreview> commandListPreview;
 #endif
@@ -920,15 +1513,25 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12Fence> fence;
         RefCountPtr<ID3D12CommandAllocator> commandAllocator;
         RefCountPtr<ID3D12CommandList> commandList;
-        std::vector<RefCountPtr<IResource>> referencedResources;
+        ResourceReferenceList referencedResources;
         std::vector<RefCountPtr<IUnknown>> referencedNativeResources;
         std::vector<RefCountPtr<StagingTexture>> referencedStagingTextures;
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers;
         std::vector<RefCountPtr<TimerQuery>> referencedTimerQueries;
+        std::vector<RefCountPtr<ReadbackTicket>> referencedReadbacks;
+        std::vector<CommandListHandle> secondaryCommandLists; // bundles executed by this command list, until submission
+        std::vector<std::shared_ptr<CommandListInstance>> secondaryInstances; // and their instances after submission
+        std::shared_ptr<CommandListInstance> recordedInstance; // for submissions of reusable command lists, keeps the recording alive
 #ifdef NVRHI_WITH_RTXMU
         std::vector<uint64_t> rtxmuBuildIds;
         std::vector<uint64_t> rtxmuCompactionIds;
+#else
+        std::vector<PendingCompactedSize> pendingCompactedSizes;
 #endif
+        std::vector<TimerQueryHandle> accelStructTimerQueries; // see AccelStructStatsTracker
+        ProfilerScopeList profilerScopes; // see GpuProfiler
+        std::unique_ptr<TransientDescriptorAllocator> transientShaderResourceViews; // see createTransientBindingSet
+        std::unique_ptr<TransientDescriptorAllocator> transientSamplers;
     };
 
     class CommandList final : public RefCounter<nvrhi::d3d12::ICommandList>
@@ -944,6 +1547,8 @@ namespace nvrhi::d3d12
         void requireSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates state);
         void requireBufferState(IBuffer* buffer, ResourceStates state);
         ID3D12CommandList* getD3D12CommandList() const { return m_ActiveCommandList->commandList; }
+        const CommandListInstance& getInstance() const { return *m_Instance; }
+        CommandListResourceStateTracker& getStateTracker() { return m_StateTracker; }
 
         // IResource implementation
 
@@ -953,6 +1558,8 @@ namespace nvrhi::d3d12
 
         void open() override;
         void close() override;
+        void openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport) override;
+        void executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists) override;
         void clearState() override;
         
         void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
@@ -969,17 +1576,30 @@ namespace nvrhi::d3d12
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        MappedWriteRegion beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
+        MappedWriteRegion beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        void commitWrite() override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        ReadbackTicketHandle readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback) override;
+        ReadbackTicketHandle readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
+        void setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings) override;
+        BindingSetHandle createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
+        void drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
+        void drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -987,16 +1607,27 @@ namespace nvrhi::d3d12
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount) override;
+
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const WorkGraphDispatchArguments& args) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+            nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
@@ -1022,6 +1653,9 @@ namespace nvrhi::d3d12
         
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, ResourceStates nextState) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
 
         void commitBarriers() override;
 
@@ -1030,6 +1664,7 @@ namespace nvrhi::d3d12
 
         nvrhi::IDevice* getDevice() override;
         const CommandListParameters& getDesc() override { return m_Desc; }
+        CommandListStats getStats() override;
 
         // D3D12 specific methods
 
@@ -1060,13 +1695,19 @@ namespace nvrhi::d3d12
         UploadManager m_DxrScratchManager;
         CommandListResourceStateTracker m_StateTracker;
         bool m_EnableAutomaticBarriers = true;
+        bool m_AccelStructBuildTimingActive = false;
         
         CommandListParameters m_Desc;
+        CommandListStats m_Stats;
+
+        ProfilerScopeRecorder m_ProfilerScopes;
+        bool m_ProfilingEnabled = false; // GPU profiler enabled and usable with this command list type
 
         std::shared_ptr<InternalCommandList> m_ActiveCommandList;
         std::list<std::shared_ptr<InternalCommandList>> m_CommandListPool;
         std::shared_ptr<CommandListInstance> m_Instance;
         uint64_t m_RecordingVersion = 0;
+        uint64_t m_LastSubmittedInstance = 0; // of a reusable command list, which keeps its recording until re-opened
 #if NVRHI_WITH_AFTERMATH
         AftermathMarkerTracker m_AftermathTracker;
 #endif
@@ -1077,22 +1718,53 @@ namespace nvrhi::d3d12
         ComputeState m_CurrentComputeState;
         MeshletState m_CurrentMeshletState;
         rt::State m_CurrentRayTracingState;
+        WorkGraphState m_CurrentWorkGraphState;
         bool m_CurrentGraphicsStateValid = false;
         bool m_CurrentComputeStateValid = false;
         bool m_CurrentMeshletStateValid = false;
         bool m_CurrentRayTracingStateValid = false;
+        bool m_CurrentWorkGraphStateValid = false;
 
         // Cache for internal state
 
         ID3D12DescriptorHeap* m_CurrentHeapSRVetc = nullptr;
         ID3D12DescriptorHeap* m_CurrentHeapSamplers = nullptr;
         ID3D12Resource* m_CurrentUploadBuffer = nullptr;
+
+        // Render pass that a bundle is recorded for, see openSecondary
+        FramebufferHandle m_SecondaryFramebuffer;
+        // Last framebuffer that the load ops were applied for
+        Framebuffer* m_LastLoadedFramebuffer = nullptr;
+        ViewportState m_SecondaryViewport;
+
+        // Destination and upload memory of the write started by beginWriteTexture or beginWriteBuffer
+        struct PendingWrite
+        {
+            TextureHandle texture;
+            BufferHandle buffer;
+            ID3D12Resource* uploadBuffer = nullptr;
+            size_t uploadOffset = 0;
+            D3D12_GPU_VIRTUAL_ADDRESS uploadGpuVA = 0;
+            uint64_t destOffset = 0;
+            size_t size = 0;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+            uint32_t subresource = 0;
+            uint64_t rowSizeInBytes = 0;
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint{};
+        } m_PendingWrite;
         SinglePassStereoState m_CurrentSinglePassStereoState;
         
         std::unordered_map<IBuffer*, D3D12_GPU_VIRTUAL_ADDRESS> m_VolatileConstantBufferAddresses;
         bool m_AnyVolatileBufferWrites = false;
 
         std::vector<D3D12_RESOURCE_BARRIER> m_D3DBarriers; // Used locally in commitBarriers, member to avoid re-allocations
+        std::vector<D3D12_TEXTURE_BARRIER> m_D3DTextureBarriers; // Same, for the Enhanced Barriers path
+        std::vector<D3D12_BUFFER_BARRIER> m_D3DBufferBarriers;
+
+        // Textures that were aliased onto memory used by another resource and not transitioned since,
+        // their next Enhanced Barrier transition discards the contents instead of preserving the layout.
+        std::vector<const TextureStateExtension*> m_TexturesToDiscard;
 
         // Bound volatile buffer state. Saves currently bound volatile buffers and their current GPU VAs.
         // Necessary to patch the bound VAs when a buffer is updated between setGraphicsState and draw, or between draws.
@@ -1102,17 +1774,64 @@ namespace nvrhi::d3d12
 
         std::unordered_map<rt::IShaderTable*, std::unique_ptr<ShaderTableState>> m_ShaderTableStates;
         ShaderTableState* getShaderTableStateTracking(rt::IShaderTable* shaderTable);
+        void writeShaderTableEntry(uint8_t* pDest, const ShaderTable::Entry& entry);
+        bool updatePersistentShaderTable(ShaderTable* shaderTable);
         
         void clearStateCache();
+        void beginRecording();
+        void releaseReusableRecording();
+        // Recycles a recording that was closed but never executed
+        void releaseUnsubmittedRecording();
+        std::shared_ptr<CommandListInstance> executedReusable(Queue* pQueue);
+        bool useEnhancedBarriers() const;
+        void commitBarriersEnhanced();
 
         void bindGraphicsPipeline(GraphicsPipeline* pso, bool updateRootSignature) const;
         void bindMeshletPipeline(MeshletPipeline* pso, bool updateRootSignature) const;
         void bindFramebuffer(Framebuffer* fb);
+        // Clears or discards the attachments of a framebuffer that is bound after a different one, see AttachmentLoadOp.
+        // Must be called after the attachment barriers are committed.
+        void applyFramebufferLoadOps(Framebuffer* fb);
         void unbindShadingRateState();
         
         std::shared_ptr<InternalCommandList> createInternalCommandList() const;
 
         void buildTopLevelAccelStructInternal(AccelStruct* as, D3D12_GPU_VIRTUAL_ADDRESS instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags);
+        // Times the build call that the returned scope is in, if enabled in the device desc
+        ScopedAccelStructBuildTimer timeAccelStructBuild();
+
+        // Parts of buildBottomLevelAccelStruct that are shared with the batched buildBottomLevelAccelStructs
+        void setBlasBuildInputStates(const rt::GeometryDesc* pGeometries, size_t numGeometries);
+        bool fillBlasBuildInputs(D3D12BuildRaytracingAccelerationStructureInputs& inputs, AccelStruct* as,
+            const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags);
+#ifndef NVRHI_WITH_RTXMU
+        bool getBlasScratchSize(AccelStruct* as, bool performUpdate, uint64_t& scratchSize);
+        // Also makes builds with AllowCompaction write the compacted size of the BLAS for the BlasCompactionManager
+        void recordBlasBuild(D3D12BuildRaytracingAccelerationStructureInputs& inputs, AccelStruct* as,
+            D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA, rt::AccelStructBuildFlags buildFlags);
+#endif
+
+        // Parts of buildOpacityMicromap that are shared with the batched buildOpacityMicromaps
+        bool getOpacityMicromapScratchSize(const rt::OpacityMicromapDesc& desc, uint64_t& scratchSize);
+        void recordOpacityMicromapBuild(OpacityMicromap* omm, const rt::OpacityMicromapDesc& desc, D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA);
+    };
+
+    class Device;
+
+    // Reads the GPU profiler timestamps from the timer query resolve buffer
+    class ProfilerTimestampSource final : public IProfilerTimestampSource
+    {
+    public:
+        explicit ProfilerTimestampSource(Device& device)
+            : m_Device(device)
+        { }
+
+        bool readTimestamps(ITimerQuery* const* queries, size_t numQueries, uint64_t* outTimestamps) override;
+        uint64_t getTimestampFrequency(CommandQueue queue) override;
+        bool calibrateTimestamps(CommandQueue queue, uint64_t& outGpuTimestamp, int64_t& outCpuTimeNs) override;
+
+    private:
+        Device& m_Device;
     };
 
     class Device final : public RefCounter<IDevice>
@@ -1166,6 +1885,10 @@ namespace nvrhi::d3d12
         bool pollEventQuery(IEventQuery* query) override;
         void waitEventQuery(IEventQuery* query) override;
         void resetEventQuery(IEventQuery* query) override;
+        SubmissionTicket getSubmissionTicket(CommandQueue queue) override;
+        bool pollSubmission(const SubmissionTicket& ticket) override;
+        bool waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
+        bool waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
 
         TimerQueryHandle createTimerQuery() override;
         bool pollTimerQuery(ITimerQuery* query) override;
@@ -1185,8 +1908,10 @@ namespace nvrhi::d3d12
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
 
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        WorkGraphPipelineHandle createWorkGraphPipeline(const WorkGraphPipelineDesc& desc) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline) override;
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -1207,10 +1932,19 @@ namespace nvrhi::d3d12
         nvrhi::CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void flushSubmissions() override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        void runGarbageCollection(uint32_t maxReleaseMicroseconds) override;
+        void evictCachedFramebuffers(ITexture* texture) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
+        MemoryAllocatorStats getMemoryAllocatorStats() override;
+        MemoryBudget getMemoryBudget() override;
+        AccelStructStats getAccelStructStats() override;
+        DeviceStats getDeviceStats() override;
+        bool getProfilerFrameResults(ProfilerFrameResults& outResults) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& data) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
@@ -1224,6 +1958,8 @@ namespace nvrhi::d3d12
         GraphicsPipelineHandle createHandleForNativeGraphicsPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const GraphicsPipelineDesc& desc, const FramebufferInfo& framebufferInfo) override;
         MeshletPipelineHandle createHandleForNativeMeshletPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const MeshletPipelineDesc& desc, const FramebufferInfo& framebufferInfo) override;
         IDescriptorHeap* getDescriptorHeap(DescriptorHeapType heapType) override;
+        rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override;
+        ShaderHandle addShaderSpecializationPermutation(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants, const void* binary, size_t binarySize) override;
 
         // Internal interface
         Queue* getQueue(CommandQueue type) { return m_Queues[int(type)].get(); }
@@ -1244,10 +1980,29 @@ namespace nvrhi::d3d12
 
         std::array<std::unique_ptr<Queue>, (int)CommandQueue::Count> m_Queues;
         HANDLE m_FenceEvent;
+        HANDLE m_MultipleFenceEvent; // only used by waitForSubmissions, which may leave it signaled late after a timeout
+
+        std::shared_ptr<ObjectPool<EventQuery>> m_EventQueryPool = std::make_shared<ObjectPool<EventQuery>>();
 
         std::mutex m_Mutex;
 
         std::vector<ID3D12CommandList*> m_CommandListsToExecute; // used locally in executeCommandLists, member to avoid re-allocations
+
+        // Resources of retired command lists that budgeted garbage collection has not released yet
+        ReleaseQueue m_ReleaseQueue;
+
+        std::mutex m_QueueSyncMutex;
+        QueueDependencies m_QueueDependencies; // used locally in executeCommandLists, member to avoid re-allocations
+
+        RefCountPtr<ID3D12PipelineLibrary1> m_PipelineLibrary;
+        std::vector<uint8_t> m_PipelineLibraryData; // the serialized library that m_PipelineLibrary was created from, must outlive it
+        mutable std::mutex m_PipelineLibraryLoadMutex; // concurrent loads of the same pipeline must be synchronized by the application
+
+        std::unique_ptr<BindingSetCache> m_BindingSetCache; // only created with enableBindingSetCache
+        std::unique_ptr<FramebufferCache> m_FramebufferCache; // only created with enableFramebufferCache
+        ProfilerTimestampSource m_ProfilerTimestamps { *this };
+        float m_DescriptorTableGrowthFactor = 1.f;
+        bool m_ReserveDescriptorTableCapacity = false;
         
         bool m_NvapiIsInitialized = false;
         bool m_SinglePassStereoSupported = false;
@@ -1256,6 +2011,7 @@ namespace nvrhi::d3d12
         bool m_RayTracingSupported = false;
         bool m_TraceRayInlineSupported = false;
         bool m_MeshletsSupported = false;
+        bool m_WorkGraphsSupported = false;
         bool m_VariableRateShadingSupported = false;
         bool m_OpacityMicromapSupported = false;
         bool m_RayTracingClustersSupported = false;
@@ -1280,6 +2036,21 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12PipelineState> createPipelineState(const GraphicsPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo) const;
         RefCountPtr<ID3D12PipelineState> createPipelineState(const ComputePipelineDesc& desc, RootSignature* pRS) const;
         RefCountPtr<ID3D12PipelineState> createPipelineState(const MeshletPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo) const;
+        rt::PipelineHandle createRayTracingPipelineInternal(const rt::PipelineDesc& desc, RayTracingPipeline* basePipeline);
+        BindingSetHandle createBindingSetInternal(const BindingSetDesc& desc, IBindingLayout* layout);
+        FramebufferHandle createFramebufferInternal(const FramebufferDesc& desc);
+
+        // Waits for a queue fence on the CPU, flushing the deferred submissions first if the fence is not there yet
+        void waitForQueueFence(ID3D12Fence* fence, uint64_t value);
+        bool waitForSubmissions(const SubmissionTicket* tickets, size_t numTickets, bool waitAll, uint64_t timeoutNanoseconds);
+        void collectGarbage(bool releaseAll, uint32_t maxReleaseMicroseconds);
+
+        void createPipelineLibrary(const DeviceDesc& desc);
+        // These functions load the pipeline state from the pipeline library if it's there, or create it and store it in the library.
+        // When the library is disabled, they just create the pipeline state.
+        HRESULT createGraphicsPipelineStateCached(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const RootSignature* pRS, RefCountPtr<ID3D12PipelineState>& pipelineState) const;
+        HRESULT createComputePipelineStateCached(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const RootSignature* pRS, RefCountPtr<ID3D12PipelineState>& pipelineState) const;
+        HRESULT createPipelineStateCached(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, const PipelineKeyHasher& key, RefCountPtr<ID3D12PipelineState>& pipelineState) const;
     
     };
 
@@ -57,6 +57,15 @@ namespace nvrhi::d3d12
             m_Resources.shaderResourceViewHeap.releaseDescriptor(m_ClearUAV);
             m_ClearUAV = c_InvalidDescriptorIndex;
         }
+
+        if (placedAllocation.heap)
+        {
+            // Destroy the resource before its memory can be reused by another one
+            resource = nullptr;
+            m_Resources.placedResourceAllocator.release(placedAllocation);
+        }
+
+        m_Resources.residencyManager.unregisterResource(residency);
     }
 
     BufferHandle Device::createBuffer(const BufferDesc& d)
@@ -68,6 +77,7 @@ namespace nvrhi::d3d12
         }
 
         Buffer* buffer = new Buffer(m_Context, m_Resources, desc);
+        buffer->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::Buffer, d.isVolatile ? 0 : desc.byteSize);
         
         if (d.isVolatile)
         {
@@ -124,7 +134,10 @@ namespace nvrhi::d3d12
                 break;
 
             case CpuAccessMode::Write:
-                heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+                // GPU upload heaps are CPU-visible video memory, use them for buffers that are read often by the GPU
+                heapProps.Type = (d.preferDeviceLocal && m_Context.gpuUploadHeapSupported)
+                    ? D3D12_HEAP_TYPE_GPU_UPLOAD
+                    : D3D12_HEAP_TYPE_UPLOAD;
                 initialState = D3D12_RESOURCE_STATE_GENERIC_READ;
                 break;
         }
@@ -138,13 +151,52 @@ namespace nvrhi::d3d12
             initialState = D3D12_RESOURCE_STATE_COMMON;
         }
 
-        HRESULT res = m_Context.device->CreateCommittedResource(
-            &heapProps,
-            heapFlags,
-            &resourceDesc,
-            initialState,
-            nullptr,
-            IID_PPV_ARGS(&buffer->resource));
+        HRESULT res = S_OK;
+
+        // Shared buffers must own their heap, and custom heaps are not pooled
+        if (!isShared && heapProps.Type != D3D12_HEAP_TYPE_CUSTOM && m_Resources.usePlacedResourceAllocator(d.allocationMode))
+        {
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = m_Context.device->GetResourceAllocationInfo(1, 1, &resourceDesc);
+
+            if (m_Resources.placedResourceAllocator.allocate(allocInfo, heapProps.Type, PlacedResourceCategory::Buffer, buffer->placedAllocation))
+            {
+                res = m_Context.device->CreatePlacedResource(
+                    buffer->placedAllocation.heap->heap,
+                    buffer->placedAllocation.offset,
+                    &resourceDesc,
+                    initialState,
+                    nullptr,
+                    IID_PPV_ARGS(&buffer->resource));
+
+                // Fall back to a committed resource if placement failed for any reason
+                if (FAILED(res))
+                    m_Resources.placedResourceAllocator.release(buffer->placedAllocation);
+            }
+        }
+
+        if (!buffer->resource)
+        {
+            res = m_Context.device->CreateCommittedResource(
+                &heapProps,
+                heapFlags,
+                &resourceDesc,
+                initialState,
+                nullptr,
+                IID_PPV_ARGS(&buffer->resource));
+        }
+
+        if (FAILED(res) && heapProps.Type == D3D12_HEAP_TYPE_GPU_UPLOAD)
+        {
+            // The CPU-visible part of video memory is exhausted, fall back to a regular upload heap
+            heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+            res = m_Context.device->CreateCommittedResource(
+                &heapProps,
+                heapFlags,
+                &resourceDesc,
+                initialState,
+                nullptr,
+                IID_PPV_ARGS(&buffer->resource));
+        }
 
         if (FAILED(res))
         {
@@ -179,6 +231,12 @@ namespace nvrhi::d3d12
             }
         }
 
+        // Acceleration structure storage is referenced through GPU addresses that the residency manager can't observe
+        if (!buffer->placedAllocation.heap && !isShared && heapProps.Type == D3D12_HEAP_TYPE_DEFAULT && !d.isAccelStructStorage)
+        {
+            m_Resources.residencyManager.registerResource(buffer->residency, buffer->resource, d.residencyPriority);
+        }
+
         buffer->postCreate();
 
         return BufferHandle::Create(buffer);
@@ -255,7 +313,7 @@ namespace nvrhi::d3d12
 
         if (b->lastUseFence)
         {
-            WaitForFence(b->lastUseFence, b->lastUseFenceValue, m_FenceEvent);
+            waitForQueueFence(b->lastUseFence, b->lastUseFenceValue);
             b->lastUseFence = nullptr;
         }
 
@@ -354,6 +412,7 @@ namespace nvrhi::d3d12
 
         Buffer* buffer = new Buffer(m_Context, m_Resources, desc);
         buffer->resource = pResource;
+        buffer->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::Buffer, desc.byteSize);
         
         buffer->postCreate();
 
@@ -495,46 +554,40 @@ namespace nvrhi::d3d12
         m_Context.device->CreateUnorderedAccessView(resource, nullptr, &viewDesc, { descriptor });
     }
     
-    void CommandList::writeBuffer(IBuffer* _b, const void * data, size_t dataSize, uint64_t destOffsetBytes)
+    MappedWriteRegion CommandList::beginWriteBuffer(IBuffer* _b, size_t dataSize, uint64_t destOffsetBytes)
     {
         Buffer* buffer = checked_cast<Buffer*>(_b);
 
         void* cpuVA;
-        D3D12_GPU_VIRTUAL_ADDRESS gpuVA;
-        ID3D12Resource* uploadBuffer;
-        size_t offsetInUploadBuffer;
-        if (!m_UploadManager.suballocateBuffer(dataSize, nullptr, &uploadBuffer, &offsetInUploadBuffer, &cpuVA, &gpuVA, 
-            m_RecordingVersion, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT))
+        if (!m_UploadManager.suballocateBuffer(dataSize, nullptr, &m_PendingWrite.uploadBuffer, &m_PendingWrite.uploadOffset, &cpuVA,
+            &m_PendingWrite.uploadGpuVA, m_RecordingVersion, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT))
         {
             m_Context.error("Couldn't suballocate an upload buffer");
-            return;
+            return MappedWriteRegion();
         }
 
-        if (uploadBuffer != m_CurrentUploadBuffer)
-        {
-            m_Instance->referencedNativeResources.push_back(uploadBuffer);
-            m_CurrentUploadBuffer = uploadBuffer;
-        }
+        m_PendingWrite.buffer = buffer;
+        m_PendingWrite.destOffset = destOffsetBytes;
+        m_PendingWrite.size = dataSize;
+        m_Stats.uploadBytes += dataSize;
+        if (buffer->desc.isVolatile)
+            ++m_Stats.volatileBufferWrites;
 
-        memcpy(cpuVA, data, dataSize);
+        MappedWriteRegion region;
+        region.data = cpuVA;
+        region.size = dataSize;
+        return region;
+    }
 
-        if (buffer->desc.isVolatile)
-        {
-            m_VolatileConstantBufferAddresses[buffer] = gpuVA;
-            m_AnyVolatileBufferWrites = true;
-        }
-        else
-        {
-            if (m_EnableAutomaticBarriers)
-            {
-                requireBufferState(buffer, ResourceStates::CopyDest);
-            }
-            commitBarriers();
+    void CommandList::writeBuffer(IBuffer* b, const void * data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        const MappedWriteRegion region = beginWriteBuffer(b, dataSize, destOffsetBytes);
+        if (!region.data)
+            return;
 
-            m_Instance->referencedResources.push_back(buffer);
+        memcpy(region.data, data, dataSize);
 
-            m_ActiveCommandList->commandList->CopyBufferRegion(buffer->resource, destOffsetBytes, uploadBuffer, offsetInUploadBuffer, dataSize);
-        }
+        commitWrite();
     }
 
     void CommandList::clearBufferUInt(IBuffer* _b, uint32_t clearValue)
@@ -561,7 +614,7 @@ namespace nvrhi::d3d12
         DescriptorIndex clearUAV = b->getClearUAV();
         assert(clearUAV != c_InvalidDescriptorIndex);
 
-        m_Instance->referencedResources.push_back(b);
+        m_Instance->referencedResources.add(b);
 
         const uint32_t values[4] = { clearValue, clearValue, clearValue, clearValue };
         m_ActiveCommandList->commandList->ClearUnorderedAccessViewUint(
@@ -585,12 +638,12 @@ namespace nvrhi::d3d12
         if(src->desc.cpuAccess != CpuAccessMode::None)
             m_Instance->referencedStagingBuffers.push_back(src);
         else
-            m_Instance->referencedResources.push_back(src);
+            m_Instance->referencedResources.add(src);
 
         if (dest->desc.cpuAccess != CpuAccessMode::None)
             m_Instance->referencedStagingBuffers.push_back(dest);
         else
-            m_Instance->referencedResources.push_back(dest);
+            m_Instance->referencedResources.add(dest);
 
         m_ActiveCommandList->commandList->CopyBufferRegion(dest->resource, destOffsetBytes, src->resource, srcOffsetBytes, dataSizeBytes);
     }
@@ -33,8 +33,9 @@ namespace nvrhi::d3d12
         , m_Resources(resources)
         , m_Device(device)
         , m_Queue(device->getQueue(params.queueType))
-        , m_UploadManager(context, m_Queue, params.uploadChunkSize, 0, false)
-        , m_DxrScratchManager(context, m_Queue, params.scratchChunkSize, params.scratchMaxMemory, true)
+        // Reusable command lists keep their upload memory until re-opened, which would stall the ring
+        , m_UploadManager(context, m_Queue, resources.deviceStats, params.uploadChunkSize, 0, false, params.isReusable ? 0 : context.uploadRingBufferSize)
+        , m_DxrScratchManager(context, m_Queue, resources.deviceStats, params.scratchChunkSize, params.scratchMaxMemory, true)
         , m_StateTracker(context.messageCallback)
         , m_Desc(params)
     {
@@ -42,10 +43,23 @@ namespace nvrhi::d3d12
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
 #endif
+
+        m_StateTracker.setReusable(params.isReusable);
+
+        // Bundles can't contain queries, and timestamps on copy queues are an optional feature
+        m_ProfilingEnabled = resources.profiler.isEnabled() && !params.isSecondary && !params.isReusable
+            && params.queueType != CommandQueue::Copy;
     }
 
     CommandList::~CommandList()
     {
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.discard(m_Resources.profiler, m_Device);
+
+        if (!m_Desc.isReusable)
+            releaseUnsubmittedRecording();
+
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().unRegisterAftermathMarkerTracker(&m_AftermathTracker);
@@ -81,7 +95,11 @@ namespace nvrhi::d3d12
         auto commandList = std::make_shared<InternalCommandList>();
 
         D3D12_COMMAND_LIST_TYPE d3dCommandListType;
-        switch (m_Desc.queueType)
+        if (m_Desc.isSecondary)
+        {
+            d3dCommandListType = D3D12_COMMAND_LIST_TYPE_BUNDLE;
+        }
+        else switch (m_Desc.queueType)
         {
         case CommandQueue::Graphics:
             d3dCommandListType = D3D12_COMMAND_LIST_TYPE_DIRECT;
@@ -104,6 +122,11 @@ namespace nvrhi::d3d12
 
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList4));
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList6));
+        if (m_Context.enhancedBarriersSupported)
+            commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList7));
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList10));
+#endif
 #if NVRHI_D3D12_WITH_COOPVEC
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandListPreview));
 #endif
@@ -170,6 +193,14 @@ namespace nvrhi::d3d12
         return m_Device;
     }
 
+    CommandListStats CommandList::getStats()
+    {
+        CommandListStats stats = m_Stats;
+        stats.barriersIssued = m_StateTracker.getIssuedBarrierCount();
+        stats.barriersElided = m_StateTracker.getElidedBarrierCount();
+        return stats;
+    }
+
     void CommandList::beginMarker(const char* name)
     {
         PIXBeginEvent(m_ActiveCommandList->commandList, 0, name);
@@ -180,10 +211,16 @@ namespace nvrhi::d3d12
             GFSDK_Aftermath_SetEventMarker(m_ActiveCommandList->aftermathContext, (const void*)aftermathMarker, 0);
         }
 #endif
+
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.beginScope(m_Resources.profiler, m_Device, this, name);
     }
 
     void CommandList::endMarker()
     {
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.endScope(this);
+
         PIXEndEvent(m_ActiveCommandList->commandList);
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
@@ -220,6 +257,12 @@ namespace nvrhi::d3d12
             rootsig = pso->rootSignature;
             isGraphics = true;
         }
+        else if (m_CurrentWorkGraphStateValid && m_CurrentWorkGraphState.pipeline)
+        {
+            WorkGraphPipeline* pso = checked_cast<WorkGraphPipeline*>(m_CurrentWorkGraphState.pipeline);
+            rootsig = pso->rootSignature;
+            isGraphics = false;
+        }
 
         if (!rootsig || !rootsig->pushConstantByteSize)
             return;
@@ -234,6 +277,159 @@ namespace nvrhi::d3d12
 
     void CommandList::open()
     {
+        if (m_Desc.isSecondary)
+        {
+            m_Context.error("Secondary command lists must be opened with openSecondary");
+            return;
+        }
+
+        beginRecording();
+    }
+
+    void CommandList::openSecondary(IFramebuffer* _framebuffer, const ViewportState& viewport)
+    {
+        if (!m_Desc.isSecondary)
+        {
+            m_Context.error("openSecondary can only be used on command lists created with isSecondary = true");
+            return;
+        }
+
+        beginRecording();
+
+        // Bundles can't place barriers, the primary command list transitions the framebuffer
+        m_EnableAutomaticBarriers = false;
+        m_SecondaryFramebuffer = checked_cast<Framebuffer*>(_framebuffer);
+        m_SecondaryViewport = viewport;
+        m_Instance->referencedResources.add(_framebuffer);
+    }
+
+    void CommandList::executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        Framebuffer* currentFramebuffer = m_CurrentGraphicsStateValid
+            ? checked_cast<Framebuffer*>(m_CurrentGraphicsState.framebuffer)
+            : nullptr;
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* secondary = checked_cast<CommandList*>(pCommandLists[i]);
+            Framebuffer* framebuffer = checked_cast<Framebuffer*>(secondary->m_SecondaryFramebuffer.Get());
+
+            // Bundles inherit the descriptor heaps, and the render targets and viewports that are set below
+            commitDescriptorHeaps();
+
+            if (framebuffer != currentFramebuffer)
+            {
+                bindFramebuffer(framebuffer);
+                m_Instance->referencedResources.add(framebuffer);
+                currentFramebuffer = framebuffer;
+            }
+
+            // bindFramebuffer only requires the states when the framebuffer changes, and the commands
+            // recorded since then may have moved the attachments out of them
+            if (m_EnableAutomaticBarriers)
+                setResourceStatesForFramebuffer(framebuffer);
+
+            commitBarriers();
+
+            applyFramebufferLoadOps(framebuffer);
+
+            const ViewportState& viewport = secondary->m_SecondaryViewport;
+            DX12_ViewportState vpState = convertViewportState(RasterState().setScissorEnable(!viewport.scissorRects.empty()),
+                framebuffer->framebufferInfo, viewport);
+
+            if (vpState.numViewports)
+            {
+                m_ActiveCommandList->commandList->RSSetViewports(vpState.numViewports, vpState.viewports);
+            }
+
+            if (vpState.numScissorRects)
+            {
+                m_ActiveCommandList->commandList->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+            }
+
+            m_ActiveCommandList->commandList->ExecuteBundle(secondary->m_ActiveCommandList->commandList);
+
+            m_Instance->secondaryCommandLists.push_back(secondary);
+        }
+
+        // Pipeline and bindings set by the bundles leak into this command list, keep only the descriptor heaps
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
+        m_CurrentGraphicsVolatileCBs.resize(0);
+        m_CurrentComputeVolatileCBs.resize(0);
+    }
+
+    void CommandList::releaseReusableRecording()
+    {
+        if (!m_ActiveCommandList)
+            return;
+
+        // The recording may still be used by submissions in flight, so hand everything back with the version
+        // of the last submission. If it was never submitted, instance 0 makes everything available immediately.
+        m_ActiveCommandList->lastSubmittedInstance = m_LastSubmittedInstance;
+        m_CommandListPool.push_back(m_ActiveCommandList);
+        m_ActiveCommandList.reset();
+        m_Instance.reset();
+
+        uint64_t submittedVersion = MakeVersion(m_LastSubmittedInstance, m_Desc.queueType, true);
+        m_UploadManager.submitChunks(m_RecordingVersion, submittedVersion);
+        m_DxrScratchManager.submitChunks(m_RecordingVersion, submittedVersion);
+        m_RecordingVersion = 0;
+        m_LastSubmittedInstance = 0;
+
+        m_StateTracker.reset();
+    }
+
+    void CommandList::releaseUnsubmittedRecording()
+    {
+        if (m_RecordingVersion != 0)
+        {
+            // The previous recording was closed but never executed, so the GPU never reads its uploads.
+            // Instance 0 makes its chunks and ring regions available immediately, otherwise the ring
+            // would stop at the unsubmitted region forever.
+            const uint64_t discardedVersion = MakeVersion(0, m_Desc.queueType, true);
+            m_UploadManager.submitChunks(m_RecordingVersion, discardedVersion);
+            m_DxrScratchManager.submitChunks(m_RecordingVersion, discardedVersion);
+            m_RecordingVersion = 0;
+        }
+
+        if (m_Instance)
+        {
+#ifndef NVRHI_WITH_RTXMU
+            if (!m_Instance->pendingCompactedSizes.empty())
+                m_Resources.blasCompaction.buildsDiscarded(m_Instance->pendingCompactedSizes);
+#endif
+            // The bundles executed here still belong to their command lists, which recycle them
+            m_Instance.reset();
+        }
+
+        if (m_ActiveCommandList)
+        {
+            // Never submitted, so the allocator can be reset right away by the next recording
+            m_ActiveCommandList->lastSubmittedInstance = 0;
+            m_CommandListPool.push_front(m_ActiveCommandList);
+            m_ActiveCommandList.reset();
+        }
+
+        m_SecondaryFramebuffer = nullptr;
+    }
+
+    void CommandList::beginRecording()
+    {
+        if (m_Desc.isReusable)
+            releaseReusableRecording();
+        else
+            releaseUnsubmittedRecording();
+
+        m_Stats = CommandListStats();
+        m_StateTracker.resetBarrierCounts();
+
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.discard(m_Resources.profiler, m_Device);
+
         uint64_t completedInstance = m_Queue->updateLastCompletedInstance();
 
         std::shared_ptr<InternalCommandList> chunk;
@@ -260,6 +456,7 @@ namespace nvrhi::d3d12
         }
 
         m_ActiveCommandList = chunk;
+        m_LastLoadedFramebuffer = nullptr;
 
         m_Instance = std::make_shared<CommandListInstance>();
         m_Instance->commandAllocator = m_ActiveCommandList->allocator;
@@ -276,6 +473,7 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = false;
         m_CurrentMeshletStateValid = false;
         m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentHeapSRVetc = nullptr;
         m_CurrentHeapSamplers = nullptr;
         m_CurrentGraphicsVolatileCBs.resize(0);
@@ -307,9 +505,13 @@ namespace nvrhi::d3d12
 
     void CommandList::close()
     {
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.endAllScopes(this);
+
         m_StateTracker.keepBufferInitialStates();
         m_StateTracker.keepTextureInitialStates();
         commitBarriers();
+        m_TexturesToDiscard.clear();
 
 #ifdef NVRHI_WITH_RTXMU
         if (!m_Instance->rtxmuBuildIds.empty())
@@ -325,10 +527,14 @@ namespace nvrhi::d3d12
         m_CurrentUploadBuffer = nullptr;
         m_VolatileConstantBufferAddresses.clear();
         m_ShaderTableStates.clear();
+        m_SecondaryViewport = ViewportState();
     }
 
     std::shared_ptr<CommandListInstance> CommandList::executed(Queue* pQueue)
     {
+        if (m_Desc.isReusable)
+            return executedReusable(pQueue);
+
         std::shared_ptr<CommandListInstance> instance = m_Instance;
         instance->fence = pQueue->fence;
         instance->submittedInstance = pQueue->lastSubmittedInstance;
@@ -337,6 +543,13 @@ namespace nvrhi::d3d12
         m_ActiveCommandList->lastSubmittedInstance = pQueue->lastSubmittedInstance;
         m_CommandListPool.push_back(m_ActiveCommandList);
         m_ActiveCommandList.reset();
+        m_SecondaryFramebuffer = nullptr;
+
+        for (const auto& secondary : instance->secondaryCommandLists)
+        {
+            instance->secondaryInstances.push_back(checked_cast<CommandList*>(secondary.Get())->executed(pQueue));
+        }
+        instance->secondaryCommandLists.clear();
 
         for (const auto& it : instance->referencedStagingTextures)
         {
@@ -358,6 +571,21 @@ namespace nvrhi::d3d12
             it->fenceCounter = instance->submittedInstance;
         }
 
+        for (const auto& it : instance->referencedReadbacks)
+        {
+            it->fence = pQueue->fence;
+            it->fenceCounter = instance->submittedInstance;
+
+            if (it->callback)
+                m_Resources.readbackPool.addPendingCallback(it);
+        }
+
+        if (m_ProfilingEnabled)
+        {
+            instance->profilerScopes = m_ProfilerScopes.takeScopes();
+            m_Resources.profiler.scopesSubmitted(instance->profilerScopes, m_Desc.queueType);
+        }
+
         m_StateTracker.commandListSubmitted();
 
         uint64_t submittedVersion = MakeVersion(instance->submittedInstance, m_Desc.queueType, true);
@@ -368,6 +596,56 @@ namespace nvrhi::d3d12
         return instance;
     }
 
+    std::shared_ptr<CommandListInstance> CommandList::executedReusable(Queue* pQueue)
+    {
+        // The recording stays with the command list for the next submission. Each submission gets its own
+        // instance for the in-flight tracking, which keeps the recording and its resources alive.
+        auto instance = std::make_shared<CommandListInstance>();
+        instance->fence = pQueue->fence;
+        instance->submittedInstance = pQueue->lastSubmittedInstance;
+        instance->commandQueue = m_Desc.queueType;
+        instance->commandAllocator = m_Instance->commandAllocator;
+        instance->commandList = m_Instance->commandList;
+        instance->recordedInstance = m_Instance;
+#ifdef NVRHI_WITH_RTXMU
+        // The builds are only reported once, with the first submission
+        instance->rtxmuBuildIds = std::move(m_Instance->rtxmuBuildIds);
+        instance->rtxmuCompactionIds = std::move(m_Instance->rtxmuCompactionIds);
+        m_Instance->rtxmuBuildIds.clear();
+        m_Instance->rtxmuCompactionIds.clear();
+#else
+        instance->pendingCompactedSizes = std::move(m_Instance->pendingCompactedSizes);
+        m_Instance->pendingCompactedSizes.clear();
+#endif
+
+        m_ActiveCommandList->lastSubmittedInstance = pQueue->lastSubmittedInstance;
+        m_LastSubmittedInstance = pQueue->lastSubmittedInstance;
+
+        for (const auto& it : m_Instance->referencedStagingTextures)
+        {
+            it->lastUseFence = pQueue->fence;
+            it->lastUseFenceValue = instance->submittedInstance;
+        }
+
+        for (const auto& it : m_Instance->referencedStagingBuffers)
+        {
+            it->lastUseFence = pQueue->fence;
+            it->lastUseFenceValue = instance->submittedInstance;
+        }
+
+        for (const auto& it : m_Instance->referencedTimerQueries)
+        {
+            it->started = true;
+            it->resolved = false;
+            it->fence = pQueue->fence;
+            it->fenceCounter = instance->submittedInstance;
+        }
+
+        m_StateTracker.commandListSubmitted();
+
+        return instance;
+    }
+
     void CommandList::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
     {
 #if NVRHI_D3D12_WITH_COOPVEC
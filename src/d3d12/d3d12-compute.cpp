@@ -67,7 +67,7 @@ namespace nvrhi::d3d12
         }
 #endif
 
-        const HRESULT hr = m_Context.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+        const HRESULT hr = createComputePipelineStateCached(desc, pRS, pipelineState);
 
         if (FAILED(hr))
         {
@@ -80,6 +80,8 @@ namespace nvrhi::d3d12
 
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::createComputePipeline");
+
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
         RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS);
 
@@ -89,6 +91,7 @@ namespace nvrhi::d3d12
         ComputePipeline *pso = new ComputePipeline();
 
         pso->desc = desc;
+        pso->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::ComputePipeline);
 
         pso->rootSignature = pRS;
         pso->pipelineState = pPSO;
@@ -124,8 +127,9 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             m_ActiveCommandList->commandList->SetPipelineState(pso->pipelineState);
+            ++m_Stats.pipelineBinds;
             
-            m_Instance->referencedResources.push_back(pso);
+            m_Instance->referencedResources.add(pso);
         }
 
         setComputeBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
@@ -136,6 +140,7 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = true;
         m_CurrentMeshletStateValid = false;
         m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentComputeState = state;
         
         commitBarriers();
@@ -165,6 +170,7 @@ namespace nvrhi::d3d12
     void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
     {
         updateComputeVolatileBuffers();
+        ++m_Stats.dispatches;
 
         m_ActiveCommandList->commandList->Dispatch(groupsX, groupsY, groupsZ);
     }
@@ -175,6 +181,7 @@ namespace nvrhi::d3d12
         assert(indirectParams); // validation layer handles this
 
         updateComputeVolatileBuffers();
+        ++m_Stats.dispatches;
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchIndirectSignature, 1, indirectParams->resource, offsetBytes, nullptr, 0);
     }
@@ -275,6 +275,179 @@ namespace nvrhi::d3d12
         return result;
     }
 
+    struct BarrierStateMappingInternal
+    {
+        ResourceStates nvrhiState;
+        D3D12_BARRIER_SYNC sync;
+        D3D12_BARRIER_ACCESS access;
+        D3D12_BARRIER_LAYOUT layout; // UNDEFINED for states that do not imply a texture layout
+    };
+
+    static const BarrierStateMappingInternal g_BarrierStateMap[] =
+    {
+        { ResourceStates::ConstantBuffer,
+            D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_CONSTANT_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::VertexBuffer,
+            D3D12_BARRIER_SYNC_VERTEX_SHADING,
+            D3D12_BARRIER_ACCESS_VERTEX_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::IndexBuffer,
+            D3D12_BARRIER_SYNC_INDEX_INPUT,
+            D3D12_BARRIER_ACCESS_INDEX_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::IndirectArgument,
+            D3D12_BARRIER_SYNC_EXECUTE_INDIRECT,
+            D3D12_BARRIER_ACCESS_INDIRECT_ARGUMENT,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ShaderResource,
+            D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_SHADER_RESOURCE },
+        { ResourceStates::UnorderedAccess,
+            D3D12_BARRIER_SYNC_ALL_SHADING | D3D12_BARRIER_SYNC_CLEAR_UNORDERED_ACCESS_VIEW,
+            D3D12_BARRIER_ACCESS_UNORDERED_ACCESS,
+            D3D12_BARRIER_LAYOUT_UNORDERED_ACCESS },
+        { ResourceStates::RenderTarget,
+            D3D12_BARRIER_SYNC_RENDER_TARGET,
+            D3D12_BARRIER_ACCESS_RENDER_TARGET,
+            D3D12_BARRIER_LAYOUT_RENDER_TARGET },
+        { ResourceStates::DepthWrite,
+            D3D12_BARRIER_SYNC_DEPTH_STENCIL,
+            D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE,
+            D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE },
+        { ResourceStates::DepthRead,
+            D3D12_BARRIER_SYNC_DEPTH_STENCIL,
+            D3D12_BARRIER_ACCESS_DEPTH_STENCIL_READ,
+            D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ },
+        { ResourceStates::StreamOut,
+            D3D12_BARRIER_SYNC_VERTEX_SHADING,
+            D3D12_BARRIER_ACCESS_STREAM_OUTPUT,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::CopyDest,
+            D3D12_BARRIER_SYNC_COPY,
+            D3D12_BARRIER_ACCESS_COPY_DEST,
+            D3D12_BARRIER_LAYOUT_COPY_DEST },
+        { ResourceStates::CopySource,
+            D3D12_BARRIER_SYNC_COPY,
+            D3D12_BARRIER_ACCESS_COPY_SOURCE,
+            D3D12_BARRIER_LAYOUT_COPY_SOURCE },
+        { ResourceStates::ResolveDest,
+            D3D12_BARRIER_SYNC_RESOLVE,
+            D3D12_BARRIER_ACCESS_RESOLVE_DEST,
+            D3D12_BARRIER_LAYOUT_RESOLVE_DEST },
+        { ResourceStates::ResolveSource,
+            D3D12_BARRIER_SYNC_RESOLVE,
+            D3D12_BARRIER_ACCESS_RESOLVE_SOURCE,
+            D3D12_BARRIER_LAYOUT_RESOLVE_SOURCE },
+        { ResourceStates::Present,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_COMMON,
+            D3D12_BARRIER_LAYOUT_PRESENT },
+        { ResourceStates::AccelStructRead,
+            D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructWrite,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE | D3D12_BARRIER_SYNC_COPY_RAYTRACING_ACCELERATION_STRUCTURE |
+                D3D12_BARRIER_SYNC_EMIT_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructBuildInput,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructBuildBlas,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE | D3D12_BARRIER_SYNC_COPY_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ShadingRateSurface,
+            D3D12_BARRIER_SYNC_PIXEL_SHADING,
+            D3D12_BARRIER_ACCESS_SHADING_RATE_SOURCE,
+            D3D12_BARRIER_LAYOUT_SHADING_RATE_SOURCE },
+        { ResourceStates::OpacityMicromapWrite,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE | D3D12_BARRIER_SYNC_COPY_RAYTRACING_ACCELERATION_STRUCTURE |
+                D3D12_BARRIER_SYNC_EMIT_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::OpacityMicromapBuildInput,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ConvertCoopVecMatrixInput,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ConvertCoopVecMatrixOutput,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_UNORDERED_ACCESS,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+    };
+
+    static bool isReadOnlyLayout(D3D12_BARRIER_LAYOUT layout)
+    {
+        switch (layout)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case D3D12_BARRIER_LAYOUT_SHADER_RESOURCE:
+        case D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ:
+        case D3D12_BARRIER_LAYOUT_COPY_SOURCE:
+        case D3D12_BARRIER_LAYOUT_RESOLVE_SOURCE:
+        case D3D12_BARRIER_LAYOUT_SHADING_RATE_SOURCE:
+        case D3D12_BARRIER_LAYOUT_GENERIC_READ:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    BarrierStateMapping convertBarrierState(ResourceStates stateBits)
+    {
+        BarrierStateMapping result;
+
+        // Common is the state that resources are created in and decay to, it can be accessed by anything
+        if (stateBits == ResourceStates::Common)
+        {
+            result.sync = D3D12_BARRIER_SYNC_ALL;
+            result.access = D3D12_BARRIER_ACCESS_COMMON;
+            result.layout = D3D12_BARRIER_LAYOUT_COMMON;
+            return result;
+        }
+
+        D3D12_BARRIER_LAYOUT layout = D3D12_BARRIER_LAYOUT_UNDEFINED;
+        bool conflictingLayouts = false;
+        bool allLayoutsReadOnly = true;
+
+        for (const BarrierStateMappingInternal& mapping : g_BarrierStateMap)
+        {
+            if ((stateBits & mapping.nvrhiState) == 0)
+                continue;
+
+            result.sync |= mapping.sync;
+            result.access |= mapping.access;
+
+            if (mapping.layout != D3D12_BARRIER_LAYOUT_UNDEFINED)
+            {
+                allLayoutsReadOnly = allLayoutsReadOnly && isReadOnlyLayout(mapping.layout);
+
+                if (layout == D3D12_BARRIER_LAYOUT_UNDEFINED)
+                    layout = mapping.layout;
+                else if (layout != mapping.layout)
+                    conflictingLayouts = true;
+            }
+        }
+
+        // Combinations of read-only states share the generic read layout, anything else falls back to common
+        if (conflictingLayouts)
+            result.layout = allLayoutsReadOnly ? D3D12_BARRIER_LAYOUT_GENERIC_READ : D3D12_BARRIER_LAYOUT_COMMON;
+        else if (layout != D3D12_BARRIER_LAYOUT_UNDEFINED)
+            result.layout = layout;
+        else
+            result.layout = D3D12_BARRIER_LAYOUT_COMMON;
+
+        return result;
+    }
+
     D3D12_SHADING_RATE convertPixelShadingRate(VariableShadingRate shadingRate)
     {
         switch (shadingRate)
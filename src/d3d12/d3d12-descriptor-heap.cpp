@@ -22,12 +22,42 @@
 
 #include "d3d12-backend.h"
 
+#include <algorithm>
+#include <thread>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace nvrhi::d3d12
 {
-    
+    static uint32_t floorLog2(uint32_t v)
+    {
+        assert(v != 0);
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse(&index, v);
+        return uint32_t(index);
+#else
+        return 31 - uint32_t(__builtin_clz(v));
+#endif
+    }
+
+    static uint32_t lowestSetBit(uint32_t v)
+    {
+        assert(v != 0);
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, v);
+        return uint32_t(index);
+#else
+        return uint32_t(__builtin_ctz(v));
+#endif
+    }
+
     StaticDescriptorHeap::StaticDescriptorHeap(const Context& context)
         : m_Context(context)
     {
+        m_FreeListHeads.fill(c_InvalidDescriptorIndex);
     }
     
     HRESULT StaticDescriptorHeap::allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors, bool shaderVisible)
@@ -58,11 +88,25 @@ namespace nvrhi::d3d12
             m_StartGpuHandleShaderVisible = m_ShaderVisibleHeap->GetGPUDescriptorHandleForHeapStart();
         }
 
+        const uint32_t oldNumDescriptors = m_NumDescriptors;
+
         m_NumDescriptors = heapDesc.NumDescriptors;
         m_HeapType = heapDesc.Type;
         m_StartCpuHandle = m_Heap->GetCPUDescriptorHandleForHeapStart();
         m_Stride = m_Context.device->GetDescriptorHandleIncrementSize(heapDesc.Type);
+
+        m_FreeRangeSizes.resize(m_NumDescriptors, 0);
+        m_FreeRangeStarts.resize(m_NumDescriptors, 0);
+        m_FreeRangeNext.resize(m_NumDescriptors, c_InvalidDescriptorIndex);
+        m_FreeRangePrev.resize(m_NumDescriptors, c_InvalidDescriptorIndex);
+#ifdef _DEBUG
         m_AllocatedDescriptors.resize(m_NumDescriptors);
+        m_CachedDescriptors.resize(m_NumDescriptors);
+#endif
+
+        // Make the newly added part of the heap available, merging it with a free range at the old end
+        if (m_NumDescriptors > oldNumDescriptors)
+            addFreeRange(oldNumDescriptors, m_NumDescriptors - oldNumDescriptors);
 
         return S_OK;
     }
@@ -103,101 +147,329 @@ namespace nvrhi::d3d12
 
         RefCountPtr<ID3D12DescriptorHeap> oldHeap = m_Heap; 
 
+        // Only copy the descriptors up to the end of the last allocation, a free range at the end holds nothing
+        uint32_t numLiveDescriptors = oldSize;
+        if (oldSize > 0)
+        {
+            const DescriptorIndex lastFreeStart = m_FreeRangeStarts[oldSize - 1];
+            if (m_FreeRangeSizes[lastFreeStart] != 0 && lastFreeStart + m_FreeRangeSizes[lastFreeStart] == oldSize)
+                numLiveDescriptors = lastFreeStart;
+        }
+
         HRESULT hr = allocateResources(m_HeapType, newSize, isShaderVisible);
         
         if (FAILED(hr))
             return hr;
 
-        m_Context.device->CopyDescriptorsSimple(oldSize, m_StartCpuHandle, oldHeap->GetCPUDescriptorHandleForHeapStart(), m_HeapType);
+        if (numLiveDescriptors == 0)
+            return S_OK;
+
+        m_Context.device->CopyDescriptorsSimple(numLiveDescriptors, m_StartCpuHandle, oldHeap->GetCPUDescriptorHandleForHeapStart(), m_HeapType);
 
         if (m_ShaderVisibleHeap != nullptr)
         {
-            m_Context.device->CopyDescriptorsSimple(oldSize, m_StartCpuHandleShaderVisible, oldHeap->GetCPUDescriptorHandleForHeapStart(), m_HeapType);
+            m_Context.device->CopyDescriptorsSimple(numLiveDescriptors, m_StartCpuHandleShaderVisible, oldHeap->GetCPUDescriptorHandleForHeapStart(), m_HeapType);
         }
 
         return S_OK;
     }
 
-    DescriptorIndex StaticDescriptorHeap::allocateDescriptors(uint32_t count)
+    void StaticDescriptorHeap::insertFreeRange(DescriptorIndex start, uint32_t count)
     {
-        std::lock_guard lockGuard(m_Mutex);
+        const uint32_t sizeClass = floorLog2(count);
+
+        m_FreeRangeSizes[start] = count;
+        m_FreeRangeStarts[start + count - 1] = start;
+
+        m_FreeRangePrev[start] = c_InvalidDescriptorIndex;
+        m_FreeRangeNext[start] = m_FreeListHeads[sizeClass];
+        if (m_FreeListHeads[sizeClass] != c_InvalidDescriptorIndex)
+            m_FreeRangePrev[m_FreeListHeads[sizeClass]] = start;
 
-        DescriptorIndex foundIndex = 0;
-        uint32_t freeCount = 0;
-        bool found = false;
+        m_FreeListHeads[sizeClass] = start;
+        m_FreeListMask |= 1u << sizeClass;
+    }
+
+    void StaticDescriptorHeap::removeFreeRange(DescriptorIndex start)
+    {
+        const uint32_t sizeClass = floorLog2(m_FreeRangeSizes[start]);
+        const DescriptorIndex prev = m_FreeRangePrev[start];
+        const DescriptorIndex next = m_FreeRangeNext[start];
+
+        if (prev != c_InvalidDescriptorIndex)
+            m_FreeRangeNext[prev] = next;
+        else
+            m_FreeListHeads[sizeClass] = next;
+
+        if (next != c_InvalidDescriptorIndex)
+            m_FreeRangePrev[next] = prev;
+
+        if (m_FreeListHeads[sizeClass] == c_InvalidDescriptorIndex)
+            m_FreeListMask &= ~(1u << sizeClass);
 
-        // Find a contiguous range of 'count' indices for which m_AllocatedDescriptors[index] is false
+        m_FreeRangeSizes[start] = 0;
+    }
 
-        for (DescriptorIndex index = m_SearchStart; index < m_NumDescriptors; index++)
+    void StaticDescriptorHeap::addFreeRange(DescriptorIndex start, uint32_t count)
+    {
+        // Merge with the following free range
+        const DescriptorIndex end = start + count;
+        if (end < m_NumDescriptors && m_FreeRangeSizes[end] != 0)
         {
-            if (m_AllocatedDescriptors[index])
-                freeCount = 0;
-            else
-                freeCount += 1;
+            count += m_FreeRangeSizes[end];
+            removeFreeRange(end);
+        }
 
-            if (freeCount >= count)
+        // Merge with the preceding free range. The start index stored at start - 1 may be stale,
+        // so check that it really describes a free range that ends right before this one.
+        if (start > 0)
+        {
+            const DescriptorIndex prevStart = m_FreeRangeStarts[start - 1];
+            if (prevStart < start && m_FreeRangeSizes[prevStart] == start - prevStart)
             {
-                foundIndex = index - count + 1;
-                found = true;
-                break;
+                count += m_FreeRangeSizes[prevStart];
+                removeFreeRange(prevStart);
+                start = prevStart;
             }
         }
 
-        if (!found)
+        insertFreeRange(start, count);
+    }
+
+    DescriptorIndex StaticDescriptorHeap::findFreeRange(uint32_t count) const
+    {
+        // Every range in the size class of the next power of 2 or above fits, take the first one from the smallest class.
+        const uint32_t floorClass = floorLog2(count);
+        const uint32_t fitClass = (count & (count - 1)) ? floorClass + 1 : floorClass;
+
+        if (fitClass < c_NumFreeLists)
+        {
+            const uint32_t mask = m_FreeListMask & ~((1u << fitClass) - 1);
+            if (mask)
+                return m_FreeListHeads[lowestSetBit(mask)];
+        }
+
+        // Ranges in the class of 'count' itself may or may not fit, look there before giving up and growing the heap.
+        if (fitClass != floorClass)
         {
-            foundIndex = m_NumDescriptors;
+            for (DescriptorIndex start = m_FreeListHeads[floorClass]; start != c_InvalidDescriptorIndex; start = m_FreeRangeNext[start])
+            {
+                if (m_FreeRangeSizes[start] >= count)
+                    return start;
+            }
+        }
+
+        return c_InvalidDescriptorIndex;
+    }
+
+    DescriptorIndex StaticDescriptorHeap::allocateDescriptorsInternal(uint32_t count)
+    {
+        DescriptorIndex foundIndex = findFreeRange(count);
 
+        if (foundIndex == c_InvalidDescriptorIndex)
+        {
             if (FAILED(Grow(m_NumDescriptors + count)))
             {
                 m_Context.error("Failed to grow a descriptor heap!");
                 return c_InvalidDescriptorIndex;
             }
+
+            foundIndex = findFreeRange(count);
+            assert(foundIndex != c_InvalidDescriptorIndex);
         }
 
+        const uint32_t rangeSize = m_FreeRangeSizes[foundIndex];
+        removeFreeRange(foundIndex);
+
+        // Return the tail of the range to the free lists. It can't have a free neighbor after it
+        // because adjacent free ranges are always merged.
+        if (rangeSize > count)
+            insertFreeRange(foundIndex + count, rangeSize - count);
+
+#ifdef _DEBUG
         for (DescriptorIndex index = foundIndex; index < foundIndex + count; index++)
         {
             m_AllocatedDescriptors[index] = true;
         }
+#endif
 
         m_NumAllocatedDescriptors += count;
 
-        m_SearchStart = foundIndex + count;
         return foundIndex;
     }
 
+    void StaticDescriptorHeap::releaseDescriptorsInternal(DescriptorIndex baseIndex, uint32_t count)
+    {
+#ifdef _DEBUG
+        for (DescriptorIndex index = baseIndex; index < baseIndex + count; index++)
+        {
+            if (!m_AllocatedDescriptors[index])
+            {
+                m_Context.error("Attempted to release an un-allocated descriptor");
+            }
+            else if (m_CachedDescriptors[index])
+            {
+                m_Context.error("Attempted to release a descriptor that has already been released");
+            }
+
+            m_AllocatedDescriptors[index] = false;
+        }
+#endif
+
+        addFreeRange(baseIndex, count);
+
+        m_NumAllocatedDescriptors -= count;
+    }
+
+    StaticDescriptorHeap::ThreadCache& StaticDescriptorHeap::getThreadCache()
+    {
+        const size_t threadHash = std::hash<std::thread::id>()(std::this_thread::get_id());
+        return m_ThreadCaches[threadHash % c_NumThreadCaches];
+    }
+
+    DescriptorIndex StaticDescriptorHeap::allocateDescriptors(uint32_t count)
+    {
+        if (count == 0)
+            return 0;
+
+        if (count == 1)
+            return allocateDescriptor();
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        return allocateDescriptorsInternal(count);
+    }
+
     DescriptorIndex StaticDescriptorHeap::allocateDescriptor()
     {
-        return allocateDescriptors(1);
+        ThreadCache& cache = getThreadCache();
+        std::lock_guard cacheLockGuard(cache.mutex);
+
+        if (cache.indices.empty())
+        {
+            // Refill the cache with a few descriptors at once to amortize the cost of taking the heap lock
+            std::lock_guard lockGuard(m_Mutex);
+
+            for (uint32_t i = 0; i < c_ThreadCacheRefillCount; i++)
+            {
+                const DescriptorIndex index = allocateDescriptorsInternal(1);
+                if (index == c_InvalidDescriptorIndex)
+                    break;
+
+                cache.indices.push_back(index);
+            }
+
+            if (cache.indices.empty())
+                return c_InvalidDescriptorIndex;
+
+            // Hand out the lowest index first to keep the heap compact
+            std::reverse(cache.indices.begin(), cache.indices.end());
+        }
+
+        const DescriptorIndex index = cache.indices.back();
+        cache.indices.pop_back();
+
+#ifdef _DEBUG
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_CachedDescriptors[index] = false;
+        }
+#endif
+
+        return index;
     }
 
-    void StaticDescriptorHeap::releaseDescriptors(DescriptorIndex baseIndex, uint32_t count)
+    bool StaticDescriptorHeap::tryExtendDescriptors(DescriptorIndex baseIndex, uint32_t count, uint32_t newCount)
     {
+        assert(newCount > count);
+        const uint32_t extraCount = newCount - count;
+        const DescriptorIndex end = baseIndex + count;
+
         std::lock_guard lockGuard(m_Mutex);
 
+        // A free range that starts right after the allocation has its size stored at its first index
+        if (end >= m_NumDescriptors || m_FreeRangeSizes[end] < extraCount)
+            return false;
+
+        const uint32_t rangeSize = m_FreeRangeSizes[end];
+        removeFreeRange(end);
+
+        if (rangeSize > extraCount)
+            insertFreeRange(end + extraCount, rangeSize - extraCount);
+
+#ifdef _DEBUG
+        for (DescriptorIndex index = end; index < end + extraCount; index++)
+        {
+            m_AllocatedDescriptors[index] = true;
+        }
+#endif
+
+        m_NumAllocatedDescriptors += extraCount;
+
+        return true;
+    }
+
+    void StaticDescriptorHeap::releaseDescriptors(DescriptorIndex baseIndex, uint32_t count)
+    {
         if (count == 0)
             return;
 
-        for (DescriptorIndex index = baseIndex; index < baseIndex + count; index++)
+        if (count == 1)
         {
+            releaseDescriptor(baseIndex);
+            return;
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        releaseDescriptorsInternal(baseIndex, count);
+    }
+
+    void StaticDescriptorHeap::releaseDescriptor(DescriptorIndex index)
+    {
+        ThreadCache& cache = getThreadCache();
+        std::lock_guard cacheLockGuard(cache.mutex);
+
 #ifdef _DEBUG
-            if (!m_AllocatedDescriptors[index])
+        {
+            // Cached descriptors still look allocated to the heap, so track them separately to catch double releases
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (index >= m_NumDescriptors || !m_AllocatedDescriptors[index])
             {
                 m_Context.error("Attempted to release an un-allocated descriptor");
+                return;
             }
-#endif
 
-            m_AllocatedDescriptors[index] = false;
+            if (m_CachedDescriptors[index])
+            {
+                m_Context.error("Attempted to release a descriptor that has already been released");
+                return;
+            }
+
+            m_CachedDescriptors[index] = true;
         }
+#endif
 
-        m_NumAllocatedDescriptors -= count;
+        cache.indices.push_back(index);
 
-        if (m_SearchStart > baseIndex)
-            m_SearchStart = baseIndex;
-    }
+        if (cache.indices.size() <= c_ThreadCacheCapacity)
+            return;
 
-    void StaticDescriptorHeap::releaseDescriptor(DescriptorIndex index)
-    {
-        releaseDescriptors(index, 1);
+        // The cache is full, return the older half of it to the heap so that those descriptors can be merged
+        // into larger ranges again
+        std::lock_guard lockGuard(m_Mutex);
+
+        const size_t numToRelease = cache.indices.size() / 2;
+        for (size_t i = 0; i < numToRelease; i++)
+        {
+#ifdef _DEBUG
+            m_CachedDescriptors[cache.indices[i]] = false;
+#endif
+            releaseDescriptorsInternal(cache.indices[i], 1);
+        }
+
+        cache.indices.erase(cache.indices.begin(), cache.indices.begin() + ptrdiff_t(numToRelease));
     }
 
     D3D12_CPU_DESCRIPTOR_HANDLE StaticDescriptorHeap::getCpuHandle(DescriptorIndex index)
@@ -231,9 +503,89 @@ namespace nvrhi::d3d12
         return m_ShaderVisibleHeap;
     }
 
+    DescriptorHeapStats StaticDescriptorHeap::getStats()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        DescriptorHeapStats stats;
+        stats.allocated = m_NumAllocatedDescriptors;
+        stats.capacity = m_NumDescriptors;
+        return stats;
+    }
+
     void StaticDescriptorHeap::copyToShaderVisibleHeap(DescriptorIndex index, uint32_t count)
     {
         m_Context.device->CopyDescriptorsSimple(count, getCpuHandleShaderVisible(index), getCpuHandle(index), m_HeapType);
     }
 
+    TransientDescriptorChunkPool::~TransientDescriptorChunkPool()
+    {
+        // The chunks in use belong to command list instances, which are destroyed before the pool
+        for (DescriptorIndex chunk : m_FreeChunks)
+            m_Heap.releaseDescriptors(chunk, m_ChunkSize);
+    }
+
+    DescriptorIndex TransientDescriptorChunkPool::acquireChunk()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!m_FreeChunks.empty())
+        {
+            DescriptorIndex chunk = m_FreeChunks.back();
+            m_FreeChunks.pop_back();
+            return chunk;
+        }
+
+        if (m_NumAllocatedChunks >= m_MaxChunks)
+            return c_InvalidDescriptorIndex;
+
+        DescriptorIndex chunk = m_Heap.allocateDescriptors(m_ChunkSize);
+        if (chunk != c_InvalidDescriptorIndex)
+            ++m_NumAllocatedChunks;
+
+        return chunk;
+    }
+
+    void TransientDescriptorChunkPool::releaseChunks(const std::vector<DescriptorIndex>& chunks)
+    {
+        if (chunks.empty())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (DescriptorIndex chunk : chunks)
+        {
+            if (m_FreeChunks.size() < m_MaxIdleChunks)
+            {
+                m_FreeChunks.push_back(chunk);
+            }
+            else
+            {
+                m_Heap.releaseDescriptors(chunk, m_ChunkSize);
+                --m_NumAllocatedChunks;
+            }
+        }
+    }
+
+    DescriptorIndex TransientDescriptorAllocator::allocate(uint32_t count)
+    {
+        const uint32_t chunkSize = m_Pool.getChunkSize();
+        if (count > chunkSize)
+            return c_InvalidDescriptorIndex;
+
+        if (m_Chunks.empty() || m_OffsetInChunk + count > chunkSize)
+        {
+            DescriptorIndex chunk = m_Pool.acquireChunk();
+            if (chunk == c_InvalidDescriptorIndex)
+                return c_InvalidDescriptorIndex;
+
+            m_Chunks.push_back(chunk);
+            m_OffsetInChunk = 0;
+        }
+
+        DescriptorIndex index = m_Chunks.back() + m_OffsetInChunk;
+        m_OffsetInChunk += count;
+        return index;
+    }
+
 } // namespace nvrhi::d3d12
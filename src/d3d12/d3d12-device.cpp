@@ -38,6 +38,11 @@ namespace nvrhi::d3d12
         messageCallback->message(MessageSeverity::Error, message.c_str());
     }
 
+    void Context::warning(const std::string& message) const
+    {
+        messageCallback->message(MessageSeverity::Warning, message.c_str());
+    }
+
     void Context::info(const std::string& message) const
     {
         messageCallback->message(MessageSeverity::Info, message.c_str());
@@ -67,11 +72,82 @@ namespace nvrhi::d3d12
         , depthStencilViewHeap(context)
         , shaderResourceViewHeap(context)
         , samplerHeap(context)
+        // Transient sets may use up to a quarter of each heap. Sampler tables are small and the heap is too,
+        // so the sampler chunks are much smaller than the SRV ones.
+        , transientShaderResourceViewChunks(shaderResourceViewHeap, 256, std::max(desc.shaderResourceViewHeapSize / 4 / 256, 1u), 16)
+        , transientSamplerChunks(samplerHeap, 16, std::max(desc.samplerHeapSize / 4 / 16, 1u), 4)
         , timerQueries(desc.maxTimerQueries, true)
+        , placedResourceAllocator(context, desc.placedResourceHeapSize)
+        , placedResourceAllocatorEnabled(desc.enablePlacedResourceAllocator)
+        , residencyManager(context, desc.enableResidencyManager)
+        , accelStructStats(desc.enableAccelStructBuildTiming, desc.maxAccelStructBuildTimerQueries)
+        , profiler(desc.enableMarkerProfiling, desc.maxProfilerTimerQueries)
+#ifndef NVRHI_WITH_RTXMU
+        , blasCompaction(context, desc.blasCompactionBudget)
+#endif
+        , readbackPool(context, desc.readbackBufferSize)
         , m_Context(context)
     {
     }
 
+    DescriptorIndex DeviceResources::acquireSharedSamplerTable(const std::vector<DescriptorIndex>& samplerDescriptors)
+    {
+        std::lock_guard lockGuard(m_SharedSamplerTableMutex);
+
+        auto found = m_SharedSamplerTableIndices.find(samplerDescriptors);
+        if (found != m_SharedSamplerTableIndices.end())
+        {
+            m_SharedSamplerTables[found->second].refCount++;
+            return found->second;
+        }
+
+        const uint32_t numDescriptors = uint32_t(samplerDescriptors.size());
+        const DescriptorIndex baseIndex = samplerHeap.allocateDescriptors(numDescriptors);
+
+        for (uint32_t i = 0; i < numDescriptors; i++)
+        {
+            D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandle = samplerHeap.getCpuHandle(baseIndex + i);
+
+            if (samplerDescriptors[i] != c_InvalidDescriptorIndex)
+            {
+                m_Context.device->CopyDescriptorsSimple(1, descriptorHandle, samplerHeap.getCpuHandle(samplerDescriptors[i]),
+                    D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+            }
+            else
+            {
+                // Create a default sampler
+                D3D12_SAMPLER_DESC samplerDesc = {};
+                m_Context.device->CreateSampler(&samplerDesc, descriptorHandle);
+            }
+        }
+
+        samplerHeap.copyToShaderVisibleHeap(baseIndex, numDescriptors);
+
+        SharedSamplerTable& table = m_SharedSamplerTables[baseIndex];
+        table.samplerDescriptors = samplerDescriptors;
+        table.refCount = 1;
+        m_SharedSamplerTableIndices[samplerDescriptors] = baseIndex;
+
+        return baseIndex;
+    }
+
+    void DeviceResources::releaseSharedSamplerTable(DescriptorIndex baseIndex)
+    {
+        std::lock_guard lockGuard(m_SharedSamplerTableMutex);
+
+        auto found = m_SharedSamplerTables.find(baseIndex);
+        if (found == m_SharedSamplerTables.end())
+            return;
+
+        SharedSamplerTable& table = found->second;
+        if (--table.refCount > 0)
+            return;
+
+        samplerHeap.releaseDescriptors(baseIndex, uint32_t(table.samplerDescriptors.size()));
+        m_SharedSamplerTableIndices.erase(table.samplerDescriptors);
+        m_SharedSamplerTables.erase(found);
+    }
+
     Queue::Queue(const Context& context, ID3D12CommandQueue* queue)
         : queue(queue)
         , m_Context(context)
@@ -89,12 +165,56 @@ namespace nvrhi::d3d12
         return lastCompletedInstance;
     }
 
+    uint64_t Queue::submit(ID3D12CommandList* const* commandLists, size_t numCommandLists)
+    {
+        std::lock_guard lockGuard(m_SubmitMutex);
+
+        lastSubmittedInstance++;
+
+        if (m_Context.deferredSubmission)
+        {
+            m_PendingCommandLists.insert(m_PendingCommandLists.end(), commandLists, commandLists + numCommandLists);
+            return lastSubmittedInstance;
+        }
+
+        queue->ExecuteCommandLists(uint32_t(numCommandLists), commandLists);
+        queue->Signal(fence, lastSubmittedInstance);
+        m_LastFlushedInstance = lastSubmittedInstance;
+
+        return lastSubmittedInstance;
+    }
+
+    void Queue::flush()
+    {
+        std::lock_guard lockGuard(m_SubmitMutex);
+
+        if (m_LastFlushedInstance == lastSubmittedInstance)
+            return;
+
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::Queue::flush");
+
+        // One signal of the last instance completes all the deferred instances, as the fence values are ordered
+        if (!m_PendingCommandLists.empty())
+            queue->ExecuteCommandLists(uint32_t(m_PendingCommandLists.size()), m_PendingCommandLists.data());
+        queue->Signal(fence, lastSubmittedInstance);
+
+        m_PendingCommandLists.clear();
+        m_LastFlushedInstance = lastSubmittedInstance;
+    }
+
     Device::Device(const DeviceDesc& desc)
         : m_Resources(m_Context, desc)
     {
         m_Context.device = desc.pDevice;
         m_Context.logBufferLifetime = desc.logBufferLifetime;
+        m_Context.automaticQueueSync = desc.enableAutomaticQueueSync;
+        m_Context.logAutomaticQueueSync = desc.logAutomaticQueueSync;
+        m_Context.deferredSubmission = desc.enableDeferredSubmission;
+        m_Context.uploadRingBufferSize = desc.uploadRingBufferSize;
         m_Context.messageCallback = desc.errorCB;
+        m_Context.parallelTaskRunner = desc.parallelTaskRunner;
+        m_DescriptorTableGrowthFactor = std::max(desc.descriptorTableGrowthFactor, 1.f);
+        m_ReserveDescriptorTableCapacity = desc.reserveDescriptorTableCapacity;
 
         if (desc.pGraphicsCommandQueue)
             m_Queues[int(CommandQueue::Graphics)] = std::make_unique<Queue>(m_Context, desc.pGraphicsCommandQueue);
@@ -108,6 +228,15 @@ namespace nvrhi::d3d12
         m_Resources.shaderResourceViewHeap.allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, desc.shaderResourceViewHeapSize, true);
         m_Resources.samplerHeap.allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, desc.samplerHeapSize, true);
 
+        m_Context.device->QueryInterface(&m_Context.device1);
+
+        // The DXGI adapter is only needed for the memory budget queries
+        RefCountPtr<IDXGIFactory4> dxgiFactory;
+        if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&dxgiFactory))))
+        {
+            dxgiFactory->EnumAdapterByLuid(m_Context.device->GetAdapterLuid(), IID_PPV_ARGS(&m_Context.adapter3));
+        }
+
         m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &m_Options, sizeof(m_Options));
         m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS1, &m_Options1, sizeof(m_Options1));
         bool hasOptions5 = SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS5, &m_Options5, sizeof(m_Options5)));
@@ -133,6 +262,8 @@ namespace nvrhi::d3d12
 #endif
         }
 
+        m_Context.device->QueryInterface(&m_Context.device7);
+
         if (SUCCEEDED(m_Context.device->QueryInterface(&m_Context.device2)) && hasOptions7)
         {
             m_MeshletsSupported = m_Options7.MeshShaderTier >= D3D12_MESH_SHADER_TIER_1;
@@ -143,6 +274,15 @@ namespace nvrhi::d3d12
             m_SamplerFeedbackSupported = m_Options7.SamplerFeedbackTier >= D3D12_SAMPLER_FEEDBACK_TIER_0_9;
         }
 
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        if (m_Context.device5)
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS21 options21 = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS21, &options21, sizeof(options21))))
+                m_WorkGraphsSupported = options21.WorkGraphsTier != D3D12_WORK_GRAPHS_TIER_NOT_SUPPORTED;
+        }
+#endif
+
 #if NVRHI_D3D12_WITH_COOPVEC
         if (SUCCEEDED(m_Context.device->QueryInterface(&m_Context.devicePreview)))
         {
@@ -156,6 +296,20 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        if (desc.enableEnhancedBarriers)
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS12 options12 = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS12, &options12, sizeof(options12))))
+                m_Context.enhancedBarriersSupported = options12.EnhancedBarriersSupported != FALSE;
+        }
+
+        {
+            // GPU upload heaps require resizable BAR and a recent driver, OPTIONS16 doesn't exist on older runtimes
+            D3D12_FEATURE_DATA_D3D12_OPTIONS16 options16 = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS16, &options16, sizeof(options16))))
+                m_Context.gpuUploadHeapSupported = options16.GPUUploadHeapSupported != FALSE;
+        }
+
         if (hasOptions6)
         {
             m_VariableRateShadingSupported = m_Options6.VariableShadingRateTier >= D3D12_VARIABLE_SHADING_RATE_TIER_2;
@@ -178,9 +332,17 @@ namespace nvrhi::d3d12
             csDesc.ByteStride = 12;
             argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
             m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchIndirectSignature));
+
+            if (m_MeshletsSupported)
+            {
+                csDesc.ByteStride = 12;
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH;
+                m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchMeshIndirectSignature));
+            }
         }
         
         m_FenceEvent = CreateEvent(nullptr, false, false, nullptr);
+        m_MultipleFenceEvent = CreateEvent(nullptr, false, false, nullptr);
 
         m_CommandListsToExecute.reserve(64);
 
@@ -308,21 +470,68 @@ namespace nvrhi::d3d12
             m_HeapDirectlyIndexedEnabled = m_Options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_3 && 
                 hasShaderModel && shaderModel.HighestShaderModel >= D3D_SHADER_MODEL_6_6;
         }
+
+        if (desc.enablePipelineLibrary)
+        {
+            createPipelineLibrary(desc);
+        }
+
+        if (desc.enableBindingSetCache)
+        {
+            m_BindingSetCache = std::make_unique<BindingSetCache>();
+        }
+
+        if (desc.enableFramebufferCache)
+        {
+            m_FramebufferCache = std::make_unique<FramebufferCache>();
+        }
     }
 
     Device::~Device()
     {
         waitForIdle();
 
+        m_ReleaseQueue.releaseAll();
+        m_BindingSetCache.reset();
+        m_FramebufferCache.reset();
+
         if (m_FenceEvent)
         {
             CloseHandle(m_FenceEvent);
             m_FenceEvent = nullptr;
         }
+
+        if (m_MultipleFenceEvent)
+        {
+            CloseHandle(m_MultipleFenceEvent);
+            m_MultipleFenceEvent = nullptr;
+        }
+    }
+
+    void Device::flushSubmissions()
+    {
+        if (!m_Context.deferredSubmission)
+            return;
+
+        for (const auto& pQueue : m_Queues)
+        {
+            if (pQueue)
+                pQueue->flush();
+        }
+    }
+
+    void Device::waitForQueueFence(ID3D12Fence* fence, uint64_t value)
+    {
+        if (m_Context.deferredSubmission && fence->GetCompletedValue() < value)
+            flushSubmissions();
+
+        WaitForFence(fence, value, m_FenceEvent);
     }
 
     bool Device::waitForIdle()
     {
+        flushSubmissions();
+
         // Wait for every queue to reach its last submitted instance
         for (const auto& pQueue : m_Queues)
         {
@@ -348,8 +557,9 @@ namespace nvrhi::d3d12
         }
     }
     
-    Sampler::Sampler(const Context& context, const SamplerDesc& desc)
+    Sampler::Sampler(const Context& context, DeviceResources& resources, const SamplerDesc& desc)
         : m_Context(context)
+        , m_Resources(resources)
         , m_Desc(desc)
         , m_d3d12desc{}
     {
@@ -383,6 +593,23 @@ namespace nvrhi::d3d12
         m_d3d12desc.BorderColor[3] = m_Desc.borderColor.a;
         m_d3d12desc.MinLOD = 0;
         m_d3d12desc.MaxLOD = D3D12_FLOAT32_MAX;
+
+        descriptor = m_Resources.samplerHeap.allocateDescriptor();
+        createDescriptor(m_Resources.samplerHeap.getCpuHandle(descriptor).ptr);
+    }
+
+    Sampler::~Sampler()
+    {
+        {
+            // Remove the sampler from the cache, unless it has been replaced already
+            std::lock_guard lockGuard(m_Resources.samplerCacheMutex);
+            const auto it = m_Resources.samplerCache.find(m_Desc);
+            if (it != m_Resources.samplerCache.end() && it->second == this)
+                m_Resources.samplerCache.erase(it);
+        }
+
+        if (descriptor != c_InvalidDescriptorIndex)
+            m_Resources.samplerHeap.releaseDescriptor(descriptor);
     }
     
     void Sampler::createDescriptor(size_t descriptor) const
@@ -392,7 +619,18 @@ namespace nvrhi::d3d12
     
     SamplerHandle Device::createSampler(const SamplerDesc& d)
     {
-        Sampler* sampler = new Sampler(m_Context, d);
+        std::lock_guard lockGuard(m_Resources.samplerCacheMutex);
+
+        // Get a cached sampler and AddRef it (if it exists), unless it's already being destroyed
+        // and its destructor is waiting for the mutex to remove it from the cache
+        const auto it = m_Resources.samplerCache.find(d);
+        if (it != m_Resources.samplerCache.end() && it->second->TryAddRef())
+            return SamplerHandle::Create(it->second);
+
+        Sampler* sampler = new Sampler(m_Context, m_Resources, d);
+        sampler->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::Sampler);
+        // This replaces a dying sampler, whose destructor then leaves the entry alone
+        m_Resources.samplerCache[d] = sampler;
         return SamplerHandle::Create(sampler);
     }
     
@@ -427,6 +665,8 @@ namespace nvrhi::d3d12
     
     uint64_t Device::executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::executeCommandLists");
+
         m_CommandListsToExecute.resize(numCommandLists);
         for (size_t i = 0; i < numCommandLists; i++)
         {
@@ -435,16 +675,81 @@ namespace nvrhi::d3d12
 
         Queue* pQueue = getQueue(executionQueue);
 
-        pQueue->queue->ExecuteCommandLists(uint32_t(m_CommandListsToExecute.size()), m_CommandListsToExecute.data());
-        pQueue->lastSubmittedInstance++;
-        pQueue->queue->Signal(pQueue->fence, pQueue->lastSubmittedInstance);
+        // The queue access history of the resources is updated at the end of the submission
+        std::unique_lock<std::mutex> queueSyncLock;
+        if (m_Context.automaticQueueSync)
+        {
+            queueSyncLock = std::unique_lock(m_QueueSyncMutex);
+
+            m_QueueDependencies.clear();
+            for (size_t i = 0; i < numCommandLists; i++)
+            {
+                checked_cast<CommandList*>(pCommandLists[i])->getStateTracker().collectQueueDependencies(executionQueue, m_QueueDependencies);
+            }
+
+            for (size_t waitQueue = 0; waitQueue < size_t(CommandQueue::Count); waitQueue++)
+            {
+                uint64_t& instance = m_QueueDependencies.waitInstances[waitQueue];
+                if (instance == 0)
+                    continue;
+
+                Queue* pWaitQueue = getQueue(CommandQueue(waitQueue));
+                if (!pWaitQueue || pWaitQueue->updateLastCompletedInstance() >= instance)
+                {
+                    instance = 0;
+                    continue;
+                }
+
+                // The wait is inserted into the queue directly, so it must come after the pending command lists,
+                // and the signal it waits for must not be pending
+                if (m_Context.deferredSubmission)
+                {
+                    pWaitQueue->flush();
+                    pQueue->flush();
+                }
+
+                pQueue->queue->Wait(pWaitQueue->fence, instance);
+            }
+
+            if (m_Context.logAutomaticQueueSync)
+                reportQueueDependencies(m_QueueDependencies, executionQueue, m_Context.messageCallback);
+        }
+
+        if (m_Resources.residencyManager.isEnabled())
+        {
+            // Evicted resources must be resident again before the GPU can access them
+            for (size_t i = 0; i < numCommandLists; i++)
+            {
+                m_Resources.residencyManager.prepareSubmission(checked_cast<CommandList*>(pCommandLists[i])->getInstance(),
+                    executionQueue, pQueue->lastSubmittedInstance + 1);
+            }
+        }
+
+        pQueue->submit(m_CommandListsToExecute.data(), m_CommandListsToExecute.size());
+
+        if (m_Context.automaticQueueSync)
+        {
+            for (size_t i = 0; i < numCommandLists; i++)
+            {
+                checked_cast<CommandList*>(pCommandLists[i])->getStateTracker().recordQueueAccesses(executionQueue, pQueue->lastSubmittedInstance);
+            }
+
+            queueSyncLock.unlock();
+        }
 
         for (size_t i = 0; i < numCommandLists; i++)
         {
-            auto instance = checked_cast<CommandList*>(pCommandLists[i])->executed(pQueue);
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            auto instance = commandList->executed(pQueue);
+            m_Resources.deviceStats.commandListSubmitted(commandList->getStats(), instance->referencedResources.size());
             pQueue->commandListsInFlight.push_front(instance);
         }
 
+        if (m_Resources.residencyManager.isEnabled())
+        {
+            m_Resources.residencyManager.trimToBudget(m_Queues);
+        }
+
         HRESULT hr = m_Context.device->GetDeviceRemovedReason();
         if (FAILED(hr))
         {
@@ -460,6 +765,12 @@ namespace nvrhi::d3d12
         Queue* pExecutionQueue = getQueue(executionQueue);
         assert(instanceID <= pExecutionQueue->lastSubmittedInstance);
 
+        if (m_Context.deferredSubmission)
+        {
+            pExecutionQueue->flush();
+            pWaitQueue->flush();
+        }
+
         pWaitQueue->queue->Wait(pExecutionQueue->fence, instanceID);
     }
 
@@ -502,6 +813,10 @@ namespace nvrhi::d3d12
         Queue* queue = getQueue(executionQueue);
         Texture* texture = checked_cast<Texture*>(_texture);
 
+        // The mapping updates are ordered with the command lists on the queue
+        if (m_Context.deferredSubmission)
+            queue->flush();
+
         D3D12_TILE_SHAPE tileShape;
         D3D12_SUBRESOURCE_TILING subresourceTiling;
         m_Context.device->GetResourceTiling(texture->resource, nullptr, nullptr, &tileShape, nullptr, 0, &subresourceTiling);
@@ -559,6 +874,24 @@ namespace nvrhi::d3d12
 
     void Device::runGarbageCollection()
     {
+        collectGarbage(true, 0);
+    }
+
+    void Device::runGarbageCollection(uint32_t maxReleaseMicroseconds)
+    {
+        collectGarbage(false, maxReleaseMicroseconds);
+    }
+
+    void Device::evictCachedFramebuffers(ITexture* texture)
+    {
+        if (m_FramebufferCache)
+            m_FramebufferCache->evict(texture);
+    }
+
+    void Device::collectGarbage(bool releaseAll, uint32_t maxReleaseMicroseconds)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::runGarbageCollection");
+
         for (const auto& pQueue : m_Queues)
         {
             if (!pQueue)
@@ -589,7 +922,28 @@ namespace nvrhi::d3d12
                         m_Context.rtxMemUtil->GarbageCollection(instance->rtxmuCompactionIds);
                         instance->rtxmuCompactionIds.clear();
                     }
+#else
+                    if (!instance->pendingCompactedSizes.empty())
+                    {
+                        m_Resources.blasCompaction.buildsCompleted(instance->pendingCompactedSizes);
+                    }
 #endif
+                    if (!instance->accelStructTimerQueries.empty())
+                    {
+                        m_Resources.accelStructStats.buildsExecuted(instance->accelStructTimerQueries);
+                    }
+                    if (!instance->profilerScopes.empty())
+                    {
+                        m_Resources.profiler.scopesExecuted(instance->profilerScopes);
+                    }
+                    m_Resources.deviceStats.commandListRetired(instance->referencedResources.size());
+                    if (!releaseAll)
+                    {
+                        // The other references are internal objects that are cheap to release
+                        m_ReleaseQueue.add(instance->referencedResources);
+                        for (const auto& secondary : instance->secondaryInstances)
+                            m_ReleaseQueue.add(secondary->referencedResources);
+                    }
                     pQueue->commandListsInFlight.pop_back();
                 }
                 else
@@ -598,6 +952,22 @@ namespace nvrhi::d3d12
                 }
             }
         }
+
+        if (releaseAll)
+            m_ReleaseQueue.releaseAll();
+        else
+            m_ReleaseQueue.release(maxReleaseMicroseconds);
+
+        m_Resources.readbackPool.runCallbacks();
+
+        m_Resources.accelStructStats.endFrame(this);
+        m_Resources.profiler.endFrame(this, m_ProfilerTimestamps);
+
+        if (m_BindingSetCache)
+            m_BindingSetCache->releaseUnused();
+
+        if (m_FramebufferCache)
+            m_FramebufferCache->releaseUnused();
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -606,6 +976,18 @@ namespace nvrhi::d3d12
         {
         case Feature::DeferredCommandLists:
             return true;
+        case Feature::SecondaryCommandLists:
+            return true;
+        case Feature::ReusableCommandLists:
+            return true;
+        case Feature::DeviceGeneratedCommands:
+            return true;
+        case Feature::PushDescriptors:
+            return true;
+        case Feature::AsyncReadback:
+            return true;
+        case Feature::DeviceLocalUploadMemory:
+            return m_Context.gpuUploadHeapSupported;
         case Feature::SinglePassStereo:
             return m_SinglePassStereoSupported;
         case Feature::RayTracingAccelStruct:
@@ -628,6 +1010,10 @@ namespace nvrhi::d3d12
             return m_LinearSweptSpheresSupported;
         case Feature::Meshlets:
             return m_MeshletsSupported;
+        case Feature::MeshletIndirect:
+            return m_Context.dispatchMeshIndirectSignature != nullptr;
+        case Feature::WorkGraphs:
+            return m_WorkGraphsSupported;
         case Feature::VariableRateShading:
             if (pInfo)
             {
@@ -728,6 +1114,60 @@ namespace nvrhi::d3d12
         return result;
     }
 
+    MemoryAllocatorStats Device::getMemoryAllocatorStats()
+    {
+        return m_Resources.placedResourceAllocator.getStats();
+    }
+
+    MemoryBudget Device::getMemoryBudget()
+    {
+        MemoryBudget result;
+
+        if (!m_Context.adapter3)
+            return result;
+
+        const DXGI_MEMORY_SEGMENT_GROUP segmentGroups[] = { DXGI_MEMORY_SEGMENT_GROUP_LOCAL, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL };
+        for (DXGI_MEMORY_SEGMENT_GROUP segmentGroup : segmentGroups)
+        {
+            DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+            if (FAILED(m_Context.adapter3->QueryVideoMemoryInfo(0, segmentGroup, &memoryInfo)))
+                continue;
+
+            MemoryHeapBudget heap;
+            heap.budget = memoryInfo.Budget;
+            heap.usage = memoryInfo.CurrentUsage;
+            heap.isDeviceLocal = segmentGroup == DXGI_MEMORY_SEGMENT_GROUP_LOCAL;
+            result.heaps.push_back(heap);
+        }
+
+        return result;
+    }
+
+    AccelStructStats Device::getAccelStructStats()
+    {
+        AccelStructStats stats = m_Resources.accelStructStats.getStats();
+#ifndef NVRHI_WITH_RTXMU
+        stats.pendingCompactionCount = m_Resources.blasCompaction.getNumPendingCompactions();
+#endif
+        return stats;
+    }
+
+    DeviceStats Device::getDeviceStats()
+    {
+        DeviceStats stats = m_Resources.deviceStats.getStats();
+        stats.shaderResourceDescriptors = m_Resources.shaderResourceViewHeap.getStats();
+        stats.samplerDescriptors = m_Resources.samplerHeap.getStats();
+        stats.renderTargetDescriptors = m_Resources.renderTargetViewHeap.getStats();
+        stats.depthStencilDescriptors = m_Resources.depthStencilViewHeap.getStats();
+        stats.queuedResourceReleases = m_ReleaseQueue.size();
+        return stats;
+    }
+
+    bool Device::getProfilerFrameResults(ProfilerFrameResults& outResults)
+    {
+        return m_Resources.profiler.getFrameResults(outResults);
+    }
+
     coopvec::DeviceFeatures Device::queryCoopVecFeatures()
     {
         coopvec::DeviceFeatures result;
@@ -903,6 +1343,7 @@ namespace nvrhi::d3d12
         Heap* heap = new Heap();
         heap->heap = d3dHeap;
         heap->desc = d;
+        heap->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::Heap, d.capacity);
         return HeapHandle::Create(heap);
     }
 
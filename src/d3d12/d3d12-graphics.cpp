@@ -23,6 +23,7 @@
 #include "d3d12-backend.h"
 
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 
 namespace nvrhi::d3d12
@@ -41,6 +42,17 @@ namespace nvrhi::d3d12
         }
     }
 
+    Object CommandSignature::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_CommandSignature:
+            return Object(signature.Get());
+        default:
+            return nullptr;
+        }
+    }
+
     RefCountPtr<ID3D12PipelineState> Device::createPipelineState(const GraphicsPipelineDesc & state, RootSignature* pRS, const FramebufferInfo& fbinfo) const
     {
         if (state.renderState.singlePassStereo.enabled && !m_SinglePassStereoSupported)
@@ -169,7 +181,7 @@ namespace nvrhi::d3d12
         }
 #endif
 
-        const HRESULT hr = m_Context.device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+        const HRESULT hr = createGraphicsPipelineStateCached(desc, pRS, pipelineState);
 
         if (FAILED(hr))
         {
@@ -182,6 +194,8 @@ namespace nvrhi::d3d12
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::createGraphicsPipeline");
+
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, desc.inputLayout != nullptr);
 
         RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS, fbinfo);
@@ -197,6 +211,80 @@ namespace nvrhi::d3d12
         return createGraphicsPipeline(desc, fb->getFramebufferInfo());
     }
 
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* _pipeline)
+    {
+        GraphicsPipeline* pipeline = checked_cast<GraphicsPipeline*>(_pipeline);
+        if (!pipeline)
+            return nullptr;
+
+        static_vector<D3D12_INDIRECT_ARGUMENT_DESC, c_MaxIndirectArguments> argDescs;
+        bool changesRootArguments = false;
+
+        for (const IndirectArgumentDesc& arg : desc.arguments)
+        {
+            D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
+
+            switch (arg.type)
+            {
+            case IndirectArgumentType::Draw:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+                break;
+            case IndirectArgumentType::DrawIndexed:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+                break;
+            case IndirectArgumentType::VertexBuffer:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+                argDesc.VertexBuffer.Slot = arg.slot;
+                break;
+            case IndirectArgumentType::IndexBuffer:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+                break;
+            case IndirectArgumentType::PushConstants:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+                argDesc.Constant.RootParameterIndex = pipeline->rootSignature->rootParameterPushConstants;
+                argDesc.Constant.DestOffsetIn32BitValues = arg.pushConstantOffset / 4;
+                argDesc.Constant.Num32BitValuesToSet = arg.pushConstantByteSize / 4;
+                changesRootArguments = true;
+                break;
+            default:
+                utils::InvalidEnum();
+                return nullptr;
+            }
+
+            argDescs.push_back(argDesc);
+        }
+
+        D3D12_COMMAND_SIGNATURE_DESC csDesc = {};
+        csDesc.ByteStride = desc.getCommandByteStride();
+        csDesc.NumArgumentDescs = UINT(argDescs.size());
+        csDesc.pArgumentDescs = argDescs.data();
+
+        // The root signature must be provided if and only if the signature changes root arguments
+        ID3D12RootSignature* rootSignature = changesRootArguments ? pipeline->rootSignature->handle.Get() : nullptr;
+
+        RefCountPtr<ID3D12CommandSignature> d3dSignature;
+        const HRESULT hr = m_Context.device->CreateCommandSignature(&csDesc, rootSignature, IID_PPV_ARGS(&d3dSignature));
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "Failed to create command signature " << utils::DebugNameToString(desc.debugName) << ", error code = 0x" << std::hex << hr;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        if (!desc.debugName.empty())
+        {
+            std::wstring wname(desc.debugName.begin(), desc.debugName.end());
+            d3dSignature->SetName(wname.c_str());
+        }
+
+        CommandSignature* signature = new CommandSignature();
+        signature->desc = desc;
+        signature->signature = d3dSignature;
+
+        return CommandSignatureHandle::Create(signature);
+    }
+
     nvrhi::GraphicsPipelineHandle Device::createHandleForNativeGraphicsPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const GraphicsPipelineDesc& desc, const FramebufferInfo& framebufferInfo)
     {
         if (rootSignature == nullptr)
@@ -207,6 +295,7 @@ namespace nvrhi::d3d12
 
         GraphicsPipeline *pso = new GraphicsPipeline();
         pso->desc = desc;
+        pso->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::GraphicsPipeline);
         pso->framebufferInfo = framebufferInfo;
         pso->rootSignature = checked_cast<RootSignature*>(rootSignature);
         pso->pipelineState = pipelineState;
@@ -216,9 +305,18 @@ namespace nvrhi::d3d12
     }
 
     FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
+    {
+        if (m_FramebufferCache)
+            return m_FramebufferCache->getOrCreate(desc, [&]() { return createFramebufferInternal(desc); });
+
+        return createFramebufferInternal(desc);
+    }
+
+    FramebufferHandle Device::createFramebufferInternal(const FramebufferDesc& desc)
     {
         Framebuffer *fb = new Framebuffer(m_Resources);
         fb->desc = desc;
+        fb->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::Framebuffer);
         fb->framebufferInfo = FramebufferInfoEx(desc);
 
         if (!desc.colorAttachments.empty())
@@ -297,8 +395,69 @@ namespace nvrhi::d3d12
         m_ActiveCommandList->commandList->OMSetRenderTargets(UINT(RTVs.size()), RTVs.data(), false, fb->desc.depthAttachment.valid() ? &DSV : nullptr);
     }
 
+    void CommandList::applyFramebufferLoadOps(Framebuffer* fb)
+    {
+        if (fb == m_LastLoadedFramebuffer)
+            return;
+
+        m_LastLoadedFramebuffer = fb;
+
+        // Discarding works on subresources, one array slice at a time as the attachments use a single mip level
+        auto discardAttachment = [this](const FramebufferAttachment& attachment)
+        {
+            Texture* texture = checked_cast<Texture*>(attachment.texture);
+            const TextureSubresourceSet subresources = attachment.subresources.resolve(texture->desc, true);
+
+            for (uint8_t plane = 0; plane < texture->planeCount; plane++)
+            {
+                for (ArraySlice arraySlice = subresources.baseArraySlice; arraySlice < subresources.baseArraySlice + subresources.numArraySlices; arraySlice++)
+                {
+                    D3D12_DISCARD_REGION region = {};
+                    region.FirstSubresource = calcSubresource(subresources.baseMipLevel, arraySlice, plane, texture->desc.mipLevels, texture->desc.arraySize);
+                    region.NumSubresources = 1;
+                    m_ActiveCommandList->commandList->DiscardResource(texture->resource, &region);
+                }
+            }
+        };
+
+        for (uint32_t rtIndex = 0; rtIndex < fb->RTVs.size(); rtIndex++)
+        {
+            const FramebufferAttachment& attachment = fb->desc.colorAttachments[rtIndex];
+
+            if (attachment.loadOp == AttachmentLoadOp::Clear)
+            {
+                m_ActiveCommandList->commandList->ClearRenderTargetView(m_Resources.renderTargetViewHeap.getCpuHandle(fb->RTVs[rtIndex]),
+                    &attachment.clearColor.r, 0, nullptr);
+            }
+            else if (attachment.loadOp == AttachmentLoadOp::DontCare)
+            {
+                discardAttachment(attachment);
+            }
+        }
+
+        const FramebufferAttachment& depthAttachment = fb->desc.depthAttachment;
+        if (depthAttachment.valid())
+        {
+            if (depthAttachment.loadOp == AttachmentLoadOp::Clear)
+            {
+                D3D12_CLEAR_FLAGS clearFlags = D3D12_CLEAR_FLAG_DEPTH;
+                if (getFormatInfo(depthAttachment.texture->getDesc().format).hasStencil)
+                    clearFlags |= D3D12_CLEAR_FLAG_STENCIL;
+
+                m_ActiveCommandList->commandList->ClearDepthStencilView(m_Resources.depthStencilViewHeap.getCpuHandle(fb->DSV),
+                    clearFlags, depthAttachment.clearDepth, depthAttachment.clearStencil, 0, nullptr);
+            }
+            else if (depthAttachment.loadOp == AttachmentLoadOp::DontCare)
+            {
+                discardAttachment(depthAttachment);
+            }
+        }
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::setGraphicsState");
+
         GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
         Framebuffer* framebuffer = checked_cast<Framebuffer*>(state.framebuffer);
 
@@ -338,7 +497,8 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             bindGraphicsPipeline(pso, updateRootSignature);
-            m_Instance->referencedResources.push_back(pso);
+            ++m_Stats.pipelineBinds;
+            m_Instance->referencedResources.add(pso);
         }
 
         if (pso->desc.renderState.depthStencilState.stencilEnable && (updatePipeline || updateStencilRef))
@@ -351,10 +511,13 @@ namespace nvrhi::d3d12
             m_ActiveCommandList->commandList->OMSetBlendFactor(&state.blendConstantColor.r);
         }
 
-        if (updateFramebuffer)
+        // Bundles inherit the render targets, viewports and shading rate image from the primary command list
+        const bool isSecondary = m_Desc.isSecondary;
+
+        if (updateFramebuffer && !isSecondary)
         {
             bindFramebuffer(framebuffer);
-            m_Instance->referencedResources.push_back(framebuffer);
+            m_Instance->referencedResources.add(framebuffer);
         }
 
         setGraphicsBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
@@ -376,7 +539,7 @@ namespace nvrhi::d3d12
                 IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - state.indexBuffer.offset);
                 IBV.BufferLocation = buffer->gpuVA + state.indexBuffer.offset;
 
-                m_Instance->referencedResources.push_back(state.indexBuffer.buffer);
+                m_Instance->referencedResources.add(state.indexBuffer.buffer);
             }
 
             m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
@@ -406,7 +569,7 @@ namespace nvrhi::d3d12
                 VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
                 maxVbIndex = std::max(maxVbIndex, binding.slot);
 
-                m_Instance->referencedResources.push_back(buffer);
+                m_Instance->referencedResources.add(buffer);
             }
 
             if (m_CurrentGraphicsStateValid)
@@ -421,7 +584,7 @@ namespace nvrhi::d3d12
             m_ActiveCommandList->commandList->IASetVertexBuffers(0, maxVbIndex + 1, VBVs);
         }
 
-        if (updateShadingRate || updateFramebuffer)
+        if ((updateShadingRate || updateFramebuffer) && !isSecondary)
         {
             const auto& framebufferDesc = framebuffer->getDesc();
             bool shouldEnableVariableRateShading = framebufferDesc.shadingRateAttachment.valid() && state.shadingRateState.enabled;
@@ -459,7 +622,12 @@ namespace nvrhi::d3d12
 
         commitBarriers();
 
-        if (updateViewports)
+        if (!isSecondary)
+        {
+            applyFramebufferLoadOps(framebuffer);
+        }
+
+        if (updateViewports && !isSecondary)
         {
             DX12_ViewportState vpState = convertViewportState(pso->desc.renderState.rasterState, framebuffer->framebufferInfo, state.viewport);
 
@@ -496,10 +664,107 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = false;
         m_CurrentMeshletStateValid = false;
         m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentGraphicsState = state;
         m_CurrentGraphicsState.dynamicStencilRefValue = effectiveStencilRefValue;
     }
 
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        assert(m_CurrentGraphicsStateValid);
+        assert(slot < c_MaxBindingLayouts);
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+
+        if (slot < m_CurrentGraphicsState.bindings.size() && m_CurrentGraphicsState.bindings[slot] == bindingSet)
+            return;
+
+        while (m_CurrentGraphicsState.bindings.size() <= slot)
+            m_CurrentGraphicsState.bindings.push_back(nullptr);
+
+        m_CurrentGraphicsState.bindings[slot] = bindingSet;
+
+        uint32_t bindingUpdateMask = 1u << slot;
+        if (commitDescriptorHeaps())
+            bindingUpdateMask = ~0u;
+
+        setGraphicsBindings(m_CurrentGraphicsState.bindings, bindingUpdateMask, nullptr, false, pso->rootSignature);
+
+        commitBarriers();
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings)
+    {
+        assert(m_CurrentGraphicsStateValid);
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+        InputLayout* inputLayout = checked_cast<InputLayout*>(pso->desc.inputLayout.Get());
+
+        for (size_t i = 0; i < numBindings; i++)
+        {
+            const VertexBufferBinding& binding = pBindings[i];
+
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            auto current = std::find_if(m_CurrentGraphicsState.vertexBuffers.begin(), m_CurrentGraphicsState.vertexBuffers.end(),
+                [&binding](const VertexBufferBinding& vb) { return vb.slot == binding.slot; });
+
+            if (current == m_CurrentGraphicsState.vertexBuffers.end())
+                m_CurrentGraphicsState.vertexBuffers.push_back(binding);
+            else if (*current != binding)
+                *current = binding;
+            else
+                continue;
+
+            Buffer* buffer = checked_cast<Buffer*>(binding.buffer);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(buffer, ResourceStates::VertexBuffer);
+            }
+
+            D3D12_VERTEX_BUFFER_VIEW VBV = {};
+            VBV.StrideInBytes = inputLayout->elementStrides[binding.slot];
+            VBV.SizeInBytes = (UINT)(std::min(buffer->desc.byteSize - binding.offset, (uint64_t)ULONG_MAX));
+            VBV.BufferLocation = buffer->gpuVA + binding.offset;
+
+            m_ActiveCommandList->commandList->IASetVertexBuffers(binding.slot, 1, &VBV);
+
+            m_Instance->referencedResources.add(buffer);
+        }
+
+        commitBarriers();
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        assert(m_CurrentGraphicsStateValid);
+
+        if (!binding.buffer || m_CurrentGraphicsState.indexBuffer == binding)
+            return;
+
+        Buffer* buffer = checked_cast<Buffer*>(binding.buffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::IndexBuffer);
+        }
+
+        D3D12_INDEX_BUFFER_VIEW IBV = {};
+        IBV.Format = getDxgiFormatMapping(binding.format).srvFormat;
+        IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - binding.offset);
+        IBV.BufferLocation = buffer->gpuVA + binding.offset;
+
+        m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
+
+        m_Instance->referencedResources.add(buffer);
+        m_CurrentGraphicsState.indexBuffer = binding;
+
+        commitBarriers();
+    }
+
     void CommandList::unbindShadingRateState()
     {
         if (m_CurrentGraphicsStateValid && m_CurrentGraphicsState.shadingRateState.enabled)
@@ -550,6 +815,7 @@ namespace nvrhi::d3d12
     void CommandList::draw(const DrawArguments& args)
     {
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         m_ActiveCommandList->commandList->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
     }
@@ -557,16 +823,70 @@ namespace nvrhi::d3d12
     void CommandList::drawIndexed(const DrawArguments& args)
     {
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         m_ActiveCommandList->commandList->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
     }
 
+    void CommandList::drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        updateGraphicsVolatileBuffers();
+        m_Stats.drawCalls += count;
+
+        const GraphicsPipeline* pso = checked_cast<const GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+        const RootSignature* rootsig = pso ? pso->rootSignature.Get() : nullptr;
+        const uint8_t* pushConstantData = (rootsig && rootsig->pushConstantByteSize) ? static_cast<const uint8_t*>(pushConstants) : nullptr;
+
+        if (pushConstantStride == 0)
+            pushConstantStride = pushConstantByteSize;
+
+        ID3D12GraphicsCommandList* commandList = m_ActiveCommandList->commandList;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pushConstantData)
+            {
+                commandList->SetGraphicsRoot32BitConstants(rootsig->rootParameterPushConstants, UINT(pushConstantByteSize / 4), pushConstantData, 0);
+                pushConstantData += pushConstantStride;
+            }
+
+            commandList->DrawInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startVertexLocation, args[i].startInstanceLocation);
+        }
+    }
+
+    void CommandList::drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        updateGraphicsVolatileBuffers();
+        m_Stats.drawCalls += count;
+
+        const GraphicsPipeline* pso = checked_cast<const GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+        const RootSignature* rootsig = pso ? pso->rootSignature.Get() : nullptr;
+        const uint8_t* pushConstantData = (rootsig && rootsig->pushConstantByteSize) ? static_cast<const uint8_t*>(pushConstants) : nullptr;
+
+        if (pushConstantStride == 0)
+            pushConstantStride = pushConstantByteSize;
+
+        ID3D12GraphicsCommandList* commandList = m_ActiveCommandList->commandList;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pushConstantData)
+            {
+                commandList->SetGraphicsRoot32BitConstants(rootsig->rootParameterPushConstants, UINT(pushConstantByteSize / 4), pushConstantData, 0);
+                pushConstantData += pushConstantStride;
+            }
+
+            commandList->DrawIndexedInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startIndexLocation, args[i].startVertexLocation, args[i].startInstanceLocation);
+        }
+    }
+
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
         assert(indirectParams); // validation layer handles this
 
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndirectSignature, drawCount, indirectParams->resource, offsetBytes, nullptr, 0);
     }
@@ -577,6 +897,7 @@ namespace nvrhi::d3d12
         assert(indirectParams);
 
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndexedIndirectSignature, drawCount, indirectParams->resource, offsetBytes, nullptr, 0);
     }
@@ -589,6 +910,7 @@ namespace nvrhi::d3d12
         assert(countBuf);
 
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         m_ActiveCommandList->commandList->ExecuteIndirect(
             m_Context.drawIndexedIndirectSignature,
@@ -600,6 +922,49 @@ namespace nvrhi::d3d12
         );
     }
 
+    void CommandList::executeIndirect(ICommandSignature* _signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset)
+    {
+        CommandSignature* signature = checked_cast<CommandSignature*>(_signature);
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* countBuf = checked_cast<Buffer*>(countBuffer);
+        assert(signature);
+        assert(indirectParams);
+
+        updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(
+            signature->signature,
+            maxCommandCount,
+            indirectParams->resource,
+            offsetBytes,
+            countBuf ? countBuf->resource.Get() : nullptr,
+            countBufferOffset
+        );
+
+        m_Instance->referencedResources.add(signature);
+
+        // The bindings changed by the command signature are undefined after ExecuteIndirect,
+        // so make sure the next setGraphicsState or setVertexBuffers call binds them again.
+        static_vector<VertexBufferBinding, c_MaxVertexAttributes> remainingVertexBuffers;
+        for (const auto& vb : m_CurrentGraphicsState.vertexBuffers)
+        {
+            bool overwritten = false;
+            for (const auto& arg : signature->desc.arguments)
+                overwritten = overwritten || (arg.type == IndirectArgumentType::VertexBuffer && arg.slot == vb.slot);
+
+            if (!overwritten)
+                remainingVertexBuffers.push_back(vb);
+        }
+        m_CurrentGraphicsState.vertexBuffers = remainingVertexBuffers;
+
+        for (const auto& arg : signature->desc.arguments)
+        {
+            if (arg.type == IndirectArgumentType::IndexBuffer)
+                m_CurrentGraphicsState.indexBuffer = IndexBufferBinding();
+        }
+    }
+
     DX12_ViewportState convertViewportState(const RasterState& rasterState, const FramebufferInfoEx& framebufferInfo, const ViewportState& vpState)
     {
         DX12_ViewportState ret;
@@ -145,7 +145,21 @@ namespace nvrhi::d3d12
         streamDesc.pPipelineStateSubobjectStream = &psoDesc;
         streamDesc.SizeInBytes = sizeof(psoDesc);
 
-        HRESULT hr = m_Context.device2->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&pipelineState));
+        PipelineKeyHasher key;
+        key.add(pRS->serializedHash);
+        key.addShader(psoDesc.AmplificationShader);
+        key.addShader(psoDesc.MeshShader);
+        key.addShader(psoDesc.PixelShader);
+        key.addRenderState(psoDesc.BlendState, psoDesc.RasterizerState, psoDesc.DepthStencilState);
+        key.add(psoDesc.PrimitiveTopologyType);
+        key.add(psoDesc.SampleDesc);
+        key.add(psoDesc.SampleMask);
+        key.add(psoDesc.RenderTargets);
+        key.add(psoDesc.DSVFormat);
+
+        HRESULT hr = pRS->serializedHash != 0
+            ? createPipelineStateCached(streamDesc, key, pipelineState)
+            : m_Context.device2->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&pipelineState));
         if (FAILED(hr))
         {
             m_Context.error("Failed to create a meshlet pipeline state object");
@@ -157,6 +171,8 @@ namespace nvrhi::d3d12
 
     MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::createMeshletPipeline");
+
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
 
         RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS, fbinfo);
@@ -182,6 +198,7 @@ namespace nvrhi::d3d12
 
         MeshletPipeline *pso = new MeshletPipeline();
         pso->desc = desc;
+        pso->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::MeshletPipeline);
         pso->framebufferInfo = framebufferInfo;
         pso->rootSignature = checked_cast<RootSignature*>(rootSignature);
         pso->pipelineState = pipelineState;
@@ -229,6 +246,7 @@ namespace nvrhi::d3d12
 
         const bool updatePipeline = !m_CurrentMeshletStateValid || m_CurrentMeshletState.pipeline != state.pipeline;
         const bool updateIndirectParams = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectParams != state.indirectParams;
+        const bool updateIndirectCountBuffer = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectCountBuffer != state.indirectCountBuffer;
 
         const bool updateViewports = !m_CurrentMeshletStateValid ||
             arraysAreDifferent(m_CurrentMeshletState.viewport.viewports, state.viewport.viewports) ||
@@ -254,7 +272,8 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             bindMeshletPipeline(pso, updateRootSignature);
-            m_Instance->referencedResources.push_back(pso);
+            ++m_Stats.pipelineBinds;
+            m_Instance->referencedResources.add(pso);
         }
 
         if (pso->desc.renderState.depthStencilState.stencilEnable && (updatePipeline || updateStencilRef))
@@ -270,13 +289,24 @@ namespace nvrhi::d3d12
         if (updateFramebuffer)
         {
             bindFramebuffer(framebuffer);
-            m_Instance->referencedResources.push_back(framebuffer);
+            m_Instance->referencedResources.add(framebuffer);
         }
 
         setGraphicsBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
+
+        if (state.indirectCountBuffer && updateIndirectCountBuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+            m_Instance->referencedResources.add(state.indirectCountBuffer);
+        }
         
         commitBarriers();
 
+        applyFramebufferLoadOps(framebuffer);
+
         if (updateViewports)
         {
             DX12_ViewportState vpState = convertViewportState(pso->desc.renderState.rasterState, framebuffer->framebufferInfo, state.viewport);
@@ -298,6 +328,7 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = false;
         m_CurrentMeshletStateValid = true;
         m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentMeshletState = state;
         m_CurrentMeshletState.dynamicStencilRefValue = effectiveStencilRefValue;
     }
@@ -306,6 +337,38 @@ namespace nvrhi::d3d12
     {
         updateGraphicsVolatileBuffers();
 
+        ++m_Stats.dispatches;
         m_ActiveCommandList->commandList6->DispatchMesh(groupsX, groupsY, groupsZ);
     }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams); // validation layer handles this
+
+        updateGraphicsVolatileBuffers();
+        ++m_Stats.dispatches;
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchMeshIndirectSignature, dispatchCount, indirectParams->resource, offsetBytes, nullptr, 0);
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+        assert(indirectParams);
+        assert(countBuffer);
+
+        updateGraphicsVolatileBuffers();
+        ++m_Stats.dispatches;
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(
+            m_Context.dispatchMeshIndirectSignature,
+            maxDispatchCount,
+            indirectParams->resource,
+            offsetBytes,
+            countBuffer->resource,
+            countBufferOffset
+        );
+    }
 } // namespace nvrhi::d3d12
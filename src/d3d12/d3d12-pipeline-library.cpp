@@ -0,0 +1,319 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+namespace nvrhi::d3d12
+{
+    // The data returned by getPipelineCacheData starts with this header, followed by the serialized pipeline library.
+    // The runtime validates the adapter and driver version of the serialized library when it's loaded,
+    // the header identifies the data that NVRHI created and the way its pipeline names were computed.
+    struct PipelineLibraryHeader
+    {
+        static constexpr uint32_t c_Magic = 0x4C505652; // 'RVPL'
+        static constexpr uint32_t c_Version = 1; // increment when the pipeline keys change
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        LUID adapterLuid = {};
+        uint64_t librarySize = 0;
+    };
+
+    void PipelineKeyHasher::add(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            m_Hash ^= bytes[i];
+            m_Hash *= 0x100000001b3ull; // FNV-1a prime
+        }
+    }
+
+    void PipelineKeyHasher::addShader(const D3D12_SHADER_BYTECODE& shader)
+    {
+        add(shader.BytecodeLength);
+        if (shader.pShaderBytecode)
+            add(shader.pShaderBytecode, shader.BytecodeLength);
+    }
+
+    std::wstring PipelineKeyHasher::getName(const wchar_t* prefix) const
+    {
+        std::wstringstream ss;
+        ss << prefix << std::hex << std::setw(16) << std::setfill(L'0') << m_Hash;
+        return ss.str();
+    }
+
+    void PipelineKeyHasher::addRenderState(const D3D12_BLEND_DESC& blendState, const D3D12_RASTERIZER_DESC& rasterizerState,
+        const D3D12_DEPTH_STENCIL_DESC& depthStencilState)
+    {
+        add(blendState.AlphaToCoverageEnable);
+        add(blendState.IndependentBlendEnable);
+        for (const D3D12_RENDER_TARGET_BLEND_DESC& target : blendState.RenderTarget)
+        {
+            add(target.BlendEnable);
+            add(target.LogicOpEnable);
+            add(target.SrcBlend);
+            add(target.DestBlend);
+            add(target.BlendOp);
+            add(target.SrcBlendAlpha);
+            add(target.DestBlendAlpha);
+            add(target.BlendOpAlpha);
+            add(target.LogicOp);
+            add(target.RenderTargetWriteMask);
+        }
+
+        // The rasterizer state consists of 4-byte members only, so it doesn't have padding
+        add(rasterizerState);
+
+        add(depthStencilState.DepthEnable);
+        add(depthStencilState.DepthWriteMask);
+        add(depthStencilState.DepthFunc);
+        add(depthStencilState.StencilEnable);
+        add(depthStencilState.StencilReadMask);
+        add(depthStencilState.StencilWriteMask);
+        add(depthStencilState.FrontFace);
+        add(depthStencilState.BackFace);
+    }
+
+    void Device::createPipelineLibrary(const DeviceDesc& desc)
+    {
+        if (!m_Context.device1)
+        {
+            m_Context.warning("The pipeline library requires ID3D12Device1, it will not be used");
+            return;
+        }
+
+        D3D12_FEATURE_DATA_SHADER_CACHE shaderCache = {};
+        if (FAILED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &shaderCache, sizeof(shaderCache))) ||
+            (shaderCache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY) == 0)
+        {
+            m_Context.warning("The pipeline library is not supported by the driver, it will not be used");
+            return;
+        }
+
+        if (desc.pipelineCacheData && desc.pipelineCacheDataSize)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(desc.pipelineCacheData);
+            const LUID adapterLuid = m_Context.device->GetAdapterLuid();
+
+            PipelineLibraryHeader header;
+            if (desc.pipelineCacheDataSize >= sizeof(header))
+                memcpy(&header, bytes, sizeof(header));
+
+            if (header.magic == PipelineLibraryHeader::c_Magic &&
+                header.version == PipelineLibraryHeader::c_Version &&
+                header.adapterLuid.LowPart == adapterLuid.LowPart &&
+                header.adapterLuid.HighPart == adapterLuid.HighPart &&
+                header.librarySize == desc.pipelineCacheDataSize - sizeof(header))
+            {
+                m_PipelineLibraryData.assign(bytes + sizeof(header), bytes + desc.pipelineCacheDataSize);
+            }
+            else
+            {
+                m_Context.warning("The provided pipeline cache data was not created by NVRHI for this adapter, ignoring it");
+            }
+        }
+
+        if (!m_PipelineLibraryData.empty())
+        {
+            const HRESULT hr = m_Context.device1->CreatePipelineLibrary(m_PipelineLibraryData.data(), m_PipelineLibraryData.size(),
+                IID_PPV_ARGS(&m_PipelineLibrary));
+
+            if (FAILED(hr))
+            {
+                std::stringstream ss;
+                if (hr == D3D12_ERROR_DRIVER_VERSION_MISMATCH)
+                    ss << "The provided pipeline cache data was created with a different driver version";
+                else if (hr == D3D12_ERROR_ADAPTER_NOT_FOUND)
+                    ss << "The provided pipeline cache data was created on a different adapter";
+                else
+                    ss << "Failed to load the provided pipeline cache data, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+                ss << ", ignoring it";
+                m_Context.warning(ss.str());
+
+                m_PipelineLibrary = nullptr;
+                std::vector<uint8_t>().swap(m_PipelineLibraryData);
+            }
+        }
+
+        if (!m_PipelineLibrary)
+        {
+            const HRESULT hr = m_Context.device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_PipelineLibrary));
+
+            if (FAILED(hr))
+            {
+                std::stringstream ss;
+                ss << "Failed to create a pipeline library, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+                m_Context.error(ss.str());
+
+                m_PipelineLibrary = nullptr;
+            }
+        }
+    }
+
+    HRESULT Device::createGraphicsPipelineStateCached(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const RootSignature* pRS,
+        RefCountPtr<ID3D12PipelineState>& pipelineState) const
+    {
+        // Root signatures that are not built by NVRHI cannot be identified by their contents
+        if (!m_PipelineLibrary || pRS->serializedHash == 0)
+            return m_Context.device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+
+        PipelineKeyHasher key;
+        key.add(pRS->serializedHash);
+        key.addShader(desc.VS);
+        key.addShader(desc.PS);
+        key.addShader(desc.DS);
+        key.addShader(desc.HS);
+        key.addShader(desc.GS);
+        key.addRenderState(desc.BlendState, desc.RasterizerState, desc.DepthStencilState);
+        key.add(desc.SampleMask);
+
+        key.add(desc.InputLayout.NumElements);
+        for (UINT i = 0; i < desc.InputLayout.NumElements; i++)
+        {
+            const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+            key.add(element.SemanticName, strlen(element.SemanticName) + 1);
+            key.add(element.SemanticIndex);
+            key.add(element.Format);
+            key.add(element.InputSlot);
+            key.add(element.AlignedByteOffset);
+            key.add(element.InputSlotClass);
+            key.add(element.InstanceDataStepRate);
+        }
+
+        key.add(desc.IBStripCutValue);
+        key.add(desc.PrimitiveTopologyType);
+        key.add(desc.NumRenderTargets);
+        key.add(desc.RTVFormats);
+        key.add(desc.DSVFormat);
+        key.add(desc.SampleDesc);
+        key.add(desc.NodeMask);
+        key.add(desc.Flags);
+
+        const std::wstring name = key.getName(L"nvrhi-graphics-");
+
+        {
+            std::lock_guard lockGuard(m_PipelineLibraryLoadMutex);
+
+            if (SUCCEEDED(m_PipelineLibrary->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+                return S_OK;
+        }
+
+        const HRESULT hr = m_Context.device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+
+        // Storing fails if another thread has stored the same pipeline in the meantime, which is fine
+        if (SUCCEEDED(hr))
+            m_PipelineLibrary->StorePipeline(name.c_str(), pipelineState);
+
+        return hr;
+    }
+
+    HRESULT Device::createComputePipelineStateCached(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const RootSignature* pRS,
+        RefCountPtr<ID3D12PipelineState>& pipelineState) const
+    {
+        if (!m_PipelineLibrary || pRS->serializedHash == 0)
+            return m_Context.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+
+        PipelineKeyHasher key;
+        key.add(pRS->serializedHash);
+        key.addShader(desc.CS);
+        key.add(desc.NodeMask);
+        key.add(desc.Flags);
+
+        const std::wstring name = key.getName(L"nvrhi-compute-");
+
+        {
+            std::lock_guard lockGuard(m_PipelineLibraryLoadMutex);
+
+            if (SUCCEEDED(m_PipelineLibrary->LoadComputePipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+                return S_OK;
+        }
+
+        const HRESULT hr = m_Context.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+
+        if (SUCCEEDED(hr))
+            m_PipelineLibrary->StorePipeline(name.c_str(), pipelineState);
+
+        return hr;
+    }
+
+    HRESULT Device::createPipelineStateCached(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, const PipelineKeyHasher& key,
+        RefCountPtr<ID3D12PipelineState>& pipelineState) const
+    {
+        if (!m_PipelineLibrary)
+            return m_Context.device2->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+
+        const std::wstring name = key.getName(L"nvrhi-stream-");
+
+        {
+            std::lock_guard lockGuard(m_PipelineLibraryLoadMutex);
+
+            if (SUCCEEDED(m_PipelineLibrary->LoadPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+                return S_OK;
+        }
+
+        const HRESULT hr = m_Context.device2->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+
+        if (SUCCEEDED(hr))
+            m_PipelineLibrary->StorePipeline(name.c_str(), pipelineState);
+
+        return hr;
+    }
+
+    bool Device::getPipelineCacheData(std::vector<uint8_t>& data)
+    {
+        if (!m_PipelineLibrary)
+            return false;
+
+        const size_t librarySize = m_PipelineLibrary->GetSerializedSize();
+
+        PipelineLibraryHeader header;
+        header.magic = PipelineLibraryHeader::c_Magic;
+        header.version = PipelineLibraryHeader::c_Version;
+        header.adapterLuid = m_Context.device->GetAdapterLuid();
+        header.librarySize = librarySize;
+
+        data.resize(sizeof(header) + librarySize);
+        memcpy(data.data(), &header, sizeof(header));
+
+        const HRESULT hr = m_PipelineLibrary->Serialize(data.data() + sizeof(header), librarySize);
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "Failed to serialize the pipeline library, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+
+            data.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+} // namespace nvrhi::d3d12
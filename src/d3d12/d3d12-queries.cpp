@@ -24,6 +24,9 @@
 
 #include <nvrhi/common/misc.h>
 
+#include <algorithm>
+#include <chrono>
+
 namespace nvrhi::d3d12
 {
     TimerQuery::~TimerQuery()
@@ -33,63 +36,145 @@ namespace nvrhi::d3d12
 
     EventQueryHandle Device::createEventQuery(void)
     {
-        EventQuery *ret = new EventQuery();
-        return EventQueryHandle::Create(ret);
+        EventQuery* query = m_EventQueryPool->acquire();
+        query->ticket = SubmissionTicket();
+        query->started = false;
+        return EventQueryHandle::Create(query);
     }
 
     void Device::setEventQuery(IEventQuery* _query, CommandQueue queue)
     {
         EventQuery* query = checked_cast<EventQuery*>(_query);
-        Queue* pQueue = getQueue(queue);
         
+        query->ticket = getSubmissionTicket(queue);
         query->started = true;
-        query->fence = pQueue->fence;
-        query->fenceCounter = pQueue->lastSubmittedInstance;
-        query->resolved = false;
     }
 
     bool Device::pollEventQuery(IEventQuery* _query)
     {
         EventQuery* query = checked_cast<EventQuery*>(_query);
 
-        if (!query->started)
-            return false;
-
-        if (query->resolved)
-            return true;
-
-        assert(query->fence);
-        
-        if (query->fence->GetCompletedValue() >= query->fenceCounter)
-        {
-            query->resolved = true;
-            query->fence = nullptr;
-        }
-
-        return query->resolved;
+        return query->started && pollSubmission(query->ticket);
     }
 
     void Device::waitEventQuery(IEventQuery* _query)
     {
         EventQuery* query = checked_cast<EventQuery*>(_query);
 
-        if (!query->started || query->resolved)
-            return;
-
-        assert(query->fence);
-
-        WaitForFence(query->fence, query->fenceCounter, m_FenceEvent);
+        if (query->started)
+            waitForAll(&query->ticket, 1, ~0ull);
     }
 
     void Device::resetEventQuery(IEventQuery* _query)
     {
         EventQuery* query = checked_cast<EventQuery*>(_query);
 
+        query->ticket = SubmissionTicket();
         query->started = false;
-        query->resolved = false;
-        query->fence = nullptr;
     }
-    
+
+    SubmissionTicket Device::getSubmissionTicket(CommandQueue queue)
+    {
+        return SubmissionTicket()
+            .setQueue(queue)
+            .setInstance(getQueue(queue)->lastSubmittedInstance);
+    }
+
+    bool Device::pollSubmission(const SubmissionTicket& ticket)
+    {
+        if (ticket.instance == 0)
+            return true;
+
+        Queue* queue = getQueue(ticket.queue);
+
+        return queue && ticket.instance <= queue->lastSubmittedInstance && queue->updateLastCompletedInstance() >= ticket.instance;
+    }
+
+    bool Device::waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        return waitForSubmissions(tickets, numTickets, true, timeoutNanoseconds);
+    }
+
+    bool Device::waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        return waitForSubmissions(tickets, numTickets, false, timeoutNanoseconds);
+    }
+
+    bool Device::waitForSubmissions(const SubmissionTicket* tickets, size_t numTickets, bool waitAll, uint64_t timeoutNanoseconds)
+    {
+        std::vector<ID3D12Fence*> fences;
+        std::vector<UINT64> values;
+        fences.reserve(numTickets);
+        values.reserve(numTickets);
+
+        for (size_t i = 0; i < numTickets; i++)
+        {
+            const SubmissionTicket& ticket = tickets[i];
+            Queue* queue = getQueue(ticket.queue);
+
+            if (ticket.instance != 0 && (!queue || ticket.instance > queue->lastSubmittedInstance))
+                return false;
+
+            if (pollSubmission(ticket))
+            {
+                if (!waitAll)
+                    return true;
+                continue;
+            }
+
+            if (m_Context.deferredSubmission)
+                queue->flush();
+
+            fences.push_back(queue->fence);
+            values.push_back(ticket.instance);
+        }
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        while (!fences.empty())
+        {
+            DWORD timeoutMilliseconds = INFINITE;
+            if (timeoutNanoseconds != ~0ull)
+            {
+                const uint64_t elapsed = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+                const uint64_t remaining = (elapsed < timeoutNanoseconds) ? timeoutNanoseconds - elapsed : 0;
+                timeoutMilliseconds = DWORD(std::min<uint64_t>((remaining + 999999) / 1000000, INFINITE - 1));
+            }
+
+            // Without ID3D12Device1, the fences are waited for one at a time, and waiting for any of them
+            // waits for the first one
+            ResetEvent(m_MultipleFenceEvent);
+            const HRESULT hr = m_Context.device1
+                ? m_Context.device1->SetEventOnMultipleFenceCompletion(fences.data(), values.data(), UINT(fences.size()),
+                    waitAll ? D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL : D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY, m_MultipleFenceEvent)
+                : fences[0]->SetEventOnCompletion(values[0], m_MultipleFenceEvent);
+
+            if (FAILED(hr) || WaitForSingleObject(m_MultipleFenceEvent, timeoutMilliseconds) != WAIT_OBJECT_0)
+                return false;
+
+            // The event may also have been signaled by an earlier wait that timed out, so check the fences again
+            // and keep waiting for the ones that have not completed
+            size_t numPending = 0;
+            for (size_t i = 0; i < fences.size(); i++)
+            {
+                if (fences[i]->GetCompletedValue() >= values[i])
+                    continue;
+
+                fences[numPending] = fences[i];
+                values[numPending] = values[i];
+                ++numPending;
+            }
+
+            if (!waitAll && numPending < fences.size())
+                return true;
+
+            fences.resize(numPending);
+            values.resize(numPending);
+        }
+
+        return waitAll;
+    }
+
     TimerQueryHandle Device::createTimerQuery(void)
     {
         if (!m_Context.timerQueryHeap)
@@ -153,7 +238,7 @@ namespace nvrhi::d3d12
         {
             if (query->fence)
             {
-                WaitForFence(query->fence, query->fenceCounter, m_FenceEvent);
+                waitForQueueFence(query->fence, query->fenceCounter);
                 query->fence = nullptr;
             }
 
@@ -219,5 +304,64 @@ namespace nvrhi::d3d12
             query->beginQueryIndex * 8);
     }
 
+    bool ProfilerTimestampSource::readTimestamps(ITimerQuery* const* queries, size_t numQueries, uint64_t* outTimestamps)
+    {
+        Buffer* resolveBuffer = m_Device.getContext().timerQueryResolveBuffer;
+        if (!resolveBuffer)
+            return false;
+
+        // All timer queries resolve into the same buffer, so one mapping covers the whole frame
+        uint64_t* data;
+        const HRESULT res = resolveBuffer->resource->Map(0, nullptr, (void**)&data);
+
+        if (FAILED(res))
+        {
+            m_Device.getContext().error("GPU profiler: Map() failed");
+            return false;
+        }
+
+        for (size_t i = 0; i < numQueries; i++)
+        {
+            const TimerQuery* query = checked_cast<const TimerQuery*>(queries[i]);
+            outTimestamps[i * 2] = data[query->beginQueryIndex];
+            outTimestamps[i * 2 + 1] = data[query->endQueryIndex];
+        }
+
+        const D3D12_RANGE writtenRange = { 0, 0 };
+        resolveBuffer->resource->Unmap(0, &writtenRange);
+
+        return true;
+    }
+
+    uint64_t ProfilerTimestampSource::getTimestampFrequency(CommandQueue queue)
+    {
+        Queue* pQueue = m_Device.getQueue(queue);
+        if (!pQueue)
+            return 0;
+
+        uint64_t frequency = 0;
+        pQueue->queue->GetTimestampFrequency(&frequency);
+        return frequency;
+    }
+
+    bool ProfilerTimestampSource::calibrateTimestamps(CommandQueue queue, uint64_t& outGpuTimestamp, int64_t& outCpuTimeNs)
+    {
+        Queue* pQueue = m_Device.getQueue(queue);
+        if (!pQueue)
+            return false;
+
+        uint64_t cpuTimestamp = 0;
+        if (FAILED(pQueue->queue->GetClockCalibration(&outGpuTimestamp, &cpuTimestamp)))
+            return false;
+
+        // The CPU timestamp is a QueryPerformanceCounter value, which std::chrono::steady_clock is based on
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        const int64_t qpcFrequency = frequency.QuadPart;
+        const int64_t qpcValue = int64_t(cpuTimestamp);
+        outCpuTimeNs = (qpcValue / qpcFrequency) * std::nano::den + (qpcValue % qpcFrequency) * std::nano::den / qpcFrequency;
+
+        return true;
+    }
 
 } // namespace nvrhi::d3d12
@@ -21,6 +21,7 @@
 */
 
 #include "d3d12-backend.h"
+#include "../common/parallel-for.h"
 
 #include <nvrhi/common/containers.h>
 #include <nvrhi/common/misc.h>
@@ -31,6 +32,7 @@
 #include <algorithm>
 #include <list>
 #include <sstream>
+#include <iomanip>
 
 namespace
 {
@@ -306,6 +308,35 @@ namespace nvrhi::d3d12
         return true;
     }
 
+    const ShaderTable::Entry& ShaderTable::getEntry(uint32_t index) const
+    {
+        if (index == 0)
+            return rayGenerationShader;
+        index -= 1;
+
+        if (index < missShaders.size())
+            return missShaders[index];
+        index -= uint32_t(missShaders.size());
+
+        if (index < hitGroups.size())
+            return hitGroups[index];
+        index -= uint32_t(hitGroups.size());
+
+        return callableShaders[index];
+    }
+
+    void ShaderTable::markEntryDirty(uint32_t index)
+    {
+        if (desc.isPersistent && !allEntriesDirty)
+            dirtyEntries.push_back(index);
+    }
+
+    void ShaderTable::markAllEntriesDirty()
+    {
+        allEntriesDirty = true;
+        dirtyEntries.clear();
+    }
+
     void ShaderTable::setRayGenerationShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
     {
         const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
@@ -315,83 +346,114 @@ namespace nvrhi::d3d12
             rayGenerationShader.pShaderIdentifier = pipelineExport->pShaderIdentifier;
             rayGenerationShader.localBindings = bindings;
 
+            markEntryDirty(0);
             ++version;
         }
     }
 
-    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    int ShaderTable::addEntry(std::vector<Entry>& entries, uint32_t firstEntry, const char* exportName, IBindingSet* bindings)
     {
         const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
 
-        if (verifyExport(pipelineExport, bindings))
-        {
-            Entry entry;
-            entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
-            entry.localBindings = bindings;
-            missShaders.push_back(entry);
+        if (!verifyExport(pipelineExport, bindings))
+            return -1;
 
-            ++version;
+        Entry entry;
+        entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
+        entry.localBindings = bindings;
+        entries.push_back(entry);
 
-            return int(missShaders.size()) - 1;
-        }
+        // Adding a record to a section moves the records of the following sections
+        const uint32_t index = firstEntry + uint32_t(entries.size()) - 1;
+        if (index + 1 == getNumEntries())
+            markEntryDirty(index);
+        else
+            markAllEntriesDirty();
+
+        ++version;
 
-        return -1;
+        return int(entries.size()) - 1;
     }
 
-    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    bool ShaderTable::setEntry(std::vector<Entry>& entries, uint32_t firstEntry, int index, const char* exportName, IBindingSet* bindings)
     {
+        if (index < 0 || size_t(index) >= entries.size())
+        {
+            m_Context.error("Shader table record index is out of bounds");
+            return false;
+        }
+
         const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
 
-        if (verifyExport(pipelineExport, bindings))
-        {
-            Entry entry;
-            entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
-            entry.localBindings = bindings;
-            hitGroups.push_back(entry);
+        if (!verifyExport(pipelineExport, bindings))
+            return false;
 
-            ++version;
+        Entry& entry = entries[index];
+        entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
+        entry.localBindings = bindings;
 
-            return int(hitGroups.size()) - 1;
-        }
+        markEntryDirty(firstEntry + uint32_t(index));
+        ++version;
+
+        return true;
+    }
+
+    void ShaderTable::clearEntries(std::vector<Entry>& entries, uint32_t firstEntry)
+    {
+        const bool isLastSection = firstEntry + entries.size() == getNumEntries();
 
-        return -1;
+        entries.clear();
+
+        // Removing the records of the last section doesn't change the remaining ones
+        if (!isLastSection)
+            markAllEntriesDirty();
+
+        ++version;
     }
 
-    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
     {
-        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
+        return addEntry(missShaders, 1, exportName, bindings);
+    }
 
-        if (verifyExport(pipelineExport, bindings))
-        {
-            Entry entry;
-            entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
-            entry.localBindings = bindings;
-            callableShaders.push_back(entry);
+    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addEntry(hitGroups, 1 + uint32_t(missShaders.size()), exportName, bindings);
+    }
 
-            ++version;
+    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addEntry(callableShaders, 1 + uint32_t(missShaders.size() + hitGroups.size()), exportName, bindings);
+    }
 
-            return int(callableShaders.size()) - 1;
-        }
+    bool ShaderTable::setMissShader(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(missShaders, 1, index, exportName, bindings);
+    }
+
+    bool ShaderTable::setHitGroup(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(hitGroups, 1 + uint32_t(missShaders.size()), index, exportName, bindings);
+    }
 
-        return -1;
+    bool ShaderTable::setCallableShader(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(callableShaders, 1 + uint32_t(missShaders.size() + hitGroups.size()), index, exportName, bindings);
     }
 
     void ShaderTable::clearMissShaders()
     {
-        missShaders.clear();
-        ++version;
+        clearEntries(missShaders, 1);
     }
 
     void ShaderTable::clearHitShaders()
     {
-        hitGroups.clear();
-        ++version;
+        clearEntries(hitGroups, 1 + uint32_t(missShaders.size()));
     }
 
     void ShaderTable::clearCallableShaders()
     {
-        callableShaders.clear();
-        ++version;
+        clearEntries(callableShaders, 1 + uint32_t(missShaders.size() + hitGroups.size()));
     }
 
     rt::IPipeline* ShaderTable::getPipeline()
@@ -413,7 +475,12 @@ namespace nvrhi::d3d12
 
     rt::ShaderTableHandle RayTracingPipeline::createShaderTable()
     { 
-        return rt::ShaderTableHandle::Create(new ShaderTable(m_Context, this));
+        return createShaderTable(rt::ShaderTableDesc());
+    }
+
+    rt::ShaderTableHandle RayTracingPipeline::createShaderTable(const rt::ShaderTableDesc& shaderTableDesc)
+    {
+        return rt::ShaderTableHandle::Create(new ShaderTable(m_Context, this, shaderTableDesc));
     }
 
     uint32_t RayTracingPipeline::getShaderTableEntrySize() const
@@ -788,8 +855,12 @@ namespace nvrhi::d3d12
         bufferDesc.isAccelStructStorage = true;
         bufferDesc.debugName = desc.debugName;
         bufferDesc.isVirtual = false;
+        // Place OMM arrays into the shared heaps to avoid the creation cost of a committed resource per array.
+        // Placed buffers are 64 KB aligned like committed ones, so each array still occupies at least 64 KB.
+        bufferDesc.allocationMode = ResourceAllocationMode::SubAllocated;
         BufferHandle buffer = createBuffer(bufferDesc);
         om->dataBuffer = checked_cast<Buffer*>(buffer.Get());
+        om->statsEntry.set(&m_Resources.accelStructStats, AccelStructStatsTracker::ObjectType::OpacityMicromap, bufferDesc.byteSize);
                 
         return rt::OpacityMicromapHandle::Create(om);
 
@@ -822,9 +893,11 @@ namespace nvrhi::d3d12
             bufferDesc.isAccelStructStorage = true;
             bufferDesc.debugName = desc.debugName;
             bufferDesc.isVirtual = false;
+            bufferDesc.allocationMode = ResourceAllocationMode::SubAllocated;
             BufferHandle buffer = createBuffer(bufferDesc);
             om->dataBuffer = checked_cast<Buffer*>(buffer.Get());
             assert((om->dataBuffer->gpuVA % NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_BYTE_ALIGNMENT) == 0);
+            om->statsEntry.set(&m_Resources.accelStructStats, AccelStructStatsTracker::ObjectType::OpacityMicromap, bufferDesc.byteSize);
         }
         return rt::OpacityMicromapHandle::Create(om);
 #else
@@ -889,9 +962,18 @@ namespace nvrhi::d3d12
             bufferDesc.isAccelStructStorage = true;
             bufferDesc.debugName = desc.debugName;
             bufferDesc.isVirtual = desc.isVirtual;
+            // Place BLASes into the shared heaps to avoid the creation cost of a committed resource per BLAS.
+            // This doesn't save memory: placed buffers are 64 KB aligned, the same granularity as committed ones,
+            // so a BLAS smaller than that, e.g. after compaction, still occupies 64 KB.
+            if (!desc.isTopLevel)
+                bufferDesc.allocationMode = ResourceAllocationMode::SubAllocated;
             BufferHandle buffer = createBuffer(bufferDesc);
             as->dataBuffer = checked_cast<Buffer*>(buffer.Get());
         }
+
+        as->statsEntry.set(&m_Resources.accelStructStats,
+            desc.isTopLevel ? AccelStructStatsTracker::ObjectType::TopLevel : AccelStructStatsTracker::ObjectType::BottomLevel,
+            as->dataBuffer ? as->dataBuffer->desc.byteSize : 0);
         
         // Sanitize the geometry data to avoid dangling pointers, we don't need these buffers in the desc
         for (auto& geometry : as->desc.bottomLevelGeometries)
@@ -1165,10 +1247,53 @@ namespace nvrhi::d3d12
     }
     
     rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::createRayTracingPipeline");
+
+        return createRayTracingPipelineInternal(desc, nullptr);
+    }
+
+    rt::PipelineHandle Device::addToRayTracingPipeline(rt::IPipeline* _pipeline, const rt::PipelineDesc& additions)
+    {
+        RayTracingPipeline* basePipeline = checked_cast<RayTracingPipeline*>(_pipeline);
+
+        if (!m_Context.device7)
+        {
+            m_Context.error("addToRayTracingPipeline requires ID3D12Device7");
+            return nullptr;
+        }
+
+        if (!basePipeline->desc.allowAdditions)
+        {
+            m_Context.error("addToRayTracingPipeline requires a pipeline created with allowAdditions = true");
+            return nullptr;
+        }
+
+        return createRayTracingPipelineInternal(additions, basePipeline);
+    }
+
+    // When 'basePipeline' is not null, 'desc' only describes the new shaders and hit groups,
+    // and the resulting pipeline is created with AddToStateObject.
+    rt::PipelineHandle Device::createRayTracingPipelineInternal(const rt::PipelineDesc& desc, RayTracingPipeline* basePipeline)
     {
         RayTracingPipeline* pso = new RayTracingPipeline(m_Context);
-        pso->desc = desc;
-        pso->maxLocalRootParameters = 0;
+        pso->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::RayTracingPipeline);
+
+        if (basePipeline)
+        {
+            pso->desc = basePipeline->desc;
+            pso->desc.shaders.insert(pso->desc.shaders.end(), desc.shaders.begin(), desc.shaders.end());
+            pso->desc.hitGroups.insert(pso->desc.hitGroups.end(), desc.hitGroups.begin(), desc.hitGroups.end());
+            pso->localRootSignatures = basePipeline->localRootSignatures;
+            pso->globalRootSignature = basePipeline->globalRootSignature;
+            pso->maxLocalRootParameters = basePipeline->maxLocalRootParameters;
+            pso->numRenamedExports = basePipeline->numRenamedExports;
+        }
+        else
+        {
+            pso->desc = desc;
+            pso->maxLocalRootParameters = 0;
+        }
 
         // Collect all DXIL libraries that are referenced in `desc`, and enumerate their exports.
         // Build local root signatures for all referenced local binding layouts.
@@ -1253,7 +1378,8 @@ namespace nvrhi::d3d12
                     library.blobSize = blobSize;
 
                     std::string originalShaderName = shader->getDesc().entryName;
-                    std::string newShaderName = originalShaderName + std::to_string(hitGroupShaderNames.size());
+                    // Continue the numbering of the base pipeline, if any, so that the names stay unique after AddToStateObject
+                    std::string newShaderName = originalShaderName + std::to_string(pso->numRenamedExports + hitGroupShaderNames.size());
 
                     library.exports.push_back(std::make_pair<std::wstring, std::wstring>(
                         std::wstring(originalShaderName.begin(), originalShaderName.end()),
@@ -1299,6 +1425,8 @@ namespace nvrhi::d3d12
             d3dHitGroups.push_back(d3dHitGroupDesc);
         }
 
+        pso->numRenamedExports += uint32_t(hitGroupShaderNames.size());
+
         // Create descriptors for DXIL libraries, enumerate the exports used from each library.
 
         std::vector<D3D12_DXIL_LIBRARY_DESC> d3dDxilLibraries;
@@ -1335,8 +1463,8 @@ namespace nvrhi::d3d12
         // Subobject: Shader config
 
         D3D12_RAYTRACING_SHADER_CONFIG d3dShaderConfig = {};
-        d3dShaderConfig.MaxAttributeSizeInBytes = desc.maxAttributeSize;
-        d3dShaderConfig.MaxPayloadSizeInBytes = desc.maxPayloadSize;
+        d3dShaderConfig.MaxAttributeSizeInBytes = pso->desc.maxAttributeSize;
+        d3dShaderConfig.MaxPayloadSizeInBytes = pso->desc.maxPayloadSize;
 
         d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG;
         d3dSubobject.pDesc = &d3dShaderConfig;
@@ -1347,7 +1475,7 @@ namespace nvrhi::d3d12
         d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG1;
         D3D12_RAYTRACING_PIPELINE_CONFIG1 d3dPipelineConfig = {};
 
-        if (m_OpacityMicromapSupported && desc.allowOpacityMicromaps)
+        if (m_OpacityMicromapSupported && pso->desc.allowOpacityMicromaps)
         {
             d3dPipelineConfig.Flags = D3D12_RAYTRACING_PIPELINE_FLAG_ALLOW_OPACITY_MICROMAPS;
         }
@@ -1356,10 +1484,23 @@ namespace nvrhi::d3d12
         D3D12_RAYTRACING_PIPELINE_CONFIG d3dPipelineConfig = {};
 #endif
 
-        d3dPipelineConfig.MaxTraceRecursionDepth = desc.maxRecursionDepth;
+        d3dPipelineConfig.MaxTraceRecursionDepth = pso->desc.maxRecursionDepth;
         d3dSubobject.pDesc = &d3dPipelineConfig;
         d3dSubobjects.push_back(d3dSubobject);
 
+        // Subobject: state object config
+
+        D3D12_STATE_OBJECT_CONFIG d3dStateObjectConfig = {};
+
+        if (pso->desc.allowAdditions)
+        {
+            d3dStateObjectConfig.Flags = D3D12_STATE_OBJECT_FLAG_ALLOW_STATE_OBJECT_ADDITIONS;
+
+            d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_STATE_OBJECT_CONFIG;
+            d3dSubobject.pDesc = &d3dStateObjectConfig;
+            d3dSubobjects.push_back(d3dSubobject);
+        }
+
         // Subobjects: DXIL libraries
 
         for (const D3D12_DXIL_LIBRARY_DESC& d3dLibraryDesc : d3dDxilLibraries)
@@ -1382,10 +1523,14 @@ namespace nvrhi::d3d12
 
         D3D12_GLOBAL_ROOT_SIGNATURE d3dGlobalRootSignature = {};
 
-        if (!desc.globalBindingLayouts.empty())
+        if (!basePipeline && !desc.globalBindingLayouts.empty())
         {
             RootSignatureHandle rootSignature = buildRootSignature(desc.globalBindingLayouts, false, false);
             pso->globalRootSignature = checked_cast<RootSignature*>(rootSignature.Get());
+        }
+
+        if (pso->globalRootSignature)
+        {
             d3dGlobalRootSignature.pGlobalRootSignature = pso->globalRootSignature->getNativeObject(ObjectTypes::D3D12_RootSignature);
 
             d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE;
@@ -1412,6 +1557,16 @@ namespace nvrhi::d3d12
 
         for (const auto& it : pso->localRootSignatures)
         {
+            // The local root signatures inherited from the base pipeline are already associated with their exports,
+            // and an association without exports would become the default one
+            bool isUsed = std::any_of(desc.shaders.begin(), desc.shaders.end(),
+                    [&it](const rt::PipelineShaderDesc& shader) { return shader.bindingLayout == it.first; })
+                || std::any_of(desc.hitGroups.begin(), desc.hitGroups.end(),
+                    [&it](const rt::PipelineHitGroupDesc& hitGroup) { return hitGroup.bindingLayout == it.first; });
+
+            if (!isUsed)
+                continue;
+
             D3D12_LOCAL_ROOT_SIGNATURE* d3dLocalRootSignature = &d3dLocalRootSignatures.emplace_back();
             d3dLocalRootSignature->pLocalRootSignature = it.second->getNativeObject(ObjectTypes::D3D12_RootSignature);
 
@@ -1467,7 +1622,9 @@ namespace nvrhi::d3d12
                 return nullptr;
         }
 
-        HRESULT hr = m_Context.device5->CreateStateObject(&pipelineDesc, IID_PPV_ARGS(&pso->pipelineState));
+        HRESULT hr = basePipeline
+            ? m_Context.device7->AddToStateObject(&pipelineDesc, basePipeline->pipelineState, IID_PPV_ARGS(&pso->pipelineState))
+            : m_Context.device5->CreateStateObject(&pipelineDesc, IID_PPV_ARGS(&pso->pipelineState));
 
         if (desc.hlslExtensionsUAV >= 0)
         {
@@ -1491,7 +1648,7 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
-        for (const rt::PipelineShaderDesc& shaderDesc : desc.shaders)
+        for (const rt::PipelineShaderDesc& shaderDesc : pso->desc.shaders)
         {
             std::string exportName = !shaderDesc.exportName.empty() ? shaderDesc.exportName : shaderDesc.shader->getDesc().entryName;
             std::wstring exportNameW = std::wstring(exportName.begin(), exportName.end());
@@ -1506,7 +1663,7 @@ namespace nvrhi::d3d12
             pso->exports[exportName] = RayTracingPipeline::ExportTableEntry{ shaderDesc.bindingLayout, pShaderIdentifier };
         }
 
-        for(const rt::PipelineHitGroupDesc& hitGroupDesc : desc.hitGroups)
+        for(const rt::PipelineHitGroupDesc& hitGroupDesc : pso->desc.hitGroups)
         { 
             std::wstring exportNameW = std::wstring(hitGroupDesc.exportName.begin(), hitGroupDesc.exportName.end());
             const void* pShaderIdentifier = pso->pipelineInfo->GetShaderIdentifier(exportNameW.c_str());
@@ -1523,109 +1680,224 @@ namespace nvrhi::d3d12
         return rt::PipelineHandle::Create(pso);
     }
 
-    void CommandList::setRayTracingState(const rt::State& state)
+    void CommandList::writeShaderTableEntry(uint8_t* pDest, const ShaderTable::Entry& entry)
     {
-        ShaderTable* shaderTable = checked_cast<ShaderTable*>(state.shaderTable);
-        RayTracingPipeline* pso = shaderTable->pipeline;
+        memcpy(pDest, entry.pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
 
-        ShaderTableState* shaderTableState = getShaderTableStateTracking(shaderTable);
+        if (entry.localBindings)
+        {
+            d3d12::BindingSet* bindingSet = checked_cast<d3d12::BindingSet*>(entry.localBindings.Get());
+            d3d12::BindingLayout* layout = bindingSet->layout;
 
-        bool rebuildShaderTable = shaderTableState->committedVersion != shaderTable->version ||
-            shaderTableState->descriptorHeapSRV != m_Resources.shaderResourceViewHeap.getShaderVisibleHeap() ||
-            shaderTableState->descriptorHeapSamplers != m_Resources.samplerHeap.getShaderVisibleHeap();
+            if (layout->descriptorTableSizeSamplers > 0)
+            {
+                auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(pDest + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSamplers * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+                *pTable = m_Resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers);
+            }
 
-        if (rebuildShaderTable)
-        {
-            uint32_t entrySize = pso->getShaderTableEntrySize();
-            uint32_t sbtSize = shaderTable->getNumEntries() * entrySize;
+            if (layout->descriptorTableSizeSRVetc > 0)
+            {
+                auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(pDest + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSRVetc * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+                *pTable = m_Resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc);
+            }
 
-            unsigned char* cpuVA;
-            D3D12_GPU_VIRTUAL_ADDRESS gpuVA;
-            if (!m_UploadManager.suballocateBuffer(sbtSize, nullptr, nullptr, nullptr, 
-                (void**)&cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT))
+            if (!layout->rootParametersVolatileCB.empty())
             {
-                m_Context.error("Couldn't suballocate an upload buffer");
+                m_Context.error("Cannot use Volatile CBs in a shader binding table");
                 return;
             }
+        }
+    }
 
-            uint32_t entryIndex = 0;
+    static void fillDispatchRaysTemplate(D3D12_DISPATCH_RAYS_DESC& drd, const ShaderTable* shaderTable,
+        D3D12_GPU_VIRTUAL_ADDRESS gpuVA, uint32_t entrySize)
+    {
+        memset(&drd, 0, sizeof(D3D12_DISPATCH_RAYS_DESC));
 
-            auto writeEntry = [this, entrySize, &cpuVA, &gpuVA, &entryIndex](const ShaderTable::Entry& entry) 
-            {
-                memcpy(cpuVA, entry.pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+        drd.RayGenerationShaderRecord.StartAddress = gpuVA;
+        drd.RayGenerationShaderRecord.SizeInBytes = entrySize;
+        gpuVA += entrySize;
 
-                if (entry.localBindings)
-                {
-                    d3d12::BindingSet* bindingSet = checked_cast<d3d12::BindingSet*>(entry.localBindings.Get());
-                    d3d12::BindingLayout* layout = bindingSet->layout;
+        if (!shaderTable->missShaders.empty())
+        {
+            drd.MissShaderTable.StartAddress = gpuVA;
+            drd.MissShaderTable.StrideInBytes = (shaderTable->missShaders.size() == 1) ? 0 : entrySize;
+            drd.MissShaderTable.SizeInBytes = uint32_t(shaderTable->missShaders.size()) * entrySize;
+            gpuVA += drd.MissShaderTable.SizeInBytes;
+        }
 
-                    if (layout->descriptorTableSizeSamplers > 0)
-                    {
-                        auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSamplers * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-                        *pTable = m_Resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers);
-                    }
+        if (!shaderTable->hitGroups.empty())
+        {
+            drd.HitGroupTable.StartAddress = gpuVA;
+            drd.HitGroupTable.StrideInBytes = (shaderTable->hitGroups.size() == 1) ? 0 : entrySize;
+            drd.HitGroupTable.SizeInBytes = uint32_t(shaderTable->hitGroups.size()) * entrySize;
+            gpuVA += drd.HitGroupTable.SizeInBytes;
+        }
 
-                    if (layout->descriptorTableSizeSRVetc > 0)
-                    {
-                        auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSRVetc * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-                        *pTable = m_Resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc);
-                    }
+        if (!shaderTable->callableShaders.empty())
+        {
+            drd.CallableShaderTable.StartAddress = gpuVA;
+            drd.CallableShaderTable.StrideInBytes = (shaderTable->callableShaders.size() == 1) ? 0 : entrySize;
+            drd.CallableShaderTable.SizeInBytes = uint32_t(shaderTable->callableShaders.size()) * entrySize;
+        }
+    }
 
-                    if (!layout->rootParametersVolatileCB.empty())
-                    {
-                        m_Context.error("Cannot use Volatile CBs in a shader binding table");
-                        return;
-                    }
-                }
+    bool CommandList::updatePersistentShaderTable(ShaderTable* shaderTable)
+    {
+        const uint32_t entrySize = shaderTable->pipeline->getShaderTableEntrySize();
+        const uint32_t numEntries = shaderTable->getNumEntries();
+        ID3D12DescriptorHeap* heapSRV = m_Resources.shaderResourceViewHeap.getShaderVisibleHeap();
+        ID3D12DescriptorHeap* heapSamplers = m_Resources.samplerHeap.getShaderVisibleHeap();
 
-                cpuVA += entrySize;
-                gpuVA += entrySize;
-                entryIndex += 1;
-            };
+        // The records contain descriptor table handles, which change when the shader-visible heaps are reallocated,
+        // and the record size changes when addToRayTracingPipeline adds exports with more local root parameters
+        if (shaderTable->persistentEntrySize != entrySize ||
+            shaderTable->persistentHeapSRV != heapSRV ||
+            shaderTable->persistentHeapSamplers != heapSamplers)
+        {
+            shaderTable->markAllEntriesDirty();
+        }
 
-            D3D12_DISPATCH_RAYS_DESC& drd = shaderTableState->dispatchRaysTemplate;
-            memset(&drd, 0, sizeof(D3D12_DISPATCH_RAYS_DESC));
+        if (!shaderTable->persistentBuffer || shaderTable->persistentBuffer->getDesc().byteSize < uint64_t(numEntries) * entrySize)
+        {
+            // Grow geometrically, so that tables that are filled gradually are not reallocated on every use
+            uint64_t capacity = std::max(numEntries, shaderTable->desc.initialCapacity);
+            if (shaderTable->persistentBuffer)
+                capacity = std::max(capacity, 2 * (shaderTable->persistentBuffer->getDesc().byteSize / entrySize));
 
-            drd.RayGenerationShaderRecord.StartAddress = gpuVA;
-            drd.RayGenerationShaderRecord.SizeInBytes = entrySize;
-            writeEntry(shaderTable->rayGenerationShader);
-            
-            if (!shaderTable->missShaders.empty())
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = capacity * entrySize;
+            bufferDesc.isShaderBindingTable = true;
+            bufferDesc.initialState = ResourceStates::ShaderResource;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = shaderTable->desc.debugName;
+
+            // The command lists that used the previous buffer keep it alive until they finish executing
+            shaderTable->persistentBuffer = m_Device->createBuffer(bufferDesc);
+            shaderTable->markAllEntriesDirty();
+
+            if (!shaderTable->persistentBuffer)
             {
-                drd.MissShaderTable.StartAddress = gpuVA;
-                drd.MissShaderTable.StrideInBytes = (shaderTable->missShaders.size() == 1) ? 0 : entrySize;
-                drd.MissShaderTable.SizeInBytes = uint32_t(shaderTable->missShaders.size()) * entrySize;
+                m_Context.error("Failed to create the buffer for a persistent shader table");
+                return false;
+            }
+        }
+
+        shaderTable->persistentEntrySize = entrySize;
+        shaderTable->persistentHeapSRV = heapSRV;
+        shaderTable->persistentHeapSamplers = heapSamplers;
+
+        Buffer* buffer = checked_cast<Buffer*>(shaderTable->persistentBuffer.Get());
+        m_Instance->referencedResources.add(buffer);
+
+        // Merge the changed records into ranges, also rewriting small gaps between them to reduce the number of copies
+
+        std::vector<std::pair<uint32_t, uint32_t>> dirtyRanges; // [first, end)
+
+        if (shaderTable->allEntriesDirty)
+        {
+            dirtyRanges.emplace_back(0, numEntries);
+        }
+        else if (!shaderTable->dirtyEntries.empty())
+        {
+            constexpr uint32_t c_MaxMergedGap = 8;
+
+            std::vector<uint32_t>& dirtyEntries = shaderTable->dirtyEntries;
+            std::sort(dirtyEntries.begin(), dirtyEntries.end());
 
-                for (auto& entry : shaderTable->missShaders)
-                    writeEntry(entry);
+            for (uint32_t index : dirtyEntries)
+            {
+                // Records past the end may have been removed after they were changed
+                if (index >= numEntries)
+                    break;
+
+                if (!dirtyRanges.empty() && index <= dirtyRanges.back().second + c_MaxMergedGap)
+                    dirtyRanges.back().second = std::max(dirtyRanges.back().second, index + 1);
+                else
+                    dirtyRanges.emplace_back(index, index + 1);
             }
+        }
+
+        if (!dirtyRanges.empty())
+        {
+            requireBufferState(buffer, ResourceStates::CopyDest);
+            commitBarriers();
 
-            if (!shaderTable->hitGroups.empty())
+            for (const auto& [firstEntry, endEntry] : dirtyRanges)
             {
-                drd.HitGroupTable.StartAddress = gpuVA;
-                drd.HitGroupTable.StrideInBytes = (shaderTable->hitGroups.size() == 1) ? 0 : entrySize;
-                drd.HitGroupTable.SizeInBytes = uint32_t(shaderTable->hitGroups.size()) * entrySize;
+                const uint64_t rangeSize = uint64_t(endEntry - firstEntry) * entrySize;
+
+                ID3D12Resource* uploadBuffer = nullptr;
+                size_t uploadOffset = 0;
+                uint8_t* cpuVA = nullptr;
+                if (!m_UploadManager.suballocateBuffer(rangeSize, nullptr, &uploadBuffer, &uploadOffset, (void**)&cpuVA,
+                    nullptr, m_RecordingVersion, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT))
+                {
+                    m_Context.error("Couldn't suballocate an upload buffer");
+                    return false;
+                }
 
-                for (auto& entry : shaderTable->hitGroups)
-                    writeEntry(entry);
+                for (uint32_t index = firstEntry; index < endEntry; index++)
+                    writeShaderTableEntry(cpuVA + uint64_t(index - firstEntry) * entrySize, shaderTable->getEntry(index));
+
+                m_ActiveCommandList->commandList->CopyBufferRegion(buffer->resource, uint64_t(firstEntry) * entrySize,
+                    uploadBuffer, uploadOffset, rangeSize);
             }
 
-            if (!shaderTable->callableShaders.empty())
-            {
-                drd.CallableShaderTable.StartAddress = gpuVA;
-                drd.CallableShaderTable.StrideInBytes = (shaderTable->callableShaders.size() == 1) ? 0 : entrySize;
-                drd.CallableShaderTable.SizeInBytes = uint32_t(shaderTable->callableShaders.size()) * entrySize;
+            requireBufferState(buffer, ResourceStates::ShaderResource);
+        }
+
+        shaderTable->dirtyEntries.clear();
+        shaderTable->allEntriesDirty = false;
+
+        return true;
+    }
+
+    void CommandList::setRayTracingState(const rt::State& state)
+    {
+        ShaderTable* shaderTable = checked_cast<ShaderTable*>(state.shaderTable);
+        RayTracingPipeline* pso = shaderTable->pipeline;
+
+        ShaderTableState* shaderTableState = getShaderTableStateTracking(shaderTable);
+
+        if (shaderTable->desc.isPersistent)
+        {
+            if (!updatePersistentShaderTable(shaderTable))
+                return;
+
+            fillDispatchRaysTemplate(shaderTableState->dispatchRaysTemplate, shaderTable,
+                shaderTable->persistentBuffer->getGpuVirtualAddress(), shaderTable->persistentEntrySize);
+
+            m_Instance->referencedResources.add(shaderTable);
+        }
+        else if (shaderTableState->committedVersion != shaderTable->version ||
+            shaderTableState->descriptorHeapSRV != m_Resources.shaderResourceViewHeap.getShaderVisibleHeap() ||
+            shaderTableState->descriptorHeapSamplers != m_Resources.samplerHeap.getShaderVisibleHeap())
+        {
+            uint32_t entrySize = pso->getShaderTableEntrySize();
+            uint32_t numEntries = shaderTable->getNumEntries();
+            uint32_t sbtSize = numEntries * entrySize;
 
-                for (auto& entry : shaderTable->callableShaders)
-                    writeEntry(entry);
+            unsigned char* cpuVA;
+            D3D12_GPU_VIRTUAL_ADDRESS gpuVA;
+            if (!m_UploadManager.suballocateBuffer(sbtSize, nullptr, nullptr, nullptr, 
+                (void**)&cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT))
+            {
+                m_Context.error("Couldn't suballocate an upload buffer");
+                return;
             }
 
+            for (uint32_t index = 0; index < numEntries; index++)
+                writeShaderTableEntry(cpuVA + index * entrySize, shaderTable->getEntry(index));
+
+            fillDispatchRaysTemplate(shaderTableState->dispatchRaysTemplate, shaderTable, gpuVA, entrySize);
+
             shaderTableState->committedVersion = shaderTable->version;
             shaderTableState->descriptorHeapSRV = m_Resources.shaderResourceViewHeap.getShaderVisibleHeap();
             shaderTableState->descriptorHeapSamplers = m_Resources.samplerHeap.getShaderVisibleHeap();
 
             // AddRef the shaderTable only on the first use / build because build happens at least once per CL anyway
-            m_Instance->referencedResources.push_back(shaderTable);
+            m_Instance->referencedResources.add(shaderTable);
         }
 
         const bool updateRootSignature = !m_CurrentRayTracingStateValid || m_CurrentRayTracingState.shaderTable == nullptr ||
@@ -1651,8 +1923,9 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             m_ActiveCommandList->commandList4->SetPipelineState1(pso->pipelineState);
+            ++m_Stats.pipelineBinds;
 
-            m_Instance->referencedResources.push_back(pso);
+            m_Instance->referencedResources.add(pso);
         }
 
         setComputeBindings(state.bindings, bindingUpdateMask, nullptr, false, pso->globalRootSignature);
@@ -1662,6 +1935,7 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = false;
         m_CurrentGraphicsStateValid = false;
         m_CurrentRayTracingStateValid = true;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentRayTracingState = state;
 
         commitBarriers();
@@ -1685,34 +1959,14 @@ namespace nvrhi::d3d12
         desc.Depth = args.depth;
 
         m_ActiveCommandList->commandList4->DispatchRays(&desc);
+        ++m_Stats.dispatches;
     }
 
-    void CommandList::buildOpacityMicromap([[maybe_unused]] rt::IOpacityMicromap* pOmm, [[maybe_unused]] const rt::OpacityMicromapDesc& desc)
+    bool CommandList::getOpacityMicromapScratchSize([[maybe_unused]] const rt::OpacityMicromapDesc& desc, uint64_t& scratchSize)
     {
-#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP || NVRHI_WITH_NVAPI_OPACITY_MICROMAP
-        OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pOmm);
-
-        if (m_EnableAutomaticBarriers)
-        {
-            requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
-            requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
-
-            requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapWrite);
-        }
-
-        if (desc.trackLiveness)
-        {
-            m_Instance->referencedResources.push_back(desc.inputBuffer);
-            m_Instance->referencedResources.push_back(desc.perOmmDescs);
-            m_Instance->referencedResources.push_back(omm->dataBuffer);
-        }
-
-        commitBarriers();
-#endif
+        scratchSize = 0;
 
 #if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
-
-        // Gather prebuild info to get scratch buffer requirements
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS ommInputs = {};
         D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC ommArrayDesc = {};
         fillD3dOpacityMicromapDesc(ommInputs, ommArrayDesc, desc);
@@ -1720,30 +1974,10 @@ namespace nvrhi::d3d12
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ommPreBuildInfo;
         m_Context.device8.Get()->GetRaytracingAccelerationStructurePrebuildInfo(&ommInputs, &ommPreBuildInfo);
 
-        // Allocate scratch buffer
-        D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
-        if (ommPreBuildInfo.ScratchDataSizeInBytes > 0)
-        {
-            if (!m_DxrScratchManager.suballocateBuffer(ommPreBuildInfo.ScratchDataSizeInBytes, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
-                &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
-            {
-                std::stringstream ss;
-                ss << "Couldn't suballocate a scratch buffer for VM " << utils::DebugNameToString(omm->desc.debugName) << " build. "
-                    "The build requires " << ommPreBuildInfo.ScratchDataSizeInBytes << " bytes of scratch space.";
-
-                m_Context.error(ss.str());
-                return;
-            }
-        }
-
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC asDesc;
-        asDesc.Inputs = ommInputs;
-        asDesc.ScratchAccelerationStructureData = scratchGpuVA;
-        asDesc.DestAccelerationStructureData = omm->getDeviceAddress();
-        m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&asDesc, 0, nullptr); // No immediate post-build info supported.
+        scratchSize = ommPreBuildInfo.ScratchDataSizeInBytes;
+        return true;
 
 #elif NVRHI_WITH_NVAPI_OPACITY_MICROMAP
-
         NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_INPUTS inputs = {};
         fillD3dOpacityMicromapDesc(inputs, desc);
 
@@ -1756,51 +1990,232 @@ namespace nvrhi::d3d12
         NvAPI_Status status = NvAPI_D3D12_GetRaytracingOpacityMicromapArrayPrebuildInfo(m_Context.device5.Get(), &prebuildParams);
         assert(status == S_OK);
         if (status != S_OK)
-            return;
-
-        D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
-        if (vmPreBuildInfo.scratchDataSizeInBytes != 0)
-        {
-            if (!m_DxrScratchManager.suballocateBuffer(vmPreBuildInfo.scratchDataSizeInBytes, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
-                &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
-            {
-                std::stringstream ss;
-                ss << "Couldn't suballocate a scratch buffer for VM " << utils::DebugNameToString(omm->desc.debugName) << " build. "
-                    "The build requires " << vmPreBuildInfo.scratchDataSizeInBytes << " bytes of scratch space.";
-
-                m_Context.error(ss.str());
-                return;
-            }
-        }
-
-        NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC nativeDesc = {};
-        nativeDesc.destOpacityMicromapArrayData = omm->getDeviceAddress();
-        nativeDesc.inputs = inputs;
-        nativeDesc.scratchOpacityMicromapArrayData = scratchGpuVA;
+            return false;
 
-        NVAPI_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_PARAMS params;
-        params.version = NVAPI_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_PARAMS_VER;
-        params.pDesc = &nativeDesc;
-        params.numPostbuildInfoDescs = 0;
-        params.pPostbuildInfoDescs = nullptr;
+        scratchSize = vmPreBuildInfo.scratchDataSizeInBytes;
+        return true;
 
-        status = NvAPI_D3D12_BuildRaytracingOpacityMicromapArray(m_ActiveCommandList->commandList4, &params);
-        assert(status == S_OK);
 #else
-        utils::NotSupported();
+        return false;
 #endif
     }
 
-    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandList::recordOpacityMicromapBuild([[maybe_unused]] OpacityMicromap* omm, [[maybe_unused]] const rt::OpacityMicromapDesc& desc,
+        [[maybe_unused]] D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA)
     {
-        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
 
-        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
-        if (performUpdate)
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS ommInputs = {};
+        D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC ommArrayDesc = {};
+        fillD3dOpacityMicromapDesc(ommInputs, ommArrayDesc, desc);
+
+        // Compactable OMM arrays report their compacted size from the build itself, like BLASes.
+        // If no slot is available, the build is still recorded, and the OMM array just stays uncompacted.
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfo = {};
+        UINT numPostbuildInfoDescs = 0;
+#ifndef NVRHI_WITH_RTXMU
+        if ((desc.flags & rt::OpacityMicromapBuildFlags::AllowCompaction) != 0 && !omm->compacted)
         {
-            assert(as->allowUpdate);
+            PendingCompactedSize pending;
+            postbuildInfo.DestBuffer = m_Resources.blasCompaction.allocateSlot(pending.slot);
+            postbuildInfo.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+
+            if (postbuildInfo.DestBuffer != 0)
+            {
+                numPostbuildInfoDescs = 1;
+                pending.opacityMicromap = omm;
+                m_Instance->pendingCompactedSizes.push_back(std::move(pending));
+            }
+        }
+#endif
+
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC asDesc = {};
+        asDesc.Inputs = ommInputs;
+        asDesc.ScratchAccelerationStructureData = scratchGpuVA;
+        asDesc.DestAccelerationStructureData = omm->getDeviceAddress();
+        m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&asDesc,
+            numPostbuildInfoDescs, numPostbuildInfoDescs ? &postbuildInfo : nullptr);
+
+#elif NVRHI_WITH_NVAPI_OPACITY_MICROMAP
+
+        NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_INPUTS inputs = {};
+        fillD3dOpacityMicromapDesc(inputs, desc);
+
+        NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC nativeDesc = {};
+        nativeDesc.destOpacityMicromapArrayData = omm->getDeviceAddress();
+        nativeDesc.inputs = inputs;
+        nativeDesc.scratchOpacityMicromapArrayData = scratchGpuVA;
+
+        NVAPI_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_PARAMS params;
+        params.version = NVAPI_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_PARAMS_VER;
+        params.pDesc = &nativeDesc;
+        params.numPostbuildInfoDescs = 0;
+        params.pPostbuildInfoDescs = nullptr;
+
+        [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingOpacityMicromapArray(m_ActiveCommandList->commandList4, &params);
+        assert(status == S_OK);
+#endif
+    }
+
+    void CommandList::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc)
+    {
+        const rt::OpacityMicromapBuildDesc build = rt::OpacityMicromapBuildDesc()
+            .setOpacityMicromap(omm)
+            .setDesc(&desc);
+
+        buildOpacityMicromaps(&build, 1);
+    }
+
+    void CommandList::buildOpacityMicromaps([[maybe_unused]] const rt::OpacityMicromapBuildDesc* pBuilds, [[maybe_unused]] size_t numBuilds)
+    {
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP || NVRHI_WITH_NVAPI_OPACITY_MICROMAP
+        if (numBuilds == 0)
+            return;
+
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
+        // Pack the scratch regions of all builds into one allocation
+
+        std::vector<uint64_t> scratchOffsets(numBuilds);
+        uint64_t totalScratchSize = 0;
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            uint64_t scratchSize = 0;
+            if (!getOpacityMicromapScratchSize(*pBuilds[i].desc, scratchSize))
+                return;
+
+            scratchOffsets[i] = totalScratchSize;
+            totalScratchSize += align(scratchSize, uint64_t(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT));
+        }
+
+        // Transition the inputs and outputs of all builds with one barrier batch
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::OpacityMicromapDesc& desc = *pBuilds[i].desc;
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pBuilds[i].opacityMicromap);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
+                requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
+
+                requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapWrite);
+            }
+
+            if (desc.trackLiveness)
+            {
+                m_Instance->referencedResources.add(desc.inputBuffer);
+                m_Instance->referencedResources.add(desc.perOmmDescs);
+                m_Instance->referencedResources.add(omm->dataBuffer);
+            }
         }
+        commitBarriers();
+
+        D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
+        const bool sharedScratch = totalScratchSize == 0 || m_DxrScratchManager.suballocateBuffer(totalScratchSize, m_ActiveCommandList->commandList,
+            nullptr, nullptr, nullptr, &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+
+        if (sharedScratch)
+            m_Resources.accelStructStats.buildScratchUsed(totalScratchSize);
+
+        // The builds write to different memory, so they are recorded back-to-back without UAV barriers between them.
+        // The barriers before the OMM arrays are used are placed when they transition to AccelStructBuildInput.
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::OpacityMicromapDesc& desc = *pBuilds[i].desc;
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pBuilds[i].opacityMicromap);
+
+            D3D12_GPU_VIRTUAL_ADDRESS buildScratchGpuVA = scratchGpuVA + scratchOffsets[i];
+            const uint64_t scratchSize = ((i + 1 < numBuilds) ? scratchOffsets[i + 1] : totalScratchSize) - scratchOffsets[i];
+
+            if (!sharedScratch && scratchSize != 0)
+            {
+                // The whole batch doesn't fit into the scratch memory limit, fall back to allocating scratch for each build.
+                // The scratch manager places a UAV barrier when it has to reuse a chunk.
+                if (!m_DxrScratchManager.suballocateBuffer(scratchSize, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
+                    &buildScratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
+                {
+                    std::stringstream ss;
+                    ss << "Couldn't suballocate a scratch buffer for OMM " << utils::DebugNameToString(omm->desc.debugName) << " build. "
+                        "The build requires " << scratchSize << " bytes of scratch space.";
+
+                    m_Context.error(ss.str());
+                    return;
+                }
+
+                m_Resources.accelStructStats.buildScratchUsed(scratchSize);
+            }
+
+            recordOpacityMicromapBuild(omm, desc, scratchSize != 0 ? buildScratchGpuVA : 0);
+        }
+#else
+        utils::NotSupported();
+#endif
+    }
+
+    void CommandList::compactOpacityMicromaps()
+    {
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP && !defined(NVRHI_WITH_RTXMU)
+        std::vector<rt::OpacityMicromapHandle> candidates;
+        m_Resources.blasCompaction.takeOpacityMicromapCandidates(candidates);
+
+        if (candidates.empty())
+            return;
+
+        // Allocate the compacted buffers and transition all of them with one barrier batch.
+        // The builds that wrote the compacted sizes have finished executing, so the original arrays need no barriers.
+        // Each compacted array is still a separate placed buffer of at least 64 KB.
+
+        std::vector<BufferHandle> compactedBuffers(candidates.size());
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(candidates[i].Get());
+
+            BufferDesc bufferDesc = omm->dataBuffer->desc;
+            bufferDesc.byteSize = omm->compactedSize;
+            compactedBuffers[i] = m_Device->createBuffer(bufferDesc);
+
+            if (!compactedBuffers[i])
+                continue;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(omm->dataBuffer, ResourceStates::OpacityMicromapWrite);
+                requireBufferState(compactedBuffers[i], ResourceStates::OpacityMicromapWrite);
+            }
+        }
+        commitBarriers();
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (!compactedBuffers[i])
+                continue;
+
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(candidates[i].Get());
+            Buffer* compactedBuffer = checked_cast<Buffer*>(compactedBuffers[i].Get());
+
+            m_ActiveCommandList->commandList4->CopyRaytracingAccelerationStructure(compactedBuffer->gpuVA, omm->dataBuffer->gpuVA,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+            // The original buffer is released when this command list finishes executing, which returns its memory to the allocator
+            m_Instance->referencedResources.add(omm->dataBuffer);
+
+            omm->dataBuffer = compactedBuffer;
+            omm->compacted = true;
+            omm->statsEntry.setCompacted(compactedBuffer->desc.byteSize);
 
+            if (omm->desc.trackLiveness)
+                m_Instance->referencedResources.add(omm);
+        }
+#endif
+    }
+
+    void CommandList::setBlasBuildInputStates(const rt::GeometryDesc* pGeometries, size_t numGeometries)
+    {
         for (uint32_t i = 0; i < numGeometries; i++)
         {
             const auto& geometryDesc = pGeometries[i];
@@ -1820,12 +2235,12 @@ namespace nvrhi::d3d12
                         requireBufferState(triangles.ommIndexBuffer, ResourceStates::AccelStructBuildInput);
                 }
 
-                m_Instance->referencedResources.push_back(triangles.indexBuffer);
-                m_Instance->referencedResources.push_back(triangles.vertexBuffer);
+                m_Instance->referencedResources.add(triangles.indexBuffer);
+                m_Instance->referencedResources.add(triangles.vertexBuffer);
                 if (om && om->desc.trackLiveness)
-                    m_Instance->referencedResources.push_back(om);
+                    m_Instance->referencedResources.add(om);
                 if (triangles.ommIndexBuffer)
-                    m_Instance->referencedResources.push_back(triangles.ommIndexBuffer);
+                    m_Instance->referencedResources.add(triangles.ommIndexBuffer);
             }
             else if (geometryDesc.geometryType == rt::GeometryType::AABBs)
             {
@@ -1836,7 +2251,7 @@ namespace nvrhi::d3d12
                     requireBufferState(aabbs.buffer, ResourceStates::AccelStructBuildInput);
                 }
 
-                m_Instance->referencedResources.push_back(aabbs.buffer);
+                m_Instance->referencedResources.add(aabbs.buffer);
             }
 #if NVRHI_WITH_NVAPI_LSS
             else if (geometryDesc.geometryType == rt::GeometryType::Spheres)
@@ -1852,8 +2267,8 @@ namespace nvrhi::d3d12
                     requireBufferState(spheres.vertexBuffer, ResourceStates::AccelStructBuildInput);
                 }
 
-                m_Instance->referencedResources.push_back(spheres.indexBuffer);
-                m_Instance->referencedResources.push_back(spheres.vertexBuffer);
+                m_Instance->referencedResources.add(spheres.indexBuffer);
+                m_Instance->referencedResources.add(spheres.vertexBuffer);
             }
             else if (geometryDesc.geometryType == rt::GeometryType::Lss)
             {
@@ -1868,15 +2283,16 @@ namespace nvrhi::d3d12
                     requireBufferState(lss.vertexBuffer, ResourceStates::AccelStructBuildInput);
                 }
 
-                m_Instance->referencedResources.push_back(lss.indexBuffer);
-                m_Instance->referencedResources.push_back(lss.vertexBuffer);
+                m_Instance->referencedResources.add(lss.indexBuffer);
+                m_Instance->referencedResources.add(lss.vertexBuffer);
             }
 #endif
         }
+    }
 
-        commitBarriers();
-
-        D3D12BuildRaytracingAccelerationStructureInputs inputs;
+    bool CommandList::fillBlasBuildInputs(D3D12BuildRaytracingAccelerationStructureInputs& inputs, AccelStruct* as,
+        const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
         inputs.SetType(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL);
         if (as->allowUpdate)
             inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)buildFlags | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE);
@@ -1897,7 +2313,7 @@ namespace nvrhi::d3d12
                     &cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_TRANSFORM3X4_BYTE_ALIGNMENT))
                 {
                     m_Context.error("Couldn't suballocate an upload buffer");
-                    return;
+                    return false;
                 }
 
                 memcpy(cpuVA, &geometryDesc.transform, sizeof(rt::AffineTransform));
@@ -1924,6 +2340,110 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        return true;
+    }
+
+#ifndef NVRHI_WITH_RTXMU
+    bool CommandList::getBlasScratchSize(AccelStruct* as, bool performUpdate, uint64_t& scratchSize)
+    {
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ASPreBuildInfo = {};
+
+        if (!checked_cast<d3d12::Device*>(m_Device)->GetAccelStructPreBuildInfo(ASPreBuildInfo, as->getDesc()))
+            return false;
+
+        if (ASPreBuildInfo.ResultDataMaxSizeInBytes > as->dataBuffer->desc.byteSize)
+        {
+            std::stringstream ss;
+            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
+                << ASPreBuildInfo.ResultDataMaxSizeInBytes << " bytes in the data buffer, while the allocated buffer is only "
+                << as->dataBuffer->desc.byteSize << " bytes";
+
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        scratchSize = performUpdate
+            ? ASPreBuildInfo.UpdateScratchDataSizeInBytes
+            : ASPreBuildInfo.ScratchDataSizeInBytes;
+
+        return true;
+    }
+
+    void CommandList::recordBlasBuild(D3D12BuildRaytracingAccelerationStructureInputs& inputs, AccelStruct* as,
+        D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA, rt::AccelStructBuildFlags buildFlags)
+    {
+        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+
+        // Compactable BLASes report their compacted size from the build itself. If no slot is available,
+        // the build is still recorded, and the BLAS just stays uncompacted. Virtual BLASes are not compacted
+        // because their memory is managed by the application.
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfo = {};
+        UINT numPostbuildInfoDescs = 0;
+        if ((buildFlags & rt::AccelStructBuildFlags::AllowCompaction) != 0 && !performUpdate && !as->compacted && !as->desc.isVirtual)
+        {
+            int slot = -1;
+            postbuildInfo.DestBuffer = m_Resources.blasCompaction.allocateSlot(slot);
+            postbuildInfo.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+
+            if (postbuildInfo.DestBuffer != 0)
+            {
+                numPostbuildInfoDescs = 1;
+                m_Instance->pendingCompactedSizes.push_back(PendingCompactedSize{ as, slot });
+            }
+        }
+
+#if NVRHI_WITH_NVAPI_OPACITY_MICROMAP || NVRHI_WITH_NVAPI_LSS
+        d3d12::Device* d3d12Device = checked_cast<d3d12::Device*>(m_Device);
+        if (d3d12Device->GetOpacityMicromapSupported() || d3d12Device->GetLinearSweptSpheresSupported())
+        {
+            NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC_EX buildDesc = {};
+            buildDesc.inputs = inputs.GetAs<NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS_EX>();
+            buildDesc.scratchAccelerationStructureData = scratchGpuVA;
+            buildDesc.destAccelerationStructureData = as->dataBuffer->gpuVA;
+            buildDesc.sourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
+
+            NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS params = {};
+            params.version = NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS_VER;
+            params.pDesc = &buildDesc;
+            params.numPostbuildInfoDescs = numPostbuildInfoDescs;
+            params.pPostbuildInfoDescs = numPostbuildInfoDescs ? &postbuildInfo : nullptr;
+            [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingAccelerationStructureEx(m_ActiveCommandList->commandList4, &params);
+            assert(status == S_OK);
+        }
+        else
+#endif
+        {
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+            buildDesc.Inputs = inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>();
+            buildDesc.ScratchAccelerationStructureData = scratchGpuVA;
+            buildDesc.DestAccelerationStructureData = as->dataBuffer->gpuVA;
+            buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
+            m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc,
+                numPostbuildInfoDescs, numPostbuildInfoDescs ? &postbuildInfo : nullptr);
+        }
+    }
+#endif // !NVRHI_WITH_RTXMU
+
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
+        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+        if (performUpdate)
+        {
+            assert(as->allowUpdate);
+        }
+
+        setBlasBuildInputStates(pGeometries, numGeometries);
+
+        commitBarriers();
+
+        D3D12BuildRaytracingAccelerationStructureInputs inputs;
+        if (!fillBlasBuildInputs(inputs, as, pGeometries, numGeometries, buildFlags))
+            return;
+
 #ifdef NVRHI_WITH_RTXMU
         std::vector<uint64_t> accelStructsToBuild;
         std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> buildInputs;
@@ -1953,26 +2473,10 @@ namespace nvrhi::d3d12
                                                             buildsToUpdate);
         }
 #else
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ASPreBuildInfo = {};
-
-        if (!checked_cast<d3d12::Device*>(m_Device)->GetAccelStructPreBuildInfo(ASPreBuildInfo, as->getDesc()))
+        uint64_t scratchSize = 0;
+        if (!getBlasScratchSize(as, performUpdate, scratchSize))
             return;
 
-        if (ASPreBuildInfo.ResultDataMaxSizeInBytes > as->dataBuffer->desc.byteSize)
-        {
-            std::stringstream ss;
-            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
-                << ASPreBuildInfo.ResultDataMaxSizeInBytes << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->desc.byteSize << " bytes";
-
-            m_Context.error(ss.str());
-            return;
-        }
-
-        uint64_t scratchSize = performUpdate
-            ? ASPreBuildInfo.UpdateScratchDataSizeInBytes
-            : ASPreBuildInfo.ScratchDataSizeInBytes;
-
         D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
         if (!m_DxrScratchManager.suballocateBuffer(scratchSize, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
             &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
@@ -1985,44 +2489,122 @@ namespace nvrhi::d3d12
             return;
         }
 
+        m_Resources.accelStructStats.buildScratchUsed(scratchSize);
+
         if (m_EnableAutomaticBarriers)
         {
             requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
         }
         commitBarriers();
 
-#if NVRHI_WITH_NVAPI_OPACITY_MICROMAP || NVRHI_WITH_NVAPI_LSS
-        d3d12::Device* d3d12Device = checked_cast<d3d12::Device*>(m_Device);
-        if (d3d12Device->GetOpacityMicromapSupported() || d3d12Device->GetLinearSweptSpheresSupported())
+        recordBlasBuild(inputs, as, scratchGpuVA, buildFlags);
+#endif // NVRHI_WITH_RTXMU
+
+        if (as->desc.trackLiveness)
+            m_Instance->referencedResources.add(as);
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
+#ifdef NVRHI_WITH_RTXMU
+        // RTXMU manages the scratch memory and the barriers itself
+        for (size_t i = 0; i < numBuilds; i++)
         {
-            NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC_EX buildDesc = {};
-            buildDesc.inputs = inputs.GetAs<NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS_EX>();
-            buildDesc.scratchAccelerationStructureData = scratchGpuVA;
-            buildDesc.destAccelerationStructureData = as->dataBuffer->gpuVA;
-            buildDesc.sourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
+            const rt::BlasBuildDesc& build = pBuilds[i];
+            buildBottomLevelAccelStruct(build.accelStruct, build.pGeometries, build.numGeometries, build.buildFlags);
+        }
+#else
+        if (numBuilds == 0)
+            return;
 
-            NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS params = {};
-            params.version = NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS_VER;
-            params.pDesc = &buildDesc;
-            params.numPostbuildInfoDescs = 0;
-            params.pPostbuildInfoDescs = nullptr;
-            [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingAccelerationStructureEx(m_ActiveCommandList->commandList4, &params);
-            assert(status == S_OK);
+        // Validate all builds and pack their scratch regions into one allocation
+
+        std::vector<uint64_t> scratchOffsets(numBuilds);
+        uint64_t totalScratchSize = 0;
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& build = pBuilds[i];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+
+            const bool performUpdate = (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+            if (performUpdate)
+            {
+                assert(as->allowUpdate);
+            }
+
+            uint64_t scratchSize = 0;
+            if (!getBlasScratchSize(as, performUpdate, scratchSize))
+                return;
+
+            scratchOffsets[i] = totalScratchSize;
+            totalScratchSize += align(scratchSize, uint64_t(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT));
         }
-        else
-#endif
+
+        // Transition the inputs and outputs of all builds with one barrier batch
+
+        for (size_t i = 0; i < numBuilds; i++)
         {
-            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
-            buildDesc.Inputs = inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>();
-            buildDesc.ScratchAccelerationStructureData = scratchGpuVA;
-            buildDesc.DestAccelerationStructureData = as->dataBuffer->gpuVA;
-            buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
-            m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+            const rt::BlasBuildDesc& build = pBuilds[i];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+
+            setBlasBuildInputStates(build.pGeometries, build.numGeometries);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            }
         }
-#endif // NVRHI_WITH_RTXMU
+        commitBarriers();
 
-        if (as->desc.trackLiveness)
-            m_Instance->referencedResources.push_back(as);
+        D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
+        const bool sharedScratch = m_DxrScratchManager.suballocateBuffer(totalScratchSize, m_ActiveCommandList->commandList,
+            nullptr, nullptr, nullptr, &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+
+        if (sharedScratch)
+            m_Resources.accelStructStats.buildScratchUsed(totalScratchSize);
+
+        // The builds write to different memory, so they are recorded back-to-back without UAV barriers between them.
+        // The barriers before the BLASes are used are placed when they transition to AccelStructRead.
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& build = pBuilds[i];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+
+            D3D12_GPU_VIRTUAL_ADDRESS buildScratchGpuVA = scratchGpuVA + scratchOffsets[i];
+            if (!sharedScratch)
+            {
+                // The whole batch doesn't fit into the scratch memory limit, fall back to allocating scratch for each build.
+                // The scratch manager places a UAV barrier when it has to reuse a chunk.
+                const uint64_t scratchSize = ((i + 1 < numBuilds) ? scratchOffsets[i + 1] : totalScratchSize) - scratchOffsets[i];
+
+                if (!m_DxrScratchManager.suballocateBuffer(scratchSize, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
+                    &buildScratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
+                {
+                    std::stringstream ss;
+                    ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
+                        "The build requires " << scratchSize << " bytes of scratch space.";
+
+                    m_Context.error(ss.str());
+                    return;
+                }
+
+                m_Resources.accelStructStats.buildScratchUsed(scratchSize);
+            }
+
+            D3D12BuildRaytracingAccelerationStructureInputs inputs;
+            if (!fillBlasBuildInputs(inputs, as, build.pGeometries, build.numGeometries, build.buildFlags))
+                return;
+
+            recordBlasBuild(inputs, as, buildScratchGpuVA, build.buildFlags);
+
+            if (as->desc.trackLiveness)
+                m_Instance->referencedResources.add(as);
+        }
+#endif // NVRHI_WITH_RTXMU
     }
 
     void CommandList::compactBottomLevelAccelStructs()
@@ -2042,11 +2624,215 @@ namespace nvrhi::d3d12
                 m_Resources.asBuildsCompleted.clear();
             }
         }
+#else
+        std::vector<rt::AccelStructHandle> candidates;
+        m_Resources.blasCompaction.takeCandidates(candidates);
+
+        if (candidates.empty())
+            return;
+
+        // Allocate the compacted buffers and transition all of them with one barrier batch.
+        // The compacted buffers keep the allocation mode of the originals, and each still takes at least 64 KB.
+
+        std::vector<BufferHandle> compactedBuffers(candidates.size());
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            AccelStruct* as = checked_cast<AccelStruct*>(candidates[i].Get());
+
+            BufferDesc bufferDesc = as->dataBuffer->desc;
+            bufferDesc.byteSize = as->compactedSize;
+            compactedBuffers[i] = m_Device->createBuffer(bufferDesc);
+
+            if (!compactedBuffers[i])
+                continue;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(as->dataBuffer, ResourceStates::AccelStructBuildBlas);
+                requireBufferState(compactedBuffers[i], ResourceStates::AccelStructWrite);
+            }
+        }
+        commitBarriers();
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (!compactedBuffers[i])
+                continue;
+
+            AccelStruct* as = checked_cast<AccelStruct*>(candidates[i].Get());
+            Buffer* compactedBuffer = checked_cast<Buffer*>(compactedBuffers[i].Get());
+
+            m_ActiveCommandList->commandList4->CopyRaytracingAccelerationStructure(compactedBuffer->gpuVA, as->dataBuffer->gpuVA,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+            // The original buffer is released when this command list finishes executing, which returns its memory to the allocator
+            m_Instance->referencedResources.add(as->dataBuffer);
+
+            as->dataBuffer = compactedBuffer;
+            as->compacted = true;
+            as->statsEntry.setCompacted(compactedBuffer->desc.byteSize);
+
+            if (as->desc.trackLiveness)
+                m_Instance->referencedResources.add(as);
+        }
 #endif
     }
 
+#ifndef NVRHI_WITH_RTXMU
+    BlasCompactionManager::~BlasCompactionManager()
+    {
+        if (m_SizeBuffer)
+            m_SizeBuffer->Unmap(0, nullptr);
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS BlasCompactionManager::allocateSlot(int& outSlot)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_CreationFailed)
+            return 0;
+
+        if (!m_SizeBuffer)
+        {
+            // The builds write the sizes as UAVs, so the buffer needs a CPU-readable custom heap instead of a readback heap
+            D3D12_HEAP_PROPERTIES heapProps = {};
+            heapProps.Type = D3D12_HEAP_TYPE_CUSTOM;
+            heapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
+            heapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
+
+            D3D12_RESOURCE_DESC resourceDesc = {};
+            resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+            resourceDesc.Width = sizeof(uint64_t) * c_MaxPendingSizes;
+            resourceDesc.Height = 1;
+            resourceDesc.DepthOrArraySize = 1;
+            resourceDesc.MipLevels = 1;
+            resourceDesc.SampleDesc.Count = 1;
+            resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+            resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+            HRESULT res = m_Context.device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&m_SizeBuffer));
+
+            void* mappedData = nullptr;
+            if (SUCCEEDED(res))
+                res = m_SizeBuffer->Map(0, nullptr, &mappedData);
+
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "Failed to create the BLAS compacted size buffer, HRESULT = 0x" << std::hex << std::setw(8) << res
+                    << ". BLASes will not be compacted.";
+                m_Context.error(ss.str());
+
+                m_SizeBuffer = nullptr;
+                m_CreationFailed = true;
+                return 0;
+            }
+
+            m_SizeData = static_cast<const uint64_t*>(mappedData);
+        }
+
+        outSlot = m_Slots.allocate();
+        if (outSlot < 0)
+            return 0;
+
+        return m_SizeBuffer->GetGPUVirtualAddress() + sizeof(uint64_t) * outSlot;
+    }
+
+    void BlasCompactionManager::buildsDiscarded(std::vector<PendingCompactedSize>& builds)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const PendingCompactedSize& build : builds)
+        {
+            m_Slots.release(build.slot);
+        }
+
+        builds.clear();
+    }
+
+    void BlasCompactionManager::buildsCompleted(std::vector<PendingCompactedSize>& builds)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (PendingCompactedSize& build : builds)
+        {
+            const uint64_t compactedSize = m_SizeData[build.slot];
+            m_Slots.release(build.slot);
+
+            if (build.opacityMicromap)
+            {
+                OpacityMicromap* omm = checked_cast<OpacityMicromap*>(build.opacityMicromap.Get());
+                omm->compactedSize = compactedSize;
+
+                if (!omm->compacted && compactedSize != 0 && compactedSize < omm->dataBuffer->desc.byteSize)
+                    m_OpacityMicromapCandidates.push_back(std::move(build.opacityMicromap));
+
+                continue;
+            }
+
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct.Get());
+            as->compactedSize = compactedSize;
+
+            if (!as->compacted && compactedSize != 0 && compactedSize < as->dataBuffer->desc.byteSize)
+                m_Candidates.push_back(std::move(build.accelStruct));
+        }
+
+        builds.clear();
+    }
+
+    template<typename TObject, typename THandle>
+    static void takeCompactionCandidates(std::deque<THandle>& queue, uint64_t budget, std::vector<THandle>& outCandidates)
+    {
+        uint64_t totalSize = 0;
+        while (!queue.empty())
+        {
+            TObject* object = checked_cast<TObject*>(queue.front().Get());
+            totalSize += object->dataBuffer->desc.byteSize;
+
+            // Always take at least one object, so that those larger than the budget are still compacted
+            if (budget != 0 && totalSize > budget && !outCandidates.empty())
+                break;
+
+            outCandidates.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+    }
+
+    size_t BlasCompactionManager::getNumPendingCompactions()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Candidates.size() + m_OpacityMicromapCandidates.size();
+    }
+
+    void BlasCompactionManager::takeCandidates(std::vector<rt::AccelStructHandle>& outCandidates)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        takeCompactionCandidates<AccelStruct>(m_Candidates, m_Budget, outCandidates);
+    }
+
+    void BlasCompactionManager::takeOpacityMicromapCandidates(std::vector<rt::OpacityMicromapHandle>& outCandidates)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        takeCompactionCandidates<OpacityMicromap>(m_OpacityMicromapCandidates, m_Budget, outCandidates);
+    }
+#endif // !NVRHI_WITH_RTXMU
+
+    ScopedAccelStructBuildTimer CommandList::timeAccelStructBuild()
+    {
+        // Reusable command lists can be executed many times, their builds are not timed
+        return ScopedAccelStructBuildTimer(m_Resources.accelStructStats, m_Device, this,
+            m_Desc.isReusable ? nullptr : &m_Instance->accelStructTimerQueries, m_AccelStructBuildTimingActive);
+    }
+
     void CommandList::buildTopLevelAccelStructInternal(AccelStruct* as, D3D12_GPU_VIRTUAL_ADDRESS instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
         // Remove the internal flag
         buildFlags = buildFlags & ~rt::AccelStructBuildFlags::AllowEmptyInstances;
 
@@ -2055,7 +2841,7 @@ namespace nvrhi::d3d12
         if (performUpdate)
         {
             assert(as->allowUpdate);
-            assert(as->dxrInstances.size() == numInstances); // DXR doesn't allow updating to a different instance count
+            assert(as->numBuiltInstances == numInstances); // DXR doesn't allow updating to a different instance count
         }
 
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS ASInputs;
@@ -2097,6 +2883,8 @@ namespace nvrhi::d3d12
             return;
         }
 
+        m_Resources.accelStructStats.buildScratchUsed(scratchSize);
+
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
         buildDesc.Inputs = ASInputs;
         buildDesc.ScratchAccelerationStructureData = scratchGpuVA;
@@ -2106,66 +2894,110 @@ namespace nvrhi::d3d12
         m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
     }
 
+    // Identifies each instance conversion in buildTopLevelAccelStruct, see AccelStruct::lastInstanceConversion
+    static std::atomic<uint64_t> g_InstanceConversionCounter = 0;
+
+    // Number of instances converted by one task, 64 KB of instance data
+    static constexpr size_t c_InstanceConversionChunkSize = 1024;
+
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
         
         as->bottomLevelASes.clear();
+        as->numBuiltInstances = numInstances;
+
+        // Write the instances directly to the upload buffer. Every instance is written with one 64-byte copy
+        // of a fully initialized local struct, which is efficient for write-combined memory.
+        D3D12_RAYTRACING_INSTANCE_DESC* cpuVA = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
+        size_t uploadSize = sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * numInstances;
+        if (!m_UploadManager.suballocateBuffer(uploadSize, nullptr, nullptr, nullptr, (void**)&cpuVA, &gpuVA,
+            m_RecordingVersion, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return;
+        }
 
-        // Keep the dxrInstances array in the AS object to avoid reallocating it on the next update
-        as->dxrInstances.resize(numInstances);
+        const uint64_t conversionId = ++g_InstanceConversionCounter;
+        std::vector<AccelStruct*> uniqueBottomLevelASes;
+        std::mutex uniqueBottomLevelASesMutex;
 
-        // Construct the instance array in a local vector first and then copy it over
-        // because doing it in GPU memory over PCIe is much slower.
-        for (uint32_t i = 0; i < numInstances; i++)
+#ifdef NVRHI_WITH_RTXMU
+        // RTXMU lookups are not thread-safe
+        IParallelTaskRunner* parallelTaskRunner = nullptr;
+#else
+        IParallelTaskRunner* parallelTaskRunner = m_Context.parallelTaskRunner;
+#endif
+
+        parallelFor(parallelTaskRunner, numInstances, c_InstanceConversionChunkSize, [&](size_t begin, size_t end)
         {
-            const rt::InstanceDesc& instance = pInstances[i];
-            D3D12_RAYTRACING_INSTANCE_DESC& dxrInstance = as->dxrInstances[i];
+            std::vector<AccelStruct*> newBottomLevelASes;
+            AccelStruct* previousBlas = nullptr;
 
-            if (instance.bottomLevelAS)
+            for (size_t i = begin; i < end; i++)
             {
-                AccelStruct* blas = checked_cast<AccelStruct*>(instance.bottomLevelAS);
-
-                if (blas->desc.trackLiveness)
-                    as->bottomLevelASes.push_back(blas);
+                const rt::InstanceDesc& instance = pInstances[i];
 
+                D3D12_RAYTRACING_INSTANCE_DESC dxrInstance;
                 static_assert(sizeof(dxrInstance) == sizeof(instance));
                 memcpy(&dxrInstance, &instance, sizeof(instance));
 
+                if (instance.bottomLevelAS)
+                {
+                    AccelStruct* blas = checked_cast<AccelStruct*>(instance.bottomLevelAS);
+
 #ifdef NVRHI_WITH_RTXMU
-                dxrInstance.AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
+                    dxrInstance.AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
 #else
-                dxrInstance.AccelerationStructure = blas->dataBuffer->gpuVA;
+                    dxrInstance.AccelerationStructure = blas->dataBuffer->gpuVA;
+#endif
 
-                if (m_EnableAutomaticBarriers)
+                    // Collect every BLAS once, without hashing: consecutive instances often use the same BLAS,
+                    // and the others are marked with the conversion ID. Checking before the exchange keeps
+                    // the cache line shared between the threads after the first instance of each BLAS.
+                    if (blas != previousBlas
+                        && blas->lastInstanceConversion.load(std::memory_order_relaxed) != conversionId
+                        && blas->lastInstanceConversion.exchange(conversionId, std::memory_order_relaxed) != conversionId)
+                    {
+                        newBottomLevelASes.push_back(blas);
+                    }
+                    previousBlas = blas;
+                }
+                else // !instance.bottomLevelAS
                 {
-                    requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+                    dxrInstance.AccelerationStructure = 0;
                 }
-#endif
+
+                memcpy(cpuVA + i, &dxrInstance, sizeof(dxrInstance));
             }
-            else // !instance.bottomLevelAS
+
+            if (!newBottomLevelASes.empty())
             {
-                dxrInstance.AccelerationStructure = 0;
+                std::lock_guard lockGuard(uniqueBottomLevelASesMutex);
+                uniqueBottomLevelASes.insert(uniqueBottomLevelASes.end(), newBottomLevelASes.begin(), newBottomLevelASes.end());
             }
+        });
+
+        // Track the liveness and the states once per unique BLAS instead of once per instance.
+        // Concurrent TLAS builds on other command lists can make a BLAS appear twice, which is harmless.
+        for (AccelStruct* blas : uniqueBottomLevelASes)
+        {
+            if (blas->desc.trackLiveness)
+                as->bottomLevelASes.push_back(blas);
+
+#ifndef NVRHI_WITH_RTXMU
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+            }
+#endif
         }
 
 #ifdef NVRHI_WITH_RTXMU
         m_Context.rtxMemUtil->PopulateUAVBarriersCommandList(m_ActiveCommandList->commandList4, m_Instance->rtxmuBuildIds);
 #endif
 
-        // Copy the instance array to the GPU
-        D3D12_RAYTRACING_INSTANCE_DESC* cpuVA = nullptr;
-        D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
-        size_t uploadSize = sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * as->dxrInstances.size();
-        if (!m_UploadManager.suballocateBuffer(uploadSize, nullptr, nullptr, nullptr, (void**)&cpuVA, &gpuVA,
-            m_RecordingVersion, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT))
-        {
-            m_Context.error("Couldn't suballocate an upload buffer");
-            return;
-        }
-
-        memcpy(cpuVA, as->dxrInstances.data(), sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * as->dxrInstances.size());
-
         if (m_EnableAutomaticBarriers)
         {
             requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
@@ -2175,7 +3007,7 @@ namespace nvrhi::d3d12
         buildTopLevelAccelStructInternal(as, gpuVA, numInstances, buildFlags);
 
         if (as->desc.trackLiveness)
-            m_Instance->referencedResources.push_back(as);
+            m_Instance->referencedResources.add(as);
     }
 
     void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -2183,7 +3015,7 @@ namespace nvrhi::d3d12
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
         
         as->bottomLevelASes.clear();
-        as->dxrInstances.clear();
+        as->numBuiltInstances = numInstances;
 
         if (m_EnableAutomaticBarriers)
         {
@@ -2195,7 +3027,18 @@ namespace nvrhi::d3d12
         buildTopLevelAccelStructInternal(as, getBufferGpuVA(instanceBuffer) + instanceBufferOffset, numInstances, buildFlags);
 
         if (as->desc.trackLiveness)
-            m_Instance->referencedResources.push_back(as);
+            m_Instance->referencedResources.add(as);
+    }
+
+    void CommandList::buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* _as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+        nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        // DXR has no indirect instance count, so the TLAS is built with maxInstances instances.
+        // The instances past the GPU count are inactive, which makes the result equivalent.
+        (void)argsBuffer;
+        (void)argsBufferOffset;
+
+        buildTopLevelAccelStructFromBuffer(_as, instanceBuffer, instanceBufferOffset, maxInstances, buildFlags);
     }
 
 
@@ -2205,6 +3048,8 @@ namespace nvrhi::d3d12
         // Early out: no acceleration structures to build, instantiate, or move
         if (desc.params.maxArgCount == 0) return;
 
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
         // Validate resource buffers
         assert(desc.inIndirectArgsBuffer != nullptr); 
         assert(desc.scratchSizeInBytes != 0);
@@ -2247,6 +3092,8 @@ namespace nvrhi::d3d12
             return;
         }
 
+        m_Resources.accelStructStats.clusterOperationExecuted(desc.scratchSizeInBytes);
+
         // Input/Output
         Buffer* inOutAddressesBuffer = checked_cast<Buffer*>(desc.inOutAddressesBuffer);
 
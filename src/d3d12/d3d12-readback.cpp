@@ -0,0 +1,280 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <sstream>
+#include <iomanip>
+
+namespace nvrhi::d3d12
+{
+    ReadbackTicket::~ReadbackTicket()
+    {
+        m_Pool.release(bufferIndex, offset);
+    }
+
+    bool ReadbackTicket::isReady()
+    {
+        if (!fence)
+            return false;
+
+        return fence->GetCompletedValue() >= fenceCounter;
+    }
+
+    ReadbackPool::~ReadbackPool()
+    {
+        for (const auto& buffer : m_Buffers)
+        {
+            if (buffer->resource)
+                buffer->resource->Unmap(0, nullptr);
+        }
+    }
+
+    RefCountPtr<ReadbackTicket> ReadbackPool::allocate(uint64_t size, uint64_t alignment, ID3D12Resource** outBuffer)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint32_t bufferIndex = 0;
+        uint64_t offset = 0;
+        bool allocated = false;
+
+        for (; bufferIndex < uint32_t(m_Buffers.size()); ++bufferIndex)
+        {
+            if (m_Buffers[bufferIndex]->ring.allocate(size, alignment, offset))
+            {
+                allocated = true;
+                break;
+            }
+        }
+
+        if (!allocated)
+        {
+            // All buffers are full or hold tickets that block their tails, add a new one
+            const uint64_t bufferSize = std::max(m_BufferSize, align(size, uint64_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)));
+            auto buffer = std::make_unique<ReadbackBuffer>(bufferSize);
+
+            D3D12_HEAP_PROPERTIES heapProps = {};
+            heapProps.Type = D3D12_HEAP_TYPE_READBACK;
+
+            D3D12_RESOURCE_DESC resourceDesc = {};
+            resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+            resourceDesc.Width = bufferSize;
+            resourceDesc.Height = 1;
+            resourceDesc.DepthOrArraySize = 1;
+            resourceDesc.MipLevels = 1;
+            resourceDesc.SampleDesc.Count = 1;
+            resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+            HRESULT res = m_Context.device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+                D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&buffer->resource));
+
+            void* mappedData = nullptr;
+            if (SUCCEEDED(res))
+                res = buffer->resource->Map(0, nullptr, &mappedData);
+
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "Failed to create a readback buffer of " << bufferSize << " bytes, HRESULT = 0x"
+                    << std::hex << std::setw(8) << res;
+                m_Context.error(ss.str());
+                return nullptr;
+            }
+
+            buffer->cpuAddress = static_cast<uint8_t*>(mappedData);
+
+            std::wstringstream wss;
+            wss << L"Readback Buffer " << m_Buffers.size();
+            buffer->resource->SetName(wss.str().c_str());
+
+            bufferIndex = uint32_t(m_Buffers.size());
+            m_Buffers.push_back(std::move(buffer));
+
+            allocated = m_Buffers[bufferIndex]->ring.allocate(size, alignment, offset);
+            assert(allocated);
+        }
+
+        ReadbackBuffer& buffer = *m_Buffers[bufferIndex];
+
+        RefCountPtr<ReadbackTicket> ticket = RefCountPtr<ReadbackTicket>::Create(new ReadbackTicket(*this));
+        ticket->bufferIndex = bufferIndex;
+        ticket->offset = offset;
+        ticket->cpuAddress = buffer.cpuAddress + offset;
+        ticket->size = size_t(size);
+
+        *outBuffer = buffer.resource;
+        return ticket;
+    }
+
+    void ReadbackPool::release(uint32_t bufferIndex, uint64_t offset)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (bufferIndex < m_Buffers.size())
+            m_Buffers[bufferIndex]->ring.release(offset);
+    }
+
+    void ReadbackPool::addPendingCallback(ReadbackTicket* ticket)
+    {
+        std::lock_guard lockGuard(m_CallbackMutex);
+
+        m_PendingCallbacks.push_back(ticket);
+    }
+
+    void ReadbackPool::runCallbacks()
+    {
+        std::vector<RefCountPtr<ReadbackTicket>> readyTickets;
+
+        {
+            std::lock_guard lockGuard(m_CallbackMutex);
+
+            auto it = m_PendingCallbacks.begin();
+            while (it != m_PendingCallbacks.end())
+            {
+                if ((*it)->isReady())
+                {
+                    readyTickets.push_back(*it);
+                    it = m_PendingCallbacks.erase(it);
+                }
+                else
+                    ++it;
+            }
+        }
+
+        // Call the callbacks without holding the lock, they may record new readbacks
+        for (const auto& ticket : readyTickets)
+        {
+            ReadbackCallback callback = std::move(ticket->callback);
+            ticket->callback = nullptr;
+            callback(ticket.Get());
+        }
+    }
+
+    ReadbackTicketHandle CommandList::readbackBuffer(IBuffer* _buffer, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (m_Desc.isReusable || m_Desc.isSecondary)
+        {
+            m_Context.error("Readbacks can not be recorded into reusable or secondary command lists");
+            return nullptr;
+        }
+
+        ID3D12Resource* destBuffer = nullptr;
+        RefCountPtr<ReadbackTicket> ticket = m_Resources.readbackPool.allocate(sizeBytes, 16, &destBuffer);
+        if (!ticket)
+            return nullptr;
+
+        ticket->callback = std::move(callback);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        if (buffer->desc.cpuAccess != CpuAccessMode::None)
+            m_Instance->referencedStagingBuffers.push_back(buffer);
+        else
+            m_Instance->referencedResources.add(buffer);
+
+        // The instance keeps the ticket, and therefore its readback memory, until the copy has finished executing
+        m_Instance->referencedReadbacks.push_back(ticket);
+
+        m_ActiveCommandList->commandList->CopyBufferRegion(destBuffer, ticket->offset, buffer->resource, offsetBytes, sizeBytes);
+
+        return ticket;
+    }
+
+    ReadbackTicketHandle CommandList::readbackTexture(ITexture* _texture, const TextureSlice& slice, ReadbackCallback callback)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (m_Desc.isReusable || m_Desc.isSecondary)
+        {
+            m_Context.error("Readbacks can not be recorded into reusable or secondary command lists");
+            return nullptr;
+        }
+
+        const TextureSlice resolvedSlice = slice.resolve(texture->desc);
+
+        // Get the footprint of a texture that has the size of the region
+        D3D12_RESOURCE_DESC regionDesc = texture->resource->GetDesc();
+        regionDesc.Alignment = 0;
+        regionDesc.Width = resolvedSlice.width;
+        regionDesc.Height = resolvedSlice.height;
+        regionDesc.DepthOrArraySize = UINT16(texture->desc.dimension == TextureDimension::Texture3D ? resolvedSlice.depth : 1);
+        regionDesc.MipLevels = 1;
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+        uint32_t numRows;
+        uint64_t rowSizeInBytes;
+        uint64_t totalBytes;
+        m_Context.device->GetCopyableFootprints(&regionDesc, 0, 1, 0, &footprint, &numRows, &rowSizeInBytes, &totalBytes);
+
+        ID3D12Resource* destBuffer = nullptr;
+        RefCountPtr<ReadbackTicket> ticket = m_Resources.readbackPool.allocate(totalBytes,
+            D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &destBuffer);
+        if (!ticket)
+            return nullptr;
+
+        footprint.Offset = ticket->offset;
+
+        ticket->callback = std::move(callback);
+        ticket->rowPitch = footprint.Footprint.RowPitch;
+        ticket->depthPitch = size_t(footprint.Footprint.RowPitch) * numRows;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, TextureSubresourceSet(resolvedSlice.mipLevel, 1, resolvedSlice.arraySlice, 1), ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.add(texture);
+        m_Instance->referencedReadbacks.push_back(ticket);
+
+        D3D12_TEXTURE_COPY_LOCATION dstLocation;
+        dstLocation.pResource = destBuffer;
+        dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        dstLocation.PlacedFootprint = footprint;
+
+        D3D12_TEXTURE_COPY_LOCATION srcLocation;
+        srcLocation.pResource = texture->resource;
+        srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        srcLocation.SubresourceIndex = calcSubresource(resolvedSlice.mipLevel, resolvedSlice.arraySlice, 0,
+            texture->desc.mipLevels, texture->desc.arraySize);
+
+        D3D12_BOX srcBox;
+        srcBox.left = resolvedSlice.x;
+        srcBox.top = resolvedSlice.y;
+        srcBox.front = resolvedSlice.z;
+        srcBox.right = resolvedSlice.x + resolvedSlice.width;
+        srcBox.bottom = resolvedSlice.y + resolvedSlice.height;
+        srcBox.back = resolvedSlice.z + resolvedSlice.depth;
+
+        m_ActiveCommandList->commandList->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, &srcBox);
+
+        return ticket;
+    }
+
+} // namespace nvrhi::d3d12
@@ -0,0 +1,219 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+namespace nvrhi::d3d12
+{
+    static D3D12_RESIDENCY_PRIORITY convertResidencyPriority(ResidencyPriority priority)
+    {
+        switch (priority)
+        {
+        case ResidencyPriority::Minimum: return D3D12_RESIDENCY_PRIORITY_MINIMUM;
+        case ResidencyPriority::Low:     return D3D12_RESIDENCY_PRIORITY_LOW;
+        case ResidencyPriority::High:    return D3D12_RESIDENCY_PRIORITY_HIGH;
+        case ResidencyPriority::Maximum: return D3D12_RESIDENCY_PRIORITY_MAXIMUM;
+        case ResidencyPriority::Normal:
+        default:                         return D3D12_RESIDENCY_PRIORITY_NORMAL;
+        }
+    }
+
+    void ResidencyManager::registerResource(ResidencyEntry& entry, ID3D12Resource* resource, ResidencyPriority priority)
+    {
+        if (!resource)
+            return;
+
+        if (priority != ResidencyPriority::Normal && m_Context.device1)
+        {
+            ID3D12Pageable* pageable = resource;
+            const D3D12_RESIDENCY_PRIORITY d3dPriority = convertResidencyPriority(priority);
+            m_Context.device1->SetResidencyPriority(1, &pageable, &d3dPriority);
+        }
+
+        // Resources with the maximum priority are never evicted by the manager
+        if (!m_Enabled || priority == ResidencyPriority::Maximum)
+            return;
+
+        const D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = m_Context.device->GetResourceAllocationInfo(1, 1, &resourceDesc);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        entry.pageable = resource;
+        entry.size = allocInfo.SizeInBytes;
+        entry.registered = true;
+        entry.resident = true;
+        entry.position = m_ResidentEntries.insert(m_ResidentEntries.end(), &entry);
+    }
+
+    void ResidencyManager::unregisterResource(ResidencyEntry& entry)
+    {
+        if (!entry.registered)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (entry.resident)
+            m_ResidentEntries.erase(entry.position);
+
+        // Evicted resources can be released directly, no need to make them resident first
+        entry.registered = false;
+        entry.pageable = nullptr;
+    }
+
+    void ResidencyManager::markUsed(ResidencyEntry& entry, CommandQueue queue, uint64_t submittedInstance)
+    {
+        if (!entry.registered)
+            return;
+
+        if (entry.resident)
+        {
+            // Move to the most recently used end of the list
+            m_ResidentEntries.splice(m_ResidentEntries.end(), m_ResidentEntries, entry.position);
+        }
+        else
+        {
+            m_PageablesToProcess.push_back(entry.pageable);
+            entry.resident = true;
+            entry.position = m_ResidentEntries.insert(m_ResidentEntries.end(), &entry);
+        }
+
+        entry.lastUseInstances[size_t(queue)] = submittedInstance;
+    }
+
+    void ResidencyManager::markUsed(IResource* resource, CommandQueue queue, uint64_t submittedInstance)
+    {
+        if (!resource)
+            return;
+
+        if (Texture* texture = dynamic_cast<Texture*>(resource))
+        {
+            markUsed(texture->residency, queue, submittedInstance);
+        }
+        else if (Buffer* buffer = dynamic_cast<Buffer*>(resource))
+        {
+            markUsed(buffer->residency, queue, submittedInstance);
+        }
+        else if (BindingSet* bindingSet = dynamic_cast<BindingSet*>(resource))
+        {
+            for (const auto& boundResource : bindingSet->resources)
+                markUsed(boundResource.Get(), queue, submittedInstance);
+        }
+        else if (Framebuffer* framebuffer = dynamic_cast<Framebuffer*>(resource))
+        {
+            for (const auto& attachment : framebuffer->textures)
+                markUsed(attachment.Get(), queue, submittedInstance);
+        }
+    }
+
+    void ResidencyManager::prepareSubmission(const CommandListInstance& instance, CommandQueue queue, uint64_t submittedInstance)
+    {
+        if (!m_Enabled)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_PageablesToProcess.clear();
+
+        for (const auto& resource : instance.referencedResources)
+            markUsed(resource.Get(), queue, submittedInstance);
+
+        for (const auto& secondary : instance.secondaryCommandLists)
+        {
+            for (const auto& resource : checked_cast<CommandList*>(secondary.Get())->getInstance().referencedResources)
+                markUsed(resource.Get(), queue, submittedInstance);
+        }
+
+        if (!m_PageablesToProcess.empty())
+        {
+            const HRESULT hr = m_Context.device->MakeResident(UINT(m_PageablesToProcess.size()), m_PageablesToProcess.data());
+            if (FAILED(hr))
+            {
+                std::stringstream ss;
+                ss << "MakeResident call failed for " << m_PageablesToProcess.size() << " resources, HRESULT = 0x"
+                    << std::hex << std::setw(8) << hr;
+                m_Context.error(ss.str());
+            }
+        }
+    }
+
+    void ResidencyManager::trimToBudget(const std::array<std::unique_ptr<Queue>, size_t(CommandQueue::Count)>& queues)
+    {
+        if (!m_Enabled || !m_Context.adapter3)
+            return;
+
+        DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+        if (FAILED(m_Context.adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo)))
+            return;
+
+        if (memoryInfo.CurrentUsage <= memoryInfo.Budget)
+            return;
+
+        uint64_t bytesToEvict = memoryInfo.CurrentUsage - memoryInfo.Budget;
+
+        std::array<uint64_t, size_t(CommandQueue::Count)> completedInstances{};
+        for (size_t queueIndex = 0; queueIndex < queues.size(); ++queueIndex)
+        {
+            if (queues[queueIndex])
+                completedInstances[queueIndex] = queues[queueIndex]->updateLastCompletedInstance();
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_PageablesToProcess.clear();
+
+        while (bytesToEvict > 0 && !m_ResidentEntries.empty())
+        {
+            ResidencyEntry* entry = m_ResidentEntries.front();
+
+            // Everything after the first in-flight resource was used at least as recently, stop here
+            bool inFlight = false;
+            for (size_t queueIndex = 0; queueIndex < completedInstances.size(); ++queueIndex)
+            {
+                if (entry->lastUseInstances[queueIndex] > completedInstances[queueIndex])
+                    inFlight = true;
+            }
+
+            if (inFlight)
+                break;
+
+            m_ResidentEntries.pop_front();
+            entry->resident = false;
+            m_PageablesToProcess.push_back(entry->pageable);
+
+            bytesToEvict -= std::min(bytesToEvict, entry->size);
+        }
+
+        if (!m_PageablesToProcess.empty())
+        {
+            m_Context.device->Evict(UINT(m_PageablesToProcess.size()), m_PageablesToProcess.data());
+        }
+    }
+
+} // namespace nvrhi::d3d12
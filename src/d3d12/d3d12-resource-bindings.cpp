@@ -23,6 +23,7 @@
 #include "d3d12-backend.h"
 
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -95,19 +96,17 @@ namespace nvrhi::d3d12
 
         if (layout->descriptorTableSizeSamplers > 0)
         {
-            DescriptorIndex descriptorTableBaseIndex = m_Resources.samplerHeap.allocateDescriptors(layout->descriptorTableSizeSamplers);
-            descriptorTableSamplers = descriptorTableBaseIndex;
             rootParameterIndexSamplers = layout->rootParameterSamplers;
             descriptorTableValidSamplers = true;
 
+            // Find the sampler for every entry of the table, entries without one get the default sampler
+            std::vector<Sampler*> tableSamplers(layout->descriptorTableSizeSamplers, nullptr);
+
             for (const auto& range : layout->descriptorRangesSamplers)
             {
                 for (uint32_t itemInRange = 0; itemInRange < range.NumDescriptors; itemInRange++)
                 {
                     uint32_t slot = range.BaseShaderRegister + itemInRange;
-                    bool found = false;
-                    D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandle = m_Resources.samplerHeap.getCpuHandle(
-                        descriptorTableBaseIndex + range.OffsetInDescriptorsFromTableStart + itemInRange);
 
                     for (const auto& binding : desc.bindings)
                     {
@@ -116,27 +115,55 @@ namespace nvrhi::d3d12
                             Sampler* sampler = checked_cast<Sampler*>(binding.resourceHandle);
                             resources.push_back(sampler);
 
-                            sampler->createDescriptor(descriptorHandle.ptr);
-                            found = true;
+                            tableSamplers[range.OffsetInDescriptorsFromTableStart + itemInRange] = sampler;
                             break;
                         }
                     }
+                }
+            }
 
-                    if (!found)
+            if (isTransient)
+            {
+                // Transient sets get their descriptor ranges from the command list before this call
+                for (uint32_t i = 0; i < layout->descriptorTableSizeSamplers; i++)
+                {
+                    D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandle = m_Resources.samplerHeap.getCpuHandle(descriptorTableSamplers + i);
+
+                    if (tableSamplers[i])
+                    {
+                        tableSamplers[i]->createDescriptor(descriptorHandle.ptr);
+                    }
+                    else
                     {
                         // Create a default sampler
                         D3D12_SAMPLER_DESC samplerDesc = {};
                         m_Context.device->CreateSampler(&samplerDesc, descriptorHandle);
                     }
                 }
+
+                m_Resources.samplerHeap.copyToShaderVisibleHeap(descriptorTableSamplers, layout->descriptorTableSizeSamplers);
             }
+            else
+            {
+                // Sets with the same samplers in the same order share one table, which keeps the shader-visible
+                // sampler heap small when many materials use the same few samplers
+                std::vector<DescriptorIndex> samplerDescriptors(layout->descriptorTableSizeSamplers, c_InvalidDescriptorIndex);
+                for (uint32_t i = 0; i < layout->descriptorTableSizeSamplers; i++)
+                {
+                    if (tableSamplers[i])
+                        samplerDescriptors[i] = tableSamplers[i]->descriptor;
+                }
 
-            m_Resources.samplerHeap.copyToShaderVisibleHeap(descriptorTableBaseIndex, layout->descriptorTableSizeSamplers);
+                descriptorTableSamplers = m_Resources.acquireSharedSamplerTable(samplerDescriptors);
+                sharedSamplerTable = true;
+            }
         }
 
         if (layout->descriptorTableSizeSRVetc > 0)
         {
-            DescriptorIndex descriptorTableBaseIndex = m_Resources.shaderResourceViewHeap.allocateDescriptors(layout->descriptorTableSizeSRVetc);
+            DescriptorIndex descriptorTableBaseIndex = isTransient
+                ? descriptorTableSRVetc
+                : m_Resources.shaderResourceViewHeap.allocateDescriptors(layout->descriptorTableSizeSRVetc);
             descriptorTableSRVetc = descriptorTableBaseIndex;
             rootParameterIndexSRVetc = layout->rootParameterSRVetc;
             descriptorTableValidSRVetc = true;
@@ -352,10 +379,21 @@ namespace nvrhi::d3d12
         return BindingLayoutHandle::Create(ret);
     }
 
-    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
+    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::createBindingSet");
+
+        if (m_BindingSetCache)
+            return m_BindingSetCache->getOrCreate(desc, layout, [&]() { return createBindingSetInternal(desc, layout); });
+
+        return createBindingSetInternal(desc, layout);
+    }
+
+    BindingSetHandle Device::createBindingSetInternal(const BindingSetDesc& desc, IBindingLayout* _layout)
     {
         BindingSet *ret = new BindingSet(m_Context, m_Resources);
         ret->desc = desc;
+        ret->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::BindingSet);
 
         BindingLayout* pipelineLayout = checked_cast<BindingLayout*>(_layout);
         ret->layout = pipelineLayout;
@@ -365,27 +403,89 @@ namespace nvrhi::d3d12
         return BindingSetHandle::Create(ret);
     }
 
-    DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
+    BindingSetHandle CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
     {
-        (void)layout; // not necessary on DX12
+        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+
+        BindingSet* ret = new BindingSet(m_Context, m_Resources);
+        ret->desc = desc;
+        ret->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::BindingSet);
+        ret->layout = layout;
+
+        // Sets that don't fit into a chunk use the regular allocation and are released with the set
+        if (layout->descriptorTableSizeSRVetc <= m_Resources.transientShaderResourceViewChunks.getChunkSize() &&
+            layout->descriptorTableSizeSamplers <= m_Resources.transientSamplerChunks.getChunkSize())
+        {
+            DescriptorIndex srvIndex = 0;
+            DescriptorIndex samplerIndex = 0;
+
+            if (layout->descriptorTableSizeSRVetc > 0)
+            {
+                if (!m_Instance->transientShaderResourceViews)
+                    m_Instance->transientShaderResourceViews = std::make_unique<TransientDescriptorAllocator>(m_Resources.transientShaderResourceViewChunks);
+
+                srvIndex = m_Instance->transientShaderResourceViews->allocate(layout->descriptorTableSizeSRVetc);
+            }
+
+            if (layout->descriptorTableSizeSamplers > 0)
+            {
+                if (!m_Instance->transientSamplers)
+                    m_Instance->transientSamplers = std::make_unique<TransientDescriptorAllocator>(m_Resources.transientSamplerChunks);
+
+                samplerIndex = m_Instance->transientSamplers->allocate(layout->descriptorTableSizeSamplers);
+            }
+
+            if (srvIndex != c_InvalidDescriptorIndex && samplerIndex != c_InvalidDescriptorIndex)
+            {
+                ret->isTransient = true;
+                ret->descriptorTableSRVetc = srvIndex;
+                ret->descriptorTableSamplers = samplerIndex;
+            }
+        }
+
+        ret->createDescriptors();
+
+        BindingSetHandle handle = BindingSetHandle::Create(ret);
+
+        // Keep the set alive until the instance retires, the application may drop the handle right after binding
+        m_Instance->referencedResources.add(handle);
 
+        return handle;
+    }
+
+    DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
+    {
         DescriptorTable* ret = new DescriptorTable(m_Resources);
+        ret->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::DescriptorTable);
         ret->capacity = 0;
         ret->firstDescriptor = 0;
+
+        // The layout is not necessary on DX12, except for the optional upfront reservation
+        const BindlessLayoutDesc* bindlessDesc = layout ? layout->getBindlessDesc() : nullptr;
+        if (m_ReserveDescriptorTableCapacity && bindlessDesc && bindlessDesc->maxCapacity > 0)
+        {
+            ret->firstDescriptor = m_Resources.shaderResourceViewHeap.allocateDescriptors(bindlessDesc->maxCapacity);
+            ret->reservedCapacity = bindlessDesc->maxCapacity;
+            ret->minReservedCapacity = bindlessDesc->maxCapacity;
+        }
         
         return DescriptorTableHandle::Create(ret);
     }
 
     BindingSet::~BindingSet()
     {
+        if (isTransient)
+            return; // the descriptors are recycled with the command list instance
+
         m_Resources.shaderResourceViewHeap.releaseDescriptors(descriptorTableSRVetc, layout->descriptorTableSizeSRVetc);
     
-        m_Resources.samplerHeap.releaseDescriptors(descriptorTableSamplers, layout->descriptorTableSizeSamplers);
+        if (sharedSamplerTable)
+            m_Resources.releaseSharedSamplerTable(descriptorTableSamplers);
     }
 
     DescriptorTable::~DescriptorTable()
     {
-        m_Resources.shaderResourceViewHeap.releaseDescriptors(firstDescriptor, capacity);
+        m_Resources.shaderResourceViewHeap.releaseDescriptors(firstDescriptor, reservedCapacity);
     }
 
     BindingLayout::BindingLayout(const BindingLayoutDesc& _desc)
@@ -751,6 +851,10 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        PipelineKeyHasher serializedHasher;
+        serializedHasher.add(rsBlob->GetBufferPointer(), rsBlob->GetBufferSize());
+        rootsig->serializedHash = serializedHasher.getHash();
+
         // Create the RS object
 
         res = m_Context.device->CreateRootSignature(0, rsBlob->GetBufferPointer(), rsBlob->GetBufferSize(), IID_PPV_ARGS(&rootsig->handle));
@@ -775,18 +879,23 @@ namespace nvrhi::d3d12
             hash_combine(hash, pipelineLayout.Get());
         
         hash_combine(hash, allowInputLayout ? 1u : 0u);
+
+        std::lock_guard lockGuard(m_Resources.rootsigCacheMutex);
         
-        // Get a cached RS and AddRef it (if it exists)
-        RefCountPtr<RootSignature> rootsig = m_Resources.rootsigCache[hash];
+        // Get a cached RS and AddRef it (if it exists). An RS whose last reference is gone may still be in the cache
+        // while its destructor waits for the mutex, it must not be resurrected, so build a new one instead.
+        const auto it = m_Resources.rootsigCache.find(hash);
+        if (it != m_Resources.rootsigCache.end() && it->second->TryAddRef())
+            return RefCountPtr<RootSignature>::Create(it->second);
 
+        // Does not exist - build a new one, take ownership
+        RefCountPtr<RootSignature> rootsig = checked_cast<RootSignature*>(buildRootSignature(pipelineLayouts, allowInputLayout, false).Get());
         if (!rootsig)
-        {
-            // Does not exist - build a new one, take ownership
-            rootsig = checked_cast<RootSignature*>(buildRootSignature(pipelineLayouts, allowInputLayout, false).Get());
-            rootsig->hash = hash;
+            return nullptr;
+        rootsig->hash = hash;
 
-            m_Resources.rootsigCache[hash] = rootsig;
-        }
+        // This replaces a dying RS, whose destructor then leaves the entry alone
+        m_Resources.rootsigCache[hash] = rootsig;
 
         // Pass ownership of the RS to caller
         return rootsig;
@@ -794,9 +903,10 @@ namespace nvrhi::d3d12
 
     RootSignature::~RootSignature()
     {
-        // Remove the root signature from the cache
+        // Remove the root signature from the cache, unless it has been replaced already
+        std::lock_guard lockGuard(m_Resources.rootsigCacheMutex);
         const auto it = m_Resources.rootsigCache.find(hash);
-        if (it != m_Resources.rootsigCache.end())
+        if (it != m_Resources.rootsigCache.end() && it->second == this)
             m_Resources.rootsigCache.erase(it);
     }
 
@@ -867,47 +977,86 @@ namespace nvrhi::d3d12
         }
 
         m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorTable->firstDescriptor + binding.slot, 1);
+        descriptorTable->numWrittenDescriptors = std::max(descriptorTable->numWrittenDescriptors, binding.slot + 1);
         return true;
     }
 
     void Device::resizeDescriptorTable(IDescriptorTable* _descriptorTable, uint32_t newSize, bool keepContents)
     {
         DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+        StaticDescriptorHeap& heap = m_Resources.shaderResourceViewHeap;
 
         if (newSize == descriptorTable->capacity)
             return;
 
         if (newSize < descriptorTable->capacity)
         {
-            m_Resources.shaderResourceViewHeap.releaseDescriptors(descriptorTable->firstDescriptor + newSize, descriptorTable->capacity - newSize);
+            // Keep the upfront reservation, release the rest of the tail
+            const uint32_t newReservedCapacity = std::max(newSize, descriptorTable->minReservedCapacity);
+            if (newReservedCapacity < descriptorTable->reservedCapacity)
+            {
+                heap.releaseDescriptors(descriptorTable->firstDescriptor + newReservedCapacity, descriptorTable->reservedCapacity - newReservedCapacity);
+                descriptorTable->reservedCapacity = newReservedCapacity;
+            }
+
+            descriptorTable->capacity = newSize;
+            descriptorTable->numWrittenDescriptors = std::min(descriptorTable->numWrittenDescriptors, newSize);
+            return;
+        }
+
+        // Grow within the reserved range, or extend the range in place if the following descriptors are free
+        if (newSize <= descriptorTable->reservedCapacity)
+        {
             descriptorTable->capacity = newSize;
             return;
         }
 
-        uint32_t originalFirst = descriptorTable->firstDescriptor;
-        if (!keepContents && descriptorTable->capacity > 0)
+        if (descriptorTable->reservedCapacity > 0 &&
+            heap.tryExtendDescriptors(descriptorTable->firstDescriptor, descriptorTable->reservedCapacity, newSize))
         {
-            m_Resources.shaderResourceViewHeap.releaseDescriptors(descriptorTable->firstDescriptor, descriptorTable->capacity);
+            descriptorTable->capacity = newSize;
+            descriptorTable->reservedCapacity = newSize;
+            return;
         }
 
-        descriptorTable->firstDescriptor = m_Resources.shaderResourceViewHeap.allocateDescriptors(newSize);
+        // Move the table to a new range, with some headroom for growth unless the growth factor is 1
+        const uint32_t newReservedCapacity = std::max(newSize,
+            uint32_t(std::min(double(descriptorTable->capacity) * m_DescriptorTableGrowthFactor, double(UINT32_MAX))));
 
-        if (keepContents && descriptorTable->capacity > 0)
+        const DescriptorIndex originalFirst = descriptorTable->firstDescriptor;
+        const uint32_t originalReservedCapacity = descriptorTable->reservedCapacity;
+        if (!keepContents && originalReservedCapacity > 0)
         {
-            m_Context.device->CopyDescriptorsSimple(descriptorTable->capacity,
-                m_Resources.shaderResourceViewHeap.getCpuHandle(descriptorTable->firstDescriptor),
-                m_Resources.shaderResourceViewHeap.getCpuHandle(originalFirst),
+            heap.releaseDescriptors(originalFirst, originalReservedCapacity);
+        }
+
+        descriptorTable->firstDescriptor = heap.allocateDescriptors(newReservedCapacity);
+
+        // Only the written part of the table has to be copied, the rest of it holds undefined descriptors anyway
+        if (!keepContents)
+            descriptorTable->numWrittenDescriptors = 0;
+
+        if (descriptorTable->numWrittenDescriptors > 0)
+        {
+            m_Context.device->CopyDescriptorsSimple(descriptorTable->numWrittenDescriptors,
+                heap.getCpuHandle(descriptorTable->firstDescriptor),
+                heap.getCpuHandle(originalFirst),
                 D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-            m_Context.device->CopyDescriptorsSimple(descriptorTable->capacity,
-                m_Resources.shaderResourceViewHeap.getCpuHandleShaderVisible(descriptorTable->firstDescriptor),
-                m_Resources.shaderResourceViewHeap.getCpuHandle(originalFirst),
+            m_Context.device->CopyDescriptorsSimple(descriptorTable->numWrittenDescriptors,
+                heap.getCpuHandleShaderVisible(descriptorTable->firstDescriptor),
+                heap.getCpuHandle(originalFirst),
                 D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        }
 
-            m_Resources.shaderResourceViewHeap.releaseDescriptors(originalFirst, descriptorTable->capacity);
+        if (keepContents && originalReservedCapacity > 0)
+        {
+            heap.releaseDescriptors(originalFirst, originalReservedCapacity);
         }
 
         descriptorTable->capacity = newSize;
+        descriptorTable->reservedCapacity = newReservedCapacity;
+        descriptorTable->minReservedCapacity = 0; // the upfront reservation has been left behind
     }
 
     void CommandList::setComputeBindings(
@@ -927,6 +1076,8 @@ namespace nvrhi::d3d12
                     continue;
 
                 const bool updateThisSet = (bindingUpdateMask & (1 << bindingSetIndex)) != 0;
+                if (updateThisSet)
+                    ++m_Stats.bindingSetBinds;
 
                 const std::pair<BindingLayoutHandle, RootParameterIndex>& layoutAndOffset = rootSignature->pipelineLayouts[bindingSetIndex];
                 RootParameterIndex rootParameterOffset = layoutAndOffset.second;
@@ -999,8 +1150,9 @@ namespace nvrhi::d3d12
                                 m_Resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc));
                         }
 
-                        if (bindingSet->desc.trackLiveness)
-                            m_Instance->referencedResources.push_back(bindingSet);
+                        // The residency manager needs to see the resources in every binding set
+                        if (bindingSet->desc.trackLiveness || m_Resources.residencyManager.isEnabled())
+                            m_Instance->referencedResources.add(bindingSet);
                     }
 
                     if (m_EnableAutomaticBarriers && (updateThisSet || bindingSet->hasUavBindings)) // UAV bindings may place UAV barriers on the same binding set
@@ -1025,7 +1177,7 @@ namespace nvrhi::d3d12
             {
                 requireBufferState(indirectParams, ResourceStates::IndirectArgument);
             }
-            m_Instance->referencedResources.push_back(indirectParams);
+            m_Instance->referencedResources.add(indirectParams);
         }
 
         uint32_t bindingMask = (1 << uint32_t(bindings.size())) - 1;
@@ -1053,6 +1205,8 @@ namespace nvrhi::d3d12
                     continue;
 
                 const bool updateThisSet = (bindingUpdateMask & (1 << bindingSetIndex)) != 0;
+                if (updateThisSet)
+                    ++m_Stats.bindingSetBinds;
 
                 const std::pair<BindingLayoutHandle, RootParameterIndex>& layoutAndOffset = rootSignature->pipelineLayouts[bindingSetIndex];
                 RootParameterIndex rootParameterOffset = layoutAndOffset.second;
@@ -1125,8 +1279,9 @@ namespace nvrhi::d3d12
                                 m_Resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc));
                         }
 
-                        if (bindingSet->desc.trackLiveness)
-                            m_Instance->referencedResources.push_back(bindingSet);
+                        // The residency manager needs to see the resources in every binding set
+                        if (bindingSet->desc.trackLiveness || m_Resources.residencyManager.isEnabled())
+                            m_Instance->referencedResources.add(bindingSet);
                     }
 
                     if (m_EnableAutomaticBarriers && (updateThisSet || bindingSet->hasUavBindings)) // UAV bindings may place UAV barriers on the same binding set
@@ -1151,7 +1306,7 @@ namespace nvrhi::d3d12
             {
                 requireBufferState(indirectParams, ResourceStates::IndirectArgument);
             }
-            m_Instance->referencedResources.push_back(indirectParams);
+            m_Instance->referencedResources.add(indirectParams);
         }
 
         uint32_t bindingMask = (1 << uint32_t(bindings.size())) - 1;
@@ -1162,5 +1317,61 @@ namespace nvrhi::d3d12
         }
     }
 
+    void CommandList::setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings)
+    {
+        // Find the pipeline that was set last and the bindings it uses
+        const RootSignature* rootsig = nullptr;
+        BindingSetVector* currentBindings = nullptr;
+        bool isGraphics = false;
+
+        if (m_CurrentGraphicsStateValid && m_CurrentGraphicsState.pipeline)
+        {
+            GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+            rootsig = pso->rootSignature;
+            currentBindings = &m_CurrentGraphicsState.bindings;
+            isGraphics = true;
+        }
+        else if (m_CurrentComputeStateValid && m_CurrentComputeState.pipeline)
+        {
+            ComputePipeline* pso = checked_cast<ComputePipeline*>(m_CurrentComputeState.pipeline);
+            rootsig = pso->rootSignature;
+            currentBindings = &m_CurrentComputeState.bindings;
+        }
+        else if (m_CurrentRayTracingStateValid && m_CurrentRayTracingState.shaderTable)
+        {
+            RayTracingPipeline* pso = checked_cast<RayTracingPipeline*>(m_CurrentRayTracingState.shaderTable->getPipeline());
+            rootsig = pso->globalRootSignature;
+            currentBindings = &m_CurrentRayTracingState.bindings;
+        }
+        else if (m_CurrentMeshletStateValid && m_CurrentMeshletState.pipeline)
+        {
+            MeshletPipeline* pso = checked_cast<MeshletPipeline*>(m_CurrentMeshletState.pipeline);
+            rootsig = pso->rootSignature;
+            currentBindings = &m_CurrentMeshletState.bindings;
+            isGraphics = true;
+        }
+
+        if (!rootsig || layoutIndex >= rootsig->pipelineLayouts.size() || layoutIndex >= currentBindings->size())
+        {
+            m_Context.error("setPushBindings requires a pipeline state with a binding layout at the given index");
+            return;
+        }
+
+        // There are no push descriptors on DX12: write the bindings into a transient binding set,
+        // which is kept alive by the command list instance
+        BindingSetHandle bindingSet = createTransientBindingSet(bindings, rootsig->pipelineLayouts[layoutIndex].first);
+        (*currentBindings)[layoutIndex] = bindingSet;
+
+        uint32_t bindingUpdateMask = 1u << layoutIndex;
+        if (commitDescriptorHeaps())
+            bindingUpdateMask = ~0u;
+
+        if (isGraphics)
+            setGraphicsBindings(*currentBindings, bindingUpdateMask, nullptr, false, rootsig);
+        else
+            setComputeBindings(*currentBindings, bindingUpdateMask, nullptr, false, rootsig);
+
+        commitBarriers();
+    }
 
 } // namespace nvrhi::d3d12
@@ -22,6 +22,9 @@
 
 #include "d3d12-backend.h"
 
+#include <algorithm>
+#include <sstream>
+
 namespace nvrhi::d3d12
 {
 
@@ -215,12 +218,77 @@ namespace nvrhi::d3d12
         return ShaderHandle::Create(shader);
     }
     
-    ShaderHandle Device::createShaderSpecialization(IShader*, const ShaderSpecialization*, uint32_t)
+    static bool makeSpecializationKey(const ShaderSpecialization* constants, uint32_t numConstants, std::vector<std::pair<uint32_t, uint32_t>>& key)
+    {
+        key.clear();
+        key.reserve(numConstants);
+        for (uint32_t i = 0; i < numConstants; i++)
+            key.emplace_back(constants[i].constantID, constants[i].value.u);
+
+        std::sort(key.begin(), key.end());
+
+        for (size_t i = 1; i < key.size(); i++)
+        {
+            if (key[i].first == key[i - 1].first)
+                return false;
+        }
+
+        return true;
+    }
+
+    ShaderHandle Device::createShaderSpecialization(IShader* _baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
     {
-        utils::NotSupported();
+        Shader* baseShader = checked_cast<Shader*>(_baseShader);
+
+        std::vector<std::pair<uint32_t, uint32_t>> key;
+        if (!makeSpecializationKey(constants, numConstants, key))
+        {
+            m_Context.error("The constant IDs passed to createShaderSpecialization must be unique");
+            return nullptr;
+        }
+
+        {
+            std::lock_guard lockGuard(baseShader->specializationsMutex);
+
+            const auto it = baseShader->specializations.find(key);
+            if (it != baseShader->specializations.end())
+                return it->second;
+        }
+
+        std::stringstream ss;
+        ss << "No permutation of shader ";
+        if (!baseShader->desc.debugName.empty())
+            ss << "'" << baseShader->desc.debugName << "' ";
+        ss << "is registered for the specialization constants {";
+        for (size_t i = 0; i < key.size(); i++)
+            ss << (i ? ", " : " ") << key[i].first << " = 0x" << std::hex << key[i].second << std::dec;
+        ss << " }, use addShaderSpecializationPermutation to provide it";
+        m_Context.error(ss.str());
+
         return nullptr;
     }
 
+    ShaderHandle Device::addShaderSpecializationPermutation(IShader* _baseShader, const ShaderSpecialization* constants, uint32_t numConstants, const void* binary, size_t binarySize)
+    {
+        Shader* baseShader = checked_cast<Shader*>(_baseShader);
+
+        std::vector<std::pair<uint32_t, uint32_t>> key;
+        if (!makeSpecializationKey(constants, numConstants, key))
+        {
+            m_Context.error("The constant IDs passed to addShaderSpecializationPermutation must be unique");
+            return nullptr;
+        }
+
+        ShaderHandle permutation = createShader(baseShader->desc, binary, binarySize);
+        if (!permutation)
+            return nullptr;
+
+        std::lock_guard lockGuard(baseShader->specializationsMutex);
+        baseShader->specializations[key] = permutation;
+
+        return permutation;
+    }
+
     nvrhi::ShaderLibraryHandle Device::createShaderLibrary(const void* binary, const size_t binarySize)
     {
         ShaderLibrary* shaderLibrary = new ShaderLibrary();
@@ -23,12 +23,16 @@
 #include "d3d12-backend.h"
 
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 
 namespace nvrhi::d3d12
 {
     void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
     {
+        if (!_bindingSet)
+            return; // push descriptor layouts have no binding set in the state
+
         if (_bindingSet->getDesc() == nullptr)
             return; // is bindless
 
@@ -96,14 +100,43 @@ namespace nvrhi::d3d12
         m_StateTracker.requireBufferState(buffer, state);
     }
 
+    static D3D12_RESOURCE_BARRIER_FLAGS convertSplitBarrier(SplitBarrier split)
+    {
+        switch (split)
+        {
+        case SplitBarrier::Begin:
+            return D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+        case SplitBarrier::End:
+            return D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+        case SplitBarrier::None:
+        default:
+            return D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        }
+    }
+
     void CommandList::commitBarriers()
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::commitBarriers");
+
         const auto& textureBarriers = m_StateTracker.getTextureBarriers();
         const auto& bufferBarriers = m_StateTracker.getBufferBarriers();
         const size_t barrierCount = textureBarriers.size() + bufferBarriers.size();
         if (barrierCount == 0)
             return;
 
+        if (m_Desc.isSecondary)
+        {
+            // Bundles can't contain barriers, the primary command list is responsible for the resource states
+            m_StateTracker.discardBarriers();
+            return;
+        }
+
+        if (useEnhancedBarriers())
+        {
+            commitBarriersEnhanced();
+            return;
+        }
+
         // Allocate vector space for the barriers assuming 1:1 translation.
         // For partial transitions on multi-plane textures, original barriers may translate
         // into more than 1 barrier each, but that's relatively rare.
@@ -132,6 +165,7 @@ namespace nvrhi::d3d12
             if (stateBefore != stateAfter)
             {
                 d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                d3dbarrier.Flags = convertSplitBarrier(barrier.split);
                 d3dbarrier.Transition.StateBefore = stateBefore;
                 d3dbarrier.Transition.StateAfter = stateAfter;
                 d3dbarrier.Transition.pResource = resource;
@@ -142,13 +176,24 @@ namespace nvrhi::d3d12
                 }
                 else
                 {
-                    for (uint8_t plane = 0; plane < texture->planeCount; plane++)
+                    for (ArraySlice arraySlice = barrier.arraySlice; arraySlice < barrier.arraySlice + barrier.numArraySlices; arraySlice++)
                     {
-                        d3dbarrier.Transition.Subresource = calcSubresource(barrier.mipLevel, barrier.arraySlice, plane, texture->desc.mipLevels, texture->desc.arraySize);
-                        m_D3DBarriers.push_back(d3dbarrier);
+                        for (MipLevel mipLevel = barrier.mipLevel; mipLevel < barrier.mipLevel + barrier.numMipLevels; mipLevel++)
+                        {
+                            for (uint8_t plane = 0; plane < texture->planeCount; plane++)
+                            {
+                                d3dbarrier.Transition.Subresource = calcSubresource(mipLevel, arraySlice, plane, texture->desc.mipLevels, texture->desc.arraySize);
+                                m_D3DBarriers.push_back(d3dbarrier);
+                            }
+                        }
                     }
                 }
             }
+            else if (barrier.split != SplitBarrier::None)
+            {
+                // The states map to the same D3D state, nothing to do at either end of the split
+                continue;
+            }
             else if (stateAfter & D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
             {
                 d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
@@ -170,12 +215,18 @@ namespace nvrhi::d3d12
                 (stateAfter & D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE) == 0)
             {
                 d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                d3dbarrier.Flags = convertSplitBarrier(barrier.split);
                 d3dbarrier.Transition.StateBefore = stateBefore;
                 d3dbarrier.Transition.StateAfter = stateAfter;
                 d3dbarrier.Transition.pResource = buffer->resource;
                 d3dbarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
                 m_D3DBarriers.push_back(d3dbarrier);
             }
+            else if (barrier.split == SplitBarrier::Begin)
+            {
+                // Not a state transition on D3D12, the UAV barrier (if any) is placed at the end of the split
+                continue;
+            }
             else if ((barrier.stateBefore == ResourceStates::AccelStructWrite && (barrier.stateAfter & (ResourceStates::AccelStructRead | ResourceStates::AccelStructBuildBlas)) != 0) ||
                 (barrier.stateAfter == ResourceStates::AccelStructWrite && (barrier.stateBefore & (ResourceStates::AccelStructRead | ResourceStates::AccelStructBuildBlas)) != 0) ||
                 (barrier.stateBefore == ResourceStates::OpacityMicromapWrite && (barrier.stateAfter & (ResourceStates::AccelStructBuildInput)) != 0) ||
@@ -193,9 +244,169 @@ namespace nvrhi::d3d12
         m_StateTracker.clearBarriers();
     }
 
+    bool CommandList::useEnhancedBarriers() const
+    {
+        // Copy queues only support a small subset of the layouts, keep the legacy barriers there
+        return m_ActiveCommandList->commandList7 != nullptr && m_Desc.queueType != CommandQueue::Copy;
+    }
+
+    static bool hasWriteAccess(D3D12_BARRIER_ACCESS access)
+    {
+        constexpr D3D12_BARRIER_ACCESS writeAccess =
+            D3D12_BARRIER_ACCESS_RENDER_TARGET |
+            D3D12_BARRIER_ACCESS_UNORDERED_ACCESS |
+            D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE |
+            D3D12_BARRIER_ACCESS_STREAM_OUTPUT |
+            D3D12_BARRIER_ACCESS_COPY_DEST |
+            D3D12_BARRIER_ACCESS_RESOLVE_DEST |
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE;
+
+        // Common access includes everything the resource may have been used for
+        return access == D3D12_BARRIER_ACCESS_COMMON || (access & writeAccess) != 0;
+    }
+
+    static void setSplitBarrierSync(D3D12_BARRIER_SYNC& syncBefore, D3D12_BARRIER_SYNC& syncAfter, SplitBarrier split)
+    {
+        // The first half of a split barrier only waits for the previous work, the second half only blocks the next work
+        if (split == SplitBarrier::Begin)
+            syncAfter = D3D12_BARRIER_SYNC_SPLIT;
+        else if (split == SplitBarrier::End)
+            syncBefore = D3D12_BARRIER_SYNC_SPLIT;
+    }
+
+    void CommandList::commitBarriersEnhanced()
+    {
+        const auto& textureBarriers = m_StateTracker.getTextureBarriers();
+        const auto& bufferBarriers = m_StateTracker.getBufferBarriers();
+
+        m_D3DTextureBarriers.clear();
+        m_D3DBufferBarriers.clear();
+
+        for (const auto& barrier : textureBarriers)
+        {
+            D3D12_TEXTURE_BARRIER d3dbarrier{};
+            uint8_t planeCount = 1;
+
+            if (barrier.texture->isSamplerFeedback)
+            {
+                d3dbarrier.pResource = static_cast<const SamplerFeedbackTexture*>(barrier.texture)->resource;
+            }
+            else
+            {
+                const Texture* texture = static_cast<const Texture*>(barrier.texture);
+                d3dbarrier.pResource = texture->resource;
+                planeCount = texture->planeCount;
+            }
+
+            const BarrierStateMapping before = convertBarrierState(barrier.stateBefore);
+            const BarrierStateMapping after = convertBarrierState(barrier.stateAfter);
+
+            // Layout changes always need a barrier. With the layout unchanged, only writes need to be made visible,
+            // and a UAV-to-UAV dependency replaces the legacy UAV barrier.
+            const bool layoutChange = before.layout != after.layout;
+            if (!layoutChange && !hasWriteAccess(before.access) && !hasWriteAccess(after.access))
+                continue;
+            if (!layoutChange && barrier.stateBefore == barrier.stateAfter && (after.access & D3D12_BARRIER_ACCESS_UNORDERED_ACCESS) == 0)
+                continue;
+
+            d3dbarrier.SyncBefore = before.sync;
+            d3dbarrier.SyncAfter = after.sync;
+            d3dbarrier.AccessBefore = before.access;
+            d3dbarrier.AccessAfter = after.access;
+            d3dbarrier.LayoutBefore = before.layout;
+            d3dbarrier.LayoutAfter = after.layout;
+            setSplitBarrierSync(d3dbarrier.SyncBefore, d3dbarrier.SyncAfter, barrier.split);
+
+            if (barrier.entireTexture)
+            {
+                d3dbarrier.Subresources.IndexOrFirstMipLevel = D3D12_BARRIER_ALL_SUBRESOURCES;
+            }
+            else
+            {
+                // Enhanced Barriers take subresource ranges, so partial transitions don't need to be expanded
+                d3dbarrier.Subresources.IndexOrFirstMipLevel = barrier.mipLevel;
+                d3dbarrier.Subresources.NumMipLevels = barrier.numMipLevels;
+                d3dbarrier.Subresources.FirstArraySlice = barrier.arraySlice;
+                d3dbarrier.Subresources.NumArraySlices = barrier.numArraySlices;
+                d3dbarrier.Subresources.FirstPlane = 0;
+                d3dbarrier.Subresources.NumPlanes = planeCount;
+            }
+
+            // The first transition of a texture after aliasing discards the previous memory contents,
+            // there is nothing to wait for or to preserve. Both halves of a split barrier must match.
+            auto discard = std::find(m_TexturesToDiscard.begin(), m_TexturesToDiscard.end(), barrier.texture);
+            if (discard != m_TexturesToDiscard.end())
+            {
+                if (barrier.split != SplitBarrier::End)
+                    d3dbarrier.SyncBefore = D3D12_BARRIER_SYNC_NONE;
+                d3dbarrier.AccessBefore = D3D12_BARRIER_ACCESS_NO_ACCESS;
+                d3dbarrier.LayoutBefore = D3D12_BARRIER_LAYOUT_UNDEFINED;
+                d3dbarrier.Flags = D3D12_TEXTURE_BARRIER_FLAG_DISCARD;
+
+                // Other subresources stay undefined until their own first transition
+                if (barrier.entireTexture && barrier.split != SplitBarrier::Begin)
+                    m_TexturesToDiscard.erase(discard);
+            }
+
+            m_D3DTextureBarriers.push_back(d3dbarrier);
+        }
+
+        for (const auto& barrier : bufferBarriers)
+        {
+            const Buffer* buffer = static_cast<const Buffer*>(barrier.buffer);
+
+            const BarrierStateMapping before = convertBarrierState(barrier.stateBefore);
+            const BarrierStateMapping after = convertBarrierState(barrier.stateAfter);
+
+            // Buffers have no layouts, so transitions between read-only states need no synchronization at all.
+            // This also covers the acceleration structure states, which the legacy path can't transition.
+            if (!hasWriteAccess(before.access) && !hasWriteAccess(after.access))
+                continue;
+            if (barrier.stateBefore == barrier.stateAfter && (after.access & D3D12_BARRIER_ACCESS_UNORDERED_ACCESS) == 0 &&
+                (after.access & D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE) == 0)
+                continue;
+
+            D3D12_BUFFER_BARRIER d3dbarrier{};
+            d3dbarrier.SyncBefore = before.sync;
+            d3dbarrier.SyncAfter = after.sync;
+            d3dbarrier.AccessBefore = before.access;
+            d3dbarrier.AccessAfter = after.access;
+            d3dbarrier.pResource = buffer->resource;
+            d3dbarrier.Offset = 0;
+            d3dbarrier.Size = UINT64_MAX;
+            setSplitBarrierSync(d3dbarrier.SyncBefore, d3dbarrier.SyncAfter, barrier.split);
+
+            m_D3DBufferBarriers.push_back(d3dbarrier);
+        }
+
+        D3D12_BARRIER_GROUP groups[2];
+        uint32_t numGroups = 0;
+
+        if (!m_D3DTextureBarriers.empty())
+        {
+            groups[numGroups].Type = D3D12_BARRIER_TYPE_TEXTURE;
+            groups[numGroups].NumBarriers = uint32_t(m_D3DTextureBarriers.size());
+            groups[numGroups].pTextureBarriers = m_D3DTextureBarriers.data();
+            ++numGroups;
+        }
+
+        if (!m_D3DBufferBarriers.empty())
+        {
+            groups[numGroups].Type = D3D12_BARRIER_TYPE_BUFFER;
+            groups[numGroups].NumBarriers = uint32_t(m_D3DBufferBarriers.size());
+            groups[numGroups].pBufferBarriers = m_D3DBufferBarriers.data();
+            ++numGroups;
+        }
+
+        if (numGroups > 0)
+            m_ActiveCommandList->commandList7->Barrier(numGroups, groups);
+
+        m_StateTracker.clearBarriers();
+    }
+
     void CommandList::setEnableAutomaticBarriers(bool enable)
     {
-        m_EnableAutomaticBarriers = enable;
+        m_EnableAutomaticBarriers = enable && !m_Desc.isSecondary;
     }
 
     void CommandList::setEnableUavBarriersForTexture(ITexture* _texture, bool enableBarriers)
@@ -250,7 +461,7 @@ namespace nvrhi::d3d12
         m_StateTracker.requireTextureState(texture, subresources, stateBits);
 
         if (m_Instance)
-            m_Instance->referencedResources.push_back(texture);
+            m_Instance->referencedResources.add(texture);
     }
 
     void CommandList::setBufferState(IBuffer* _buffer, ResourceStates stateBits)
@@ -260,7 +471,7 @@ namespace nvrhi::d3d12
         m_StateTracker.requireBufferState(buffer, stateBits);
 
         if (m_Instance)
-            m_Instance->referencedResources.push_back(buffer);
+            m_Instance->referencedResources.add(buffer);
     }
 
     void CommandList::setAccelStructState(rt::IAccelStruct* _as, ResourceStates stateBits)
@@ -272,7 +483,7 @@ namespace nvrhi::d3d12
             m_StateTracker.requireBufferState(as->dataBuffer, stateBits);
             
             if (m_Instance)
-                m_Instance->referencedResources.push_back(as);
+                m_Instance->referencedResources.add(as);
         }
     }
 
@@ -283,7 +494,7 @@ namespace nvrhi::d3d12
         m_StateTracker.setPermanentTextureState(texture, AllSubresources, stateBits);
 
         if (m_Instance)
-            m_Instance->referencedResources.push_back(texture);
+            m_Instance->referencedResources.add(texture);
     }
 
     void CommandList::setPermanentBufferState(IBuffer* _buffer, ResourceStates stateBits)
@@ -293,7 +504,105 @@ namespace nvrhi::d3d12
         m_StateTracker.setPermanentBufferState(buffer, stateBits);
         
         if (m_Instance)
-            m_Instance->referencedResources.push_back(buffer);
+            m_Instance->referencedResources.add(buffer);
+    }
+
+    void CommandList::beginTextureStateTransition(ITexture* _texture, ResourceStates nextState)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, nextState);
+
+        if (m_Instance)
+            m_Instance->referencedResources.add(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates nextState)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer, nextState);
+
+        if (m_Instance)
+            m_Instance->referencedResources.add(buffer);
+    }
+
+    static ID3D12Resource* getAliasedResource(IResource* resource)
+    {
+        if (!resource)
+            return nullptr;
+
+        if (Texture* texture = dynamic_cast<Texture*>(resource))
+            return texture->resource;
+
+        if (Buffer* buffer = dynamic_cast<Buffer*>(resource))
+            return buffer->resource;
+
+        utils::InvalidEnum();
+        return nullptr;
+    }
+
+    void CommandList::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        commitBarriers();
+
+        if (useEnhancedBarriers())
+        {
+            // Enhanced Barriers have no aliasing barrier type: wait for all previous work, and let the next
+            // transition of 'resourceAfter' discard its contents from the undefined layout.
+            D3D12_GLOBAL_BARRIER globalBarrier{};
+            globalBarrier.SyncBefore = D3D12_BARRIER_SYNC_ALL;
+            globalBarrier.SyncAfter = D3D12_BARRIER_SYNC_ALL;
+            globalBarrier.AccessBefore = D3D12_BARRIER_ACCESS_COMMON;
+            globalBarrier.AccessAfter = D3D12_BARRIER_ACCESS_COMMON;
+
+            D3D12_BARRIER_GROUP group{};
+            group.Type = D3D12_BARRIER_TYPE_GLOBAL;
+            group.NumBarriers = 1;
+            group.pGlobalBarriers = &globalBarrier;
+            m_ActiveCommandList->commandList7->Barrier(1, &group);
+
+            if (Texture* texture = dynamic_cast<Texture*>(resourceAfter))
+            {
+                m_StateTracker.beginTrackingTextureState(texture, AllSubresources, ResourceStates::Common);
+                if (std::find(m_TexturesToDiscard.begin(), m_TexturesToDiscard.end(), texture) == m_TexturesToDiscard.end())
+                    m_TexturesToDiscard.push_back(texture);
+            }
+            else if (Buffer* buffer = dynamic_cast<Buffer*>(resourceAfter))
+            {
+                m_StateTracker.beginTrackingBufferState(buffer, ResourceStates::Common);
+            }
+        }
+        else
+        {
+            D3D12_RESOURCE_BARRIER d3dbarrier{};
+            d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+            d3dbarrier.Aliasing.pResourceBefore = getAliasedResource(resourceBefore);
+            d3dbarrier.Aliasing.pResourceAfter = getAliasedResource(resourceAfter);
+            m_ActiveCommandList->commandList->ResourceBarrier(1, &d3dbarrier);
+
+            // The first operation on an aliased render target or depth-stencil texture must be a clear, a copy
+            // or a discard, and the application may start with a partial clear or draw, so discard it right away
+            Texture* texture = dynamic_cast<Texture*>(resourceAfter);
+            if (texture && texture->desc.isRenderTarget)
+            {
+                const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
+                const bool isDepthStencil = formatInfo.hasDepth || formatInfo.hasStencil;
+
+                m_StateTracker.requireTextureState(texture, AllSubresources,
+                    isDepthStencil ? ResourceStates::DepthWrite : ResourceStates::RenderTarget);
+                commitBarriers();
+                m_ActiveCommandList->commandList->DiscardResource(texture->resource, nullptr);
+            }
+        }
+
+        if (m_Instance)
+        {
+            if (resourceBefore)
+                m_Instance->referencedResources.add(resourceBefore);
+            if (resourceAfter)
+                m_Instance->referencedResources.add(resourceAfter);
+        }
     }
 
     ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
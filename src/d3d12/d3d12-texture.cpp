@@ -43,15 +43,66 @@ namespace nvrhi::d3d12
         }
     }
 
+    int Texture::getDefaultViewSlot(ObjectType objectType, Format format, const TextureSubresourceSet& subresources,
+        TextureDimension dimension, bool isReadOnlyDSV) const
+    {
+        if ((format != Format::UNKNOWN && format != desc.format) ||
+            (dimension != TextureDimension::Unknown && dimension != desc.dimension))
+            return -1;
+
+        const bool isSRV = objectType == ObjectTypes::D3D12_ShaderResourceViewGpuDescripror;
+        const TextureSubresourceSet resolved = subresources.resolve(desc, !isSRV);
+        const TextureSubresourceSet expected(0, isSRV ? desc.mipLevels : 1, 0, desc.arraySize);
+        if (resolved != expected)
+            return -1;
+
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_ShaderResourceViewGpuDescripror: return DefaultSRV;
+        case ObjectTypes::D3D12_UnorderedAccessViewGpuDescripror: return DefaultUAV;
+        case ObjectTypes::D3D12_RenderTargetViewDescriptor: return DefaultRTV;
+        case ObjectTypes::D3D12_DepthStencilViewDescriptor: return isReadOnlyDSV ? DefaultReadOnlyDSV : DefaultDSV;
+        default: return -1;
+        }
+    }
+
+    Object Texture::getViewObject(ObjectType objectType, DescriptorIndex descriptorIndex) const
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_ShaderResourceViewGpuDescripror:
+        case ObjectTypes::D3D12_UnorderedAccessViewGpuDescripror:
+            return Object(m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorIndex).ptr);
+        case ObjectTypes::D3D12_RenderTargetViewDescriptor:
+            return Object(m_Resources.renderTargetViewHeap.getCpuHandle(descriptorIndex).ptr);
+        case ObjectTypes::D3D12_DepthStencilViewDescriptor:
+            return Object(m_Resources.depthStencilViewHeap.getCpuHandle(descriptorIndex).ptr);
+        default:
+            return nullptr;
+        }
+    }
+
     Object Texture::getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV)
     {
         static_assert(sizeof(void*) == sizeof(D3D12_CPU_DESCRIPTOR_HANDLE), "Cannot typecast a descriptor to void*");
-        
+
+        const int defaultSlot = getDefaultViewSlot(objectType, format, subresources, dimension, isReadOnlyDSV);
+        if (defaultSlot >= 0)
+        {
+            // The acquire pairs with the release below, which happens after the descriptor is written
+            const DescriptorIndex descriptorIndex = m_DefaultViews[defaultSlot].load(std::memory_order_acquire);
+            if (descriptorIndex != c_InvalidDescriptorIndex)
+                return getViewObject(objectType, descriptorIndex);
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        DescriptorIndex descriptorIndex;
+
         switch (objectType)
         {
         case nvrhi::ObjectTypes::D3D12_ShaderResourceViewGpuDescripror: {
             TextureBindingKey key = TextureBindingKey(subresources, format);
-            DescriptorIndex descriptorIndex;
             auto found = m_CustomSRVs.find(key);
             if (found == m_CustomSRVs.end())
             {
@@ -66,13 +117,11 @@ namespace nvrhi::d3d12
             {
                 descriptorIndex = found->second;
             }
-
-            return Object(m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorIndex).ptr);
+            break;
         }
 
         case nvrhi::ObjectTypes::D3D12_UnorderedAccessViewGpuDescripror: {
             TextureBindingKey key = TextureBindingKey(subresources, format);
-            DescriptorIndex descriptorIndex;
             auto found = m_CustomUAVs.find(key);
             if (found == m_CustomUAVs.end())
             {
@@ -87,13 +136,11 @@ namespace nvrhi::d3d12
             {
                 descriptorIndex = found->second;
             }
-
-            return Object(m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorIndex).ptr);
+            break;
         }
+
         case nvrhi::ObjectTypes::D3D12_RenderTargetViewDescriptor: {
             TextureBindingKey key = TextureBindingKey(subresources, format);
-            DescriptorIndex descriptorIndex;
-
             auto found = m_RenderTargetViews.find(key);
             if (found == m_RenderTargetViews.end())
             {
@@ -107,14 +154,11 @@ namespace nvrhi::d3d12
             {
                 descriptorIndex = found->second;
             }
-
-            return Object(m_Resources.renderTargetViewHeap.getCpuHandle(descriptorIndex).ptr);
+            break;
         }
 
         case nvrhi::ObjectTypes::D3D12_DepthStencilViewDescriptor: {
             TextureBindingKey key = TextureBindingKey(subresources, format, isReadOnlyDSV);
-            DescriptorIndex descriptorIndex;
-
             auto found = m_DepthStencilViews.find(key);
             if (found == m_DepthStencilViews.end())
             {
@@ -128,13 +172,17 @@ namespace nvrhi::d3d12
             {
                 descriptorIndex = found->second;
             }
-
-            return Object(m_Resources.depthStencilViewHeap.getCpuHandle(descriptorIndex).ptr);
+            break;
         }
 
         default:
             return nullptr;
         }
+
+        if (defaultSlot >= 0)
+            m_DefaultViews[defaultSlot].store(descriptorIndex, std::memory_order_release);
+
+        return getViewObject(objectType, descriptorIndex);
     }
 
     Texture::~Texture()
@@ -153,6 +201,15 @@ namespace nvrhi::d3d12
 
         for (auto pair : m_CustomUAVs)
             m_Resources.shaderResourceViewHeap.releaseDescriptor(pair.second);
+
+        if (placedAllocation.heap)
+        {
+            // Destroy the resource before its memory can be reused by another one
+            resource = nullptr;
+            m_Resources.placedResourceAllocator.release(placedAllocation);
+        }
+
+        m_Resources.residencyManager.unregisterResource(residency);
     }
 
     StagingTexture::SliceRegion StagingTexture::getSliceRegion(ID3D12Device *device, const TextureSlice& slice)
@@ -327,7 +384,31 @@ namespace nvrhi::d3d12
             rd.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
         }
 
+        // Render targets and depth-stencil surfaces need to be initialized after placement into reused memory,
+        // and MSAA textures need larger heap alignment, so only place the regular textures.
+        const bool usePlacedResource = !d.isVirtual && !d.isTiled && !isShared
+            && (rd.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) == 0
+            && rd.SampleDesc.Count == 1
+            && m_Resources.usePlacedResourceAllocator(d.allocationMode);
+
+        D3D12_RESOURCE_ALLOCATION_INFO allocInfo = {};
+        if (usePlacedResource)
+        {
+            // Try the 4 KB small resource alignment first, the runtime reports a larger alignment when it's not allowed
+            rd.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+            allocInfo = m_Context.device->GetResourceAllocationInfo(1, 1, &rd);
+
+            if (allocInfo.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+            {
+                rd.Alignment = 0;
+                allocInfo = m_Context.device->GetResourceAllocationInfo(1, 1, &rd);
+            }
+        }
+
         Texture* texture = new Texture(m_Context, m_Resources, d, rd);
+        // Virtual textures use the memory of the heaps they are bound to
+        texture->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::Texture,
+            d.isVirtual ? 0 : usePlacedResource ? allocInfo.SizeInBytes : estimateTextureMemorySize(d));
 
         D3D12_CLEAR_VALUE clearValue = convertTextureClearValue(d);
         HRESULT hr = S_OK;
@@ -350,13 +431,36 @@ namespace nvrhi::d3d12
         {
             heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
 
-            hr = m_Context.device->CreateCommittedResource(
-                &heapProps,
-                heapFlags,
-                &texture->resourceDesc,
-                convertResourceStates(d.initialState),
-                d.useClearValue ? &clearValue : nullptr,
-                IID_PPV_ARGS(&texture->resource));
+            if (usePlacedResource && m_Resources.placedResourceAllocator.allocate(allocInfo, heapProps.Type,
+                PlacedResourceCategory::NonTargetTexture, texture->placedAllocation))
+            {
+                hr = m_Context.device->CreatePlacedResource(
+                    texture->placedAllocation.heap->heap,
+                    texture->placedAllocation.offset,
+                    &texture->resourceDesc,
+                    convertResourceStates(d.initialState),
+                    d.useClearValue ? &clearValue : nullptr,
+                    IID_PPV_ARGS(&texture->resource));
+
+                // Fall back to a committed resource if placement failed for any reason
+                if (FAILED(hr))
+                    m_Resources.placedResourceAllocator.release(texture->placedAllocation);
+            }
+
+            if (!texture->resource)
+            {
+                // Committed resources don't use the small alignment that may have been selected above
+                D3D12_RESOURCE_DESC committedDesc = texture->resourceDesc;
+                committedDesc.Alignment = 0;
+
+                hr = m_Context.device->CreateCommittedResource(
+                    &heapProps,
+                    heapFlags,
+                    &committedDesc,
+                    convertResourceStates(d.initialState),
+                    d.useClearValue ? &clearValue : nullptr,
+                    IID_PPV_ARGS(&texture->resource));
+            }
         }
 
         if (FAILED(hr))
@@ -393,6 +497,11 @@ namespace nvrhi::d3d12
             }
         }
 
+        if (!texture->placedAllocation.heap && !d.isTiled && !isShared)
+        {
+            m_Resources.residencyManager.registerResource(texture->residency, texture->resource, d.residencyPriority);
+        }
+
         texture->postCreate();
 
         return TextureHandle::Create(texture);
@@ -460,6 +569,7 @@ namespace nvrhi::d3d12
 
         Texture* texture = new Texture(m_Context, m_Resources, desc, pResource->GetDesc());
         texture->resource = pResource;
+        texture->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::Texture, estimateTextureMemorySize(desc));
         texture->postCreate();
 
         return TextureHandle::Create(texture);
@@ -491,6 +601,9 @@ namespace nvrhi::d3d12
     {
         assert(desc.isUAV);
 
+        // Clears are recorded free-threaded, and are not frequent enough to need lock-free reads
+        std::lock_guard lockGuard(m_Mutex);
+
         DescriptorIndex descriptorIndex = m_ClearMipLevelUAVs[mipLevel];
 
         if (descriptorIndex != c_InvalidDescriptorIndex)
@@ -511,6 +624,7 @@ namespace nvrhi::d3d12
 
         StagingTexture *ret = new StagingTexture();
         ret->desc = d;
+        ret->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::StagingTexture);
         ret->resourceDesc = convertTextureDesc(d);
         ret->computeSubresourceOffsets(m_Context.device);
 
@@ -823,7 +937,7 @@ namespace nvrhi::d3d12
 
         if (tex->lastUseFence)
         {
-            WaitForFence(tex->lastUseFence, tex->lastUseFenceValue, m_FenceEvent);
+            waitForQueueFence(tex->lastUseFence, tex->lastUseFenceValue);
             tex->lastUseFence = nullptr;
         }
 
@@ -981,7 +1095,7 @@ namespace nvrhi::d3d12
 
         subresources = subresources.resolve(t->desc, false);
 
-        m_Instance->referencedResources.push_back(t);
+        m_Instance->referencedResources.add(t);
 
         if (t->desc.isRenderTarget)
         {
@@ -1042,7 +1156,7 @@ namespace nvrhi::d3d12
 
         subresources = subresources.resolve(t->desc, false);
 
-        m_Instance->referencedResources.push_back(t);
+        m_Instance->referencedResources.add(t);
 
         if (m_EnableAutomaticBarriers)
         {
@@ -1085,7 +1199,7 @@ namespace nvrhi::d3d12
 
         uint32_t clearValues[4] = { clearColor, clearColor, clearColor, clearColor };
 
-        m_Instance->referencedResources.push_back(t);
+        m_Instance->referencedResources.add(t);
 
         if (t->desc.isUAV)
         {
@@ -1207,8 +1321,8 @@ namespace nvrhi::d3d12
         }
         commitBarriers();
 
-        m_Instance->referencedResources.push_back(dst);
-        m_Instance->referencedResources.push_back(src);
+        m_Instance->referencedResources.add(dst);
+        m_Instance->referencedResources.add(src);
 
         m_ActiveCommandList->commandList->CopyTextureRegion(&dstLocation,
             resolvedDstSlice.x,
@@ -1235,7 +1349,7 @@ namespace nvrhi::d3d12
         }
         commitBarriers();
 
-        m_Instance->referencedResources.push_back(dst);
+        m_Instance->referencedResources.add(dst);
         m_Instance->referencedStagingTextures.push_back(src);
 
         auto srcRegion = src->getSliceRegion(m_Context.device, resolvedSrcSlice);
@@ -1279,7 +1393,7 @@ namespace nvrhi::d3d12
         }
         commitBarriers();
 
-        m_Instance->referencedResources.push_back(src);
+        m_Instance->referencedResources.add(src);
         m_Instance->referencedStagingTextures.push_back(dst);
 
         auto dstRegion = dst->getSliceRegion(m_Context.device, resolvedDstSlice);
@@ -1306,16 +1420,10 @@ namespace nvrhi::d3d12
             &srcLocation, &srcBox);
     }
 
-    void CommandList::writeTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    MappedWriteRegion CommandList::beginWriteTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel)
     {
         Texture* dest = checked_cast<Texture*>(_dest);
 
-        if (m_EnableAutomaticBarriers)
-        {
-            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
-        }
-        commitBarriers();
-
         uint32_t subresource = calcSubresource(mipLevel, arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
 
         D3D12_RESOURCE_DESC resourceDesc = dest->resource->GetDesc();
@@ -1327,47 +1435,112 @@ namespace nvrhi::d3d12
         m_Context.device->GetCopyableFootprints(&resourceDesc, subresource, 1, 0, &footprint, &numRows, &rowSizeInBytes, &totalBytes);
 
         void* cpuVA;
-        ID3D12Resource* uploadBuffer;
-        size_t offsetInUploadBuffer;
-        if (!m_UploadManager.suballocateBuffer(totalBytes, nullptr, &uploadBuffer, &offsetInUploadBuffer, &cpuVA, nullptr, 
+        if (!m_UploadManager.suballocateBuffer(totalBytes, nullptr, &m_PendingWrite.uploadBuffer, &m_PendingWrite.uploadOffset, &cpuVA, nullptr,
             m_RecordingVersion, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT))
         {
             m_Context.error("Couldn't suballocate an upload buffer");
-            return;
+            return MappedWriteRegion();
         }
-        footprint.Offset = uint64_t(offsetInUploadBuffer);
+        footprint.Offset = uint64_t(m_PendingWrite.uploadOffset);
 
         assert(numRows <= footprint.Footprint.Height);
 
-        for (uint32_t depthSlice = 0; depthSlice < footprint.Footprint.Depth; depthSlice++)
+        m_PendingWrite.texture = dest;
+        m_PendingWrite.arraySlice = arraySlice;
+        m_PendingWrite.mipLevel = mipLevel;
+        m_PendingWrite.subresource = subresource;
+        m_PendingWrite.rowSizeInBytes = rowSizeInBytes;
+        m_PendingWrite.footprint = footprint;
+        m_PendingWrite.size = size_t(totalBytes);
+        m_Stats.uploadBytes += totalBytes;
+
+        MappedWriteRegion region;
+        region.data = cpuVA;
+        region.rowPitch = footprint.Footprint.RowPitch;
+        region.depthPitch = size_t(footprint.Footprint.RowPitch) * numRows;
+        region.size = size_t(totalBytes);
+        return region;
+    }
+
+    void CommandList::commitWrite()
+    {
+        PendingWrite& write = m_PendingWrite;
+
+        if (!write.texture && !write.buffer)
+            return;
+
+        if (write.uploadBuffer != m_CurrentUploadBuffer)
         {
-            for (uint32_t row = 0; row < numRows; row++)
+            m_Instance->referencedNativeResources.push_back(write.uploadBuffer);
+            m_CurrentUploadBuffer = write.uploadBuffer;
+        }
+
+        if (write.texture)
+        {
+            Texture* dest = checked_cast<Texture*>(write.texture.Get());
+
+            if (m_EnableAutomaticBarriers)
             {
-                void* destAddress = (char*)cpuVA + uint64_t(footprint.Footprint.RowPitch) * uint64_t(row + depthSlice * numRows);
-                const void* srcAddress = (const char*)data + rowPitch * row + depthPitch * depthSlice;
-                memcpy(destAddress, srcAddress, std::min(rowPitch, rowSizeInBytes));
+                requireTextureState(dest, TextureSubresourceSet(write.mipLevel, 1, write.arraySlice, 1), ResourceStates::CopyDest);
             }
-        }
+            commitBarriers();
 
-        D3D12_TEXTURE_COPY_LOCATION destCopyLocation;
-        destCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-        destCopyLocation.SubresourceIndex = subresource;
-        destCopyLocation.pResource = dest->resource;
+            D3D12_TEXTURE_COPY_LOCATION destCopyLocation;
+            destCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            destCopyLocation.SubresourceIndex = write.subresource;
+            destCopyLocation.pResource = dest->resource;
 
-        D3D12_TEXTURE_COPY_LOCATION srcCopyLocation;
-        srcCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-        srcCopyLocation.PlacedFootprint = footprint;
-        srcCopyLocation.pResource = uploadBuffer;
+            D3D12_TEXTURE_COPY_LOCATION srcCopyLocation;
+            srcCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            srcCopyLocation.PlacedFootprint = write.footprint;
+            srcCopyLocation.pResource = write.uploadBuffer;
 
-        m_Instance->referencedResources.push_back(dest);
+            m_Instance->referencedResources.add(dest);
 
-        if (uploadBuffer != m_CurrentUploadBuffer)
+            m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
+        }
+        else
         {
-            m_Instance->referencedNativeResources.push_back(uploadBuffer);
-            m_CurrentUploadBuffer = uploadBuffer;
+            Buffer* buffer = checked_cast<Buffer*>(write.buffer.Get());
+
+            if (buffer->desc.isVolatile)
+            {
+                m_VolatileConstantBufferAddresses[buffer] = write.uploadGpuVA;
+                m_AnyVolatileBufferWrites = true;
+            }
+            else
+            {
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(buffer, ResourceStates::CopyDest);
+                }
+                commitBarriers();
+
+                m_Instance->referencedResources.add(buffer);
+
+                m_ActiveCommandList->commandList->CopyBufferRegion(buffer->resource, write.destOffset, write.uploadBuffer, write.uploadOffset, write.size);
+            }
         }
 
-        m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
+        write.texture = nullptr;
+        write.buffer = nullptr;
+        write.uploadBuffer = nullptr;
+    }
+
+    void CommandList::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        const MappedWriteRegion region = beginWriteTexture(dest, arraySlice, mipLevel);
+        if (!region.data)
+            return;
+
+        const D3D12_SUBRESOURCE_FOOTPRINT& footprint = m_PendingWrite.footprint.Footprint;
+        const uint32_t numRows = uint32_t(region.depthPitch / region.rowPitch);
+        const size_t rowSizeInBytes = std::min(rowPitch, size_t(m_PendingWrite.rowSizeInBytes));
+
+        utils::CopyTextureRows(region.data, region.rowPitch, region.depthPitch, data, rowPitch, depthPitch,
+            rowSizeInBytes, numRows, footprint.Depth);
+
+        commitWrite();
     }
 
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
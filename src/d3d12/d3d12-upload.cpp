@@ -37,12 +37,14 @@ namespace nvrhi::d3d12
         }
     }
     
-    UploadManager::UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+    UploadManager::UploadManager(const Context& context, class Queue* pQueue, DeviceStatsTracker& stats, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer, uint64_t ringBufferSize)
         : m_Context(context)
         , m_Queue(pQueue)
+        , m_Stats(stats)
         , m_DefaultChunkSize(defaultChunkSize)
         , m_MemoryLimit(memoryLimit)
         , m_IsScratchBuffer(isScratchBuffer)
+        , m_RingBufferSize(ringBufferSize)
     {
         assert(pQueue);
     }
@@ -53,8 +55,13 @@ namespace nvrhi::d3d12
 
         size = align(size, BufferChunk::c_sizeAlignment);
 
+        // Volatile constant buffers and other per-frame data are read by shaders straight from the upload chunks,
+        // so place the chunks into CPU-visible video memory when it's available.
         D3D12_HEAP_PROPERTIES heapProps = {};
-        heapProps.Type = m_IsScratchBuffer ? D3D12_HEAP_TYPE_DEFAULT : D3D12_HEAP_TYPE_UPLOAD;
+        if (m_IsScratchBuffer)
+            heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+        else
+            heapProps.Type = m_Context.gpuUploadHeapSupported ? D3D12_HEAP_TYPE_GPU_UPLOAD : D3D12_HEAP_TYPE_UPLOAD;
 
         D3D12_RESOURCE_DESC bufferDesc = {};
         bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -74,6 +81,18 @@ namespace nvrhi::d3d12
             nullptr,
             IID_PPV_ARGS(&chunk->buffer));
 
+        if (FAILED(hr) && heapProps.Type == D3D12_HEAP_TYPE_GPU_UPLOAD)
+        {
+            heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+            hr = m_Context.device->CreateCommittedResource(
+                &heapProps,
+                D3D12_HEAP_FLAG_NONE,
+                &bufferDesc,
+                D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                IID_PPV_ARGS(&chunk->buffer));
+        }
+
         if (FAILED(hr))
             return nullptr;
 
@@ -88,6 +107,7 @@ namespace nvrhi::d3d12
         chunk->bufferSize = size;
         chunk->gpuVA = chunk->buffer->GetGPUVirtualAddress();
         chunk->identifier = uint32_t(m_ChunkPool.size());
+        chunk->statsEntry.setUploadChunk(&m_Stats, size);
 
         std::wstringstream wss;
         if (m_IsScratchBuffer)
@@ -99,12 +119,110 @@ namespace nvrhi::d3d12
         return chunk;
     }
         
+    bool UploadManager::tryAllocateFromRing(uint64_t size, uint32_t alignment, uint64_t currentVersion, uint64_t* pOffset)
+    {
+        // An empty allocation would leave the head at the tail while a region is in flight,
+        // which looks like a full ring until that region retires, so it takes one byte
+        size = std::max<uint64_t>(size, 1);
+
+        if (m_RingRegions.empty())
+        {
+            // Nothing is in flight, start from the beginning to avoid wrapping
+            m_RingHead = 0;
+            m_RingTail = 0;
+        }
+
+        // The head and the tail are only equal when the ring is empty,
+        // so allocations never fill the free space up to the tail completely.
+        uint64_t offset = align(m_RingHead, (uint64_t)alignment);
+        if (m_RingRegions.empty() || m_RingHead > m_RingTail)
+        {
+            if (offset + size > m_RingBuffer->bufferSize)
+            {
+                // Wrap around to the beginning of the ring
+                if (m_RingRegions.empty() || size >= m_RingTail)
+                    return false;
+
+                offset = 0;
+            }
+        }
+        else if (offset + size >= m_RingTail)
+        {
+            return false;
+        }
+
+        m_RingHead = offset + size;
+
+        if (!m_RingRegions.empty() && m_RingRegions.back().version == currentVersion)
+            m_RingRegions.back().end = m_RingHead;
+        else
+            m_RingRegions.push_back(RingRegion{ m_RingHead, currentVersion });
+
+        *pOffset = offset;
+        return true;
+    }
+
+    void UploadManager::retireRingRegions(uint64_t completedInstance)
+    {
+        while (!m_RingRegions.empty())
+        {
+            const RingRegion& region = m_RingRegions.front();
+
+            if (!VersionGetSubmitted(region.version) || VersionGetInstance(region.version) > completedInstance)
+                break;
+
+            m_RingTail = region.end;
+            m_RingRegions.pop_front();
+        }
+    }
+
     bool UploadManager::suballocateBuffer(uint64_t size, ID3D12GraphicsCommandList* pCommandList, ID3D12Resource** pBuffer, size_t* pOffset,
         void** pCpuVA, D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint64_t currentVersion, uint32_t alignment)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::suballocateBuffer");
+
         // Scratch allocations need a command list, upload ones don't
         assert(!m_IsScratchBuffer || pCommandList);
 
+        if (m_RingBufferSize > 0 && size <= m_RingBufferSize)
+        {
+            if (!m_RingBuffer)
+            {
+                m_RingBuffer = createChunk(m_RingBufferSize);
+
+                if (!m_RingBuffer)
+                {
+                    // Could not create the ring, use the chunks from now on
+                    m_RingBufferSize = 0;
+                }
+            }
+
+            if (m_RingBuffer)
+            {
+                uint64_t offset = 0;
+                bool allocated = tryAllocateFromRing(size, alignment, currentVersion, &offset);
+
+                if (!allocated)
+                {
+                    // Only query the fence when the ring is out of space
+                    retireRingRegions(m_Queue->updateLastCompletedInstance());
+                    allocated = tryAllocateFromRing(size, alignment, currentVersion, &offset);
+                }
+
+                if (allocated)
+                {
+                    if (pBuffer) *pBuffer = m_RingBuffer->buffer;
+                    if (pOffset) *pOffset = offset;
+                    if (pCpuVA) *pCpuVA = (char*)m_RingBuffer->cpuVA + offset;
+                    if (pGpuVA) *pGpuVA = m_RingBuffer->gpuVA + offset;
+
+                    return true;
+                }
+            }
+
+            // The ring is full of in-flight data, fall back to the chunks
+        }
+
         std::shared_ptr<BufferChunk> chunkToRetire;
 
         // Try to allocate from the current chunk first
@@ -251,5 +369,11 @@ namespace nvrhi::d3d12
             if (chunk->version == currentVersion)
                 chunk->version = submittedVersion;
         }
+
+        // Regions of the current recording are always at the head of the ring
+        for (auto it = m_RingRegions.rbegin(); it != m_RingRegions.rend() && it->version == currentVersion; ++it)
+        {
+            it->version = submittedVersion;
+        }
     }
 } // namespace nvrhi::d3d12
@@ -0,0 +1,237 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::d3d12
+{
+    static const wchar_t* c_WorkGraphProgramName = L"nvrhi_WorkGraph";
+
+    Object WorkGraphPipeline::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_RootSignature:
+            return rootSignature->getNativeObject(objectType);
+        case ObjectTypes::D3D12_StateObject:
+            return Object(stateObject.Get());
+        default:
+            return nullptr;
+        }
+    }
+
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+
+    WorkGraphPipelineHandle Device::createWorkGraphPipeline(const WorkGraphPipelineDesc& desc)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::d3d12::createWorkGraphPipeline");
+
+        if (!m_WorkGraphsSupported)
+        {
+            m_Context.error("Work graphs are not supported by this device");
+            return nullptr;
+        }
+
+        ShaderLibrary* library = checked_cast<ShaderLibrary*>(desc.shaderLibrary.Get());
+        RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
+
+        // The node names must stay in place while the entry points point at them
+        std::vector<std::wstring> entrypointNames;
+        std::vector<D3D12_NODE_ID> entrypoints;
+        entrypointNames.reserve(desc.nodes.size());
+        for (const WorkGraphNodeDesc& node : desc.nodes)
+        {
+            if (node.producerNode < 0)
+            {
+                entrypointNames.push_back(std::wstring(node.name.begin(), node.name.end()));
+                entrypoints.push_back({ entrypointNames.back().c_str(), node.arrayIndex });
+            }
+        }
+
+        D3D12_DXIL_LIBRARY_DESC libraryDesc = {};
+        libraryDesc.DXILLibrary.pShaderBytecode = library->bytecode.data();
+        libraryDesc.DXILLibrary.BytecodeLength = library->bytecode.size();
+
+        D3D12_GLOBAL_ROOT_SIGNATURE globalRootSignature = {};
+        globalRootSignature.pGlobalRootSignature = pRS->handle;
+
+        // The other nodes of the graph are found in the library from the node outputs of the entry points
+        D3D12_WORK_GRAPH_DESC workGraphDesc = {};
+        workGraphDesc.ProgramName = c_WorkGraphProgramName;
+        workGraphDesc.Flags = D3D12_WORK_GRAPH_FLAG_INCLUDE_ALL_AVAILABLE_NODES;
+        workGraphDesc.NumEntrypoints = UINT(entrypoints.size());
+        workGraphDesc.pEntrypoints = entrypoints.data();
+
+        D3D12_STATE_SUBOBJECT subobjects[3] = {};
+        subobjects[0].Type = D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY;
+        subobjects[0].pDesc = &libraryDesc;
+        subobjects[1].Type = D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE;
+        subobjects[1].pDesc = &globalRootSignature;
+        subobjects[2].Type = D3D12_STATE_SUBOBJECT_TYPE_WORK_GRAPH;
+        subobjects[2].pDesc = &workGraphDesc;
+
+        D3D12_STATE_OBJECT_DESC stateObjectDesc = {};
+        stateObjectDesc.Type = D3D12_STATE_OBJECT_TYPE_EXECUTABLE;
+        stateObjectDesc.NumSubobjects = UINT(std::size(subobjects));
+        stateObjectDesc.pSubobjects = subobjects;
+
+        RefCountPtr<ID3D12StateObject> stateObject;
+        HRESULT hr = m_Context.device5->CreateStateObject(&stateObjectDesc, IID_PPV_ARGS(&stateObject));
+        if (FAILED(hr))
+        {
+            m_Context.error("Failed to create a work graph state object");
+            return nullptr;
+        }
+
+        RefCountPtr<ID3D12StateObjectProperties1> stateObjectProperties;
+        RefCountPtr<ID3D12WorkGraphProperties> workGraphProperties;
+        if (FAILED(stateObject->QueryInterface(IID_PPV_ARGS(&stateObjectProperties))) ||
+            FAILED(stateObject->QueryInterface(IID_PPV_ARGS(&workGraphProperties))))
+        {
+            m_Context.error("Failed to query the work graph properties");
+            return nullptr;
+        }
+
+        const UINT workGraphIndex = workGraphProperties->GetWorkGraphIndex(c_WorkGraphProgramName);
+
+        D3D12_WORK_GRAPH_MEMORY_REQUIREMENTS memoryRequirements = {};
+        workGraphProperties->GetWorkGraphMemoryRequirements(workGraphIndex, &memoryRequirements);
+
+        WorkGraphPipeline* pso = new WorkGraphPipeline();
+        pso->desc = desc;
+        pso->statsEntry.set(&m_Resources.deviceStats, LiveObjectType::WorkGraphPipeline);
+        pso->rootSignature = pRS;
+        pso->stateObject = stateObject;
+        pso->programIdentifier = stateObjectProperties->GetProgramIdentifier(c_WorkGraphProgramName);
+        pso->memoryRequirements.minSize = memoryRequirements.MinSizeInBytes;
+        pso->memoryRequirements.maxSize = memoryRequirements.MaxSizeInBytes;
+        pso->memoryRequirements.sizeGranularity = memoryRequirements.SizeGranularityInBytes;
+
+        pso->entrypointIndices.resize(desc.nodes.size(), ~0u);
+        for (size_t index = 0, entry = 0; index < desc.nodes.size(); index++)
+        {
+            if (desc.nodes[index].producerNode < 0)
+                pso->entrypointIndices[index] = workGraphProperties->GetEntrypointIndex(workGraphIndex, entrypoints[entry++]);
+        }
+
+        return WorkGraphPipelineHandle::Create(pso);
+    }
+
+    void CommandList::setWorkGraphState(const WorkGraphState& state)
+    {
+        WorkGraphPipeline* pso = checked_cast<WorkGraphPipeline*>(state.pipeline);
+        Buffer* backingMemory = checked_cast<Buffer*>(state.backingMemory);
+
+        // Work graphs use the compute root signature and bindings
+        const bool updateRootSignature = !m_CurrentWorkGraphStateValid || m_CurrentWorkGraphState.pipeline == nullptr ||
+            checked_cast<WorkGraphPipeline*>(m_CurrentWorkGraphState.pipeline)->rootSignature != pso->rootSignature;
+
+        uint32_t bindingUpdateMask = 0;
+        if (!m_CurrentWorkGraphStateValid || updateRootSignature)
+            bindingUpdateMask = ~0u;
+
+        if (commitDescriptorHeaps())
+            bindingUpdateMask = ~0u;
+
+        if (bindingUpdateMask == 0)
+            bindingUpdateMask = arrayDifferenceMask(m_CurrentWorkGraphState.bindings, state.bindings);
+
+        if (updateRootSignature)
+        {
+            m_ActiveCommandList->commandList->SetComputeRootSignature(pso->rootSignature->handle);
+        }
+
+        setComputeBindings(state.bindings, bindingUpdateMask, nullptr, false, pso->rootSignature);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(backingMemory, ResourceStates::UnorderedAccess);
+        }
+
+        m_Instance->referencedResources.add(pso);
+        m_Instance->referencedResources.add(backingMemory);
+
+        commitBarriers();
+
+        // Setting the program again without initialization keeps the state of the graph in the backing memory
+        D3D12_SET_PROGRAM_DESC programDesc = {};
+        programDesc.Type = D3D12_PROGRAM_TYPE_WORK_GRAPH;
+        programDesc.WorkGraph.ProgramIdentifier = pso->programIdentifier;
+        programDesc.WorkGraph.Flags = state.initializeBackingMemory ? D3D12_SET_WORK_GRAPH_FLAG_INITIALIZE : D3D12_SET_WORK_GRAPH_FLAG_NONE;
+        programDesc.WorkGraph.BackingMemory.StartAddress = backingMemory->gpuVA;
+        programDesc.WorkGraph.BackingMemory.SizeInBytes = backingMemory->desc.byteSize;
+
+        m_ActiveCommandList->commandList10->SetProgram(&programDesc);
+        ++m_Stats.pipelineBinds;
+
+        unbindShadingRateState();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = true;
+        m_CurrentWorkGraphState = state;
+    }
+
+    void CommandList::dispatchGraph(const WorkGraphDispatchArguments& args)
+    {
+        WorkGraphPipeline* pso = checked_cast<WorkGraphPipeline*>(m_CurrentWorkGraphState.pipeline);
+        assert(pso); // validation layer handles this
+
+        updateComputeVolatileBuffers();
+        ++m_Stats.dispatches;
+
+        // The runtime copies the input records during the call
+        D3D12_DISPATCH_GRAPH_DESC dispatchDesc = {};
+        dispatchDesc.Mode = D3D12_DISPATCH_MODE_NODE_CPU_INPUT;
+        dispatchDesc.NodeCPUInput.EntrypointIndex = pso->entrypointIndices[args.entryNode];
+        dispatchDesc.NodeCPUInput.NumRecords = args.numRecords;
+        dispatchDesc.NodeCPUInput.pRecords = args.records;
+        dispatchDesc.NodeCPUInput.RecordStrideInBytes = args.recordStride;
+
+        m_ActiveCommandList->commandList10->DispatchGraph(&dispatchDesc);
+    }
+
+#else // NVRHI_D3D12_WITH_WORK_GRAPHS
+
+    WorkGraphPipelineHandle Device::createWorkGraphPipeline(const WorkGraphPipelineDesc&)
+    {
+        m_Context.error("NVRHI was built without work graph support, which requires the Agility SDK 1.613 or newer");
+        return nullptr;
+    }
+
+    void CommandList::setWorkGraphState(const WorkGraphState&)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::dispatchGraph(const WorkGraphDispatchArguments&)
+    {
+        utils::NotSupported();
+    }
+
+#endif // NVRHI_D3D12_WITH_WORK_GRAPHS
+
+} // namespace nvrhi::d3d12
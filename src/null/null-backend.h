@@ -0,0 +1,789 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/null.h>
+#include <nvrhi/utils.h>
+#include <nvrhi/common/aftermath.h>
+#include "../common/device-stats.h"
+#include "../common/object-pool.h"
+#include "../common/profile-hooks.h"
+#include "../common/resource-references.h"
+#include "../common/state-tracking.h"
+#include "../common/versioning.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi::null
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct Context
+    {
+        IMessageCallback* messageCallback = nullptr;
+        std::chrono::microseconds completionLatency{ 0 };
+
+        // Fake GPU virtual addresses, so that buffers and acceleration structures have distinct non-zero addresses
+        std::atomic<uint64_t> nextGpuAddress = 0x10000;
+
+        uint64_t allocateGpuAddress(uint64_t size);
+        void error(const std::string& message) const;
+    };
+
+    class CommandListInstance;
+
+    // Emulates a command queue: submissions get increasing instance numbers like fence values,
+    // and are considered completed when their completion time has passed.
+    class Queue
+    {
+    public:
+        const CommandQueue queueType;
+        DeviceStatsTracker& stats;
+        std::atomic<uint64_t> recordingInstance = 1;
+        uint64_t lastSubmittedInstance = 0;
+
+        Queue(CommandQueue type, DeviceStatsTracker& stats) : queueType(type), stats(stats) { }
+
+        // Returns the instance submitted with the command list instances, which are kept alive until it completes
+        uint64_t submit(std::vector<std::shared_ptr<CommandListInstance>>&& instances, std::chrono::microseconds latency);
+        // Makes the next submission complete no earlier than an instance on another queue
+        void waitForQueue(Queue* otherQueue, uint64_t instance);
+
+        // Releases the completed submissions and returns the last completed instance
+        uint64_t updateLastCompletedInstance();
+        [[nodiscard]] bool isInstanceCompleted(uint64_t instance) { return updateLastCompletedInstance() >= instance; }
+        // Blocks the calling thread until the instance has completed
+        void waitForInstance(uint64_t instance);
+        // Returns the simulated completion time of the instance, or a default time point if it's not in flight
+        [[nodiscard]] Clock::time_point getCompletionTime(uint64_t instance);
+
+    private:
+        struct Submission
+        {
+            uint64_t instance = 0;
+            Clock::time_point completionTime;
+            std::vector<std::shared_ptr<CommandListInstance>> instances;
+        };
+
+        std::mutex m_Mutex;
+        std::deque<Submission> m_SubmissionsInFlight;
+        uint64_t m_LastCompletedInstance = 0;
+        Clock::time_point m_LastCompletionTime;
+        Clock::time_point m_PendingWaitTime;
+    };
+
+    class Heap : public RefCounter<IHeap>
+    {
+    public:
+        HeapDesc desc;
+        DeviceStatsEntry statsEntry;
+
+        explicit Heap(const HeapDesc& desc) : desc(desc) { }
+        const HeapDesc& getDesc() override { return desc; }
+    };
+
+    class Texture : public RefCounter<ITexture>, public TextureStateExtension
+    {
+    public:
+        const TextureDesc desc;
+        HeapHandle heap;
+        DeviceStatsEntry statsEntry;
+
+        explicit Texture(TextureDesc desc)
+            : TextureStateExtension(this->desc)
+            , desc(std::move(desc))
+        {
+            TextureStateExtension::stateInitialized = true;
+        }
+
+        const TextureDesc& getDesc() const override { return desc; }
+        Object getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV = false) override;
+    };
+
+    class StagingTexture : public RefCounter<IStagingTexture>
+    {
+    public:
+        const TextureDesc desc;
+        const CpuAccessMode cpuAccess;
+        std::vector<uint8_t> memory;
+
+        // Offsets and pitches of the subresources in 'memory', indexed by arraySlice * mipLevels + mipLevel
+        struct SubresourceLayout
+        {
+            size_t offset = 0;
+            size_t rowPitch = 0;
+            size_t depthPitch = 0;
+        };
+        std::vector<SubresourceLayout> subresources;
+        DeviceStatsEntry statsEntry;
+
+        Queue* lastUseQueue = nullptr;
+        uint64_t lastUseInstance = 0;
+
+        StagingTexture(TextureDesc desc, CpuAccessMode cpuAccess);
+
+        const TextureDesc& getDesc() const override { return desc; }
+    };
+
+    class Buffer : public RefCounter<IBuffer>, public BufferStateExtension
+    {
+    public:
+        const BufferDesc desc;
+        GpuVirtualAddress gpuAddress = 0;
+        HeapHandle heap;
+        DeviceStatsEntry statsEntry;
+
+        // Only CPU-accessible buffers have memory, because the commands never access the buffer data
+        std::vector<uint8_t> memory;
+
+        Queue* lastUseQueue = nullptr;
+        uint64_t lastUseInstance = 0;
+
+        explicit Buffer(BufferDesc desc)
+            : BufferStateExtension(this->desc)
+            , desc(std::move(desc))
+        { }
+
+        const BufferDesc& getDesc() const override { return desc; }
+        GpuVirtualAddress getGpuVirtualAddress() const override { return gpuAddress; }
+    };
+
+    class Shader : public RefCounter<IShader>
+    {
+    public:
+        ShaderDesc desc;
+        std::shared_ptr<std::vector<uint8_t>> bytecode;
+        std::vector<ShaderSpecialization> specializationConstants;
+
+        const ShaderDesc& getDesc() const override { return desc; }
+        void getBytecode(const void** ppBytecode, size_t* pSize) const override;
+    };
+
+    class ShaderLibrary : public RefCounter<IShaderLibrary>
+    {
+    public:
+        std::shared_ptr<std::vector<uint8_t>> bytecode;
+
+        void getBytecode(const void** ppBytecode, size_t* pSize) const override;
+        ShaderHandle getShader(const char* entryName, ShaderType shaderType) override;
+    };
+
+    class Sampler : public RefCounter<ISampler>
+    {
+    public:
+        SamplerDesc desc;
+        DeviceStatsEntry statsEntry;
+
+        explicit Sampler(const SamplerDesc& desc) : desc(desc) { }
+        const SamplerDesc& getDesc() const override { return desc; }
+    };
+
+    class InputLayout : public RefCounter<IInputLayout>
+    {
+    public:
+        std::vector<VertexAttributeDesc> attributes;
+
+        uint32_t getNumAttributes() const override { return uint32_t(attributes.size()); }
+        const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
+    };
+
+    // Recycled through Device::m_EventQueryPool
+    class EventQuery : public PooledRefCounter<IEventQuery, EventQuery>
+    {
+    public:
+        SubmissionTicket ticket;
+        bool started = false;
+    };
+
+    class TimerQuery : public RefCounter<ITimerQuery>
+    {
+    public:
+        Queue* queue = nullptr;
+        uint64_t instance = 0;
+        bool started = false;
+    };
+
+    class ReadbackTicket : public RefCounter<IReadbackTicket>
+    {
+    public:
+        std::vector<uint8_t> data;
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+        ReadbackCallback callback;
+
+        Queue* queue = nullptr;
+        uint64_t instance = 0;
+
+        bool isReady() override { return queue && queue->isInstanceCompleted(instance); }
+        const void* getData() override { return isReady() ? data.data() : nullptr; }
+        size_t getSize() const override { return data.size(); }
+        size_t getRowPitch() const override { return rowPitch; }
+        size_t getDepthPitch() const override { return depthPitch; }
+    };
+
+    class Framebuffer : public RefCounter<IFramebuffer>
+    {
+    public:
+        FramebufferDesc desc;
+        FramebufferInfoEx framebufferInfo;
+        DeviceStatsEntry statsEntry;
+
+        explicit Framebuffer(const FramebufferDesc& desc) : desc(desc), framebufferInfo(desc) { }
+        const FramebufferDesc& getDesc() const override { return desc; }
+        const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class GraphicsPipeline : public RefCounter<IGraphicsPipeline>
+    {
+    public:
+        GraphicsPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+        DeviceStatsEntry statsEntry;
+
+        const GraphicsPipelineDesc& getDesc() const override { return desc; }
+        const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class ComputePipeline : public RefCounter<IComputePipeline>
+    {
+    public:
+        ComputePipelineDesc desc;
+        DeviceStatsEntry statsEntry;
+
+        const ComputePipelineDesc& getDesc() const override { return desc; }
+    };
+
+    class WorkGraphPipeline : public RefCounter<IWorkGraphPipeline>
+    {
+    public:
+        WorkGraphPipelineDesc desc;
+        DeviceStatsEntry statsEntry;
+
+        const WorkGraphPipelineDesc& getDesc() const override { return desc; }
+        WorkGraphMemoryRequirements getMemoryRequirements() const override;
+    };
+
+    class MeshletPipeline : public RefCounter<IMeshletPipeline>
+    {
+    public:
+        MeshletPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+        DeviceStatsEntry statsEntry;
+
+        const MeshletPipelineDesc& getDesc() const override { return desc; }
+        const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+        GraphicsPipelineHandle pipeline;
+
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+    };
+
+    class BindingLayout : public RefCounter<IBindingLayout>
+    {
+    public:
+        BindingLayoutDesc desc;
+        BindlessLayoutDesc bindlessDesc;
+        bool isBindless = false;
+
+        const BindingLayoutDesc* getDesc() const override { return isBindless ? nullptr : &desc; }
+        const BindlessLayoutDesc* getBindlessDesc() const override { return isBindless ? &bindlessDesc : nullptr; }
+    };
+
+    class BindingSet : public RefCounter<IBindingSet>
+    {
+    public:
+        BindingSetDesc desc;
+        BindingLayoutHandle layout;
+
+        // Keeps the bound resources alive while the set exists
+        std::vector<RefCountPtr<IResource>> resources;
+        // Indices of the bindings whose resources are tracked, i.e. have no permanent state
+        std::vector<uint16_t> bindingsThatNeedTransitions;
+        DeviceStatsEntry statsEntry;
+
+        const BindingSetDesc* getDesc() const override { return &desc; }
+        IBindingLayout* getLayout() const override { return layout; }
+    };
+
+    class DescriptorTable : public RefCounter<IDescriptorTable>
+    {
+    public:
+        BindingLayoutHandle layout;
+        std::vector<BindingSetItem> descriptors;
+        DeviceStatsEntry statsEntry;
+
+        const BindingSetDesc* getDesc() const override { return nullptr; }
+        IBindingLayout* getLayout() const override { return layout; }
+        uint32_t getCapacity() const override { return uint32_t(descriptors.size()); }
+        uint32_t getFirstDescriptorIndexInHeap() const override { return 0; }
+    };
+
+    class AccelStruct : public RefCounter<rt::IAccelStruct>
+    {
+    public:
+        rt::AccelStructDesc desc;
+        // Stands for the acceleration structure memory in the state tracker
+        BufferHandle dataBuffer;
+        // TLAS only: the BLASes referenced by the last build
+        std::vector<rt::AccelStructHandle> bottomLevelASes;
+
+        const rt::AccelStructDesc& getDesc() const override { return desc; }
+        bool isCompacted() const override { return false; }
+        uint64_t getDeviceAddress() const override { return dataBuffer->getGpuVirtualAddress(); }
+    };
+
+    class RayTracingPipeline : public RefCounter<rt::IPipeline>
+    {
+    public:
+        rt::PipelineDesc desc;
+        // Binding layouts of the shaders and hit groups, by export name
+        std::unordered_map<std::string, BindingLayoutHandle> exports;
+        DeviceStatsEntry statsEntry;
+
+        explicit RayTracingPipeline(const Context& context) : m_Context(context) { }
+
+        const rt::PipelineDesc& getDesc() const override { return desc; }
+        rt::ShaderTableHandle createShaderTable() override { return createShaderTable(rt::ShaderTableDesc()); }
+        rt::ShaderTableHandle createShaderTable(const rt::ShaderTableDesc& desc) override;
+
+    private:
+        const Context& m_Context;
+    };
+
+    class ShaderTable : public RefCounter<rt::IShaderTable>
+    {
+    public:
+        RefCountPtr<RayTracingPipeline> pipeline;
+        rt::ShaderTableDesc desc;
+
+        struct Entry
+        {
+            std::string exportName;
+            BindingSetHandle localBindings;
+        };
+
+        Entry rayGenerationShader;
+        std::vector<Entry> missShaders;
+        std::vector<Entry> hitGroups;
+        std::vector<Entry> callableShaders;
+
+        uint32_t version = 0;
+
+        ShaderTable(const Context& context, RayTracingPipeline* pipeline, const rt::ShaderTableDesc& desc)
+            : pipeline(pipeline)
+            , desc(desc)
+            , m_Context(context)
+        { }
+
+        [[nodiscard]] uint32_t getNumEntries() const;
+
+        const rt::ShaderTableDesc& getDesc() const override { return desc; }
+        void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setMissShader(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setHitGroup(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setCallableShader(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        void clearMissShaders() override;
+        void clearHitShaders() override;
+        void clearCallableShaders() override;
+        rt::IPipeline* getPipeline() override { return pipeline; }
+
+    private:
+        const Context& m_Context;
+
+        bool verifyExport(const char* exportName, IBindingSet* bindings) const;
+        int addEntry(std::vector<Entry>& entries, const char* exportName, IBindingSet* bindings);
+        bool setEntry(std::vector<Entry>& entries, int index, const char* exportName, IBindingSet* bindings);
+    };
+
+    // Upload memory for writeBuffer, writeTexture and the other commands that take data from the CPU.
+    // Chunks are recycled when the command list instances that used them have completed, like on D3D12.
+    class UploadChunk
+    {
+    public:
+        std::unique_ptr<uint8_t[]> memory;
+        uint64_t version = 0;
+        uint64_t bufferSize = 0;
+        uint64_t writePointer = 0;
+        DeviceStatsEntry statsEntry;
+    };
+
+    class UploadManager
+    {
+    public:
+        UploadManager(Queue* pQueue, size_t defaultChunkSize);
+
+        void* suballocate(uint64_t size, uint64_t currentVersion, uint32_t alignment = 256);
+        void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
+
+    private:
+        Queue* m_Queue;
+        size_t m_DefaultChunkSize = 0;
+
+        std::list<std::shared_ptr<UploadChunk>> m_ChunkPool;
+        std::shared_ptr<UploadChunk> m_CurrentChunk;
+    };
+
+    class CommandListInstance
+    {
+    public:
+        uint64_t submittedInstance = 0;
+        CommandQueue commandQueue = CommandQueue::Graphics;
+        ResourceReferenceList referencedResources;
+        std::vector<RefCountPtr<Buffer>> referencedCpuBuffers;
+        std::vector<RefCountPtr<StagingTexture>> referencedStagingTextures;
+        std::vector<RefCountPtr<TimerQuery>> referencedTimerQueries;
+        std::vector<RefCountPtr<ReadbackTicket>> referencedReadbacks;
+    };
+
+    class Device;
+
+    class CommandList : public RefCounter<ICommandList>
+    {
+    public:
+        CommandList(Device* device, const Context& context, Queue* queue, const CommandListParameters& params);
+
+        std::shared_ptr<CommandListInstance> executed(uint64_t submittedInstance);
+        CommandListResourceStateTracker& getStateTracker() { return m_StateTracker; }
+
+        // ICommandList implementation
+
+        void open() override;
+        void close() override;
+        void openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport) override;
+        void executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists) override;
+        void clearState() override;
+
+        void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
+        void clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil) override;
+        void clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor) override;
+
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
+        void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+
+        void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        MappedWriteRegion beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
+        MappedWriteRegion beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        void commitWrite() override;
+        void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
+        void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        ReadbackTicketHandle readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback = nullptr) override;
+        ReadbackTicketHandle readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback = nullptr) override;
+
+        void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
+        void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format) override;
+        void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+
+        void setPushConstants(const void* data, size_t byteSize) override;
+        void setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings) override;
+        BindingSetHandle createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawBatch(const DrawArguments* args, size_t count, const void* pushConstants = nullptr, size_t pushConstantByteSize = 0, size_t pushConstantStride = 0) override;
+        void drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants = nullptr, size_t pushConstantByteSize = 0, size_t pushConstantStride = 0) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer = nullptr, uint32_t countBufferOffset = 0) override;
+
+        void setComputeState(const ComputeState& state) override;
+        void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchIndirect(uint32_t offsetBytes) override;
+
+        void setMeshletState(const MeshletState& state) override;
+        void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount) override;
+
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const WorkGraphDispatchArguments& args) override;
+
+        void setRayTracingState(const rt::State& state) override;
+        void dispatchRays(const rt::DispatchRaysArguments& args) override;
+
+        void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
+        void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactBottomLevelAccelStructs() override;
+        void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+            nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
+
+        void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
+
+        void beginTimerQuery(ITimerQuery* query) override;
+        void endTimerQuery(ITimerQuery* query) override;
+
+        void beginMarker(const char* name) override;
+        void endMarker() override;
+
+        void setEnableAutomaticBarriers(bool enable) override;
+        void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
+
+        void setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers) override;
+        void setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers) override;
+
+        void beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void setBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits) override;
+
+        void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
+        void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, ResourceStates nextState) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
+        void commitBarriers() override;
+
+        ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
+        ResourceStates getBufferState(IBuffer* buffer) override;
+
+        IDevice* getDevice() override;
+        const CommandListParameters& getDesc() override { return m_Desc; }
+        CommandListStats getStats() override;
+
+    private:
+        struct PendingWrite
+        {
+            TextureHandle texture;
+            BufferHandle buffer;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+        };
+
+        Device* m_Device;
+        const Context& m_Context;
+        Queue* m_Queue;
+        CommandListParameters m_Desc;
+
+        CommandListResourceStateTracker m_StateTracker;
+        bool m_EnableAutomaticBarriers = true;
+        CommandListStats m_Stats;
+
+        UploadManager m_UploadManager;
+        uint64_t m_RecordingVersion = 0;
+        PendingWrite m_PendingWrite;
+
+        std::shared_ptr<CommandListInstance> m_Instance;
+
+        GraphicsState m_CurrentGraphicsState;
+        ComputeState m_CurrentComputeState;
+        MeshletState m_CurrentMeshletState;
+        rt::State m_CurrentRayTracingState;
+        WorkGraphState m_CurrentWorkGraphState;
+        bool m_CurrentGraphicsStateValid = false;
+        bool m_CurrentComputeStateValid = false;
+        bool m_CurrentMeshletStateValid = false;
+        bool m_CurrentRayTracingStateValid = false;
+        bool m_CurrentWorkGraphStateValid = false;
+
+        // Versions of the shader tables that were last uploaded in this recording
+        std::unordered_map<ShaderTable*, uint32_t> m_ShaderTableVersions;
+
+        void requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state);
+        void requireBufferState(IBuffer* buffer, ResourceStates state);
+        // CPU-accessible buffers also record their last use, so that mapping them waits for this command list
+        void referenceBuffer(IBuffer* buffer);
+        void setBindings(const BindingSetVector& bindings, uint32_t bindingUpdateMask);
+        void setIndirectParams(IBuffer* indirectParams);
+        void uploadShaderTable(ShaderTable* shaderTable);
+        void bindAccelStructBuildInputs(const rt::GeometryDesc* pGeometries, size_t numGeometries);
+        void buildBottomLevelAccelStructInternal(AccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries);
+        ReadbackTicket* createReadbackTicket(size_t size, size_t rowPitch, size_t depthPitch, ReadbackCallback callback);
+    };
+
+    class Device : public RefCounter<IDevice>
+    {
+    public:
+        explicit Device(const DeviceDesc& desc);
+        ~Device() override;
+
+        Queue* getQueue(CommandQueue queue) { return m_Queues[size_t(queue)].get(); }
+        void addPendingReadbackCallback(ReadbackTicket* ticket);
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // IDevice implementation
+
+        HeapHandle createHeap(const HeapDesc& d) override;
+
+        TextureHandle createTexture(const TextureDesc& d) override;
+        MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
+        bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+
+        TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
+
+        StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
+        void unmapStagingTexture(IStagingTexture* tex) override;
+
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+
+        SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+        SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
+
+        BufferHandle createBuffer(const BufferDesc& d) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void unmapBuffer(IBuffer* b) override;
+        MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
+        bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
+
+        BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
+        ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+
+        SamplerHandle createSampler(const SamplerDesc& d) override;
+
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) override;
+
+        // event queries
+        EventQueryHandle createEventQuery() override;
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override;
+        bool pollEventQuery(IEventQuery* query) override;
+        void waitEventQuery(IEventQuery* query) override;
+        void resetEventQuery(IEventQuery* query) override;
+        SubmissionTicket getSubmissionTicket(CommandQueue queue) override;
+        bool pollSubmission(const SubmissionTicket& ticket) override;
+        bool waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
+        bool waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
+
+        // timer queries
+        TimerQueryHandle createTimerQuery() override;
+        bool pollTimerQuery(ITimerQuery* query) override;
+        float getTimerQueryTime(ITimerQuery* query) override;
+        void resetTimerQuery(ITimerQuery* query) override;
+
+        GraphicsAPI getGraphicsAPI() override { return GraphicsAPI::NULL_DEVICE; }
+
+        FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override;
+
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        WorkGraphPipelineHandle createWorkGraphPipeline(const WorkGraphPipelineDesc& desc) override;
+
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline) override;
+
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
+
+        BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
+
+        void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override;
+        bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
+
+        CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void flushSubmissions() override { }
+        bool waitForIdle() override;
+        void runGarbageCollection() override;
+        void runGarbageCollection(uint32_t) override { runGarbageCollection(); }
+        void evictCachedFramebuffers(ITexture*) override { }
+        bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
+        FormatSupport queryFormatSupport(Format format) override;
+        MemoryAllocatorStats getMemoryAllocatorStats() override;
+        MemoryBudget getMemoryBudget() override;
+        AccelStructStats getAccelStructStats() override;
+        DeviceStats getDeviceStats() override;
+        bool getProfilerFrameResults(ProfilerFrameResults& outResults) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& data) override;
+        coopvec::DeviceFeatures queryCoopVecFeatures() override;
+        size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
+        Object getNativeQueue(ObjectType objectType, CommandQueue queue) override { (void)objectType; (void)queue; return nullptr; }
+        IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
+        bool isAftermathEnabled() override { return false; }
+        AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
+
+    private:
+        Context m_Context;
+        // Declared before the queues, which release the objects of the command lists in flight
+        DeviceStatsTracker m_Stats;
+        std::array<std::unique_ptr<Queue>, size_t(CommandQueue::Count)> m_Queues;
+        std::shared_ptr<ObjectPool<EventQuery>> m_EventQueryPool = std::make_shared<ObjectPool<EventQuery>>();
+
+        std::mutex m_ReadbackMutex;
+        std::vector<RefCountPtr<ReadbackTicket>> m_PendingReadbackCallbacks;
+
+        AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
+
+        BufferHandle createAccelStructDataBuffer(const rt::AccelStructDesc& desc, uint64_t size);
+        bool waitForSubmissions(const SubmissionTicket* tickets, size_t numTickets, bool waitAll, uint64_t timeoutNanoseconds);
+    };
+
+    // Size of a subresource when its rows of pixels or blocks are tightly packed
+    void getSubresourceLayout(const TextureDesc& desc, uint32_t mipLevel, size_t* pRowPitch, size_t* pDepthPitch, uint32_t* pDepth);
+
+} // namespace nvrhi::null
@@ -0,0 +1,1202 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <cstring>
+#include <sstream>
+
+namespace nvrhi::null
+{
+    CommandList::CommandList(Device* device, const Context& context, Queue* queue, const CommandListParameters& params)
+        : m_Device(device)
+        , m_Context(context)
+        , m_Queue(queue)
+        , m_Desc(params)
+        , m_StateTracker(context.messageCallback)
+        , m_UploadManager(queue, params.uploadChunkSize)
+    {
+    }
+
+    IDevice* CommandList::getDevice()
+    {
+        return m_Device;
+    }
+
+    void CommandList::open()
+    {
+        m_RecordingVersion = MakeVersion(m_Queue->recordingInstance++, m_Desc.queueType, false);
+
+        m_Instance = std::make_shared<CommandListInstance>();
+        m_Instance->commandQueue = m_Desc.queueType;
+
+        m_Stats = CommandListStats();
+        m_StateTracker.resetBarrierCounts();
+
+        clearState();
+    }
+
+    void CommandList::close()
+    {
+        m_StateTracker.keepBufferInitialStates();
+        m_StateTracker.keepTextureInitialStates();
+        commitBarriers();
+
+        clearState();
+        m_ShaderTableVersions.clear();
+    }
+
+    CommandListStats CommandList::getStats()
+    {
+        CommandListStats stats = m_Stats;
+        stats.barriersIssued = m_StateTracker.getIssuedBarrierCount();
+        stats.barriersElided = m_StateTracker.getElidedBarrierCount();
+        return stats;
+    }
+
+    void CommandList::openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport)
+    {
+        (void)framebuffer;
+        (void)viewport;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        (void)pCommandLists;
+        (void)numCommandLists;
+
+        utils::NotSupported();
+    }
+
+    std::shared_ptr<CommandListInstance> CommandList::executed(uint64_t submittedInstance)
+    {
+        std::shared_ptr<CommandListInstance> instance = std::move(m_Instance);
+        instance->submittedInstance = submittedInstance;
+
+        for (const auto& buffer : instance->referencedCpuBuffers)
+        {
+            buffer->lastUseQueue = m_Queue;
+            buffer->lastUseInstance = submittedInstance;
+        }
+
+        for (const auto& stagingTexture : instance->referencedStagingTextures)
+        {
+            stagingTexture->lastUseQueue = m_Queue;
+            stagingTexture->lastUseInstance = submittedInstance;
+        }
+
+        for (const auto& query : instance->referencedTimerQueries)
+        {
+            query->started = true;
+            query->queue = m_Queue;
+            query->instance = submittedInstance;
+        }
+
+        for (const auto& ticket : instance->referencedReadbacks)
+        {
+            ticket->queue = m_Queue;
+            ticket->instance = submittedInstance;
+
+            if (ticket->callback)
+                m_Device->addPendingReadbackCallback(ticket);
+        }
+
+        m_StateTracker.commandListSubmitted();
+
+        m_UploadManager.submitChunks(m_RecordingVersion, MakeVersion(submittedInstance, m_Desc.queueType, true));
+        m_RecordingVersion = 0;
+
+        return instance;
+    }
+
+    void CommandList::clearState()
+    {
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
+
+        m_CurrentGraphicsState = GraphicsState();
+        m_CurrentComputeState = ComputeState();
+        m_CurrentMeshletState = MeshletState();
+        m_CurrentRayTracingState = rt::State();
+        m_CurrentWorkGraphState = WorkGraphState();
+    }
+
+    void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.requireTextureState(texture, subresources, state);
+    }
+
+    void CommandList::requireBufferState(IBuffer* _buffer, ResourceStates state)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.requireBufferState(buffer, state);
+    }
+
+    void CommandList::referenceBuffer(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (!buffer->memory.empty())
+            m_Instance->referencedCpuBuffers.push_back(buffer);
+        else
+            m_Instance->referencedResources.add(buffer);
+    }
+
+    void CommandList::commitBarriers()
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::commitBarriers");
+
+        // There is no native API to record the barriers into, but they are still computed by the state tracker
+        m_StateTracker.clearBarriers();
+    }
+
+    void CommandList::clearTextureFloat(ITexture* _t, TextureSubresourceSet subresources, const Color& clearColor)
+    {
+        Texture* t = checked_cast<Texture*>(_t);
+
+        (void)clearColor;
+
+        subresources = subresources.resolve(t->desc, false);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(t, subresources, t->desc.isRenderTarget ? ResourceStates::RenderTarget : ResourceStates::UnorderedAccess);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.add(t);
+    }
+
+    void CommandList::clearDepthStencilTexture(ITexture* _t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
+    {
+        Texture* t = checked_cast<Texture*>(_t);
+
+        (void)depth;
+        (void)stencil;
+
+        if (!clearDepth && !clearStencil)
+            return;
+
+        subresources = subresources.resolve(t->desc, false);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(t, subresources, ResourceStates::DepthWrite);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.add(t);
+    }
+
+    void CommandList::clearTextureUInt(ITexture* _t, TextureSubresourceSet subresources, uint32_t clearColor)
+    {
+        Texture* t = checked_cast<Texture*>(_t);
+
+        (void)clearColor;
+
+        subresources = subresources.resolve(t->desc, false);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(t, subresources, t->desc.isRenderTarget ? ResourceStates::RenderTarget : ResourceStates::UnorderedAccess);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.add(t);
+    }
+
+    void CommandList::copyTexture(ITexture* _dst, const TextureSlice& dstSlice, ITexture* _src, const TextureSlice& srcSlice)
+    {
+        Texture* dst = checked_cast<Texture*>(_dst);
+        Texture* src = checked_cast<Texture*>(_src);
+
+        const TextureSlice resolvedDstSlice = dstSlice.resolve(dst->desc);
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->desc);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dst, TextureSubresourceSet(resolvedDstSlice.mipLevel, 1, resolvedDstSlice.arraySlice, 1), ResourceStates::CopyDest);
+            requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.add(dst);
+        m_Instance->referencedResources.add(src);
+    }
+
+    void CommandList::copyTexture(IStagingTexture* _dst, const TextureSlice& dstSlice, ITexture* _src, const TextureSlice& srcSlice)
+    {
+        StagingTexture* dst = checked_cast<StagingTexture*>(_dst);
+        Texture* src = checked_cast<Texture*>(_src);
+
+        (void)dstSlice;
+
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->desc);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedStagingTextures.push_back(dst);
+        m_Instance->referencedResources.add(src);
+    }
+
+    void CommandList::copyTexture(ITexture* _dst, const TextureSlice& dstSlice, IStagingTexture* _src, const TextureSlice& srcSlice)
+    {
+        Texture* dst = checked_cast<Texture*>(_dst);
+        StagingTexture* src = checked_cast<StagingTexture*>(_src);
+
+        (void)srcSlice;
+
+        const TextureSlice resolvedDstSlice = dstSlice.resolve(dst->desc);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dst, TextureSubresourceSet(resolvedDstSlice.mipLevel, 1, resolvedDstSlice.arraySlice, 1), ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.add(dst);
+        m_Instance->referencedStagingTextures.push_back(src);
+    }
+
+    void CommandList::writeTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        const MappedWriteRegion region = beginWriteTexture(dest, arraySlice, mipLevel);
+        if (!region.data)
+            return;
+
+        // Copy the data into the upload memory like the other backends do, so that the CPU cost is comparable
+        const size_t numRows = region.depthPitch / region.rowPitch;
+        const size_t depth = region.size / region.depthPitch;
+        const size_t rowSize = std::min(region.rowPitch, rowPitch);
+
+        for (size_t depthSlice = 0; depthSlice < depth; depthSlice++)
+        {
+            for (size_t row = 0; row < numRows; row++)
+            {
+                const uint8_t* srcRow = static_cast<const uint8_t*>(data) + depthPitch * depthSlice + rowPitch * row;
+                uint8_t* dstRow = static_cast<uint8_t*>(region.data) + region.depthPitch * depthSlice + region.rowPitch * row;
+                memcpy(dstRow, srcRow, rowSize);
+            }
+        }
+
+        commitWrite();
+    }
+
+    MappedWriteRegion CommandList::beginWriteTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+        uint32_t depth = 0;
+        getSubresourceLayout(dest->desc, mipLevel, &rowPitch, &depthPitch, &depth);
+
+        const size_t totalBytes = depthPitch * depth;
+
+        void* cpuVA = m_UploadManager.suballocate(totalBytes, m_RecordingVersion, 512);
+        m_Stats.uploadBytes += totalBytes;
+
+        m_PendingWrite.texture = dest;
+        m_PendingWrite.arraySlice = arraySlice;
+        m_PendingWrite.mipLevel = mipLevel;
+
+        MappedWriteRegion region;
+        region.data = cpuVA;
+        region.rowPitch = rowPitch;
+        region.depthPitch = depthPitch;
+        region.size = totalBytes;
+        return region;
+    }
+
+    MappedWriteRegion CommandList::beginWriteBuffer(IBuffer* _b, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_b);
+
+        (void)destOffsetBytes;
+
+        void* cpuVA = m_UploadManager.suballocate(dataSize, m_RecordingVersion);
+        m_Stats.uploadBytes += dataSize;
+        if (buffer->desc.isVolatile)
+            ++m_Stats.volatileBufferWrites;
+
+        m_PendingWrite.buffer = buffer;
+
+        MappedWriteRegion region;
+        region.data = cpuVA;
+        region.size = dataSize;
+        return region;
+    }
+
+    void CommandList::commitWrite()
+    {
+        PendingWrite& write = m_PendingWrite;
+
+        if (write.texture)
+        {
+            Texture* dest = checked_cast<Texture*>(write.texture.Get());
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireTextureState(dest, TextureSubresourceSet(write.mipLevel, 1, write.arraySlice, 1), ResourceStates::CopyDest);
+            }
+            commitBarriers();
+
+            m_Instance->referencedResources.add(dest);
+        }
+        else if (write.buffer)
+        {
+            Buffer* buffer = checked_cast<Buffer*>(write.buffer.Get());
+
+            // Volatile buffers live in the upload memory and are never transitioned
+            if (!buffer->desc.isVolatile)
+            {
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(buffer, ResourceStates::CopyDest);
+                }
+                commitBarriers();
+            }
+
+            referenceBuffer(buffer);
+        }
+
+        write = PendingWrite();
+    }
+
+    void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+        Texture* src = checked_cast<Texture*>(_src);
+
+        const TextureSubresourceSet dstSR = dstSubresources.resolve(dest->desc, false);
+        const TextureSubresourceSet srcSR = srcSubresources.resolve(src->desc, false);
+
+        if (dstSR.numArraySlices != srcSR.numArraySlices || dstSR.numMipLevels != srcSR.numMipLevels)
+            // let the validation layer handle the messages
+            return;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, dstSR, ResourceStates::ResolveDest);
+            requireTextureState(src, srcSR, ResourceStates::ResolveSource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.add(dest);
+        m_Instance->referencedResources.add(src);
+    }
+
+    void CommandList::writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        const MappedWriteRegion region = beginWriteBuffer(b, dataSize, destOffsetBytes);
+        if (!region.data)
+            return;
+
+        memcpy(region.data, data, dataSize);
+
+        commitWrite();
+    }
+
+    void CommandList::clearBufferUInt(IBuffer* _b, uint32_t clearValue)
+    {
+        Buffer* b = checked_cast<Buffer*>(_b);
+
+        (void)clearValue;
+
+        if (!b->desc.canHaveUAVs)
+        {
+            std::stringstream ss;
+            ss << "Cannot clear buffer " << utils::DebugNameToString(b->desc.debugName)
+               << " because it was created with canHaveUAVs = false";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(b, ResourceStates::UnorderedAccess);
+        }
+        commitBarriers();
+
+        referenceBuffer(b);
+    }
+
+    void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        Buffer* dest = checked_cast<Buffer*>(_dest);
+        Buffer* src = checked_cast<Buffer*>(_src);
+
+        (void)destOffsetBytes;
+        (void)srcOffsetBytes;
+        (void)dataSizeBytes;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(dest, ResourceStates::CopyDest);
+            requireBufferState(src, ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        referenceBuffer(dest);
+        referenceBuffer(src);
+    }
+
+    ReadbackTicket* CommandList::createReadbackTicket(size_t size, size_t rowPitch, size_t depthPitch, ReadbackCallback callback)
+    {
+        // The data is all zeros because the commands do not produce any results
+        RefCountPtr<ReadbackTicket> ticket = RefCountPtr<ReadbackTicket>::Create(new ReadbackTicket());
+        ticket->data.resize(size);
+        ticket->rowPitch = rowPitch;
+        ticket->depthPitch = depthPitch;
+        ticket->callback = std::move(callback);
+
+        m_Instance->referencedReadbacks.push_back(ticket);
+
+        return ticket;
+    }
+
+    ReadbackTicketHandle CommandList::readbackBuffer(IBuffer* _b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback)
+    {
+        Buffer* b = checked_cast<Buffer*>(_b);
+
+        (void)offsetBytes;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(b, ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        referenceBuffer(b);
+
+        return createReadbackTicket(size_t(sizeBytes), 0, 0, std::move(callback));
+    }
+
+    ReadbackTicketHandle CommandList::readbackTexture(ITexture* _texture, const TextureSlice& slice, ReadbackCallback callback)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        const TextureSlice resolvedSlice = slice.resolve(texture->desc);
+
+        // Get the layout of a texture that has the size of the region
+        TextureDesc regionDesc = texture->desc;
+        regionDesc.width = resolvedSlice.width;
+        regionDesc.height = resolvedSlice.height;
+        regionDesc.depth = resolvedSlice.depth;
+
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+        uint32_t depth = 0;
+        getSubresourceLayout(regionDesc, 0, &rowPitch, &depthPitch, &depth);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, TextureSubresourceSet(resolvedSlice.mipLevel, 1, resolvedSlice.arraySlice, 1), ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.add(texture);
+
+        return createReadbackTicket(depthPitch * depth, rowPitch, depthPitch, std::move(callback));
+    }
+
+    void CommandList::clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture)
+    {
+        (void)texture;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format)
+    {
+        (void)buffer;
+        (void)texture;
+        (void)format;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits)
+    {
+        (void)texture;
+        (void)stateBits;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::setPushConstants(const void* data, size_t byteSize)
+    {
+        (void)data;
+        (void)byteSize;
+    }
+
+    void CommandList::setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings)
+    {
+        (void)layoutIndex;
+        (void)bindings;
+
+        utils::NotSupported();
+    }
+
+    BindingSetHandle CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSetHandle bindingSet = m_Device->createBindingSet(desc, layout);
+
+        if (bindingSet)
+            m_Instance->referencedResources.add(bindingSet);
+
+        return bindingSet;
+    }
+
+    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    {
+        if (_bindingSet == nullptr)
+            return;
+        if (_bindingSet->getDesc() == nullptr)
+            return; // is bindless
+
+        BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+        for (auto bindingIndex : bindingSet->bindingsThatNeedTransitions)
+        {
+            const BindingSetItem& binding = bindingSet->desc.bindings[bindingIndex];
+
+            switch(binding.type)  // NOLINT(clang-diagnostic-switch-enum)
+            {
+            case ResourceType::Texture_SRV:
+                requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::ShaderResource);
+                break;
+
+            case ResourceType::Texture_UAV:
+                requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::UnorderedAccess);
+                break;
+
+            case ResourceType::TypedBuffer_SRV:
+            case ResourceType::StructuredBuffer_SRV:
+            case ResourceType::RawBuffer_SRV:
+                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ShaderResource);
+                break;
+
+            case ResourceType::TypedBuffer_UAV:
+            case ResourceType::StructuredBuffer_UAV:
+            case ResourceType::RawBuffer_UAV:
+                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::UnorderedAccess);
+                break;
+
+            case ResourceType::ConstantBuffer:
+                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ConstantBuffer);
+                break;
+
+            case ResourceType::RayTracingAccelStruct:
+                requireBufferState(checked_cast<AccelStruct*>(binding.resourceHandle)->dataBuffer, ResourceStates::AccelStructRead);
+                break;
+
+            default:
+                // do nothing
+                break;
+            }
+        }
+    }
+
+    void CommandList::setBindings(const BindingSetVector& bindings, uint32_t bindingUpdateMask)
+    {
+        for (uint32_t bindingSetIndex = 0; bindingSetIndex < uint32_t(bindings.size()); bindingSetIndex++)
+        {
+            IBindingSet* bindingSet = bindings[bindingSetIndex];
+
+            if (!bindingSet || (bindingUpdateMask & (1 << bindingSetIndex)) == 0)
+                continue;
+
+            if (m_EnableAutomaticBarriers)
+                setResourceStatesForBindingSet(bindingSet);
+
+            m_Instance->referencedResources.add(bindingSet);
+            ++m_Stats.bindingSetBinds;
+        }
+    }
+
+    void CommandList::setIndirectParams(IBuffer* indirectParams)
+    {
+        if (!indirectParams)
+            return;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(indirectParams, ResourceStates::IndirectArgument);
+        }
+
+        referenceBuffer(indirectParams);
+    }
+
+    void CommandList::setGraphicsState(const GraphicsState& state)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::setGraphicsState");
+
+        const bool updateFramebuffer = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.framebuffer != state.framebuffer;
+        const bool updatePipeline = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.pipeline != state.pipeline;
+        const bool updateIndirectParams = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indirectParams != state.indirectParams;
+        const bool updateIndexBuffer = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indexBuffer != state.indexBuffer;
+        const bool updateVertexBuffers = !m_CurrentGraphicsStateValid || arraysAreDifferent(m_CurrentGraphicsState.vertexBuffers, state.vertexBuffers);
+
+        const uint32_t bindingUpdateMask = m_CurrentGraphicsStateValid
+            ? arrayDifferenceMask(m_CurrentGraphicsState.bindings, state.bindings)
+            : ~0u;
+
+        if (updatePipeline)
+        {
+            m_Instance->referencedResources.add(state.pipeline);
+            ++m_Stats.pipelineBinds;
+        }
+
+        if (updateFramebuffer && state.framebuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+                setResourceStatesForFramebuffer(state.framebuffer);
+
+            m_Instance->referencedResources.add(state.framebuffer);
+        }
+
+        setBindings(state.bindings, bindingUpdateMask);
+
+        if (updateIndexBuffer && state.indexBuffer.buffer)
+        {
+            if (m_EnableAutomaticBarriers)
+                requireBufferState(state.indexBuffer.buffer, ResourceStates::IndexBuffer);
+
+            referenceBuffer(state.indexBuffer.buffer);
+        }
+
+        if (updateVertexBuffers)
+        {
+            for (const VertexBufferBinding& binding : state.vertexBuffers)
+            {
+                if (m_EnableAutomaticBarriers)
+                    requireBufferState(binding.buffer, ResourceStates::VertexBuffer);
+
+                referenceBuffer(binding.buffer);
+            }
+        }
+
+        if (updateIndirectParams)
+            setIndirectParams(state.indirectParams);
+
+        commitBarriers();
+
+        m_CurrentGraphicsStateValid = true;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
+        m_CurrentGraphicsState = state;
+    }
+
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsBindingSet requires a previous call to setGraphicsState");
+            return;
+        }
+
+        if (slot >= m_CurrentGraphicsState.bindings.size())
+        {
+            m_Context.error("setGraphicsBindingSet slot is outside of the bindings in the current state");
+            return;
+        }
+
+        if (m_CurrentGraphicsState.bindings[slot] == bindingSet)
+            return;
+
+        m_CurrentGraphicsState.bindings[slot] = bindingSet;
+
+        setBindings(m_CurrentGraphicsState.bindings, 1u << slot);
+
+        commitBarriers();
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setVertexBuffers requires a previous call to setGraphicsState");
+            return;
+        }
+
+        m_CurrentGraphicsState.vertexBuffers.resize(0);
+
+        for (size_t index = 0; index < numBindings; index++)
+        {
+            const VertexBufferBinding& binding = pBindings[index];
+
+            if (m_EnableAutomaticBarriers)
+                requireBufferState(binding.buffer, ResourceStates::VertexBuffer);
+
+            referenceBuffer(binding.buffer);
+
+            m_CurrentGraphicsState.vertexBuffers.push_back(binding);
+        }
+
+        commitBarriers();
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setIndexBuffer requires a previous call to setGraphicsState");
+            return;
+        }
+
+        if (binding.buffer)
+        {
+            if (m_EnableAutomaticBarriers)
+                requireBufferState(binding.buffer, ResourceStates::IndexBuffer);
+
+            referenceBuffer(binding.buffer);
+        }
+
+        m_CurrentGraphicsState.indexBuffer = binding;
+
+        commitBarriers();
+    }
+
+    void CommandList::draw(const DrawArguments& args)
+    {
+        (void)args;
+
+        ++m_Stats.drawCalls;
+    }
+
+    void CommandList::drawIndexed(const DrawArguments& args)
+    {
+        (void)args;
+
+        ++m_Stats.drawCalls;
+    }
+
+    void CommandList::drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        for (size_t index = 0; index < count; index++)
+        {
+            if (pushConstants && pushConstantByteSize)
+                setPushConstants(static_cast<const uint8_t*>(pushConstants) + index * pushConstantStride, pushConstantByteSize);
+
+            draw(args[index]);
+        }
+    }
+
+    void CommandList::drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        for (size_t index = 0; index < count; index++)
+        {
+            if (pushConstants && pushConstantByteSize)
+                setPushConstants(static_cast<const uint8_t*>(pushConstants) + index * pushConstantStride, pushConstantByteSize);
+
+            drawIndexed(args[index]);
+        }
+    }
+
+    void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        ++m_Stats.drawCalls;
+    }
+
+    void CommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        ++m_Stats.drawCalls;
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount)
+    {
+        (void)offsetBytes;
+        (void)countBufferOffset;
+        (void)maxDrawCount;
+
+        ++m_Stats.drawCalls;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(countBuffer, ResourceStates::IndirectArgument);
+        }
+        commitBarriers();
+
+        referenceBuffer(countBuffer);
+    }
+
+    void CommandList::executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset)
+    {
+        (void)offsetBytes;
+        (void)maxCommandCount;
+        (void)countBufferOffset;
+
+        ++m_Stats.drawCalls;
+
+        if (countBuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(countBuffer, ResourceStates::IndirectArgument);
+            }
+            commitBarriers();
+
+            referenceBuffer(countBuffer);
+        }
+
+        m_Instance->referencedResources.add(signature);
+    }
+
+    void CommandList::setComputeState(const ComputeState& state)
+    {
+        const bool updatePipeline = !m_CurrentComputeStateValid || m_CurrentComputeState.pipeline != state.pipeline;
+        const bool updateIndirectParams = !m_CurrentComputeStateValid || m_CurrentComputeState.indirectParams != state.indirectParams;
+
+        const uint32_t bindingUpdateMask = m_CurrentComputeStateValid
+            ? arrayDifferenceMask(m_CurrentComputeState.bindings, state.bindings)
+            : ~0u;
+
+        if (updatePipeline)
+        {
+            m_Instance->referencedResources.add(state.pipeline);
+            ++m_Stats.pipelineBinds;
+        }
+
+        setBindings(state.bindings, bindingUpdateMask);
+
+        if (updateIndirectParams)
+            setIndirectParams(state.indirectParams);
+
+        commitBarriers();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = true;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
+        m_CurrentComputeState = state;
+    }
+
+    void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        (void)groupsX;
+        (void)groupsY;
+        (void)groupsZ;
+
+        ++m_Stats.dispatches;
+    }
+
+    void CommandList::dispatchIndirect(uint32_t offsetBytes)
+    {
+        (void)offsetBytes;
+
+        ++m_Stats.dispatches;
+    }
+
+    void CommandList::setMeshletState(const MeshletState& state)
+    {
+        const bool updateFramebuffer = !m_CurrentMeshletStateValid || m_CurrentMeshletState.framebuffer != state.framebuffer;
+        const bool updatePipeline = !m_CurrentMeshletStateValid || m_CurrentMeshletState.pipeline != state.pipeline;
+        const bool updateIndirectParams = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectParams != state.indirectParams;
+        const bool updateIndirectCountBuffer = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectCountBuffer != state.indirectCountBuffer;
+
+        const uint32_t bindingUpdateMask = m_CurrentMeshletStateValid
+            ? arrayDifferenceMask(m_CurrentMeshletState.bindings, state.bindings)
+            : ~0u;
+
+        if (updatePipeline)
+        {
+            m_Instance->referencedResources.add(state.pipeline);
+            ++m_Stats.pipelineBinds;
+        }
+
+        if (updateFramebuffer && state.framebuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+                setResourceStatesForFramebuffer(state.framebuffer);
+
+            m_Instance->referencedResources.add(state.framebuffer);
+        }
+
+        setBindings(state.bindings, bindingUpdateMask);
+
+        if (updateIndirectParams)
+            setIndirectParams(state.indirectParams);
+
+        if (updateIndirectCountBuffer)
+            setIndirectParams(state.indirectCountBuffer);
+
+        commitBarriers();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = true;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
+        m_CurrentMeshletState = state;
+    }
+
+    void CommandList::dispatchMesh(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        (void)groupsX;
+        (void)groupsY;
+        (void)groupsZ;
+
+        ++m_Stats.dispatches;
+    }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        (void)offsetBytes;
+        (void)dispatchCount;
+
+        ++m_Stats.dispatches;
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount)
+    {
+        (void)offsetBytes;
+        (void)countBufferOffset;
+        (void)maxDispatchCount;
+
+        ++m_Stats.dispatches;
+    }
+
+    void CommandList::setWorkGraphState(const WorkGraphState& state)
+    {
+        const bool updatePipeline = !m_CurrentWorkGraphStateValid || m_CurrentWorkGraphState.pipeline != state.pipeline;
+        const bool updateBackingMemory = !m_CurrentWorkGraphStateValid || m_CurrentWorkGraphState.backingMemory != state.backingMemory;
+
+        const uint32_t bindingUpdateMask = m_CurrentWorkGraphStateValid
+            ? arrayDifferenceMask(m_CurrentWorkGraphState.bindings, state.bindings)
+            : ~0u;
+
+        if (updatePipeline)
+        {
+            m_Instance->referencedResources.add(state.pipeline);
+            ++m_Stats.pipelineBinds;
+        }
+
+        setBindings(state.bindings, bindingUpdateMask);
+
+        if (updateBackingMemory && state.backingMemory)
+        {
+            if (m_EnableAutomaticBarriers)
+                requireBufferState(state.backingMemory, ResourceStates::UnorderedAccess);
+
+            referenceBuffer(state.backingMemory);
+        }
+
+        commitBarriers();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = true;
+        m_CurrentWorkGraphState = state;
+    }
+
+    void CommandList::dispatchGraph(const WorkGraphDispatchArguments& args)
+    {
+        (void)args;
+
+        ++m_Stats.dispatches;
+    }
+
+    void CommandList::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
+    {
+        (void)convertDescs;
+        (void)numDescs;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::beginTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        m_Instance->referencedTimerQueries.push_back(query);
+    }
+
+    void CommandList::endTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        m_Instance->referencedTimerQueries.push_back(query);
+    }
+
+    void CommandList::beginMarker(const char* name)
+    {
+        (void)name;
+    }
+
+    void CommandList::endMarker()
+    {
+    }
+
+    void CommandList::setEnableAutomaticBarriers(bool enable)
+    {
+        m_EnableAutomaticBarriers = enable;
+    }
+
+    void CommandList::setEnableUavBarriersForTexture(ITexture* _texture, bool enableBarriers)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.setEnableUavBarriersForTexture(texture, enableBarriers);
+    }
+
+    void CommandList::setEnableUavBarriersForBuffer(IBuffer* _buffer, bool enableBarriers)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.setEnableUavBarriersForBuffer(buffer, enableBarriers);
+    }
+
+    void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTrackingTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandList::beginTrackingBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginTrackingBufferState(buffer, stateBits);
+    }
+
+    void CommandList::setTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        requireTextureState(texture, subresources, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.add(texture);
+    }
+
+    void CommandList::setBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        requireBufferState(buffer, stateBits);
+
+        if (m_Instance)
+            referenceBuffer(buffer);
+    }
+
+    void CommandList::setAccelStructState(rt::IAccelStruct* _as, ResourceStates stateBits)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        requireBufferState(as->dataBuffer, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.add(as);
+    }
+
+    void CommandList::setPermanentTextureState(ITexture* _texture, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.setPermanentTextureState(texture, AllSubresources, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.add(texture);
+    }
+
+    void CommandList::setPermanentBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.setPermanentBufferState(buffer, stateBits);
+
+        if (m_Instance)
+            referenceBuffer(buffer);
+    }
+
+    void CommandList::beginTextureStateTransition(ITexture* _texture, ResourceStates nextState)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, nextState);
+
+        if (m_Instance)
+            m_Instance->referencedResources.add(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates nextState)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer, nextState);
+
+        if (m_Instance)
+            referenceBuffer(buffer);
+    }
+
+    void CommandList::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        (void)resourceBefore;
+
+        if (resourceAfter)
+            m_Instance->referencedResources.add(resourceAfter);
+    }
+
+    ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        return m_StateTracker.getTextureSubresourceState(texture, arraySlice, mipLevel);
+    }
+
+    ResourceStates CommandList::getBufferState(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        return m_StateTracker.getBufferState(buffer);
+    }
+
+} // namespace nvrhi::null
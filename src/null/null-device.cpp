@@ -0,0 +1,501 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <thread>
+
+namespace nvrhi::null
+{
+    uint64_t Context::allocateGpuAddress(uint64_t size)
+    {
+        return nextGpuAddress.fetch_add(align(std::max<uint64_t>(size, 1), uint64_t(65536)));
+    }
+
+    void Context::error(const std::string& message) const
+    {
+        if (messageCallback)
+            messageCallback->message(MessageSeverity::Error, message.c_str());
+    }
+
+    uint64_t Queue::submit(std::vector<std::shared_ptr<CommandListInstance>>&& instances, std::chrono::microseconds latency)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Submissions complete in order, and not before the submissions that they wait for
+        Clock::time_point completionTime = std::max(Clock::now() + latency, m_PendingWaitTime);
+        if (!m_SubmissionsInFlight.empty())
+            completionTime = std::max(completionTime, m_SubmissionsInFlight.back().completionTime);
+        m_PendingWaitTime = Clock::time_point();
+
+        Submission submission;
+        submission.instance = ++lastSubmittedInstance;
+        submission.completionTime = completionTime;
+        submission.instances = std::move(instances);
+        m_SubmissionsInFlight.push_back(std::move(submission));
+
+        return lastSubmittedInstance;
+    }
+
+    void Queue::waitForQueue(Queue* otherQueue, uint64_t instance)
+    {
+        if (otherQueue == this)
+            return;
+
+        const Clock::time_point completionTime = otherQueue->getCompletionTime(instance);
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_PendingWaitTime = std::max(m_PendingWaitTime, completionTime);
+    }
+
+    Clock::time_point Queue::getCompletionTime(uint64_t instance)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const Submission& submission : m_SubmissionsInFlight)
+        {
+            if (submission.instance >= instance)
+                return submission.completionTime;
+        }
+
+        // Already completed, or never submitted
+        return Clock::time_point();
+    }
+
+    uint64_t Queue::updateLastCompletedInstance()
+    {
+        // The instances are released outside of the lock, because that can release the last references to resources
+        std::vector<Submission> completedSubmissions;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (m_SubmissionsInFlight.empty())
+                return m_LastCompletedInstance;
+
+            const Clock::time_point now = Clock::now();
+            while (!m_SubmissionsInFlight.empty() && m_SubmissionsInFlight.front().completionTime <= now)
+            {
+                m_LastCompletedInstance = m_SubmissionsInFlight.front().instance;
+                for (const auto& instance : m_SubmissionsInFlight.front().instances)
+                    stats.commandListRetired(instance->referencedResources.size());
+                completedSubmissions.push_back(std::move(m_SubmissionsInFlight.front()));
+                m_SubmissionsInFlight.pop_front();
+            }
+        }
+
+        return m_LastCompletedInstance;
+    }
+
+    void Queue::waitForInstance(uint64_t instance)
+    {
+        // Instances that were never submitted would never complete
+        if (instance == 0 || instance > lastSubmittedInstance)
+            return;
+
+        while (!isInstanceCompleted(instance))
+        {
+            const Clock::time_point completionTime = getCompletionTime(instance);
+            if (completionTime != Clock::time_point())
+                std::this_thread::sleep_until(completionTime);
+        }
+    }
+
+    DeviceHandle createDevice(const DeviceDesc& desc)
+    {
+        Device* device = new Device(desc);
+        return DeviceHandle::Create(device);
+    }
+
+    Device::Device(const DeviceDesc& desc)
+    {
+        m_Context.messageCallback = desc.messageCallback;
+        m_Context.completionLatency = std::chrono::microseconds(desc.completionLatencyMicroseconds);
+
+        for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+        {
+            m_Queues[queue] = std::make_unique<Queue>(CommandQueue(queue), m_Stats);
+        }
+    }
+
+    Device::~Device()
+    {
+        waitForIdle();
+    }
+
+    Object Device::getNativeObject(ObjectType objectType)
+    {
+        if (objectType == ObjectTypes::Nvrhi_Null_Device)
+            return this;
+
+        return nullptr;
+    }
+
+    CommandListHandle Device::createCommandList(const CommandListParameters& params)
+    {
+        if (params.isSecondary)
+        {
+            m_Context.error("Secondary command lists are not supported by the null backend.");
+            return nullptr;
+        }
+
+        if (params.isReusable)
+        {
+            m_Context.error("Reusable command lists are not supported by the null backend.");
+            return nullptr;
+        }
+
+        CommandList* commandList = new CommandList(this, m_Context, getQueue(params.queueType), params);
+        return CommandListHandle::Create(commandList);
+    }
+
+    uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::executeCommandLists");
+
+        Queue* pQueue = getQueue(executionQueue);
+
+        // The instance that the command lists are submitted with is the next one on the queue,
+        // the queue is externally synchronized like on the other backends
+        const uint64_t submittedInstance = pQueue->lastSubmittedInstance + 1;
+
+        std::vector<std::shared_ptr<CommandListInstance>> instances;
+        instances.reserve(numCommandLists);
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            instances.push_back(commandList->executed(submittedInstance));
+            m_Stats.commandListSubmitted(commandList->getStats(), instances.back()->referencedResources.size());
+        }
+
+        const uint64_t instance = pQueue->submit(std::move(instances), m_Context.completionLatency);
+        assert(instance == submittedInstance);
+
+        return instance;
+    }
+
+    void Device::queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance)
+    {
+        getQueue(waitQueue)->waitForQueue(getQueue(executionQueue), instance);
+    }
+
+    bool Device::waitForIdle()
+    {
+        for (const auto& queue : m_Queues)
+        {
+            queue->waitForInstance(queue->lastSubmittedInstance);
+        }
+
+        return true;
+    }
+
+    void Device::addPendingReadbackCallback(ReadbackTicket* ticket)
+    {
+        std::lock_guard lockGuard(m_ReadbackMutex);
+        m_PendingReadbackCallbacks.push_back(ticket);
+    }
+
+    void Device::runGarbageCollection()
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::runGarbageCollection");
+
+        for (const auto& queue : m_Queues)
+        {
+            queue->updateLastCompletedInstance();
+        }
+
+        std::vector<RefCountPtr<ReadbackTicket>> readyTickets;
+
+        {
+            std::lock_guard lockGuard(m_ReadbackMutex);
+
+            auto it = m_PendingReadbackCallbacks.begin();
+            while (it != m_PendingReadbackCallbacks.end())
+            {
+                if ((*it)->isReady())
+                {
+                    readyTickets.push_back(*it);
+                    it = m_PendingReadbackCallbacks.erase(it);
+                }
+                else
+                    ++it;
+            }
+        }
+
+        // The callbacks may record new readbacks, so they are called outside of the lock
+        for (const auto& ticket : readyTickets)
+        {
+            ticket->callback(ticket);
+        }
+    }
+
+    EventQueryHandle Device::createEventQuery()
+    {
+        EventQuery* query = m_EventQueryPool->acquire();
+        query->ticket = SubmissionTicket();
+        query->started = false;
+        return EventQueryHandle::Create(query);
+    }
+
+    void Device::setEventQuery(IEventQuery* _query, CommandQueue queue)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        query->ticket = getSubmissionTicket(queue);
+        query->started = true;
+    }
+
+    bool Device::pollEventQuery(IEventQuery* _query)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        return query->started && pollSubmission(query->ticket);
+    }
+
+    void Device::waitEventQuery(IEventQuery* _query)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        if (query->started)
+            waitForAll(&query->ticket, 1, ~0ull);
+    }
+
+    void Device::resetEventQuery(IEventQuery* _query)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        query->ticket = SubmissionTicket();
+        query->started = false;
+    }
+
+    SubmissionTicket Device::getSubmissionTicket(CommandQueue queue)
+    {
+        return SubmissionTicket()
+            .setQueue(queue)
+            .setInstance(getQueue(queue)->lastSubmittedInstance);
+    }
+
+    bool Device::pollSubmission(const SubmissionTicket& ticket)
+    {
+        Queue* queue = getQueue(ticket.queue);
+
+        return ticket.instance == 0 || (ticket.instance <= queue->lastSubmittedInstance && queue->isInstanceCompleted(ticket.instance));
+    }
+
+    bool Device::waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        return waitForSubmissions(tickets, numTickets, true, timeoutNanoseconds);
+    }
+
+    bool Device::waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        return waitForSubmissions(tickets, numTickets, false, timeoutNanoseconds);
+    }
+
+    bool Device::waitForSubmissions(const SubmissionTicket* tickets, size_t numTickets, bool waitAll, uint64_t timeoutNanoseconds)
+    {
+        if (numTickets == 0)
+            return waitAll;
+
+        const Clock::time_point deadline = (timeoutNanoseconds == ~0ull)
+            ? Clock::time_point::max()
+            : Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(timeoutNanoseconds));
+
+        while (true)
+        {
+            // Sleep until the next submission completes, as the completion times are known in advance
+            Clock::time_point wakeTime = Clock::time_point::max();
+            size_t numCompleted = 0;
+
+            for (size_t i = 0; i < numTickets; i++)
+            {
+                const SubmissionTicket& ticket = tickets[i];
+                Queue* queue = getQueue(ticket.queue);
+
+                if (ticket.instance > queue->lastSubmittedInstance)
+                    return false;
+
+                if (pollSubmission(ticket))
+                {
+                    ++numCompleted;
+                    continue;
+                }
+
+                wakeTime = std::min(wakeTime, queue->getCompletionTime(ticket.instance));
+            }
+
+            if (waitAll ? (numCompleted == numTickets) : (numCompleted != 0))
+                return true;
+
+            if (Clock::now() >= deadline)
+                return false;
+
+            std::this_thread::sleep_until(std::min(wakeTime, deadline));
+        }
+    }
+
+    TimerQueryHandle Device::createTimerQuery()
+    {
+        TimerQuery* query = new TimerQuery();
+        return TimerQueryHandle::Create(query);
+    }
+
+    bool Device::pollTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        if (!query->started || !query->queue)
+            return false;
+
+        return query->queue->isInstanceCompleted(query->instance);
+    }
+
+    float Device::getTimerQueryTime(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        if (!query->started || !query->queue)
+            return 0.f;
+
+        query->queue->waitForInstance(query->instance);
+
+        // No work is executed, so no time passes between the timestamps
+        return 0.f;
+    }
+
+    void Device::resetTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        query->started = false;
+        query->queue = nullptr;
+        query->instance = 0;
+    }
+
+    bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
+    {
+        (void)pInfo;
+        (void)infoSize;
+
+        switch (feature)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case Feature::ComputeQueue:
+        case Feature::CopyQueue:
+        case Feature::ConstantBufferRanges:
+        case Feature::DeferredCommandLists:
+        case Feature::Meshlets:
+        case Feature::MeshletIndirect:
+        case Feature::RayQuery:
+        case Feature::RayTracingAccelStruct:
+        case Feature::RayTracingPipeline:
+        case Feature::ShaderSpecializations:
+        case Feature::VirtualResources:
+        case Feature::AsyncReadback:
+        case Feature::WorkGraphs:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    FormatSupport Device::queryFormatSupport(Format format)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(format);
+
+        if (format == Format::UNKNOWN)
+            return FormatSupport::None;
+
+        FormatSupport result = FormatSupport::Texture | FormatSupport::ShaderLoad | FormatSupport::ShaderSample;
+
+        if (formatInfo.hasDepth || formatInfo.hasStencil)
+        {
+            result = result | FormatSupport::DepthStencil;
+            return result;
+        }
+
+        if (formatInfo.blockSize == 1)
+        {
+            result = result | FormatSupport::Buffer | FormatSupport::VertexBuffer | FormatSupport::RenderTarget | FormatSupport::Blendable
+                | FormatSupport::ShaderUavLoad | FormatSupport::ShaderUavStore;
+        }
+
+        if (format == Format::R16_UINT || format == Format::R32_UINT)
+            result = result | FormatSupport::IndexBuffer;
+
+        if (format == Format::R32_UINT || format == Format::R32_SINT)
+            result = result | FormatSupport::ShaderAtomic;
+
+        return result;
+    }
+
+    MemoryAllocatorStats Device::getMemoryAllocatorStats()
+    {
+        // There is no device memory to allocate
+        return MemoryAllocatorStats();
+    }
+
+    MemoryBudget Device::getMemoryBudget()
+    {
+        return MemoryBudget();
+    }
+
+    AccelStructStats Device::getAccelStructStats()
+    {
+        return AccelStructStats();
+    }
+
+    DeviceStats Device::getDeviceStats()
+    {
+        // There are no descriptor heaps
+        return m_Stats.getStats();
+    }
+
+    bool Device::getProfilerFrameResults(ProfilerFrameResults& outResults)
+    {
+        // Nothing executes on a GPU
+        (void)outResults;
+        return false;
+    }
+
+    bool Device::getPipelineCacheData(std::vector<uint8_t>& data)
+    {
+        // Pipelines are not compiled
+        (void)data;
+        return false;
+    }
+
+    coopvec::DeviceFeatures Device::queryCoopVecFeatures()
+    {
+        utils::NotSupported();
+        return coopvec::DeviceFeatures();
+    }
+
+    size_t Device::getCoopVecMatrixSize(coopvec::DataType, coopvec::MatrixLayout, int, int)
+    {
+        utils::NotSupported();
+        return 0;
+    }
+
+} // namespace nvrhi::null
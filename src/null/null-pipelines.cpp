@@ -0,0 +1,299 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::null
+{
+    void Shader::getBytecode(const void** ppBytecode, size_t* pSize) const
+    {
+        if (ppBytecode) *ppBytecode = bytecode->data();
+        if (pSize) *pSize = bytecode->size();
+    }
+
+    void ShaderLibrary::getBytecode(const void** ppBytecode, size_t* pSize) const
+    {
+        if (ppBytecode) *ppBytecode = bytecode->data();
+        if (pSize) *pSize = bytecode->size();
+    }
+
+    ShaderHandle ShaderLibrary::getShader(const char* entryName, ShaderType shaderType)
+    {
+        Shader* shader = new Shader();
+        shader->desc.entryName = entryName;
+        shader->desc.shaderType = shaderType;
+        shader->bytecode = bytecode;
+
+        return ShaderHandle::Create(shader);
+    }
+
+    const VertexAttributeDesc* InputLayout::getAttributeDesc(uint32_t index) const
+    {
+        if (index < uint32_t(attributes.size()))
+            return &attributes[index];
+
+        return nullptr;
+    }
+
+    ShaderHandle Device::createShader(const ShaderDesc& d, const void* binary, size_t binarySize)
+    {
+        Shader* shader = new Shader();
+        shader->desc = d;
+        shader->bytecode = std::make_shared<std::vector<uint8_t>>(static_cast<const uint8_t*>(binary), static_cast<const uint8_t*>(binary) + binarySize);
+
+        return ShaderHandle::Create(shader);
+    }
+
+    ShaderHandle Device::createShaderSpecialization(IShader* _baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        Shader* baseShader = checked_cast<Shader*>(_baseShader);
+
+        Shader* shader = new Shader();
+        shader->desc = baseShader->desc;
+        shader->bytecode = baseShader->bytecode;
+        shader->specializationConstants.assign(constants, constants + numConstants);
+
+        return ShaderHandle::Create(shader);
+    }
+
+    ShaderLibraryHandle Device::createShaderLibrary(const void* binary, size_t binarySize)
+    {
+        ShaderLibrary* library = new ShaderLibrary();
+        library->bytecode = std::make_shared<std::vector<uint8_t>>(static_cast<const uint8_t*>(binary), static_cast<const uint8_t*>(binary) + binarySize);
+
+        return ShaderLibraryHandle::Create(library);
+    }
+
+    InputLayoutHandle Device::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader)
+    {
+        (void)vertexShader;
+
+        InputLayout* layout = new InputLayout();
+        layout->attributes.assign(d, d + attributeCount);
+
+        return InputLayoutHandle::Create(layout);
+    }
+
+    FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
+    {
+        Framebuffer* framebuffer = new Framebuffer(desc);
+        framebuffer->statsEntry.set(&m_Stats, LiveObjectType::Framebuffer);
+        return FramebufferHandle::Create(framebuffer);
+    }
+
+    GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::createGraphicsPipeline");
+
+        GraphicsPipeline* pso = new GraphicsPipeline();
+        pso->statsEntry.set(&m_Stats, LiveObjectType::GraphicsPipeline);
+        pso->desc = desc;
+        pso->framebufferInfo = fbinfo;
+
+        return GraphicsPipelineHandle::Create(pso);
+    }
+
+    GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return createGraphicsPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::createComputePipeline");
+
+        ComputePipeline* pso = new ComputePipeline();
+        pso->statsEntry.set(&m_Stats, LiveObjectType::ComputePipeline);
+        pso->desc = desc;
+
+        return ComputePipelineHandle::Create(pso);
+    }
+
+    MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::createMeshletPipeline");
+
+        MeshletPipeline* pso = new MeshletPipeline();
+        pso->statsEntry.set(&m_Stats, LiveObjectType::MeshletPipeline);
+        pso->desc = desc;
+        pso->framebufferInfo = fbinfo;
+
+        return MeshletPipelineHandle::Create(pso);
+    }
+
+    MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return createMeshletPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    WorkGraphMemoryRequirements WorkGraphPipeline::getMemoryRequirements() const
+    {
+        WorkGraphMemoryRequirements requirements;
+        requirements.minSize = desc.getDispatchArgumentsEnd();
+        requirements.maxSize = requirements.minSize;
+        requirements.sizeGranularity = 4;
+        return requirements;
+    }
+
+    WorkGraphPipelineHandle Device::createWorkGraphPipeline(const WorkGraphPipelineDesc& desc)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::createWorkGraphPipeline");
+
+        WorkGraphPipeline* pso = new WorkGraphPipeline();
+        pso->statsEntry.set(&m_Stats, LiveObjectType::WorkGraphPipeline);
+        pso->desc = desc;
+
+        return WorkGraphPipelineHandle::Create(pso);
+    }
+
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline)
+    {
+        CommandSignature* signature = new CommandSignature();
+        signature->desc = desc;
+        signature->pipeline = pipeline;
+
+        return CommandSignatureHandle::Create(signature);
+    }
+
+    BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
+    {
+        BindingLayout* layout = new BindingLayout();
+        layout->desc = desc;
+
+        return BindingLayoutHandle::Create(layout);
+    }
+
+    BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc& desc)
+    {
+        BindingLayout* layout = new BindingLayout();
+        layout->bindlessDesc = desc;
+        layout->isBindless = true;
+
+        return BindingLayoutHandle::Create(layout);
+    }
+
+    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::createBindingSet");
+
+        BindingSet* bindingSet = new BindingSet();
+        bindingSet->statsEntry.set(&m_Stats, LiveObjectType::BindingSet);
+        bindingSet->desc = desc;
+        bindingSet->layout = layout;
+
+        for (size_t bindingIndex = 0; bindingIndex < desc.bindings.size(); bindingIndex++)
+        {
+            const BindingSetItem& binding = desc.bindings[bindingIndex];
+
+            if (!binding.resourceHandle)
+                continue;
+
+            bindingSet->resources.push_back(binding.resourceHandle);
+
+            switch (binding.type)  // NOLINT(clang-diagnostic-switch-enum)
+            {
+            case ResourceType::Texture_SRV:
+            case ResourceType::Texture_UAV: {
+                const Texture* texture = checked_cast<Texture*>(binding.resourceHandle);
+                const ResourceStates requiredState = binding.type == ResourceType::Texture_SRV
+                    ? ResourceStates::ShaderResource
+                    : ResourceStates::UnorderedAccess;
+
+                if (!texture->permanentState)
+                    bindingSet->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                else
+                    verifyPermanentResourceState(texture->permanentState, requiredState,
+                        true, texture->desc.debugName, m_Context.messageCallback);
+                break;
+            }
+
+            case ResourceType::TypedBuffer_SRV:
+            case ResourceType::StructuredBuffer_SRV:
+            case ResourceType::RawBuffer_SRV:
+            case ResourceType::TypedBuffer_UAV:
+            case ResourceType::StructuredBuffer_UAV:
+            case ResourceType::RawBuffer_UAV:
+            case ResourceType::ConstantBuffer: {
+                const Buffer* buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                const ResourceStates requiredState = binding.type == ResourceType::ConstantBuffer ? ResourceStates::ConstantBuffer
+                    : (binding.type == ResourceType::TypedBuffer_UAV || binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::RawBuffer_UAV)
+                    ? ResourceStates::UnorderedAccess
+                    : ResourceStates::ShaderResource;
+
+                // Volatile constant buffers live in the upload memory and are never transitioned
+                if (buffer->desc.isVolatile)
+                    break;
+
+                if (!buffer->permanentState)
+                    bindingSet->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                else
+                    verifyPermanentResourceState(buffer->permanentState, requiredState,
+                        false, buffer->desc.debugName, m_Context.messageCallback);
+                break;
+            }
+
+            case ResourceType::RayTracingAccelStruct:
+                bindingSet->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                break;
+
+            default:
+                // samplers, push constants and the other bindings have no state
+                break;
+            }
+        }
+
+        return BindingSetHandle::Create(bindingSet);
+    }
+
+    DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
+    {
+        DescriptorTable* descriptorTable = new DescriptorTable();
+        descriptorTable->statsEntry.set(&m_Stats, LiveObjectType::DescriptorTable);
+        descriptorTable->layout = layout;
+
+        return DescriptorTableHandle::Create(descriptorTable);
+    }
+
+    void Device::resizeDescriptorTable(IDescriptorTable* _descriptorTable, uint32_t newSize, bool keepContents)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (!keepContents)
+            descriptorTable->descriptors.clear();
+
+        descriptorTable->descriptors.resize(newSize, BindingSetItem::None());
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& item)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (item.slot >= descriptorTable->descriptors.size())
+            return false;
+
+        descriptorTable->descriptors[item.slot] = item;
+        return true;
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,542 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <cstring>
+
+namespace nvrhi::null
+{
+    // Sizes of the records that a real shader table and TLAS build would write into the upload memory
+    static constexpr uint32_t c_ShaderTableEntrySize = 64;
+    static constexpr uint64_t c_AccelStructAlignment = 256;
+
+    static uint64_t getGeometryPrimitiveCount(const rt::GeometryDesc& geometry)
+    {
+        switch (geometry.geometryType)
+        {
+        case rt::GeometryType::Triangles: {
+            const rt::GeometryTriangles& triangles = geometry.geometryData.triangles;
+            return (triangles.indexFormat != Format::UNKNOWN ? triangles.indexCount : triangles.vertexCount) / 3;
+        }
+        case rt::GeometryType::AABBs:
+            return geometry.geometryData.aabbs.count;
+        case rt::GeometryType::Spheres:
+            return geometry.geometryData.spheres.vertexCount;
+        case rt::GeometryType::Lss:
+            return geometry.geometryData.lss.primitiveCount;
+        default:
+            return 0;
+        }
+    }
+
+    BufferHandle Device::createAccelStructDataBuffer(const rt::AccelStructDesc& desc, uint64_t size)
+    {
+        BufferDesc bufferDesc;
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.byteSize = size;
+        bufferDesc.initialState = desc.isTopLevel ? ResourceStates::AccelStructRead : ResourceStates::AccelStructBuildBlas;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.isAccelStructStorage = true;
+        bufferDesc.debugName = desc.debugName;
+        bufferDesc.isVirtual = desc.isVirtual;
+
+        return createBuffer(bufferDesc);
+    }
+
+    rt::AccelStructHandle Device::createAccelStruct(const rt::AccelStructDesc& desc)
+    {
+        // Rough estimates of the result size, there is no driver to ask
+        uint64_t size = c_AccelStructAlignment;
+        if (desc.isTopLevel)
+        {
+            size += uint64_t(desc.topLevelMaxInstances) * sizeof(rt::InstanceDesc);
+        }
+        else
+        {
+            for (const rt::GeometryDesc& geometry : desc.bottomLevelGeometries)
+                size += getGeometryPrimitiveCount(geometry) * 64;
+        }
+
+        AccelStruct* as = new AccelStruct();
+        as->desc = desc;
+        as->dataBuffer = createAccelStructDataBuffer(desc, align(size, c_AccelStructAlignment));
+
+        return rt::AccelStructHandle::Create(as);
+    }
+
+    MemoryRequirements Device::getAccelStructMemoryRequirements(rt::IAccelStruct* _as)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        return getBufferMemoryRequirements(as->dataBuffer);
+    }
+
+    bool Device::bindAccelStructMemory(rt::IAccelStruct* _as, IHeap* heap, uint64_t offset)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        return bindBufferMemory(as->dataBuffer, heap, offset);
+    }
+
+    rt::OpacityMicromapHandle Device::createOpacityMicromap(const rt::OpacityMicromapDesc& desc)
+    {
+        (void)desc;
+
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    rt::cluster::OperationSizeInfo Device::getClusterOperationSizeInfo(const rt::cluster::OperationParams& params)
+    {
+        (void)params;
+
+        utils::NotSupported();
+        return rt::cluster::OperationSizeInfo();
+    }
+
+    rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::null::createRayTracingPipeline");
+
+        RayTracingPipeline* pso = new RayTracingPipeline(m_Context);
+        pso->statsEntry.set(&m_Stats, LiveObjectType::RayTracingPipeline);
+        pso->desc = desc;
+
+        for (const rt::PipelineShaderDesc& shaderDesc : desc.shaders)
+        {
+            std::string exportName = shaderDesc.exportName;
+            if (exportName.empty() && shaderDesc.shader)
+                exportName = shaderDesc.shader->getDesc().entryName;
+
+            pso->exports[exportName] = shaderDesc.bindingLayout;
+        }
+
+        for (const rt::PipelineHitGroupDesc& hitGroupDesc : desc.hitGroups)
+        {
+            pso->exports[hitGroupDesc.exportName] = hitGroupDesc.bindingLayout;
+        }
+
+        return rt::PipelineHandle::Create(pso);
+    }
+
+    rt::ShaderTableHandle RayTracingPipeline::createShaderTable(const rt::ShaderTableDesc& shaderTableDesc)
+    {
+        ShaderTable* shaderTable = new ShaderTable(m_Context, this, shaderTableDesc);
+        return rt::ShaderTableHandle::Create(shaderTable);
+    }
+
+    uint32_t ShaderTable::getNumEntries() const
+    {
+        return 1 + // rayGeneration
+            uint32_t(missShaders.size()) +
+            uint32_t(hitGroups.size()) +
+            uint32_t(callableShaders.size());
+    }
+
+    bool ShaderTable::verifyExport(const char* exportName, IBindingSet* bindings) const
+    {
+        auto it = pipeline->exports.find(exportName);
+        if (it == pipeline->exports.end())
+        {
+            m_Context.error("Couldn't find a ray tracing pipeline export with a given name");
+            return false;
+        }
+
+        const BindingLayoutHandle& bindingLayout = it->second;
+
+        if (bindingLayout && !bindings)
+        {
+            m_Context.error("A shader table entry does not provide required local bindings");
+            return false;
+        }
+
+        if (!bindingLayout && bindings)
+        {
+            m_Context.error("A shader table entry provides local bindings, but none are required");
+            return false;
+        }
+
+        if (bindings && (bindings->getLayout() != bindingLayout))
+        {
+            m_Context.error("A shader table entry provides local bindings that do not match the expected layout");
+            return false;
+        }
+
+        return true;
+    }
+
+    void ShaderTable::setRayGenerationShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (verifyExport(exportName, bindings))
+        {
+            rayGenerationShader.exportName = exportName;
+            rayGenerationShader.localBindings = bindings;
+
+            ++version;
+        }
+    }
+
+    int ShaderTable::addEntry(std::vector<Entry>& entries, const char* exportName, IBindingSet* bindings)
+    {
+        if (!verifyExport(exportName, bindings))
+            return -1;
+
+        Entry entry;
+        entry.exportName = exportName;
+        entry.localBindings = bindings;
+        entries.push_back(entry);
+
+        ++version;
+
+        return int(entries.size()) - 1;
+    }
+
+    bool ShaderTable::setEntry(std::vector<Entry>& entries, int index, const char* exportName, IBindingSet* bindings)
+    {
+        if (index < 0 || size_t(index) >= entries.size())
+        {
+            m_Context.error("Shader table record index is out of bounds");
+            return false;
+        }
+
+        if (!verifyExport(exportName, bindings))
+            return false;
+
+        Entry& entry = entries[index];
+        entry.exportName = exportName;
+        entry.localBindings = bindings;
+
+        ++version;
+
+        return true;
+    }
+
+    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addEntry(missShaders, exportName, bindings);
+    }
+
+    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addEntry(hitGroups, exportName, bindings);
+    }
+
+    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addEntry(callableShaders, exportName, bindings);
+    }
+
+    bool ShaderTable::setMissShader(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(missShaders, index, exportName, bindings);
+    }
+
+    bool ShaderTable::setHitGroup(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(hitGroups, index, exportName, bindings);
+    }
+
+    bool ShaderTable::setCallableShader(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(callableShaders, index, exportName, bindings);
+    }
+
+    void ShaderTable::clearMissShaders()
+    {
+        missShaders.clear();
+        ++version;
+    }
+
+    void ShaderTable::clearHitShaders()
+    {
+        hitGroups.clear();
+        ++version;
+    }
+
+    void ShaderTable::clearCallableShaders()
+    {
+        callableShaders.clear();
+        ++version;
+    }
+
+    void CommandList::uploadShaderTable(ShaderTable* shaderTable)
+    {
+        // Like the non-persistent shader tables on D3D12, the records are written into the upload memory
+        // on the first use in a command list and after every change
+        auto it = m_ShaderTableVersions.find(shaderTable);
+        if (it != m_ShaderTableVersions.end() && it->second == shaderTable->version)
+            return;
+
+        const uint32_t sbtSize = shaderTable->getNumEntries() * c_ShaderTableEntrySize;
+        void* cpuVA = m_UploadManager.suballocate(sbtSize, m_RecordingVersion, c_ShaderTableEntrySize);
+        memset(cpuVA, 0, sbtSize);
+
+        m_ShaderTableVersions[shaderTable] = shaderTable->version;
+
+        m_Instance->referencedResources.add(shaderTable);
+    }
+
+    void CommandList::setRayTracingState(const rt::State& state)
+    {
+        ShaderTable* shaderTable = checked_cast<ShaderTable*>(state.shaderTable);
+
+        uploadShaderTable(shaderTable);
+
+        if (!m_CurrentRayTracingStateValid || m_CurrentRayTracingState.shaderTable->getPipeline() != shaderTable->getPipeline())
+            ++m_Stats.pipelineBinds;
+
+        const uint32_t bindingUpdateMask = m_CurrentRayTracingStateValid
+            ? arrayDifferenceMask(m_CurrentRayTracingState.bindings, state.bindings)
+            : ~0u;
+
+        setBindings(state.bindings, bindingUpdateMask);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            auto setLocalBindings = [this](const ShaderTable::Entry& entry)
+            {
+                if (entry.localBindings)
+                    setResourceStatesForBindingSet(entry.localBindings);
+            };
+
+            setLocalBindings(shaderTable->rayGenerationShader);
+            for (const auto& entry : shaderTable->missShaders)
+                setLocalBindings(entry);
+            for (const auto& entry : shaderTable->hitGroups)
+                setLocalBindings(entry);
+            for (const auto& entry : shaderTable->callableShaders)
+                setLocalBindings(entry);
+        }
+
+        commitBarriers();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = true;
+        m_CurrentWorkGraphStateValid = false;
+        m_CurrentRayTracingState = state;
+    }
+
+    void CommandList::dispatchRays(const rt::DispatchRaysArguments& args)
+    {
+        (void)args;
+
+        if (!m_CurrentRayTracingStateValid)
+        {
+            m_Context.error("setRayTracingState must be called before dispatchRays");
+            return;
+        }
+
+        ++m_Stats.dispatches;
+    }
+
+    void CommandList::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc)
+    {
+        (void)omm;
+        (void)desc;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds)
+    {
+        (void)pBuilds;
+        (void)numBuilds;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::compactOpacityMicromaps()
+    {
+    }
+
+    void CommandList::bindAccelStructBuildInputs(const rt::GeometryDesc* pGeometries, size_t numGeometries)
+    {
+        auto requireInput = [this](IBuffer* buffer)
+        {
+            if (!buffer)
+                return;
+
+            if (m_EnableAutomaticBarriers)
+                requireBufferState(buffer, ResourceStates::AccelStructBuildInput);
+
+            referenceBuffer(buffer);
+        };
+
+        for (size_t i = 0; i < numGeometries; i++)
+        {
+            const rt::GeometryDesc& geometry = pGeometries[i];
+
+            switch (geometry.geometryType)
+            {
+            case rt::GeometryType::Triangles:
+                requireInput(geometry.geometryData.triangles.indexBuffer);
+                requireInput(geometry.geometryData.triangles.vertexBuffer);
+                break;
+            case rt::GeometryType::AABBs:
+                requireInput(geometry.geometryData.aabbs.buffer);
+                break;
+            case rt::GeometryType::Spheres:
+                requireInput(geometry.geometryData.spheres.indexBuffer);
+                requireInput(geometry.geometryData.spheres.vertexBuffer);
+                break;
+            case rt::GeometryType::Lss:
+                requireInput(geometry.geometryData.lss.indexBuffer);
+                requireInput(geometry.geometryData.lss.vertexBuffer);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void CommandList::buildBottomLevelAccelStructInternal(AccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries)
+    {
+        bindAccelStructBuildInputs(pGeometries, numGeometries);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->dataBuffer, ResourceStates::AccelStructWrite);
+        }
+
+        if (as->desc.trackLiveness)
+            m_Instance->referencedResources.add(as);
+    }
+
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        (void)buildFlags;
+
+        buildBottomLevelAccelStructInternal(as, pGeometries, numGeometries);
+
+        commitBarriers();
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& build = pBuilds[i];
+            buildBottomLevelAccelStructInternal(checked_cast<AccelStruct*>(build.accelStruct), build.pGeometries, build.numGeometries);
+        }
+
+        commitBarriers();
+    }
+
+    void CommandList::compactBottomLevelAccelStructs()
+    {
+    }
+
+    void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        (void)buildFlags;
+
+        as->bottomLevelASes.clear();
+
+        // Write the instances into the upload memory like the other backends do
+        const size_t uploadSize = sizeof(rt::InstanceDesc) * numInstances;
+        if (uploadSize)
+        {
+            void* cpuVA = m_UploadManager.suballocate(uploadSize, m_RecordingVersion);
+            memcpy(cpuVA, pInstances, uploadSize);
+        }
+
+        AccelStruct* previousBlas = nullptr;
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            AccelStruct* blas = checked_cast<AccelStruct*>(pInstances[i].bottomLevelAS);
+            if (!blas || blas == previousBlas)
+                continue;
+            previousBlas = blas;
+
+            if (blas->desc.trackLiveness)
+                as->bottomLevelASes.push_back(blas);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(blas->dataBuffer, ResourceStates::AccelStructBuildBlas);
+            }
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->dataBuffer, ResourceStates::AccelStructWrite);
+        }
+        commitBarriers();
+
+        if (as->desc.trackLiveness)
+            m_Instance->referencedResources.add(as);
+    }
+
+    void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        (void)instanceBufferOffset;
+        (void)numInstances;
+        (void)buildFlags;
+
+        as->bottomLevelASes.clear();
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->dataBuffer, ResourceStates::AccelStructWrite);
+            requireBufferState(instanceBuffer, ResourceStates::AccelStructBuildInput);
+        }
+        commitBarriers();
+
+        referenceBuffer(instanceBuffer);
+
+        if (as->desc.trackLiveness)
+            m_Instance->referencedResources.add(as);
+    }
+
+    void CommandList::buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* _as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+        nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        (void)argsBufferOffset;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(argsBuffer, ResourceStates::IndirectArgument);
+        }
+
+        referenceBuffer(argsBuffer);
+
+        buildTopLevelAccelStructFromBuffer(_as, instanceBuffer, instanceBufferOffset, maxInstances, buildFlags);
+    }
+
+    void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
+    {
+        (void)desc;
+
+        utils::NotSupported();
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,307 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <sstream>
+
+namespace nvrhi::null
+{
+    void getSubresourceLayout(const TextureDesc& desc, uint32_t mipLevel, size_t* pRowPitch, size_t* pDepthPitch, uint32_t* pDepth)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+        const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        const size_t rowPitch = size_t((width + blockSize - 1) / blockSize) * formatInfo.bytesPerBlock;
+        const size_t numRows = size_t((height + blockSize - 1) / blockSize);
+
+        if (pRowPitch) *pRowPitch = rowPitch;
+        if (pDepthPitch) *pDepthPitch = rowPitch * numRows;
+        if (pDepth) *pDepth = depth;
+    }
+
+    static uint64_t getTextureSize(const TextureDesc& desc)
+    {
+        uint64_t size = 0;
+
+        for (uint32_t mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+        {
+            size_t depthPitch = 0;
+            uint32_t depth = 0;
+            getSubresourceLayout(desc, mipLevel, nullptr, &depthPitch, &depth);
+
+            size += uint64_t(depthPitch) * depth;
+        }
+
+        return size * desc.arraySize * std::max(desc.sampleCount, 1u);
+    }
+
+    Object Texture::getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV)
+    {
+        // There are no native views
+        (void)objectType;
+        (void)format;
+        (void)subresources;
+        (void)dimension;
+        (void)isReadOnlyDSV;
+        return nullptr;
+    }
+
+    StagingTexture::StagingTexture(TextureDesc _desc, CpuAccessMode _cpuAccess)
+        : desc(std::move(_desc))
+        , cpuAccess(_cpuAccess)
+    {
+        size_t offset = 0;
+
+        for (uint32_t arraySlice = 0; arraySlice < desc.arraySize; arraySlice++)
+        {
+            for (uint32_t mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+            {
+                SubresourceLayout layout;
+                uint32_t depth = 0;
+                getSubresourceLayout(desc, mipLevel, &layout.rowPitch, &layout.depthPitch, &depth);
+                layout.offset = offset;
+
+                subresources.push_back(layout);
+                offset += layout.depthPitch * depth;
+            }
+        }
+
+        memory.resize(offset);
+    }
+
+    HeapHandle Device::createHeap(const HeapDesc& d)
+    {
+        Heap* heap = new Heap(d);
+        heap->statsEntry.set(&m_Stats, LiveObjectType::Heap, d.capacity);
+        return HeapHandle::Create(heap);
+    }
+
+    TextureHandle Device::createTexture(const TextureDesc& d)
+    {
+        Texture* texture = new Texture(d);
+        texture->statsEntry.set(&m_Stats, LiveObjectType::Texture, getTextureSize(d));
+        return TextureHandle::Create(texture);
+    }
+
+    MemoryRequirements Device::getTextureMemoryRequirements(ITexture* _texture)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        MemoryRequirements memReq;
+        memReq.alignment = 65536;
+        memReq.size = align(getTextureSize(texture->desc), memReq.alignment);
+        return memReq;
+    }
+
+    bool Device::bindTextureMemory(ITexture* _texture, IHeap* heap, uint64_t offset)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (texture->heap)
+            return false;
+
+        if (!texture->desc.isVirtual)
+            return false;
+
+        if (offset + getTextureMemoryRequirements(texture).size > heap->getDesc().capacity)
+            return false;
+
+        texture->heap = heap;
+        return true;
+    }
+
+    TextureHandle Device::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
+    {
+        // There are no native textures to wrap
+        (void)objectType;
+        (void)texture;
+        (void)desc;
+        return nullptr;
+    }
+
+    StagingTextureHandle Device::createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
+    {
+        StagingTexture* stagingTexture = new StagingTexture(d, cpuAccess);
+        stagingTexture->statsEntry.set(&m_Stats, LiveObjectType::StagingTexture, stagingTexture->memory.size());
+        return StagingTextureHandle::Create(stagingTexture);
+    }
+
+    void* Device::mapStagingTexture(IStagingTexture* _tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t* outRowPitch)
+    {
+        StagingTexture* tex = checked_cast<StagingTexture*>(_tex);
+
+        assert(slice.x == 0);
+        assert(slice.y == 0);
+        assert(cpuAccess != CpuAccessMode::None);
+        (void)cpuAccess;
+
+        // Wait for the command lists that copy to or from the texture, like mapping a real staging texture does
+        if (tex->lastUseQueue)
+            tex->lastUseQueue->waitForInstance(tex->lastUseInstance);
+
+        const uint32_t subresource = slice.arraySlice * tex->desc.mipLevels + slice.mipLevel;
+        if (subresource >= tex->subresources.size())
+            return nullptr;
+
+        const StagingTexture::SubresourceLayout& layout = tex->subresources[subresource];
+
+        if (outRowPitch)
+            *outRowPitch = layout.rowPitch;
+
+        return tex->memory.data() + layout.offset + layout.depthPitch * slice.z;
+    }
+
+    void Device::unmapStagingTexture(IStagingTexture* tex)
+    {
+        (void)tex;
+    }
+
+    void Device::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        (void)texture;
+        (void)numTiles;
+        (void)desc;
+        (void)tileShape;
+        (void)subresourceTilingsNum;
+        (void)subresourceTilings;
+
+        utils::NotSupported();
+    }
+
+    void Device::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        (void)texture;
+        (void)tileMappings;
+        (void)numTileMappings;
+        (void)executionQueue;
+
+        utils::NotSupported();
+    }
+
+    SamplerFeedbackTextureHandle Device::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+        (void)pairedTexture;
+        (void)desc;
+
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    SamplerFeedbackTextureHandle Device::createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture)
+    {
+        (void)objectType;
+        (void)texture;
+        (void)pairedTexture;
+
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    BufferHandle Device::createBuffer(const BufferDesc& d)
+    {
+        Buffer* buffer = new Buffer(d);
+        buffer->statsEntry.set(&m_Stats, LiveObjectType::Buffer, d.byteSize);
+        buffer->gpuAddress = m_Context.allocateGpuAddress(d.byteSize);
+
+        if (d.cpuAccess != CpuAccessMode::None)
+            buffer->memory.resize(size_t(d.byteSize));
+
+        return BufferHandle::Create(buffer);
+    }
+
+    void* Device::mapBuffer(IBuffer* _buffer, CpuAccessMode mapFlags)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        (void)mapFlags;
+
+        if (buffer->memory.empty())
+        {
+            std::stringstream ss;
+            ss << "Cannot map buffer " << utils::DebugNameToString(buffer->desc.debugName)
+               << " because it was created without CPU access";
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        // Wait for the command lists that use the buffer, like mapping a real readback or upload buffer does
+        if (buffer->lastUseQueue)
+            buffer->lastUseQueue->waitForInstance(buffer->lastUseInstance);
+
+        return buffer->memory.data();
+    }
+
+    void Device::unmapBuffer(IBuffer* buffer)
+    {
+        (void)buffer;
+    }
+
+    MemoryRequirements Device::getBufferMemoryRequirements(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        MemoryRequirements memReq;
+        memReq.alignment = 65536;
+        memReq.size = align(buffer->desc.byteSize, memReq.alignment);
+        return memReq;
+    }
+
+    bool Device::bindBufferMemory(IBuffer* _buffer, IHeap* heap, uint64_t offset)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (buffer->heap)
+            return false;
+
+        if (!buffer->desc.isVirtual)
+            return false;
+
+        if (offset + buffer->desc.byteSize > heap->getDesc().capacity)
+            return false;
+
+        buffer->heap = heap;
+        return true;
+    }
+
+    BufferHandle Device::createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc)
+    {
+        // There are no native buffers to wrap
+        (void)objectType;
+        (void)buffer;
+        (void)desc;
+        return nullptr;
+    }
+
+    SamplerHandle Device::createSampler(const SamplerDesc& d)
+    {
+        Sampler* sampler = new Sampler(d);
+        sampler->statsEntry.set(&m_Stats, LiveObjectType::Sampler);
+        return SamplerHandle::Create(sampler);
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,106 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::null
+{
+    static constexpr uint64_t c_ChunkSizeAlignment = 4096;
+
+    UploadManager::UploadManager(Queue* pQueue, size_t defaultChunkSize)
+        : m_Queue(pQueue)
+        , m_DefaultChunkSize(defaultChunkSize)
+    {
+        assert(pQueue);
+    }
+
+    void* UploadManager::suballocate(uint64_t size, uint64_t currentVersion, uint32_t alignment)
+    {
+        // Try to allocate from the current chunk first
+        if (m_CurrentChunk != nullptr)
+        {
+            uint64_t alignedOffset = align(m_CurrentChunk->writePointer, (uint64_t)alignment);
+            uint64_t endOfDataInChunk = alignedOffset + size;
+
+            if (endOfDataInChunk <= m_CurrentChunk->bufferSize)
+            {
+                m_CurrentChunk->writePointer = endOfDataInChunk;
+                return m_CurrentChunk->memory.get() + alignedOffset;
+            }
+
+            m_ChunkPool.push_back(m_CurrentChunk);
+            m_CurrentChunk.reset();
+        }
+
+        uint64_t completedInstance = m_Queue->updateLastCompletedInstance();
+
+        // Try to find a chunk in the pool that's no longer used and is large enough to allocate our buffer
+        for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); ++it)
+        {
+            std::shared_ptr<UploadChunk> chunk = *it;
+
+            if (VersionGetSubmitted(chunk->version)
+                && VersionGetInstance(chunk->version) <= completedInstance)
+            {
+                chunk->version = 0;
+            }
+
+            if (chunk->version == 0 && chunk->bufferSize >= size)
+            {
+                m_ChunkPool.erase(it);
+                m_CurrentChunk = chunk;
+                break;
+            }
+        }
+
+        if (!m_CurrentChunk)
+        {
+            m_CurrentChunk = std::make_shared<UploadChunk>();
+            m_CurrentChunk->bufferSize = align(std::max(size, uint64_t(m_DefaultChunkSize)), c_ChunkSizeAlignment);
+            m_CurrentChunk->memory.reset(new uint8_t[size_t(m_CurrentChunk->bufferSize)]);
+            m_CurrentChunk->statsEntry.setUploadChunk(&m_Queue->stats, m_CurrentChunk->bufferSize);
+        }
+
+        m_CurrentChunk->version = currentVersion;
+        m_CurrentChunk->writePointer = size;
+
+        return m_CurrentChunk->memory.get();
+    }
+
+    void UploadManager::submitChunks(uint64_t currentVersion, uint64_t submittedVersion)
+    {
+        if (m_CurrentChunk)
+        {
+            m_ChunkPool.push_back(m_CurrentChunk);
+            m_CurrentChunk.reset();
+        }
+
+        for (const auto& chunk : m_ChunkPool)
+        {
+            if (chunk->version == currentVersion)
+                chunk->version = submittedVersion;
+        }
+    }
+
+} // namespace nvrhi::null
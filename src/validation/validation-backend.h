@@ -163,10 +163,19 @@ namespace nvrhi::validation
         bool m_GraphicsStateSet = false;
         bool m_ComputeStateSet = false;
         bool m_MeshletStateSet = false;
+        bool m_WorkGraphStateSet = false;
         bool m_RayTracingStateSet = false;
+        bool m_WriteInProgress = false;
+        bool m_IsSecondary = false;
+        bool m_IsReusable = false;
+        bool m_DeepValidation = true;
+        FramebufferHandle m_SecondaryFramebuffer;
+        // Volatile buffers written since a reusable command list was opened
+        std::unordered_set<IBuffer*> m_WrittenVolatileBuffers;
         GraphicsState m_CurrentGraphicsState;
         ComputeState m_CurrentComputeState;
         MeshletState m_CurrentMeshletState;
+        WorkGraphState m_CurrentWorkGraphState;
         rt::State m_CurrentRayTracingState;
 
         size_t m_PipelinePushConstantSize = 0;
@@ -178,12 +187,21 @@ namespace nvrhi::validation
         bool requireOpenState() const;
         bool requireExecuteState();
         bool requireType(CommandQueue queueType, const char* operation) const;
+        bool requirePrimary(const char* operation) const;
+        // The checks against the binding layouts and the framebuffer info are only done with 'deep' set
+        bool validateGraphicsState(const GraphicsState& state, bool deep) const;
+        bool validateComputeState(const ComputeState& state, bool deep) const;
+        bool validateReadback(const char* operation);
         ICommandList* getUnderlyingCommandList() const { return m_CommandList; }
 
         void evaluatePushConstantSize(const nvrhi::BindingLayoutVector& bindingLayouts);
         bool validatePushConstants(const char* pipelineType, const char* stateFunctionName) const;
+        bool validateVolatileBufferWrites(const BindingSetVector& bindings) const;
+        bool validateDispatchMeshIndirect(const char* operation, uint32_t offsetBytes, uint32_t dispatchCount);
+        bool validateDrawBatch(const char* operation, bool indexed, const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) const;
         bool validateBindingSetsAgainstLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& layouts, const static_vector<IBindingSet*, c_MaxBindingLayouts>& sets) const;
 
+        bool validateBuildBottomLevelAccelStruct(AccelStructWrapper* wrapper, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) const;
         bool validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const;
 
     public:
@@ -196,6 +214,8 @@ namespace nvrhi::validation
 
         void open() override;
         void close() override;
+        void openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport) override;
+        void executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists) override;
         void clearState() override;
 
         void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
@@ -209,38 +229,61 @@ namespace nvrhi::validation
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
+        MappedWriteRegion beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
+        MappedWriteRegion beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes) override;
+        void commitWrite() override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        ReadbackTicketHandle readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback) override;
+        ReadbackTicketHandle readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback) override;
 
         void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
         void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format) override;
         void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
+        void setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings) override;
+        BindingSetHandle createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
+        void drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
+        void drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
         void dispatchIndirect(uint32_t offsetBytes)  override;
 
         void setMeshletState(const MeshletState& state) override;
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const WorkGraphDispatchArguments& args) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+            nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
@@ -266,6 +309,9 @@ namespace nvrhi::validation
 
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, ResourceStates nextState) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
 
         void commitBarriers() override;
         
@@ -274,6 +320,7 @@ namespace nvrhi::validation
 
         IDevice* getDevice() override;
         const CommandListParameters& getDesc() override;
+        CommandListStats getStats() override;
     };
 
     class DeviceWrapper : public RefCounter<IDevice>
@@ -281,20 +328,27 @@ namespace nvrhi::validation
     public:
         friend class CommandListWrapper;
 
-        DeviceWrapper(IDevice* device);
+        DeviceWrapper(IDevice* device, const ValidationLayerDesc& desc);
         
     protected:
         DeviceHandle m_Device;
         IMessageCallback* m_MessageCallback;
+        ValidationLayerDesc m_Desc;
         std::atomic<unsigned int> m_NumOpenImmediateCommandLists = 0;
+        std::atomic<uint32_t> m_NumSamplingDecisions = 0;
 
         void error(const std::string& messageText) const;
         void warning(const std::string& messageText) const;
 
+        // Decides whether the next command list recording or binding set creation gets the full checks
+        bool sampleDeepValidation();
+
         bool validateBindingSetItem(const BindingSetItem& binding, IDescriptorTable *pOptDescriptorTable, std::stringstream& errorStream);
+        bool validateBindingSet(const BindingSetDesc& desc, IBindingLayout* layout, bool checkResources);
         bool validatePipelineBindingLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& bindingLayouts, const std::vector<IShader*>& shaders) const;
         bool validateShaderType(ShaderType expected, const ShaderDesc& shaderDesc, const char* function) const;
         bool validateRenderState(const RenderState& renderState, FramebufferInfo const& fbinfo) const;
+        bool validateSubmissionTickets(const SubmissionTicket* tickets, size_t numTickets, const char* function) const;
 
         bool validateClusterOperationParams(const rt::cluster::OperationParams& params) const;
     public:
@@ -345,6 +399,10 @@ namespace nvrhi::validation
         bool pollEventQuery(IEventQuery* query) override;
         void waitEventQuery(IEventQuery* query) override;
         void resetEventQuery(IEventQuery* query) override;
+        SubmissionTicket getSubmissionTicket(CommandQueue queue) override;
+        bool pollSubmission(const SubmissionTicket& ticket) override;
+        bool waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
+        bool waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
 
         // timer queries
         TimerQueryHandle createTimerQuery() override;
@@ -365,9 +423,12 @@ namespace nvrhi::validation
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
 
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        WorkGraphPipelineHandle createWorkGraphPipeline(const WorkGraphPipelineDesc& desc) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
 
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline) override;
+
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
 
@@ -386,10 +447,19 @@ namespace nvrhi::validation
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void flushSubmissions() override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        void runGarbageCollection(uint32_t maxReleaseMicroseconds) override;
+        void evictCachedFramebuffers(ITexture* texture) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
+        MemoryAllocatorStats getMemoryAllocatorStats() override;
+        MemoryBudget getMemoryBudget() override;
+        AccelStructStats getAccelStructStats() override;
+        DeviceStats getDeviceStats() override;
+        bool getProfilerFrameResults(ProfilerFrameResults& outResults) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& data) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
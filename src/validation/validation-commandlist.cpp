@@ -26,6 +26,7 @@
 #include <nvrhi/utils.h>
 
 #include <sstream>
+#include <unordered_set>
 
 
 namespace nvrhi::validation
@@ -37,6 +38,8 @@ namespace nvrhi::validation
         , m_MessageCallback(device->getMessageCallback())
         , m_IsImmediate(isImmediate)
         , m_type(queueType)
+        , m_IsSecondary(commandList->getDesc().isSecondary)
+        , m_IsReusable(commandList->getDesc().isReusable)
     {
     }
     
@@ -84,7 +87,14 @@ namespace nvrhi::validation
     bool CommandListWrapper::requireOpenState() const
     {
         if (m_State == CommandListState::OPEN)
-            return true;
+        {
+            if (!m_WriteInProgress)
+                return true;
+
+            error("Cannot record commands into a command list while a write started with beginWriteTexture "
+                "or beginWriteBuffer is not committed");
+            return false;
+        }
 
         std::stringstream ss;
         ss << "A command list must be opened before any rendering commands can be executed. "
@@ -109,7 +119,10 @@ namespace nvrhi::validation
             break;
         }
 
-        m_State = CommandListState::INITIAL;
+        // Reusable command lists can be executed again until they are re-opened
+        if (!m_IsReusable)
+            m_State = CommandListState::INITIAL;
+
         return true;
     }
 
@@ -125,6 +138,24 @@ namespace nvrhi::validation
             return false;
         }
 
+        // Compute and copy operations are never allowed inside a render pass
+        if (queueType != CommandQueue::Graphics)
+            return requirePrimary(operation);
+
+        return true;
+    }
+
+    bool CommandListWrapper::requirePrimary(const char* operation) const
+    {
+        if (m_IsSecondary)
+        {
+            std::stringstream ss;
+            ss << "The '" << operation << "' operation cannot be recorded into a secondary command list";
+            error(ss.str());
+
+            return false;
+        }
+
         return true;
     }
 
@@ -135,13 +166,24 @@ namespace nvrhi::validation
 
     void CommandListWrapper::open()
     {
+        if (m_IsSecondary)
+        {
+            error("Secondary command lists must be opened with openSecondary");
+            return;
+        }
+
         switch (m_State)
         {
         case CommandListState::OPEN:
             error("Cannot open a command list that is already open");
             return;
         case CommandListState::CLOSED:
-            if (m_IsImmediate)
+            if (m_IsReusable)
+            {
+                // Re-recording a reusable command list is expected, executed or not
+                break;
+            }
+            else if (m_IsImmediate)
             {
                 error("An immediate command list cannot be abandoned and must be executed before it is re-opened");
                 return;
@@ -169,9 +211,13 @@ namespace nvrhi::validation
         m_CommandList->open();
 
         m_State = CommandListState::OPEN;
+        m_WrittenVolatileBuffers.clear();
+        m_DeepValidation = m_Device->sampleDeepValidation();
+        m_WriteInProgress = false;
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
     }
 
     void CommandListWrapper::close()
@@ -189,6 +235,13 @@ namespace nvrhi::validation
             break;
         }
 
+        if (m_WriteInProgress)
+        {
+            error("Cannot close a command list while a write started with beginWriteTexture or beginWriteBuffer "
+                "is not committed");
+            return;
+        }
+
         if (m_IsImmediate)
         {
             --m_Device->m_NumOpenImmediateCommandLists;
@@ -200,6 +253,115 @@ namespace nvrhi::validation
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
+    }
+
+    void CommandListWrapper::openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport)
+    {
+        if (!m_IsSecondary)
+        {
+            error("openSecondary can only be used on command lists created with isSecondary = true");
+            return;
+        }
+
+        if (m_State == CommandListState::OPEN)
+        {
+            error("Cannot open a command list that is already open");
+            return;
+        }
+
+        if (m_State == CommandListState::CLOSED)
+        {
+            warning("A command list should be executed before it is reopened");
+        }
+
+        if (!framebuffer)
+        {
+            error("openSecondary: framebuffer is NULL");
+            return;
+        }
+
+        if (viewport.viewports.empty())
+        {
+            error("openSecondary: at least one viewport must be specified");
+            return;
+        }
+
+        m_CommandList->openSecondary(framebuffer, viewport);
+
+        m_State = CommandListState::OPEN;
+        m_DeepValidation = m_Device->sampleDeepValidation();
+        m_WriteInProgress = false;
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = false;
+        m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
+        m_SecondaryFramebuffer = framebuffer;
+    }
+
+    void CommandListWrapper::executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "executeSecondaryCommandLists"))
+            return;
+
+        if (!requirePrimary("executeSecondaryCommandLists"))
+            return;
+
+        if (m_IsReusable)
+        {
+            error("executeSecondaryCommandLists: secondary command lists cannot be executed in a reusable command list");
+            return;
+        }
+
+        if (numCommandLists == 0)
+            return;
+
+        if (pCommandLists == nullptr)
+        {
+            error("executeSecondaryCommandLists: pCommandLists is NULL");
+            return;
+        }
+
+        std::vector<ICommandList*> unwrappedCommandLists;
+        unwrappedCommandLists.resize(numCommandLists);
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(pCommandLists[i]);
+
+            if (!wrapper)
+            {
+                std::stringstream ss;
+                ss << "executeSecondaryCommandLists: pCommandLists[" << i << "] is NULL or not a validation layer command list";
+                error(ss.str());
+                return;
+            }
+
+            if (!wrapper->m_IsSecondary)
+            {
+                std::stringstream ss;
+                ss << "executeSecondaryCommandLists: pCommandLists[" << i << "] was not created with isSecondary = true";
+                error(ss.str());
+                return;
+            }
+
+            if (!wrapper->requireExecuteState())
+                return;
+
+            unwrappedCommandLists[i] = wrapper->getUnderlyingCommandList();
+        }
+
+        m_CommandList->executeSecondaryCommandLists(unwrappedCommandLists.data(), numCommandLists);
+
+        // The graphics state is reset by the backend after the secondary command lists
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = false;
+        m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
+        m_RayTracingStateSet = false;
     }
 
     void CommandListWrapper::clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor)
@@ -248,6 +410,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("clearDepthStencilTexture"))
+            return;
+
         if (!requireType(CommandQueue::Graphics, "clearDepthStencilTexture"))
             return;
 
@@ -318,6 +483,9 @@ namespace nvrhi::validation
     {
         if (!requireOpenState())
             return;
+
+        if (!requirePrimary("copyTexture"))
+            return;
         
         m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
     }
@@ -327,6 +495,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("copyTexture"))
+            return;
+
         m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
     }
 
@@ -335,6 +506,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("copyTexture"))
+            return;
+
         m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
     }
 
@@ -343,6 +517,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("writeTexture"))
+            return;
+
         if (dest->getDesc().height > 1 && rowPitch == 0)
         {
             error("writeTexture: rowPitch is 0 but dest has multiple rows");
@@ -356,6 +533,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("resolveTexture"))
+            return;
+
         if (!requireType(CommandQueue::Graphics, "resolveTexture"))
             return;
 
@@ -427,6 +607,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("writeBuffer"))
+            return;
+
         if (dataSize + destOffsetBytes > b->getDesc().byteSize)
         {
             error("writeBuffer: dataSize + destOffsetBytes is greater than the buffer size");
@@ -445,9 +628,82 @@ namespace nvrhi::validation
             return;
         }
 
+        if (m_IsReusable && b->getDesc().isVolatile)
+            m_WrittenVolatileBuffers.insert(b);
+
         m_CommandList->writeBuffer(b, data, dataSize, destOffsetBytes);
     }
 
+    MappedWriteRegion CommandListWrapper::beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        if (!requireOpenState())
+            return MappedWriteRegion();
+
+        if (!requirePrimary("beginWriteTexture"))
+            return MappedWriteRegion();
+
+        const TextureDesc& desc = dest->getDesc();
+        if (mipLevel >= desc.mipLevels || arraySlice >= desc.arraySize)
+        {
+            std::stringstream ss;
+            ss << "beginWriteTexture: mip level " << mipLevel << " or array slice " << arraySlice
+                << " is out of bounds for texture " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return MappedWriteRegion();
+        }
+
+        MappedWriteRegion region = m_CommandList->beginWriteTexture(dest, arraySlice, mipLevel);
+        m_WriteInProgress = region.data != nullptr;
+        return region;
+    }
+
+    MappedWriteRegion CommandListWrapper::beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        if (!requireOpenState())
+            return MappedWriteRegion();
+
+        if (!requirePrimary("beginWriteBuffer"))
+            return MappedWriteRegion();
+
+        if (dataSize + destOffsetBytes > b->getDesc().byteSize)
+        {
+            error("beginWriteBuffer: dataSize + destOffsetBytes is greater than the buffer size");
+            return MappedWriteRegion();
+        }
+
+        if (destOffsetBytes > 0 && b->getDesc().isVolatile)
+        {
+            error("beginWriteBuffer: cannot write into volatile buffers with an offset");
+            return MappedWriteRegion();
+        }
+
+        if (dataSize > 0x10000 && b->getDesc().isVolatile)
+        {
+            error("beginWriteBuffer: cannot write more than 65535 bytes into volatile buffers");
+            return MappedWriteRegion();
+        }
+
+        MappedWriteRegion region = m_CommandList->beginWriteBuffer(b, dataSize, destOffsetBytes);
+        m_WriteInProgress = region.data != nullptr;
+
+        if (m_IsReusable && region.data && b->getDesc().isVolatile)
+            m_WrittenVolatileBuffers.insert(b);
+        return region;
+    }
+
+    void CommandListWrapper::commitWrite()
+    {
+        if (!m_WriteInProgress)
+        {
+            error("commitWrite: there is no write started with beginWriteTexture or beginWriteBuffer to commit");
+            return;
+        }
+
+        m_WriteInProgress = false;
+
+        m_CommandList->commitWrite();
+    }
+
     void CommandListWrapper::clearBufferUInt(IBuffer* b, uint32_t clearValue)
     {
         if (!requireOpenState())
@@ -464,21 +720,133 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("copyBuffer"))
+            return;
+
         m_CommandList->copyBuffer(dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
     }
 
+    bool CommandListWrapper::validateReadback(const char* operation)
+    {
+        if (!requireOpenState())
+            return false;
+
+        if (!requirePrimary(operation))
+            return false;
+
+        if (m_IsReusable)
+        {
+            std::stringstream ss;
+            ss << "The '" << operation << "' operation cannot be recorded into a reusable command list";
+            error(ss.str());
+            return false;
+        }
+
+        if (!m_Device->queryFeatureSupport(Feature::AsyncReadback))
+        {
+            std::stringstream ss;
+            ss << "The '" << operation << "' operation requires Feature::AsyncReadback";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    ReadbackTicketHandle CommandListWrapper::readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback)
+    {
+        if (!validateReadback("readbackBuffer"))
+            return nullptr;
+
+        if (!b)
+        {
+            error("readbackBuffer: buffer is NULL");
+            return nullptr;
+        }
+
+        if (sizeBytes == 0 || offsetBytes + sizeBytes > b->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << "readbackBuffer: the range [" << offsetBytes << ", " << offsetBytes + sizeBytes
+                << ") is empty or exceeds the size of buffer " << utils::DebugNameToString(b->getDesc().debugName)
+                << " (" << b->getDesc().byteSize << " bytes)";
+            error(ss.str());
+            return nullptr;
+        }
+
+        return m_CommandList->readbackBuffer(b, offsetBytes, sizeBytes, std::move(callback));
+    }
+
+    ReadbackTicketHandle CommandListWrapper::readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback)
+    {
+        if (!validateReadback("readbackTexture"))
+            return nullptr;
+
+        if (!texture)
+        {
+            error("readbackTexture: texture is NULL");
+            return nullptr;
+        }
+
+        const TextureDesc& desc = texture->getDesc();
+        if (slice.mipLevel >= desc.mipLevels || slice.arraySlice >= desc.arraySize)
+        {
+            std::stringstream ss;
+            ss << "readbackTexture: invalid mip level " << slice.mipLevel << " or array slice " << slice.arraySlice
+                << " for texture " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return nullptr;
+        }
+
+        if (desc.sampleCount > 1)
+        {
+            std::stringstream ss;
+            ss << "readbackTexture: texture " << utils::DebugNameToString(desc.debugName)
+                << " is multisampled, resolve it first";
+            error(ss.str());
+            return nullptr;
+        }
+
+        const TextureSlice resolvedSlice = slice.resolve(desc);
+        const uint32_t mipWidth = std::max(desc.width >> resolvedSlice.mipLevel, 1u);
+        const uint32_t mipHeight = std::max(desc.height >> resolvedSlice.mipLevel, 1u);
+        const uint32_t mipDepth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> resolvedSlice.mipLevel, 1u) : 1u;
+
+        if (resolvedSlice.x + resolvedSlice.width > mipWidth ||
+            resolvedSlice.y + resolvedSlice.height > mipHeight ||
+            resolvedSlice.z + resolvedSlice.depth > mipDepth)
+        {
+            std::stringstream ss;
+            ss << "readbackTexture: the region exceeds the size of mip level " << resolvedSlice.mipLevel
+                << " of texture " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return nullptr;
+        }
+
+        return m_CommandList->readbackTexture(texture, slice, std::move(callback));
+    }
+
     void CommandListWrapper::clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture)
     {
+        if (!requirePrimary("clearSamplerFeedbackTexture"))
+            return;
+
         m_CommandList->clearSamplerFeedbackTexture(texture);
     }
 
     void CommandListWrapper::decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format)
     {
+        if (!requirePrimary("decodeSamplerFeedbackTexture"))
+            return;
+
         m_CommandList->decodeSamplerFeedbackTexture(buffer, texture, format);
     }
 
     void CommandListWrapper::setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits)
     {
+        if (!requirePrimary("setSamplerFeedbackTextureState"))
+            return;
+
         m_CommandList->setSamplerFeedbackTextureState(texture, stateBits);
     }
 
@@ -499,6 +867,11 @@ namespace nvrhi::validation
         {
             if (sets[index] == nullptr)
             {
+                // Push descriptor layouts get their bindings through setPushBindings
+                const BindingLayoutDesc* expectedDesc = layouts[index] ? layouts[index]->getDesc() : nullptr;
+                if (expectedDesc && expectedDesc->usePushDescriptors)
+                    continue;
+
                 std::stringstream ss;
                 ss << "Binding set in slot " << index << " is NULL";
                 error(ss.str());
@@ -536,9 +909,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
-        if (!m_GraphicsStateSet && !m_ComputeStateSet && !m_MeshletStateSet && !m_RayTracingStateSet)
+        if (!m_GraphicsStateSet && !m_ComputeStateSet && !m_MeshletStateSet && !m_WorkGraphStateSet && !m_RayTracingStateSet)
         {
-            error("setPushConstants is only valid when a graphics, compute, meshlet, or ray tracing state is set");
+            error("setPushConstants is only valid when a graphics, compute, meshlet, work graph, or ray tracing state is set");
             return;
         }
 
@@ -568,14 +941,82 @@ namespace nvrhi::validation
         m_CommandList->setPushConstants(data, byteSize);
     }
 
-    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    void CommandListWrapper::setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Graphics, "setGraphicsState"))
+        if (!m_GraphicsStateSet && !m_ComputeStateSet && !m_MeshletStateSet && !m_WorkGraphStateSet && !m_RayTracingStateSet)
+        {
+            error("setPushBindings is only valid when a graphics, compute, meshlet, work graph, or ray tracing state is set");
+            return;
+        }
+
+        if (!m_Device->queryFeatureSupport(Feature::PushDescriptors))
+        {
+            error("Push descriptors are not supported by this device");
+            return;
+        }
+
+        const BindingLayoutVector* bindingLayouts = nullptr;
+        if (m_GraphicsStateSet && m_CurrentGraphicsState.pipeline)
+            bindingLayouts = &m_CurrentGraphicsState.pipeline->getDesc().bindingLayouts;
+        else if (m_ComputeStateSet && m_CurrentComputeState.pipeline)
+            bindingLayouts = &m_CurrentComputeState.pipeline->getDesc().bindingLayouts;
+        else if (m_MeshletStateSet && m_CurrentMeshletState.pipeline)
+            bindingLayouts = &m_CurrentMeshletState.pipeline->getDesc().bindingLayouts;
+        else if (m_WorkGraphStateSet && m_CurrentWorkGraphState.pipeline)
+            bindingLayouts = &m_CurrentWorkGraphState.pipeline->getDesc().bindingLayouts;
+        else if (m_RayTracingStateSet && m_CurrentRayTracingState.shaderTable)
+            bindingLayouts = &m_CurrentRayTracingState.shaderTable->getPipeline()->getDesc().globalBindingLayouts;
+
+        if (!bindingLayouts || layoutIndex >= bindingLayouts->size())
+        {
+            std::stringstream ss;
+            ss << "setPushBindings: layout index " << layoutIndex << " is out of range for the current pipeline";
+            error(ss.str());
+            return;
+        }
+
+        const BindingLayoutDesc* layoutDesc = (*bindingLayouts)[layoutIndex]->getDesc();
+        if (!layoutDesc || !layoutDesc->usePushDescriptors)
+        {
+            std::stringstream ss;
+            ss << "setPushBindings: binding layout " << layoutIndex << " of the current pipeline is not a push descriptor layout";
+            error(ss.str());
             return;
+        }
+
+        // Unwrap the resources
+        BindingSetDesc patchedBindings = bindings;
+        for (auto& binding : patchedBindings.bindings)
+        {
+            binding.resourceHandle = unwrapResource(binding.resourceHandle);
+        }
+
+        m_CommandList->setPushBindings(layoutIndex, patchedBindings);
+    }
+
+    BindingSetHandle CommandListWrapper::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        if (!requireOpenState())
+            return nullptr;
+
+        if (!m_Device->validateBindingSet(desc, layout, m_DeepValidation))
+            return nullptr;
+
+        // Unwrap the resources
+        BindingSetDesc patchedDesc = desc;
+        for (auto& binding : patchedDesc.bindings)
+        {
+            binding.resourceHandle = unwrapResource(binding.resourceHandle);
+        }
+
+        return m_CommandList->createTransientBindingSet(patchedDesc, layout);
+    }
 
+    bool CommandListWrapper::validateGraphicsState(const GraphicsState& state, bool deep) const
+    {
         bool anyErrors = false;
         std::stringstream ss;
         ss << "setGraphicsState: " << std::endl;
@@ -626,12 +1067,21 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (m_IsSecondary && state.framebuffer != m_SecondaryFramebuffer)
+        {
+            ss << "A secondary command list can only render into the framebuffer that was passed to openSecondary." << std::endl;
+            anyErrors = true;
+        }
+
         if (anyErrors)
         {
             error(ss.str());
-            return;
+            return false;
         }
 
+        if (!deep)
+            return true;
+
         if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
             anyErrors = true;
 
@@ -645,9 +1095,23 @@ namespace nvrhi::validation
         if (anyErrors)
         {
             error(ss.str());
-            return;
+            return false;
         }
 
+        return true;
+    }
+
+    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setGraphicsState"))
+            return;
+
+        if (!validateGraphicsState(state, m_DeepValidation))
+            return;
+
         evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
 
         m_CommandList->setGraphicsState(state);
@@ -655,11 +1119,159 @@ namespace nvrhi::validation
         m_GraphicsStateSet = true;
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
         m_RayTracingStateSet = false;
         m_PushConstantsSet = false;
         m_CurrentGraphicsState = state;
     }
 
+    void CommandListWrapper::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setGraphicsBindingSet"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("setGraphicsBindingSet: graphics state must be set before its binding sets can be replaced.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        const BindingLayoutVector& layouts = m_CurrentGraphicsState.pipeline->getDesc().bindingLayouts;
+
+        if (slot >= layouts.size())
+        {
+            std::stringstream ss;
+            ss << "setGraphicsBindingSet: slot " << slot << " is out of range, the current pipeline has "
+                << layouts.size() << " binding layouts";
+            error(ss.str());
+            return;
+        }
+
+        BindingSetVector bindings = m_CurrentGraphicsState.bindings;
+        bindings[slot] = bindingSet;
+
+        if (m_DeepValidation && !validateBindingSetsAgainstLayouts(layouts, bindings))
+            return;
+
+        m_CommandList->setGraphicsBindingSet(slot, bindingSet);
+
+        m_CurrentGraphicsState.bindings = bindings;
+    }
+
+    void CommandListWrapper::setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setVertexBuffers"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("setVertexBuffers: graphics state must be set before its vertex buffers can be replaced.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (numBindings != 0 && !pBindings)
+        {
+            error("setVertexBuffers: pBindings is NULL");
+            return;
+        }
+
+        bool anyErrors = false;
+        std::stringstream ss;
+        ss << "setVertexBuffers: " << std::endl;
+
+        for (size_t index = 0; index < numBindings; index++)
+        {
+            const VertexBufferBinding& vb = pBindings[index];
+
+            if (!vb.buffer)
+            {
+                ss << "Vertex buffer at index " << index << " is NULL." << std::endl;
+                anyErrors = true;
+            }
+            else if (!vb.buffer->getDesc().isVertexBuffer)
+            {
+                ss << "Buffer '" << utils::DebugNameToString(vb.buffer->getDesc().debugName) << "' bound to vertex buffer slot " << index << " cannot be used as a vertex buffer because it does not have the isVertexBuffer flag set." << std::endl;
+                anyErrors = true;
+            }
+
+            if (vb.slot >= c_MaxVertexAttributes)
+            {
+                ss << "Vertex buffer binding at index " << index << " uses an invalid slot " << vb.slot << "." << std::endl;
+                anyErrors = true;
+            }
+        }
+
+        if (anyErrors)
+        {
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->setVertexBuffers(pBindings, numBindings);
+
+        for (size_t index = 0; index < numBindings; index++)
+        {
+            const VertexBufferBinding& vb = pBindings[index];
+
+            bool found = false;
+            for (VertexBufferBinding& current : m_CurrentGraphicsState.vertexBuffers)
+            {
+                if (current.slot == vb.slot)
+                {
+                    current = vb;
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found)
+                m_CurrentGraphicsState.vertexBuffers.push_back(vb);
+        }
+    }
+
+    void CommandListWrapper::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setIndexBuffer"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("setIndexBuffer: graphics state must be set before its index buffer can be replaced.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!binding.buffer)
+        {
+            error("setIndexBuffer: buffer is NULL, use setGraphicsState to unbind the index buffer");
+            return;
+        }
+
+        if (!binding.buffer->getDesc().isIndexBuffer)
+        {
+            std::stringstream ss;
+            ss << "setIndexBuffer: Cannot use buffer '" << utils::DebugNameToString(binding.buffer->getDesc().debugName)
+                << "' as an index buffer because it does not have the isIndexBuffer flag set.";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->setIndexBuffer(binding);
+
+        m_CurrentGraphicsState.indexBuffer = binding;
+    }
+
     void CommandListWrapper::draw(const DrawArguments& args)
     {
         if (!requireOpenState())
@@ -678,6 +1290,9 @@ namespace nvrhi::validation
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
+        if (!validateVolatileBufferWrites(m_CurrentGraphicsState.bindings))
+            return;
+
         m_CommandList->draw(args);
     }
 
@@ -705,9 +1320,40 @@ namespace nvrhi::validation
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
+        if (!validateVolatileBufferWrites(m_CurrentGraphicsState.bindings))
+            return;
+
         m_CommandList->drawIndexed(args);
     }
 
+    void CommandListWrapper::drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateDrawBatch("drawBatch", false, args, count, pushConstants, pushConstantByteSize, pushConstantStride))
+            return;
+
+        if (pushConstants && count != 0)
+            m_PushConstantsSet = true;
+
+        m_CommandList->drawBatch(args, count, pushConstants, pushConstantByteSize, pushConstantStride);
+    }
+
+    void CommandListWrapper::drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateDrawBatch("drawIndexedBatch", true, args, count, pushConstants, pushConstantByteSize, pushConstantStride))
+            return;
+
+        if (pushConstants && count != 0)
+            m_PushConstantsSet = true;
+
+        m_CommandList->drawIndexedBatch(args, count, pushConstants, pushConstantByteSize, pushConstantStride);
+    }
+
     void CommandListWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
         if (!requireOpenState())
@@ -732,6 +1378,9 @@ namespace nvrhi::validation
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
+        if (!validateVolatileBufferWrites(m_CurrentGraphicsState.bindings))
+            return;
+
         m_CommandList->drawIndirect(offsetBytes, drawCount);
     }
 
@@ -759,6 +1408,9 @@ namespace nvrhi::validation
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
+        if (!validateVolatileBufferWrites(m_CurrentGraphicsState.bindings))
+            return;
+
         m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
     }
 
@@ -792,17 +1444,99 @@ namespace nvrhi::validation
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
+        if (!validateVolatileBufferWrites(m_CurrentGraphicsState.bindings))
+            return;
+
         m_CommandList->drawIndexedIndirectCount(offsetBytes, countBuffer, countBufferOffset, maxDrawCount);
     }
 
-    void CommandListWrapper::setComputeState(const ComputeState& state)
+    void CommandListWrapper::executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Compute, "setComputeState"))
+        if (!requireType(CommandQueue::Graphics, "executeIndirect"))
+            return;
+
+        if (!requirePrimary("executeIndirect"))
+            return;
+
+        if (!signature)
+        {
+            error("executeIndirect: signature is NULL");
+            return;
+        }
+
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before an executeIndirect call.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before an executeIndirect call.");
+            return;
+        }
+
+        const CommandSignatureDesc& signatureDesc = signature->getDesc();
+
+        bool setsIndexBuffer = false;
+        bool setsPushConstants = false;
+        bool indexedDraw = false;
+        for (const auto& arg : signatureDesc.arguments)
+        {
+            setsIndexBuffer = setsIndexBuffer || arg.type == IndirectArgumentType::IndexBuffer;
+            setsPushConstants = setsPushConstants || arg.type == IndirectArgumentType::PushConstants;
+            indexedDraw = indexedDraw || arg.type == IndirectArgumentType::DrawIndexed;
+        }
+
+        if (indexedDraw && !setsIndexBuffer && m_CurrentGraphicsState.indexBuffer.buffer == nullptr)
+        {
+            std::stringstream ss;
+            ss << "executeIndirect: signature '" << utils::DebugNameToString(signatureDesc.debugName)
+                << "' issues indexed draws without an IndexBuffer argument, and no index buffer is set";
+            error(ss.str());
+            return;
+        }
+
+        if (!setsPushConstants && !validatePushConstants("graphics", "setGraphicsState"))
             return;
 
+        if (!validateVolatileBufferWrites(m_CurrentGraphicsState.bindings))
+            return;
+
+        if (countBufferOffset % 4 != 0 || offsetBytes % 4 != 0)
+        {
+            error("executeIndirect: offsetBytes and countBufferOffset must be multiples of 4");
+            return;
+        }
+
+        m_CommandList->executeIndirect(signature, offsetBytes, maxCommandCount, countBuffer, countBufferOffset);
+
+        // The state changed by the generated commands is undefined after their execution
+        static_vector<VertexBufferBinding, c_MaxVertexAttributes> remainingVertexBuffers;
+        for (const auto& vb : m_CurrentGraphicsState.vertexBuffers)
+        {
+            bool overwritten = false;
+            for (const auto& arg : signatureDesc.arguments)
+                overwritten = overwritten || (arg.type == IndirectArgumentType::VertexBuffer && arg.slot == vb.slot);
+
+            if (!overwritten)
+                remainingVertexBuffers.push_back(vb);
+        }
+        m_CurrentGraphicsState.vertexBuffers = remainingVertexBuffers;
+
+        if (setsIndexBuffer)
+            m_CurrentGraphicsState.indexBuffer = IndexBufferBinding();
+
+        if (setsPushConstants)
+            m_PushConstantsSet = false;
+    }
+
+    bool CommandListWrapper::validateComputeState(const ComputeState& state, bool deep) const
+    {
         bool anyErrors = false;
         std::stringstream ss;
         ss << "setComputeState: " << std::endl;
@@ -822,16 +1556,21 @@ namespace nvrhi::validation
         if (anyErrors)
         {
             error(ss.str());
-            return;
+            return false;
         }
 
-        if (anyErrors)
+        return !deep || validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings);
+    }
+
+    void CommandListWrapper::setComputeState(const ComputeState& state)
+    {
+        if (!requireOpenState())
             return;
 
-        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
-            anyErrors = true;
+        if (!requireType(CommandQueue::Compute, "setComputeState"))
+            return;
 
-        if (anyErrors)
+        if (!validateComputeState(state, m_DeepValidation))
             return;
 
         evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
@@ -841,6 +1580,7 @@ namespace nvrhi::validation
         m_GraphicsStateSet = false;
         m_ComputeStateSet = true;
         m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
         m_RayTracingStateSet = false;
         m_PushConstantsSet = false;
         m_CurrentComputeState = state;
@@ -864,6 +1604,9 @@ namespace nvrhi::validation
         if (!validatePushConstants("compute", "setComputeState"))
             return;
 
+        if (!validateVolatileBufferWrites(m_CurrentComputeState.bindings))
+            return;
+
         m_CommandList->dispatch(groupsX, groupsY, groupsZ);
     }
 
@@ -891,6 +1634,9 @@ namespace nvrhi::validation
         if (!validatePushConstants("compute", "setComputeState"))
             return;
 
+        if (!validateVolatileBufferWrites(m_CurrentComputeState.bindings))
+            return;
+
         m_CommandList->dispatchIndirect(offsetBytes);
     }
 
@@ -899,6 +1645,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("setMeshletState"))
+            return;
+
         if (!requireType(CommandQueue::Graphics, "setMeshletState"))
             return;
 
@@ -909,46 +1658,255 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (state.indirectParams && !state.indirectParams->getDesc().isDrawIndirectArgs)
+        {
+            error(std::string("Cannot use buffer '") + utils::DebugNameToString(state.indirectParams->getDesc().debugName) + "' as a DispatchMeshIndirect "
+                "argument buffer because it does not have the isDrawIndirectArgs flag set.");
+            anyErrors = true;
+        }
+
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            error(std::string("Cannot use buffer '") + utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) + "' as a DispatchMeshIndirect "
+                "count buffer because it does not have the isDrawIndirectArgs flag set.");
+            anyErrors = true;
+        }
+
         if (anyErrors)
             return;
 
-        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
+        if (m_DeepValidation && !validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
+            return;
+
+        evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
+
+        m_CommandList->setMeshletState(state);
+
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = false;
+        m_MeshletStateSet = true;
+        m_WorkGraphStateSet = false;
+        m_RayTracingStateSet = false;
+        m_PushConstantsSet = false;
+        m_CurrentMeshletState = state;
+    }
+
+    void CommandListWrapper::dispatchMesh(uint32_t groupsX, uint32_t groupsY /*= 1*/, uint32_t groupsZ /*= 1*/)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "dispatchMesh"))
+            return;
+
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMesh call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
+            return;
+        }
+
+        if (!validatePushConstants("meshlet", "setMeshletState"))
+            return;
+
+        if (!validateVolatileBufferWrites(m_CurrentMeshletState.bindings))
+            return;
+
+        m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
+    }
+
+    bool CommandListWrapper::validateDispatchMeshIndirect(const char* operation, uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        if (!requireOpenState())
+            return false;
+
+        if (!requireType(CommandQueue::Graphics, operation))
+            return false;
+
+        if (!m_Device->queryFeatureSupport(Feature::MeshletIndirect))
+        {
+            error(std::string(operation) + " is not supported by this device, see Feature::MeshletIndirect");
+            return false;
+        }
+
+        if (!m_MeshletStateSet)
+        {
+            error(std::string("Meshlet state is not set before a ") + operation + " call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
+            return false;
+        }
+
+        IBuffer* indirectParams = m_CurrentMeshletState.indirectParams;
+        if (!indirectParams)
+        {
+            error(std::string("Indirect params buffer is not set before a ") + operation + " call.");
+            return false;
+        }
+
+        if ((offsetBytes & 3) != 0)
+        {
+            error(std::string(operation) + ": offsetBytes (" + std::to_string(offsetBytes) + ") must be a multiple of 4");
+            return false;
+        }
+
+        const uint64_t argumentsEnd = uint64_t(offsetBytes) + uint64_t(dispatchCount) * sizeof(DispatchIndirectArguments);
+        if (argumentsEnd > indirectParams->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << operation << ": the arguments of " << dispatchCount << " dispatches at offset " << offsetBytes
+                << " do not fit into buffer '" << utils::DebugNameToString(indirectParams->getDesc().debugName)
+                << "' (" << indirectParams->getDesc().byteSize << " bytes)";
+            error(ss.str());
+            return false;
+        }
+
+        if (!validatePushConstants("meshlet", "setMeshletState"))
+            return false;
+
+        return true;
+    }
+
+    void CommandListWrapper::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        if (!validateDispatchMeshIndirect("dispatchMeshIndirect", offsetBytes, dispatchCount))
+            return;
+
+        m_CommandList->dispatchMeshIndirect(offsetBytes, dispatchCount);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount)
+    {
+        if (!validateDispatchMeshIndirect("dispatchMeshIndirectCount", offsetBytes, maxDispatchCount))
+            return;
+
+        IBuffer* countBuffer = m_CurrentMeshletState.indirectCountBuffer;
+        if (!countBuffer)
+        {
+            error("Count buffer is not set before a dispatchMeshIndirectCount call.");
+            return;
+        }
+
+        if ((countBufferOffset & 3) != 0 || uint64_t(countBufferOffset) + sizeof(uint32_t) > countBuffer->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << "dispatchMeshIndirectCount: countBufferOffset (" << countBufferOffset << ") must be a multiple of 4 "
+                "and leave room for the count in buffer '" << utils::DebugNameToString(countBuffer->getDesc().debugName)
+                << "' (" << countBuffer->getDesc().byteSize << " bytes)";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->dispatchMeshIndirectCount(offsetBytes, countBufferOffset, maxDispatchCount);
+    }
+
+    void CommandListWrapper::setWorkGraphState(const WorkGraphState& state)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requirePrimary("setWorkGraphState"))
+            return;
+
+        if (!requireType(CommandQueue::Compute, "setWorkGraphState"))
+            return;
+
+        bool anyErrors = false;
+        if (!state.pipeline)
+        {
+            error("WorkGraphState::pipeline is NULL");
+            anyErrors = true;
+        }
+
+        if (!state.backingMemory)
+        {
+            error("WorkGraphState::backingMemory is NULL");
+            anyErrors = true;
+        }
+        else if (!state.backingMemory->getDesc().canHaveUAVs)
+        {
+            std::stringstream ss;
+            ss << "The work graph backing memory buffer " << utils::DebugNameToString(state.backingMemory->getDesc().debugName)
+               << " must be created with canHaveUAVs = true";
+            error(ss.str());
             anyErrors = true;
+        }
+        else if (state.pipeline)
+        {
+            const uint64_t minSize = state.pipeline->getMemoryRequirements().minSize;
+            if (state.backingMemory->getDesc().byteSize < minSize)
+            {
+                std::stringstream ss;
+                ss << "The work graph backing memory buffer " << utils::DebugNameToString(state.backingMemory->getDesc().debugName)
+                   << " is " << state.backingMemory->getDesc().byteSize << " bytes, smaller than the " << minSize
+                   << " bytes required by the pipeline " << utils::DebugNameToString(state.pipeline->getDesc().debugName);
+                error(ss.str());
+                anyErrors = true;
+            }
+        }
 
         if (anyErrors)
             return;
 
+        if (m_DeepValidation && !validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
+            return;
+
         evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
 
-        m_CommandList->setMeshletState(state);
+        m_CommandList->setWorkGraphState(state);
 
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
-        m_MeshletStateSet = true;
+        m_MeshletStateSet = false;
+        m_WorkGraphStateSet = true;
         m_RayTracingStateSet = false;
         m_PushConstantsSet = false;
-        m_CurrentMeshletState = state;
+        m_CurrentWorkGraphState = state;
     }
 
-    void CommandListWrapper::dispatchMesh(uint32_t groupsX, uint32_t groupsY /*= 1*/, uint32_t groupsZ /*= 1*/)
+    void CommandListWrapper::dispatchGraph(const WorkGraphDispatchArguments& args)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Graphics, "dispatchMesh"))
+        if (!requireType(CommandQueue::Compute, "dispatchGraph"))
             return;
 
-        if (!m_MeshletStateSet)
+        if (!m_WorkGraphStateSet)
         {
-            error("Meshlet state is not set before a dispatchMesh call.\n"
-                "Note that setting graphics or compute state invalidates the meshlet state.");
+            error("Work graph state is not set before a dispatchGraph call.\n"
+                "Note that setting graphics or compute state invalidates the work graph state.");
             return;
         }
 
-        if (!validatePushConstants("meshlet", "setMeshletState"))
+        const WorkGraphPipelineDesc& pipelineDesc = m_CurrentWorkGraphState.pipeline->getDesc();
+        if (args.entryNode >= pipelineDesc.nodes.size() || pipelineDesc.nodes[args.entryNode].producerNode >= 0)
+        {
+            std::stringstream ss;
+            ss << "dispatchGraph: node " << args.entryNode << " is not an entry node of the work graph "
+               << utils::DebugNameToString(pipelineDesc.debugName);
+            error(ss.str());
+            return;
+        }
+
+        if (args.numRecords == 0)
+        {
+            error("dispatchGraph: numRecords must be at least 1, also for entry nodes without input records");
             return;
+        }
 
-        m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
+        if (args.records && args.recordStride == 0)
+        {
+            error("dispatchGraph: records are provided with a zero recordStride");
+            return;
+        }
+
+        if (!validatePushConstants("work graph", "setWorkGraphState"))
+            return;
+
+        if (!validateVolatileBufferWrites(m_CurrentWorkGraphState.bindings))
+            return;
+
+        m_CommandList->dispatchGraph(args);
     }
 
     void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
@@ -956,6 +1914,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("beginTimerQuery"))
+            return;
+
         m_CommandList->beginTimerQuery(query);
     }
 
@@ -964,6 +1925,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("endTimerQuery"))
+            return;
+
         m_CommandList->endTimerQuery(query);
     }
 
@@ -987,6 +1951,9 @@ namespace nvrhi::validation
     {
         if (!requireOpenState())
             return;
+
+        if (!requirePrimary("setEnableAutomaticBarriers"))
+            return;
         
         m_CommandList->setEnableAutomaticBarriers(enable);
     }
@@ -996,6 +1963,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("setResourceStatesForBindingSet"))
+            return;
+
         m_CommandList->setResourceStatesForBindingSet(bindingSet);
     }
 
@@ -1026,6 +1996,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("beginTrackingTextureState"))
+            return;
+
         m_CommandList->beginTrackingTextureState(texture, subresources, stateBits);
     }
 
@@ -1034,6 +2007,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("beginTrackingBufferState"))
+            return;
+
         m_CommandList->beginTrackingBufferState(buffer, stateBits);
     }
 
@@ -1042,6 +2018,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("setTextureState"))
+            return;
+
         m_CommandList->setTextureState(texture, subresources, stateBits);
     }
 
@@ -1050,6 +2029,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("setBufferState"))
+            return;
+
         m_CommandList->setBufferState(buffer, stateBits);
     }
 
@@ -1058,6 +2040,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("setAccelStructState"))
+            return;
+
         m_CommandList->setAccelStructState(checked_cast<rt::IAccelStruct*>(unwrapResource(as)), stateBits);
     }
 
@@ -1066,6 +2051,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("setPermanentTextureState"))
+            return;
+
         m_CommandList->setPermanentTextureState(texture, stateBits);
     }
 
@@ -1074,14 +2062,65 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("setPermanentBufferState"))
+            return;
+
         m_CommandList->setPermanentBufferState(buffer, stateBits);
     }
 
+    void CommandListWrapper::beginTextureStateTransition(ITexture* texture, ResourceStates nextState)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requirePrimary("beginTextureStateTransition"))
+            return;
+
+        if (!texture)
+        {
+            error("beginTextureStateTransition: texture is NULL");
+            return;
+        }
+
+        m_CommandList->beginTextureStateTransition(texture, nextState);
+    }
+
+    void CommandListWrapper::beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requirePrimary("beginBufferStateTransition"))
+            return;
+
+        if (!buffer)
+        {
+            error("beginBufferStateTransition: buffer is NULL");
+            return;
+        }
+
+        m_CommandList->beginBufferStateTransition(buffer, nextState);
+    }
+
+    void CommandListWrapper::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requirePrimary("aliasingBarrier"))
+            return;
+
+        m_CommandList->aliasingBarrier(resourceBefore, resourceAfter);
+    }
+
     void CommandListWrapper::commitBarriers()
     {
         if (!requireOpenState())
             return;
 
+        if (!requirePrimary("commitBarriers"))
+            return;
+
         m_CommandList->commitBarriers();
     }
 
@@ -1109,6 +2148,7 @@ namespace nvrhi::validation
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
         m_RayTracingStateSet = false;
         m_PushConstantsSet = false;
 
@@ -1125,6 +2165,11 @@ namespace nvrhi::validation
         return m_CommandList->getDesc();
     }
 
+    CommandListStats CommandListWrapper::getStats()
+    {
+        return m_CommandList->getStats();
+    }
+
     void CommandListWrapper::setRayTracingState(const rt::State& state)
     {
         if (!requireOpenState())
@@ -1140,6 +2185,7 @@ namespace nvrhi::validation
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
         m_MeshletStateSet = true;
+        m_WorkGraphStateSet = false;
         m_RayTracingStateSet = true;
         m_PushConstantsSet = false;
         m_CurrentRayTracingState = state;
@@ -1188,388 +2234,530 @@ namespace nvrhi::validation
         m_CommandList->buildOpacityMicromap(omm, desc);
     }
 
-    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandListWrapper::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStruct"))
+        if (!requireType(CommandQueue::Compute, "buildOpacityMicromaps"))
             return;
 
-        rt::IAccelStruct* underlyingAS = as;
+        if (numBuilds > 0 && !pBuilds)
+        {
+            error("buildOpacityMicromaps: 'pBuilds' is NULL");
+            return;
+        }
 
-        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
-        if (wrapper)
+        std::unordered_set<rt::IOpacityMicromap*> opacityMicromapsInBatch;
+
+        for (size_t i = 0; i < numBuilds; i++)
         {
-            underlyingAS = wrapper->getUnderlyingObject();
+            const rt::OpacityMicromapBuildDesc& build = pBuilds[i];
 
-            if (wrapper->isTopLevel)
+            if (!build.opacityMicromap)
             {
-                error("Cannot perform buildBottomLevelAccelStruct on a top-level AS");
+                std::stringstream ss;
+                ss << "buildOpacityMicromaps: pBuilds[" << i << "].opacityMicromap is NULL";
+                error(ss.str());
                 return;
             }
-            
-            for (size_t i = 0; i < numGeometries; i++)
+
+            if (!build.desc)
             {
-                const auto& geom = pGeometries[i];
+                std::stringstream ss;
+                ss << "buildOpacityMicromaps: pBuilds[" << i << "].desc is NULL";
+                error(ss.str());
+                return;
+            }
 
-                if (geom.geometryType == rt::GeometryType::Triangles)
-                {
-                    const auto& triangles = geom.geometryData.triangles;
+            if (!build.desc->inputBuffer || !build.desc->perOmmDescs)
+            {
+                std::stringstream ss;
+                ss << "buildOpacityMicromaps: pBuilds[" << i << "].desc must have non-NULL inputBuffer and perOmmDescs";
+                error(ss.str());
+                return;
+            }
 
-                    if (triangles.indexFormat != Format::UNKNOWN)
-                    {
-                        switch (triangles.indexFormat)  // NOLINT(clang-diagnostic-switch-enum)
-                        {
-                        case Format::R8_UINT:
-                            if (m_Device->getGraphicsAPI() != GraphicsAPI::VULKAN)
-                            {
-                                std::stringstream ss;
-                                ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                    << " has index format R8_UINT which is only supported on Vulkan";
-                                error(ss.str());
-                                return;
-                            }
-                            break;
-                        case Format::R16_UINT:
-                        case Format::R32_UINT:
-                            break;
-                        default: {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has unsupported index format: " << utils::FormatToString(triangles.indexFormat);
-                            error(ss.str());
-                            return;
-                        }
-                        }
+            if (!opacityMicromapsInBatch.insert(build.opacityMicromap).second)
+            {
+                std::stringstream ss;
+                ss << "buildOpacityMicromaps: OMM " << utils::DebugNameToString(build.opacityMicromap->getDesc().debugName)
+                    << " is built more than once in the same batch (pBuilds[" << i << "])";
+                error(ss.str());
+                return;
+            }
+        }
 
-                        if (triangles.indexBuffer == nullptr)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has a NULL index buffer but indexFormat is " << utils::FormatToString(triangles.indexFormat);
-                            error(ss.str());
-                            return;
-                        }
+        m_CommandList->buildOpacityMicromaps(pBuilds, numBuilds);
+    }
 
-                        const BufferDesc& indexBufferDesc = triangles.indexBuffer->getDesc();
-                        if (!indexBufferDesc.isAccelStructBuildInput)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has index buffer = " << utils::DebugNameToString(indexBufferDesc.debugName)
-                                << " which does not have the isAccelStructBuildInput flag set";
-                            error(ss.str());
-                            return;
-                        }
+    void CommandListWrapper::compactOpacityMicromaps()
+    {
+        if (!requireOpenState())
+            return;
 
-                        const size_t indexSize = triangles.indexCount * getFormatInfo(triangles.indexFormat).bytesPerBlock;
-                        if (triangles.indexOffset + indexSize > indexBufferDesc.byteSize)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " points at " << indexSize << " bytes of index data at offset " << triangles.indexOffset
-                                << " in buffer " << utils::DebugNameToString(indexBufferDesc.debugName) << " whose size is " << indexBufferDesc.byteSize
-                                << ", which will result in a buffer overrun";
-                            error(ss.str());
-                            return;
-                        }
+        if (!requireType(CommandQueue::Compute, "compactOpacityMicromaps"))
+            return;
 
-                        if ((triangles.indexCount % 3) != 0)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexCount = " << triangles.indexCount
-                                << ", which is not a multiple of 3";
-                            error(ss.str());
-                            return;
-                        }
-                    }
-                    else
-                    {
-                        if (triangles.indexCount != 0 || triangles.indexBuffer != nullptr)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexFormat = UNKNOWN but nonzero indexCount = " << triangles.indexCount;
-                            error(ss.str());
-                            return;
-                        }
+        m_CommandList->compactOpacityMicromaps();
+    }
+
+    bool CommandListWrapper::validateBuildBottomLevelAccelStruct(AccelStructWrapper* wrapper, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) const
+    {
+        if (wrapper->isTopLevel)
+        {
+            error("Cannot perform buildBottomLevelAccelStruct on a top-level AS");
+            return false;
+        }
+        
+        for (size_t i = 0; i < numGeometries; i++)
+        {
+            const auto& geom = pGeometries[i];
+
+            if (geom.geometryType == rt::GeometryType::Triangles)
+            {
+                const auto& triangles = geom.geometryData.triangles;
 
-                        if (triangles.indexBuffer != nullptr)
+                if (triangles.indexFormat != Format::UNKNOWN)
+                {
+                    switch (triangles.indexFormat)  // NOLINT(clang-diagnostic-switch-enum)
+                    {
+                    case Format::R8_UINT:
+                        if (m_Device->getGraphicsAPI() != GraphicsAPI::VULKAN)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexFormat = UNKNOWN but non-NULL indexBuffer = "
-                                << utils::DebugNameToString(triangles.indexBuffer->getDesc().debugName);
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                                << " has index format R8_UINT which is only supported on Vulkan";
                             error(ss.str());
-                            return;
+                            return false;
                         }
-                    }
-
-                    switch (triangles.vertexFormat)  // NOLINT(clang-diagnostic-switch-enum)
-                    {
-                    case Format::RG32_FLOAT:
-                    case Format::RGB32_FLOAT:
-                    case Format::RGBA32_FLOAT:
-                    case Format::RG16_FLOAT:
-                    case Format::RGBA16_FLOAT:
-                    case Format::RG16_SNORM:
-                    case Format::RGBA16_SNORM:
-                    case Format::RGBA16_UNORM:
-                    case Format::RG16_UNORM:
-                    case Format::R10G10B10A2_UNORM:
-                    case Format::RGBA8_UNORM:
-                    case Format::RG8_UNORM:
-                    case Format::RGBA8_SNORM:
-                    case Format::RG8_SNORM:
+                        break;
+                    case Format::R16_UINT:
+                    case Format::R32_UINT:
                         break;
                     default: {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has unsupported vertex format: " << utils::FormatToString(triangles.vertexFormat);
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has unsupported index format: " << utils::FormatToString(triangles.indexFormat);
                         error(ss.str());
-                        return;
+                        return false;
                     }
                     }
 
-                    if (triangles.vertexBuffer == nullptr)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL vertex buffer";
-                        error(ss.str());
-                        return;
-                    }
-
-                    if (triangles.vertexStride == 0)
+                    if (triangles.indexBuffer == nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has vertexStride = 0";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has a NULL index buffer but indexFormat is " << utils::FormatToString(triangles.indexFormat);
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    if ((triangles.indexFormat == Format::UNKNOWN) && (triangles.vertexCount % 3) != 0)
+                    const BufferDesc& indexBufferDesc = triangles.indexBuffer->getDesc();
+                    if (!indexBufferDesc.isAccelStructBuildInput)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has indexFormat = UNKNOWN and vertexCount = " << triangles.vertexCount
-                            << ", which is not a multiple of 3";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has index buffer = " << utils::DebugNameToString(indexBufferDesc.debugName)
+                            << " which does not have the isAccelStructBuildInput flag set";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const BufferDesc& vertexBufferDesc = triangles.vertexBuffer->getDesc();
-                    if (!vertexBufferDesc.isAccelStructBuildInput)
+                    const size_t indexSize = triangles.indexCount * getFormatInfo(triangles.indexFormat).bytesPerBlock;
+                    if (triangles.indexOffset + indexSize > indexBufferDesc.byteSize)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has vertex buffer = " << utils::DebugNameToString(vertexBufferDesc.debugName)
-                            << " which does not have the isAccelStructBuildInput flag set";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " points at " << indexSize << " bytes of index data at offset " << triangles.indexOffset
+                            << " in buffer " << utils::DebugNameToString(indexBufferDesc.debugName) << " whose size is " << indexBufferDesc.byteSize
+                            << ", which will result in a buffer overrun";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const size_t vertexDataSize = triangles.vertexCount * triangles.vertexStride;
-                    if (triangles.vertexOffset + vertexDataSize > vertexBufferDesc.byteSize)
+                    if ((triangles.indexCount % 3) != 0)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " points at " << vertexDataSize << " bytes of vertex data at offset " << triangles.vertexOffset
-                            << " in buffer " << utils::DebugNameToString(vertexBufferDesc.debugName) << " whose size is " << vertexBufferDesc.byteSize
-                            << ", which will result in a buffer overrun";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexCount = " << triangles.indexCount
+                            << ", which is not a multiple of 3";
                         error(ss.str());
-                        return;
+                        return false;
                     }
                 }
-                else if (geom.geometryType == rt::GeometryType::AABBs)
+                else
                 {
-                    const auto& aabbs = geom.geometryData.aabbs;
-
-                    if (aabbs.buffer== nullptr)
+                    if (triangles.indexCount != 0 || triangles.indexBuffer != nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL AABB data buffer";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexFormat = UNKNOWN but nonzero indexCount = " << triangles.indexCount;
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const BufferDesc& aabbBufferDesc = aabbs.buffer->getDesc();
-                    if (!aabbBufferDesc.isAccelStructBuildInput)
+                    if (triangles.indexBuffer != nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has AABB data buffer = " << utils::DebugNameToString(aabbBufferDesc.debugName)
-                            << " which does not have the isAccelStructBuildInput flag set";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexFormat = UNKNOWN but non-NULL indexBuffer = "
+                            << utils::DebugNameToString(triangles.indexBuffer->getDesc().debugName);
                         error(ss.str());
-                        return;
+                        return false;
                     }
+                }
 
-                    if (aabbs.count > 1 && aabbs.stride < sizeof(rt::GeometryAABB))
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has AABB stride = " << aabbs.stride
-                            << " which is less than the size of one AABB (" << sizeof(rt::GeometryAABB) << " bytes)";
-                        error(ss.str());
-                        return;
-                    }
+                switch (triangles.vertexFormat)  // NOLINT(clang-diagnostic-switch-enum)
+                {
+                case Format::RG32_FLOAT:
+                case Format::RGB32_FLOAT:
+                case Format::RGBA32_FLOAT:
+                case Format::RG16_FLOAT:
+                case Format::RGBA16_FLOAT:
+                case Format::RG16_SNORM:
+                case Format::RGBA16_SNORM:
+                case Format::RGBA16_UNORM:
+                case Format::RG16_UNORM:
+                case Format::R10G10B10A2_UNORM:
+                case Format::RGBA8_UNORM:
+                case Format::RG8_UNORM:
+                case Format::RGBA8_SNORM:
+                case Format::RG8_SNORM:
+                    break;
+                default: {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has unsupported vertex format: " << utils::FormatToString(triangles.vertexFormat);
+                    error(ss.str());
+                    return false;
+                }
+                }
 
-                    const size_t aabbDataSize = aabbs.count * aabbs.stride;
-                    if (aabbs.offset + aabbDataSize > aabbBufferDesc.byteSize)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " points at " << aabbDataSize << " bytes of AABB data at offset " << aabbs.offset
-                            << " in buffer " << utils::DebugNameToString(aabbBufferDesc.debugName) << " whose size is " << aabbBufferDesc.byteSize
-                            << ", which will result in a buffer overrun";
-                        error(ss.str());
-                        return;
-                    }
+                if (triangles.vertexBuffer == nullptr)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL vertex buffer";
+                    error(ss.str());
+                    return false;
+                }
 
-                    if (geom.useTransform)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " is of type AABB but has useTransform = true, "
-                            "which is unsupported, and the transform will be ignored";
-                        m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
-                    }
+                if (triangles.vertexStride == 0)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has vertexStride = 0";
+                    error(ss.str());
+                    return false;
                 }
-                else if (geom.geometryType == rt::GeometryType::Spheres)
+
+                if ((triangles.indexFormat == Format::UNKNOWN) && (triangles.vertexCount % 3) != 0)
                 {
-                    const auto& spheres = geom.geometryData.spheres;
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has indexFormat = UNKNOWN and vertexCount = " << triangles.vertexCount
+                        << ", which is not a multiple of 3";
+                    error(ss.str());
+                    return false;
+                }
 
-                    if (spheres.vertexBuffer == nullptr)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL vertex buffer";
-                        error(ss.str());
-                        return;
-                    }
+                const BufferDesc& vertexBufferDesc = triangles.vertexBuffer->getDesc();
+                if (!vertexBufferDesc.isAccelStructBuildInput)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has vertex buffer = " << utils::DebugNameToString(vertexBufferDesc.debugName)
+                        << " which does not have the isAccelStructBuildInput flag set";
+                    error(ss.str());
+                    return false;
+                }
 
-                    // TODO: Add more validation
+                const size_t vertexDataSize = triangles.vertexCount * triangles.vertexStride;
+                if (triangles.vertexOffset + vertexDataSize > vertexBufferDesc.byteSize)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " points at " << vertexDataSize << " bytes of vertex data at offset " << triangles.vertexOffset
+                        << " in buffer " << utils::DebugNameToString(vertexBufferDesc.debugName) << " whose size is " << vertexBufferDesc.byteSize
+                        << ", which will result in a buffer overrun";
+                    error(ss.str());
+                    return false;
                 }
-                else if (geom.geometryType == rt::GeometryType::Lss)
+            }
+            else if (geom.geometryType == rt::GeometryType::AABBs)
+            {
+                const auto& aabbs = geom.geometryData.aabbs;
+
+                if (aabbs.buffer== nullptr)
                 {
-                    const auto& lss = geom.geometryData.lss;
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL AABB data buffer";
+                    error(ss.str());
+                    return false;
+                }
 
-                    if (lss.vertexBuffer == nullptr)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL vertex buffer";
-                        error(ss.str());
-                        return;
-                    }
+                const BufferDesc& aabbBufferDesc = aabbs.buffer->getDesc();
+                if (!aabbBufferDesc.isAccelStructBuildInput)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has AABB data buffer = " << utils::DebugNameToString(aabbBufferDesc.debugName)
+                        << " which does not have the isAccelStructBuildInput flag set";
+                    error(ss.str());
+                    return false;
+                }
+
+                if (aabbs.count > 1 && aabbs.stride < sizeof(rt::GeometryAABB))
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has AABB stride = " << aabbs.stride
+                        << " which is less than the size of one AABB (" << sizeof(rt::GeometryAABB) << " bytes)";
+                    error(ss.str());
+                    return false;
+                }
+
+                const size_t aabbDataSize = aabbs.count * aabbs.stride;
+                if (aabbs.offset + aabbDataSize > aabbBufferDesc.byteSize)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " points at " << aabbDataSize << " bytes of AABB data at offset " << aabbs.offset
+                        << " in buffer " << utils::DebugNameToString(aabbBufferDesc.debugName) << " whose size is " << aabbBufferDesc.byteSize
+                        << ", which will result in a buffer overrun";
+                    error(ss.str());
+                    return false;
+                }
 
-                    // TODO: Add more validation
+                if (geom.useTransform)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " is of type AABB but has useTransform = true, "
+                        "which is unsupported, and the transform will be ignored";
+                    m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
                 }
             }
-
-            if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+            else if (geom.geometryType == rt::GeometryType::Spheres)
             {
-                if (!wrapper->allowUpdate)
+                const auto& spheres = geom.geometryData.spheres;
+
+                if (spheres.vertexBuffer == nullptr)
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " that was not created with the AllowUpdate flag";
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL vertex buffer";
                     error(ss.str());
-                    return;
+                    return false;
                 }
 
-                if (!wrapper->wasBuilt)
+                // TODO: Add more validation
+            }
+            else if (geom.geometryType == rt::GeometryType::Lss)
+            {
+                const auto& lss = geom.geometryData.lss;
+
+                if (lss.vertexBuffer == nullptr)
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " before the same BLAS was initially built";
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL vertex buffer";
                     error(ss.str());
-                    return;
+                    return false;
                 }
 
-                if (numGeometries != wrapper->buildGeometries.size())
+                // TODO: Add more validation
+            }
+        }
+
+        if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+        {
+            if (!wrapper->allowUpdate)
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " that was not created with the AllowUpdate flag";
+                error(ss.str());
+                return false;
+            }
+
+            if (!wrapper->wasBuilt)
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " before the same BLAS was initially built";
+                error(ss.str());
+                return false;
+            }
+
+            if (numGeometries != wrapper->buildGeometries.size())
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " with " << numGeometries << " geometries "
+                    "when this BLAS was built with " << wrapper->buildGeometries.size() << " geometries";
+                error(ss.str());
+                return false;
+            }
+            
+            for (size_t i = 0; i < numGeometries; i++)
+            {
+                const auto& before = wrapper->buildGeometries[i];
+                const auto& after = pGeometries[i];
+
+                if (before.geometryType != after.geometryType)
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " with " << numGeometries << " geometries "
-                        "when this BLAS was built with " << wrapper->buildGeometries.size() << " geometries";
+                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                        << " with mismatching geometry types in slot " << i;
                     error(ss.str());
-                    return;
+                    return false;
                 }
-                
-                for (size_t i = 0; i < numGeometries; i++)
+
+                if (before.geometryType == rt::GeometryType::Triangles)
                 {
-                    const auto& before = wrapper->buildGeometries[i];
-                    const auto& after = pGeometries[i];
+                    uint32_t primitivesBefore = (before.geometryData.triangles.vertexFormat == Format::UNKNOWN)
+                        ? before.geometryData.triangles.vertexCount
+                        : before.geometryData.triangles.indexCount;
+
+                    uint32_t primitivesAfter = (after.geometryData.triangles.vertexFormat == Format::UNKNOWN)
+                        ? after.geometryData.triangles.vertexCount
+                        : after.geometryData.triangles.indexCount;
+
+                    primitivesBefore /= 3;
+                    primitivesAfter /= 3;
 
-                    if (before.geometryType != after.geometryType)
+                    if (primitivesBefore != primitivesAfter)
                     {
                         std::stringstream ss;
-                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                            << " with mismatching geometry types in slot " << i;
+                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                            << " with mismatching triangle counts in geometry slot " << i << ": "
+                            "built with " << primitivesBefore << " triangles, updating with " << primitivesAfter << " triangles";
                         error(ss.str());
-                        return;
+                        return false;
                     }
+                }
+                else // AABBs
+                {
+                    uint32_t aabbsBefore = before.geometryData.aabbs.count;
+                    uint32_t aabbsAfter = after.geometryData.aabbs.count;
 
-                    if (before.geometryType == rt::GeometryType::Triangles)
+                    if (aabbsBefore != aabbsAfter)
                     {
-                        uint32_t primitivesBefore = (before.geometryData.triangles.vertexFormat == Format::UNKNOWN)
-                            ? before.geometryData.triangles.vertexCount
-                            : before.geometryData.triangles.indexCount;
+                        std::stringstream ss;
+                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                            << " with mismatching AABB counts in geometry slot " << i << ": "
+                            "built with " << aabbsBefore << " AABBs, updating with " << aabbsAfter << " AABBs";
+                        error(ss.str());
+                        return false;
+                    }
+                }
+            }
+        }
 
-                        uint32_t primitivesAfter = (after.geometryData.triangles.vertexFormat == Format::UNKNOWN)
-                            ? after.geometryData.triangles.vertexCount
-                            : after.geometryData.triangles.indexCount;
+        if (wrapper->allowCompaction && wrapper->wasBuilt)
+        {
+            std::stringstream ss;
+            ss << "Cannot rebuild BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                << " that has the AllowCompaction flag set";
+            error(ss.str());
+            return false;
+        }
 
-                        primitivesBefore /= 3;
-                        primitivesAfter /= 3;
+        return true;
+    }
 
-                        if (primitivesBefore != primitivesAfter)
-                        {
-                            std::stringstream ss;
-                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                                << " with mismatching triangle counts in geometry slot " << i << ": "
-                                "built with " << primitivesBefore << " triangles, updating with " << primitivesAfter << " triangles";
-                            error(ss.str());
-                            return;
-                        }
-                    }
-                    else // AABBs
-                    {
-                        uint32_t aabbsBefore = before.geometryData.aabbs.count;
-                        uint32_t aabbsAfter = after.geometryData.aabbs.count;
+    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        if (!requireOpenState())
+            return;
 
-                        if (aabbsBefore != aabbsAfter)
-                        {
-                            std::stringstream ss;
-                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                                << " with mismatching AABB counts in geometry slot " << i << ": "
-                                "built with " << aabbsBefore << " AABBs, updating with " << aabbsAfter << " AABBs";
-                            error(ss.str());
-                            return;
-                        }
-                    }
-                }
+        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStruct"))
+            return;
+
+        rt::IAccelStruct* underlyingAS = as;
+
+        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
+        if (wrapper)
+        {
+            underlyingAS = wrapper->getUnderlyingObject();
+
+            if (m_DeepValidation && !validateBuildBottomLevelAccelStruct(wrapper, pGeometries, numGeometries, buildFlags))
+                return;
+
+            wrapper->wasBuilt = true;
+            wrapper->buildGeometries.assign(pGeometries, pGeometries + numGeometries);
+        }
+
+        m_CommandList->buildBottomLevelAccelStruct(underlyingAS, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStructs"))
+            return;
+
+        if (numBuilds > 0 && !pBuilds)
+        {
+            error("buildBottomLevelAccelStructs: 'pBuilds' is NULL");
+            return;
+        }
+
+        std::vector<rt::BlasBuildDesc> patchedBuilds;
+        patchedBuilds.assign(pBuilds, pBuilds + numBuilds);
+
+        std::unordered_set<rt::IAccelStruct*> accelStructsInBatch;
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& build = pBuilds[i];
+
+            if (!build.accelStruct)
+            {
+                std::stringstream ss;
+                ss << "buildBottomLevelAccelStructs: pBuilds[" << i << "].accelStruct is NULL";
+                error(ss.str());
+                return;
             }
 
-            if (wrapper->allowCompaction && wrapper->wasBuilt)
+            if (!accelStructsInBatch.insert(build.accelStruct).second)
             {
                 std::stringstream ss;
-                ss << "Cannot rebuild BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                    << " that has the AllowCompaction flag set";
+                ss << "buildBottomLevelAccelStructs: BLAS " << utils::DebugNameToString(build.accelStruct->getDesc().debugName)
+                    << " is built more than once in the same batch (pBuilds[" << i << "])";
                 error(ss.str());
                 return;
             }
 
-            wrapper->wasBuilt = true;
-            wrapper->buildGeometries.assign(pGeometries, pGeometries + numGeometries);
+            AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(build.accelStruct);
+            if (wrapper)
+            {
+                patchedBuilds[i].accelStruct = wrapper->getUnderlyingObject();
+
+                if (m_DeepValidation && !validateBuildBottomLevelAccelStruct(wrapper, build.pGeometries, build.numGeometries, build.buildFlags))
+                    return;
+            }
         }
 
-        m_CommandList->buildBottomLevelAccelStruct(underlyingAS, pGeometries, numGeometries, buildFlags);
+        // Only update the wrapper states when the whole batch is valid and will be built
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& build = pBuilds[i];
+
+            AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(build.accelStruct);
+            if (wrapper)
+            {
+                wrapper->wasBuilt = true;
+                wrapper->buildGeometries.assign(build.pGeometries, build.pGeometries + build.numGeometries);
+            }
+        }
+
+        m_CommandList->buildBottomLevelAccelStructs(patchedBuilds.data(), patchedBuilds.size());
     }
 
     bool CommandListWrapper::validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const
@@ -1775,6 +2963,95 @@ namespace nvrhi::validation
         m_CommandList->buildTopLevelAccelStructFromBuffer(underlyingAS, instanceBuffer, instanceBufferOffset, numInstances, buildFlags);
     }
 
+    void CommandListWrapper::buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+        nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildTopLevelAccelStructFromBufferIndirect"))
+            return;
+
+        if (!as)
+        {
+            error("buildTopLevelAccelStructFromBufferIndirect: 'as' is NULL");
+            return;
+        }
+
+        if (!instanceBuffer)
+        {
+            error("buildTopLevelAccelStructFromBufferIndirect: 'instanceBuffer' is NULL");
+            return;
+        }
+
+        if (!argsBuffer)
+        {
+            error("buildTopLevelAccelStructFromBufferIndirect: 'argsBuffer' is NULL");
+            return;
+        }
+
+        if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+        {
+            error("buildTopLevelAccelStructFromBufferIndirect: updates are not supported because the instance count is determined on the GPU");
+            return;
+        }
+
+        rt::IAccelStruct* underlyingAS = as;
+
+        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
+        if (wrapper)
+        {
+            underlyingAS = wrapper->getUnderlyingObject();
+
+            if (!validateBuildTopLevelAccelStruct(wrapper, maxInstances, buildFlags))
+                return;
+        }
+
+        auto bufferDesc = instanceBuffer->getDesc();
+        if (!bufferDesc.isAccelStructBuildInput)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << utils::DebugNameToString(bufferDesc.debugName) << " used in buildTopLevelAccelStructFromBufferIndirect "
+                "doesn't have the 'isAccelStructBuildInput' flag set";
+            error(ss.str());
+            return;
+        }
+
+        uint64_t sizeOfData = maxInstances * sizeof(rt::InstanceDesc);
+        if (bufferDesc.byteSize < instanceBufferOffset + sizeOfData)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << utils::DebugNameToString(bufferDesc.debugName) << " used in buildTopLevelAccelStructFromBufferIndirect "
+                "is smaller than the referenced instance data: " << sizeOfData << " bytes used at offset " << instanceBufferOffset
+                << ", buffer size is " << bufferDesc.byteSize << " bytes";
+            error(ss.str());
+            return;
+        }
+
+        auto argsDesc = argsBuffer->getDesc();
+        if (!argsDesc.isDrawIndirectArgs)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << utils::DebugNameToString(argsDesc.debugName) << " used in buildTopLevelAccelStructFromBufferIndirect "
+                "doesn't have the 'isDrawIndirectArgs' flag set";
+            error(ss.str());
+            return;
+        }
+
+        if (argsDesc.byteSize < argsBufferOffset + sizeof(rt::IndirectTlasBuildArgs) || (argsBufferOffset % 4) != 0)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << utils::DebugNameToString(argsDesc.debugName) << " used in buildTopLevelAccelStructFromBufferIndirect "
+                "cannot hold the indirect arguments at offset " << argsBufferOffset << ", the offset must be a multiple of 4 "
+                "and the buffer size is " << argsDesc.byteSize << " bytes";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->buildTopLevelAccelStructFromBufferIndirect(underlyingAS, instanceBuffer, instanceBufferOffset,
+            argsBuffer, argsBufferOffset, maxInstances, buildFlags);
+    }
+
     void CommandListWrapper::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
     {
         if (!requireOpenState())
@@ -1839,6 +3116,9 @@ namespace nvrhi::validation
 
     void CommandListWrapper::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
     {
+        if (!requirePrimary("convertCoopVecMatrices"))
+            return;
+
         if (!m_Device->queryFeatureSupport(Feature::CooperativeVectorInferencing))
         {
             error("convertCoopVecMatrices: Cooperative Vectors are not supported by the device");
@@ -1912,6 +3192,39 @@ namespace nvrhi::validation
         }
     }
 
+    bool CommandListWrapper::validateVolatileBufferWrites(const BindingSetVector& bindings) const
+    {
+        // A reusable command list is executed with whatever versions of the volatile buffers it was recorded with,
+        // so the contents of every volatile buffer it uses must be written in the command list itself
+        if (!m_IsReusable)
+            return true;
+
+        for (IBindingSet* bindingSet : bindings)
+        {
+            const BindingSetDesc* desc = bindingSet ? bindingSet->getDesc() : nullptr;
+            if (!desc)
+                continue;
+
+            for (const BindingSetItem& item : desc->bindings)
+            {
+                if (item.type != ResourceType::VolatileConstantBuffer || !item.resourceHandle)
+                    continue;
+
+                IBuffer* buffer = checked_cast<IBuffer*>(item.resourceHandle);
+                if (m_WrittenVolatileBuffers.find(buffer) == m_WrittenVolatileBuffers.end())
+                {
+                    std::stringstream ss;
+                    ss << "Volatile constant buffer " << utils::DebugNameToString(buffer->getDesc().debugName)
+                        << " is used in a reusable command list before it is written in that command list";
+                    error(ss.str());
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
     bool CommandListWrapper::validatePushConstants(const char* pipelineType, const char* stateFunctionName) const
     {
         if (m_PipelinePushConstantSize != 0 && !m_PushConstantsSet)
@@ -1927,5 +3240,64 @@ namespace nvrhi::validation
 
         return true;
     }
+    bool CommandListWrapper::validateDrawBatch(const char* operation, bool indexed, const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) const
+    {
+        if (!requireType(CommandQueue::Graphics, operation))
+            return false;
+
+        if (!m_GraphicsStateSet)
+        {
+            std::stringstream ss;
+            ss << "Graphics state is not set before a " << operation << " call.\n"
+                "Note that setting compute state invalidates the graphics state.";
+            error(ss.str());
+            return false;
+        }
+
+        if (indexed && m_CurrentGraphicsState.indexBuffer.buffer == nullptr)
+        {
+            std::stringstream ss;
+            ss << "Index buffer is not set before a " << operation << " call";
+            error(ss.str());
+            return false;
+        }
+
+        if (count != 0 && !args)
+        {
+            std::stringstream ss;
+            ss << operation << ": args is NULL while count is " << count;
+            error(ss.str());
+            return false;
+        }
+
+        if (!validateVolatileBufferWrites(m_CurrentGraphicsState.bindings))
+            return false;
+
+        if (!pushConstants)
+            return validatePushConstants("graphics", "setGraphicsState");
+
+        if (pushConstantByteSize != m_PipelinePushConstantSize)
+        {
+            std::stringstream ss;
+
+            if (m_PipelinePushConstantSize == 0)
+                ss << operation << ": The current pipeline does not expect any push constants, so pushConstants must be NULL.";
+            else
+                ss << operation << ": Push constant size (" << pushConstantByteSize << " bytes) doesn't match the size expected by the pipeline (" << m_PipelinePushConstantSize << " bytes)";
+
+            error(ss.str());
+            return false;
+        }
+
+        if (pushConstantStride != 0 && pushConstantStride < pushConstantByteSize)
+        {
+            std::stringstream ss;
+            ss << operation << ": Push constant stride (" << pushConstantStride << " bytes) is smaller than the push constant size (" << pushConstantByteSize << " bytes)";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
     
 } // namespace nvrhi::validation
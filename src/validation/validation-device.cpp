@@ -59,15 +59,37 @@ namespace nvrhi::validation
 
     DeviceHandle createValidationLayer(IDevice* underlyingDevice)
     {
-        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice);
+        return createValidationLayer(underlyingDevice, ValidationLayerDesc());
+    }
+
+    DeviceHandle createValidationLayer(IDevice* underlyingDevice, const ValidationLayerDesc& desc)
+    {
+        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice, desc);
         return DeviceHandle::Create(wrapper);
     }
 
-    DeviceWrapper::DeviceWrapper(IDevice* device)
+    DeviceWrapper::DeviceWrapper(IDevice* device, const ValidationLayerDesc& desc)
         : m_Device(device)
         , m_MessageCallback(device->getMessageCallback())
+        , m_Desc(desc)
     {
+        m_Desc.samplingInterval = std::max(m_Desc.samplingInterval, 1u);
+    }
 
+    bool DeviceWrapper::sampleDeepValidation()
+    {
+        switch (m_Desc.level)
+        {
+        case ValidationLevel::Full:
+            return true;
+        case ValidationLevel::StateOnly:
+            return false;
+        case ValidationLevel::Sampled:
+        default:
+            // The counter is shared by all threads recording command lists, so the exact sample assignment
+            // is not deterministic, but the rate is, and no lock is taken on the recording path
+            return m_NumSamplingDecisions.fetch_add(1, std::memory_order_relaxed) % m_Desc.samplingInterval == 0;
+        }
     }
 
     void DeviceWrapper::error(const std::string& messageText) const
@@ -458,6 +480,14 @@ namespace nvrhi::validation
             return nullptr;
         }
 
+        if (d.preferDeviceLocal && d.cpuAccess == CpuAccessMode::Read)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << patchedDesc.debugName << " has preferDeviceLocal = true and cpuAccess = Read. "
+                "Device-local CPU-visible memory is only suitable for writing, the flag will be ignored.";
+            warning(ss.str());
+        }
+
         if (d.isVirtual && !m_Device->queryFeatureSupport(Feature::VirtualResources))
         {
             error("The device does not support virtual resources");
@@ -575,7 +605,9 @@ namespace nvrhi::validation
     
     ShaderHandle DeviceWrapper::createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
     {
-        if (!m_Device->queryFeatureSupport(Feature::ShaderSpecializations))
+        // D3D12 doesn't report the feature but serves specializations from permutations registered with
+        // d3d12::IDevice::addShaderSpecializationPermutation
+        if (!m_Device->queryFeatureSupport(Feature::ShaderSpecializations) && m_Device->getGraphicsAPI() != GraphicsAPI::D3D12)
         {
             std::stringstream ss;
             ss << "The current graphics API (" << utils::GraphicsAPIToString(m_Device->getGraphicsAPI()) << ") "
@@ -639,6 +671,65 @@ namespace nvrhi::validation
         m_Device->resetEventQuery(query);
     }
 
+    bool DeviceWrapper::validateSubmissionTickets(const SubmissionTicket* tickets, size_t numTickets, const char* function) const
+    {
+        if (numTickets != 0 && !tickets)
+        {
+            std::stringstream ss;
+            ss << function << ": tickets is NULL, but numTickets = " << numTickets;
+            error(ss.str());
+            return false;
+        }
+
+        for (size_t i = 0; i < numTickets; i++)
+        {
+            if (tickets[i].queue >= CommandQueue::Count)
+            {
+                std::stringstream ss;
+                ss << function << ": ticket [" << i << "] has an invalid queue type " << uint32_t(tickets[i].queue);
+                error(ss.str());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    SubmissionTicket DeviceWrapper::getSubmissionTicket(CommandQueue queue)
+    {
+        if (queue >= CommandQueue::Count)
+        {
+            error("getSubmissionTicket: invalid queue type");
+            return SubmissionTicket();
+        }
+
+        return m_Device->getSubmissionTicket(queue);
+    }
+
+    bool DeviceWrapper::pollSubmission(const SubmissionTicket& ticket)
+    {
+        if (!validateSubmissionTickets(&ticket, 1, "pollSubmission"))
+            return false;
+
+        return m_Device->pollSubmission(ticket);
+    }
+
+    bool DeviceWrapper::waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        if (!validateSubmissionTickets(tickets, numTickets, "waitForAll"))
+            return false;
+
+        return m_Device->waitForAll(tickets, numTickets, timeoutNanoseconds);
+    }
+
+    bool DeviceWrapper::waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        if (!validateSubmissionTickets(tickets, numTickets, "waitForAny"))
+            return false;
+
+        return m_Device->waitForAny(tickets, numTickets, timeoutNanoseconds);
+    }
+
     TimerQueryHandle DeviceWrapper::createTimerQuery()
     {
         return m_Device->createTimerQuery();
@@ -703,6 +794,16 @@ namespace nvrhi::validation
                 error(ss.str());
                 return nullptr;
             }
+
+            if (desc.depthAttachment.isReadOnly &&
+                (desc.depthAttachment.loadOp != AttachmentLoadOp::Load || desc.depthAttachment.storeOp != AttachmentStoreOp::Store))
+            {
+                std::stringstream ss;
+                ss << "Read-only depth attachment texture " << utils::DebugNameToString(d.debugName)
+                    << " must use AttachmentLoadOp::Load and AttachmentStoreOp::Store";
+                error(ss.str());
+                return nullptr;
+            }
         }
 
         for (size_t i = 0; i < desc.colorAttachments.size(); ++i)
@@ -1104,6 +1205,7 @@ namespace nvrhi::validation
 
         int pushConstantCount = 0;
         uint32_t pushConstantSize = 0;
+        int pushDescriptorLayoutCount = 0;
         enum class RegisterSpaceIsDescriptorSet
         {
             False,
@@ -1128,6 +1230,9 @@ namespace nvrhi::validation
                     }
                 }
 
+                if (layoutDesc->usePushDescriptors)
+                    pushDescriptorLayoutCount++;
+
                 if (layoutDesc->registerSpaceIsDescriptorSet)
                 {
                     if (layoutDesc->registerSpace >= c_MaxBindingLayouts)
@@ -1175,6 +1280,14 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (pushDescriptorLayoutCount > 1)
+        {
+            std::stringstream errorStream;
+            errorStream << "Pipeline contains more than one (" << pushDescriptorLayoutCount << ") push descriptor layouts";
+            error(errorStream.str());
+            anyErrors = true;
+        }
+
         if (pushConstantCount > 1)
         {
             std::stringstream errorStream;
@@ -1321,11 +1434,193 @@ namespace nvrhi::validation
         return createMeshletPipeline(pipelineDesc, fb->getFramebufferInfo());
     }
 
+    WorkGraphPipelineHandle DeviceWrapper::createWorkGraphPipeline(const WorkGraphPipelineDesc& pipelineDesc)
+    {
+        const bool native = m_Device->queryFeatureSupport(Feature::WorkGraphs);
+        if (!native && !m_Device->queryFeatureSupport(Feature::WorkGraphEmulation))
+        {
+            error("createWorkGraphPipeline: work graphs are not supported by this device");
+            return nullptr;
+        }
+
+        if (native && !pipelineDesc.shaderLibrary && m_Device->getGraphicsAPI() == GraphicsAPI::D3D12)
+        {
+            error("createWorkGraphPipeline: shaderLibrary is NULL");
+            return nullptr;
+        }
+
+        bool anyEntryNodes = false;
+        std::vector<IShader*> shaders;
+
+        for (size_t index = 0; index < pipelineDesc.nodes.size(); index++)
+        {
+            const WorkGraphNodeDesc& node = pipelineDesc.nodes[index];
+
+            if (node.producerNode >= int32_t(index))
+            {
+                std::stringstream ss;
+                ss << "createWorkGraphPipeline: the producer of node " << index << " (" << node.name << ") is node "
+                   << node.producerNode << ", producers must be listed before their consumers";
+                error(ss.str());
+                return nullptr;
+            }
+
+            if (node.producerNode < 0)
+                anyEntryNodes = true;
+            else if (node.dispatchArgumentsOffset % 4 != 0)
+            {
+                std::stringstream ss;
+                ss << "createWorkGraphPipeline: dispatchArgumentsOffset of node " << index << " (" << node.name
+                   << ") must be a multiple of 4";
+                error(ss.str());
+                return nullptr;
+            }
+
+            if (!native)
+            {
+                if (!node.computeShader)
+                {
+                    std::stringstream ss;
+                    ss << "createWorkGraphPipeline: node " << index << " (" << node.name
+                       << ") has no compute shader, which emulated work graphs require";
+                    error(ss.str());
+                    return nullptr;
+                }
+
+                if (!validateShaderType(ShaderType::Compute, node.computeShader->getDesc(), "createWorkGraphPipeline"))
+                    return nullptr;
+
+                shaders.push_back(node.computeShader);
+            }
+        }
+
+        if (!anyEntryNodes)
+        {
+            error("createWorkGraphPipeline: the work graph has no entry nodes");
+            return nullptr;
+        }
+
+        if (!validatePipelineBindingLayouts(pipelineDesc.bindingLayouts, shaders))
+            return nullptr;
+
+        return m_Device->createWorkGraphPipeline(pipelineDesc);
+    }
+
     nvrhi::rt::PipelineHandle DeviceWrapper::createRayTracingPipeline(const rt::PipelineDesc& desc)
     {
         return m_Device->createRayTracingPipeline(desc);
     }
 
+    CommandSignatureHandle DeviceWrapper::createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline)
+    {
+        if (!m_Device->queryFeatureSupport(Feature::DeviceGeneratedCommands))
+        {
+            error("createCommandSignature: device-generated commands are not supported by this device");
+            return nullptr;
+        }
+
+        if (!pipeline)
+        {
+            error("createCommandSignature: pipeline is NULL");
+            return nullptr;
+        }
+
+        if (desc.arguments.empty())
+        {
+            error("createCommandSignature: the signature has no arguments");
+            return nullptr;
+        }
+
+        uint32_t pipelinePushConstantSize = 0;
+        for (const auto& layout : pipeline->getDesc().bindingLayouts)
+        {
+            const BindingLayoutDesc* layoutDesc = layout->getDesc();
+            if (!layoutDesc)
+                continue;
+
+            for (const auto& item : layoutDesc->bindings)
+            {
+                if (item.type == ResourceType::PushConstants)
+                    pipelinePushConstantSize = item.size;
+            }
+        }
+
+        uint32_t vertexBufferSlotMask = 0;
+        bool anyErrors = false;
+
+        for (size_t index = 0; index < desc.arguments.size(); index++)
+        {
+            const IndirectArgumentDesc& arg = desc.arguments[index];
+            const bool isLast = index + 1 == desc.arguments.size();
+            const bool isDraw = arg.type == IndirectArgumentType::Draw || arg.type == IndirectArgumentType::DrawIndexed;
+
+            std::stringstream ss;
+            ss << "createCommandSignature: argument " << index << ": ";
+
+            if (isDraw != isLast)
+            {
+                ss << "the signature must contain exactly one Draw or DrawIndexed argument, and it must be the last one";
+                error(ss.str());
+                anyErrors = true;
+            }
+            else if (arg.type == IndirectArgumentType::VertexBuffer)
+            {
+                if (arg.slot >= c_MaxVertexAttributes)
+                {
+                    ss << "vertex buffer slot " << arg.slot << " is out of range";
+                    error(ss.str());
+                    anyErrors = true;
+                }
+                else if (vertexBufferSlotMask & (1u << arg.slot))
+                {
+                    ss << "vertex buffer slot " << arg.slot << " is used more than once";
+                    error(ss.str());
+                    anyErrors = true;
+                }
+                else
+                    vertexBufferSlotMask |= 1u << arg.slot;
+            }
+            else if (arg.type == IndirectArgumentType::PushConstants)
+            {
+                if (arg.pushConstantByteSize == 0 || (arg.pushConstantByteSize % 4) != 0 || (arg.pushConstantOffset % 4) != 0)
+                {
+                    ss << "push constant offset (" << arg.pushConstantOffset << ") and size (" << arg.pushConstantByteSize
+                        << ") must be non-zero multiples of 4 bytes";
+                    error(ss.str());
+                    anyErrors = true;
+                }
+                else if (arg.pushConstantOffset + arg.pushConstantByteSize > pipelinePushConstantSize)
+                {
+                    ss << "push constant range [" << arg.pushConstantOffset << ", " << arg.pushConstantOffset + arg.pushConstantByteSize
+                        << ") exceeds the pipeline push constant size (" << pipelinePushConstantSize << " bytes)";
+                    error(ss.str());
+                    anyErrors = true;
+                }
+            }
+        }
+
+        if (anyErrors)
+            return nullptr;
+
+        if (desc.byteStride != 0)
+        {
+            CommandSignatureDesc packedDesc = desc;
+            packedDesc.byteStride = 0;
+            const uint32_t packedSize = packedDesc.getCommandByteStride();
+
+            if ((desc.byteStride % 4) != 0 || desc.byteStride < packedSize)
+            {
+                std::stringstream ss;
+                ss << "createCommandSignature: byteStride (" << desc.byteStride << ") must be a multiple of 4 bytes "
+                    "and at least the total size of the arguments (" << packedSize << " bytes)";
+                error(ss.str());
+                return nullptr;
+            }
+        }
+
+        return m_Device->createCommandSignature(desc, pipeline);
+    }
+
     BindingLayoutHandle DeviceWrapper::createBindingLayout(const BindingLayoutDesc& desc)
     {
         std::stringstream errorStream;
@@ -1418,6 +1713,18 @@ namespace nvrhi::validation
 
         const GraphicsAPI graphicsApi = m_Device->getGraphicsAPI();
         
+        if (desc.usePushDescriptors && !m_Device->queryFeatureSupport(Feature::PushDescriptors))
+        {
+            errorStream << "Push descriptor layouts are not supported by this device" << std::endl;
+            anyErrors = true;
+        }
+
+        if (desc.usePushDescriptors && pushConstantCount)
+        {
+            errorStream << "Push descriptor layouts cannot contain push constants" << std::endl;
+            anyErrors = true;
+        }
+
         if (desc.registerSpace != 0 && graphicsApi == GraphicsAPI::VULKAN && !desc.registerSpaceIsDescriptorSet)
         {
             errorStream << "Binding layout has nonzero registerSpace (" << desc.registerSpace << "), which is supported "
@@ -1815,21 +2122,30 @@ namespace nvrhi::validation
         return true;
     }
 
-    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    bool DeviceWrapper::validateBindingSet(const BindingSetDesc& desc, IBindingLayout* layout, bool checkResources)
     {
         if (layout == nullptr)
         {
             error("Cannot create a binding set without a valid layout");
-            return nullptr;
+            return false;
         }
 
         const BindingLayoutDesc* layoutDesc = layout->getDesc();
         if (!layoutDesc)
         {
             error("Cannot create a binding set from a bindless layout");
-            return nullptr;
+            return false;
+        }
+
+        if (layoutDesc->usePushDescriptors)
+        {
+            error("Cannot create a binding set from a push descriptor layout, use ICommandList::setPushBindings instead");
+            return false;
         }
 
+        if (!checkResources)
+            return true;
+
         std::stringstream errorStream;
         bool anyErrors = false;
         bool const ignoreRegisterSpaces = (m_Device->getGraphicsAPI() == GraphicsAPI::D3D11);
@@ -1879,9 +2195,17 @@ namespace nvrhi::validation
         if (anyErrors)
         {
             error(errorStream.str());
-            return nullptr;
+            return false;
         }
 
+        return true;
+    }
+
+    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        if (!validateBindingSet(desc, layout, sampleDeepValidation()))
+            return nullptr;
+
         // Unwrap the resources
         BindingSetDesc patchedDesc = desc;
         for (auto& binding : patchedDesc.bindings)
@@ -2217,6 +2541,36 @@ namespace nvrhi::validation
             return nullptr;
         }
 
+        if (params.isSecondary)
+        {
+            if (params.queueType != CommandQueue::Graphics)
+            {
+                error("Secondary command lists can only be created for the graphics queue");
+                return nullptr;
+            }
+
+            if (!m_Device->queryFeatureSupport(Feature::SecondaryCommandLists))
+            {
+                error("Secondary command lists are not supported by this device");
+                return nullptr;
+            }
+        }
+
+        if (params.isReusable)
+        {
+            if (params.isSecondary)
+            {
+                error("A command list cannot be both secondary and reusable");
+                return nullptr;
+            }
+
+            if (!m_Device->queryFeatureSupport(Feature::ReusableCommandLists))
+            {
+                error("Reusable command lists are not supported by this device");
+                return nullptr;
+            }
+        }
+
         CommandListHandle commandList = m_Device->createCommandList(params);
 
         if (commandList == nullptr)
@@ -2251,6 +2605,15 @@ namespace nvrhi::validation
             }
 
             const CommandListParameters& desc = pCommandLists[i]->getDesc();
+            if (desc.isSecondary)
+            {
+                std::stringstream ss;
+                ss << "executeCommandLists: The command list [" << i << "] is a secondary command list, "
+                    "it can only be executed with executeSecondaryCommandLists";
+                error(ss.str());
+                return 0;
+            }
+
             if (desc.queueType != executionQueue)
             {
                 std::stringstream ss;
@@ -2280,6 +2643,11 @@ namespace nvrhi::validation
         m_Device->queueWaitForCommandList(waitQueue, executionQueue, instance);
     }
 
+    void DeviceWrapper::flushSubmissions()
+    {
+        m_Device->flushSubmissions();
+    }
+
     bool DeviceWrapper::waitForIdle()
     {
         return m_Device->waitForIdle();
@@ -2290,6 +2658,16 @@ namespace nvrhi::validation
         m_Device->runGarbageCollection();
     }
 
+    void DeviceWrapper::runGarbageCollection(uint32_t maxReleaseMicroseconds)
+    {
+        m_Device->runGarbageCollection(maxReleaseMicroseconds);
+    }
+
+    void DeviceWrapper::evictCachedFramebuffers(ITexture* texture)
+    {
+        m_Device->evictCachedFramebuffers(texture);
+    }
+
     bool DeviceWrapper::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
     {
         return m_Device->queryFeatureSupport(feature, pInfo, infoSize);
@@ -2300,6 +2678,36 @@ namespace nvrhi::validation
         return m_Device->queryFormatSupport(format);
     }
 
+    MemoryAllocatorStats DeviceWrapper::getMemoryAllocatorStats()
+    {
+        return m_Device->getMemoryAllocatorStats();
+    }
+
+    MemoryBudget DeviceWrapper::getMemoryBudget()
+    {
+        return m_Device->getMemoryBudget();
+    }
+
+    AccelStructStats DeviceWrapper::getAccelStructStats()
+    {
+        return m_Device->getAccelStructStats();
+    }
+
+    DeviceStats DeviceWrapper::getDeviceStats()
+    {
+        return m_Device->getDeviceStats();
+    }
+
+    bool DeviceWrapper::getProfilerFrameResults(ProfilerFrameResults& outResults)
+    {
+        return m_Device->getProfilerFrameResults(outResults);
+    }
+
+    bool DeviceWrapper::getPipelineCacheData(std::vector<uint8_t>& data)
+    {
+        return m_Device->getPipelineCacheData(data);
+    }
+
     coopvec::DeviceFeatures DeviceWrapper::queryCoopVecFeatures()
     {
         return m_Device->queryCoopVecFeatures();
@@ -25,7 +25,7 @@
 namespace nvrhi::vulkan
 {
 
-    static vk::MemoryPropertyFlags pickBufferMemoryProperties(const BufferDesc& d)
+    static vk::MemoryPropertyFlags pickBufferMemoryProperties(const BufferDesc& d, bool deviceLocalUpload)
     {
         vk::MemoryPropertyFlags flags{};
 
@@ -39,54 +39,377 @@ namespace nvrhi::vulkan
             break;
         case CpuAccessMode::Write:
             flags = vk::MemoryPropertyFlagBits::eHostVisible;
+            if (deviceLocalUpload)
+                flags |= vk::MemoryPropertyFlagBits::eDeviceLocal;
             break;
         }
 
         return flags;
     }
 
-    vk::Result VulkanAllocator::allocateBufferMemory(Buffer *buffer, bool enableDeviceAddress) const
+    static float convertResidencyPriority(ResidencyPriority priority)
     {
-        // figure out memory requirements
-        vk::MemoryRequirements memRequirements;
-        m_Context.device.getBufferMemoryRequirements(buffer->buffer, &memRequirements);
+        switch (priority)
+        {
+        case ResidencyPriority::Minimum: return 0.f;
+        case ResidencyPriority::Low:     return 0.25f;
+        case ResidencyPriority::High:    return 0.75f;
+        case ResidencyPriority::Maximum: return 1.f;
+        case ResidencyPriority::Normal:
+        default:                         return 0.5f;
+        }
+    }
+
+    static uint32_t makePoolKey(uint32_t memTypeIndex, bool linearResource, bool smallAllocation, bool enableDeviceAddress)
+    {
+        // Buffers and optimal-tiling images are kept in separate blocks so that bufferImageGranularity
+        // never has to be taken into account when placing resources next to each other.
+        return memTypeIndex
+            | (linearResource ? (1u << 5) : 0)
+            | (smallAllocation ? (1u << 6) : 0)
+            | (enableDeviceAddress ? (1u << 7) : 0);
+    }
+
+    VulkanAllocator::VulkanAllocator(const VulkanContext& context, uint64_t blockSize)
+        : m_Context(context)
+        , m_BlockSize(blockSize)
+    {
+        m_Context.physicalDevice.getMemoryProperties(&m_MemoryProperties);
+
+        // Every discrete GPU exposes a small host-visible window into video memory, but only consider it usable
+        // for general uploads when resizable BAR makes it large enough not to run out.
+        constexpr vk::MemoryPropertyFlags deviceLocalUploadFlags = vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible;
+        for (uint32_t memTypeIndex = 0; memTypeIndex < m_MemoryProperties.memoryTypeCount; memTypeIndex++)
+        {
+            const vk::MemoryType& memType = m_MemoryProperties.memoryTypes[memTypeIndex];
+            if ((memType.propertyFlags & deviceLocalUploadFlags) == deviceLocalUploadFlags &&
+                m_MemoryProperties.memoryHeaps[memType.heapIndex].size > c_MinDeviceLocalUploadHeapSize)
+            {
+                m_DeviceLocalUploadSupported = true;
+                break;
+            }
+        }
+    }
+
+    VulkanAllocator::~VulkanAllocator()
+    {
+        for (auto& poolIter : m_Pools)
+        {
+            for (const auto& block : poolIter.second.blocks)
+            {
+                // All resources should be released before the device
+                assert(block->ranges.isEmpty());
+
+                if (block->mappedMemory)
+                    m_Context.device.unmapMemory(block->memory);
+
+                m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+            }
+        }
+        m_Pools.clear();
+    }
+
+    bool VulkanAllocator::findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memPropertyFlags, uint32_t& outMemTypeIndex) const
+    {
+        for (uint32_t memTypeIndex = 0; memTypeIndex < m_MemoryProperties.memoryTypeCount; memTypeIndex++)
+        {
+            if ((memoryTypeBits & (1 << memTypeIndex)) &&
+                ((m_MemoryProperties.memoryTypes[memTypeIndex].propertyFlags & memPropertyFlags) == memPropertyFlags))
+            {
+                outMemTypeIndex = memTypeIndex;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    vk::Result VulkanAllocator::allocateBufferMemory(Buffer *buffer, bool enableDeviceAddress)
+    {
+        // figure out memory requirements and whether the driver wants a dedicated allocation for this buffer
+        auto dedicatedRequirements = vk::MemoryDedicatedRequirements();
+        auto memRequirements2 = vk::MemoryRequirements2()
+            .setPNext(&dedicatedRequirements);
+        auto requirementsInfo = vk::BufferMemoryRequirementsInfo2()
+            .setBuffer(buffer->buffer);
+        m_Context.device.getBufferMemoryRequirements2(&requirementsInfo, &memRequirements2);
+
+        // Volatile buffers are persistently mapped and flushed using offsets relative to their own memory
+        // object, so keep them separate.
+        // Memory priorities apply to whole allocations, so resources with a specific priority get their own.
+        buffer->residencyPriority = buffer->desc.residencyPriority;
+        const bool requiresDedicatedAllocation = dedicatedRequirements.prefersDedicatedAllocation
+            || dedicatedRequirements.requiresDedicatedAllocation
+            || buffer->desc.isVolatile
+            || buffer->desc.allocationMode == ResourceAllocationMode::Dedicated
+            || (m_Context.memoryPriority && buffer->residencyPriority != ResidencyPriority::Normal);
+
+        // Place CPU-written buffers into device-local memory when requested, or for volatile buffers when resizable BAR
+        // is available, so that the GPU reads them from video memory instead of over PCIe.
+        bool deviceLocalUpload = buffer->desc.cpuAccess == CpuAccessMode::Write
+            && (buffer->desc.preferDeviceLocal || (buffer->desc.isVolatile && m_DeviceLocalUploadSupported));
+
+        uint32_t memTypeIndex;
+        if (deviceLocalUpload && !findMemoryType(memRequirements2.memoryRequirements.memoryTypeBits,
+            pickBufferMemoryProperties(buffer->desc, true), memTypeIndex))
+        {
+            deviceLocalUpload = false;
+        }
 
         // allocate memory
         const bool enableMemoryExport = (buffer->desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0;
-        const vk::Result res = allocateMemory(buffer, memRequirements, pickBufferMemoryProperties(buffer->desc), enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer);
+        vk::Result res = allocateResourceMemory(buffer, memRequirements2.memoryRequirements, pickBufferMemoryProperties(buffer->desc, deviceLocalUpload),
+            requiresDedicatedAllocation, enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer);
+
+        if (deviceLocalUpload && res == vk::Result::eErrorOutOfDeviceMemory)
+        {
+            // The host-visible part of video memory is exhausted, fall back to regular upload memory
+            res = allocateResourceMemory(buffer, memRequirements2.memoryRequirements, pickBufferMemoryProperties(buffer->desc, false),
+                requiresDedicatedAllocation, enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer);
+        }
         CHECK_VK_RETURN(res)
 
-        m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, 0);
+        m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, buffer->memoryOffset);
 
         return vk::Result::eSuccess;
     }
 
-    void VulkanAllocator::freeBufferMemory(Buffer *buffer) const
+    void VulkanAllocator::freeBufferMemory(Buffer *buffer)
     {
-        freeMemory(buffer);
+        freeResourceMemory(buffer);
     }
 
-    vk::Result VulkanAllocator::allocateTextureMemory(Texture *texture) const
+    vk::Result VulkanAllocator::allocateTextureMemory(Texture *texture)
     {
-        // grab the image memory requirements
-        vk::MemoryRequirements memRequirements;
-        m_Context.device.getImageMemoryRequirements(texture->image, &memRequirements);
+        // grab the image memory requirements and whether the driver wants a dedicated allocation for this image
+        auto dedicatedRequirements = vk::MemoryDedicatedRequirements();
+        auto memRequirements2 = vk::MemoryRequirements2()
+            .setPNext(&dedicatedRequirements);
+        auto requirementsInfo = vk::ImageMemoryRequirementsInfo2()
+            .setImage(texture->image);
+        m_Context.device.getImageMemoryRequirements2(&requirementsInfo, &memRequirements2);
+
+        texture->residencyPriority = texture->desc.residencyPriority;
+        const bool requiresDedicatedAllocation = dedicatedRequirements.prefersDedicatedAllocation
+            || dedicatedRequirements.requiresDedicatedAllocation
+            || texture->desc.allocationMode == ResourceAllocationMode::Dedicated
+            || (m_Context.memoryPriority && texture->residencyPriority != ResidencyPriority::Normal);
 
         // allocate memory
         const vk::MemoryPropertyFlags memProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
         const bool enableDeviceAddress = false;
         const bool enableMemoryExport = (texture->desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0;
-        const vk::Result res = allocateMemory(texture, memRequirements, memProperties, enableDeviceAddress, enableMemoryExport, texture->image, nullptr);
+        const vk::Result res = allocateResourceMemory(texture, memRequirements2.memoryRequirements, memProperties,
+            requiresDedicatedAllocation, enableDeviceAddress, enableMemoryExport, texture->image, nullptr);
         CHECK_VK_RETURN(res)
 
-        m_Context.device.bindImageMemory(texture->image, texture->memory, 0);
+        m_Context.device.bindImageMemory(texture->image, texture->memory, texture->memoryOffset);
+
+        return vk::Result::eSuccess;
+    }
+
+    void VulkanAllocator::freeTextureMemory(Texture *texture)
+    {
+        freeResourceMemory(texture);
+    }
+
+    vk::Result VulkanAllocator::allocateResourceMemory(MemoryResource* res,
+                                                       vk::MemoryRequirements memRequirements,
+                                                       vk::MemoryPropertyFlags memPropertyFlags,
+                                                       bool requiresDedicatedAllocation,
+                                                       bool enableDeviceAddress,
+                                                       bool enableExportMemory,
+                                                       VkImage image,
+                                                       VkBuffer buffer)
+    {
+        // Exported memory is shared with other APIs or processes as a whole, so it can't contain other resources
+        if (requiresDedicatedAllocation || enableExportMemory)
+        {
+            return allocateMemory(res, memRequirements, memPropertyFlags, enableDeviceAddress, enableExportMemory, image, buffer);
+        }
+
+        const bool linearResource = buffer != nullptr;
+        const vk::Result result = subAllocateMemory(res, memRequirements, memPropertyFlags, linearResource, enableDeviceAddress);
+
+        if (result == vk::Result::eErrorFeatureNotPresent)
+        {
+            // The resource is too large for the blocks, or sub-allocation is disabled
+            return allocateMemory(res, memRequirements, memPropertyFlags, enableDeviceAddress);
+        }
+
+        return result;
+    }
+
+    void VulkanAllocator::freeResourceMemory(MemoryResource* res)
+    {
+        if (res->memoryBlock)
+            freeSubAllocatedMemory(res);
+        else
+            freeMemory(res);
+    }
+
+    vk::Result VulkanAllocator::subAllocateMemory(MemoryResource* res,
+                                                  vk::MemoryRequirements memRequirements,
+                                                  vk::MemoryPropertyFlags memPropertyFlags,
+                                                  bool linearResource,
+                                                  bool enableDeviceAddress)
+    {
+        if (m_BlockSize == 0)
+            return vk::Result::eErrorFeatureNotPresent;
+
+        vk::DeviceSize size = memRequirements.size;
+        vk::DeviceSize alignment = std::max<vk::DeviceSize>(memRequirements.alignment, 1);
+
+        // Pick the size class: small resources are rounded up so that their slots can be reused by others
+        const bool smallAllocation = std::max(size, alignment) <= c_SmallAllocationMaxSize;
+        vk::DeviceSize blockSize = m_BlockSize;
+        if (smallAllocation)
+        {
+            size = NextPowerOf2(std::max(std::max(size, alignment), c_SmallAllocationMinSize));
+            alignment = std::max(alignment, size);
+            blockSize = std::max(m_BlockSize / c_SmallBlockDivisor, c_SmallAllocationMaxSize);
+        }
+
+        // Resources that would take up a large fraction of a block get their own allocation
+        if (!smallAllocation && size > blockSize / 2)
+            return vk::Result::eErrorFeatureNotPresent;
+
+        uint32_t memTypeIndex;
+        if (!findMemoryType(memRequirements.memoryTypeBits, memPropertyFlags, memTypeIndex))
+        {
+            // xxxnsubtil: this is incorrect; need better error reporting
+            return vk::Result::eErrorOutOfDeviceMemory;
+        }
+
+        // The device address bit only matters for buffers, and it's only legal when the feature is enabled
+        enableDeviceAddress = enableDeviceAddress && linearResource && m_Context.extensions.buffer_device_address;
+
+        const uint32_t poolKey = makePoolKey(memTypeIndex, linearResource, smallAllocation, enableDeviceAddress);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        MemoryPool& pool = m_Pools[poolKey];
+
+        MemoryBlock* block = nullptr;
+        vk::DeviceSize offset = 0;
+        for (const auto& candidate : pool.blocks)
+        {
+            if (candidate->ranges.allocate(size, alignment, offset))
+            {
+                block = candidate.get();
+                break;
+            }
+        }
+
+        if (!block)
+        {
+            auto newBlock = std::make_unique<MemoryBlock>(blockSize);
+            newBlock->poolKey = poolKey;
+
+            auto allocFlags = vk::MemoryAllocateFlagsInfo();
+            if (enableDeviceAddress)
+                allocFlags.flags |= vk::MemoryAllocateFlagBits::eDeviceAddress;
+
+            auto allocInfo = vk::MemoryAllocateInfo()
+                                .setAllocationSize(blockSize)
+                                .setMemoryTypeIndex(memTypeIndex)
+                                .setPNext(&allocFlags);
+
+            const vk::Result result = m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &newBlock->memory);
+            if (result != vk::Result::eSuccess)
+            {
+                // Not enough memory for a whole block, maybe there is enough for the resource alone
+                return vk::Result::eErrorFeatureNotPresent;
+            }
+
+            if (memPropertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+            {
+                newBlock->mappedMemory = m_Context.device.mapMemory(newBlock->memory, 0, VK_WHOLE_SIZE);
+                assert(newBlock->mappedMemory);
+            }
+
+            [[maybe_unused]] const bool allocated = newBlock->ranges.allocate(size, alignment, offset);
+            assert(allocated);
+
+            block = newBlock.get();
+            pool.blocks.push_back(std::move(newBlock));
+        }
+
+        res->managed = true;
+        res->memory = block->memory;
+        res->memoryBlock = block;
+        res->memoryOffset = offset;
+        res->memorySize = size;
 
         return vk::Result::eSuccess;
     }
 
-    void VulkanAllocator::freeTextureMemory(Texture *texture) const
+    void VulkanAllocator::freeSubAllocatedMemory(MemoryResource* res)
     {
-        freeMemory(texture);
+        assert(res->managed);
+        assert(res->memoryBlock);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        MemoryBlock* block = res->memoryBlock;
+        block->ranges.release(res->memoryOffset, res->memorySize);
+
+        res->memory = vk::DeviceMemory(nullptr);
+        res->memoryBlock = nullptr;
+        res->memoryOffset = 0;
+        res->memorySize = 0;
+
+        if (!block->ranges.isEmpty())
+            return;
+
+        // Release the empty block unless it's the only one left in the pool, to avoid reallocating
+        // the block over and over when a single resource is created and destroyed repeatedly.
+        MemoryPool& pool = m_Pools[block->poolKey];
+        if (pool.blocks.size() <= 1)
+            return;
+
+        for (auto it = pool.blocks.begin(); it != pool.blocks.end(); ++it)
+        {
+            if (it->get() == block)
+            {
+                if (block->mappedMemory)
+                    m_Context.device.unmapMemory(block->memory);
+
+                m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+                pool.blocks.erase(it);
+                break;
+            }
+        }
+    }
+
+    void* VulkanAllocator::getPersistentMapping(const MemoryResource* res)
+    {
+        if (!res->memoryBlock || !res->memoryBlock->mappedMemory)
+            return nullptr;
+
+        return static_cast<char*>(res->memoryBlock->mappedMemory) + res->memoryOffset;
+    }
+
+    MemoryAllocatorStats VulkanAllocator::getStats()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        MemoryAllocatorStats stats;
+        for (const auto& poolIter : m_Pools)
+        {
+            for (const auto& block : poolIter.second.blocks)
+            {
+                ++stats.blockCount;
+                stats.blockBytes += block->ranges.getSize();
+                stats.subAllocationCount += block->ranges.getAllocationCount();
+                stats.subAllocationBytes += block->ranges.getAllocatedBytes();
+            }
+        }
+
+        stats.dedicatedAllocationCount = m_DedicatedAllocationCount;
+        stats.dedicatedAllocationBytes = m_DedicatedAllocationBytes;
+
+        return stats;
     }
 
     vk::Result VulkanAllocator::allocateMemory(MemoryResource *res,
@@ -95,25 +418,16 @@ namespace nvrhi::vulkan
                                                 bool enableDeviceAddress,
                                                 bool enableExportMemory,
                                                 VkImage dedicatedImage,
-                                                VkBuffer dedicatedBuffer) const
+                                                VkBuffer dedicatedBuffer)
     {
         res->managed = true;
+        res->memoryBlock = nullptr;
+        res->memoryOffset = 0;
+        res->memorySize = memRequirements.size;
 
         // find a memory space that satisfies the requirements
-        vk::PhysicalDeviceMemoryProperties memProperties;
-        m_Context.physicalDevice.getMemoryProperties(&memProperties);
-
         uint32_t memTypeIndex;
-        for(memTypeIndex = 0; memTypeIndex < memProperties.memoryTypeCount; memTypeIndex++)
-        {
-            if ((memRequirements.memoryTypeBits & (1 << memTypeIndex)) &&
-                ((memProperties.memoryTypes[memTypeIndex].propertyFlags & memPropertyFlags) == memPropertyFlags))
-            {
-                break;
-            }
-        }
-
-        if (memTypeIndex == memProperties.memoryTypeCount)
+        if (!findMemoryType(memRequirements.memoryTypeBits, memPropertyFlags, memTypeIndex))
         {
             // xxxnsubtil: this is incorrect; need better error reporting
             return vk::Result::eErrorOutOfDeviceMemory;
@@ -151,20 +465,46 @@ namespace nvrhi::vulkan
             pNext = &exportInfo;
         }
 
+        auto priorityInfo = vk::MemoryPriorityAllocateInfoEXT()
+            .setPriority(convertResidencyPriority(res->residencyPriority))
+            .setPNext(pNext);
+
+        if (m_Context.memoryPriority)
+        {
+            // Append the VkMemoryPriorityAllocateInfoEXT structure to the chain
+            pNext = &priorityInfo;
+        }
+
         auto allocInfo = vk::MemoryAllocateInfo()
                             .setAllocationSize(memRequirements.size)
                             .setMemoryTypeIndex(memTypeIndex)
                             .setPNext(pNext);
 
-        return m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &res->memory);
+        const vk::Result result = m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &res->memory);
+
+        if (result == vk::Result::eSuccess)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            ++m_DedicatedAllocationCount;
+            m_DedicatedAllocationBytes += memRequirements.size;
+        }
+
+        return result;
     }
 
-    void VulkanAllocator::freeMemory(MemoryResource *res) const
+    void VulkanAllocator::freeMemory(MemoryResource *res)
     {
         assert(res->managed);
+        assert(!res->memoryBlock);
 
         m_Context.device.freeMemory(res->memory, m_Context.allocationCallbacks);
         res->memory = vk::DeviceMemory(nullptr);
+
+        std::lock_guard lockGuard(m_Mutex);
+        assert(m_DedicatedAllocationCount > 0);
+        --m_DedicatedAllocationCount;
+        m_DedicatedAllocationBytes -= res->memorySize;
+        res->memorySize = 0;
     }
 
 } // namespace nvrhi::vulkan
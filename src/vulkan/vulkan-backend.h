@@ -27,8 +27,21 @@
 #include <nvrhi/common/aftermath.h>
 #include "../common/state-tracking.h"
 #include "../common/versioning.h"
+#include "../common/accel-struct-stats.h"
+#include "../common/device-stats.h"
+#include "../common/profile-hooks.h"
+#include "../common/gpu-profiler.h"
+#include "../common/object-pool.h"
+#include "../common/binding-set-cache.h"
+#include "../common/framebuffer-cache.h"
+#include "../common/range-allocator.h"
+#include "../common/readback-ring.h"
+#include "../common/release-queue.h"
+#include "../common/resource-references.h"
 #include <mutex>
+#include <atomic>
 #include <list>
+#include <deque>
 
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
 #include <vulkan/vulkan.hpp>
@@ -75,6 +88,7 @@ namespace nvrhi::vulkan
     class BindingSet;
     class EvenetQuery;
     class TimerQuery;
+    class ReadbackTicket;
     class Marker;
     class Device;
 
@@ -142,6 +156,130 @@ namespace nvrhi::vulkan
     };
 #endif
 
+    struct VulkanContext;
+
+    // Compacted size of a BLAS that was built by a command buffer, written by the GPU into a BlasCompactionManager query
+    struct PendingCompactedSize
+    {
+        rt::AccelStructHandle accelStruct;
+        uint32_t query = 0;
+        rt::OpacityMicromapHandle opacityMicromap;
+    };
+
+    // Collects the compacted sizes of the BLASes and OMM arrays built with the AllowCompaction flag without RTXMU,
+    // and hands them out for compaction once their builds have finished executing. The sizes are written into
+    // query pools right after the builds, and read without waiting when the command buffers are retired.
+    class BlasCompactionManager
+    {
+    public:
+        BlasCompactionManager(const VulkanContext& context, uint64_t budget)
+            : m_Context(context)
+            , m_Budget(budget)
+            , m_Queries(c_MaxPendingSizes, false)
+        { }
+
+        ~BlasCompactionManager();
+
+        // Reserves a query for the compacted size of a BLAS or OMM array build,
+        // returns false if all queries are in use by builds that haven't finished yet
+        bool allocateQuery(bool opacityMicromap, vk::QueryPool& outPool, uint32_t& outQuery);
+
+        // Reads the sizes written by a finished command buffer, releases their queries,
+        // and queues the BLASes and OMM arrays that will get smaller for compaction
+        void buildsCompleted(std::vector<PendingCompactedSize>& builds);
+
+        // Releases the queries of builds recorded into a command buffer that was never submitted
+        void buildsDiscarded(std::vector<PendingCompactedSize>& builds);
+
+        // Takes the queued BLASes in the order they were built, until their total size exceeds the budget
+        void takeCandidates(std::vector<rt::AccelStructHandle>& outCandidates);
+
+        // Same as takeCandidates, for the queued OMM arrays
+        void takeOpacityMicromapCandidates(std::vector<rt::OpacityMicromapHandle>& outCandidates);
+
+        // Returns the number of queued BLASes and OMM arrays
+        size_t getNumPendingCompactions();
+
+    private:
+        static constexpr int c_MaxPendingSizes = 4096;
+
+        const VulkanContext& m_Context;
+        const uint64_t m_Budget;
+
+        std::mutex m_Mutex;
+        vk::QueryPool m_QueryPool;
+        vk::QueryPool m_MicromapQueryPool;
+        bool m_CreationFailed = false;
+        bool m_MicromapCreationFailed = false;
+        // The queries are allocated from one set of indices shared by both pools
+        utils::BitSetAllocator m_Queries;
+        std::deque<rt::AccelStructHandle> m_Candidates;
+        std::deque<rt::OpacityMicromapHandle> m_OpacityMicromapCandidates;
+    };
+
+    // A range of the descriptor buffer that holds the descriptors of one binding set or descriptor table
+    struct DescriptorBufferAllocation
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    // Holds the descriptors of all binding sets and descriptor tables when VK_EXT_descriptor_buffer is used.
+    // The buffer is persistently mapped, descriptors are written into it with vkGetDescriptorEXT, and the binding sets
+    // are bound by their offsets with vkCmdSetDescriptorBufferOffsetsEXT. Released ranges are reused once the GPU
+    // has finished all work that was submitted before their release.
+    class DescriptorBufferHeap
+    {
+    public:
+        DescriptorBufferHeap(const VulkanContext& context, const Device& device)
+            : m_Context(context)
+            , m_Device(device)
+            , m_Ranges(0)
+        { }
+
+        ~DescriptorBufferHeap();
+
+        vk::Result init(uint64_t size);
+
+        // Allocates a range aligned to descriptorBufferOffsetAlignment, returns false if the buffer is full
+        bool allocate(uint64_t size, DescriptorBufferAllocation& outAllocation);
+
+        // Returns a range that may still be used by the command lists that were submitted before the call
+        void release(const DescriptorBufferAllocation& allocation);
+
+        // Returns a range that is known not to be used by the GPU anymore, e.g. one used by a retired command buffer
+        void free(const DescriptorBufferAllocation& allocation);
+
+        [[nodiscard]] vk::Buffer getBuffer() const { return m_Buffer; }
+        [[nodiscard]] vk::DeviceAddress getDeviceAddress() const { return m_DeviceAddress; }
+        [[nodiscard]] uint8_t* getMappedMemory(uint64_t offset) const { return m_MappedMemory + offset; }
+
+        // In bytes, the released ranges that the GPU may still be using count as allocated
+        DescriptorHeapStats getStats();
+
+    private:
+        struct PendingRange
+        {
+            DescriptorBufferAllocation allocation;
+            std::array<uint64_t, uint32_t(CommandQueue::Count)> lastSubmittedIDs{};
+        };
+
+        const VulkanContext& m_Context;
+        const Device& m_Device;
+
+        vk::Buffer m_Buffer;
+        vk::DeviceMemory m_Memory;
+        vk::DeviceAddress m_DeviceAddress = 0;
+        uint8_t* m_MappedMemory = nullptr;
+
+        std::mutex m_Mutex;
+        RangeAllocator m_Ranges;
+        // Ranges that were released, in release order, and the GPU may still be using them
+        std::deque<PendingRange> m_PendingRanges;
+
+        void retirePendingRanges();
+    };
+
     // underlying vulkan context
     struct VulkanContext
     {
@@ -172,6 +310,7 @@ namespace nvrhi::vulkan
             bool KHR_ray_query = false;
             bool KHR_ray_tracing_pipeline = false;
             bool NV_mesh_shader = false;
+            bool EXT_mesh_shader = false;
             bool KHR_fragment_shading_rate = false;
             bool EXT_conservative_rasterization = false;
             bool EXT_opacity_micromap = false;
@@ -180,6 +319,19 @@ namespace nvrhi::vulkan
             bool EXT_mutable_descriptor_type = false;
             bool EXT_debug_utils = false;
             bool NV_cooperative_vector = false;
+            bool EXT_memory_budget = false;
+            bool EXT_memory_priority = false;
+            bool EXT_multi_draw = false;
+            bool EXT_device_generated_commands = false;
+            bool EXT_graphics_pipeline_library = false;
+            bool KHR_deferred_host_operations = false;
+            bool EXT_descriptor_buffer = false;
+            bool KHR_push_descriptor = false;
+            bool EXT_extended_dynamic_state = false;
+            bool EXT_extended_dynamic_state2 = false;
+            bool EXT_extended_dynamic_state3 = false;
+            bool EXT_vertex_input_dynamic_state = false;
+            bool EXT_calibrated_timestamps = false;
 #if NVRHI_WITH_AFTERMATH
             bool NV_device_diagnostic_checkpoints = false;
             bool NV_device_diagnostics_config= false;
@@ -194,18 +346,60 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceOpacityMicromapPropertiesEXT opacityMicromapProperties;
         vk::PhysicalDeviceRayTracingInvocationReorderPropertiesNV nvRayTracingInvocationReorderProperties;
         vk::PhysicalDeviceClusterAccelerationStructurePropertiesNV nvClusterAccelerationStructureProperties;
+        vk::PhysicalDeviceAccelerationStructureFeaturesKHR accelStructFeatures; // as enabled in DeviceDesc::enabledFeatures
         vk::PhysicalDeviceFragmentShadingRateFeaturesKHR shadingRateFeatures;
         vk::PhysicalDeviceCooperativeVectorFeaturesNV coopVecFeatures;
         vk::PhysicalDeviceCooperativeVectorPropertiesNV coopVecProperties;
         vk::PhysicalDeviceSubgroupProperties subgroupProperties;
+        vk::PhysicalDeviceMultiDrawPropertiesEXT multiDrawProperties;
+        vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties;
+        vk::PhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties;
+        vk::PhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures;
+        vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features;
+        vk::PhysicalDeviceExtendedDynamicState3PropertiesEXT extendedDynamicState3Properties;
+        vk::PhysicalDeviceDeviceGeneratedCommandsPropertiesEXT deviceGeneratedCommandsProperties;
+        vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT vertexInputDynamicStateFeatures;
         IMessageCallback* messageCallback = nullptr;
+        IParallelTaskRunner* parallelTaskRunner = nullptr;
         bool logBufferLifetime = false;
+        bool automaticQueueSync = false;
+        bool queueOwnershipTransfers = false; // also set with automaticQueueSync
+        // The vkCmdSet* functions of VK_EXT_extended_dynamic_state and _2 are available, from Vulkan 1.3 or the extensions
+        bool extendedDynamicState = false;
+        bool extendedDynamicState2 = false;
+        // DeviceDesc::enableDynamicPipelineState, and which optional parts of the state are dynamic in that mode
+        bool dynamicPipelineState = false;
+        bool dynamicBlendState = false;
+        bool dynamicPolygonMode = false;
+        bool dynamicConservativeRaster = false;
+        bool dynamicVertexInput = false;
+        // VkPhysicalDeviceFeatures::robustBufferAccess is enabled, which selects the robust buffer descriptor sizes
+        bool robustBufferAccess = false;
+        // VK_EXT_multi_draw is enabled with its multiDraw feature
+        bool multiDraw = false;
+        // VK_EXT_memory_priority is enabled with its memoryPriority feature
+        bool memoryPriority = false;
+        bool logAutomaticQueueSync = false;
+        bool deferredSubmission = false;
+        uint64_t uploadRingBufferSize = 0;
 #ifdef NVRHI_WITH_RTXMU
         std::unique_ptr<rtxmu::VkAccelStructManager> rtxMemUtil;
         std::unique_ptr<RtxMuResources> rtxMuResources;
+#else
+        std::unique_ptr<BlasCompactionManager> blasCompaction;
 #endif
+        std::unique_ptr<AccelStructStatsTracker> accelStructStats;
+        std::unique_ptr<DeviceStatsTracker> deviceStats; // must outlive all objects, not reset before the context
+        std::unique_ptr<GpuProfiler> profiler;
+        std::unique_ptr<DescriptorBufferHeap> descriptorBufferHeap; // only created with enableDescriptorBuffers
         vk::DescriptorSetLayout emptyDescriptorSetLayout;
 
+        // descriptor buffers replace descriptor sets in all pipelines and binding layouts, which must be created with the matching flags
+        [[nodiscard]] vk::PipelineCreateFlags getPipelineCreateFlags() const
+        {
+            return descriptorBufferHeap ? vk::PipelineCreateFlagBits::eDescriptorBufferEXT : vk::PipelineCreateFlags();
+        }
+
         void nameVKObject(const void* handle, const vk::ObjectType objtype,
             const vk::DebugReportObjectTypeEXT objtypeEXT, const char* name) const;
         void error(const std::string& message) const;
@@ -222,25 +416,75 @@ namespace nvrhi::vulkan
         vk::CommandBuffer cmdBuf = vk::CommandBuffer();
         vk::CommandPool cmdPool = vk::CommandPool();
 
-        std::vector<RefCountPtr<IResource>> referencedResources; // to keep them alive
+        ResourceReferenceList referencedResources; // to keep them alive
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers; // to allow synchronous mapBuffer
+        std::vector<RefCountPtr<ReadbackTicket>> referencedReadbacks; // to keep their memory reserved until the copies finish
+
+        // secondary command buffers executed inside this one, retired together with it
+        std::vector<std::shared_ptr<TrackedCommandBuffer>> secondaryCommandBuffers;
 
         uint64_t recordingID = 0;
         uint64_t submissionID = 0;
 
+        // set when the submission was reported to DeviceStatsTracker, with the number of references it holds
+        bool statsSubmitted = false;
+        size_t statsReferenceCount = 0;
+
 #ifdef NVRHI_WITH_RTXMU
         std::vector<uint64_t> rtxmuBuildIds;
         std::vector<uint64_t> rtxmuCompactionIds;
+#else
+        std::vector<PendingCompactedSize> pendingCompactedSizes;
 #endif
+        std::vector<TimerQueryHandle> accelStructTimerQueries;
+        ProfilerScopeList profilerScopes; // see GpuProfiler
+
+        // descriptor buffer mode: copies of the binding sets with volatile constant buffers, written at bind time,
+        // and the ranges of transient binding sets
+        std::vector<DescriptorBufferAllocation> transientDescriptors;
+        bool descriptorBufferBound = false;
+
+        // descriptor buffer mode: the block that the copies of binding sets with volatile constant buffers are linearly
+        // allocated from, which is also in transientDescriptors, and the last copy of every set with the constant
+        // buffer offsets it was written for, so that binding a set again without new versions doesn't copy it again
+        struct VolatileDescriptorCopy
+        {
+            uint64_t sourceOffset = 0;
+            uint64_t offset = 0;
+            std::vector<uint64_t> constantBufferOffsets;
+        };
+        DescriptorBufferAllocation volatileDescriptorBlock;
+        uint64_t volatileDescriptorBlockUsed = 0;
+        std::unordered_map<const BindingSet*, VolatileDescriptorCopy> volatileDescriptorCopies;
 
         explicit TrackedCommandBuffer(const VulkanContext& context)
             : m_Context(context)
         { }
 
         ~TrackedCommandBuffer();
+
+        // returns an unsignaled event for a split barrier, events are reused after the command buffer is retired
+        vk::Event getSplitBarrierEvent();
+        void resetSplitBarrierEvents();
+
+        // allocates the descriptor set of a transient binding set from pools owned by the command buffer
+        vk::DescriptorSet allocateTransientDescriptorSet(vk::DescriptorSetLayout layout);
+
+        // returns transientDescriptors to the descriptor buffer heap and resets the transient descriptor pools,
+        // called when the command buffer is retired
+        void releaseTransientDescriptors();
     
     private:
+        static constexpr uint32_t c_TransientDescriptorSetsPerPool = 256;
+        static constexpr uint32_t c_TransientDescriptorsPerType = 1024;
+
         const VulkanContext& m_Context;
+
+        std::vector<vk::Event> m_SplitBarrierEvents;
+        size_t m_NumSplitBarrierEventsUsed = 0;
+
+        std::vector<vk::DescriptorPool> m_TransientDescriptorPools;
+        size_t m_NumTransientDescriptorPoolsUsed = 0;
     };
 
     typedef std::shared_ptr<TrackedCommandBuffer> TrackedCommandBufferPtr;
@@ -255,20 +499,34 @@ namespace nvrhi::vulkan
         ~Queue();
 
         // creates a command buffer and its synchronization resources
-        TrackedCommandBufferPtr createCommandBuffer();
+        TrackedCommandBufferPtr createCommandBuffer(vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
 
-        TrackedCommandBufferPtr getOrCreateCommandBuffer();
+        TrackedCommandBufferPtr getOrCreateCommandBuffer(bool secondary = false);
 
         void addWaitSemaphore(vk::Semaphore semaphore, uint64_t value);
         void addSignalSemaphore(vk::Semaphore semaphore, uint64_t value);
 
         // submits a command buffer to this queue, returns submissionID
+        // with DeviceDesc::enableDeferredSubmission, the submission is only queued until the next flush
         uint64_t submit(ICommandList* const* ppCmd, size_t numCmd);
 
+        // submits all queued submissions in one call
+        void flush();
+        bool hasPendingSubmissions(uint64_t upToID) const { return upToID > m_LastFlushedID; }
+
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings);
 
-        // retire any command buffers that have finished execution from the pending execution list
-        void retireCommandBuffers();
+        // retire any command buffers that have finished execution from the pending execution list,
+        // their resource references are moved to 'deferredReleases' if it's not null and released otherwise
+        void retireCommandBuffers(ReleaseQueue* deferredReleases);
+
+        // returns the command buffer of a reusable command list that is recorded again or destroyed,
+        // it is recycled once its last submission has finished
+        void releaseReusableCommandBuffer(const TrackedCommandBufferPtr& cmdBuf);
+
+        // returns a primary or secondary command buffer that was recorded but never submitted to its pool,
+        // releasing everything it references
+        void recycleUnsubmittedCommandBuffer(const TrackedCommandBufferPtr& cmdBuf, bool secondary);
 
         TrackedCommandBufferPtr getCommandBufferInFlight(uint64_t submissionID);
 
@@ -277,6 +535,7 @@ namespace nvrhi::vulkan
         uint64_t getLastFinishedID() const { return m_LastFinishedID; }
         CommandQueue getQueueID() const { return m_QueueID; }
         vk::Queue getVkQueue() const { return m_Queue; }
+        uint32_t getQueueFamilyIndex() const { return m_QueueFamilyIndex; }
 
         bool pollCommandList(uint64_t commandListID);
         bool waitCommandList(uint64_t commandListID, uint64_t timeout);
@@ -294,46 +553,145 @@ namespace nvrhi::vulkan
         std::vector<vk::Semaphore> m_SignalSemaphores;
         std::vector<uint64_t> m_SignalSemaphoreValues;
 
+        // one batch of a vkQueueSubmit or vkQueueSubmit2 call
+        struct PendingSubmission
+        {
+            uint64_t submissionID = 0;
+            std::vector<vk::CommandBuffer> commandBuffers;
+            std::vector<vk::Semaphore> waitSemaphores;
+            std::vector<uint64_t> waitSemaphoreValues;
+            std::vector<vk::Semaphore> signalSemaphores;
+            std::vector<uint64_t> signalSemaphoreValues;
+        };
+
+        std::mutex m_SubmitMutex; // flushes can come from the threads that wait for the submissions
+        std::vector<PendingSubmission> m_PendingSubmissions;
+
+        void submitBatches(const PendingSubmission* batches, size_t numBatches);
+
         uint64_t m_LastRecordingID = 0;
         uint64_t m_LastSubmittedID = 0;
+        std::atomic<uint64_t> m_LastFlushedID = 0;
         uint64_t m_LastFinishedID = 0;
 
         // tracks the list of command buffers in flight on this queue
         std::list<TrackedCommandBufferPtr> m_CommandBuffersInFlight;
         std::list<TrackedCommandBufferPtr> m_CommandBuffersPool;
+        std::list<TrackedCommandBufferPtr> m_SecondaryCommandBuffersPool;
+
+        // reusable command lists keep their command buffers, the queue only keeps the command lists alive while in flight
+        std::list<std::pair<uint64_t, CommandListHandle>> m_ReusableCommandListsInFlight;
     };
 
+    struct MemoryBlock;
+
     class MemoryResource
     {
     public:
         bool managed = true;
         vk::DeviceMemory memory;
+
+        // Location of the resource inside 'memory' when it was sub-allocated from a shared block.
+        // For dedicated allocations, memoryBlock is null and memoryOffset is 0.
+        MemoryBlock* memoryBlock = nullptr;
+        vk::DeviceSize memoryOffset = 0;
+        vk::DeviceSize memorySize = 0;
+
+        // Applied to dedicated allocations when VK_EXT_memory_priority is enabled with its memoryPriority feature
+        ResidencyPriority residencyPriority = ResidencyPriority::Normal;
+    };
+
+    // A single VkDeviceMemory object that multiple resources are sub-allocated from.
+    struct MemoryBlock
+    {
+        vk::DeviceMemory memory;
+        uint32_t poolKey = 0;
+
+        // Host-visible blocks are mapped once at creation and stay mapped until the block is released,
+        // because Vulkan doesn't allow mapping the same VkDeviceMemory multiple times.
+        void* mappedMemory = nullptr;
+
+        RangeAllocator ranges;
+
+        explicit MemoryBlock(vk::DeviceSize size)
+            : ranges(size)
+        { }
     };
 
     class VulkanAllocator
     {
     public:
-        explicit VulkanAllocator(const VulkanContext& context)
-            : m_Context(context)
-        { }
+        explicit VulkanAllocator(const VulkanContext& context, uint64_t blockSize);
+        ~VulkanAllocator();
 
-        vk::Result allocateBufferMemory(Buffer* buffer, bool enableBufferAddress = false) const;
-        void freeBufferMemory(Buffer* buffer) const;
+        vk::Result allocateBufferMemory(Buffer* buffer, bool enableBufferAddress = false);
+        void freeBufferMemory(Buffer* buffer);
 
-        vk::Result allocateTextureMemory(Texture* texture) const;
-        void freeTextureMemory(Texture* texture) const;
+        vk::Result allocateTextureMemory(Texture* texture);
+        void freeTextureMemory(Texture* texture);
 
+        // Allocates a separate VkDeviceMemory object for the resource, used for heaps and dedicated allocations
         vk::Result allocateMemory(MemoryResource* res,
             vk::MemoryRequirements memRequirements,
             vk::MemoryPropertyFlags memPropertyFlags,
             bool enableDeviceAddress = false,
             bool enableExportMemory = false,
             VkImage dedicatedImage = nullptr,
-            VkBuffer dedicatedBuffer = nullptr) const;
-        void freeMemory(MemoryResource* res) const;
+            VkBuffer dedicatedBuffer = nullptr);
+        void freeMemory(MemoryResource* res);
+
+        // Returns a CPU pointer to the start of the resource memory if it was sub-allocated from a host-visible block
+        [[nodiscard]] static void* getPersistentMapping(const MemoryResource* res);
+
+        [[nodiscard]] MemoryAllocatorStats getStats();
+
+        // True if there is a large device-local host-visible memory heap, i.e. resizable BAR is enabled
+        [[nodiscard]] bool isDeviceLocalUploadSupported() const { return m_DeviceLocalUploadSupported; }
 
     private:
+        // Host-visible video memory heaps up to this size are the legacy 256 MB BAR window, too small for general use
+        static constexpr vk::DeviceSize c_MinDeviceLocalUploadHeapSize = 256 * 1024 * 1024;
+
+        // Resources smaller than this are rounded up to a power of 2 and placed into smaller blocks,
+        // which keeps the free ranges in those blocks uniform and easy to reuse.
+        static constexpr vk::DeviceSize c_SmallAllocationMaxSize = 256 * 1024;
+        static constexpr vk::DeviceSize c_SmallAllocationMinSize = 256;
+        static constexpr uint32_t c_SmallBlockDivisor = 8;
+
+        struct MemoryPool
+        {
+            std::vector<std::unique_ptr<MemoryBlock>> blocks;
+        };
+
         const VulkanContext& m_Context;
+        vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+        vk::DeviceSize m_BlockSize;
+        bool m_DeviceLocalUploadSupported = false;
+
+        std::mutex m_Mutex;
+        std::unordered_map<uint32_t, MemoryPool> m_Pools;
+        uint64_t m_DedicatedAllocationCount = 0;
+        uint64_t m_DedicatedAllocationBytes = 0;
+
+        [[nodiscard]] bool findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memPropertyFlags, uint32_t& outMemTypeIndex) const;
+
+        vk::Result subAllocateMemory(MemoryResource* res,
+            vk::MemoryRequirements memRequirements,
+            vk::MemoryPropertyFlags memPropertyFlags,
+            bool linearResource,
+            bool enableDeviceAddress);
+        void freeSubAllocatedMemory(MemoryResource* res);
+
+        // Allocates either from a shared block or as a separate allocation, whichever is suitable for the resource
+        vk::Result allocateResourceMemory(MemoryResource* res,
+            vk::MemoryRequirements memRequirements,
+            vk::MemoryPropertyFlags memPropertyFlags,
+            bool requiresDedicatedAllocation,
+            bool enableDeviceAddress,
+            bool enableExportMemory,
+            VkImage image,
+            VkBuffer buffer);
+        void freeResourceMemory(MemoryResource* res);
     };
 
     class Heap : public MemoryResource, public RefCounter<IHeap>
@@ -346,6 +704,7 @@ namespace nvrhi::vulkan
         ~Heap() override;
 
         HeapDesc desc;
+        DeviceStatsEntry statsEntry;
         
         const HeapDesc& getDesc() override { return desc; }
 
@@ -421,6 +780,7 @@ namespace nvrhi::vulkan
         HeapHandle heap;
 
         void* sharedHandle = nullptr;
+        DeviceStatsEntry statsEntry;
 
         // contains subresource views for this texture
         // note that we only create the views that the app uses, and that multiple views may map to the same subresources
@@ -447,9 +807,16 @@ namespace nvrhi::vulkan
         Object getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV = false) override;
 
     private:
+        // The views with the texture's own format and dimension, all array slices, and either all mip levels
+        // or mip 0, for every view type. They point into subresourceViews, whose nodes never move.
+        static constexpr size_t c_NumDefaultViewSubresources = 2;
+        static constexpr size_t c_NumDefaultViewTypes = 3;
+
         const VulkanContext& m_Context;
         VulkanAllocator& m_Allocator;
+        // Protects subresourceViews, the default views are published without it and read lock-free
         std::mutex m_Mutex;
+        std::atomic<TextureSubresourceView*> m_DefaultViews[c_NumDefaultViewTypes][c_NumDefaultViewSubresources] = {};
     };
 
     /* ----------------------------------------------------------------------------
@@ -518,6 +885,16 @@ namespace nvrhi::vulkan
     to the available state (tracking word == 0) if their command list is abandoned,
     but that is currently not implemented.
 
+    To keep the per-write cost constant, a command list doesn't search for a free
+    version on every write. Instead, it reserves a contiguous run of versions at once
+    and hands them out with a bump pointer. The run length is the number of versions
+    that the previous recording of the command list wrote into the buffer, minus those
+    written so far, so that the reservations don't exceed what the command list
+    actually uses when it records similar work every frame. It is at least 1 and at
+    most c_MaxVolatileVersionReservation or a quarter of maxVersions. Reserved versions
+    that were not written are returned to the available state when the command list
+    is closed.
+
     See also:
         - CommandList::writeVolatileBuffer
         - CommandList::flushVolatileBufferWrites
@@ -530,6 +907,11 @@ namespace nvrhi::vulkan
         int latestVersion = 0;
         int minVersion = 0;
         int maxVersion = 0;
+        // Versions [reservedBegin, reservedEnd) are pending in this command list but not written yet
+        uint32_t reservedBegin = 0;
+        uint32_t reservedEnd = 0;
+        // Number of versions written in this recording
+        uint32_t numWrites = 0;
         bool initialized = false;
     };
     
@@ -574,6 +956,8 @@ namespace nvrhi::vulkan
         CommandQueue lastUseQueue = CommandQueue::Graphics;
         uint64_t lastUseCommandListID = 0;
 
+        DeviceStatsEntry statsEntry;
+
         Buffer(const VulkanContext& context, VulkanAllocator& allocator)
             : BufferStateExtension(desc)
             , m_Context(context)
@@ -606,6 +990,7 @@ namespace nvrhi::vulkan
         // per-mip, per-slice regions
         // offset = mipLevel * numDepthSlices + depthSlice
         std::vector<StagingTextureRegion> sliceRegions;
+        DeviceStatsEntry statsEntry; // the memory is reported by the buffer
 
         size_t computeSliceSize(uint32_t mipLevel);
         const StagingTextureRegion& getSliceRegion(uint32_t mipLevel, uint32_t arraySlice, uint32_t z);
@@ -629,6 +1014,7 @@ namespace nvrhi::vulkan
 
         vk::SamplerCreateInfo samplerInfo;
         vk::Sampler sampler;
+        DeviceStatsEntry statsEntry;
 
         explicit Sampler(const VulkanContext& context)
             : m_Context(context)
@@ -691,16 +1077,21 @@ namespace nvrhi::vulkan
 
         std::vector<vk::VertexInputBindingDescription> bindingDesc;
         std::vector<vk::VertexInputAttributeDescription> attributeDesc;
+
+        // The same descriptions for vkCmdSetVertexInputEXT, only filled when VulkanContext::dynamicVertexInput is set
+        std::vector<vk::VertexInputBindingDescription2EXT> bindingDesc2;
+        std::vector<vk::VertexInputAttributeDescription2EXT> attributeDesc2;
         
         uint32_t getNumAttributes() const override;
         const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
     };
 
-    class EventQuery : public RefCounter<IEventQuery>
+    // Recycled through Device::m_EventQueryPool
+    class EventQuery : public PooledRefCounter<IEventQuery, EventQuery>
     {
     public:
-        CommandQueue queue = CommandQueue::Graphics;
-        uint64_t commandListID = 0;
+        SubmissionTicket ticket;
+        bool started = false;
     };
     
     class TimerQuery : public RefCounter<ITimerQuery>
@@ -729,19 +1120,76 @@ namespace nvrhi::vulkan
         FramebufferDesc desc;
         FramebufferInfoEx framebufferInfo;
         
+        // Attachments with the load ops from the desc, used when a render pass with this framebuffer begins
         static_vector<vk::RenderingAttachmentInfo, c_MaxRenderTargets> colorAttachments;
         vk::RenderingAttachmentInfo depthAttachment{};
         vk::RenderingAttachmentInfo stencilAttachment{};
+        // Attachments that load the current contents, used when a render pass with this framebuffer is resumed
+        static_vector<vk::RenderingAttachmentInfo, c_MaxRenderTargets> resumeColorAttachments;
+        vk::RenderingAttachmentInfo resumeDepthAttachment{};
+        vk::RenderingAttachmentInfo resumeStencilAttachment{};
         vk::RenderingFragmentShadingRateAttachmentInfoKHR shadingRateAttachment{};
 
+        bool loadsAllAttachments = true; // all attachments use AttachmentLoadOp::Load
+        bool discardsAnyAttachment = false; // some attachment uses AttachmentStoreOp::DontCare
+
         std::vector<ResourceHandle> resources;
 
         bool managed = true;
+        DeviceStatsEntry statsEntry;
 
         const FramebufferDesc& getDesc() const override { return desc; }
         const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
     };
 
+    // Allocates descriptor sets with one layout from a family of shared pools. Released sets are not freed but
+    // recycled for new binding sets, once the GPU has finished all work that was submitted before their release.
+    class DescriptorSetAllocator
+    {
+    public:
+        DescriptorSetAllocator(const VulkanContext& context, const Device& device)
+            : m_Context(context)
+            , m_Device(device)
+        { }
+
+        ~DescriptorSetAllocator();
+
+        void init(vk::DescriptorSetLayout layout, const std::vector<vk::DescriptorPoolSize>& poolSizes);
+
+        vk::Result allocate(vk::DescriptorSet& outSet, vk::DescriptorPool& outPool);
+        void release(vk::DescriptorSet set, vk::DescriptorPool pool);
+
+    private:
+        static constexpr uint32_t c_InitialPoolCapacity = 16;
+        static constexpr uint32_t c_MaxPoolCapacity = 1024;
+
+        struct RecycledSet
+        {
+            vk::DescriptorSet set;
+            vk::DescriptorPool pool;
+            std::array<uint64_t, uint32_t(CommandQueue::Count)> lastSubmittedIDs{};
+        };
+
+        const VulkanContext& m_Context;
+        const Device& m_Device;
+        vk::DescriptorSetLayout m_Layout;
+        std::vector<vk::DescriptorPoolSize> m_PoolSizes;
+
+        std::mutex m_Mutex;
+        std::vector<vk::DescriptorPool> m_Pools;
+        uint32_t m_PoolCapacity = 0; // total of all pools, reported to DeviceStatsTracker
+        uint32_t m_NextPoolCapacity = c_InitialPoolCapacity;
+        uint32_t m_SetsLeftInCurrentPool = 0;
+
+        // Sets that were released, in release order, and the GPU may still be using them
+        std::deque<RecycledSet> m_PendingSets;
+        // Sets that can be reused immediately
+        std::vector<RecycledSet> m_FreeSets;
+
+        void retirePendingSets();
+        vk::Result createPool();
+    };
+
     class BindingLayout : public RefCounter<IBindingLayout>
     {
     public:
@@ -756,8 +1204,20 @@ namespace nvrhi::vulkan
         // descriptor pool size information per binding set
         std::vector<vk::DescriptorPoolSize> descriptorPoolSizeInfo;
 
-        BindingLayout(const VulkanContext& context, const BindingLayoutDesc& desc);
-        BindingLayout(const VulkanContext& context, const BindlessLayoutDesc& desc);
+        // shared pools that the binding sets using this layout are allocated from
+        DescriptorSetAllocator descriptorSetAllocator;
+
+        // descriptor buffer mode: the size of the set and the placement of each binding within it
+        struct DescriptorBufferBinding
+        {
+            uint64_t offset = 0;
+            uint64_t stride = 0; // between the array elements
+        };
+        uint64_t descriptorBufferSize = 0;
+        std::unordered_map<uint32_t, DescriptorBufferBinding> descriptorBufferBindings;
+
+        BindingLayout(const VulkanContext& context, const Device& device, const BindingLayoutDesc& desc);
+        BindingLayout(const VulkanContext& context, const Device& device, const BindlessLayoutDesc& desc);
         ~BindingLayout() override;
         const BindingLayoutDesc* getDesc() const override { return isBindless ? nullptr : &desc; }
         const BindlessLayoutDesc* getBindlessDesc() const override { return isBindless ? &bindlessDesc : nullptr; }
@@ -777,15 +1237,25 @@ namespace nvrhi::vulkan
         BindingSetDesc desc;
         BindingLayoutHandle layout;
 
-        // TODO: move pool to the context instead
+        // the pool is shared with other binding sets and owned by the layout's descriptorSetAllocator
         vk::DescriptorPool descriptorPool;
         vk::DescriptorSet descriptorSet;
 
+        // used instead of descriptorSet in descriptor buffer mode
+        DescriptorBufferAllocation descriptorBufferRange;
+
         std::vector<ResourceHandle> resources;
         static_vector<Buffer*, c_MaxVolatileConstantBuffersPerLayout> volatileConstantBuffers;
+        // descriptor buffer mode: where the descriptors of volatileConstantBuffers go in the set, they are written at bind time
+        static_vector<uint64_t, c_MaxVolatileConstantBuffersPerLayout> volatileConstantBufferOffsets;
 
         std::vector<uint16_t> bindingsThatNeedTransitions;
 
+        // the descriptors are owned by a command buffer, see CommandList::createTransientBindingSet
+        bool isTransient = false;
+
+        DeviceStatsEntry statsEntry;
+
         explicit BindingSet(const VulkanContext& context)
             : m_Context(context)
         { }
@@ -808,6 +1278,11 @@ namespace nvrhi::vulkan
         vk::DescriptorPool descriptorPool;
         vk::DescriptorSet descriptorSet;
 
+        // used instead of descriptorSet in descriptor buffer mode
+        DescriptorBufferAllocation descriptorBufferRange;
+
+        DeviceStatsEntry statsEntry;
+
         explicit DescriptorTable(const VulkanContext& context)
             : m_Context(context)
         { }
@@ -837,6 +1312,22 @@ namespace nvrhi::vulkan
         VulkanContext const& context,
         BindingLayoutVector const& inBindingLayouts);
 
+    // A VkPipeline shared by the graphics pipelines created in the dynamic state mode, see DynamicStatePipelineCache
+    class SharedGraphicsPipeline
+    {
+    public:
+        vk::Pipeline pipeline;
+
+        explicit SharedGraphicsPipeline(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~SharedGraphicsPipeline();
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
     class GraphicsPipeline : public RefCounter<IGraphicsPipeline>
     {
     public:
@@ -847,14 +1338,29 @@ namespace nvrhi::vulkan
         BindingVector<uint32_t> descriptorSetIdxToBindingIdx;
         vk::PipelineLayout pipelineLayout;
         vk::Pipeline pipeline;
+        // When the pipeline is linked from graphics pipeline libraries, 'pipeline' is the fast-linked version,
+        // and the link-time optimized version is placed here by a background thread once it's ready.
+        std::atomic<VkPipeline> optimizedPipeline = VK_NULL_HANDLE;
         vk::ShaderStageFlags pushConstantVisibility;
         bool usesBlendConstants = false;
+        bool usesDynamicVertexStrides = false;
+        // Set when the pipeline was created in the dynamic state mode, in which case 'pipeline' belongs to sharedPipeline
+        bool usesDynamicPipelineState = false;
+        std::shared_ptr<SharedGraphicsPipeline> sharedPipeline;
+        DeviceStatsEntry statsEntry;
 
         explicit GraphicsPipeline(const VulkanContext& context)
             : m_Context(context)
         { }
 
         ~GraphicsPipeline() override;
+
+        // Returns the pipeline to bind: the optimized one if it's available
+        [[nodiscard]] vk::Pipeline getPipeline() const
+        {
+            const VkPipeline optimized = optimizedPipeline.load(std::memory_order_acquire);
+            return optimized ? vk::Pipeline(optimized) : pipeline;
+        }
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
         Object getNativeObject(ObjectType objectType) override;
@@ -863,6 +1369,121 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
+    // Creates graphics pipelines from VK_EXT_graphics_pipeline_library parts: the vertex input interface,
+    // pre-rasterization shaders, fragment shader and fragment output interface libraries are cached separately,
+    // so that a pipeline that only differs from the previous ones in some state subsets reuses the other libraries.
+    // The pipeline is fast-linked from the libraries right away, and the link-time optimized version is created
+    // on a background thread and replaces the fast-linked one in the command lists recorded after it's ready.
+    // The cached libraries keep their shaders, input layouts and binding layouts alive until the device is destroyed.
+    class GraphicsPipelineLibraryCache
+    {
+    public:
+        explicit GraphicsPipelineLibraryCache(const VulkanContext& context);
+        ~GraphicsPipelineLibraryCache();
+
+        // Creates pso->pipeline from the libraries for the state subsets of pipelineInfo, creating the missing libraries
+        vk::Result createPipeline(GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo);
+
+    private:
+        struct Library
+        {
+            vk::Pipeline pipeline;
+            vk::PipelineLayout pipelineLayout; // owned by the library, as the pipelines created from it can be released
+            static_vector<RefCountPtr<IResource>, c_MaxBindingLayouts + 5> references;
+        };
+
+        struct OptimizeJob
+        {
+            RefCountPtr<GraphicsPipeline> pso;
+            std::array<vk::Pipeline, 4> libraries;
+        };
+
+        const VulkanContext& m_Context;
+
+        std::mutex m_Mutex;
+        std::unordered_map<size_t, Library> m_Libraries;
+
+        std::condition_variable m_JobsAvailable;
+        std::deque<OptimizeJob> m_OptimizeJobs;
+        bool m_ShuttingDown = false;
+        std::thread m_OptimizeThread;
+
+        vk::Result getLibrary(size_t hash, vk::GraphicsPipelineLibraryFlagsEXT subset, const GraphicsPipeline* pso,
+            const vk::GraphicsPipelineCreateInfo& pipelineInfo, vk::Pipeline& outLibrary);
+        void optimizeThreadProc();
+    };
+
+    // Shares one VkPipeline between the graphics pipelines that only differ in the state which is dynamic
+    // with DeviceDesc::enableDynamicPipelineState. The pipelines are looked up by the remaining state,
+    // and a shared pipeline is destroyed together with the last GraphicsPipeline that uses it.
+    class DynamicStatePipelineCache
+    {
+    public:
+        explicit DynamicStatePipelineCache(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        // Sets pso->pipeline to a shared pipeline with the same static state, creating it from pipelineInfo if there's none
+        vk::Result createPipeline(GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo);
+
+    private:
+        const VulkanContext& m_Context;
+
+        // The parts of the pipeline state that are not dynamic. The shader, input layout and binding layout pointers
+        // stay valid while any pipeline that uses the shared one exists, because the pipelines reference them.
+        struct Key
+        {
+            std::array<IShader*, 5> shaders{};
+            static_vector<IBindingLayout*, c_MaxBindingLayouts> bindingLayouts;
+            FramebufferInfo framebufferInfo;
+            bool shadingRateEnabled = false;
+            uint32_t topologyClass = 0;
+            uint32_t patchControlPoints = 0;
+            IInputLayout* inputLayout = nullptr; // null with dynamic vertex input
+            BlendState blendState; // default with dynamic blend state
+            RasterFillMode fillMode = RasterFillMode::Solid;
+            bool conservativeRasterEnable = false;
+
+            [[nodiscard]] bool operator==(const Key& other) const;
+        };
+
+        struct Entry
+        {
+            Key key;
+            std::weak_ptr<SharedGraphicsPipeline> pipeline;
+        };
+
+        std::mutex m_Mutex;
+        std::unordered_multimap<size_t, Entry> m_Pipelines; // keyed by the hash of Entry::key
+
+        [[nodiscard]] Key getPipelineKey(const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo) const;
+        [[nodiscard]] static size_t getKeyHash(const Key& key);
+        // Returns the entry with the key, or null
+        Entry* findEntry(size_t hash, const Key& key);
+    };
+
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+        
+        // Keeps the pipeline layout referenced by the push constant tokens alive
+        GraphicsPipelineHandle pipeline;
+        vk::IndirectCommandsLayoutEXT layout;
+        vk::ShaderStageFlags shaderStages;
+
+        explicit CommandSignature(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~CommandSignature() override;
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override;
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
     class ComputePipeline : public RefCounter<IComputePipeline>
     {
     public:
@@ -873,6 +1494,7 @@ namespace nvrhi::vulkan
         vk::PipelineLayout pipelineLayout;
         vk::Pipeline pipeline;
         vk::ShaderStageFlags pushConstantVisibility;
+        DeviceStatsEntry statsEntry;
 
         explicit ComputePipeline(const VulkanContext& context)
             : m_Context(context)
@@ -886,6 +1508,19 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
+    // Emulates a work graph with one compute pipeline per node, all with the same pipeline layout,
+    // so that the descriptor sets bound for the first node stay valid for the others
+    class WorkGraphPipeline : public RefCounter<IWorkGraphPipeline>
+    {
+    public:
+        WorkGraphPipelineDesc desc;
+        std::vector<ComputePipelineHandle> nodePipelines;
+        DeviceStatsEntry statsEntry;
+
+        const WorkGraphPipelineDesc& getDesc() const override { return desc; }
+        WorkGraphMemoryRequirements getMemoryRequirements() const override;
+    };
+
     class MeshletPipeline : public RefCounter<IMeshletPipeline>
     {
     public:
@@ -898,6 +1533,7 @@ namespace nvrhi::vulkan
         vk::Pipeline pipeline;
         vk::ShaderStageFlags pushConstantVisibility;
         bool usesBlendConstants = false;
+        DeviceStatsEntry statsEntry;
 
         explicit MeshletPipeline(const VulkanContext& context)
             : m_Context(context)
@@ -924,6 +1560,7 @@ namespace nvrhi::vulkan
 
         std::unordered_map<std::string, uint32_t> shaderGroups; // name -> index
         std::vector<uint8_t> shaderGroupHandles;
+        DeviceStatsEntry statsEntry;
 
         explicit RayTracingPipeline(const VulkanContext& context)
             : m_Context(context)
@@ -932,6 +1569,7 @@ namespace nvrhi::vulkan
         ~RayTracingPipeline() override;
         const rt::PipelineDesc& getDesc() const override { return desc; }
         rt::ShaderTableHandle createShaderTable() override;
+        rt::ShaderTableHandle createShaderTable(const rt::ShaderTableDesc& desc) override;
         Object getNativeObject(ObjectType objectType) override;
 
         int findShaderGroup(const std::string& name); // returns -1 if not found
@@ -944,6 +1582,7 @@ namespace nvrhi::vulkan
     {
     public:
         RefCountPtr<RayTracingPipeline> pipeline;
+        rt::ShaderTableDesc desc;
 
         int rayGenerationShader = -1;
         std::vector<uint32_t> missShaders;
@@ -952,25 +1591,43 @@ namespace nvrhi::vulkan
 
         uint32_t version = 0;
 
-        ShaderTable(const VulkanContext& context, RayTracingPipeline* _pipeline)
+        // Persistent tables only: the device-local copy of the table
+        BufferHandle persistentBuffer;
+        // Records changed since the last upload, indexed in the order ray generation, miss, hit group, callable
+        std::vector<uint32_t> dirtyEntries;
+        bool allEntriesDirty = true;
+
+        ShaderTable(const VulkanContext& context, RayTracingPipeline* _pipeline, const rt::ShaderTableDesc& _desc)
             : pipeline(_pipeline)
+            , desc(_desc)
             , m_Context(context)
         { }
         
+        const rt::ShaderTableDesc& getDesc() const override { return desc; }
         void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setMissShader(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setHitGroup(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setCallableShader(int index, const char* exportName, IBindingSet* bindings = nullptr) override;
         void clearMissShaders() override;
         void clearHitShaders() override;
         void clearCallableShaders() override;
         rt::IPipeline* getPipeline() override { return pipeline; }
         uint32_t getNumEntries() const;
+        // Returns the shader group index of a record
+        uint32_t getEntry(uint32_t index) const;
+        void markAllEntriesDirty();
 
     private:
         const VulkanContext& m_Context;
 
         bool verifyShaderGroupExists(const char* exportName, int shaderGroupIndex) const;
+        int addEntry(std::vector<uint32_t>& entries, uint32_t firstEntry, const char* exportName, IBindingSet* bindings);
+        bool setEntry(std::vector<uint32_t>& entries, uint32_t firstEntry, int index, const char* exportName, IBindingSet* bindings);
+        void clearEntries(std::vector<uint32_t>& entries, uint32_t firstEntry);
+        void markEntryDirty(uint32_t index);
     };
 
     struct BufferChunk
@@ -980,6 +1637,7 @@ namespace nvrhi::vulkan
         uint64_t bufferSize = 0;
         uint64_t writePointer = 0;
         void* mappedMemory = nullptr;
+        DeviceStatsEntry statsEntry;
 
         static constexpr uint64_t c_sizeAlignment = 4096; // GPU page size
     };
@@ -987,11 +1645,14 @@ namespace nvrhi::vulkan
     class UploadManager
     {
     public:
-        UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+        UploadManager(Device* pParent, DeviceStatsTracker& stats, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer, uint64_t ringBufferSize = 0, bool isPreprocessBuffer = false)
             : m_Device(pParent)
+            , m_Stats(stats)
             , m_DefaultChunkSize(defaultChunkSize)
             , m_MemoryLimit(memoryLimit)
             , m_IsScratchBuffer(isScratchBuffer)
+            , m_IsPreprocessBuffer(isPreprocessBuffer)
+            , m_RingBufferSize(ringBufferSize)
         { }
 
         std::shared_ptr<BufferChunk> CreateChunk(uint64_t size);
@@ -1000,29 +1661,129 @@ namespace nvrhi::vulkan
         void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
 
     private:
+        // A contiguous part of the ring buffer used by one recording of the command list
+        struct RingRegion
+        {
+            uint64_t end = 0;
+            uint64_t version = 0;
+        };
+
         Device* m_Device;
+        DeviceStatsTracker& m_Stats;
         uint64_t m_DefaultChunkSize = 0;
         uint64_t m_MemoryLimit = 0;
         uint64_t m_AllocatedMemory = 0;
         bool m_IsScratchBuffer = false;
+        bool m_IsPreprocessBuffer = false; // scratch chunks usable as device-generated commands preprocess memory
 
         std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
+
+        // Ring buffer mode: allocations are taken from the head, whole regions are retired from the tail
+        uint64_t m_RingBufferSize = 0;
+        std::shared_ptr<BufferChunk> m_RingBuffer;
+        uint64_t m_RingHead = 0;
+        uint64_t m_RingTail = 0;
+        std::deque<RingRegion> m_RingRegions;
+
+        bool tryAllocateFromRing(uint64_t size, uint32_t alignment, uint64_t currentVersion, uint64_t* pOffset);
+        void retireRingRegions(uint64_t completedInstance);
+    };
+
+    class ReadbackPool;
+
+    class ReadbackTicket : public RefCounter<IReadbackTicket>
+    {
+    public:
+        uint32_t bufferIndex = 0;
+        uint64_t offset = 0;
+        const uint8_t* cpuAddress = nullptr;
+        size_t size = 0;
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+        ReadbackCallback callback;
+
+        explicit ReadbackTicket(ReadbackPool& pool)
+            : m_Pool(pool)
+        { }
+
+        ~ReadbackTicket() override;
+
+        // Called when the command list that recorded the readback is executed, other threads may be polling meanwhile
+        void setSubmission(Queue* queue, uint64_t submissionID);
+
+        bool isReady() override;
+        const void* getData() override { return isReady() ? cpuAddress : nullptr; }
+        size_t getSize() const override { return size; }
+        size_t getRowPitch() const override { return rowPitch; }
+        size_t getDepthPitch() const override { return depthPitch; }
+
+    private:
+        ReadbackPool& m_Pool;
+        // m_Queue is published after m_SubmissionID, so a non-null queue means that the ID is valid
+        std::atomic<Queue*> m_Queue = nullptr;
+        std::atomic<uint64_t> m_SubmissionID = 0;
+        std::atomic<bool> m_Ready = false;
+    };
+
+    // Device-wide pool of persistently mapped host-visible buffers that the asynchronous readbacks are
+    // suballocated from, see ReadbackRing. The buffers are kept for the lifetime of the device.
+    class ReadbackPool
+    {
+    public:
+        ReadbackPool(Device* pParent, uint64_t bufferSize)
+            : m_Device(pParent)
+            , m_BufferSize(bufferSize)
+        { }
+
+        // Creates a ticket with 'size' bytes of readback memory at an offset aligned to 'alignment',
+        // and returns its buffer in 'outBuffer'. Returns nullptr if the memory couldn't be allocated.
+        RefCountPtr<ReadbackTicket> allocate(uint64_t size, uint64_t alignment, Buffer** outBuffer);
+        void release(uint32_t bufferIndex, uint64_t offset);
+
+        // Makes the data of a finished readback visible to the host, as the memory may be host cached but not coherent
+        void invalidate(const ReadbackTicket& ticket);
+
+        // Queues the callback of a submitted ticket, runCallbacks(...) calls it once the ticket is ready
+        void addPendingCallback(ReadbackTicket* ticket);
+        void runCallbacks();
+
+    private:
+        struct ReadbackBuffer
+        {
+            BufferHandle buffer;
+            uint8_t* cpuAddress = nullptr;
+            ReadbackRing ring;
+
+            explicit ReadbackBuffer(uint64_t size) : ring(size) { }
+        };
+
+        Device* m_Device;
+        const uint64_t m_BufferSize;
+
+        std::mutex m_Mutex;
+        std::vector<std::unique_ptr<ReadbackBuffer>> m_Buffers;
+
+        std::mutex m_CallbackMutex;
+        std::vector<RefCountPtr<ReadbackTicket>> m_PendingCallbacks;
     };
 
     class AccelStruct : public RefCounter<rt::IAccelStruct>
     {
     public:
         BufferHandle dataBuffer;
-        std::vector<vk::AccelerationStructureInstanceKHR> instances;
+        size_t numBuiltInstances = 0; // TLAS only
+        // BLAS only, the last buildTopLevelAccelStruct that referenced this BLAS, used to find the unique BLASes quickly
+        std::atomic<uint64_t> lastInstanceConversion = 0;
         vk::AccelerationStructureKHR accelStruct;
         vk::DeviceAddress accelStructDeviceAddress = 0;
         rt::AccelStructDesc desc;
         bool allowUpdate = false;
         bool compacted = false;
+        uint64_t compactedSize = 0; // BLAS only, known after a build with AllowCompaction has finished executing
         size_t rtxmuId = ~0ull;
         vk::Buffer rtxmuBuffer;
-
+        AccelStructStatsEntry statsEntry;
 
         explicit AccelStruct(const VulkanContext& context)
             : m_Context(context)
@@ -1045,8 +1806,10 @@ namespace nvrhi::vulkan
         BufferHandle dataBuffer;
         vk::UniqueMicromapEXT opacityMicromap;
         rt::OpacityMicromapDesc desc;
+        uint64_t compactedSize = 0;
         bool allowUpdate = false;
         bool compacted = false;
+        AccelStructStatsEntry statsEntry;
 
         explicit OpacityMicromap()
         { }
@@ -1059,6 +1822,24 @@ namespace nvrhi::vulkan
         uint64_t getDeviceAddress() const override;
     };
 
+    // Reads the GPU profiler timestamps from the timer query pool
+    class ProfilerTimestampSource final : public IProfilerTimestampSource
+    {
+    public:
+        ProfilerTimestampSource(const VulkanContext& context, Device& device)
+            : m_Context(context)
+            , m_Device(device)
+        { }
+
+        bool readTimestamps(ITimerQuery* const* queries, size_t numQueries, uint64_t* outTimestamps) override;
+        uint64_t getTimestampFrequency(CommandQueue queue) override;
+        bool calibrateTimestamps(CommandQueue queue, uint64_t& outGpuTimestamp, int64_t& outCpuTimeNs) override;
+
+    private:
+        const VulkanContext& m_Context;
+        Device& m_Device;
+    };
+
     class Device : public RefCounter<nvrhi::vulkan::IDevice>
     {
     public:
@@ -1069,6 +1850,11 @@ namespace nvrhi::vulkan
 
         Queue* getQueue(CommandQueue queue) const { return m_Queues[int(queue)].get(); }
         vk::QueryPool getTimerQueryPool() const { return m_TimerQueryPool; }
+        ReadbackPool& getReadbackPool() { return m_ReadbackPool; }
+        const VulkanContext& getContext() const { return m_Context; }
+
+        // Creates a buffer that can also be used as preprocess memory for device-generated commands
+        BufferHandle createPreprocessBuffer(const BufferDesc& desc);
 
         // IResource implementation
 
@@ -1117,6 +1903,10 @@ namespace nvrhi::vulkan
         bool pollEventQuery(IEventQuery* query) override;
         void waitEventQuery(IEventQuery* query) override;
         void resetEventQuery(IEventQuery* query) override;
+        SubmissionTicket getSubmissionTicket(CommandQueue queue) override;
+        bool pollSubmission(const SubmissionTicket& ticket) override;
+        bool waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
+        bool waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds) override;
 
         // timer queries
         TimerQueryHandle createTimerQuery() override;
@@ -1137,8 +1927,10 @@ namespace nvrhi::vulkan
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
 
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        WorkGraphPipelineHandle createWorkGraphPipeline(const WorkGraphPipelineDesc& desc) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* pipeline) override;
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -1158,10 +1950,19 @@ namespace nvrhi::vulkan
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void flushSubmissions() override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        void runGarbageCollection(uint32_t maxReleaseMicroseconds) override;
+        void evictCachedFramebuffers(ITexture* texture) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
+        MemoryAllocatorStats getMemoryAllocatorStats() override;
+        MemoryBudget getMemoryBudget() override;
+        AccelStructStats getAccelStructStats() override;
+        DeviceStats getDeviceStats() override;
+        bool getProfilerFrameResults(ProfilerFrameResults& outResults) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& data) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
@@ -1187,12 +1988,46 @@ namespace nvrhi::vulkan
         vk::QueryPool m_TimerQueryPool = nullptr;
         utils::BitSetAllocator m_TimerQueryAllocator;
 
+        std::shared_ptr<ObjectPool<EventQuery>> m_EventQueryPool = std::make_shared<ObjectPool<EventQuery>>();
+
+        // Declared before the queues, so that the tickets held by the command buffers in flight are released first
+        ReadbackPool m_ReadbackPool;
+
         std::mutex m_Mutex;
 
         // array of submission queues
         std::array<std::unique_ptr<Queue>, uint32_t(CommandQueue::Count)> m_Queues;
+
+        // Resources of retired command lists that budgeted garbage collection has not released yet
+        ReleaseQueue m_ReleaseQueue;
+
+        std::mutex m_QueueSyncMutex;
+        QueueDependencies m_QueueDependencies; // used locally in executeCommandLists, member to avoid re-allocations
+
+        std::unique_ptr<GraphicsPipelineLibraryCache> m_PipelineLibraryCache; // only created with enableGraphicsPipelineLibrary
+        std::unique_ptr<DynamicStatePipelineCache> m_DynamicStatePipelineCache; // only created with enableDynamicPipelineState
+        std::unique_ptr<BindingSetCache> m_BindingSetCache; // only created with enableBindingSetCache
+        std::unique_ptr<FramebufferCache> m_FramebufferCache; // only created with enableFramebufferCache
+        ProfilerTimestampSource m_ProfilerTimestamps { m_Context, *this };
         
+        void addAutomaticQueueSync(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue, CommandListHandle& prologueCommandList);
+        void collectGarbage(bool releaseAll, uint32_t maxReleaseMicroseconds);
+        bool waitForSubmissions(const SubmissionTicket* tickets, size_t numTickets, bool waitAll, uint64_t timeoutNanoseconds);
+
         void *mapBuffer(IBuffer* b, CpuAccessMode flags, uint64_t offset, size_t size) const;
+        BufferHandle createBufferInternal(const BufferDesc& desc, bool isPreprocessBuffer);
+        // transientOwner is the command buffer that owns the descriptors of transient binding sets
+        BindingSetHandle createBindingSetInternal(const BindingSetDesc& desc, IBindingLayout* layout, TrackedCommandBuffer* transientOwner = nullptr);
+        FramebufferHandle createFramebufferInternal(const FramebufferDesc& desc);
+        BindingSetHandle createBindingSetInDescriptorBuffer(const BindingSetDesc& desc, BindingLayout* layout, TrackedCommandBuffer* transientOwner);
+    };
+
+    struct QueueOwnershipTransfer
+    {
+        Texture* texture = nullptr;
+        Buffer* buffer = nullptr;
+        uint32_t srcQueueFamilyIndex = 0;
+        uint32_t dstQueueFamilyIndex = 0;
     };
 
     class CommandList : public RefCounter<ICommandList>
@@ -1213,6 +2048,8 @@ namespace nvrhi::vulkan
 
         void open() override;
         void close() override;
+        void openSecondary(IFramebuffer* framebuffer, const ViewportState& viewport) override;
+        void executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists) override;
         void clearState() override;
 
         void clearTextureFloat(ITexture* texture, TextureSubresourceSet subresources, const Color& clearColor) override;
@@ -1229,17 +2066,30 @@ namespace nvrhi::vulkan
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        MappedWriteRegion beginWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
+        MappedWriteRegion beginWriteBuffer(IBuffer* b, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        void commitWrite() override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        ReadbackTicketHandle readbackBuffer(IBuffer* b, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback) override;
+        ReadbackTicketHandle readbackTexture(ITexture* texture, const TextureSlice& slice, ReadbackCallback callback) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
+        void setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings) override;
+        BindingSetHandle createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
+        void drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
+        void drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirectCount(uint32_t offsetBytes, IBuffer* countBuffer, uint32_t countBufferOffset, uint32_t maxDrawCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -1247,16 +2097,27 @@ namespace nvrhi::vulkan
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount) override;
+
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const WorkGraphDispatchArguments& args) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
         
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset,
+            nvrhi::IBuffer* argsBuffer, uint64_t argsBufferOffset, size_t maxInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
@@ -1282,6 +2143,9 @@ namespace nvrhi::vulkan
 
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, ResourceStates nextState) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates nextState) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
 
         void commitBarriers() override;
 
@@ -1290,14 +2154,22 @@ namespace nvrhi::vulkan
 
         IDevice* getDevice() override { return m_Device; }
         const CommandListParameters& getDesc() override { return m_CommandListParameters; }
+        CommandListStats getStats() override;
 
         TrackedCommandBufferPtr getCurrentCmdBuf() const { return m_CurrentCmdBuf; }
+        const std::vector<TextureStateExtension*>& getTexturesRequiringInitialState() const { return m_StateTracker.getTexturesRequiringInitialState(); }
+        CommandListResourceStateTracker& getStateTracker() { return m_StateTracker; }
+
+        // Records the release (on the source queue) or acquire (on the destination queue) half of queue family
+        // ownership transfers. The resources keep the layouts they were left in on the source queue.
+        void queueOwnershipTransferBarriers(const std::vector<QueueOwnershipTransfer>& transfers, bool release);
 
     private:
         Device* m_Device;
         const VulkanContext& m_Context;
 
         CommandListParameters m_CommandListParameters;
+        CommandListStats m_Stats;
 
         CommandListResourceStateTracker m_StateTracker;
         bool m_EnableAutomaticBarriers = true;
@@ -1311,12 +2183,29 @@ namespace nvrhi::vulkan
 
         vk::PipelineLayout m_CurrentPipelineLayout;
         vk::ShaderStageFlags m_CurrentPushConstantsVisibility;
+        vk::Pipeline m_CurrentGraphicsPipeline; // the bound version of the graphics pipeline, see GraphicsPipeline::getPipeline
         GraphicsState m_CurrentGraphicsState{};
         ComputeState m_CurrentComputeState{};
         MeshletState m_CurrentMeshletState{};
         rt::State m_CurrentRayTracingState;
+        WorkGraphState m_CurrentWorkGraphState;
+        std::vector<bool> m_WorkGraphNodesReached; // used locally in dispatchGraph, member to avoid re-allocations
         bool m_AnyVolatileBufferWrites = false;
 
+        // The state set with vkCmdSet* for the graphics pipelines created in the dynamic state mode,
+        // not valid after a pipeline with static state is bound
+        struct DynamicPipelineState
+        {
+            bool valid = false;
+            PrimitiveType primType = PrimitiveType::TriangleList;
+            RasterState rasterState;
+            DepthStencilState depthStencilState;
+            BlendState blendState;
+            uint32_t numColorTargets = 0;
+            IInputLayout* inputLayout = nullptr;
+        };
+        DynamicPipelineState m_CurrentDynamicPipelineState;
+
         struct ShaderTableState
         {
             vk::StridedDeviceAddressRegionKHR rayGen;
@@ -1327,34 +2216,107 @@ namespace nvrhi::vulkan
         } m_CurrentShaderTablePointers;
 
         std::unordered_map<Buffer*, VolatileBufferState> m_VolatileBufferStates;
+        // Versions written into each volatile buffer by the previous recording, which sizes the reservations
+        std::unordered_map<Buffer*, uint32_t> m_PreviousVolatileBufferWrites;
+
+        // Events of the split barriers that have begun but not ended yet, keyed by the texture or buffer state extension
+        std::unordered_map<const void*, vk::Event> m_SplitBarrierEvents;
+
+        // Destination and upload memory of the write started by beginWriteTexture or beginWriteBuffer
+        struct PendingWrite
+        {
+            TextureHandle texture;
+            BufferHandle buffer;
+            Buffer* uploadBuffer = nullptr;
+            uint64_t uploadOffset = 0;
+            uint64_t destOffset = 0;
+            size_t size = 0;
+            vk::BufferImageCopy imageCopy;
+            std::vector<uint8_t> volatileData; // volatile buffers are versioned by writeVolatileBuffer on commit
+        } m_PendingWrite;
 
         std::unique_ptr<UploadManager> m_UploadManager;
         std::unique_ptr<UploadManager> m_ScratchManager;
+        std::unique_ptr<UploadManager> m_PreprocessManager; // only created with VK_EXT_device_generated_commands
+
+        // Framebuffer of the render pass that a secondary command list is recorded for
+        FramebufferHandle m_SecondaryFramebuffer;
+
+        // Framebuffer of the render pass instance being recorded, and of the last one that was begun. A render pass
+        // that begins with the same framebuffer as the last one resumes it and loads the attachment contents.
+        Framebuffer* m_RenderPassFramebuffer = nullptr;
+        Framebuffer* m_LastRenderPassFramebuffer = nullptr;
+
+        // Secondary command lists executed in the current recording, they are submitted together with this one
+        std::vector<RefCountPtr<CommandList>> m_ExecutedSecondaryCommandLists;
+
+        // Latest submission of a reusable command list, which keeps its command buffer and upload memory until re-opened
+        uint64_t m_LastSubmissionID = 0;
+
+        // Scratch arrays for translating drawBatch arguments into vkCmdDrawMulti*EXT parameters
+        std::vector<vk::MultiDrawInfoEXT> m_MultiDrawInfos;
+        std::vector<vk::MultiDrawIndexedInfoEXT> m_MultiDrawIndexedInfos;
+
+        // Set while a build call is timed, so that the build calls it makes are not timed again
+        bool m_AccelStructBuildTimingActive = false;
+
+        ProfilerScopeRecorder m_ProfilerScopes;
+        bool m_ProfilingEnabled = false; // GPU profiler enabled and usable with this command list type
         
         void clearTexture(ITexture* texture, TextureSubresourceSet subresources, const vk::ClearColorValue& clearValue);
 
         void bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx);
+        void bindDescriptorBufferOffsets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx);
+        uint64_t getVolatileConstantBufferOffset(Buffer* constantBuffer);
+        bool allocateVolatileDescriptorCopy(uint64_t size, uint64_t& outOffset);
 
-        void beginRenderPass(nvrhi::IFramebuffer* framebuffer);
+        void beginRenderPass(nvrhi::IFramebuffer* framebuffer, vk::RenderingFlags flags = vk::RenderingFlags());
+        void setViewportState(const ViewportState& viewport, const ViewportState& currentViewport);
+        void setDynamicPipelineState(const GraphicsPipeline* pso);
         void endRenderPass();
+        // Makes the framebuffer current for draws: continues the open render pass when possible, ends it
+        // and begins a new one otherwise. Commits the pending barriers, which always ends the render pass.
+        void prepareRenderPass(Framebuffer* framebuffer);
 
         void trackResourcesAndBarriers(const GraphicsState& state);
         void trackResourcesAndBarriers(const MeshletState& state);
         
         void writeVolatileBuffer(Buffer* buffer, const void* data, size_t dataSize);
+        bool reserveVolatileBufferVersions(Buffer* buffer, VolatileBufferState& state);
+        void releaseVolatileBufferReservations();
         void flushVolatileBufferWrites();
         void submitVolatileBuffers(uint64_t recordingID, uint64_t submittedID);
+        void releaseReusableRecording();
+        void releaseUnsubmittedRecording();
 
         void updateGraphicsVolatileBuffers();
+        bool canUseMultiDraw(const DrawArguments* args, size_t count, const void* pushConstants) const;
+        void commitGraphicsStateBarriers();
         void updateComputeVolatileBuffers();
         void updateMeshletVolatileBuffers();
         void updateRayTracingVolatileBuffers();
+        void workGraphBackingMemoryBarrier(Buffer* backingMemory, vk::PipelineStageFlags srcStages, vk::AccessFlags srcAccess);
+        bool updatePersistentShaderTable(ShaderTable* shaderTable);
 
         void requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state);
         void requireBufferState(IBuffer* buffer, ResourceStates state);
         bool anyBarriers() const;
 
-        void buildTopLevelAccelStructInternal(AccelStruct* as, VkDeviceAddress instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags, uint64_t currentVersion);
+        // Starts timing an acceleration structure or OMM build call, see AccelStructStatsTracker
+        ScopedAccelStructBuildTimer timeAccelStructBuild();
+
+        void buildTopLevelAccelStructInternal(AccelStruct* as, VkDeviceAddress instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags, uint64_t currentVersion, VkDeviceAddress indirectArgs = 0);
+
+        // Converted geometries of one BLAS build, they must stay alive until the build is recorded
+        struct BlasBuildGeometries
+        {
+            std::vector<vk::AccelerationStructureGeometryKHR> geometries;
+            std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
+            std::vector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges;
+            std::vector<uint32_t> maxPrimitiveCounts;
+        };
+
+        void convertBlasBuildGeometries(const rt::GeometryDesc* pGeometries, size_t numGeometries, uint64_t currentVersion, BlasBuildGeometries& out);
 
         void commitBarriersInternal();
         void commitBarriersInternal_synchronization2();
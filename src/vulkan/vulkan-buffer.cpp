@@ -29,6 +29,16 @@ namespace nvrhi::vulkan
 {
 
     BufferHandle Device::createBuffer(const BufferDesc& desc)
+    {
+        return createBufferInternal(desc, false);
+    }
+
+    BufferHandle Device::createPreprocessBuffer(const BufferDesc& desc)
+    {
+        return createBufferInternal(desc, true);
+    }
+
+    BufferHandle Device::createBufferInternal(const BufferDesc& desc, bool isPreprocessBuffer)
     {
         // Check some basic constraints first - the validation layer is expected to handle them too
 
@@ -44,6 +54,7 @@ namespace nvrhi::vulkan
 
         Buffer *buffer = new Buffer(m_Context, m_Allocator);
         buffer->desc = desc;
+        buffer->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::Buffer, desc.byteSize);
 
         vk::BufferUsageFlags usageFlags = vk::BufferUsageFlagBits::eTransferSrc |
                                           vk::BufferUsageFlagBits::eTransferDst;
@@ -126,6 +137,16 @@ namespace nvrhi::vulkan
         if (desc.sharedResourceFlags == SharedResourceFlags::Shared)
             bufferInfo.setPNext(&externalBuffer);
 
+        // The preprocess usage only exists in the 64-bit usage flags, which replace the legacy usage when chained
+        vk::BufferUsageFlags2CreateInfoKHR usageFlags2;
+        if (isPreprocessBuffer)
+        {
+            usageFlags2.usage = vk::BufferUsageFlags2KHR(VkBufferUsageFlags2KHR(VkBufferUsageFlags(usageFlags)))
+                | vk::BufferUsageFlagBits2KHR::ePreprocessBufferEXT;
+            usageFlags2.pNext = bufferInfo.pNext;
+            bufferInfo.setPNext(&usageFlags2);
+        }
+
         vk::Result res = m_Context.device.createBuffer(&bufferInfo, m_Context.allocationCallbacks, &buffer->buffer);
         CHECK_VK_FAIL(res);
 
@@ -136,7 +157,9 @@ namespace nvrhi::vulkan
             res = m_Allocator.allocateBufferMemory(buffer, (usageFlags & vk::BufferUsageFlagBits::eShaderDeviceAddress) != vk::BufferUsageFlags(0));
             CHECK_VK_FAIL(res)
 
-            m_Context.nameVKObject(buffer->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
+            // Shared memory blocks contain multiple resources, so only name dedicated allocations
+            if (!buffer->memoryBlock)
+                m_Context.nameVKObject(buffer->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
 
             if (desc.isVolatile)
             {
@@ -211,6 +234,7 @@ namespace nvrhi::vulkan
         buffer->buffer = VkBuffer(_buffer.integer);
         buffer->desc = desc;
         buffer->managed = false;
+        buffer->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::Buffer, desc.byteSize);
         
         if (m_Context.extensions.buffer_device_address)
         {
@@ -237,12 +261,12 @@ namespace nvrhi::vulkan
         if (dest->desc.cpuAccess != CpuAccessMode::None)
             m_CurrentCmdBuf->referencedStagingBuffers.push_back(dest);
         else
-            m_CurrentCmdBuf->referencedResources.push_back(dest);
+            m_CurrentCmdBuf->referencedResources.add(dest);
 
         if (src->desc.cpuAccess != CpuAccessMode::None)
             m_CurrentCmdBuf->referencedStagingBuffers.push_back(src);
         else
-            m_CurrentCmdBuf->referencedResources.push_back(src);
+            m_CurrentCmdBuf->referencedResources.add(src);
 
         if (m_EnableAutomaticBarriers)
         {
@@ -267,17 +291,12 @@ namespace nvrhi::vulkan
         return 0;
     }
 
-    void CommandList::writeVolatileBuffer(Buffer* buffer, const void* data, size_t dataSize)
-    {
-        VolatileBufferState& state = m_VolatileBufferStates[buffer];
+    // Upper limit on the number of versions that a command list reserves in one go,
+    // see the comment above VolatileBufferState in vulkan-backend.h
+    static constexpr uint32_t c_MaxVolatileVersionReservation = 64;
 
-        if (!state.initialized)
-        {
-            state.minVersion = int(buffer->desc.maxVersions);
-            state.maxVersion = -1;
-            state.initialized = true;
-        }
-        
+    bool CommandList::reserveVolatileBufferVersions(Buffer* buffer, VolatileBufferState& state)
+    {
         std::array<uint64_t, uint32_t(CommandQueue::Count)> queueCompletionValues = {
             getQueueLastFinishedID(m_Device, CommandQueue::Graphics),
             getQueueLastFinishedID(m_Device, CommandQueue::Compute),
@@ -354,7 +373,7 @@ namespace nvrhi::vulkan
                     " has maxVersions = " << buffer->desc.maxVersions << ", which is insufficient.";
 
                 m_Context.error(ss.str());
-                return;
+                return false;
             }
 
             // Encode the current CL ID for this version of the buffer, in a "pending" state
@@ -365,7 +384,63 @@ namespace nvrhi::vulkan
                 break;
         }
 
-        buffer->versionSearchStart = (version + 1 < maxVersions) ? (version + 1) : 0;
+        // Try to extend the reservation with the versions that follow the one we just claimed.
+        // Stop at the first version that is unavailable, or at the end of the buffer, to keep the run contiguous.
+        uint32_t reservationLimit = 1;
+        auto previousWrites = m_PreviousVolatileBufferWrites.find(buffer);
+        if (previousWrites != m_PreviousVolatileBufferWrites.end() && previousWrites->second > state.numWrites)
+            reservationLimit = previousWrites->second - state.numWrites;
+        reservationLimit = std::min(std::min(reservationLimit, c_MaxVolatileVersionReservation), std::max(maxVersions / 4, 1u));
+        uint32_t reservedEnd = version + 1;
+
+        while (reservedEnd < maxVersions && reservedEnd - version < reservationLimit)
+        {
+            uint64_t versionInfo = buffer->versionTracking[reservedEnd];
+
+            bool available = versionInfo == 0;
+            if (!available && (versionInfo & c_VersionSubmittedFlag) != 0)
+            {
+                uint32_t queueIndex = uint32_t(versionInfo >> c_VersionQueueShift) & c_VersionQueueMask;
+                uint64_t id = versionInfo & c_VersionIDMask;
+                available = queueIndex < uint32_t(CommandQueue::Count) && id <= queueCompletionValues[queueIndex];
+            }
+
+            uint64_t newVersionInfo = (uint64_t(m_CommandListParameters.queueType) << c_VersionQueueShift) | (m_CurrentCmdBuf->recordingID);
+
+            if (!available || !buffer->versionTracking[reservedEnd].compare_exchange_strong(versionInfo, newVersionInfo))
+                break;
+
+            ++reservedEnd;
+        }
+
+        buffer->versionSearchStart = (reservedEnd < maxVersions) ? reservedEnd : 0;
+
+        state.reservedBegin = version;
+        state.reservedEnd = reservedEnd;
+
+        return true;
+    }
+
+    void CommandList::writeVolatileBuffer(Buffer* buffer, const void* data, size_t dataSize)
+    {
+        VolatileBufferState& state = m_VolatileBufferStates[buffer];
+
+        if (!state.initialized)
+        {
+            state.minVersion = int(buffer->desc.maxVersions);
+            state.maxVersion = -1;
+            state.initialized = true;
+        }
+
+        // Take the next version from this command list's reservation, only search the buffer when it runs out
+        if (state.reservedBegin >= state.reservedEnd)
+        {
+            if (!reserveVolatileBufferVersions(buffer, state))
+                return;
+        }
+
+        uint32_t version = state.reservedBegin++;
+        ++state.numWrites;
 
         // Store the current version and expand the version range in this CL
         state.latestVersion = int(version);
@@ -379,6 +454,34 @@ namespace nvrhi::vulkan
         m_AnyVolatileBufferWrites = true;
     }
 
+    void CommandList::releaseVolatileBufferReservations()
+    {
+        // Return the versions that were reserved by this command list but never written to the available state,
+        // so that other command lists can use them while this one is in flight.
+
+        // Also remember how many versions were written, only for the buffers used in this recording.
+
+        uint64_t pendingState = (uint64_t(m_CommandListParameters.queueType) << c_VersionQueueShift) | (m_CurrentCmdBuf->recordingID & c_VersionIDMask);
+
+        m_PreviousVolatileBufferWrites.clear();
+
+        for (auto& iter : m_VolatileBufferStates)
+        {
+            Buffer* buffer = iter.first;
+            VolatileBufferState& state = iter.second;
+
+            m_PreviousVolatileBufferWrites[buffer] = state.numWrites;
+
+            for (uint32_t version = state.reservedBegin; version < state.reservedEnd; version++)
+            {
+                uint64_t expected = pendingState;
+                buffer->versionTracking[version].compare_exchange_strong(expected, 0);
+            }
+
+            state.reservedBegin = state.reservedEnd = 0;
+        }
+    }
+
     void CommandList::flushVolatileBufferWrites()
     {
         // The volatile CBs are permanently mapped with the eHostVisible flag, but not eHostCoherent,
@@ -450,12 +553,15 @@ namespace nvrhi::vulkan
 
         endRenderPass();
 
-        m_CurrentCmdBuf->referencedResources.push_back(buffer);
+        m_CurrentCmdBuf->referencedResources.add(buffer);
+
+        m_Stats.uploadBytes += dataSize;
 
         if (buffer->desc.isVolatile)
         {
             assert(destOffsetBytes == 0);
 
+            ++m_Stats.volatileBufferWrites;
             writeVolatileBuffer(buffer, data, dataSize);
             
             return;
@@ -500,6 +606,51 @@ namespace nvrhi::vulkan
         }
     }
 
+    MappedWriteRegion CommandList::beginWriteBuffer(IBuffer* _buffer, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        assert(dataSize <= buffer->desc.byteSize);
+
+        assert(m_CurrentCmdBuf);
+
+        MappedWriteRegion region;
+
+        m_Stats.uploadBytes += dataSize;
+
+        if (buffer->desc.isVolatile)
+        {
+            assert(destOffsetBytes == 0);
+
+            ++m_Stats.volatileBufferWrites;
+
+            // The version of a volatile buffer is only selected when the write is committed
+            m_PendingWrite.volatileData.resize(dataSize);
+            region.data = m_PendingWrite.volatileData.data();
+        }
+        else if (buffer->desc.cpuAccess != CpuAccessMode::Write)
+        {
+            if (!m_UploadManager->suballocateBuffer(dataSize, &m_PendingWrite.uploadBuffer, &m_PendingWrite.uploadOffset, &region.data,
+                MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false)))
+            {
+                m_Context.error("Couldn't suballocate an upload buffer");
+                return MappedWriteRegion();
+            }
+        }
+        else
+        {
+            m_Context.error("Using beginWriteBuffer on mappable buffers is invalid");
+            return MappedWriteRegion();
+        }
+
+        m_PendingWrite.buffer = buffer;
+        m_PendingWrite.destOffset = destOffsetBytes;
+        m_PendingWrite.size = dataSize;
+
+        region.size = dataSize;
+        return region;
+    }
+
     void CommandList::clearBufferUInt(IBuffer* b, uint32_t clearValue)
     {
         Buffer* vkbuf = checked_cast<Buffer*>(b);
@@ -515,7 +666,7 @@ namespace nvrhi::vulkan
         commitBarriers();
 
         m_CurrentCmdBuf->cmdBuf.fillBuffer(vkbuf->buffer, 0, vkbuf->desc.byteSize, clearValue);
-        m_CurrentCmdBuf->referencedResources.push_back(b);
+        m_CurrentCmdBuf->referencedResources.add(b);
     }
 
     Buffer::~Buffer()
@@ -604,6 +755,10 @@ namespace nvrhi::vulkan
         // TODO: there should be a barrier... But there can't be a command list here
         // buffer->barrier(cmd, vk::PipelineStageFlagBits::eHost, accessFlags);
 
+        // Sub-allocated buffers live in blocks that are mapped for their entire lifetime
+        if (void* persistentMapping = VulkanAllocator::getPersistentMapping(buffer))
+            return static_cast<char*>(persistentMapping) + offset;
+
         void* ptr = nullptr;
         [[maybe_unused]] const vk::Result res = m_Context.device.mapMemory(buffer->memory, offset, size, vk::MemoryMapFlags(), &ptr);
         assert(res == vk::Result::eSuccess);
@@ -622,7 +777,8 @@ namespace nvrhi::vulkan
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_Context.device.unmapMemory(buffer->memory);
+        if (!buffer->memoryBlock)
+            m_Context.device.unmapMemory(buffer->memory);
 
         // TODO: there should be a barrier
         // buffer->barrier(cmd, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
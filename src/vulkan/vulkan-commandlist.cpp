@@ -30,17 +30,37 @@ namespace nvrhi::vulkan
         , m_Context(context)
         , m_CommandListParameters(parameters)
         , m_StateTracker(context.messageCallback)
-        , m_UploadManager(std::make_unique<UploadManager>(device, parameters.uploadChunkSize, 0, false))
-        , m_ScratchManager(std::make_unique<UploadManager>(device, parameters.scratchChunkSize, parameters.scratchMaxMemory, true))
+        // Reusable command lists keep their upload memory until re-opened, which would stall the ring
+        , m_UploadManager(std::make_unique<UploadManager>(device, *context.deviceStats, parameters.uploadChunkSize, 0, false,
+            parameters.isReusable ? 0 : context.uploadRingBufferSize))
+        , m_ScratchManager(std::make_unique<UploadManager>(device, *context.deviceStats, parameters.scratchChunkSize, parameters.scratchMaxMemory, true))
+        , m_PreprocessManager(context.extensions.EXT_device_generated_commands
+            ? std::make_unique<UploadManager>(device, *context.deviceStats, parameters.scratchChunkSize, parameters.scratchMaxMemory, true, 0, true)
+            : nullptr)
     {
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
 #endif
+
+        m_StateTracker.setReusable(parameters.isReusable);
+
+        // Timestamps are not supported on all transfer queue families
+        m_ProfilingEnabled = context.profiler->isEnabled() && !parameters.isSecondary && !parameters.isReusable
+            && parameters.queueType != CommandQueue::Copy;
     }
 
     CommandList::~CommandList()
     {
+        if (m_CommandListParameters.isReusable)
+            releaseReusableRecording();
+        else
+            releaseUnsubmittedRecording(); // secondary command lists that were closed but never executed
+
+        // Command lists kept alive by the queues are destroyed after the profiler
+        if (m_ProfilingEnabled && m_Context.profiler)
+            m_ProfilerScopes.discard(*m_Context.profiler, m_Device);
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().unRegisterAftermathMarkerTracker(&m_AftermathTracker);
@@ -60,19 +80,60 @@ namespace nvrhi::vulkan
 
     void CommandList::open()
     {
+        if (m_CommandListParameters.isSecondary)
+        {
+            m_Context.error("Secondary command lists must be opened with openSecondary");
+            return;
+        }
+
+        if (m_CommandListParameters.isReusable)
+        {
+            releaseReusableRecording();
+            m_StateTracker.reset();
+        }
+        else
+        {
+            releaseUnsubmittedRecording();
+        }
+
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.discard(*m_Context.profiler, m_Device);
+
+        m_Stats = CommandListStats();
+        m_StateTracker.resetBarrierCounts();
+
         m_CurrentCmdBuf = m_Device->getQueue(m_CommandListParameters.queueType)->getOrCreateCommandBuffer();
 
+        // Reusable command buffers may be submitted again while a previous submission is still pending
         auto beginInfo = vk::CommandBufferBeginInfo()
-            .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+            .setFlags(m_CommandListParameters.isReusable
+                ? vk::CommandBufferUsageFlagBits::eSimultaneousUse
+                : vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 
         (void)m_CurrentCmdBuf->cmdBuf.begin(&beginInfo);
-        m_CurrentCmdBuf->referencedResources.push_back(this); // prevent deletion of e.g. UploadManager
+
+        // The queue keeps reusable command lists alive while they are in flight, a reference from their own
+        // command buffer would never be released
+        if (!m_CommandListParameters.isReusable)
+            m_CurrentCmdBuf->referencedResources.add(this); // prevent deletion of e.g. UploadManager
 
         clearState();
+        m_LastRenderPassFramebuffer = nullptr;
+    }
+
+    CommandListStats CommandList::getStats()
+    {
+        CommandListStats stats = m_Stats;
+        stats.barriersIssued = m_StateTracker.getIssuedBarrierCount();
+        stats.barriersElided = m_StateTracker.getElidedBarrierCount();
+        return stats;
     }
 
     void CommandList::close()
     {
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.endAllScopes(this);
+
         endRenderPass();
 
         m_StateTracker.keepBufferInitialStates();
@@ -90,6 +151,7 @@ namespace nvrhi::vulkan
 
         clearState();
 
+        releaseVolatileBufferReservations();
         flushVolatileBufferWrites();
     }
 
@@ -99,12 +161,15 @@ namespace nvrhi::vulkan
 
         m_CurrentPipelineLayout = vk::PipelineLayout();
         m_CurrentPushConstantsVisibility = vk::ShaderStageFlagBits();
+        m_CurrentGraphicsPipeline = vk::Pipeline();
 
         m_CurrentGraphicsState = GraphicsState();
         m_CurrentComputeState = ComputeState();
         m_CurrentMeshletState = MeshletState();
         m_CurrentRayTracingState = rt::State();
+        m_CurrentWorkGraphState = WorkGraphState();
         m_CurrentShaderTablePointers = ShaderTableState();
+        m_CurrentDynamicPipelineState.valid = false;
 
         m_AnyVolatileBufferWrites = false;
 
@@ -122,13 +187,53 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
+        if (m_CommandListParameters.isReusable)
+        {
+            // Everything recorded stays valid for the next submission, only the state tracker needs to know.
+            // The upload chunks and volatile buffer versions are handed back in releaseReusableRecording.
+            m_CurrentCmdBuf->submissionID = submissionID;
+            m_LastSubmissionID = submissionID;
+            m_StateTracker.commandListSubmitted();
+            // Retired by the queue when the submission finishes, the command buffer keeps its references
+            m_Context.deviceStats->commandListSubmitted(getStats(), 0);
+            return;
+        }
+
         m_CurrentCmdBuf->submissionID = submissionID;
 
+        // Secondary command buffers are retired with the primary one
+        if (!m_CommandListParameters.isSecondary)
+        {
+            m_CurrentCmdBuf->statsSubmitted = true;
+            m_CurrentCmdBuf->statsReferenceCount = m_CurrentCmdBuf->referencedResources.size();
+            m_Context.deviceStats->commandListSubmitted(getStats(), m_CurrentCmdBuf->statsReferenceCount);
+        }
+
+        for (const auto& ticket : m_CurrentCmdBuf->referencedReadbacks)
+        {
+            ticket->setSubmission(&queue, submissionID);
+
+            if (ticket->callback)
+                m_Device->getReadbackPool().addPendingCallback(ticket);
+        }
+
         const CommandQueue queueID = queue.getQueueID();
         const uint64_t recordingID = m_CurrentCmdBuf->recordingID;
 
+        if (m_ProfilingEnabled)
+        {
+            m_CurrentCmdBuf->profilerScopes = m_ProfilerScopes.takeScopes();
+            m_Context.profiler->scopesSubmitted(m_CurrentCmdBuf->profilerScopes, queueID);
+        }
+
         m_CurrentCmdBuf = nullptr;
 
+        for (const auto& secondary : m_ExecutedSecondaryCommandLists)
+        {
+            secondary->executed(queue, submissionID);
+        }
+        m_ExecutedSecondaryCommandLists.clear();
+
         submitVolatileBuffers(recordingID, submissionID);
 
         m_StateTracker.commandListSubmitted();
@@ -141,8 +246,84 @@ namespace nvrhi::vulkan
             MakeVersion(recordingID, queueID, false),
             MakeVersion(submissionID, queueID, true));
 
+        if (m_PreprocessManager)
+        {
+            m_PreprocessManager->submitChunks(
+                MakeVersion(recordingID, queueID, false),
+                MakeVersion(submissionID, queueID, true));
+        }
+
         m_VolatileBufferStates.clear();
     }
+
+    void CommandList::releaseUnsubmittedRecording()
+    {
+        // A command buffer that is still current when the command list is opened again was closed but never
+        // executed, so the GPU never reads its uploads. Submission ID 0 makes them available immediately,
+        // otherwise the upload ring would stop at the unsubmitted region forever.
+        if (!m_CurrentCmdBuf)
+            return;
+
+        const CommandQueue queueID = m_CommandListParameters.queueType;
+        const uint64_t recordingID = m_CurrentCmdBuf->recordingID;
+
+        submitVolatileBuffers(recordingID, 0);
+
+        m_UploadManager->submitChunks(
+            MakeVersion(recordingID, queueID, false),
+            MakeVersion(0, queueID, true));
+
+        m_ScratchManager->submitChunks(
+            MakeVersion(recordingID, queueID, false),
+            MakeVersion(0, queueID, true));
+
+        if (m_PreprocessManager)
+        {
+            m_PreprocessManager->submitChunks(
+                MakeVersion(recordingID, queueID, false),
+                MakeVersion(0, queueID, true));
+        }
+
+        m_VolatileBufferStates.clear();
+        m_ExecutedSecondaryCommandLists.clear();
+
+        m_Device->getQueue(queueID)->recycleUnsubmittedCommandBuffer(m_CurrentCmdBuf, m_CommandListParameters.isSecondary);
+        m_CurrentCmdBuf = nullptr;
+    }
+
+    void CommandList::releaseReusableRecording()
+    {
+        if (!m_CurrentCmdBuf)
+            return;
+
+        // If the recording was never submitted, submission ID 0 makes everything available immediately
+        const CommandQueue queueID = m_CommandListParameters.queueType;
+        const uint64_t recordingID = m_CurrentCmdBuf->recordingID;
+
+        submitVolatileBuffers(recordingID, m_LastSubmissionID);
+
+        m_UploadManager->submitChunks(
+            MakeVersion(recordingID, queueID, false),
+            MakeVersion(m_LastSubmissionID, queueID, true));
+
+        m_ScratchManager->submitChunks(
+            MakeVersion(recordingID, queueID, false),
+            MakeVersion(m_LastSubmissionID, queueID, true));
+
+        if (m_PreprocessManager)
+        {
+            m_PreprocessManager->submitChunks(
+                MakeVersion(recordingID, queueID, false),
+                MakeVersion(m_LastSubmissionID, queueID, true));
+        }
+
+        m_VolatileBufferStates.clear();
+
+        m_CurrentCmdBuf->submissionID = m_LastSubmissionID;
+        m_Device->getQueue(queueID)->releaseReusableCommandBuffer(m_CurrentCmdBuf);
+        m_CurrentCmdBuf = nullptr;
+        m_LastSubmissionID = 0;
+    }
  
     void CommandList::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
     {
@@ -27,12 +27,15 @@ namespace nvrhi::vulkan
 {
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::createComputePipeline");
+
         vk::Result res;
 
         assert(desc.CS);
         
         ComputePipeline *pso = new ComputePipeline(m_Context);
         pso->desc = desc;
+        pso->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::ComputePipeline);
 
         res = createPipelineLayout(
             pso->pipelineLayout,
@@ -68,6 +71,7 @@ namespace nvrhi::vulkan
             specInfos, specMapEntries, specData);
         
         auto pipelineInfo = vk::ComputePipelineCreateInfo()
+                                .setFlags(m_Context.getPipelineCreateFlags())
                                 .setStage(shaderStageInfo)
                                 .setLayout(pso->pipelineLayout);
 
@@ -136,8 +140,9 @@ namespace nvrhi::vulkan
         if (m_CurrentComputeState.pipeline != state.pipeline)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, pso->pipeline);
+            ++m_Stats.pipelineBinds;
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
+            m_CurrentCmdBuf->referencedResources.add(state.pipeline);
         }
 
         if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
@@ -152,7 +157,7 @@ namespace nvrhi::vulkan
         {
             Buffer* indirectParams = checked_cast<Buffer*>(state.indirectParams);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            m_CurrentCmdBuf->referencedResources.add(state.indirectParams);
 
             if (m_EnableAutomaticBarriers)
             {
@@ -166,6 +171,7 @@ namespace nvrhi::vulkan
         m_CurrentComputeState = state;
         m_CurrentMeshletState = MeshletState();
         m_CurrentRayTracingState = rt::State();
+        m_CurrentWorkGraphState = WorkGraphState();
         m_AnyVolatileBufferWrites = false;
     }
 
@@ -186,6 +192,7 @@ namespace nvrhi::vulkan
         assert(m_CurrentCmdBuf);
 
         updateComputeVolatileBuffers();
+        ++m_Stats.dispatches;
 
         m_CurrentCmdBuf->cmdBuf.dispatch(groupsX, groupsY, groupsZ);
     }
@@ -195,6 +202,7 @@ namespace nvrhi::vulkan
         assert(m_CurrentCmdBuf);
 
         updateComputeVolatileBuffers();
+        ++m_Stats.dispatches;
 
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentComputeState.indirectParams);
         assert(indirectParams);
@@ -223,6 +223,7 @@ namespace nvrhi::vulkan
             // The below stages are exclustive to synchronization2
             assert((stageFlags & vk::PipelineStageFlagBits2::eMicromapBuildEXT) != vk::PipelineStageFlagBits2::eMicromapBuildEXT);
             assert((accessMask & vk::AccessFlagBits2::eMicromapWriteEXT) != vk::AccessFlagBits2::eMicromapWriteEXT);
+            assert((accessMask & vk::AccessFlagBits2::eMicromapReadEXT) != vk::AccessFlagBits2::eMicromapReadEXT);
             return
                 ResourceStateMapping(nvrhiState,
                     reinterpret_cast<const vk::PipelineStageFlags&>(stageFlags),
@@ -329,7 +330,7 @@ namespace nvrhi::vulkan
             vk::ImageLayout::eUndefined },
         { ResourceStates::OpacityMicromapBuildInput,
             vk::PipelineStageFlagBits2::eMicromapBuildEXT,
-            vk::AccessFlagBits2::eShaderRead,
+            vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eMicromapReadEXT,
             vk::ImageLayout::eUndefined },
         { ResourceStates::ConvertCoopVecMatrixInput,
             vk::PipelineStageFlagBits2::eConvertCooperativeVectorMatrixNV,
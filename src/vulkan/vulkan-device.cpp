@@ -23,6 +23,8 @@
 #include "vulkan-backend.h"
 #include <unordered_map>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
 
 #include <nvrhi/common/misc.h>
 
@@ -49,11 +51,46 @@ namespace nvrhi::vulkan
         Device* device = new Device(desc);
         return DeviceHandle::Create(device);
     }
-        
+
+    // Finds a feature structure in the chain that the application passed to vkCreateDevice, see DeviceDesc::enabledFeatures
+    template<typename T>
+    static const T* findEnabledFeatures(const void* chain)
+    {
+        for (auto item = static_cast<const vk::BaseInStructure*>(chain); item; item = item->pNext)
+        {
+            if (item->sType == T::structureType)
+                return reinterpret_cast<const T*>(item);
+        }
+        return nullptr;
+    }
+
+    // Checks the header of the pipeline cache data against the device to avoid passing foreign data to the driver,
+    // which is allowed by the spec but not handled gracefully by all drivers.
+    static bool isPipelineCacheDataCompatible(const void* data, size_t dataSize, const vk::PhysicalDeviceProperties& properties)
+    {
+        if (dataSize < sizeof(VkPipelineCacheHeaderVersionOne))
+            return false;
+
+        VkPipelineCacheHeaderVersionOne header;
+        memcpy(&header, data, sizeof(header));
+
+        if (header.headerSize < sizeof(VkPipelineCacheHeaderVersionOne) || header.headerSize > dataSize)
+            return false;
+
+        if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+            return false;
+
+        if (header.vendorID != properties.vendorID || header.deviceID != properties.deviceID)
+            return false;
+
+        return memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+    }
+
     Device::Device(const DeviceDesc& desc)
         : m_Context(desc.instance, desc.physicalDevice, desc.device, reinterpret_cast<vk::AllocationCallbacks*>(desc.allocationCallbacks))
-        , m_Allocator(m_Context)
+        , m_Allocator(m_Context, desc.memoryBlockSize)
         , m_TimerQueryAllocator(desc.maxTimerQueries, true)
+        , m_ReadbackPool(this, desc.readbackBufferSize)
     {
         if (desc.graphicsQueue)
         {
@@ -88,10 +125,24 @@ namespace nvrhi::vulkan
             { VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, &m_Context.extensions.KHR_ray_tracing_pipeline },
             { VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, &m_Context.extensions.KHR_synchronization2 },
             { VK_NV_MESH_SHADER_EXTENSION_NAME, &m_Context.extensions.NV_mesh_shader },
+            { VK_EXT_MESH_SHADER_EXTENSION_NAME, &m_Context.extensions.EXT_mesh_shader },
             { VK_NV_RAY_TRACING_INVOCATION_REORDER_EXTENSION_NAME, &m_Context.extensions.NV_ray_tracing_invocation_reorder },
             { VK_NV_CLUSTER_ACCELERATION_STRUCTURE_EXTENSION_NAME, &m_Context.extensions.NV_cluster_acceleration_structure },
             { VK_EXT_MUTABLE_DESCRIPTOR_TYPE_EXTENSION_NAME, &m_Context.extensions.EXT_mutable_descriptor_type },
             { VK_NV_COOPERATIVE_VECTOR_EXTENSION_NAME, &m_Context.extensions.NV_cooperative_vector },
+            { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, &m_Context.extensions.EXT_memory_budget },
+            { VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME, &m_Context.extensions.EXT_memory_priority },
+            { VK_EXT_MULTI_DRAW_EXTENSION_NAME, &m_Context.extensions.EXT_multi_draw },
+            { VK_EXT_DEVICE_GENERATED_COMMANDS_EXTENSION_NAME, &m_Context.extensions.EXT_device_generated_commands },
+            { VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, &m_Context.extensions.EXT_graphics_pipeline_library },
+            { VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME, &m_Context.extensions.KHR_deferred_host_operations },
+            { VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME, &m_Context.extensions.EXT_descriptor_buffer },
+            { VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, &m_Context.extensions.KHR_push_descriptor },
+            { VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME, &m_Context.extensions.EXT_extended_dynamic_state },
+            { VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME, &m_Context.extensions.EXT_extended_dynamic_state2 },
+            { VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME, &m_Context.extensions.EXT_extended_dynamic_state3 },
+            { VK_EXT_VERTEX_INPUT_DYNAMIC_STATE_EXTENSION_NAME, &m_Context.extensions.EXT_vertex_input_dynamic_state },
+            { VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME, &m_Context.extensions.EXT_calibrated_timestamps },
 #if NVRHI_WITH_AFTERMATH
             { VK_NV_DEVICE_DIAGNOSTIC_CHECKPOINTS_EXTENSION_NAME, &m_Context.extensions.NV_device_diagnostic_checkpoints },
             { VK_NV_DEVICE_DIAGNOSTICS_CONFIG_EXTENSION_NAME, &m_Context.extensions.NV_device_diagnostics_config }
@@ -131,6 +182,11 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceClusterAccelerationStructurePropertiesNV nvClusterAccelerationStructureProperties;
         vk::PhysicalDeviceCooperativeVectorPropertiesNV nvCoopVecProperties;
         vk::PhysicalDeviceSubgroupProperties subgroupProperties;
+        vk::PhysicalDeviceMultiDrawPropertiesEXT multiDrawProperties;
+        vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties;
+        vk::PhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties;
+        vk::PhysicalDeviceExtendedDynamicState3PropertiesEXT extendedDynamicState3Properties;
+        vk::PhysicalDeviceDeviceGeneratedCommandsPropertiesEXT deviceGeneratedCommandsProperties;
         
         vk::PhysicalDeviceProperties2 deviceProperties2;
 
@@ -186,6 +242,36 @@ namespace nvrhi::vulkan
             pNext = &nvCoopVecProperties;
         }
 
+        if (m_Context.extensions.EXT_multi_draw)
+        {
+            multiDrawProperties.pNext = pNext;
+            pNext = &multiDrawProperties;
+        }
+
+        if (m_Context.extensions.EXT_graphics_pipeline_library)
+        {
+            graphicsPipelineLibraryProperties.pNext = pNext;
+            pNext = &graphicsPipelineLibraryProperties;
+        }
+
+        if (m_Context.extensions.EXT_descriptor_buffer)
+        {
+            descriptorBufferProperties.pNext = pNext;
+            pNext = &descriptorBufferProperties;
+        }
+
+        if (m_Context.extensions.EXT_extended_dynamic_state3)
+        {
+            extendedDynamicState3Properties.pNext = pNext;
+            pNext = &extendedDynamicState3Properties;
+        }
+
+        if (m_Context.extensions.EXT_device_generated_commands)
+        {
+            deviceGeneratedCommandsProperties.pNext = pNext;
+            pNext = &deviceGeneratedCommandsProperties;
+        }
+
         deviceProperties2.pNext = pNext;
 
         m_Context.physicalDevice.getProperties2(&deviceProperties2);
@@ -200,8 +286,19 @@ namespace nvrhi::vulkan
         m_Context.subgroupProperties = subgroupProperties;
         m_Context.nvClusterAccelerationStructureProperties = nvClusterAccelerationStructureProperties;
         m_Context.coopVecProperties = nvCoopVecProperties;
+        m_Context.multiDrawProperties = multiDrawProperties;
+        m_Context.graphicsPipelineLibraryProperties = graphicsPipelineLibraryProperties;
+        m_Context.descriptorBufferProperties = descriptorBufferProperties;
+        m_Context.extendedDynamicState3Properties = extendedDynamicState3Properties;
+        m_Context.deviceGeneratedCommandsProperties = deviceGeneratedCommandsProperties;
         m_Context.messageCallback = desc.errorCB;
+        m_Context.parallelTaskRunner = desc.parallelTaskRunner;
         m_Context.logBufferLifetime = desc.logBufferLifetime;
+        m_Context.automaticQueueSync = desc.enableAutomaticQueueSync;
+        m_Context.queueOwnershipTransfers = desc.enableAutomaticQueueSync || desc.enableQueueOwnershipTransfers;
+        m_Context.logAutomaticQueueSync = desc.logAutomaticQueueSync;
+        m_Context.deferredSubmission = desc.enableDeferredSubmission;
+        m_Context.uploadRingBufferSize = desc.uploadRingBufferSize;
 
         if (m_Context.extensions.EXT_opacity_micromap && !m_Context.extensions.KHR_synchronization2)
         {
@@ -209,6 +306,17 @@ namespace nvrhi::vulkan
                 "EXT_opacity_micromap is used without KHR_synchronization2 which is nessesary for OMM Array state transitions. Feature::RayTracingOpacityMicromap will be disabled.");
         }
 
+        // The optional acceleration structure features, such as indirect builds, must be enabled to be used,
+        // so they are taken from the application's chain rather than from what the device supports
+        if (m_Context.extensions.KHR_acceleration_structure)
+        {
+            if (const auto* features = findEnabledFeatures<vk::PhysicalDeviceAccelerationStructureFeaturesKHR>(desc.enabledFeatures))
+            {
+                m_Context.accelStructFeatures = *features;
+                m_Context.accelStructFeatures.pNext = nullptr;
+            }
+        }
+
         if (m_Context.extensions.KHR_fragment_shading_rate)
         {
             vk::PhysicalDeviceFeatures2 deviceFeatures2;
@@ -222,6 +330,81 @@ namespace nvrhi::vulkan
             deviceFeatures2.setPNext(&m_Context.coopVecFeatures);
             m_Context.physicalDevice.getFeatures2(&deviceFeatures2);
         }
+
+        if (m_Context.extensions.EXT_descriptor_buffer)
+        {
+            vk::PhysicalDeviceFeatures2 deviceFeatures2;
+            deviceFeatures2.setPNext(&m_Context.descriptorBufferFeatures);
+            m_Context.physicalDevice.getFeatures2(&deviceFeatures2);
+        }
+
+        if (const auto* features = findEnabledFeatures<vk::PhysicalDeviceFeatures2>(desc.enabledFeatures))
+            m_Context.robustBufferAccess = features->features.robustBufferAccess;
+
+        if (m_Context.extensions.EXT_multi_draw)
+        {
+            const auto* features = findEnabledFeatures<vk::PhysicalDeviceMultiDrawFeaturesEXT>(desc.enabledFeatures);
+            m_Context.multiDraw = features && features->multiDraw;
+        }
+
+        if (m_Context.extensions.EXT_memory_priority)
+        {
+            const auto* features = findEnabledFeatures<vk::PhysicalDeviceMemoryPriorityFeaturesEXT>(desc.enabledFeatures);
+            m_Context.memoryPriority = features && features->memoryPriority;
+        }
+
+        // The dynamic state features are taken from what the application enabled, not from what the device supports
+        if (m_Context.extensions.EXT_extended_dynamic_state3)
+        {
+            if (const auto* features = findEnabledFeatures<vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT>(desc.enabledFeatures))
+            {
+                m_Context.extendedDynamicState3Features = *features;
+                m_Context.extendedDynamicState3Features.pNext = nullptr;
+            }
+        }
+
+        if (m_Context.extensions.EXT_vertex_input_dynamic_state)
+        {
+            if (const auto* features = findEnabledFeatures<vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT>(desc.enabledFeatures))
+            {
+                m_Context.vertexInputDynamicStateFeatures = *features;
+                m_Context.vertexInputDynamicStateFeatures.pNext = nullptr;
+            }
+        }
+
+        {
+            const bool vulkan13 = std::min(desc.apiVersion, m_Context.physicalDeviceProperties.apiVersion) >= VK_API_VERSION_1_3;
+
+            const auto* eds1 = findEnabledFeatures<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>(desc.enabledFeatures);
+            m_Context.extendedDynamicState = vulkan13
+                || (m_Context.extensions.EXT_extended_dynamic_state && eds1 && eds1->extendedDynamicState);
+
+            const auto* eds2 = findEnabledFeatures<vk::PhysicalDeviceExtendedDynamicState2FeaturesEXT>(desc.enabledFeatures);
+            m_Context.extendedDynamicState2 = vulkan13
+                || (m_Context.extensions.EXT_extended_dynamic_state2 && eds2 && eds2->extendedDynamicState2);
+        }
+
+        if (desc.enableDynamicPipelineState && !(m_Context.extendedDynamicState && m_Context.extendedDynamicState2))
+        {
+            m_Context.warning("enableDynamicPipelineState requires Vulkan 1.3, or VK_EXT_extended_dynamic_state and "
+                "VK_EXT_extended_dynamic_state2 with their features enabled, it will not be used");
+        }
+        else if (desc.enableDynamicPipelineState)
+        {
+            const vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT& eds3 = m_Context.extendedDynamicState3Features;
+
+            m_Context.dynamicPipelineState = true;
+            m_Context.dynamicBlendState = eds3.extendedDynamicState3ColorBlendEnable
+                && eds3.extendedDynamicState3ColorBlendEquation
+                && eds3.extendedDynamicState3ColorWriteMask
+                && eds3.extendedDynamicState3AlphaToCoverageEnable;
+            m_Context.dynamicPolygonMode = eds3.extendedDynamicState3PolygonMode;
+            m_Context.dynamicConservativeRaster = m_Context.extensions.EXT_conservative_rasterization
+                && eds3.extendedDynamicState3ConservativeRasterizationMode;
+            // Vertex buffer tokens in device-generated commands need dynamic strides, which can't be combined with dynamic vertex input
+            m_Context.dynamicVertexInput = m_Context.vertexInputDynamicStateFeatures.vertexInputDynamicState
+                && !m_Context.extensions.EXT_device_generated_commands;
+        }
 #ifdef NVRHI_WITH_RTXMU
         if (m_Context.extensions.KHR_acceleration_structure)
         {
@@ -237,19 +420,81 @@ namespace nvrhi::vulkan
         {
             m_Context.warning("Opacity micro-maps are not currently supported by RTXMU.");
         }
+#else
+        m_Context.blasCompaction = std::make_unique<BlasCompactionManager>(m_Context, desc.blasCompactionBudget);
 #endif
+        m_Context.accelStructStats = std::make_unique<AccelStructStatsTracker>(desc.enableAccelStructBuildTiming, desc.maxAccelStructBuildTimerQueries);
+        m_Context.deviceStats = std::make_unique<DeviceStatsTracker>();
+        m_Context.profiler = std::make_unique<GpuProfiler>(desc.enableMarkerProfiling, desc.maxProfilerTimerQueries);
         auto pipelineInfo = vk::PipelineCacheCreateInfo();
+        if (desc.pipelineCacheData && desc.pipelineCacheDataSize)
+        {
+            if (isPipelineCacheDataCompatible(desc.pipelineCacheData, desc.pipelineCacheDataSize, m_Context.physicalDeviceProperties))
+            {
+                pipelineInfo.setInitialDataSize(desc.pipelineCacheDataSize);
+                pipelineInfo.setPInitialData(desc.pipelineCacheData);
+            }
+            else
+            {
+                m_Context.warning("The provided pipeline cache data was created with a different device or driver, ignoring it");
+            }
+        }
+
         vk::Result res = m_Context.device.createPipelineCache(&pipelineInfo,
             m_Context.allocationCallbacks,
             &m_Context.pipelineCache);
 
+        if (res != vk::Result::eSuccess && pipelineInfo.initialDataSize != 0)
+        {
+            m_Context.warning("Failed to create the pipeline cache from the provided data, creating an empty one");
+
+            pipelineInfo.setInitialDataSize(0);
+            pipelineInfo.setPInitialData(nullptr);
+            res = m_Context.device.createPipelineCache(&pipelineInfo,
+                m_Context.allocationCallbacks,
+                &m_Context.pipelineCache);
+        }
+
         if (res != vk::Result::eSuccess)
         {
             m_Context.error("Failed to create the pipeline cache");
         }
 
+        if (desc.enableDescriptorBuffers)
+        {
+            if (m_Context.extensions.EXT_descriptor_buffer && m_Context.descriptorBufferFeatures.descriptorBuffer && m_Context.extensions.buffer_device_address)
+            {
+                // Samplers and resources share the buffer, so it has to fit within the limits of both kinds of bindings
+                const vk::PhysicalDeviceDescriptorBufferPropertiesEXT& limits = m_Context.descriptorBufferProperties;
+                const uint64_t descriptorBufferSize = std::min({ desc.descriptorBufferSize,
+                    uint64_t(limits.maxResourceDescriptorBufferRange), uint64_t(limits.resourceDescriptorBufferAddressSpaceSize),
+                    uint64_t(limits.maxSamplerDescriptorBufferRange), uint64_t(limits.samplerDescriptorBufferAddressSpaceSize) });
+
+                if (descriptorBufferSize < desc.descriptorBufferSize)
+                {
+                    std::stringstream ss;
+                    ss << "descriptorBufferSize exceeds the descriptor buffer limits of the device, using " << descriptorBufferSize << " bytes instead";
+                    m_Context.warning(ss.str());
+                }
+
+                auto descriptorBufferHeap = std::make_unique<DescriptorBufferHeap>(m_Context, *this);
+                if (descriptorBufferHeap->init(descriptorBufferSize) == vk::Result::eSuccess)
+                    m_Context.descriptorBufferHeap = std::move(descriptorBufferHeap);
+                else
+                    m_Context.warning("Failed to create the descriptor buffer, descriptor sets will be used instead");
+            }
+            else
+            {
+                m_Context.warning("enableDescriptorBuffers requires VK_EXT_descriptor_buffer with the descriptorBuffer feature "
+                    "and buffer device addresses, descriptor sets will be used instead");
+            }
+        }
+
         // Create an empty Vk::DescriptorSetLayout
         auto descriptorSetLayoutInfo = vk::DescriptorSetLayoutCreateInfo()
+            .setFlags(m_Context.descriptorBufferHeap
+                ? vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT
+                : vk::DescriptorSetLayoutCreateFlags())
             .setBindingCount(0)
             .setPBindings(nullptr);
         res = m_Context.device.createDescriptorSetLayout(&descriptorSetLayoutInfo,
@@ -261,6 +506,29 @@ namespace nvrhi::vulkan
             m_Context.error("Failed to create an empty descriptor set layout");
         }
 
+        if (desc.enableGraphicsPipelineLibrary)
+        {
+            if (m_Context.extensions.EXT_graphics_pipeline_library)
+                m_PipelineLibraryCache = std::make_unique<GraphicsPipelineLibraryCache>(m_Context);
+            else
+                m_Context.warning("enableGraphicsPipelineLibrary requires VK_EXT_graphics_pipeline_library, it will not be used");
+        }
+
+        if (m_Context.dynamicPipelineState)
+        {
+            m_DynamicStatePipelineCache = std::make_unique<DynamicStatePipelineCache>(m_Context);
+        }
+
+        if (desc.enableBindingSetCache)
+        {
+            m_BindingSetCache = std::make_unique<BindingSetCache>();
+        }
+
+        if (desc.enableFramebufferCache)
+        {
+            m_FramebufferCache = std::make_unique<FramebufferCache>();
+        }
+
 #if NVRHI_WITH_AFTERMATH
         m_AftermathEnabled = desc.aftermathEnabled;
 #endif
@@ -268,6 +536,26 @@ namespace nvrhi::vulkan
 
     Device::~Device()
     {
+        // Stop the background pipeline optimization before the resources it uses go away
+        m_PipelineLibraryCache.reset();
+
+        // The resources queued by budgeted garbage collection must be released before the allocator
+        m_ReleaseQueue.releaseAll();
+
+        // The cached binding sets return their descriptor sets to the layouts
+        m_BindingSetCache.reset();
+
+        // The cached framebuffers hold their textures, which must be released before the allocator
+        m_FramebufferCache.reset();
+
+#ifndef NVRHI_WITH_RTXMU
+        // The BLASes waiting for compaction hold buffers that must be released before the allocator goes away
+        m_Context.blasCompaction.reset();
+#endif
+        // The pooled build and profiler timer queries release their indices to the timer query allocator
+        m_Context.accelStructStats.reset();
+        m_Context.profiler.reset();
+
         if (m_TimerQueryPool)
         {
             m_Context.device.destroyQueryPool(m_TimerQueryPool);
@@ -309,8 +597,19 @@ namespace nvrhi::vulkan
         return GraphicsAPI::VULKAN;
     }
 
+    void Device::flushSubmissions()
+    {
+        for (const auto& queue : m_Queues)
+        {
+            if (queue)
+                queue->flush();
+        }
+    }
+
     bool Device::waitForIdle()
     {
+        flushSubmissions();
+
         try {
             m_Context.device.waitIdle();
         }
@@ -322,14 +621,46 @@ namespace nvrhi::vulkan
     }
 
     void Device::runGarbageCollection()
+    {
+        collectGarbage(true, 0);
+    }
+
+    void Device::runGarbageCollection(uint32_t maxReleaseMicroseconds)
+    {
+        collectGarbage(false, maxReleaseMicroseconds);
+    }
+
+    void Device::evictCachedFramebuffers(ITexture* texture)
+    {
+        if (m_FramebufferCache)
+            m_FramebufferCache->evict(texture);
+    }
+
+    void Device::collectGarbage(bool releaseAll, uint32_t maxReleaseMicroseconds)
     {
         for (auto& m_Queue : m_Queues)
         {
             if (m_Queue)
             {
-                m_Queue->retireCommandBuffers();
+                m_Queue->retireCommandBuffers(releaseAll ? nullptr : &m_ReleaseQueue);
             }
         }
+
+        if (releaseAll)
+            m_ReleaseQueue.releaseAll();
+        else
+            m_ReleaseQueue.release(maxReleaseMicroseconds);
+
+        m_ReadbackPool.runCallbacks();
+
+        m_Context.accelStructStats->endFrame(this);
+        m_Context.profiler->endFrame(this, m_ProfilerTimestamps);
+
+        if (m_BindingSetCache)
+            m_BindingSetCache->releaseUnused();
+
+        if (m_FramebufferCache)
+            m_FramebufferCache->releaseUnused();
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -338,10 +669,22 @@ namespace nvrhi::vulkan
         {
         case Feature::DeferredCommandLists:
             return true;
+        case Feature::SecondaryCommandLists:
+            return true;
+        case Feature::ReusableCommandLists:
+            return true;
+        case Feature::AsyncReadback:
+            return true;
+        case Feature::DeviceLocalUploadMemory:
+            return m_Allocator.isDeviceLocalUploadSupported();
+        case Feature::DeviceGeneratedCommands:
+            return m_Context.extensions.EXT_device_generated_commands;
         case Feature::RayTracingAccelStruct:
             return m_Context.extensions.KHR_acceleration_structure;
         case Feature::RayTracingPipeline:
             return m_Context.extensions.KHR_ray_tracing_pipeline;
+        case Feature::RayTracingIndirectInstanceCount:
+            return m_Context.extensions.KHR_acceleration_structure && m_Context.accelStructFeatures.accelerationStructureIndirectBuild;
         case Feature::RayTracingOpacityMicromap:
 #ifdef NVRHI_WITH_RTXMU
             return false; // RTXMU does not support OMMs
@@ -363,7 +706,12 @@ namespace nvrhi::vulkan
         case Feature::ShaderSpecializations:
             return true;
         case Feature::Meshlets:
-            return m_Context.extensions.NV_mesh_shader;
+            return m_Context.extensions.NV_mesh_shader || m_Context.extensions.EXT_mesh_shader;
+        case Feature::MeshletIndirect:
+            // The NV extension uses a different argument layout, only the EXT layout matches DispatchIndirectArguments
+            return m_Context.extensions.EXT_mesh_shader;
+        case Feature::WorkGraphEmulation:
+            return true;
         case Feature::VariableRateShading:
             if (pInfo)
             {
@@ -409,6 +757,10 @@ namespace nvrhi::vulkan
             return m_Context.extensions.NV_cooperative_vector && m_Context.coopVecFeatures.cooperativeVector;
         case Feature::CooperativeVectorTraining:
             return m_Context.extensions.NV_cooperative_vector && m_Context.coopVecFeatures.cooperativeVectorTraining;
+        case Feature::PushDescriptors:
+            // With descriptor buffers, push descriptors are only supported without a separate push descriptor buffer
+            return m_Context.extensions.KHR_push_descriptor &&
+                (!m_Context.descriptorBufferHeap || m_Context.descriptorBufferProperties.bufferlessPushDescriptors);
         default:
             return false;
         }
@@ -474,6 +826,82 @@ namespace nvrhi::vulkan
         return result;
     }
 
+    MemoryAllocatorStats Device::getMemoryAllocatorStats()
+    {
+        return m_Allocator.getStats();
+    }
+
+    MemoryBudget Device::getMemoryBudget()
+    {
+        MemoryBudget result;
+
+        if (!m_Context.extensions.EXT_memory_budget)
+            return result;
+
+        auto budgetProperties = vk::PhysicalDeviceMemoryBudgetPropertiesEXT();
+        auto memoryProperties = vk::PhysicalDeviceMemoryProperties2()
+            .setPNext(&budgetProperties);
+        m_Context.physicalDevice.getMemoryProperties2(&memoryProperties);
+
+        const vk::PhysicalDeviceMemoryProperties& heapProperties = memoryProperties.memoryProperties;
+        for (uint32_t heapIndex = 0; heapIndex < heapProperties.memoryHeapCount && heapIndex < c_MaxMemoryHeaps; heapIndex++)
+        {
+            MemoryHeapBudget heap;
+            heap.budget = budgetProperties.heapBudget[heapIndex];
+            heap.usage = budgetProperties.heapUsage[heapIndex];
+            heap.isDeviceLocal = bool(heapProperties.memoryHeaps[heapIndex].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+            result.heaps.push_back(heap);
+        }
+
+        return result;
+    }
+
+    AccelStructStats Device::getAccelStructStats()
+    {
+        AccelStructStats stats = m_Context.accelStructStats->getStats();
+#ifndef NVRHI_WITH_RTXMU
+        stats.pendingCompactionCount = m_Context.blasCompaction->getNumPendingCompactions();
+#endif
+        return stats;
+    }
+
+    DeviceStats Device::getDeviceStats()
+    {
+        DeviceStats stats = m_Context.deviceStats->getStats();
+        if (m_Context.descriptorBufferHeap)
+            stats.descriptorBufferBytes = m_Context.descriptorBufferHeap->getStats();
+        stats.queuedResourceReleases = m_ReleaseQueue.size();
+        return stats;
+    }
+
+    bool Device::getProfilerFrameResults(ProfilerFrameResults& outResults)
+    {
+        return m_Context.profiler->getFrameResults(outResults);
+    }
+
+    bool Device::getPipelineCacheData(std::vector<uint8_t>& data)
+    {
+        if (!m_Context.pipelineCache)
+            return false;
+
+        size_t dataSize = 0;
+        vk::Result res = m_Context.device.getPipelineCacheData(m_Context.pipelineCache, &dataSize, nullptr);
+        if (res != vk::Result::eSuccess)
+            return false;
+
+        data.resize(dataSize);
+        res = m_Context.device.getPipelineCacheData(m_Context.pipelineCache, &dataSize, data.data());
+        data.resize(dataSize);
+
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.error("Failed to get the pipeline cache data");
+            return false;
+        }
+
+        return true;
+    }
+
     coopvec::DeviceFeatures Device::queryCoopVecFeatures()
     {
         coopvec::DeviceFeatures result;
@@ -558,12 +986,180 @@ namespace nvrhi::vulkan
         return CommandListHandle::Create(cmdList);
     }
     
+    void Device::addAutomaticQueueSync(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue, CommandListHandle& prologueCommandList)
+    {
+        Queue& queue = *m_Queues[uint32_t(executionQueue)];
+
+        m_QueueDependencies.clear();
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            checked_cast<CommandList*>(pCommandLists[i])->getStateTracker().collectQueueDependencies(executionQueue, m_QueueDependencies);
+        }
+
+        // Without automatic queue sync, the application orders the submissions itself and only the ownership
+        // transfers are needed from the dependencies
+        if (!m_Context.automaticQueueSync)
+        {
+            m_QueueDependencies.waitInstances.fill(0);
+            m_QueueDependencies.waitReasons.fill(nullptr);
+        }
+
+        // Resources that were last used on a queue of a different family are released there by a separate submission,
+        // and acquired on this queue by the prologue command list
+        std::vector<QueueOwnershipTransfer> acquireTransfers;
+
+        for (uint32_t srcQueueIndex = 0; srcQueueIndex < uint32_t(CommandQueue::Count); srcQueueIndex++)
+        {
+            Queue* srcQueue = m_Queues[srcQueueIndex].get();
+            if (!srcQueue || srcQueue == &queue || srcQueue->getQueueFamilyIndex() == queue.getQueueFamilyIndex())
+                continue;
+
+            std::vector<QueueOwnershipTransfer> releaseTransfers;
+
+            for (const auto& [texture, lastQueue] : m_QueueDependencies.textureTransfers)
+            {
+                // Textures with an unknown layout have no contents to preserve
+                if (lastQueue != CommandQueue(srcQueueIndex) ||
+                    (texture->queueAccess.lastState == ResourceStates::Unknown && texture->queueAccess.lastSubresourceStates.empty()))
+                    continue;
+
+                QueueOwnershipTransfer transfer;
+                transfer.texture = static_cast<Texture*>(texture);
+                transfer.srcQueueFamilyIndex = srcQueue->getQueueFamilyIndex();
+                transfer.dstQueueFamilyIndex = queue.getQueueFamilyIndex();
+                releaseTransfers.push_back(transfer);
+            }
+
+            for (const auto& [buffer, lastQueue] : m_QueueDependencies.bufferTransfers)
+            {
+                if (lastQueue != CommandQueue(srcQueueIndex))
+                    continue;
+
+                QueueOwnershipTransfer transfer;
+                transfer.buffer = static_cast<Buffer*>(buffer);
+                transfer.srcQueueFamilyIndex = srcQueue->getQueueFamilyIndex();
+                transfer.dstQueueFamilyIndex = queue.getQueueFamilyIndex();
+                releaseTransfers.push_back(transfer);
+            }
+
+            if (releaseTransfers.empty())
+                continue;
+
+            CommandListHandle releaseCommandList = createCommandList(CommandListParameters()
+                .setQueueType(CommandQueue(srcQueueIndex))
+                .setEnableImmediateExecution(false));
+            releaseCommandList->open();
+            checked_cast<CommandList*>(releaseCommandList.Get())->queueOwnershipTransferBarriers(releaseTransfers, true);
+            releaseCommandList->close();
+
+            ICommandList* releaseCommandListPtr = releaseCommandList;
+            const uint64_t releaseSubmissionID = srcQueue->submit(&releaseCommandListPtr, 1);
+            checked_cast<CommandList*>(releaseCommandListPtr)->executed(*srcQueue, releaseSubmissionID);
+
+            const QueueOwnershipTransfer& firstTransfer = releaseTransfers[0];
+            m_QueueDependencies.addWait(CommandQueue(srcQueueIndex), releaseSubmissionID,
+                firstTransfer.texture ? firstTransfer.texture->desc.debugName : firstTransfer.buffer->desc.debugName);
+
+            acquireTransfers.insert(acquireTransfers.end(), releaseTransfers.begin(), releaseTransfers.end());
+        }
+
+        if (!acquireTransfers.empty())
+        {
+            prologueCommandList = createCommandList(CommandListParameters()
+                .setQueueType(executionQueue)
+                .setEnableImmediateExecution(false));
+            prologueCommandList->open();
+            checked_cast<CommandList*>(prologueCommandList.Get())->queueOwnershipTransferBarriers(acquireTransfers, false);
+        }
+
+        for (uint32_t waitQueueIndex = 0; waitQueueIndex < uint32_t(CommandQueue::Count); waitQueueIndex++)
+        {
+            uint64_t& instance = m_QueueDependencies.waitInstances[waitQueueIndex];
+            if (instance == 0)
+                continue;
+
+            Queue* waitQueue = m_Queues[waitQueueIndex].get();
+            if (!waitQueue || waitQueue->pollCommandList(instance))
+            {
+                instance = 0;
+                continue;
+            }
+
+            if (waitQueue->hasPendingSubmissions(instance))
+                waitQueue->flush();
+
+            queue.addWaitSemaphore(waitQueue->trackingSemaphore, instance);
+        }
+
+        if (m_Context.logAutomaticQueueSync)
+            reportQueueDependencies(m_QueueDependencies, executionQueue, m_Context.messageCallback);
+    }
+
     uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
     {
         Queue& queue = *m_Queues[uint32_t(executionQueue)];
 
+        // Cross-queue dependencies are found before the submission, and the queue access history of the resources
+        // is updated after it. The ownership transfers, if any, are recorded into the prologue command list.
+        CommandListHandle prologueCommandList;
+        std::vector<ICommandList*> commandListsWithPrologue;
+
+        std::unique_lock<std::mutex> queueSyncLock;
+        if (m_Context.queueOwnershipTransfers)
+        {
+            queueSyncLock = std::unique_lock(m_QueueSyncMutex);
+            addAutomaticQueueSync(pCommandLists, numCommandLists, executionQueue, prologueCommandList);
+        }
+
+        // Reusable command lists are recorded with the assumption that keepInitialState textures are in their
+        // initial states on entry. Textures that have not been used by any command list before are still in the
+        // undefined layout, so transition them in the prologue command list submitted in front of the others.
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            if (!commandList->getDesc().isReusable)
+                continue;
+
+            for (TextureStateExtension* texture : commandList->getTexturesRequiringInitialState())
+            {
+                if (texture->stateInitialized)
+                    continue;
+
+                if (!prologueCommandList)
+                {
+                    prologueCommandList = createCommandList(CommandListParameters()
+                        .setQueueType(executionQueue)
+                        .setEnableImmediateExecution(false));
+                    prologueCommandList->open();
+                }
+
+                prologueCommandList->setTextureState(static_cast<Texture*>(texture), AllSubresources, texture->descRef.initialState);
+            }
+        }
+
+        if (prologueCommandList)
+        {
+            prologueCommandList->close();
+
+            commandListsWithPrologue.push_back(prologueCommandList);
+            commandListsWithPrologue.insert(commandListsWithPrologue.end(), pCommandLists, pCommandLists + numCommandLists);
+            pCommandLists = commandListsWithPrologue.data();
+            numCommandLists = commandListsWithPrologue.size();
+        }
+
         uint64_t submissionID = queue.submit(pCommandLists, numCommandLists);
 
+        if (m_Context.queueOwnershipTransfers)
+        {
+            for (size_t i = 0; i < numCommandLists; i++)
+            {
+                checked_cast<CommandList*>(pCommandLists[i])->getStateTracker().recordQueueAccesses(executionQueue, submissionID);
+            }
+
+            queueSyncLock.unlock();
+        }
+
         for (size_t i = 0; i < numCommandLists; i++)
         {
             checked_cast<CommandList*>(pCommandLists[i])->executed(queue, submissionID);
@@ -702,6 +1298,7 @@ namespace nvrhi::vulkan
         Heap* heap = new Heap(m_Allocator);
         heap->desc = d;
         heap->managed = true;
+        heap->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::Heap, d.capacity);
 
         // Set the Device Address bit if that feature is supported, because the heap might be used to store acceleration structures
         const bool enableDeviceAddress = m_Context.extensions.buffer_device_address;
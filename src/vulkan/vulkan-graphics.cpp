@@ -23,6 +23,9 @@
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
 
+#include <algorithm>
+#include <sstream>
+
 namespace nvrhi::vulkan
 {
     static TextureDimension getDimensionForFramebuffer(TextureDimension dimension, bool isArray)
@@ -53,10 +56,88 @@ namespace nvrhi::vulkan
         return dimension;
     }
 
+    static vk::AttachmentLoadOp convertAttachmentLoadOp(AttachmentLoadOp op)
+    {
+        switch (op)
+        {
+        case AttachmentLoadOp::Clear:
+            return vk::AttachmentLoadOp::eClear;
+        case AttachmentLoadOp::DontCare:
+            return vk::AttachmentLoadOp::eDontCare;
+        case AttachmentLoadOp::Load:
+        default:
+            return vk::AttachmentLoadOp::eLoad;
+        }
+    }
+
+    static vk::AttachmentStoreOp convertAttachmentStoreOp(AttachmentStoreOp op)
+    {
+        return op == AttachmentStoreOp::DontCare ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore;
+    }
+
+    static vk::ClearColorValue convertClearColor(Format format, const Color& color)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(format);
+
+        if (formatInfo.kind == FormatKind::Integer)
+        {
+            if (formatInfo.isSigned)
+                return vk::ClearColorValue().setInt32({ int32_t(color.r), int32_t(color.g), int32_t(color.b), int32_t(color.a) });
+
+            return vk::ClearColorValue().setUint32({ uint32_t(color.r), uint32_t(color.g), uint32_t(color.b), uint32_t(color.a) });
+        }
+
+        return vk::ClearColorValue().setFloat32({ color.r, color.g, color.b, color.a });
+    }
+
+    // A render pass can be continued with a different framebuffer object for the same attachments,
+    // as long as that framebuffer loads their contents
+    static bool canContinueRenderPass(const Framebuffer* current, const Framebuffer* next)
+    {
+        if (current == next)
+            return true;
+
+        if (!current || !next || !next->loadsAllAttachments)
+            return false;
+
+        auto sameAttachment = [](const FramebufferAttachment& a, const FramebufferAttachment& b)
+        {
+            return a.texture == b.texture
+                && a.subresources == b.subresources
+                && a.format == b.format
+                && a.isReadOnly == b.isReadOnly
+                && a.storeOp == b.storeOp;
+        };
+
+        const FramebufferDesc& currentDesc = current->desc;
+        const FramebufferDesc& nextDesc = next->desc;
+
+        if (currentDesc.colorAttachments.size() != nextDesc.colorAttachments.size())
+            return false;
+
+        for (size_t i = 0; i < currentDesc.colorAttachments.size(); i++)
+        {
+            if (!sameAttachment(currentDesc.colorAttachments[i], nextDesc.colorAttachments[i]))
+                return false;
+        }
+
+        return sameAttachment(currentDesc.depthAttachment, nextDesc.depthAttachment)
+            && sameAttachment(currentDesc.shadingRateAttachment, nextDesc.shadingRateAttachment);
+    }
+
     FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
+    {
+        if (m_FramebufferCache)
+            return m_FramebufferCache->getOrCreate(desc, [&]() { return createFramebufferInternal(desc); });
+
+        return createFramebufferInternal(desc);
+    }
+
+    FramebufferHandle Device::createFramebufferInternal(const FramebufferDesc& desc)
     {
         Framebuffer *fb = new Framebuffer();
         fb->desc = desc;
+        fb->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::Framebuffer);
         fb->framebufferInfo = FramebufferInfoEx(desc);
 
         for(uint32_t i = 0; i < desc.colorAttachments.size(); i++)
@@ -73,12 +154,19 @@ namespace nvrhi::vulkan
 
             const auto& view = t->getSubresourceView(subresources, dimension, rt.format, vk::ImageUsageFlagBits::eColorAttachment);
 
-            vk::RenderingAttachmentInfo& attachmentInfo = fb->colorAttachments.emplace_back();
-            attachmentInfo = vk::RenderingAttachmentInfo()
+            const auto attachmentInfo = vk::RenderingAttachmentInfo()
                 .setImageView(view.view)
                 .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
                 .setLoadOp(vk::AttachmentLoadOp::eLoad)
-                .setStoreOp(vk::AttachmentStoreOp::eStore);
+                .setStoreOp(convertAttachmentStoreOp(rt.storeOp));
+
+            fb->resumeColorAttachments.push_back(attachmentInfo);
+            fb->colorAttachments.push_back(vk::RenderingAttachmentInfo(attachmentInfo)
+                .setLoadOp(convertAttachmentLoadOp(rt.loadOp))
+                .setClearValue(convertClearColor(rt.format != Format::UNKNOWN ? rt.format : t->desc.format, rt.clearColor)));
+
+            fb->loadsAllAttachments &= rt.loadOp == AttachmentLoadOp::Load;
+            fb->discardsAnyAttachment |= rt.storeOp == AttachmentStoreOp::DontCare;
 
             fb->resources.push_back(rt.texture);
         }
@@ -105,14 +193,24 @@ namespace nvrhi::vulkan
 
             const auto& view = texture->getSubresourceView(subresources, dimension, att.format, vk::ImageUsageFlagBits::eDepthStencilAttachment);
 
-            fb->depthAttachment = vk::RenderingAttachmentInfo()
+            fb->resumeDepthAttachment = vk::RenderingAttachmentInfo()
                 .setImageView(view.view)
                 .setImageLayout(depthLayout)
                 .setLoadOp(vk::AttachmentLoadOp::eLoad)
-                .setStoreOp(vk::AttachmentStoreOp::eStore);
+                .setStoreOp(convertAttachmentStoreOp(att.storeOp));
+
+            fb->depthAttachment = vk::RenderingAttachmentInfo(fb->resumeDepthAttachment)
+                .setLoadOp(convertAttachmentLoadOp(att.loadOp))
+                .setClearValue(vk::ClearDepthStencilValue(att.clearDepth, uint32_t(att.clearStencil)));
 
             if (getFormatInfo(texture->desc.format).hasStencil)
+            {
                 fb->stencilAttachment = fb->depthAttachment;
+                fb->resumeStencilAttachment = fb->resumeDepthAttachment;
+            }
+
+            fb->loadsAllAttachments &= att.loadOp == AttachmentLoadOp::Load;
+            fb->discardsAnyAttachment |= att.storeOp == AttachmentStoreOp::DontCare;
 
             fb->resources.push_back(att.texture);
         }
@@ -146,6 +244,17 @@ namespace nvrhi::vulkan
         return FramebufferHandle::Create(fb);
     }
 
+    static void getVertexBufferStrides(const GraphicsPipeline* pso, vk::DeviceSize* strides)
+    {
+        const InputLayout* inputLayout = checked_cast<const InputLayout*>(pso->desc.inputLayout.Get());
+
+        for (const vk::VertexInputBindingDescription& binding : inputLayout->bindingDesc)
+        {
+            if (binding.binding < c_MaxVertexAttributes)
+                strides[binding.binding] = binding.stride;
+        }
+    }
+
     void countSpecializationConstants(
         Shader* shader,
         size_t& numShaders,
@@ -215,6 +324,8 @@ namespace nvrhi::vulkan
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::createGraphicsPipeline");
+
         if (desc.renderState.singlePassStereo.enabled)
         {
             m_Context.error("Single-pass stereo is not supported by the Vulkan backend");
@@ -227,6 +338,7 @@ namespace nvrhi::vulkan
 
         GraphicsPipeline *pso = new GraphicsPipeline(m_Context);
         pso->desc = desc;
+        pso->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::GraphicsPipeline);
         pso->framebufferInfo = fbinfo;
 
         Shader* VS = checked_cast<Shader*>(desc.VS.Get());
@@ -381,16 +493,71 @@ namespace nvrhi::vulkan
 
         pso->usesBlendConstants = blendState.usesConstantColor(uint32_t(fbinfo.colorFormats.size()));
 
-        static_vector<vk::DynamicState, 5> dynamicStates = {
+        // Vertex buffer tokens in device-generated commands replace the strides too, which requires them to be dynamic.
+        // That's only done for the pipelines that ask for it, as it needs the extended dynamic state.
+        pso->usesDynamicVertexStrides = desc.indirectVertexBuffers && m_Context.extensions.EXT_device_generated_commands
+            && m_Context.extendedDynamicState && inputLayout && !inputLayout->bindingDesc.empty();
+
+        if (desc.indirectVertexBuffers && !m_Context.extendedDynamicState)
+        {
+            m_Context.warning("GraphicsPipelineDesc::indirectVertexBuffers requires Vulkan 1.3 or VK_EXT_extended_dynamic_state, "
+                "command signatures with vertex buffer arguments can't be created for this pipeline");
+        }
+
+        pso->usesDynamicPipelineState = m_DynamicStatePipelineCache != nullptr;
+
+        static_vector<vk::DynamicState, 32> dynamicStates = {
             vk::DynamicState::eViewport,
             vk::DynamicState::eScissor
         };
-        if (pso->usesBlendConstants)
-            dynamicStates.push_back(vk::DynamicState::eBlendConstants);
-        if (pso->desc.renderState.depthStencilState.dynamicStencilRef)
-            dynamicStates.push_back(vk::DynamicState::eStencilReference);
+        if (pso->usesDynamicPipelineState)
+        {
+            // All of this state is set by CommandList::setDynamicPipelineState, so that the pipelines
+            // which only differ in it can share the VkPipeline. The first group is core in Vulkan 1.3.
+            for (vk::DynamicState state : {
+                vk::DynamicState::ePrimitiveTopology,
+                vk::DynamicState::eCullMode,
+                vk::DynamicState::eFrontFace,
+                vk::DynamicState::eDepthBiasEnable,
+                vk::DynamicState::eDepthBias,
+                vk::DynamicState::eDepthTestEnable,
+                vk::DynamicState::eDepthWriteEnable,
+                vk::DynamicState::eDepthCompareOp,
+                vk::DynamicState::eStencilTestEnable,
+                vk::DynamicState::eStencilOp,
+                vk::DynamicState::eStencilCompareMask,
+                vk::DynamicState::eStencilWriteMask,
+                vk::DynamicState::eStencilReference,
+                vk::DynamicState::eBlendConstants })
+            {
+                dynamicStates.push_back(state);
+            }
+
+            if (m_Context.dynamicBlendState)
+            {
+                dynamicStates.push_back(vk::DynamicState::eColorBlendEnableEXT);
+                dynamicStates.push_back(vk::DynamicState::eColorBlendEquationEXT);
+                dynamicStates.push_back(vk::DynamicState::eColorWriteMaskEXT);
+                dynamicStates.push_back(vk::DynamicState::eAlphaToCoverageEnableEXT);
+            }
+            if (m_Context.dynamicPolygonMode)
+                dynamicStates.push_back(vk::DynamicState::ePolygonModeEXT);
+            if (m_Context.dynamicConservativeRaster)
+                dynamicStates.push_back(vk::DynamicState::eConservativeRasterizationModeEXT);
+            if (m_Context.dynamicVertexInput)
+                dynamicStates.push_back(vk::DynamicState::eVertexInputEXT);
+        }
+        else
+        {
+            if (pso->usesBlendConstants)
+                dynamicStates.push_back(vk::DynamicState::eBlendConstants);
+            if (pso->desc.renderState.depthStencilState.dynamicStencilRef)
+                dynamicStates.push_back(vk::DynamicState::eStencilReference);
+        }
         if (pso->desc.shadingRateState.enabled)
             dynamicStates.push_back(vk::DynamicState::eFragmentShadingRateKHR);
+        if (pso->usesDynamicVertexStrides)
+            dynamicStates.push_back(vk::DynamicState::eVertexInputBindingStride);
 
         auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo()
             .setDynamicStateCount(uint32_t(dynamicStates.size()))
@@ -421,6 +588,7 @@ namespace nvrhi::vulkan
             .setPDepthStencilState(&depthStencil)
             .setPColorBlendState(&colorBlend)
             .setPDynamicState(&dynamicStateInfo)
+            .setFlags(m_Context.getPipelineCreateFlags())
             .setLayout(pso->pipelineLayout)
             .setBasePipelineHandle(nullptr)
             .setBasePipelineIndex(-1)
@@ -437,10 +605,21 @@ namespace nvrhi::vulkan
             pipelineInfo.setPTessellationState(&tessellationState);
         }
 
-        res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
-                                                     1, &pipelineInfo,
-                                                     m_Context.allocationCallbacks,
-                                                     &pso->pipeline);
+        if (m_DynamicStatePipelineCache)
+        {
+            res = m_DynamicStatePipelineCache->createPipeline(pso, pipelineInfo);
+        }
+        else if (m_PipelineLibraryCache)
+        {
+            res = m_PipelineLibraryCache->createPipeline(pso, pipelineInfo);
+        }
+        else
+        {
+            res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+                                                         1, &pipelineInfo,
+                                                         m_Context.allocationCallbacks,
+                                                         &pso->pipeline);
+        }
         ASSERT_VK_OK(res); // for debugging
         CHECK_VK_FAIL(res);
 
@@ -457,11 +636,19 @@ namespace nvrhi::vulkan
 
     GraphicsPipeline::~GraphicsPipeline()
     {
-        if (pipeline)
+        if (const VkPipeline optimized = optimizedPipeline.load())
+        {
+            m_Context.device.destroyPipeline(vk::Pipeline(optimized), m_Context.allocationCallbacks);
+            optimizedPipeline = VK_NULL_HANDLE;
+        }
+
+        // A shared pipeline is destroyed by the last of its users when sharedPipeline is released
+        if (pipeline && !sharedPipeline)
         {
             m_Context.device.destroyPipeline(pipeline, m_Context.allocationCallbacks);
-            pipeline = nullptr;
         }
+        pipeline = nullptr;
+        sharedPipeline.reset();
 
         if (pipelineLayout)
         {
@@ -470,6 +657,282 @@ namespace nvrhi::vulkan
         }
     }
 
+    SharedGraphicsPipeline::~SharedGraphicsPipeline()
+    {
+        if (pipeline)
+        {
+            m_Context.device.destroyPipeline(pipeline, m_Context.allocationCallbacks);
+            pipeline = nullptr;
+        }
+    }
+
+    static uint32_t getPrimitiveTopologyClass(PrimitiveType primType)
+    {
+        switch (primType)
+        {
+        case PrimitiveType::PointList:
+            return 0;
+        case PrimitiveType::LineList:
+        case PrimitiveType::LineStrip:
+            return 1;
+        case PrimitiveType::PatchList:
+            return 3;
+        default:
+            return 2;
+        }
+    }
+
+    bool DynamicStatePipelineCache::Key::operator==(const Key& other) const
+    {
+        return shaders == other.shaders
+            && bindingLayouts.size() == other.bindingLayouts.size()
+            && std::equal(bindingLayouts.begin(), bindingLayouts.end(), other.bindingLayouts.begin())
+            && framebufferInfo == other.framebufferInfo
+            && shadingRateEnabled == other.shadingRateEnabled
+            && topologyClass == other.topologyClass
+            && patchControlPoints == other.patchControlPoints
+            && inputLayout == other.inputLayout
+            && blendState == other.blendState
+            && fillMode == other.fillMode
+            && conservativeRasterEnable == other.conservativeRasterEnable;
+    }
+
+    DynamicStatePipelineCache::Key DynamicStatePipelineCache::getPipelineKey(const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo) const
+    {
+        Key key;
+        key.shaders = { desc.VS.Get(), desc.HS.Get(), desc.DS.Get(), desc.GS.Get(), desc.PS.Get() };
+        for (const BindingLayoutHandle& layout : desc.bindingLayouts)
+            key.bindingLayouts.push_back(layout.Get());
+        key.framebufferInfo = fbinfo;
+        key.shadingRateEnabled = desc.shadingRateState.enabled;
+
+        // Without dynamicPrimitiveTopologyUnrestricted, the dynamic topology must be of the same class as the static one
+        if (m_Context.extendedDynamicState3Properties.dynamicPrimitiveTopologyUnrestricted)
+            key.topologyClass = desc.primType == PrimitiveType::PatchList ? 1 : 0;
+        else
+            key.topologyClass = getPrimitiveTopologyClass(desc.primType);
+        if (desc.primType == PrimitiveType::PatchList)
+            key.patchControlPoints = desc.patchControlPoints;
+
+        if (!m_Context.dynamicVertexInput)
+            key.inputLayout = desc.inputLayout.Get();
+        if (!m_Context.dynamicBlendState)
+            key.blendState = desc.renderState.blendState;
+        if (!m_Context.dynamicPolygonMode)
+            key.fillMode = desc.renderState.rasterState.fillMode;
+        if (!m_Context.dynamicConservativeRaster)
+            key.conservativeRasterEnable = desc.renderState.rasterState.conservativeRasterEnable;
+
+        return key;
+    }
+
+    size_t DynamicStatePipelineCache::getKeyHash(const Key& key)
+    {
+        size_t hash = 0;
+        for (IShader* shader : key.shaders)
+            hash_combine(hash, shader);
+        for (IBindingLayout* layout : key.bindingLayouts)
+            hash_combine(hash, layout);
+        hash_combine(hash, key.framebufferInfo);
+        hash_combine(hash, key.shadingRateEnabled);
+        hash_combine(hash, key.topologyClass);
+        hash_combine(hash, key.patchControlPoints);
+        hash_combine(hash, key.inputLayout);
+        hash_combine(hash, key.blendState);
+        hash_combine(hash, key.fillMode);
+        hash_combine(hash, key.conservativeRasterEnable);
+        return hash;
+    }
+
+    DynamicStatePipelineCache::Entry* DynamicStatePipelineCache::findEntry(size_t hash, const Key& key)
+    {
+        const auto range = m_Pipelines.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second.key == key)
+                return &it->second;
+        }
+        return nullptr;
+    }
+
+    vk::Result DynamicStatePipelineCache::createPipeline(GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo)
+    {
+        const Key key = getPipelineKey(pso->desc, pso->framebufferInfo);
+        const size_t hash = getKeyHash(key);
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (const Entry* entry = findEntry(hash, key))
+            {
+                pso->sharedPipeline = entry->pipeline.lock();
+                if (pso->sharedPipeline)
+                {
+                    pso->pipeline = pso->sharedPipeline->pipeline;
+                    return vk::Result::eSuccess;
+                }
+            }
+        }
+
+        // Create the pipeline outside of the lock, as that's slow and other pipelines can be looked up meanwhile
+        auto shared = std::make_shared<SharedGraphicsPipeline>(m_Context);
+        const vk::Result res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+            1, &pipelineInfo,
+            m_Context.allocationCallbacks,
+            &shared->pipeline);
+
+        if (res != vk::Result::eSuccess)
+            return res;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        Entry* entry = findEntry(hash, key);
+        if (entry)
+            pso->sharedPipeline = entry->pipeline.lock();
+        if (!pso->sharedPipeline)
+        {
+            // Drop the entries whose pipelines were all released
+            for (auto it = m_Pipelines.begin(); it != m_Pipelines.end(); )
+            {
+                if (it->second.pipeline.expired() && &it->second != entry)
+                    it = m_Pipelines.erase(it);
+                else
+                    ++it;
+            }
+
+            if (!entry)
+                entry = &m_Pipelines.emplace(hash, Entry{ key, {} })->second;
+
+            entry->pipeline = shared;
+            pso->sharedPipeline = std::move(shared);
+        }
+        // else: another thread has created the same pipeline meanwhile, 'shared' destroys ours
+
+        pso->pipeline = pso->sharedPipeline->pipeline;
+        return vk::Result::eSuccess;
+    }
+
+    CommandSignature::~CommandSignature()
+    {
+        if (layout)
+        {
+            m_Context.device.destroyIndirectCommandsLayoutEXT(layout, m_Context.allocationCallbacks);
+            layout = nullptr;
+        }
+    }
+
+    Object CommandSignature::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::VK_IndirectCommandsLayoutEXT:
+            return Object(layout);
+        default:
+            return nullptr;
+        }
+    }
+
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc, IGraphicsPipeline* _pipeline)
+    {
+        GraphicsPipeline* pipeline = checked_cast<GraphicsPipeline*>(_pipeline);
+        if (!pipeline || !m_Context.extensions.EXT_device_generated_commands)
+            return nullptr;
+
+        // The token data structures are referenced by pointer, so they cannot move while the tokens are filled
+        static_vector<vk::IndirectCommandsLayoutTokenEXT, c_MaxIndirectArguments> tokens;
+        static_vector<vk::IndirectCommandsPushConstantTokenEXT, c_MaxIndirectArguments> pushConstantTokens;
+        static_vector<vk::IndirectCommandsVertexBufferTokenEXT, c_MaxIndirectArguments> vertexBufferTokens;
+        vk::IndirectCommandsIndexBufferTokenEXT indexBufferToken;
+        indexBufferToken.mode = vk::IndirectCommandsInputModeFlagBitsEXT::eDxgiIndexBuffer;
+
+        for (const IndirectArgumentDesc& arg : desc.arguments)
+        {
+            if (arg.type == IndirectArgumentType::VertexBuffer && !pipeline->usesDynamicVertexStrides)
+            {
+                m_Context.error(std::string("Command signature ") + utils::DebugNameToString(desc.debugName) + " has vertex buffer arguments, "
+                    "which requires a pipeline created with GraphicsPipelineDesc::indirectVertexBuffers and an input layout");
+                return nullptr;
+            }
+
+            // IndirectIndexBufferView uses the DXGI layout, which not all devices can consume
+            if (arg.type == IndirectArgumentType::IndexBuffer && !(m_Context.deviceGeneratedCommandsProperties.supportedIndirectCommandsInputModes & indexBufferToken.mode))
+            {
+                m_Context.error(std::string("Command signature ") + utils::DebugNameToString(desc.debugName) + " has an index buffer argument, "
+                    "but the device doesn't support VK_INDIRECT_COMMANDS_INPUT_MODE_DXGI_INDEX_BUFFER_EXT");
+                return nullptr;
+            }
+        }
+
+        uint32_t offset = 0;
+        for (const IndirectArgumentDesc& arg : desc.arguments)
+        {
+            vk::IndirectCommandsLayoutTokenEXT token;
+            token.offset = offset;
+
+            switch (arg.type)
+            {
+            case IndirectArgumentType::Draw:
+                token.type = vk::IndirectCommandsTokenTypeEXT::eDraw;
+                break;
+            case IndirectArgumentType::DrawIndexed:
+                token.type = vk::IndirectCommandsTokenTypeEXT::eDrawIndexed;
+                break;
+            case IndirectArgumentType::VertexBuffer:
+                vertexBufferTokens.push_back(vk::IndirectCommandsVertexBufferTokenEXT().setVertexBindingUnit(arg.slot));
+                token.type = vk::IndirectCommandsTokenTypeEXT::eVertexBuffer;
+                token.data.pVertexBuffer = &vertexBufferTokens.back();
+                break;
+            case IndirectArgumentType::IndexBuffer:
+                token.type = vk::IndirectCommandsTokenTypeEXT::eIndexBuffer;
+                token.data.pIndexBuffer = &indexBufferToken;
+                break;
+            case IndirectArgumentType::PushConstants:
+                pushConstantTokens.push_back(vk::IndirectCommandsPushConstantTokenEXT()
+                    .setUpdateRange(vk::PushConstantRange()
+                        .setStageFlags(pipeline->pushConstantVisibility)
+                        .setOffset(arg.pushConstantOffset)
+                        .setSize(arg.pushConstantByteSize)));
+                token.type = vk::IndirectCommandsTokenTypeEXT::ePushConstant;
+                token.data.pPushConstant = &pushConstantTokens.back();
+                break;
+            default:
+                utils::InvalidEnum();
+                return nullptr;
+            }
+
+            tokens.push_back(token);
+            offset += arg.getByteSize();
+        }
+
+        CommandSignature* signature = new CommandSignature(m_Context);
+        signature->desc = desc;
+        signature->pipeline = pipeline;
+        signature->shaderStages = vk::ShaderStageFlags(convertShaderTypeToShaderStageFlagBits(pipeline->shaderMask));
+
+        auto layoutInfo = vk::IndirectCommandsLayoutCreateInfoEXT()
+            .setShaderStages(signature->shaderStages)
+            .setIndirectStride(desc.getCommandByteStride())
+            .setPipelineLayout(pipeline->pipelineLayout)
+            .setTokenCount(uint32_t(tokens.size()))
+            .setPTokens(tokens.data());
+
+        const vk::Result res = m_Context.device.createIndirectCommandsLayoutEXT(&layoutInfo, m_Context.allocationCallbacks, &signature->layout);
+        if (res != vk::Result::eSuccess)
+        {
+            std::stringstream ss;
+            ss << "Failed to create indirect commands layout " << utils::DebugNameToString(desc.debugName)
+                << ", error code = " << resultToString(VkResult(res));
+            m_Context.error(ss.str());
+            delete signature;
+            return nullptr;
+        }
+
+        m_Context.nameVKObject(VkIndirectCommandsLayoutEXT(signature->layout), vk::ObjectType::eIndirectCommandsLayoutEXT,
+            vk::DebugReportObjectTypeEXT::eUnknown, desc.debugName.c_str());
+
+        return CommandSignatureHandle::Create(signature);
+    }
+
     Object GraphicsPipeline::getNativeObject(ObjectType objectType)
     {
         switch (objectType)
@@ -477,13 +940,13 @@ namespace nvrhi::vulkan
         case ObjectTypes::VK_PipelineLayout:
             return Object(pipelineLayout);
         case ObjectTypes::VK_Pipeline:
-            return Object(pipeline);
+            return Object(getPipeline());
         default:
             return nullptr;
         }
     }
 
-    void CommandList::beginRenderPass(nvrhi::IFramebuffer* _framebuffer)
+    void CommandList::beginRenderPass(nvrhi::IFramebuffer* _framebuffer, vk::RenderingFlags flags)
     {
         endRenderPass();
 
@@ -494,28 +957,82 @@ namespace nvrhi::vulkan
 
         m_CurrentGraphicsState.framebuffer = framebuffer;
         m_CurrentMeshletState.framebuffer = framebuffer;
+        m_RenderPassFramebuffer = framebuffer;
+
+        const bool resume = framebuffer == m_LastRenderPassFramebuffer;
+        m_LastRenderPassFramebuffer = framebuffer;
+
+        if (m_CommandListParameters.isSecondary)
+        {
+            // Secondary command buffers continue the render pass started by the primary command buffer
+            m_CurrentCmdBuf->referencedResources.add(framebuffer);
+            return;
+        }
+
+        // The render pass on the same framebuffer was ended by a copy, clear or barrier
+        if (resume)
+            ++m_Stats.renderPassBreaks;
+
+        const auto& colorAttachments = resume ? framebuffer->resumeColorAttachments : framebuffer->colorAttachments;
+        const auto& depthAttachment = resume ? framebuffer->resumeDepthAttachment : framebuffer->depthAttachment;
+        const auto& stencilAttachment = resume ? framebuffer->resumeStencilAttachment : framebuffer->stencilAttachment;
 
         vk::RenderingInfo renderingInfo = vk::RenderingInfo()
+            .setFlags(flags)
             .setRenderArea(vk::Rect2D()
                 .setOffset(vk::Offset2D(0, 0))
                 .setExtent(vk::Extent2D(framebuffer->framebufferInfo.width, framebuffer->framebufferInfo.height)))
             .setLayerCount(framebuffer->framebufferInfo.arraySize)
-            .setColorAttachmentCount(uint32_t(framebuffer->colorAttachments.size()))
-            .setPColorAttachments(framebuffer->colorAttachments.data())
-            .setPDepthAttachment(framebuffer->depthAttachment.imageView ? &framebuffer->depthAttachment : nullptr)
-            .setPStencilAttachment(framebuffer->stencilAttachment.imageView ? &framebuffer->stencilAttachment : nullptr);
+            .setColorAttachmentCount(uint32_t(colorAttachments.size()))
+            .setPColorAttachments(colorAttachments.data())
+            .setPDepthAttachment(depthAttachment.imageView ? &depthAttachment : nullptr)
+            .setPStencilAttachment(stencilAttachment.imageView ? &stencilAttachment : nullptr);
 
         m_CurrentCmdBuf->cmdBuf.beginRendering(renderingInfo);
-        m_CurrentCmdBuf->referencedResources.push_back(framebuffer);
+        m_CurrentCmdBuf->referencedResources.add(framebuffer);
     }
 
     void CommandList::endRenderPass()
     {
-        if (m_CurrentGraphicsState.framebuffer || m_CurrentMeshletState.framebuffer)
+        if (m_RenderPassFramebuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.endRendering();
-            m_CurrentGraphicsState.framebuffer = nullptr;
-            m_CurrentMeshletState.framebuffer = nullptr;
+            if (!m_CommandListParameters.isSecondary)
+                m_CurrentCmdBuf->cmdBuf.endRendering();
+            m_RenderPassFramebuffer = nullptr;
+        }
+
+        m_CurrentGraphicsState.framebuffer = nullptr;
+        m_CurrentMeshletState.framebuffer = nullptr;
+    }
+
+    void CommandList::prepareRenderPass(Framebuffer* framebuffer)
+    {
+        const bool anyBarriers = this->anyBarriers();
+
+        if (anyBarriers && m_RenderPassFramebuffer && m_RenderPassFramebuffer->discardsAnyAttachment)
+        {
+            m_Context.warning("A render pass with AttachmentStoreOp::DontCare attachments is interrupted for barriers, "
+                "the contents rendered so far are lost. Transition the resources used by the draws before the first draw.");
+        }
+
+        // Barriers cannot be set inside a render pass
+        if (anyBarriers || !canContinueRenderPass(m_RenderPassFramebuffer, framebuffer))
+        {
+            endRenderPass();
+        }
+
+        commitBarriers();
+
+        if (!m_RenderPassFramebuffer)
+        {
+            beginRenderPass(framebuffer);
+        }
+        else if (m_RenderPassFramebuffer != framebuffer)
+        {
+            // Another framebuffer object for the same attachments, keep the render pass
+            m_RenderPassFramebuffer = framebuffer;
+            m_LastRenderPassFramebuffer = framebuffer;
+            m_CurrentCmdBuf->referencedResources.add(framebuffer);
         }
     }
 
@@ -525,8 +1042,132 @@ namespace nvrhi::vulkan
         return vk::Viewport(v.minX, v.maxY, v.maxX - v.minX, -(v.maxY - v.minY), v.minZ, v.maxZ);
     }
 
+    void CommandList::setViewportState(const ViewportState& viewport, const ViewportState& currentViewport)
+    {
+        if (!viewport.viewports.empty() && arraysAreDifferent(viewport.viewports, currentViewport.viewports))
+        {
+            nvrhi::static_vector<vk::Viewport, c_MaxViewports> viewports;
+            for (const auto& vp : viewport.viewports)
+            {
+                viewports.push_back(VKViewportWithDXCoords(vp));
+            }
+
+            m_CurrentCmdBuf->cmdBuf.setViewport(0, uint32_t(viewports.size()), viewports.data());
+        }
+
+        if (!viewport.scissorRects.empty() && arraysAreDifferent(viewport.scissorRects, currentViewport.scissorRects))
+        {
+            nvrhi::static_vector<vk::Rect2D, c_MaxViewports> scissors;
+            for (const auto& sc : viewport.scissorRects)
+            {
+                scissors.push_back(vk::Rect2D(vk::Offset2D(sc.minX, sc.minY),
+                    vk::Extent2D(std::abs(sc.maxX - sc.minX), std::abs(sc.maxY - sc.minY))));
+            }
+
+            m_CurrentCmdBuf->cmdBuf.setScissor(0, uint32_t(scissors.size()), scissors.data());
+        }
+    }
+
+    void CommandList::openSecondary(IFramebuffer* _framebuffer, const ViewportState& viewport)
+    {
+        if (!m_CommandListParameters.isSecondary)
+        {
+            m_Context.error("openSecondary can only be used on command lists created with isSecondary = true");
+            return;
+        }
+
+        Framebuffer* framebuffer = checked_cast<Framebuffer*>(_framebuffer);
+        const FramebufferInfoEx& framebufferInfo = framebuffer->framebufferInfo;
+
+        if (!m_CommandListParameters.isReusable)
+            releaseUnsubmittedRecording();
+
+        m_Stats = CommandListStats();
+        m_StateTracker.resetBarrierCounts();
+
+        m_CurrentCmdBuf = m_Device->getQueue(m_CommandListParameters.queueType)->getOrCreateCommandBuffer(true);
+
+        static_vector<vk::Format, c_MaxRenderTargets> colorFormats;
+        for (Format format : framebufferInfo.colorFormats)
+        {
+            colorFormats.push_back(vk::Format(convertFormat(format)));
+        }
+
+        const FormatInfo& depthFormatInfo = getFormatInfo(framebufferInfo.depthFormat);
+        const vk::Format depthFormat = vk::Format(convertFormat(framebufferInfo.depthFormat));
+
+        auto renderingInheritanceInfo = vk::CommandBufferInheritanceRenderingInfo()
+            .setColorAttachmentCount(uint32_t(colorFormats.size()))
+            .setPColorAttachmentFormats(colorFormats.data())
+            .setDepthAttachmentFormat(depthFormatInfo.hasDepth ? depthFormat : vk::Format::eUndefined)
+            .setStencilAttachmentFormat(depthFormatInfo.hasStencil ? depthFormat : vk::Format::eUndefined)
+            .setRasterizationSamples(vk::SampleCountFlagBits(framebufferInfo.sampleCount));
+
+        auto inheritanceInfo = vk::CommandBufferInheritanceInfo()
+            .setPNext(&renderingInheritanceInfo);
+
+        auto beginInfo = vk::CommandBufferBeginInfo()
+            .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue)
+            .setPInheritanceInfo(&inheritanceInfo);
+
+        (void)m_CurrentCmdBuf->cmdBuf.begin(&beginInfo);
+
+        // Unlike primary command buffers, the secondary one doesn't reference its command list: the primary
+        // command buffer does that when it executes the secondary, so that a secondary command list that is
+        // never executed can still be destroyed and recycle its command buffer.
+
+        clearState();
+        m_LastRenderPassFramebuffer = nullptr;
+
+        m_EnableAutomaticBarriers = false;
+        m_SecondaryFramebuffer = framebuffer;
+        beginRenderPass(framebuffer);
+
+        // Dynamic state is not inherited from the primary command buffer
+        setViewportState(viewport, ViewportState());
+    }
+
+    void CommandList::executeSecondaryCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        assert(m_CurrentCmdBuf);
+
+        endRenderPass();
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* secondary = checked_cast<CommandList*>(pCommandLists[i]);
+            assert(secondary->m_CurrentCmdBuf);
+
+            if (m_RenderPassFramebuffer != secondary->m_SecondaryFramebuffer)
+            {
+                endRenderPass();
+
+                if (m_EnableAutomaticBarriers)
+                {
+                    setResourceStatesForFramebuffer(secondary->m_SecondaryFramebuffer);
+                }
+                commitBarriers();
+
+                beginRenderPass(secondary->m_SecondaryFramebuffer, vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+            }
+
+            m_CurrentCmdBuf->cmdBuf.executeCommands(1, &secondary->m_CurrentCmdBuf->cmdBuf);
+
+            m_CurrentCmdBuf->secondaryCommandBuffers.push_back(secondary->m_CurrentCmdBuf);
+            m_CurrentCmdBuf->referencedResources.add(secondary); // prevent deletion of e.g. its UploadManager
+            m_ExecutedSecondaryCommandLists.push_back(secondary);
+        }
+
+        // The bindings made by the secondary command buffers are not visible to the primary one,
+        // and a render pass with secondary contents can't be continued with inline draws
+        clearState();
+        m_CurrentCmdBuf->descriptorBufferBound = false;
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::setGraphicsState");
+
         assert(m_CurrentCmdBuf);
 
         GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
@@ -537,28 +1178,33 @@ namespace nvrhi::vulkan
             trackResourcesAndBarriers(state);
         }
 
-        bool anyBarriers = this->anyBarriers();
         bool updatePipeline = false;
 
         if (m_CurrentGraphicsState.pipeline != state.pipeline)
         {
-            m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+            // Pipelines created in the dynamic state mode can share the VkPipeline, which doesn't need to be bound again
+            const vk::Pipeline pipeline = pso->getPipeline();
+            if (pipeline != m_CurrentGraphicsPipeline)
+            {
+                m_CurrentGraphicsPipeline = pipeline;
+                m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, m_CurrentGraphicsPipeline);
+                ++m_Stats.pipelineBinds;
+            }
+
+            // Binding a pipeline with static state overwrites the corresponding dynamic state
+            if (!pso->usesDynamicPipelineState)
+                m_CurrentDynamicPipelineState.valid = false;
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
+            m_CurrentCmdBuf->referencedResources.add(state.pipeline);
             updatePipeline = true;
         }
 
-        if (m_CurrentGraphicsState.framebuffer != state.framebuffer || anyBarriers /* because barriers cannot be set inside a renderpass */)
+        if (pso->usesDynamicPipelineState)
         {
-            endRenderPass();
+            setDynamicPipelineState(pso);
         }
 
-        commitBarriers();
-
-        if(!m_CurrentGraphicsState.framebuffer)
-        {
-            beginRenderPass(fb);
-        }
+        prepareRenderPass(fb);
 
         m_CurrentPipelineLayout = pso->pipelineLayout;
         m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
@@ -568,27 +1214,10 @@ namespace nvrhi::vulkan
             bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
         }
 
-        if (!state.viewport.viewports.empty() && arraysAreDifferent(state.viewport.viewports, m_CurrentGraphicsState.viewport.viewports))
+        // Secondary command lists use the viewport state passed to openSecondary
+        if (!m_CommandListParameters.isSecondary)
         {
-            nvrhi::static_vector<vk::Viewport, c_MaxViewports> viewports;
-            for (const auto& vp : state.viewport.viewports)
-            {
-                viewports.push_back(VKViewportWithDXCoords(vp));
-            }
-
-            m_CurrentCmdBuf->cmdBuf.setViewport(0, uint32_t(viewports.size()), viewports.data());
-        }
-
-        if (!state.viewport.scissorRects.empty() && arraysAreDifferent(state.viewport.scissorRects, m_CurrentGraphicsState.viewport.scissorRects))
-        {
-            nvrhi::static_vector<vk::Rect2D, c_MaxViewports> scissors;
-            for (const auto& sc : state.viewport.scissorRects)
-            {
-                scissors.push_back(vk::Rect2D(vk::Offset2D(sc.minX, sc.minY),
-                    vk::Extent2D(std::abs(sc.maxX - sc.minX), std::abs(sc.maxY - sc.minY))));
-            }
-
-            m_CurrentCmdBuf->cmdBuf.setScissor(0, uint32_t(scissors.size()), scissors.data());
+            setViewportState(state.viewport, m_CurrentGraphicsState.viewport);
         }
 
         if (pso->desc.renderState.depthStencilState.dynamicStencilRef && (updatePipeline || m_CurrentGraphicsState.dynamicStencilRefValue != state.dynamicStencilRefValue))
@@ -608,10 +1237,13 @@ namespace nvrhi::vulkan
                 state.indexBuffer.format == Format::R16_UINT ?
                 vk::IndexType::eUint16 : vk::IndexType::eUint32);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.indexBuffer.buffer);
+            m_CurrentCmdBuf->referencedResources.add(state.indexBuffer.buffer);
         }
 
-        if (!state.vertexBuffers.empty() && arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
+        // Binding a pipeline with dynamic strides leaves them undefined, so the vertex buffers have to be bound again
+        const bool updateVertexStrides = pso->usesDynamicVertexStrides && updatePipeline;
+
+        if (!state.vertexBuffers.empty() && (updateVertexStrides || arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers)))
         {
             vk::Buffer vertexBuffers[c_MaxVertexAttributes];
             vk::DeviceSize vertexBufferOffsets[c_MaxVertexAttributes];
@@ -627,15 +1259,23 @@ namespace nvrhi::vulkan
                 vertexBufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
                 maxVbIndex = std::max(maxVbIndex, binding.slot);
 
-                m_CurrentCmdBuf->referencedResources.push_back(binding.buffer);
+                m_CurrentCmdBuf->referencedResources.add(binding.buffer);
             }
 
-            m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
+            if (pso->usesDynamicVertexStrides)
+            {
+                vk::DeviceSize vertexBufferStrides[c_MaxVertexAttributes] = {};
+                getVertexBufferStrides(pso, vertexBufferStrides);
+
+                m_CurrentCmdBuf->cmdBuf.bindVertexBuffers2(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets, nullptr, vertexBufferStrides);
+            }
+            else
+                m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
         }
 
         if (state.indirectParams)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            m_CurrentCmdBuf->referencedResources.add(state.indirectParams);
         }
 
         if (state.shadingRateState.enabled)
@@ -649,9 +1289,264 @@ namespace nvrhi::vulkan
         m_CurrentComputeState = ComputeState();
         m_CurrentMeshletState = MeshletState();
         m_CurrentRayTracingState = rt::State();
+        m_CurrentWorkGraphState = WorkGraphState();
+        m_AnyVolatileBufferWrites = false;
+    }
+
+    static bool rasterStatesDiffer(const RasterState& a, const RasterState& b)
+    {
+        return a.fillMode != b.fillMode
+            || a.cullMode != b.cullMode
+            || a.frontCounterClockwise != b.frontCounterClockwise
+            || a.depthBias != b.depthBias
+            || a.depthBiasClamp != b.depthBiasClamp
+            || a.slopeScaledDepthBias != b.slopeScaledDepthBias
+            || a.conservativeRasterEnable != b.conservativeRasterEnable;
+    }
+
+    static bool stencilOpsDiffer(const DepthStencilState::StencilOpDesc& a, const DepthStencilState::StencilOpDesc& b)
+    {
+        return a.failOp != b.failOp
+            || a.depthFailOp != b.depthFailOp
+            || a.passOp != b.passOp
+            || a.stencilFunc != b.stencilFunc;
+    }
+
+    static bool depthStencilStatesDiffer(const DepthStencilState& a, const DepthStencilState& b)
+    {
+        return a.depthTestEnable != b.depthTestEnable
+            || a.depthWriteEnable != b.depthWriteEnable
+            || a.depthFunc != b.depthFunc
+            || a.stencilEnable != b.stencilEnable
+            || a.stencilReadMask != b.stencilReadMask
+            || a.stencilWriteMask != b.stencilWriteMask
+            || a.stencilRefValue != b.stencilRefValue
+            || a.dynamicStencilRef != b.dynamicStencilRef
+            || stencilOpsDiffer(a.frontFaceStencil, b.frontFaceStencil)
+            || stencilOpsDiffer(a.backFaceStencil, b.backFaceStencil);
+    }
+
+    void CommandList::setDynamicPipelineState(const GraphicsPipeline* pso)
+    {
+        const GraphicsPipelineDesc& desc = pso->desc;
+        DynamicPipelineState& current = m_CurrentDynamicPipelineState;
+        const vk::CommandBuffer cmdBuf = m_CurrentCmdBuf->cmdBuf;
+
+        // Pipelines with static state may have been bound since the last call, replacing all dynamic state
+        const bool setAll = !current.valid;
+
+        if (setAll || current.primType != desc.primType)
+        {
+            cmdBuf.setPrimitiveTopology(convertPrimitiveTopology(desc.primType));
+            current.primType = desc.primType;
+        }
+
+        const RasterState& rasterState = desc.renderState.rasterState;
+        if (setAll || rasterStatesDiffer(current.rasterState, rasterState))
+        {
+            cmdBuf.setCullMode(convertCullMode(rasterState.cullMode));
+            cmdBuf.setFrontFace(rasterState.frontCounterClockwise ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise);
+            cmdBuf.setDepthBiasEnable(rasterState.depthBias ? true : false);
+            cmdBuf.setDepthBias(float(rasterState.depthBias), rasterState.depthBiasClamp, rasterState.slopeScaledDepthBias);
+
+            if (m_Context.dynamicPolygonMode)
+                cmdBuf.setPolygonModeEXT(convertFillMode(rasterState.fillMode));
+
+            if (m_Context.dynamicConservativeRaster)
+            {
+                cmdBuf.setConservativeRasterizationModeEXT(rasterState.conservativeRasterEnable
+                    ? vk::ConservativeRasterizationModeEXT::eOverestimate
+                    : vk::ConservativeRasterizationModeEXT::eDisabled);
+            }
+
+            current.rasterState = rasterState;
+        }
+
+        const DepthStencilState& depthStencilState = desc.renderState.depthStencilState;
+        if (setAll || depthStencilStatesDiffer(current.depthStencilState, depthStencilState))
+        {
+            const vk::StencilOpState front = convertStencilState(depthStencilState, depthStencilState.frontFaceStencil);
+            const vk::StencilOpState back = convertStencilState(depthStencilState, depthStencilState.backFaceStencil);
+
+            cmdBuf.setDepthTestEnable(depthStencilState.depthTestEnable);
+            cmdBuf.setDepthWriteEnable(depthStencilState.depthWriteEnable);
+            cmdBuf.setDepthCompareOp(convertCompareOp(depthStencilState.depthFunc));
+            cmdBuf.setStencilTestEnable(depthStencilState.stencilEnable);
+            cmdBuf.setStencilOp(vk::StencilFaceFlagBits::eFront, front.failOp, front.passOp, front.depthFailOp, front.compareOp);
+            cmdBuf.setStencilOp(vk::StencilFaceFlagBits::eBack, back.failOp, back.passOp, back.depthFailOp, back.compareOp);
+            cmdBuf.setStencilCompareMask(vk::StencilFaceFlagBits::eFrontAndBack, depthStencilState.stencilReadMask);
+            cmdBuf.setStencilWriteMask(vk::StencilFaceFlagBits::eFrontAndBack, depthStencilState.stencilWriteMask);
+
+            // The dynamic reference value comes from GraphicsState and is set by setGraphicsState
+            if (!depthStencilState.dynamicStencilRef)
+                cmdBuf.setStencilReference(vk::StencilFaceFlagBits::eFrontAndBack, depthStencilState.stencilRefValue);
+
+            current.depthStencilState = depthStencilState;
+        }
+
+        const BlendState& blendState = desc.renderState.blendState;
+        const uint32_t numColorTargets = uint32_t(pso->framebufferInfo.colorFormats.size());
+        if (m_Context.dynamicBlendState && (setAll || current.numColorTargets != numColorTargets || current.blendState != blendState))
+        {
+            std::array<vk::Bool32, c_MaxRenderTargets> blendEnables;
+            std::array<vk::ColorBlendEquationEXT, c_MaxRenderTargets> blendEquations;
+            std::array<vk::ColorComponentFlags, c_MaxRenderTargets> writeMasks;
+
+            for (uint32_t i = 0; i < numColorTargets; i++)
+            {
+                const vk::PipelineColorBlendAttachmentState target = convertBlendState(blendState.targets[i]);
+
+                blendEnables[i] = target.blendEnable;
+                blendEquations[i] = vk::ColorBlendEquationEXT()
+                    .setSrcColorBlendFactor(target.srcColorBlendFactor)
+                    .setDstColorBlendFactor(target.dstColorBlendFactor)
+                    .setColorBlendOp(target.colorBlendOp)
+                    .setSrcAlphaBlendFactor(target.srcAlphaBlendFactor)
+                    .setDstAlphaBlendFactor(target.dstAlphaBlendFactor)
+                    .setAlphaBlendOp(target.alphaBlendOp);
+                writeMasks[i] = target.colorWriteMask;
+            }
+
+            if (numColorTargets > 0)
+            {
+                cmdBuf.setColorBlendEnableEXT(0, numColorTargets, blendEnables.data());
+                cmdBuf.setColorBlendEquationEXT(0, numColorTargets, blendEquations.data());
+                cmdBuf.setColorWriteMaskEXT(0, numColorTargets, writeMasks.data());
+            }
+            cmdBuf.setAlphaToCoverageEnableEXT(blendState.alphaToCoverageEnable);
+
+            current.blendState = blendState;
+            current.numColorTargets = numColorTargets;
+        }
+
+        if (m_Context.dynamicVertexInput && (setAll || current.inputLayout != desc.inputLayout))
+        {
+            const InputLayout* inputLayout = checked_cast<const InputLayout*>(desc.inputLayout.Get());
+            if (inputLayout)
+            {
+                cmdBuf.setVertexInputEXT(
+                    uint32_t(inputLayout->bindingDesc2.size()), inputLayout->bindingDesc2.data(),
+                    uint32_t(inputLayout->attributeDesc2.size()), inputLayout->attributeDesc2.data());
+            }
+            else
+                cmdBuf.setVertexInputEXT(0, nullptr, 0, nullptr);
+
+            current.inputLayout = desc.inputLayout;
+        }
+
+        current.valid = true;
+    }
+
+    void CommandList::commitGraphicsStateBarriers()
+    {
+        if (!anyBarriers())
+            return;
+
+        // Barriers cannot be set inside a render pass, so interrupt it
+        prepareRenderPass(m_RenderPassFramebuffer);
+    }
+
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        assert(m_CurrentCmdBuf);
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+        assert(pso);
+        assert(slot < c_MaxBindingLayouts);
+
+        if (slot < m_CurrentGraphicsState.bindings.size() && m_CurrentGraphicsState.bindings[slot] == bindingSet && !m_AnyVolatileBufferWrites)
+            return;
+
+        while (m_CurrentGraphicsState.bindings.size() <= slot)
+            m_CurrentGraphicsState.bindings.push_back(nullptr);
+
+        m_CurrentGraphicsState.bindings[slot] = bindingSet;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            setResourceStatesForBindingSet(bindingSet);
+        }
+
+        commitGraphicsStateBarriers();
+
+        bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentGraphicsState.bindings, pso->descriptorSetIdxToBindingIdx);
         m_AnyVolatileBufferWrites = false;
     }
 
+    void CommandList::setVertexBuffers(const VertexBufferBinding* pBindings, size_t numBindings)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            for (size_t i = 0; i < numBindings; i++)
+            {
+                requireBufferState(pBindings[i].buffer, ResourceStates::VertexBuffer);
+            }
+        }
+
+        commitGraphicsStateBarriers();
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+
+        for (size_t i = 0; i < numBindings; i++)
+        {
+            const VertexBufferBinding& binding = pBindings[i];
+
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            auto current = std::find_if(m_CurrentGraphicsState.vertexBuffers.begin(), m_CurrentGraphicsState.vertexBuffers.end(),
+                [&binding](const VertexBufferBinding& vb) { return vb.slot == binding.slot; });
+
+            if (current == m_CurrentGraphicsState.vertexBuffers.end())
+                m_CurrentGraphicsState.vertexBuffers.push_back(binding);
+            else if (*current != binding)
+                *current = binding;
+            else
+                continue;
+
+            vk::Buffer buffer = checked_cast<Buffer*>(binding.buffer)->buffer;
+            vk::DeviceSize offset = vk::DeviceSize(binding.offset);
+
+            if (pso->usesDynamicVertexStrides)
+            {
+                vk::DeviceSize strides[c_MaxVertexAttributes] = {};
+                getVertexBufferStrides(pso, strides);
+
+                m_CurrentCmdBuf->cmdBuf.bindVertexBuffers2(binding.slot, 1, &buffer, &offset, nullptr, &strides[binding.slot]);
+            }
+            else
+                m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(binding.slot, 1, &buffer, &offset);
+
+            m_CurrentCmdBuf->referencedResources.add(binding.buffer);
+        }
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!binding.buffer || m_CurrentGraphicsState.indexBuffer == binding)
+            return;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(binding.buffer, ResourceStates::IndexBuffer);
+        }
+
+        commitGraphicsStateBarriers();
+
+        m_CurrentCmdBuf->cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(binding.buffer)->buffer,
+            binding.offset,
+            binding.format == Format::R16_UINT ?
+            vk::IndexType::eUint16 : vk::IndexType::eUint32);
+
+        m_CurrentCmdBuf->referencedResources.add(binding.buffer);
+        m_CurrentGraphicsState.indexBuffer = binding;
+    }
+
     void CommandList::updateGraphicsVolatileBuffers()
     {
         if (m_AnyVolatileBufferWrites && m_CurrentGraphicsState.pipeline)
@@ -669,6 +1564,7 @@ namespace nvrhi::vulkan
         assert(m_CurrentCmdBuf);
 
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         m_CurrentCmdBuf->cmdBuf.draw(args.vertexCount,
             args.instanceCount,
@@ -681,6 +1577,7 @@ namespace nvrhi::vulkan
         assert(m_CurrentCmdBuf);
 
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         m_CurrentCmdBuf->cmdBuf.drawIndexed(args.vertexCount,
             args.instanceCount,
@@ -689,11 +1586,117 @@ namespace nvrhi::vulkan
             args.startInstanceLocation);
     }
 
+    bool CommandList::canUseMultiDraw(const DrawArguments* args, size_t count, const void* pushConstants) const
+    {
+        // vkCmdDrawMulti*EXT takes one instance range for all draws and cannot interleave push constants
+        if (!m_Context.multiDraw || pushConstants || count < 2)
+            return false;
+
+        for (size_t i = 1; i < count; i++)
+        {
+            if (args[i].instanceCount != args[0].instanceCount || args[i].startInstanceLocation != args[0].startInstanceLocation)
+                return false;
+        }
+
+        return true;
+    }
+
+    void CommandList::drawBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        assert(m_CurrentCmdBuf);
+
+        updateGraphicsVolatileBuffers();
+        m_Stats.drawCalls += count;
+
+        if (canUseMultiDraw(args, count, pushConstants))
+        {
+            m_MultiDrawInfos.resize(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                m_MultiDrawInfos[i].firstVertex = args[i].startVertexLocation;
+                m_MultiDrawInfos[i].vertexCount = args[i].vertexCount;
+            }
+
+            const size_t maxDrawCount = std::max<size_t>(m_Context.multiDrawProperties.maxMultiDrawCount, 1);
+            for (size_t first = 0; first < count; first += maxDrawCount)
+            {
+                const uint32_t drawCount = uint32_t(std::min(count - first, maxDrawCount));
+                m_CurrentCmdBuf->cmdBuf.drawMultiEXT(drawCount, m_MultiDrawInfos.data() + first,
+                    args[0].instanceCount, args[0].startInstanceLocation, sizeof(vk::MultiDrawInfoEXT));
+            }
+            return;
+        }
+
+        if (pushConstantStride == 0)
+            pushConstantStride = pushConstantByteSize;
+
+        const uint8_t* pushConstantData = static_cast<const uint8_t*>(pushConstants);
+        vk::CommandBuffer cmdBuf = m_CurrentCmdBuf->cmdBuf;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pushConstantData)
+            {
+                cmdBuf.pushConstants(m_CurrentPipelineLayout, m_CurrentPushConstantsVisibility, 0, uint32_t(pushConstantByteSize), pushConstantData);
+                pushConstantData += pushConstantStride;
+            }
+
+            cmdBuf.draw(args[i].vertexCount, args[i].instanceCount, args[i].startVertexLocation, args[i].startInstanceLocation);
+        }
+    }
+
+    void CommandList::drawIndexedBatch(const DrawArguments* args, size_t count, const void* pushConstants, size_t pushConstantByteSize, size_t pushConstantStride)
+    {
+        assert(m_CurrentCmdBuf);
+
+        updateGraphicsVolatileBuffers();
+        m_Stats.drawCalls += count;
+
+        if (canUseMultiDraw(args, count, pushConstants))
+        {
+            m_MultiDrawIndexedInfos.resize(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                m_MultiDrawIndexedInfos[i].firstIndex = args[i].startIndexLocation;
+                m_MultiDrawIndexedInfos[i].indexCount = args[i].vertexCount;
+                m_MultiDrawIndexedInfos[i].vertexOffset = int32_t(args[i].startVertexLocation);
+            }
+
+            const size_t maxDrawCount = std::max<size_t>(m_Context.multiDrawProperties.maxMultiDrawCount, 1);
+            for (size_t first = 0; first < count; first += maxDrawCount)
+            {
+                const uint32_t drawCount = uint32_t(std::min(count - first, maxDrawCount));
+                m_CurrentCmdBuf->cmdBuf.drawMultiIndexedEXT(drawCount, m_MultiDrawIndexedInfos.data() + first,
+                    args[0].instanceCount, args[0].startInstanceLocation, sizeof(vk::MultiDrawIndexedInfoEXT), nullptr);
+            }
+            return;
+        }
+
+        if (pushConstantStride == 0)
+            pushConstantStride = pushConstantByteSize;
+
+        const uint8_t* pushConstantData = static_cast<const uint8_t*>(pushConstants);
+        vk::CommandBuffer cmdBuf = m_CurrentCmdBuf->cmdBuf;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pushConstantData)
+            {
+                cmdBuf.pushConstants(m_CurrentPipelineLayout, m_CurrentPushConstantsVisibility, 0, uint32_t(pushConstantByteSize), pushConstantData);
+                pushConstantData += pushConstantStride;
+            }
+
+            cmdBuf.drawIndexed(args[i].vertexCount, args[i].instanceCount, args[i].startIndexLocation,
+                int32_t(args[i].startVertexLocation), args[i].startInstanceLocation);
+        }
+    }
+
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
         assert(m_CurrentCmdBuf);
 
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
         assert(indirectParams);
@@ -706,6 +1709,7 @@ namespace nvrhi::vulkan
         assert(m_CurrentCmdBuf);
 
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
         assert(indirectParams);
@@ -718,6 +1722,7 @@ namespace nvrhi::vulkan
         assert(m_CurrentCmdBuf);
 
         updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
 
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
         Buffer* countBuf = checked_cast<Buffer*>(countBuffer);
@@ -734,4 +1739,92 @@ namespace nvrhi::vulkan
         );
     }
 
+    void CommandList::executeIndirect(ICommandSignature* _signature, uint32_t offsetBytes, uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countBufferOffset)
+    {
+        assert(m_CurrentCmdBuf);
+        assert(m_PreprocessManager); // the device doesn't create signatures without VK_EXT_device_generated_commands
+
+        CommandSignature* signature = checked_cast<CommandSignature*>(_signature);
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* countBuf = checked_cast<Buffer*>(countBuffer);
+        assert(signature);
+        assert(indirectParams);
+
+        if (maxCommandCount == 0)
+            return;
+
+        updateGraphicsVolatileBuffers();
+        ++m_Stats.drawCalls;
+
+        auto pipelineInfo = vk::GeneratedCommandsPipelineInfoEXT()
+            .setPipeline(m_CurrentGraphicsPipeline);
+
+        auto memoryRequirementsInfo = vk::GeneratedCommandsMemoryRequirementsInfoEXT()
+            .setPNext(&pipelineInfo)
+            .setIndirectCommandsLayout(signature->layout)
+            .setMaxSequenceCount(maxCommandCount);
+
+        vk::MemoryRequirements2 memoryRequirements;
+        m_Context.device.getGeneratedCommandsMemoryRequirementsEXT(&memoryRequirementsInfo, &memoryRequirements);
+
+        Buffer* preprocessBuffer = nullptr;
+        uint64_t preprocessOffset = 0;
+        const uint64_t preprocessSize = memoryRequirements.memoryRequirements.size;
+
+        if (preprocessSize > 0)
+        {
+            const uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+
+            if (!m_PreprocessManager->suballocateBuffer(preprocessSize, &preprocessBuffer, &preprocessOffset, nullptr,
+                currentVersion, uint32_t(memoryRequirements.memoryRequirements.alignment)))
+            {
+                std::stringstream ss;
+                ss << "Couldn't suballocate a preprocess buffer for executeIndirect. "
+                    "The commands require " << preprocessSize << " bytes of preprocess memory.";
+
+                m_Context.error(ss.str());
+                return;
+            }
+        }
+
+        const uint32_t stride = signature->desc.getCommandByteStride();
+
+        auto generatedCommandsInfo = vk::GeneratedCommandsInfoEXT()
+            .setPNext(&pipelineInfo)
+            .setShaderStages(signature->shaderStages)
+            .setIndirectCommandsLayout(signature->layout)
+            .setIndirectAddress(indirectParams->deviceAddress + offsetBytes)
+            .setIndirectAddressSize(uint64_t(stride) * maxCommandCount)
+            .setPreprocessAddress(preprocessBuffer ? preprocessBuffer->deviceAddress + preprocessOffset : 0)
+            .setPreprocessSize(preprocessSize)
+            .setMaxSequenceCount(maxCommandCount)
+            .setSequenceCountAddress(countBuf ? countBuf->deviceAddress + countBufferOffset : 0);
+
+        m_CurrentCmdBuf->cmdBuf.executeGeneratedCommandsEXT(VK_FALSE, generatedCommandsInfo);
+
+        m_CurrentCmdBuf->referencedResources.add(signature);
+        if (countBuf)
+            m_CurrentCmdBuf->referencedResources.add(countBuf);
+
+        // The state changed by the tokens is undefined after the generated commands,
+        // so make sure the next setGraphicsState or setVertexBuffers call binds it again.
+        static_vector<VertexBufferBinding, c_MaxVertexAttributes> remainingVertexBuffers;
+        for (const auto& vb : m_CurrentGraphicsState.vertexBuffers)
+        {
+            bool overwritten = false;
+            for (const auto& arg : signature->desc.arguments)
+                overwritten = overwritten || (arg.type == IndirectArgumentType::VertexBuffer && arg.slot == vb.slot);
+
+            if (!overwritten)
+                remainingVertexBuffers.push_back(vb);
+        }
+        m_CurrentGraphicsState.vertexBuffers = remainingVertexBuffers;
+
+        for (const auto& arg : signature->desc.arguments)
+        {
+            if (arg.type == IndirectArgumentType::IndexBuffer)
+                m_CurrentGraphicsState.indexBuffer = IndexBufferBinding();
+        }
+    }
+
 } // namespace nvrhi::vulkan
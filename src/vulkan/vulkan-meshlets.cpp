@@ -27,7 +27,9 @@ namespace nvrhi::vulkan
 {
     MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
-        if (!m_Context.extensions.NV_mesh_shader)
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::createMeshletPipeline");
+
+        if (!m_Context.extensions.NV_mesh_shader && !m_Context.extensions.EXT_mesh_shader)
         {
             utils::NotSupported();
             return nullptr;
@@ -37,6 +39,7 @@ namespace nvrhi::vulkan
 
         MeshletPipeline *pso = new MeshletPipeline(m_Context);
         pso->desc = desc;
+        pso->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::MeshletPipeline);
         pso->framebufferInfo = fbinfo;
 
         Shader* AS = checked_cast<Shader*>(desc.AS.Get());
@@ -183,6 +186,7 @@ namespace nvrhi::vulkan
             .setPDepthStencilState(&depthStencil)
             .setPColorBlendState(&colorBlend)
             .setPDynamicState(&dynamicStateInfo)
+            .setFlags(m_Context.getPipelineCreateFlags())
             .setLayout(pso->pipelineLayout)
             .setBasePipelineHandle(nullptr)
             .setBasePipelineIndex(-1);
@@ -252,28 +256,22 @@ namespace nvrhi::vulkan
             trackResourcesAndBarriers(state);
         }
 
-        bool anyBarriers = this->anyBarriers();
         bool updatePipeline = false;
 
         if (m_CurrentMeshletState.pipeline != state.pipeline)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+            ++m_Stats.pipelineBinds;
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
-            updatePipeline = true;
-        }
+            // The meshlet pipeline replaces the bound graphics pipeline and its dynamic state
+            m_CurrentGraphicsPipeline = vk::Pipeline();
+            m_CurrentDynamicPipelineState.valid = false;
 
-        if (m_CurrentMeshletState.framebuffer != state.framebuffer || anyBarriers /* because barriers cannot be set inside a renderpass */)
-        {
-            endRenderPass();
+            m_CurrentCmdBuf->referencedResources.add(state.pipeline);
+            updatePipeline = true;
         }
 
-        commitBarriers();
-
-        if(!m_CurrentMeshletState.framebuffer)
-        {
-            beginRenderPass(fb);
-        }
+        prepareRenderPass(fb);
 
         m_CurrentPipelineLayout = pso->pipelineLayout;
         m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
@@ -318,13 +316,19 @@ namespace nvrhi::vulkan
 
         if (state.indirectParams)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            m_CurrentCmdBuf->referencedResources.add(state.indirectParams);
+        }
+
+        if (state.indirectCountBuffer)
+        {
+            m_CurrentCmdBuf->referencedResources.add(state.indirectCountBuffer);
         }
 
         m_CurrentComputeState = ComputeState();
         m_CurrentGraphicsState = GraphicsState();
         m_CurrentMeshletState = state;
         m_CurrentRayTracingState = rt::State();
+        m_CurrentWorkGraphState = WorkGraphState();
         m_AnyVolatileBufferWrites = false;
     }
 
@@ -344,16 +348,73 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
+        if (m_Context.extensions.EXT_mesh_shader)
+        {
+            updateMeshletVolatileBuffers();
+            ++m_Stats.dispatches;
+
+            m_CurrentCmdBuf->cmdBuf.drawMeshTasksEXT(groupsX, groupsY, groupsZ);
+            return;
+        }
+
         if (groupsY > 1 || groupsZ > 1)
         {
-            // only 1D dispatches are supported by Vulkan
+            // only 1D dispatches are supported by VK_NV_mesh_shader
             utils::NotSupported();
             return;
         }
 
         updateMeshletVolatileBuffers();
+        ++m_Stats.dispatches;
 
         m_CurrentCmdBuf->cmdBuf.drawMeshTasksNV(groupsX, 0);
     }
 
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_Context.extensions.EXT_mesh_shader)
+        {
+            utils::NotSupported();
+            return;
+        }
+
+        updateMeshletVolatileBuffers();
+        ++m_Stats.dispatches;
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams);
+
+        m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectEXT(indirectParams->buffer, offsetBytes, dispatchCount, sizeof(DispatchIndirectArguments));
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t offsetBytes, uint32_t countBufferOffset, uint32_t maxDispatchCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_Context.extensions.EXT_mesh_shader)
+        {
+            utils::NotSupported();
+            return;
+        }
+
+        updateMeshletVolatileBuffers();
+        ++m_Stats.dispatches;
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+        assert(indirectParams);
+        assert(countBuffer);
+
+        m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountEXT(
+            indirectParams->buffer,
+            offsetBytes,
+            countBuffer->buffer,
+            countBufferOffset,
+            maxDispatchCount,
+            sizeof(DispatchIndirectArguments)
+        );
+    }
+
 } // namespace nvrhi::vulkan
@@ -0,0 +1,408 @@
+/*
+* Copyright (c) 2014-2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::vulkan
+{
+    static bool isDynamicStateInSubset(vk::DynamicState state, vk::GraphicsPipelineLibraryFlagsEXT subset)
+    {
+        switch (state)
+        {
+        case vk::DynamicState::eVertexInputBindingStride:
+            return bool(subset & vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface);
+        case vk::DynamicState::eViewport:
+        case vk::DynamicState::eScissor:
+            return bool(subset & vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders);
+        case vk::DynamicState::eFragmentShadingRateKHR:
+            return bool(subset & (vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders | vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader));
+        case vk::DynamicState::eStencilReference:
+            return bool(subset & vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader);
+        case vk::DynamicState::eBlendConstants:
+            return bool(subset & vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface);
+        default:
+            return true;
+        }
+    }
+
+    static void hashShadingRateState(size_t& hash, const VariableRateShadingState& state)
+    {
+        hash_combine(hash, state.enabled);
+        if (state.enabled)
+        {
+            hash_combine(hash, state.shadingRate);
+            hash_combine(hash, state.pipelinePrimitiveCombiner);
+            hash_combine(hash, state.imageCombiner);
+        }
+    }
+
+    GraphicsPipelineLibraryCache::GraphicsPipelineLibraryCache(const VulkanContext& context)
+        : m_Context(context)
+    {
+        m_OptimizeThread = std::thread(&GraphicsPipelineLibraryCache::optimizeThreadProc, this);
+    }
+
+    GraphicsPipelineLibraryCache::~GraphicsPipelineLibraryCache()
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_ShuttingDown = true;
+            m_OptimizeJobs.clear();
+        }
+
+        m_JobsAvailable.notify_all();
+        m_OptimizeThread.join();
+
+        for (auto& [hash, library] : m_Libraries)
+        {
+            m_Context.device.destroyPipeline(library.pipeline, m_Context.allocationCallbacks);
+            if (library.pipelineLayout)
+                m_Context.device.destroyPipelineLayout(library.pipelineLayout, m_Context.allocationCallbacks);
+        }
+    }
+
+    vk::Result GraphicsPipelineLibraryCache::getLibrary(size_t hash, vk::GraphicsPipelineLibraryFlagsEXT subset,
+        const GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo, vk::Pipeline& outLibrary)
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            const auto it = m_Libraries.find(hash);
+            if (it != m_Libraries.end())
+            {
+                outLibrary = it->second.pipeline;
+                return vk::Result::eSuccess;
+            }
+        }
+
+        // Create the library without holding the lock, so that other threads can create their pipelines in parallel
+
+        Library library;
+
+        // The rendering info and the shading rate state in the pNext chain are consumed by the subsets that need them
+        auto libraryInfo = vk::GraphicsPipelineLibraryCreateInfoEXT()
+            .setPNext(pipelineInfo.pNext)
+            .setFlags(subset);
+        
+        auto info = vk::GraphicsPipelineCreateInfo()
+            .setPNext(&libraryInfo)
+            .setFlags(vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT
+                | m_Context.getPipelineCreateFlags())
+            .setBasePipelineIndex(-1);
+
+        static_vector<vk::PipelineShaderStageCreateInfo, 5> shaderStages;
+        const bool isPreRasterization = bool(subset & vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders);
+        const bool isFragmentShader = bool(subset & vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader);
+
+        for (uint32_t i = 0; i < pipelineInfo.stageCount; i++)
+        {
+            const vk::PipelineShaderStageCreateInfo& stage = pipelineInfo.pStages[i];
+            const bool isFragmentStage = stage.stage == vk::ShaderStageFlagBits::eFragment;
+            if (isFragmentStage ? isFragmentShader : isPreRasterization)
+                shaderStages.push_back(stage);
+        }
+
+        info.setStageCount(uint32_t(shaderStages.size()))
+            .setPStages(shaderStages.data());
+
+        if (subset & vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface)
+        {
+            info.setPVertexInputState(pipelineInfo.pVertexInputState)
+                .setPInputAssemblyState(pipelineInfo.pInputAssemblyState);
+
+            if (pso->desc.inputLayout)
+                library.references.push_back(pso->desc.inputLayout);
+        }
+
+        if (isPreRasterization)
+        {
+            info.setPViewportState(pipelineInfo.pViewportState)
+                .setPRasterizationState(pipelineInfo.pRasterizationState)
+                .setPTessellationState(pipelineInfo.pTessellationState);
+
+            if (pso->desc.VS) library.references.push_back(pso->desc.VS);
+            if (pso->desc.HS) library.references.push_back(pso->desc.HS);
+            if (pso->desc.DS) library.references.push_back(pso->desc.DS);
+            if (pso->desc.GS) library.references.push_back(pso->desc.GS);
+        }
+
+        if (isFragmentShader)
+        {
+            info.setPDepthStencilState(pipelineInfo.pDepthStencilState)
+                .setPMultisampleState(pipelineInfo.pMultisampleState);
+
+            if (pso->desc.PS) library.references.push_back(pso->desc.PS);
+        }
+
+        if (subset & vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface)
+        {
+            info.setPColorBlendState(pipelineInfo.pColorBlendState)
+                .setPMultisampleState(pipelineInfo.pMultisampleState);
+        }
+
+        static_vector<vk::DynamicState, 8> dynamicStates;
+        if (pipelineInfo.pDynamicState)
+        {
+            for (uint32_t i = 0; i < pipelineInfo.pDynamicState->dynamicStateCount; i++)
+            {
+                const vk::DynamicState state = pipelineInfo.pDynamicState->pDynamicStates[i];
+                if (isDynamicStateInSubset(state, subset))
+                    dynamicStates.push_back(state);
+            }
+        }
+
+        auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo()
+            .setDynamicStateCount(uint32_t(dynamicStates.size()))
+            .setPDynamicStates(dynamicStates.data());
+        info.setPDynamicState(&dynamicStateInfo);
+
+        vk::Result res;
+
+        // The shader subsets need a pipeline layout, which must be identically defined to the one of the linked pipelines.
+        // Create a separate one from the same binding layouts because the library outlives the pipeline.
+        if (isPreRasterization || isFragmentShader)
+        {
+            BindingVector<RefCountPtr<BindingLayout>> pipelineBindingLayouts;
+            vk::ShaderStageFlags pushConstantVisibility;
+            BindingVector<uint32_t> descriptorSetIdxToBindingIdx;
+
+            res = createPipelineLayout(
+                library.pipelineLayout,
+                pipelineBindingLayouts,
+                pushConstantVisibility,
+                descriptorSetIdxToBindingIdx,
+                m_Context,
+                pso->desc.bindingLayouts);
+
+            if (res != vk::Result::eSuccess)
+                return res;
+
+            info.setLayout(library.pipelineLayout);
+
+            for (const BindingLayoutHandle& bindingLayout : pso->desc.bindingLayouts)
+                library.references.push_back(bindingLayout);
+        }
+
+        res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+            1, &info,
+            m_Context.allocationCallbacks,
+            &library.pipeline);
+
+        if (res != vk::Result::eSuccess)
+        {
+            if (library.pipelineLayout)
+                m_Context.device.destroyPipelineLayout(library.pipelineLayout, m_Context.allocationCallbacks);
+            return res;
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Another thread could have created the same library in the meantime, use the first one
+        const auto [it, inserted] = m_Libraries.try_emplace(hash, library);
+        if (!inserted)
+        {
+            m_Context.device.destroyPipeline(library.pipeline, m_Context.allocationCallbacks);
+            if (library.pipelineLayout)
+                m_Context.device.destroyPipelineLayout(library.pipelineLayout, m_Context.allocationCallbacks);
+        }
+
+        outLibrary = it->second.pipeline;
+        return vk::Result::eSuccess;
+    }
+
+    vk::Result GraphicsPipelineLibraryCache::createPipeline(GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo)
+    {
+        const GraphicsPipelineDesc& desc = pso->desc;
+        const FramebufferInfo& fbinfo = pso->framebufferInfo;
+        const RasterState& rasterState = desc.renderState.rasterState;
+        const DepthStencilState& depthStencilState = desc.renderState.depthStencilState;
+        const BlendState& blendState = desc.renderState.blendState;
+
+        // The hashes start with the subset bit, so that the libraries of different subsets never collide
+        size_t vertexInputHash = size_t(vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface);
+        hash_combine(vertexInputHash, desc.inputLayout.Get());
+        hash_combine(vertexInputHash, desc.primType);
+        hash_combine(vertexInputHash, pso->usesDynamicVertexStrides);
+
+        size_t preRasterizationHash = size_t(vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders);
+        hash_combine(preRasterizationHash, desc.VS.Get());
+        hash_combine(preRasterizationHash, desc.HS.Get());
+        hash_combine(preRasterizationHash, desc.DS.Get());
+        hash_combine(preRasterizationHash, desc.GS.Get());
+        hash_combine(preRasterizationHash, desc.primType == PrimitiveType::PatchList ? desc.patchControlPoints : 0u);
+        hash_combine(preRasterizationHash, rasterState.fillMode);
+        hash_combine(preRasterizationHash, rasterState.cullMode);
+        hash_combine(preRasterizationHash, rasterState.frontCounterClockwise);
+        hash_combine(preRasterizationHash, rasterState.depthBias);
+        hash_combine(preRasterizationHash, rasterState.depthBiasClamp);
+        hash_combine(preRasterizationHash, rasterState.slopeScaledDepthBias);
+        hash_combine(preRasterizationHash, rasterState.conservativeRasterEnable);
+        hashShadingRateState(preRasterizationHash, desc.shadingRateState);
+
+        size_t fragmentShaderHash = size_t(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader);
+        hash_combine(fragmentShaderHash, desc.PS.Get());
+        hash_combine(fragmentShaderHash, depthStencilState.depthTestEnable);
+        hash_combine(fragmentShaderHash, depthStencilState.depthWriteEnable);
+        hash_combine(fragmentShaderHash, depthStencilState.depthFunc);
+        hash_combine(fragmentShaderHash, depthStencilState.stencilEnable);
+        hash_combine(fragmentShaderHash, depthStencilState.stencilReadMask);
+        hash_combine(fragmentShaderHash, depthStencilState.stencilWriteMask);
+        hash_combine(fragmentShaderHash, depthStencilState.dynamicStencilRef ? 0 : depthStencilState.stencilRefValue);
+        hash_combine(fragmentShaderHash, depthStencilState.dynamicStencilRef);
+        for (const DepthStencilState::StencilOpDesc* stencilOp : { &depthStencilState.frontFaceStencil, &depthStencilState.backFaceStencil })
+        {
+            hash_combine(fragmentShaderHash, stencilOp->failOp);
+            hash_combine(fragmentShaderHash, stencilOp->depthFailOp);
+            hash_combine(fragmentShaderHash, stencilOp->passOp);
+            hash_combine(fragmentShaderHash, stencilOp->stencilFunc);
+        }
+        hash_combine(fragmentShaderHash, fbinfo.depthFormat);
+        hashShadingRateState(fragmentShaderHash, desc.shadingRateState);
+
+        // The multisample state must be identical in the fragment shader and fragment output libraries
+        size_t fragmentOutputHash = size_t(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface);
+        for (size_t* hash : { &fragmentShaderHash, &fragmentOutputHash })
+        {
+            hash_combine(*hash, fbinfo.sampleCount);
+            hash_combine(*hash, blendState.alphaToCoverageEnable);
+        }
+        
+        for (uint32_t i = 0; i < uint32_t(fbinfo.colorFormats.size()); i++)
+        {
+            const BlendState::RenderTarget& target = blendState.targets[i];
+            hash_combine(fragmentOutputHash, fbinfo.colorFormats[i]);
+            hash_combine(fragmentOutputHash, target.blendEnable);
+            hash_combine(fragmentOutputHash, target.srcBlend);
+            hash_combine(fragmentOutputHash, target.destBlend);
+            hash_combine(fragmentOutputHash, target.blendOp);
+            hash_combine(fragmentOutputHash, target.srcBlendAlpha);
+            hash_combine(fragmentOutputHash, target.destBlendAlpha);
+            hash_combine(fragmentOutputHash, target.blendOpAlpha);
+            hash_combine(fragmentOutputHash, target.colorWriteMask);
+        }
+        hash_combine(fragmentOutputHash, fbinfo.depthFormat);
+        hash_combine(fragmentOutputHash, pso->usesBlendConstants);
+
+        // Both shader subsets depend on the pipeline layout
+        for (const BindingLayoutHandle& bindingLayout : desc.bindingLayouts)
+        {
+            hash_combine(preRasterizationHash, bindingLayout.Get());
+            hash_combine(fragmentShaderHash, bindingLayout.Get());
+        }
+
+        std::array<vk::Pipeline, 4> libraries;
+        vk::Result res;
+
+        res = getLibrary(vertexInputHash, vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface, pso, pipelineInfo, libraries[0]);
+        if (res != vk::Result::eSuccess)
+            return res;
+
+        res = getLibrary(preRasterizationHash, vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders, pso, pipelineInfo, libraries[1]);
+        if (res != vk::Result::eSuccess)
+            return res;
+
+        res = getLibrary(fragmentShaderHash, vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader, pso, pipelineInfo, libraries[2]);
+        if (res != vk::Result::eSuccess)
+            return res;
+
+        res = getLibrary(fragmentOutputHash, vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface, pso, pipelineInfo, libraries[3]);
+        if (res != vk::Result::eSuccess)
+            return res;
+
+        auto libraryInfo = vk::PipelineLibraryCreateInfoKHR()
+            .setLibraryCount(uint32_t(libraries.size()))
+            .setPLibraries(libraries.data());
+
+        auto linkInfo = vk::GraphicsPipelineCreateInfo()
+            .setPNext(&libraryInfo)
+            .setFlags(m_Context.getPipelineCreateFlags())
+            .setLayout(pso->pipelineLayout)
+            .setBasePipelineIndex(-1);
+
+        res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+            1, &linkInfo,
+            m_Context.allocationCallbacks,
+            &pso->pipeline);
+
+        if (res != vk::Result::eSuccess)
+            return res;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            OptimizeJob& job = m_OptimizeJobs.emplace_back();
+            job.pso = pso;
+            job.libraries = libraries;
+        }
+
+        m_JobsAvailable.notify_one();
+
+        return vk::Result::eSuccess;
+    }
+
+    void GraphicsPipelineLibraryCache::optimizeThreadProc()
+    {
+        std::unique_lock lock(m_Mutex);
+
+        while (true)
+        {
+            m_JobsAvailable.wait(lock, [this]() { return m_ShuttingDown || !m_OptimizeJobs.empty(); });
+
+            if (m_ShuttingDown)
+                return;
+
+            OptimizeJob job = std::move(m_OptimizeJobs.front());
+            m_OptimizeJobs.pop_front();
+
+            lock.unlock();
+
+            auto libraryInfo = vk::PipelineLibraryCreateInfoKHR()
+                .setLibraryCount(uint32_t(job.libraries.size()))
+                .setPLibraries(job.libraries.data());
+
+            auto linkInfo = vk::GraphicsPipelineCreateInfo()
+                .setPNext(&libraryInfo)
+                .setFlags(vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT | m_Context.getPipelineCreateFlags())
+                .setLayout(job.pso->pipelineLayout)
+                .setBasePipelineIndex(-1);
+
+            vk::Pipeline optimizedPipeline;
+            const vk::Result res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+                1, &linkInfo,
+                m_Context.allocationCallbacks,
+                &optimizedPipeline);
+
+            if (res == vk::Result::eSuccess)
+                job.pso->optimizedPipeline.store(VkPipeline(optimizedPipeline), std::memory_order_release);
+            else
+                m_Context.warning("Failed to create a link-time optimized graphics pipeline, the fast-linked version will be used");
+
+            // Release the pipeline before taking the lock, in case it's the last reference
+            job.pso = nullptr;
+
+            lock.lock();
+        }
+    }
+
+} // namespace nvrhi::vulkan
@@ -23,12 +23,17 @@
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
 
+#include <algorithm>
+#include <chrono>
+
 namespace nvrhi::vulkan
 {
 
     EventQueryHandle Device::createEventQuery(void)
     {
-        EventQuery *query = new EventQuery();
+        EventQuery* query = m_EventQueryPool->acquire();
+        query->ticket = SubmissionTicket();
+        query->started = false;
         return EventQueryHandle::Create(query);
     }
 
@@ -36,31 +41,27 @@ namespace nvrhi::vulkan
     {
         EventQuery* query = checked_cast<EventQuery*>(_query);
 
-        assert(query->commandListID == 0);
+        assert(!query->started);
 
-        query->queue = queue;
-        query->commandListID = m_Queues[uint32_t(queue)]->getLastSubmittedID();
+        query->ticket = getSubmissionTicket(queue);
+        query->started = true;
     }
 
     bool Device::pollEventQuery(IEventQuery* _query)
     {
         EventQuery* query = checked_cast<EventQuery*>(_query);
         
-        auto& queue = *m_Queues[uint32_t(query->queue)];
-
-        return queue.pollCommandList(query->commandListID);
+        return query->started && pollSubmission(query->ticket);
     }
 
     void Device::waitEventQuery(IEventQuery* _query)
     {
         EventQuery* query = checked_cast<EventQuery*>(_query);
 
-        if (query->commandListID == 0)
+        if (!query->started)
             return;
 
-        auto& queue = *m_Queues[uint32_t(query->queue)];
-
-        bool success = queue.waitCommandList(query->commandListID, ~0ull);
+        bool success = waitForAll(&query->ticket, 1, ~0ull);
         assert(success);
         (void)success;
     }
@@ -69,7 +70,81 @@ namespace nvrhi::vulkan
     {
         EventQuery* query = checked_cast<EventQuery*>(_query);
 
-        query->commandListID = 0;
+        query->ticket = SubmissionTicket();
+        query->started = false;
+    }
+
+    SubmissionTicket Device::getSubmissionTicket(CommandQueue queue)
+    {
+        return SubmissionTicket()
+            .setQueue(queue)
+            .setInstance(m_Queues[uint32_t(queue)]->getLastSubmittedID());
+    }
+
+    bool Device::pollSubmission(const SubmissionTicket& ticket)
+    {
+        if (ticket.instance == 0)
+            return true;
+
+        Queue* queue = m_Queues[uint32_t(ticket.queue)].get();
+
+        return queue && queue->pollCommandList(ticket.instance);
+    }
+
+    bool Device::waitForAll(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        return waitForSubmissions(tickets, numTickets, true, timeoutNanoseconds);
+    }
+
+    bool Device::waitForAny(const SubmissionTicket* tickets, size_t numTickets, uint64_t timeoutNanoseconds)
+    {
+        return waitForSubmissions(tickets, numTickets, false, timeoutNanoseconds);
+    }
+
+    bool Device::waitForSubmissions(const SubmissionTicket* tickets, size_t numTickets, bool waitAll, uint64_t timeoutNanoseconds)
+    {
+        std::vector<vk::Semaphore> semaphores;
+        std::vector<uint64_t> values;
+        semaphores.reserve(numTickets);
+        values.reserve(numTickets);
+
+        for (size_t i = 0; i < numTickets; i++)
+        {
+            const SubmissionTicket& ticket = tickets[i];
+            Queue* queue = m_Queues[uint32_t(ticket.queue)].get();
+
+            if (ticket.instance != 0 && (!queue || ticket.instance > queue->getLastSubmittedID()))
+                return false;
+
+            if (pollSubmission(ticket))
+            {
+                if (!waitAll)
+                    return true;
+                continue;
+            }
+
+            if (queue->hasPendingSubmissions(ticket.instance))
+                queue->flush();
+
+            semaphores.push_back(queue->trackingSemaphore);
+            values.push_back(ticket.instance);
+        }
+
+        if (semaphores.empty())
+            return waitAll;
+
+        auto waitInfo = vk::SemaphoreWaitInfo()
+            .setFlags(waitAll ? vk::SemaphoreWaitFlags() : vk::SemaphoreWaitFlagBits::eAny)
+            .setSemaphores(semaphores)
+            .setValues(values);
+
+        try {
+            return m_Context.device.waitSemaphores(waitInfo, timeoutNanoseconds) == vk::Result::eSuccess;
+        }
+        catch (vk::DeviceLostError&)
+        {
+            return false;
+        }
     }
 
 
@@ -190,6 +265,10 @@ namespace nvrhi::vulkan
 
         if (!query->resolved)
         {
+            // The query doesn't know which queue it was submitted to, and with deferred submission
+            // its command list may still be pending on any of them
+            flushSubmissions();
+
             while(!pollTimerQuery(query))
                 ;
         }
@@ -236,10 +315,16 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->cmdBuf.setCheckpointNV((const void*)aftermathMarker);
         }
 #endif
+
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.beginScope(*m_Context.profiler, m_Device, this, name);
     }
 
     void CommandList::endMarker()
     {
+        if (m_ProfilingEnabled)
+            m_ProfilerScopes.endScope(this);
+
         if (m_Context.extensions.EXT_debug_utils)
         {
             assert(m_CurrentCmdBuf);
@@ -257,5 +342,99 @@ namespace nvrhi::vulkan
         m_AftermathTracker.popEvent();
 #endif
     }
+    bool ProfilerTimestampSource::readTimestamps(ITimerQuery* const* queries, size_t numQueries, uint64_t* outTimestamps)
+    {
+        // Queries allocated next to each other are read together. Reading any wider ranges could touch
+        // queries that were never reset, which is not allowed.
+        std::vector<std::pair<int, size_t>> queryIndices(numQueries);
+        for (size_t i = 0; i < numQueries; i++)
+            queryIndices[i] = std::make_pair(checked_cast<const TimerQuery*>(queries[i])->beginQueryIndex, i);
+
+        std::sort(queryIndices.begin(), queryIndices.end());
+
+        std::vector<uint64_t> results;
+        size_t rangeStart = 0;
+        while (rangeStart < numQueries)
+        {
+            size_t rangeEnd = rangeStart + 1;
+            while (rangeEnd < numQueries && queryIndices[rangeEnd].first == queryIndices[rangeEnd - 1].first + 2)
+                ++rangeEnd;
+
+            const uint32_t firstQuery = uint32_t(queryIndices[rangeStart].first);
+            const uint32_t queryCount = uint32_t(rangeEnd - rangeStart) * 2;
+            results.resize(queryCount);
+
+            const vk::Result res = m_Context.device.getQueryPoolResults(m_Device.getTimerQueryPool(),
+                firstQuery, queryCount, results.size() * sizeof(uint64_t), results.data(), sizeof(uint64_t),
+                vk::QueryResultFlagBits::e64);
+
+            if (res != vk::Result::eSuccess)
+                return false;
+
+            for (size_t i = rangeStart; i < rangeEnd; i++)
+            {
+                const size_t resultIndex = (i - rangeStart) * 2;
+                const size_t outputIndex = queryIndices[i].second * 2;
+                outTimestamps[outputIndex] = results[resultIndex];
+                outTimestamps[outputIndex + 1] = results[resultIndex + 1];
+            }
+
+            rangeStart = rangeEnd;
+        }
+
+        return true;
+    }
+
+    uint64_t ProfilerTimestampSource::getTimestampFrequency(CommandQueue queue)
+    {
+        // All queues use the same timestamp period
+        (void)queue;
+
+        const float timestampPeriod = m_Context.physicalDeviceProperties.limits.timestampPeriod; // in nanoseconds
+        if (timestampPeriod <= 0.f)
+            return 0;
+
+        return uint64_t(1e9 / double(timestampPeriod) + 0.5);
+    }
+
+    bool ProfilerTimestampSource::calibrateTimestamps(CommandQueue queue, uint64_t& outGpuTimestamp, int64_t& outCpuTimeNs)
+    {
+        (void)queue;
+
+        if (!m_Context.extensions.EXT_calibrated_timestamps)
+            return false;
+
+        // These are the clocks that std::chrono::steady_clock uses with MSVC and libstdc++
+#ifdef _WIN32
+        const vk::TimeDomainEXT hostTimeDomain = vk::TimeDomainEXT::eQueryPerformanceCounter;
+#else
+        const vk::TimeDomainEXT hostTimeDomain = vk::TimeDomainEXT::eClockMonotonic;
+#endif
+
+        const vk::CalibratedTimestampInfoEXT timestampInfos[2] = {
+            vk::CalibratedTimestampInfoEXT().setTimeDomain(vk::TimeDomainEXT::eDevice),
+            vk::CalibratedTimestampInfoEXT().setTimeDomain(hostTimeDomain)
+        };
+
+        uint64_t timestamps[2] = {};
+        uint64_t maxDeviation = 0;
+        const vk::Result res = m_Context.device.getCalibratedTimestampsEXT(2, timestampInfos, timestamps, &maxDeviation);
+        if (res != vk::Result::eSuccess)
+            return false;
+
+        outGpuTimestamp = timestamps[0];
+
+#ifdef _WIN32
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        const int64_t qpcFrequency = frequency.QuadPart;
+        const int64_t qpcValue = int64_t(timestamps[1]);
+        outCpuTimeNs = (qpcValue / qpcFrequency) * std::nano::den + (qpcValue % qpcFrequency) * std::nano::den / qpcFrequency;
+#else
+        outCpuTimeNs = int64_t(timestamps[1]);
+#endif
+
+        return true;
+    }
 
 } // namespace nvrhi::vulkan
\ No newline at end of file
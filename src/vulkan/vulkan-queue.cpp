@@ -29,9 +29,122 @@ namespace nvrhi::vulkan
 
     TrackedCommandBuffer::~TrackedCommandBuffer()
     {
+        for (vk::Event event : m_SplitBarrierEvents)
+        {
+            m_Context.device.destroyEvent(event, m_Context.allocationCallbacks);
+        }
+
+        for (vk::DescriptorPool pool : m_TransientDescriptorPools)
+        {
+            m_Context.device.destroyDescriptorPool(pool, m_Context.allocationCallbacks);
+        }
+
         m_Context.device.destroyCommandPool(cmdPool, m_Context.allocationCallbacks);
     }
 
+    vk::Event TrackedCommandBuffer::getSplitBarrierEvent()
+    {
+        if (m_NumSplitBarrierEventsUsed == m_SplitBarrierEvents.size())
+        {
+            vk::Event event;
+            const vk::Result res = m_Context.device.createEvent(vk::EventCreateInfo(), m_Context.allocationCallbacks, &event);
+            CHECK_VK_FAIL(res)
+
+            m_SplitBarrierEvents.push_back(event);
+        }
+
+        return m_SplitBarrierEvents[m_NumSplitBarrierEventsUsed++];
+    }
+
+    void TrackedCommandBuffer::resetSplitBarrierEvents()
+    {
+        for (size_t i = 0; i < m_NumSplitBarrierEventsUsed; i++)
+        {
+            m_Context.device.resetEvent(m_SplitBarrierEvents[i]);
+        }
+
+        m_NumSplitBarrierEventsUsed = 0;
+    }
+
+    vk::DescriptorSet TrackedCommandBuffer::allocateTransientDescriptorSet(vk::DescriptorSetLayout layout)
+    {
+        auto allocInfo = vk::DescriptorSetAllocateInfo()
+            .setDescriptorSetCount(1)
+            .setPSetLayouts(&layout);
+
+        if (m_NumTransientDescriptorPoolsUsed > 0)
+        {
+            allocInfo.setDescriptorPool(m_TransientDescriptorPools[m_NumTransientDescriptorPoolsUsed - 1]);
+
+            vk::DescriptorSet set;
+            const vk::Result res = m_Context.device.allocateDescriptorSets(&allocInfo, &set);
+            if (res == vk::Result::eSuccess)
+                return set;
+
+            if (res != vk::Result::eErrorOutOfPoolMemory && res != vk::Result::eErrorFragmentedPool)
+                return vk::DescriptorSet();
+        }
+
+        // The current pool is full, move on to the next one
+        if (m_NumTransientDescriptorPoolsUsed == m_TransientDescriptorPools.size())
+        {
+            static_vector<vk::DescriptorPoolSize, 9> poolSizes = {
+                { vk::DescriptorType::eSampler, c_TransientDescriptorsPerType },
+                { vk::DescriptorType::eSampledImage, c_TransientDescriptorsPerType },
+                { vk::DescriptorType::eStorageImage, c_TransientDescriptorsPerType },
+                { vk::DescriptorType::eUniformTexelBuffer, c_TransientDescriptorsPerType },
+                { vk::DescriptorType::eStorageTexelBuffer, c_TransientDescriptorsPerType },
+                { vk::DescriptorType::eUniformBuffer, c_TransientDescriptorsPerType },
+                { vk::DescriptorType::eUniformBufferDynamic, c_TransientDescriptorsPerType },
+                { vk::DescriptorType::eStorageBuffer, c_TransientDescriptorsPerType }
+            };
+
+            if (m_Context.extensions.KHR_acceleration_structure)
+                poolSizes.push_back({ vk::DescriptorType::eAccelerationStructureKHR, c_TransientDescriptorsPerType });
+
+            auto poolInfo = vk::DescriptorPoolCreateInfo()
+                .setPoolSizeCount(uint32_t(poolSizes.size()))
+                .setPPoolSizes(poolSizes.data())
+                .setMaxSets(c_TransientDescriptorSetsPerPool);
+
+            vk::DescriptorPool pool;
+            const vk::Result res = m_Context.device.createDescriptorPool(&poolInfo, m_Context.allocationCallbacks, &pool);
+            CHECK_VK_FAIL(res)
+
+            m_TransientDescriptorPools.push_back(pool);
+        }
+
+        allocInfo.setDescriptorPool(m_TransientDescriptorPools[m_NumTransientDescriptorPoolsUsed++]);
+
+        // A set that doesn't fit into an empty pool is not going to fit anywhere
+        vk::DescriptorSet set;
+        const vk::Result res = m_Context.device.allocateDescriptorSets(&allocInfo, &set);
+        CHECK_VK_FAIL(res)
+
+        return set;
+    }
+
+    void TrackedCommandBuffer::releaseTransientDescriptors()
+    {
+        for (const DescriptorBufferAllocation& allocation : transientDescriptors)
+        {
+            m_Context.descriptorBufferHeap->free(allocation);
+        }
+
+        transientDescriptors.clear();
+        descriptorBufferBound = false;
+        volatileDescriptorBlock = DescriptorBufferAllocation();
+        volatileDescriptorBlockUsed = 0;
+        volatileDescriptorCopies.clear();
+
+        for (size_t i = 0; i < m_NumTransientDescriptorPoolsUsed; i++)
+        {
+            m_Context.device.resetDescriptorPool(m_TransientDescriptorPools[i]);
+        }
+
+        m_NumTransientDescriptorPoolsUsed = 0;
+    }
+
     Queue::Queue(const VulkanContext& context, CommandQueue queueID, vk::Queue queue, uint32_t queueFamilyIndex)
         : m_Context(context)
         , m_Queue(queue)
@@ -53,7 +166,7 @@ namespace nvrhi::vulkan
         trackingSemaphore = vk::Semaphore();
     }
 
-    TrackedCommandBufferPtr Queue::createCommandBuffer()
+    TrackedCommandBufferPtr Queue::createCommandBuffer(vk::CommandBufferLevel level)
     {
         vk::Result res;
 
@@ -69,7 +182,7 @@ namespace nvrhi::vulkan
         
         // allocate command buffer
         auto allocInfo = vk::CommandBufferAllocateInfo()
-                            .setLevel(vk::CommandBufferLevel::ePrimary)
+                            .setLevel(level)
                             .setCommandPool(ret->cmdPool)
                             .setCommandBufferCount(1);
 
@@ -79,21 +192,23 @@ namespace nvrhi::vulkan
         return ret;
     }
 
-    TrackedCommandBufferPtr Queue::getOrCreateCommandBuffer()
+    TrackedCommandBufferPtr Queue::getOrCreateCommandBuffer(bool secondary)
     {
         std::lock_guard lockGuard(m_Mutex); // this is called from CommandList::open, so free-threaded
 
         uint64_t recordingID = ++m_LastRecordingID;
 
+        std::list<TrackedCommandBufferPtr>& pool = secondary ? m_SecondaryCommandBuffersPool : m_CommandBuffersPool;
+
         TrackedCommandBufferPtr cmdBuf;
-        if (m_CommandBuffersPool.empty())
+        if (pool.empty())
         {
-            cmdBuf = createCommandBuffer();
+            cmdBuf = createCommandBuffer(secondary ? vk::CommandBufferLevel::eSecondary : vk::CommandBufferLevel::ePrimary);
         }
         else
         {
-            cmdBuf = m_CommandBuffersPool.front();
-            m_CommandBuffersPool.pop_front();
+            cmdBuf = pool.front();
+            pool.pop_front();
         }
 
         cmdBuf->recordingID = recordingID;
@@ -120,23 +235,27 @@ namespace nvrhi::vulkan
 
     uint64_t Queue::submit(ICommandList* const* ppCmd, size_t numCmd)
     {
-        std::vector<vk::PipelineStageFlags> waitStageArray(m_WaitSemaphores.size());
-        std::vector<vk::CommandBuffer> commandBuffers(numCmd);
-
-        for (size_t i = 0; i < m_WaitSemaphores.size(); i++)
-        {
-            waitStageArray[i] = vk::PipelineStageFlagBits::eTopOfPipe;
-        }
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::Queue::submit");
 
         m_LastSubmittedID++;
 
+        PendingSubmission submission;
+        submission.submissionID = m_LastSubmittedID;
+        submission.commandBuffers.resize(numCmd);
+
+        std::unique_lock lockGuard(m_Mutex);
+
         for (size_t i = 0; i < numCmd; i++)
         {
             CommandList* commandList = checked_cast<CommandList*>(ppCmd[i]);
             TrackedCommandBufferPtr commandBuffer = commandList->getCurrentCmdBuf();
 
-            commandBuffers[i] = commandBuffer->cmdBuf;
-            m_CommandBuffersInFlight.push_back(commandBuffer);
+            submission.commandBuffers[i] = commandBuffer->cmdBuf;
+
+            if (commandList->getDesc().isReusable)
+                m_ReusableCommandListsInFlight.push_back(std::make_pair(m_LastSubmittedID, CommandListHandle(commandList)));
+            else
+                m_CommandBuffersInFlight.push_back(commandBuffer);
 
             for (const auto& buffer : commandBuffer->referencedStagingBuffers)
             {
@@ -144,44 +263,152 @@ namespace nvrhi::vulkan
                 buffer->lastUseCommandListID = m_LastSubmittedID;
             }
         }
+
+        lockGuard.unlock();
         
         m_SignalSemaphores.push_back(trackingSemaphore);
         m_SignalSemaphoreValues.push_back(m_LastSubmittedID);
 
-        auto timelineSemaphoreInfo = vk::TimelineSemaphoreSubmitInfo()
-            .setSignalSemaphoreValueCount(uint32_t(m_SignalSemaphoreValues.size()))
-            .setPSignalSemaphoreValues(m_SignalSemaphoreValues.data());
+        submission.waitSemaphores = std::move(m_WaitSemaphores);
+        submission.waitSemaphoreValues = std::move(m_WaitSemaphoreValues);
+        submission.signalSemaphores = std::move(m_SignalSemaphores);
+        submission.signalSemaphoreValues = std::move(m_SignalSemaphoreValues);
 
-        if (!m_WaitSemaphoreValues.empty()) 
+        m_WaitSemaphores.clear();
+        m_WaitSemaphoreValues.clear();
+        m_SignalSemaphores.clear();
+        m_SignalSemaphoreValues.clear();
+
+        std::lock_guard submitLockGuard(m_SubmitMutex);
+
+        if (m_Context.deferredSubmission)
         {
-            timelineSemaphoreInfo.setWaitSemaphoreValueCount(uint32_t(m_WaitSemaphoreValues.size()));
-            timelineSemaphoreInfo.setPWaitSemaphoreValues(m_WaitSemaphoreValues.data());
+            m_PendingSubmissions.push_back(std::move(submission));
         }
+        else
+        {
+            submitBatches(&submission, 1);
+            m_LastFlushedID = submission.submissionID;
+        }
+        
+        return submission.submissionID;
+    }
+
+    void Queue::flush()
+    {
+        std::lock_guard submitLockGuard(m_SubmitMutex);
+
+        if (m_PendingSubmissions.empty())
+            return;
 
-        auto submitInfo = vk::SubmitInfo()
-            .setPNext(&timelineSemaphoreInfo)
-            .setCommandBufferCount(uint32_t(numCmd))
-            .setPCommandBuffers(commandBuffers.data())
-            .setWaitSemaphoreCount(uint32_t(m_WaitSemaphores.size()))
-            .setPWaitSemaphores(m_WaitSemaphores.data())
-            .setPWaitDstStageMask(waitStageArray.data())
-            .setSignalSemaphoreCount(uint32_t(m_SignalSemaphores.size()))
-            .setPSignalSemaphores(m_SignalSemaphores.data());
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::Queue::flush");
 
+        submitBatches(m_PendingSubmissions.data(), m_PendingSubmissions.size());
+
+        m_LastFlushedID = m_PendingSubmissions.back().submissionID;
+        m_PendingSubmissions.clear();
+    }
+
+    void Queue::submitBatches(const PendingSubmission* batches, size_t numBatches)
+    {
         try {
-            m_Queue.submit(submitInfo);
+            if (m_Context.extensions.KHR_synchronization2)
+            {
+                // The semaphore and command buffer infos of all batches are stored first, so that they don't move
+                std::vector<vk::SemaphoreSubmitInfo> semaphoreInfos;
+                std::vector<vk::CommandBufferSubmitInfo> commandBufferInfos;
+                for (size_t batchIndex = 0; batchIndex < numBatches; batchIndex++)
+                {
+                    const PendingSubmission& batch = batches[batchIndex];
+
+                    for (size_t i = 0; i < batch.waitSemaphores.size(); i++)
+                    {
+                        semaphoreInfos.push_back(vk::SemaphoreSubmitInfo()
+                            .setSemaphore(batch.waitSemaphores[i])
+                            .setValue(batch.waitSemaphoreValues[i])
+                            .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+                    }
+
+                    for (size_t i = 0; i < batch.signalSemaphores.size(); i++)
+                    {
+                        semaphoreInfos.push_back(vk::SemaphoreSubmitInfo()
+                            .setSemaphore(batch.signalSemaphores[i])
+                            .setValue(batch.signalSemaphoreValues[i])
+                            .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+                    }
+
+                    for (vk::CommandBuffer commandBuffer : batch.commandBuffers)
+                    {
+                        commandBufferInfos.push_back(vk::CommandBufferSubmitInfo()
+                            .setCommandBuffer(commandBuffer));
+                    }
+                }
+
+                std::vector<vk::SubmitInfo2> submitInfos;
+                submitInfos.reserve(numBatches);
+                size_t semaphoreOffset = 0;
+                size_t commandBufferOffset = 0;
+                for (size_t batchIndex = 0; batchIndex < numBatches; batchIndex++)
+                {
+                    const PendingSubmission& batch = batches[batchIndex];
+                    const size_t numWaits = batch.waitSemaphores.size();
+                    const size_t numSignals = batch.signalSemaphores.size();
+                    const size_t numCommandBuffers = batch.commandBuffers.size();
+
+                    submitInfos.push_back(vk::SubmitInfo2()
+                        .setWaitSemaphoreInfoCount(uint32_t(numWaits))
+                        .setPWaitSemaphoreInfos(semaphoreInfos.data() + semaphoreOffset)
+                        .setSignalSemaphoreInfoCount(uint32_t(numSignals))
+                        .setPSignalSemaphoreInfos(semaphoreInfos.data() + semaphoreOffset + numWaits)
+                        .setCommandBufferInfoCount(uint32_t(numCommandBuffers))
+                        .setPCommandBufferInfos(commandBufferInfos.data() + commandBufferOffset));
+
+                    semaphoreOffset += numWaits + numSignals;
+                    commandBufferOffset += numCommandBuffers;
+                }
+
+                m_Queue.submit2(submitInfos);
+            }
+            else
+            {
+                std::vector<vk::PipelineStageFlags> waitStageArray;
+                for (size_t i = 0; i < numBatches; i++)
+                    waitStageArray.resize(std::max(waitStageArray.size(), batches[i].waitSemaphores.size()), vk::PipelineStageFlagBits::eTopOfPipe);
+
+                std::vector<vk::TimelineSemaphoreSubmitInfo> timelineSemaphoreInfos(numBatches);
+                std::vector<vk::SubmitInfo> submitInfos(numBatches);
+                for (size_t i = 0; i < numBatches; i++)
+                {
+                    const PendingSubmission& batch = batches[i];
+
+                    timelineSemaphoreInfos[i]
+                        .setSignalSemaphoreValueCount(uint32_t(batch.signalSemaphoreValues.size()))
+                        .setPSignalSemaphoreValues(batch.signalSemaphoreValues.data());
+
+                    if (!batch.waitSemaphoreValues.empty())
+                    {
+                        timelineSemaphoreInfos[i].setWaitSemaphoreValueCount(uint32_t(batch.waitSemaphoreValues.size()));
+                        timelineSemaphoreInfos[i].setPWaitSemaphoreValues(batch.waitSemaphoreValues.data());
+                    }
+
+                    submitInfos[i]
+                        .setPNext(&timelineSemaphoreInfos[i])
+                        .setCommandBufferCount(uint32_t(batch.commandBuffers.size()))
+                        .setPCommandBuffers(batch.commandBuffers.data())
+                        .setWaitSemaphoreCount(uint32_t(batch.waitSemaphores.size()))
+                        .setPWaitSemaphores(batch.waitSemaphores.data())
+                        .setPWaitDstStageMask(waitStageArray.data())
+                        .setSignalSemaphoreCount(uint32_t(batch.signalSemaphores.size()))
+                        .setPSignalSemaphores(batch.signalSemaphores.data());
+                }
+
+                m_Queue.submit(submitInfos);
+            }
         }
         catch (vk::DeviceLostError&)
         {
             m_Context.messageCallback->message(MessageSeverity::Error, "Device Removed!");
         }
-
-        m_WaitSemaphores.clear();
-        m_WaitSemaphoreValues.clear();
-        m_SignalSemaphores.clear();
-        m_SignalSemaphoreValues.clear();
-        
-        return m_LastSubmittedID;
     }
 
     void Queue::updateTextureTileMappings(ITexture* _texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings)
@@ -281,6 +508,9 @@ namespace nvrhi::vulkan
             bindSparseInfo.setImageOpaqueBinds(sparseImageOpaqueMemoryBindInfo);
         }
 
+        // The binding is ordered with the command buffers on the queue
+        flush();
+
         m_Queue.bindSparse(bindSparseInfo, vk::Fence());
     }
 
@@ -291,21 +521,70 @@ namespace nvrhi::vulkan
         return m_LastFinishedID;
     }
 
-    void Queue::retireCommandBuffers()
+    void Queue::retireCommandBuffers(ReleaseQueue* deferredReleases)
     {
-        std::list<TrackedCommandBufferPtr> submissions = std::move(m_CommandBuffersInFlight);
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::Queue::retireCommandBuffers");
 
         uint64_t lastFinishedID = updateLastFinishedID();
+
+        // Releasing the last reference to a reusable command list returns its command buffer to the in-flight list,
+        // so drop these references before looking at the command buffers, and outside of the lock
+        std::vector<CommandListHandle> finishedReusableCommandLists;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            while (!m_ReusableCommandListsInFlight.empty() && m_ReusableCommandListsInFlight.front().first <= lastFinishedID)
+            {
+                finishedReusableCommandLists.push_back(std::move(m_ReusableCommandListsInFlight.front().second));
+                m_ReusableCommandListsInFlight.pop_front();
+                m_Context.deviceStats->commandListRetired(0);
+            }
+        }
+        finishedReusableCommandLists.clear();
+
+        std::list<TrackedCommandBufferPtr> submissions;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            submissions = std::move(m_CommandBuffersInFlight);
+            m_CommandBuffersInFlight.clear();
+        }
+
+        std::list<TrackedCommandBufferPtr> stillInFlight;
         
         for (const TrackedCommandBufferPtr& cmd : submissions)
         {
             if (cmd->submissionID <= lastFinishedID)
             {
-                cmd->referencedResources.clear();
+                if (cmd->statsSubmitted)
+                {
+                    m_Context.deviceStats->commandListRetired(cmd->statsReferenceCount);
+                    cmd->statsSubmitted = false;
+                }
+
+                if (deferredReleases)
+                    deferredReleases->add(cmd->referencedResources);
+                else
+                    cmd->referencedResources.clear();
                 cmd->referencedStagingBuffers.clear();
+                cmd->referencedReadbacks.clear();
+                cmd->resetSplitBarrierEvents();
+                cmd->releaseTransientDescriptors();
                 cmd->submissionID = 0;
                 m_CommandBuffersPool.push_back(cmd);
 
+                for (const TrackedCommandBufferPtr& secondary : cmd->secondaryCommandBuffers)
+                {
+                    if (deferredReleases)
+                        deferredReleases->add(secondary->referencedResources);
+                    else
+                        secondary->referencedResources.clear();
+                    secondary->referencedStagingBuffers.clear();
+                    secondary->releaseTransientDescriptors();
+                    secondary->submissionID = 0;
+                    m_SecondaryCommandBuffersPool.push_back(secondary);
+                }
+                cmd->secondaryCommandBuffers.clear();
+
 #ifdef NVRHI_WITH_RTXMU
                 if (!cmd->rtxmuBuildIds.empty())
                 {
@@ -321,13 +600,67 @@ namespace nvrhi::vulkan
                     m_Context.rtxMemUtil->GarbageCollection(cmd->rtxmuCompactionIds);
                     cmd->rtxmuCompactionIds.clear();
                 }
+#else
+                if (!cmd->pendingCompactedSizes.empty())
+                {
+                    m_Context.blasCompaction->buildsCompleted(cmd->pendingCompactedSizes);
+                }
 #endif
+                if (!cmd->accelStructTimerQueries.empty())
+                {
+                    m_Context.accelStructStats->buildsExecuted(cmd->accelStructTimerQueries);
+                }
+                if (!cmd->profilerScopes.empty())
+                {
+                    m_Context.profiler->scopesExecuted(cmd->profilerScopes);
+                }
             }
             else
             {
-                m_CommandBuffersInFlight.push_back(cmd);
+                stillInFlight.push_back(cmd);
             }
         }
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_CommandBuffersInFlight.splice(m_CommandBuffersInFlight.begin(), stillInFlight);
+    }
+
+    void Queue::releaseReusableCommandBuffer(const TrackedCommandBufferPtr& cmdBuf)
+    {
+        std::lock_guard lockGuard(m_Mutex); // called from CommandList::open, so free-threaded
+
+        m_CommandBuffersInFlight.push_back(cmdBuf);
+    }
+
+    void Queue::recycleUnsubmittedCommandBuffer(const TrackedCommandBufferPtr& cmdBuf, bool secondary)
+    {
+        // Nothing recorded here reaches the GPU, so the references can be dropped right away
+        cmdBuf->referencedResources.clear();
+        cmdBuf->referencedStagingBuffers.clear();
+        cmdBuf->referencedReadbacks.clear();
+        cmdBuf->resetSplitBarrierEvents();
+        cmdBuf->releaseTransientDescriptors();
+        cmdBuf->descriptorBufferBound = false;
+        cmdBuf->submissionID = 0;
+
+        // Secondary command buffers executed here still belong to their command lists, which recycle them
+        cmdBuf->secondaryCommandBuffers.clear();
+
+#ifdef NVRHI_WITH_RTXMU
+        cmdBuf->rtxmuBuildIds.clear();
+        cmdBuf->rtxmuCompactionIds.clear();
+#else
+        if (!cmdBuf->pendingCompactedSizes.empty())
+        {
+            m_Context.blasCompaction->buildsDiscarded(cmdBuf->pendingCompactedSizes);
+        }
+#endif
+        cmdBuf->accelStructTimerQueries.clear();
+
+        std::lock_guard lockGuard(m_Mutex); // called from CommandList::open, so free-threaded
+
+        std::list<TrackedCommandBufferPtr>& pool = secondary ? m_SecondaryCommandBuffersPool : m_CommandBuffersPool;
+        pool.push_back(cmdBuf);
     }
 
     TrackedCommandBufferPtr Queue::getCommandBufferInFlight(uint64_t submissionID)
@@ -364,6 +697,11 @@ namespace nvrhi::vulkan
 
     void Device::queueWaitForCommandList(CommandQueue waitQueueID, CommandQueue executionQueueID, uint64_t instance)
     {
+        // The signal that the wait depends on must not stay pending after the waiting submission is flushed
+        Queue& executionQueue = *m_Queues[uint32_t(executionQueueID)];
+        if (executionQueue.hasPendingSubmissions(instance))
+            executionQueue.flush();
+
         queueWaitForSemaphore(waitQueueID, getQueueSemaphore(executionQueueID), instance);
     }
 
@@ -397,6 +735,9 @@ namespace nvrhi::vulkan
         if (commandListID > m_LastSubmittedID || commandListID == 0)
             return false;
 
+        if (hasPendingSubmissions(commandListID))
+            flush();
+
         if (pollCommandList(commandListID))
             return true;
 
@@ -21,8 +21,11 @@
 */
 
 #include "vulkan-backend.h"
+#include "../common/parallel-for.h"
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
+#include <thread>
 
 namespace nvrhi::vulkan
 {
@@ -248,6 +251,7 @@ namespace nvrhi::vulkan
             .setDeviceAddress(getMutableBufferAddress(buffer, 0).deviceAddress);
 
         om->opacityMicromap = m_Context.device.createMicromapEXTUnique(create, m_Context.allocationCallbacks);
+        om->statsEntry.set(m_Context.accelStructStats.get(), AccelStructStatsTracker::ObjectType::OpacityMicromap, bufferDesc.byteSize);
         return rt::OpacityMicromapHandle::Create(om);
     }
 
@@ -331,6 +335,10 @@ namespace nvrhi::vulkan
             }
         }
 
+        as->statsEntry.set(m_Context.accelStructStats.get(),
+            desc.isTopLevel ? AccelStructStatsTracker::ObjectType::TopLevel : AccelStructStatsTracker::ObjectType::BottomLevel,
+            as->dataBuffer ? as->dataBuffer->getDesc().byteSize : 0);
+
         // Sanitize the geometry data to avoid dangling pointers, we don't need these buffers in the Desc
         for (auto& geometry : as->desc.bottomLevelGeometries)
         {
@@ -533,91 +541,252 @@ namespace nvrhi::vulkan
         return bound;
     }
 
-    void CommandList::buildOpacityMicromap(rt::IOpacityMicromap* pOpacityMicromap, const rt::OpacityMicromapDesc& desc)
+    void CommandList::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc)
     {
-        OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pOpacityMicromap);
+        const rt::OpacityMicromapBuildDesc build = rt::OpacityMicromapBuildDesc()
+            .setOpacityMicromap(omm)
+            .setDesc(&desc);
 
-        if (m_EnableAutomaticBarriers)
-        {
-            requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
-            requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
+        buildOpacityMicromaps(&build, 1);
+    }
 
-            requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapWrite);
-        }
+    void CommandList::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* pBuilds, size_t numBuilds)
+    {
+        if (numBuilds == 0)
+            return;
 
-        if (desc.trackLiveness)
-        {
-            m_CurrentCmdBuf->referencedResources.push_back(desc.inputBuffer);
-            m_CurrentCmdBuf->referencedResources.push_back(desc.perOmmDescs);
-            m_CurrentCmdBuf->referencedResources.push_back(omm->dataBuffer);
-        }
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
 
-        commitBarriers();
+        const uint64_t scratchAlignment = m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment;
 
-        auto buildInfo = vk::MicromapBuildInfoEXT()
-            .setType(vk::MicromapTypeEXT::eOpacityMicromap)
-            .setFlags(GetAsVkBuildMicromapFlagBitsEXT(desc.flags))
-            .setMode(vk::BuildMicromapModeEXT::eBuild)
-            .setDstMicromap(omm->opacityMicromap.get())
-            .setPUsageCounts(GetAsVkOpacityMicromapUsageCounts(desc.counts.data()))
-            .setUsageCountsCount((uint32_t)desc.counts.size())
-            .setData(getBufferAddress(desc.inputBuffer, desc.inputBufferOffset))
-            .setTriangleArray(getBufferAddress(desc.perOmmDescs, desc.perOmmDescsOffset))
-            .setTriangleArrayStride((VkDeviceSize)sizeof(vk::MicromapTriangleEXT))
-            ;
+        std::vector<vk::MicromapBuildInfoEXT> buildInfos(numBuilds);
+        std::vector<uint64_t> scratchOffsets(numBuilds);
+        uint64_t totalScratchSize = 0;
 
-        vk::MicromapBuildSizesInfoEXT buildSize;
-        m_Context.device.getMicromapBuildSizesEXT(vk::AccelerationStructureBuildTypeKHR::eDevice, &buildInfo, &buildSize);
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::OpacityMicromapDesc& desc = *pBuilds[i].desc;
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pBuilds[i].opacityMicromap);
+
+            buildInfos[i] = vk::MicromapBuildInfoEXT()
+                .setType(vk::MicromapTypeEXT::eOpacityMicromap)
+                .setFlags(GetAsVkBuildMicromapFlagBitsEXT(desc.flags))
+                .setMode(vk::BuildMicromapModeEXT::eBuild)
+                .setDstMicromap(omm->opacityMicromap.get())
+                .setPUsageCounts(GetAsVkOpacityMicromapUsageCounts(desc.counts.data()))
+                .setUsageCountsCount((uint32_t)desc.counts.size())
+                .setData(getBufferAddress(desc.inputBuffer, desc.inputBufferOffset))
+                .setTriangleArray(getBufferAddress(desc.perOmmDescs, desc.perOmmDescsOffset))
+                .setTriangleArrayStride((VkDeviceSize)sizeof(vk::MicromapTriangleEXT))
+                ;
+
+            vk::MicromapBuildSizesInfoEXT buildSize;
+            m_Context.device.getMicromapBuildSizesEXT(vk::AccelerationStructureBuildTypeKHR::eDevice, &buildInfos[i], &buildSize);
+
+            // Pack the scratch regions of all builds into one allocation
+            scratchOffsets[i] = totalScratchSize;
+            totalScratchSize += align(uint64_t(buildSize.buildScratchSize), scratchAlignment);
+        }
 
-        if (buildSize.buildScratchSize != 0)
+        if (totalScratchSize != 0)
         {
             Buffer* scratchBuffer = nullptr;
             uint64_t scratchOffset = 0;
             uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
 
-            bool allocated = m_ScratchManager->suballocateBuffer(buildSize.buildScratchSize, &scratchBuffer, &scratchOffset, nullptr,
-                currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
+            bool allocated = m_ScratchManager->suballocateBuffer(totalScratchSize, &scratchBuffer, &scratchOffset, nullptr,
+                currentVersion, uint32_t(scratchAlignment));
 
             if (!allocated)
             {
+                if (numBuilds > 1)
+                {
+                    // The batch doesn't fit into the scratch memory limit, build it in two halves
+                    size_t const firstHalf = numBuilds / 2;
+                    buildOpacityMicromaps(pBuilds, firstHalf);
+                    buildOpacityMicromaps(pBuilds + firstHalf, numBuilds - firstHalf);
+                    return;
+                }
+
                 std::stringstream ss;
-                ss << "Couldn't suballocate a scratch buffer for OMM " << utils::DebugNameToString(omm->desc.debugName) << " build. "
-                    "The build requires " << buildSize.buildScratchSize << " bytes of scratch space.";
+                ss << "Couldn't suballocate a scratch buffer for OMM " << utils::DebugNameToString(pBuilds[0].opacityMicromap->getDesc().debugName) << " build. "
+                    "The build requires " << totalScratchSize << " bytes of scratch space.";
 
                 m_Context.error(ss.str());
                 return;
             }
 
-            buildInfo.setScratchData(getMutableBufferAddress(scratchBuffer, scratchOffset));
+            m_Context.accelStructStats->buildScratchUsed(totalScratchSize);
+
+            for (size_t i = 0; i < numBuilds; i++)
+            {
+                buildInfos[i].setScratchData(getMutableBufferAddress(scratchBuffer, scratchOffset + scratchOffsets[i]));
+            }
         }
 
-        m_CurrentCmdBuf->cmdBuf.buildMicromapsEXT(1, &buildInfo);
+        // Transition the inputs and outputs of all builds with one barrier batch
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::OpacityMicromapDesc& desc = *pBuilds[i].desc;
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pBuilds[i].opacityMicromap);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
+                requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
+
+                requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapWrite);
+            }
+
+            if (desc.trackLiveness)
+            {
+                m_CurrentCmdBuf->referencedResources.add(desc.inputBuffer);
+                m_CurrentCmdBuf->referencedResources.add(desc.perOmmDescs);
+                m_CurrentCmdBuf->referencedResources.add(omm->dataBuffer);
+            }
+        }
+
+        commitBarriers();
+
+        // The builds are independent, so they are recorded as one command that the GPU can execute concurrently.
+        // The barriers before the OMM arrays are used are placed when they transition to AccelStructBuildInput.
+        m_CurrentCmdBuf->cmdBuf.buildMicromapsEXT(uint32_t(numBuilds), buildInfos.data());
+
+#ifndef NVRHI_WITH_RTXMU
+        // Compactable OMM arrays write their compacted sizes into queries, which are read when the command buffer is retired
+        std::vector<OpacityMicromap*> compactableOmms;
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pBuilds[i].opacityMicromap);
+
+            if ((pBuilds[i].desc->flags & rt::OpacityMicromapBuildFlags::AllowCompaction) != 0 && !omm->compacted)
+            {
+                compactableOmms.push_back(omm);
+
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapBuildInput);
+                }
+            }
+        }
+
+        if (!compactableOmms.empty())
+        {
+            commitBarriers();
+
+            for (OpacityMicromap* omm : compactableOmms)
+            {
+                // If no query is available, the OMM array just stays uncompacted
+                vk::QueryPool queryPool;
+                uint32_t query = 0;
+                if (!m_Context.blasCompaction->allocateQuery(true, queryPool, query))
+                    break;
+
+                const vk::MicromapEXT micromap = omm->opacityMicromap.get();
+
+                m_CurrentCmdBuf->cmdBuf.resetQueryPool(queryPool, query, 1);
+                m_CurrentCmdBuf->cmdBuf.writeMicromapsPropertiesEXT(1, &micromap,
+                    vk::QueryType::eMicromapCompactedSizeEXT, queryPool, query);
+
+                PendingCompactedSize pending;
+                pending.query = query;
+                pending.opacityMicromap = omm;
+                m_CurrentCmdBuf->pendingCompactedSizes.push_back(std::move(pending));
+            }
+        }
+#endif
     }
 
-    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandList::compactOpacityMicromaps()
     {
-        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+#ifndef NVRHI_WITH_RTXMU
+        std::vector<rt::OpacityMicromapHandle> candidates;
+        m_Context.blasCompaction->takeOpacityMicromapCandidates(candidates);
 
-        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
-        if (performUpdate)
+        if (candidates.empty())
+            return;
+
+        // Create the compacted OMM arrays and transition all of their buffers with one barrier batch.
+        // The small compacted buffers are sub-allocated from the shared memory blocks.
+
+        std::vector<BufferHandle> compactedBuffers(candidates.size());
+        std::vector<vk::UniqueMicromapEXT> compactedMicromaps(candidates.size());
+
+        for (size_t i = 0; i < candidates.size(); i++)
         {
-            assert(as->allowUpdate);
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(candidates[i].Get());
+
+            BufferDesc bufferDesc = omm->dataBuffer->getDesc();
+            bufferDesc.byteSize = omm->compactedSize;
+            BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+
+            if (!buffer)
+                continue;
+
+            auto createInfo = vk::MicromapCreateInfoEXT()
+                .setType(vk::MicromapTypeEXT::eOpacityMicromap)
+                .setBuffer(checked_cast<Buffer*>(buffer.Get())->buffer)
+                .setSize(omm->compactedSize);
+
+            compactedMicromaps[i] = m_Context.device.createMicromapEXTUnique(createInfo, m_Context.allocationCallbacks);
+
+            if (!compactedMicromaps[i])
+                continue;
+
+            compactedBuffers[i] = buffer;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapBuildInput);
+                requireBufferState(buffer, nvrhi::ResourceStates::OpacityMicromapWrite);
+            }
         }
+        commitBarriers();
 
-        std::vector<vk::AccelerationStructureGeometryKHR> geometries;
-        std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
-        std::vector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges;
-        std::vector<uint32_t> maxPrimitiveCounts;
-        geometries.resize(numGeometries);
-        omms.resize(numGeometries);
-        maxPrimitiveCounts.resize(numGeometries);
-        buildRanges.resize(numGeometries);
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (!compactedBuffers[i])
+                continue;
 
-        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(candidates[i].Get());
+
+            auto copyInfo = vk::CopyMicromapInfoEXT()
+                .setSrc(omm->opacityMicromap.get())
+                .setDst(compactedMicromaps[i].get())
+                .setMode(vk::CopyMicromapModeEXT::eCompact);
+
+            m_CurrentCmdBuf->cmdBuf.copyMicromapEXT(copyInfo);
+
+            // The original micromap and its buffer are destroyed when this command buffer is retired,
+            // which returns their memory to the allocator
+            OpacityMicromap* original = new OpacityMicromap();
+            original->opacityMicromap = std::move(omm->opacityMicromap);
+            original->dataBuffer = std::move(omm->dataBuffer);
+            m_CurrentCmdBuf->referencedResources.add(rt::OpacityMicromapHandle::Create(original));
+
+            omm->dataBuffer = compactedBuffers[i];
+            omm->opacityMicromap = std::move(compactedMicromaps[i]);
+            omm->compacted = true;
+            omm->statsEntry.setCompacted(omm->dataBuffer->getDesc().byteSize);
+
+            if (omm->desc.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.add(omm);
+        }
+#endif
+    }
+
+    void CommandList::convertBlasBuildGeometries(const rt::GeometryDesc* pGeometries, size_t numGeometries, uint64_t currentVersion, BlasBuildGeometries& out)
+    {
+        out.geometries.resize(numGeometries);
+        out.omms.resize(numGeometries);
+        out.maxPrimitiveCounts.resize(numGeometries);
+        out.buildRanges.resize(numGeometries);
 
         for (size_t i = 0; i < numGeometries; i++)
         {
-            convertBottomLevelGeometry(pGeometries[i], geometries[i], omms[i], maxPrimitiveCounts[i], &buildRanges[i],
+            convertBottomLevelGeometry(pGeometries[i], out.geometries[i], out.omms[i], out.maxPrimitiveCounts[i], &out.buildRanges[i],
                 m_Context, m_UploadManager.get(), currentVersion);
 
             const rt::GeometryDesc& src = pGeometries[i];
@@ -652,6 +821,12 @@ namespace nvrhi::vulkan
                 break;
             }
         }
+    }
+
+    static vk::AccelerationStructureBuildGeometryInfoKHR getBlasBuildInfo(AccelStruct* as,
+        const std::vector<vk::AccelerationStructureGeometryKHR>& geometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
 
         auto buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR()
             .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
@@ -665,13 +840,35 @@ namespace nvrhi::vulkan
 
         if (performUpdate)
             buildInfo.setSrcAccelerationStructure(as->accelStruct);
-        
+
+        return buildInfo;
+    }
+
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
 #ifdef NVRHI_WITH_RTXMU
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+        if (performUpdate)
+        {
+            assert(as->allowUpdate);
+        }
+
+        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+
+        BlasBuildGeometries buildGeometries;
+        convertBlasBuildGeometries(pGeometries, numGeometries, currentVersion, buildGeometries);
+
+        vk::AccelerationStructureBuildGeometryInfoKHR buildInfo = getBlasBuildInfo(as, buildGeometries.geometries, buildFlags);
+
         commitBarriers();
 
         std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
-        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
-        std::array<const uint32_t*, 1> maxPrimArrays = { maxPrimitiveCounts.data() };
+        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildGeometries.buildRanges.data() };
+        std::array<const uint32_t*, 1> maxPrimArrays = { buildGeometries.maxPrimitiveCounts.data() };
 
         if(as->rtxmuId == ~0ull)
         {
@@ -703,58 +900,173 @@ namespace nvrhi::vulkan
                                                             (uint32_t)buildInfos.size(),
                                                             buildsToUpdate);
         }
+
+        if (as->desc.trackLiveness)
+            m_CurrentCmdBuf->referencedResources.add(as);
 #else
+        // Without RTXMU, a single build is a batch of one
+        auto build = rt::BlasBuildDesc()
+            .setAccelStruct(_as)
+            .setGeometries(pGeometries, numGeometries)
+            .setBuildFlags(buildFlags);
 
-        if (m_EnableAutomaticBarriers)
+        buildBottomLevelAccelStructs(&build, 1);
+#endif
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
+#ifdef NVRHI_WITH_RTXMU
+        // RTXMU manages the scratch memory and the barriers itself
+        for (size_t i = 0; i < numBuilds; i++)
         {
-            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            const rt::BlasBuildDesc& build = pBuilds[i];
+            buildBottomLevelAccelStruct(build.accelStruct, build.pGeometries, build.numGeometries, build.buildFlags);
         }
-        commitBarriers();
+#else
+        if (numBuilds == 0)
+            return;
 
-        auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
-            vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, maxPrimitiveCounts);
+        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+        const uint64_t scratchAlignment = m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment;
 
-        if (buildSizes.accelerationStructureSize > as->dataBuffer->getDesc().byteSize)
+        std::vector<BlasBuildGeometries> buildGeometries(numBuilds);
+        std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> buildInfos(numBuilds);
+        std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> buildRangeArrays(numBuilds);
+        std::vector<uint64_t> scratchOffsets(numBuilds);
+        uint64_t totalScratchSize = 0;
+
+        for (size_t i = 0; i < numBuilds; i++)
         {
-            std::stringstream ss;
-            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
-                << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->getDesc().byteSize << " bytes";
+            const rt::BlasBuildDesc& build = pBuilds[i];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
 
-            m_Context.error(ss.str());
-            return;
-        }
+            const bool performUpdate = (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+            if (performUpdate)
+            {
+                assert(as->allowUpdate);
+            }
 
-        size_t scratchSize = performUpdate
-            ? buildSizes.updateScratchSize
-            : buildSizes.buildScratchSize;
+            convertBlasBuildGeometries(build.pGeometries, build.numGeometries, currentVersion, buildGeometries[i]);
+
+            buildInfos[i] = getBlasBuildInfo(as, buildGeometries[i].geometries, build.buildFlags);
+            buildRangeArrays[i] = buildGeometries[i].buildRanges.data();
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            }
+
+            auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
+                vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfos[i], buildGeometries[i].maxPrimitiveCounts);
+
+            if (buildSizes.accelerationStructureSize > as->dataBuffer->getDesc().byteSize)
+            {
+                std::stringstream ss;
+                ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
+                    << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
+                    << as->dataBuffer->getDesc().byteSize << " bytes";
+
+                m_Context.error(ss.str());
+                return;
+            }
+
+            uint64_t scratchSize = performUpdate
+                ? buildSizes.updateScratchSize
+                : buildSizes.buildScratchSize;
+
+            // Pack the scratch regions of all builds into one allocation
+            scratchOffsets[i] = totalScratchSize;
+            totalScratchSize += align(scratchSize, scratchAlignment);
+        }
 
         Buffer* scratchBuffer = nullptr;
         uint64_t scratchOffset = 0;
 
-        bool allocated = m_ScratchManager->suballocateBuffer(scratchSize, &scratchBuffer, &scratchOffset, nullptr,
-            currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
+        bool allocated = m_ScratchManager->suballocateBuffer(totalScratchSize, &scratchBuffer, &scratchOffset, nullptr,
+            currentVersion, uint32_t(scratchAlignment));
 
         if (!allocated)
         {
+            if (numBuilds > 1)
+            {
+                // The batch doesn't fit into the scratch memory limit, build it in two halves.
+                // The geometry conversion above is repeated, which is only wasteful for the transforms that are uploaded again.
+                size_t const firstHalf = numBuilds / 2;
+                buildBottomLevelAccelStructs(pBuilds, firstHalf);
+                buildBottomLevelAccelStructs(pBuilds + firstHalf, numBuilds - firstHalf);
+                return;
+            }
+
             std::stringstream ss;
-            ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
-                "The build requires " << scratchSize << " bytes of scratch space.";
+            ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(pBuilds[0].accelStruct->getDesc().debugName) << " build. "
+                "The build requires " << totalScratchSize << " bytes of scratch space.";
 
             m_Context.error(ss.str());
             return;
         }
-        
+
+        m_Context.accelStructStats->buildScratchUsed(totalScratchSize);
+
         assert(scratchBuffer->deviceAddress);
-        buildInfo.setScratchData(scratchBuffer->deviceAddress + scratchOffset);
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            buildInfos[i].setScratchData(scratchBuffer->deviceAddress + scratchOffset + scratchOffsets[i]);
+        }
 
-        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
-        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
+        commitBarriers();
 
+        // The builds are independent, so they are recorded as one command that the GPU can execute concurrently.
+        // The barriers before the BLASes are used are placed when they transition to AccelStructRead.
         m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
+
+        // Compactable BLASes write their compacted sizes into queries, which are read when the command buffer is retired.
+        // Virtual BLASes are not compacted because their memory is managed by the application.
+        std::vector<AccelStruct*> compactableBlases;
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& build = pBuilds[i];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+
+            if (as->desc.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.add(as);
+
+            if ((build.buildFlags & rt::AccelStructBuildFlags::AllowCompaction) != 0 &&
+                (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) == 0 &&
+                !as->compacted && !as->desc.isVirtual)
+            {
+                compactableBlases.push_back(as);
+
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+                }
+            }
+        }
+
+        if (!compactableBlases.empty())
+        {
+            commitBarriers();
+
+            for (AccelStruct* as : compactableBlases)
+            {
+                // If no query is available, the BLAS just stays uncompacted
+                vk::QueryPool queryPool;
+                uint32_t query = 0;
+                if (!m_Context.blasCompaction->allocateQuery(false, queryPool, query))
+                    break;
+
+                m_CurrentCmdBuf->cmdBuf.resetQueryPool(queryPool, query, 1);
+                m_CurrentCmdBuf->cmdBuf.writeAccelerationStructuresPropertiesKHR(1, &as->accelStruct,
+                    vk::QueryType::eAccelerationStructureCompactedSizeKHR, queryPool, query);
+
+                m_CurrentCmdBuf->pendingCompactedSizes.push_back(PendingCompactedSize{ as, query });
+            }
+        }
 #endif
-        if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
     }
 
     void CommandList::compactBottomLevelAccelStructs()
@@ -769,16 +1081,248 @@ namespace nvrhi::vulkan
             {
                 m_Context.rtxMemUtil->PopulateCompactionCommandList(m_CurrentCmdBuf->cmdBuf, m_Context.rtxMuResources->asBuildsCompleted);
 
-                m_CurrentCmdBuf->rtxmuCompactionIds.insert(m_CurrentCmdBuf->rtxmuCompactionIds.end(), m_Context.rtxMuResources->asBuildsCompleted.begin(), m_Context.rtxMuResources->asBuildsCompleted.end());
+                m_CurrentCmdBuf->rtxmuCompactionIds.insert(m_CurrentCmdBuf->rtxmuCompactionIds.end(), m_Context.rtxMuResources->asBuildsCompleted.begin(), m_Context.rtxMuResources->asBuildsCompleted.end());
+
+                m_Context.rtxMuResources->asBuildsCompleted.clear();
+            }
+        }
+#else
+        std::vector<rt::AccelStructHandle> candidates;
+        m_Context.blasCompaction->takeCandidates(candidates);
+
+        if (candidates.empty())
+            return;
+
+        // Create the compacted BLASes and transition all of their buffers with one barrier batch.
+        // The small compacted buffers are sub-allocated from the shared memory blocks.
+
+        std::vector<BufferHandle> compactedBuffers(candidates.size());
+        std::vector<vk::AccelerationStructureKHR> compactedAccelStructs(candidates.size());
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            AccelStruct* as = checked_cast<AccelStruct*>(candidates[i].Get());
+
+            BufferDesc bufferDesc = as->dataBuffer->getDesc();
+            bufferDesc.byteSize = as->compactedSize;
+            BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+
+            if (!buffer)
+                continue;
+
+            auto createInfo = vk::AccelerationStructureCreateInfoKHR()
+                .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+                .setBuffer(checked_cast<Buffer*>(buffer.Get())->buffer)
+                .setSize(as->compactedSize);
+
+            compactedAccelStructs[i] = m_Context.device.createAccelerationStructureKHR(createInfo, m_Context.allocationCallbacks);
+
+            if (!compactedAccelStructs[i])
+                continue;
+
+            compactedBuffers[i] = buffer;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+                requireBufferState(buffer, nvrhi::ResourceStates::AccelStructWrite);
+            }
+        }
+        commitBarriers();
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (!compactedBuffers[i])
+                continue;
+
+            AccelStruct* as = checked_cast<AccelStruct*>(candidates[i].Get());
+
+            auto copyInfo = vk::CopyAccelerationStructureInfoKHR()
+                .setSrc(as->accelStruct)
+                .setDst(compactedAccelStructs[i])
+                .setMode(vk::CopyAccelerationStructureModeKHR::eCompact);
+
+            m_CurrentCmdBuf->cmdBuf.copyAccelerationStructureKHR(copyInfo);
+
+            // The original acceleration structure and its buffer are destroyed when this command buffer is retired,
+            // which returns their memory to the allocator
+            AccelStruct* original = new AccelStruct(m_Context);
+            original->accelStruct = as->accelStruct;
+            original->dataBuffer = std::move(as->dataBuffer);
+            m_CurrentCmdBuf->referencedResources.add(rt::AccelStructHandle::Create(original));
+
+            as->dataBuffer = compactedBuffers[i];
+            as->accelStruct = compactedAccelStructs[i];
+            as->compacted = true;
+            as->statsEntry.setCompacted(as->dataBuffer->getDesc().byteSize);
+
+            auto addressInfo = vk::AccelerationStructureDeviceAddressInfoKHR()
+                .setAccelerationStructure(as->accelStruct);
+
+            as->accelStructDeviceAddress = m_Context.device.getAccelerationStructureAddressKHR(addressInfo);
+
+            if (as->desc.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.add(as);
+        }
+#endif
+    }
+
+#ifndef NVRHI_WITH_RTXMU
+    BlasCompactionManager::~BlasCompactionManager()
+    {
+        if (m_QueryPool)
+        {
+            m_Context.device.destroyQueryPool(m_QueryPool, m_Context.allocationCallbacks);
+            m_QueryPool = vk::QueryPool();
+        }
+
+        if (m_MicromapQueryPool)
+        {
+            m_Context.device.destroyQueryPool(m_MicromapQueryPool, m_Context.allocationCallbacks);
+            m_MicromapQueryPool = vk::QueryPool();
+        }
+    }
+
+    bool BlasCompactionManager::allocateQuery(bool opacityMicromap, vk::QueryPool& outPool, uint32_t& outQuery)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        vk::QueryPool& queryPool = opacityMicromap ? m_MicromapQueryPool : m_QueryPool;
+        bool& creationFailed = opacityMicromap ? m_MicromapCreationFailed : m_CreationFailed;
+
+        if (creationFailed)
+            return false;
+
+        if (!queryPool)
+        {
+            auto poolInfo = vk::QueryPoolCreateInfo()
+                .setQueryType(opacityMicromap
+                    ? vk::QueryType::eMicromapCompactedSizeEXT
+                    : vk::QueryType::eAccelerationStructureCompactedSizeKHR)
+                .setQueryCount(uint32_t(m_Queries.getCapacity()));
+
+            const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &queryPool);
+            if (res != vk::Result::eSuccess)
+            {
+                m_Context.error(opacityMicromap
+                    ? "Failed to create the OMM compacted size query pool, OMM arrays will not be compacted"
+                    : "Failed to create the BLAS compacted size query pool, BLASes will not be compacted");
+                queryPool = vk::QueryPool();
+                creationFailed = true;
+                return false;
+            }
+        }
+
+        const int query = m_Queries.allocate();
+        if (query < 0)
+            return false;
+
+        outPool = queryPool;
+        outQuery = uint32_t(query);
+        return true;
+    }
+
+    void BlasCompactionManager::buildsDiscarded(std::vector<PendingCompactedSize>& builds)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const PendingCompactedSize& build : builds)
+        {
+            m_Queries.release(int(build.query));
+        }
+
+        builds.clear();
+    }
+
+    void BlasCompactionManager::buildsCompleted(std::vector<PendingCompactedSize>& builds)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (PendingCompactedSize& build : builds)
+        {
+            const vk::QueryPool queryPool = build.opacityMicromap ? m_MicromapQueryPool : m_QueryPool;
+
+            uint64_t compactedSize = 0;
+            const vk::Result res = m_Context.device.getQueryPoolResults(queryPool, build.query, 1,
+                sizeof(compactedSize), &compactedSize, sizeof(compactedSize), vk::QueryResultFlagBits::e64);
+
+            m_Queries.release(int(build.query));
+
+            if (res != vk::Result::eSuccess)
+                continue;
+
+            if (build.opacityMicromap)
+            {
+                OpacityMicromap* omm = checked_cast<OpacityMicromap*>(build.opacityMicromap.Get());
+                omm->compactedSize = compactedSize;
+
+                if (!omm->compacted && compactedSize != 0 && compactedSize < omm->dataBuffer->getDesc().byteSize)
+                    m_OpacityMicromapCandidates.push_back(std::move(build.opacityMicromap));
+
+                continue;
+            }
+
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct.Get());
+            as->compactedSize = compactedSize;
+
+            if (!as->compacted && compactedSize != 0 && compactedSize < as->dataBuffer->getDesc().byteSize)
+                m_Candidates.push_back(std::move(build.accelStruct));
+        }
+
+        builds.clear();
+    }
+
+    template<typename TObject, typename THandle>
+    static void takeCompactionCandidates(std::deque<THandle>& queue, uint64_t budget, std::vector<THandle>& outCandidates)
+    {
+        uint64_t totalSize = 0;
+        while (!queue.empty())
+        {
+            TObject* object = checked_cast<TObject*>(queue.front().Get());
+            totalSize += object->dataBuffer->getDesc().byteSize;
+
+            // Always take at least one object, so that those larger than the budget are still compacted
+            if (budget != 0 && totalSize > budget && !outCandidates.empty())
+                break;
+
+            outCandidates.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+    }
+
+    size_t BlasCompactionManager::getNumPendingCompactions()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Candidates.size() + m_OpacityMicromapCandidates.size();
+    }
+
+    void BlasCompactionManager::takeCandidates(std::vector<rt::AccelStructHandle>& outCandidates)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        takeCompactionCandidates<AccelStruct>(m_Candidates, m_Budget, outCandidates);
+    }
+
+    void BlasCompactionManager::takeOpacityMicromapCandidates(std::vector<rt::OpacityMicromapHandle>& outCandidates)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        takeCompactionCandidates<OpacityMicromap>(m_OpacityMicromapCandidates, m_Budget, outCandidates);
+    }
+#endif // !NVRHI_WITH_RTXMU
 
-                m_Context.rtxMuResources->asBuildsCompleted.clear();
-            }
-        }
-#endif
+    ScopedAccelStructBuildTimer CommandList::timeAccelStructBuild()
+    {
+        // Reusable command lists can be executed many times, their builds are not timed
+        return ScopedAccelStructBuildTimer(*m_Context.accelStructStats, m_Device, this,
+            m_CommandListParameters.isReusable ? nullptr : &m_CurrentCmdBuf->accelStructTimerQueries, m_AccelStructBuildTimingActive);
     }
 
-    void CommandList::buildTopLevelAccelStructInternal(AccelStruct* as, VkDeviceAddress instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags, uint64_t currentVersion)
+    void CommandList::buildTopLevelAccelStructInternal(AccelStruct* as, VkDeviceAddress instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags, uint64_t currentVersion, VkDeviceAddress indirectArgs)
     {
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
         // Remove the internal flag
         buildFlags = buildFlags & ~rt::AccelStructBuildFlags::AllowEmptyInstances;
 
@@ -786,7 +1330,7 @@ namespace nvrhi::vulkan
         if (performUpdate)
         {
             assert(as->allowUpdate);
-            assert(as->instances.size() == numInstances);
+            assert(as->numBuiltInstances == numInstances);
         }
 
         auto geometry = vk::AccelerationStructureGeometryKHR()
@@ -847,74 +1391,133 @@ namespace nvrhi::vulkan
             m_Context.error(ss.str());
             return;
         }
+
+        m_Context.accelStructStats->buildScratchUsed(scratchSize);
         
         assert(scratchBuffer->deviceAddress);
         buildInfo.setScratchData(scratchBuffer->deviceAddress + scratchOffset);
 
         std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
+
+        if (indirectArgs)
+        {
+            // The range is read from an rt::IndirectTlasBuildArgs structure, which matches VkAccelerationStructureBuildRangeInfoKHR
+            std::array<vk::DeviceAddress, 1> indirectAddresses = { indirectArgs };
+            std::array<uint32_t, 1> indirectStrides = { uint32_t(sizeof(rt::IndirectTlasBuildArgs)) };
+            std::array<const uint32_t*, 1> maxPrimitiveCountArrays = { maxPrimitiveCounts.data() };
+
+            m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresIndirectKHR(buildInfos, indirectAddresses, indirectStrides, maxPrimitiveCountArrays);
+            return;
+        }
+
         std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
 
         m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
     }
 
+    // Identifies each instance conversion in buildTopLevelAccelStruct, see AccelStruct::lastInstanceConversion
+    static std::atomic<uint64_t> g_InstanceConversionCounter = 0;
+
+    // Number of instances converted by one task, 64 KB of instance data
+    static constexpr size_t c_InstanceConversionChunkSize = 1024;
+
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
 
-        as->instances.resize(numInstances);
+        as->numBuiltInstances = numInstances;
+
+        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
 
-        for (size_t i = 0; i < numInstances; i++)
+        // Write the instances directly to the upload buffer. Every instance is written with one 64-byte copy
+        // of a fully initialized local struct, which is efficient for write-combined memory.
+        Buffer* uploadBuffer = nullptr;
+        uint64_t uploadOffset = 0;
+        void* uploadCpuVA = nullptr;
+        if (!m_UploadManager->suballocateBuffer(numInstances * sizeof(vk::AccelerationStructureInstanceKHR),
+            &uploadBuffer, &uploadOffset, &uploadCpuVA, currentVersion))
         {
-            const rt::InstanceDesc& src = pInstances[i];
-            vk::AccelerationStructureInstanceKHR& dst = as->instances[i];
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return;
+        }
+
+        const uint64_t conversionId = ++g_InstanceConversionCounter;
+        std::vector<AccelStruct*> uniqueBottomLevelASes;
+        std::mutex uniqueBottomLevelASesMutex;
 
-            if (src.bottomLevelAS)
-            {
-                AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
 #ifdef NVRHI_WITH_RTXMU
-                blas->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(blas->rtxmuId);
-                blas->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(blas->rtxmuId);
-                blas->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(blas->rtxmuId);
-                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+        // RTXMU lookups are not thread-safe
+        IParallelTaskRunner* parallelTaskRunner = nullptr;
 #else
-                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+        IParallelTaskRunner* parallelTaskRunner = m_Context.parallelTaskRunner;
+#endif
 
-                if (m_EnableAutomaticBarriers)
+        parallelFor(parallelTaskRunner, numInstances, c_InstanceConversionChunkSize, [&](size_t begin, size_t end)
+        {
+            std::vector<AccelStruct*> newBottomLevelASes;
+            AccelStruct* previousBlas = nullptr;
+
+            for (size_t i = begin; i < end; i++)
+            {
+                const rt::InstanceDesc& src = pInstances[i];
+                vk::AccelerationStructureInstanceKHR dst;
+
+                if (src.bottomLevelAS)
                 {
-                    requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
-                }
+                    AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
+#ifdef NVRHI_WITH_RTXMU
+                    blas->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(blas->rtxmuId);
+                    blas->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(blas->rtxmuId);
+                    blas->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(blas->rtxmuId);
 #endif
+                    dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+
+                    // Collect every BLAS once, without hashing: consecutive instances often use the same BLAS,
+                    // and the others are marked with the conversion ID. Checking before the exchange keeps
+                    // the cache line shared between the threads after the first instance of each BLAS.
+                    if (blas != previousBlas
+                        && blas->lastInstanceConversion.load(std::memory_order_relaxed) != conversionId
+                        && blas->lastInstanceConversion.exchange(conversionId, std::memory_order_relaxed) != conversionId)
+                    {
+                        newBottomLevelASes.push_back(blas);
+                    }
+                    previousBlas = blas;
+                }
+                else // !src.bottomLevelAS
+                {
+                    dst.setAccelerationStructureReference(0);
+                }
+
+                dst.setInstanceCustomIndex(src.instanceID);
+                dst.setInstanceShaderBindingTableRecordOffset(src.instanceContributionToHitGroupIndex);
+                dst.setFlags(convertInstanceFlags(src.flags));
+                dst.setMask(src.instanceMask);
+                memcpy(dst.transform.matrix.data(), src.transform, sizeof(float) * 12);
+
+                // The vk::AccelerationStructureInstanceKHR struct should be directly copyable, but ReSharper/clang thinks it's not,
+                // so the inspection is disabled with a comment below.
+                memcpy(static_cast<vk::AccelerationStructureInstanceKHR*>(uploadCpuVA) + i, &dst, sizeof(dst)); // NOLINT(bugprone-undefined-memory-manipulation)
             }
-            else // !src.bottomLevelAS
+
+            if (!newBottomLevelASes.empty())
             {
-                dst.setAccelerationStructureReference(0);
+                std::lock_guard lockGuard(uniqueBottomLevelASesMutex);
+                uniqueBottomLevelASes.insert(uniqueBottomLevelASes.end(), newBottomLevelASes.begin(), newBottomLevelASes.end());
             }
-
-            dst.setInstanceCustomIndex(src.instanceID);
-            dst.setInstanceShaderBindingTableRecordOffset(src.instanceContributionToHitGroupIndex);
-            dst.setFlags(convertInstanceFlags(src.flags));
-            dst.setMask(src.instanceMask);
-            memcpy(dst.transform.matrix.data(), src.transform, sizeof(float) * 12);
-        }
+        });
 
 #ifdef NVRHI_WITH_RTXMU
         m_Context.rtxMemUtil->PopulateUAVBarriersCommandList(m_CurrentCmdBuf->cmdBuf, m_CurrentCmdBuf->rtxmuBuildIds);
+#else
+        // Require the states once per unique BLAS instead of once per instance.
+        // Concurrent TLAS builds on other command lists can make a BLAS appear twice, which is harmless.
+        if (m_EnableAutomaticBarriers)
+        {
+            for (AccelStruct* blas : uniqueBottomLevelASes)
+                requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+        }
 #endif
 
-        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
-
-        Buffer* uploadBuffer = nullptr;
-        uint64_t uploadOffset = 0;
-        void* uploadCpuVA = nullptr;
-        m_UploadManager->suballocateBuffer(as->instances.size() * sizeof(vk::AccelerationStructureInstanceKHR),
-            &uploadBuffer, &uploadOffset, &uploadCpuVA, currentVersion);
-
-        // Copy the instance data to GPU-visible memory.
-        // The vk::AccelerationStructureInstanceKHR struct should be directly copyable, but ReSharper/clang thinks it's not,
-        // so the inspection is disabled with a comment below.
-        memcpy(uploadCpuVA, as->instances.data(), // NOLINT(bugprone-undefined-memory-manipulation)
-            as->instances.size() * sizeof(vk::AccelerationStructureInstanceKHR));
-
         if (m_EnableAutomaticBarriers)
         {
             requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
@@ -924,7 +1527,7 @@ namespace nvrhi::vulkan
         buildTopLevelAccelStructInternal(as, uploadBuffer->deviceAddress + uploadOffset, numInstances, buildFlags, currentVersion);
 
         if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
+            m_CurrentCmdBuf->referencedResources.add(as);
     }
 
     void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* _instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -932,7 +1535,7 @@ namespace nvrhi::vulkan
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
         Buffer* instanceBuffer = checked_cast<Buffer*>(_instanceBuffer);
 
-        as->instances.clear();
+        as->numBuiltInstances = numInstances;
 
         if (m_EnableAutomaticBarriers)
         {
@@ -946,11 +1549,44 @@ namespace nvrhi::vulkan
         buildTopLevelAccelStructInternal(as, instanceBuffer->deviceAddress + instanceBufferOffset, numInstances, buildFlags, currentVersion);
 
         if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
+            m_CurrentCmdBuf->referencedResources.add(as);
+    }
+
+    void CommandList::buildTopLevelAccelStructFromBufferIndirect(rt::IAccelStruct* _as, nvrhi::IBuffer* _instanceBuffer, uint64_t instanceBufferOffset,
+        nvrhi::IBuffer* _argsBuffer, uint64_t argsBufferOffset, size_t maxInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        Buffer* instanceBuffer = checked_cast<Buffer*>(_instanceBuffer);
+        Buffer* argsBuffer = checked_cast<Buffer*>(_argsBuffer);
+
+        // Without indirect builds, the TLAS is built with maxInstances instances,
+        // and the instances past the GPU count are inactive.
+        const bool indirectBuild = m_Context.accelStructFeatures.accelerationStructureIndirectBuild;
+
+        as->numBuiltInstances = maxInstances;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            requireBufferState(instanceBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+            if (indirectBuild)
+                requireBufferState(argsBuffer, nvrhi::ResourceStates::IndirectArgument | nvrhi::ResourceStates::AccelStructBuildInput);
+        }
+        commitBarriers();
+
+        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+
+        buildTopLevelAccelStructInternal(as, instanceBuffer->deviceAddress + instanceBufferOffset, maxInstances, buildFlags, currentVersion,
+            indirectBuild ? argsBuffer->deviceAddress + argsBufferOffset : 0);
+
+        if (as->desc.trackLiveness)
+            m_CurrentCmdBuf->referencedResources.add(as);
     }
 
     void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
     {
+        [[maybe_unused]] auto buildTimer = timeAccelStructBuild();
+
         // Create Vulkan operation info
         vk::ClusterAccelerationStructureInputInfoNV inputInfo = {};
         vk::ClusterAccelerationStructureMoveObjectsInputNV moveInput = {};
@@ -984,15 +1620,15 @@ namespace nvrhi::vulkan
 
         // Track resources for liveness
         if (indirectArgCountBuffer)
-            m_CurrentCmdBuf->referencedResources.push_back(indirectArgCountBuffer);
+            m_CurrentCmdBuf->referencedResources.add(indirectArgCountBuffer);
         if (indirectArgsBuffer)
-            m_CurrentCmdBuf->referencedResources.push_back(indirectArgsBuffer);
+            m_CurrentCmdBuf->referencedResources.add(indirectArgsBuffer);
         if (inOutAddressesBuffer)
-            m_CurrentCmdBuf->referencedResources.push_back(inOutAddressesBuffer);
+            m_CurrentCmdBuf->referencedResources.add(inOutAddressesBuffer);
         if (outSizesBuffer)
-            m_CurrentCmdBuf->referencedResources.push_back(outSizesBuffer);
+            m_CurrentCmdBuf->referencedResources.add(outSizesBuffer);
         if (outAccelerationStructuresBuffer)
-            m_CurrentCmdBuf->referencedResources.push_back(outAccelerationStructuresBuffer);
+            m_CurrentCmdBuf->referencedResources.add(outAccelerationStructuresBuffer);
 
         commitBarriers();
 
@@ -1015,6 +1651,8 @@ namespace nvrhi::vulkan
             }
         }
 
+        m_Context.accelStructStats->clusterOperationExecuted(desc.scratchSizeInBytes);
+
         // Create commands info
         vk::ClusterAccelerationStructureCommandsInfoNV commandsInfo = {};
         commandsInfo.input = inputInfo;
@@ -1128,6 +1766,119 @@ namespace nvrhi::vulkan
         return getBufferAddress(dataBuffer, 0).deviceAddress;
     }
 
+    bool CommandList::updatePersistentShaderTable(ShaderTable* shaderTable)
+    {
+        const RayTracingPipeline* pso = shaderTable->pipeline;
+        const uint32_t shaderGroupHandleSize = m_Context.rayTracingPipelineProperties.shaderGroupHandleSize;
+        const uint32_t entrySize = m_Context.rayTracingPipelineProperties.shaderGroupBaseAlignment;
+        const uint32_t numEntries = shaderTable->getNumEntries();
+
+        if (!shaderTable->persistentBuffer || shaderTable->persistentBuffer->getDesc().byteSize < uint64_t(numEntries) * entrySize)
+        {
+            // Grow geometrically, so that tables that are filled gradually are not reallocated on every use
+            uint64_t capacity = std::max(numEntries, shaderTable->desc.initialCapacity);
+            if (shaderTable->persistentBuffer)
+                capacity = std::max(capacity, 2 * (shaderTable->persistentBuffer->getDesc().byteSize / entrySize));
+
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = capacity * entrySize;
+            bufferDesc.isShaderBindingTable = true;
+            bufferDesc.initialState = ResourceStates::ShaderResource;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = shaderTable->desc.debugName;
+
+            // The command buffers that used the previous buffer keep it alive until they finish executing
+            shaderTable->persistentBuffer = m_Device->createBuffer(bufferDesc);
+            shaderTable->markAllEntriesDirty();
+
+            if (!shaderTable->persistentBuffer)
+            {
+                m_Context.error("Failed to create the buffer for a persistent shader table");
+                return false;
+            }
+        }
+
+        Buffer* buffer = checked_cast<Buffer*>(shaderTable->persistentBuffer.Get());
+        m_CurrentCmdBuf->referencedResources.add(buffer);
+
+        // Merge the changed records into ranges, also rewriting small gaps between them to reduce the number of copies
+
+        std::vector<vk::BufferCopy> copyRegions;
+
+        if (shaderTable->allEntriesDirty)
+        {
+            copyRegions.push_back(vk::BufferCopy().setDstOffset(0).setSize(uint64_t(numEntries) * entrySize));
+        }
+        else if (!shaderTable->dirtyEntries.empty())
+        {
+            constexpr uint64_t c_MaxMergedGap = 8;
+
+            std::vector<uint32_t>& dirtyEntries = shaderTable->dirtyEntries;
+            std::sort(dirtyEntries.begin(), dirtyEntries.end());
+
+            for (uint32_t index : dirtyEntries)
+            {
+                // Records past the end may have been removed after they were changed
+                if (index >= numEntries)
+                    break;
+
+                const uint64_t offset = uint64_t(index) * entrySize;
+
+                if (!copyRegions.empty() && offset <= copyRegions.back().dstOffset + copyRegions.back().size + c_MaxMergedGap * entrySize)
+                    copyRegions.back().size = std::max(copyRegions.back().size, offset + entrySize - copyRegions.back().dstOffset);
+                else
+                    copyRegions.push_back(vk::BufferCopy().setDstOffset(offset).setSize(entrySize));
+            }
+        }
+
+        if (!copyRegions.empty())
+        {
+            uint64_t uploadSize = 0;
+            for (const vk::BufferCopy& region : copyRegions)
+                uploadSize += region.size;
+
+            Buffer* uploadBuffer = nullptr;
+            uint64_t uploadOffset = 0;
+            uint8_t* uploadCpuVA = nullptr;
+            if (!m_UploadManager->suballocateBuffer(uploadSize, &uploadBuffer, &uploadOffset, (void**)&uploadCpuVA,
+                MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false), entrySize))
+            {
+                m_Context.error("Failed to suballocate an upload buffer for the SBT");
+                return false;
+            }
+
+            // Pack the records of all regions into one upload allocation, and copy them with one command
+            for (vk::BufferCopy& region : copyRegions)
+            {
+                region.setSrcOffset(uploadOffset);
+
+                const uint32_t firstEntry = uint32_t(region.dstOffset / entrySize);
+                const uint32_t numRegionEntries = uint32_t(region.size / entrySize);
+                for (uint32_t i = 0; i < numRegionEntries; i++)
+                {
+                    memcpy(uploadCpuVA + i * entrySize,
+                        pso->shaderGroupHandles.data() + shaderGroupHandleSize * shaderTable->getEntry(firstEntry + i),
+                        shaderGroupHandleSize);
+                }
+
+                uploadCpuVA += region.size;
+                uploadOffset += region.size;
+            }
+
+            requireBufferState(buffer, ResourceStates::CopyDest);
+            commitBarriers();
+
+            m_CurrentCmdBuf->cmdBuf.copyBuffer(uploadBuffer->buffer, buffer->buffer, copyRegions);
+
+            requireBufferState(buffer, ResourceStates::ShaderResource);
+        }
+
+        shaderTable->dirtyEntries.clear();
+        shaderTable->allEntriesDirty = false;
+
+        return true;
+    }
+
     void CommandList::setRayTracingState(const rt::State& state)
     {
         if (!state.shaderTable)
@@ -1157,12 +1908,13 @@ namespace nvrhi::vulkan
 
         if (m_CurrentRayTracingState.shaderTable != state.shaderTable)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.shaderTable);
+            m_CurrentCmdBuf->referencedResources.add(state.shaderTable);
         }
 
         if (!m_CurrentRayTracingState.shaderTable || m_CurrentRayTracingState.shaderTable->getPipeline() != pso)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, pso->pipeline);
+            ++m_Stats.pipelineBinds;
             m_CurrentPipelineLayout = pso->pipelineLayout;
             m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
         }
@@ -1179,94 +1931,87 @@ namespace nvrhi::vulkan
             const uint32_t shaderGroupHandleSize = m_Context.rayTracingPipelineProperties.shaderGroupHandleSize;
             const uint32_t shaderGroupBaseAlignment = m_Context.rayTracingPipelineProperties.shaderGroupBaseAlignment;
 
-            const uint32_t shaderTableSize = shaderTable->getNumEntries() * shaderGroupBaseAlignment;
+            vk::DeviceAddress sbtAddress = 0;
 
-            // First, allocate a piece of the upload buffer. That will be our SBT on the device.
-
-            Buffer* uploadBuffer = nullptr;
-            uint64_t uploadOffset = 0;
-            uint8_t* uploadCpuVA = nullptr;
-            bool allocated = m_UploadManager->suballocateBuffer(shaderTableSize, &uploadBuffer, &uploadOffset, (void**)&uploadCpuVA,
-                MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false),
-                shaderGroupBaseAlignment);
-
-            if (!allocated)
+            if (shaderTable->desc.isPersistent)
             {
-                m_Context.error("Failed to suballocate an upload buffer for the SBT");
-                return;
+                // Only upload the changed records into the device-local copy of the SBT
+                if (!updatePersistentShaderTable(shaderTable))
+                    return;
+
+                sbtAddress = checked_cast<Buffer*>(shaderTable->persistentBuffer.Get())->deviceAddress;
             }
+            else
+            {
+                const uint32_t numEntries = shaderTable->getNumEntries();
+                const uint32_t shaderTableSize = numEntries * shaderGroupBaseAlignment;
+
+                // First, allocate a piece of the upload buffer. That will be our SBT on the device.
+
+                Buffer* uploadBuffer = nullptr;
+                uint64_t uploadOffset = 0;
+                uint8_t* uploadCpuVA = nullptr;
+                bool allocated = m_UploadManager->suballocateBuffer(shaderTableSize, &uploadBuffer, &uploadOffset, (void**)&uploadCpuVA,
+                    MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false),
+                    shaderGroupBaseAlignment);
+
+                if (!allocated)
+                {
+                    m_Context.error("Failed to suballocate an upload buffer for the SBT");
+                    return;
+                }
 
-            assert(uploadCpuVA);
-            assert(uploadBuffer);
+                assert(uploadCpuVA);
+                assert(uploadBuffer);
 
-            // Copy the shader and group handles into the device SBT, record the pointers.
+                // Copy the shader and group handles into the device SBT.
+
+                for (uint32_t sbtIndex = 0; sbtIndex < numEntries; sbtIndex++)
+                {
+                    memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
+                        pso->shaderGroupHandles.data() + shaderGroupHandleSize * shaderTable->getEntry(sbtIndex),
+                        shaderGroupHandleSize);
+                }
+
+                sbtAddress = uploadBuffer->deviceAddress + uploadOffset;
+            }
+
+            // Record the pointers to the SBT sections for use in dispatchRays later, and the version.
 
             vk::StridedDeviceAddressRegionKHR rayGenHandle;
             vk::StridedDeviceAddressRegionKHR missHandles;
             vk::StridedDeviceAddressRegionKHR hitGroupHandles;
             vk::StridedDeviceAddressRegionKHR callableHandles;
 
-            // ... RayGen
-
             uint32_t sbtIndex = 0;
-            memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
-                pso->shaderGroupHandles.data() + shaderGroupHandleSize * shaderTable->rayGenerationShader,
-                shaderGroupHandleSize);
-            rayGenHandle.setDeviceAddress(uploadBuffer->deviceAddress + uploadOffset + sbtIndex * shaderGroupBaseAlignment);
+            rayGenHandle.setDeviceAddress(sbtAddress);
             rayGenHandle.setSize(shaderGroupBaseAlignment);
             rayGenHandle.setStride(shaderGroupBaseAlignment);
             sbtIndex++;
 
-            // ... Miss
-
             if (!shaderTable->missShaders.empty())
             {
-                missHandles.setDeviceAddress(uploadBuffer->deviceAddress + uploadOffset + sbtIndex * shaderGroupBaseAlignment);
-                for (uint32_t shaderGroupIndex : shaderTable->missShaders)
-                {
-                    memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
-                        pso->shaderGroupHandles.data() + shaderGroupHandleSize * shaderGroupIndex,
-                        shaderGroupHandleSize);
-                    sbtIndex++;
-                }
+                missHandles.setDeviceAddress(sbtAddress + sbtIndex * shaderGroupBaseAlignment);
                 missHandles.setSize(shaderGroupBaseAlignment * uint32_t(shaderTable->missShaders.size()));
                 missHandles.setStride(shaderGroupBaseAlignment);
+                sbtIndex += uint32_t(shaderTable->missShaders.size());
             }
 
-            // ... Hit Groups
-
             if (!shaderTable->hitGroups.empty())
             {
-                hitGroupHandles.setDeviceAddress(uploadBuffer->deviceAddress + uploadOffset + sbtIndex * shaderGroupBaseAlignment);
-                for (uint32_t shaderGroupIndex : shaderTable->hitGroups)
-                {
-                    memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
-                        pso->shaderGroupHandles.data() + shaderGroupHandleSize * shaderGroupIndex,
-                        shaderGroupHandleSize);
-                    sbtIndex++;
-                }
+                hitGroupHandles.setDeviceAddress(sbtAddress + sbtIndex * shaderGroupBaseAlignment);
                 hitGroupHandles.setSize(shaderGroupBaseAlignment * uint32_t(shaderTable->hitGroups.size()));
                 hitGroupHandles.setStride(shaderGroupBaseAlignment);
+                sbtIndex += uint32_t(shaderTable->hitGroups.size());
             }
 
-            // ... Callable
-
             if (!shaderTable->callableShaders.empty())
             {
-                callableHandles.setDeviceAddress(uploadBuffer->deviceAddress + uploadOffset + sbtIndex * shaderGroupBaseAlignment);
-                for (uint32_t shaderGroupIndex : shaderTable->callableShaders)
-                {
-                    memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
-                        pso->shaderGroupHandles.data() + shaderGroupHandleSize * shaderGroupIndex,
-                        shaderGroupHandleSize);
-                    sbtIndex++;
-                }
+                callableHandles.setDeviceAddress(sbtAddress + sbtIndex * shaderGroupBaseAlignment);
                 callableHandles.setSize(shaderGroupBaseAlignment * uint32_t(shaderTable->callableShaders.size()));
                 callableHandles.setStride(shaderGroupBaseAlignment);
             }
 
-            // Store the device pointers to the SBT for use in dispatchRays later, and the version.
-
             m_CurrentShaderTablePointers.rayGen = rayGenHandle;
             m_CurrentShaderTablePointers.miss = missHandles;
             m_CurrentShaderTablePointers.hitGroups = hitGroupHandles;
@@ -1280,6 +2025,7 @@ namespace nvrhi::vulkan
         m_CurrentComputeState = ComputeState();
         m_CurrentMeshletState = MeshletState();
         m_CurrentRayTracingState = state;
+        m_CurrentWorkGraphState = WorkGraphState();
         m_AnyVolatileBufferWrites = false;
     }
 
@@ -1288,6 +2034,7 @@ namespace nvrhi::vulkan
         assert(m_CurrentCmdBuf);
 
         updateRayTracingVolatileBuffers();
+        ++m_Stats.dispatches;
 
         m_CurrentCmdBuf->cmdBuf.traceRaysKHR(
             &m_CurrentShaderTablePointers.rayGen,
@@ -1330,8 +2077,11 @@ namespace nvrhi::vulkan
 
     rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::createRayTracingPipeline");
+
         RayTracingPipeline* pso = new RayTracingPipeline(m_Context);
         pso->desc = desc;
+        pso->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::RayTracingPipeline);
 
         vk::Result res = createPipelineLayout(
             pso->pipelineLayout,
@@ -1477,6 +2227,7 @@ namespace nvrhi::vulkan
             .setAllowClusterAccelerationStructure(true);
 
         auto pipelineInfo = vk::RayTracingPipelineCreateInfoKHR()
+            .setFlags(m_Context.getPipelineCreateFlags())
             .setStages(shaderStages)
             .setGroups(shaderGroups)
             .setLayout(pso->pipelineLayout)
@@ -1488,10 +2239,50 @@ namespace nvrhi::vulkan
             pipelineInfo.setPNext(&pipelineClusters);
         }
 
-        res = m_Context.device.createRayTracingPipelinesKHR(vk::DeferredOperationKHR(), m_Context.pipelineCache,
-            1, &pipelineInfo,
-            m_Context.allocationCallbacks,
-            &pso->pipeline);
+        if (m_Context.parallelTaskRunner && m_Context.extensions.KHR_deferred_host_operations)
+        {
+            // Let the driver split the compilation into parts that the application's threads can execute in parallel
+            vk::DeferredOperationKHR deferredOperation;
+            res = m_Context.device.createDeferredOperationKHR(m_Context.allocationCallbacks, &deferredOperation);
+            CHECK_VK_FAIL(res)
+
+            res = m_Context.device.createRayTracingPipelinesKHR(deferredOperation, m_Context.pipelineCache,
+                1, &pipelineInfo,
+                m_Context.allocationCallbacks,
+                &pso->pipeline);
+
+            if (res == vk::Result::eOperationDeferredKHR)
+            {
+                uint32_t const maxConcurrency = m_Context.device.getDeferredOperationMaxConcurrencyKHR(deferredOperation);
+
+                m_Context.parallelTaskRunner->runParallel(std::max(maxConcurrency, 1u), [this, deferredOperation]()
+                {
+                    // eThreadIdleKHR means that there is no work for this thread right now, but there may be later
+                    while (m_Context.device.deferredOperationJoinKHR(deferredOperation) == vk::Result::eThreadIdleKHR)
+                        std::this_thread::yield();
+                });
+
+                // The runner may return before the last part has finished on another thread, keep helping until it's done
+                while ((res = m_Context.device.getDeferredOperationResultKHR(deferredOperation)) == vk::Result::eNotReady)
+                {
+                    if (m_Context.device.deferredOperationJoinKHR(deferredOperation) == vk::Result::eThreadIdleKHR)
+                        std::this_thread::yield();
+                }
+            }
+            else if (res == vk::Result::eOperationNotDeferredKHR)
+            {
+                res = vk::Result::eSuccess;
+            }
+
+            m_Context.device.destroyDeferredOperationKHR(deferredOperation, m_Context.allocationCallbacks);
+        }
+        else
+        {
+            res = m_Context.device.createRayTracingPipelinesKHR(vk::DeferredOperationKHR(), m_Context.pipelineCache,
+                1, &pipelineInfo,
+                m_Context.allocationCallbacks,
+                &pso->pipeline);
+        }
 
         CHECK_VK_FAIL(res)
 
@@ -1525,7 +2316,12 @@ namespace nvrhi::vulkan
 
     rt::ShaderTableHandle RayTracingPipeline::createShaderTable()
     {
-        ShaderTable* st = new ShaderTable(m_Context, this);
+        return createShaderTable(rt::ShaderTableDesc());
+    }
+
+    rt::ShaderTableHandle RayTracingPipeline::createShaderTable(const rt::ShaderTableDesc& shaderTableDesc)
+    {
+        ShaderTable* st = new ShaderTable(m_Context, this, shaderTableDesc);
         return rt::ShaderTableHandle::Create(st);
     }
 
@@ -1562,6 +2358,18 @@ namespace nvrhi::vulkan
         return false;
     }
 
+    void ShaderTable::markEntryDirty(uint32_t index)
+    {
+        if (desc.isPersistent && !allEntriesDirty)
+            dirtyEntries.push_back(index);
+    }
+
+    void ShaderTable::markAllEntriesDirty()
+    {
+        allEntriesDirty = true;
+        dirtyEntries.clear();
+    }
+
     void ShaderTable::setRayGenerationShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
     {
         if (bindings != nullptr)
@@ -1572,80 +2380,132 @@ namespace nvrhi::vulkan
         if (verifyShaderGroupExists(exportName, shaderGroupIndex))
         {
             rayGenerationShader = shaderGroupIndex;
+            markEntryDirty(0);
             ++version;
         }
     }
 
-    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    int ShaderTable::addEntry(std::vector<uint32_t>& entries, uint32_t firstEntry, const char* exportName, IBindingSet* bindings)
     {
         if (bindings != nullptr)
             utils::NotSupported();
 
         const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
 
-        if (verifyShaderGroupExists(exportName, shaderGroupIndex))
-        {
-            missShaders.push_back(uint32_t(shaderGroupIndex));
-            ++version;
+        if (!verifyShaderGroupExists(exportName, shaderGroupIndex))
+            return -1;
 
-            return int(missShaders.size()) - 1;
-        }
+        entries.push_back(uint32_t(shaderGroupIndex));
+
+        // Adding a record to a section moves the records of the following sections
+        const uint32_t index = firstEntry + uint32_t(entries.size()) - 1;
+        if (index + 1 == getNumEntries())
+            markEntryDirty(index);
+        else
+            markAllEntriesDirty();
 
-        return -1;
+        ++version;
+
+        return int(entries.size()) - 1;
     }
 
-    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    bool ShaderTable::setEntry(std::vector<uint32_t>& entries, uint32_t firstEntry, int index, const char* exportName, IBindingSet* bindings)
     {
         if (bindings != nullptr)
             utils::NotSupported();
 
+        if (index < 0 || size_t(index) >= entries.size())
+        {
+            m_Context.error("Shader table record index is out of bounds");
+            return false;
+        }
+
         const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
 
-        if (verifyShaderGroupExists(exportName, shaderGroupIndex))
-        {
-            hitGroups.push_back(uint32_t(shaderGroupIndex));
-            ++version;
+        if (!verifyShaderGroupExists(exportName, shaderGroupIndex))
+            return false;
 
-            return int(hitGroups.size()) - 1;
-        }
+        entries[index] = uint32_t(shaderGroupIndex);
 
-        return -1;
+        markEntryDirty(firstEntry + uint32_t(index));
+        ++version;
+
+        return true;
     }
 
-    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    void ShaderTable::clearEntries(std::vector<uint32_t>& entries, uint32_t firstEntry)
     {
-        if (bindings != nullptr)
-            utils::NotSupported();
+        const bool isLastSection = firstEntry + entries.size() == getNumEntries();
 
-        const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
+        entries.clear();
 
-        if (verifyShaderGroupExists(exportName, shaderGroupIndex))
-        {
-            callableShaders.push_back(uint32_t(shaderGroupIndex));
-            ++version;
+        // Removing the records of the last section doesn't change the remaining ones
+        if (!isLastSection)
+            markAllEntriesDirty();
 
-            return int(callableShaders.size()) - 1;
-        }
+        ++version;
+    }
+
+    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addEntry(missShaders, 1, exportName, bindings);
+    }
+
+    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addEntry(hitGroups, 1 + uint32_t(missShaders.size()), exportName, bindings);
+    }
+
+    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addEntry(callableShaders, 1 + uint32_t(missShaders.size() + hitGroups.size()), exportName, bindings);
+    }
 
-        return -1;
+    bool ShaderTable::setMissShader(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(missShaders, 1, index, exportName, bindings);
+    }
+
+    bool ShaderTable::setHitGroup(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(hitGroups, 1 + uint32_t(missShaders.size()), index, exportName, bindings);
+    }
+
+    bool ShaderTable::setCallableShader(int index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setEntry(callableShaders, 1 + uint32_t(missShaders.size() + hitGroups.size()), index, exportName, bindings);
     }
 
     void ShaderTable::clearMissShaders()
     {
-        missShaders.clear();
-        ++version;
+        clearEntries(missShaders, 1);
     }
 
     void ShaderTable::clearHitShaders()
     {
-        hitGroups.clear();
-        ++version;
+        clearEntries(hitGroups, 1 + uint32_t(missShaders.size()));
     }
 
     void ShaderTable::clearCallableShaders()
     {
-        callableShaders.clear();
-        ++version;
+        clearEntries(callableShaders, 1 + uint32_t(missShaders.size() + hitGroups.size()));
+    }
+
+    uint32_t ShaderTable::getEntry(uint32_t index) const
+    {
+        if (index == 0)
+            return uint32_t(rayGenerationShader);
+        index -= 1;
+
+        if (index < missShaders.size())
+            return missShaders[index];
+        index -= uint32_t(missShaders.size());
+
+        if (index < hitGroups.size())
+            return hitGroups[index];
+        index -= uint32_t(hitGroups.size());
+
+        return callableShaders[index];
     }
     
     uint32_t ShaderTable::getNumEntries() const
@@ -0,0 +1,320 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+#include <sstream>
+
+namespace nvrhi::vulkan
+{
+    extern vk::ImageAspectFlags guessImageAspectFlags(vk::Format format);
+
+    // Makes the copy into the readback memory visible to the host once the command buffer has finished
+    static void makeReadbackVisibleToHost(vk::CommandBuffer cmdBuf)
+    {
+        auto memoryBarrier = vk::MemoryBarrier()
+            .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+            .setDstAccessMask(vk::AccessFlagBits::eHostRead);
+
+        cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+            vk::DependencyFlags(), 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    ReadbackTicket::~ReadbackTicket()
+    {
+        m_Pool.release(bufferIndex, offset);
+    }
+
+    void ReadbackTicket::setSubmission(Queue* queue, uint64_t submissionID)
+    {
+        m_SubmissionID.store(submissionID, std::memory_order_relaxed);
+        m_Queue.store(queue, std::memory_order_release);
+    }
+
+    bool ReadbackTicket::isReady()
+    {
+        if (m_Ready.load(std::memory_order_acquire))
+            return true;
+
+        Queue* queue = m_Queue.load(std::memory_order_acquire);
+        if (!queue)
+            return false;
+
+        if (!queue->pollCommandList(m_SubmissionID.load(std::memory_order_relaxed)))
+            return false;
+
+        // Concurrent polls may both invalidate the range, which is harmless
+        m_Pool.invalidate(*this);
+        m_Ready.store(true, std::memory_order_release);
+        return true;
+    }
+
+    RefCountPtr<ReadbackTicket> ReadbackPool::allocate(uint64_t size, uint64_t alignment, Buffer** outBuffer)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint32_t bufferIndex = 0;
+        uint64_t offset = 0;
+        bool allocated = false;
+
+        for (; bufferIndex < uint32_t(m_Buffers.size()); ++bufferIndex)
+        {
+            if (m_Buffers[bufferIndex]->ring.allocate(size, alignment, offset))
+            {
+                allocated = true;
+                break;
+            }
+        }
+
+        if (!allocated)
+        {
+            // All buffers are full or hold tickets that block their tails, add a new one
+            const uint64_t bufferSize = std::max(m_BufferSize, align(size, uint64_t(65536)));
+            auto buffer = std::make_unique<ReadbackBuffer>(bufferSize);
+
+            std::stringstream ss;
+            ss << "ReadbackBuffer" << m_Buffers.size();
+            const std::string debugName = ss.str();
+
+            BufferDesc desc;
+            desc.byteSize = bufferSize;
+            desc.cpuAccess = CpuAccessMode::Read;
+            desc.debugName = debugName;
+            desc.initialState = ResourceStates::CopyDest;
+            desc.keepInitialState = true;
+
+            buffer->buffer = m_Device->createBuffer(desc);
+            if (!buffer->buffer)
+                return nullptr;
+
+            // The buffer is never used by the GPU after this, so mapBuffer does not block
+            buffer->cpuAddress = static_cast<uint8_t*>(m_Device->mapBuffer(buffer->buffer, CpuAccessMode::Read));
+            if (!buffer->cpuAddress)
+                return nullptr;
+
+            bufferIndex = uint32_t(m_Buffers.size());
+            m_Buffers.push_back(std::move(buffer));
+
+            allocated = m_Buffers[bufferIndex]->ring.allocate(size, alignment, offset);
+            assert(allocated);
+        }
+
+        ReadbackBuffer& buffer = *m_Buffers[bufferIndex];
+
+        RefCountPtr<ReadbackTicket> ticket = RefCountPtr<ReadbackTicket>::Create(new ReadbackTicket(*this));
+        ticket->bufferIndex = bufferIndex;
+        ticket->offset = offset;
+        ticket->cpuAddress = buffer.cpuAddress + offset;
+        ticket->size = size_t(size);
+
+        *outBuffer = checked_cast<Buffer*>(buffer.buffer.Get());
+        return ticket;
+    }
+
+    void ReadbackPool::release(uint32_t bufferIndex, uint64_t offset)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (bufferIndex < m_Buffers.size())
+            m_Buffers[bufferIndex]->ring.release(offset);
+    }
+
+    void ReadbackPool::invalidate(const ReadbackTicket& ticket)
+    {
+        Buffer* buffer;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            buffer = checked_cast<Buffer*>(m_Buffers[ticket.bufferIndex]->buffer.Get());
+        }
+
+        // The range must be aligned to nonCoherentAtomSize, or end at the end of the memory object
+        const VulkanContext& context = m_Device->getContext();
+        const uint64_t atomSize = context.physicalDeviceProperties.limits.nonCoherentAtomSize;
+        const uint64_t memorySize = buffer->memoryBlock ? buffer->memoryBlock->ranges.getSize() : buffer->memorySize;
+        const uint64_t begin = buffer->memoryOffset + ticket.offset;
+        const uint64_t alignedBegin = begin - begin % atomSize;
+        const uint64_t alignedEnd = std::min(align(begin + ticket.size, atomSize), memorySize);
+
+        auto range = vk::MappedMemoryRange()
+            .setMemory(buffer->memory)
+            .setOffset(alignedBegin)
+            .setSize(alignedEnd - alignedBegin);
+
+        [[maybe_unused]] const vk::Result res = context.device.invalidateMappedMemoryRanges(1, &range);
+        assert(res == vk::Result::eSuccess);
+    }
+
+    void ReadbackPool::addPendingCallback(ReadbackTicket* ticket)
+    {
+        std::lock_guard lockGuard(m_CallbackMutex);
+
+        m_PendingCallbacks.push_back(ticket);
+    }
+
+    void ReadbackPool::runCallbacks()
+    {
+        std::vector<RefCountPtr<ReadbackTicket>> readyTickets;
+
+        {
+            std::lock_guard lockGuard(m_CallbackMutex);
+
+            auto it = m_PendingCallbacks.begin();
+            while (it != m_PendingCallbacks.end())
+            {
+                if ((*it)->isReady())
+                {
+                    readyTickets.push_back(*it);
+                    it = m_PendingCallbacks.erase(it);
+                }
+                else
+                    ++it;
+            }
+        }
+
+        // Call the callbacks without holding the lock, they may record new readbacks
+        for (const auto& ticket : readyTickets)
+        {
+            ReadbackCallback callback = std::move(ticket->callback);
+            ticket->callback = nullptr;
+            callback(ticket.Get());
+        }
+    }
+
+    ReadbackTicketHandle CommandList::readbackBuffer(IBuffer* _buffer, uint64_t offsetBytes, uint64_t sizeBytes, ReadbackCallback callback)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        assert(m_CurrentCmdBuf);
+        assert(offsetBytes + sizeBytes <= buffer->desc.byteSize);
+
+        if (m_CommandListParameters.isReusable || m_CommandListParameters.isSecondary)
+        {
+            m_Context.error("Readbacks can not be recorded into reusable or secondary command lists");
+            return nullptr;
+        }
+
+        Buffer* destBuffer = nullptr;
+        RefCountPtr<ReadbackTicket> ticket = m_Device->getReadbackPool().allocate(sizeBytes, 16, &destBuffer);
+        if (!ticket)
+            return nullptr;
+
+        ticket->callback = std::move(callback);
+
+        if (buffer->desc.cpuAccess != CpuAccessMode::None)
+            m_CurrentCmdBuf->referencedStagingBuffers.push_back(buffer);
+        else
+            m_CurrentCmdBuf->referencedResources.add(buffer);
+
+        // The command buffer keeps the ticket, and therefore its readback memory, until the copy has finished executing
+        m_CurrentCmdBuf->referencedReadbacks.push_back(ticket);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        auto copyRegion = vk::BufferCopy()
+            .setSize(sizeBytes)
+            .setSrcOffset(offsetBytes)
+            .setDstOffset(ticket->offset);
+
+        m_CurrentCmdBuf->cmdBuf.copyBuffer(buffer->buffer, destBuffer->buffer, { copyRegion });
+        makeReadbackVisibleToHost(m_CurrentCmdBuf->cmdBuf);
+
+        return ticket;
+    }
+
+    ReadbackTicketHandle CommandList::readbackTexture(ITexture* _texture, const TextureSlice& slice, ReadbackCallback callback)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        assert(m_CurrentCmdBuf);
+
+        if (m_CommandListParameters.isReusable || m_CommandListParameters.isSecondary)
+        {
+            m_Context.error("Readbacks can not be recorded into reusable or secondary command lists");
+            return nullptr;
+        }
+
+        const TextureSlice resolvedSlice = slice.resolve(texture->desc);
+
+        const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
+        uint32_t numCols = (resolvedSlice.width + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        uint32_t numRows = (resolvedSlice.height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        uint32_t rowPitch = numCols * formatInfo.bytesPerBlock;
+        uint64_t totalBytes = uint64_t(rowPitch) * uint64_t(numRows) * resolvedSlice.depth;
+
+        // The buffer offset must be a multiple of the texel block size and of 4, which the ring alignment
+        // can only express for power-of-2 block sizes
+        if ((formatInfo.bytesPerBlock & (formatInfo.bytesPerBlock - 1)) != 0)
+        {
+            std::stringstream ss;
+            ss << "Readbacks of textures with the format " << formatInfo.name << " are not supported";
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        Buffer* destBuffer = nullptr;
+        RefCountPtr<ReadbackTicket> ticket = m_Device->getReadbackPool().allocate(totalBytes,
+            std::max<uint64_t>(formatInfo.bytesPerBlock, 4), &destBuffer);
+        if (!ticket)
+            return nullptr;
+
+        ticket->callback = std::move(callback);
+        ticket->rowPitch = rowPitch;
+        ticket->depthPitch = size_t(rowPitch) * numRows;
+
+        TextureSubresourceSet srcSubresource = TextureSubresourceSet(
+            resolvedSlice.mipLevel, 1,
+            resolvedSlice.arraySlice, 1
+        );
+
+        auto imageCopy = vk::BufferImageCopy()
+            .setBufferOffset(ticket->offset)
+            .setBufferRowLength(numCols * formatInfo.blockSize)
+            .setBufferImageHeight(numRows * formatInfo.blockSize)
+            .setImageSubresource(vk::ImageSubresourceLayers()
+                .setAspectMask(guessImageAspectFlags(texture->imageInfo.format))
+                .setMipLevel(resolvedSlice.mipLevel)
+                .setBaseArrayLayer(resolvedSlice.arraySlice)
+                .setLayerCount(1))
+            .setImageOffset(vk::Offset3D(resolvedSlice.x, resolvedSlice.y, resolvedSlice.z))
+            .setImageExtent(vk::Extent3D(resolvedSlice.width, resolvedSlice.height, resolvedSlice.depth));
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, srcSubresource, ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_CurrentCmdBuf->referencedResources.add(texture);
+        m_CurrentCmdBuf->referencedReadbacks.push_back(ticket);
+
+        m_CurrentCmdBuf->cmdBuf.copyImageToBuffer(texture->image, vk::ImageLayout::eTransferSrcOptimal,
+            destBuffer->buffer, 1, &imageCopy);
+        makeReadbackVisibleToHost(m_CurrentCmdBuf->cmdBuf);
+
+        return ticket;
+    }
+
+} // namespace nvrhi::vulkan
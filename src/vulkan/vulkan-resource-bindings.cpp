@@ -23,13 +23,21 @@
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
 #include <sstream>
+#include <cstring>
 
 namespace nvrhi::vulkan
 {
 
     BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
     {
-        BindingLayout* ret = new BindingLayout(m_Context, desc);
+        if (desc.usePushDescriptors && !queryFeatureSupport(Feature::PushDescriptors))
+        {
+            m_Context.error("Push descriptor layouts require VK_KHR_push_descriptor, and bufferlessPushDescriptors "
+                "when descriptor buffers are enabled");
+            return nullptr;
+        }
+
+        BindingLayout* ret = new BindingLayout(m_Context, *this, desc);
 
         ret->bake();
 
@@ -38,7 +46,7 @@ namespace nvrhi::vulkan
 
     BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc& desc)
     {
-        BindingLayout* ret = new BindingLayout(m_Context, desc);
+        BindingLayout* ret = new BindingLayout(m_Context, *this, desc);
 
         ret->bake();
 
@@ -77,9 +85,50 @@ namespace nvrhi::vulkan
         }        
     }
 
-    BindingLayout::BindingLayout(const VulkanContext& context, const BindingLayoutDesc& _desc)
+    static vk::DescriptorType getDescriptorType(const VulkanContext& context, ResourceType type, bool pushDescriptors = false)
+    {
+        // Dynamic uniform buffers are not available with descriptor buffers or push descriptors, the descriptors
+        // of volatile constant buffers point at the current version instead and are written at bind time
+        if ((context.descriptorBufferHeap || pushDescriptors) && type == ResourceType::VolatileConstantBuffer)
+            return vk::DescriptorType::eUniformBuffer;
+
+        return convertResourceType(type);
+    }
+
+    // Buffer descriptors have different sizes with robustBufferAccess, and vkGetDescriptorEXT requires the exact one
+    static size_t getDescriptorSizeInBuffer(const VulkanContext& context, vk::DescriptorType type)
+    {
+        const vk::PhysicalDeviceDescriptorBufferPropertiesEXT& properties = context.descriptorBufferProperties;
+        const bool robust = context.robustBufferAccess;
+
+        switch (type)
+        {
+        case vk::DescriptorType::eSampler:
+            return properties.samplerDescriptorSize;
+        case vk::DescriptorType::eSampledImage:
+            return properties.sampledImageDescriptorSize;
+        case vk::DescriptorType::eStorageImage:
+            return properties.storageImageDescriptorSize;
+        case vk::DescriptorType::eUniformTexelBuffer:
+            return robust ? properties.robustUniformTexelBufferDescriptorSize : properties.uniformTexelBufferDescriptorSize;
+        case vk::DescriptorType::eStorageTexelBuffer:
+            return robust ? properties.robustStorageTexelBufferDescriptorSize : properties.storageTexelBufferDescriptorSize;
+        case vk::DescriptorType::eUniformBuffer:
+            return robust ? properties.robustUniformBufferDescriptorSize : properties.uniformBufferDescriptorSize;
+        case vk::DescriptorType::eStorageBuffer:
+            return robust ? properties.robustStorageBufferDescriptorSize : properties.storageBufferDescriptorSize;
+        case vk::DescriptorType::eAccelerationStructureKHR:
+            return properties.accelerationStructureDescriptorSize;
+        default:
+            utils::InvalidEnum();
+            return 0;
+        }
+    }
+
+    BindingLayout::BindingLayout(const VulkanContext& context, const Device& device, const BindingLayoutDesc& _desc)
         : desc(_desc)
         , isBindless(false)
+        , descriptorSetAllocator(context, device)
         , m_Context(context)
     {
         vk::ShaderStageFlagBits shaderStageFlags = convertShaderTypeToShaderStageFlagBits(desc.visibility);
@@ -93,7 +142,7 @@ namespace nvrhi::vulkan
                 continue;
             }
 
-            vk::DescriptorType const descriptorType = convertResourceType(binding.type);
+            vk::DescriptorType const descriptorType = getDescriptorType(m_Context, binding.type, desc.usePushDescriptors);
             uint32_t const descriptorCount = binding.size;
             uint32_t const registerOffset = getRegisterOffsetForResourceType(_desc.bindingOffsets, binding.type);
 
@@ -109,9 +158,10 @@ namespace nvrhi::vulkan
         }
     }
 
-    BindingLayout::BindingLayout(const VulkanContext& context, const BindlessLayoutDesc& _desc)
+    BindingLayout::BindingLayout(const VulkanContext& context, const Device& device, const BindlessLayoutDesc& _desc)
         : bindlessDesc(_desc)
         , isBindless(true)
+        , descriptorSetAllocator(context, device)
         , m_Context(context)
     {
         desc.visibility = bindlessDesc.visibility;
@@ -181,6 +231,13 @@ namespace nvrhi::vulkan
             .setBindingCount(uint32_t(vulkanLayoutBindings.size()))
             .setPBindings(vulkanLayoutBindings.data());
 
+        vk::DescriptorSetLayoutCreateFlags layoutFlags;
+        if (m_Context.descriptorBufferHeap)
+            layoutFlags |= vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT;
+        if (!isBindless && desc.usePushDescriptors)
+            layoutFlags |= vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR;
+        descriptorSetLayoutInfo.setFlags(layoutFlags);
+
         std::vector<vk::DescriptorBindingFlags> bindFlag(vulkanLayoutBindings.size(), vk::DescriptorBindingFlagBits::ePartiallyBound);
 
         auto extendedInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfo()
@@ -246,6 +303,32 @@ namespace nvrhi::vulkan
                                                                         &descriptorSetLayout);
         CHECK_VK_RETURN(res)
 
+        if (m_Context.descriptorBufferHeap && !(layoutFlags & vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR))
+        {
+            // Find out where the descriptors of each binding go in the descriptor buffer range of a binding set
+            m_Context.device.getDescriptorSetLayoutSizeEXT(descriptorSetLayout, &descriptorBufferSize);
+
+            for (const vk::DescriptorSetLayoutBinding& layoutBinding : vulkanLayoutBindings)
+            {
+                DescriptorBufferBinding& placement = descriptorBufferBindings[layoutBinding.binding];
+                m_Context.device.getDescriptorSetLayoutBindingOffsetEXT(descriptorSetLayout, layoutBinding.binding, &placement.offset);
+
+                if (layoutBinding.descriptorType == vk::DescriptorType::eMutableEXT)
+                {
+                    // Mutable descriptors take as much space as the largest type they can hold
+                    for (uint32_t i = 0; i < pMutableDescriptorTypeLists->descriptorTypeCount; i++)
+                    {
+                        placement.stride = std::max<uint64_t>(placement.stride,
+                            getDescriptorSizeInBuffer(m_Context, pMutableDescriptorTypeLists->pDescriptorTypes[i]));
+                    }
+                }
+                else
+                {
+                    placement.stride = getDescriptorSizeInBuffer(m_Context, layoutBinding.descriptorType);
+                }
+            }
+        }
+
         // count the number of descriptors required per type
         std::unordered_map<vk::DescriptorType, uint32_t> poolSizeMap;
         for (auto layoutBinding : vulkanLayoutBindings)
@@ -269,6 +352,13 @@ namespace nvrhi::vulkan
             }
         }
 
+        // bindless layouts are only used by descriptor tables, which manage their own pools,
+        // and descriptor buffers and push descriptors don't use pools at all
+        if (!isBindless && !m_Context.descriptorBufferHeap && !desc.usePushDescriptors)
+        {
+            descriptorSetAllocator.init(descriptorSetLayout, descriptorPoolSizeInfo);
+        }
+
         return vk::Result::eSuccess;
     }
 
@@ -281,6 +371,290 @@ namespace nvrhi::vulkan
         }
     }
 
+    DescriptorSetAllocator::~DescriptorSetAllocator()
+    {
+        // destroying the pools implicitly frees all descriptor sets allocated from them
+        for (vk::DescriptorPool pool : m_Pools)
+        {
+            m_Context.device.destroyDescriptorPool(pool, m_Context.allocationCallbacks);
+        }
+        m_Pools.clear();
+
+        m_Context.deviceStats->addDescriptorSetCapacity(-int64_t(m_PoolCapacity));
+    }
+
+    void DescriptorSetAllocator::init(vk::DescriptorSetLayout layout, const std::vector<vk::DescriptorPoolSize>& poolSizes)
+    {
+        m_Layout = layout;
+        m_PoolSizes = poolSizes;
+    }
+
+    void DescriptorSetAllocator::retirePendingSets()
+    {
+        while (!m_PendingSets.empty())
+        {
+            const RecycledSet& pending = m_PendingSets.front();
+
+            for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+            {
+                const Queue* queue = m_Device.getQueue(CommandQueue(queueIndex));
+                if (queue && queue->getLastFinishedID() < pending.lastSubmittedIDs[queueIndex])
+                    return;
+            }
+
+            m_FreeSets.push_back(pending);
+            m_PendingSets.pop_front();
+        }
+    }
+
+    vk::Result DescriptorSetAllocator::createPool()
+    {
+        std::vector<vk::DescriptorPoolSize> scaledPoolSizes = m_PoolSizes;
+        for (vk::DescriptorPoolSize& poolSize : scaledPoolSizes)
+        {
+            poolSize.descriptorCount *= m_NextPoolCapacity;
+        }
+
+        auto poolInfo = vk::DescriptorPoolCreateInfo()
+            .setPoolSizeCount(uint32_t(scaledPoolSizes.size()))
+            .setPPoolSizes(scaledPoolSizes.data())
+            .setMaxSets(m_NextPoolCapacity);
+
+        vk::DescriptorPool pool;
+        const vk::Result res = m_Context.device.createDescriptorPool(&poolInfo, m_Context.allocationCallbacks, &pool);
+        CHECK_VK_RETURN(res)
+
+        m_Pools.push_back(pool);
+        m_SetsLeftInCurrentPool = m_NextPoolCapacity;
+        m_PoolCapacity += m_NextPoolCapacity;
+        m_Context.deviceStats->addDescriptorSetCapacity(m_NextPoolCapacity);
+        m_NextPoolCapacity = std::min(m_NextPoolCapacity * 2, c_MaxPoolCapacity);
+
+        return vk::Result::eSuccess;
+    }
+
+    vk::Result DescriptorSetAllocator::allocate(vk::DescriptorSet& outSet, vk::DescriptorPool& outPool)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_FreeSets.empty())
+            retirePendingSets();
+
+        if (!m_FreeSets.empty())
+        {
+            outSet = m_FreeSets.back().set;
+            outPool = m_FreeSets.back().pool;
+            m_FreeSets.pop_back();
+            m_Context.deviceStats->addAllocatedDescriptorSets(1);
+            return vk::Result::eSuccess;
+        }
+
+        if (m_SetsLeftInCurrentPool == 0)
+        {
+            const vk::Result res = createPool();
+            if (res != vk::Result::eSuccess)
+                return res;
+        }
+
+        auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
+            .setDescriptorPool(m_Pools.back())
+            .setDescriptorSetCount(1)
+            .setPSetLayouts(&m_Layout);
+
+        const vk::Result res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+        CHECK_VK_RETURN(res)
+
+        outPool = m_Pools.back();
+        --m_SetsLeftInCurrentPool;
+        m_Context.deviceStats->addAllocatedDescriptorSets(1);
+
+        return vk::Result::eSuccess;
+    }
+
+    void DescriptorSetAllocator::release(vk::DescriptorSet set, vk::DescriptorPool pool)
+    {
+        RecycledSet pending;
+        pending.set = set;
+        pending.pool = pool;
+
+        // the set may still be referenced by command lists that were submitted before it was released
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            const Queue* queue = m_Device.getQueue(CommandQueue(queueIndex));
+            if (queue)
+                pending.lastSubmittedIDs[queueIndex] = queue->getLastSubmittedID();
+        }
+
+        m_Context.deviceStats->addAllocatedDescriptorSets(-1);
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_PendingSets.push_back(pending);
+    }
+
+    DescriptorBufferHeap::~DescriptorBufferHeap()
+    {
+        if (m_MappedMemory)
+        {
+            m_Context.device.unmapMemory(m_Memory);
+            m_MappedMemory = nullptr;
+        }
+
+        if (m_Buffer)
+        {
+            m_Context.device.destroyBuffer(m_Buffer, m_Context.allocationCallbacks);
+            m_Buffer = vk::Buffer();
+        }
+
+        if (m_Memory)
+        {
+            m_Context.device.freeMemory(m_Memory, m_Context.allocationCallbacks);
+            m_Memory = vk::DeviceMemory();
+        }
+    }
+
+    vk::Result DescriptorBufferHeap::init(uint64_t size)
+    {
+        auto bufferInfo = vk::BufferCreateInfo()
+            .setSize(size)
+            .setUsage(vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT
+                | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT
+                | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+            .setSharingMode(vk::SharingMode::eExclusive);
+
+        vk::Result res = m_Context.device.createBuffer(&bufferInfo, m_Context.allocationCallbacks, &m_Buffer);
+        CHECK_VK_RETURN(res)
+
+        m_Context.nameVKObject(VkBuffer(m_Buffer), vk::ObjectType::eBuffer, vk::DebugReportObjectTypeEXT::eBuffer, "DescriptorBuffer");
+
+        vk::MemoryRequirements memRequirements;
+        m_Context.device.getBufferMemoryRequirements(m_Buffer, &memRequirements);
+
+        // The descriptors are written by the CPU and read by the GPU on every access,
+        // so prefer the memory that is both host-visible and device-local when there is any
+        const vk::PhysicalDeviceMemoryProperties memProperties = m_Context.physicalDevice.getMemoryProperties();
+        const vk::MemoryPropertyFlags hostMemoryFlags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+        const vk::MemoryPropertyFlags preferredFlags[] = { hostMemoryFlags | vk::MemoryPropertyFlagBits::eDeviceLocal, hostMemoryFlags };
+
+        uint32_t memTypeIndex = ~0u;
+        for (vk::MemoryPropertyFlags flags : preferredFlags)
+        {
+            for (uint32_t i = 0; i < memProperties.memoryTypeCount && memTypeIndex == ~0u; i++)
+            {
+                if ((memRequirements.memoryTypeBits & (1u << i)) && (memProperties.memoryTypes[i].propertyFlags & flags) == flags)
+                    memTypeIndex = i;
+            }
+        }
+
+        if (memTypeIndex == ~0u)
+            return vk::Result::eErrorOutOfDeviceMemory;
+
+        auto allocFlags = vk::MemoryAllocateFlagsInfo()
+            .setFlags(vk::MemoryAllocateFlagBits::eDeviceAddress);
+
+        auto allocInfo = vk::MemoryAllocateInfo()
+            .setAllocationSize(memRequirements.size)
+            .setMemoryTypeIndex(memTypeIndex)
+            .setPNext(&allocFlags);
+
+        res = m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &m_Memory);
+        CHECK_VK_RETURN(res)
+
+        res = m_Context.device.bindBufferMemory(m_Buffer, m_Memory, 0);
+        CHECK_VK_RETURN(res)
+
+        void* mappedMemory = nullptr;
+        res = m_Context.device.mapMemory(m_Memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags(), &mappedMemory);
+        CHECK_VK_RETURN(res)
+
+        m_MappedMemory = static_cast<uint8_t*>(mappedMemory);
+        m_DeviceAddress = m_Context.device.getBufferAddress(vk::BufferDeviceAddressInfo().setBuffer(m_Buffer));
+        m_Ranges = RangeAllocator(size);
+
+        return vk::Result::eSuccess;
+    }
+
+    void DescriptorBufferHeap::retirePendingRanges()
+    {
+        while (!m_PendingRanges.empty())
+        {
+            const PendingRange& pending = m_PendingRanges.front();
+
+            for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+            {
+                const Queue* queue = m_Device.getQueue(CommandQueue(queueIndex));
+                if (queue && queue->getLastFinishedID() < pending.lastSubmittedIDs[queueIndex])
+                    return;
+            }
+
+            m_Ranges.release(pending.allocation.offset, pending.allocation.size);
+            m_PendingRanges.pop_front();
+        }
+    }
+
+    bool DescriptorBufferHeap::allocate(uint64_t size, DescriptorBufferAllocation& outAllocation)
+    {
+        outAllocation = DescriptorBufferAllocation();
+
+        // Layouts without any descriptors, nothing to place
+        if (size == 0)
+            return true;
+
+        const uint64_t alignment = m_Context.descriptorBufferProperties.descriptorBufferOffsetAlignment;
+        const uint64_t alignedSize = align(size, alignment);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!m_Ranges.allocate(alignedSize, alignment, outAllocation.offset))
+        {
+            retirePendingRanges();
+
+            if (!m_Ranges.allocate(alignedSize, alignment, outAllocation.offset))
+                return false;
+        }
+
+        outAllocation.size = alignedSize;
+        return true;
+    }
+
+    void DescriptorBufferHeap::release(const DescriptorBufferAllocation& allocation)
+    {
+        if (allocation.size == 0)
+            return;
+
+        PendingRange pending;
+        pending.allocation = allocation;
+
+        // the range may still be referenced by command lists that were submitted before it was released
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            const Queue* queue = m_Device.getQueue(CommandQueue(queueIndex));
+            if (queue)
+                pending.lastSubmittedIDs[queueIndex] = queue->getLastSubmittedID();
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_PendingRanges.push_back(pending);
+    }
+
+    void DescriptorBufferHeap::free(const DescriptorBufferAllocation& allocation)
+    {
+        if (allocation.size == 0)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_Ranges.release(allocation.offset, allocation.size);
+    }
+
+    DescriptorHeapStats DescriptorBufferHeap::getStats()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        DescriptorHeapStats stats;
+        stats.allocated = m_Ranges.getAllocatedBytes();
+        stats.capacity = m_Ranges.getSize();
+        return stats;
+    }
+
     static Texture::TextureSubresourceViewType getTextureViewType(Format bindingFormat, Format textureFormat)
     {
         Format format = (bindingFormat == Format::UNKNOWN) ? textureFormat : bindingFormat;
@@ -295,63 +669,139 @@ namespace nvrhi::vulkan
             return Texture::TextureSubresourceViewType::AllAspects;
     }
 
-    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
+    // Writes the descriptor for a binding set item directly into the mapped descriptor buffer
+    static void writeDescriptorToBuffer(const VulkanContext& context, const BindingSetItem& binding, vk::DescriptorType descriptorType, uint8_t* dst)
     {
-        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+        vk::DescriptorImageInfo imageInfo;
+        vk::DescriptorAddressInfoEXT addressInfo;
+        vk::DescriptorDataEXT data;
 
-        BindingSet *ret = new BindingSet(m_Context);
-        ret->desc = desc;
-        ret->layout = layout;
+        switch (binding.type)
+        {
+        case ResourceType::Texture_SRV:
+        case ResourceType::Texture_UAV:
+        {
+            const auto texture = checked_cast<Texture*>(binding.resourceHandle);
+            const bool isUAV = (binding.type == ResourceType::Texture_UAV);
 
-        const auto& descriptorSetLayout = layout->descriptorSetLayout;
-        const auto& poolSizes = layout->descriptorPoolSizeInfo;
+            const auto subresource = binding.subresources.resolve(texture->desc, isUAV);
+            const auto textureViewType = getTextureViewType(binding.format, texture->desc.format);
+            auto& view = texture->getSubresourceView(subresource, binding.dimension, binding.format,
+                isUAV ? vk::ImageUsageFlagBits::eStorage : vk::ImageUsageFlagBits::eSampled, textureViewType);
 
-        // create descriptor pool to allocate a descriptor from
-        auto poolInfo = vk::DescriptorPoolCreateInfo()
-            .setPoolSizeCount(uint32_t(poolSizes.size()))
-            .setPPoolSizes(poolSizes.data())
-            .setMaxSets(1);
+            imageInfo = vk::DescriptorImageInfo()
+                .setImageView(view.view)
+                .setImageLayout(isUAV ? vk::ImageLayout::eGeneral : vk::ImageLayout::eShaderReadOnlyOptimal);
 
-        vk::Result res = m_Context.device.createDescriptorPool(&poolInfo,
-                                                             m_Context.allocationCallbacks,
-                                                             &ret->descriptorPool);
-        CHECK_VK_FAIL(res)
-        
-        // create the descriptor set
-        auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
-            .setDescriptorPool(ret->descriptorPool)
-            .setDescriptorSetCount(1)
-            .setPSetLayouts(&descriptorSetLayout);
+            if (isUAV)
+                data.setPStorageImage(&imageInfo);
+            else
+                data.setPSampledImage(&imageInfo);
+        }
+        break;
 
-        res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo,
-            &ret->descriptorSet);
-        CHECK_VK_FAIL(res)
-        
-        // collect all of the descriptor write data
-        std::vector<vk::DescriptorImageInfo> descriptorImageInfo;
-        std::vector<vk::DescriptorBufferInfo> descriptorBufferInfo;
-        std::vector<vk::WriteDescriptorSet> descriptorWriteInfo;
-        std::vector<vk::WriteDescriptorSetAccelerationStructureKHR> accelStructWriteInfo;
-        descriptorImageInfo.reserve(desc.bindings.size());
-        descriptorBufferInfo.reserve(desc.bindings.size());
-        descriptorWriteInfo.reserve(desc.bindings.size());
-        accelStructWriteInfo.reserve(desc.bindings.size());
+        case ResourceType::TypedBuffer_SRV:
+        case ResourceType::TypedBuffer_UAV:
+        {
+            // Texel buffer descriptors are made from the address and format, no buffer views are needed
+            const auto buffer = checked_cast<Buffer*>(binding.resourceHandle);
+            const Format format = (binding.format == Format::UNKNOWN) ? buffer->desc.format : binding.format;
+            const auto range = binding.range.resolve(buffer->desc);
+
+            addressInfo = vk::DescriptorAddressInfoEXT()
+                .setAddress(buffer->deviceAddress + range.byteOffset)
+                .setRange(range.byteSize)
+                .setFormat(vk::Format(convertFormat(format)));
+
+            if (binding.type == ResourceType::TypedBuffer_UAV)
+                data.setPStorageTexelBuffer(&addressInfo);
+            else
+                data.setPUniformTexelBuffer(&addressInfo);
+        }
+        break;
 
-        auto generateWriteDescriptorData =
-            // generates a vk::WriteDescriptorSet struct in descriptorWriteInfo
-            [&](uint32_t bindingLocation,
-                uint32_t arrayElement,
-                vk::DescriptorType descriptorType,
-                vk::DescriptorImageInfo *imageInfo,
-                vk::DescriptorBufferInfo *bufferInfo,
-                vk::BufferView *bufferView,
-                const void* pNext = nullptr)
+        case ResourceType::StructuredBuffer_SRV:
+        case ResourceType::StructuredBuffer_UAV:
+        case ResourceType::RawBuffer_SRV:
+        case ResourceType::RawBuffer_UAV:
+        case ResourceType::ConstantBuffer:
         {
-            descriptorWriteInfo.push_back(
+            const auto buffer = checked_cast<Buffer*>(binding.resourceHandle);
+            const auto range = binding.range.resolve(buffer->desc);
+
+            addressInfo = vk::DescriptorAddressInfoEXT()
+                .setAddress(buffer->deviceAddress + range.byteOffset)
+                .setRange(range.byteSize);
+
+            if (descriptorType == vk::DescriptorType::eUniformBuffer)
+                data.setPUniformBuffer(&addressInfo);
+            else
+                data.setPStorageBuffer(&addressInfo);
+        }
+        break;
+
+        case ResourceType::Sampler:
+        {
+            const auto sampler = checked_cast<Sampler*>(binding.resourceHandle);
+            data.setPSampler(&sampler->sampler);
+        }
+        break;
+
+        case ResourceType::RayTracingAccelStruct:
+        {
+            const auto as = checked_cast<AccelStruct*>(binding.resourceHandle);
+            data.setAccelerationStructure(as->accelStructDeviceAddress);
+        }
+        break;
+
+        case ResourceType::VolatileConstantBuffer: // written at bind time
+        case ResourceType::PushConstants:
+        case ResourceType::None:
+        case ResourceType::Count:
+        default:
+            utils::InvalidEnum();
+            return;
+        }
+
+        auto descriptorInfo = vk::DescriptorGetInfoEXT()
+            .setType(descriptorType)
+            .setData(data);
+
+        context.device.getDescriptorEXT(&descriptorInfo, getDescriptorSizeInBuffer(context, descriptorType), dst);
+    }
+
+    // Descriptor writes for a group of bindings, along with the image, buffer and acceleration structure
+    // infos that the writes point at. The info arrays are reserved upfront so that the pointers stay valid.
+    struct DescriptorWriteList
+    {
+        std::vector<vk::DescriptorImageInfo> imageInfos;
+        std::vector<vk::DescriptorBufferInfo> bufferInfos;
+        std::vector<vk::WriteDescriptorSetAccelerationStructureKHR> accelStructInfos;
+        std::vector<vk::WriteDescriptorSet> writes;
+
+        explicit DescriptorWriteList(size_t maxBindings)
+        {
+            imageInfos.reserve(maxBindings);
+            bufferInfos.reserve(maxBindings);
+            accelStructInfos.reserve(maxBindings);
+            writes.reserve(maxBindings);
+        }
+    };
+
+    // Generates a vk::WriteDescriptorSet for one non-null binding, creating the views it needs
+    static void generateDescriptorWrite(const VulkanContext& context, const BindingLayout* layout, const BindingSetItem& binding,
+        vk::DescriptorType descriptorType, vk::DescriptorSet dstSet, DescriptorWriteList& out)
+    {
+        uint32_t const registerOffset = getRegisterOffsetForResourceType(layout->desc.bindingOffsets, binding.type);
+
+        auto addWrite = [&](vk::DescriptorImageInfo* imageInfo, vk::DescriptorBufferInfo* bufferInfo,
+            vk::BufferView* bufferView, const void* pNext = nullptr)
+        {
+            out.writes.push_back(
                 vk::WriteDescriptorSet()
-                .setDstSet(ret->descriptorSet)
-                .setDstBinding(bindingLocation)
-                .setDstArrayElement(arrayElement)
+                .setDstSet(dstSet)
+                .setDstBinding(registerOffset + binding.slot)
+                .setDstArrayElement(binding.arrayElement)
                 .setDescriptorCount(1)
                 .setDescriptorType(descriptorType)
                 .setPImageInfo(imageInfo)
@@ -361,6 +811,184 @@ namespace nvrhi::vulkan
             );
         };
 
+        switch (binding.type)
+        {
+        case ResourceType::Texture_SRV:
+        case ResourceType::Texture_UAV:
+        {
+            const auto texture = checked_cast<Texture *>(binding.resourceHandle);
+            const bool isUAV = (binding.type == ResourceType::Texture_UAV);
+
+            const auto subresource = binding.subresources.resolve(texture->desc, isUAV);
+            const auto textureViewType = getTextureViewType(binding.format, texture->desc.format);
+            auto& view = texture->getSubresourceView(subresource, binding.dimension, binding.format,
+                isUAV ? vk::ImageUsageFlagBits::eStorage : vk::ImageUsageFlagBits::eSampled, textureViewType);
+
+            auto& imageInfo = out.imageInfos.emplace_back();
+            imageInfo = vk::DescriptorImageInfo()
+                .setImageView(view.view)
+                .setImageLayout(isUAV ? vk::ImageLayout::eGeneral : vk::ImageLayout::eShaderReadOnlyOptimal);
+
+            addWrite(&imageInfo, nullptr, nullptr);
+        }
+        break;
+
+        case ResourceType::TypedBuffer_SRV:
+        case ResourceType::TypedBuffer_UAV:
+        {
+            const auto buffer = checked_cast<Buffer *>(binding.resourceHandle);
+
+            assert(buffer->desc.canHaveTypedViews);
+            if (binding.type == ResourceType::TypedBuffer_UAV)
+                assert(buffer->desc.canHaveUAVs);
+
+            Format format = binding.format;
+
+            if (format == Format::UNKNOWN)
+            {
+                format = buffer->desc.format;
+            }
+
+            auto vkformat = nvrhi::vulkan::convertFormat(format);
+            const auto range = binding.range.resolve(buffer->desc);
+
+            size_t viewInfoHash = 0;
+            nvrhi::hash_combine(viewInfoHash, range.byteOffset);
+            nvrhi::hash_combine(viewInfoHash, range.byteSize);
+            nvrhi::hash_combine(viewInfoHash, (uint64_t)vkformat);
+
+            const auto& bufferViewFound = buffer->viewCache.find(viewInfoHash);
+            auto& bufferViewRef = (bufferViewFound != buffer->viewCache.end()) ? bufferViewFound->second : buffer->viewCache[viewInfoHash];
+            if (bufferViewFound == buffer->viewCache.end())
+            {
+                assert(format != Format::UNKNOWN);
+
+                auto bufferViewInfo = vk::BufferViewCreateInfo()
+                    .setBuffer(buffer->buffer)
+                    .setOffset(range.byteOffset)
+                    .setRange(range.byteSize)
+                    .setFormat(vk::Format(vkformat));
+
+                const vk::Result res = context.device.createBufferView(&bufferViewInfo, context.allocationCallbacks, &bufferViewRef);
+                ASSERT_VK_OK(res);
+            }
+
+            addWrite(nullptr, nullptr, &bufferViewRef);
+        }
+        break;
+
+        case ResourceType::StructuredBuffer_SRV:
+        case ResourceType::StructuredBuffer_UAV:
+        case ResourceType::RawBuffer_SRV:
+        case ResourceType::RawBuffer_UAV:
+        case ResourceType::ConstantBuffer:
+        case ResourceType::VolatileConstantBuffer:
+        {
+            const auto buffer = checked_cast<Buffer *>(binding.resourceHandle);
+
+            if (binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::RawBuffer_UAV)
+                assert(buffer->desc.canHaveUAVs);
+            if (binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::StructuredBuffer_SRV)
+                assert(buffer->desc.structStride != 0);
+            if (binding.type == ResourceType::RawBuffer_SRV|| binding.type == ResourceType::RawBuffer_UAV)
+                assert(buffer->desc.canHaveRawViews);
+
+            const auto range = binding.range.resolve(buffer->desc);
+
+            auto& bufferInfo = out.bufferInfos.emplace_back();
+            bufferInfo = vk::DescriptorBufferInfo()
+                .setBuffer(buffer->buffer)
+                .setOffset(range.byteOffset)
+                .setRange(range.byteSize);
+
+            assert(buffer->buffer);
+            addWrite(nullptr, &bufferInfo, nullptr);
+        }
+        break;
+
+        case ResourceType::Sampler:
+        {
+            const auto sampler = checked_cast<Sampler *>(binding.resourceHandle);
+
+            auto& imageInfo = out.imageInfos.emplace_back();
+            imageInfo = vk::DescriptorImageInfo()
+                .setSampler(sampler->sampler);
+
+            addWrite(&imageInfo, nullptr, nullptr);
+        }
+        break;
+
+        case ResourceType::RayTracingAccelStruct:
+        {
+            const auto as = checked_cast<AccelStruct*>(binding.resourceHandle);
+
+            auto& accelStructWrite = out.accelStructInfos.emplace_back();
+            accelStructWrite.accelerationStructureCount = 1;
+            accelStructWrite.pAccelerationStructures = &as->accelStruct;
+
+            addWrite(nullptr, nullptr, nullptr, &accelStructWrite);
+        }
+        break;
+
+        case ResourceType::PushConstants:
+            break;
+
+        case ResourceType::None:
+        case ResourceType::Count:
+        default:
+            utils::InvalidEnum();
+            break;
+        }
+    }
+
+    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::createBindingSet");
+
+        if (m_BindingSetCache)
+            return m_BindingSetCache->getOrCreate(desc, layout, [&]() { return createBindingSetInternal(desc, layout); });
+
+        return createBindingSetInternal(desc, layout);
+    }
+
+    BindingSetHandle Device::createBindingSetInternal(const BindingSetDesc& desc, IBindingLayout* _layout, TrackedCommandBuffer* transientOwner)
+    {
+        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+
+        if (m_Context.descriptorBufferHeap)
+            return createBindingSetInDescriptorBuffer(desc, layout, transientOwner);
+
+        BindingSet *ret = new BindingSet(m_Context);
+        ret->desc = desc;
+        ret->layout = layout;
+        ret->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::BindingSet);
+
+        if (transientOwner)
+        {
+            // take a descriptor set from the command buffer's pools, they are reset when it is retired
+            ret->descriptorSet = transientOwner->allocateTransientDescriptorSet(layout->descriptorSetLayout);
+            ret->isTransient = true;
+            if (!ret->descriptorSet)
+            {
+                m_Context.error("Failed to allocate a descriptor set for a transient binding set");
+                delete ret;
+                return nullptr;
+            }
+        }
+        else
+        {
+            // take a descriptor set from the layout's shared pools
+            const vk::Result res = layout->descriptorSetAllocator.allocate(ret->descriptorSet, ret->descriptorPool);
+            if (res != vk::Result::eSuccess)
+            {
+                delete ret;
+                return nullptr;
+            }
+        }
+        
+        // collect all of the descriptor write data
+        DescriptorWriteList writeList(desc.bindings.size());
+
         for (size_t bindingIndex = 0; bindingIndex < desc.bindings.size(); bindingIndex++)
         {
             const BindingSetItem& binding = desc.bindings[bindingIndex];
@@ -372,218 +1000,183 @@ namespace nvrhi::vulkan
 
             ret->resources.push_back(binding.resourceHandle); // keep a strong reference to the resource
 
-            vk::DescriptorType const descriptorType = convertResourceType(binding.type);
-            uint32_t const registerOffset = getRegisterOffsetForResourceType(layout->desc.bindingOffsets, binding.type);
+            generateDescriptorWrite(m_Context, layout, binding, convertResourceType(binding.type), ret->descriptorSet, writeList);
             
             switch (binding.type)
             {
             case ResourceType::Texture_SRV:
+            case ResourceType::Texture_UAV:
             {
                 const auto texture = checked_cast<Texture *>(binding.resourceHandle);
 
-                const auto subresource = binding.subresources.resolve(texture->desc, false);
-                const auto textureViewType = getTextureViewType(binding.format, texture->desc.format);
-                auto& view = texture->getSubresourceView(subresource, binding.dimension, binding.format, vk::ImageUsageFlagBits::eSampled, textureViewType);
-
-                auto& imageInfo = descriptorImageInfo.emplace_back();
-                imageInfo = vk::DescriptorImageInfo()
-                    .setImageView(view.view)
-                    .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-
-                generateWriteDescriptorData(
-                    registerOffset + binding.slot,
-                    binding.arrayElement,
-                    descriptorType,
-                    &imageInfo, nullptr, nullptr);
-
                 if (!texture->permanentState)
                     ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
                 else
                     verifyPermanentResourceState(texture->permanentState,
-                        ResourceStates::ShaderResource,
+                        binding.type == ResourceType::Texture_UAV ? ResourceStates::UnorderedAccess : ResourceStates::ShaderResource,
                         true, texture->desc.debugName, m_Context.messageCallback);
             }
-
             break;
 
-            case ResourceType::Texture_UAV:
+            case ResourceType::TypedBuffer_SRV:
+            case ResourceType::TypedBuffer_UAV:
+            case ResourceType::StructuredBuffer_SRV:
+            case ResourceType::StructuredBuffer_UAV:
+            case ResourceType::RawBuffer_SRV:
+            case ResourceType::RawBuffer_UAV:
+            case ResourceType::ConstantBuffer:
             {
-                const auto texture = checked_cast<Texture *>(binding.resourceHandle);
-
-                const auto subresource = binding.subresources.resolve(texture->desc, true);
-                const auto textureViewType = getTextureViewType(binding.format, texture->desc.format);
-                auto& view = texture->getSubresourceView(subresource, binding.dimension, binding.format, vk::ImageUsageFlagBits::eStorage, textureViewType);
-
-                auto& imageInfo = descriptorImageInfo.emplace_back();
-                imageInfo = vk::DescriptorImageInfo()
-                    .setImageView(view.view)
-                    .setImageLayout(vk::ImageLayout::eGeneral);
-
-                generateWriteDescriptorData(
-                    registerOffset + binding.slot,
-                    binding.arrayElement,
-                    descriptorType,
-                    &imageInfo, nullptr, nullptr);
+                const auto buffer = checked_cast<Buffer *>(binding.resourceHandle);
 
-                if (!texture->permanentState)
+                if (!buffer->permanentState)
                     ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
                 else
-                    verifyPermanentResourceState(texture->permanentState,
-                        ResourceStates::UnorderedAccess,
-                        true, texture->desc.debugName, m_Context.messageCallback);
-            }
+                {
+                    ResourceStates requiredState;
+                    if (binding.type == ResourceType::TypedBuffer_UAV || binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::RawBuffer_UAV)
+                        requiredState = ResourceStates::UnorderedAccess;
+                    else if (binding.type == ResourceType::ConstantBuffer)
+                        requiredState = ResourceStates::ConstantBuffer;
+                    else
+                        requiredState = ResourceStates::ShaderResource;
 
+                    verifyPermanentResourceState(buffer->permanentState, requiredState,
+                        false, buffer->desc.debugName, m_Context.messageCallback);
+                }
+            }
             break;
 
-            case ResourceType::TypedBuffer_SRV:
-            case ResourceType::TypedBuffer_UAV:
+            case ResourceType::VolatileConstantBuffer:
             {
                 const auto buffer = checked_cast<Buffer *>(binding.resourceHandle);
+                assert(buffer->desc.isVolatile);
+                ret->volatileConstantBuffers.push_back(buffer);
+            }
+            break;
 
-                assert(buffer->desc.canHaveTypedViews);
-                const bool isUAV = (binding.type == ResourceType::TypedBuffer_UAV);
-                if (isUAV)
-                    assert(buffer->desc.canHaveUAVs);
+            case ResourceType::RayTracingAccelStruct:
+                ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        m_Context.device.updateDescriptorSets(uint32_t(writeList.writes.size()), writeList.writes.data(), 0, nullptr);
+
+        return BindingSetHandle::Create(ret);
+    }
+
+    BindingSetHandle Device::createBindingSetInDescriptorBuffer(const BindingSetDesc& desc, BindingLayout* layout, TrackedCommandBuffer* transientOwner)
+    {
+        BindingSet *ret = new BindingSet(m_Context);
+        ret->desc = desc;
+        ret->layout = layout;
+        ret->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::BindingSet);
+
+        DescriptorBufferHeap& heap = *m_Context.descriptorBufferHeap;
+        if (!heap.allocate(layout->descriptorBufferSize, ret->descriptorBufferRange))
+        {
+            m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+            delete ret;
+            return nullptr;
+        }
+
+        if (transientOwner)
+        {
+            // the range is freed when the command buffer is retired
+            transientOwner->transientDescriptors.push_back(ret->descriptorBufferRange);
+            ret->isTransient = true;
+        }
 
-                Format format = binding.format;
+        uint8_t* setMemory = heap.getMappedMemory(ret->descriptorBufferRange.offset);
 
-                if (format == Format::UNKNOWN)
-                {
-                    format = buffer->desc.format;
-                }
+        for (size_t bindingIndex = 0; bindingIndex < desc.bindings.size(); bindingIndex++)
+        {
+            const BindingSetItem& binding = desc.bindings[bindingIndex];
 
-                auto vkformat = nvrhi::vulkan::convertFormat(format);
-                const auto range = binding.range.resolve(buffer->desc);
+            if (binding.resourceHandle == nullptr)
+            {
+                continue;
+            }
 
-                size_t viewInfoHash = 0;
-                nvrhi::hash_combine(viewInfoHash, range.byteOffset);
-                nvrhi::hash_combine(viewInfoHash, range.byteSize);
-                nvrhi::hash_combine(viewInfoHash, (uint64_t)vkformat);
+            ret->resources.push_back(binding.resourceHandle); // keep a strong reference to the resource
 
-                const auto& bufferViewFound = buffer->viewCache.find(viewInfoHash);
-                auto& bufferViewRef = (bufferViewFound != buffer->viewCache.end()) ? bufferViewFound->second : buffer->viewCache[viewInfoHash];
-                if (bufferViewFound == buffer->viewCache.end())
-                {
-                    assert(format != Format::UNKNOWN);
+            vk::DescriptorType const descriptorType = getDescriptorType(m_Context, binding.type);
+            uint32_t const registerOffset = getRegisterOffsetForResourceType(layout->desc.bindingOffsets, binding.type);
 
-                    auto bufferViewInfo = vk::BufferViewCreateInfo()
-                        .setBuffer(buffer->buffer)
-                        .setOffset(range.byteOffset)
-                        .setRange(range.byteSize)
-                        .setFormat(vk::Format(vkformat));
+            const auto placement = layout->descriptorBufferBindings.find(registerOffset + binding.slot);
+            assert(placement != layout->descriptorBufferBindings.end());
+            const uint64_t descriptorOffset = placement->second.offset + binding.arrayElement * placement->second.stride;
 
-                    res = m_Context.device.createBufferView(&bufferViewInfo, m_Context.allocationCallbacks, &bufferViewRef);
-                    ASSERT_VK_OK(res);
-                }
+            switch (binding.type)
+            {
+            case ResourceType::Texture_SRV:
+            case ResourceType::Texture_UAV:
+            {
+                const auto texture = checked_cast<Texture *>(binding.resourceHandle);
 
-                generateWriteDescriptorData(
-                    registerOffset + binding.slot,
-                    binding.arrayElement,
-                    descriptorType,
-                    nullptr, nullptr, &bufferViewRef);
+                writeDescriptorToBuffer(m_Context, binding, descriptorType, setMemory + descriptorOffset);
 
-                if (!buffer->permanentState)
+                if (!texture->permanentState)
                     ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
                 else
-                    verifyPermanentResourceState(buffer->permanentState, 
-                        isUAV ? ResourceStates::UnorderedAccess : ResourceStates::ShaderResource,
-                        false, buffer->desc.debugName, m_Context.messageCallback);
+                    verifyPermanentResourceState(texture->permanentState,
+                        binding.type == ResourceType::Texture_UAV ? ResourceStates::UnorderedAccess : ResourceStates::ShaderResource,
+                        true, texture->desc.debugName, m_Context.messageCallback);
             }
             break;
 
+            case ResourceType::TypedBuffer_SRV:
+            case ResourceType::TypedBuffer_UAV:
             case ResourceType::StructuredBuffer_SRV:
             case ResourceType::StructuredBuffer_UAV:
             case ResourceType::RawBuffer_SRV:
             case ResourceType::RawBuffer_UAV:
             case ResourceType::ConstantBuffer:
-            case ResourceType::VolatileConstantBuffer:
             {
                 const auto buffer = checked_cast<Buffer *>(binding.resourceHandle);
+                assert(buffer->deviceAddress);
 
-                if (binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::RawBuffer_UAV)
-                    assert(buffer->desc.canHaveUAVs);
-                if (binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::StructuredBuffer_SRV)
-                    assert(buffer->desc.structStride != 0);
-                if (binding.type == ResourceType::RawBuffer_SRV|| binding.type == ResourceType::RawBuffer_UAV)
-                    assert(buffer->desc.canHaveRawViews);
-
-                const auto range = binding.range.resolve(buffer->desc);
-
-                auto& bufferInfo = descriptorBufferInfo.emplace_back();
-                bufferInfo = vk::DescriptorBufferInfo()
-                    .setBuffer(buffer->buffer)
-                    .setOffset(range.byteOffset)
-                    .setRange(range.byteSize);
-
-                assert(buffer->buffer);
-                generateWriteDescriptorData(
-                    registerOffset + binding.slot,
-                    binding.arrayElement,
-                    descriptorType,
-                    nullptr, &bufferInfo, nullptr);
+                writeDescriptorToBuffer(m_Context, binding, descriptorType, setMemory + descriptorOffset);
 
-                if (binding.type == ResourceType::VolatileConstantBuffer) 
-                {
-                    assert(buffer->desc.isVolatile);
-                    ret->volatileConstantBuffers.push_back(buffer);
-                }
+                if (!buffer->permanentState)
+                    ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
                 else
                 {
-                    if (!buffer->permanentState)
-                        ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                    ResourceStates requiredState;
+                    if (binding.type == ResourceType::TypedBuffer_UAV || binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::RawBuffer_UAV)
+                        requiredState = ResourceStates::UnorderedAccess;
+                    else if (binding.type == ResourceType::ConstantBuffer)
+                        requiredState = ResourceStates::ConstantBuffer;
                     else
-                    {
-                        ResourceStates requiredState;
-                        if (binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::RawBuffer_UAV)
-                            requiredState = ResourceStates::UnorderedAccess;
-                        else if (binding.type == ResourceType::ConstantBuffer)
-                            requiredState = ResourceStates::ConstantBuffer;
-                        else
-                            requiredState = ResourceStates::ShaderResource;
-
-                        verifyPermanentResourceState(buffer->permanentState, requiredState,
-                            false, buffer->desc.debugName, m_Context.messageCallback);
-                    }
+                        requiredState = ResourceStates::ShaderResource;
+
+                    verifyPermanentResourceState(buffer->permanentState, requiredState,
+                        false, buffer->desc.debugName, m_Context.messageCallback);
                 }
             }
-
             break;
 
-            case ResourceType::Sampler:
+            case ResourceType::VolatileConstantBuffer:
             {
-                const auto sampler = checked_cast<Sampler *>(binding.resourceHandle);
-
-                auto& imageInfo = descriptorImageInfo.emplace_back();
-                imageInfo = vk::DescriptorImageInfo()
-                    .setSampler(sampler->sampler);
-
-                generateWriteDescriptorData(
-                    registerOffset + binding.slot,
-                    binding.arrayElement,
-                    descriptorType,
-                    &imageInfo, nullptr, nullptr);
+                // the descriptor depends on the buffer version that is current when the set is bound
+                const auto buffer = checked_cast<Buffer *>(binding.resourceHandle);
+                assert(buffer->desc.isVolatile);
+                ret->volatileConstantBuffers.push_back(buffer);
+                ret->volatileConstantBufferOffsets.push_back(descriptorOffset);
             }
-
             break;
 
-            case ResourceType::RayTracingAccelStruct:
-            {
-                const auto as = checked_cast<AccelStruct*>(binding.resourceHandle);
-
-                auto& accelStructWrite = accelStructWriteInfo.emplace_back();
-                accelStructWrite.accelerationStructureCount = 1;
-                accelStructWrite.pAccelerationStructures = &as->accelStruct;
-
-                generateWriteDescriptorData(
-                    registerOffset + binding.slot,
-                    binding.arrayElement,
-                    descriptorType,
-                    nullptr, nullptr, nullptr, &accelStructWrite);
+            case ResourceType::Sampler:
+                writeDescriptorToBuffer(m_Context, binding, descriptorType, setMemory + descriptorOffset);
+                break;
 
+            case ResourceType::RayTracingAccelStruct:
+                writeDescriptorToBuffer(m_Context, binding, descriptorType, setMemory + descriptorOffset);
                 ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
-            }
-
-            break;
+                break;
 
             case ResourceType::PushConstants:
                 break;
@@ -596,19 +1189,26 @@ namespace nvrhi::vulkan
             }
         }
 
-        m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
-
         return BindingSetHandle::Create(ret);
     }
 
     BindingSet::~BindingSet()
     {
-        if (descriptorPool)
+        if (isTransient)
+            return; // the descriptors are recycled with the command buffer
+
+        if (descriptorSet)
         {
-            m_Context.device.destroyDescriptorPool(descriptorPool, m_Context.allocationCallbacks);
+            checked_cast<BindingLayout*>(layout.Get())->descriptorSetAllocator.release(descriptorSet, descriptorPool);
             descriptorPool = vk::DescriptorPool();
             descriptorSet = vk::DescriptorSet();
         }
+
+        if (descriptorBufferRange.size)
+        {
+            m_Context.descriptorBufferHeap->release(descriptorBufferRange);
+            descriptorBufferRange = DescriptorBufferAllocation();
+        }
     }
 
     Object BindingSet::getNativeObject(ObjectType objectType)
@@ -630,8 +1230,21 @@ namespace nvrhi::vulkan
 
         DescriptorTable* ret = new DescriptorTable(m_Context);
         ret->layout = layout;
+        ret->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::DescriptorTable);
         ret->capacity = layout->vulkanLayoutBindings[0].descriptorCount;
 
+        if (m_Context.descriptorBufferHeap)
+        {
+            if (!m_Context.descriptorBufferHeap->allocate(layout->descriptorBufferSize, ret->descriptorBufferRange))
+            {
+                m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+                delete ret;
+                return nullptr;
+            }
+
+            return DescriptorTableHandle::Create(ret);
+        }
+
         const auto& descriptorSetLayout = layout->descriptorSetLayout;
         const auto& poolSizes = layout->descriptorPoolSizeInfo;
 
@@ -667,6 +1280,12 @@ namespace nvrhi::vulkan
             descriptorPool = vk::DescriptorPool();
             descriptorSet = vk::DescriptorSet();
         }
+
+        if (descriptorBufferRange.size)
+        {
+            m_Context.descriptorBufferHeap->release(descriptorBufferRange);
+            descriptorBufferRange = DescriptorBufferAllocation();
+        }
     }
 
     Object DescriptorTable::getNativeObject(ObjectType objectType)
@@ -704,6 +1323,34 @@ namespace nvrhi::vulkan
             return true;
         }
 
+        if (m_Context.descriptorBufferHeap)
+        {
+            uint8_t* tableMemory = m_Context.descriptorBufferHeap->getMappedMemory(descriptorTable->descriptorBufferRange.offset);
+
+            auto writeDescriptorToTable = [&](const vk::DescriptorSetLayoutBinding& layoutBinding)
+            {
+                const BindingLayout::DescriptorBufferBinding& placement = layout->descriptorBufferBindings[layoutBinding.binding];
+                writeDescriptorToBuffer(m_Context, binding, getDescriptorType(m_Context, binding.type),
+                    tableMemory + placement.offset + binding.slot * placement.stride);
+            };
+
+            if (layout->bindlessDesc.layoutType != BindlessLayoutDesc::LayoutType::Immutable)
+            {
+                assert(layout->vulkanLayoutBindings.size() > 0);
+                writeDescriptorToTable(layout->vulkanLayoutBindings[0]);
+            }
+            else
+            {
+                for (uint32_t bindingLocation = 0; bindingLocation < uint32_t(layout->bindlessDesc.registerSpaces.size()); bindingLocation++)
+                {
+                    if (layout->bindlessDesc.registerSpaces[bindingLocation].type == binding.type)
+                        writeDescriptorToTable(layout->vulkanLayoutBindings[bindingLocation]);
+                }
+            }
+
+            return true;
+        }
+
         // collect all of the descriptor write data
         static_vector<vk::DescriptorImageInfo, c_MaxBindlessRegisterSpaces> descriptorImageInfo;
         static_vector<vk::DescriptorBufferInfo, c_MaxBindlessRegisterSpaces> descriptorBufferInfo;
@@ -884,8 +1531,37 @@ namespace nvrhi::vulkan
         return true;
     }
 
+    uint64_t CommandList::getVolatileConstantBufferOffset(Buffer* constantBuffer)
+    {
+        auto found = m_VolatileBufferStates.find(constantBuffer);
+        if (found == m_VolatileBufferStates.end())
+        {
+            std::stringstream ss;
+            ss << "Binding volatile constant buffer " << utils::DebugNameToString(constantBuffer->desc.debugName)
+                << " before writing into it is invalid.";
+            m_Context.error(ss.str());
+
+            return 0; // use zero offset just to use something
+        }
+
+        uint32_t version = found->second.latestVersion;
+        return version * constantBuffer->desc.byteSize;
+    }
+
     void CommandList::bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx)
     {
+        for (IBindingSet* bindingSet : bindings)
+        {
+            if (bindingSet)
+                ++m_Stats.bindingSetBinds;
+        }
+
+        if (m_Context.descriptorBufferHeap)
+        {
+            bindDescriptorBufferOffsets(bindPoint, pipelineLayout, bindings, descriptorSetIdxToBindingIdx);
+            return;
+        }
+
         const uint32_t numBindings = (uint32_t)bindings.size();
         const uint32_t numDescriptorSets = descriptorSetIdxToBindingIdx.empty() ? numBindings : (uint32_t)descriptorSetIdxToBindingIdx.size();
 
@@ -928,27 +1604,13 @@ namespace nvrhi::vulkan
 
                     for (Buffer* constantBuffer : bindingSet->volatileConstantBuffers)
                     {
-                        auto found = m_VolatileBufferStates.find(constantBuffer);
-                        if (found == m_VolatileBufferStates.end())
-                        {
-                            std::stringstream ss;
-                            ss << "Binding volatile constant buffer " << utils::DebugNameToString(constantBuffer->desc.debugName)
-                                << " before writing into it is invalid.";
-                            m_Context.error(ss.str());
-
-                            dynamicOffsets.push_back(0); // use zero offset just to use something
-                        }
-                        else
-                        {
-                            uint32_t version = found->second.latestVersion;
-                            uint64_t offset = version * constantBuffer->desc.byteSize;
-                            assert(offset < std::numeric_limits<uint32_t>::max());
-                            dynamicOffsets.push_back(uint32_t(offset));
-                        }
+                        uint64_t offset = getVolatileConstantBufferOffset(constantBuffer);
+                        assert(offset < std::numeric_limits<uint32_t>::max());
+                        dynamicOffsets.push_back(uint32_t(offset));
                     }
 
                     if (desc->trackLiveness)
-                        m_CurrentCmdBuf->referencedResources.push_back(bindingSetHandle);
+                        m_CurrentCmdBuf->referencedResources.add(bindingSetHandle);
                 }
                 else
                 {
@@ -966,6 +1628,269 @@ namespace nvrhi::vulkan
         }
     }
 
+    bool CommandList::allocateVolatileDescriptorCopy(uint64_t size, uint64_t& outOffset)
+    {
+        // Most copies are small, so they are allocated from a block owned by the command buffer, which takes
+        // the heap mutex once per block instead of once per bind
+        static constexpr uint64_t c_VolatileDescriptorBlockSize = 64 * 1024;
+
+        DescriptorBufferHeap& heap = *m_Context.descriptorBufferHeap;
+        TrackedCommandBuffer& cmdBuf = *m_CurrentCmdBuf;
+
+        const uint64_t alignment = m_Context.descriptorBufferProperties.descriptorBufferOffsetAlignment;
+        const uint64_t alignedSize = align(size, alignment);
+
+        if (alignedSize > c_VolatileDescriptorBlockSize / 4)
+        {
+            DescriptorBufferAllocation range;
+            if (!heap.allocate(size, range))
+                return false;
+
+            cmdBuf.transientDescriptors.push_back(range);
+            outOffset = range.offset;
+            return true;
+        }
+
+        if (cmdBuf.volatileDescriptorBlock.size == 0 || cmdBuf.volatileDescriptorBlockUsed + alignedSize > cmdBuf.volatileDescriptorBlock.size)
+        {
+            DescriptorBufferAllocation block;
+            if (!heap.allocate(c_VolatileDescriptorBlockSize, block))
+                return false;
+
+            cmdBuf.transientDescriptors.push_back(block);
+            cmdBuf.volatileDescriptorBlock = block;
+            cmdBuf.volatileDescriptorBlockUsed = 0;
+        }
+
+        outOffset = cmdBuf.volatileDescriptorBlock.offset + cmdBuf.volatileDescriptorBlockUsed;
+        cmdBuf.volatileDescriptorBlockUsed += alignedSize;
+        return true;
+    }
+
+    void CommandList::bindDescriptorBufferOffsets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx)
+    {
+        DescriptorBufferHeap& heap = *m_Context.descriptorBufferHeap;
+
+        if (!m_CurrentCmdBuf->descriptorBufferBound)
+        {
+            // All binding sets live in one buffer, which stays bound until the end of the command buffer
+            auto bindingInfo = vk::DescriptorBufferBindingInfoEXT()
+                .setAddress(heap.getDeviceAddress())
+                .setUsage(vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT);
+
+            m_CurrentCmdBuf->cmdBuf.bindDescriptorBuffersEXT(1, &bindingInfo);
+            m_CurrentCmdBuf->descriptorBufferBound = true;
+        }
+
+        const uint32_t numBindings = (uint32_t)bindings.size();
+        const uint32_t numDescriptorSets = descriptorSetIdxToBindingIdx.empty() ? numBindings : (uint32_t)descriptorSetIdxToBindingIdx.size();
+
+        BindingVector<uint32_t> bufferIndices;
+        BindingVector<vk::DeviceSize> offsets;
+        uint32_t nextDescriptorSetToBind = 0;
+
+        auto setContiguousOffsets = [&]()
+        {
+            if (offsets.empty())
+                return;
+
+            m_CurrentCmdBuf->cmdBuf.setDescriptorBufferOffsetsEXT(bindPoint, pipelineLayout,
+                /* firstSet = */ nextDescriptorSetToBind, uint32_t(offsets.size()), bufferIndices.data(), offsets.data());
+
+            bufferIndices.resize(0);
+            offsets.resize(0);
+        };
+
+        for (uint32_t i = 0; i < numDescriptorSets; ++i)
+        {
+            IBindingSet* bindingSetHandle = nullptr;
+            if (descriptorSetIdxToBindingIdx.empty())
+            {
+                bindingSetHandle = bindings[i];
+            }
+            else if(descriptorSetIdxToBindingIdx[i] != 0xffffffff)
+            {
+                bindingSetHandle = bindings[descriptorSetIdxToBindingIdx[i]];
+            }
+
+            if (bindingSetHandle == nullptr)
+            {
+                // This is a hole in the descriptor sets, so set the contiguous offsets we've got so far
+                setContiguousOffsets();
+                nextDescriptorSetToBind = i + 1;
+                continue;
+            }
+
+            const BindingSetDesc* desc = bindingSetHandle->getDesc();
+            if (desc)
+            {
+                BindingSet* bindingSet = checked_cast<BindingSet*>(bindingSetHandle);
+                uint64_t offset = bindingSet->descriptorBufferRange.offset;
+
+                if (!bindingSet->volatileConstantBuffers.empty())
+                {
+                    // There are no dynamic offsets for descriptor buffers: bind a copy of the set where the descriptors
+                    // of the volatile constant buffers point at their current versions. The copy lives until the
+                    // command buffer is retired, and is bound again while none of the buffers get a new version.
+                    std::vector<uint64_t> constantBufferOffsets(bindingSet->volatileConstantBuffers.size());
+                    for (size_t cbIndex = 0; cbIndex < bindingSet->volatileConstantBuffers.size(); cbIndex++)
+                        constantBufferOffsets[cbIndex] = getVolatileConstantBufferOffset(bindingSet->volatileConstantBuffers[cbIndex]);
+
+                    TrackedCommandBuffer::VolatileDescriptorCopy& copy = m_CurrentCmdBuf->volatileDescriptorCopies[bindingSet];
+                    uint64_t copyOffset = 0;
+
+                    if (copy.sourceOffset == offset && copy.constantBufferOffsets == constantBufferOffsets)
+                    {
+                        offset = copy.offset;
+                    }
+                    else if (allocateVolatileDescriptorCopy(bindingSet->descriptorBufferRange.size, copyOffset))
+                    {
+                        uint8_t* transientMemory = heap.getMappedMemory(copyOffset);
+                        memcpy(transientMemory, heap.getMappedMemory(offset), bindingSet->descriptorBufferRange.size);
+
+                        for (size_t cbIndex = 0; cbIndex < bindingSet->volatileConstantBuffers.size(); cbIndex++)
+                        {
+                            Buffer* constantBuffer = bindingSet->volatileConstantBuffers[cbIndex];
+
+                            auto addressInfo = vk::DescriptorAddressInfoEXT()
+                                .setAddress(constantBuffer->deviceAddress + constantBufferOffsets[cbIndex])
+                                .setRange(constantBuffer->desc.byteSize);
+
+                            auto descriptorInfo = vk::DescriptorGetInfoEXT()
+                                .setType(vk::DescriptorType::eUniformBuffer)
+                                .setData(vk::DescriptorDataEXT().setPUniformBuffer(&addressInfo));
+
+                            m_Context.device.getDescriptorEXT(&descriptorInfo, getDescriptorSizeInBuffer(m_Context, vk::DescriptorType::eUniformBuffer),
+                                transientMemory + bindingSet->volatileConstantBufferOffsets[cbIndex]);
+                        }
+
+                        copy.sourceOffset = offset;
+                        copy.offset = copyOffset;
+                        copy.constantBufferOffsets = std::move(constantBufferOffsets);
+                        offset = copyOffset;
+                    }
+                    else
+                    {
+                        m_CurrentCmdBuf->volatileDescriptorCopies.erase(bindingSet);
+                        m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+                    }
+                }
+
+                bufferIndices.push_back(0);
+                offsets.push_back(offset);
+
+                if (desc->trackLiveness)
+                    m_CurrentCmdBuf->referencedResources.add(bindingSetHandle);
+            }
+            else
+            {
+                DescriptorTable* table = checked_cast<DescriptorTable*>(bindingSetHandle);
+                bufferIndices.push_back(0);
+                offsets.push_back(table->descriptorBufferRange.offset);
+            }
+        }
+
+        // Set the remaining offsets
+        setContiguousOffsets();
+    }
+
+    BindingSetHandle CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        assert(m_CurrentCmdBuf);
+
+        BindingSetHandle bindingSet = m_Device->createBindingSetInternal(desc, layout, m_CurrentCmdBuf.get());
+
+        // Keep the set alive until the command buffer is retired, the application may drop the handle right after binding
+        if (bindingSet)
+            m_CurrentCmdBuf->referencedResources.add(bindingSet);
+
+        return bindingSet;
+    }
+
+    void CommandList::setPushBindings(uint32_t layoutIndex, const BindingSetDesc& bindings)
+    {
+        assert(m_CurrentCmdBuf);
+
+        // Find the binding layouts of the pipeline that was set last, only one state is current at a time
+        const BindingLayoutVector* pipelineLayouts = nullptr;
+        const BindingVector<uint32_t>* descriptorSetIdxToBindingIdx = nullptr;
+        vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eGraphics;
+
+        if (m_CurrentGraphicsState.pipeline)
+        {
+            GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+            pipelineLayouts = &pso->desc.bindingLayouts;
+            descriptorSetIdxToBindingIdx = &pso->descriptorSetIdxToBindingIdx;
+        }
+        else if (m_CurrentComputeState.pipeline)
+        {
+            ComputePipeline* pso = checked_cast<ComputePipeline*>(m_CurrentComputeState.pipeline);
+            pipelineLayouts = &pso->desc.bindingLayouts;
+            descriptorSetIdxToBindingIdx = &pso->descriptorSetIdxToBindingIdx;
+            bindPoint = vk::PipelineBindPoint::eCompute;
+        }
+        else if (m_CurrentMeshletState.pipeline)
+        {
+            MeshletPipeline* pso = checked_cast<MeshletPipeline*>(m_CurrentMeshletState.pipeline);
+            pipelineLayouts = &pso->desc.bindingLayouts;
+            descriptorSetIdxToBindingIdx = &pso->descriptorSetIdxToBindingIdx;
+        }
+        else if (m_CurrentRayTracingState.shaderTable)
+        {
+            RayTracingPipeline* pso = checked_cast<RayTracingPipeline*>(m_CurrentRayTracingState.shaderTable->getPipeline());
+            pipelineLayouts = &pso->desc.globalBindingLayouts;
+            descriptorSetIdxToBindingIdx = &pso->descriptorSetIdxToBindingIdx;
+            bindPoint = vk::PipelineBindPoint::eRayTracingKHR;
+        }
+
+        if (!pipelineLayouts || layoutIndex >= pipelineLayouts->size())
+        {
+            m_Context.error("setPushBindings requires a pipeline state with a binding layout at the given index");
+            return;
+        }
+
+        const BindingLayout* layout = checked_cast<const BindingLayout*>((*pipelineLayouts)[layoutIndex].Get());
+
+        uint32_t descriptorSetIndex = layoutIndex;
+        if (!descriptorSetIdxToBindingIdx->empty())
+        {
+            for (uint32_t i = 0; i < uint32_t(descriptorSetIdxToBindingIdx->size()); i++)
+            {
+                if ((*descriptorSetIdxToBindingIdx)[i] == layoutIndex)
+                {
+                    descriptorSetIndex = i;
+                    break;
+                }
+            }
+        }
+
+        DescriptorWriteList writeList(bindings.bindings.size());
+
+        for (const BindingSetItem& binding : bindings.bindings)
+        {
+            if (binding.resourceHandle == nullptr)
+                continue;
+
+            generateDescriptorWrite(m_Context, layout, binding, getDescriptorType(m_Context, binding.type, true), vk::DescriptorSet(), writeList);
+
+            if (binding.type == ResourceType::VolatileConstantBuffer)
+            {
+                // Point the descriptor at the current version of the buffer
+                Buffer* constantBuffer = checked_cast<Buffer*>(binding.resourceHandle);
+                writeList.bufferInfos.back().offset += getVolatileConstantBufferOffset(constantBuffer);
+            }
+
+            if (bindings.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.add(binding.resourceHandle);
+        }
+
+        if (writeList.writes.empty())
+            return;
+
+        m_CurrentCmdBuf->cmdBuf.pushDescriptorSetKHR(bindPoint, m_CurrentPipelineLayout, descriptorSetIndex,
+            uint32_t(writeList.writes.size()), writeList.writes.data());
+    }
+
     vk::Result createPipelineLayout(
         vk::PipelineLayout& outPipelineLayout,
         BindingVector<RefCountPtr<BindingLayout>>& outBindingLayouts,
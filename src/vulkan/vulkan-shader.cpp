@@ -197,6 +197,27 @@ namespace nvrhi::vulkan
             }
         }
 
+        if (m_Context.dynamicVertexInput)
+        {
+            for (const auto& binding : layout->bindingDesc)
+            {
+                layout->bindingDesc2.push_back(vk::VertexInputBindingDescription2EXT()
+                    .setBinding(binding.binding)
+                    .setStride(binding.stride)
+                    .setInputRate(binding.inputRate)
+                    .setDivisor(1));
+            }
+
+            for (const auto& attribute : layout->attributeDesc)
+            {
+                layout->attributeDesc2.push_back(vk::VertexInputAttributeDescription2EXT()
+                    .setLocation(attribute.location)
+                    .setBinding(attribute.binding)
+                    .setFormat(attribute.format)
+                    .setOffset(attribute.offset));
+            }
+        }
+
         return InputLayoutHandle::Create(layout);
     }
 
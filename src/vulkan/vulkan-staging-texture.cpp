@@ -115,6 +115,7 @@ namespace nvrhi::vulkan
 
         StagingTexture *tex = new StagingTexture();
         tex->desc = desc;
+        tex->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::StagingTexture);
         tex->populateSliceRegions();
 
         BufferDesc bufDesc;
@@ -206,8 +207,8 @@ namespace nvrhi::vulkan
         }
         commitBarriers();
 
-        m_CurrentCmdBuf->referencedResources.push_back(src);
-        m_CurrentCmdBuf->referencedResources.push_back(dst);
+        m_CurrentCmdBuf->referencedResources.add(src);
+        m_CurrentCmdBuf->referencedResources.add(dst);
         m_CurrentCmdBuf->referencedStagingBuffers.push_back(dst->buffer);
 
         m_CurrentCmdBuf->cmdBuf.copyImageToBuffer(src->image, vk::ImageLayout::eTransferSrcOptimal,
@@ -255,8 +256,8 @@ namespace nvrhi::vulkan
         }
         commitBarriers();
 
-        m_CurrentCmdBuf->referencedResources.push_back(src);
-        m_CurrentCmdBuf->referencedResources.push_back(dst);
+        m_CurrentCmdBuf->referencedResources.add(src);
+        m_CurrentCmdBuf->referencedResources.add(dst);
         m_CurrentCmdBuf->referencedStagingBuffers.push_back(src->buffer);
 
         m_CurrentCmdBuf->cmdBuf.copyBufferToImage(src->buffer->buffer,
@@ -132,6 +132,11 @@ namespace nvrhi::vulkan
         {
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentMeshletState.indirectCountBuffer)
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
     }
 
     void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
@@ -153,8 +158,27 @@ namespace nvrhi::vulkan
         return !m_StateTracker.getBufferBarriers().empty() || !m_StateTracker.getTextureBarriers().empty();
     }
 
+    static vk::ImageSubresourceRange getBarrierSubresourceRange(const TextureBarrier& barrier, const Texture* texture)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
+
+        vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
+        if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
+        if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
+        if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
+
+        return vk::ImageSubresourceRange()
+            .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
+            .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : barrier.numArraySlices)
+            .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
+            .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : barrier.numMipLevels)
+            .setAspectMask(aspectMask);
+    }
+
     void CommandList::commitBarriersInternal()
     {
+        // Without synchronization2, split barriers are not used: the transitions happen at the end of the split.
+        // All barriers are placed with a single call, using the union of their stages.
         std::vector<vk::ImageMemoryBarrier> imageBarriers;
         std::vector<vk::BufferMemoryBarrier> bufferBarriers;
         vk::PipelineStageFlags beforeStageFlags = vk::PipelineStageFlags(0);
@@ -162,38 +186,19 @@ namespace nvrhi::vulkan
 
         for (const TextureBarrier& barrier : m_StateTracker.getTextureBarriers())
         {
+            if (barrier.split == SplitBarrier::Begin)
+                continue;
+
             ResourceStateMapping before = convertResourceState(barrier.stateBefore);
             ResourceStateMapping after = convertResourceState(barrier.stateAfter);
 
-            if ((before.stageFlags != beforeStageFlags || after.stageFlags != afterStageFlags) && !imageBarriers.empty())
-            {
-                m_CurrentCmdBuf->cmdBuf.pipelineBarrier(beforeStageFlags, afterStageFlags,
-                    vk::DependencyFlags(), {}, {}, imageBarriers);
-
-                imageBarriers.clear();
-            }
-
-            beforeStageFlags = before.stageFlags;
-            afterStageFlags = after.stageFlags;
+            beforeStageFlags |= before.stageFlags;
+            afterStageFlags |= after.stageFlags;
 
             assert(after.imageLayout != vk::ImageLayout::eUndefined);
 
             Texture* texture = static_cast<Texture*>(barrier.texture);
 
-            const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
-
-            vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
-            if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
-            if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
-            if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
-
-            vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange()
-                .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
-                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : 1)
-                .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
-                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : 1)
-                .setAspectMask(aspectMask);
-
             imageBarriers.push_back(vk::ImageMemoryBarrier()
                 .setSrcAccessMask(before.accessMask)
                 .setDstAccessMask(after.accessMask)
@@ -202,34 +207,19 @@ namespace nvrhi::vulkan
                 .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
                 .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
                 .setImage(texture->image)
-                .setSubresourceRange(subresourceRange));
-        }
-
-        if (!imageBarriers.empty())
-        {
-            m_CurrentCmdBuf->cmdBuf.pipelineBarrier(beforeStageFlags, afterStageFlags,
-                vk::DependencyFlags(), {}, {}, imageBarriers);
+                .setSubresourceRange(getBarrierSubresourceRange(barrier, texture)));
         }
 
-        beforeStageFlags = vk::PipelineStageFlags(0);
-        afterStageFlags = vk::PipelineStageFlags(0);
-        imageBarriers.clear();
-
         for (const BufferBarrier& barrier : m_StateTracker.getBufferBarriers())
         {
+            if (barrier.split == SplitBarrier::Begin)
+                continue;
+
             ResourceStateMapping before = convertResourceState(barrier.stateBefore);
             ResourceStateMapping after = convertResourceState(barrier.stateAfter);
 
-            if ((before.stageFlags != beforeStageFlags || after.stageFlags != afterStageFlags) && !bufferBarriers.empty())
-            {
-                m_CurrentCmdBuf->cmdBuf.pipelineBarrier(beforeStageFlags, afterStageFlags,
-                    vk::DependencyFlags(), {}, bufferBarriers, {});
-
-                bufferBarriers.clear();
-            }
-
-            beforeStageFlags = before.stageFlags;
-            afterStageFlags = after.stageFlags;
+            beforeStageFlags |= before.stageFlags;
+            afterStageFlags |= after.stageFlags;
 
             Buffer* buffer = static_cast<Buffer*>(barrier.buffer);
 
@@ -243,12 +233,11 @@ namespace nvrhi::vulkan
                 .setSize(buffer->desc.byteSize));
         }
 
-        if (!bufferBarriers.empty())
+        if (!imageBarriers.empty() || !bufferBarriers.empty())
         {
             m_CurrentCmdBuf->cmdBuf.pipelineBarrier(beforeStageFlags, afterStageFlags,
-                vk::DependencyFlags(), {}, bufferBarriers, {});
+                vk::DependencyFlags(), {}, bufferBarriers, imageBarriers);
         }
-        bufferBarriers.clear();
 
         m_StateTracker.clearBarriers();
     }
@@ -258,6 +247,53 @@ namespace nvrhi::vulkan
         std::vector<vk::ImageMemoryBarrier2> imageBarriers;
         std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
 
+        // Places the regular barriers collected so far, to keep them ordered with the split barriers
+        auto flushBarriers = [this, &imageBarriers, &bufferBarriers]()
+        {
+            if (imageBarriers.empty() && bufferBarriers.empty())
+                return;
+
+            vk::DependencyInfo dep_info;
+            dep_info.setImageMemoryBarriers(imageBarriers);
+            dep_info.setBufferMemoryBarriers(bufferBarriers);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+
+            imageBarriers.clear();
+            bufferBarriers.clear();
+        };
+
+        // Begins a split barrier with vkCmdSetEvent2, or ends it with vkCmdWaitEvents2 using the same dependency.
+        // Returns false if the barrier needs to be placed as a regular one.
+        auto placeSplitBarrier = [this, &flushBarriers](SplitBarrier split, const void* resource, const vk::DependencyInfo& dep_info)
+        {
+            if (split == SplitBarrier::Begin)
+            {
+                // The events are reset when the command buffer retires, which doesn't happen between
+                // submissions of a reusable command list
+                if (m_CommandListParameters.isReusable)
+                    return false;
+
+                vk::Event event = m_CurrentCmdBuf->getSplitBarrierEvent();
+                if (!event)
+                    return false;
+
+                flushBarriers();
+                m_CurrentCmdBuf->cmdBuf.setEvent2(event, dep_info);
+                m_SplitBarrierEvents[resource] = event;
+                return true;
+            }
+
+            auto found = m_SplitBarrierEvents.find(resource);
+            if (found == m_SplitBarrierEvents.end())
+                return false;
+
+            flushBarriers();
+            m_CurrentCmdBuf->cmdBuf.waitEvents2(1, &found->second, &dep_info);
+            m_SplitBarrierEvents.erase(found);
+            return true;
+        };
+
         for (const TextureBarrier& barrier : m_StateTracker.getTextureBarriers())
         {
             ResourceStateMapping2 before = convertResourceState2(barrier.stateBefore);
@@ -267,21 +303,7 @@ namespace nvrhi::vulkan
 
             Texture* texture = static_cast<Texture*>(barrier.texture);
 
-            const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
-
-            vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
-            if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
-            if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
-            if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
-
-            vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange()
-                .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
-                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : 1)
-                .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
-                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : 1)
-                .setAspectMask(aspectMask);
-
-            imageBarriers.push_back(vk::ImageMemoryBarrier2()
+            const auto imageBarrier = vk::ImageMemoryBarrier2()
                 .setSrcAccessMask(before.accessMask)
                 .setDstAccessMask(after.accessMask)
                 .setSrcStageMask(before.stageFlags)
@@ -291,19 +313,27 @@ namespace nvrhi::vulkan
                 .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
                 .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
                 .setImage(texture->image)
-                .setSubresourceRange(subresourceRange));
-        }
+                .setSubresourceRange(getBarrierSubresourceRange(barrier, texture));
 
-        if (!imageBarriers.empty())
-        {
-            vk::DependencyInfo dep_info;
-            dep_info.setImageMemoryBarriers(imageBarriers);
+            if (barrier.split != SplitBarrier::None)
+            {
+                vk::DependencyInfo dep_info;
+                dep_info.setImageMemoryBarrierCount(1);
+                dep_info.setPImageMemoryBarriers(&imageBarrier);
+
+                if (placeSplitBarrier(barrier.split, barrier.texture, dep_info))
+                    continue;
+
+                if (barrier.split == SplitBarrier::Begin)
+                {
+                    // No event, the regular barrier is placed at the end of the split
+                    continue;
+                }
+            }
 
-            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+            imageBarriers.push_back(imageBarrier);
         }
 
-        imageBarriers.clear();
-
         for (const BufferBarrier& barrier : m_StateTracker.getBufferBarriers())
         {
             ResourceStateMapping2 before = convertResourceState2(barrier.stateBefore);
@@ -311,7 +341,7 @@ namespace nvrhi::vulkan
 
             Buffer* buffer = static_cast<Buffer*>(barrier.buffer);
 
-            bufferBarriers.push_back(vk::BufferMemoryBarrier2()
+            const auto bufferBarrier = vk::BufferMemoryBarrier2()
                 .setSrcAccessMask(before.accessMask)
                 .setDstAccessMask(after.accessMask)
                 .setSrcStageMask(before.stageFlags)
@@ -320,26 +350,43 @@ namespace nvrhi::vulkan
                 .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
                 .setBuffer(buffer->buffer)
                 .setOffset(0)
-                .setSize(buffer->desc.byteSize));
-        }
+                .setSize(buffer->desc.byteSize);
 
-        if (!bufferBarriers.empty())
-        {
-            vk::DependencyInfo dep_info;
-            dep_info.setBufferMemoryBarriers(bufferBarriers);
+            if (barrier.split != SplitBarrier::None)
+            {
+                vk::DependencyInfo dep_info;
+                dep_info.setBufferMemoryBarrierCount(1);
+                dep_info.setPBufferMemoryBarriers(&bufferBarrier);
 
-            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+                if (placeSplitBarrier(barrier.split, barrier.buffer, dep_info))
+                    continue;
+
+                if (barrier.split == SplitBarrier::Begin)
+                    continue;
+            }
+
+            bufferBarriers.push_back(bufferBarrier);
         }
-        bufferBarriers.clear();
+
+        flushBarriers();
 
         m_StateTracker.clearBarriers();
     }
 
     void CommandList::commitBarriers()
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::commitBarriers");
+
         if (m_StateTracker.getBufferBarriers().empty() && m_StateTracker.getTextureBarriers().empty())
             return;
 
+        if (m_CommandListParameters.isSecondary)
+        {
+            // The primary command list is responsible for the resource states, see openSecondary
+            m_StateTracker.discardBarriers();
+            return;
+        }
+
         endRenderPass();
 
         if (m_Context.extensions.KHR_synchronization2)
@@ -352,6 +399,142 @@ namespace nvrhi::vulkan
         }
     }
 
+    void CommandList::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        assert(m_CurrentCmdBuf);
+
+        commitBarriers();
+        endRenderPass();
+
+        // The memory has no defined contents for the new resource, so the Common state is used to make
+        // the next transition start from the undefined layout.
+        if (Texture* texture = dynamic_cast<Texture*>(resourceAfter))
+        {
+            m_StateTracker.beginTrackingTextureState(texture, AllSubresources, ResourceStates::Common);
+        }
+        else if (Buffer* buffer = dynamic_cast<Buffer*>(resourceAfter))
+        {
+            m_StateTracker.beginTrackingBufferState(buffer, ResourceStates::Common);
+        }
+
+        // Vulkan has no dedicated aliasing barrier, so make all previous writes available to all later accesses
+        if (m_Context.extensions.KHR_synchronization2)
+        {
+            auto memoryBarrier = vk::MemoryBarrier2()
+                .setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                .setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+                .setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                .setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite);
+
+            vk::DependencyInfo dep_info;
+            dep_info.setMemoryBarriers(memoryBarrier);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+        }
+        else
+        {
+            auto memoryBarrier = vk::MemoryBarrier()
+                .setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+                .setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands,
+                vk::DependencyFlags(), 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+        }
+
+        if (resourceBefore)
+            m_CurrentCmdBuf->referencedResources.add(resourceBefore);
+        if (resourceAfter)
+            m_CurrentCmdBuf->referencedResources.add(resourceAfter);
+    }
+
+    void CommandList::queueOwnershipTransferBarriers(const std::vector<QueueOwnershipTransfer>& transfers, bool release)
+    {
+        assert(m_CurrentCmdBuf);
+
+        std::vector<vk::ImageMemoryBarrier> imageBarriers;
+        std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+        vk::PipelineStageFlags stageFlags = vk::PipelineStageFlags(0);
+
+        // The release half only makes the source accesses available, the acquire half makes them visible to
+        // the accesses in the resource state. Both halves must use the same layouts.
+        auto addImageBarrier = [&](const QueueOwnershipTransfer& transfer, const TextureBarrier& barrier, ResourceStates state)
+        {
+            ResourceStateMapping mapping = convertResourceState(state);
+            stageFlags |= mapping.stageFlags;
+
+            imageBarriers.push_back(vk::ImageMemoryBarrier()
+                .setSrcAccessMask(release ? mapping.accessMask : vk::AccessFlags())
+                .setDstAccessMask(release ? vk::AccessFlags() : mapping.accessMask)
+                .setOldLayout(mapping.imageLayout)
+                .setNewLayout(mapping.imageLayout)
+                .setSrcQueueFamilyIndex(transfer.srcQueueFamilyIndex)
+                .setDstQueueFamilyIndex(transfer.dstQueueFamilyIndex)
+                .setImage(transfer.texture->image)
+                .setSubresourceRange(getBarrierSubresourceRange(barrier, transfer.texture)));
+        };
+
+        for (const QueueOwnershipTransfer& transfer : transfers)
+        {
+            if (transfer.texture)
+            {
+                const QueueAccessHistory& history = transfer.texture->queueAccess;
+
+                TextureBarrier barrier;
+                barrier.texture = transfer.texture;
+
+                if (history.lastSubresourceStates.empty())
+                {
+                    barrier.entireTexture = true;
+                    addImageBarrier(transfer, barrier, history.lastState);
+                    continue;
+                }
+
+                for (ArraySlice arraySlice = 0; arraySlice < transfer.texture->desc.arraySize; arraySlice++)
+                {
+                    for (MipLevel mipLevel = 0; mipLevel < transfer.texture->desc.mipLevels; mipLevel++)
+                    {
+                        barrier.mipLevel = mipLevel;
+                        barrier.arraySlice = arraySlice;
+                        addImageBarrier(transfer, barrier, history.lastSubresourceStates[mipLevel + arraySlice * transfer.texture->desc.mipLevels]);
+                    }
+                }
+            }
+            else if (transfer.buffer)
+            {
+                ResourceStateMapping mapping = convertResourceState(transfer.buffer->queueAccess.lastState);
+                stageFlags |= mapping.stageFlags;
+
+                bufferBarriers.push_back(vk::BufferMemoryBarrier()
+                    .setSrcAccessMask(release ? mapping.accessMask : vk::AccessFlags())
+                    .setDstAccessMask(release ? vk::AccessFlags() : mapping.accessMask)
+                    .setSrcQueueFamilyIndex(transfer.srcQueueFamilyIndex)
+                    .setDstQueueFamilyIndex(transfer.dstQueueFamilyIndex)
+                    .setBuffer(transfer.buffer->buffer)
+                    .setOffset(0)
+                    .setSize(transfer.buffer->desc.byteSize));
+            }
+        }
+
+        if (imageBarriers.empty() && bufferBarriers.empty())
+            return;
+
+        if (!stageFlags)
+            stageFlags = vk::PipelineStageFlagBits::eAllCommands;
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(
+            release ? stageFlags : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe),
+            release ? vk::PipelineStageFlags(vk::PipelineStageFlagBits::eBottomOfPipe) : stageFlags,
+            vk::DependencyFlags(), {}, bufferBarriers, imageBarriers);
+
+        for (const QueueOwnershipTransfer& transfer : transfers)
+        {
+            if (transfer.texture)
+                m_CurrentCmdBuf->referencedResources.add(transfer.texture);
+            else if (transfer.buffer)
+                m_CurrentCmdBuf->referencedResources.add(transfer.buffer);
+        }
+    }
+
     void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
@@ -373,7 +556,7 @@ namespace nvrhi::vulkan
         m_StateTracker.requireTextureState(texture, subresources, stateBits);
 
         if (m_CurrentCmdBuf)
-            m_CurrentCmdBuf->referencedResources.push_back(texture);
+            m_CurrentCmdBuf->referencedResources.add(texture);
     }
 
     void CommandList::setBufferState(IBuffer* _buffer, ResourceStates stateBits)
@@ -383,7 +566,7 @@ namespace nvrhi::vulkan
         m_StateTracker.requireBufferState(buffer, stateBits);
         
         if (m_CurrentCmdBuf)
-            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+            m_CurrentCmdBuf->referencedResources.add(buffer);
     }
     
     void CommandList::setAccelStructState(rt::IAccelStruct* _as, ResourceStates stateBits)
@@ -396,7 +579,7 @@ namespace nvrhi::vulkan
             m_StateTracker.requireBufferState(buffer, stateBits);
 
             if (m_CurrentCmdBuf)
-                m_CurrentCmdBuf->referencedResources.push_back(as);
+                m_CurrentCmdBuf->referencedResources.add(as);
         }
     }
 
@@ -407,7 +590,7 @@ namespace nvrhi::vulkan
         m_StateTracker.setPermanentTextureState(texture, AllSubresources, stateBits);
 
         if (m_CurrentCmdBuf)
-            m_CurrentCmdBuf->referencedResources.push_back(texture);
+            m_CurrentCmdBuf->referencedResources.add(texture);
     }
 
     void CommandList::setPermanentBufferState(IBuffer* _buffer, ResourceStates stateBits)
@@ -417,7 +600,27 @@ namespace nvrhi::vulkan
         m_StateTracker.setPermanentBufferState(buffer, stateBits);
         
         if (m_CurrentCmdBuf)
-            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+            m_CurrentCmdBuf->referencedResources.add(buffer);
+    }
+
+    void CommandList::beginTextureStateTransition(ITexture* _texture, ResourceStates nextState)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, nextState);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.add(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates nextState)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer, nextState);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.add(buffer);
     }
 
     ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
@@ -436,7 +639,8 @@ namespace nvrhi::vulkan
 
     void CommandList::setEnableAutomaticBarriers(bool enable)
     {
-        m_EnableAutomaticBarriers = enable;
+        // Secondary command buffers are executed inside a render pass where barriers can't be placed
+        m_EnableAutomaticBarriers = enable && !m_CommandListParameters.isSecondary;
     }
 
     void CommandList::setEnableUavBarriersForTexture(ITexture* _texture, bool enableBarriers)
@@ -260,9 +260,6 @@ namespace nvrhi::vulkan
         Format format, vk::ImageUsageFlags usage, TextureSubresourceViewType viewtype)
     {
         // This function is called from createBindingSet etc. and therefore free-threaded.
-        // It modifies the subresourceViews map associated with the texture.
-        std::lock_guard lockGuard(m_Mutex);
-
         if (dimension == TextureDimension::Unknown)
             dimension = desc.dimension;
 
@@ -274,10 +271,30 @@ namespace nvrhi::vulkan
         if (!desc.isTypeless)
             usage = vk::ImageUsageFlags(0);
 
+        // The common views are read from fixed slots without locking. Typeless textures are excluded
+        // because their views also differ by usage.
+        std::atomic<TextureSubresourceView*>* defaultView = nullptr;
+        if (!desc.isTypeless && dimension == desc.dimension && format == desc.format &&
+            subresource.baseMipLevel == 0 && subresource.baseArraySlice == 0 && subresource.numArraySlices == desc.arraySize &&
+            (subresource.numMipLevels == desc.mipLevels || subresource.numMipLevels == 1))
+        {
+            defaultView = &m_DefaultViews[size_t(viewtype)][subresource.numMipLevels == desc.mipLevels ? 0 : 1];
+
+            // The acquire pairs with the release below, which happens after the view is created
+            TextureSubresourceView* view = defaultView->load(std::memory_order_acquire);
+            if (view)
+                return *view;
+        }
+
+        // The map is only modified under the lock, and its nodes don't move, so the returned reference stays valid
+        std::lock_guard lockGuard(m_Mutex);
+
         auto cachekey = std::make_tuple(subresource, viewtype, dimension, format, usage);
         auto iter = subresourceViews.find(cachekey);
         if (iter != subresourceViews.end())
         {
+            if (defaultView)
+                defaultView->store(&iter->second, std::memory_order_release);
             return iter->second;
         }
 
@@ -323,6 +340,9 @@ namespace nvrhi::vulkan
         const std::string debugName = std::string("ImageView for: ") + utils::DebugNameToString(desc.debugName);
         m_Context.nameVKObject(VkImageView(view.view), vk::ObjectType::eImageView, vk::DebugReportObjectTypeEXT::eImageView, debugName.c_str());
 
+        if (defaultView)
+            defaultView->store(&view, std::memory_order_release);
+
         return view;
     }
 
@@ -331,6 +351,9 @@ namespace nvrhi::vulkan
         Texture *texture = new Texture(m_Context, m_Allocator);
         assert(texture);
         fillTextureInfo(texture, desc);
+        // Virtual and tiled textures use the memory of the heaps they are bound to
+        texture->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::Texture,
+            (desc.isVirtual || desc.isTiled) ? 0 : estimateTextureMemorySize(desc));
 
         vk::Result res = m_Context.device.createImage(&texture->imageInfo, m_Context.allocationCallbacks, &texture->image);
         ASSERT_VK_OK(res);
@@ -353,7 +376,9 @@ namespace nvrhi::vulkan
 #endif
             }
 
-            m_Context.nameVKObject(texture->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
+            // Shared memory blocks contain multiple resources, so only name dedicated allocations
+            if (!texture->memoryBlock)
+                m_Context.nameVKObject(texture->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
         }
 
         return TextureHandle::Create(texture);
@@ -401,8 +426,8 @@ namespace nvrhi::vulkan
 
         assert(m_CurrentCmdBuf);
 
-        m_CurrentCmdBuf->referencedResources.push_back(dst);
-        m_CurrentCmdBuf->referencedResources.push_back(src);
+        m_CurrentCmdBuf->referencedResources.add(dst);
+        m_CurrentCmdBuf->referencedResources.add(src);
 
         TextureSubresourceSet srcSubresource = TextureSubresourceSet(
             resolvedSrcSlice.mipLevel, 1,
@@ -470,9 +495,9 @@ namespace nvrhi::vulkan
             *depthOut = depth;
     }
 
-    void CommandList::writeTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    MappedWriteRegion CommandList::beginWriteTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel)
     {
-        endRenderPass();
+        assert(m_CurrentCmdBuf);
 
         Texture* dest = checked_cast<Texture*>(_dest);
 
@@ -487,31 +512,23 @@ namespace nvrhi::vulkan
         uint32_t deviceRowPitch = deviceNumCols * formatInfo.bytesPerBlock;
         uint64_t deviceMemSize = uint64_t(deviceRowPitch) * uint64_t(deviceNumRows) * mipDepth;
 
-        Buffer* uploadBuffer;
-        uint64_t uploadOffset;
-        void* uploadCpuVA;
-        m_UploadManager->suballocateBuffer(
+        void* uploadCpuVA = nullptr;
+        if (!m_UploadManager->suballocateBuffer(
             deviceMemSize,
-            &uploadBuffer,
-            &uploadOffset,
+            &m_PendingWrite.uploadBuffer,
+            &m_PendingWrite.uploadOffset,
             &uploadCpuVA,
-            MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false));
-
-        size_t minRowPitch = std::min(size_t(deviceRowPitch), rowPitch);
-        uint8_t* mappedPtr = (uint8_t*)uploadCpuVA;
-        for (uint32_t slice = 0; slice < mipDepth; slice++)
+            MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false)))
         {
-            const uint8_t* sourcePtr = (const uint8_t*)data + depthPitch * slice;
-            for (uint32_t row = 0; row < deviceNumRows; row++)
-            {
-                memcpy(mappedPtr, sourcePtr, minRowPitch);
-                mappedPtr += deviceRowPitch;
-                sourcePtr += rowPitch;
-            }
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return MappedWriteRegion();
         }
 
-        auto imageCopy = vk::BufferImageCopy()
-            .setBufferOffset(uploadOffset)
+        m_PendingWrite.texture = dest;
+        m_PendingWrite.size = size_t(deviceMemSize);
+        m_Stats.uploadBytes += deviceMemSize;
+        m_PendingWrite.imageCopy = vk::BufferImageCopy()
+            .setBufferOffset(m_PendingWrite.uploadOffset)
             .setBufferRowLength(deviceNumCols * formatInfo.blockSize)
             .setBufferImageHeight(deviceNumRows * formatInfo.blockSize)
             .setImageSubresource(vk::ImageSubresourceLayers()
@@ -521,19 +538,73 @@ namespace nvrhi::vulkan
                 .setLayerCount(1))
             .setImageExtent(vk::Extent3D().setWidth(mipWidth).setHeight(mipHeight).setDepth(mipDepth));
 
+        MappedWriteRegion region;
+        region.data = uploadCpuVA;
+        region.rowPitch = deviceRowPitch;
+        region.depthPitch = size_t(deviceRowPitch) * deviceNumRows;
+        region.size = size_t(deviceMemSize);
+        return region;
+    }
+
+    void CommandList::commitWrite()
+    {
         assert(m_CurrentCmdBuf);
 
-        if (m_EnableAutomaticBarriers)
+        PendingWrite& write = m_PendingWrite;
+
+        endRenderPass();
+
+        if (write.texture)
         {
-            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
+            Texture* dest = checked_cast<Texture*>(write.texture.Get());
+            const vk::ImageSubresourceLayers& subresource = write.imageCopy.imageSubresource;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireTextureState(dest, TextureSubresourceSet(subresource.mipLevel, 1, subresource.baseArrayLayer, 1), ResourceStates::CopyDest);
+            }
+            commitBarriers();
+
+            m_CurrentCmdBuf->referencedResources.add(dest);
+
+            m_CurrentCmdBuf->cmdBuf.copyBufferToImage(write.uploadBuffer->buffer,
+                dest->image, vk::ImageLayout::eTransferDstOptimal,
+                1, &write.imageCopy);
         }
-        commitBarriers();
+        else if (write.buffer)
+        {
+            Buffer* dest = checked_cast<Buffer*>(write.buffer.Get());
+
+            if (dest->desc.isVolatile)
+            {
+                m_CurrentCmdBuf->referencedResources.add(dest);
+                writeVolatileBuffer(dest, write.volatileData.data(), write.size);
+            }
+            else
+            {
+                copyBuffer(dest, write.destOffset, write.uploadBuffer, write.uploadOffset, write.size);
+            }
+        }
+
+        write.texture = nullptr;
+        write.buffer = nullptr;
+        write.uploadBuffer = nullptr;
+    }
+
+    void CommandList::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        const MappedWriteRegion region = beginWriteTexture(dest, arraySlice, mipLevel);
+        if (!region.data)
+            return;
+
+        const uint32_t deviceNumRows = uint32_t(region.depthPitch / region.rowPitch);
+        const uint32_t mipDepth = uint32_t(region.size / region.depthPitch);
 
-        m_CurrentCmdBuf->referencedResources.push_back(dest);
+        const size_t minRowPitch = std::min(region.rowPitch, rowPitch);
+        utils::CopyTextureRows(region.data, region.rowPitch, region.depthPitch, data, rowPitch, depthPitch,
+            minRowPitch, deviceNumRows, mipDepth);
 
-        m_CurrentCmdBuf->cmdBuf.copyBufferToImage(uploadBuffer->buffer,
-            dest->image, vk::ImageLayout::eTransferDstOptimal,
-            1, &imageCopy);
+        commitWrite();
     }
 
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
@@ -786,6 +857,7 @@ namespace nvrhi::vulkan
 
         texture->image = image;
         texture->managed = false;
+        texture->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::Texture, estimateTextureMemorySize(desc));
 
         return TextureHandle::Create(texture);
     }
@@ -820,6 +892,7 @@ namespace nvrhi::vulkan
     SamplerHandle Device::createSampler(const SamplerDesc& desc)
     {
         Sampler *sampler = new Sampler(m_Context);
+        sampler->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::Sampler);
 
         const bool anisotropyEnable = desc.maxAnisotropy > 1.0f;
 
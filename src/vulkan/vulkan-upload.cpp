@@ -35,10 +35,10 @@ namespace nvrhi::vulkan
             BufferDesc desc;
             desc.byteSize = size;
             desc.cpuAccess = CpuAccessMode::None;
-            desc.debugName = "ScratchBufferChunk";
+            desc.debugName = m_IsPreprocessBuffer ? "PreprocessBufferChunk" : "ScratchBufferChunk";
             desc.canHaveUAVs = true;
 
-            chunk->buffer = m_Device->createBuffer(desc);
+            chunk->buffer = m_IsPreprocessBuffer ? m_Device->createPreprocessBuffer(desc) : m_Device->createBuffer(desc);
             chunk->mappedMemory = nullptr;
             chunk->bufferSize = size;
         }
@@ -58,12 +58,113 @@ namespace nvrhi::vulkan
             chunk->bufferSize = size;
         }
 
+        chunk->statsEntry.setUploadChunk(&m_Stats, size);
+
         return chunk;
     }
 
+    bool UploadManager::tryAllocateFromRing(uint64_t size, uint32_t alignment, uint64_t currentVersion, uint64_t* pOffset)
+    {
+        // An empty allocation would leave the head at the tail while a region is in flight,
+        // which looks like a full ring until that region retires, so it takes one byte
+        size = std::max<uint64_t>(size, 1);
+
+        if (m_RingRegions.empty())
+        {
+            // Nothing is in flight, start from the beginning to avoid wrapping
+            m_RingHead = 0;
+            m_RingTail = 0;
+        }
+
+        // The head and the tail are only equal when the ring is empty,
+        // so allocations never fill the free space up to the tail completely.
+        uint64_t offset = align(m_RingHead, (uint64_t)alignment);
+        if (m_RingRegions.empty() || m_RingHead > m_RingTail)
+        {
+            if (offset + size > m_RingBuffer->bufferSize)
+            {
+                // Wrap around to the beginning of the ring
+                if (m_RingRegions.empty() || size >= m_RingTail)
+                    return false;
+
+                offset = 0;
+            }
+        }
+        else if (offset + size >= m_RingTail)
+        {
+            return false;
+        }
+
+        m_RingHead = offset + size;
+
+        if (!m_RingRegions.empty() && m_RingRegions.back().version == currentVersion)
+            m_RingRegions.back().end = m_RingHead;
+        else
+            m_RingRegions.push_back(RingRegion{ m_RingHead, currentVersion });
+
+        *pOffset = offset;
+        return true;
+    }
+
+    void UploadManager::retireRingRegions(uint64_t completedInstance)
+    {
+        while (!m_RingRegions.empty())
+        {
+            const RingRegion& region = m_RingRegions.front();
+
+            if (!VersionGetSubmitted(region.version) || VersionGetInstance(region.version) > completedInstance)
+                break;
+
+            m_RingTail = region.end;
+            m_RingRegions.pop_front();
+        }
+    }
+
     bool UploadManager::suballocateBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA,
         uint64_t currentVersion, uint32_t alignment)
     {
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::suballocateBuffer");
+
+        if (m_RingBufferSize > 0 && size <= m_RingBufferSize)
+        {
+            if (!m_RingBuffer)
+            {
+                m_RingBuffer = CreateChunk(align(m_RingBufferSize, BufferChunk::c_sizeAlignment));
+
+                if (!m_RingBuffer->buffer)
+                {
+                    // Could not create the ring, use the chunks from now on
+                    m_RingBuffer.reset();
+                    m_RingBufferSize = 0;
+                }
+            }
+
+            if (m_RingBuffer)
+            {
+                uint64_t offset = 0;
+                bool allocated = tryAllocateFromRing(size, alignment, currentVersion, &offset);
+
+                if (!allocated)
+                {
+                    // Only query the queue progress when the ring is out of space
+                    retireRingRegions(m_Device->queueGetCompletedInstance(VersionGetQueue(currentVersion)));
+                    allocated = tryAllocateFromRing(size, alignment, currentVersion, &offset);
+                }
+
+                if (allocated)
+                {
+                    *pBuffer = checked_cast<Buffer*>(m_RingBuffer->buffer.Get());
+                    *pOffset = offset;
+                    if (pCpuVA && m_RingBuffer->mappedMemory)
+                        *pCpuVA = (char*)m_RingBuffer->mappedMemory + offset;
+
+                    return true;
+                }
+            }
+
+            // The ring is full of in-flight data, fall back to the chunks
+        }
+
         std::shared_ptr<BufferChunk> chunkToRetire;
 
         if (m_CurrentChunk)
@@ -147,6 +248,12 @@ namespace nvrhi::vulkan
             if (chunk->version == currentVersion)
                 chunk->version = submittedVersion;
         }
+
+        // Regions of the current recording are always at the head of the ring
+        for (auto it = m_RingRegions.rbegin(); it != m_RingRegions.rend() && it->version == currentVersion; ++it)
+        {
+            it->version = submittedVersion;
+        }
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::vulkan
+{
+    WorkGraphMemoryRequirements WorkGraphPipeline::getMemoryRequirements() const
+    {
+        WorkGraphMemoryRequirements requirements;
+        requirements.minSize = desc.getDispatchArgumentsEnd();
+        requirements.maxSize = requirements.minSize;
+        requirements.sizeGranularity = 4;
+        return requirements;
+    }
+
+    WorkGraphPipelineHandle Device::createWorkGraphPipeline(const WorkGraphPipelineDesc& desc)
+    {
+        NVRHI_PROFILE_SCOPE("nvrhi::vulkan::createWorkGraphPipeline");
+
+        RefCountPtr<WorkGraphPipeline> pso = RefCountPtr<WorkGraphPipeline>::Create(new WorkGraphPipeline());
+        pso->desc = desc;
+        pso->statsEntry.set(m_Context.deviceStats.get(), LiveObjectType::WorkGraphPipeline);
+
+        for (const WorkGraphNodeDesc& node : desc.nodes)
+        {
+            if (!node.computeShader)
+            {
+                m_Context.error("Work graph node '" + node.name + "' has no compute shader, which emulated work graphs require");
+                return nullptr;
+            }
+
+            ComputePipelineDesc nodeDesc;
+            nodeDesc.CS = node.computeShader;
+            nodeDesc.bindingLayouts = desc.bindingLayouts;
+
+            ComputePipelineHandle nodePipeline = createComputePipeline(nodeDesc);
+            if (!nodePipeline)
+                return nullptr;
+
+            pso->nodePipelines.push_back(nodePipeline);
+        }
+
+        return pso;
+    }
+
+    void CommandList::setWorkGraphState(const WorkGraphState& state)
+    {
+        WorkGraphPipeline* pso = checked_cast<WorkGraphPipeline*>(state.pipeline);
+        Buffer* backingMemory = checked_cast<Buffer*>(state.backingMemory);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(backingMemory, ResourceStates::UnorderedAccess);
+        }
+
+        // The first node is always an entry node. Binding its pipeline also binds the descriptor sets for all nodes,
+        // and makes the push constants go through its pipeline layout, which is compatible with the other nodes.
+        ComputeState computeState;
+        computeState.pipeline = pso->nodePipelines[0];
+        computeState.bindings = state.bindings;
+        setComputeState(computeState);
+
+        m_CurrentCmdBuf->referencedResources.add(pso);
+        m_CurrentCmdBuf->referencedResources.add(backingMemory);
+
+        m_CurrentWorkGraphState = state;
+    }
+
+    void CommandList::workGraphBackingMemoryBarrier(Buffer* backingMemory, vk::PipelineStageFlags srcStages, vk::AccessFlags srcAccess)
+    {
+        auto barrier = vk::BufferMemoryBarrier()
+            .setSrcAccessMask(srcAccess)
+            .setDstAccessMask(vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite)
+            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setBuffer(backingMemory->buffer)
+            .setOffset(0)
+            .setSize(backingMemory->desc.byteSize);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(srcStages,
+            vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eComputeShader,
+            vk::DependencyFlags(), 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    void CommandList::dispatchGraph(const WorkGraphDispatchArguments& args)
+    {
+        assert(m_CurrentCmdBuf);
+
+        WorkGraphPipeline* pso = checked_cast<WorkGraphPipeline*>(m_CurrentWorkGraphState.pipeline);
+        Buffer* backingMemory = checked_cast<Buffer*>(m_CurrentWorkGraphState.backingMemory);
+        assert(pso && backingMemory); // validation layer handles this
+
+        const std::vector<WorkGraphNodeDesc>& nodes = pso->desc.nodes;
+
+        if (args.records && args.recordStride)
+        {
+            writeBuffer(backingMemory, args.records, size_t(args.numRecords) * args.recordStride, nodes[args.entryNode].inputRecordsOffset);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(backingMemory, ResourceStates::UnorderedAccess);
+                commitBarriers();
+            }
+            else
+            {
+                workGraphBackingMemoryBarrier(backingMemory, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+            }
+        }
+
+        updateComputeVolatileBuffers();
+
+        // Producers are listed before their consumers, so one pass over the nodes dispatches every node after its input
+        // has been written. A consumer only needs a barrier if its producer was dispatched after the last barrier,
+        // and the nodes between two barriers run concurrently.
+        m_WorkGraphNodesReached.assign(nodes.size(), false);
+        size_t firstUnsynchronizedNode = args.entryNode;
+
+        for (size_t index = args.entryNode; index < nodes.size(); index++)
+        {
+            const WorkGraphNodeDesc& node = nodes[index];
+            const bool isEntry = index == args.entryNode;
+
+            if (!isEntry && (node.producerNode < 0 || !m_WorkGraphNodesReached[node.producerNode]))
+                continue;
+
+            m_WorkGraphNodesReached[index] = true;
+
+            if (!isEntry && size_t(node.producerNode) >= firstUnsynchronizedNode)
+            {
+                workGraphBackingMemoryBarrier(backingMemory, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite);
+                firstUnsynchronizedNode = index;
+            }
+
+            IComputePipeline* nodePipeline = pso->nodePipelines[index];
+            if (m_CurrentComputeState.pipeline != nodePipeline)
+            {
+                m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, checked_cast<ComputePipeline*>(nodePipeline)->pipeline);
+                ++m_Stats.pipelineBinds;
+
+                // Keeps setComputeState from skipping the pipeline bind later
+                m_CurrentComputeState.pipeline = nodePipeline;
+            }
+
+            ++m_Stats.dispatches;
+
+            if (isEntry)
+                m_CurrentCmdBuf->cmdBuf.dispatch(args.numRecords, 1, 1);
+            else
+                m_CurrentCmdBuf->cmdBuf.dispatchIndirect(backingMemory->buffer, node.dispatchArgumentsOffset);
+        }
+    }
+
+} // namespace nvrhi::vulkan
@@ -0,0 +1,674 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <nvrhi/utils.h>
+
+#include <array>
+
+namespace nvrhi::bench
+{
+    static constexpr uint32_t c_NumTextures = 4;
+    static constexpr uint32_t c_NumBindingSets = 16;
+    static constexpr uint32_t c_ConstantBufferSize = 256;
+
+    // Textures, a constant buffer and a sampler that match the bindings of benchmark-shaders.hlsl
+    class BindingResources
+    {
+    public:
+        BindingLayoutHandle layout;
+        std::vector<TextureHandle> textures;
+        BufferHandle constantBuffer;
+        SamplerHandle sampler;
+
+        bool create(IDevice* device, bool volatileConstants)
+        {
+            BindingLayoutDesc layoutDesc;
+            layoutDesc.visibility = ShaderType::All;
+            layoutDesc.addItem(volatileConstants
+                ? BindingLayoutItem::VolatileConstantBuffer(0)
+                : BindingLayoutItem::ConstantBuffer(0));
+            for (uint32_t slot = 0; slot < c_NumTextures; slot++)
+                layoutDesc.addItem(BindingLayoutItem::Texture_SRV(slot));
+            layoutDesc.addItem(BindingLayoutItem::Sampler(0));
+
+            layout = device->createBindingLayout(layoutDesc);
+            if (!layout)
+                return false;
+
+            for (uint32_t index = 0; index < c_NumBindingSets + c_NumTextures; index++)
+            {
+                TextureDesc textureDesc;
+                textureDesc.width = 64;
+                textureDesc.height = 64;
+                textureDesc.format = Format::RGBA8_UNORM;
+                textureDesc.initialState = ResourceStates::ShaderResource;
+                textureDesc.keepInitialState = true;
+                textureDesc.debugName = "BenchmarkTexture";
+
+                TextureHandle texture = device->createTexture(textureDesc);
+                if (!texture)
+                    return false;
+                textures.push_back(texture);
+            }
+
+            constantBuffer = device->createBuffer(volatileConstants
+                ? utils::CreateVolatileConstantBufferDesc(c_ConstantBufferSize, "BenchmarkConstants", 1024)
+                : utils::CreateStaticConstantBufferDesc(c_ConstantBufferSize, "BenchmarkConstants")
+                    .setInitialState(ResourceStates::ConstantBuffer).setKeepInitialState(true));
+
+            sampler = device->createSampler(SamplerDesc());
+
+            return constantBuffer && sampler;
+        }
+
+        // Different sets use different textures, so that the switches between them transition resources
+        [[nodiscard]] BindingSetDesc getBindingSetDesc(uint32_t index) const
+        {
+            BindingSetDesc desc;
+            desc.addItem(BindingSetItem::ConstantBuffer(0, constantBuffer));
+            for (uint32_t slot = 0; slot < c_NumTextures; slot++)
+                desc.addItem(BindingSetItem::Texture_SRV(slot, textures[(index + slot) % textures.size()]));
+            desc.addItem(BindingSetItem::Sampler(0, sampler));
+            return desc;
+        }
+    };
+
+    class DrawBenchmark : public Benchmark
+    {
+    public:
+        enum class Mode
+        {
+            StaticState,        // One setGraphicsState and many draws
+            RepeatedState,      // setGraphicsState with an unchanged state before every draw
+            ChangingBindings,   // setGraphicsState with a different binding set before every draw
+            VolatileConstants   // writeBuffer to a volatile constant buffer before every draw
+        };
+
+        explicit DrawBenchmark(Mode mode) : m_Mode(mode) { }
+
+        [[nodiscard]] const char* getName() const override
+        {
+            switch (m_Mode)
+            {
+            case Mode::StaticState: return "draw/static-state";
+            case Mode::RepeatedState: return "draw/repeated-state";
+            case Mode::ChangingBindings: return "draw/changing-bindings";
+            case Mode::VolatileConstants: return "draw/volatile-constants";
+            }
+            return "";
+        }
+
+        bool setup(const Environment& env, std::string& outSkipReason) override
+        {
+            IDevice* device = env.device;
+
+            // The null backend doesn't look at the bytecode
+            static const uint8_t c_DummyBytecode[4] = {};
+            const bool needsShaders = device->getGraphicsAPI() != GraphicsAPI::NULL_DEVICE;
+            if (needsShaders && env.shaders->empty())
+            {
+                outSkipReason = "no shader binaries, see --shaders";
+                return false;
+            }
+
+            ShaderHandle vertexShader = needsShaders
+                ? device->createShader(ShaderDesc().setShaderType(ShaderType::Vertex).setEntryName("main_vs"),
+                    env.shaders->vertexShader.data(), env.shaders->vertexShader.size())
+                : device->createShader(ShaderDesc().setShaderType(ShaderType::Vertex), c_DummyBytecode, sizeof(c_DummyBytecode));
+
+            ShaderHandle pixelShader = needsShaders
+                ? device->createShader(ShaderDesc().setShaderType(ShaderType::Pixel).setEntryName("main_ps"),
+                    env.shaders->pixelShader.data(), env.shaders->pixelShader.size())
+                : device->createShader(ShaderDesc().setShaderType(ShaderType::Pixel), c_DummyBytecode, sizeof(c_DummyBytecode));
+
+            if (!vertexShader || !pixelShader)
+            {
+                outSkipReason = "cannot create the shaders";
+                return false;
+            }
+
+            if (!m_Resources.create(device, m_Mode == Mode::VolatileConstants))
+            {
+                outSkipReason = "cannot create the binding resources";
+                return false;
+            }
+
+            for (uint32_t index = 0; index < c_NumBindingSets; index++)
+            {
+                BindingSetHandle bindingSet = device->createBindingSet(m_Resources.getBindingSetDesc(index), m_Resources.layout);
+                if (!bindingSet)
+                {
+                    outSkipReason = "cannot create the binding sets";
+                    return false;
+                }
+                m_BindingSets.push_back(bindingSet);
+            }
+
+            TextureDesc renderTargetDesc;
+            renderTargetDesc.width = 256;
+            renderTargetDesc.height = 256;
+            renderTargetDesc.format = Format::RGBA8_UNORM;
+            renderTargetDesc.isRenderTarget = true;
+            renderTargetDesc.initialState = ResourceStates::RenderTarget;
+            renderTargetDesc.keepInitialState = true;
+            renderTargetDesc.debugName = "BenchmarkRenderTarget";
+            m_RenderTarget = device->createTexture(renderTargetDesc);
+
+            m_Framebuffer = device->createFramebuffer(FramebufferDesc().addColorAttachment(m_RenderTarget));
+
+            GraphicsPipelineDesc pipelineDesc;
+            pipelineDesc.VS = vertexShader;
+            pipelineDesc.PS = pixelShader;
+            pipelineDesc.primType = PrimitiveType::TriangleList;
+            pipelineDesc.renderState.depthStencilState.depthTestEnable = false;
+            pipelineDesc.renderState.rasterState.cullMode = RasterCullMode::None;
+            pipelineDesc.bindingLayouts = { m_Resources.layout };
+
+            m_Pipeline = device->createGraphicsPipeline(pipelineDesc, m_Framebuffer->getFramebufferInfo());
+            if (!m_Pipeline)
+            {
+                outSkipReason = "cannot create the graphics pipeline";
+                return false;
+            }
+
+            m_State.pipeline = m_Pipeline;
+            m_State.framebuffer = m_Framebuffer;
+            m_State.bindings = { m_BindingSets[0] };
+            m_State.viewport.addViewportAndScissorRect(m_Framebuffer->getFramebufferInfo().getViewport());
+
+            return true;
+        }
+
+        uint64_t run(IDevice* device, ICommandList* commandList) override
+        {
+            (void)device;
+
+            constexpr uint32_t c_NumDraws = 4096;
+
+            const std::array<uint8_t, c_ConstantBufferSize> constants = {};
+            if (m_Mode == Mode::VolatileConstants)
+                commandList->writeBuffer(m_Resources.constantBuffer, constants.data(), constants.size());
+
+            m_State.bindings[0] = m_BindingSets[0];
+            commandList->setGraphicsState(m_State);
+
+            for (uint32_t index = 0; index < c_NumDraws; index++)
+            {
+                switch (m_Mode)
+                {
+                case Mode::StaticState:
+                    break;
+                case Mode::RepeatedState:
+                    commandList->setGraphicsState(m_State);
+                    break;
+                case Mode::ChangingBindings:
+                    m_State.bindings[0] = m_BindingSets[index % c_NumBindingSets];
+                    commandList->setGraphicsState(m_State);
+                    break;
+                case Mode::VolatileConstants:
+                    commandList->writeBuffer(m_Resources.constantBuffer, constants.data(), constants.size());
+                    commandList->setGraphicsState(m_State);
+                    break;
+                }
+
+                commandList->draw(DrawArguments().setVertexCount(3));
+            }
+
+            return c_NumDraws;
+        }
+
+    private:
+        Mode m_Mode;
+        BindingResources m_Resources;
+        std::vector<BindingSetHandle> m_BindingSets;
+        TextureHandle m_RenderTarget;
+        FramebufferHandle m_Framebuffer;
+        GraphicsPipelineHandle m_Pipeline;
+        GraphicsState m_State;
+    };
+
+    class BindingSetCreationBenchmark : public Benchmark
+    {
+    public:
+        // When releaseImmediately is true, every set is released right after it's created, which measures
+        // the descriptor heap allocation and release on the backends that allocate descriptors per set
+        explicit BindingSetCreationBenchmark(bool releaseImmediately) : m_ReleaseImmediately(releaseImmediately) { }
+
+        [[nodiscard]] const char* getName() const override
+        {
+            return m_ReleaseImmediately ? "bindings/create-release-binding-set" : "bindings/create-binding-set";
+        }
+
+        bool setup(const Environment& env, std::string& outSkipReason) override
+        {
+            if (!m_Resources.create(env.device, false))
+            {
+                outSkipReason = "cannot create the binding resources";
+                return false;
+            }
+
+            return true;
+        }
+
+        uint64_t run(IDevice* device, ICommandList* commandList) override
+        {
+            (void)commandList;
+
+            constexpr uint32_t c_NumBindingSets = 1024;
+
+            for (uint32_t index = 0; index < c_NumBindingSets; index++)
+            {
+                BindingSetHandle bindingSet = device->createBindingSet(m_Resources.getBindingSetDesc(index), m_Resources.layout);
+
+                if (!m_ReleaseImmediately)
+                    m_BindingSets.push_back(bindingSet);
+            }
+
+            return c_NumBindingSets;
+        }
+
+        void endRepetition() override
+        {
+            m_BindingSets.clear();
+        }
+
+        [[nodiscard]] bool recordsCommands() const override { return false; }
+
+    private:
+        bool m_ReleaseImmediately;
+        BindingResources m_Resources;
+        std::vector<BindingSetHandle> m_BindingSets;
+    };
+
+    class DescriptorTableBenchmark : public Benchmark
+    {
+    public:
+        [[nodiscard]] const char* getName() const override { return "bindings/descriptor-table-writes"; }
+
+        bool setup(const Environment& env, std::string& outSkipReason) override
+        {
+            BindlessLayoutDesc layoutDesc;
+            layoutDesc.visibility = ShaderType::All;
+            layoutDesc.maxCapacity = c_NumDescriptors;
+            layoutDesc.addRegisterSpace(BindingLayoutItem::Texture_SRV(1));
+
+            m_Layout = env.device->createBindlessLayout(layoutDesc);
+            if (!m_Layout)
+            {
+                outSkipReason = "bindless layouts are not supported";
+                return false;
+            }
+
+            if (!m_Resources.create(env.device, false))
+            {
+                outSkipReason = "cannot create the binding resources";
+                return false;
+            }
+
+            return true;
+        }
+
+        uint64_t run(IDevice* device, ICommandList* commandList) override
+        {
+            (void)commandList;
+
+            m_DescriptorTable = device->createDescriptorTable(m_Layout);
+            device->resizeDescriptorTable(m_DescriptorTable, c_NumDescriptors, false);
+
+            for (uint32_t index = 0; index < c_NumDescriptors; index++)
+            {
+                ITexture* texture = m_Resources.textures[index % m_Resources.textures.size()];
+                device->writeDescriptorTable(m_DescriptorTable, BindingSetItem::Texture_SRV(index, texture));
+            }
+
+            return c_NumDescriptors;
+        }
+
+        void endRepetition() override
+        {
+            m_DescriptorTable = nullptr;
+        }
+
+        [[nodiscard]] bool recordsCommands() const override { return false; }
+
+    private:
+        static constexpr uint32_t c_NumDescriptors = 4096;
+
+        BindingLayoutHandle m_Layout;
+        BindingResources m_Resources;
+        DescriptorTableHandle m_DescriptorTable;
+    };
+
+    class WriteBufferBenchmark : public Benchmark
+    {
+    public:
+        // Volatile writes are the small constant buffer updates between draws,
+        // the other writes measure the upload throughput of 64 KB blocks
+        explicit WriteBufferBenchmark(bool isVolatile) : m_IsVolatile(isVolatile) { }
+
+        [[nodiscard]] const char* getName() const override
+        {
+            return m_IsVolatile ? "upload/write-volatile-buffer" : "upload/write-buffer";
+        }
+
+        bool setup(const Environment& env, std::string& outSkipReason) override
+        {
+            BufferDesc bufferDesc = m_IsVolatile
+                ? utils::CreateVolatileConstantBufferDesc(c_ConstantBufferSize, "BenchmarkVolatileBuffer", 4096)
+                : BufferDesc()
+                    .setByteSize(c_BlockSize)
+                    .setInitialState(ResourceStates::CopyDest)
+                    .setKeepInitialState(true)
+                    .setDebugName("BenchmarkUploadBuffer");
+
+            m_Buffer = env.device->createBuffer(bufferDesc);
+            if (!m_Buffer)
+            {
+                outSkipReason = "cannot create the buffer";
+                return false;
+            }
+
+            m_Data.resize(getBytesPerOperation());
+            return true;
+        }
+
+        uint64_t run(IDevice* device, ICommandList* commandList) override
+        {
+            (void)device;
+
+            const uint32_t numWrites = m_IsVolatile ? 4096 : 256;
+
+            for (uint32_t index = 0; index < numWrites; index++)
+                commandList->writeBuffer(m_Buffer, m_Data.data(), m_Data.size());
+
+            return numWrites;
+        }
+
+        [[nodiscard]] uint64_t getBytesPerOperation() const override
+        {
+            return m_IsVolatile ? c_ConstantBufferSize : c_BlockSize;
+        }
+
+    private:
+        static constexpr uint32_t c_BlockSize = 64 * 1024;
+
+        bool m_IsVolatile;
+        BufferHandle m_Buffer;
+        std::vector<uint8_t> m_Data;
+    };
+
+    class WriteTextureBenchmark : public Benchmark
+    {
+    public:
+        [[nodiscard]] const char* getName() const override { return "upload/write-texture"; }
+
+        bool setup(const Environment& env, std::string& outSkipReason) override
+        {
+            TextureDesc textureDesc;
+            textureDesc.width = c_Size;
+            textureDesc.height = c_Size;
+            textureDesc.format = Format::RGBA8_UNORM;
+            textureDesc.initialState = ResourceStates::ShaderResource;
+            textureDesc.keepInitialState = true;
+            textureDesc.debugName = "BenchmarkUploadTexture";
+
+            m_Texture = env.device->createTexture(textureDesc);
+            if (!m_Texture)
+            {
+                outSkipReason = "cannot create the texture";
+                return false;
+            }
+
+            m_Data.resize(getBytesPerOperation());
+            return true;
+        }
+
+        uint64_t run(IDevice* device, ICommandList* commandList) override
+        {
+            (void)device;
+
+            constexpr uint32_t c_NumWrites = 32;
+
+            for (uint32_t index = 0; index < c_NumWrites; index++)
+                commandList->writeTexture(m_Texture, 0, 0, m_Data.data(), c_Size * 4);
+
+            return c_NumWrites;
+        }
+
+        [[nodiscard]] uint64_t getBytesPerOperation() const override { return c_Size * c_Size * 4; }
+
+    private:
+        static constexpr uint32_t c_Size = 256;
+
+        TextureHandle m_Texture;
+        std::vector<uint8_t> m_Data;
+    };
+
+    class TlasBuildBenchmark : public Benchmark
+    {
+    public:
+        [[nodiscard]] const char* getName() const override { return "raytracing/tlas-instances"; }
+
+        bool setup(const Environment& env, std::string& outSkipReason) override
+        {
+            IDevice* device = env.device;
+
+            if (!device->queryFeatureSupport(Feature::RayTracingAccelStruct))
+            {
+                outSkipReason = "ray tracing acceleration structures are not supported";
+                return false;
+            }
+
+            const float vertices[9] = { 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+
+            BufferDesc vertexBufferDesc;
+            vertexBufferDesc.byteSize = sizeof(vertices);
+            vertexBufferDesc.isAccelStructBuildInput = true;
+            vertexBufferDesc.initialState = ResourceStates::AccelStructBuildInput;
+            vertexBufferDesc.keepInitialState = true;
+            vertexBufferDesc.debugName = "BenchmarkVertices";
+            m_VertexBuffer = device->createBuffer(vertexBufferDesc);
+
+            rt::GeometryDesc geometry;
+            geometry.setTriangles(rt::GeometryTriangles()
+                .setVertexBuffer(m_VertexBuffer)
+                .setVertexFormat(Format::RGB32_FLOAT)
+                .setVertexCount(3)
+                .setVertexStride(sizeof(float) * 3));
+            geometry.setFlags(rt::GeometryFlags::Opaque);
+
+            CommandListHandle commandList = device->createCommandList();
+            commandList->open();
+            commandList->writeBuffer(m_VertexBuffer, vertices, sizeof(vertices));
+
+            for (uint32_t index = 0; index < c_NumBottomLevelASes; index++)
+            {
+                rt::AccelStructDesc blasDesc;
+                blasDesc.addBottomLevelGeometry(geometry);
+                blasDesc.debugName = "BenchmarkBLAS";
+
+                rt::AccelStructHandle blas = device->createAccelStruct(blasDesc);
+                if (!blas)
+                {
+                    outSkipReason = "cannot create the BLAS";
+                    return false;
+                }
+
+                commandList->buildBottomLevelAccelStruct(blas, &geometry, 1);
+                m_BottomLevelASes.push_back(blas);
+            }
+
+            commandList->close();
+            device->executeCommandLists(&commandList, 1);
+            device->waitForIdle();
+
+            rt::AccelStructDesc tlasDesc;
+            tlasDesc.setTopLevelMaxInstances(c_NumInstances);
+            tlasDesc.debugName = "BenchmarkTLAS";
+            m_TopLevelAS = device->createAccelStruct(tlasDesc);
+            if (!m_TopLevelAS)
+            {
+                outSkipReason = "cannot create the TLAS";
+                return false;
+            }
+
+            // Runs of instances with the same BLAS, like the instances of a mesh in a real scene
+            m_Instances.resize(c_NumInstances);
+            for (uint32_t index = 0; index < c_NumInstances; index++)
+            {
+                m_Instances[index]
+                    .setBLAS(m_BottomLevelASes[(index / 64) % c_NumBottomLevelASes])
+                    .setInstanceID(index)
+                    .setInstanceMask(0xff);
+            }
+
+            return true;
+        }
+
+        uint64_t run(IDevice* device, ICommandList* commandList) override
+        {
+            (void)device;
+
+            commandList->buildTopLevelAccelStruct(m_TopLevelAS, m_Instances.data(), m_Instances.size());
+
+            return c_NumInstances;
+        }
+
+    private:
+        static constexpr uint32_t c_NumBottomLevelASes = 16;
+        static constexpr uint32_t c_NumInstances = 16384;
+
+        BufferHandle m_VertexBuffer;
+        std::vector<rt::AccelStructHandle> m_BottomLevelASes;
+        rt::AccelStructHandle m_TopLevelAS;
+        std::vector<rt::InstanceDesc> m_Instances;
+    };
+
+    class BarrierBenchmark : public Benchmark
+    {
+    public:
+        // Textures alternate between SRV and UAV states, buffers stay in the UAV state and get UAV barriers
+        explicit BarrierBenchmark(bool useTextures) : m_UseTextures(useTextures) { }
+
+        [[nodiscard]] const char* getName() const override
+        {
+            return m_UseTextures ? "barriers/texture-transitions" : "barriers/buffer-uav-barriers";
+        }
+
+        bool setup(const Environment& env, std::string& outSkipReason) override
+        {
+            for (uint32_t index = 0; index < c_NumResources; index++)
+            {
+                if (m_UseTextures)
+                {
+                    TextureDesc textureDesc;
+                    textureDesc.width = 64;
+                    textureDesc.height = 64;
+                    textureDesc.format = Format::RGBA8_UNORM;
+                    textureDesc.isUAV = true;
+                    textureDesc.initialState = ResourceStates::ShaderResource;
+                    textureDesc.keepInitialState = true;
+                    textureDesc.debugName = "BenchmarkBarrierTexture";
+
+                    TextureHandle texture = env.device->createTexture(textureDesc);
+                    if (!texture)
+                    {
+                        outSkipReason = "cannot create the textures";
+                        return false;
+                    }
+                    m_Textures.push_back(texture);
+                }
+                else
+                {
+                    BufferDesc bufferDesc;
+                    bufferDesc.byteSize = 4096;
+                    bufferDesc.canHaveUAVs = true;
+                    bufferDesc.initialState = ResourceStates::UnorderedAccess;
+                    bufferDesc.keepInitialState = true;
+                    bufferDesc.debugName = "BenchmarkBarrierBuffer";
+
+                    BufferHandle buffer = env.device->createBuffer(bufferDesc);
+                    if (!buffer)
+                    {
+                        outSkipReason = "cannot create the buffers";
+                        return false;
+                    }
+                    m_Buffers.push_back(buffer);
+                }
+            }
+
+            return true;
+        }
+
+        uint64_t run(IDevice* device, ICommandList* commandList) override
+        {
+            (void)device;
+
+            constexpr uint32_t c_NumRounds = 64;
+
+            for (uint32_t round = 0; round < c_NumRounds; round++)
+            {
+                const ResourceStates state = (round & 1) ? ResourceStates::ShaderResource : ResourceStates::UnorderedAccess;
+
+                for (uint32_t index = 0; index < c_NumResources; index++)
+                {
+                    if (m_UseTextures)
+                        commandList->setTextureState(m_Textures[index], AllSubresources, state);
+                    else
+                        commandList->setBufferState(m_Buffers[index], ResourceStates::UnorderedAccess);
+                }
+
+                commandList->commitBarriers();
+            }
+
+            return uint64_t(c_NumRounds) * c_NumResources;
+        }
+
+    private:
+        static constexpr uint32_t c_NumResources = 256;
+
+        bool m_UseTextures;
+        std::vector<TextureHandle> m_Textures;
+        std::vector<BufferHandle> m_Buffers;
+    };
+
+    std::vector<std::unique_ptr<Benchmark>> createBenchmarks()
+    {
+        std::vector<std::unique_ptr<Benchmark>> benchmarks;
+        benchmarks.push_back(std::make_unique<DrawBenchmark>(DrawBenchmark::Mode::StaticState));
+        benchmarks.push_back(std::make_unique<DrawBenchmark>(DrawBenchmark::Mode::RepeatedState));
+        benchmarks.push_back(std::make_unique<DrawBenchmark>(DrawBenchmark::Mode::ChangingBindings));
+        benchmarks.push_back(std::make_unique<DrawBenchmark>(DrawBenchmark::Mode::VolatileConstants));
+        benchmarks.push_back(std::make_unique<BindingSetCreationBenchmark>(false));
+        benchmarks.push_back(std::make_unique<BindingSetCreationBenchmark>(true));
+        benchmarks.push_back(std::make_unique<DescriptorTableBenchmark>());
+        benchmarks.push_back(std::make_unique<WriteBufferBenchmark>(false));
+        benchmarks.push_back(std::make_unique<WriteBufferBenchmark>(true));
+        benchmarks.push_back(std::make_unique<WriteTextureBenchmark>());
+        benchmarks.push_back(std::make_unique<TlasBuildBenchmark>());
+        benchmarks.push_back(std::make_unique<BarrierBenchmark>(true));
+        benchmarks.push_back(std::make_unique<BarrierBenchmark>(false));
+        return benchmarks;
+    }
+}
@@ -0,0 +1,336 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#if NVRHI_BENCH_WITH_NULL
+#include <nvrhi/null.h>
+#endif
+
+#if NVRHI_BENCH_WITH_DX11
+#include <nvrhi/d3d11.h>
+#include <d3d11.h>
+#endif
+
+#if NVRHI_BENCH_WITH_DX12
+#include <nvrhi/d3d12.h>
+#endif
+
+#if NVRHI_BENCH_WITH_DX11 || NVRHI_BENCH_WITH_DX12
+#include <wrl/client.h>
+#endif
+
+#if NVRHI_BENCH_WITH_VULKAN
+#include <nvrhi/vulkan.h>
+#include <cstring>
+#endif
+
+namespace nvrhi::bench
+{
+#if NVRHI_BENCH_WITH_NULL
+    static std::unique_ptr<BenchmarkDevice> createNullDevice(IMessageCallback* messageCallback, std::string& outError)
+    {
+        (void)outError;
+
+        null::DeviceDesc desc;
+        desc.messageCallback = messageCallback;
+
+        auto result = std::make_unique<BenchmarkDevice>();
+        result->device = null::createDevice(desc);
+        return result;
+    }
+#endif
+
+#if NVRHI_BENCH_WITH_DX11
+    class D3D11BenchmarkDevice : public BenchmarkDevice
+    {
+    public:
+        Microsoft::WRL::ComPtr<ID3D11Device> nativeDevice;
+        Microsoft::WRL::ComPtr<ID3D11DeviceContext> nativeContext;
+
+        ~D3D11BenchmarkDevice() override
+        {
+            // The NVRHI device must be released before the native objects
+            device = nullptr;
+        }
+    };
+
+    static std::unique_ptr<BenchmarkDevice> createD3D11Device(IMessageCallback* messageCallback, std::string& outError)
+    {
+        auto result = std::make_unique<D3D11BenchmarkDevice>();
+
+        const D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
+        HRESULT hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, &featureLevel, 1,
+            D3D11_SDK_VERSION, &result->nativeDevice, nullptr, &result->nativeContext);
+        if (FAILED(hr))
+        {
+            outError = "D3D11CreateDevice failed";
+            return nullptr;
+        }
+
+        d3d11::DeviceDesc desc;
+        desc.messageCallback = messageCallback;
+        desc.context = result->nativeContext.Get();
+
+        result->device = d3d11::createDevice(desc);
+        return result;
+    }
+#endif
+
+#if NVRHI_BENCH_WITH_DX12
+    class D3D12BenchmarkDevice : public BenchmarkDevice
+    {
+    public:
+        Microsoft::WRL::ComPtr<ID3D12Device> nativeDevice;
+        Microsoft::WRL::ComPtr<ID3D12CommandQueue> graphicsQueue;
+        Microsoft::WRL::ComPtr<ID3D12CommandQueue> computeQueue;
+        Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyQueue;
+
+        ~D3D12BenchmarkDevice() override
+        {
+            // The NVRHI device must be released before the native objects
+            device = nullptr;
+        }
+    };
+
+    static std::unique_ptr<BenchmarkDevice> createD3D12Device(IMessageCallback* messageCallback, std::string& outError)
+    {
+        auto result = std::make_unique<D3D12BenchmarkDevice>();
+
+        HRESULT hr = D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&result->nativeDevice));
+        if (FAILED(hr))
+        {
+            outError = "D3D12CreateDevice failed";
+            return nullptr;
+        }
+
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+        hr = result->nativeDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&result->graphicsQueue));
+        if (SUCCEEDED(hr))
+        {
+            queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+            hr = result->nativeDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&result->computeQueue));
+        }
+        if (SUCCEEDED(hr))
+        {
+            queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+            hr = result->nativeDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&result->copyQueue));
+        }
+        if (FAILED(hr))
+        {
+            outError = "ID3D12Device::CreateCommandQueue failed";
+            return nullptr;
+        }
+
+        d3d12::DeviceDesc desc;
+        desc.errorCB = messageCallback;
+        desc.pDevice = result->nativeDevice.Get();
+        desc.pGraphicsCommandQueue = result->graphicsQueue.Get();
+        desc.pComputeCommandQueue = result->computeQueue.Get();
+        desc.pCopyCommandQueue = result->copyQueue.Get();
+
+        result->device = d3d12::createDevice(desc);
+        return result;
+    }
+#endif
+
+#if NVRHI_BENCH_WITH_VULKAN
+    class VulkanBenchmarkDevice : public BenchmarkDevice
+    {
+    public:
+        VkInstance instance = VK_NULL_HANDLE;
+        VkDevice nativeDevice = VK_NULL_HANDLE;
+
+        ~VulkanBenchmarkDevice() override
+        {
+            // The NVRHI device must be released before the native objects
+            device = nullptr;
+
+            if (nativeDevice)
+                vkDestroyDevice(nativeDevice, nullptr);
+            if (instance)
+                vkDestroyInstance(instance, nullptr);
+        }
+    };
+
+    static std::unique_ptr<BenchmarkDevice> createVulkanDevice(IMessageCallback* messageCallback, std::string& outError)
+    {
+        auto result = std::make_unique<VulkanBenchmarkDevice>();
+
+        VkApplicationInfo applicationInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+        applicationInfo.pApplicationName = "nvrhi-bench";
+        applicationInfo.apiVersion = VK_API_VERSION_1_3;
+
+        VkInstanceCreateInfo instanceInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+        instanceInfo.pApplicationInfo = &applicationInfo;
+
+        if (vkCreateInstance(&instanceInfo, nullptr, &result->instance) != VK_SUCCESS)
+        {
+            outError = "vkCreateInstance failed";
+            return nullptr;
+        }
+
+        uint32_t numPhysicalDevices = 0;
+        vkEnumeratePhysicalDevices(result->instance, &numPhysicalDevices, nullptr);
+        std::vector<VkPhysicalDevice> physicalDevices(numPhysicalDevices);
+        vkEnumeratePhysicalDevices(result->instance, &numPhysicalDevices, physicalDevices.data());
+
+        // Prefer a discrete GPU, otherwise use the first device
+        VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+        for (VkPhysicalDevice candidate : physicalDevices)
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(candidate, &properties);
+
+            if (properties.apiVersion < VK_API_VERSION_1_3)
+                continue;
+
+            if (!physicalDevice || properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+                physicalDevice = candidate;
+        }
+
+        if (!physicalDevice)
+        {
+            outError = "No Vulkan 1.3 physical device found";
+            return nullptr;
+        }
+
+        uint32_t numQueueFamilies = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueueFamilies, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(numQueueFamilies);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueueFamilies, queueFamilies.data());
+
+        int graphicsQueueFamily = -1;
+        for (uint32_t index = 0; index < numQueueFamilies; index++)
+        {
+            const VkQueueFlags requiredFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+            if ((queueFamilies[index].queueFlags & requiredFlags) == requiredFlags)
+            {
+                graphicsQueueFamily = int(index);
+                break;
+            }
+        }
+
+        if (graphicsQueueFamily < 0)
+        {
+            outError = "No Vulkan graphics queue found";
+            return nullptr;
+        }
+
+        // Enable the ray tracing extensions when they are available so that the TLAS benchmark can run
+        uint32_t numAvailableExtensions = 0;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &numAvailableExtensions, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(numAvailableExtensions);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &numAvailableExtensions, availableExtensions.data());
+
+        auto isExtensionAvailable = [&availableExtensions](const char* name)
+        {
+            for (const VkExtensionProperties& extension : availableExtensions)
+            {
+                if (strcmp(extension.extensionName, name) == 0)
+                    return true;
+            }
+            return false;
+        };
+
+        std::vector<const char*> deviceExtensions;
+        deviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+
+        const bool rayTracingSupported = isExtensionAvailable(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME)
+            && isExtensionAvailable(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+        if (rayTracingSupported)
+        {
+            deviceExtensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
+            deviceExtensions.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+        }
+
+        VkPhysicalDeviceAccelerationStructureFeaturesKHR accelStructFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR };
+        accelStructFeatures.accelerationStructure = VK_TRUE;
+
+        VkPhysicalDeviceVulkan13Features vulkan13Features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+        vulkan13Features.synchronization2 = VK_TRUE;
+        vulkan13Features.pNext = rayTracingSupported ? &accelStructFeatures : nullptr;
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+        vulkan12Features.timelineSemaphore = VK_TRUE;
+        vulkan12Features.bufferDeviceAddress = VK_TRUE;
+        vulkan12Features.pNext = &vulkan13Features;
+
+        const float queuePriority = 1.f;
+        VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+        queueInfo.queueFamilyIndex = uint32_t(graphicsQueueFamily);
+        queueInfo.queueCount = 1;
+        queueInfo.pQueuePriorities = &queuePriority;
+
+        VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+        deviceInfo.pNext = &vulkan12Features;
+        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = &queueInfo;
+        deviceInfo.enabledExtensionCount = uint32_t(deviceExtensions.size());
+        deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+        if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &result->nativeDevice) != VK_SUCCESS)
+        {
+            outError = "vkCreateDevice failed";
+            return nullptr;
+        }
+
+        VkQueue graphicsQueue = VK_NULL_HANDLE;
+        vkGetDeviceQueue(result->nativeDevice, uint32_t(graphicsQueueFamily), 0, &graphicsQueue);
+
+        vulkan::DeviceDesc desc;
+        desc.errorCB = messageCallback;
+        desc.instance = result->instance;
+        desc.physicalDevice = physicalDevice;
+        desc.device = result->nativeDevice;
+        desc.graphicsQueue = graphicsQueue;
+        desc.graphicsQueueIndex = graphicsQueueFamily;
+        desc.deviceExtensions = deviceExtensions.data();
+        desc.numDeviceExtensions = deviceExtensions.size();
+        desc.bufferDeviceAddressSupported = true;
+
+        result->device = vulkan::createDevice(desc);
+        return result;
+    }
+#endif
+
+    const std::vector<BackendInfo>& getBackends()
+    {
+        static const std::vector<BackendInfo> backends = {
+#if NVRHI_BENCH_WITH_NULL
+            { "null", nullptr, createNullDevice },
+#endif
+#if NVRHI_BENCH_WITH_DX11
+            { "d3d11", "dxbc", createD3D11Device },
+#endif
+#if NVRHI_BENCH_WITH_DX12
+            { "d3d12", "dxil", createD3D12Device },
+#endif
+#if NVRHI_BENCH_WITH_VULKAN
+            { "vulkan", "spirv", createVulkanDevice },
+#endif
+        };
+
+        return backends;
+    }
+}
@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Shaders for the nvrhi-bench draw benchmarks. Compile them into the directory passed with --shaders:
+
+    fxc -T vs_5_0 -E main_vs -Fo benchmark_vs.dxbc benchmark-shaders.hlsl
+    fxc -T ps_5_0 -E main_ps -Fo benchmark_ps.dxbc benchmark-shaders.hlsl
+    dxc -T vs_6_0 -E main_vs -Fo benchmark_vs.dxil benchmark-shaders.hlsl
+    dxc -T ps_6_0 -E main_ps -Fo benchmark_ps.dxil benchmark-shaders.hlsl
+    dxc -spirv -T vs_6_0 -E main_vs -Fo benchmark_vs.spirv benchmark-shaders.hlsl <shifts>
+    dxc -spirv -T ps_6_0 -E main_ps -Fo benchmark_ps.spirv benchmark-shaders.hlsl <shifts>
+
+The SPIR-V shifts must match the default VulkanBindingOffsets:
+    -fvk-t-shift 0 0 -fvk-s-shift 128 0 -fvk-b-shift 256 0 -fvk-u-shift 384 0
+*/
+
+cbuffer Constants : register(b0)
+{
+    float4 g_Color;
+};
+
+Texture2D t_Texture0 : register(t0);
+Texture2D t_Texture1 : register(t1);
+Texture2D t_Texture2 : register(t2);
+Texture2D t_Texture3 : register(t3);
+SamplerState s_Sampler : register(s0);
+
+void main_vs(
+    uint i_vertexID : SV_VertexID,
+    out float4 o_position : SV_Position,
+    out float2 o_uv : TEXCOORD)
+{
+    o_uv = float2((i_vertexID << 1) & 2, i_vertexID & 2);
+    o_position = float4(o_uv * float2(2, -2) + float2(-1, 1), 0, 1);
+}
+
+void main_ps(
+    in float4 i_position : SV_Position,
+    in float2 i_uv : TEXCOORD,
+    out float4 o_color : SV_Target0)
+{
+    o_color = g_Color
+        * t_Texture0.Sample(s_Sampler, i_uv)
+        * t_Texture1.Sample(s_Sampler, i_uv)
+        * t_Texture2.Sample(s_Sampler, i_uv)
+        * t_Texture3.Sample(s_Sampler, i_uv);
+}
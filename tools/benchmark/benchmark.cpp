@@ -0,0 +1,543 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+nvrhi-bench measures the CPU cost of common NVRHI operations on every backend that it was built with,
+optionally through the validation layer. The results are printed as a table and can be written
+into a JSON file for tracking them over time.
+
+Usage: nvrhi-bench [options]
+    --backend <name>        Run only on the given backend: null, d3d11, d3d12, vulkan
+    --validation <mode>     on, off, or both (default)
+    --validation-level <l>  Level of the validation layer: full (default), sampled, or state
+    --filter <text>         Run only the benchmarks whose names contain the text
+    --repetitions <count>   Number of timed repetitions of each benchmark, 20 by default
+    --shaders <path>        Directory with benchmark_vs.<ext> and benchmark_ps.<ext> compiled from
+                            benchmark-shaders.hlsl, where <ext> is dxbc, dxil or spirv
+    --output <file>         Write the results into a JSON file
+    --capture <file>        Record the benchmark calls into a trace file through the capture layer,
+                            requires a single backend and validation mode
+    --replay <file>         Replay a trace on the selected backends instead of running the benchmarks,
+                            and print the per-frame CPU and GPU times
+*/
+
+#include "benchmark.h"
+
+#if NVRHI_BENCH_WITH_VALIDATION
+#include <nvrhi/validation.h>
+#endif
+
+#if NVRHI_BENCH_WITH_CAPTURE
+#include <nvrhi/capture.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+using namespace nvrhi;
+using namespace nvrhi::bench;
+
+struct Options
+{
+    std::string backend;
+    std::string filter;
+    std::string shaderPath;
+    std::string outputFile;
+    uint32_t repetitions = 20;
+    bool withoutValidation = true;
+    bool withValidation = true;
+    std::string validationLevel = "full";
+    std::string captureFile;
+    std::string replayFile;
+};
+
+struct Result
+{
+    std::string benchmark;
+    std::string backend;
+    bool validation = false;
+    std::string skipReason;
+    uint64_t operationsPerRepetition = 0;
+    uint64_t bytesPerOperation = 0;
+    uint32_t repetitions = 0;
+    double minNsPerOperation = 0.0;
+    double medianNsPerOperation = 0.0;
+    double meanNsPerOperation = 0.0;
+};
+
+// Errors are always reported, a benchmark that produces them is likely measuring something broken
+class MessageCallback : public IMessageCallback
+{
+public:
+    void message(MessageSeverity severity, const char* messageText) override
+    {
+        if (severity == MessageSeverity::Error || severity == MessageSeverity::Fatal)
+            fprintf(stderr, "NVRHI error: %s\n", messageText);
+    }
+};
+
+static bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        auto takeValue = [&value, &i, arg]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                return false;
+            }
+            ++i;
+            return true;
+        };
+
+        if (!strcmp(arg, "--backend"))
+        {
+            if (!takeValue()) return false;
+            options.backend = value;
+        }
+        else if (!strcmp(arg, "--filter"))
+        {
+            if (!takeValue()) return false;
+            options.filter = value;
+        }
+        else if (!strcmp(arg, "--shaders"))
+        {
+            if (!takeValue()) return false;
+            options.shaderPath = value;
+        }
+        else if (!strcmp(arg, "--output"))
+        {
+            if (!takeValue()) return false;
+            options.outputFile = value;
+        }
+        else if (!strcmp(arg, "--repetitions"))
+        {
+            if (!takeValue()) return false;
+            options.repetitions = uint32_t(std::max(1, atoi(value)));
+        }
+        else if (!strcmp(arg, "--validation"))
+        {
+            if (!takeValue()) return false;
+            if (!strcmp(value, "on"))
+            {
+                options.withoutValidation = false;
+                options.withValidation = true;
+            }
+            else if (!strcmp(value, "off"))
+            {
+                options.withoutValidation = true;
+                options.withValidation = false;
+            }
+            else if (!strcmp(value, "both"))
+            {
+                options.withoutValidation = true;
+                options.withValidation = true;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown validation mode '%s', expected on, off or both\n", value);
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--validation-level"))
+        {
+            if (!takeValue()) return false;
+            if (strcmp(value, "full") && strcmp(value, "sampled") && strcmp(value, "state"))
+            {
+                fprintf(stderr, "Unknown validation level '%s', expected full, sampled or state\n", value);
+                return false;
+            }
+            options.validationLevel = value;
+        }
+        else if (!strcmp(arg, "--capture"))
+        {
+            if (!takeValue()) return false;
+            options.captureFile = value;
+        }
+        else if (!strcmp(arg, "--replay"))
+        {
+            if (!takeValue()) return false;
+            options.replayFile = value;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option '%s'\n"
+                "Usage: nvrhi-bench [--backend <name>] [--validation on|off|both] [--validation-level full|sampled|state]\n"
+                "                   [--filter <text>] [--repetitions <count>] [--shaders <path>] [--output <file>]\n"
+                "                   [--capture <file>] [--replay <file>]\n", arg);
+            return false;
+        }
+    }
+
+#if NVRHI_BENCH_WITH_CAPTURE
+    if (!options.captureFile.empty() && !options.replayFile.empty())
+    {
+        fprintf(stderr, "--capture and --replay cannot be used together\n");
+        return false;
+    }
+
+    // Every run would overwrite the trace of the previous one
+    if (!options.captureFile.empty() && (options.backend.empty() || (options.withValidation && options.withoutValidation)))
+    {
+        fprintf(stderr, "--capture requires --backend and --validation on or off\n");
+        return false;
+    }
+#else
+    if (!options.captureFile.empty() || !options.replayFile.empty())
+    {
+        fprintf(stderr, "nvrhi-bench was built without the capture layer\n");
+        return false;
+    }
+#endif
+
+#if !NVRHI_BENCH_WITH_VALIDATION
+    if (options.withValidation && !options.withoutValidation)
+    {
+        fprintf(stderr, "nvrhi-bench was built without the validation layer\n");
+        return false;
+    }
+    options.withValidation = false;
+#endif
+
+    return true;
+}
+
+static std::vector<uint8_t> readFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return {};
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static ShaderBinaries loadShaders(const Options& options, const BackendInfo& backend)
+{
+    ShaderBinaries shaders;
+    if (options.shaderPath.empty() || !backend.shaderExtension)
+        return shaders;
+
+    const std::string prefix = options.shaderPath + "/benchmark_";
+    shaders.vertexShader = readFile(prefix + "vs." + backend.shaderExtension);
+    shaders.pixelShader = readFile(prefix + "ps." + backend.shaderExtension);
+
+    if (shaders.empty())
+        fprintf(stderr, "Cannot load the %s shaders from '%s'\n", backend.shaderExtension, options.shaderPath.c_str());
+
+    return shaders;
+}
+
+static Result runBenchmark(Benchmark& benchmark, const Environment& env, uint32_t repetitions)
+{
+    using clock = std::chrono::high_resolution_clock;
+
+    Result result;
+    result.benchmark = benchmark.getName();
+    result.bytesPerOperation = benchmark.getBytesPerOperation();
+
+    if (!benchmark.setup(env, result.skipReason))
+        return result;
+
+    IDevice* device = env.device;
+    CommandListHandle commandList = device->createCommandList();
+
+    std::vector<double> nsPerOperation;
+    nsPerOperation.reserve(repetitions);
+
+    // The first repetition is a warm-up that fills the upload and descriptor allocators
+    for (uint32_t repetition = 0; repetition <= repetitions; repetition++)
+    {
+        const bool recordsCommands = benchmark.recordsCommands();
+
+        const auto start = clock::now();
+
+        if (recordsCommands)
+            commandList->open();
+
+        const uint64_t operations = benchmark.run(device, commandList);
+
+        if (recordsCommands)
+        {
+            commandList->close();
+            device->executeCommandLists(&commandList, 1);
+        }
+
+        const auto end = clock::now();
+
+        device->waitForIdle();
+        benchmark.endRepetition();
+        device->runGarbageCollection();
+
+        if (repetition == 0 || operations == 0)
+            continue;
+
+        result.operationsPerRepetition = operations;
+        nsPerOperation.push_back(double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count())
+            / double(operations));
+    }
+
+    if (nsPerOperation.empty())
+    {
+        result.skipReason = "the benchmark didn't perform any operations";
+        return result;
+    }
+
+    std::sort(nsPerOperation.begin(), nsPerOperation.end());
+
+    double sum = 0.0;
+    for (double value : nsPerOperation)
+        sum += value;
+
+    result.repetitions = uint32_t(nsPerOperation.size());
+    result.minNsPerOperation = nsPerOperation.front();
+    result.meanNsPerOperation = sum / double(nsPerOperation.size());
+
+    const size_t middle = nsPerOperation.size() / 2;
+    result.medianNsPerOperation = (nsPerOperation.size() & 1)
+        ? nsPerOperation[middle]
+        : (nsPerOperation[middle - 1] + nsPerOperation[middle]) * 0.5;
+
+    return result;
+}
+
+#if NVRHI_BENCH_WITH_CAPTURE
+static void replayTrace(IDevice* device, const char* backendName, bool validation, const std::string& traceFile)
+{
+    const char* validationText = validation ? "on" : "off";
+
+    capture::ReplayResults replay;
+    if (!capture::replayTrace(device, traceFile.c_str(), replay))
+    {
+        printf("%-8s %-4s replay failed: %s\n", backendName, validationText, replay.error.c_str());
+        return;
+    }
+
+    if (replay.frames.empty())
+    {
+        printf("%-8s %-4s the trace doesn't contain any frames\n", backendName, validationText);
+        return;
+    }
+
+    for (size_t index = 0; index < replay.frames.size(); index++)
+    {
+        const capture::ReplayFrameStats& frame = replay.frames[index];
+        printf("%-8s %-4s %8zu %12.3f %12.3f %8u %8u %8u\n", backendName, validationText, index,
+            frame.cpuTimeMs, frame.gpuTimeMs, frame.numCommandLists, frame.numDraws, frame.numDispatches);
+    }
+
+    if (replay.numUnsupportedEvents || replay.numMissingObjects)
+    {
+        printf("%-8s %-4s %u unsupported events and %u missing objects were skipped\n", backendName, validationText,
+            replay.numUnsupportedEvents, replay.numMissingObjects);
+    }
+}
+#endif
+
+static void printResult(const Result& result)
+{
+    char bandwidth[32] = "";
+    if (result.bytesPerOperation && result.medianNsPerOperation > 0.0)
+        snprintf(bandwidth, sizeof(bandwidth), " %10.1f MB/s",
+            double(result.bytesPerOperation) * 1000.0 / result.medianNsPerOperation);
+
+    if (result.skipReason.empty())
+    {
+        printf("%-8s %-4s %-38s %12.1f %12.1f%s\n", result.backend.c_str(), result.validation ? "on" : "off",
+            result.benchmark.c_str(), result.medianNsPerOperation, result.minNsPerOperation, bandwidth);
+    }
+    else
+    {
+        printf("%-8s %-4s %-38s skipped: %s\n", result.backend.c_str(), result.validation ? "on" : "off",
+            result.benchmark.c_str(), result.skipReason.c_str());
+    }
+}
+
+static std::string escapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+static bool writeJson(const std::string& path, const std::vector<Result>& results)
+{
+    std::ostringstream json;
+    json << "{\n  \"results\": [";
+
+    bool first = true;
+    for (const Result& result : results)
+    {
+        json << (first ? "\n" : ",\n");
+        first = false;
+
+        json << "    {"
+            << "\"benchmark\": \"" << escapeJson(result.benchmark) << "\", "
+            << "\"backend\": \"" << escapeJson(result.backend) << "\", "
+            << "\"validation\": " << (result.validation ? "true" : "false") << ", ";
+
+        if (result.skipReason.empty())
+        {
+            json << "\"repetitions\": " << result.repetitions << ", "
+                << "\"operationsPerRepetition\": " << result.operationsPerRepetition << ", "
+                << "\"bytesPerOperation\": " << result.bytesPerOperation << ", "
+                << "\"medianNsPerOperation\": " << result.medianNsPerOperation << ", "
+                << "\"minNsPerOperation\": " << result.minNsPerOperation << ", "
+                << "\"meanNsPerOperation\": " << result.meanNsPerOperation << "}";
+        }
+        else
+        {
+            json << "\"skipped\": \"" << escapeJson(result.skipReason) << "\"}";
+        }
+    }
+
+    json << "\n  ]\n}\n";
+
+    std::ofstream file(path);
+    if (!file.is_open())
+        return false;
+
+    file << json.str();
+    return file.good();
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    MessageCallback messageCallback;
+    std::vector<Result> results;
+    bool backendFound = false;
+
+    if (options.replayFile.empty())
+        printf("%-8s %-4s %-38s %12s %12s\n", "backend", "val", "benchmark", "median ns/op", "min ns/op");
+    else
+        printf("%-8s %-4s %8s %12s %12s %8s %8s %8s\n", "backend", "val", "frame", "cpu ms", "gpu ms", "cmdlists", "draws", "dispatch");
+
+    for (const BackendInfo& backend : getBackends())
+    {
+        if (!options.backend.empty() && options.backend != backend.name)
+            continue;
+
+        backendFound = true;
+
+        std::string error;
+        std::unique_ptr<BenchmarkDevice> benchmarkDevice = backend.createDevice(&messageCallback, error);
+        if (!benchmarkDevice)
+        {
+            fprintf(stderr, "Cannot create a %s device: %s\n", backend.name, error.c_str());
+            continue;
+        }
+
+        const ShaderBinaries shaders = loadShaders(options, backend);
+
+        for (int validation = 0; validation < 2; validation++)
+        {
+            if (validation ? !options.withValidation : !options.withoutValidation)
+                continue;
+
+            DeviceHandle device = benchmarkDevice->device;
+#if NVRHI_BENCH_WITH_VALIDATION
+            if (validation)
+            {
+                validation::ValidationLayerDesc validationDesc;
+                if (options.validationLevel == "sampled")
+                    validationDesc.level = validation::ValidationLevel::Sampled;
+                else if (options.validationLevel == "state")
+                    validationDesc.level = validation::ValidationLevel::StateOnly;
+
+                device = validation::createValidationLayer(device, validationDesc);
+            }
+#endif
+
+#if NVRHI_BENCH_WITH_CAPTURE
+            if (!options.replayFile.empty())
+            {
+                replayTrace(device, backend.name, validation != 0, options.replayFile);
+                continue;
+            }
+
+            // The capture layer is the outermost wrapper to record the calls exactly as the benchmarks make them
+            if (!options.captureFile.empty())
+            {
+                device = capture::createCaptureLayer(device, capture::CaptureLayerDesc().setTraceFileName(options.captureFile.c_str()));
+                if (!device)
+                {
+                    fprintf(stderr, "Cannot create the trace file '%s'\n", options.captureFile.c_str());
+                    return 1;
+                }
+            }
+#endif
+
+            Environment env;
+            env.device = device;
+            env.shaders = &shaders;
+
+            // Create the benchmarks again for every device so that each of them owns its resources
+            for (const auto& benchmark : createBenchmarks())
+            {
+                if (!options.filter.empty() && !strstr(benchmark->getName(), options.filter.c_str()))
+                    continue;
+
+                Result result = runBenchmark(*benchmark, env, options.repetitions);
+                result.backend = backend.name;
+                result.validation = validation != 0;
+
+                printResult(result);
+                results.push_back(std::move(result));
+            }
+
+            device->waitForIdle();
+            device->runGarbageCollection();
+        }
+    }
+
+    if (!backendFound)
+    {
+        fprintf(stderr, "Backend '%s' is not available in this build\n", options.backend.c_str());
+        return 1;
+    }
+
+    if (!options.outputFile.empty() && !writeJson(options.outputFile, results))
+    {
+        fprintf(stderr, "Cannot write '%s'\n", options.outputFile.c_str());
+        return 1;
+    }
+
+    return 0;
+}
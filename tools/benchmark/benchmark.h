@@ -0,0 +1,94 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nvrhi::bench
+{
+    // Shaders for the benchmarks that need a graphics pipeline, loaded from the files compiled from
+    // benchmark-shaders.hlsl. The null backend accepts any bytecode, so it doesn't need them.
+    struct ShaderBinaries
+    {
+        std::vector<uint8_t> vertexShader;
+        std::vector<uint8_t> pixelShader;
+
+        [[nodiscard]] bool empty() const { return vertexShader.empty() || pixelShader.empty(); }
+    };
+
+    struct Environment
+    {
+        IDevice* device = nullptr;
+        const ShaderBinaries* shaders = nullptr;
+    };
+
+    class Benchmark
+    {
+    public:
+        virtual ~Benchmark() = default;
+
+        [[nodiscard]] virtual const char* getName() const = 0;
+
+        // Creates the resources used by the benchmark. Returns false and sets the reason
+        // when the benchmark can't run on the device, e.g. because a feature is not supported.
+        virtual bool setup(const Environment& env, std::string& outSkipReason) = 0;
+
+        // Performs one timed repetition and returns the number of operations that it performed.
+        // When recordsCommands() is true, the command list is open during the call and submitted
+        // after it as part of the timed region.
+        virtual uint64_t run(IDevice* device, ICommandList* commandList) = 0;
+
+        // Called after every repetition outside of the timed region, once the GPU is idle
+        virtual void endRepetition() { }
+
+        [[nodiscard]] virtual bool recordsCommands() const { return true; }
+        [[nodiscard]] virtual uint64_t getBytesPerOperation() const { return 0; }
+    };
+
+    std::vector<std::unique_ptr<Benchmark>> createBenchmarks();
+
+    // Owns the native API objects that an NVRHI device was created from
+    class BenchmarkDevice
+    {
+    public:
+        DeviceHandle device;
+
+        virtual ~BenchmarkDevice() = default;
+    };
+
+    struct BackendInfo
+    {
+        const char* name;
+        // Extension of the shader binaries for this backend, nullptr if it doesn't need them
+        const char* shaderExtension;
+        std::unique_ptr<BenchmarkDevice>(*createDevice)(IMessageCallback* messageCallback, std::string& outError);
+    };
+
+    // The backends that nvrhi-bench was built with
+    const std::vector<BackendInfo>& getBackends();
+}
@@ -0,0 +1,292 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "inProcessCompiler.h"
+
+#if SHADERCOMPILER_WITH_DXC_API
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+#include <dxcapi.h>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#if __has_include(<filesystem>)
+#include <filesystem>
+namespace fs = std::filesystem;
+#elif __has_include(<experimental/filesystem>)
+#include <experimental/filesystem> 
+namespace fs = std::experimental::filesystem;
+#else
+error "Missing the <filesystem> header."
+#endif
+
+using namespace std;
+
+static DxcCreateInstanceProc g_DxcCreateInstance = nullptr;
+
+struct CachedFile
+{
+	bool exists = false;
+	string contents;
+};
+
+// The map nodes are never removed, so the contents can be passed to DXC as pinned blobs
+static map<fs::path, CachedFile> g_FileCache;
+static mutex g_FileCacheMutex;
+
+static const CachedFile& getCachedFile(const fs::path& path)
+{
+	fs::path normalizedPath = path.lexically_normal();
+
+	lock_guard<mutex> guard(g_FileCacheMutex);
+
+	auto found = g_FileCache.find(normalizedPath);
+	if (found != g_FileCache.end())
+		return found->second;
+
+	CachedFile& file = g_FileCache[normalizedPath];
+
+	ifstream inputFile(normalizedPath, ios::binary);
+	if (inputFile.is_open())
+	{
+		ostringstream ss;
+		ss << inputFile.rdbuf();
+		file.contents = ss.str();
+		file.exists = true;
+	}
+
+	return file;
+}
+
+// DXC calls LoadSource for every candidate location of an include file, so the misses are cached too
+class CachingIncludeHandler : public IDxcIncludeHandler
+{
+public:
+	IDxcUtils* utils = nullptr;
+
+	HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR pFilename, IDxcBlob** ppIncludeSource) override
+	{
+		*ppIncludeSource = nullptr;
+
+		const CachedFile& file = getCachedFile(fs::path(pFilename));
+		if (!file.exists)
+			return E_FAIL;
+
+		IDxcBlobEncoding* blob = nullptr;
+		HRESULT hr = utils->CreateBlobFromPinned(file.contents.data(), uint32_t(file.contents.size()), DXC_CP_UTF8, &blob);
+		*ppIncludeSource = blob;
+		return hr;
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+	{
+		if (riid == __uuidof(IDxcIncludeHandler) || riid == __uuidof(IUnknown))
+		{
+			*ppvObject = this;
+			return S_OK;
+		}
+
+		*ppvObject = nullptr;
+		return E_NOINTERFACE;
+	}
+
+	// The handler is owned by the worker thread and outlives all compilations
+	ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+	ULONG STDMETHODCALLTYPE Release() override { return 1; }
+};
+
+struct ThreadCompiler
+{
+	IDxcUtils* utils = nullptr;
+	IDxcCompiler3* compiler = nullptr;
+	CachingIncludeHandler includeHandler;
+
+	~ThreadCompiler()
+	{
+		if (compiler)
+			compiler->Release();
+		if (utils)
+			utils->Release();
+	}
+
+	bool initialize()
+	{
+		if (compiler)
+			return true;
+
+		if (FAILED(g_DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils))))
+			return false;
+
+		if (FAILED(g_DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler))))
+			return false;
+
+		includeHandler.utils = utils;
+		return true;
+	}
+};
+
+static thread_local ThreadCompiler t_Compiler;
+
+static void* loadCompilerLibrary(const fs::path& compilerPath)
+{
+	// Try the library that belongs to the compiler executable first, then the system search path
+#ifdef _WIN32
+	const fs::path libraryName = "dxcompiler.dll";
+	for (const fs::path& libraryPath : { compilerPath.parent_path() / libraryName, libraryName })
+	{
+		if (HMODULE module = LoadLibraryW(libraryPath.c_str()))
+			return (void*)GetProcAddress(module, "DxcCreateInstance");
+	}
+#else
+#ifdef __APPLE__
+	const fs::path libraryName = "libdxcompiler.dylib";
+#else
+	const fs::path libraryName = "libdxcompiler.so";
+#endif
+	for (const fs::path& libraryPath : { compilerPath.parent_path() / libraryName, compilerPath.parent_path().parent_path() / "lib" / libraryName, libraryName })
+	{
+		if (void* module = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL))
+			return dlsym(module, "DxcCreateInstance");
+	}
+#endif
+	return nullptr;
+}
+
+bool initializeInProcessCompiler(const string& compilerPath, string& outError)
+{
+	g_DxcCreateInstance = (DxcCreateInstanceProc)loadCompilerLibrary(compilerPath);
+	if (!g_DxcCreateInstance)
+	{
+		outError = "cannot load the DXC library for " + compilerPath;
+		return false;
+	}
+
+	return true;
+}
+
+static wstring widen(const string& s)
+{
+	// The arguments are paths and ASCII options, let std::filesystem do the conversion for the paths
+	return fs::path(s).wstring();
+}
+
+bool compileInProcess(const string& sourceFile, const vector<string>& arguments, const string& outputFile, string& outMessages)
+{
+	if (!t_Compiler.initialize())
+	{
+		outMessages = "cannot create a DXC compiler instance";
+		return false;
+	}
+
+	const CachedFile& source = getCachedFile(sourceFile);
+	if (!source.exists)
+	{
+		outMessages = "cannot open " + sourceFile;
+		return false;
+	}
+
+	vector<wstring> wideArguments;
+	wideArguments.reserve(arguments.size() + 1);
+	// The source file name is used for the diagnostics and to resolve the relative includes
+	wideArguments.push_back(widen(sourceFile));
+	for (const string& argument : arguments)
+		wideArguments.push_back(widen(argument));
+
+	vector<LPCWSTR> argumentPointers;
+	argumentPointers.reserve(wideArguments.size());
+	for (const wstring& argument : wideArguments)
+		argumentPointers.push_back(argument.c_str());
+
+	DxcBuffer sourceBuffer;
+	sourceBuffer.Ptr = source.contents.data();
+	sourceBuffer.Size = source.contents.size();
+	sourceBuffer.Encoding = DXC_CP_UTF8;
+
+	IDxcResult* result = nullptr;
+	HRESULT hr = t_Compiler.compiler->Compile(&sourceBuffer, argumentPointers.data(), uint32_t(argumentPointers.size()),
+		&t_Compiler.includeHandler, IID_PPV_ARGS(&result));
+
+	if (FAILED(hr) || !result)
+	{
+		outMessages = "IDxcCompiler3::Compile failed";
+		return false;
+	}
+
+	HRESULT status = E_FAIL;
+	result->GetStatus(&status);
+
+	IDxcBlobUtf8* errors = nullptr;
+	if (SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), nullptr)) && errors)
+	{
+		if (errors->GetStringLength() != 0)
+			outMessages = string(errors->GetStringPointer(), errors->GetStringLength());
+		errors->Release();
+	}
+
+	bool success = SUCCEEDED(status);
+	if (success)
+	{
+		IDxcBlob* object = nullptr;
+		success = SUCCEEDED(result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&object), nullptr)) && object;
+
+		if (success)
+		{
+			FILE* file = fopen(outputFile.c_str(), "wb");
+			success = file && fwrite(object->GetBufferPointer(), 1, object->GetBufferSize(), file) == object->GetBufferSize();
+			if (file)
+				fclose(file);
+			if (!success)
+				outMessages += "cannot write " + outputFile + "\n";
+		}
+
+		if (object)
+			object->Release();
+	}
+
+	result->Release();
+
+	return success;
+}
+
+#else // SHADERCOMPILER_WITH_DXC_API
+
+bool initializeInProcessCompiler(const std::string&, std::string& outError)
+{
+	outError = "the shader compiler was built without the DXC API headers";
+	return false;
+}
+
+bool compileInProcess(const std::string&, const std::vector<std::string>&, const std::string&, std::string& outMessages)
+{
+	outMessages = "in-process compilation is not available";
+	return false;
+}
+
+#endif // SHADERCOMPILER_WITH_DXC_API
@@ -0,0 +1,39 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Compiles shaders with the DXC library loaded into the shaderCompiler process, instead of starting
+// a compiler process for every permutation. Each worker thread creates its own compiler instance,
+// and the contents of the source and include files are shared between all threads and tasks.
+// Only available when the tool is built with SHADERCOMPILER_WITH_DXC_API, and only for DXC.
+
+// Loads the DXC library that belongs to the given compiler executable. Call before starting the worker threads.
+bool initializeInProcessCompiler(const std::string& compilerPath, std::string& outError);
+
+// Compiles 'sourceFile' with the DXC command line 'arguments', excluding the source file and output options,
+// and writes the resulting object to 'outputFile'. The warnings and errors are returned in 'outMessages'.
+bool compileInProcess(const std::string& sourceFile, const std::vector<std::string>& arguments,
+	const std::string& outputFile, std::string& outMessages);
@@ -46,6 +46,7 @@ THE SOFTWARE.
 
 #include "options.h"
 #include <cxxopts.hpp>
+#include <cstdio>
 
 #if __has_include(<filesystem>)
 #include <filesystem>
@@ -65,6 +66,7 @@ bool CommandLineOptions::parse(int argc, char** argv)
 	Options options(argv[0], "Batch shader compiler for NVRHI");
 
 	string platformName;
+	string shard;
 
 	options.add_options()
 		("i,infile", "File with the list of shaders to compile", value(inputFile))
@@ -73,11 +75,17 @@ bool CommandLineOptions::parse(int argc, char** argv)
 		("v,verbose", "Print commands before executing them", value(verbose))
 		("f,force", "Treat all source files as modified", value(force))
 		("k,keep", "Keep intermediate files", value(keep))
+		("archive", "Write the permutations into indexed archives that can be memory-mapped, see nvrhi/common/shader-archive.h", value(archive))
+		("compress", "Compress the permutations in the archives with LZ4 when it makes them smaller", value(compress))
 		("c,compiler", "Path to the compiler executable (FXC or DXC)", value(compilerPath))
+		("external-compiler", "Run the compiler executable for every shader instead of loading the DXC library", value(externalCompiler))
 		("I,include", "Include paths", value(includePaths))
 		("D,define", "Additional defines", value(additionalDefines))
 		("ignore", "Include files to ignore", value(ignoreFileNames))
 		("cflags", "Additional compiler command line options", value(additionalCompilerOptions))
+		("hash-db", "File with the content hashes of the outputs, enables rebuilding only the outputs whose sources, defines or compiler have changed", value(hashDatabase))
+		("shard", "Compile only the outputs of shard N of M, in the form N/M, to distribute a build between machines that share the --cache directory", value(shard))
+		("cache", "Directory with compiled outputs addressed by content hash, can be shared between machines", value(cacheDirectory))
 		("P,platform", "Target shader bytecode type, one of: DXBC, DXIL, SPIRV", value(platformName))
 		("vk-t-shift", "Register shift for texture (t#) resources on SPIR-V", value(vulkanTextureShift))
 		("vk-s-shift", "Register shift for sampler (s#) resources on SPIR-V", value(vulkanSamplerShift))
@@ -124,6 +132,18 @@ bool CommandLineOptions::parse(int argc, char** argv)
 		else
 			throw OptionException("Unrecognized platform: " + platformName);
 
+		if (compress && !archive)
+			throw OptionException("Compression requires --archive");
+
+		if (!shard.empty())
+		{
+			if (sscanf(shard.c_str(), "%u/%u", &shardIndex, &shardCount) != 2 || shardCount == 0 || shardIndex >= shardCount)
+				throw OptionException("Invalid shard: " + shard + ", expected N/M with N < M");
+
+			if (cacheDirectory.empty())
+				throw OptionException("Sharded builds require a cache directory");
+		}
+
 		if (argc > 1)
 			throw OptionException("Unexpected positional arguments");
 
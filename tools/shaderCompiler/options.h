@@ -20,6 +20,7 @@
 * DEALINGS IN THE SOFTWARE.
 */
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -40,12 +41,19 @@ struct CommandLineOptions
     std::vector<std::string> ignoreFileNames;
     std::vector<std::string> additionalCompilerOptions;
 	std::string compilerPath;
+	std::string hashDatabase;
+	std::string cacheDirectory;
 	Platform platform = Platform::UNKNOWN;
 	bool parallel = false;
 	bool verbose = false;
 	bool force = false;
 	bool help = false;
 	bool keep = false;
+	bool externalCompiler = false;
+	bool archive = false;
+	bool compress = false;
+	uint32_t shardIndex = 0;
+	uint32_t shardCount = 1;
 	int vulkanTextureShift = 0;
 	int vulkanSamplerShift = 128;
 	int vulkanConstantShift = 256;
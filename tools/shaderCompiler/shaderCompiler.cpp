@@ -21,6 +21,7 @@
 */
 
 #include "options.h"
+#include "inProcessCompiler.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -31,7 +32,10 @@
 #include <thread>
 #include <mutex>
 #include <csignal>
+#include <algorithm>
+#include <chrono>
 #include <nvrhi/common/shader-blob.h>
+#include <nvrhi/common/shader-archive.h>
 #include <nvrhi/common/misc.h>
 
 #if __has_include(<filesystem>)
@@ -62,6 +66,10 @@ struct CompileTask
 	string entryPoint;
 	string combinedDefines;
 	string commandLine;
+	string outputName;
+	// Used by the in-process compiler instead of the command line
+	vector<string> compilerArguments;
+	string outputFile;
 };
 
 vector<CompileTask> g_CompileTasks;
@@ -71,6 +79,7 @@ mutex g_TaskMutex;
 mutex g_ReportMutex;
 bool g_Terminate = false;
 bool g_CompileSuccess = true;
+bool g_UseInProcessCompiler = false;
 fs::file_time_type g_ConfigWriteTime;
 
 struct BlobEntry
@@ -86,15 +95,134 @@ vector<fs::path> g_IgnoreIncludes;
 
 const char* g_SharedCompilerOptions = "-nologo ";
 
+// Content hash based incremental builds, enabled by --hash-db or --cache.
+// Each output gets a key that combines the hashes of the source files in the include closure of all its
+// permutations with their defines, the compiler options and the compiler binaries. An output is rebuilt only
+// when its key differs from the one stored in the database, regardless of the file timestamps.
+// The keys don't contain any absolute paths, so the cache directory can be shared between machines.
+typedef uint64_t ContentHash;
+
+const ContentHash c_EmptyHash = 0xcbf29ce484222325ull; // FNV-1a offset basis
+const char* c_HashDatabaseSignature = "NVRHI-SCOMP-HASHDB";
+// Increment when the way the outputs are produced changes, to invalidate existing databases and caches
+const uint32_t c_HashDatabaseVersion = 1;
+
+struct OutputState
+{
+	ContentHash key = c_EmptyHash;
+	int pendingTasks = 0;
+	bool isBlob = false;
+	bool failed = false;
+	bool upToDate = false;
+	bool otherShard = false;
+};
+
+bool g_UseContentHashes = false;
+ContentHash g_CompilerHash = c_EmptyHash;
+map<string, OutputState> g_Outputs; // keyed by the output file path
+map<string, ContentHash> g_HashDatabase; // keyed by the output file path, may contain outputs of other configs
+map<fs::path, ContentHash> g_HierarchicalContentHashes;
+
+// Compile times of the permutations in the previous builds in milliseconds, keyed by the permutation file path.
+// Stored next to the hash database and used to start the longest tasks first.
+map<string, uint32_t> g_TaskTimes;
+
 string path_string(fs::path path)
 {
 	return path.make_preferred().string();
 }
 
-bool getHierarchicalUpdateTime(const fs::path& rootFilePath, list<fs::path>& callStack, fs::file_time_type& outTime)
+ContentHash hashBytes(const void* data, size_t size, ContentHash hash)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull; // FNV-1a prime
+	}
+	return hash;
+}
+
+ContentHash hashValue(uint64_t value, ContentHash hash)
+{
+	return hashBytes(&value, sizeof(value), hash);
+}
+
+ContentHash hashString(const string& s, ContentHash hash)
+{
+	hash = hashValue(s.size(), hash);
+	return hashBytes(s.data(), s.size(), hash);
+}
+
+ContentHash hashStrings(const vector<string>& strings, ContentHash hash)
+{
+	hash = hashValue(strings.size(), hash);
+	for (const string& s : strings)
+		hash = hashString(s, hash);
+	return hash;
+}
+
+string formatHash(ContentHash hash)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash);
+	return buf;
+}
+
+bool readFile(const fs::path& path, string& outContents)
+{
+	ifstream file(path, ios::binary);
+	if (!file.is_open())
+		return false;
+
+	ostringstream ss;
+	ss << file.rdbuf();
+	outContents = ss.str();
+	return true;
+}
+
+bool parseIncludeLine(const string& line, fs::path& outInclude)
 {
 	static basic_regex<char> include_pattern("\\s*#include\\s+[\"<]([^>\"]+)[>\"].*");
 
+	std::match_results<const char*> result;
+	std::regex_match(line.c_str(), result, include_pattern);
+	if (result.empty())
+		return false;
+
+	outInclude = string(result[1]);
+	return true;
+}
+
+bool isIgnoredInclude(const fs::path& include)
+{
+	for (const fs::path& ignoredPath : g_IgnoreIncludes)
+	{
+		if (ignoredPath == include)
+			return true;
+	}
+
+	return false;
+}
+
+bool findIncludedFile(const fs::path& include, const fs::path& rootBasePath, fs::path& outPath)
+{
+	outPath = rootBasePath / include;
+	if (fs::exists(outPath))
+		return true;
+
+	for (const string& includePath : g_Options.includePaths)
+	{
+		outPath = includePath / include;
+		if (fs::exists(outPath))
+			return true;
+	}
+
+	return false;
+}
+
+bool getHierarchicalUpdateTime(const fs::path& rootFilePath, list<fs::path>& callStack, fs::file_time_type& outTime)
+{
 	auto found = g_HierarchicalUpdateTimes.find(rootFilePath);
 	if (found != g_HierarchicalUpdateTimes.end())
 	{
@@ -117,50 +245,16 @@ bool getHierarchicalUpdateTime(const fs::path& rootFilePath, list<fs::path>& cal
 	fs::path rootBasePath = rootFilePath.parent_path();
 	fs::file_time_type hierarchicalUpdateTime = fs::last_write_time(rootFilePath);
 
-	uint32_t lineno = 0;
 	for (string line; getline(inputFile, line);)
 	{
-		lineno++;
-
-		std::match_results<const char*> result;
-		std::regex_match(line.c_str(), result, include_pattern);
-		if (!result.empty())
+		fs::path include;
+		if (parseIncludeLine(line, include))
 		{
-			fs::path include = string(result[1]);
-
-			bool ignoreThisInclude = false;
-			for (const fs::path& ignoredPath : g_IgnoreIncludes)
-			{
-				if (ignoredPath == include)
-				{
-					ignoreThisInclude = true;
-					break;
-				}
-			}
-
-			if (ignoreThisInclude)
+			if (isIgnoredInclude(include))
 				continue;
 
-			bool foundIncludedFile = false;
-			fs::path includedFilePath = rootBasePath / include;
-			if (fs::exists(includedFilePath))
-			{
-				foundIncludedFile = true;
-			}
-			else
-			{
-				for (const string& includePath : g_Options.includePaths)
-				{
-					includedFilePath = includePath / include;
-					if (fs::exists(includedFilePath))
-					{
-						foundIncludedFile = true;
-						break;
-					}
-				}
-			}
-
-			if (!foundIncludedFile)
+			fs::path includedFilePath;
+			if (!findIncludedFile(include, rootBasePath, includedFilePath))
 			{
 				cout << "ERROR: Cannot find include file  " << path_string(include) << endl;
 				for (const fs::path& otherPath : callStack)
@@ -185,46 +279,435 @@ bool getHierarchicalUpdateTime(const fs::path& rootFilePath, list<fs::path>& cal
 	return true;
 }
 
-string buildCompilerCommandLine(const CompilerOptions& options, const fs::path& shaderFile, const fs::path& outputFile)
+bool getHierarchicalContentHash(const fs::path& rootFilePath, list<fs::path>& callStack, ContentHash& outHash)
 {
-	std::ostringstream ss;
-#ifdef _WIN32
-	ss << "%COMPILER% ";
-#else
-	ss << "$COMPILER ";
-#endif
-	ss << path_string(shaderFile) << " ";
-	ss << "-Fo " << path_string(outputFile) << " ";
-	ss << "-T " << options.target << " ";
+	auto found = g_HierarchicalContentHashes.find(rootFilePath);
+	if (found != g_HierarchicalContentHashes.end())
+	{
+		outHash = found->second;
+		return true;
+	}
+
+	// An include cycle, the file is already being hashed further up the stack
+	if (std::find(callStack.begin(), callStack.end(), rootFilePath) != callStack.end())
+	{
+		outHash = c_EmptyHash;
+		return true;
+	}
+
+	string contents;
+	if (!readFile(rootFilePath, contents))
+	{
+		cout << "ERROR: Cannot open file  " << path_string(rootFilePath) << endl;
+		for (const fs::path& otherPath : callStack)
+			cout << "            included in  " << path_string(otherPath) << endl;
+
+		return false;
+	}
+
+	// Ignore the line endings so that checkouts on different platforms produce the same hashes
+	contents.erase(std::remove(contents.begin(), contents.end(), '\r'), contents.end());
+
+	callStack.push_front(rootFilePath);
+
+	fs::path rootBasePath = rootFilePath.parent_path();
+	ContentHash hierarchicalHash = hashString(contents, c_EmptyHash);
+
+	istringstream inputFile(contents);
+	for (string line; getline(inputFile, line);)
+	{
+		fs::path include;
+		if (parseIncludeLine(line, include))
+		{
+			if (isIgnoredInclude(include))
+				continue;
+
+			fs::path includedFilePath;
+			if (!findIncludedFile(include, rootBasePath, includedFilePath))
+			{
+				cout << "ERROR: Cannot find include file  " << path_string(include) << endl;
+				for (const fs::path& otherPath : callStack)
+					cout << "                    included in  " << path_string(otherPath) << endl;
+
+				return false;
+			}
+
+			ContentHash dependencyHash;
+			if (!getHierarchicalContentHash(includedFilePath, callStack, dependencyHash))
+				return false;
+
+			hierarchicalHash = hashValue(dependencyHash, hierarchicalHash);
+		}
+	}
+
+	callStack.pop_front();
+
+	g_HierarchicalContentHashes[rootFilePath] = hierarchicalHash;
+	outHash = hierarchicalHash;
+
+	return true;
+}
+
+ContentHash hashCompiler()
+{
+	fs::path compilerPath = g_Options.compilerPath;
+
+	string contents;
+	readFile(compilerPath, contents);
+	ContentHash hash = hashString(contents, c_EmptyHash);
+
+	// DXC keeps most of the compiler in shared libraries next to the executable, or in ../lib on Linux
+	const fs::path libraryDirs[] = { compilerPath.parent_path(), compilerPath.parent_path().parent_path() / "lib" };
+	const char* libraryNames[] = { "dxcompiler.dll", "dxil.dll", "libdxcompiler.so", "libdxil.so", "libdxcompiler.dylib" };
+	for (const fs::path& libraryDir : libraryDirs)
+	{
+		for (const char* libraryName : libraryNames)
+		{
+			fs::path libraryPath = libraryDir / libraryName;
+			if (fs::exists(libraryPath) && readFile(libraryPath, contents))
+				hash = hashString(contents, hash);
+		}
+	}
+
+	return hash;
+}
+
+// Only the inputs that affect the compiled code are hashed, and no absolute paths
+ContentHash getPermutationKey(const CompilerOptions& options, ContentHash sourceHash)
+{
+	ContentHash key = hashValue(c_HashDatabaseVersion, g_CompilerHash);
+	key = hashValue(sourceHash, key);
+	key = hashString(g_PlatformName, key);
+	key = hashString(options.target, key);
+	key = hashString(options.entryPoint, key);
+	key = hashStrings(options.definitions, key);
+	key = hashStrings(g_Options.additionalDefines, key);
+	key = hashStrings(g_Options.additionalCompilerOptions, key);
+	key = hashString(g_SharedCompilerOptions, key);
+	key = hashValue((g_Options.archive ? 1 : 0) | (g_Options.compress ? 2 : 0), key);
+
+	if (g_Options.platform == Platform::SPIRV)
+	{
+		key = hashValue(g_Options.vulkanTextureShift, key);
+		key = hashValue(g_Options.vulkanSamplerShift, key);
+		key = hashValue(g_Options.vulkanConstantShift, key);
+		key = hashValue(g_Options.vulkanUavShift, key);
+	}
+
+	return key;
+}
+
+void loadHashDatabase()
+{
+	if (g_Options.hashDatabase.empty())
+		return;
+
+	ifstream databaseFile(g_Options.hashDatabase);
+	if (!databaseFile.is_open())
+		return;
+
+	string header;
+	getline(databaseFile, header);
+	if (header != string(c_HashDatabaseSignature) + " " + to_string(c_HashDatabaseVersion))
+	{
+		cout << "INFO: Ignoring the hash database " << g_Options.hashDatabase << " created by a different version" << endl;
+		return;
+	}
+
+	// Each line is "<hash> <output file path>"
+	for (string line; getline(databaseFile, line);)
+	{
+		size_t space = line.find(' ');
+		if (space == string::npos)
+			continue;
+
+		g_HashDatabase[line.substr(space + 1)] = strtoull(line.substr(0, space).c_str(), nullptr, 16);
+	}
+}
+
+bool saveHashDatabase()
+{
+	if (g_Options.hashDatabase.empty())
+		return true;
+
+	// Write a temporary file and replace the database with it, so that an interrupted write doesn't corrupt it
+	string temporaryFileName = g_Options.hashDatabase + ".tmp";
+	{
+		ofstream databaseFile(temporaryFileName);
+		if (!databaseFile.is_open())
+		{
+			cout << "ERROR: cannot write " << temporaryFileName << endl;
+			return false;
+		}
+
+		databaseFile << c_HashDatabaseSignature << " " << c_HashDatabaseVersion << endl;
+		for (const pair<const string, ContentHash>& it : g_HashDatabase)
+			databaseFile << formatHash(it.second) << " " << it.first << endl;
+	}
+
+	std::error_code ec;
+	fs::rename(temporaryFileName, g_Options.hashDatabase, ec);
+	if (ec)
+	{
+		cout << "ERROR: cannot write " << g_Options.hashDatabase << ": " << ec.message() << endl;
+		fs::remove(temporaryFileName, ec);
+		return false;
+	}
+
+	return true;
+}
+
+string getTaskTimesFileName()
+{
+	return g_Options.hashDatabase + ".times";
+}
+
+void loadTaskTimes()
+{
+	if (g_Options.hashDatabase.empty())
+		return;
+
+	ifstream timesFile(getTaskTimesFileName());
+
+	// Each line is "<milliseconds> <permutation file path>"
+	for (string line; getline(timesFile, line);)
+	{
+		size_t space = line.find(' ');
+		if (space == string::npos)
+			continue;
+
+		g_TaskTimes[line.substr(space + 1)] = uint32_t(strtoul(line.substr(0, space).c_str(), nullptr, 10));
+	}
+}
+
+void saveTaskTimes()
+{
+	if (g_Options.hashDatabase.empty())
+		return;
+
+	ofstream timesFile(getTaskTimesFileName());
+	for (const pair<const string, uint32_t>& it : g_TaskTimes)
+		timesFile << it.second << " " << it.first << endl;
+}
+
+// Orders the tasks so that the longest ones are started first, which keeps the tail of a parallel build short.
+// The tasks without a recorded time are new or changed, and they are started before all others.
+void sortTasksByCost()
+{
+	// The tasks are taken from the back of g_CompileTasks
+	auto getCost = [](const CompileTask& task)
+	{
+		auto found = g_TaskTimes.find(task.outputFile);
+		return (found != g_TaskTimes.end()) ? found->second : std::numeric_limits<uint32_t>::max();
+	};
+
+	std::stable_sort(g_CompileTasks.begin(), g_CompileTasks.end(),
+		[&getCost](const CompileTask& a, const CompileTask& b) { return getCost(a) < getCost(b); });
+}
+
+// Keeps only the outputs that belong to the shard selected with --shard. The outputs are assigned to the shards
+// by the hash of their path, so that all machines agree on the split without communicating.
+void selectShardOutputs()
+{
+	for (pair<const string, OutputState>& it : g_Outputs)
+	{
+		ContentHash nameHash = hashString(it.first, c_EmptyHash);
+		if (nameHash % g_Options.shardCount != g_Options.shardIndex)
+			it.second.otherShard = true;
+	}
+
+	g_CompileTasks.erase(std::remove_if(g_CompileTasks.begin(), g_CompileTasks.end(),
+		[](const CompileTask& task) { return g_Outputs[task.outputName].otherShard; }), g_CompileTasks.end());
+
+	for (auto it = g_ShaderBlobs.begin(); it != g_ShaderBlobs.end(); )
+	{
+		if (g_Outputs[path_string(fs::path(g_Options.outputPath) / it->first)].otherShard)
+			it = g_ShaderBlobs.erase(it);
+		else
+			++it;
+	}
+}
+
+fs::path getCacheFilePath(ContentHash key)
+{
+	return fs::path(g_Options.cacheDirectory) / (formatHash(key) + ".bin");
+}
+
+bool fetchFromCache(ContentHash key, const fs::path& outputFile)
+{
+	if (g_Options.cacheDirectory.empty())
+		return false;
+
+	fs::path cacheFile = getCacheFilePath(key);
+	if (!fs::exists(cacheFile))
+		return false;
+
+	std::error_code ec;
+	fs::copy_file(cacheFile, outputFile, fs::copy_options::overwrite_existing, ec);
+	return !ec;
+}
+
+void storeInCache(ContentHash key, const fs::path& outputFile)
+{
+	if (g_Options.cacheDirectory.empty())
+		return;
+
+	fs::path cacheFile = getCacheFilePath(key);
+	if (fs::exists(cacheFile))
+		return;
+
+	std::error_code ec;
+	fs::create_directories(g_Options.cacheDirectory, ec);
+
+	// Copy to a uniquely named file and rename it, so that other machines never see a partially written file
+	fs::path temporaryFile = cacheFile;
+	temporaryFile += ".tmp" + to_string(chrono::steady_clock::now().time_since_epoch().count());
+
+	fs::copy_file(outputFile, temporaryFile, fs::copy_options::overwrite_existing, ec);
+	if (!ec)
+		fs::rename(temporaryFile, cacheFile, ec);
+
+	if (ec)
+	{
+		cout << "WARNING: cannot store " << path_string(outputFile) << " in the cache: " << ec.message() << endl;
+		fs::remove(temporaryFile, ec);
+	}
+}
+
+// Removes the compile tasks for the outputs that are up to date or available in the cache
+void skipUpToDateOutputs()
+{
+	size_t numFetchedOutputs = 0;
+
+	for (pair<const string, OutputState>& it : g_Outputs)
+	{
+		OutputState& output = it.second;
+
+		if (g_Options.force)
+			break;
+
+		auto found = g_HashDatabase.find(it.first);
+		if (found != g_HashDatabase.end() && found->second == output.key && fs::exists(it.first))
+		{
+			output.upToDate = true;
+		}
+		else if (fetchFromCache(output.key, it.first))
+		{
+			output.upToDate = true;
+			g_HashDatabase[it.first] = output.key;
+			++numFetchedOutputs;
+		}
+	}
+
+	g_CompileTasks.erase(std::remove_if(g_CompileTasks.begin(), g_CompileTasks.end(),
+		[](const CompileTask& task) { return g_Outputs[task.outputName].upToDate; }), g_CompileTasks.end());
+
+	for (auto it = g_ShaderBlobs.begin(); it != g_ShaderBlobs.end(); )
+	{
+		if (g_Outputs[path_string(fs::path(g_Options.outputPath) / it->first)].upToDate)
+			it = g_ShaderBlobs.erase(it);
+		else
+			++it;
+	}
+
+	if (numFetchedOutputs != 0)
+		cout << "INFO: " << numFetchedOutputs << " " << g_PlatformName << " outputs copied from the cache" << endl;
+}
+
+// Records the keys of the outputs that have been built successfully, and stores them in the cache
+bool updateHashDatabase(bool blobsWritten)
+{
+	for (pair<const string, OutputState>& it : g_Outputs)
+	{
+		const OutputState& output = it.second;
+
+		if (output.upToDate || output.otherShard)
+			continue;
+
+		if (output.failed || output.pendingTasks != 0 || (output.isBlob && !blobsWritten) || !fs::exists(it.first))
+		{
+			// The output might be stale, make sure that it's rebuilt next time
+			g_HashDatabase.erase(it.first);
+			continue;
+		}
+
+		g_HashDatabase[it.first] = output.key;
+		storeInCache(output.key, it.first);
+	}
+
+	saveTaskTimes();
+
+	return saveHashDatabase();
+}
+
+void splitArguments(const string& options, vector<string>& arguments)
+{
+	istringstream ss(options);
+	for (string argument; ss >> argument;)
+		arguments.push_back(argument);
+}
+
+// Returns the compiler arguments except the source and output files
+vector<string> buildCompilerArguments(const CompilerOptions& options)
+{
+	vector<string> arguments;
+	arguments.push_back("-T");
+	arguments.push_back(options.target);
 	if (!options.entryPoint.empty())
-		ss << "-E " << options.entryPoint << " ";
+	{
+		arguments.push_back("-E");
+		arguments.push_back(options.entryPoint);
+	}
 	for (const string& define : options.definitions)
-		ss << "-D" << define << " ";
+		arguments.push_back("-D" + define);
 	for (const string& define : g_Options.additionalDefines)
-		ss << "-D" << define << " ";
+		arguments.push_back("-D" + define);
 	for (const string& dir : g_Options.includePaths)
-		ss << "-I" << path_string(dir) << " ";
+		arguments.push_back("-I" + path_string(dir));
 
-	ss << g_SharedCompilerOptions;
+	splitArguments(g_SharedCompilerOptions, arguments);
 
 	for (const string& option : g_Options.additionalCompilerOptions)
-	{
-		ss << option << " ";
-	}
+		splitArguments(option, arguments);
 
 	if (g_Options.platform == Platform::SPIRV)
 	{
-		ss << "-spirv ";
+		arguments.push_back("-spirv");
+
+		const pair<const char*, int> shifts[] = {
+			{ "-fvk-t-shift", g_Options.vulkanTextureShift },
+			{ "-fvk-s-shift", g_Options.vulkanSamplerShift },
+			{ "-fvk-b-shift", g_Options.vulkanConstantShift },
+			{ "-fvk-u-shift", g_Options.vulkanUavShift }
+		};
 
 		for (int space = 0; space < 10; space++)
 		{
-			ss << "-fvk-t-shift " << g_Options.vulkanTextureShift << " " << space << " ";
-			ss << "-fvk-s-shift " << g_Options.vulkanSamplerShift << " " << space << " ";
-			ss << "-fvk-b-shift " << g_Options.vulkanConstantShift << " " << space << " ";
-			ss << "-fvk-u-shift " << g_Options.vulkanUavShift << " " << space << " ";
+			for (const auto& [option, shift] : shifts)
+			{
+				arguments.push_back(option);
+				arguments.push_back(to_string(shift));
+				arguments.push_back(to_string(space));
+			}
 		}
 	}
-	
+
+	return arguments;
+}
+
+string buildCompilerCommandLine(const vector<string>& arguments, const fs::path& shaderFile, const fs::path& outputFile)
+{
+	std::ostringstream ss;
+#ifdef _WIN32
+	ss << "%COMPILER% ";
+#else
+	ss << "$COMPILER ";
+#endif
+	ss << path_string(shaderFile) << " ";
+	ss << "-Fo " << path_string(outputFile) << " ";
+	for (const string& argument : arguments)
+		ss << argument << " ";
+
 	return ss.str();
 }
 
@@ -290,7 +773,7 @@ bool processShaderConfig(uint32_t lineno, const string& shaderConfig)
 		cout << "INFO: Creating directory " << compiledShaderPath << endl;
 		fs::create_directories(compiledShaderPath);
 	}
-	else if(!g_Options.force)
+	else if(!g_Options.force && !g_UseContentHashes)
 	{
 		fs::path compiledShaderFile = g_Options.outputPath / compiledShaderName;
 		if (fs::exists(compiledShaderFile))
@@ -321,7 +804,8 @@ bool processShaderConfig(uint32_t lineno, const string& shaderConfig)
 
 	fs::path compiledPermutationFile = g_Options.outputPath / compiledPermutationName;
 
-	string commandLine = buildCompilerCommandLine(compilerOptions, sourceFile, compiledPermutationFile);
+	vector<string> compilerArguments = buildCompilerArguments(compilerOptions);
+	string commandLine = buildCompilerCommandLine(compilerArguments, sourceFile, compiledPermutationFile);
 	
 	CompileTask task;
 	task.sourceFile = sourceFile.generic_string();
@@ -329,8 +813,26 @@ bool processShaderConfig(uint32_t lineno, const string& shaderConfig)
 	task.entryPoint = compilerOptions.entryPoint;
 	task.combinedDefines = combinedDefines.str();
 	task.commandLine = commandLine;
+	task.outputName = path_string(g_Options.outputPath / compiledShaderName);
+	task.outputFile = path_string(compiledPermutationFile);
+	if (g_UseInProcessCompiler)
+		task.compilerArguments = std::move(compilerArguments);
 	g_CompileTasks.push_back(task);
 
+	if (g_UseContentHashes)
+	{
+		ContentHash sourceHash;
+		list<fs::path> callStack;
+		if (!getHierarchicalContentHash(sourceFile, callStack, sourceHash))
+			return false;
+
+		// The permutations of a blob are combined in the order of the config file, same as in the blob
+		OutputState& output = g_Outputs[task.outputName];
+		output.key = hashValue(getPermutationKey(compilerOptions, sourceHash), output.key);
+		output.isBlob = !compilerOptions.definitions.empty();
+		++output.pendingTasks;
+	}
+
 	if (!compilerOptions.definitions.empty())
 	{
 		BlobEntry entry;
@@ -480,6 +982,240 @@ bool WriteShaderBlob(const string& compiledShaderName, const vector<BlobEntry>&
 	return true;
 }
 
+// A greedy LZ4 block compressor. The archives are written once and read many times, so the decompression speed
+// matters more than the compression ratio.
+vector<uint8_t> compressLZ4Block(const uint8_t* src, size_t size)
+{
+	vector<uint8_t> output;
+	output.reserve(size);
+
+	auto writeLength = [&output](size_t length)
+	{
+		for (; length >= 255; length -= 255)
+			output.push_back(255);
+		output.push_back(uint8_t(length));
+	};
+
+	auto writeSequence = [&](const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+	{
+		uint8_t token = uint8_t(std::min<size_t>(literalLength, 15) << 4);
+		if (matchLength != 0)
+			token |= uint8_t(std::min<size_t>(matchLength - 4, 15));
+		output.push_back(token);
+
+		if (literalLength >= 15)
+			writeLength(literalLength - 15);
+		output.insert(output.end(), literals, literals + literalLength);
+
+		if (matchLength != 0)
+		{
+			output.push_back(uint8_t(offset));
+			output.push_back(uint8_t(offset >> 8));
+			if (matchLength - 4 >= 15)
+				writeLength(matchLength - 4 - 15);
+		}
+	};
+
+	auto read32 = [src](size_t pos) { uint32_t value; memcpy(&value, src + pos, 4); return value; };
+
+	// The format requires the last 5 bytes to be literals, and the last match to start 12 bytes before the end
+	const size_t c_LastLiterals = 5;
+	const size_t c_MatchStartLimit = 12;
+	const uint32_t c_HashBits = 16;
+
+	size_t anchor = 0;
+
+	if (size > c_MatchStartLimit)
+	{
+		vector<int64_t> table(size_t(1) << c_HashBits, -1);
+		const size_t matchStartEnd = size - c_MatchStartLimit;
+		const size_t matchEnd = size - c_LastLiterals;
+
+		size_t pos = 0;
+		while (pos < matchStartEnd)
+		{
+			const uint32_t sequence = read32(pos);
+			const uint32_t hash = (sequence * 2654435761u) >> (32 - c_HashBits);
+			const int64_t candidate = table[hash];
+			table[hash] = int64_t(pos);
+
+			if (candidate >= 0 && pos - size_t(candidate) <= 65535 && read32(size_t(candidate)) == sequence)
+			{
+				size_t matchLength = 4;
+				while (pos + matchLength < matchEnd && src[size_t(candidate) + matchLength] == src[pos + matchLength])
+					matchLength++;
+
+				writeSequence(src + anchor, pos - anchor, pos - size_t(candidate), matchLength);
+				pos += matchLength;
+				anchor = pos;
+			}
+			else
+				pos++;
+		}
+	}
+
+	writeSequence(src + anchor, size - anchor, 0, 0);
+
+	return output;
+}
+
+// Converts "A=1 B " from the config file into the canonical permutation string of the archives
+string getArchivePermutation(const string& combinedDefines)
+{
+	vector<pair<string, string>> defines;
+
+	istringstream ss(combinedDefines);
+	for (string define; ss >> define;)
+	{
+		size_t equals = define.find('=');
+		if (equals == string::npos)
+			defines.emplace_back(define, "");
+		else
+			defines.emplace_back(define.substr(0, equals), define.substr(equals + 1));
+	}
+
+	return nvrhi::BuildShaderArchivePermutation(std::move(defines));
+}
+
+bool WriteShaderArchive(const string& compiledShaderName, const vector<BlobEntry>& entries)
+{
+	fs::path outputFilePath = fs::path(g_Options.outputPath) / compiledShaderName;
+	string outputFileName = path_string(outputFilePath);
+
+	struct ArchiveItem
+	{
+		string permutation;
+		vector<uint8_t> data;
+		uint32_t uncompressedSize = 0;
+		nvrhi::ShaderArchiveCompression compression = nvrhi::ShaderArchiveCompression::None;
+	};
+
+	vector<ArchiveItem> items;
+	items.reserve(entries.size());
+
+	for (const BlobEntry& entry : entries)
+	{
+		string inputFileName = path_string(entry.compiledPermutationFile);
+		string contents;
+		if (!readFile(entry.compiledPermutationFile, contents))
+		{
+			cout << "ERROR: cannot read " << inputFileName << endl;
+			return false;
+		}
+
+		if (contents.empty())
+			continue;
+
+		if (contents.size() > size_t(std::numeric_limits<uint32_t>::max()))
+		{
+			cout << "ERROR: binary shader file too big: " << inputFileName << endl;
+			continue;
+		}
+
+		if (!g_Options.keep)
+		{
+			fs::remove(inputFileName);
+		}
+
+		ArchiveItem& item = items.emplace_back();
+		item.permutation = getArchivePermutation(entry.permutation);
+		item.uncompressedSize = uint32_t(contents.size());
+
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(contents.data());
+
+		if (g_Options.compress)
+		{
+			vector<uint8_t> compressed = compressLZ4Block(data, contents.size());
+
+			// Keep the small gains uncompressed, they are not worth losing the zero-copy access
+			if (compressed.size() < contents.size() - contents.size() / 8)
+			{
+				item.data = std::move(compressed);
+				item.compression = nvrhi::ShaderArchiveCompression::LZ4;
+			}
+		}
+
+		if (item.compression == nvrhi::ShaderArchiveCompression::None)
+			item.data.assign(data, data + contents.size());
+	}
+
+	// The index is sorted by hash, the payloads stay in the config file order
+	vector<nvrhi::ShaderArchiveEntry> index(items.size());
+	uint64_t offset = sizeof(nvrhi::ShaderArchiveHeader) + index.size() * sizeof(nvrhi::ShaderArchiveEntry);
+
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		index[i] = nvrhi::ShaderArchiveEntry();
+		index[i].permutationHash = nvrhi::HashShaderArchivePermutation(items[i].permutation);
+		index[i].permutationOffset = uint32_t(offset);
+		index[i].permutationSize = uint32_t(items[i].permutation.size());
+		offset += items[i].permutation.size();
+	}
+
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		offset = nvrhi::align<uint64_t>(offset, nvrhi::c_ShaderArchivePayloadAlignment);
+		index[i].dataOffset = offset;
+		index[i].dataSize = uint32_t(items[i].data.size());
+		index[i].uncompressedSize = items[i].uncompressedSize;
+		index[i].compression = items[i].compression;
+		offset += items[i].data.size();
+	}
+
+	vector<size_t> sortedIndices(items.size());
+	for (size_t i = 0; i < sortedIndices.size(); i++)
+		sortedIndices[i] = i;
+	std::stable_sort(sortedIndices.begin(), sortedIndices.end(),
+		[&index](size_t a, size_t b) { return index[a].permutationHash < index[b].permutationHash; });
+
+	for (size_t i = 1; i < sortedIndices.size(); i++)
+	{
+		if (items[sortedIndices[i]].permutation == items[sortedIndices[i - 1]].permutation)
+			cout << "WARNING: duplicate permutation '" << items[sortedIndices[i]].permutation << "' in " << outputFileName << endl;
+	}
+
+	FILE* outputFile = fopen(outputFileName.c_str(), "wb");
+	if (!outputFile)
+	{
+		cout << "ERROR: cannot write " << outputFileName << endl;
+		return false;
+	}
+
+	if (g_Options.verbose)
+	{
+		cout << "INFO: writing " << outputFileName << endl;
+	}
+
+	nvrhi::ShaderArchiveHeader header;
+	header.signature = nvrhi::c_ShaderArchiveSignature;
+	header.version = nvrhi::c_ShaderArchiveVersion;
+	header.numEntries = uint32_t(items.size());
+	header.payloadAlignment = nvrhi::c_ShaderArchivePayloadAlignment;
+	fwrite(&header, 1, sizeof(header), outputFile);
+
+	for (size_t i : sortedIndices)
+		fwrite(&index[i], 1, sizeof(nvrhi::ShaderArchiveEntry), outputFile);
+
+	for (const ArchiveItem& item : items)
+		fwrite(item.permutation.data(), 1, item.permutation.size(), outputFile);
+
+	const char padding[nvrhi::c_ShaderArchivePayloadAlignment] = {};
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		long position = ftell(outputFile);
+		fwrite(padding, 1, size_t(index[i].dataOffset - uint64_t(position)), outputFile);
+		fwrite(items[i].data.data(), 1, items[i].data.size(), outputFile);
+	}
+
+	bool success = !ferror(outputFile);
+	fclose(outputFile);
+
+	if (!success)
+		cout << "ERROR: cannot write " << outputFileName << endl;
+
+	return success;
+}
+
 void compileThreadProc()
 {
 	while (!g_Terminate)
@@ -500,29 +1236,48 @@ void compileThreadProc()
 			cout << task.commandLine << endl;
 		}
 
-		string commandLine = task.commandLine + " 2>&1";
+		ostringstream ss;
+		char buf[1024];
+		int result;
+
+		auto startTime = chrono::steady_clock::now();
 
-		FILE* pipe = popen(commandLine.c_str(), "r");
-		if (!pipe)
+		if (g_UseInProcessCompiler)
 		{
-			lock_guard<mutex> guard(g_ReportMutex);
-			cout << "ERROR: cannot run " << g_Options.compilerPath << endl;
-			g_CompileSuccess = false;
-			g_Terminate = true;
-			return;
+			string messages;
+			result = compileInProcess(task.sourceFile, task.compilerArguments, task.outputFile, messages) ? 0 : 1;
+			ss << messages;
 		}
+		else
+		{
+			string commandLine = task.commandLine + " 2>&1";
 
-		ostringstream ss;
-		char buf[1024];
-		while (fgets(buf, sizeof(buf), pipe))
-			ss << buf;
+			FILE* pipe = popen(commandLine.c_str(), "r");
+			if (!pipe)
+			{
+				lock_guard<mutex> guard(g_ReportMutex);
+				cout << "ERROR: cannot run " << g_Options.compilerPath << endl;
+				g_CompileSuccess = false;
+				g_Terminate = true;
+				return;
+			}
+
+			while (fgets(buf, sizeof(buf), pipe))
+				ss << buf;
+
+			result = pclose(pipe);
+		}
 
-		int result = pclose(pipe);
 		g_ProcessedTaskCount++;
 
+		uint32_t compileTime = uint32_t(chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count());
+
 		{
 			lock_guard<mutex> guard(g_ReportMutex);
 
+			if (result == 0)
+				g_TaskTimes[task.outputFile] = compileTime;
+
 			const char* resultCode = (result == 0) ? " OK  " : "FAIL ";
 			float progress = (float)g_ProcessedTaskCount / (float)g_OriginalTaskCount;
 
@@ -535,6 +1290,15 @@ void compileThreadProc()
 				task.combinedDefines.c_str());
 
 			cout << buf << endl;
+
+			if (g_UseContentHashes)
+			{
+				OutputState& output = g_Outputs[task.outputName];
+				if (result == 0)
+					--output.pendingTasks;
+				else
+					output.failed = true;
+			}
  
 			if (result != 0 && !g_Terminate)
 			{
@@ -581,6 +1345,23 @@ int main(int argc, char** argv)
 
 	// Updated shaderCompiler executable also means everything must be recompiled
 	g_ConfigWriteTime = std::max(g_ConfigWriteTime, fs::last_write_time(argv[0]));
+
+	// FXC has no library interface, so DXBC is always compiled by running the compiler executable
+	if (g_Options.platform != Platform::DXBC && !g_Options.externalCompiler)
+	{
+		string error;
+		g_UseInProcessCompiler = initializeInProcessCompiler(g_Options.compilerPath, error);
+		if (!g_UseInProcessCompiler && g_Options.verbose)
+			cout << "INFO: Running the compiler executable for every shader, " << error << endl;
+	}
+
+	g_UseContentHashes = !g_Options.hashDatabase.empty() || !g_Options.cacheDirectory.empty();
+	if (g_UseContentHashes)
+	{
+		g_CompilerHash = hashCompiler();
+		loadHashDatabase();
+		loadTaskTimes();
+	}
 	
 	ifstream configFile(g_Options.inputFile);
 	uint32_t lineno = 0;
@@ -595,9 +1376,21 @@ int main(int argc, char** argv)
 			return 1;
 	}
 
+	if (g_UseContentHashes)
+	{
+		skipUpToDateOutputs();
+
+		if (g_Options.shardCount > 1)
+			selectShardOutputs();
+
+		sortTasksByCost();
+	}
+
 	if (g_CompileTasks.empty())
 	{
 		cout << "All " << g_PlatformName << " outputs are up to date." << endl;
+		if (g_UseContentHashes && !saveHashDatabase())
+			return 1;
 		return 0;
 	}
 
@@ -642,13 +1435,25 @@ int main(int argc, char** argv)
 	}
 
 	if (!g_CompileSuccess || g_Terminate)
+	{
+		// Keep the outputs that did compile, so that they are not rebuilt next time
+		if (g_UseContentHashes)
+			updateHashDatabase(false);
 		return 1;
+	}
 
 	for (const pair<const string, vector<BlobEntry>>& it : g_ShaderBlobs)
 	{
-		if (!WriteShaderBlob(it.first, it.second))
+		bool written = g_Options.archive
+			? WriteShaderArchive(it.first, it.second)
+			: WriteShaderBlob(it.first, it.second);
+
+		if (!written)
 			return 1;
 	}
 
+	if (g_UseContentHashes && !updateHashDatabase(true))
+		return 1;
+
 	return 0;
 }